@@ -31,6 +31,7 @@ SET(LMMS_PLUGIN_LIST
 	CarlaPatchbay
 	CarlaRack
 	Compressor
+	Convolver
 	CrossoverEQ
 	Delay
 	Dispersion
@@ -63,6 +64,7 @@ SET(LMMS_PLUGIN_LIST
 	Sid
 	SlicerT
 	SpectrumAnalyzer
+	Splitter
 	StereoEnhancer
 	StereoMatrix
 	Stk
@@ -0,0 +1,129 @@
+/*
+ * ActiveAutomation.h - applies the automation clips playing at the song position
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_ACTIVE_AUTOMATION_H
+#define LMMS_ACTIVE_AUTOMATION_H
+
+#include <QPointer>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "AutomatableModel.h"
+#include "TimePos.h"
+
+namespace lmms {
+
+class AutomationClip;
+class PatternClip;
+class Track;
+class TrackContainer;
+
+/**
+ * Index of the automation clips applying to the models at the song position,
+ * in the order TrackContainer::automatedValuesAt() resolves them.
+ *
+ * The clips are only looked up again when the position passes the start of a
+ * clip or the arrangement has changed (see TrackContainer::arrangementRevision()).
+ * In between, every tick only evaluates the indexed clips and writes their
+ * values into the models, ramping to the values of the next tick so the
+ * models' value buffers follow the clips sample-exactly.
+ *
+ * Must only be used by the audio thread.
+ */
+class ActiveAutomation
+{
+public:
+	//! Applies the automation of @p container (preceded by @p globalTrack if not null) at @p time,
+	//! only that of pattern @p clipNum if it isn't negative, and records into recording clips
+	void process(const TrackContainer& container, Track* globalTrack, TimePos time, int clipNum);
+
+	//! Moves the control of all automated models back to their controllers
+	void release();
+
+	//! Forgets all models without touching them, e.g. when they are about to be destroyed
+	void clear();
+
+private:
+	static constexpr auto None = std::numeric_limits<std::size_t>::max();
+
+	struct Entry
+	{
+		QPointer<AutomatableModel> model;
+		float value = 0.f;
+		//! Value at the next tick
+		float target = 0.f;
+		bool automated = false;
+		bool wasAutomated = false;
+		bool recorded = false;
+	};
+
+	struct Source
+	{
+		AutomationClip* clip;
+		Track* track;
+		//! The clip playing the pattern containing the clip, if any
+		PatternClip* patternClip = nullptr;
+		Track* patternTrack = nullptr;
+		int patternIndex = -1;
+		bool inPattern = false;
+		//! Indices of the models automated by the clip in m_entries
+		std::vector<std::size_t> entries;
+	};
+
+	struct RecordingCandidate
+	{
+		AutomationClip* clip;
+		std::size_t entry;
+	};
+
+	struct PatternAutomation
+	{
+		AutomationClip* clip;
+		Track* track;
+	};
+
+	void rebuild(const TrackContainer& container, Track* globalTrack, TimePos time, int clipNum);
+
+	//! The automation clips of pattern @p patternIndex in PatternStore's track order
+	auto patternAutomation(int patternIndex) -> const std::vector<PatternAutomation>&;
+
+	std::vector<Entry> m_entries;
+	std::vector<Source> m_sources;
+	std::vector<RecordingCandidate> m_recordingCandidates;
+
+	//! Automation clips of the patterns looked up so far, as long as the arrangement revision doesn't change
+	std::vector<std::vector<PatternAutomation>> m_patternAutomation;
+	std::vector<bool> m_patternAutomationValid;
+
+	// what the index has been built for
+	const TrackContainer* m_container = nullptr;
+	int m_clipNum = -1;
+	unsigned m_revision = 0;
+	//! The index is valid from the start of the last clip started to the start of the next one
+	int m_validFrom = std::numeric_limits<int>::max();
+	int m_validUntil = std::numeric_limits<int>::min();
+};
+
+} // namespace lmms
+
+#endif // LMMS_ACTIVE_AUTOMATION_H
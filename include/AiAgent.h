@@ -9,12 +9,15 @@
 #include <QStringList>
 #include <functional>
 
+class QNetworkAccessManager;
+
 namespace lmms::gui
 {
 
 // Forward declarations
 class AiSidebar;
 class AiToolResult;
+class ProjectStateObserver;
 
 // Musical knowledge structures
 struct MusicalPattern {
@@ -87,16 +90,13 @@ signals:
     void executionCompleted(bool success, const QString& summary);
     void errorRecoveryNeeded(const QString& error, const QJsonArray& suggestions);
 
-private slots:
-    void onExecutionTimer();
-    void onStateUpdateTimer();
-
 private:
     // Core agent functions
     void analyzeUserIntent(const QString& message);
     QJsonObject extractMusicalParameters(const QString& message);
     QStringList identifyRequiredTools(const QString& intent);
     void executeNextStep();
+    void finishSequence(bool success, const QString& summary);
     
     // Intelligent analysis functions
     bool needsWebResearch(const QString& message);
@@ -197,12 +197,16 @@ private:
     QStringList m_criticalTools;
     
     // Execution state
-    QTimer* m_executionTimer;
-    QTimer* m_stateUpdateTimer;
+    ProjectStateObserver* m_stateObserver {nullptr};
+    QNetworkAccessManager* m_net; // Shared by all requests, so connections are reused
     QString m_currentSessionId;
     QJsonArray m_currentSequence;
     int m_currentStepIndex;
     int m_maxRetries;
+    bool m_sequenceRunning {false};
+    bool m_sequenceSucceeded {false};
+    QString m_sequenceSummary;
+    QString m_recoveryError;
     
     // Error tracking
     QHash<QString, int> m_errorHistory;
@@ -35,6 +35,8 @@ class AutomationClip;
 
 namespace lmms::gui {
 
+class ProjectStateObserver;
+
 // Symbolic project representation (Architecture principle #1)
 struct ProjectSnapshot {
     QString hash;
@@ -82,6 +84,7 @@ public:
 private slots:
     void onSend();
     void onNetworkFinished();
+    void onNetworkReadyRead();
     void onActionButtonClicked();
 
 private:
@@ -93,6 +96,8 @@ private:
     // GPT-5 request
     void sendToGPT5(const QString& message);
     bool processResponse(const QJsonObject& response);
+    void consumeStream(const QByteArray& data);
+    void handleStreamEvent(const QJsonObject& event);
 
     // Tool registry and execution
     QJsonArray getToolDefinitions() const;
@@ -124,6 +129,7 @@ private:
     AiToolResult toolGetTrackNotes(const QJsonObject& p);
     AiToolResult toolModifyNotes(const QJsonObject& p);
     AiToolResult toolAnalyzeBeforeWriting(const QJsonObject& p);
+    AiToolResult toolAnalyzeAudio(const QJsonObject& p);
     
     // Effect management tools
     AiToolResult toolListEffects(const QJsonObject& p);
@@ -246,6 +252,13 @@ private:
 
     std::unique_ptr<QNetworkAccessManager> m_net;
     QNetworkReply* m_reply {nullptr};
+    
+    // Responses are streamed as server-sent events: text is shown as it
+    // arrives, the complete response comes with the last event
+    QByteArray m_streamBuffer; // Bytes after the last complete event
+    QString m_streamText;
+    QLabel* m_streamLabel {nullptr};
+    QJsonObject m_streamedResponse;
     QJsonArray m_history; // chat-style messages
     QString m_apiKey;
     
@@ -254,6 +267,13 @@ private:
     int m_maxRetries {5};
     QString m_lastMessage;
     
+    // Requests continue the previous response, so they only carry what changed
+    // in the project since the last one that got through
+    ProjectStateObserver* m_stateObserver {nullptr};
+    QString m_previousResponseId;
+    quint64 m_sentStateVersion {0};
+    quint64 m_pendingStateVersion {0};
+    
     // Symbolic-first architecture state
     QHash<QString, ProjectSnapshot> m_snapshots; // Version control
     QList<ChangeOperation> m_pendingChanges;
@@ -0,0 +1,94 @@
+/*
+ * AudioAnalysis.h - tempo, key and loudness of audio, computed locally
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_AUDIO_ANALYSIS_H
+#define LMMS_AUDIO_ANALYSIS_H
+
+#include <array>
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <vector>
+
+#include "LmmsTypes.h"
+#include "SampleFrame.h"
+#include "lmms_export.h"
+
+namespace lmms
+{
+
+class SampleBuffer;
+
+/**
+ * The spectral flux of each window of @p windowSize frames of @p mono, i.e.
+ * how much the magnitudes of its spectrum changed from the window before.
+ * Peaks mark onsets, see
+ * http://www.iro.umontreal.ca/~pift6080/H09/documents/papers/bello_onset_tutorial.pdf
+ *
+ * Never zero, so ratios between windows can be taken.
+ */
+LMMS_EXPORT std::vector<float> spectralFlux(const float* mono, std::size_t frames, unsigned int windowSize);
+
+
+/**
+ * Estimates tempo, key and loudness of audio, without leaving the machine.
+ *
+ * The analyses run on the ThreadPool. Results are cached by the content of
+ * the audio, so analysing the same sample again, e.g. from another clip,
+ * returns at once.
+ */
+class LMMS_EXPORT AudioAnalysis
+{
+public:
+	struct Result
+	{
+		double duration = 0.0; //!< seconds
+
+		float bpm = 0.f; //!< 0 if there aren't enough onsets to tell
+		float bpmConfidence = 0.f; //!< 0 to 1
+		std::vector<double> onsets; //!< seconds
+
+		int key = -1; //!< pitch class of the tonic, 0 being C, -1 if there is no tonal content
+		bool minor = false;
+		float keyConfidence = 0.f; //!< correlation with the key profile, -1 to 1
+		std::array<float, 12> chroma{}; //!< energy per pitch class, the strongest being 1
+
+		float loudness = -70.f; //!< integrated loudness following ITU-R BS.1770, LUFS
+		float peak = -70.f; //!< sample peak, dBFS
+		float rms = -70.f; //!< dBFS
+	};
+
+	//! Analyses all frames of @p buffer, decoding it first if need be
+	static std::future<Result> analyze(std::shared_ptr<const SampleBuffer> buffer);
+	//! Analyses @p frames, e.g. rendered from a mixer channel
+	static std::future<Result> analyze(std::vector<SampleFrame> frames, sample_rate_t sampleRate);
+
+	//! Analyses on the calling thread, bypassing the cache
+	static Result compute(const SampleFrame* frames, std::size_t count, sample_rate_t sampleRate);
+
+	//! "C", "C#", ... for pitch class @p key
+	static const char* keyName(int key);
+};
+
+} // namespace lmms
+
+#endif // LMMS_AUDIO_ANALYSIS_H
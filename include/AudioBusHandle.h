@@ -26,17 +26,23 @@
 #ifndef LMMS_AUDIO_BUS_HANDLE_H
 #define LMMS_AUDIO_BUS_HANDLE_H
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <QString>
 #include <QMutex>
 
+#include "CompensationDelay.h"
+#include "CpuTime.h"
 #include "PlayHandle.h"
+#include "PlayHandleRegistry.h"
 
 namespace lmms
 {
 
 class EffectChain;
 class FloatModel;
+class FrozenAudio;
 class BoolModel;
 
 /**
@@ -60,6 +66,10 @@ public:
 
 	SampleFrame* buffer() { return m_buffer; }
 
+	//! Whether the buffer holds output which was sent to the mixer in the
+	//! last period, otherwise its content has to be considered silence
+	bool hasOutput() const { return m_hasOutput; }
+
 	// indicate whether JACK & Co should provide output-buffer at ext. port
 	bool extOutputEnabled() const { return m_extOutputEnabled; }
 	void setExtOutputEnabled(bool enabled);
@@ -75,6 +85,28 @@ public:
 	EffectChain* effects() { return m_effects.get(); }
 	bool processEffects();
 
+	//! Latency of the output sent to the mixer, without compensation
+	f_cnt_t latency() const;
+	//! Delays the output sent to the mixer to line it up with other paths, set by the mixer every period
+	void setCompensation(f_cnt_t frames) { m_compensation.setDelay(frames); }
+
+	//! Sends @p audio to the mixer instead of the play handles and effects while the song plays,
+	//! or the live output again if null
+	void setFrozenAudio(std::shared_ptr<const FrozenAudio> audio);
+	//! Sends @p audio, cached by an earlier export, to the mixer instead of the live output while
+	//! exporting, or the live output again if null. May only be changed while the audio engine isn't processing.
+	void setRenderCache(std::shared_ptr<const FrozenAudio> audio) { m_renderCache = std::move(audio); }
+	//! Whether frozen or cached audio replaces the live output in the current period
+	bool playsFrozenAudio() const;
+	//! Appends the output of every period to @p audio, or stops if null.
+	//! May only be changed while the audio engine isn't processing.
+	void setFreezeCapture(FrozenAudio* audio) { m_freezeCapture = audio; }
+
+	//! The time taken by the play handles, e.g. the voices of an instrument
+	CpuTime& playHandlesTime() { return m_playHandlesTime; }
+	//! The time taken by the volume, panning and effects applied to their sum
+	CpuTime& processingTime() { return m_processingTime; }
+
 	// ThreadableJob stuff
 	void doProcessing() override;
 	bool requiresProcessing() const override { return true; }
@@ -82,8 +114,34 @@ public:
 	void addPlayHandle(PlayHandle* handle);
 	void removePlayHandle(PlayHandle* handle);
 
+	//! Called by the play handles of this bus handle once they are done for
+	//! the current period. Queues this bus handle after the last one.
+	void playHandleProcessed();
+
 private:
+	// one pending reference is held by the audio engine while it is
+	// queueing the play handles, so we can't be queued too early
+	void beginPeriod() { m_pendingPlayHandles = 1; }
+	void addPendingPlayHandle() { ++m_pendingPlayHandles; }
+
+	void process();
+	//! The frozen or cached audio replacing the live output in the current period, if any
+	std::shared_ptr<const FrozenAudio> playedAudio() const;
+	//! Sends the frozen audio to the mixer, returns false if there is none for this period
+	bool processFrozen();
+
+	std::atomic_int m_pendingPlayHandles;
+	//! NUMA node whose workers process the play handles, see AudioEngine::renderStageProcessing()
+	std::size_t m_node = 0;
+	//! The last period this bus handle got scheduled in, see AudioEngine::renderStageProcessing()
+	std::uint64_t m_scheduledPeriod = 0;
+	//! Position among the bus handles scheduled in the current period, see AudioEngine::seedRandom()
+	std::uint64_t m_randomKey = 0;
+
 	volatile bool m_bufferUsage;
+	// whether m_buffer is known to contain nothing but zeros
+	bool m_bufferSilent;
+	bool m_hasOutput;
 
 	SampleFrame* const m_buffer;
 
@@ -93,14 +151,22 @@ private:
 	QString m_name;
 
 	std::unique_ptr<EffectChain> m_effects;
+	CompensationDelay m_compensation;
+
+	std::shared_ptr<const FrozenAudio> m_frozenAudio;
+	std::shared_ptr<const FrozenAudio> m_renderCache;
+	FrozenAudio* m_freezeCapture = nullptr;
 
-	PlayHandleList m_playHandles;
+	PlayHandleRegistry m_playHandles;
 	QMutex m_playHandleLock;
 
 	FloatModel* m_volumeModel;
 	FloatModel* m_panningModel;
 	BoolModel* m_mutedModel;
 
+	CpuTime m_playHandlesTime;
+	CpuTime m_processingTime;
+
 	friend class AudioEngine;
 	friend class AudioEngineWorkerThread;
 };
@@ -84,6 +84,13 @@ public:
 
 	virtual void stopProcessing();
 
+	//! Whether the driver calls AudioEngine::renderNextBuffer() right in its
+	//! callback, so the engine runs without its FIFO thread
+	virtual bool rendersInCallback() const
+	{
+		return false;
+	}
+
 protected:
 	// subclasses can re-implement this for being used in conjunction with
 	// processNextBuffer()
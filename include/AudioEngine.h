@@ -25,7 +25,9 @@
 #ifndef LMMS_AUDIO_ENGINE_H
 #define LMMS_AUDIO_ENGINE_H
 
+#include <atomic>
 #include <mutex>
+#include <utility>
 
 #include <QThread>
 #include <samplerate.h>
@@ -37,9 +39,11 @@
 #include "LmmsTypes.h"
 #include "SampleFrame.h"
 #include "LocklessList.h"
+#include "LocklessRingBuffer.h"
 #include "FifoBuffer.h"
 #include "AudioEngineProfiler.h"
 #include "PlayHandle.h"
+#include "PlayHandleRegistry.h"
 
 
 namespace lmms
@@ -48,10 +52,13 @@ namespace lmms
 class MidiClient;
 class AudioBusHandle;  // IWYU pragma: keep
 class AudioEngineWorkerThread;
+class XRunRecorder;
 
 constexpr fpp_t MINIMUM_BUFFER_SIZE = 32;
 constexpr fpp_t DEFAULT_BUFFER_SIZE = 256;
 constexpr fpp_t MAXIMUM_BUFFER_SIZE = 4096;
+//! Largest period size for offline rendering, see the "renderframesperperiod" setting
+constexpr fpp_t MAXIMUM_RENDER_BUFFER_SIZE = 16384;
 
 constexpr int BYTES_PER_SAMPLE = sizeof(sample_t);
 constexpr int BYTES_PER_INT_SAMPLE = sizeof(int_sample_t);
@@ -115,11 +122,34 @@ public:
 			SincBest
 		} ;
 
+		//! Renders the whole engine at a multiple of the output rate when
+		//! exporting, and decimates the periods before they're written
+		enum class Oversampling
+		{
+			None,
+			X2,
+			X4,
+			X8
+		} ;
+
 		Interpolation interpolation;
+		Oversampling oversampling;
+
+		qualitySettings(Interpolation i, Oversampling o = Oversampling::None) :
+			interpolation(i),
+			oversampling(o)
+		{
+		}
+
+		//! The number of times the output rate is doubled
+		int oversamplingStages() const
+		{
+			return static_cast<int>(oversampling);
+		}
 
-		qualitySettings(Interpolation i) :
-			interpolation(i)
+		int oversamplingFactor() const
 		{
+			return 1 << oversamplingStages();
 		}
 
 		int libsrcInterpolation() const
@@ -147,6 +177,53 @@ public:
 	// audio-device-stuff
 
 	bool renderOnly() const { return m_renderOnly; }
+
+	//! Whether the contributions to each mixer channel are summed in a fixed
+	//! order, so renders are bit-identical whatever the number of threads
+	bool isDeterministic() const { return m_deterministic; }
+	//! Must not be changed while the engine is running
+	void setDeterministic(bool deterministic) { m_deterministic = deterministic; }
+
+	//! What the key passed to seedRandom() identifies
+	enum class RandomDomain
+	{
+		Engine,
+		PlayHandle,
+		BusHandle,
+		MixerChannel,
+		//! Work shared by several jobs, done by whichever needs it first
+		Shared
+	};
+
+	//! In deterministic renders, restarts fastRand() of the calling thread
+	//! with a seed derived from @p key and the current period, so a job draws
+	//! the same numbers whichever thread runs it
+	void seedRandom(RandomDomain domain, std::uint64_t key) const;
+
+	//! Returns a key for seedRandom() with RandomDomain::Shared. Keys are
+	//! handed out in order, so objects created in the same order get the same
+	std::uint64_t newSharedRandomKey()
+	{
+		return m_sharedRandomKeys.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	//! Seeds fastRand() for RandomDomain::Shared while it lives and restores
+	//! the numbers of the job it interrupts after, which may or may not be the
+	//! one doing the shared work
+	class SharedRandomScope
+	{
+	public:
+		SharedRandomScope(const AudioEngine* audioEngine, std::uint64_t key);
+		~SharedRandomScope();
+
+		SharedRandomScope(const SharedRandomScope&) = delete;
+		SharedRandomScope& operator=(const SharedRandomScope&) = delete;
+
+	private:
+		bool m_seeded;
+		unsigned long m_jobState;
+	};
+
 	// Returns the current audio device's name. This is not necessarily
 	// the user's preferred audio device, in case you were thinking that.
 	inline const QString & audioDevName() const
@@ -200,18 +277,55 @@ public:
 
 	void removePlayHandle( PlayHandle* handle );
 
-	inline PlayHandleList& playHandles()
+	inline const PlayHandleList& playHandles() const
 	{
-		return m_playHandles;
+		return m_playHandles.handles();
 	}
 
 	void removePlayHandlesOfTypes(Track * track, PlayHandle::Types types);
 
 
 	// methods providing information for other classes
+	//! The number of frames of the period being rendered. It may change
+	//! between periods, but never exceeds maxFramesPerPeriod().
 	inline fpp_t framesPerPeriod() const
 	{
-		return m_framesPerPeriod;
+		return m_framesPerPeriod.load(std::memory_order_relaxed);
+	}
+
+	//! The longest period ever rendered, which buffers holding a period have
+	//! to be allocated for
+	fpp_t maxFramesPerPeriod() const
+	{
+		return m_maxFramesPerPeriod;
+	}
+
+	//! Render periods of @p frames frames from the next period on, at most
+	//! maxFramesPerPeriod(). Nothing is reallocated, and the audio device
+	//! keeps running.
+	void setFramesPerPeriod(fpp_t frames);
+
+	//! Render periods of @p frames frames while recording, if they are
+	//! shorter, so recorded input arrives earlier. 0 keeps the period size.
+	void setRecordingFramesPerPeriod(fpp_t frames);
+
+	//! Keeps periods at maxFramesPerPeriod() until as many calls to
+	//! releaseFramesPerPeriod(), for plugins which can't process periods of
+	//! varying length
+	void holdFramesPerPeriod()
+	{
+		m_framesPerPeriodHolds.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void releaseFramesPerPeriod()
+	{
+		m_framesPerPeriodHolds.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	//! Number of threads processing jobs, including the one running the audio engine
+	int numJobThreads() const
+	{
+		return m_numWorkers + 1;
 	}
 
 
@@ -230,6 +344,12 @@ public:
 		return m_profiler.detailLoad(type);
 	}
 
+	//! Keeps the last periods which missed their deadline, nullptr if disabled
+	XRunRecorder* xrunRecorder()
+	{
+		return m_xrunRecorder.get();
+	}
+
 	const qualitySettings & currentQualitySettings() const
 	{
 		return m_qualitySettings;
@@ -283,23 +403,57 @@ public:
 		return m_fifoWriter != nullptr;
 	}
 
+	//! Called by the audio device with captured frames. Lock-free, so it
+	//! can be called from the device's realtime callback.
 	void pushInputFrames( SampleFrame* _ab, const f_cnt_t _frames );
 
+	//! The input captured for the period being rendered
 	inline const SampleFrame* inputBuffer()
 	{
-		return m_inputBuffer[ m_inputBufferRead ];
+		return m_inputBuffer.get();
 	}
 
 	inline f_cnt_t inputBufferFrames() const
 	{
-		return m_inputBufferFrames[ m_inputBufferRead ];
+		return m_inputBufferFrames;
+	}
+
+	//! Mix the captured input into mixer channel @p channel in the period
+	//! it arrives in, or -1 to stop monitoring
+	void setInputMonitorChannel( int channel )
+	{
+		m_inputMonitorChannel = channel;
+	}
+
+	int inputMonitorChannel() const
+	{
+		return m_inputMonitorChannel;
+	}
+
+	//! Whether the master output is queued for displays like the oscilloscope
+	void setDisplayed(bool displayed)
+	{
+		m_displayed.store(displayed, std::memory_order_relaxed);
 	}
 
+	//! Copies the latest period of the master output into @p buffer, which
+	//! must hold maxFramesPerPeriod() frames, skipping older ones. Returns false
+	//! if no period was rendered since the last call. Must only be called by
+	//! one thread, usually the GUI thread.
+	bool readDisplayBuffer(SampleFrame* buffer);
+
 	inline const SampleFrame* nextBuffer()
 	{
 		return hasFifoWriter() ? m_fifo->read() : renderNextBuffer();
 	}
 
+	//! The number of frames of the period nextBuffer() returned last, which
+	//! the FIFO may have rendered before the period size changed
+	fpp_t nextBufferFrames() const
+	{
+		return hasFifoWriter() ? m_fifo->readFrames() : m_outputBufferReadFrames;
+	}
+
 	void changeQuality(const struct qualitySettings & qs);
 
 	//! Block until a change in model can be done (i.e. wait for audio thread)
@@ -318,11 +472,12 @@ public:
 signals:
 	void qualitySettingsChanged();
 	void sampleRateChanged();
-	void nextAudioBuffer(const lmms::SampleFrame* buffer);
+	//! Emitted from the rendering thread once periods of the new size are rendered
+	void framesPerPeriodChanged();
 
 
 private:
-	using Fifo = FifoBuffer<SampleFrame*>;
+	using Fifo = FifoBuffer;
 
 	class fifoWriter : public QThread
 	{
@@ -354,12 +509,21 @@ private:
 	MidiClient * tryMidiClients();
 
 	void renderStageNoteSetup();
-	void renderStageInstruments();
-	void renderStageEffects();
+	void renderStageProcessing();
 	void renderStageMix();
 
+	void removeFinishedPlayHandles();
+	//! Removes @p handle from all lists and deletes it
+	void deletePlayHandle(PlayHandle* handle);
+
 	const SampleFrame* renderNextBuffer();
 
+	//! Switches to the requested period size, between two periods
+	void updateFramesPerPeriod();
+
+	//! Keeps what was going on in the period which just missed its deadline
+	void recordXRun();
+
 	void swapBuffers();
 
 	void clearInternal();
@@ -368,27 +532,62 @@ private:
 
 	std::vector<AudioBusHandle*> m_audioBusHandles;
 
-	fpp_t m_framesPerPeriod;
+	std::atomic<fpp_t> m_framesPerPeriod;
+	fpp_t m_maxFramesPerPeriod;
+	std::atomic<fpp_t> m_requestedFramesPerPeriod;
+	std::atomic<fpp_t> m_recordingFramesPerPeriod;
+	std::atomic<int> m_framesPerPeriodHolds = 0;
 
-	SampleFrame* m_inputBuffer[2];
-	f_cnt_t m_inputBufferFrames[2];
-	f_cnt_t m_inputBufferSize[2];
 	sample_rate_t m_baseSampleRate;
-	int m_inputBufferRead;
-	int m_inputBufferWrite;
+
+	// captured input: the device writes into the ring, which is drained
+	// into the input buffer at the start of each period, at most one
+	// period at a time
+	LocklessRingBuffer<SampleFrame> m_inputRing;
+	LocklessRingBufferReader<SampleFrame> m_inputRingReader;
+	std::unique_ptr<SampleFrame[]> m_inputBuffer;
+	f_cnt_t m_inputBufferFrames;
+	//! Input left in the ring beyond this is skipped, so it can't add latency
+	f_cnt_t m_inputBacklogLimit;
+	std::atomic<int> m_inputMonitorChannel;
 
 	std::unique_ptr<SampleFrame[]> m_outputBufferRead;
 	std::unique_ptr<SampleFrame[]> m_outputBufferWrite;
+	//! The periods in the output buffers, rendered at different sizes after a switch
+	fpp_t m_outputBufferReadFrames;
+	fpp_t m_outputBufferWriteFrames;
+
+	// the master output is queued for the displays, which only read the
+	// latest period whenever they repaint
+	std::atomic<bool> m_displayed;
+	LocklessRingBuffer<SampleFrame> m_displayRing;
+	LocklessRingBufferReader<SampleFrame> m_displayRingReader;
 
 	// worker thread stuff
 	std::vector<AudioEngineWorkerThread *> m_workers;
 	int m_numWorkers;
+	//! Workers which only help while rendering offline, started after the other ones
+	int m_numRenderWorkers;
+
+	bool m_deterministic;
 
 	// playhandle stuff
-	PlayHandleList m_playHandles;
+	PlayHandleRegistry m_playHandles;
+	//! The handles of m_playHandles by PlayHandle::typeIndex()
+	std::vector<PlayHandleRegistry> m_playHandlesOfType;
 	// place where new playhandles are added temporarily
 	LocklessList<PlayHandle *> m_newPlayHandles;
 	ConstPlayHandleList m_playHandlesToRemove;
+	// jobs rendering all notes of a track, see Instrument::Flag::BatchesNotes,
+	// with the lane to queue them in
+	std::vector<std::pair<ThreadableJob*, std::size_t>> m_noteBatches;
+	//! Jobs queued on every NUMA node in the current period
+	std::vector<std::size_t> m_nodeJobs;
+	//! The bus handles waited for in the current period, including those of
+	//! play handles whose bus handle isn't registered (yet or anymore)
+	std::vector<AudioBusHandle*> m_scheduledBusHandles;
+	std::uint64_t m_schedulingPeriod = 0;
+	std::atomic<std::uint64_t> m_sharedRandomKeys = 0;
 
 
 	struct qualitySettings m_qualitySettings;
@@ -410,6 +609,7 @@ private:
 	fifoWriter * m_fifoWriter;
 
 	AudioEngineProfiler m_profiler;
+	std::unique_ptr<XRunRecorder> m_xrunRecorder;
 
 	bool m_clearSignal;
 
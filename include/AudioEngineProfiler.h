@@ -27,6 +27,10 @@
 
 #include <array>
 #include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
 #include <QFile>
 
 #include "LmmsTypes.h"
@@ -39,14 +43,28 @@ class AudioEngineProfiler
 {
 public:
 	AudioEngineProfiler();
-	~AudioEngineProfiler() = default;
+	~AudioEngineProfiler();
 
 	void startPeriod()
 	{
 		m_periodTimer.reset();
+		m_period.store(m_period.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
 	}
 
-	void finishPeriod( sample_rate_t sampleRate, fpp_t framesPerPeriod );
+	//! Returns whether the period took longer than playing it back does
+	bool finishPeriod( sample_rate_t sampleRate, fpp_t framesPerPeriod );
+
+	//! Microseconds the last period took
+	int periodTime() const
+	{
+		return m_periodTime;
+	}
+
+	//! Counts the periods started so far
+	std::uint64_t period() const
+	{
+		return m_period.load(std::memory_order_relaxed);
+	}
 
 	int cpuLoad() const
 	{
@@ -57,8 +75,7 @@ public:
 
 	enum class DetailType {
 		NoteSetup,
-		Instruments,
-		Effects,
+		Instruments, // including effects and mixer channels, which are processed in parallel
 		Mixing,
 		Count
 	};
@@ -70,12 +87,118 @@ public:
 		return m_detailLoad[static_cast<std::size_t>(type)].load(std::memory_order_relaxed);
 	}
 
+	//! Microseconds the stage took in the last period
+	int detailTime(const DetailType type) const
+	{
+		return m_detailTime[static_cast<std::size_t>(type)];
+	}
+
+	//! Times accumulated since the last resetTotals(), in microseconds
+	struct Totals
+	{
+		std::uint64_t periods = 0;
+		std::uint64_t frames = 0;
+		std::uint64_t periodTime = 0;
+		std::array<std::uint64_t, DetailCount> detailTime{};
+	};
+
+	//! Only safe to call while the audio engine isn't processing
+	const Totals& totals() const
+	{
+		return m_totals;
+	}
+
+	void resetTotals()
+	{
+		m_totals = Totals{};
+	}
+
+	//! Start writing per-job timings as Chrome trace / Perfetto JSON to \p outputFile
+	bool startTracing(const QString& outputFile);
+	//! Flush all pending events and close the trace file
+	void stopTracing();
+
+	bool isTracing() const
+	{
+		return m_tracing.load(std::memory_order_relaxed);
+	}
+
+	//! Number of events that got lost because a thread's trace buffer was full
+	std::size_t droppedTraceEvents() const
+	{
+		return m_droppedTraceEvents.load(std::memory_order_relaxed);
+	}
+
+	//! How long a job recorded by a TraceScope took
+	struct JobTime
+	{
+		const char* category = nullptr;
+		const char* name = nullptr;
+		std::uintptr_t id = 0;
+		std::int64_t duration = 0; // ns
+	};
+
+	static constexpr std::size_t SlowestJobCount = 8;
+	using SlowestJobs = std::array<JobTime, SlowestJobCount>;
+
+	//! Time the jobs of every period, for slowestJobs(), independently of tracing
+	void setTimingJobs(bool timing)
+	{
+		m_timingJobs.store(timing, std::memory_order_relaxed);
+	}
+
+	bool isTimingJobs() const
+	{
+		return m_timingJobs.load(std::memory_order_relaxed);
+	}
+
+	/*! \brief Fills \p jobs with the slowest jobs of the current period, the slowest first
+	 *
+	 * Returns how many there are. Must only be called by the thread rendering
+	 * the period, once all of its jobs are done.
+	 */
+	std::size_t slowestJobs(SlowestJobs& jobs) const;
+
+	/*! \brief Records the wall time of the enclosing scope as one trace event
+	 *
+	 * Costs two relaxed loads if neither tracing nor timing jobs. \p category
+	 * and \p name must be string literals or otherwise outlive the trace, as
+	 * only the pointers are stored. \p id tells apart jobs sharing the same name.
+	 */
+	class TraceScope
+	{
+	public:
+		TraceScope(AudioEngineProfiler& profiler, const char* category, const char* name, std::uintptr_t id = 0)
+			: m_profiler(profiler.isTracing() || profiler.isTimingJobs() ? &profiler : nullptr)
+			, m_category(category)
+			, m_name(name)
+			, m_id(id)
+			, m_begin(m_profiler ? m_profiler->traceClock() : 0)
+		{
+		}
+		~TraceScope()
+		{
+			if (m_profiler) { m_profiler->addTraceEvent(m_category, m_name, m_id, m_begin); }
+		}
+		TraceScope& operator=(const TraceScope&) = delete;
+		TraceScope(const TraceScope&) = delete;
+		TraceScope(TraceScope&&) = delete;
+
+	private:
+		AudioEngineProfiler* const m_profiler;
+		const char* const m_category;
+		const char* const m_name;
+		const std::uintptr_t m_id;
+		const std::int64_t m_begin;
+	};
+
 	class Probe
 	{
 	public:
 		Probe(AudioEngineProfiler& profiler, AudioEngineProfiler::DetailType type)
 			: m_profiler(profiler)
 			, m_type(type)
+			, m_trace(profiler, "Stage", detailName(type))
 		{
 			profiler.startDetail(type);
 		}
@@ -87,9 +210,53 @@ public:
 	private:
 		AudioEngineProfiler &m_profiler;
 		const AudioEngineProfiler::DetailType m_type;
+		const TraceScope m_trace;
 	};
 
+	static const char* detailName(DetailType type);
+
 private:
+	struct TraceEvent
+	{
+		const char* category;
+		const char* name;
+		std::uintptr_t id;
+		std::int64_t begin; // ns since trace start
+		std::int64_t end;
+	};
+
+	//! Single producer/single consumer ring of events, one per recording thread
+	struct alignas(64) TraceLane
+	{
+		static constexpr std::size_t Size = 4096;
+		std::array<TraceEvent, Size> events;
+		alignas(64) std::atomic<std::size_t> writeIndex{0};
+		alignas(64) std::atomic<std::size_t> readIndex{0};
+	};
+
+	static constexpr std::size_t MaxTraceLanes = 64;
+
+	//! The slowest jobs a thread processed in one period
+	struct alignas(64) JobLane
+	{
+		std::uint64_t period = 0;
+		std::size_t count = 0;
+		SlowestJobs jobs{};
+	};
+
+	std::int64_t traceClock() const
+	{
+		using namespace std::chrono;
+		return duration_cast<nanoseconds>(steady_clock::now() - m_traceStart).count();
+	}
+
+	void addTraceEvent(const char* category, const char* name, std::uintptr_t id, std::int64_t begin);
+	TraceLane* currentTraceLane();
+	JobLane* currentJobLane();
+	void addJobTime(const JobTime& job);
+	void drainTrace();
+	void traceWriter();
+
 	void startDetail(const DetailType type) { m_detailTimer[static_cast<std::size_t>(type)].reset(); }
 	void finishDetail(const DetailType type)
 	{
@@ -97,6 +264,7 @@ private:
 	}
 
 	MicroTimer m_periodTimer;
+	int m_periodTime = 0;
 	std::atomic<float> m_cpuLoad;
 	QFile m_outputFile;
 
@@ -104,6 +272,27 @@ private:
 	std::array<MicroTimer, DetailCount> m_detailTimer;
 	std::array<int, DetailCount> m_detailTime{0};
 	std::array<std::atomic<float>, DetailCount> m_detailLoad{0};
+	Totals m_totals;
+
+	// Tracing state. Lanes are only allocated while a trace is running.
+	std::atomic<bool> m_tracing{false};
+	std::atomic<bool> m_traceWriterQuit{false};
+	std::atomic<int> m_activeTraceRecorders{0};
+	std::chrono::steady_clock::time_point m_traceStart;
+	std::unique_ptr<TraceLane[]> m_traceLanes;
+	std::atomic<std::size_t> m_usedTraceLanes{0};
+	std::atomic<unsigned> m_traceGeneration{0};
+	std::atomic<std::size_t> m_droppedTraceEvents{0};
+	std::thread m_traceWriter;
+	QFile m_traceFile;
+	bool m_firstTraceEvent = true;
+
+	// Job timing state. Lanes are kept for the lifetime of the profiler, as
+	// threads rendering periods only come and go with audio devices.
+	std::atomic<bool> m_timingJobs{false};
+	std::atomic<std::uint64_t> m_period{0};
+	std::unique_ptr<JobLane[]> m_jobLanes;
+	std::atomic<std::size_t> m_usedJobLanes{0};
 };
 
 } // namespace lmms
@@ -27,7 +27,16 @@
 
 #include <QThread>
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "RealtimeThread.h"
 
 class QWaitCondition;
 
@@ -42,6 +51,13 @@ class AudioEngineWorkerThread : public QThread
 	Q_OBJECT
 public:
 	// internal representation of the job queue - all functions are thread-safe
+	//
+	// Every worker thread owns one lane. A thread pushes jobs it creates while
+	// processing (e.g. mixer channels whose dependencies are met) into its own
+	// lane and pops from it first; when its lane runs dry it steals from the
+	// other lanes. This way the threads do not all hammer one shared counter.
+	// The rendering thread uses the lane of the worker it processes inline,
+	// any other thread one more lane, which is shared and locked for writing.
 	class JobQueue
 	{
 	public:
@@ -54,30 +70,88 @@ public:
 		static constexpr size_t JOB_QUEUE_SIZE = 8192;
 
 		JobQueue() :
-			m_items(),
-			m_writeIndex( 0 ),
-			m_itemsDone( 0 ),
+			m_lanes(),
+			m_epoch( 0 ),
 			m_opMode( OperationMode::Static )
 		{
-			std::fill(m_items, m_items + JOB_QUEUE_SIZE, nullptr);
 		}
 
+		//! Sets the number of worker lanes, the shared lane comes on top.
+		//! Must only be called while no worker thread is running
+		void setNumLanes( size_t _numLanes );
+		//! Groups the first lanes by the NUMA node (any number) of their
+		//! threads, so threads steal jobs from lanes of their own node first.
+		//! Must only be called while no worker thread is running
+		void setLaneNodes( const std::vector<size_t>& _nodes );
+
+		//! Number of nodes the lanes are grouped into, at least 1
+		size_t numNodes() const { return std::max<size_t>( m_nodeLanes.size(), 1 ); }
+		//! The @p _index th lane of @p _node (both modulo their count)
+		size_t nodeLane( size_t _node, size_t _index ) const;
+
 		void reset( OperationMode _opMode );
 
-		void addJob( ThreadableJob * _job );
+		//! Queue the job in the lane of the calling thread
+		bool addJob( ThreadableJob * _job );
+		//! Queue the job in the given lane (modulo number of lanes), used to
+		//! spread jobs across all workers when filling the queue
+		//! @return whether the job was queued, i.e. requires processing
+		bool addJob( ThreadableJob * _job, size_t _lane );
 
 		void run();
 		void wait();
+		//! Processes queued jobs until all of @p jobs are done
+		void runUntilDone( std::span<ThreadableJob* const> _jobs );
+		//! Processes one queued job, returns false if there was none
+		bool runOne();
 
 	private:
-		std::atomic<ThreadableJob*> m_items[JOB_QUEUE_SIZE];
-		std::atomic_size_t m_writeIndex;
-		std::atomic_size_t m_itemsDone;
+		static constexpr size_t CacheLineSize = 64;
+
+		struct alignas(CacheLineSize) Lane
+		{
+			Lane();
+
+			//! Claims the next unprocessed job in this lane, or returns nullptr
+			ThreadableJob* take();
+
+			std::atomic<ThreadableJob*> m_items[JOB_QUEUE_SIZE];
+
+			// only written by the thread owning the lane
+			alignas(CacheLineSize) std::atomic_size_t m_writeIndex;
+			std::atomic_size_t m_itemsDone;
+
+			// index of the first job that might not have been claimed yet,
+			// tagged with the queue epoch in the upper 32 bits so that a
+			// stale hint can never survive a reset()
+			alignas(CacheLineSize) std::atomic<std::uint64_t> m_readHint;
+		} ;
+
+		ThreadableJob* takeJob( size_t _ownLane );
+		size_t currentLane() const;
+		size_t sharedLane() const { return m_lanes.size() - 1; }
+		bool push( ThreadableJob * _job, size_t _lane );
+		bool isDone() const;
+		void updateStealOrder();
+
+		std::vector<std::unique_ptr<Lane>> m_lanes;
+		//! Node of every lane, lanes beyond it belong to none
+		std::vector<size_t> m_laneNodes;
+		//! Lanes of every node
+		std::vector<std::vector<size_t>> m_nodeLanes;
+		//! Lanes to take jobs from by every lane, its own one first
+		std::vector<std::vector<size_t>> m_stealOrder;
+		std::uint32_t m_epoch;
 		OperationMode m_opMode;
+		//! Taken while writing to the shared lane, which has any number of writers
+		std::atomic_flag m_sharedLaneLock = ATOMIC_FLAG_INIT;
 	} ;
 
 
-	AudioEngineWorkerThread( AudioEngine* audioEngine );
+	//! @param cpu core to keep the thread on, by default it's only pinned once promoted
+	//! @param offline whether the thread only helps while rendering offline, see setRenderingOffline()
+	AudioEngineWorkerThread( AudioEngine* audioEngine, std::optional<unsigned> cpu = std::nullopt,
+		bool offline = false );
 	~AudioEngineWorkerThread() override;
 
 	virtual void quit();
@@ -88,9 +162,30 @@ public:
 		globalJobQueue.reset( _opMode );
 	}
 
-	static void addJob( ThreadableJob * _job )
+	static bool addJob( ThreadableJob * _job )
+	{
+		return globalJobQueue.addJob( _job );
+	}
+
+	static bool addJob( ThreadableJob * _job, size_t _lane )
 	{
-		globalJobQueue.addJob( _job );
+		return globalJobQueue.addJob( _job, _lane );
+	}
+
+	static void setLaneNodes( const std::vector<size_t>& _nodes )
+	{
+		globalJobQueue.setLaneNodes( _nodes );
+	}
+
+	static size_t numNodes()
+	{
+		return globalJobQueue.numNodes();
+	}
+
+	// lane to queue the @p _index th job of a group of jobs kept on @p _node
+	static size_t nodeLane( size_t _node, size_t _index )
+	{
+		return globalJobQueue.nodeLane( _node, _index );
 	}
 
 	// a convenient helper function allowing to pass a container with pointers
@@ -100,23 +195,92 @@ public:
 							JobQueue::OperationMode _opMode = JobQueue::OperationMode::Static )
 	{
 		resetJobQueue( _opMode );
+		size_t lane = 0;
 		for (const auto& job : _vec)
 		{
-			addJob(job);
+			addJob(job, lane++);
 		}
 	}
 
 	static void startAndWaitForJobs();
 
+	// makes the calling thread use the lane of the worker processed inline
+	// while it renders, see AudioEngine::renderNextBuffer()
+	static void setRenderingThread( bool _rendering );
+
+	// gives the calling thread real-time scheduling and the worker threads
+	// the same priority, each pinned to its own core, when they wake up next;
+	// used when a driver renders in its own callback
+	static void promoteWithCurrentThread();
+
+	// sets the priority (0 for the middle of the range) and policy used when
+	// promoting threads to real-time scheduling
+	static void setRealtimeScheduling( int priority, RealtimePolicy policy );
+
+	// sets how long workers keep looking for new jobs before going to sleep,
+	// so they stay awake between the stages of a period
+	static void setSpinTime( std::chrono::microseconds time )
+	{
+		s_spinTime = time;
+	}
+
+	// wakes the workers dedicated to offline rendering along with the other
+	// ones while set, e.g. while exporting; their lanes are stolen from otherwise
+	static void setRenderingOffline( bool offline )
+	{
+		s_renderingOffline.store( offline, std::memory_order_relaxed );
+	}
+
+	// number of workers waiting for jobs instead of looking for them
+	static int sleepingWorkers()
+	{
+		return s_sleepingWorkers.load( std::memory_order_relaxed );
+	}
+
+	// lets a job wait for the jobs it queued without blocking its thread:
+	// processes queued jobs until all of the given jobs are done
+	static void waitForJobs( std::span<ThreadableJob* const> _jobs )
+	{
+		globalJobQueue.runUntilDone( _jobs );
+	}
+
+	// lets a job which waits for something outside of the queue, e.g. a
+	// remote process, help with the queued jobs meanwhile: processes them
+	// while the predicate holds and there are any left
+	template<typename F>
+	static void runJobsWhile( F&& _pending )
+	{
+		while( _pending() && globalJobQueue.runOne() ) {}
+	}
+
 
 private:
 	void run() override;
 
+	//! Whether startAndWaitForJobs() was called since @p generation and concerns this worker
+	bool hasNewJobs( std::uint32_t generation ) const;
+	//! Waits for the next call of startAndWaitForJobs() after @p generation
+	void awaitJobs( std::uint32_t generation );
+
 	static JobQueue globalJobQueue;
 	static QWaitCondition * queueReadyWaitCond;
+	static QWaitCondition * offlineReadyWaitCond;
 	static QList<AudioEngineWorkerThread *> workerThreads;
+	static std::atomic_int s_realtimePriority;
+	static std::atomic_bool s_renderingOffline;
+	//! Counts the calls of startAndWaitForJobs()
+	static std::atomic<std::uint32_t> s_generation;
+	static std::atomic_int s_sleepingWorkers;
+	static std::atomic_int s_sleepingOfflineWorkers;
+	static std::chrono::microseconds s_spinTime;
+	static int s_configuredPriority;
+	static RealtimePolicy s_realtimePolicy;
 
+	const size_t m_lane;
+	const std::optional<unsigned> m_cpu;
+	const bool m_offline;
 	volatile bool m_quit;
+	int m_realtimePriority;
 } ;
 
 } // namespace lmms
@@ -28,6 +28,11 @@
 
 #include <QFile>
 
+#include <cstdint>
+#include <vector>
+
+#include <sndfile.h>
+
 #include "AudioDevice.h"
 #include "OutputSettings.h"
 
@@ -49,10 +54,36 @@ public:
 
 	OutputSettings const & getOutputSettings() const { return m_outputSettings; }
 
+	// allow writing buffers which don't come from the audio engine's output,
+	// e.g. the individual tracks of a stem export
+	using AudioDevice::writeBuffer;
+
+	//! Writes what has been buffered so far to the file. Called by the
+	//! thread writing the buffers, or once it's done.
+	void flushOutput();
+
+	struct WriteStats
+	{
+		std::uint64_t bytes;
+		std::uint64_t writes;
+		//! Time spent in writing to files, not in encoding
+		double seconds;
+	};
+
+	//! What all file devices have written to their files since LMMS started
+	static WriteStats writeStats();
+
 
 protected:
+	//! Buffers @p data, which is written to the file in large chunks, so
+	//! encoding a period doesn't take a system call (or a network round
+	//! trip, on network mounts)
 	int writeData( const void* data, int len );
 
+	//! Opens a libsndfile stream writing through writeData(), so it's
+	//! buffered like the other encoders and works with any file name
+	SNDFILE* openSndFile(SF_INFO* info);
+
 	inline bool outputFileOpened() const
 	{
 		return m_outputFile.isOpen();
@@ -64,8 +95,26 @@ protected:
 	}
 
 private:
+	//! Size of the chunks written, a multiple of the page size
+	static constexpr std::size_t BufferSize = std::size_t{4} << 20;
+
+	static sf_count_t sndFileLength(void* device);
+	static sf_count_t sndFileSeek(sf_count_t offset, int whence, void* device);
+	static sf_count_t sndFileRead(void* data, sf_count_t size, void* device);
+	static sf_count_t sndFileWrite(const void* data, sf_count_t size, void* device);
+	static sf_count_t sndFileTell(void* device);
+
+	void adviseWritten(qint64 begin, qint64 end);
+
 	QFile m_outputFile;
 	OutputSettings m_outputSettings;
+
+	std::vector<char> m_buffer;
+	//! Whether the pages written are dropped from the page cache, see adviseWritten()
+	bool m_dropWrittenPages;
+	//! Range written last, whose writeback has been started but not waited for
+	qint64 m_pendingBegin = 0;
+	qint64 m_pendingEnd = 0;
 } ;
 
 using AudioFileDeviceInstantiaton
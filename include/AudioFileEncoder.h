@@ -0,0 +1,77 @@
+/*
+ * AudioFileEncoder.h - encodes into an AudioFileDevice on its own thread
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_AUDIO_FILE_ENCODER_H
+#define LMMS_AUDIO_FILE_ENCODER_H
+
+#include <QThread>
+
+#include <vector>
+
+#include "FifoBuffer.h"
+
+
+namespace lmms
+{
+
+class AudioFileDevice;
+
+
+/**
+	Moves encoding off the thread that renders
+
+	Periods passed to write() are copied into a bounded FIFO. The encoder
+	thread collects them into batches of a few periods and hands each batch
+	to the file device at once. The renderer only waits when the encoder
+	falls a whole FIFO behind.
+*/
+class AudioFileEncoder : public QThread
+{
+public:
+	//! Starts encoding into @p device, which must outlive this object
+	AudioFileEncoder(AudioFileDevice* device, fpp_t framesPerPeriod);
+	~AudioFileEncoder() override;
+
+	//! Queue one period for encoding
+	void write(const SampleFrame* buffer);
+
+	//! Encode everything queued so far and stop the thread
+	void finish();
+
+
+private:
+	void run() override;
+
+	static constexpr int FifoPeriods = 16;
+	static constexpr int BatchPeriods = 8;
+
+	AudioFileDevice* m_device;
+	const fpp_t m_frames;
+	FifoBuffer m_fifo;
+	std::vector<SampleFrame> m_batch;
+	bool m_finished;
+} ;
+
+
+} // namespace lmms
+
+#endif // LMMS_AUDIO_FILE_ENCODER_H
@@ -28,6 +28,7 @@
 #include "lmmsconfig.h"
 
 #include "AudioFileDevice.h"
+#include "SampleConversion.h"
 #include <sndfile.h>
 
 namespace lmms
@@ -64,6 +65,7 @@ private:
 
 	SF_INFO  m_sfinfo;
 	SNDFILE* m_sf;
+	SampleConversion::DitherState m_dither;
 
 	void writeBuffer(const SampleFrame* _ab, fpp_t const frames) override;
 
@@ -28,6 +28,7 @@
 
 #include "lmmsconfig.h"
 #include "AudioFileDevice.h"
+#include "SampleConversion.h"
 
 #include <sndfile.h>
 
@@ -64,6 +65,7 @@ private:
 private:
 	SF_INFO m_si;
 	SNDFILE * m_sf;
+	SampleConversion::DitherState m_dither;
 } ;
 
 
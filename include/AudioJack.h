@@ -46,6 +46,7 @@
 #include "AudioBusHandle.h"
 #endif
 
+class QCheckBox;
 class QLineEdit;
 class QMenu;
 class QToolButton;
@@ -89,6 +90,7 @@ public:
 
 	private:
 		QLineEdit* m_clientName;
+		QCheckBox* m_renderInCallback;
 		// Because we do not have access to a JackAudio driver instance we have to be our own client to display inputs and outputs...
 		jack_client_t* m_client;
 
@@ -109,6 +111,7 @@ private:
 
 	void startProcessing() override;
 	void stopProcessing() override;
+	bool rendersInCallback() const override { return m_renderInCallback; }
 
 	void registerPort(AudioBusHandle* port) override;
 	void unregisterPort(AudioBusHandle* port) override;
@@ -123,6 +126,9 @@ private:
 
 	bool m_active;
 	std::atomic<bool> m_stopped;
+	std::atomic<bool> m_inCallback = false;
+	const bool m_renderInCallback;
+	bool m_callbackPromoted = false;
 
 	std::atomic<MidiJack*> m_midiClient;
 	std::vector<jack_port_t*> m_outputPorts;
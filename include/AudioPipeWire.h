@@ -0,0 +1,132 @@
+/*
+ * AudioPipeWire.h - device-class that performs PCM-output via PipeWire
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_AUDIO_PIPEWIRE_H
+#define LMMS_AUDIO_PIPEWIRE_H
+
+#include "lmmsconfig.h"
+
+#ifdef LMMS_HAVE_PIPEWIRE
+
+#include <pipewire/pipewire.h>
+
+#include <atomic>
+#include <vector>
+
+#ifdef AUDIO_BUS_HANDLE_SUPPORT
+#include <map>
+#include <memory>
+#endif
+
+#include "AudioDevice.h"
+#include "AudioDeviceSetupWidget.h"
+
+class QCheckBox;
+class QLineEdit;
+
+namespace lmms
+{
+
+/**
+	Plays through a PipeWire stream
+
+	The stream asks for 32 bit float planar samples at the engine's rate,
+	which is what LMMS renders, so PipeWire has nothing to convert unless
+	the graph runs at another rate. Periods are written in the stream's
+	real-time process callback, like AudioJack does.
+*/
+class AudioPipeWire : public AudioDevice
+{
+public:
+	AudioPipeWire(bool& successful, AudioEngine* audioEngine);
+	~AudioPipeWire() override;
+
+	inline static QString name()
+	{
+		return QT_TRANSLATE_NOOP("AudioDeviceSetupWidget", "PipeWire");
+	}
+
+	//! Node name LMMS shows up with in the PipeWire graph
+	static QString probeDevice();
+
+	class setupWidget : public gui::AudioDeviceSetupWidget
+	{
+	public:
+		setupWidget(QWidget* parent);
+		void saveSettings() override;
+
+	private:
+		QLineEdit* m_clientName;
+		QCheckBox* m_renderInCallback;
+	};
+
+private:
+	void startProcessing() override;
+	void stopProcessing() override;
+	bool rendersInCallback() const override { return m_renderInCallback; }
+
+	void registerPort(AudioBusHandle* port) override;
+	void unregisterPort(AudioBusHandle* port) override;
+	void renamePort(AudioBusHandle* port) override;
+
+	//! Creates a stream playing 32 bit float planar samples at our rate
+	pw_stream* createStream(const QString& name, const pw_stream_events* events, void* data, spa_hook* listener);
+	void setActive(bool active);
+
+	void processCallback();
+	static void staticProcessCallback(void* data);
+
+	pw_thread_loop* m_loop;
+	pw_context* m_context;
+	pw_core* m_core;
+	pw_stream* m_stream;
+	spa_hook m_streamListener;
+
+	const bool m_renderInCallback;
+	bool m_callbackPromoted;
+	std::atomic<bool> m_stopped;
+	std::atomic<bool> m_inCallback;
+
+	std::vector<SampleFrame> m_outBuf;
+	f_cnt_t m_outBufPos;
+	f_cnt_t m_outBufSize;
+
+#ifdef AUDIO_BUS_HANDLE_SUPPORT
+	//! Extra stream carrying the output of one AudioBusHandle
+	struct BusStream
+	{
+		AudioBusHandle* handle;
+		pw_stream* stream;
+		spa_hook listener;
+	};
+
+	static void busProcessCallback(void* data);
+
+	std::map<AudioBusHandle*, std::unique_ptr<BusStream>> m_busStreams;
+#endif
+};
+
+} // namespace lmms
+
+#endif // LMMS_HAVE_PIPEWIRE
+
+#endif // LMMS_AUDIO_PIPEWIRE_H
@@ -27,6 +27,8 @@
 
 #include <QObject>
 
+class QCheckBox;
+
 #include "lmmsconfig.h"
 #include "ComboBoxModel.h"
 
@@ -97,6 +99,7 @@ public:
 	private:
 		gui::ComboBox * m_backend;
 		gui::ComboBox * m_device;
+		QCheckBox * m_renderInCallback;
 		AudioPortAudioSetupUtil m_setupUtil;
 
 	} ;
@@ -104,6 +107,7 @@ public:
 private:
 	void startProcessing() override;
 	void stopProcessing() override;
+	bool rendersInCallback() const override { return m_renderInCallback; }
 
 #ifdef PORTAUDIO_V19
 	static int _process_callback( const void *_inputBuffer, void * _outputBuffer,
@@ -151,6 +155,9 @@ private:
 
 	bool m_stopped;
 
+	const bool m_renderInCallback;
+	bool m_callbackPromoted;
+
 } ;
 
 #endif // LMMS_HAVE_PORTAUDIO
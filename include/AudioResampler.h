@@ -53,6 +53,8 @@ public:
 	auto interpolationMode() const -> int { return m_interpolationMode; }
 	auto channels() const -> int { return m_channels; }
 	void setRatio(double ratio);
+	//! Forgets about previous input
+	void reset();
 
 private:
 	int m_interpolationMode = -1;
@@ -25,7 +25,11 @@
 #ifndef LMMS_AUTOMATABLE_MODEL_H
 #define LMMS_AUTOMATABLE_MODEL_H
 
+#include <array>
+#include <atomic>
 #include <cmath>
+#include <utility>
+#include <vector>
 #include <QMap>
 #include <QMutex>
 
@@ -169,6 +173,8 @@ public:
 		return castValue<T>( m_value );
 	}
 
+	//! Value of the controller or the model linked to this one, the value at the start of
+	//! the period is only calculated once per period, or when something it depends on changes
 	float controllerValue( int frameOffset ) const;
 
 	//! @brief Function that returns sample-exact data as a ValueBuffer
@@ -212,6 +218,9 @@ public:
 	void setInitValue( const float value );
 
 	void setAutomatedValue( const float value );
+	//! Sets the automated @p value and ramps the value buffer from it to @p target
+	//! within the following @p frames, so automation doesn't step once per tick
+	void setAutomatedRamp( const float value, const float target, const f_cnt_t frames );
 	void setValue( const float value );
 
 	void incValue( int steps )
@@ -227,6 +236,7 @@ public:
 	void setRange( const float min, const float max, const float step = 1 );
 	void setScaleType( ScaleType sc ) {
 		m_scaleType = sc;
+		invalidateControllerValue();
 	}
 	void setScaleLogarithmic( bool setToTrue = true )
 	{
@@ -299,16 +309,28 @@ public:
 	void setStrictStepSize( const bool b )
 	{
 		m_hasStrictStepSize = b;
+		invalidateControllerValue();
 	}
 
-	static void incrementPeriodCounter()
+	//! Counts the period of @p frames frames which was just rendered
+	static void incrementPeriodCounter(fpp_t frames)
 	{
 		++s_periodCounter;
+		s_periodStartFrame += static_cast<long long>(frames);
 	}
 
 	static void resetPeriodCounter()
 	{
 		s_periodCounter = 0;
+		s_periodStartFrame = 0;
+	}
+
+	//! Set the frame offset within the current period at which the following
+	//! automated values apply. Periods can span several ticks when rendering
+	//! with a large block size, this keeps sample-exact automation in place.
+	static void setPeriodFrameOffset(f_cnt_t offset)
+	{
+		s_periodFrameOffset = offset;
 	}
 
 	bool useControllerValue()
@@ -370,6 +392,10 @@ private:
 	void linkModel( AutomatableModel* model );
 	void unlinkModel( AutomatableModel* model );
 
+	float calculateControllerValue( int frameOffset ) const;
+	//! Makes this model and the ones linked to it calculate their controller values again
+	void invalidateControllerValue();
+
 	//! @brief Scales @value from linear to logarithmic.
 	//! Value should be within [0,1]
 	template<class T> T logToLinearScale( T value ) const;
@@ -405,17 +431,48 @@ private:
 	ControllerConnection* m_controllerConnection;
 
 
-	ValueBuffer m_valueBuffer;
-	long m_lastUpdatedPeriod;
+	ValueBuffer* renderValueBuffer( ValueBuffer& buffer );
+
+	//! Indexed by the parity of the period, so the buffer of the previous
+	//! period stays valid while the current one is calculated
+	std::array<ValueBuffer, 2> m_valueBuffers;
+	//! Period of the last calculated buffer shifted left by one, the lowest
+	//! bit is set if it has sample-exact data
+	std::atomic<long> m_valueBufferState = -2;
+	//! Period for which a thread has started calculating the buffer
+	std::atomic<long> m_valueBufferClaim = -1;
 	static long s_periodCounter;
+	//! The first frame of the current period, counted like the periods
+	static long long s_periodStartFrame;
+	static f_cnt_t s_periodFrameOffset;
+
+	//! Automated value, starting at frame s_periodStartFrame + s_periodFrameOffset
+	//! and moving linearly to another value within the given number of frames, if any
+	struct AutomationStep
+	{
+		long long start = 0;
+		float from = 0;
+		float to = 0;
+		f_cnt_t frames = 0;
+	};
 
-	bool m_hasSampleExactData;
+	void addAutomationStep( const float target, const f_cnt_t frames );
 
-	// prevent several threads from attempting to write the same vb at the same time
-	QMutex m_valueBufferMutex;
+	// automated values of the current period, used for the value buffer if
+	// there was more than one, they ramp or the period is longer than the default one
+	std::vector<AutomationStep> m_automationSteps;
+	long m_automationStepsPeriod;
+	float m_periodStartValue;
+	//! The step playing at the start of the current period
+	AutomationStep m_periodStartStep;
+	AutomationStep m_lastAutomationStep;
 
 	bool m_useControllerValue;
 
+	mutable std::atomic<float> m_controllerValue = 0.f;
+	//! Period m_controllerValue has been calculated for, -1 if it has to be calculated again
+	mutable std::atomic<long> m_controllerValuePeriod = -1;
+
 signals:
 	void initValueChanged( float val );
 	void destroyed( lmms::jo_id_t id );
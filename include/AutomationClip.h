@@ -29,6 +29,10 @@
 
 #include <QMap>
 #include <QPointer>
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <vector>
 
 #include "AutomationNode.h"
 #include "Clip.h"
@@ -65,7 +69,7 @@ public:
 	using TimemapIterator = timeMap::const_iterator;
 
 	AutomationClip( AutomationTrack * _auto_track );
-	~AutomationClip() override = default;
+	~AutomationClip() override;
 
 	bool addObject( AutomatableModel * _obj, bool _search_dup = true );
 
@@ -103,6 +107,10 @@ public:
 		const bool ignoreSurroundingPoints = true
 	);
 
+	//! Puts a node for each of @p values at once, unquantized, replacing
+	//! nodes at the same times. Meant for importers adding many nodes.
+	void putValues(const std::vector<std::pair<TimePos, float>>& values);
+
 	void removeNode(const TimePos & time);
 	void removeNodes(const int tick0, const int tick1);
 
@@ -115,6 +123,14 @@ public:
 	 */
 	void resetTangents(const int tick0, const int tick1);
 
+	//! Removes the nodes changing the curve by less than @p tolerance, keeping jumps and locked tangents
+	void simplify(float tolerance);
+
+	//! Tolerance to simplify() the clip with after recording, 0 keeps all recorded nodes
+	float simplificationTolerance() const { return m_simplificationTolerance; }
+	void setSimplificationTolerance(float tolerance) { m_simplificationTolerance = tolerance; }
+
+	//! Records @p value at @p time into the clip, doesn't block and may be called from the audio thread
 	void recordValue(TimePos time, float value);
 
 	TimePos setDragValue( const TimePos & time,
@@ -166,8 +182,12 @@ public:
 		return supportsTangentEditing(m_progressionType);
 	}
 
+	//! Doesn't lock the clip, so the audio thread can call it while the clip is edited
 	float valueAt( const TimePos & _time ) const;
 	float *valuesAfter( const TimePos & _time ) const;
+	//! Every @p step-th value between the node at @p time and the next one, for drawing
+	//! long segments with fewer points than ticks
+	std::vector<float> valuesAfter(const TimePos& time, int step) const;
 
 	QString name() const;
 
@@ -186,8 +206,8 @@ public:
 	static AutomationClip * globalAutomationClip( AutomatableModel * _m );
 	static void resolveAllIDs();
 
-	bool isRecording() const { return m_isRecording; }
-	void setRecording( const bool b ) { m_isRecording = b; }
+	bool isRecording() const { return m_isRecording.load(std::memory_order_acquire); }
+	void setRecording( const bool b );
 
 	static int quantization() { return s_quantization; }
 	static void setQuantization(int q) { s_quantization = q; }
@@ -211,10 +231,18 @@ protected:
 
 private:
 	void cleanObjects();
+	//! Adds the values recorded by recordValue() to the nodes, called by the thread owning the clip
+	void addRecordedValues();
 	void generateTangents();
 	void generateTangents(timeMap::iterator it, int numToGenerate);
 	float valueAt( timeMap::const_iterator v, int offset ) const;
 
+	struct Curve;
+	struct RecordQueue;
+	//! Replaces the curve read by valueAt() with the current nodes, progression and tension,
+	//! must be called after changing any of them
+	void publishCurve();
+
 	/**
 	 * @brief
 	 * This function combines the song tracks, pattern store tracks,
@@ -248,8 +276,16 @@ private:
 	float m_dragInTan; // The dragged node's inTangent
 	float m_dragOutTan; // The dragged node's outTangent
 
-	bool m_isRecording;
+	std::atomic<bool> m_isRecording;
 	float m_lastRecordedValue;
+	float m_simplificationTolerance = 0;
+	//! Created on the first recording, the recorded values are passed through it to the clip's thread
+	std::unique_ptr<RecordQueue> m_recordQueue;
+
+	//! Immutable copy of the nodes, replaced as a whole whenever the clip is edited
+	std::atomic<const Curve*> m_curve = nullptr;
+	//! Number of threads reading m_curve, the replaced curve is deleted once there are none
+	mutable std::atomic<int> m_curveReaders = 0;
 
 	static int s_quantization;
 
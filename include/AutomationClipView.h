@@ -25,8 +25,11 @@
 #ifndef LMMS_GUI_AUTOMATION_CLIP_VIEW_H
 #define LMMS_GUI_AUTOMATION_CLIP_VIEW_H
 
+#include <QPainterPath>
 #include <QStaticText>
 
+#include <vector>
+
 #include "ClipView.h"
 
 namespace lmms
@@ -58,6 +61,7 @@ protected slots:
 	void changeName();
 	void disconnectObject( QAction * _a );
 	void toggleRecording();
+	void changeSimplification();
 	void flipY();
 	void flipX();
 
@@ -72,6 +76,11 @@ protected:
 private:
 	AutomationClip * m_clip;
 	QPixmap m_paintPixmap;
+
+	//! The shapes under the curve between the nodes, only rebuilt when
+	//! the nodes or the scale changed, as the values are computed per tick
+	std::vector<QPainterPath> m_curve;
+	std::vector<int> m_curveState;
 	
 	QStaticText m_staticTextName;
 	void scaleTimemapToFit( float oldMin, float oldMax );
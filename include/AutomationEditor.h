@@ -26,8 +26,11 @@
 #ifndef LMMS_GUI_AUTOMATION_EDITOR_H
 #define LMMS_GUI_AUTOMATION_EDITOR_H
 
+#include <QPainterPath>
 #include <QWidget>
 #include <array>
+#include <map>
+#include <vector>
 
 #include "AutomationClip.h"
 #include "ComboBoxModel.h"
@@ -276,6 +279,19 @@ private:
 	void drawAutomationTangents(QPainter& p, timeMap::iterator it);
 	bool inPatternEditor();
 
+	//! The area under the curve between two nodes, in ticks and levels
+	struct CurveSegment
+	{
+		std::vector<int> state;
+		QPainterPath path;
+	};
+	//! Returns the cached segment starting at node @p it, which is built again
+	//! if the nodes, progression or zoom changed
+	const QPainterPath& curveSegment(timeMap::const_iterator it);
+
+	//! Segments keyed by the position of their first node
+	std::map<int, CurveSegment> m_curveSegments;
+
 	QColor m_barLineColor;
 	QColor m_beatLineColor;
 	QColor m_lineColor;
@@ -167,6 +167,12 @@ public:
 
 	static void generateWaves();
 
+	//! Memory taken by the waveforms, once generated
+	static std::size_t memoryUsage()
+	{
+		return s_wavesGenerated ? sizeof( s_waveforms ) : 0;
+	}
+
 	static bool s_wavesGenerated;
 
 	static std::array<WaveMipMap, NumWaveforms> s_waveforms;
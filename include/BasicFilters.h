@@ -34,6 +34,7 @@
 #include <algorithm>
 #include <array>
 #include <cmath>
+#include <limits>
 #include <numbers>
 
 #include "lmms_constants.h"
@@ -178,6 +179,38 @@ public:
 		m_z2[ch] = m_b2 * in - m_a2 * out;
 		return out;
 	}
+	//! Filters @p frames frames of CHANNELS interleaved channels in place, the same as calling update()
+	//! for every sample. The channels may also belong to several voices using the same coefficients.
+	inline void process( sample_t* buf, fpp_t frames )
+	{
+		const float a1 = m_a1, a2 = m_a2, b0 = m_b0, b1 = m_b1, b2 = m_b2;
+		auto z1 = std::to_array( m_z1 );
+		auto z2 = std::to_array( m_z2 );
+		for( fpp_t f = 0; f < frames; ++f, buf += CHANNELS )
+		{
+			for( ch_cnt_t ch = 0; ch < CHANNELS; ++ch )
+			{
+				const float in = buf[ch];
+				const float out = z1[ch] + b0 * in;
+				z1[ch] = b1 * in + z2[ch] - a1 * out;
+				z2[ch] = b2 * in - a2 * out;
+				buf[ch] = out;
+			}
+		}
+		std::copy( z1.begin(), z1.end(), m_z1 );
+		std::copy( z2.begin(), z2.end(), m_z2 );
+	}
+	//! The gain at the angular frequency @p w, in radians per sample
+	inline float magnitude( float w ) const
+	{
+		const float c1 = std::cos( w ), s1 = std::sin( w );
+		const float c2 = std::cos( 2 * w ), s2 = std::sin( 2 * w );
+		const float numRe = m_b0 + m_b1 * c1 + m_b2 * c2;
+		const float numIm = m_b1 * s1 + m_b2 * s2;
+		const float denRe = 1 + m_a1 * c1 + m_a2 * c2;
+		const float denIm = m_a1 * s1 + m_a2 * s2;
+		return std::sqrt( ( numRe * numRe + numIm * numIm ) / ( denRe * denRe + denIm * denIm ) );
+	}
 private:
 	float m_a1, m_a2, m_b0, m_b1, m_b2;
 	float m_z1 [CHANNELS], m_z2 [CHANNELS];
@@ -288,6 +321,7 @@ public:
 		m_sampleRatio( 1.0f / m_sampleRate ),
 		m_subFilter( nullptr )
 	{
+		invalidateCoeffs();
 		clearHistory();
 	}
 
@@ -331,12 +365,56 @@ public:
 	{
 		m_sampleRate = sampleRate;
 		m_sampleRatio = 1.f / m_sampleRate;
+		invalidateCoeffs();
 		if (m_subFilter != nullptr)
 		{
 			m_subFilter->setSampleRate(m_sampleRate);
 		}
 	}
 
+	//! Filters a block of @p frames frames of CHANNELS interleaved channels in place, the same as calling
+	//! update() for every sample, but the filter type is only looked at once and the state of the most
+	//! used filters is kept in registers while processing the block
+	inline void process( sample_t* buf, fpp_t frames )
+	{
+		switch( m_type )
+		{
+			case FilterType::LowPass:
+			case FilterType::HiPass:
+			case FilterType::BandPass_CSG:
+			case FilterType::BandPass_CZPG:
+			case FilterType::Notch:
+			case FilterType::AllPass:
+				m_biQuad.process( buf, frames );
+				break;
+
+			case FilterType::Moog:
+				processMoog( buf, frames );
+				break;
+
+			case FilterType::Lowpass_SV:
+			case FilterType::Bandpass_SV:
+				processSV( buf, frames );
+				return;
+
+			default:
+				// these are never used as double filter
+				for( fpp_t f = 0; f < frames; ++f, buf += CHANNELS )
+				{
+					for( ch_cnt_t ch = 0; ch < CHANNELS; ++ch )
+					{
+						buf[ch] = update( buf[ch], ch );
+					}
+				}
+				return;
+		}
+
+		if( m_doubleFilter )
+		{
+			m_subFilter->process( buf, frames );
+		}
+	}
+
 	inline sample_t update( sample_t _in0, ch_cnt_t _chnl )
 	{
 		sample_t out = 0.0f;
@@ -705,6 +783,17 @@ public:
 	inline void calcFilterCoeffs( float _freq, float _q )
 	{
 		using namespace std::numbers;
+
+		// the coefficients are often requested again for the same values
+		if( _freq == m_coeffFreq && _q == m_coeffQ && m_type == m_coeffType && m_doubleFilter == m_coeffDoubleFilter )
+		{
+			return;
+		}
+		m_coeffFreq = _freq;
+		m_coeffQ = _q;
+		m_coeffType = m_type;
+		m_coeffDoubleFilter = m_doubleFilter;
+
 		// temp coef vars
 		_q = std::max(_q, minQ());
 
@@ -870,6 +959,68 @@ public:
 
 
 private:
+	inline void invalidateCoeffs()
+	{
+		m_coeffFreq = std::numeric_limits<float>::quiet_NaN();
+	}
+
+	inline void processMoog( sample_t* buf, fpp_t frames )
+	{
+		const float r = m_r, p = m_p, k = m_k;
+		frame y1 = m_y1, y2 = m_y2, y3 = m_y3, y4 = m_y4;
+		frame oldx = m_oldx, oldy1 = m_oldy1, oldy2 = m_oldy2, oldy3 = m_oldy3;
+		for( fpp_t f = 0; f < frames; ++f, buf += CHANNELS )
+		{
+			for( ch_cnt_t ch = 0; ch < CHANNELS; ++ch )
+			{
+				const sample_t x = buf[ch] - r * y4[ch];
+
+				// see update()
+				y1[ch] = std::clamp((x + oldx[ch]) * p - k * y1[ch], -10.0f, 10.0f);
+				y2[ch] = std::clamp((y1[ch] + oldy1[ch]) * p - k * y2[ch], -10.0f, 10.0f);
+				y3[ch] = std::clamp((y2[ch] + oldy2[ch]) * p - k * y3[ch], -10.0f, 10.0f);
+				y4[ch] = std::clamp((y3[ch] + oldy3[ch]) * p - k * y4[ch], -10.0f, 10.0f);
+
+				oldx[ch] = x;
+				oldy1[ch] = y1[ch];
+				oldy2[ch] = y2[ch];
+				oldy3[ch] = y3[ch];
+				buf[ch] = y4[ch] - y4[ch] * y4[ch] * y4[ch] * ( 1.0f / 6.0f );
+			}
+		}
+		m_y1 = y1; m_y2 = y2; m_y3 = y3; m_y4 = y4;
+		m_oldx = oldx; m_oldy1 = oldy1; m_oldy2 = oldy2; m_oldy3 = oldy3;
+	}
+
+	inline void processSV( sample_t* buf, fpp_t frames )
+	{
+		const float svf1 = m_svf1, svf2 = m_svf2, svq = m_svq;
+		const bool lowpass = m_type == FilterType::Lowpass_SV;
+		frame delay1 = m_delay1, delay2 = m_delay2, delay3 = m_delay3, delay4 = m_delay4;
+		for( fpp_t f = 0; f < frames; ++f, buf += CHANNELS )
+		{
+			for( ch_cnt_t ch = 0; ch < CHANNELS; ++ch )
+			{
+				const sample_t in = buf[ch];
+
+				// see update()
+				for( int i = 0; i < 2; ++i ) // 2x oversample
+				{
+					delay2[ch] = delay2[ch] + svf1 * delay1[ch];
+					float highpass = in - delay2[ch] - svq * delay1[ch];
+					delay1[ch] = svf1 * highpass + delay1[ch];
+
+					delay4[ch] = delay4[ch] + svf2 * delay3[ch];
+					highpass = delay2[ch] - delay4[ch] - svq * delay3[ch];
+					delay3[ch] = svf2 * highpass + delay3[ch];
+				}
+
+				buf[ch] = lowpass ? delay4[ch] : delay3[ch];
+			}
+		}
+		m_delay1 = delay1; m_delay2 = delay2; m_delay3 = delay3; m_delay4 = delay4;
+	}
+
 	// biquad filter
 	BiQuad<CHANNELS> m_biQuad;
 
@@ -909,6 +1060,12 @@ private:
 	float m_sampleRatio;
 	BasicFilters<CHANNELS> * m_subFilter;
 
+	// parameters the coefficients have been calculated for
+	float m_coeffFreq;
+	float m_coeffQ;
+	FilterType m_coeffType;
+	bool m_coeffDoubleFilter;
+
 } ;
 
 
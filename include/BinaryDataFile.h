@@ -0,0 +1,71 @@
+/*
+ * BinaryDataFile.h - compact binary encoding of DataFile documents
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_BINARY_DATA_FILE_H
+#define LMMS_BINARY_DATA_FILE_H
+
+#include <QByteArray>
+#include <QString>
+
+#include "lmms_export.h"
+
+class QDomDocument;
+
+namespace lmms
+{
+
+/*! \brief Binary encoding of project documents (.mmpb)
+
+	Stores the same DOM as the XML formats, so converting between them is
+	lossless, but can be read without parsing any XML:
+
+	- a 4 byte magic "LMMB" and a format version byte, followed by the
+	  zlib compressed (qCompress()) payload
+	- the payload starts with a table of all names and values, each stored
+	  once, which nodes refer to by index
+	- the nodes follow in document order, elements with their attributes
+	  and the number of their children
+	- runs of sibling elements with the same name and attributes and no
+	  children, like the notes of a clip or the nodes of an automation clip,
+	  are stored as one block: the attribute names once, then one row of
+	  values per element. Columns of integers are stored as deltas.
+*/
+namespace BinaryDataFile
+{
+
+//! The file extension of binary song projects
+constexpr const char* SongProjectExtension = "mmpb";
+
+//! Whether @p data starts like a binary document
+LMMS_EXPORT bool isBinary(const QByteArray& data);
+
+LMMS_EXPORT QByteArray encode(const QDomDocument& doc);
+
+//! Reads the nodes of @p data into the empty document @p doc. On failure
+//! false is returned and @p error describes the problem.
+LMMS_EXPORT bool decode(const QByteArray& data, QDomDocument& doc, QString* error = nullptr);
+
+} // namespace BinaryDataFile
+
+} // namespace lmms
+
+#endif // LMMS_BINARY_DATA_FILE_H
@@ -26,6 +26,8 @@
 #ifndef LMMS_BUFFER_MANAGER_H
 #define LMMS_BUFFER_MANAGER_H
 
+#include <cstddef>
+
 #include "lmms_export.h"
 #include "LmmsTypes.h"
 
@@ -34,13 +36,41 @@ namespace lmms
 
 class SampleFrame;
 
+/**
+	@brief Pool of period-sized sample buffers
+
+	All buffers are allocated up front and recycled through a lock-free free
+	list, so acquire() and release() can be called from the realtime threads
+	without hitting the heap. When the pool runs low, a background thread
+	allocates more buffers. Buffers are aligned to 64 bytes and returned zeroed.
+*/
 class LMMS_EXPORT BufferManager
 {
 public:
+	struct Stats
+	{
+		std::size_t capacity;      //!< number of buffers owned by the pool
+		std::size_t inUse;         //!< number of buffers currently acquired
+		std::size_t highWaterMark; //!< maximum of inUse since init()
+		std::size_t misses;        //!< acquires which had to allocate on the calling thread
+	};
+
+	static constexpr std::size_t Alignment = 64;
+
+	//! Must be called before any buffer is acquired
 	static void init( fpp_t fpp );
 	static SampleFrame* acquire();
 	static void release( SampleFrame* buf );
 
+	//! Length of the buffers handed out by acquire(), 0 before init()
+	static fpp_t framesPerPeriod() { return s_framesPerPeriod; }
+
+	//! Grow the pool to at least @p count buffers. Allocates, so don't call
+	//! this from realtime threads.
+	static void reserve( std::size_t count );
+
+	static Stats stats();
+
 private:
 	static fpp_t s_framesPerPeriod;
 };
@@ -27,6 +27,7 @@
 #define LMMS_GUI_CPU_LOAD_WIDGET_H
 
 #include <algorithm>
+#include <cstdint>
 #include <QTimer>
 #include <QPixmap>
 #include <QWidget>
@@ -49,6 +50,7 @@ public:
 
 protected:
 	void paintEvent( QPaintEvent * _ev ) override;
+	void contextMenuEvent( QContextMenuEvent * _ev ) override;
 
 
 protected slots:
@@ -59,6 +61,7 @@ private:
 	int stepSize() const { return std::max(1, m_stepSize); }
 
 	int m_currentLoad;
+	std::uint64_t m_xruns = 0;
 
 	QPixmap m_temp;
 	QPixmap m_background;
@@ -27,11 +27,11 @@
 
 #include <QDomElement>
 #include <QMap>
+#include <QMimeData>
 
+#include "DataFile.h"
 #include "lmms_export.h"
 
-class QMimeData;
-
 namespace lmms::Clipboard
 {
 
@@ -54,6 +54,40 @@ namespace lmms::Clipboard
 	QString decodeKey( const QMimeData * mimeData );
 	QString decodeValue( const QMimeData * mimeData );
 
+	// Helper methods for DataFiles, e.g. copied clips or notes
+	void LMMS_EXPORT copyDataFile(const DataFile& dataFile, MimeType mT, const QString& key = QString());
+	//! The DataFile put on the clipboard or into a drag by copyDataFile(). Only
+	//! parsed from XML if it came from another process.
+	DataFile LMMS_EXPORT decodeDataFile(const QMimeData* mimeData, MimeType mT);
+
+
+	/**
+	 * Mime data holding a DataFile as it is. Copying or dragging a large
+	 * selection inside LMMS thus doesn't write it to XML and parse it again;
+	 * the XML is only generated if another application asks for the data.
+	 */
+	class LMMS_EXPORT DataFileMimeData : public QMimeData
+	{
+	public:
+		DataFileMimeData(const DataFile& dataFile, MimeType mT, const QString& key = QString());
+
+		const DataFile& dataFile() const { return m_dataFile; }
+		MimeType type() const { return m_type; }
+		const QString& key() const { return m_key; }
+
+		bool hasFormat(const QString& mimeType) const override;
+		QStringList formats() const override;
+
+	protected:
+		QVariant retrieveData(const QString& mimeType, QVariant::Type type) const override;
+
+	private:
+		DataFile m_dataFile;
+		MimeType m_type;
+		QString m_key;
+		mutable QByteArray m_serialized;
+	};
+
 	inline const char * mimeType( MimeType type )
 	{
 		switch( type )
@@ -0,0 +1,91 @@
+/*
+ * CompensationDelay.h - delays a signal to line it up with a signal of higher latency
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_COMPENSATION_DELAY_H
+#define LMMS_COMPENSATION_DELAY_H
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "LmmsTypes.h"
+#include "SampleFrame.h"
+
+namespace lmms
+{
+
+/**
+ * Delay line of the plugin delay compensation (see Mixer::latency()).
+ *
+ * The line is allocated up front, so the delay can be changed by the audio
+ * thread at any time. Delays longer than MaxDelay frames are clamped.
+ */
+class CompensationDelay
+{
+public:
+	static constexpr auto Size = f_cnt_t{8192};
+	static constexpr auto MaxDelay = Size - 1;
+
+	f_cnt_t delay() const { return m_delay; }
+
+	std::size_t memoryUsage() const { return m_buffer.capacity() * sizeof(SampleFrame); }
+
+	void setDelay(f_cnt_t delay)
+	{
+		delay = std::min(delay, MaxDelay);
+		if (delay == m_delay) { return; }
+
+		// whatever was delayed before doesn't line up anymore
+		std::fill(m_buffer.begin(), m_buffer.end(), SampleFrame{});
+		m_delay = delay;
+		m_pending = 0;
+	}
+
+	//! Writes @p frames frames of @p in (silence if null) delayed into @p out, which may be @p in.
+	//! Returns whether the output may not be silent.
+	bool process(const SampleFrame* in, SampleFrame* out, fpp_t frames)
+	{
+		if (in) { m_pending = m_delay + frames; }
+		else if (m_pending == 0) { return false; }
+
+		for (fpp_t f = 0; f < frames; ++f)
+		{
+			m_buffer[m_position] = in ? in[f] : SampleFrame{};
+			out[f] = m_buffer[(m_position + Size - m_delay) % Size];
+			m_position = (m_position + 1) % Size;
+		}
+
+		m_pending -= std::min(m_pending, frames);
+		return true;
+	}
+
+private:
+	std::vector<SampleFrame> m_buffer = std::vector<SampleFrame>(Size);
+	f_cnt_t m_position = 0;
+	f_cnt_t m_delay = 0;
+	//! Frames until the last input has left the line
+	f_cnt_t m_pending = 0;
+};
+
+} // namespace lmms
+
+#endif // LMMS_COMPENSATION_DELAY_H
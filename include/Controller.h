@@ -127,7 +127,8 @@ public:
 	static unsigned int runningFrames();
 	static float runningTime();
 
-	static void triggerFrameCounter();
+	//! Counts the period of @p frames frames which was just rendered
+	static void triggerFrameCounter(fpp_t frames);
 	static void resetFrameCounter();
 
 	//Accepts a ControllerConnection * as it may be used in the future.
@@ -152,6 +153,13 @@ protected:
 
 	virtual void updateValueBuffer();
 
+	//! Whether valueChanged() is to be emitted for the period which has
+	//! just been rendered, by default after every period
+	virtual bool valueChangedInPeriod()
+	{
+		return true;
+	}
+
 	// buffer for storing sample-exact values in case there
 	// are more than one model wanting it, so we don't have to create it
 	// again every time
@@ -169,6 +177,8 @@ protected:
 	static ControllerVector s_controllers;
 
 	static long s_periods;
+	//! Frames rendered in all periods so far, which may differ in size
+	static long long s_frames;
 
 
 signals:
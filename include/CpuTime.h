@@ -0,0 +1,93 @@
+/*
+ * CpuTime.h - the processing time spent on a part of the project
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_CPU_TIME_H
+#define LMMS_CPU_TIME_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "lmms_export.h"
+
+namespace lmms {
+
+/**
+ * The processing time spent on a part of the project, e.g. the voices of a
+ * track or an effect, by whichever threads process it.
+ *
+ * The time is only measured while a display observes any of them, as
+ * reading the clock around every job isn't free.
+ */
+class LMMS_EXPORT CpuTime
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	//! Adds the wall time of the enclosing scope to a CpuTime, if there's one
+	class Scope
+	{
+	public:
+		explicit Scope(CpuTime* time)
+			: m_time(time && isMeasuring() ? time : nullptr)
+			, m_begin(m_time ? Clock::now() : Clock::time_point{})
+		{
+		}
+		~Scope()
+		{
+			if (m_time) { m_time->add(Clock::now() - m_begin); }
+		}
+		Scope& operator=(const Scope&) = delete;
+		Scope(const Scope&) = delete;
+
+	private:
+		CpuTime* const m_time;
+		const Clock::time_point m_begin;
+	};
+
+	void add(Clock::duration time)
+	{
+		m_total.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(time).count(),
+			std::memory_order_relaxed);
+	}
+
+	//! The time measured so far, only differences between two calls mean anything
+	auto total() const -> std::chrono::nanoseconds
+	{
+		return std::chrono::nanoseconds{m_total.load(std::memory_order_relaxed)};
+	}
+
+	static bool isMeasuring() { return s_observers.load(std::memory_order_relaxed) > 0; }
+
+	//! Time is measured from the first call on until each has been followed by removeObserver()
+	static void addObserver();
+	static void removeObserver();
+
+private:
+	std::atomic<std::int64_t> m_total = 0;
+
+	static std::atomic<int> s_observers;
+};
+
+} // namespace lmms
+
+#endif // LMMS_CPU_TIME_H
@@ -0,0 +1,67 @@
+/*
+ * CpuUsageLabel.h - shows the processing time a part of the project takes
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_GUI_CPU_USAGE_LABEL_H
+#define LMMS_GUI_CPU_USAGE_LABEL_H
+
+#include <QLabel>
+#include <QTimer>
+#include <chrono>
+#include <functional>
+
+#include "CpuTime.h"
+#include "lmms_export.h"
+
+namespace lmms::gui {
+
+/**
+ * Shows the share of one core a part of the project takes, e.g. a track or
+ * an effect, while "Show CPU usage" is checked in the View menu.
+ */
+class LMMS_EXPORT CpuUsageLabel : public QLabel
+{
+	Q_OBJECT
+public:
+	//! @p total returns the CpuTime::total() of the part, or the sum of several
+	CpuUsageLabel(std::function<std::chrono::nanoseconds()> total, QWidget* parent);
+	~CpuUsageLabel() override;
+
+	static bool isShown();
+
+private slots:
+	void updateUsage();
+	void handleConfigChange(QString cls, QString attr, QString value);
+
+private:
+	void setShown(bool shown);
+
+	std::function<std::chrono::nanoseconds()> m_total;
+	std::chrono::nanoseconds m_lastTotal{0};
+	CpuTime::Clock::time_point m_lastUpdate;
+	float m_usage = 0.f;
+	bool m_shown = false;
+	QTimer m_updateTimer;
+};
+
+} // namespace lmms::gui
+
+#endif // LMMS_GUI_CPU_USAGE_LABEL_H
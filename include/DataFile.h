@@ -27,23 +27,31 @@
 #define LMMS_DATA_FILE_H
 
 #include <map>
+#include <memory>
 #include <QDomDocument>
+#include <utility>
 #include <vector>
 
 #include "lmms_export.h"
 
+class QIODevice;
+class QSaveFile;
 class QTextStream;
 
+class DataFileUpgradeTest;
+
 namespace lmms
 {
 
 class ProjectVersion;
+class SampleBuffer;
 
 
 class LMMS_EXPORT DataFile : public QDomDocument
 {
 
 	using UpgradeMethod = void(DataFile::*)();
+	using ElementUpgrade = void(*)(QDomElement&);
 
 public:
 	enum class Type
@@ -63,7 +71,7 @@ public:
 	DataFile( const QByteArray& data );
 	DataFile( Type type );
 
-	virtual ~DataFile() = default;
+	virtual ~DataFile();
 
 	///
 	/// \brief validate
@@ -75,9 +83,21 @@ public:
 
 	void write( QTextStream& strm );
 	bool writeFile(const QString& fn, bool withResources = false);
+	//! Writes the document to @p filename as is, replacing the file only once
+	//! all of it was written, so a crash meanwhile leaves the old file intact.
+	//! Shows no dialogs, so it can run on a worker thread, as long as nothing
+	//! else uses the document meanwhile.
+	bool writeFileAtomically(const QString& filename);
 	bool copyResources(const QString& resourcesDir); //!< Copies resources to the resourcesDir and changes the DataFile to use local paths to them
 	bool hasLocalPlugins(QDomElement parent = QDomElement(), bool firstCall = true) const;
 
+	//! Makes bundleSample() store samples in the resources folder when writing the file with resources
+	void setBundlesSamples(bool bundlesSamples);
+	//! If @p doc is a DataFile written with resources, @p buffer is stored as a raw WAV file in the resources
+	//! folder, which the "src" attribute of @p element will refer to. Returns false if the sample has to be
+	//! embedded into the element instead.
+	static bool bundleSample(QDomDocument& doc, const QDomElement& element, std::shared_ptr<const SampleBuffer> buffer);
+
 	QDomElement& content()
 	{
 		return m_content;
@@ -100,8 +120,15 @@ private:
 	static QString typeName( Type type );
 
 	void cleanMetaNodes( QDomElement de );
+	//! Removes what isn't to be saved, before writing in any format
+	void prepareForWriting();
+
+	//! Replaces the resources @p element refers to, if it's an element with resources
+	static void mapSrcAttributes(QDomElement& element, const QMap<QString, QString>& map);
 
-	void mapSrcAttributeInElementsWithResources(const QMap<QString, QString>& map);
+	bool writeBundledSamples(const QString& resourcesDir);
+	//! Writes the document in the format belonging to @p extension
+	void writeContent(QSaveFile& outfile, const QString& extension);
 
 	// helper upgrade routines
 	void upgrade_0_2_1_20070501();
@@ -124,20 +151,41 @@ private:
 	void upgrade_noHiddenClipNames();
 	void upgrade_automationNodes();
 	void upgrade_extendedNoteRange();
-	void upgrade_defaultTripleOscillatorHQ();
-	void upgrade_mixerRename();
-	void upgrade_bbTcoRename();
-	void upgrade_sampleAndHold();
-	void upgrade_midiCCIndexing();
-	void upgrade_loopsRename();
-	void upgrade_noteTypes();
-	void upgrade_fixCMTDelays();
-	void upgrade_fixBassLoopsTypo();
+	static void upgrade_defaultTripleOscillatorHQ(QDomElement& element);
+	static void upgrade_mixerRename(QDomElement& element);
+	static void upgrade_bbTcoRename(QDomElement& element);
+	static void upgrade_sampleAndHold(QDomElement& element);
+	static void upgrade_midiCCIndexing(QDomElement& element);
+	static void upgrade_loopsRename(QDomElement& element);
+	static void upgrade_noteTypes(QDomElement& element);
+	static void upgrade_fixCMTDelays(QDomElement& element);
+	static void upgrade_fixBassLoopsTypo(QDomElement& element);
 	void findProblematicLadspaPlugins();
 	void upgrade_noHiddenAutomationTracks();
 
+	/**
+		One step of upgrading documents to the next file version
+
+		Steps which list tag names are skipped if the document has no such
+		elements. Element upgrades change the elements with these tag names
+		one at a time, independently of all other elements, so consecutive
+		ones share a single walk through the document.
+	*/
+	struct UpgradeStep
+	{
+		UpgradeMethod method = nullptr;
+		ElementUpgrade elementUpgrade = nullptr;
+		//! The tag names of the elements the step looks at, or empty if it
+		//! may look at anything
+		std::vector<QString> tagNames = {};
+		//! The tag names of the elements the step may add or rename to
+		std::vector<QString> addedTagNames = {};
+	};
+
+	void upgradeElements(const std::vector<const UpgradeStep*>& steps);
+
 	// List of all upgrade methods
-	static const std::vector<UpgradeMethod> UPGRADE_METHODS;
+	static const std::vector<UpgradeStep> UPGRADE_METHODS;
 	// List of ProjectVersions for the legacyFileVersion method
 	static const std::vector<ProjectVersion> UPGRADE_VERSIONS;
 
@@ -148,12 +196,28 @@ private:
 	void upgrade();
 
 	void loadData( const QByteArray & _data, const QString & _sourceFile );
+	//! Loads data in the format of qCompress(), decompressing while parsing
+	void loadCompressedData(QIODevice& compressed, const QString& sourceFile);
+	//! Sets up the members for the document once it was parsed
+	void loadContent(const QString& sourceFile);
+	static void showLoadError(const QString& sourceFile);
 
 	QString m_fileName; //!< The origin file name or "" if this DataFile didn't originate from a file
 	QDomElement m_content;
 	QDomElement m_head;
 	Type m_type;
 	unsigned int m_fileVersion;
+
+	//! Samples to write into the resources folder, with the elements referring to them
+	std::vector<std::pair<QDomElement, std::shared_ptr<const SampleBuffer>>> m_bundledSamples;
+
+	//! Whether this file is in s_bundlingFiles
+	bool m_bundlesSamples = false;
+
+	//! The DataFiles setBundlesSamples() has been enabled for
+	static std::vector<DataFile*> s_bundlingFiles;
+
+	friend class ::DataFileUpgradeTest;
 } ;
 
 
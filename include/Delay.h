@@ -26,7 +26,11 @@
 #ifndef LMMS_DELAY_H
 #define LMMS_DELAY_H
 
+#include <array>
 #include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <vector>
 
 #include "LmmsTypes.h"
 
@@ -41,6 +45,7 @@ namespace lmms
 // CombFeedfwd: a feed-forward comb filter - an "inverted" comb filter, can be combined with CombFeedback to create a net allpass if negative gain is used
 // CombFeedbackDualtap: same as CombFeedback but takes two delay values
 // AllpassDelay: an allpass delay - combines feedback and feed-forward - has flat frequency response
+// DelayLine: a plain circular buffer of frames with fractional reads, see below - for delays which are modulated per frame
 
 // all classes are templated with channel count, any arbitrary channel count can be used for each fx
 
@@ -69,7 +74,7 @@ public:
 	CombFeedback( int maxDelay ) :
 		m_size( maxDelay ),
 		m_position( 0 ),
-		m_feedBack( 0.0 ),
+		m_gain( 0.0 ),
 		m_delay( 0 ),
 		m_fraction( 0.0 )
 	{
@@ -135,12 +140,13 @@ private:
 template<ch_cnt_t CHANNELS>
 class CombFeedfwd
 {
+public:
 	using frame = std::array<double, CHANNELS>;
 
 	CombFeedfwd( int maxDelay ) :
 		m_size( maxDelay ),
 		m_position( 0 ),
-		m_feedBack( 0.0 ),
+		m_gain( 0.0 ),
 		m_delay( 0 ),
 		m_fraction( 0.0 )
 	{
@@ -206,14 +212,17 @@ private:
 template<ch_cnt_t CHANNELS>
 class CombFeedbackDualtap
 {
+public:
 	using frame = std::array<double, CHANNELS>;
 
 	CombFeedbackDualtap( int maxDelay ) :
 		m_size( maxDelay ),
 		m_position( 0 ),
-		m_feedBack( 0.0 ),
-		m_delay( 0 ),
-		m_fraction( 0.0 )
+		m_gain( 0.0 ),
+		m_delay1( 0 ),
+		m_delay2( 0 ),
+		m_fraction1( 0.0 ),
+		m_fraction2( 0.0 )
 	{
 		m_buffer = new frame[maxDelay];
 		memset( m_buffer, 0, sizeof( frame ) * maxDelay );
@@ -292,7 +301,7 @@ public:
 	AllpassDelay( int maxDelay ) :
 		m_size( maxDelay ),
 		m_position( 0 ),
-		m_feedBack( 0.0 ),
+		m_gain( 0.0 ),
 		m_delay( 0 ),
 		m_fraction( 0.0 )
 	{
@@ -355,6 +364,91 @@ private:
 	double m_fraction;	
 };
 
+/**
+	A circular buffer of frames which can be read at fractional delays
+
+	The size is rounded up to a power of two, so wrapping around only masks the position instead of
+	dividing by the size for every frame. The frames are stored interleaved and interpolated with the
+	same operations for all channels, which lets the compiler vectorize them.
+
+	Read before writing: read(1) returns the frame written last.
+*/
+template<ch_cnt_t CHANNELS>
+class DelayLine
+{
+public:
+	using Frame = std::array<float, CHANNELS>;
+
+	explicit DelayLine(std::size_t maxDelay = 0)
+	{
+		setMaxDelay(maxDelay);
+	}
+
+	//! Makes room for delays up to @p maxDelay frames and clears the history
+	void setMaxDelay(std::size_t maxDelay)
+	{
+		// one more frame for interpolating, and one for the frame being written
+		auto size = std::size_t{1};
+		while (size < maxDelay + 2) { size *= 2; }
+
+		m_buffer.assign(size, Frame{});
+		m_mask = size - 1;
+		m_position = 0;
+		m_maxDelay = maxDelay;
+	}
+
+	std::size_t maxDelay() const { return m_maxDelay; }
+
+	void clear()
+	{
+		m_buffer.assign(m_buffer.size(), Frame{});
+	}
+
+	//! The frame written @p delay frames ago, 1 <= delay <= maxDelay()
+	const Frame& read(std::size_t delay) const
+	{
+		return m_buffer[(m_position - delay) & m_mask];
+	}
+
+	//! The frames around @p delay, linearly interpolated, 1 <= delay <= maxDelay()
+	Frame read(float delay) const
+	{
+		const auto whole = static_cast<std::size_t>(delay);
+		const float fraction = delay - whole;
+		const Frame& newer = m_buffer[(m_position - whole) & m_mask];
+		const Frame& older = m_buffer[(m_position - whole - 1) & m_mask];
+
+		auto out = Frame{};
+		for (ch_cnt_t ch = 0; ch < CHANNELS; ++ch)
+		{
+			out[ch] = newer[ch] + fraction * (older[ch] - newer[ch]);
+		}
+		return out;
+	}
+
+	void write(const Frame& frame)
+	{
+		m_buffer[m_position] = frame;
+		m_position = (m_position + 1) & m_mask;
+	}
+
+	//! Writes @p frames frames at once, which must not be more than maxDelay()
+	void write(const Frame* frames, std::size_t count)
+	{
+		for (auto i = std::size_t{0}; i < count; ++i)
+		{
+			m_buffer[(m_position + i) & m_mask] = frames[i];
+		}
+		m_position = (m_position + count) & m_mask;
+	}
+
+private:
+	std::vector<Frame> m_buffer;
+	std::size_t m_mask = 0;
+	std::size_t m_position = 0;
+	std::size_t m_maxDelay = 0;
+};
+
 // convenience typedefs for stereo effects
 using StereoCombFeedback = CombFeedback<2>;
 using StereoCombFeedfwd = CombFeedfwd<2>;
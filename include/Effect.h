@@ -26,10 +26,13 @@
 #ifndef LMMS_EFFECT_H
 #define LMMS_EFFECT_H
 
+#include <algorithm>
+#include <initializer_list>
 #include <span>
 
 #include "AudioEngine.h"
 #include "AutomatableModel.h"
+#include "CpuTime.h"
 #include "Engine.h"
 #include "Plugin.h"
 #include "TempoSyncKnobModel.h"
@@ -68,6 +71,23 @@ public:
 	//! Returns true if audio was processed and should continue being processed
 	bool processAudioBuffer(SampleFrame* buf, const fpp_t frames);
 
+	//! Whether the effect processes each frame without looking at the frames after it, so that
+	//! it can process the period in blocks through processFrames(). A chain processes consecutive
+	//! fusible effects block by block, passing the buffer through the cache once instead of once
+	//! per effect.
+	virtual bool isFusible() const
+	{
+		return false;
+	}
+
+	//! Processes the consecutive fusible @p effects of a chain in blocks of FusedBlockFrames,
+	//! each block by all of them before the next one. Returns whether any of them should
+	//! continue being processed, like processAudioBuffer().
+	static bool processFused(std::span<Effect* const> effects, SampleFrame* buf, const fpp_t frames,
+		bool hasInputNoise);
+
+	static constexpr fpp_t FusedBlockFrames = 64;
+
 	inline bool isOkay() const
 	{
 		return m_okay;
@@ -142,6 +162,11 @@ public:
 		return m_parent;
 	}
 
+	CpuTime& cpuTime()
+	{
+		return m_cpuTime;
+	}
+
 	virtual EffectControls * controls() = 0;
 
 	static Effect * instantiate( const QString & _plugin_name,
@@ -173,6 +198,44 @@ protected:
 	 */
 	virtual void processBypassedImpl() {}
 
+	/**
+	 * Processes the frames from @p start to @p end of the period in @p buf, must be implemented
+	 * by fusible effects. The blocks of a period are processed in order and their output is
+	 * checked like with ProcessStatus::ContinueIfNotQuiet.
+	 */
+	virtual void processFrames(SampleFrame* buf, fpp_t start, fpp_t end) {}
+
+	//! Frames in which the coefficients derived from automated parameters are only
+	//! calculated once, see processControlBlocks()
+	static constexpr fpp_t ControlBlockFrames = 16;
+
+	/**
+	 * Calls @p process(start, end) for consecutive blocks of at most @p blockFrames frames
+	 * covering the @p frames of the period, so that coefficients derived from parameters
+	 * with sample-exact data only have to be recalculated once per block instead of once
+	 * per frame. If none of @p models has sample-exact data, the period is a single block.
+	 */
+	template<typename Process>
+	static void processControlBlocks(fpp_t frames, std::initializer_list<AutomatableModel*> models,
+		Process process, fpp_t blockFrames = ControlBlockFrames)
+	{
+		const bool sampleExact = std::any_of(models.begin(), models.end(),
+			[](AutomatableModel* model) { return model->valueBuffer() != nullptr; });
+		const fpp_t step = std::max<fpp_t>(sampleExact ? blockFrames : frames, 1);
+		for (fpp_t start = 0; start < frames; start += step)
+		{
+			process(start, std::min<fpp_t>(start + step, frames));
+		}
+	}
+
+	//! The value of @p model in the block of frames from @p start to @p end, i.e. the value in
+	//! the middle of the block if the model has sample-exact data, which is the average of a ramp
+	static float controlValue(FloatModel& model, fpp_t start, fpp_t end)
+	{
+		const ValueBuffer* buffer = model.valueBuffer();
+		return buffer ? buffer->value(start + (end - start) / 2) : model.value();
+	}
+
 
 	gui::PluginView* instantiateView( QWidget * ) override;
 
@@ -210,6 +273,11 @@ private:
 	 */
 	void handleAutoQuit(std::span<const SampleFrame> output);
 
+	//! Whether @p output is below the silence threshold of auto-quit
+	static bool isQuiet(std::span<const SampleFrame> output);
+	//! Counts a period with a @p quiet output towards auto-quit
+	void updateAutoQuit(bool quiet);
+
 
 	EffectChain * m_parent;
 	void resample( int _i, const SampleFrame* _src_buf,
@@ -230,6 +298,12 @@ private:
 
 	bool m_autoQuitEnabled = false;
 
+	//! Whether the effect is processed in the current fused period, and whether its output has been quiet so far
+	bool m_fusedActive = false;
+	bool m_fusedQuiet = false;
+
+	CpuTime m_cpuTime;
+
 	SRC_DATA m_srcData[2];
 	SRC_STATE * m_srcState[2];
 
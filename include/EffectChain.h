@@ -26,6 +26,9 @@
 #ifndef LMMS_EFFECT_CHAIN_H
 #define LMMS_EFFECT_CHAIN_H
 
+#include <memory>
+#include <vector>
+
 #include "Model.h"
 #include "SerializingObject.h"
 #include "AutomatableModel.h"
@@ -35,6 +38,7 @@ namespace lmms
 
 class Effect;
 class SampleFrame;
+class ThreadableJob;
 
 namespace gui
 {
@@ -66,14 +70,41 @@ public:
 	bool processAudioBuffer( SampleFrame* _buf, const fpp_t _frames, bool hasInputNoise );
 	void startRunning();
 
+	//! Returns whether any effect still produces output without input, i.e.
+	//! whether a silent buffer has to be processed at all
+	bool isRunning() const;
+
+	//! Returns the latency of the enabled effects. In pipelined mode, the effects are split into
+	//! stages processed in parallel, each one processing the output the previous one produced
+	//! in the last period, which adds a period of latency per additional stage. The stages are
+	//! flushed when the period size changes, so this is always the current period size.
+	f_cnt_t latency() const;
+
 	void clear();
 
+	const std::vector<Effect*>& effects() const
+	{
+		return m_effects;
+	}
+
 
 private:
+	class Stage;
+
+	//! Splits the effects into stages if pipelined, must be called while the audio engine is locked
+	void updateStages();
+	//! Drops the periods on their way through the stages, which were of another length
+	void flushStages();
+
 	using EffectList = std::vector<Effect*>;
 	EffectList m_effects;
 
 	BoolModel m_enabledModel;
+	BoolModel m_pipelinedModel;
+
+	//! Empty unless the chain is pipelined and has more than one effect
+	std::vector<std::unique_ptr<Stage>> m_stages;
+	std::vector<ThreadableJob*> m_queuedStages;
 
 
 	friend class gui::EffectRackView;
@@ -38,9 +38,10 @@ namespace lmms::gui
 
 class EffectView;
 class GroupBox;
+class LedCheckBox;
 
 
-class EffectRackView : public QWidget, public ModelView
+class LMMS_EXPORT EffectRackView : public QWidget, public ModelView
 {
 	Q_OBJECT
 public:
@@ -79,6 +80,7 @@ private:
 	QVector<EffectView *> m_effectViews;
 
 	GroupBox* m_effectsGroupBox;
+	LedCheckBox* m_pipelinedCheckBox;
 	QScrollArea* m_scrollArea;
 
 	int m_lastY;
@@ -26,6 +26,7 @@
 #define LMMS_ENVELOPE_AND_LFO_PARAMETERS_H
 
 #include <memory>
+#include <vector>
 
 #include "JournallingObject.h"
 #include "AutomatableModel.h"
@@ -152,7 +153,9 @@ public slots:
 
 
 protected:
-	void fillLfoLevel( float * _buf, f_cnt_t _frame, const fpp_t _frames );
+	void fillEnvLevel( float * _buf, f_cnt_t _frame, const f_cnt_t _release_begin, const fpp_t _frames );
+	//! Combines the envelope levels in @p _buf with the LFO
+	void applyLfoLevel( float * _buf, f_cnt_t _frame, const fpp_t _frames );
 
 
 private:
@@ -199,9 +202,18 @@ private:
 	bool m_lfoAmountIsZero;
 	sample_t * m_lfoShapeData;
 	sample_t m_random;
+	//! See AudioEngine::SharedRandomScope
+	std::uint64_t m_randomKey;
 	bool m_bad_lfoShapeData;
 	std::shared_ptr<const SampleBuffer> m_userWave = SampleBuffer::emptyBuffer();
 
+	// levels returned by the last call of fillLevel() in this period
+	std::vector<float> m_levelCache;
+	f_cnt_t m_levelCacheFrame = 0;
+	f_cnt_t m_levelCacheReleaseBegin = 0;
+	fpp_t m_levelCacheFrames = 0;
+	bool m_levelCacheValid = false;
+
 	constexpr static auto NumLfoShapes = static_cast<std::size_t>(LfoShape::Count);
 
 	sample_t lfoShapeSample( fpp_t _frame_offset );
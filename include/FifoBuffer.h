@@ -1,5 +1,5 @@
 /*
- * FifoBuffer.h - FIFO fixed-size buffer
+ * FifoBuffer.h - FIFO of audio periods
  *
  * Copyright (c) 2007 Javier Serrano Polo <jasp00/at/users.sourceforge.net>
  *
@@ -25,70 +25,119 @@
 #ifndef LMMS_FIFO_BUFFER_H
 #define LMMS_FIFO_BUFFER_H
 
-#include <QSemaphore>
+#include <memory>
+#include <semaphore>
+#include <vector>
+
+#include "LmmsTypes.h"
+#include "SampleFrame.h"
 
 
 namespace lmms
 {
 
 
-template<typename T>
+/**
+	FIFO of audio periods between one writer and one reader thread
+
+	All periods are allocated up front. The writer renders into the period
+	returned by writeBuffer() and hands it over with commit(). The reader gets
+	the periods from read(), each one staying valid until its next call.
+	Periods may be shorter than the frames allocated for each of them, the
+	reader gets their length from readFrames().
+	Each index is only touched by one side, so the threads never lock anything
+	and only wait on a semaphore while the FIFO is full or empty.
+*/
 class FifoBuffer
 {
 public:
-	FifoBuffer(int size) :
-		m_readSem(size),
-		m_writeSem(size),
-		m_readIndex(0),
-		m_writeIndex(0),
-		m_size(size)
+	//! Holds up to @p size periods of @p frames frames for the reader
+	FifoBuffer(int size, fpp_t frames) :
+		// one more for the period the reader works on and one for the writer
+		m_size(size + 2),
+		m_frames(frames),
+		m_buffers(std::make_unique<SampleFrame[]>(m_size * frames)),
+		m_committed(m_size, nullptr),
+		m_committedFrames(m_size, 0),
+		m_free(m_size),
+		m_used(0),
+		m_drained(0)
 	{
-		m_buffer = new T[size];
-		m_readSem.acquire(size);
 	}
 
-	~FifoBuffer()
+	//! The period to render into next, blocks while the FIFO is full
+	SampleFrame* writeBuffer()
 	{
-		delete[] m_buffer;
-		m_readSem.release(m_size);
+		m_free.acquire();
+		return &m_buffers[m_writeIndex * m_frames];
 	}
 
-	void write(T element)
+	//! Hand the period returned by writeBuffer() to the reader, of which
+	//! @p frames frames were rendered
+	void commit(fpp_t frames)
 	{
-		m_writeSem.acquire();
-		m_buffer[m_writeIndex++] = element;
-		m_writeIndex %= m_size;
-		m_readSem.release();
+		m_committedFrames[m_writeIndex] = frames;
+		publish(&m_buffers[m_writeIndex * m_frames]);
 	}
 
-	T read()
+	//! Let the reader know no more periods follow, read() returns nullptr then
+	void commitEnd()
 	{
-		m_readSem.acquire();
-		T element = m_buffer[m_readIndex++];
-		m_readIndex %= m_size;
-		m_writeSem.release();
-		return element;
+		m_free.acquire();
+		publish(nullptr);
 	}
 
-	void waitUntilRead()
+	//! The oldest period, or nullptr at the end of the stream. Blocks while
+	//! the FIFO is empty.
+	const SampleFrame* read()
+	{
+		// the reader is done with the period it got before
+		if (m_reading) { m_free.release(); }
+		m_reading = true;
+
+		m_used.acquire();
+		const SampleFrame* buffer = m_committed[m_readIndex];
+		m_readFrames = m_committedFrames[m_readIndex];
+		m_readIndex = (m_readIndex + 1) % m_size;
+		if (buffer == nullptr) { m_drained.release(); }
+		return buffer;
+	}
+
+	//! The number of frames of the period read() returned last
+	fpp_t readFrames() const
 	{
-		m_writeSem.acquire(m_size);
-		m_writeSem.release(m_size);
+		return m_readFrames;
 	}
 
-	bool available()
+	//! Block until the reader has got to the end of the stream
+	void waitUntilRead()
 	{
-		return m_readSem.available();
+		m_drained.acquire();
 	}
 
 
 private:
-	QSemaphore m_readSem;
-	QSemaphore m_writeSem;
-	int m_readIndex;
-	int m_writeIndex;
-	int m_size;
-	T * m_buffer;
+	void publish(const SampleFrame* buffer)
+	{
+		m_committed[m_writeIndex] = buffer;
+		m_writeIndex = (m_writeIndex + 1) % m_size;
+		m_used.release();
+	}
+
+	const int m_size;
+	const fpp_t m_frames;
+	std::unique_ptr<SampleFrame[]> m_buffers;
+	std::vector<const SampleFrame*> m_committed;
+	std::vector<fpp_t> m_committedFrames;
+
+	std::counting_semaphore<> m_free; //!< periods the writer may still use
+	std::counting_semaphore<> m_used; //!< periods committed but not read yet
+	std::binary_semaphore m_drained;
+
+	int m_writeIndex = 0; //!< only used by the writer
+	int m_readIndex = 0; //!< only used by the reader
+	bool m_reading = false; //!< only used by the reader
+	fpp_t m_readFrames = 0; //!< only used by the reader
 } ;
 
 
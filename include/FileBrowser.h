@@ -26,6 +26,7 @@
 #define LMMS_GUI_FILE_BROWSER_H
 
 #include <QDir>
+#include <QHash>
 #include <QMutex>
 #include <memory>
 
@@ -107,7 +108,8 @@ private:
 	void saveDirectoriesStates();
 	void restoreDirectoriesStates();
 
-	void foundSearchMatch(FileSearch* search, const QString& match);
+	void foundSearchMatches(FileSearch* search, const QStringList& matches);
+	void addSearchMatch(const QString& match);
 	void searchCompleted(FileSearch* search);
 	void onSearch(const QString& filter);
 	void displaySearch(bool on);
@@ -121,6 +123,11 @@ private:
 	Type m_type;
 
 	std::shared_ptr<FileSearch> m_currentSearch;
+	//! Items of the search results by their path, to find the parents of new results quickly
+	QHash<QString, QTreeWidgetItem*> m_searchItems;
+	//! Entries found by the last complete search, reused by searches in the same paths until reloading
+	std::shared_ptr<const QStringList> m_searchIndex;
+	QString m_searchIndexPaths;
 	QProgressBar* m_searchIndicator = nullptr;
 
 	QString m_directories; //!< Directories to search, split with '*'
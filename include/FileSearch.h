@@ -28,6 +28,7 @@
 #include <QDir>
 #include <QObject>
 #include <atomic>
+#include <memory>
 
 namespace lmms {
 //! A Qt object that encapsulates the operation of searching the file system.
@@ -35,8 +36,12 @@ class FileSearch : public QObject
 {
 	Q_OBJECT
 public:
-	//! Number of milliseconds the search waits before signaling a matching result.
-	static constexpr int MillisecondsBetweenResults = 1;
+	//! Number of milliseconds the search collects matches before signaling them.
+	static constexpr int MillisecondsBetweenResults = 50;
+
+	//! The paths of all directories and files with matching extensions below the searched paths,
+	//! in the order they are found. Searches in the same paths can use it instead of the file system.
+	using Index = QStringList;
 
 	//! Create a `FileSearch` object that uses the specified string filter `filter` and extension filters in
 	//! `extensions` to search within the given `paths`.
@@ -46,15 +51,22 @@ public:
 		const QStringList& excludedPaths = {}, QDir::Filters dirFilters = QDir::Filters{},
 		QDir::SortFlags sortFlags = QDir::SortFlags{});
 
-	//! Execute the search, emitting the `foundResult` signal when matches are found.
+	//! Execute the search, emitting the `foundMatches` signal when matches are found.
 	void operator()();
 
 	//! Cancel the search.
 	void cancel();
 
+	//! Search in @p index instead of the file system. Must be called before the search runs.
+	void setIndex(std::shared_ptr<const Index> index) { m_index = std::move(index); }
+
+	//! The index the search used, or built while searching the file system. Only complete after
+	//! `searchCompleted` was emitted.
+	auto index() const -> std::shared_ptr<const Index> { return m_index; }
+
 signals:
-	//! Emitted when a result is found when searching the file system.
-	void foundMatch(FileSearch* search, const QString& match);
+	//! Emitted with the results found since the last time, at most every `MillisecondsBetweenResults`.
+	void foundMatches(FileSearch* search, const QStringList& matches);
 
 	//! Emitted when the search completes.
 	void searchCompleted(FileSearch* search);
@@ -68,6 +80,7 @@ private:
 	QDir::Filters m_dirFilters;
 	QDir::SortFlags m_sortFlags;
 	std::atomic<bool> m_cancel = false;
+	std::shared_ptr<const Index> m_index;
 };
 } // namespace lmms
 #endif // LMMS_FILE_SEARCH_H
@@ -85,6 +85,9 @@ protected:
 	void leaveEvent(QEvent *event) override;
 
 	virtual float getValue(const QPoint & p);
+	//! Whether a change of the model's value changes what is painted. Editors which only show
+	//! the value at a coarse resolution can skip repainting for smaller changes.
+	virtual bool valueChangeVisible() const { return true; }
 
 private slots:
 	virtual void enterValue();
@@ -0,0 +1,99 @@
+/*
+ * FrozenAudio.h - output of a track rendered ahead of time
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_FROZEN_AUDIO_H
+#define LMMS_FROZEN_AUDIO_H
+
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "LmmsTypes.h"
+#include "SampleFrame.h"
+#include "lmms_export.h"
+
+class QDataStream;
+
+namespace lmms
+{
+
+/**
+ * The output of an AudioBusHandle through the whole song, rendered by a
+ * TrackFreezer and played back in place of the track.
+ *
+ * The output is stored period by period along with the song position each
+ * period was rendered at, so it's found again by position even if the tempo
+ * is automated. Positions within a period are converted with the tempo at
+ * playback time.
+ */
+class LMMS_EXPORT FrozenAudio
+{
+public:
+	FrozenAudio(fpp_t periodSize, sample_rate_t sampleRate);
+
+	fpp_t periodSize() const { return m_periodSize; }
+	sample_rate_t sampleRate() const { return m_sampleRate; }
+
+	//! The latency the output was rendered with, which has to be compensated for just like before
+	f_cnt_t latency() const { return m_latency; }
+	void setLatency(f_cnt_t latency) { m_latency = latency; }
+
+	//! Appends a period of @p buf (silence if null) rendered at song position @p ticks.
+	//! Periods rendered at or before the last position, e.g. after a loop, are dropped.
+	void append(const SampleFrame* buf, double ticks);
+
+	//! Writes the period rendered at song position @p ticks to @p buf.
+	//! Returns false, leaving @p buf untouched, if nothing or only silence was rendered there.
+	bool read(SampleFrame* buf, double ticks, float framesPerTick) const;
+
+	//! The memory taken by the rendered frames, in bytes
+	std::size_t memoryUsage() const { return m_frames.capacity() * sizeof(SampleFrame); }
+	//! Frees the memory reserved for periods which weren't appended, once done appending
+	void shrinkToFit() { m_frames.shrink_to_fit(); }
+
+	//! Writes all periods to @p stream, e.g. to send them to another host
+	void save(QDataStream& stream) const;
+	//! Reads periods written by save(), returns null if @p stream doesn't hold them
+	static auto load(QDataStream& stream) -> std::shared_ptr<FrozenAudio>;
+
+private:
+	static constexpr auto SilentPeriod = std::numeric_limits<std::size_t>::max();
+
+	bool isAudible(std::size_t period) const;
+	//! Writes @p count frames of @p period from @p offset on to @p buf, or silence if there are none
+	void copy(std::size_t period, std::size_t offset, std::size_t count, SampleFrame* buf) const;
+
+	fpp_t m_periodSize;
+	sample_rate_t m_sampleRate;
+	f_cnt_t m_latency = 0;
+
+	//! The frames of all periods which weren't silent, one after the other
+	std::vector<SampleFrame> m_frames;
+	//! The song position of each period, in ascending order
+	std::vector<double> m_ticks;
+	//! The index of each period's first frame in m_frames, or SilentPeriod
+	std::vector<std::size_t> m_starts;
+};
+
+} // namespace lmms
+
+#endif // LMMS_FROZEN_AUDIO_H
@@ -34,7 +34,11 @@
 #include "Plugin.h"
 #include "TimePos.h"
 
+#include <atomic>
 #include <cmath>
+#include <memory>
+#include <span>
+#include <vector>
 
 
 namespace lmms
@@ -46,6 +50,7 @@ class MidiEvent;
 class NotePlayHandle;
 class Track;
 class SampleFrame;
+class ThreadableJob;
 
 
 class LMMS_EXPORT Instrument : public Plugin
@@ -57,6 +62,7 @@ public:
 		IsSingleStreamed = 0x01,	/*! Instrument provides a single audio stream for all notes */
 		IsMidiBased = 0x02,			/*! Instrument is controlled by MIDI events rather than NotePlayHandles */
 		IsNotBendable = 0x04,		/*! Instrument can't react to pitch bend changes */
+		BatchesNotes = 0x08,		/*! All notes of the track are rendered by one job through playNotes() */
 	};
 
 	using Flags = lmms::Flags<Flag>;
@@ -65,7 +71,7 @@ public:
 			const Descriptor * _descriptor,
 			const Descriptor::SubPluginFeatures::Key * key = nullptr,
 			Flags flags = Flag::NoFlags);
-	~Instrument() override = default;
+	~Instrument() override;
 
 	// --------------------------------------------------------------------
 	// functions that can/should be re-implemented:
@@ -84,6 +90,12 @@ public:
 	{
 	}
 
+	// renders all notes of the track playing in this period at once, called
+	// instead of playNote() for instruments with Flag::BatchesNotes. The
+	// default implementation calls playNote() for every note, instruments
+	// may re-implement it to share work between their voices
+	virtual void playNotes( std::span<NotePlayHandle* const> notes );
+
 	// needed for deleting plugin-specific-data of a note - plugin has to
 	// cast void-ptr so that the plugin-data is deleted properly
 	// (call of dtor if it's a class etc.)
@@ -131,6 +143,11 @@ public:
 		return !m_flags.testFlag(Instrument::Flag::IsNotBendable);
 	}
 
+	bool batchesNotes() const
+	{
+		return m_flags.testFlag(Instrument::Flag::BatchesNotes);
+	}
+
 	// sub-classes can re-implement this for receiving all incoming
 	// MIDI-events
 	inline virtual bool handleMidiEvent( const MidiEvent&, const TimePos& = TimePos(), f_cnt_t offset = 0 )
@@ -158,6 +175,19 @@ public:
 		return m_instrumentTrack;
 	}
 
+	//! Resumes processing a single-streamed instrument suspended while idle, see
+	//! InstrumentPlayHandle. Called for every note and MIDI event, from any thread.
+	void wake()
+	{
+		m_wakeRequests.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	//! Changes whenever wake() is called
+	unsigned wakeRequests() const
+	{
+		return m_wakeRequests.load(std::memory_order_relaxed);
+	}
+
 
 protected:
 	// fade in to prevent clicks
@@ -170,10 +200,44 @@ protected:
 
 	float computeReleaseTimeMsByFrameCount(f_cnt_t frames) const;
 
+	// single-streamed instruments whose voices can be split into groups not
+	// sharing any state may render these groups in parallel: play() calls
+	// renderVoiceGroups(), which calls renderVoiceGroup() for every group on
+	// the worker threads of the audio engine and adds their output to the
+	// working buffer. While waiting for the groups, the calling thread
+	// processes other queued jobs, which may take locks held by the caller
+	//
+	// must not be called while the instrument is playing, e.g. from the
+	// constructor or while the audio engine is locked
+	void setVoiceGroups(int groups);
+
+	int voiceGroups() const
+	{
+		return static_cast<int>(m_voiceGroupJobs.size()) + 1;
+	}
+
+	void renderVoiceGroups(SampleFrame* buffer, fpp_t frames);
+
+	// to be implemented by instruments calling renderVoiceGroups(), adds the
+	// voices of the given group to the buffer. Any worker thread may call it,
+	// concurrently with the other groups
+	virtual void renderVoiceGroup(int /* group */, SampleFrame* /* buffer */, fpp_t /* frames */)
+	{
+	}
+
 
 private:
+	class VoiceGroupJob;
+
 	InstrumentTrack * m_instrumentTrack;
 	Flags m_flags;
+
+	//! Jobs of all voice groups but the first one, which is rendered by the thread playing the instrument
+	std::vector<std::unique_ptr<VoiceGroupJob>> m_voiceGroupJobs;
+	//! Jobs queued in the current period
+	std::vector<ThreadableJob*> m_queuedVoiceGroups;
+
+	std::atomic<unsigned> m_wakeRequests = 0;
 };
 
 
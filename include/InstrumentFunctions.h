@@ -26,6 +26,9 @@
 #define LMMS_INSTRUMENT_FUNCTIONS_H
 
 #include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
 
 #include "AutomatableModel.h"
 #include "ComboBoxModel.h"
@@ -161,10 +164,26 @@ public:
 
 
 private:
+	//! The notes added to every base note, expanded whenever the chord or its range changes
+	struct ChordSchedule
+	{
+		unsigned revision;
+		int chordSize;
+		//! Keys relative to the base note, chordSize of them per octave of the range
+		std::vector<int> offsets;
+	};
+
+	std::shared_ptr<const ChordSchedule> chordSchedule() const;
+
 	BoolModel m_chordsEnabledModel;
 	ComboBoxModel m_chordsModel;
 	FloatModel m_chordRangeModel;
 
+	//! Increased whenever the chord schedule may have changed
+	std::atomic<unsigned> m_scheduleRevision = 0;
+	//! Accessed atomically, as notes are processed by the worker threads
+	mutable std::shared_ptr<const ChordSchedule> m_schedule;
+
 
 	friend class gui::InstrumentFunctionNoteStackingView;
 
@@ -209,6 +228,23 @@ private:
 		Sync
 	} ;
 
+	//! The keys of one cycle of steps, expanded whenever the arpeggio changes. Steps of
+	//! ArpDirection::Random and of ArpMode::Sort can't be precomputed and aren't included.
+	struct ArpSchedule
+	{
+		unsigned revision;
+		ArpDirection direction;
+		int repeats;
+		int cycle;
+		int chordSize;
+		//! Number of steps of the arpeggio, i.e. notes of the chord times range and repeats
+		int range;
+		//! Key relative to the base note of every step of a cycle
+		std::vector<int> offsets;
+	};
+
+	std::shared_ptr<const ArpSchedule> arpSchedule() const;
+
 	BoolModel m_arpEnabledModel;
 	ComboBoxModel m_arpModel;
 	FloatModel m_arpRangeModel;
@@ -221,6 +257,11 @@ private:
 	ComboBoxModel m_arpDirectionModel;
 	ComboBoxModel m_arpModeModel;
 
+	//! Increased whenever the arpeggio schedule may have changed
+	std::atomic<unsigned> m_scheduleRevision = 0;
+	//! Accessed atomically, as notes are processed by the worker threads
+	mutable std::shared_ptr<const ArpSchedule> m_schedule;
+
 
 	friend class InstrumentTrack;
 	friend class gui::InstrumentFunctionArpeggioView;
@@ -25,6 +25,8 @@
 #ifndef LMMS_INSTRUMENT_PLAY_HANDLE_H
 #define LMMS_INSTRUMENT_PLAY_HANDLE_H
 
+#include <chrono>
+
 #include "PlayHandle.h"
 #include "lmms_export.h"
 
@@ -50,8 +52,29 @@ public:
 
 	bool isFromTrack(const Track* track) const override;
 
+	//! Single-streamed instruments keep being processed without any notes, so the handle
+	//! suspends the instrument once its output has been silent for SuspendTimeout without
+	//! any notes or MIDI events. It isn't processed then, and neither are the effects of
+	//! the track once they have quit, until the next note or MIDI event wakes it up, which
+	//! happens before the next period is scheduled.
+	bool requiresProcessing() const override
+	{
+		return !isSuspended();
+	}
+
+	bool isSuspended() const;
+
+	static constexpr auto SuspendTimeout = std::chrono::seconds{1};
+
 private:
 	Instrument* m_instrument;
+
+	//! Like auto-quit of effects, disabled by "Keep effects running even without input"
+	bool m_suspendable;
+	//! Frames the instrument has been idle for
+	f_cnt_t m_idleFrames = 0;
+	//! The wake requests of the instrument the last time it was processed
+	unsigned m_wakeRequests = 0;
 };
 
 } // namespace lmms
@@ -26,6 +26,10 @@
 #ifndef LMMS_INSTRUMENT_TRACK_H
 #define LMMS_INSTRUMENT_TRACK_H
 
+#include <span>
+#include <vector>
+
+#include <QDomDocument>
 
 #include "AudioBusHandle.h"
 #include "InstrumentFunctions.h"
@@ -46,6 +50,7 @@ namespace lmms
 
 class Instrument;
 class DataFile;
+class FrozenAudio;
 
 namespace gui
 {
@@ -74,6 +79,9 @@ public:
 
 	void processInEvent( const MidiEvent& event, const TimePos& time = TimePos(), f_cnt_t offset = 0 ) override;
 	void processOutEvent( const MidiEvent& event, const TimePos& time = TimePos(), f_cnt_t offset = 0 ) override;
+	//! Skips pressure and pitch bend events which a later one in the batch
+	//! overrides before passing the rest to processInEvent()
+	void processInEvents( const TimedMidiEvent* events, std::size_t count ) override;
 	// silence all running notes played by this track
 	void silenceAllNotes( bool removeIPH = false );
 
@@ -89,6 +97,45 @@ public:
 	// filter and so on
 	void playNote( NotePlayHandle * _n, SampleFrame* _working_buffer );
 
+	//! Like playNote(), for all notes of the track playing in this period
+	void playNotes( std::span<NotePlayHandle* const> notes );
+
+	//! Job rendering the notes of a track in one go if its instrument
+	//! batches notes, instead of a job per note
+	class NoteBatch : public ThreadableJob
+	{
+	public:
+		NoteBatch( InstrumentTrack* track );
+
+		//! Returns true for the first note added in a period, i.e. when
+		//! the batch has to be queued
+		bool add( NotePlayHandle* n )
+		{
+			m_notes.push_back( n );
+			return m_notes.size() == 1;
+		}
+
+		bool requiresProcessing() const override
+		{
+			return !m_notes.empty();
+		}
+
+		void doProcessing() override;
+
+	private:
+		InstrumentTrack* m_track;
+		std::vector<NotePlayHandle*> m_notes;
+		std::vector<NotePlayHandle*> m_begun;
+		std::vector<NotePlayHandle*> m_playing;
+	} ;
+
+	bool batchesNotes() const;
+
+	NoteBatch& noteBatch()
+	{
+		return m_noteBatch;
+	}
+
 	QString instrumentName() const;
 	const Instrument *instrument() const
 	{
@@ -115,6 +162,12 @@ public:
 		return static_cast<int>( ( ( m_pitchModel.value() + m_pitchModel.range()/2 ) * MidiMaxPitchBend ) / m_pitchModel.range() );
 	}
 
+	//! Returns how many notes may play at the same time at most, 0 for no limit (see NotePlayHandleManager::stealVoices())
+	int maxVoices() const
+	{
+		return m_maxVoicesModel.value();
+	}
+
 	/*! \brief Returns current range for pitch bend in semitones */
 	int midiPitchRange() const
 	{
@@ -138,6 +191,16 @@ public:
 	using Track::setJournalling;
 
 
+	//! Whether the instrument of this muted track wasn't created when loading
+	//! the project yet, but only its saved state kept
+	bool hasDeferredInstrument() const
+	{
+		return !m_deferredInstrument.documentElement().isNull();
+	}
+
+	//! Creates the instrument whose creation was deferred, if any
+	void loadDeferredInstrument();
+
 	// load instrument whose name matches given one
 	Instrument * loadInstrument(const QString & _instrument_name,
 				const Plugin::Descriptor::SubPluginFeatures::Key* key = nullptr,
@@ -239,8 +302,19 @@ public:
 
 	void autoAssignMidiDevice( bool );
 
+	//! Plays @p audio, rendered by a TrackFreezer, in the song instead of the
+	//! instrument and its effects, until anything it was rendered from changes
+	void freeze(std::shared_ptr<const FrozenAudio> audio);
+	void unfreeze();
+
+	bool isFrozen() const
+	{
+		return m_freezeWatcher != nullptr;
+	}
+
 signals:
 	void instrumentChanged();
+	void frozenChanged();
 	void midiNoteOn( const lmms::Note& );
 	void midiNoteOff( const lmms::Note& );
 	void newNote();
@@ -266,6 +340,11 @@ protected slots:
 private:
 	void processCCEvent(int controller);
 
+	//! Whether creating the instrument saved in @p instrument can wait
+	//! until the track is unmuted or opened
+	bool mayDeferInstrument(const QDomElement& instrument) const;
+	void restoreInstrument(const QDomElement& instrument);
+
 	MidiPort m_midiPort;
 
 	NotePlayHandle* m_notes[NumKeys];
@@ -298,8 +377,11 @@ private:
 	IntModel m_pitchRangeModel;
 	IntModel m_mixerChannelModel;
 	BoolModel m_useMasterPitchModel;
+	IntModel m_maxVoicesModel;
 
 	Instrument * m_instrument;
+	//! Holds the saved "instrument" element while its creation is deferred
+	QDomDocument m_deferredInstrument;
 	InstrumentSoundShaping m_soundShaping;
 	InstrumentFunctionArpeggio m_arpeggio;
 	InstrumentFunctionNoteStacking m_noteStacking;
@@ -308,9 +390,15 @@ private:
 
 	Microtuner m_microtuner;
 
+	NoteBatch m_noteBatch;
+	std::vector<NotePlayHandle*> m_batchedNotes;
+
 	std::unique_ptr<BoolModel> m_midiCCEnable;
 	std::unique_ptr<FloatModel> m_midiCCModel[MidiControllerCount];
 
+	//! Context of the connections unfreezing the track, which are dropped along with it
+	std::unique_ptr<QObject> m_freezeWatcher;
+
 	friend class gui::InstrumentTrackView;
 	friend class gui::InstrumentTrackWindow;
 	friend class NotePlayHandle;
@@ -25,6 +25,8 @@
 #ifndef LMMS_GUI_INSTRUMENT_TRACK_VIEW_H
 #define LMMS_GUI_INSTRUMENT_TRACK_VIEW_H
 
+#include <QTimer>
+
 #include "TrackView.h"
 
 #include "InstrumentTrack.h"
@@ -71,6 +73,10 @@ public:
 	// Create a menu for assigning/creating channels for this track
 	QMenu * createMixerMenu( QString title, QString newMixerLabel ) override;
 
+public slots:
+	//! Renders the track into frozen audio, or plays it live again if it's frozen
+	void toggleFreeze();
+
 
 protected:
 	void modelChanged() override;
@@ -93,11 +99,16 @@ private slots:
 
 	void handleConfigChange(QString cls, QString attr, QString value);
 
+	//! Destroys the window if it's still closed, to be created again once opened
+	void releaseInstrumentTrackWindow();
+
 private:
 	static QPixmap determinePixmap(InstrumentTrack* instrumentTrack);
 
 private:
 	InstrumentTrackWindow * m_window;
+	//! Runs while the window is closed, see releaseInstrumentTrackWindow()
+	QTimer m_windowReleaseTimer;
 
 	// widgets in track-settings-widget
 	TrackLabelButton * m_tlb;
@@ -159,6 +159,7 @@ private:
 	InstrumentSoundShapingView * m_ssView;
 	InstrumentFunctionNoteStackingView* m_noteStackingView;
 	InstrumentFunctionArpeggioView* m_arpeggioView;
+	LcdSpinBox* m_maxVoicesSpinBox;
 	QWidget* m_instrumentFunctionsView; // container of note stacking and arpeggio
 	InstrumentMidiIOView * m_midiView;
 	EffectRackView * m_effectView;
@@ -56,6 +56,10 @@ public:
 
 	InstrumentTrackWindow * instrumentTrackWindow();
 
+	//! Whether the view may be destroyed while the window of its track is
+	//! closed, to be created again when it's opened
+	virtual bool isDisposable() const { return true; }
+
 } ;
 
 
@@ -0,0 +1,77 @@
+/*
+ * JournalDiff.h - line based differences between journalled states
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_JOURNAL_DIFF_H
+#define LMMS_JOURNAL_DIFF_H
+
+#include <QStringList>
+
+#include <cstddef>
+#include <vector>
+
+#include "lmms_export.h"
+
+namespace lmms
+{
+
+/**
+	The changes which turn one list of lines into another one
+
+	The undo journal stores the serialized state of an object as indented
+	XML, which has one line per element. Editing a few notes of a clip then
+	only changes a few lines, so storing the difference to the next state
+	instead of the whole state saves most of the memory.
+*/
+class LMMS_EXPORT JournalDiff
+{
+public:
+	//! Computes the changes turning @p from into @p to
+	static JournalDiff between(const QStringList& from, const QStringList& to);
+
+	//! Applies the changes to the lines they were computed from
+	QStringList applyTo(const QStringList& from) const;
+
+	bool isEmpty() const
+	{
+		return m_hunks.empty();
+	}
+
+	//! An estimate of the memory held, in bytes
+	std::size_t memoryUsage() const;
+
+
+private:
+	//! Replaces @p removed lines starting at @p pos with @p inserted
+	struct Hunk
+	{
+		int pos;
+		int removed;
+		QStringList inserted;
+	};
+
+	std::vector<Hunk> m_hunks;
+} ;
+
+
+} // namespace lmms
+
+#endif // LMMS_JOURNAL_DIFF_H
@@ -168,6 +168,8 @@ protected:
 
 	void changeEvent(QEvent * ev) override;
 
+	bool valueChangeVisible() const override;
+
 	/*!
 	 * Affects how the label of the knob is rendered.
 	 *
@@ -200,6 +202,9 @@ private:
 
 	void drawKnob( QPainter * _p );
 	void drawLabel(QPainter& p);
+	//! The pixmap and the arc of the knob, shared by all knobs of the same kind and size
+	QPixmap background() const;
+	int currentAngle() const;
 	bool updateAngle();
 
 	int angleFromValue( float value, float minValue, float maxValue, float totalAngle ) const
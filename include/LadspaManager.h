@@ -33,6 +33,8 @@
 #include <QPair>
 #include <QString>
 #include <QStringList>
+#include <QVariantList>
+#include <optional>
 
 
 #include "lmms_export.h"
@@ -74,11 +76,17 @@ enum class LadspaPluginType
 
 struct LadspaManagerDescription
 {
+	//! Resolved when the descriptor is first needed if the library was not
+	//! loaded while scanning it
 	LADSPA_Descriptor_Function descriptorFunction;
+	QString library;
 	uint32_t index;
 	LadspaPluginType type;
 	uint16_t inputChannels;
 	uint16_t outputChannels;
+	// kept so listing the plugins does not need their libraries
+	QString name;
+	bool realTimeCapable;
 };
 
 class LMMS_EXPORT LadspaManager
@@ -330,10 +338,14 @@ public:
 						LADSPA_Handle _instance );
 
 private:
-	void  addPlugins( LADSPA_Descriptor_Function _descriptor_func,
-						const QString & _file );
-	uint16_t  getPluginInputs( const LADSPA_Descriptor * _descriptor );
-	uint16_t  getPluginOutputs( const LADSPA_Descriptor * _descriptor );
+	void  addPlugins( const QVariantList & _plugins,
+				LADSPA_Descriptor_Function _descriptor_func,
+				const QString & _library, const QString & _file );
+	//! Loads @p _library and lists its plugins, may run on any thread
+	static std::optional<QVariantList> scanLibrary( const QString & _library,
+				LADSPA_Descriptor_Function & _descriptor_func );
+	static uint16_t  getPluginInputs( const LADSPA_Descriptor * _descriptor );
+	static uint16_t  getPluginOutputs( const LADSPA_Descriptor * _descriptor );
 
 	const LADSPA_PortDescriptor* getPortDescriptor( const ladspa_key_t& _plugin,
 													uint32_t _port );
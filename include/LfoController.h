@@ -80,10 +80,13 @@ protected:
 	float m_phaseOffset;
 	float m_currentPhase;
 
-	sample_t (*m_sampleFunction)( const float );
+	//! Fills a buffer with the selected wave shape from the given phase on, using the given phase increment
+	void (*m_waveFunction)( float* values, f_cnt_t frames, float phase, float phaseIncrement );
 
 private:
 	float m_heldSample;
+	//! See AudioEngine::SharedRandomScope
+	std::uint64_t m_randomKey;
 	std::shared_ptr<const SampleBuffer> m_userDefSampleBuffer = SampleBuffer::emptyBuffer();
 
 protected slots:
@@ -0,0 +1,103 @@
+/*
+ * LinearPhaseFilter.h - FIR filter with a linear phase, designed from a magnitude response
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_LINEAR_PHASE_FILTER_H
+#define LMMS_LINEAR_PHASE_FILTER_H
+
+#include <array>
+#include <functional>
+#include <future>
+#include <memory>
+
+#include "LmmsTypes.h"
+#include "PartitionedConvolution.h"
+#include "lmms_export.h"
+
+namespace lmms
+{
+
+class SampleFrame;
+
+/**
+ * A stereo FIR filter with a linear phase, for equalizers which must not
+ * shift the phase of the bands they change.
+ *
+ * The filter is designed from its magnitude response on the ThreadPool and
+ * convolved period by period with a UniformConvolver. All frequencies are
+ * delayed by half the filter's length, which is its latency. When the response
+ * changes, the output fades from the old filter to the new one over a period.
+ *
+ * As the convolution is bound to the period size, the filter holds the period
+ * size of the engine while it exists, see AudioEngine::holdFramesPerPeriod().
+ */
+class LMMS_EXPORT LinearPhaseFilter
+{
+public:
+	//! The gain of the filter at a frequency in Hz
+	using Magnitude = std::function<float(float)>;
+
+	//! A filter of @p length taps, a power of two, for the periods of the engine
+	LinearPhaseFilter(std::size_t length, sample_rate_t sampleRate);
+	~LinearPhaseFilter();
+
+	LinearPhaseFilter(const LinearPhaseFilter&) = delete;
+	auto operator=(const LinearPhaseFilter&) -> LinearPhaseFilter& = delete;
+
+	//! A length of about a tenth of a second, which resolves shelves and peaks down to 20 Hz
+	static auto lengthFor(sample_rate_t sampleRate) -> std::size_t;
+
+	//! By how many frames the output lags behind the input
+	auto latency() const -> f_cnt_t { return static_cast<f_cnt_t>(m_length / 2); }
+
+	//! Designs the filter for @p magnitude in the background. Must be called on the thread calling process().
+	//! While a design is running, only the latest magnitude response is designed next.
+	void setMagnitude(Magnitude magnitude);
+
+	//! Filters @p frames frames of @p buf in place, @p frames must be the period size.
+	//! Until the first response is designed, the signal is only delayed.
+	void process(SampleFrame* buf, fpp_t frames);
+
+private:
+	//! Designs the kernel for @p magnitude into m_responses[@p target]
+	void design(const Magnitude& magnitude, int target);
+
+	std::size_t m_length;
+	std::size_t m_periodSize;
+	sample_rate_t m_sampleRate;
+
+	std::array<std::unique_ptr<UniformConvolver>, 2> m_channels;
+	std::array<FftwBuffer<float>, 2> m_in;
+	std::array<FftwBuffer<float>, 2> m_out;
+	FftwBuffer<float> m_fadeOut;
+
+	//! The response being played, and the one being designed or faded from
+	std::array<PartitionedResponse, 2> m_responses;
+	int m_played = 0;
+	bool m_fading = false;
+
+	Magnitude m_pending;
+	std::future<void> m_job;
+};
+
+} // namespace lmms
+
+#endif // LMMS_LINEAR_PHASE_FILTER_H
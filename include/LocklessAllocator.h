@@ -36,16 +36,27 @@ namespace lmms
 class LocklessAllocator
 {
 public:
-	LocklessAllocator( size_t nmemb, size_t size );
+	LocklessAllocator( size_t nmemb, size_t size, size_t alignment = sizeof( void * ) );
 	virtual ~LocklessAllocator();
 	void * alloc();
+	//! Like alloc(), but doesn't complain if there's no free space
+	void * tryAlloc();
 	void free( void * ptr );
 
+	bool owns( const void * ptr ) const
+	{
+		return ptr >= m_pool && ptr < m_pool + m_capacity * m_elementSize;
+	}
+
+	size_t capacity() const { return m_capacity; }
+	size_t memoryUsage() const { return m_capacity * m_elementSize; }
+
 
 private:
 	char * m_pool;
 	size_t m_capacity;
 	size_t m_elementSize;
+	size_t m_alignment;
 
 	std::atomic_int * m_freeState;
 	size_t m_freeStateSets;
@@ -62,8 +73,8 @@ template<typename T>
 class LocklessAllocatorT : private LocklessAllocator
 {
 public:
-	LocklessAllocatorT( size_t nmemb ) :
-		LocklessAllocator( nmemb, sizeof( T ) )
+	LocklessAllocatorT( size_t nmemb, size_t alignment = sizeof( void * ) ) :
+		LocklessAllocator( nmemb, sizeof( T ), alignment )
 	{
 	}
 
@@ -74,11 +85,20 @@ public:
 		return (T *)LocklessAllocator::alloc();
 	}
 
+	T * tryAlloc()
+	{
+		return (T *)LocklessAllocator::tryAlloc();
+	}
+
 	void free( T * ptr )
 	{
 		LocklessAllocator::free( ptr );
 	}
 
+	using LocklessAllocator::owns;
+	using LocklessAllocator::capacity;
+	using LocklessAllocator::memoryUsage;
+
 } ;
 
 
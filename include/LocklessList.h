@@ -55,16 +55,19 @@ public:
 
 	void push( T value )
 	{
-		Element * e = m_allocator->alloc();
-		e->value = value;
-		e->next = m_first.load(std::memory_order_relaxed);
+		link( m_allocator->alloc(), value );
+	}
 
-		while (!m_first.compare_exchange_weak(e->next, e,
-				std::memory_order_release,
-				std::memory_order_relaxed))
+	//! Like push(), but returns false instead of complaining if the list is full
+	bool tryPush( T value )
+	{
+		Element * e = m_allocator->tryAlloc();
+		if( !e )
 		{
-			// Empty loop (compare_exchange_weak updates e->next)
+			return false;
 		}
+		link( e, value );
+		return true;
 	}
 
 	Element * popList()
@@ -89,6 +92,19 @@ public:
 
 
 private:
+	void link( Element * e, T value )
+	{
+		e->value = value;
+		e->next = m_first.load(std::memory_order_relaxed);
+
+		while (!m_first.compare_exchange_weak(e->next, e,
+				std::memory_order_release,
+				std::memory_order_relaxed))
+		{
+			// Empty loop (compare_exchange_weak updates e->next)
+		}
+	}
+
 	std::atomic<Element*> m_first;
 	LocklessAllocatorT<Element> * m_allocator;
 
@@ -121,6 +121,9 @@ protected:
 	void copyBuffersFromLmms(const SampleFrame* buf, fpp_t frames);
 	//! Copy our ports into buffers passed by LMMS
 	void copyBuffersToLmms(SampleFrame* buf, fpp_t frames) const;
+	//! Mix our ports into buffers passed by LMMS, scaling the buffers by
+	//! @p dry and our ports by @p wet
+	void mixBuffersToLmms(SampleFrame* buf, fpp_t frames, float dry, float wet) const;
 	//! Run the Lv2 plugin instance for @param frames frames
 	void run(fpp_t frames);
 
@@ -58,6 +58,17 @@ struct LV2_Evbuf_Iterator
 	uint32_t offset;
 };
 
+/**
+   An event to be written by lv2_evbuf_write_events.
+*/
+struct LV2_Evbuf_Event
+{
+	uint32_t frames;
+	uint32_t type;
+	uint32_t size;
+	const uint8_t* data;
+};
+
 /**
    Allocate a new, empty event buffer.
    URIDs for atom:Chunk and atom:Sequence must be passed for LV2_EVBUF_ATOM.
@@ -73,14 +84,26 @@ lv2_evbuf_free(LV2_Evbuf* evbuf);
 
 /**
    Clear and initialize an existing event buffer.
-   The contents of buf are ignored entirely and overwritten, except capacity
-   which is unmodified.
+   Only the header of the sequence is written, so this is cheap no matter
+   how large the buffer is; the capacity is unmodified.
    If input is false and this is an atom buffer, the buffer will be prepared
    for writing by the plugin.  This MUST be called before every run cycle.
 */
 void
 lv2_evbuf_reset(LV2_Evbuf* evbuf, bool input);
 
+/**
+   Return the capacity the buffer has been allocated with.
+*/
+uint32_t
+lv2_evbuf_get_capacity(LV2_Evbuf* evbuf);
+
+/**
+   Return the capacity needed to hold `count` events of `size` bytes each.
+*/
+uint32_t
+lv2_evbuf_capacity_for(uint32_t count, uint32_t size);
+
 /**
    Return the total padded size of the events stored in the buffer.
 */
@@ -151,6 +174,19 @@ lv2_evbuf_write(	LV2_Evbuf_Iterator* iter,
 					const uint8_t* data);
 
 
+/**
+   Write `count` events at `iter`, like that many calls to lv2_evbuf_write,
+   but checking the space left only once.
+   The events must be sorted by time, as atom sequences must be.
+   @return The number of events written, less than `count` if the buffer is
+   full.
+*/
+uint32_t
+lv2_evbuf_write_events(	LV2_Evbuf_Iterator* iter,
+						const LV2_Evbuf_Event* events,
+						uint32_t count);
+
+
 } // namespace lmms
 
 #endif // LMMS_HAVE_LV2
@@ -166,7 +166,7 @@ struct ControlPortBase : public VisitablePort<ControlPortBase, PortBase>
 struct Control : public VisitablePort<Control, ControlPortBase>
 {
 	//! Data location which Lv2 plugins see
-	//! Model values are being copied here every run
+	//! Model values are being copied here before runs where they changed
 	//! Between runs, this data is not up-to-date
 	float m_val;
 };
@@ -174,7 +174,7 @@ struct Control : public VisitablePort<Control, ControlPortBase>
 struct Cv : public VisitablePort<Cv, ControlPortBase>
 {
 	//! Data location which Lv2 plugins see
-	//! Model values are being copied here every run
+	//! Model values are being copied here before runs where they changed
 	//! Between runs, this data is not up-to-date
 	std::vector<float> m_buffer;
 };
@@ -195,6 +195,11 @@ struct Audio : public VisitablePort<Audio, PortBase>
 	//! @param channel channel index into each sample frame
 	void copyBuffersToCore(SampleFrame* lmmsBuf,
 		unsigned channel, fpp_t frames) const;
+	//! Mix our ports into buffers passed by LMMS, i.e. scale the buffers by
+	//! @p dry and add our ports scaled by @p wet
+	//! @param channel channel index into each sample frame
+	void mixBuffersToCore(SampleFrame* lmmsBuf,
+		unsigned channel, fpp_t frames, float dry, float wet) const;
 
 	bool isSideChain() const { return m_sidechain; }
 	bool isOptional() const { return m_optional; }
@@ -29,15 +29,18 @@
 
 #ifdef LMMS_HAVE_LV2
 
+#include <array>
 #include <lilv/lilv.h>
 #include <memory>
 #include <optional>
+#include <vector>
 
 #include <ringbuffer/ringbuffer.h>
 
 #include "LinkedModelGroups.h"
 #include "LmmsSemaphore.h"
 #include "Lv2Basics.h"
+#include "Lv2Evbuf.h"
 #include "Lv2Features.h"
 #include "Lv2Options.h"
 #include "Lv2Worker.h"
@@ -117,6 +120,8 @@ public:
 	*/
 	//! Copy values from the LMMS core (connected models, MIDI events, ...) into
 	//! the respective ports
+	//! @note Control ports are only written if their models changed since
+	//!   the last call
 	void copyModelsFromCore();
 	//! Bring values from all ports to the LMMS core
 	void copyModelsToCore();
@@ -146,6 +151,13 @@ public:
 	 */
 	void copyBuffersToCore(SampleFrame* buf, unsigned firstChan, unsigned num,
 								fpp_t frames) const;
+	/**
+	 * Like copyBuffersToCore(), but mix our ports into the buffers passed by
+	 * the core, scaling the buffers by @p dry and our ports by @p wet.
+	 * This saves effects a temporary buffer and a pass over it.
+	 */
+	void mixBuffersToCore(SampleFrame* buf, unsigned firstChan, unsigned num,
+								fpp_t frames, float dry, float wet) const;
 	//! Run the Lv2 plugin instance for @param frames frames
 	void run(fpp_t frames);
 
@@ -196,14 +208,25 @@ private:
 	ringbuffer_t<struct MidiInputEvent> m_midiInputBuf;
 	//! MIDI ringbuffer reader
 	ringbuffer_reader_t<struct MidiInputEvent> m_midiInputReader;
+	//! The MIDI events of a period, converted and sorted by time for being
+	//! written to the atom port in one go, preallocated for a full ringbuffer
+	std::vector<std::array<uint8_t, 4>> m_midiInputBytes;
+	std::vector<LV2_Evbuf_Event> m_midiInputAtoms;
 
 	// other
 	static int32_t defaultEvbufSize() { return 1 << 15; /* ardour uses this*/ }
+	//! Capacity of the largest atom port buffer
+	int32_t m_sequenceSize = defaultEvbufSize();
 
 	//! models for the controls, sorted by port symbols
 	//! @note These are not owned, but rather link to the models in
 	//!   ControlPorts in `m_ports`
 	std::map<std::string, AutomatableModel *> m_connectedModels;
+	//! whether the next copyModelsFromCore() must write all control ports,
+	//! e.g. because they were just created
+	bool m_copyAllModels = true;
+	//! whether the plugin relies on all periods having the same length
+	bool m_fixedBlockLength = false;
 
 	void initMOptions(); //!< initialize m_options
 	void initPluginSpecificFeatures();
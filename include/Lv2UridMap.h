@@ -30,9 +30,12 @@
 #ifdef LMMS_HAVE_LV2
 
 #include <lv2/urid/urid.h>
-#include <mutex> // TODO: use semaphore, even though this is not realtime critical
+#include <array>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <string>
-#include <unordered_map>
 #include <vector>
 
 
@@ -42,19 +45,50 @@ namespace lmms
 
 /**
  * Complete implementation of the Lv2 Urid Map extension
+ *
+ * Plugins may map and unmap URIs from the audio thread, so looking up URIs
+ * which are mapped already never blocks: both directions are read from
+ * tables which are only ever appended to. Only mapping a new URI takes a
+ * lock, which is rare after instantiation.
  */
 class UridMap
 {
-	std::unordered_map<std::string, LV2_URID> m_map;
-	std::vector<const char*> m_unMap;
-
-	//! mutex for both m_map and m_unMap
+	struct Slot
+	{
+		std::atomic<const char*> uri = nullptr; //!< written last, so the URID is valid once this is set
+		std::atomic<LV2_URID> urid = 0;
+	};
+
+	//! Open addressing hash table from URIs to URIDs, filled at most half
+	struct Table
+	{
+		explicit Table(std::size_t capacity) : slots(capacity) {}
+		std::vector<Slot> slots;
+	};
+
+	std::atomic<Table*> m_table;
+	//! All tables ever used, as readers may still look into replaced ones
+	std::vector<std::unique_ptr<Table>> m_tables;
+
+	//! The URIs, in the order of their URIDs; elements never move
+	std::deque<std::string> m_uris;
+
+	//! URIs by URID - 1, in chunks of doubling size, so they never move
+	static constexpr std::size_t FirstChunkSize = 256;
+	static constexpr std::size_t ChunkCount = 24;
+	std::array<std::atomic<std::atomic<const char*>*>, ChunkCount> m_unmapChunks{};
+	std::vector<std::unique_ptr<std::atomic<const char*>[]>> m_unmapStorage;
+
+	//! serializes the mapping of new URIs
 	//! the URID map is global, which is why a mutex is required here
 	std::mutex m_MapMutex;
 
 	LV2_URID_Map m_mapFeature;
 	LV2_URID_Unmap m_unmapFeature;
 
+	static LV2_URID find(const Table& table, const char* uri, std::size_t hash);
+	static void insert(Table& table, const char* uri, std::size_t hash, LV2_URID urid);
+
 public:
 	//! constructor; will set up the features
 	UridMap();
@@ -30,7 +30,6 @@
 #ifdef LMMS_HAVE_LV2
 
 #include <lv2/worker/worker.h>
-#include <thread>
 #include <vector>
 
 #include "LocklessRingBuffer.h"
@@ -41,6 +40,10 @@ namespace lmms
 
 /**
 	Worker container
+
+	Requests of threaded workers are run on a small pool of threads shared by
+	all workers. Each worker's requests are run one after another, in the
+	order they were scheduled, as the Lv2 worker extension requires.
 */
 class Lv2Worker
 {
@@ -64,8 +67,19 @@ public:
 	LV2_Worker_Status respond(uint32_t size, const void* data);
 
 private:
+	friend class Lv2WorkerPool;
+
 	// functions
-	void workerFunc();
+	//! Run all queued requests, called by the pool
+	void workOnRequests();
+	//! Whether requests are queued for the pool
+	bool hasRequests() const { return !m_requestsReader.empty(); }
+	//! Write @p size and @p data into @p ring in one piece, so the reader
+	//! never sees just a part of it
+	LV2_Worker_Status write(LocklessRingBuffer<char>& ring, std::vector<char>& buf,
+		uint32_t size, const void* data);
+	//! Run a request in the calling thread
+	void workInline(uint32_t size, const void* data);
 	std::size_t bufferSize() const;  //!< size of internal buffers
 
 	// parameters
@@ -75,12 +89,13 @@ private:
 	LV2_Worker_Schedule m_scheduleFeature;
 
 	// threading/synchronization
-	std::thread m_thread;
-	std::vector<char> m_response;  //!< buffer where single requests from m_requests are unpacked
+	std::vector<char> m_request;  //!< buffer where single requests from m_requests are unpacked
+	std::vector<char> m_response;  //!< buffer where single requests from m_responses are unpacked
+	std::vector<char> m_scheduled, m_responded;  //!< buffers where requests are packed for writing
 	LocklessRingBuffer<char> m_requests, m_responses;  //!< ringbuffer to queue multiple requests
 	LocklessRingBufferReader<char> m_requestsReader, m_responsesReader;
-	std::atomic<bool> m_exit = false;  //!< Whether the worker function should keep looping
-	Semaphore m_sem;
+	bool m_busy = false;  //!< Whether a pool thread works on our requests, guarded by the pool
+	bool m_inline = false;  //!< Whether a request currently runs in the scheduling thread
 	Semaphore* m_workLock;
 };
 
@@ -31,6 +31,8 @@
 #include <QMainWindow>
 #include <QMdiArea>
 
+#include <future>
+
 #include "ConfigManager.h"
 
 class QAction;
@@ -179,6 +181,8 @@ public slots:
 
 private slots:
 	void onExportProjectMidi();
+	void showLoadReport();
+	void showMemoryReport();
 
 protected:
 	void closeEvent( QCloseEvent * _ce ) override;
@@ -243,6 +247,8 @@ private:
 	QBasicTimer m_updateTimer;
 	QTimer m_autoSaveTimer;
 	int m_autoSaveInterval;
+	//! Whether the autosave running on a worker thread succeeded
+	std::future<bool> m_autoSaveResult;
 
 	friend class GuiApplication;
 
@@ -0,0 +1,90 @@
+/*
+ * MemoryReport.h - tells where the memory of the loaded project goes
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_MEMORY_REPORT_H
+#define LMMS_MEMORY_REPORT_H
+
+#include <QString>
+#include <cstddef>
+#include <vector>
+
+#include "lmms_export.h"
+
+namespace lmms {
+
+/**
+ * The memory used by the subsystems of the engine, e.g. to decide which
+ * tracks to freeze or which samples to stream.
+ *
+ * Only memory the subsystems keep track of is included: plugins report
+ * theirs if they implement Plugin::memoryUsage(), and samples are only found
+ * if they were loaded from files. Memory shared between users, like a sample
+ * used by several clips, is counted once, except for plugins, which each
+ * report what they hold.
+ */
+class LMMS_EXPORT MemoryReport
+{
+public:
+	enum class Category
+	{
+		Samples,
+		Wavetables,
+		Plugins,
+		UndoJournal,
+		Thumbnails,
+		NotePlayHandles,
+		MixerBuffers,
+		Count
+	};
+
+	struct Entry
+	{
+		Category category;
+		QString name;
+		std::size_t bytes;
+	};
+
+	//! Collects the memory used right now, must be called on the main thread
+	static auto collect() -> MemoryReport;
+
+	//! The entries of all categories, the largest first
+	auto entries() const -> const std::vector<Entry>& { return m_entries; }
+
+	auto total() const -> std::size_t;
+	auto total(Category category) const -> std::size_t;
+
+	static auto categoryName(Category category) -> QString;
+	//! @p bytes in the largest unit leaving at least 1 of it, e.g. "1.5 MiB"
+	static auto formatBytes(std::size_t bytes) -> QString;
+
+	//! The totals of each category followed by the entries, as a table
+	auto toString() const -> QString;
+
+private:
+	void add(Category category, const QString& name, std::size_t bytes);
+
+	std::vector<Entry> m_entries;
+};
+
+} // namespace lmms
+
+#endif // LMMS_MEMORY_REPORT_H
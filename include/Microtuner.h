@@ -25,13 +25,20 @@
 #ifndef LMMS_MICROTUNER_H
 #define LMMS_MICROTUNER_H
 
+#include <array>
+#include <memory>
+
 #include "AutomatableModel.h"
 #include "ComboBoxModel.h"
 #include "JournallingObject.h"
+#include "Note.h"
 
 namespace lmms
 {
 
+class Keymap;
+class Scale;
+
 class LMMS_EXPORT Microtuner : public Model, public JournallingObject
 {
 	Q_OBJECT
@@ -53,6 +60,8 @@ public:
 	int baseKey() const;
 	float baseFreq() const;
 
+	//! Looked up in tables of all keys, which are computed whenever the scale
+	//! or the keymap changes, so it's safe to call on the audio thread
 	float keyToFreq(int key, int userBaseNote) const;
 	int octaveSize() const;
 
@@ -65,11 +74,27 @@ protected slots:
 	void updateKeymapList(int index);
 
 private:
+	//! The frequency of a key is the one of the middle note for the base
+	//! note, times the ratio of the key to the middle note
+	struct FrequencyTable
+	{
+		//! The base key of the keymap if the key range is imported, or -1
+		//! for the base note of the instrument
+		int baseKey;
+		std::array<float, NumKeys> middleFrequencies;
+		std::array<double, NumKeys> ratios;
+	};
+
+	void updateFrequencies();
+
 	BoolModel m_enabledModel;               //!< Enable microtuner (otherwise using 12-TET @440 Hz)
 	ComboBoxModel m_scaleModel;
 	ComboBoxModel m_keymapModel;
 	BoolModel m_keyRangeImportModel;
 
+	//! Accessed atomically, as notes may ask for frequencies from any thread
+	std::shared_ptr<const FrequencyTable> m_frequencies;
+
 };
 
 } // namespace lmms
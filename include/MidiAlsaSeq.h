@@ -35,6 +35,8 @@
 #include <QThread>
 #include <QTimer>
 
+#include <chrono>
+
 
 #include "MidiClient.h"
 
@@ -72,6 +74,11 @@ public:
 	void processOutEvent( const MidiEvent & _me,
 						const TimePos & _time,
 						const MidiPort * _port ) override;
+	//! Schedules the event on the sequencer's queue instead of a timer thread
+	void processOutEvent( const MidiEvent & event,
+						const TimePos & time,
+						f_cnt_t offset,
+						const MidiPort * port ) override;
 
 	void applyPortMode( MidiPort * _port ) override;
 	void applyPortName( MidiPort * _port ) override;
@@ -123,6 +130,9 @@ private slots:
 private:
 	void run() override;
 
+	//! Output the event on the queue, @p delay from now
+	void outputEvent( const MidiEvent & event, const MidiPort * port, std::chrono::nanoseconds delay );
+
 #ifdef LMMS_HAVE_ALSA
 	QMutex m_seqMutex;
 	snd_seq_t * m_seqHandle;
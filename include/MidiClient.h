@@ -26,9 +26,14 @@
 #define LMMS_MIDI_CLIENT_H
 
 #include <QStringList>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 
+#include "LmmsTypes.h"
 #include "MidiEvent.h"
 
 class QObject;
@@ -37,6 +42,7 @@ class QObject;
 namespace lmms
 {
 
+class MidiOutScheduler;
 class MidiPort;
 class TimePos;
 
@@ -53,6 +59,20 @@ public:
 						const TimePos & _time,
 						const MidiPort * _port ) = 0;
 
+	//! Send an event rendered @p offset frames into the current period. It
+	//! is due when that frame is played, one period later. The default
+	//! holds it back on a timer thread and then sends it through the
+	//! method above, clients which can schedule events themselves
+	//! re-implement this.
+	virtual void processOutEvent( const MidiEvent & event,
+						const TimePos & time,
+						f_cnt_t offset,
+						const MidiPort * port );
+
+	//! Drop the events still held back and stop the timer thread. Has to be
+	//! called before a client which used it gets destroyed.
+	void stopOutScheduler();
+
 	// inheriting classes can re-implement this for being able to update
 	// their internal port-structures etc.
 	virtual void applyPortMode( MidiPort * _port );
@@ -63,6 +83,10 @@ public:
 	// re-implemented methods HAVE to call removePort() of base-class!!
 	virtual void removePort( MidiPort * _port );
 
+	//! Let all ports process the events queued since the last period,
+	//! called by the audio thread at the start of each period
+	void processQueuedInEvents( fpp_t frames, sample_rate_t sampleRate );
+
 
 	// returns whether client works with raw-MIDI, only needs to be
 	// re-implemented by MidiClientRaw for returning true
@@ -111,8 +135,20 @@ public:
 	static MidiClient * openMidiClient();
 
 protected:
+	//! When the frame @p offset frames into the current period is played
+	std::chrono::steady_clock::time_point outputTime( f_cnt_t offset ) const;
+
 	std::vector<MidiPort *> m_midiPorts;
 
+private:
+	// start of the current period and its timing, set by processQueuedInEvents()
+	std::atomic<std::chrono::steady_clock::rep> m_periodStart = 0;
+	std::atomic<fpp_t> m_periodFrames = 0;
+	std::atomic<sample_rate_t> m_periodSampleRate = 0;
+
+	std::once_flag m_outSchedulerCreated;
+	std::unique_ptr<MidiOutScheduler> m_outScheduler;
+
 } ;
 
 
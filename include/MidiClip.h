@@ -26,8 +26,18 @@
 #ifndef LMMS_MIDI_CLIP_H
 #define LMMS_MIDI_CLIP_H
 
+#include <span>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <QDomDocument>
+#include <QDomElement>
+
 #include "Clip.h"
 #include "Note.h"
+#include "NoteIndex.h"
 
 
 namespace lmms
@@ -52,15 +62,40 @@ public:
 		MelodyClip
 	} ;
 
+	//! The notes saved in a clip, parsed ahead of loading the clip
+	struct ParsedNotes
+	{
+		QDomElement clip;
+		//! The copy of the clip the notes were parsed from
+		QDomDocument document;
+		//! The element is only kept for notes with detuning, which is
+		//! loaded from it
+		std::vector<std::pair<Note::Attributes, QDomElement>> notes;
+	};
+
 	MidiClip( InstrumentTrack* instrumentTrack );
 	~MidiClip() override;
 
+	//! Parses the notes of a clip from @p clip, the text of its element, into
+	//! a document of its own. QDom isn't thread-safe, so this is what worker
+	//! threads may do while the project's document is used by other threads.
+	//! The clip element is left for the caller to set.
+	static std::optional<ParsedNotes> parseNotes(const QString& clip);
+
+	//! Makes loadSettings() take the notes of the clips in @p parsed instead
+	//! of parsing them again. Returns the previous ones, for restoring them.
+	static std::vector<ParsedNotes>* useParsedNotes(std::vector<ParsedNotes>* parsed);
+
 	void init();
 
 	void updateLength() override;
 
 	// note management
 	Note * addNote( const Note & _new_note, const bool _quant_pos = true );
+	//! Adds copies of @p newNotes in one go: the notes are merged into the
+	//! sorted ones at once, with a single journal checkpoint and a single
+	//! dataChanged(). Returns the added notes.
+	NoteVector addNotes(const std::vector<Note>& newNotes, const bool quantPos = true);
 
 	NoteVector::const_iterator removeNote(NoteVector::const_iterator it);
 	NoteVector::const_iterator removeNote(Note* note);
@@ -72,9 +107,29 @@ public:
 
 	inline const NoteVector & notes() const
 	{
-		return m_notes;
+		return *m_notes;
 	}
 
+	//! Copies of a clip and clips loaded with the same notes share their notes
+	//! until one of them changes. Changing them through this clip's methods
+	//! takes care of that, but the notes returned by notes() or noteAtStep()
+	//! may only be modified after calling this. The notes of the clip open in
+	//! the piano roll are never shared.
+	void detachNotes();
+
+	//! Returns the notes starting at @p pos. Playback asks for positions in
+	//! ascending order, so a cursor remembers where the last query ended and
+	//! only moves forward, other positions are searched for.
+	//! Must only be called with the instrument track locked.
+	std::span<Note* const> notesStartingAt(const TimePos& pos) const;
+
+	//! Returns the notes with a key in [@p firstKey, @p lastKey] which cover
+	//! any tick in [@p from, @p to], in the order of notes(). The notes are
+	//! indexed the first time they are searched after changing, so finding
+	//! the visible ones or the one under the mouse is fast in huge clips.
+	//! Step notes count as NoteIndex::MinLength ticks long.
+	NoteVector notesIn(tick_t from, tick_t to, int firstKey = 0, int lastKey = NumKeys - 1) const;
+
 	Note * addStepNote( int step );
 	void setStep( int step, bool enabled );
 
@@ -93,6 +148,12 @@ public:
 		return m_clipType;
 	}
 
+	//! The number of steps shown in the pattern editor
+	int steps() const
+	{
+		return m_steps;
+	}
+
 
 	// next/previous track based on position in the containing track
 	MidiClip * previousMidiClip() const;
@@ -151,12 +212,25 @@ private:
 
 	Type m_clipType;
 
+	//! Shares the notes of a clip loaded before with the same notes
+	void shareNotes();
+
 	// data-stuff
-	NoteVector m_notes;
+	std::shared_ptr<NoteVector> m_notes;
 	int m_steps;
 
+	//! Index of the note following the ones returned by notesStartingAt() last
+	mutable std::size_t m_playCursor = 0;
+
+	//! Built by notesIn() from the GUI thread, invalidated whenever the notes change
+	mutable NoteIndex m_noteIndex;
+
 	MidiClip * adjacentMidiClipByOffset(int offset) const;
 
+	static std::vector<ParsedNotes>* s_parsedNotes;
+	//! Where to look for the next clip in s_parsedNotes first
+	static std::size_t s_nextParsedNotes;
+
 	friend class gui::MidiClipView;
 
 
@@ -26,6 +26,9 @@
 #define LMMS_GUI_MIDI_CLIP_VIEW_H
 
 #include <QStaticText>
+
+#include <vector>
+
 #include "ClipView.h"
 #include "embed.h"
 
@@ -102,6 +105,11 @@ private:
 	MidiClip* m_clip;
 	QPixmap m_paintPixmap;
 
+	//! The notes drawn over the background, only redrawn when what they
+	//! show changed. The state holds the note and view properties drawn.
+	QPixmap m_notesPreview;
+	std::vector<int> m_notesPreviewState;
+
 	QColor m_noteFillColor;
 	QColor m_noteBorderColor;
 	QColor m_mutedNoteFillColor;
@@ -27,8 +27,12 @@
 
 #include <QWidget>
 
+#include <array>
+#include <atomic>
+
 #include "AutomatableModel.h"
 #include "Controller.h"
+#include "LocklessList.h"
 #include "MidiEventProcessor.h"
 #include "MidiPort.h"
 
@@ -52,8 +56,12 @@ public:
 	MidiController( Model * _parent );
 	~MidiController() override = default;
 
+	//! Only gets the events the MIDI port couldn't queue, on the thread of the
+	//! MIDI client, which are handed to the audio thread
 	void processInEvent( const MidiEvent & _me,
 					const TimePos & _time, f_cnt_t offset = 0 ) override;
+	//! The events queued during the last period, on the audio thread
+	void processInEvents( const TimedMidiEvent* events, std::size_t count ) override;
 
 	void processOutEvent( const MidiEvent& _me,
 					const TimePos & _time, f_cnt_t offset = 0 ) override
@@ -77,14 +85,56 @@ public slots:
 protected:
 	// The internal per-controller get-value function
 	void updateValueBuffer() override;
+	bool valueChangedInPeriod() override;
 
 
 	MidiPort m_midiPort;
 
 
+	//! The value received last
 	float m_lastValue;
+	//! The value the last period ended with
 	float m_previousValue;
 
+
+private:
+	//! A value received during the period, at the frame it arrived at
+	struct RampPoint
+	{
+		f_cnt_t offset;
+		float value;
+	};
+
+	//! Values arriving faster than this within a period replace the last one
+	static constexpr std::size_t MaxRampPoints = 32;
+
+	//! Updates m_lastValue from @p event, returns false if it isn't a change of this controller
+	bool receiveValue(const MidiEvent& event);
+	void addRampPoint(f_cnt_t offset, float value);
+	//! Drops the points of periods which have passed without reading them
+	void startRampPeriod();
+	//! Adds the events passed on by processInEvent() at the start of the period
+	void processUnqueuedEvents();
+
+	//! The values received during the period m_rampPeriod, which the value
+	//! buffer ramps through, so any number of messages cost one update of
+	//! the buffer and one valueChanged() per period
+	std::array<RampPoint, MaxRampPoints> m_rampPoints;
+	std::size_t m_rampPointCount = 0;
+	long m_rampPeriod = -1;
+
+	//! Events processInEvent() got, as the ramp points and the values above
+	//! are only ever touched by the audio thread
+	LocklessList<MidiEvent> m_unqueuedEvents{MaxRampPoints};
+
+	//! The most and least significant 7 bits of 14-bit controllers, which
+	//! send the latter on the controller number + 32. -1 until received,
+	//! 7-bit controllers don't send it at all.
+	int m_coarseValue = 0;
+	int m_fineValue = -1;
+
+	std::atomic_bool m_valueChangedInPeriod = false;
+
 	friend class gui::ControllerConnectionDialog;
 	friend class AutoDetectMidiController;
 
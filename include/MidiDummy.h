@@ -54,6 +54,11 @@ public:
 		return QString(); // no configuration settings
 	}
 
+	// nothing to send, so don't start the timer thread
+	void processOutEvent( const MidiEvent &, const TimePos &, f_cnt_t, const MidiPort * ) override
+	{
+	}
+
 
 protected:
 	void sendByte( const unsigned char ) override
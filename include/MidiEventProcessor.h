@@ -25,12 +25,22 @@
 #ifndef LMMS_MIDI_EVENT_PROCESSOR_H
 #define LMMS_MIDI_EVENT_PROCESSOR_H
 
+#include <cstddef>
+
 #include "MidiEvent.h"
 #include "TimePos.h"
 
 namespace lmms
 {
 
+//! An event together with where it happens, for passing events in batches
+struct TimedMidiEvent
+{
+	MidiEvent event;
+	TimePos time;
+	f_cnt_t offset;
+};
+
 // all classes being able to process MIDI-events should inherit from this
 class MidiEventProcessor
 {
@@ -43,6 +53,17 @@ public:
 	virtual void processInEvent( const MidiEvent& event, const TimePos& time = TimePos(), f_cnt_t offset = 0 ) = 0;
 	virtual void processOutEvent( const MidiEvent& event, const TimePos& time = TimePos(), f_cnt_t offset = 0 ) = 0;
 
+	//! Process all events of a period at once, in order. Re-implement this
+	//! to share work between the events, by default each one is passed to
+	//! processInEvent().
+	virtual void processInEvents( const TimedMidiEvent* events, std::size_t count )
+	{
+		for( std::size_t i = 0; i < count; ++i )
+		{
+			processInEvent( events[i].event, events[i].time, events[i].offset );
+		}
+	}
+
 } ;
 
 } // namespace lmms
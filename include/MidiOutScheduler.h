@@ -0,0 +1,97 @@
+/*
+ * MidiOutScheduler.h - sends MIDI events at the time they are due
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_MIDI_OUT_SCHEDULER_H
+#define LMMS_MIDI_OUT_SCHEDULER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "MidiEvent.h"
+#include "TimePos.h"
+
+
+namespace lmms
+{
+
+class MidiPort;
+
+
+/**
+	Timer thread for MIDI clients which can only send events right away
+
+	Events rendered in one period are all produced at once. The scheduler
+	holds each of them back until the time it is due, so they reach the
+	hardware as far apart as they are in the audio.
+*/
+class MidiOutScheduler
+{
+public:
+	using Clock = std::chrono::steady_clock;
+	using Send = std::function<void(const MidiEvent&, const TimePos&, const MidiPort*)>;
+
+	//! @p send is called on the scheduler's thread for each event when it is due
+	explicit MidiOutScheduler(Send send);
+	~MidiOutScheduler();
+
+	void schedule(Clock::time_point due, const MidiEvent& event, const TimePos& time, const MidiPort* port);
+
+	//! Drop the pending events of @p port and wait until none of them is being sent
+	void removePort(const MidiPort* port);
+
+
+private:
+	struct Entry
+	{
+		Clock::time_point due;
+		std::uint64_t sequence; //!< keeps events due at the same time in order
+		MidiEvent event;
+		TimePos time;
+		const MidiPort* port;
+	};
+
+	//! Orders the heap by due time, earliest first
+	static bool later(const Entry& a, const Entry& b);
+
+	void run();
+
+	const Send m_send;
+
+	std::mutex m_mutex;
+	std::mutex m_sendMutex;
+	std::condition_variable m_wake;
+	std::vector<Entry> m_queue;
+	std::uint64_t m_sequence;
+	bool m_quit;
+
+	std::thread m_thread;
+} ;
+
+
+} // namespace lmms
+
+#endif // LMMS_MIDI_OUT_SCHEDULER_H
@@ -0,0 +1,86 @@
+/*
+ * MidiPipeWire.h - MIDI client for PipeWire
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_MIDI_PIPEWIRE_H
+#define LMMS_MIDI_PIPEWIRE_H
+
+#include "lmmsconfig.h"
+
+#ifdef LMMS_HAVE_PIPEWIRE
+
+#include <pipewire/pipewire.h>
+
+#include "MidiClient.h"
+
+
+namespace lmms
+{
+
+//! Receives MIDI through a PipeWire filter node with one raw MIDI input port
+class MidiPipeWire : public MidiClientRaw
+{
+public:
+	MidiPipeWire();
+	~MidiPipeWire() override;
+
+	static QString probeDevice();
+
+	inline static QString name()
+	{
+		return QT_TRANSLATE_NOOP("MidiSetupWidget", "PipeWire-MIDI");
+	}
+
+	inline static QString configSection()
+	{
+		return "midipipewire";
+	}
+
+	//! Whether the filter is connected to PipeWire
+	bool isRunning() const
+	{
+		return m_filter != nullptr;
+	}
+
+
+protected:
+	// MIDI output is not implemented yet, as with Jack-MIDI
+	void sendByte(const unsigned char) override {}
+
+
+private:
+	void processCallback();
+	static void staticProcessCallback(void* data, spa_io_position* position);
+
+	pw_thread_loop* m_loop;
+	pw_context* m_context;
+	pw_core* m_core;
+	pw_filter* m_filter;
+	spa_hook m_filterListener;
+	void* m_inputPort;
+};
+
+
+} // namespace lmms
+
+#endif // LMMS_HAVE_PIPEWIRE
+
+#endif // LMMS_MIDI_PIPEWIRE_H
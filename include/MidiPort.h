@@ -30,7 +30,13 @@
 #include <QList>
 #include <QMap>
 
+#include <chrono>
+#include <vector>
+
+#include "LocklessList.h"
 #include "Midi.h"
+#include "MidiEvent.h"
+#include "MidiEventProcessor.h"
 #include "TimePos.h"
 #include "AutomatableModel.h"
 
@@ -38,8 +44,6 @@ namespace lmms
 {
 
 class MidiClient;
-class MidiEvent;
-class MidiEventProcessor;
 
 namespace gui
 {
@@ -111,8 +115,26 @@ public:
 		return outputChannel() ? outputChannel() - 1 : 0;
 	}
 
+	//! Called by the MIDI client for incoming events. Unless disabled with
+	//! setQueueInEvents(), the event is queued without locking and the audio
+	//! thread processes it in processQueuedInEvents().
 	void processInEvent( const MidiEvent& event, const TimePos& time = TimePos() );
-	void processOutEvent( const MidiEvent& event, const TimePos& time = TimePos() );
+	//! Sends the event through the MIDI client, timed @p offset frames into
+	//! the period being rendered
+	void processOutEvent( const MidiEvent& event, const TimePos& time = TimePos(), f_cnt_t offset = 0 );
+
+	//! Processes the events queued since the last period, each at the
+	//! offset into the period it arrived at one period earlier.
+	//! Called by the audio thread at the start of each period.
+	void processQueuedInEvents( std::chrono::steady_clock::time_point periodStart,
+		fpp_t frames, sample_rate_t sampleRate );
+
+	//! Whether incoming events are queued for the audio thread (default) or
+	//! processed right away on the MIDI client's thread
+	void setQueueInEvents( bool queue )
+	{
+		m_queueInEvents = queue;
+	}
 
 
 	void saveSettings( QDomDocument& doc, QDomElement& thisElement ) override;
@@ -153,11 +175,30 @@ private slots:
 
 
 private:
+	struct QueuedInEvent
+	{
+		MidiEvent event;
+		TimePos time;
+		std::chrono::steady_clock::time_point arrival;
+	};
+
+	static constexpr std::size_t InEventQueueSize = 512;
+
+	void dispatchInEvent( const MidiEvent& event, const TimePos& time, f_cnt_t offset );
+	//! Applies the input channel, key range and fixed velocity, returns
+	//! whether the event is to be processed at all
+	bool maskInEvent( MidiEvent& event ) const;
+
 	MidiClient* m_midiClient;
 	MidiEventProcessor* m_midiEventProcessor;
 
 	Mode m_mode;
 
+	LocklessList<QueuedInEvent> m_queuedInEvents;
+	bool m_queueInEvents;
+	//! The queued events of one period, handed to the processor at once
+	std::vector<TimedMidiEvent> m_inEventBatch;
+
 	IntModel m_inputChannelModel;
 	IntModel m_outputChannelModel;
 	IntModel m_inputControllerModel;
@@ -26,6 +26,7 @@
 #define LMMS_MIX_HELPERS_H
 
 #include "LmmsTypes.h"
+#include "lmms_export.h"
 
 namespace lmms
 {
@@ -36,8 +37,36 @@ class SampleFrame;
 namespace MixHelpers
 {
 
+/*! \brief Instruction sets the hot mixing functions have implementations for
+ *
+ * The best one supported by the CPU is chosen once at startup. The functions
+ * produce bit-identical results for each of them.
+ */
+enum class SimdLevel
+{
+	Scalar,
+	Sse2,
+	Avx2,
+	Neon
+};
+
+/*! \brief Instruction set currently used */
+SimdLevel simdLevel();
+
+/*! \brief Best instruction set supported by this build and CPU */
+SimdLevel bestSimdLevel();
+
+/*! \brief Switch the instruction set, e.g. for testing - returns false if it isn't supported */
+bool setSimdLevel( SimdLevel level );
+
 bool isSilent( const SampleFrame* src, int frames );
 
+/*! \brief Copy the planar channels `left` and `right` into the frames of `dst`, e.g. from plugin hosts */
+LMMS_EXPORT void interleave(SampleFrame* dst, const float* left, const float* right, int frames);
+
+/*! \brief Copy the frames of `src` into the planar channels `left` and `right` */
+LMMS_EXPORT void deinterleave(float* left, float* right, const SampleFrame* src, int frames);
+
 bool useNaNHandler();
 
 void setNaNHandler( bool use );
@@ -50,6 +79,24 @@ void add( SampleFrame* dst, const SampleFrame* src, int frames );
 /*! \brief Multiply samples from `dst` by `coeff` */
 void multiply(SampleFrame* dst, float coeff, int frames);
 
+/*! \brief Multiply the left and right samples of `dst` by `coeffLeft` and `coeffRight`, e.g. for panning */
+void multiplyStereo(SampleFrame* dst, float coeffLeft, float coeffRight, int frames);
+
+/*! \brief Multiply the samples of each frame of `dst` by the corresponding value of `coeffBuf` */
+void multiplyByBuffer(SampleFrame* dst, const float* coeffBuf, int frames);
+
+/*! \brief Largest absolute sample of each channel, nans are ignored */
+LMMS_EXPORT SampleFrame absPeak(const SampleFrame* src, int frames);
+
+/*! \brief Sum of the squared samples of each channel */
+LMMS_EXPORT SampleFrame sumOfSquares(const SampleFrame* src, int frames);
+
+/*! \brief Root mean square of the samples of each channel */
+LMMS_EXPORT SampleFrame rms(const SampleFrame* src, int frames);
+
+/*! \brief absPeak() and sumOfSquares() in a single pass, e.g. for metering */
+LMMS_EXPORT void levels(const SampleFrame* src, int frames, SampleFrame& peak, SampleFrame& sumOfSquares);
+
 /*! \brief Add samples from src multiplied by coeffSrc to dst */
 void addMultiplied( SampleFrame* dst, const SampleFrame* src, float coeffSrc, int frames );
 
@@ -75,7 +122,7 @@ void addSanitizedMultipliedByBuffers( SampleFrame* dst, const SampleFrame* src,
 void addMultipliedStereo( SampleFrame* dst, const SampleFrame* src, float coeffSrcLeft, float coeffSrcRight, int frames );
 
 /*! \brief Multiply dst by coeffDst and add samples from src multiplied by coeffSrc */
-void multiplyAndAddMultiplied( SampleFrame* dst, const SampleFrame* src, float coeffDst, float coeffSrc, int frames );
+LMMS_EXPORT void multiplyAndAddMultiplied( SampleFrame* dst, const SampleFrame* src, float coeffDst, float coeffSrc, int frames );
 
 /*! \brief Multiply dst by coeffDst and add samples from srcLeft/srcRight multiplied by coeffSrc */
 void multiplyAndAddMultipliedJoined( SampleFrame* dst, const sample_t* srcLeft, const sample_t* srcRight, float coeffDst, float coeffSrc, int frames );
@@ -25,19 +25,25 @@
 #ifndef LMMS_MIXER_H
 #define LMMS_MIXER_H
 
+#include "CompensationDelay.h"
+#include "CpuTime.h"
 #include "Model.h"
 #include "EffectChain.h"
 #include "JournallingObject.h"
+#include "LocklessRingBuffer.h"
 #include "ThreadableJob.h"
 
 #include <atomic>
+#include <memory>
 #include <optional>
+#include <vector>
 #include <QColor>
 
 namespace lmms
 {
 
 
+class AudioBusHandle;
 class MixerRoute;
 using MixerRouteVector = std::vector<MixerRoute*>;
 
@@ -45,7 +51,7 @@ class MixerChannel : public ThreadableJob
 {
 	public:
 		MixerChannel( int idx, Model * _parent );
-		virtual ~MixerChannel();
+		virtual ~MixerChannel() = default;
 
 		EffectChain m_fxChain;
 
@@ -53,9 +59,11 @@ class MixerChannel : public ThreadableJob
 		bool m_hasInput;
 		// set to true if any effect in the channel is enabled and running
 		bool m_stillRunning;
+		// set to false once the effect chain wrote to m_buffer in the current
+		// period, so clearing the buffer can be skipped for silent channels
+		bool m_bufferSilent;
 
-		float m_peakLeft;
-		float m_peakRight;
+		// owned by the mixer, which allocates the buffers of all channels in one block
 		SampleFrame* m_buffer;
 		bool m_muteBeforeSolo;
 		BoolModel m_muteModel;
@@ -72,11 +80,30 @@ class MixerChannel : public ThreadableJob
 		// pointers to other channels that send to this one
 		MixerRouteVector m_receives;
 
+		// number of audio bus handles feeding this channel in the current period
+		size_t m_busInputs;
+		// the bus handles feeding this channel in deterministic mode, whose
+		// output the channel sums up itself, always in this order
+		std::vector<AudioBusHandle*> m_busHandles;
+
+		// latency of the signals mixed into this channel once they have been
+		// lined up, and of its output, updated every period
+		f_cnt_t m_inputLatency;
+		f_cnt_t m_outputLatency;
+		// the delayed output of a sender
+		std::vector<SampleFrame> m_compensationBuffer;
+
+		// the time taken by summing up the inputs, the effects and the fader
+		CpuTime m_cpuTime;
+
 		int index() const { return m_channelIndex; }
 		void setIndex(int index) { m_channelIndex = index; }
 
 		bool isMaster() { return m_channelIndex == 0; }
 
+		//! Whether m_buffer is known to contain nothing but zeros
+		bool isSilent() const { return m_bufferSilent && !m_hasInput; }
+
 		bool requiresProcessing() const override { return true; }
 		void unmuteForSolo();
 		void unmuteSenderForSolo();
@@ -88,11 +115,34 @@ class MixerChannel : public ThreadableJob
 		std::atomic_size_t m_dependenciesMet;
 		void incrementDeps();
 		void processed();
-		
+
+		//! Levels of the output of the channel, after its fader
+		struct Levels
+		{
+			SampleFrame peak;
+			SampleFrame rms;
+		};
+
+		//! Whether the levels are measured for the meters, e.g. only while the channel is visible
+		void setMetered(bool metered) { m_metered.store(metered, std::memory_order_relaxed); }
+
+		//! Combines the levels of all periods processed since the last call into @p levels,
+		//! returns false if there are none. Must only be called by one thread, usually the GUI thread.
+		bool readLevels(Levels& levels);
+
 	private:
+		//! Periods of levels queued for the meters
+		static constexpr std::size_t LevelsQueueSize = 64;
+
 		void doProcessing() override;
+		void publishLevels(const Levels& levels);
+
 		int m_channelIndex;
 		std::optional<QColor> m_color;
+
+		std::atomic<bool> m_metered;
+		LocklessRingBuffer<Levels> m_levels;
+		LocklessRingBufferReader<Levels> m_levelsReader;
 };
 
 class MixerRoute : public QObject
@@ -127,12 +177,19 @@ public:
 		return m_to;
 	}
 
+	// delays what is sent to line it up with the other inputs of the receiver
+	CompensationDelay& compensation()
+	{
+		return m_compensation;
+	}
+
 	void updateName();
 
 	private:
 		MixerChannel * m_from;
 		MixerChannel * m_to;
 		FloatModel m_amount;
+		CompensationDelay m_compensation;
 };
 
 
@@ -146,8 +203,20 @@ public:
 	void mixToChannel( const SampleFrame* _buf, mix_ch_t _ch );
 
 	void prepareMasterMix();
+	// queue all channels which can be processed right away, the other ones
+	// get queued as soon as all their senders and bus handles are done
+	void scheduleChannels( const std::vector<AudioBusHandle*>& _busHandles );
+	// called by an audio bus handle once it has fed its channel
+	void busHandleProcessed( mix_ch_t _ch );
 	void masterMix( SampleFrame* _buf );
 
+	// latency of the master output: every signal path is delayed to line up
+	// with the path of the highest latency into the same channel
+	f_cnt_t latency() const
+	{
+		return m_latency;
+	}
+
 	void saveSettings( QDomDocument & _doc, QDomElement & _parent ) override;
 	void loadSettings( const QDomElement & _this ) override;
 
@@ -222,6 +291,33 @@ private:
 	// make sure we have at least num channels
 	void allocateChannelsTo(int num);
 
+	// rebuild m_processingOrder, must be called whenever channels or routes change
+	void compileRoutingPlan();
+
+	// all channels, the ones with the longest chain of sends to master first,
+	// so the channels most other ones wait for get processed first
+	std::vector<MixerChannel*> m_processingOrder;
+
+	// set the delays lining up all paths into each channel
+	void compensateLatencies( const std::vector<AudioBusHandle*>& _busHandles );
+
+	// allocate the buffers of all channels from one contiguous block, must be
+	// called with the audio engine locked whenever channels are added or removed
+	void allocateChannelBuffers();
+
+	//! Memory taken by the buffers of the channels and the delay lines lining up their inputs
+	std::size_t memoryUsage() const;
+
+	struct AlignedDeleter
+	{
+		void operator()(SampleFrame* frames) const;
+	};
+	std::unique_ptr<SampleFrame[], AlignedDeleter> m_channelBuffers;
+	// frames from the buffer of one channel to the next one, whole cache lines
+	fpp_t m_channelBufferStride = 0;
+
+	f_cnt_t m_latency = 0;
+
 	int m_lastSoloed;
 } ;
 
@@ -0,0 +1,92 @@
+/*
+ * ModelChangeNotifier.h - passes changes of models made by other threads on to views at display rate
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_GUI_MODEL_CHANGE_NOTIFIER_H
+#define LMMS_GUI_MODEL_CHANGE_NOTIFIER_H
+
+#include <QObject>
+#include <QTimer>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "lmms_export.h"
+
+namespace lmms
+{
+
+class Model;
+
+namespace gui
+{
+
+/**
+ * Coalesces the dataChanged() signals models emit from other threads than
+ * the GUI thread, e.g. when they are automated, which would otherwise queue
+ * an event for every view and period.
+ *
+ * Every receiver owns a bit in a lock-free bitmap, which those threads only
+ * set. The GUI thread collects the set bits at display refresh rate and
+ * updates each changed receiver once. Changes made by the GUI thread itself
+ * still update the receiver right away.
+ */
+class LMMS_EXPORT ModelChangeNotifier : public QObject
+{
+	Q_OBJECT
+public:
+	//! Calls @p update whenever @p model changes, at most once per display refresh if the change
+	//! has been made by another thread. @p receiver owns the connection like a Qt slot does and
+	//! only has a single update function, connecting it again replaces the previous one.
+	static void connectDataChanged(Model* model, QObject* receiver, std::function<void()> update);
+
+private:
+	struct Receiver
+	{
+		QObject* object = nullptr;
+		std::function<void()> update;
+	};
+
+	ModelChangeNotifier();
+
+	static auto instance() -> ModelChangeNotifier&;
+
+	auto bitOf(QObject* object) -> std::size_t;
+	void release(QObject* object);
+	void collect();
+
+	//! A deque, since the elements must not move while other threads set bits in them
+	std::deque<std::atomic<std::uint64_t>> m_changed;
+
+	std::vector<Receiver> m_receivers;
+	std::vector<std::size_t> m_freeBits;
+	std::unordered_map<QObject*, std::size_t> m_bits;
+	QTimer m_timer;
+};
+
+} // namespace gui
+
+} // namespace lmms
+
+#endif // LMMS_GUI_MODEL_CHANGE_NOTIFIER_H
@@ -123,6 +123,21 @@ public:
 	Type type() const { return m_type; }
 	inline void setType(Type t) { m_type = t; }
 
+	//! The attributes of a saved note, apart from its detuning
+	struct Attributes
+	{
+		int key;
+		volume_t volume;
+		panning_t panning;
+		int length;
+		int pos;
+		Type type;
+	};
+
+	//! Only reads @p element, so may be used on any thread
+	static Attributes parseAttributes(const QDomElement& element);
+	void loadAttributes(const Attributes& attributes);
+
 	// used by GUI
 	inline void setSelected( const bool selected ) { m_selected = selected; }
 	inline void setOldKey( const int oldKey ) { m_oldKey = oldKey; }
@@ -0,0 +1,90 @@
+/*
+ * NoteIndex.h - finds the notes in a range of time and keys
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_NOTE_INDEX_H
+#define LMMS_NOTE_INDEX_H
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "LmmsTypes.h"
+#include "Note.h"
+
+namespace lmms
+{
+
+/**
+	Finds the notes of a clip covering a range of time and keys
+
+	The notes are sorted into one list per key, ordered by their position.
+	Along with every note, the latest end of the notes up to it is stored,
+	which only grows along the list. Both are searched in logarithmic time,
+	so only the notes around the range are looked at, however many notes
+	the clip has.
+
+	The index has to be rebuilt after the notes were changed.
+*/
+class LMMS_EXPORT NoteIndex
+{
+public:
+	//! Notes are indexed as covering at least that many ticks, as step notes
+	//! have no length but are drawn that long
+	static constexpr tick_t MinLength = 4;
+
+	//! Indexes @p notes, which must not change until the index is invalidated
+	void build(const NoteVector& notes);
+
+	void invalidate()
+	{
+		m_valid = false;
+	}
+
+	bool isValid() const
+	{
+		return m_valid;
+	}
+
+	//! Returns the notes with a key in [@p firstKey, @p lastKey] which cover
+	//! any tick in [@p from, @p to], both including their end, in the order
+	//! of the indexed vector. Notes without length are left out.
+	NoteVector notesIn(tick_t from, tick_t to, int firstKey, int lastKey) const;
+
+private:
+	struct Entry
+	{
+		tick_t pos;
+		tick_t end;
+		//! The latest end of this and the previous entries
+		tick_t maxEnd;
+		std::size_t order;
+		Note* note;
+	};
+
+	std::array<std::vector<Entry>, NumKeys> m_keys;
+	bool m_valid = false;
+} ;
+
+
+} // namespace lmms
+
+#endif // LMMS_NOTE_INDEX_H
@@ -33,8 +33,6 @@
 #include "PlayHandle.h"
 #include "Track.h"
 
-class QReadWriteLock;
-
 namespace lmms
 {
 
@@ -109,9 +107,21 @@ public:
 	//! Get the current per-note detuning for this note
 	float currentDetuning() const { return m_baseDetuning->value(); }
 
+	//! Length of the fade out of stolen notes
+	static constexpr f_cnt_t StolenFadeFrames = 256;
+
 	/*! Renders one chunk using the attached instrument into the buffer */
 	void play( SampleFrame* buffer ) override;
 
+	/*! Does what play() does before the instrument renders the note, for
+	    notes rendered together with others (see Instrument::playNotes()).
+	    Returns false if the note doesn't play in this period, otherwise the
+	    note stays locked until finishPeriod() is called. */
+	bool beginPeriod();
+
+	/*! Does what play() does after the instrument has rendered the note */
+	void finishPeriod();
+
 	/*! Returns whether playback of note is finished and thus handle can be deleted */
 	bool isFinished() const override
 	{
@@ -130,6 +140,20 @@ public:
 	/*! Releases the note (and plays release frames) */
 	void noteOff( const f_cnt_t offset = 0 );
 
+	/*! Releases the note with a short fade out instead of its release, to make room for other notes */
+	void steal();
+
+	bool isStolen() const
+	{
+		return m_stolen;
+	}
+
+	/*! Returns the length of the fade out of a stolen note */
+	f_cnt_t stolenFadeFrames() const
+	{
+		return m_stolenFadeFrames;
+	}
+
 	/*! Returns number of frames to be played until the note is going to be released */
 	f_cnt_t framesBeforeRelease() const
 	{
@@ -298,6 +322,7 @@ private:
 	f_cnt_t m_totalFramesPlayed;			// total frame-counter - used for
 											// figuring out whether a whole note
 											// has been played
+	f_cnt_t m_framesThisPeriod;				// frames played in current period
 	f_cnt_t m_framesBeforeRelease;			// number of frames after which note
 											// is released
 	f_cnt_t m_releaseFramesToDo;			// total numbers of frames to be
@@ -305,8 +330,11 @@ private:
 	f_cnt_t m_releaseFramesDone;			// number of frames done after
 											// release of note
 	NotePlayHandleList m_subNotes;			// used for chords and arpeggios
+	unsigned m_subNotesCreated;				// orders the sub-notes
 	volatile bool m_released;				// indicates whether note is released
 	bool m_releaseStarted;
+	bool m_stolen;							// released by voice stealing
+	f_cnt_t m_stolenFadeFrames;
 	bool m_hasMidiNote;
 	bool m_hasParent;						// indicates whether note has parent
 	NotePlayHandle * m_parent;			// parent note
@@ -334,11 +362,29 @@ private:
 
 
 const int INITIAL_NPH_CACHE = 256;
-const int NPH_CACHE_INCREMENT = 16;
+const int NPH_CACHE_INCREMENT = 64;
 
+/**
+ * Lock-free pool of note play handles, so notes can be started from any
+ * thread without allocating memory or waiting for a lock.
+ *
+ * The pool is sized for the voices a project needs when it is loaded (see
+ * reserve()). If it runs out of voices anyway, it still grows, and releases
+ * further voices according to the configured VoiceStealing policy until the
+ * reserved voices suffice again. Voices are also stolen when the CPU load is
+ * about to exceed the time budget of a period, and when a track plays more
+ * notes than its maximum number of voices.
+ */
 class NotePlayHandleManager
 {
 public:
+	enum class VoiceStealing
+	{
+		None, //!< Let all notes play to the end
+		Oldest, //!< Release the notes which have been playing the longest
+		Quietest //!< Release the notes with the lowest current volume
+	};
+
 	static void init();
 	static NotePlayHandle * acquire( InstrumentTrack* instrumentTrack,
 					const f_cnt_t offset,
@@ -348,14 +394,18 @@ public:
 					int midiEventChannel = -1,
 					NotePlayHandle::Origin origin = NotePlayHandle::Origin::MidiClip );
 	static void release( NotePlayHandle * nph );
-	static void extend( int i );
+	//! Makes room for at least @p voices notes playing at the same time, must not be called from the audio thread
+	static void reserve( int voices );
 	static void free();
-
-private:
-	static NotePlayHandle ** s_available;
-	static QReadWriteLock s_mutex;
-	static std::atomic_int s_availableIndex;
-	static int s_size;
+	//! Memory taken by the pools of voices, whether the voices are playing or not
+	static std::size_t memoryUsage();
+
+	static void setVoiceStealing( VoiceStealing voiceStealing );
+	//! Fades out the notes exceeding the reserved voices, the voice limits of their tracks or the
+	//! CPU budget. Voices exceeding the limit of a track are stolen even without a VoiceStealing
+	//! policy, the oldest ones in that case. Expects the audio engine's play handles not to be
+	//! processed concurrently.
+	static void stealVoices( const PlayHandleList& playHandles );
 };
 
 
@@ -26,11 +26,15 @@
 #ifndef LMMS_OSCILLATOR_H
 #define LMMS_OSCILLATOR_H
 
+#include <array>
+#include <atomic>
 #include <cassert>
+#include <cstdint>
 #include <fftw3.h>
 #include <memory>
 #include <cstdlib>
 #include <cmath>
+#include <utility>
 
 #include "Engine.h"
 #include "lmms_math.h"
@@ -89,9 +93,15 @@ public:
 		delete m_subOsc;
 	}
 
-	static void waveTableInit();
 	static void destroyFFTPlans();
-	static std::unique_ptr<OscillatorConstants::waveform_t> generateAntiAliasUserWaveTable(const SampleBuffer* sampleBuffer);
+	//! Band-limited waveform of a user wave, shared with all users of an identical wave
+	static std::shared_ptr<const OscillatorConstants::waveform_t> generateAntiAliasUserWaveTable(
+		const SampleBuffer* sampleBuffer);
+	//! Generates the wavetables of @p shape if they haven't been used yet, otherwise that happens
+	//! once an oscillator plays it
+	static void prepareWaveTable(WaveShape shape);
+	//! Memory taken by the wavetables generated so far and those of the user waves in use
+	static std::size_t waveTableMemoryUsage();
 
 	inline void setUseWaveTable(bool n)
 	{
@@ -162,7 +172,7 @@ public:
 
 	static inline sample_t noiseSample( const float )
 	{
-		return 1.0f - rand() * 2.0f / static_cast<float>(RAND_MAX);
+		return 1.0f - fastRand(2.0f);
 	}
 
 	static sample_t userWaveSample(const SampleBuffer* buffer, const float sample)
@@ -190,8 +200,7 @@ public:
 		control.f2 = control.f1 < OscillatorConstants::WAVETABLE_LENGTH - 1 ?
 					control.f1 + 1 :
 					0;
-		control.band = waveTableBandFromFreq(
-			m_freq * m_detuning_div_samplerate * Engine::audioEngine()->outputSampleRate());
+		control.band = m_waveTableBand;
 		return control;
 	}
 
@@ -256,9 +265,18 @@ private:
 	// There are many update*() variants; the modulator flag is stored as a member variable to avoid
 	// adding more explicit parameters to all of them. Can be converted to a parameter if needed.
 	bool m_isModulator;
+	//! Band of the wavetables for the current frequency, looked up once per update()
+	int m_waveTableBand = 1;
+
+	//! Frames rendered at once, the phases of a block are computed before its samples
+	static constexpr fpp_t BlockFrames = 64;
+	//! Number of independent noise generators, interleaved so they can run in parallel
+	static constexpr std::size_t NoiseLanes = 8;
+	std::array<std::uint32_t, NoiseLanes> m_noiseState;
 
 	/* Multiband WaveTable */
-	static sample_t s_waveTables[NumWaveShapeTables][OscillatorConstants::WAVE_TABLES_PER_WAVEFORM_COUNT][OscillatorConstants::WAVETABLE_LENGTH];
+	//! Generated on first use, so only the wave shapes actually played take up memory
+	static std::array<std::atomic<const OscillatorConstants::waveform_t*>, NumWaveShapeTables> s_waveTables;
 	static fftwf_plan s_fftPlan;
 	static fftwf_plan s_ifftPlan;
 	static fftwf_complex * s_specBuf;
@@ -268,24 +286,25 @@ private:
 	static void generateTriangleWaveTable(int bands, sample_t* table, int firstBand = 1);
 	static void generateSquareWaveTable(int bands, sample_t* table, int firstBand = 1);
 	static void generateFromFFT(int bands, sample_t* table);
-	static void generateWaveTables();
+	static void generateFromFFT(OscillatorConstants::waveform_t& waveform);
+	static const OscillatorConstants::waveform_t& generateWaveTable(WaveShape shape);
 	static void createFFTPlans();
 
 	/* End Multiband wavetable */
 
 
-	void updateNoSub( SampleFrame* _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl );
-	void updatePM( SampleFrame* _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl );
-	void updateAM( SampleFrame* _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl );
-	void updateMix( SampleFrame* _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl );
-	void updateSync( SampleFrame* _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl );
-	void updateFM( SampleFrame* _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl );
+	//! Renders a wave shape with a modulation algorithm, or without sub-oscillator if Algo is NoSubOsc
+	using Kernel = void (Oscillator::*)(SampleFrame*, const fpp_t, const ch_cnt_t);
+	//! Row of the kernels used without sub-oscillator, following the ones of the modulation algorithms
+	static constexpr auto NoSubOsc = NumModulationAlgos;
+	using KernelTable = std::array<std::array<Kernel, NumWaveShapes>, NumModulationAlgos + 1>;
+
+	template<std::size_t Algo, WaveShape W>
+	void updateKernel(SampleFrame* ab, const fpp_t frames, const ch_cnt_t chnl);
+	template<std::size_t... Algos>
+	static constexpr auto kernelTable(std::index_sequence<Algos...>) -> KernelTable;
+	template<std::size_t Algo, std::size_t... Shapes>
+	static constexpr auto kernelRow(std::index_sequence<Shapes...>) -> std::array<Kernel, NumWaveShapes>;
 
 	float syncInit( SampleFrame* _ab, const fpp_t _frames,
 							const ch_cnt_t _chnl );
@@ -310,8 +329,32 @@ private:
 	void updateFM( SampleFrame* _ab, const fpp_t _frames,
 							const ch_cnt_t _chnl );
 
+	template<WaveShape W, typename PhaseFn, typename WriteFn>
+	void render(SampleFrame* ab, const fpp_t frames, const ch_cnt_t chnl, PhaseFn nextPhase, WriteFn write);
+
 	template<WaveShape W>
-	inline sample_t getSample( const float _sample );
+	inline void getSamples(const float* phases, sample_t* samples, const fpp_t count);
+
+	//! Interpolates the samples at @p phases from one band of a wavetable
+	void wtSamples(const sample_t* table, const float* phases, sample_t* samples, const fpp_t count) const;
+
+	const sample_t* waveTable(WaveShape shape) const
+	{
+		const auto waveform = s_waveTables[static_cast<std::size_t>(shape) - FirstWaveShapeTable].load(
+			std::memory_order_acquire);
+		return (waveform ? *waveform : generateWaveTable(shape))[m_waveTableBand].data();
+	}
+
+	void noiseSamples(sample_t* samples, const fpp_t count);
+
+	//! Next sample of the xorshift generator with @p state, in [-1, 1)
+	static sample_t nextNoise(std::uint32_t& state)
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return static_cast<float>(static_cast<std::int32_t>(state)) * (1.0f / 2147483648.0f);
+	}
 
 	inline void recalcPhase();
 
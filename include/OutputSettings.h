@@ -27,6 +27,7 @@
 #define LMMS_OUTPUT_SETTINGS_H
 
 #include "LmmsTypes.h"
+#include "SampleConversion.h"
 
 namespace lmms
 {
@@ -56,6 +57,7 @@ public:
 		, m_bitDepth(bitDepth)
 		, m_stereoMode(stereoMode)
 		, m_compressionLevel(0.625) // 5/8
+		, m_dither(SampleConversion::Dither::None)
 	{
 	}
 
@@ -83,12 +85,17 @@ public:
 		m_compressionLevel = level;
 	}
 
+	//! Dither used when writing integer samples
+	SampleConversion::Dither getDither() const { return m_dither; }
+	void setDither(SampleConversion::Dither dither) { m_dither = dither; }
+
 private:
 	sample_rate_t m_sampleRate;
 	bitrate_t m_bitRate;
 	BitDepth m_bitDepth;
 	StereoMode m_stereoMode;
 	double m_compressionLevel;
+	SampleConversion::Dither m_dither;
 };
 
 
@@ -0,0 +1,204 @@
+/*
+ * Oversampler.h - runs nonlinear effects at a multiple of the sample rate
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_OVERSAMPLER_H
+#define LMMS_OVERSAMPLER_H
+
+#include <algorithm>
+#include <array>
+#include <span>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#	include <hiir/Downsampler2xSse.h>
+#	include <hiir/Upsampler2xSse.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#	include <hiir/Downsampler2xNeon.h>
+#	include <hiir/Upsampler2xNeon.h>
+#else
+#	include <hiir/Downsampler2xFpu.h>
+#	include <hiir/Upsampler2xFpu.h>
+#endif
+#include <hiir/PolyphaseIir2Designer.h>
+
+#include "LmmsTypes.h"
+#include "SampleFrame.h"
+
+namespace lmms {
+
+/**
+ * Stereo oversampler for nonlinear effects, which alias less when run at a
+ * multiple of the sample rate.
+ *
+ * Every stage doubles the sample rate using the polyphase IIR half-band
+ * filters of hiir, vectorised where available. An effect passes a period to
+ * upsample(), processes the returned frames in place and passes them back
+ * with downsample(). The buffers are allocated up front for periods of up to
+ * the given number of frames, so nothing is allocated while processing.
+ *
+ * Must only be used by one thread at a time, the effect's.
+ */
+class Oversampler
+{
+public:
+	//! Up to 8x oversampling
+	static constexpr int MaxStages = 3;
+
+	explicit Oversampler(fpp_t maxFrames, int stages = 0)
+		: m_maxFrames(maxFrames)
+		, m_frames(static_cast<std::size_t>(maxFrames) << MaxStages)
+	{
+		for (auto& channel : m_buffers)
+		{
+			for (auto& buffer : channel) { buffer.resize(m_frames.size()); }
+		}
+
+		// the images of the first stage are closest to the signal, the signals of the
+		// others don't come near the edges of their pass bands
+		for (int stage = 0; stage < MaxStages; ++stage)
+		{
+			auto coefs = std::array<double, Coefs>{};
+			hiir::PolyphaseIir2Designer::compute_coefs_spec_order_tbw(coefs.data(), Coefs,
+				stage == 0 ? FirstTransition : Transition);
+			for (auto& channel : m_filters)
+			{
+				channel[stage].up.set_coefs(coefs.data());
+				channel[stage].down.set_coefs(coefs.data());
+			}
+		}
+		setStages(stages);
+	}
+
+	//! The number of times the sample rate is doubled, 0 to pass periods through
+	int stages() const { return m_stages; }
+	int factor() const { return 1 << m_stages; }
+
+	void setStages(int stages)
+	{
+		stages = std::clamp(stages, 0, MaxStages);
+		if (stages != m_stages) { clear(); }
+		m_stages = stages;
+	}
+
+	//! Resets the filters, e.g. when the effect is restarted
+	void clear()
+	{
+		for (auto& channel : m_filters)
+		{
+			for (auto& stage : channel)
+			{
+				stage.up.clear_buffers();
+				stage.down.clear_buffers();
+			}
+		}
+	}
+
+	//! Returns the @p frames frames of @p src at the oversampled rate
+	auto upsample(const SampleFrame* src, fpp_t frames) -> std::span<SampleFrame>
+	{
+		frames = std::min(frames, m_maxFrames);
+		const auto count = static_cast<std::size_t>(frames) << m_stages;
+		for (int ch = 0; ch < 2; ++ch)
+		{
+			auto& buffers = m_buffers[ch];
+			float* in = buffers[0].data();
+			float* out = buffers[1].data();
+			for (fpp_t f = 0; f < frames; ++f) { in[f] = src[f][ch]; }
+
+			long length = frames;
+			for (int stage = 0; stage < m_stages; ++stage)
+			{
+				m_filters[ch][stage].up.process_block(out, in, length);
+				std::swap(in, out);
+				length *= 2;
+			}
+			for (std::size_t f = 0; f < count; ++f) { m_frames[f][ch] = in[f]; }
+		}
+		return {m_frames.data(), count};
+	}
+
+	//! Writes the frames returned by the last call to upsample() back to @p dst,
+	//! at the original rate
+	void downsample(SampleFrame* dst, fpp_t frames)
+	{
+		decimate(m_frames.data(), dst, frames);
+	}
+
+	//! Writes @p frames frames to @p dst from the frames of @p src, which are
+	//! at the oversampled rate, e.g. for signals which were rendered there
+	void decimate(const SampleFrame* src, SampleFrame* dst, fpp_t frames)
+	{
+		frames = std::min(frames, m_maxFrames);
+		const auto count = static_cast<std::size_t>(frames) << m_stages;
+		for (int ch = 0; ch < 2; ++ch)
+		{
+			auto& buffers = m_buffers[ch];
+			float* in = buffers[0].data();
+			float* out = buffers[1].data();
+			for (std::size_t f = 0; f < count; ++f) { in[f] = src[f][ch]; }
+
+			long length = static_cast<long>(count);
+			for (int stage = m_stages - 1; stage >= 0; --stage)
+			{
+				length /= 2;
+				m_filters[ch][stage].down.process_block(out, in, length);
+				std::swap(in, out);
+			}
+			for (fpp_t f = 0; f < frames; ++f) { dst[f][ch] = in[f]; }
+		}
+	}
+
+private:
+	//! Coefficients of the filters of each stage
+	static constexpr int Coefs = 8;
+	//! Transition bandwidths of the filters, relative to the oversampled rate
+	static constexpr double FirstTransition = 0.04;
+	static constexpr double Transition = 0.1;
+
+#if defined(__SSE2__) || defined(_M_X64)
+	using Upsampler = hiir::Upsampler2xSse<Coefs>;
+	using Downsampler = hiir::Downsampler2xSse<Coefs>;
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+	using Upsampler = hiir::Upsampler2xNeon<Coefs>;
+	using Downsampler = hiir::Downsampler2xNeon<Coefs>;
+#else
+	using Upsampler = hiir::Upsampler2xFpu<Coefs>;
+	using Downsampler = hiir::Downsampler2xFpu<Coefs>;
+#endif
+
+	struct Stage
+	{
+		Upsampler up;
+		Downsampler down;
+	};
+
+	fpp_t m_maxFrames;
+	int m_stages = 0;
+	std::array<std::array<Stage, MaxStages>, 2> m_filters;
+	//! Two buffers per channel the stages alternately read from and write to
+	std::array<std::array<std::vector<float>, 2>, 2> m_buffers;
+	std::vector<SampleFrame> m_frames;
+};
+
+} // namespace lmms
+
+#endif // LMMS_OVERSAMPLER_H
@@ -0,0 +1,97 @@
+/*
+ * PartitionedConvolution.h - uniformly partitioned convolution with overlap-save
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_PARTITIONED_CONVOLUTION_H
+#define LMMS_PARTITIONED_CONVOLUTION_H
+
+#include <cstddef>
+
+#include "fft_helpers.h"
+#include "lmms_export.h"
+
+namespace lmms
+{
+
+/**
+ * Spectra of the partitions of one channel of an impulse response, for a
+ * uniformly partitioned convolution with blocks of blockSize frames
+ */
+struct LMMS_EXPORT PartitionedResponse
+{
+	std::size_t blockSize = 0;
+	std::size_t partitions = 0;
+	//! The spectra of all partitions one after the other, blockSize + 1 bins each
+	FftwBuffer<fftwf_complex> spectra;
+
+	auto bins() const -> std::size_t { return blockSize + 1; }
+	auto spectrum(std::size_t partition) const -> const fftwf_complex* { return spectra.get() + partition * bins(); }
+	auto memoryUsage() const -> std::size_t { return partitions * bins() * sizeof(fftwf_complex); }
+
+	//! Splits the @p count samples of @p samples into partitions of @p blockSize and transforms them
+	static auto partition(const float* samples, std::size_t count, std::size_t blockSize) -> PartitionedResponse;
+};
+
+/**
+ * Convolves one channel with PartitionedResponses of up to a number of
+ * partitions, block by block, with the overlap-save method.
+ *
+ * The output of a block is complete as soon as its input is, so the
+ * convolution adds no latency. Since the spectra of the past input don't
+ * depend on the response, one block may be convolved with several responses,
+ * e.g. to fade between them.
+ */
+class LMMS_EXPORT UniformConvolver
+{
+public:
+	UniformConvolver(std::size_t blockSize, std::size_t partitions);
+
+	UniformConvolver(const UniformConvolver&) = delete;
+	auto operator=(const UniformConvolver&) -> UniformConvolver& = delete;
+
+	//! Takes the next block of input, blockSize frames
+	void push(const float* in);
+	//! Writes blockSize frames of the input so far convolved with @p response to @p out
+	void convolve(const PartitionedResponse& response, float* out);
+
+	void process(const float* in, const PartitionedResponse& response, float* out)
+	{
+		push(in);
+		convolve(response, out);
+	}
+
+private:
+	std::size_t m_blockSize;
+	std::size_t m_partitions;
+	fftwf_plan m_forward;
+	fftwf_plan m_inverse;
+	//! The last two blocks of input
+	FftwBuffer<float> m_input;
+	FftwBuffer<float> m_output;
+	//! Spectra of the last input blocks, one per partition, m_newest being the latest
+	FftwBuffer<fftwf_complex> m_history;
+	FftwBuffer<fftwf_complex> m_sum;
+	std::size_t m_newest = 0;
+};
+
+} // namespace lmms
+
+#endif // LMMS_PARTITIONED_CONVOLUTION_H
@@ -25,12 +25,18 @@
 #ifndef LMMS_PATTERN_STORE_H
 #define LMMS_PATTERN_STORE_H
 
+#include <memory>
+#include <mutex>
+#include <vector>
+
 #include "TrackContainer.h"
 #include "ComboBoxModel.h"
 
 namespace lmms
 {
 
+class PatternTrack;
+
 namespace gui
 {
 	class PatternEditorWindow;
@@ -79,6 +85,8 @@ public:
 	}
 
 	bar_t lengthOfPattern(int pattern) const;
+	//! The pattern track in the Song Editor playing @p pattern
+	PatternTrack* patternTrack(int pattern) const;
 	inline bar_t lengthOfCurrentPattern()
 	{
 		return lengthOfPattern(currentPattern());
@@ -92,6 +100,10 @@ public:
 	void fixIncorrectPositions();
 	void createClipsForPattern(int pattern);
 
+	//! Works out what playing the patterns needs to know about them, after the arrangement
+	//! changed. Called by the editing side, so the audio thread only picks the result up.
+	void compilePatterns();
+
 	AutomatedValueMap automatedValuesAt(TimePos time, int clipNum) const override;
 
 public slots:
@@ -103,8 +115,28 @@ signals:
 	void trackUpdated();
 
 private:
+	//! What playing a pattern needs to know about it, worked out once for all
+	//! patterns after the arrangement changed instead of on every tick
+	struct CompiledPattern
+	{
+		bar_t length;
+		PatternTrack* patternTrack;
+	};
+
+	struct CompiledPatterns
+	{
+		std::vector<CompiledPattern> patterns;
+	};
+
+	CompiledPattern compiledPattern(int pattern) const;
+
 	ComboBoxModel m_patternComboBoxModel;
 
+	//! Accessed atomically, as patterns are played by the audio thread while being edited
+	std::shared_ptr<const CompiledPatterns> m_compiledPatterns;
+	//! Serializes compiling, the arrangement may change on more than one thread
+	std::mutex m_compileMutex;
+
 
 	// Where the pattern selection combo box is
 	friend class gui::PatternEditorWindow;
@@ -25,9 +25,13 @@
 #ifndef LMMS_PERFLOG_H
 #define LMMS_PERFLOG_H
 
+#include <chrono>
 #include <ctime>
+#include <vector>
 #include <QString>
 
+#include "lmms_export.h"
+
 namespace lmms
 {
 
@@ -74,6 +78,57 @@ class PerfLogTimer
 	PerfTime begin_time;
 };
 
+/// \brief Collects timings of the stages of loading a project
+///
+/// Timers add the wall-clock time they measure to the report being collected
+/// when they were started, summed up per stage and name. Nothing is measured
+/// while no report is being collected. Timers may run on any thread.
+class LMMS_EXPORT PerfLogReport
+{
+public:
+	struct Entry
+	{
+		QString stage;
+		QString name;
+		int count;
+		double seconds;
+		double maxSeconds;
+	};
+
+	class LMMS_EXPORT Timer
+	{
+	public:
+		Timer(const QString& stage, const QString& name);
+		~Timer();
+
+		Timer(const Timer&) = delete;
+		Timer& operator=(const Timer&) = delete;
+
+		/// Adds the time since construction to the report, once
+		void end();
+
+	private:
+		QString m_stage;
+		QString m_name;
+		int m_report;
+		std::chrono::steady_clock::time_point m_begin;
+	};
+
+	/// Starts collecting a new report, dropping the previous one
+	static void begin(const QString& title);
+	/// Stops starting timers. Running ones still add to the report.
+	static void end();
+	/// Waits for the running timers, like those of samples decoded in the
+	/// background
+	static void waitForTimers();
+
+	static QString title();
+	/// The entries in the order their stage and name were first timed
+	static std::vector<Entry> entries();
+	/// The report as a table, for attaching to bug reports
+	static QString toString();
+};
+
 
 } // namespace lmms
 
@@ -27,6 +27,8 @@
 #ifndef LMMS_GUI_PIANO_ROLL_H
 #define LMMS_GUI_PIANO_ROLL_H
 
+#include <QPixmap>
+#include <QPolygonF>
 #include <QWidget>
 
 #include <vector>
@@ -468,6 +470,16 @@ private:
 	int m_knifeEndKey;
 	bool m_knifeDown;
 
+	// The grid and the notes only change when scrolling, zooming or editing,
+	// so they are drawn into layers which are only redrawn when what they
+	// show changed, as told by their states
+	QPixmap createLayer() const;
+	QPixmap m_gridLayer;
+	std::vector<int> m_gridLayerState;
+	QPixmap m_notesLayer;
+	std::vector<int> m_notesLayerState;
+	QPolygonF m_notesLayerEditHandles;
+
 	void updateKnifePos(QMouseEvent* me, bool initial);
 
 	//! Stores the chords for the strum tool
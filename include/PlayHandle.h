@@ -27,6 +27,8 @@
 
 #include <QList>
 #include <QMutex>
+#include <bit>
+#include <cstdint>
 
 #include "lmms_export.h"
 
@@ -56,6 +58,22 @@ public:
 	using Types = Flags<Type>;
 
 	constexpr static std::size_t MaxNumber = 1024;
+	constexpr static std::size_t TypeCount = 4;
+
+	//! The index of the type, for tables of all types
+	static std::size_t typeIndex(Type type)
+	{
+		return static_cast<std::size_t>(std::countr_zero(static_cast<unsigned>(type)));
+	}
+
+	//! The indices of the handle in the PlayHandleRegistry it's in for each slot
+	struct Slots
+	{
+		std::size_t engine;
+		std::size_t type;
+		std::size_t bus;
+	};
+	constexpr static std::size_t Unlisted = static_cast<std::size_t>(-1);
 
 	PlayHandle( const Type type, f_cnt_t offset = 0 );
 
@@ -89,6 +107,12 @@ public:
 	// required for ThreadableJob
 	void doProcessing() override;
 
+	//! Prepares the buffer for play(), followed by finishProcessing() once
+	//! the handle has been played. Only needed when the handle is played by
+	//! another job than itself.
+	void beginProcessing();
+	void finishProcessing();
+
 	bool requiresProcessing() const override
 	{
 		return !isFinished();
@@ -121,6 +145,15 @@ public:
 		m_offset = _offset;
 	}
 
+	//! Sorts the handle among the others in deterministic render mode: the
+	//! handles are played and mixed in ascending order. Handles get it in the
+	//! order they're created in, except for sub-notes, which sort after their
+	//! parent as they're created by the worker threads.
+	std::uint64_t order() const
+	{
+		return m_order;
+	}
+
 
 	virtual bool isFromTrack( const Track * _track ) const = 0;
 
@@ -148,6 +181,27 @@ public:
 	
 	SampleFrame* buffer();
 
+	//! The buffer passed to play() in this period, nullptr if the handle
+	//! doesn't use one
+	SampleFrame* workingBuffer()
+	{
+		return m_usesBuffer ? buffer() : nullptr;
+	}
+
+	//! Whether the buffer was found to be silent after the last period, in
+	//! which case there's no need to mix it. Note play handles are never
+	//! checked, as they hardly ever are silent.
+	bool isBufferSilent() const
+	{
+		return m_bufferSilent;
+	}
+
+protected:
+	void setOrder(std::uint64_t order)
+	{
+		m_order = order;
+	}
+
 private:
 	Type m_type;
 	f_cnt_t m_offset;
@@ -155,8 +209,13 @@ private:
 	QMutex m_processingLock;
 	SampleFrame* m_playHandleBuffer;
 	bool m_bufferReleased;
+	bool m_bufferSilent;
 	bool m_usesBuffer;
 	AudioBusHandle* m_audioBusHandle;
+	std::uint64_t m_order;
+	Slots m_slots;
+
+	friend class PlayHandleRegistry;
 } ;
 
 using PlayHandleList = QList<PlayHandle*>;
@@ -0,0 +1,132 @@
+/*
+ * PlayHandleRegistry.h - list of play handles with constant time removal
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_PLAY_HANDLE_REGISTRY_H
+#define LMMS_PLAY_HANDLE_REGISTRY_H
+
+#include <algorithm>
+
+#include "PlayHandle.h"
+
+namespace lmms {
+
+/**
+ * A list of play handles which tells whether it holds a handle and removes
+ * it in constant time, as the handles keep their index in the list.
+ *
+ * Removing a handle moves the last one into its place, so the order only
+ * stays the same as the handles were added in until the first removal.
+ * A handle can be in one registry per slot of PlayHandle::Slots.
+ */
+class PlayHandleRegistry
+{
+public:
+	using Slot = std::size_t PlayHandle::Slots::*;
+
+	explicit PlayHandleRegistry(Slot slot) :
+		m_slot(slot)
+	{
+	}
+
+	void add(PlayHandle* handle)
+	{
+		index(handle) = m_handles.size();
+		m_handles.push_back(handle);
+	}
+
+	//! Inserts @p handle before @p position, in linear time
+	void insert(std::size_t position, PlayHandle* handle)
+	{
+		m_handles.insert(static_cast<int>(position), handle);
+		reindex(position);
+	}
+
+	//! Returns false if @p handle isn't in the registry
+	bool remove(PlayHandle* handle)
+	{
+		if (!contains(handle)) { return false; }
+
+		const auto i = index(handle);
+		if (i + 1 < static_cast<std::size_t>(m_handles.size()))
+		{
+			m_handles[static_cast<int>(i)] = m_handles.last();
+			index(m_handles[static_cast<int>(i)]) = i;
+		}
+		m_handles.removeLast();
+		index(handle) = PlayHandle::Unlisted;
+		return true;
+	}
+
+	//! Like remove(), but keeps the order of the others, in linear time
+	bool removeKeepingOrder(PlayHandle* handle)
+	{
+		if (!contains(handle)) { return false; }
+
+		const auto i = index(handle);
+		m_handles.removeAt(static_cast<int>(i));
+		index(handle) = PlayHandle::Unlisted;
+		reindex(i);
+		return true;
+	}
+
+	bool contains(const PlayHandle* handle) const
+	{
+		const auto i = handle->m_slots.*m_slot;
+		return i < static_cast<std::size_t>(m_handles.size()) && m_handles[static_cast<int>(i)] == handle;
+	}
+
+	//! Sorts the handles from @p first on, in linear time plus the sorting
+	template<class Compare>
+	void sort(std::size_t first, Compare compare)
+	{
+		std::sort(m_handles.begin() + static_cast<int>(first), m_handles.end(), compare);
+		reindex(first);
+	}
+
+	void clear()
+	{
+		for (const auto handle : m_handles) { index(handle) = PlayHandle::Unlisted; }
+		m_handles.clear();
+	}
+
+	const PlayHandleList& handles() const { return m_handles; }
+	PlayHandle* operator[](std::size_t i) const { return m_handles[static_cast<int>(i)]; }
+	std::size_t size() const { return static_cast<std::size_t>(m_handles.size()); }
+	bool empty() const { return m_handles.empty(); }
+	auto begin() const { return m_handles.begin(); }
+	auto end() const { return m_handles.end(); }
+
+private:
+	std::size_t& index(PlayHandle* handle) const { return handle->m_slots.*m_slot; }
+
+	void reindex(std::size_t first)
+	{
+		for (auto i = first; i < size(); ++i) { index(m_handles[static_cast<int>(i)]) = i; }
+	}
+
+	PlayHandleList m_handles;
+	Slot m_slot;
+};
+
+} // namespace lmms
+
+#endif // LMMS_PLAY_HANDLE_REGISTRY_H
@@ -27,8 +27,10 @@
 
 #include <QStringList>
 #include <QMap>
+#include <cstddef>
 
 #include "JournallingObject.h"
+#include "LmmsTypes.h"
 #include "Model.h"
 
 
@@ -276,6 +278,20 @@ public:
 	//! reference the class header.  Should return null if not key not found.
 	virtual AutomatableModel* childModel( const QString & modelName );
 
+	//! Return by how many frames the output lags behind the input, e.g. for
+	//! lookahead. The mixer delays parallel signal paths by the same amount.
+	virtual f_cnt_t latency() const
+	{
+		return 0;
+	}
+
+	//! Return how many bytes the plugin holds on to, e.g. for samples or
+	//! delay lines, for the memory report. Plugins which can't tell return 0.
+	virtual std::size_t memoryUsage() const
+	{
+		return 0;
+	}
+
 	//! Overload if the argument passed to the plugin is a subPluginKey
 	//! If you can not pass the key and are aware that it's stored in
 	//! Engine::pickDndPluginKey(), use this function, too
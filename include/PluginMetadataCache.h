@@ -0,0 +1,80 @@
+/*
+ * PluginMetadataCache.h - keeps plugin metadata between runs
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_PLUGIN_METADATA_CACHE_H
+#define LMMS_PLUGIN_METADATA_CACHE_H
+
+#include <QHash>
+#include <QString>
+#include <QVariant>
+#include <optional>
+
+#include "lmms_export.h"
+
+namespace lmms {
+
+/**
+ * Metadata of plugin libraries or bundles, kept in the user's cache directory
+ * so plugins don't need to be loaded and inspected again at every startup.
+ *
+ * Entries are keyed by the path of the library or bundle and only returned
+ * while its modification time is the one stored with them. The cache is
+ * written back when it is destroyed, without the entries not looked up or
+ * inserted since it has been read, so uninstalled plugins are dropped.
+ *
+ * Not thread-safe, use it from the thread discovering the plugins.
+ */
+class LMMS_EXPORT PluginMetadataCache
+{
+public:
+	//! Reads the cache named @p name, whose data is stored in format @p version
+	PluginMetadataCache(const QString& name, quint16 version);
+	~PluginMetadataCache();
+
+	PluginMetadataCache(const PluginMetadataCache&) = delete;
+	auto operator=(const PluginMetadataCache&) -> PluginMetadataCache& = delete;
+
+	//! Returns the data stored for @p path, if @p path has not been modified since
+	auto find(const QString& path) -> std::optional<QVariant>;
+	//! Stores @p data for @p path as it is now
+	void insert(const QString& path, const QVariant& data);
+
+	//! Modification time of @p path, or of its newest file if @p path is a directory
+	static auto modificationTime(const QString& path) -> qint64;
+
+private:
+	struct Entry
+	{
+		qint64 modified = 0;
+		QVariant data;
+		bool used = false;
+	};
+
+	QString m_path;
+	quint16 m_version;
+	QHash<QString, Entry> m_entries;
+	bool m_changed = false;
+};
+
+} // namespace lmms
+
+#endif // LMMS_PLUGIN_METADATA_CACHE_H
@@ -0,0 +1,78 @@
+/*
+ * PolyphaseResampler.h - fast resampler for constant ratios
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_POLYPHASE_RESAMPLER_H
+#define LMMS_POLYPHASE_RESAMPLER_H
+
+#include <vector>
+
+#include "AudioResampler.h"
+#include "SampleFrame.h"
+#include "lmms_export.h"
+
+namespace lmms {
+
+/**
+ * Stereo resampler using precomputed windowed sinc tables, one per
+ * libsamplerate converter type (see AudioEngine::qualitySettings).
+ *
+ * It has far less overhead per call than libsamplerate, which matters when
+ * many voices each process a few frames. As the tables are not adapted to
+ * the ratio, ratios that would need an anti-aliasing filter (i.e. below 1
+ * for the sinc converters) aren't supported, see supports().
+ */
+class LMMS_EXPORT PolyphaseResampler
+{
+public:
+	using ProcessResult = AudioResampler::ProcessResult;
+
+	explicit PolyphaseResampler(int interpolationMode);
+
+	//! Whether a resampler for @p interpolationMode can resample with @p ratio
+	static auto supports(int interpolationMode, double ratio) -> bool;
+
+	//! Same semantics as AudioResampler::resample(), for stereo frames
+	auto resample(const SampleFrame* in, long inputFrames, SampleFrame* out, long outputFrames, double ratio)
+		-> ProcessResult;
+
+	auto interpolationMode() const -> int { return m_interpolationMode; }
+
+	//! Forgets about previous input, e.g. when seeking
+	void reset();
+
+private:
+	struct Kernel;
+	static auto kernel(int interpolationMode) -> const Kernel&;
+
+	int m_interpolationMode;
+	const Kernel* m_kernel;
+
+	//! Input frames still needed, preceded by those before the current position the kernel needs
+	std::vector<SampleFrame> m_buffer;
+	//! Position in m_buffer of the next output frame
+	double m_position = 0.0;
+	bool m_started = false;
+};
+
+} // namespace lmms
+
+#endif // LMMS_POLYPHASE_RESAMPLER_H
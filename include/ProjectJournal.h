@@ -28,8 +28,12 @@
 #include <QHash>
 #include <QStack>
 
+#include <cstddef>
+#include <vector>
+
 #include "LmmsTypes.h"
 #include "DataFile.h"
+#include "JournalDiff.h"
 
 
 namespace lmms
@@ -44,6 +48,8 @@ class ProjectJournal
 {
 public:
 	static const int MAX_UNDO_STATES;
+	//! Memory the undo checkpoints may take, in bytes
+	static const std::size_t MAX_UNDO_MEMORY;
 
 	ProjectJournal();
 	virtual ~ProjectJournal() = default;
@@ -54,6 +60,9 @@ public:
 	bool canUndo() const;
 	bool canRedo() const;
 
+	//! Memory taken by the undo and redo checkpoints, in bytes
+	std::size_t memoryUsage() const;
+
 	void addJournalCheckPoint( JournallingObject *jo );
 
 	bool isJournalling() const
@@ -86,35 +95,75 @@ public:
 	static jo_id_t idToSave( jo_id_t id );
 	//! hack, not used when loading a savefile
 	static jo_id_t idFromSave( jo_id_t id );
+	//! The ID older versions saved for allocated ID @p id
+	static jo_id_t idFromLegacySave( jo_id_t id );
 
 	void clearJournal();
 	void stopAllJournalling();
-	JournallingObject * journallingObject( const jo_id_t _id )
+	JournallingObject * journallingObject( const jo_id_t _id ) const
 	{
-		if( m_joIDs.contains( _id ) )
+		if( isAllocatedID( _id ) )
 		{
-			return m_joIDs[_id];
+			return m_allocatedObjects[_id - EO_ID_MSB];
 		}
-		return nullptr;
+		return m_loadedObjects.value( _id, nullptr );
 	}
 
 
 private:
 	using JoIdMap = QHash<jo_id_t, JournallingObject*>;
 
+	//! Avoid clashes between loaded IDs (have the bit cleared)
+	//! and newly created IDs (have the bit set)
+	static constexpr jo_id_t EO_ID_MSB = 1 << 23;
+
+	//! Added to allocated IDs when saving them, so the IDs of different
+	//! sessions are as unlikely to collide as when IDs were random. As they
+	//! are allocated sequentially, idFromSave() on an ID from another session
+	//! would find one of the first objects of this session otherwise.
+	static const jo_id_t s_savedIDOffset;
+
+	bool isAllocatedID( const jo_id_t _id ) const
+	{
+		return _id >= EO_ID_MSB && _id - EO_ID_MSB < m_allocatedObjects.size();
+	}
+
+	/**
+		The state of an object before a change
+
+		Only the newest checkpoint of each object in a stack holds the
+		serialized state. Older ones hold the difference to the next newer
+		checkpoint of the same object, so their memory is proportional to
+		what changed in between.
+	*/
 	struct CheckPoint
 	{
-		CheckPoint( jo_id_t initID = 0, const DataFile& initData = DataFile( DataFile::Type::JournalData ) ) :
-			joID( initID ),
-			data( initData )
-		{
-		}
-		jo_id_t joID;
-		DataFile data;
+		jo_id_t joID = 0;
+		QString state;
+		//! Turns the state of the next newer checkpoint into this one
+		JournalDiff diff;
+		bool isDiff = false;
+
+		std::size_t memoryUsage() const;
 	} ;
 	using CheckPointStack = QStack<CheckPoint>;
 
-	JoIdMap m_joIDs;
+	static QString saveState(JournallingObject* jo);
+	static DataFile loadState(const QString& state);
+
+	static void pushCheckPoint(CheckPointStack& stack, jo_id_t id, const QString& state);
+	//! Pops the newest checkpoint, which always holds a state
+	static CheckPoint popCheckPoint(CheckPointStack& stack);
+	static void limitCheckPoints(CheckPointStack& stack);
+
+	//! The objects with IDs from allocID(), indexed by the ID without
+	//! EO_ID_MSB. Freed IDs hold nullptr, and are reserved for restoring
+	//! their object from the journal until clearJournal().
+	std::vector<JournallingObject*> m_allocatedObjects;
+	//! Freed IDs which nothing refers to anymore
+	std::vector<jo_id_t> m_reusableIDs;
+	//! The objects with IDs from loaded files, which may be any number
+	JoIdMap m_loadedObjects;
 
 	CheckPointStack m_undoCheckPoints;
 	CheckPointStack m_redoCheckPoints;
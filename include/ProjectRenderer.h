@@ -25,7 +25,13 @@
 #ifndef LMMS_PROJECT_RENDERER_H
 #define LMMS_PROJECT_RENDERER_H
 
+#include <memory>
+#include <vector>
+
 #include "AudioFileDevice.h"
+#include "AudioFileEncoder.h"
+#include "Oversampler.h"
+#include "SampleFrame.h"
 #include "AudioEngine.h"
 #include "OutputSettings.h"
 
@@ -71,6 +77,18 @@ public:
 		return m_fileDev != nullptr;
 	}
 
+	//! Additionally encode the full mix as \p fileFormat into \p outputFile,
+	//! from the same render pass. The sample rate of \p outputSettings is
+	//! replaced with the one rendered at. Returns false if the file could
+	//! not be created.
+	bool addOutput(ExportFileFormat fileFormat, const OutputSettings& outputSettings, const QString& outputFile);
+
+	//! Additionally write the output of \p busHandle to \p outputFile while
+	//! rendering. The output is taken before it enters the mixer.
+	//! Returns false if the file could not be created.
+	bool addStem(AudioBusHandle* busHandle, const QString& outputFile, ExportFileFormat fileFormat,
+		const OutputSettings& outputSettings);
+
 	static ExportFileFormat getFileFormatFromExtension(
 							const QString & _ext );
 
@@ -90,10 +108,56 @@ signals:
 
 
 private:
+	//! A file encoded on its own thread, destroyed encoder first
+	struct Output
+	{
+		std::unique_ptr<AudioFileDevice> fileDev;
+		std::unique_ptr<AudioFileEncoder> encoder;
+	};
+
+	//! Brings periods rendered oversampled down to the rate of the files
+	struct Decimator
+	{
+		Decimator(fpp_t frames, int stages) :
+			oversampler(frames, stages),
+			buffer(frames)
+		{
+		}
+
+		const SampleFrame* process(const SampleFrame* src)
+		{
+			oversampler.decimate(src, buffer.data(), static_cast<fpp_t>(buffer.size()));
+			return buffer.data();
+		}
+
+		Oversampler oversampler;
+		std::vector<SampleFrame> buffer;
+	};
+
+	struct Stem
+	{
+		AudioBusHandle* busHandle;
+		Output output;
+		std::unique_ptr<Decimator> decimator;
+	};
+
 	void run() override;
+	void writeStems(fpp_t frames);
+	void finishOutput(Output& output);
+
+	OutputSettings withRenderedRate(const OutputSettings& outputSettings) const;
+
+	static AudioFileDevice* createFileDevice(ExportFileFormat fileFormat,
+		const OutputSettings& outputSettings, const QString& outputFile);
 
 	AudioFileDevice * m_fileDev;
 	AudioEngine::qualitySettings m_qualitySettings;
+	std::unique_ptr<Decimator> m_decimator;
+	const OutputSettings m_outputSettings;
+	const ExportFileFormat m_fileFormat;
+	std::vector<Output> m_outputs;
+	std::vector<Stem> m_stems;
+	std::vector<SampleFrame> m_silence;
 
 	volatile int m_progress;
 	volatile bool m_abort;
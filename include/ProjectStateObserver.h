@@ -0,0 +1,86 @@
+/*
+ * ProjectStateObserver.h - versioned digest of the project state for the AI tools
+ */
+
+#ifndef LMMS_GUI_PROJECT_STATE_OBSERVER_H
+#define LMMS_GUI_PROJECT_STATE_OBSERVER_H
+
+#include <QObject>
+#include <QHash>
+#include <QJsonObject>
+#include <QSet>
+#include <QStringList>
+
+namespace lmms {
+class Clip;
+class Song;
+class Track;
+}
+
+namespace lmms::gui {
+
+// Keeps a JSON digest of the song (tempo, time signature and one entry per
+// track) up to date from the change signals of the song and its tracks,
+// instead of walking the project on a timer.
+//
+// Signals only mark what changed; entries are rebuilt when the digest is
+// read, and every entry whose content actually changed gets a new version.
+// This lets requests carry just what changed since the last one.
+class ProjectStateObserver : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ProjectStateObserver(Song* song, QObject* parent = nullptr);
+
+    // The version of the last change, 0 for an empty project never read
+    quint64 version();
+
+    // The whole digest: {"version", "song": {...}, "tracks": {key: {...}}}
+    QJsonObject digest();
+
+    // What changed after `since`: {"version", "since", "song", "tracks",
+    // "removed_tracks"}, leaving out parts that didn't change. If `since` is
+    // 0 or predates the last project load, this is the full digest with
+    // "full" set instead.
+    QJsonObject deltaSince(quint64 since);
+
+    // Track names in song order
+    QStringList trackNames();
+
+signals:
+    // Emitted once per burst of changes, until the digest is read again
+    void stateChanged();
+
+private:
+    void observeTrack(Track* track);
+    void observeClip(Track* track, Clip* clip);
+    void forgetTrack(Track* track);
+    void markSongDirty();
+    void markTrackDirty(Track* track);
+    void resync();
+    void flush();
+    QJsonObject songEntry() const;
+    QJsonObject trackEntry(Track* track) const;
+    QString trackKey(Track* track) const;
+
+    Song* m_song;
+    quint64 m_version {0};
+    quint64 m_base {0}; // Version of the last project load
+    int m_nextTrackId {1};
+    bool m_notified {false};
+
+    QHash<Track*, int> m_trackIds;
+    QSet<Track*> m_dirtyTracks;
+    bool m_songDirty {true};
+
+    QJsonObject m_songEntry;
+    quint64 m_songVersion {0};
+    QHash<QString, QJsonObject> m_trackEntries;
+    QHash<QString, quint64> m_trackVersions;
+    QHash<QString, quint64> m_removedTracks; // Key -> version of the removal
+};
+
+} // namespace lmms::gui
+
+#endif // LMMS_GUI_PROJECT_STATE_OBSERVER_H
@@ -0,0 +1,70 @@
+/*
+ * RealtimeChecker.h - reports calls which may block threads rendering audio
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_REALTIME_CHECKER_H
+#define LMMS_REALTIME_CHECKER_H
+
+#include "lmmsconfig.h"
+#include "lmms_export.h"
+
+namespace lmms {
+
+/**
+ * In builds configured with WANT_DEBUG_REALTIME, reports every call which may
+ * block a thread while it renders audio: allocating or freeing memory,
+ * locking a mutex, waiting on a contended lock or semaphore, sleeping and
+ * opening files. This covers the core as well as plugins, as the calls are
+ * intercepted in the C library.
+ *
+ * Each call site is reported once, with its stack trace, on stderr. If the
+ * environment variable LMMS_REALTIME_CHECK is set to "abort", the first
+ * violation aborts instead, so CI runs fail on them.
+ *
+ * In all other builds, this does nothing.
+ */
+class LMMS_EXPORT RealtimeChecker
+{
+public:
+	//! Marks the current thread as rendering audio while alive
+	class Scope
+	{
+	public:
+		Scope() { enter(); }
+		~Scope() { leave(); }
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+	};
+
+private:
+#ifdef LMMS_DEBUG_REALTIME
+	static void enter();
+	static void leave();
+#else
+	static void enter() {}
+	static void leave() {}
+#endif
+};
+
+} // namespace lmms
+
+#endif // LMMS_REALTIME_CHECKER_H
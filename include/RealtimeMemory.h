@@ -0,0 +1,84 @@
+/*
+ * RealtimeMemory.h - keeps memory used by the audio threads resident
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_REALTIME_MEMORY_H
+#define LMMS_REALTIME_MEMORY_H
+
+#include <cstddef>
+
+#include "lmms_export.h"
+
+namespace lmms
+{
+
+/**
+ * Memory the audio threads rely on, e.g. the buffer and voice pools, is
+ * allocated before playing, but the system may still page it out while
+ * LMMS idles, so the first notes played afterwards wait for it to be read
+ * back. Locking it into RAM prevents this, huge pages additionally save
+ * TLB misses when reading large tables and samples.
+ *
+ * Both are chosen by the user ("audioengine/lockmemory" and
+ * "audioengine/hugepages") and read once; all functions do nothing while
+ * disabled or where not supported.
+ */
+class LMMS_EXPORT RealtimeMemory
+{
+public:
+	enum class HugePages
+	{
+		Off,
+		//! Transparent huge pages, if the system has them enabled for "madvise" or "always"
+		Transparent,
+		//! Huge pages reserved by the administrator (vm.nr_hugepages), or else transparent ones
+		Explicit
+	};
+
+	static bool lockingEnabled();
+	static HugePages hugePages();
+
+	//! Locks the pages of the range into RAM, which also faults them in.
+	//! Must be undone by unlock() unless the memory is kept until exit.
+	//! @return whether the range is locked now
+	static bool lock(const void* data, std::size_t size);
+	static void unlock(const void* data, std::size_t size);
+
+	//! Allocates @p size bytes backed by huge pages if enabled, aligned to 64 bytes at least
+	static void* allocate(std::size_t size);
+	//! Frees memory from allocate(), with the same @p size
+	static void deallocate(void* data, std::size_t size);
+
+	//! Lets the system collapse the whole huge pages inside the range, e.g.
+	//! of memory allocated before, if enabled
+	static void adviseHugePages(const void* data, std::size_t size);
+
+	//! Faults in (and locks, if enabled) the stack the calling thread is
+	//! going to use, so it doesn't fault in while processing audio
+	static void prefaultStack();
+
+	//! Bytes locked by lock() so far
+	static std::size_t lockedBytes();
+};
+
+} // namespace lmms
+
+#endif // LMMS_REALTIME_MEMORY_H
@@ -0,0 +1,65 @@
+/*
+ * RealtimeThread.h - scheduling helpers for audio threads
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_REALTIME_THREAD_H
+#define LMMS_REALTIME_THREAD_H
+
+#include <string_view>
+#include <vector>
+
+#include "lmms_export.h"
+
+namespace lmms
+{
+
+enum class RealtimePolicy
+{
+	Fifo,
+	RoundRobin
+};
+
+//! Runs the calling thread with real-time scheduling: SCHED_FIFO or SCHED_RR
+//! on Linux, the MMCSS "Pro Audio" task on Windows. A thread which already
+//! runs with SCHED_FIFO or SCHED_RR keeps its priority.
+//! @param priority priority to use, 0 for the middle of the range
+//! @return the priority the thread runs with now, 0 if it could not be changed
+LMMS_EXPORT int makeCurrentThreadRealtime(int priority = 0, RealtimePolicy policy = RealtimePolicy::Fifo);
+
+//! Lets the calling thread only run on the given CPU core where this is
+//! supported, so it keeps its caches warm between periods
+LMMS_EXPORT void pinCurrentThread(unsigned cpu);
+
+//! Returns the performance cores of a hybrid processor, or nothing if all
+//! cores are alike or this isn't known
+LMMS_EXPORT std::vector<unsigned> performanceCores();
+
+//! Returns the cores of every NUMA node having any, or nothing if there is
+//! only one node or this isn't known
+LMMS_EXPORT std::vector<std::vector<unsigned>> numaNodes();
+
+//! Parses a list of CPU cores in the format used by Linux, e.g. "0-3,6",
+//! skipping invalid entries
+LMMS_EXPORT std::vector<unsigned> parseCpuList(std::string_view list);
+
+} // namespace lmms
+
+#endif // LMMS_REALTIME_THREAD_H
@@ -25,6 +25,8 @@
 #ifndef LMMS_REMOTE_PLUGIN_H
 #define LMMS_REMOTE_PLUGIN_H
 
+#include <memory>
+
 #include <QThread>
 #include <QProcess>
 #if (QT_VERSION >= QT_VERSION_CHECK(5,14,0))
@@ -40,6 +42,7 @@ namespace lmms
 
 class MidiEvent;
 class RemotePlugin;
+class RemotePluginHost;
 class SampleFrame;
 
 class ProcessWatcher : public QThread
@@ -76,14 +79,7 @@ public:
 	RemotePlugin();
 	~RemotePlugin() override;
 
-	inline bool isRunning()
-	{
-#ifdef DEBUG_REMOTE_PLUGIN
-		return true;
-#else
-		return m_process.state() != QProcess::NotRunning;
-#endif // DEBUG_REMOTE_PLUGIN
-	}
+	bool isRunning();
 
 	bool init( const QString &pluginExecutable, bool waitForInitDoneMsg, QStringList extraArgs = {} );
 
@@ -154,10 +150,20 @@ protected:
 		m_splitChannels = _on;
 	}
 
+	//! Lets init() add the plugin to a process shared with other plugins
+	//! of the same executable instead of starting one of its own
+	inline void setSharedProcess( bool _on )
+	{
+		m_sharedProcess = _on;
+	}
+
 
 	bool m_failed;
 private:
 	void resizeSharedProcessingMemory();
+	void createProcessSync();
+	//! Waits for the remote process to post the period after @p seen
+	void waitForProcessing(std::uint32_t seen);
 
 
 	QProcess m_process;
@@ -172,9 +178,15 @@ private:
 	QMutex m_commMutex;
 #endif
 	bool m_splitChannels;
+	bool m_sharedProcess;
+	//! The process hosting this plugin if it is shared, see setSharedProcess()
+	std::shared_ptr<RemotePluginHost> m_host;
 
 	SharedMemory<float[]> m_audioBuffer;
 	std::size_t m_audioBufferSize;
+	//! The period size the remote process renders, sent along when it changes
+	fpp_t m_bufferFrames;
+	SharedMemory<RemoteProcessSync> m_processSync;
 
 	int m_inputCount;
 	int m_outputCount;
@@ -192,6 +204,34 @@ private slots:
 	void processErrored(QProcess::ProcessError err );
 } ;
 
+/**
+ * A remote process hosting several plugins of the same executable.
+ *
+ * The process is started with an additional "shared" argument and only
+ * talks to the host through this channel. For every plugin added to it,
+ * it connects to the plugin's own channel, so the plugins exchange
+ * messages and render periods independently of each other.
+ *
+ * This relies on the channels being sockets, which break when the process
+ * dies and so invalidate every plugin hosted by it.
+ */
+class RemotePluginHost : public RemotePlugin
+{
+public:
+	~RemotePluginHost() override = default;
+
+	//! Returns the process running @p executable with @p args, starting it
+	//! if there is none yet. Returns nullptr if it can't be started.
+	static std::shared_ptr<RemotePluginHost> get( const QString& executable,
+							const QStringList& args );
+
+	//! Asks the process to add a plugin talking through @p channelArgs
+	void addInstance( const QStringList& channelArgs );
+
+private:
+	RemotePluginHost() = default;
+} ;
+
 inline std::string QSTR_TO_STDSTR(QString const& qstr)
 {
 	return qstr.toStdString();
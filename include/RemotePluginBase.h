@@ -75,8 +75,8 @@
 
 #endif // BUILD_REMOTE_PLUGIN_CLIENT
 
-#ifdef SYNC_WITH_SHM_FIFO
 #include "SharedMemory.h"
+#ifdef SYNC_WITH_SHM_FIFO
 #include "SystemSemaphore.h"
 #endif
 
@@ -360,10 +360,35 @@ enum RemoteMessageIDs
 	IdLoadPresetFile,
 	IdDebugMessage,
 	IdIdle,
+	IdChangeProcessSyncKey,
+	IdHostAddInstance,
 	IdUserBase = 64
 } ;
 
 
+/**
+ * Lets the remote process hand processed periods back to the host through
+ * shared memory instead of an IdProcessingDone message, see
+ * IdStartProcessing
+ */
+struct RemoteProcessSync
+{
+	SharedEvent processed;
+	std::uint32_t m_attached;
+
+	//! Set by the remote process once it has attached to the memory
+	bool attached() noexcept
+	{
+		return std::atomic_ref{m_attached}.load(std::memory_order_acquire) != 0;
+	}
+
+	void attach() noexcept
+	{
+		std::atomic_ref{m_attached}.store(1, std::memory_order_release);
+	}
+};
+
+
 
 class LMMS_EXPORT RemotePluginBase
 {
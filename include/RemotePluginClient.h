@@ -130,6 +130,7 @@ private:
 
 	SharedMemory<float[]> m_audioBuffer;
 	SharedMemory<const VstSyncData> m_vstSyncData;
+	SharedMemory<RemoteProcessSync> m_processSync;
 
 	int m_inputCount;
 	int m_outputCount;
@@ -275,9 +276,8 @@ bool RemotePluginClient::processMessage( const message & _m )
 			break;
 
 		case IdBufferSizeInformation:
-			// Should LMMS gain the ability to change buffer size
-			// without a restart, it must wait for this message to
-			// complete processing or else risk VST crashes
+			// also sent whenever the period size changes, right before
+			// the next IdStartProcessing, which is handled after this
 			m_bufferSize = _m.getInt();
 			updateBufferSize();
 			break;
@@ -297,10 +297,29 @@ bool RemotePluginClient::processMessage( const message & _m )
 
 		case IdStartProcessing:
 			doProcessing();
+			// the host tells us whether it waits on the shared event
+			if (_m.getInt() && m_processSync)
+			{
+				m_processSync->processed.post();
+				break;
+			}
 			reply_message.id = IdProcessingDone;
 			reply = true;
 			break;
 
+		case IdChangeProcessSyncKey:
+			try
+			{
+				m_processSync.attach(_m.getString(0));
+				m_processSync->attach();
+			}
+			catch (const std::runtime_error& error)
+			{
+				// the host keeps waiting for IdProcessingDone
+				debugMessage(std::string{"failed attaching process sync memory: "} + error.what() + '\n');
+			}
+			break;
+
 		case IdChangeSharedMemoryKey:
 			setShmKey(_m.getString(0));
 			break;
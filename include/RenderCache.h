@@ -0,0 +1,73 @@
+/*
+ * RenderCache.h - keeps the output of tracks rendered by earlier exports
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_RENDER_CACHE_H
+#define LMMS_RENDER_CACHE_H
+
+#include <cstddef>
+
+#include "lmms_export.h"
+
+namespace lmms {
+
+/**
+ * Cache of the output of instrument tracks rendered by earlier exports, so
+ * exporting again only renders the tracks which changed since.
+ *
+ * Each track is identified by a hash of everything its output depends on:
+ * its settings, instrument, effects and clips, the automation of its
+ * controls, the song's tempo, pitch and length, and the range exported. The
+ * output of an unchanged track is played from the cache like a frozen track,
+ * every other track is rendered live and its output cached for the next
+ * export. The mixer always processes everything sent to it, so changes
+ * there never need the tracks to be rendered again.
+ *
+ * A track is always rendered as a whole, since the state of instruments and
+ * effects at some point in the song, e.g. notes still held or the tail of
+ * a reverb, can't be restored. Tracks with controls driven by controllers,
+ * which may follow other tracks, are never cached, and neither is anything
+ * when a loop is exported more than once, as each pass continues from the
+ * tails of the one before.
+ *
+ * The most recently used output is kept within a memory budget.
+ */
+class LMMS_EXPORT RenderCache
+{
+public:
+	//! Sets the tracks of the song up to either play their cached output or have it captured.
+	//! Must be called on the GUI thread once the audio device rendering the export is set.
+	static void beginRender();
+
+	//! Caches the captured output if the export @p completed, and has all tracks played live again.
+	//! Must be called once the audio engine stopped rendering.
+	static void endRender(bool completed);
+
+	//! Sets how much memory the cached output may take up
+	static void setMemoryBudget(std::size_t bytes);
+
+	//! Drops all cached output, e.g. when another project is loaded
+	static void clear();
+};
+
+} // namespace lmms
+
+#endif // LMMS_RENDER_CACHE_H
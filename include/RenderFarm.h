@@ -0,0 +1,142 @@
+/*
+ * RenderFarm.h - renders the tracks of a project on several hosts
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_RENDER_FARM_H
+#define LMMS_RENDER_FARM_H
+
+#include <QPointer>
+#include <QStringList>
+#include <QTcpServer>
+#include <QTimer>
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "AudioEngine.h"
+#include "lmms_export.h"
+
+class QTcpSocket;
+
+namespace lmms
+{
+
+class FrozenAudio;
+class Track;
+
+/**
+ * Has the instrument tracks of the loaded project rendered by hosts running
+ * a RenderWorker, so the export on this host only has to mix their output.
+ *
+ * The tracks are spread over the workers, which render all of theirs in a
+ * single pass through the song, like a frozen track is rendered. The output
+ * of each track is sent back and played while exporting instead of the
+ * track, like cached output is. Everything else, i.e. sample tracks and the
+ * mixer, is rendered by the export itself, as are the tracks of workers
+ * which failed.
+ *
+ * The workers load the project from the same path, e.g. on shared storage,
+ * and have to use the same block size. Jobs carry the environment variable
+ * LMMS_RENDER_SECRET, which has to match the one of the workers.
+ */
+class LMMS_EXPORT RenderCoordinator : public QObject
+{
+	Q_OBJECT
+public:
+	//! @p workers are given as "host" or "host:port"
+	RenderCoordinator(const QString& projectFile, const QStringList& workers,
+		const AudioEngine::qualitySettings& qualitySettings, sample_rate_t sampleRate, QObject* parent = nullptr);
+	~RenderCoordinator() override;
+
+	//! Sends the tracks to the workers. finished() is emitted once all of them replied or failed.
+	void start();
+
+signals:
+	void finished();
+
+private:
+	struct Worker
+	{
+		QString name;
+		QTcpSocket* socket = nullptr;
+		std::vector<quint32> tracks;
+		int progress = 0;
+		bool done = false;
+	};
+
+	void sendJob(Worker& worker);
+	void receive(Worker& worker);
+	void fail(Worker& worker, const QString& reason);
+	void finishWorker(Worker& worker);
+
+	QString m_projectFile;
+	QStringList m_workerNames;
+	AudioEngine::qualitySettings m_qualitySettings;
+	sample_rate_t m_sampleRate;
+
+	std::vector<std::unique_ptr<Worker>> m_workers;
+	std::map<quint32, std::shared_ptr<const FrozenAudio>> m_stems;
+};
+
+
+
+
+/**
+ * Renders tracks for a RenderCoordinator on another host, one project at a time.
+ */
+class LMMS_EXPORT RenderWorker : public QObject
+{
+	Q_OBJECT
+public:
+	static constexpr quint16 DefaultPort = 8731;
+
+	RenderWorker(QObject* parent = nullptr);
+	~RenderWorker() override;
+
+	//! Only listens on other interfaces than the loopback one if the
+	//! environment variable LMMS_RENDER_SECRET is set, which the jobs have
+	//! to carry as well
+	bool listen(const QHostAddress& address, quint16 port);
+
+private:
+	class Renderer;
+
+	void acceptConnections();
+	void receive(QTcpSocket* socket);
+	void startJob(QTcpSocket* socket, const QByteArray& job);
+	void sendProgress();
+	void finishJob();
+
+	QTcpServer m_server;
+	QTimer m_progressTimer;
+
+	//! The job being rendered and the coordinator it's sent back to
+	std::unique_ptr<Renderer> m_renderer;
+	QPointer<QTcpSocket> m_coordinator;
+	std::vector<std::pair<quint32, std::shared_ptr<FrozenAudio>>> m_stems;
+	std::vector<Track*> m_muted;
+	int m_progress = 0;
+};
+
+} // namespace lmms
+
+#endif // LMMS_RENDER_FARM_H
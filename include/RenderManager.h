@@ -27,6 +27,8 @@
 #define LMMS_RENDER_MANAGER_H
 
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include "ProjectRenderer.h"
 #include "OutputSettings.h"
@@ -54,6 +56,18 @@ public:
 	/// Export all unmuted tracks into individual file
 	void renderTracks();
 
+	/// Export all unmuted tracks into individual files within a single pass
+	/// through the song. Each file holds the track's output before it enters
+	/// the mixer, the full mix is written alongside.
+	void renderTracksSinglePass();
+
+	/// Also encode every rendered file as \p fmt, from the same render pass
+	void addFormat(ProjectRenderer::ExportFileFormat fmt);
+
+	/// Also encode every rendered file as \p fmt with its own settings,
+	/// e.g. a different bitrate. The sample rate is the one of the main format.
+	void addFormat(ProjectRenderer::ExportFileFormat fmt, const OutputSettings& outputSettings);
+
 	void abortProcessing();
 
 signals:
@@ -66,14 +80,18 @@ private slots:
 
 private:
 	QString pathForTrack( const Track *track, int num );
+	QString pathForFormat(const QString& path, ProjectRenderer::ExportFileFormat fmt) const;
+	void collectTracksToRender();
 	void restoreMutedState();
 
-	void render( QString outputPath );
+	void render( QString outputPath, const std::vector<Track*>& stems = {} );
 
 	const AudioEngine::qualitySettings m_qualitySettings;
 	const AudioEngine::qualitySettings m_oldQualitySettings;
 	const OutputSettings m_outputSettings;
 	ProjectRenderer::ExportFileFormat m_format;
+	//! Formats encoded alongside m_format, from the same render pass
+	std::vector<std::pair<ProjectRenderer::ExportFileFormat, OutputSettings>> m_extraFormats;
 	QString m_outputPath;
 
 	std::unique_ptr<ProjectRenderer> m_activeRenderer;
@@ -0,0 +1,113 @@
+/*
+ * RenderServer.h - renders projects sent over a local socket, one after another
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_RENDER_SERVER_H
+#define LMMS_RENDER_SERVER_H
+
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QLocalServer>
+#include <QPointer>
+
+#include <deque>
+#include <memory>
+
+#include "AudioEngine.h"
+#include "AudioFileDevice.h"
+#include "lmms_export.h"
+
+class QLocalSocket;
+
+namespace lmms
+{
+
+class RenderManager;
+
+/**
+ * Renders projects sent by clients over a local socket, so batches of
+ * renders only pay for starting LMMS once: the wavetables, the plugins
+ * found, and the samples kept by SampleCache stay available from one job to
+ * the next.
+ *
+ * Clients send one JSON object per line:
+ *
+ *     {"project": "/path/song.mmpz", "output": "/path/song.flac", "samplerate": 48000, "bitrate": 320, "loop": false}
+ *
+ * of which "samplerate", "bitrate" and "loop" are optional, the format is
+ * told by the extension of the output. The server replies with one JSON
+ * object per line as well, each with the "id" of the job and its "status":
+ * "queued" (with its "position" in the queue), "rendering", "progress"
+ * (with the "progress" in percent), "done" (with the "seconds" it took, the
+ * bytes "written" to files and the "writeSeconds" spent writing them) or
+ * "failed" (with an "error").
+ *
+ * There is only one song, so jobs are rendered one after another, each
+ * using the worker threads of the audio engine. Run a server per job to be
+ * rendered at the same time.
+ */
+class LMMS_EXPORT RenderServer : public QObject
+{
+	Q_OBJECT
+public:
+	static constexpr auto DefaultName = "lmms-render";
+
+	RenderServer(const AudioEngine::qualitySettings& qualitySettings, QObject* parent = nullptr);
+	~RenderServer() override;
+
+	//! Listens on the local socket @p name, which only the same user may connect to, replacing one left
+	//! behind by a server which crashed
+	bool listen(const QString& name);
+	auto fullServerName() const -> QString { return m_server.fullServerName(); }
+
+private:
+	struct Job
+	{
+		quint64 id;
+		QPointer<QLocalSocket> client;
+		QJsonObject request;
+	};
+
+	void acceptConnections();
+	void receive(QLocalSocket* socket);
+	void startNextJob();
+	void finishJob();
+	void reply(const Job& job, QJsonObject message);
+	void fail(const Job& job, const QString& error);
+
+	QLocalServer m_server;
+	AudioEngine::qualitySettings m_qualitySettings;
+
+	std::deque<Job> m_queue;
+	quint64 m_lastId = 0;
+
+	//! The job being rendered
+	std::unique_ptr<Job> m_job;
+	std::unique_ptr<RenderManager> m_renderManager;
+	QElapsedTimer m_jobTimer;
+	//! What had been written when the job started
+	AudioFileDevice::WriteStats m_writeStats = {};
+	int m_progress = 0;
+};
+
+} // namespace lmms
+
+#endif // LMMS_RENDER_SERVER_H
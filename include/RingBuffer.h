@@ -213,6 +213,7 @@ private:
 		return static_cast<f_cnt_t>( ceilf( ms * (float)m_samplerate * 0.001f ) );
 	}
 
+	//! Room for the longest period beyond the size, which the current one may be shorter than
 	const fpp_t m_fpp;
 	sample_rate_t m_samplerate;
 	size_t m_size;
@@ -29,7 +29,9 @@
 
 #include "AudioResampler.h"
 #include "Note.h"
+#include "PolyphaseResampler.h"
 #include "SampleBuffer.h"
+#include "SampleStream.h"
 #include "lmms_export.h"
 
 namespace lmms {
@@ -54,6 +56,7 @@ public:
 	public:
 		PlaybackState(bool varyingPitch = false, int interpolationMode = SRC_LINEAR)
 			: m_resampler(interpolationMode, DEFAULT_CHANNELS)
+			, m_polyphaseResampler(interpolationMode)
 			, m_varyingPitch(varyingPitch)
 		{
 		}
@@ -68,7 +71,19 @@ public:
 		void setBackwards(bool backwards) { m_backwards = backwards; }
 
 	private:
+		enum class Resampling
+		{
+			Generic, //!< m_resampler
+			Polyphase, //!< m_polyphaseResampler
+			None //!< The frames are copied as they are
+		};
+
 		AudioResampler m_resampler;
+		//! Used instead of m_resampler while the pitch doesn't vary, if it supports the ratio
+		PolyphaseResampler m_polyphaseResampler;
+		Resampling m_resampling = Resampling::Generic;
+		//! Reads ahead for streamed buffers
+		SampleStream m_stream;
 		int m_frameIndex = 0;
 		bool m_varyingPitch = false;
 		bool m_backwards = false;
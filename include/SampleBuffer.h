@@ -26,6 +26,11 @@
 #define LMMS_SAMPLE_BUFFER_H
 
 #include <QString>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
 #include <memory>
 #include <vector>
 
@@ -33,23 +38,60 @@
 #include "Engine.h"
 #include "LmmsTypes.h"
 #include "lmms_export.h"
+#include "lmms_math.h"
 
 namespace lmms {
+
+/**
+ * Holds the frames of a sample.
+ *
+ * Large audio files, and any file when asked to, are not decoded up front
+ * but in the background. The frames of large files are kept in a file mapped
+ * into memory, so only the parts in use need to stay resident. Everything
+ * accessing the whole buffer (data(), begin(), ...) waits until decoding has
+ * finished, partialData() along with decodedFrames() can be used to read the
+ * frames available so far instead.
+ *
+ * The frames of audio files can be stored in a compact format (see Storage),
+ * which is converted when reading them with frameAt() or read(). data() has to
+ * convert all of them into an additional buffer for such files, so code
+ * processing samples in realtime should read them in their storage format.
+ */
 class LMMS_EXPORT SampleBuffer
 {
 public:
 	using value_type = SampleFrame;
 	using reference = SampleFrame&;
 	using const_reference = const SampleFrame&;
-	using iterator = std::vector<SampleFrame>::iterator;
-	using const_iterator = std::vector<SampleFrame>::const_iterator;
-	using difference_type = std::vector<SampleFrame>::difference_type;
-	using size_type = std::vector<SampleFrame>::size_type;
-	using reverse_iterator = std::vector<SampleFrame>::reverse_iterator;
-	using const_reverse_iterator = std::vector<SampleFrame>::const_reverse_iterator;
+	using iterator = SampleFrame*;
+	using const_iterator = const SampleFrame*;
+	using difference_type = std::ptrdiff_t;
+	using size_type = std::size_t;
+	using reverse_iterator = std::reverse_iterator<iterator>;
+	using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+	enum class Decoding
+	{
+		Blocking, //!< Decode the file in the constructor, unless it is large
+		Background, //!< Decode the file in the background, if its format allows to
+		//! Decode the file in the background into a file mapped into memory whatever its size, only its
+		//! beginning is kept in memory for certain (see preloadedData()) and the rest is read through
+		//! a SampleStream when playing it
+		Streaming
+	};
+
+	//! How the frames are kept in memory
+	enum class Storage
+	{
+		Float32, //!< SampleFrame, 8 bytes per frame
+		Int16, //!< 16 bit integers, 4 bytes per frame
+		Int24, //!< 24 bit integers, 6 bytes per frame
+		Float16 //!< Half precision floats, 4 bytes per frame
+	};
 
 	SampleBuffer() = default;
-	explicit SampleBuffer(const QString& audioFile);
+	explicit SampleBuffer(
+		const QString& audioFile, Decoding decoding = Decoding::Blocking, Storage storage = defaultStorage());
 	SampleBuffer(const QString& base64, int sampleRate);
 	SampleBuffer(std::vector<SampleFrame> data, int sampleRate);
 	SampleBuffer(
@@ -61,36 +103,122 @@ public:
 	auto audioFile() const -> const QString& { return m_audioFile; }
 	auto sampleRate() const -> sample_rate_t { return m_sampleRate; }
 
-	auto begin() -> iterator { return m_data.begin(); }
-	auto end() -> iterator { return m_data.end(); }
+	auto begin() -> iterator { return mutableData(); }
+	auto end() -> iterator { return mutableData() + size(); }
+
+	auto begin() const -> const_iterator { return data(); }
+	auto end() const -> const_iterator { return data() + size(); }
+
+	auto cbegin() const -> const_iterator { return begin(); }
+	auto cend() const -> const_iterator { return end(); }
+
+	auto rbegin() -> reverse_iterator { return reverse_iterator{end()}; }
+	auto rend() -> reverse_iterator { return reverse_iterator{begin()}; }
+
+	auto rbegin() const -> const_reverse_iterator { return const_reverse_iterator{end()}; }
+	auto rend() const -> const_reverse_iterator { return const_reverse_iterator{begin()}; }
+
+	auto crbegin() const -> const_reverse_iterator { return rbegin(); }
+	auto crend() const -> const_reverse_iterator { return rend(); }
 
-	auto begin() const -> const_iterator { return m_data.begin(); }
-	auto end() const -> const_iterator { return m_data.end(); }
+	//! All frames of the buffer, waits for them to be decoded if necessary
+	auto data() const -> const SampleFrame*;
+	auto size() const -> size_type;
+	auto empty() const -> bool { return size() == 0; }
 
-	auto cbegin() const -> const_iterator { return m_data.cbegin(); }
-	auto cend() const -> const_iterator { return m_data.cend(); }
+	//! The frames decoded so far. Never waits, only the first decodedFrames() frames may be read.
+	//! Only available with Storage::Float32, nullptr otherwise.
+	auto partialData() const -> const SampleFrame*;
+	auto decodedFrames() const -> size_type;
+	//! Blocks until all frames have been decoded
+	void waitUntilDecoded() const;
 
-	auto rbegin() -> reverse_iterator { return m_data.rbegin(); }
-	auto rend() -> reverse_iterator { return m_data.rend(); }
+	//! Whether the buffer has been decoded for streaming, and is longer than its preloaded beginning
+	auto streamed() const -> bool;
+	//! The beginning of a streamed buffer, which is always kept in memory
+	auto preloadedData() const -> const SampleFrame*;
+	//! Number of frames of preloadedData() decoded so far
+	auto preloadedFrames() const -> size_type;
 
-	auto rbegin() const -> const_reverse_iterator { return m_data.rbegin(); }
-	auto rend() const -> const_reverse_iterator { return m_data.rend(); }
+	auto storage() const -> Storage;
+	//! The frames decoded so far in their storage format, to be read with frameAt()
+	auto storageData() const -> const std::byte*;
+	//! Converts @p count frames starting at @p first, which must have been decoded already
+	void read(size_type first, size_type count, SampleFrame* out) const;
+	//! Memory taken up by the frames in their storage format
+	auto memoryUsage() const -> std::size_t { return size() * bytesPerFrame(storage()); }
 
-	auto crbegin() const -> const_reverse_iterator { return m_data.crbegin(); }
-	auto crend() const -> const_reverse_iterator { return m_data.crend(); }
+	//! Converts frame @p index of @p data, which holds frames in storage @p S
+	template<Storage S>
+	static auto frameAt(const std::byte* data, size_type index) -> SampleFrame;
 
-	auto data() const -> const SampleFrame* { return m_data.data(); }
-	auto size() const -> size_type { return m_data.size(); }
-	auto empty() const -> bool { return m_data.empty(); }
+	static auto bytesPerFrame(Storage storage) -> std::size_t;
+
+	//! The storage used for audio files unless told otherwise, set by the "samplestorage" option
+	//! of the audio engine ("float32", "int16", "int24" or "float16")
+	static auto defaultStorage() -> Storage;
+
+	//! A copy of the buffer converted to @p sampleRate with the best quality libsamplerate offers, kept
+	//! in Storage::Float32. Waits until the buffer has been decoded, so it should only be used on
+	//! buffers held in memory.
+	auto resampled(sample_rate_t sampleRate) const -> SampleBuffer;
+
+	//! Whether audio files are converted to the output sample rate when loaded, so playing them at
+	//! their original pitch doesn't need to resample, set by the "resampleonload" option of the audio engine
+	static auto resampleOnLoad() -> bool;
+
+	//! Whether large sample libraries are streamed from disk (see Decoding::Streaming) rather than kept
+	//! in memory completely, set by the "streamsamples" option of the audio engine
+	static auto streamSamples() -> bool;
 
 	static auto emptyBuffer() -> std::shared_ptr<const SampleBuffer>;
 
 private:
+	class StreamedData;
+
+	auto mutableData() -> SampleFrame*;
+
 	std::vector<SampleFrame> m_data;
+	//! Set instead of m_data for files decoded in the background
+	std::shared_ptr<StreamedData> m_streamedData;
 	QString m_audioFile;
 	sample_rate_t m_sampleRate = Engine::audioEngine()->outputSampleRate();
 };
 
+template<SampleBuffer::Storage S>
+inline auto SampleBuffer::frameAt(const std::byte* data, size_type index) -> SampleFrame
+{
+	if constexpr (S == Storage::Float32)
+	{
+		return reinterpret_cast<const SampleFrame*>(data)[index];
+	}
+	else if constexpr (S == Storage::Int16)
+	{
+		auto values = std::array<std::int16_t, 2>{};
+		std::memcpy(values.data(), data + index * sizeof(values), sizeof(values));
+		return SampleFrame{values[0] / 32768.f, values[1] / 32768.f};
+	}
+	else if constexpr (S == Storage::Int24)
+	{
+		// little endian, shifted into the upper bytes to sign extend it
+		const auto sample = [](const std::byte* bytes) {
+			const auto value = std::to_integer<std::uint32_t>(bytes[0]) << 8
+				| std::to_integer<std::uint32_t>(bytes[1]) << 16
+				| std::to_integer<std::uint32_t>(bytes[2]) << 24;
+			return (static_cast<std::int32_t>(value) >> 8) / 8388608.f;
+		};
+		const auto frame = data + index * 6;
+		return SampleFrame{sample(frame), sample(frame + 3)};
+	}
+	else
+	{
+		static_assert(S == Storage::Float16);
+		auto values = std::array<std::uint16_t, 2>{};
+		std::memcpy(values.data(), data + index * sizeof(values), sizeof(values));
+		return SampleFrame{halfToFloat(values[0]), halfToFloat(values[1])};
+	}
+}
+
 } // namespace lmms
 
 #endif // LMMS_SAMPLE_BUFFER_H
@@ -0,0 +1,100 @@
+/*
+ * SampleCache.h - shares the buffers of audio files used several times
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_SAMPLE_CACHE_H
+#define LMMS_SAMPLE_CACHE_H
+
+#include <QString>
+#include <QStringList>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "SampleBuffer.h"
+#include "lmms_export.h"
+
+namespace lmms {
+
+/**
+ * Cache of decoded audio files, so a file used by several instruments or
+ * clips is only decoded and kept in memory once.
+ *
+ * Files are identified by their absolute path, size and modification time,
+ * so a file changed on disk is decoded again. A file is decoded once for
+ * every storage format requested, but shared whatever decoding has been
+ * requested (e.g. a buffer decoded for streaming is also used by those that
+ * don't stream it, and the other way round). Every buffer still in use is
+ * found in the cache. In addition, the most recently used buffers are kept
+ * alive within a memory budget, so samples can be reloaded quickly (e.g.
+ * when loading another project using the same one-shots).
+ *
+ * If SampleBuffer::resampleOnLoad() is set, files decoded in one go are
+ * converted to the output sample rate once, and cached per sample rate. A
+ * file already decoded at its own sample rate (e.g. prefetched) is converted
+ * from that buffer instead of being decoded again.
+ *
+ * All functions are thread-safe.
+ */
+class LMMS_EXPORT SampleCache
+{
+public:
+	struct Statistics
+	{
+		std::size_t hits = 0;
+		std::size_t misses = 0;
+		//! Memory used by the buffers kept alive by the cache
+		std::size_t retainedBytes = 0;
+	};
+
+	struct Usage
+	{
+		QString file;
+		std::size_t bytes = 0;
+		//! False if only the cache keeps the buffer alive
+		bool inUse = false;
+	};
+
+	//! Returns the buffer of @p audioFile, decoding the file only if it isn't cached in @p storage.
+	//! Throws std::runtime_error like SampleBuffer's constructor if the file can't be decoded.
+	static auto get(const QString& audioFile, SampleBuffer::Decoding decoding = SampleBuffer::Decoding::Blocking,
+		SampleBuffer::Storage storage = SampleBuffer::defaultStorage()) -> std::shared_ptr<const SampleBuffer>;
+
+	//! Starts decoding @p audioFiles in the background, so later calls to get() return right away.
+	//! They are decoded for streaming if SampleBuffer::streamSamples() is set.
+	//! The buffers stay cached at least as long as the returned ones are kept.
+	static auto prefetch(const QStringList& audioFiles) -> std::vector<std::shared_ptr<const SampleBuffer>>;
+
+	static auto statistics() -> Statistics;
+
+	//! The memory used by each buffer in the cache, one per file and storage format
+	static auto usage() -> std::vector<Usage>;
+
+	//! Sets how much memory recently used buffers not in use anymore may take up
+	static void setMemoryBudget(std::size_t bytes);
+
+	//! Releases all buffers kept alive by the cache, buffers in use stay valid
+	static void clear();
+};
+
+} // namespace lmms
+
+#endif // LMMS_SAMPLE_CACHE_H
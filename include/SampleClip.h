@@ -26,13 +26,18 @@
 #define LMMS_SAMPLE_CLIP_H
 
 #include <memory>
+
+#include <QTimer>
+
 #include "Clip.h"
 #include "Sample.h"
+#include "TimeStretch.h"
 
 namespace lmms
 {
 
 class SampleBuffer;
+class SampleRecording;
 
 namespace gui
 {
@@ -79,6 +84,24 @@ public:
 	void setIsPlaying(bool isPlaying);
 	void setSampleBuffer(std::shared_ptr<const SampleBuffer> sb);
 
+	//! The tempo the sample has been recorded at if it is stretched to the tempo of the song, 0 otherwise
+	bpm_t originalTempo() const
+	{
+		return m_originalTempo;
+	}
+	void setOriginalTempo(bpm_t tempo);
+
+	//! The sample played, which is the stretched one if the clip follows the tempo of the song and it has
+	//! been rendered. Never waits for the render. Must only be called by the audio engine.
+	Sample& playbackSample();
+
+	//! Waits until the sample is stretched to the current tempo, e.g. before exporting
+	void finishStretch();
+
+	//! Hands the recording prepared while the clip is armed over to the take
+	//! starting now, null if there is none. Must only be called by the audio engine.
+	std::shared_ptr<SampleRecording> takeRecording();
+
 	SampleClip* clone() override
 	{
 		return new SampleClip(*this);
@@ -90,15 +113,33 @@ public slots:
 	void toggleRecord();
 	void playbackPositionChanged();
 	void updateTrackClips();
+	void updateStretch();
+
+private slots:
+	void updateRecording();
 
 protected:
 	SampleClip( const SampleClip& orig );
 
 private:
+	double stretchRatio() const;
+	//! Hands the render of the current tempo to the audio engine, rendering it unless it is cached
+	TimeStretch::Render requestStretch();
+
 	Sample m_sample;
 	BoolModel m_recordModel;
 	bool m_isPlaying;
 
+	bpm_t m_originalTempo = 0;
+	//! Pending until the audio engine picks it up in playbackSample()
+	TimeStretch::Render m_stretchRender;
+	Sample m_stretchedSample;
+	//! Only stretches to the last of tempo changes in quick succession, e.g. while dragging the tempo
+	QTimer m_stretchTimer;
+
+	//! The file the next take is recorded into, opened when the clip is armed
+	std::shared_ptr<SampleRecording> m_recording;
+
 	friend class gui::SampleClipView;
 
 
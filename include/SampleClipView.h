@@ -28,6 +28,7 @@
 #include "ClipView.h"
 
 #include "SampleThumbnail.h"
+#include "SampleWaveformRenderer.h"
 
 namespace lmms
 {
@@ -49,6 +50,7 @@ public:
 public slots:
 	void updateSample();
 	void reverseSample();
+	void syncToTempo();
 	void setAutomationGhost();
 
 
@@ -66,6 +68,7 @@ protected:
 private:
 	SampleClip * m_clip;
 	SampleThumbnail m_sampleThumbnail;
+	SampleWaveformRenderer m_waveform;
 	QPixmap m_paintPixmap;
 	long m_paintPixmapXPosition;
 } ;
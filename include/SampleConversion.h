@@ -0,0 +1,85 @@
+/*
+ * SampleConversion.h - conversion of sample frames to integer formats
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_SAMPLE_CONVERSION_H
+#define LMMS_SAMPLE_CONVERSION_H
+
+#include <array>
+#include <cstdint>
+
+#include "LmmsTypes.h"
+#include "lmms_constants.h"
+#include "lmms_export.h"
+
+namespace lmms
+{
+
+class SampleFrame;
+
+namespace SampleConversion
+{
+
+/*! \brief Noise added before rounding to the integer format */
+enum class Dither
+{
+	None,
+	Triangular, //!< TPDF noise of +-1 LSB, decorrelates the rounding error from the signal
+	NoiseShaped //!< TPDF noise with first order error feedback, moving the noise to high frequencies
+};
+
+/*! \brief Dither settings and state, carried from one buffer of a stream to the next */
+struct LMMS_EXPORT DitherState
+{
+	explicit DitherState(Dither dither = Dither::None);
+
+	Dither dither;
+	//! One xorshift generator for every 8th sample, so vectorised code gets one per lane
+	std::array<std::uint32_t, 8> random;
+	//! Rounding error of the previous sample per channel, for noise shaping
+	std::array<float, DEFAULT_CHANNELS> error;
+};
+
+/*! \brief Convert to interleaved signed 16 bit samples, clipping at +-1.0
+ *
+ * Uses the same instruction set as MixHelpers (see MixHelpers::simdLevel())
+ * and gives bit-identical results for each of them.
+ *
+ * \param channels 1 to only take the left channel, or 2
+ * \param swapBytes write the byte order opposite to the host's
+ * \param dither state of the dither to add, or nullptr for none
+ */
+LMMS_EXPORT void toS16(const SampleFrame* src, int frames, ch_cnt_t channels, std::int16_t* dst,
+	bool swapBytes = false, DitherState* dither = nullptr);
+
+/*! \brief Convert to interleaved signed 32 bit samples, clipping at +-1.0
+ *
+ * \param bits significant bits, from 16 to 32. The samples are rounded to
+ * that resolution and left aligned, e.g. 24 for 24 bit PCM.
+ */
+LMMS_EXPORT void toS32(const SampleFrame* src, int frames, ch_cnt_t channels, std::int32_t* dst,
+	int bits = 32, DitherState* dither = nullptr);
+
+} // namespace SampleConversion
+
+} // namespace lmms
+
+#endif // LMMS_SAMPLE_CONVERSION_H
@@ -25,8 +25,11 @@
 #ifndef LMMS_SAMPLE_DECODER_H
 #define LMMS_SAMPLE_DECODER_H
 
+#include <QFile>
 #include <QString>
+#include <memory>
 #include <optional>
+#include <sndfile.h>
 #include <string>
 #include <vector>
 
@@ -48,8 +51,41 @@ public:
 		std::string extension;
 	};
 
+	//! Decodes an audio file in chunks, so large files don't have to be decoded at once.
+	//! Only formats supported by libsndfile can be streamed.
+	class Stream
+	{
+	public:
+		//! Returns nullptr if the file can't be opened as a stream
+		static auto open(const QString& audioFile) -> std::unique_ptr<Stream>;
+		~Stream();
+
+		Stream(const Stream&) = delete;
+		auto operator=(const Stream&) -> Stream& = delete;
+
+		auto frames() const -> std::size_t { return m_frames; }
+		auto sampleRate() const -> int { return m_sampleRate; }
+
+		//! Decodes the next (at most) @p frames frames into @p dst, returns the number of frames decoded
+		auto read(SampleFrame* dst, std::size_t frames) -> std::size_t;
+
+	private:
+		Stream() = default;
+
+		QFile m_file;
+		SNDFILE* m_sndFile = nullptr;
+		int m_channels = 0;
+		std::size_t m_frames = 0;
+		int m_sampleRate = 0;
+		std::vector<sample_t> m_readBuffer;
+	};
+
 	static auto decode(const QString& audioFile) -> std::optional<Result>;
 	static auto supportedAudioTypes() -> const std::vector<AudioType>&;
+
+	//! Whether @p audioFile is synthesized at the output sample rate when decoded, i.e. a DrumSynth
+	//! file, so its decoded buffer changes with the sample rate. The renders are cached on disk.
+	static auto isSynthesized(const QString& audioFile) -> bool;
 };
 } // namespace lmms
 
@@ -28,6 +28,7 @@
 
 #include "LmmsTypes.h"
 #include "lmms_constants.h"
+#include "MixHelpers.h"
 
 #include <algorithm>
 #include <array>
@@ -199,14 +200,7 @@ inline void zeroSampleFrames(SampleFrame* buffer, size_t frames)
 
 inline SampleFrame getAbsPeakValues(SampleFrame* buffer, size_t frames)
 {
-	SampleFrame peaks;
-
-	for (f_cnt_t i = 0; i < frames; ++i)
-	{
-		peaks = peaks.absMax(buffer[i]);
-	}
-
-	return peaks;
+	return MixHelpers::absPeak(buffer, static_cast<int>(frames));
 }
 
 inline void copyToSampleFrames(SampleFrame* target, const float* source, size_t frames)
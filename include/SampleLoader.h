@@ -37,7 +37,8 @@ class LMMS_EXPORT SampleLoader
 public:
 	static QString openAudioFile(const QString& previousFile = "");
 	static QString openWaveformFile(const QString& previousFile = "");
-	static std::shared_ptr<const SampleBuffer> createBufferFromFile(const QString& filePath);
+	static std::shared_ptr<const SampleBuffer> createBufferFromFile(
+		const QString& filePath, SampleBuffer::Decoding decoding = SampleBuffer::Decoding::Blocking);
 	static std::shared_ptr<const SampleBuffer> createBufferFromBase64(
 		const QString& base64, int sampleRate = Engine::audioEngine()->outputSampleRate());
 private:
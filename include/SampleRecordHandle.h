@@ -25,10 +25,14 @@
 #ifndef LMMS_SAMPLE_RECORD_HANDLE_H
 #define LMMS_SAMPLE_RECORD_HANDLE_H
 
-#include <QList>
-#include <QPair>
+#include <QString>
+#include <atomic>
 #include <memory>
+#include <sndfile.h>
+#include <thread>
+#include <vector>
 
+#include "LocklessRingBuffer.h"
 #include "PlayHandle.h"
 #include "TimePos.h"
 
@@ -42,10 +46,73 @@ class SampleClip;
 class Track;
 
 
+/**
+ * The file a take is recorded into.
+ *
+ * The recorded frames are passed through a ring buffer to a writer thread,
+ * which appends them to a WAV file in the recordings directory. Only if the
+ * file can't be created, the frames are kept in memory instead.
+ *
+ * Opening and closing the file may take long, so a recording is created
+ * before recording starts, when a clip is armed, and destroyed after the
+ * take has been handed off the audio thread. Only write() is meant for the
+ * audio thread.
+ */
+class SampleRecording
+{
+public:
+	SampleRecording();
+	~SampleRecording();
+
+	SampleRecording(const SampleRecording&) = delete;
+	SampleRecording& operator=(const SampleRecording&) = delete;
+
+	void write(const SampleFrame* frames, f_cnt_t count);
+
+	f_cnt_t framesRecorded() const
+	{
+		return m_framesRecorded;
+	}
+
+	//! Stops writing the recording and returns a buffer with all of it
+	std::shared_ptr<const SampleBuffer> createSampleBuffer();
+
+private:
+	void openFile();
+	void runWriter();
+	void finishWriting();
+
+	f_cnt_t m_framesRecorded = 0;
+
+	QString m_fileName;
+	SNDFILE* m_sndFile = nullptr;
+
+	//! Frames recorded but not written to the file yet
+	LocklessRingBuffer<SampleFrame> m_ringBuffer;
+	LocklessRingBufferReader<SampleFrame> m_ringBufferReader;
+	std::thread m_writer;
+	std::atomic<bool> m_stopWriter = false;
+	//! Frames lost because the writer couldn't keep up
+	std::atomic<f_cnt_t> m_framesDropped = 0;
+	//! Frames lost which the writer hasn't replaced by silence yet
+	std::atomic<f_cnt_t> m_pendingSilence = 0;
+
+	//! Used if the file couldn't be created
+	std::vector<SampleFrame> m_memoryBuffer;
+};
+
+
+/**
+ * Records the input of the audio engine into a sample clip.
+ *
+ * The handle is created and destroyed on the audio thread. It writes into the
+ * recording the clip prepared when it was armed, which is finished and
+ * loaded into the clip by a worker thread once the handle is gone.
+ */
 class SampleRecordHandle : public PlayHandle
 {
 public:
-	SampleRecordHandle( SampleClip* clip );
+	SampleRecordHandle(SampleClip* clip, std::shared_ptr<SampleRecording> recording);
 	~SampleRecordHandle() override;
 
 	void play( SampleFrame* _working_buffer ) override;
@@ -54,22 +121,17 @@ public:
 	bool isFromTrack( const Track * _track ) const override;
 
 	f_cnt_t framesRecorded() const;
-	std::shared_ptr<const SampleBuffer> createSampleBuffer();
 
 
 private:
-	virtual void writeBuffer( const SampleFrame* _ab,
-						const f_cnt_t _frames );
-
-	using bufferList = QList<QPair<SampleFrame*, f_cnt_t>>;
-	bufferList m_buffers;
-	f_cnt_t m_framesRecorded;
 	TimePos m_minLength;
 
 	Track * m_track;
 	PatternTrack* m_patternTrack;
 	SampleClip * m_clip;
 
+	std::shared_ptr<SampleRecording> m_recording;
+
 } ;
 
 
@@ -0,0 +1,107 @@
+/*
+ * SampleStream.h - reads the frames of a streamed sample ahead for a voice
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_SAMPLE_STREAM_H
+#define LMMS_SAMPLE_STREAM_H
+
+#include <cstddef>
+#include <memory>
+
+#include "SampleFrame.h"
+#include "lmms_export.h"
+
+namespace lmms {
+
+class SampleBuffer;
+
+/**
+ * Read-ahead buffer of a voice playing a streamed sample (see SampleBuffer::Decoding::Streaming).
+ *
+ * The frames of streamed samples are kept in a file mapped into memory, so
+ * reading them may have to wait for the disk. A prefetch thread shared by all
+ * streams copies the frames following the position of each voice into its
+ * read-ahead buffer, so the audio thread doesn't have to. Frames which
+ * haven't been read ahead (e.g. right after a jump) have to be read from the
+ * buffer directly.
+ *
+ * The read-ahead buffers come from a pool the prefetch thread allocates ahead
+ * and claiming one is lock-free, so opening a stream in the audio thread
+ * neither allocates nor waits. If all of them are in use, the stream stays
+ * closed and the voice reads the buffer directly.
+ *
+ * The stream itself must only be used by the voice's thread.
+ */
+class LMMS_EXPORT SampleStream
+{
+public:
+	//! Frames read ahead of the position of a voice
+	static constexpr auto ReadAheadFrames = std::size_t{16384};
+
+	SampleStream() = default;
+	~SampleStream();
+
+	SampleStream(const SampleStream&) = delete;
+	auto operator=(const SampleStream&) -> SampleStream& = delete;
+
+	//! Starts the prefetch thread and its pool, so the first stream opened doesn't have to
+	static void prepare();
+
+	//! Starts reading @p buffer ahead from @p position on, closing the stream opened before if any.
+	//! Returns false if there is no read-ahead buffer left.
+	auto open(const std::shared_ptr<const SampleBuffer>& buffer, std::size_t position) -> bool;
+	//! Hands the read-ahead buffer back to the pool
+	void close();
+
+	auto isOpen() const -> bool { return m_slot != nullptr; }
+
+	//! Announces that the frames from @p position on are going to be read, the frames before it aren't
+	//! needed anymore. Restarts reading ahead at @p position if it's outside the frames read so far.
+	void seek(std::size_t position);
+
+	//! The buffer read ahead, nullptr if the stream isn't open
+	auto buffer() const -> const SampleBuffer*;
+
+	//! Returns frame @p index in @p frame if it has been read ahead already, only frames from the
+	//! position passed to seek() on may be read
+	auto read(std::size_t index, SampleFrame& frame) const -> bool
+	{
+		if (index < m_position || index >= m_available) { return false; }
+		frame = m_frames[index % ReadAheadFrames];
+		return true;
+	}
+
+private:
+	struct Slot;
+	class Prefetcher;
+
+	//! Owned by the pool, which releases the buffer once the stream has been closed
+	Slot* m_slot = nullptr;
+	const SampleFrame* m_frames = nullptr;
+	std::size_t m_position = 0;
+	//! The frames before it have been read ahead when seek() was called last
+	std::size_t m_available = 0;
+	unsigned m_restart = 0;
+};
+
+} // namespace lmms
+
+#endif // LMMS_SAMPLE_STREAM_H
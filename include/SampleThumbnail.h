@@ -29,6 +29,7 @@
 #include <QDateTime>
 #include <QRect>
 #include <memory>
+#include <mutex>
 
 #include "lmms_export.h"
 #include "SampleBuffer.h"
@@ -50,6 +51,10 @@ class Sample;
    Given that we are dealing with far less data to generate
    the visualization however (i.e., we are not reading from original sample data when drawing), this provides a
    significant performance boost that wouldn't be possible otherwise.
+
+   For large samples, the thumbnails are generated in parallel on the thread pool and stored in a cache directory,
+   so opening the same file again later only needs to read them back. Meanwhile, a coarse preview computed from a
+   part of the frames is drawn.
  */
 class LMMS_EXPORT SampleThumbnail
 {
@@ -74,6 +79,20 @@ public:
 	SampleThumbnail(const Sample& sample);
 	void visualize(VisualizeParameters parameters, QPainter& painter) const;
 
+	//! True if the sample was still being decoded or the thumbnails are still being generated. At most a preview
+	//! is drawn then, and the thumbnail has to be drawn (or created, if decoding) again later.
+	auto isIncomplete() const -> bool { return m_incomplete || !m_thumbnailCache->complete(); }
+
+	//! Memory taken by the cached thumbnails of sample files, must be called on the GUI thread
+	static auto memoryUsage() -> std::size_t;
+
+	//! True if both thumbnails draw the same sample in the same state
+	friend bool operator==(const SampleThumbnail& first, const SampleThumbnail& second)
+	{
+		return first.m_buffer == second.m_buffer && first.m_thumbnailCache == second.m_thumbnailCache
+			&& first.m_incomplete == second.m_incomplete;
+	}
+
 private:
 	class Thumbnail
 	{
@@ -103,11 +122,16 @@ private:
 
 		Thumbnail() = default;
 		Thumbnail(std::vector<Peak> peaks, double samplesPerPeak);
-		Thumbnail(const float* buffer, size_t size, size_t width);
+		Thumbnail(const SampleBuffer& buffer, size_t width);
+
+		//! Computes the peaks from @p first up to @p last of a thumbnail of @p buffer that is @p width peaks wide
+		static void computePeaks(
+			const SampleBuffer& buffer, size_t width, size_t first, size_t last, Peak* peaks);
 
 		Thumbnail zoomOut(float factor) const;
 
 		Peak* data() { return m_peaks.data(); }
+		const Peak* data() const { return m_peaks.data(); }
 		Peak& operator[](size_t index) { return m_peaks[index]; }
 		const Peak& operator[](size_t index) const { return m_peaks[index]; }
 
@@ -135,9 +159,43 @@ private:
 		std::size_t operator()(const SampleThumbnailEntry& entry) const noexcept { return qHash(entry.filePath); }
 	};
 
-	using ThumbnailCache = std::vector<Thumbnail>;
-	std::shared_ptr<ThumbnailCache> m_thumbnailCache = std::make_shared<ThumbnailCache>();
+	//! The thumbnails of a sample from the finest to the coarsest one, published at once by the thread
+	//! generating them
+	class ThumbnailCache
+	{
+	public:
+		using Levels = std::vector<Thumbnail>;
+
+		ThumbnailCache() = default;
+		//! Creates a cache with complete @p levels
+		explicit ThumbnailCache(Levels levels);
+
+		//! Null until the first thumbnails have been published
+		auto levels() const -> std::shared_ptr<const Levels>;
+
+		//! False while only a preview has been published
+		auto complete() const -> bool;
+
+		void publish(Levels levels, bool complete);
+
+	private:
+		mutable std::mutex m_mutex;
+		std::shared_ptr<const Levels> m_levels;
+		bool m_complete = false;
+	};
+
+	struct Generation;
+
+	static auto zoomOutLevels(Thumbnail finest) -> ThumbnailCache::Levels;
+	static auto generateLevels(const SampleBuffer& buffer) -> ThumbnailCache::Levels;
+	static auto generatePreview(const SampleBuffer& buffer) -> ThumbnailCache::Levels;
+	static void generateInBackground(std::shared_ptr<Generation> generation);
+	static auto readPeakFile(const QString& path, std::size_t frames) -> ThumbnailCache::Levels;
+	static void writePeakFile(const QString& path, std::size_t frames, const ThumbnailCache::Levels& levels);
+
+	std::shared_ptr<ThumbnailCache> m_thumbnailCache = std::make_shared<ThumbnailCache>(ThumbnailCache::Levels{});
 	std::shared_ptr<const SampleBuffer> m_buffer = SampleBuffer::emptyBuffer();
+	bool m_incomplete = false;
 	inline static std::unordered_map<SampleThumbnailEntry, std::shared_ptr<ThumbnailCache>, Hash> s_sampleThumbnailCacheMap;
 };
 
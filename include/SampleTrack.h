@@ -90,13 +90,17 @@ public slots:
 	void updateClips();
 	void setPlayingClips( bool isPlaying );
 	void updateMixerChannel();
+	void updateInputMonitoring();
 
 private:
 	FloatModel m_volumeModel;
 	FloatModel m_panningModel;
 	IntModel m_mixerChannelModel;
+	//! Whether the audio input is heard on this track's mixer channel
+	BoolModel m_monitorInputModel;
 	AudioBusHandle m_audioBusHandle;
 	bool m_isPlaying;
+	bool m_monitoringInput;
 
 
 
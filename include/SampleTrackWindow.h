@@ -39,6 +39,7 @@ namespace lmms::gui
 class AutomatableButton;
 class EffectRackView;
 class Knob;
+class LedCheckBox;
 class MixerChannelLcdSpinBox;
 class SampleTrackView;
 
@@ -94,6 +95,7 @@ private:
 	AutomatableButton* m_muteBtn;
 	AutomatableButton* m_soloBtn;
 	MixerChannelLcdSpinBox * m_mixerChannelNumber;
+	LedCheckBox* m_monitorInputCheckBox;
 
 	EffectRackView * m_effectRack;
 } ;
@@ -0,0 +1,87 @@
+/*
+ * SampleWaveformRenderer.h - draws waveforms of samples on the thread pool
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_GUI_SAMPLE_WAVEFORM_RENDERER_H
+#define LMMS_GUI_SAMPLE_WAVEFORM_RENDERER_H
+
+#include <QImage>
+#include <QObject>
+#include <optional>
+
+#include "SampleThumbnail.h"
+#include "lmms_export.h"
+
+class QPainter;
+
+namespace lmms::gui
+{
+
+/**
+	Draws the waveform of a sample into an image on the thread pool
+
+	Drawing the waveform of a long sample at a high zoom level means going
+	through many peaks, or even the frames themselves, so views don't draw it
+	while painting. Instead, they draw the last image rendered, and a new one
+	is rendered in the background whenever what is drawn changes. Until it is
+	ready, the last image is stretched to where the new one goes, so zooming
+	and scrolling stay responsive. Only one image is rendered at a time, the
+	latest request is queued meanwhile.
+*/
+class LMMS_EXPORT SampleWaveformRenderer : public QObject
+{
+	Q_OBJECT
+public:
+	using QObject::QObject;
+
+	//! Draws the waveform of @p thumbnail with @p parameters and @p color onto @p painter, as far as it
+	//! has been rendered. Thumbnails which are still being generated are drawn right away.
+	void draw(const SampleThumbnail& thumbnail, const SampleThumbnail::VisualizeParameters& parameters,
+		const QColor& color, QPainter& painter);
+
+signals:
+	//! A new image has been rendered, the view should paint again
+	void rendered();
+
+private:
+	struct Request
+	{
+		SampleThumbnail thumbnail;
+		SampleThumbnail::VisualizeParameters parameters;
+		QSize size;
+		qreal devicePixelRatio;
+		QRgb color;
+
+		friend bool operator==(const Request& first, const Request& second);
+	};
+
+	void render(const Request& request);
+	void finish(const Request& request, const QImage& image);
+
+	QImage m_image;
+	std::optional<Request> m_imageRequest;
+	std::optional<Request> m_rendering;
+	std::optional<Request> m_queued;
+};
+
+} // namespace lmms::gui
+
+#endif // LMMS_GUI_SAMPLE_WAVEFORM_RENDERER_H
@@ -39,6 +39,7 @@ class QComboBox;
 class QLabel;
 class QLineEdit;
 class QSlider;
+class QSpinBox;
 
 
 namespace lmms::gui
@@ -97,6 +98,7 @@ private slots:
 	void toggleAnimateAFP(bool enabled);
 	void vstEmbedMethodChanged();
 	void toggleVSTAlwaysOnTop(bool en);
+	void toggleVSTSharedProcess(bool enabled);
 	void toggleDisableAutoQuit(bool enabled);
 
 	// Audio settings widget.
@@ -167,7 +169,18 @@ private:
 	QString m_vstEmbedMethod;
 	QCheckBox * m_vstAlwaysOnTopCheckBox;
 	bool m_vstAlwaysOnTop;
+	bool m_vstSharedProcess;
 	bool m_disableAutoQuit;
+	QSpinBox* m_workerThreadsSpinBox;
+	QSpinBox* m_renderWorkerThreadsSpinBox;
+	QLineEdit* m_workerCpusLineEdit;
+	QCheckBox* m_efficiencyCoresCheckBox;
+	QCheckBox* m_numaNodesCheckBox;
+	QComboBox* m_realtimePolicyComboBox;
+	QSpinBox* m_realtimePrioritySpinBox;
+	QSpinBox* m_spinTimeSpinBox;
+	QCheckBox* m_lockMemoryCheckBox;
+	QComboBox* m_hugePagesComboBox;
 
 	using AswMap = QMap<QString, AudioDeviceSetupWidget*>;
 	using MswMap = QMap<QString, MidiSetupWidget*>;
@@ -182,8 +195,13 @@ private:
 	QSlider * m_bufferSizeSlider;
 	QLabel * m_bufferSizeLbl;
 	QLabel * m_bufferSizeWarnLbl;
+	QSpinBox* m_recordingBufferSizeSpinBox;
 	int m_sampleRate;
 	QSlider* m_sampleRateSlider;
+	QComboBox* m_sampleStorageComboBox;
+	QCheckBox* m_streamSamplesCheckBox;
+	QCheckBox* m_resampleOnLoadCheckBox;
+	QComboBox* m_voiceStealingComboBox;
 
 	// MIDI settings widgets.
 	QComboBox * m_midiInterfaces;
@@ -25,6 +25,7 @@
 #ifndef LMMS_SHARED_MEMORY_H
 #define LMMS_SHARED_MEMORY_H
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <type_traits>
@@ -165,6 +166,37 @@ private:
 	detail::SharedMemoryData m_data;
 };
 
+/**
+ * An event counter in shared memory, for one process to signal another it is
+ * done with something without a round trip through the kernel when the other
+ * one is already waiting.
+ *
+ * The waiting process spins for a while before it goes to sleep, on Linux on a
+ * futex on the counter. Elsewhere it polls with yields, so the message
+ * channels remain the better choice there.
+ */
+struct SharedEvent
+{
+#ifdef __linux__
+	static constexpr bool Supported = true;
+#else
+	static constexpr bool Supported = false;
+#endif
+
+	//! The number of times the event has been posted, pass to wait()
+	auto count() noexcept -> std::uint32_t;
+
+	//! Wakes up the process waiting for the event
+	void post() noexcept;
+
+	//! Waits until the event has been posted more than @p seen times, spinning
+	//! @p spins times before sleeping. Returns false on timeout.
+	auto wait(std::uint32_t seen, int spins, int timeoutMs) noexcept -> bool;
+
+	std::uint32_t m_count;
+	std::uint32_t m_sleeping;
+};
+
 } // namespace lmms
 
 #endif // LMMS_SHARED_MEMORY_H
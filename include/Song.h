@@ -31,6 +31,7 @@
 #include <QString>
 #include <QHash>  // IWYU pragma: keep
 
+#include "ActiveAutomation.h"
 #include "AudioEngine.h"
 #include "Controller.h"
 #include "Metronome.h"
@@ -38,12 +39,14 @@
 #include "MeterModel.h"
 #include "Timeline.h"
 #include "TrackContainer.h"
+#include "TransportSchedule.h"
 #include "VstSyncController.h"
 
 namespace lmms
 {
 
 class AutomationTrack;
+class DataFile;
 class Keymap;
 class MidiClip;
 class Scale;
@@ -222,6 +225,8 @@ public:
 		m_exportLoop = exportLoop;
 	}
 
+	bool exportLoop() const { return m_exportLoop; }
+
 	inline bool isRecording() const
 	{
 		return m_recording;
@@ -249,6 +254,8 @@ public:
 		m_renderBetweenMarkers = renderBetweenMarkers;
 	}
 
+	bool renderBetweenMarkers() const { return m_renderBetweenMarkers; }
+
 	inline PlayMode playMode() const
 	{
 		return m_playMode;
@@ -301,6 +308,9 @@ public:
 	bool guiSaveProject();
 	bool guiSaveProjectAs(const QString & filename);
 	bool saveProjectFile(const QString & filename, bool withResources = false);
+	//! Saves the project into a new document, which no longer refers to the
+	//! project, so it can be written while the project is edited
+	DataFile projectSnapshot(bool withResources = false);
 
 	const QString & projectFileName() const
 	{
@@ -358,7 +368,13 @@ public:
 		return m_tempoModel;
 	}
 
-	void exportProjectMidi(QString const & exportFileName) const;
+	IntModel& masterPitchModel()
+	{
+		return m_masterPitchModel;
+	}
+
+	//! Returns false if the file couldn't be written
+	bool exportProjectMidi(QString const & exportFileName) const;
 
 	inline void setLoadOnLaunch(bool value) { m_loadOnLaunch = value; }
 	SaveOptions &getSaveOptions() {
@@ -492,6 +508,8 @@ private:
 	PlayMode m_playMode;
 	PlayMode m_lastPlayMode;
 	PlayPos m_playPos[PlayModeCount];
+	//! Where the ticks start at the current tempo, updated by processNextBuffer()
+	TransportSchedule m_transportSchedule;
 	bar_t m_length;
 
 	const MidiClip* m_midiClipToPlay;
@@ -514,7 +532,7 @@ private:
 	std::shared_ptr<Scale> m_scales[MaxScaleCount];
 	std::shared_ptr<Keymap> m_keymaps[MaxKeymapCount];
 
-	AutomatedValueMap m_oldAutomatedValues;
+	ActiveAutomation m_activeAutomation;
 
 	Metronome m_metronome;
 
@@ -0,0 +1,78 @@
+/*
+ * StartupScheduler.h - parallel and deferred tasks while starting up
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_STARTUP_SCHEDULER_H
+#define LMMS_STARTUP_SCHEDULER_H
+
+#include <QString>
+
+#include <functional>
+
+#include "lmms_export.h"
+
+class QObject;
+
+namespace lmms
+{
+
+/**
+	Orders the work done while starting up
+
+	Tasks which don't depend on each other, like scanning for plugins and
+	generating the wavetables, run on threads of their own while the main
+	thread goes on, until someone waits for them. Tasks which aren't needed
+	to show the main window run on the main thread once the event loop is
+	running.
+
+	The main thread's work is split into phases. The time each phase and
+	task took can be written to a file, which is what `--profile` does when
+	starting the GUI.
+*/
+class LMMS_EXPORT StartupScheduler
+{
+public:
+	//! Runs @p task on a thread of its own. @p name must be unique.
+	static void start(const QString& name, std::function<void()> task);
+	//! Waits until the task started as @p name is done. Does nothing for
+	//! unknown tasks, or those waited for already.
+	static void wait(const QString& name);
+
+	//! Runs @p task on the main thread once the event loop is running,
+	//! unless @p context was deleted by then
+	static void defer(const QString& name, QObject* context, std::function<void()> task);
+
+	//! Ends the main thread's current phase, if any, and begins the next one
+	static void beginPhase(const QString& name);
+	//! Ends the main thread's last phase. The report is written once all
+	//! deferred tasks are done.
+	static void finish();
+
+	//! Writes the report to @p fileName when starting up is finished
+	static void reportTo(const QString& fileName);
+	//! The time each phase and task took, as a table
+	static QString report();
+};
+
+
+} // namespace lmms
+
+#endif // LMMS_STARTUP_SCHEDULER_H
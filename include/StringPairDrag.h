@@ -35,6 +35,11 @@
 
 class QPixmap;
 
+namespace lmms
+{
+class DataFile;
+}
+
 namespace lmms::gui
 {
 
@@ -44,12 +49,18 @@ class LMMS_EXPORT StringPairDrag : public QDrag
 public:
 	StringPairDrag( const QString & _key, const QString & _value,
 					const QPixmap & _icon, QWidget * _w );
+	//! Drags @p dataFile without writing it to XML, unless it's dropped
+	//! on another application
+	StringPairDrag(const QString& key, const DataFile& dataFile, const QPixmap& icon, QWidget* w);
 	~StringPairDrag() override;
 
 	static bool processDragEnterEvent( QDragEnterEvent * _dee,
 						const QString & _allowed_keys );
 	static QString decodeKey( QDropEvent * _de );
 	static QString decodeValue( QDropEvent * _de );
+
+private:
+	void start(QMimeData* mimeData, const QPixmap& icon, QWidget* w);
 } ;
 
 
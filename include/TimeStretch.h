@@ -0,0 +1,68 @@
+/*
+ * TimeStretch.h - changes the length of samples without changing their pitch
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_TIME_STRETCH_H
+#define LMMS_TIME_STRETCH_H
+
+#include <future>
+#include <memory>
+
+#include "lmms_export.h"
+
+namespace lmms {
+
+class SampleBuffer;
+
+/**
+ * Stretches samples in time while keeping their pitch, e.g. to play loops
+ * in sync with the tempo of the song.
+ *
+ * Stretching uses WSOLA (waveform similarity overlap-add): windows of the
+ * sample are overlapped at a different distance than they were taken from,
+ * each shifted slightly to where it resembles the continuation of the one
+ * before the most, so the waveform isn't disrupted. It works best on
+ * rhythmic material and ratios not too far from 1.
+ *
+ * Stretching takes far too long to be done while playing, so samples are
+ * rendered in the background and played from the renders. The most recently
+ * used renders of each buffer in use are cached, so buffers shared by several
+ * clips are only stretched once per ratio.
+ */
+class LMMS_EXPORT TimeStretch
+{
+public:
+	using Render = std::shared_future<std::shared_ptr<const SampleBuffer>>;
+
+	//! @p buffer stretched to @p ratio times its length, at its sample rate. Waits until it has been decoded.
+	static auto stretch(const SampleBuffer& buffer, double ratio) -> SampleBuffer;
+
+	//! The render of @p buffer stretched to @p ratio times its length, which is stretched on the thread
+	//! pool unless it is cached already
+	static auto render(std::shared_ptr<const SampleBuffer> buffer, double ratio) -> Render;
+
+	//! Drops all cached renders, renders still in use stay valid
+	static void clear();
+};
+
+} // namespace lmms
+
+#endif // LMMS_TIME_STRETCH_H
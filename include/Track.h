@@ -25,9 +25,11 @@
 #ifndef LMMS_TRACK_H
 #define LMMS_TRACK_H
 
+#include <atomic>
 #include <vector>
 
 #include <QColor>
+#include <QMutex>
 
 #include "AutomatableModel.h"
 #include "JournallingObject.h"
@@ -121,6 +123,11 @@ public:
 	// -- for usage by Clip only ---------------
 	Clip * addClip( Clip * clip );
 	void removeClip( Clip * clip );
+	//! To be called when a clip was moved or resized
+	void clipMoved()
+	{
+		m_clipsRevision.fetch_add(1, std::memory_order_release);
+	}
 	// -------------------------------------------------------
 	void deleteClips();
 
@@ -132,6 +139,9 @@ public:
 	{
 		return m_clips;
 	}
+	//! Adds the clips overlapping [@p start, @p end] to @p clipV, keeping it
+	//! sorted by position. Takes O(log n) plus the number of clips found,
+	//! using an index which is rebuilt on the first query after a change.
 	void getClipsInRange( clipVector & clipV, const TimePos & start,
 							const TimePos & end );
 	void swapPositionOfClips( int clipNum1, int clipNum2 );
@@ -226,6 +236,22 @@ private:
 
 	clipVector m_clips;
 
+	//! The clips sorted by start position, along with the furthest end
+	//! position of any clip up to each of them
+	struct ClipIndexEntry
+	{
+		tick_t start;
+		tick_t end;
+		tick_t reach;
+		Clip* clip;
+	};
+	std::vector<ClipIndexEntry> m_clipIndex;
+	//! Increased whenever clips are added, removed, moved or resized
+	std::atomic<unsigned> m_clipsRevision = 1;
+	unsigned m_clipIndexRevision = 0;
+	//! The index is built by whichever thread queries it first
+	QMutex m_clipIndexMutex;
+
 	QMutex m_processingLock;
 	
 	std::optional<QColor> m_color;
@@ -27,6 +27,7 @@
 #define LMMS_TRACK_CONTAINER_H
 
 #include <QReadWriteLock>
+#include <atomic>
 
 #include "Track.h"
 #include "JournallingObject.h"
@@ -65,6 +66,10 @@ public:
 
 	int countTracks( Track::Type _tt = Track::Type::Count ) const;
 
+	//! Waits until the sample clips of all tracks are stretched to the
+	//! current tempo, as the audio engine never waits for them
+	void finishStretch() const;
+
 
 	void addTrack( Track * _track );
 	void removeTrack( Track * _track );
@@ -97,6 +102,16 @@ public:
 
 	virtual AutomatedValueMap automatedValuesAt(TimePos time, int clipNum = -1) const;
 
+	//! Changes whenever tracks or clips are added, removed, moved or resized in any container, or the models of an
+	//! automation clip change, so the audio thread can tell whether the automation it plays is still valid
+	static unsigned arrangementRevision()
+	{
+		return s_arrangementRevision.load(std::memory_order_acquire);
+	}
+
+	//! Also compiles the patterns again, see PatternStore::compilePatterns()
+	static void arrangementChanged();
+
 signals:
 	void trackAdded( lmms::Track * _track );
 
@@ -106,6 +121,8 @@ protected:
 	mutable QReadWriteLock m_tracksMutex;
 
 private:
+	inline static std::atomic<unsigned> s_arrangementRevision = 0;
+
 	TrackList m_tracks;
 
 	Type m_TrackContainerType;
@@ -0,0 +1,83 @@
+/*
+ * TrackFreezer.h - renders an instrument track ahead of time to play it back frozen
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_TRACK_FREEZER_H
+#define LMMS_TRACK_FREEZER_H
+
+#include <QThread>
+
+#include <memory>
+#include <vector>
+
+#include "lmms_export.h"
+
+namespace lmms
+{
+
+class FrozenAudio;
+class InstrumentTrack;
+class Track;
+
+/**
+ * Renders the output of an instrument track through the whole song, with all
+ * other tracks muted, and freezes the track with it once done.
+ *
+ * Rendering works like an export, just without a file: the audio engine
+ * processes the song as fast as it can on this thread, and the output of the
+ * track's audio bus is captured after its effects.
+ */
+class LMMS_EXPORT TrackFreezer : public QThread
+{
+	Q_OBJECT
+public:
+	TrackFreezer(InstrumentTrack* track);
+	~TrackFreezer() override = default;
+
+public slots:
+	void startProcessing();
+	void abortProcessing();
+
+signals:
+	void progressChanged(int);
+	//! Emitted once the track is frozen, or rendering was aborted
+	void done();
+
+private slots:
+	void finish();
+
+private:
+	void run() override;
+
+	InstrumentTrack* m_track;
+	std::shared_ptr<FrozenAudio> m_audio;
+
+	//! Tracks muted while rendering, unmuted again afterwards
+	std::vector<Track*> m_muted;
+	bool m_trackWasMuted = false;
+
+	volatile int m_progress = 0;
+	volatile bool m_abort = false;
+};
+
+} // namespace lmms
+
+#endif // LMMS_TRACK_FREEZER_H
@@ -0,0 +1,91 @@
+/*
+ * TransportSchedule.h - exact frame positions of the ticks at a tempo
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_TRANSPORT_SCHEDULE_H
+#define LMMS_TRANSPORT_SCHEDULE_H
+
+#include <cstdint>
+
+#include "LmmsTypes.h"
+#include "TimePos.h"
+
+namespace lmms {
+
+/**
+ * The frames the ticks start at, from a tick on which the tempo was set.
+ *
+ * A tick takes a fractional number of frames, which the song used to add up
+ * in floating point, period by period. The schedule keeps the frames per tick
+ * as the exact fraction they are instead, so the ticks start at the same
+ * frames however the periods split them, and the song doesn't drift.
+ */
+class TransportSchedule
+{
+public:
+	TransportSchedule() = default;
+
+	//! The ticks from @p anchor on, which starts at frame 0
+	TransportSchedule(sample_rate_t sampleRate, bpm_t tempo, tick_t anchor) :
+		m_sampleRate(sampleRate),
+		m_tempo(tempo),
+		m_anchor(anchor),
+		// see Engine::framesPerTick()
+		m_numerator(std::int64_t{sampleRate} * 60 * 4),
+		m_denominator(std::int64_t{DefaultTicksPerBar} * tempo)
+	{
+	}
+
+	//! Whether the schedule still applies, or the tempo or sample rate changed since
+	bool fits(sample_rate_t sampleRate, bpm_t tempo) const
+	{
+		return sampleRate == m_sampleRate && tempo == m_tempo && m_denominator > 0;
+	}
+
+	tick_t anchor() const { return m_anchor; }
+
+	//! The frame @p tick starts at, counted from the anchor
+	std::int64_t tickStart(tick_t tick) const
+	{
+		const auto product = (std::int64_t{tick} - m_anchor) * m_numerator;
+		// rounds towards negative infinity, so ticks before the anchor are just as long
+		return product >= 0
+			? product / m_denominator
+			: -((-product + m_denominator - 1) / m_denominator);
+	}
+
+	//! The frames of @p tick, the whole number below or above the frames per tick
+	f_cnt_t tickLength(tick_t tick) const
+	{
+		return static_cast<f_cnt_t>(tickStart(tick + 1) - tickStart(tick));
+	}
+
+private:
+	sample_rate_t m_sampleRate = 0;
+	bpm_t m_tempo = 0;
+	tick_t m_anchor = 0;
+	std::int64_t m_numerator = 0;
+	std::int64_t m_denominator = 0;
+};
+
+} // namespace lmms
+
+#endif // LMMS_TRANSPORT_SCHEDULE_H
@@ -26,19 +26,36 @@
 #ifndef LMMS_VALUE_BUFFER_H
 #define LMMS_VALUE_BUFFER_H
 
-#include <vector>
+#include <cstddef>
 
 #include "lmms_export.h"
 
 namespace lmms
 {
 
+/**
+	@brief Per-frame values of a model for one period
 
-class LMMS_EXPORT ValueBuffer : public std::vector<float>
+	The storage is taken from the BufferManager pool the first time the values
+	are accessed, so the many models which are never automated sample-exactly
+	don't hold on to any pooled buffer, and acquiring it doesn't allocate on the
+	realtime threads. Buffers longer than the pooled ones live on the heap.
+
+	The buffer remembers whether it holds a single value, i.e. was last filled
+	by fill() or a flat interpolate(), so consumers can take scalar paths.
+	Code writing the values directly must call markVarying().
+*/
+class LMMS_EXPORT ValueBuffer
 {
 public:
 	ValueBuffer() = default;
 	ValueBuffer(int length);
+	ValueBuffer(const ValueBuffer& other);
+	ValueBuffer(ValueBuffer&& other) noexcept;
+	~ValueBuffer();
+
+	ValueBuffer& operator=(const ValueBuffer& other);
+	ValueBuffer& operator=(ValueBuffer&& other) noexcept;
 
 	void fill(float value);
 
@@ -46,10 +63,43 @@ public:
 
 	const float * values() const;
 	float * values();
-	
+	const float* data() const { return values(); }
+	float* data() { return values(); }
+
+	const float* begin() const { return values(); }
+	const float* end() const { return values() + m_length; }
+	float* begin() { return values(); }
+	float* end() { return values() + m_length; }
+
+	float operator[](std::size_t i) const { return values()[i]; }
+	float& operator[](std::size_t i) { return values()[i]; }
+
 	int length() const;
+	std::size_t size() const { return m_length; }
+	bool empty() const { return m_length == 0; }
+
+	//! Changes the length, keeping the values. Doesn't allocate as long as
+	//! @p length is within the length the buffer was created with.
+	void resize(std::size_t length);
+	//! Sets the length to 0 and gives the storage back
+	void clear();
 
 	void interpolate(float start, float end);
+
+	//! True if all values are the same, see fill()
+	bool isConstant() const { return m_constant; }
+	//! Must be called after writing to values() directly
+	void markVarying() { m_constant = false; }
+
+private:
+	void acquire() const;
+	void release();
+
+	mutable float* m_data = nullptr;
+	mutable bool m_pooled = false;
+	std::size_t m_length = 0;
+	std::size_t m_capacity = 0;
+	bool m_constant = false;
 };
 
 
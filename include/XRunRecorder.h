@@ -0,0 +1,118 @@
+/*
+ * XRunRecorder.h - keeps what was going on when periods missed their deadline
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_XRUN_RECORDER_H
+#define LMMS_XRUN_RECORDER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "AudioEngineProfiler.h"
+#include "LmmsTypes.h"
+#include "lmms_export.h"
+
+class QString;
+
+namespace lmms
+{
+
+/**
+ * Keeps the last incidents of periods which took longer to render than to
+ * play back, so intermittent dropouts can be diagnosed after the fact.
+ *
+ * Incidents are recorded by the thread rendering the period without
+ * allocating or blocking; should the ring be read at that moment, the
+ * incident is counted, but not kept.
+ */
+class LMMS_EXPORT XRunRecorder
+{
+public:
+	struct Incident
+	{
+		std::int64_t time = 0; //!< milliseconds since the epoch
+		std::uint64_t period = 0; //!< periods rendered before
+		fpp_t frames = 0;
+		sample_rate_t sampleRate = 0;
+		int renderTime = 0; //!< microseconds the period took
+		int deadline = 0; //!< microseconds it could take
+		std::array<int, AudioEngineProfiler::DetailCount> stageTimes{}; //!< microseconds
+		AudioEngineProfiler::SlowestJobs slowestJobs{};
+		std::size_t slowestJobCount = 0;
+		int playHandles = 0;
+		int workers = 0; //!< threads processing jobs, including the rendering one
+		int sleepingWorkers = 0;
+		int deviceInterval = 0; //!< microseconds between the last two requests of the audio device
+		int deviceWait = 0; //!< microseconds the device waited for its last period
+	};
+
+	explicit XRunRecorder(std::size_t capacity);
+
+	void record(const Incident& incident);
+
+	//! Called by audio devices around requesting a period, to time their callbacks
+	void beginDeviceRequest();
+	void endDeviceRequest();
+
+	int deviceInterval() const
+	{
+		return m_deviceInterval.load(std::memory_order_relaxed);
+	}
+
+	int deviceWait() const
+	{
+		return m_deviceWait.load(std::memory_order_relaxed);
+	}
+
+	//! The incidents kept, the oldest first
+	std::vector<Incident> incidents() const;
+
+	//! All incidents since the last clear(), including the ones no longer kept
+	std::uint64_t total() const
+	{
+		return m_total.load(std::memory_order_relaxed);
+	}
+
+	void clear();
+
+	//! Writes the incidents kept to @p file as JSON
+	bool exportTo(const QString& file) const;
+
+private:
+	static std::int64_t now();
+
+	mutable std::mutex m_mutex;
+	std::vector<Incident> m_incidents;
+	std::size_t m_next = 0;
+	std::size_t m_count = 0;
+	std::atomic<std::uint64_t> m_total = 0;
+
+	std::atomic<std::int64_t> m_lastDeviceRequest = 0;
+	std::atomic<int> m_deviceInterval = 0;
+	std::atomic<int> m_deviceWait = 0;
+};
+
+} // namespace lmms
+
+#endif // LMMS_XRUN_RECORDER_H
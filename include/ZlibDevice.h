@@ -0,0 +1,159 @@
+/*
+ * ZlibDevice.h - streaming compression in the format of qCompress()
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_ZLIB_DEVICE_H
+#define LMMS_ZLIB_DEVICE_H
+
+#include <QByteArray>
+#include <QIODevice>
+
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+
+#include "lmms_export.h"
+
+namespace lmms
+{
+
+//! Whether @p data starts like the output of qCompress() or DeflatingDevice
+LMMS_EXPORT bool isZlibCompressed(const QByteArray& data);
+
+
+/**
+	Compresses everything written to it into another device, which reads
+	back with qUncompress() or InflatingDevice
+
+	The data is split into chunks, which are compressed in parallel on
+	worker threads while the next chunk is written, and are joined into one
+	zlib stream. Only the chunks in flight are held in memory.
+
+	The target has to be seekable, as the uncompressed size which starts
+	the format is only known after close().
+*/
+class LMMS_EXPORT DeflatingDevice : public QIODevice
+{
+public:
+	explicit DeflatingDevice(QIODevice* target, int level = -1);
+	~DeflatingDevice() override;
+
+	//! Only QIODevice::WriteOnly is supported
+	bool open(OpenMode mode) override;
+	//! Finishes the stream. Check error() afterwards.
+	void close() override;
+
+	bool isSequential() const override
+	{
+		return true;
+	}
+
+	bool error() const
+	{
+		return m_error;
+	}
+
+
+protected:
+	qint64 readData(char*, qint64) override
+	{
+		return -1;
+	}
+	qint64 writeData(const char* data, qint64 length) override;
+
+
+private:
+	struct Chunk
+	{
+		QByteArray compressed;
+		std::uint32_t adler;
+		qint64 size;
+		bool ok;
+	};
+
+	void submitChunk(bool last);
+	void writeChunk(const Chunk& chunk);
+
+	QIODevice* m_target;
+	const int m_level;
+	qint64 m_headerPos;
+	qint64 m_totalSize;
+	std::uint32_t m_adler;
+	bool m_error;
+
+	QByteArray m_pending;
+	//! The end of the previous chunk, as the dictionary for the next one
+	QByteArray m_dictionary;
+	std::deque<std::future<Chunk>> m_inFlight;
+} ;
+
+
+/**
+	Decompresses data in the format of qCompress() from another device as
+	it is read, without holding all of it in memory
+*/
+class LMMS_EXPORT InflatingDevice : public QIODevice
+{
+public:
+	explicit InflatingDevice(QIODevice* source);
+	~InflatingDevice() override;
+
+	//! Only QIODevice::ReadOnly is supported
+	bool open(OpenMode mode) override;
+	void close() override;
+
+	bool isSequential() const override
+	{
+		return true;
+	}
+
+	bool atEnd() const override;
+
+	//! Whether the data was corrupt or ended early
+	bool error() const
+	{
+		return m_error;
+	}
+
+
+protected:
+	qint64 readData(char* data, qint64 maxLength) override;
+	qint64 writeData(const char*, qint64) override
+	{
+		return -1;
+	}
+
+
+private:
+	struct Stream;
+
+	QIODevice* m_source;
+	std::unique_ptr<Stream> m_stream;
+	QByteArray m_input;
+	bool m_finished;
+	bool m_error;
+} ;
+
+
+} // namespace lmms
+
+#endif // LMMS_ZLIB_DEVICE_H
@@ -4,6 +4,8 @@
 #ifndef LMMS_DENORMALS_H
 #define LMMS_DENORMALS_H
 
+#include <cstdint>
+
 #ifdef __SSE__
 #include <immintrin.h>
 #ifdef __GNUC__
@@ -23,28 +25,75 @@ namespace lmms
 int inline can_we_daz()
 {
   alignas(16) unsigned char buffer[512] = {0};
-#if defined(LMMS_HOST_X86)
-  _fxsave(buffer);
-#elif defined(LMMS_HOST_X86_64)
+  // checks the target rather than the host, as 32-bit remote plugins are
+  // built on 64-bit hosts
+#if defined(__x86_64__) || defined(_M_X64)
   _fxsave64(buffer);
-#endif // defined(LLMS_HOST_X86)
+#else
+  _fxsave(buffer);
+#endif
   // Bit 6 of the MXCSR_MASK, i.e. in the lowest byte,
   // tells if we can use the DAZ flag.
   return ((buffer[28] & (1 << 6)) != 0);
 }
 
+#elif defined(__GNUC__) && (defined(__aarch64__) || (defined(__arm__) && defined(__ARM_FP)))
+
+// The FZ bit of the FPCR (AArch64) or FPSCR (AArch32). Unlike on x86,
+// it flushes denormal inputs as well as results.
+constexpr std::uint64_t ArmFlushToZero = std::uint64_t{1} << 24;
+
+std::uint64_t inline arm_fp_control()
+{
+#ifdef __aarch64__
+  std::uint64_t fpcr;
+  asm volatile("mrs %0, fpcr" : "=r"(fpcr));
+  return fpcr;
+#else
+  std::uint32_t fpscr;
+  asm volatile("vmrs %0, fpscr" : "=r"(fpscr));
+  return fpscr;
+#endif
+}
+
+void inline set_arm_fp_control(std::uint64_t value)
+{
+#ifdef __aarch64__
+  asm volatile("msr fpcr, %0" : : "r"(value));
+#else
+  asm volatile("vmsr fpscr, %0" : : "r"(static_cast<std::uint32_t>(value)));
+#endif
+}
+
 #endif // __SSE__
 
 // Set denormal protection for this thread.
+// Cheap enough to be called every period, which restores it should a
+// plugin have changed the floating point environment meanwhile.
 void inline disable_denormals()
 {
 #ifdef __SSE__
   /* Setting DAZ might freeze systems not supporting it */
-  if (can_we_daz()) {
+  static const bool s_canDaz = can_we_daz();
+  if (s_canDaz) {
     _MM_SET_DENORMALS_ZERO_MODE( _MM_DENORMALS_ZERO_ON );
   }
   /* FTZ flag */
   _MM_SET_FLUSH_ZERO_MODE( _MM_FLUSH_ZERO_ON );
+#elif defined(__GNUC__) && (defined(__aarch64__) || (defined(__arm__) && defined(__ARM_FP)))
+  set_arm_fp_control(arm_fp_control() | ArmFlushToZero);
+#endif // __SSE__
+}
+
+// Whether denormal results are flushed to zero on this thread.
+bool inline denormals_disabled()
+{
+#ifdef __SSE__
+  return _MM_GET_FLUSH_ZERO_MODE() == _MM_FLUSH_ZERO_ON;
+#elif defined(__GNUC__) && (defined(__aarch64__) || (defined(__arm__) && defined(__ARM_FP)))
+  return (arm_fp_control() & ArmFlushToZero) != 0;
+#else
+  return false;
 #endif // __SSE__
 }
 
@@ -28,9 +28,18 @@
 
 #include "lmms_export.h"
 
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
 #include <vector>
 #include <fftw3.h>
 
+#include "LmmsTypes.h"
+#include "LocklessRingBuffer.h"
+#include "SampleFrame.h"
+
 namespace lmms
 {
 
@@ -106,6 +115,117 @@ int LMMS_EXPORT compressbands(const float * _absspec_buffer, float * _compressed
 			int _num_old, int _num_new, int _bottom, int _top);
 
 
+struct FftwDeleter
+{
+	void operator()(void* data) const { fftwf_free(data); }
+};
+
+//! Buffer allocated by fftwf_malloc(), aligned for the SIMD code of FFTW
+template<typename T>
+using FftwBuffer = std::unique_ptr<T[], FftwDeleter>;
+
+template<typename T>
+FftwBuffer<T> makeFftwBuffer(std::size_t size)
+{
+	return FftwBuffer<T>{static_cast<T*>(fftwf_malloc(size * sizeof(T)))};
+}
+
+
+/**	Returns a plan for real-to-complex FFTs of size values, shared by all callers
+ *	and kept until the program ends, so that every size is only planned once.
+ *	Execute it with fftwf_execute_dft_r2c() on buffers allocated by fftwf_malloc().
+ *	Thread-safe.
+ */
+fftwf_plan LMMS_EXPORT realFftPlan(unsigned int size);
+
+/**	Returns a shared plan for complex-to-real FFTs of size values, like realFftPlan().
+ *	Execute it with fftwf_execute_dft_c2r(), which overwrites the input.
+ *	Thread-safe.
+ */
+fftwf_plan LMMS_EXPORT inverseRealFftPlan(unsigned int size);
+
+
+/**
+ * Windowed FFT analysis of a stereo signal, for views such as spectrum analysers.
+ *
+ * The audio thread only copies its periods into a lockless ring buffer with
+ * write(). The FFTs run on a low-priority worker thread shared by all
+ * analyses, which passes every spectrum to all subscribers, so any number of
+ * views can show one analysis. Nothing is computed while the analysis isn't
+ * active, e.g. while none of its views is visible.
+ */
+class LMMS_EXPORT SpectrumAnalysis
+{
+public:
+	struct Spectrum
+	{
+		//! Absolute magnitudes of binCount() bins; right is empty when analysing in mono
+		std::vector<float> left;
+		std::vector<float> right;
+		//! The highest windowed sample of the block, per channel
+		float peakLeft = 0.f;
+		float peakRight = 0.f;
+		sample_rate_t sampleRate = 0;
+	};
+
+	//! Called on the worker thread for every spectrum, must not (un)subscribe
+	using Subscriber = std::function<void(const Spectrum&)>;
+
+	//! Analyses blocks of blockSize frames, zero padded to zeroPadFactor times the size, and
+	//! mixes both channels to mono unless stereo is set
+	SpectrumAnalysis(unsigned int blockSize, FFTWindow window, bool stereo = false, unsigned int zeroPadFactor = 1);
+	~SpectrumAnalysis();
+
+	SpectrumAnalysis(const SpectrumAnalysis&) = delete;
+	SpectrumAnalysis& operator=(const SpectrumAnalysis&) = delete;
+
+	//! Passes a period to the analysis, audio thread only
+	void write(const SampleFrame* buf, fpp_t frames);
+
+	//! Returns an id for unsubscribe()
+	int subscribe(Subscriber subscriber);
+	void unsubscribe(int id);
+
+	//! Input is ignored while the analysis isn't active
+	void setActive(bool active) { m_active = active; }
+	bool isActive() const { return m_active; }
+
+	unsigned int blockSize() const { return m_blockSize; }
+	unsigned int fftSize() const { return m_fftSize; }
+	unsigned int binCount() const { return m_fftSize / 2 + 1; }
+
+private:
+	friend class AnalysisWorker;
+
+	//! Analyses the data written so far, worker thread only
+	void process();
+	void analyseBlock();
+	//! Runs the FFT of the first m_blockSize values of m_fftInput, returns the highest one
+	float transform(std::vector<float>& magnitudes);
+
+	const unsigned int m_blockSize;
+	const unsigned int m_fftSize;
+	const bool m_stereo;
+	std::vector<float> m_window;
+	fftwf_plan m_plan;
+
+	std::atomic<bool> m_active = false;
+	LocklessRingBuffer<SampleFrame> m_input;
+	LocklessRingBufferReader<SampleFrame> m_reader;
+
+	// worker thread state
+	std::vector<SampleFrame> m_block;
+	unsigned int m_framesFilledUp = 0;
+	FftwBuffer<float> m_fftInput;
+	FftwBuffer<fftwf_complex> m_fftOutput;
+	Spectrum m_spectrum;
+
+	std::mutex m_subscriberAccess;
+	std::vector<std::pair<int, Subscriber>> m_subscribers;
+	int m_nextId = 0;
+};
+
+
 } // namespace lmms
 
 #endif // LMMS_FFT_HELPERS_H
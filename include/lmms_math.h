@@ -27,6 +27,7 @@
 
 #include <QtGlobal>
 #include <algorithm>
+#include <bit>
 #include <cassert>
 #include <cmath>
 #include <cstdint>
@@ -35,6 +36,7 @@
 #include <concepts>
 
 #include "lmms_constants.h"
+#include "lmms_export.h"
 
 namespace lmms
 {
@@ -77,9 +79,18 @@ inline auto absFraction(std::floating_point auto x) noexcept
 	return x - std::floor(x);
 }
 
+//! State of fastRand(), of which every thread has its own, seeded differently on every thread
+LMMS_EXPORT unsigned long& fastRandState() noexcept;
+
+//! Restarts the numbers fastRand() returns on the calling thread
+inline void seedFastRand(unsigned long seed) noexcept
+{
+	fastRandState() = seed;
+}
+
 inline auto fastRand() noexcept
 {
-	static unsigned long next = 1;
+	auto& next = fastRandState();
 	next = next * 1103515245 + 12345;
 	return next / 65536 % 32768;
 }
@@ -257,6 +268,58 @@ inline int numDigitsAsInt(float f)
 	return digits;
 }
 
+//! Converts an IEEE 754 half precision float, given by its bits, to a float
+inline float halfToFloat(std::uint16_t half) noexcept
+{
+	constexpr auto shiftedExponent = std::uint32_t{0x7c00} << 13;
+
+	auto bits = static_cast<std::uint32_t>(half & 0x7fff) << 13;
+	const auto exponent = bits & shiftedExponent;
+	bits += (127 - 15) << 23; // rebias the exponent
+
+	if (exponent == shiftedExponent) { bits += (128 - 16) << 23; } // infinity or NaN
+	else if (exponent == 0) // zero or subnormal, renormalize
+	{
+		bits += 1 << 23;
+		bits = std::bit_cast<std::uint32_t>(std::bit_cast<float>(bits) - std::bit_cast<float>(std::uint32_t{113} << 23));
+	}
+
+	bits |= static_cast<std::uint32_t>(half & 0x8000) << 16;
+	return std::bit_cast<float>(bits);
+}
+
+//! Converts a float to the bits of the nearest IEEE 754 half precision float (ties to even)
+inline std::uint16_t floatToHalf(float value) noexcept
+{
+	constexpr auto infinity = std::uint32_t{255} << 23;
+	constexpr auto halfOverflow = std::uint32_t{127 + 16} << 23;
+	constexpr auto denormalMagic = std::uint32_t{((127 - 15) + (23 - 10) + 1) << 23};
+
+	auto bits = std::bit_cast<std::uint32_t>(value);
+	const auto sign = static_cast<std::uint16_t>((bits >> 16) & 0x8000);
+	bits &= 0x7fffffff;
+
+	auto half = std::uint16_t{0};
+	if (bits >= halfOverflow) // too large for a half, or infinity or NaN
+	{
+		half = bits > infinity ? 0x7e00 : 0x7c00;
+	}
+	else if (bits < (std::uint32_t{113} << 23)) // becomes a subnormal or zero
+	{
+		const auto shifted = std::bit_cast<float>(bits) + std::bit_cast<float>(denormalMagic);
+		half = static_cast<std::uint16_t>(std::bit_cast<std::uint32_t>(shifted) - denormalMagic);
+	}
+	else
+	{
+		const auto mantissaOdd = (bits >> 13) & 1;
+		bits += (static_cast<std::uint32_t>(15 - 127) << 23) + 0xfff; // rebias the exponent and round
+		bits += mantissaOdd;
+		half = static_cast<std::uint16_t>(bits >> 13);
+	}
+
+	return half | sign;
+}
+
 template <typename T>
 class LinearMap
 {
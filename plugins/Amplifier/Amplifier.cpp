@@ -58,6 +58,13 @@ AmplifierEffect::AmplifierEffect(Model* parent, const Descriptor::SubPluginFeatu
 
 
 Effect::ProcessStatus AmplifierEffect::processImpl(SampleFrame* buf, const fpp_t frames)
+{
+	processFrames(buf, 0, frames);
+	return ProcessStatus::ContinueIfNotQuiet;
+}
+
+
+void AmplifierEffect::processFrames(SampleFrame* buf, fpp_t start, fpp_t end)
 {
 	const float d = dryLevel();
 	const float w = wetLevel();
@@ -67,7 +74,7 @@ Effect::ProcessStatus AmplifierEffect::processImpl(SampleFrame* buf, const fpp_t
 	const ValueBuffer* leftBuf = m_ampControls.m_leftModel.valueBuffer();
 	const ValueBuffer* rightBuf = m_ampControls.m_rightModel.valueBuffer();
 
-	for (fpp_t f = 0; f < frames; ++f)
+	for (fpp_t f = start; f < end; ++f)
 	{
 		const float volume = (volumeBuf ? volumeBuf->value(f) : m_ampControls.m_volumeModel.value()) * 0.01f;
 		const float pan = (panBuf ? panBuf->value(f) : m_ampControls.m_panModel.value()) * 0.01f;
@@ -84,8 +91,6 @@ Effect::ProcessStatus AmplifierEffect::processImpl(SampleFrame* buf, const fpp_t
 		// Dry/wet mix
 		currentFrame = currentFrame * d + s * w;
 	}
-
-	return ProcessStatus::ContinueIfNotQuiet;
 }
 
 
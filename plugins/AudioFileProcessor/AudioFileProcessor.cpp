@@ -25,6 +25,7 @@
 #include "AudioFileProcessor.h"
 #include "AudioFileProcessorView.h"
 
+#include "DataFile.h"
 #include "InstrumentTrack.h"
 #include "PathUtil.h"
 #include "SampleLoader.h"
@@ -195,7 +196,7 @@ void AudioFileProcessor::deleteNotePluginData( NotePlayHandle * _n )
 void AudioFileProcessor::saveSettings(QDomDocument& doc, QDomElement& elem)
 {
 	elem.setAttribute("src", m_sample.sampleFile());
-	if (m_sample.sampleFile().isEmpty())
+	if (m_sample.sampleFile().isEmpty() && !DataFile::bundleSample(doc, elem, m_sample.buffer()))
 	{
 		elem.setAttribute("sampledata", m_sample.toBase64());
 	}
@@ -317,7 +318,12 @@ void AudioFileProcessor::setAudioFile(const QString& _audio_file, bool _rename)
 	}
 	// else we don't touch the track-name, because the user named it self
 
-	m_sample = Sample(gui::SampleLoader::createBufferFromFile(_audio_file));
+	// like that, large sample libraries don't need to fit into memory
+	const auto decoding = SampleBuffer::streamSamples()
+		? SampleBuffer::Decoding::Streaming
+		: SampleBuffer::Decoding::Blocking;
+
+	m_sample = Sample(gui::SampleLoader::createBufferFromFile(_audio_file, decoding));
 	loopPointChanged();
 	emit sampleUpdated();
 }
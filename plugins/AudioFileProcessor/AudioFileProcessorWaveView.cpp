@@ -31,6 +31,7 @@
 
 #include <QPainter>
 #include <QMouseEvent>
+#include <QTimer>
 
 #include <algorithm>
 
@@ -94,6 +95,11 @@ AudioFileProcessorWaveView::AudioFileProcessorWaveView(QWidget* parent, int w, i
 	m_graph.fill(Qt::transparent);
 	update();
 	updateCursor();
+
+	connect(&m_waveform, &SampleWaveformRenderer::rendered, this, [this] {
+		m_last_from = -1;
+		update();
+	});
 }
 
 void AudioFileProcessorWaveView::isPlaying(f_cnt_t current_frame)
@@ -338,7 +344,6 @@ void AudioFileProcessorWaveView::updateGraph()
 
 	m_graph.fill(Qt::transparent);
 	QPainter p(&m_graph);
-	p.setPen(QColor(255, 255, 255));
 
 	m_sampleThumbnail = SampleThumbnail{*m_sample};
 
@@ -350,7 +355,14 @@ void AudioFileProcessorWaveView::updateGraph()
 		.reversed = m_sample->reversed(),
 	};
 
-	m_sampleThumbnail.visualize(param, p);
+	m_waveform.draw(m_sampleThumbnail, param, QColor(255, 255, 255), p);
+
+	if (m_sampleThumbnail.isIncomplete())
+	{
+		// draw the waveform again once it is available
+		m_last_from = -1;
+		QTimer::singleShot(100, this, &AudioFileProcessorWaveView::update);
+	}
 }
 
 void AudioFileProcessorWaveView::zoom(const bool out)
@@ -28,6 +28,7 @@
 
 #include "Knob.h"
 #include "SampleThumbnail.h"
+#include "SampleWaveformRenderer.h"
 
 
 namespace lmms
@@ -143,6 +144,7 @@ private:
 	f_cnt_t m_framesPlayed;
 	bool m_animation;
 	SampleThumbnail m_sampleThumbnail;
+	SampleWaveformRenderer m_waveform;
 
 	friend class AudioFileProcessorView;
 
@@ -70,6 +70,15 @@ BassBoosterEffect::BassBoosterEffect( Model* parent, const Descriptor::SubPlugin
 
 
 Effect::ProcessStatus BassBoosterEffect::processImpl(SampleFrame* buf, const fpp_t frames)
+{
+	processFrames(buf, 0, frames);
+	return ProcessStatus::ContinueIfNotQuiet;
+}
+
+
+
+
+void BassBoosterEffect::processFrames(SampleFrame* buf, fpp_t start, fpp_t end)
 {
 	// check out changed controls
 	if( m_frequencyChangeNeeded || m_bbControls.m_freqModel.isValueChanged() )
@@ -86,7 +95,7 @@ Effect::ProcessStatus BassBoosterEffect::processImpl(SampleFrame* buf, const fpp
 	const float d = dryLevel();
 	const float w = wetLevel();
 
-	for (fpp_t f = 0; f < frames; ++f)
+	for (fpp_t f = start; f < end; ++f)
 	{
 		auto& currentFrame = buf[f];
 
@@ -98,8 +107,6 @@ Effect::ProcessStatus BassBoosterEffect::processImpl(SampleFrame* buf, const fpp
 		// Dry/wet mix
 		currentFrame = currentFrame * d + s * w;
 	}
-
-	return ProcessStatus::ContinueIfNotQuiet;
 }
 
 
@@ -40,6 +40,12 @@ public:
 	~BassBoosterEffect() override = default;
 
 	ProcessStatus processImpl(SampleFrame* buf, const fpp_t frames) override;
+	void processFrames(SampleFrame* buf, fpp_t start, fpp_t end) override;
+
+	bool isFusible() const override
+	{
+		return true;
+	}
 
 	EffectControls* controls() override
 	{
@@ -70,7 +70,6 @@ Plugin::Descriptor PLUGIN_EXPORT bitinvader_plugin_descriptor =
 
 BSynth::BSynth( float * _shape, NotePlayHandle * _nph, bool _interpolation,
 				float _factor, const sample_rate_t _sample_rate ) :
-	sample_index( 0 ),
 	sample_realindex( 0 ),
 	nph( _nph ),
 	sample_rate( _sample_rate ),
@@ -100,28 +99,31 @@ BSynth::~BSynth()
 }
 
 
-sample_t BSynth::nextStringSample( float sample_length )
+void BSynth::renderOutput( SampleFrame* buf, fpp_t frames, float sample_length )
 {
-	auto sample_step = static_cast<float>(sample_length / (sample_rate / nph->frequency()));
-
-	// check overflow
-	while (sample_realindex >= sample_length) {
-		sample_realindex -= sample_length;
-	}
-
-	const auto currentRealIndex = sample_realindex;
-	const auto currentIndex = static_cast<int>(sample_realindex);
-	sample_realindex += sample_step;
+	// the pitch only changes between periods
+	const auto sample_step = static_cast<float>(sample_length / (sample_rate / nph->frequency()));
 
 	if (!interpolation)
 	{
-		sample_index = currentIndex;
-		return sample_shape[sample_index];
+		for (fpp_t frame = 0; frame < frames; ++frame)
+		{
+			while (sample_realindex >= sample_length) { sample_realindex -= sample_length; }
+			buf[frame] = SampleFrame(sample_shape[static_cast<int>(sample_realindex)]);
+			sample_realindex += sample_step;
+		}
+		return;
 	}
 
-	const auto nextIndex = currentIndex < sample_length - 1 ? currentIndex + 1 : 0;
-	return std::lerp(sample_shape[currentIndex], sample_shape[nextIndex], fraction(currentRealIndex));
-}	
+	for (fpp_t frame = 0; frame < frames; ++frame)
+	{
+		while (sample_realindex >= sample_length) { sample_realindex -= sample_length; }
+		const auto currentIndex = static_cast<int>(sample_realindex);
+		const auto nextIndex = currentIndex < sample_length - 1 ? currentIndex + 1 : 0;
+		buf[frame] = SampleFrame(std::lerp(sample_shape[currentIndex], sample_shape[nextIndex], fraction(sample_realindex)));
+		sample_realindex += sample_step;
+	}
+}
 
 /***********************************************************************
 *
@@ -133,7 +135,7 @@ sample_t BSynth::nextStringSample( float sample_length )
 
 
 BitInvader::BitInvader( InstrumentTrack * _instrument_track ) :
-	Instrument( _instrument_track, &bitinvader_plugin_descriptor ),
+	Instrument(_instrument_track, &bitinvader_plugin_descriptor, nullptr, Flag::BatchesNotes),
 	m_sampleLength(wavetableSize, 4, wavetableSize, 1, this, tr("Sample length")),
 	m_graph(-1.0f, 1.0f, wavetableSize, this),
 	m_interpolation(false, this, tr("Interpolation")),
@@ -271,10 +273,7 @@ void BitInvader::playNote( NotePlayHandle * _n,
 	const f_cnt_t offset = _n->noteOffset();
 
 	auto ps = static_cast<BSynth*>(_n->m_pluginData);
-	for( fpp_t frame = offset; frame < frames + offset; ++frame )
-	{
-		_working_buffer[frame] = SampleFrame(ps->nextStringSample(m_graph.length()));
-	}
+	ps->renderOutput(_working_buffer + offset, frames, m_graph.length());
 
 	applyRelease( _working_buffer, _n );
 }
@@ -53,11 +53,11 @@ public:
 			const sample_rate_t _sample_rate );
 	virtual ~BSynth();
 	
-	sample_t nextStringSample( float sample_length );
+	//! Renders @p frames frames of the wave, @p sample_length samples long, to @p buf
+	void renderOutput( SampleFrame* buf, fpp_t frames, float sample_length );
 
 
 private:
-	int sample_index;
 	float sample_realindex;
 	float* sample_shape;
 	NotePlayHandle* nph;
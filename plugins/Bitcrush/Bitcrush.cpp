@@ -63,7 +63,7 @@ BitcrushEffect::BitcrushEffect( Model * parent, const Descriptor::SubPluginFeatu
 	m_sampleRate( Engine::audioEngine()->outputSampleRate() ),
 	m_filter( m_sampleRate )
 {
-	m_buffer = new SampleFrame[Engine::audioEngine()->framesPerPeriod() * OS_RATE];
+	m_buffer = new SampleFrame[Engine::audioEngine()->maxFramesPerPeriod() * OS_RATE];
 	m_filter.setLowpass( m_sampleRate * ( CUTOFF_RATIO * OS_RATIO ) );
 	m_needsUpdate = true;
 
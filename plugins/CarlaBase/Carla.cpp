@@ -32,6 +32,7 @@
 #include "Knob.h"
 #include "MidiEventToByteSeq.h"
 #include "MainWindow.h"
+#include "MixHelpers.h"
 #include "FontHelper.h"
 #include "Song.h"
 
@@ -155,6 +156,8 @@ CarlaInstrument::CarlaInstrument(InstrumentTrack* const instrumentTrack, const D
       fHandle(nullptr),
       fDescriptor(isPatchbay ? carla_get_native_patchbay_plugin() : carla_get_native_rack_plugin()),
       fMidiEventCount(0),
+      m_scratch(2 * Engine::audioEngine()->maxFramesPerPeriod()),
+      m_silence(Engine::audioEngine()->maxFramesPerPeriod()),
       m_paramModels()
 {
     fHost.handle      = this;
@@ -254,7 +257,7 @@ CarlaInstrument::~CarlaInstrument()
 
 uint32_t CarlaInstrument::handleGetBufferSize() const
 {
-    return Engine::audioEngine()->framesPerPeriod();
+    return Engine::audioEngine()->maxFramesPerPeriod();
 }
 
 double CarlaInstrument::handleGetSampleRate() const
@@ -499,10 +502,9 @@ void CarlaInstrument::play(SampleFrame* workingBuffer)
 {
     const uint bufsize = Engine::audioEngine()->framesPerPeriod();
 
-	zeroSampleFrames(workingBuffer, bufsize);
-
     if (fHandle == nullptr)
     {
+        zeroSampleFrames(workingBuffer, bufsize);
         return;
     }
 
@@ -520,17 +522,10 @@ void CarlaInstrument::play(SampleFrame* workingBuffer)
     fTimeInfo.bbt.ticksPerBeat   = ticksPerBeat;
     fTimeInfo.bbt.beatsPerMinute = s->getTempo();
 
-#ifndef _MSC_VER
-    float buf1[bufsize];
-    float buf2[bufsize];
-#else
-    float *buf1 = static_cast<float *>(_alloca(bufsize * sizeof(float)));
-    float *buf2 = static_cast<float *>(_alloca(bufsize * sizeof(float)));
-#endif
-
-    float* rBuf[] = { buf1, buf2 };
-    std::memset(buf1, 0, sizeof(float)*bufsize);
-    std::memset(buf2, 0, sizeof(float)*bufsize);
+    // Carla writes planar output into the scratch buffer and reads the silence as its input,
+    // which is never written to and doesn't have to be cleared
+    float* inBuf[] = { m_silence.data(), m_silence.data() };
+    float* outBuf[] = { m_scratch.data(), m_scratch.data() + m_silence.size() };
 
     {
         const QMutexLocker ml(&fMutex);
@@ -538,18 +533,14 @@ void CarlaInstrument::play(SampleFrame* workingBuffer)
 // https://github.com/falkTX/Carla/blob/8bceb9ed173a10b29038f8abb4383710c0e497c1/source/includes/CarlaNative.h
 //     FIXME for v3.0, use const for the input buffer
 #if CARLA_VERSION_HEX >= CARLA_VERSION_HEX_3
-        fDescriptor->process(fHandle, (const float**)rBuf, rBuf, bufsize, fMidiEvents, fMidiEventCount);
+        fDescriptor->process(fHandle, (const float**)inBuf, outBuf, bufsize, fMidiEvents, fMidiEventCount);
 #else
-        fDescriptor->process(fHandle, rBuf, rBuf, bufsize, fMidiEvents, fMidiEventCount);
+        fDescriptor->process(fHandle, inBuf, outBuf, bufsize, fMidiEvents, fMidiEventCount);
 #endif
         fMidiEventCount = 0;
     }
 
-    for (uint i=0; i < bufsize; ++i)
-    {
-        workingBuffer[i][0] = buf1[i];
-        workingBuffer[i][1] = buf2[i];
-    }
+    MixHelpers::interleave(workingBuffer, outBuf[0], outBuf[1], bufsize);
 }
 
 bool CarlaInstrument::handleMidiEvent(const MidiEvent& event, const TimePos&, f_cnt_t offset)
@@ -670,6 +661,11 @@ CarlaInstrumentView::~CarlaInstrumentView()
 #endif
 }
 
+bool CarlaInstrumentView::isDisposable() const
+{
+    return !m_toggleUIButton->isChecked() && !(m_paramsSubWindow && m_paramsSubWindow->isVisible());
+}
+
 void CarlaInstrumentView::toggleUI(bool visible)
 {
     if (fHandle != nullptr && fDescriptor->ui_show != nullptr) {
@@ -221,6 +221,10 @@ private:
     NativeMidiEvent fMidiEvents[kMaxMidiEvents];
     NativeTimeInfo  fTimeInfo;
 
+    //! Planar output of Carla, both channels one after another, and its silent input
+    std::vector<float> m_scratch;
+    std::vector<float> m_silence;
+
     // this is only needed because note-offs are being sent during play
     QMutex fMutex;
 
@@ -302,6 +306,9 @@ public:
     CarlaInstrumentView(CarlaInstrument* const instrument, QWidget* const parent);
     ~CarlaInstrumentView() override;
 
+    //! Not while the UI of the plugin or the parameters are shown, as they'd be closed with the view
+    bool isDisposable() const override;
+
 private slots:
     void toggleUI(bool);
     void uiClosed();
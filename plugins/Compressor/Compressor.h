@@ -52,6 +52,12 @@ public:
 		return &m_compressorControls;
 	}
 
+	//! With lookahead, the audio is delayed by the whole lookahead buffer
+	f_cnt_t latency() const override
+	{
+		return m_compressorControls.m_lookaheadModel.value() ? m_lookBufLength : 0;
+	}
+
 private slots:
 	void calcAutoMakeup();
 	void calcAttack();
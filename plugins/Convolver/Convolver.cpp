@@ -0,0 +1,113 @@
+/*
+ * Convolver.cpp - convolution reverb effect
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "Convolver.h"
+
+#include "embed.h"
+#include "lmms_math.h"
+#include "plugin_export.h"
+
+namespace lmms
+{
+
+extern "C"
+{
+
+Plugin::Descriptor PLUGIN_EXPORT convolver_plugin_descriptor =
+{
+	LMMS_STRINGIFY(PLUGIN_NAME),
+	"Convolver",
+	QT_TRANSLATE_NOOP("PluginBrowser", "A reverb convolving the signal with an impulse response"),
+	"LMMS team",
+	0x0100,
+	Plugin::Type::Effect,
+	new PluginPixmapLoader("logo"),
+	nullptr,
+	nullptr,
+} ;
+
+}
+
+
+ConvolverEffect::ConvolverEffect(Model* parent, const Descriptor::SubPluginFeatures::Key* key) :
+	Effect(&convolver_plugin_descriptor, parent, key),
+	m_controls(this),
+	m_wetBuffer(Engine::audioEngine()->maxFramesPerPeriod())
+{
+}
+
+
+Effect::ProcessStatus ConvolverEffect::processImpl(SampleFrame* buf, const fpp_t frames)
+{
+	if (!m_convolver) { return ProcessStatus::ContinueIfNotQuiet; }
+
+	const float d = dryLevel();
+	const float w = wetLevel() * dbfsToAmp(m_controls.m_gainModel.value());
+
+	m_convolver->process(buf, m_wetBuffer.data(), frames);
+	for (fpp_t f = 0; f < frames; ++f)
+	{
+		buf[f] = buf[f] * d + m_wetBuffer[f] * w;
+	}
+
+	return ProcessStatus::ContinueIfNotQuiet;
+}
+
+
+void ConvolverEffect::setImpulseResponse(std::shared_ptr<const ImpulseResponse> response)
+{
+	// set up outside of the lock, the old convolver waits for its background work when destroyed
+	auto convolver = response
+		? std::make_unique<PartitionedConvolver>(std::move(response), Engine::audioEngine()->maxFramesPerPeriod())
+		: nullptr;
+
+	Engine::audioEngine()->requestChangeInModel();
+	std::swap(m_convolver, convolver);
+	Engine::audioEngine()->doneChangeInModel();
+}
+
+
+auto ConvolverEffect::impulseResponse() const -> std::shared_ptr<const ImpulseResponse>
+{
+	return m_convolver ? m_convolver->response() : nullptr;
+}
+
+
+auto ConvolverEffect::memoryUsage() const -> std::size_t
+{
+	const auto response = impulseResponse();
+	return m_wetBuffer.capacity() * sizeof(SampleFrame) + (response ? response->memoryUsage() : 0);
+}
+
+
+extern "C"
+{
+
+// necessary for getting instance out of shared lib
+PLUGIN_EXPORT Plugin* lmms_plugin_main(Model* parent, void* data)
+{
+	return new ConvolverEffect(parent, static_cast<const Plugin::Descriptor::SubPluginFeatures::Key*>(data));
+}
+
+}
+
+} // namespace lmms
@@ -0,0 +1,68 @@
+/*
+ * Convolver.h - convolution reverb effect
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_CONVOLVER_H
+#define LMMS_CONVOLVER_H
+
+#include <memory>
+#include <vector>
+
+#include "ConvolverControls.h"
+#include "Effect.h"
+#include "PartitionedConvolver.h"
+
+namespace lmms
+{
+
+class ConvolverEffect : public Effect
+{
+public:
+	ConvolverEffect(Model* parent, const Descriptor::SubPluginFeatures::Key* key);
+	~ConvolverEffect() override = default;
+
+	ProcessStatus processImpl(SampleFrame* buf, const fpp_t frames) override;
+
+	EffectControls* controls() override
+	{
+		return &m_controls;
+	}
+
+	//! Switches to @p response, no response to only pass the dry signal on
+	void setImpulseResponse(std::shared_ptr<const ImpulseResponse> response);
+
+	auto impulseResponse() const -> std::shared_ptr<const ImpulseResponse>;
+
+	//! Includes the impulse response, which is shared by all convolvers using it
+	auto memoryUsage() const -> std::size_t override;
+
+private:
+	ConvolverControls m_controls;
+
+	std::unique_ptr<PartitionedConvolver> m_convolver;
+	std::vector<SampleFrame> m_wetBuffer;
+
+	friend class ConvolverControls;
+};
+
+} // namespace lmms
+
+#endif // LMMS_CONVOLVER_H
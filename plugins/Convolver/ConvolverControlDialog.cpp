@@ -0,0 +1,75 @@
+/*
+ * ConvolverControlDialog.cpp - control dialog for the convolution reverb
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "ConvolverControlDialog.h"
+
+#include <QFileInfo>
+#include <QGridLayout>
+#include <QLabel>
+#include <QPushButton>
+
+#include "ConvolverControls.h"
+#include "Knob.h"
+#include "PathUtil.h"
+#include "SampleLoader.h"
+
+namespace lmms::gui
+{
+
+ConvolverControlDialog::ConvolverControlDialog(ConvolverControls* controls) :
+	EffectControlDialog(controls),
+	m_controls(controls),
+	m_fileLabel(new QLabel(this))
+{
+	auto gridLayout = new QGridLayout(this);
+
+	auto openButton = new QPushButton(tr("Open impulse response"), this);
+	connect(openButton, &QPushButton::clicked, this, &ConvolverControlDialog::openImpulseResponse);
+
+	auto gainKnob = new Knob(KnobType::Bright26, tr("GAIN"), this);
+	gainKnob->setModel(&controls->m_gainModel);
+	gainKnob->setHintText(tr("Wet gain:"), " dB");
+
+	gridLayout->addWidget(openButton, 0, 0);
+	gridLayout->addWidget(m_fileLabel, 1, 0);
+	gridLayout->addWidget(gainKnob, 0, 1, 2, 1, Qt::AlignHCenter);
+
+	connect(controls, &ConvolverControls::impulseResponseChanged, this, &ConvolverControlDialog::updateFileName);
+	updateFileName();
+}
+
+
+void ConvolverControlDialog::openImpulseResponse()
+{
+	const auto file = SampleLoader::openAudioFile(PathUtil::toAbsolute(m_controls->impulseResponseFile()));
+	if (!file.isEmpty()) { m_controls->loadImpulseResponse(PathUtil::toShortestRelative(file)); }
+}
+
+
+void ConvolverControlDialog::updateFileName()
+{
+	const auto& file = m_controls->impulseResponseFile();
+	m_fileLabel->setText(file.isEmpty() ? tr("No impulse response") : QFileInfo{file}.fileName());
+	m_fileLabel->setToolTip(file);
+}
+
+} // namespace lmms::gui
@@ -0,0 +1,76 @@
+/*
+ * ConvolverControls.cpp - controls for the convolution reverb
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "ConvolverControls.h"
+
+#include <QDomElement>
+
+#include "Convolver.h"
+#include "PathUtil.h"
+
+namespace lmms
+{
+
+ConvolverControls::ConvolverControls(ConvolverEffect* effect) :
+	EffectControls(effect),
+	m_effect(effect),
+	m_gainModel(0.0f, -24.0f, 24.0f, 0.1f, this, tr("Wet gain"))
+{
+	connect(Engine::audioEngine(), &AudioEngine::sampleRateChanged, this, &ConvolverControls::changeSampleRate);
+}
+
+
+void ConvolverControls::loadImpulseResponse(const QString& file)
+{
+	auto response = file.isEmpty()
+		? nullptr
+		: ImpulseResponse::load(PathUtil::toAbsolute(file), Engine::audioEngine()->maxFramesPerPeriod());
+
+	// keep the previous response if the file can't be loaded
+	if (!file.isEmpty() && !response) { return; }
+
+	m_file = file;
+	m_effect->setImpulseResponse(std::move(response));
+	emit impulseResponseChanged();
+}
+
+
+void ConvolverControls::changeSampleRate()
+{
+	loadImpulseResponse(m_file);
+}
+
+
+void ConvolverControls::loadSettings(const QDomElement& parent)
+{
+	m_gainModel.loadSettings(parent, "gain");
+	loadImpulseResponse(parent.attribute("ir"));
+}
+
+
+void ConvolverControls::saveSettings(QDomDocument& doc, QDomElement& parent)
+{
+	m_gainModel.saveSettings(doc, parent, "gain");
+	parent.setAttribute("ir", PathUtil::toShortestRelative(m_file));
+}
+
+} // namespace lmms
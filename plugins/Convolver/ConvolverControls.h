@@ -0,0 +1,75 @@
+/*
+ * ConvolverControls.h - controls for the convolution reverb
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_CONVOLVER_CONTROLS_H
+#define LMMS_CONVOLVER_CONTROLS_H
+
+#include "ConvolverControlDialog.h"
+#include "EffectControls.h"
+
+namespace lmms
+{
+
+class ConvolverEffect;
+
+class ConvolverControls : public EffectControls
+{
+	Q_OBJECT
+public:
+	ConvolverControls(ConvolverEffect* effect);
+	~ConvolverControls() override = default;
+
+	void saveSettings(QDomDocument& doc, QDomElement& parent) override;
+	void loadSettings(const QDomElement& parent) override;
+	inline QString nodeName() const override
+	{
+		return "ConvolverControls";
+	}
+	gui::EffectControlDialog* createView() override
+	{
+		return new gui::ConvolverControlDialog(this);
+	}
+	int controlCount() override { return 1; }
+
+	auto impulseResponseFile() const -> const QString& { return m_file; }
+
+	//! Loads the impulse response in @p file, an empty file to remove it
+	void loadImpulseResponse(const QString& file);
+
+signals:
+	void impulseResponseChanged();
+
+private slots:
+	void changeSampleRate();
+
+private:
+	ConvolverEffect* m_effect;
+	FloatModel m_gainModel;
+	QString m_file;
+
+	friend class gui::ConvolverControlDialog;
+	friend class ConvolverEffect;
+};
+
+} // namespace lmms
+
+#endif // LMMS_CONVOLVER_CONTROLS_H
@@ -0,0 +1,213 @@
+/*
+ * PartitionedConvolver.cpp - convolves a signal with an impulse response in partitions
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "PartitionedConvolver.h"
+
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+#include "AudioEngine.h"
+#include "AudioResampler.h"
+#include "Engine.h"
+#include "SampleCache.h"
+#include "SampleFrame.h"
+#include "ThreadPool.h"
+
+namespace lmms
+{
+
+namespace
+{
+
+template<typename T>
+auto allocate(std::size_t count) -> FftwBuffer<T>
+{
+	auto data = static_cast<T*>(fftwf_malloc(sizeof(T) * count));
+	if (!data) { throw std::bad_alloc{}; }
+	std::memset(data, 0, sizeof(T) * count);
+	return FftwBuffer<T>{data};
+}
+
+//! The frames of @p file at the sample rate of the engine
+auto readFrames(const QString& file) -> std::vector<SampleFrame>
+{
+	const auto buffer = SampleCache::get(file);
+	buffer->waitUntilDecoded();
+	auto frames = std::vector<SampleFrame>(buffer->size());
+	buffer->read(0, frames.size(), frames.data());
+
+	const auto sampleRate = Engine::audioEngine()->outputSampleRate();
+	if (frames.empty() || buffer->sampleRate() == sampleRate) { return frames; }
+
+	// pad the input so the resampler puts out the end of the response as well
+	const auto ratio = static_cast<double>(sampleRate) / buffer->sampleRate();
+	frames.resize(frames.size() + 256);
+	auto resampled = std::vector<SampleFrame>(static_cast<std::size_t>(std::ceil(frames.size() * ratio)));
+	auto resampler = AudioResampler{SRC_SINC_MEDIUM_QUALITY, DEFAULT_CHANNELS};
+	const auto result = resampler.resample(&frames[0][0], static_cast<long>(frames.size()),
+		&resampled[0][0], static_cast<long>(resampled.size()), ratio);
+	resampled.resize(result.outputFramesGenerated);
+	return resampled;
+}
+
+} // namespace
+
+auto ImpulseResponse::load(const QString& file, fpp_t periodSize) -> std::shared_ptr<const ImpulseResponse>
+{
+	using Key = std::tuple<QString, fpp_t, sample_rate_t>;
+	static auto s_mutex = std::mutex{};
+	static auto s_responses = std::map<Key, std::weak_ptr<const ImpulseResponse>>{};
+
+	const auto key = Key{file, periodSize, Engine::audioEngine()->outputSampleRate()};
+	const auto lock = std::lock_guard{s_mutex};
+	if (auto response = s_responses[key].lock()) { return response; }
+
+	auto frames = std::vector<SampleFrame>{};
+	try
+	{
+		frames = readFrames(file);
+	}
+	catch (const std::runtime_error& error)
+	{
+		qWarning() << "Convolver: can't load impulse response" << file << "-" << error.what();
+		return nullptr;
+	}
+	if (frames.empty()) { return nullptr; }
+
+	// normalized to unit energy in the louder channel, so noise passes at about the same level
+	auto energy = SampleFrame{};
+	for (const auto& frame : frames) { energy += frame * frame; }
+	const auto maxEnergy = std::max(energy[0], energy[1]);
+	const auto scale = maxEnergy > 0.f ? 1.f / std::sqrt(maxEnergy) : 0.f;
+
+	auto response = std::shared_ptr<ImpulseResponse>{new ImpulseResponse{}};
+	response->m_file = file;
+	response->m_frames = frames.size();
+
+	const auto tailSize = periodSize * TailPeriods;
+	const auto headFrames = std::min(frames.size(), 2 * tailSize);
+	for (int ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+	{
+		auto samples = std::vector<float>(frames.size());
+		std::transform(frames.begin(), frames.end(), samples.begin(),
+			[ch, scale](const SampleFrame& frame) { return frame[ch] * scale; });
+
+		response->m_tail[ch] = PartitionedResponse::partition(samples.data() + headFrames, samples.size() - headFrames, tailSize);
+		response->m_head[ch] = PartitionedResponse::partition(samples.data(), headFrames, periodSize);
+	}
+
+	s_responses[key] = response;
+	return response;
+}
+
+
+
+
+PartitionedConvolver::PartitionedConvolver(std::shared_ptr<const ImpulseResponse> response, fpp_t periodSize)
+	: m_response(std::move(response))
+	, m_periodSize(periodSize)
+	, m_tailSize(periodSize * ImpulseResponse::TailPeriods)
+{
+	Engine::audioEngine()->holdFramesPerPeriod();
+
+	for (int ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+	{
+		m_in[ch] = allocate<float>(m_periodSize);
+		m_out[ch] = allocate<float>(m_periodSize);
+		if (m_response->head(ch).partitions > 0) { m_head[ch] = std::make_unique<UniformConvolver>(m_periodSize, m_response->head(ch).partitions); }
+		if (m_response->tail(ch).partitions > 0)
+		{
+			m_tail[ch] = std::make_unique<UniformConvolver>(m_tailSize, m_response->tail(ch).partitions);
+			m_tailInput[ch] = allocate<float>(m_tailSize);
+			m_tailJobInput[ch] = allocate<float>(m_tailSize);
+			m_tailOutput[0][ch] = allocate<float>(m_tailSize);
+			m_tailOutput[1][ch] = allocate<float>(m_tailSize);
+		}
+	}
+}
+
+PartitionedConvolver::~PartitionedConvolver()
+{
+	if (m_tailJob.valid()) { m_tailJob.wait(); }
+	Engine::audioEngine()->releaseFramesPerPeriod();
+}
+
+void PartitionedConvolver::process(const SampleFrame* in, SampleFrame* out, fpp_t frames)
+{
+	if (static_cast<std::size_t>(frames) != m_periodSize)
+	{
+		std::fill_n(out, frames, SampleFrame{});
+		return;
+	}
+
+	for (int ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+	{
+		float* x = m_in[ch].get();
+		float* y = m_out[ch].get();
+		for (std::size_t f = 0; f < m_periodSize; ++f) { x[f] = in[f][ch]; }
+
+		if (m_head[ch]) { m_head[ch]->process(x, m_response->head(ch), y); }
+		else { std::fill_n(y, m_periodSize, 0.f); }
+
+		if (m_tail[ch])
+		{
+			std::copy(x, x + m_periodSize, m_tailInput[ch].get() + m_tailPosition);
+			const float* tail = m_tailOutput[m_playedOutput][ch].get() + m_tailPosition;
+			for (std::size_t f = 0; f < m_periodSize; ++f) { y[f] += tail[f]; }
+		}
+
+		for (std::size_t f = 0; f < m_periodSize; ++f) { out[f][ch] = y[f]; }
+	}
+
+	// both channels of a response are equally long
+	if (!m_tail[0]) { return; }
+
+	m_tailPosition += m_periodSize;
+	if (m_tailPosition < m_tailSize) { return; }
+	m_tailPosition = 0;
+
+	// the output of the last block is played from now on, it usually finished long ago
+	if (m_tailJob.valid()) { m_tailJob.wait(); }
+	m_playedOutput = 1 - m_playedOutput;
+
+	std::swap(m_tailInput, m_tailJobInput);
+	const int output = 1 - m_playedOutput;
+	m_tailJob = ThreadPool::instance().enqueue([this, output] { convolveTail(output); });
+}
+
+void PartitionedConvolver::convolveTail(int output)
+{
+	for (int ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+	{
+		if (m_tail[ch]) { m_tail[ch]->process(m_tailJobInput[ch].get(), m_response->tail(ch), m_tailOutput[output][ch].get()); }
+	}
+}
+
+} // namespace lmms
@@ -0,0 +1,130 @@
+/*
+ * PartitionedConvolver.h - convolves a signal with an impulse response in partitions
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_PARTITIONED_CONVOLVER_H
+#define LMMS_PARTITIONED_CONVOLVER_H
+
+#include <QString>
+#include <array>
+#include <cstddef>
+#include <future>
+#include <memory>
+
+#include "LmmsTypes.h"
+#include "PartitionedConvolution.h"
+
+namespace lmms
+{
+
+class SampleFrame;
+
+/**
+ * A stereo impulse response, split into the partitions convolved by
+ * PartitionedConvolver: the head in blocks of the period size, the tail from
+ * twice the tail block size on in blocks of the tail block size.
+ *
+ * Impulse responses are loaded once for every file, period size and sample
+ * rate, and shared by all convolvers using them.
+ */
+class ImpulseResponse
+{
+public:
+	//! Returns the impulse response of @p file for periods of @p periodSize frames at the sample
+	//! rate of the engine, or nullptr if the file can't be loaded
+	static auto load(const QString& file, fpp_t periodSize) -> std::shared_ptr<const ImpulseResponse>;
+
+	//! Blocks of the tail are this many periods long
+	static constexpr std::size_t TailPeriods = 8;
+
+	auto file() const -> const QString& { return m_file; }
+	auto frames() const -> std::size_t { return m_frames; }
+	auto head(int channel) const -> const PartitionedResponse& { return m_head[channel]; }
+	auto tail(int channel) const -> const PartitionedResponse& { return m_tail[channel]; }
+
+	auto memoryUsage() const -> std::size_t
+	{
+		return m_head[0].memoryUsage() + m_head[1].memoryUsage() + m_tail[0].memoryUsage() + m_tail[1].memoryUsage();
+	}
+
+private:
+	ImpulseResponse() = default;
+
+	QString m_file;
+	std::size_t m_frames = 0;
+	std::array<PartitionedResponse, 2> m_head;
+	std::array<PartitionedResponse, 2> m_tail;
+};
+
+/**
+ * Convolves a stereo signal with an ImpulseResponse without adding latency.
+ *
+ * The head of the response is convolved on the audio thread period by period.
+ * The tail is convolved in longer blocks on the threads of the ThreadPool:
+ * since it starts two tail blocks into the response, a block of input only
+ * affects the output a tail block after it is complete, which leaves that long
+ * to convolve it in the background.
+ *
+ * The convolver holds the period size of the engine while it exists, as the
+ * partitions are bound to it. Responses have to be loaded for
+ * AudioEngine::maxFramesPerPeriod().
+ */
+class PartitionedConvolver
+{
+public:
+	PartitionedConvolver(std::shared_ptr<const ImpulseResponse> response, fpp_t periodSize);
+	~PartitionedConvolver();
+
+	PartitionedConvolver(const PartitionedConvolver&) = delete;
+	auto operator=(const PartitionedConvolver&) -> PartitionedConvolver& = delete;
+
+	auto response() const -> const std::shared_ptr<const ImpulseResponse>& { return m_response; }
+
+	//! Writes the convolution of the @p frames frames of @p in to @p out, @p frames must be the period size
+	void process(const SampleFrame* in, SampleFrame* out, fpp_t frames);
+
+private:
+	//! Convolves the last complete tail block into m_tailOutput[@p output]
+	void convolveTail(int output);
+
+	std::shared_ptr<const ImpulseResponse> m_response;
+	std::size_t m_periodSize;
+	std::size_t m_tailSize;
+
+	std::array<std::unique_ptr<UniformConvolver>, 2> m_head;
+	std::array<std::unique_ptr<UniformConvolver>, 2> m_tail;
+
+	std::array<FftwBuffer<float>, 2> m_in;
+	std::array<FftwBuffer<float>, 2> m_out;
+
+	// the tail block being filled and the one being convolved, per channel
+	std::array<FftwBuffer<float>, 2> m_tailInput;
+	std::array<FftwBuffer<float>, 2> m_tailJobInput;
+	//! The output of the tail block being convolved and of the one being played
+	std::array<std::array<FftwBuffer<float>, 2>, 2> m_tailOutput;
+	int m_playedOutput = 0;
+	std::size_t m_tailPosition = 0;
+	std::future<void> m_tailJob;
+};
+
+} // namespace lmms
+
+#endif // LMMS_PARTITIONED_CONVOLVER_H
@@ -29,6 +29,9 @@
 #include "embed.h"
 #include "plugin_export.h"
 
+#include <cmath>
+#include <numbers>
+
 namespace lmms
 {
 
@@ -64,9 +67,9 @@ CrossoverEQEffect::CrossoverEQEffect( Model* parent, const Descriptor::SubPlugin
 	m_hp4( m_sampleRate ),
 	m_needsUpdate( true )
 {
-	m_tmp2 = new SampleFrame[Engine::audioEngine()->framesPerPeriod()];
-	m_tmp1 = new SampleFrame[Engine::audioEngine()->framesPerPeriod()];
-	m_work = new SampleFrame[Engine::audioEngine()->framesPerPeriod()];
+	m_tmp2 = new SampleFrame[Engine::audioEngine()->maxFramesPerPeriod()];
+	m_tmp1 = new SampleFrame[Engine::audioEngine()->maxFramesPerPeriod()];
+	m_work = new SampleFrame[Engine::audioEngine()->maxFramesPerPeriod()];
 }
 
 CrossoverEQEffect::~CrossoverEQEffect()
@@ -86,6 +89,7 @@ void CrossoverEQEffect::sampleRateChanged()
 	m_hp3.setSampleRate( m_sampleRate );
 	m_hp4.setSampleRate( m_sampleRate );
 	m_needsUpdate = true;
+	updateLinearPhaseFilter();
 }
 
 
@@ -134,6 +138,16 @@ Effect::ProcessStatus CrossoverEQEffect::processImpl(SampleFrame* buf, const fpp
 	
 	m_needsUpdate = false;
 	
+	const float d = dryLevel();
+	const float w = wetLevel();
+
+	if( m_linearPhase )
+	{
+		designLinearPhase( d, w );
+		m_linearPhase->process( buf, frames );
+		return ProcessStatus::ContinueIfNotQuiet;
+	}
+	
 	zeroSampleFrames(m_work, frames);
 	
 	// run temp bands
@@ -185,9 +199,6 @@ Effect::ProcessStatus CrossoverEQEffect::processImpl(SampleFrame* buf, const fpp
 		}
 	}
 	
-	const float d = dryLevel();
-	const float w = wetLevel();
-
 	for (auto f = std::size_t{0}; f < frames; ++f)
 	{
 		buf[f][0] = d * buf[f][0] + w * m_work[f][0];
@@ -197,6 +208,55 @@ Effect::ProcessStatus CrossoverEQEffect::processImpl(SampleFrame* buf, const fpp
 	return ProcessStatus::ContinueIfNotQuiet;
 }
 
+void CrossoverEQEffect::updateLinearPhaseFilter()
+{
+	// set up outside of the lock, the old filter waits for its design when destroyed
+	const auto sampleRate = Engine::audioEngine()->outputSampleRate();
+	auto filter = m_controls.m_linearPhase.value()
+		? std::make_unique<LinearPhaseFilter>(LinearPhaseFilter::lengthFor(sampleRate), sampleRate)
+		: nullptr;
+
+	Engine::audioEngine()->requestChangeInModel();
+	std::swap(m_linearPhase, filter);
+	m_linearPhaseState.reset();
+	Engine::audioEngine()->doneChangeInModel();
+}
+
+void CrossoverEQEffect::designLinearPhase(float dry, float wet)
+{
+	const std::array<float, 3> xovers = {m_controls.m_xover12.value(), m_controls.m_xover23.value(), m_controls.m_xover34.value()};
+	const std::array<float, 4> gains = {
+		m_controls.m_mute1.value() ? m_gain1 : 0.f,
+		m_controls.m_mute2.value() ? m_gain2 : 0.f,
+		m_controls.m_mute3.value() ? m_gain3 : 0.f,
+		m_controls.m_mute4.value() ? m_gain4 : 0.f
+	};
+
+	const auto state = std::array{xovers[0], xovers[1], xovers[2], gains[0], gains[1], gains[2], gains[3], dry, wet};
+	if (m_linearPhaseState == state) { return; }
+	m_linearPhaseState = state;
+
+	m_linearPhase->setMagnitude([xovers, gains, dry, wet, sampleRate = m_sampleRate](float freq)
+	{
+		using std::numbers::pi;
+		// magnitude of the Linkwitz-Riley lowpass, warped like the filters by the bilinear transform;
+		// the highpass is its complement, so the bands sum up to a flat response
+		const auto lowpass = [&](float xover)
+		{
+			const auto ratio = std::tan(pi * freq / sampleRate) / std::tan(pi * xover / sampleRate);
+			return static_cast<float>(1 / (1 + ratio * ratio * ratio * ratio));
+		};
+		const float low12 = lowpass(xovers[0]);
+		const float low23 = lowpass(xovers[1]);
+		const float low34 = lowpass(xovers[2]);
+
+		// the same splits as when filtering sample by sample
+		const float bands = low23 * (gains[0] * low12 + gains[1] * (1 - low12))
+			+ (1 - low23) * (gains[2] * low34 + gains[3] * (1 - low34));
+		return dry + wet * bands;
+	});
+}
+
 void CrossoverEQEffect::clearFilterHistories()
 {
 	m_lp1.clearHistory();
@@ -30,6 +30,11 @@
 #include "Effect.h"
 #include "CrossoverEQControls.h"
 #include "BasicFilters.h"
+#include "LinearPhaseFilter.h"
+
+#include <array>
+#include <memory>
+#include <optional>
 
 namespace lmms
 {
@@ -48,7 +53,14 @@ public:
 		return &m_controls;
 	}
 
+	f_cnt_t latency() const override
+	{
+		return m_linearPhase ? m_linearPhase->latency() : 0;
+	}
+
 	void clearFilterHistories();
+	//! Sets up or removes the linear phase filter, depending on the controls
+	void updateLinearPhaseFilter();
 	
 private:
 	CrossoverEQControls m_controls;
@@ -76,6 +88,13 @@ private:
 	
 	bool m_needsUpdate;
 	
+	//! Replaces the crossover while linear phase is on
+	std::unique_ptr<LinearPhaseFilter> m_linearPhase;
+	//! The parameters the linear phase filter was last designed for
+	std::optional<std::array<float, 9>> m_linearPhaseState;
+	
+	void designLinearPhase(float dry, float wet);
+	
 	friend class CrossoverEQControls;
 };
 
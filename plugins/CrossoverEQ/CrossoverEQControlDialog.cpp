@@ -32,6 +32,7 @@
 #include "FontHelper.h"
 #include "Knob.h"
 #include "Fader.h"
+#include "LedCheckBox.h"
 
 #include <QHBoxLayout>
 #include <QVBoxLayout>
@@ -107,6 +108,11 @@ CrossoverEQControlDialog::CrossoverEQControlDialog(CrossoverEQControls *controls
 	makeMuteBtn(&controls->m_mute2, tr("Mute band 2"), 1);
 	makeMuteBtn(&controls->m_mute3, tr("Mute band 3"), 2);
 	makeMuteBtn(&controls->m_mute4, tr("Mute band 4"), 3);
+
+	auto linearPhase = new LedCheckBox(tr("Linear phase"), this);
+	linearPhase->setModel(&controls->m_linearPhase);
+	linearPhase->setToolTip(tr("Split the bands without phase shifts, delaying the signal by about a tenth of a second"));
+	layout->addWidget(linearPhase, 0, Qt::AlignHCenter);
 }
 
 
@@ -44,12 +44,16 @@ CrossoverEQControls::CrossoverEQControls( CrossoverEQEffect * eff ) :
 	m_mute1( true, this, "Mute Band 1" ),
 	m_mute2( true, this, "Mute Band 2" ),
 	m_mute3( true, this, "Mute Band 3" ),
-	m_mute4( true, this, "Mute Band 4" )
+	m_mute4( true, this, "Mute Band 4" ),
+	m_linearPhase( false, this, "Linear Phase" )
 {
 	connect( Engine::audioEngine(), SIGNAL( sampleRateChanged() ), this, SLOT( sampleRateChanged() ) );
 	connect( &m_xover12, SIGNAL( dataChanged() ), this, SLOT( xover12Changed() ) );
 	connect( &m_xover23, SIGNAL( dataChanged() ), this, SLOT( xover23Changed() ) );
 	connect( &m_xover34, SIGNAL( dataChanged() ), this, SLOT( xover34Changed() ) );
+	// queued, so the filter is also replaced on this thread when automated
+	connect( &m_linearPhase, &BoolModel::dataChanged, this,
+		[this] { m_effect->updateLinearPhaseFilter(); }, Qt::QueuedConnection );
 	
 	m_xover12.setScaleLogarithmic( true );
 	m_xover23.setScaleLogarithmic( true );
@@ -71,6 +75,8 @@ void CrossoverEQControls::saveSettings( QDomDocument & doc, QDomElement & elem )
 	m_mute2.saveSettings( doc, elem, "mute2" );
 	m_mute3.saveSettings( doc, elem, "mute3" );
 	m_mute4.saveSettings( doc, elem, "mute4" );
+	
+	m_linearPhase.saveSettings( doc, elem, "linearphase" );
 }
 
 void CrossoverEQControls::loadSettings( const QDomElement & elem )
@@ -89,6 +95,8 @@ void CrossoverEQControls::loadSettings( const QDomElement & elem )
 	m_mute3.loadSettings( elem, "mute3" );
 	m_mute4.loadSettings( elem, "mute4" );
 	
+	m_linearPhase.loadSettings( elem, "linearphase" );
+	
 	m_effect->m_needsUpdate = true;
 	m_effect->clearFilterHistories();
 }
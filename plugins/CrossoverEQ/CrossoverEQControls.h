@@ -51,7 +51,7 @@ public:
 
 	int controlCount() override
 	{
-		return( 11 );
+		return( 12 );
 	}
 
 	gui::EffectControlDialog * createView() override
@@ -82,6 +82,8 @@ private:
 	BoolModel m_mute3;
 	BoolModel m_mute4;
 	
+	BoolModel m_linearPhase;
+	
 	friend class gui::CrossoverEQControlDialog;
 	friend class CrossoverEQEffect;
 };
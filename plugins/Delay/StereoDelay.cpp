@@ -24,20 +24,14 @@
 
 #include "StereoDelay.h"
 
-#include "SampleFrame.h"
-
 namespace lmms
 {
 
 
 StereoDelay::StereoDelay( int maxTime, int sampleRate )
 {
-	m_buffer = 0;
 	m_maxTime = static_cast<float>(maxTime);
-	m_maxLength = maxTime * sampleRate;
-	m_length = static_cast<float>(m_maxLength);
-
-	m_writeIndex = 0;
+	m_length = static_cast<float>(maxTime * sampleRate);
 	m_feedback = 0.0f;
 	setSampleRate( sampleRate );
 }
@@ -45,49 +39,11 @@ StereoDelay::StereoDelay( int maxTime, int sampleRate )
 
 
 
-StereoDelay::~StereoDelay()
-{
-	if( m_buffer )
-	{
-		delete[] m_buffer;
-	}
-}
-
-
-
-
-void StereoDelay::tick( SampleFrame& frame )
-{
-	m_writeIndex = ( m_writeIndex + 1 ) % ( int )m_maxLength;
-	int readIndex = m_writeIndex - static_cast<int>(m_length);
-	if (readIndex < 0 ) { readIndex += m_maxLength; }
-	float lOut = m_buffer[ readIndex ][ 0 ];
-	float rOut = m_buffer[ readIndex ] [1 ];
-	m_buffer[ m_writeIndex ][ 0 ] = frame[ 0 ] + ( lOut * m_feedback );
-	m_buffer[ m_writeIndex ][ 1 ] = frame[ 1 ] + ( rOut * m_feedback );
-	frame[ 0 ] = lOut;
-	frame[ 1 ] = rOut;
-}
-
-
-
-
-
-
 void StereoDelay::setSampleRate( int sampleRate )
 {
-	if( m_buffer )
-	{
-		delete[] m_buffer;
-	}
-
-	int bufferSize = ( int )( sampleRate * m_maxTime );
-	m_buffer = new SampleFrame[bufferSize];
-	for( int i = 0 ; i < bufferSize ; i++)
-	{
-		m_buffer[i][0] = 0.0;
-		m_buffer[i][1] = 0.0;
-	}
+	m_maxLength = static_cast<int>(sampleRate * m_maxTime);
+	m_length = std::min(m_length, static_cast<float>(m_maxLength));
+	m_delay.setMaxDelay(m_maxLength);
 }
 
 
@@ -25,23 +25,24 @@
 #ifndef STEREODELAY_H
 #define STEREODELAY_H
 
+#include <algorithm>
 
+#include "Delay.h"
+#include "SampleFrame.h"
 
 namespace lmms
 {
 
-class SampleFrame;
 
 class StereoDelay
 {
 public:
 	StereoDelay( int maxLength, int sampleRate );
-	~StereoDelay();
 	inline void setLength( float length )
 	{
 		if( length <= m_maxLength && length >= 0 )
 		{
-			m_length = length;
+			m_length = std::max(length, 1.0f);
 		}
 	}
 
@@ -50,14 +51,20 @@ public:
 		m_feedback = feedback;
 	}
 
-	void tick( SampleFrame& frame );
+	inline void tick( SampleFrame& frame )
+	{
+		const auto out = m_delay.read(m_length);
+		m_delay.write({frame[0] + out[0] * m_feedback, frame[1] + out[1] * m_feedback});
+		frame[0] = out[0];
+		frame[1] = out[1];
+	}
+
 	void setSampleRate( int sampleRate );
 
 private:
-	SampleFrame* m_buffer;
+	DelayLine<2> m_delay;
 	int m_maxLength;
 	float m_length;
-	int m_writeIndex;
 	float m_feedback;
 	float m_maxTime;
 };
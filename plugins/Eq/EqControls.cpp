@@ -25,6 +25,8 @@
 #include "EqControls.h"
 
 
+#include "AudioEngine.h"
+#include "Engine.h"
 #include "EqControlsDialog.h"
 #include "EqEffect.h"
 
@@ -77,7 +79,8 @@ EqControls::EqControls( EqEffect *effect ) :
 	m_lpTypeModel( 0,0,2, this, tr( "Low-pass type" ) ) ,
 	m_hpTypeModel( 0,0,2, this, tr( "High-pass type" ) ),
 	m_analyseInModel( true, this , tr( "Analyse IN" ) ),
-	m_analyseOutModel( true, this, tr( "Analyse OUT" ) )
+	m_analyseOutModel( true, this, tr( "Analyse OUT" ) ),
+	m_linearPhaseModel( false, this, tr( "Linear phase" ) )
 {
 	m_hpFeqModel.setScaleLogarithmic( true );
 	m_lowShelfFreqModel.setScaleLogarithmic( true );
@@ -100,6 +103,12 @@ EqControls::EqControls( EqEffect *effect ) :
 	m_highShelfPeakL = 0; m_highShelfPeakR = 0;
 	m_inProgress = false;
 	m_inGainModel.setScaleLogarithmic( true );
+
+	// queued, so the filter is also replaced on this thread when automated
+	connect( &m_linearPhaseModel, &BoolModel::dataChanged, this,
+		[this] { m_effect->updateLinearPhaseFilter(); }, Qt::QueuedConnection );
+	connect( Engine::audioEngine(), &AudioEngine::sampleRateChanged, this,
+		[this] { m_effect->updateLinearPhaseFilter(); } );
 }
 
 
@@ -149,6 +158,7 @@ void EqControls::loadSettings( const QDomElement &_this )
 	m_hpTypeModel.loadSettings( _this, "HP" );
 	m_analyseInModel.loadSettings( _this, "AnalyseIn" );
 	m_analyseOutModel.loadSettings( _this, "AnalyseOut" );
+	m_linearPhaseModel.loadSettings( _this, "LinearPhase" );
 }
 
 gui::EffectControlDialog* EqControls::createView()
@@ -203,6 +213,7 @@ void EqControls::saveSettings( QDomDocument &doc, QDomElement &parent )
 	m_hpTypeModel.saveSettings( doc, parent, "HP" );
 	m_analyseInModel.saveSettings( doc, parent, "AnalyseIn" );
 	m_analyseOutModel.saveSettings( doc, parent, "AnalyseOut" );
+	m_linearPhaseModel.saveSettings( doc, parent, "LinearPhase" );
 }
 
 
@@ -57,7 +57,7 @@ public:
 
 	int controlCount() override
 	{
-		return 42;
+		return 43;
 	}
 
 	gui::EffectControlDialog* createView() override;
@@ -134,6 +134,8 @@ private:
 	BoolModel m_analyseInModel;
 	BoolModel m_analyseOutModel;
 
+	BoolModel m_linearPhaseModel;
+
 	friend class gui::EqControlsDialog;
 	friend class EqEffect;
 };
@@ -151,6 +151,11 @@ EqControlsDialog::EqControlsDialog( EqControls *controls ) :
 	outSpecButton->setModel( &controls->m_analyseOutModel );
 	outSpecButton->move( 302, 240 );
 
+	auto linearPhaseButton = new LedCheckBox( tr( "Linear phase" ), this );
+	linearPhaseButton->setModel( &controls->m_linearPhaseModel );
+	linearPhaseButton->setToolTip( tr( "Filter without phase shifts, delaying the signal by about a tenth of a second" ) );
+	linearPhaseButton->move( 390, 240 );
+
 	//hp filter type
 	auto hp12Button = new PixmapButton(this, nullptr);
 	hp12Button->setModel( m_parameterWidget->getBandModels( 0 )->hp12 );
@@ -27,6 +27,9 @@
 #include "Engine.h"
 #include "lmms_math.h"
 
+#include <numbers>
+#include <vector>
+
 #include "embed.h"
 #include "plugin_export.h"
 
@@ -165,95 +168,103 @@ Effect::ProcessStatus EqEffect::processImpl(SampleFrame* buf, const fpp_t frames
 	m_eqControls.m_inPeakL = m_eqControls.m_inPeakL < m_inPeak[0] ? m_inPeak[0] : m_eqControls.m_inPeakL;
 	m_eqControls.m_inPeakR = m_eqControls.m_inPeakR < m_inPeak[1] ? m_inPeak[1] : m_eqControls.m_inPeakR;
 
-	float periodProgress = 0.0f; // percentage of period processed
-	for( fpp_t f = 0; f < frames; ++f)
+	if( m_linearPhase )
+	{
+		designLinearPhase( sampleRate, dry, wet );
+		m_linearPhase->process( buf, frames );
+	}
+	else
 	{
-		periodProgress = (float)f / (float)(frames-1);
-		//wet dry buffer
-		dryS[0] = buf[f][0];
-		dryS[1] = buf[f][1];
-		if( hpActive )
+		float periodProgress = 0.0f; // percentage of period processed
+		for( fpp_t f = 0; f < frames; ++f)
 		{
-			buf[f][0] = m_hp12.update( buf[f][0], 0, periodProgress );
-			buf[f][1] = m_hp12.update( buf[f][1], 1, periodProgress );
-
-			if( hp24Active || hp48Active )
+			periodProgress = (float)f / (float)(frames-1);
+			//wet dry buffer
+			dryS[0] = buf[f][0];
+			dryS[1] = buf[f][1];
+			if( hpActive )
 			{
-				buf[f][0] = m_hp24.update( buf[f][0], 0, periodProgress );
-				buf[f][1] = m_hp24.update( buf[f][1], 1, periodProgress );
+				buf[f][0] = m_hp12.update( buf[f][0], 0, periodProgress );
+				buf[f][1] = m_hp12.update( buf[f][1], 1, periodProgress );
+
+				if( hp24Active || hp48Active )
+				{
+					buf[f][0] = m_hp24.update( buf[f][0], 0, periodProgress );
+					buf[f][1] = m_hp24.update( buf[f][1], 1, periodProgress );
+				}
+
+				if( hp48Active )
+				{
+					buf[f][0] = m_hp480.update( buf[f][0], 0, periodProgress );
+					buf[f][1] = m_hp480.update( buf[f][1], 1, periodProgress );
+
+					buf[f][0] = m_hp481.update( buf[f][0], 0, periodProgress );
+					buf[f][1] = m_hp481.update( buf[f][1], 1, periodProgress );
+				}
 			}
 
-			if( hp48Active )
+			if( lowShelfActive )
 			{
-				buf[f][0] = m_hp480.update( buf[f][0], 0, periodProgress );
-				buf[f][1] = m_hp480.update( buf[f][1], 1, periodProgress );
-
-				buf[f][0] = m_hp481.update( buf[f][0], 0, periodProgress );
-				buf[f][1] = m_hp481.update( buf[f][1], 1, periodProgress );
+				buf[f][0] = m_lowShelf.update( buf[f][0], 0, periodProgress );
+				buf[f][1] = m_lowShelf.update( buf[f][1], 1, periodProgress );
 			}
-		}
-
-		if( lowShelfActive )
-		{
-			buf[f][0] = m_lowShelf.update( buf[f][0], 0, periodProgress );
-			buf[f][1] = m_lowShelf.update( buf[f][1], 1, periodProgress );
-		}
-
-		if( para1Active )
-		{
-			buf[f][0] = m_para1.update( buf[f][0], 0, periodProgress );
-			buf[f][1] = m_para1.update( buf[f][1], 1, periodProgress );
-		}
 
-		if( para2Active )
-		{
-			buf[f][0] = m_para2.update( buf[f][0], 0, periodProgress );
-			buf[f][1] = m_para2.update( buf[f][1], 1, periodProgress );
-		}
-
-		if( para3Active )
-		{
-			buf[f][0] = m_para3.update( buf[f][0], 0, periodProgress );
-			buf[f][1] = m_para3.update( buf[f][1], 1, periodProgress );
-		}
-
-		if( para4Active )
-		{
-			buf[f][0] = m_para4.update( buf[f][0], 0, periodProgress );
-			buf[f][1] = m_para4.update( buf[f][1], 1, periodProgress );
-		}
+			if( para1Active )
+			{
+				buf[f][0] = m_para1.update( buf[f][0], 0, periodProgress );
+				buf[f][1] = m_para1.update( buf[f][1], 1, periodProgress );
+			}
 
-		if( highShelfActive )
-		{
-			buf[f][0] = m_highShelf.update( buf[f][0], 0, periodProgress );
-			buf[f][1] = m_highShelf.update( buf[f][1], 1, periodProgress );
-		}
+			if( para2Active )
+			{
+				buf[f][0] = m_para2.update( buf[f][0], 0, periodProgress );
+				buf[f][1] = m_para2.update( buf[f][1], 1, periodProgress );
+			}
 
-		if( lpActive ){
-			buf[f][0] = m_lp12.update( buf[f][0], 0, periodProgress );
-			buf[f][1] = m_lp12.update( buf[f][1], 1, periodProgress );
+			if( para3Active )
+			{
+				buf[f][0] = m_para3.update( buf[f][0], 0, periodProgress );
+				buf[f][1] = m_para3.update( buf[f][1], 1, periodProgress );
+			}
 
-			if( lp24Active || lp48Active )
+			if( para4Active )
 			{
-				buf[f][0] = m_lp24.update( buf[f][0], 0, periodProgress );
-				buf[f][1] = m_lp24.update( buf[f][1], 1, periodProgress );
+				buf[f][0] = m_para4.update( buf[f][0], 0, periodProgress );
+				buf[f][1] = m_para4.update( buf[f][1], 1, periodProgress );
 			}
 
-			if( lp48Active )
+			if( highShelfActive )
 			{
-				buf[f][0] = m_lp480.update( buf[f][0], 0, periodProgress );
-				buf[f][1] = m_lp480.update( buf[f][1], 1, periodProgress );
+				buf[f][0] = m_highShelf.update( buf[f][0], 0, periodProgress );
+				buf[f][1] = m_highShelf.update( buf[f][1], 1, periodProgress );
+			}
+
+			if( lpActive ){
+				buf[f][0] = m_lp12.update( buf[f][0], 0, periodProgress );
+				buf[f][1] = m_lp12.update( buf[f][1], 1, periodProgress );
+
+				if( lp24Active || lp48Active )
+				{
+					buf[f][0] = m_lp24.update( buf[f][0], 0, periodProgress );
+					buf[f][1] = m_lp24.update( buf[f][1], 1, periodProgress );
+				}
+
+				if( lp48Active )
+				{
+					buf[f][0] = m_lp480.update( buf[f][0], 0, periodProgress );
+					buf[f][1] = m_lp480.update( buf[f][1], 1, periodProgress );
 
-				buf[f][0] = m_lp481.update( buf[f][0], 0, periodProgress );
-				buf[f][1] = m_lp481.update( buf[f][1], 1, periodProgress );
+					buf[f][0] = m_lp481.update( buf[f][0], 0, periodProgress );
+					buf[f][1] = m_lp481.update( buf[f][1], 1, periodProgress );
+				}
 			}
-		}
 
-		//apply wet / dry levels
-		buf[f][1] = ( dry * dryS[1] ) + ( wet * buf[f][1] );
-		buf[f][0] = ( dry * dryS[0] ) + ( wet * buf[f][0] );
+			//apply wet / dry levels
+			buf[f][1] = ( dry * dryS[1] ) + ( wet * buf[f][1] );
+			buf[f][0] = ( dry * dryS[0] ) + ( wet * buf[f][0] );
 
 
+		}
 	}
 
 	SampleFrame outPeak = { 0, 0 };
@@ -279,6 +290,86 @@ Effect::ProcessStatus EqEffect::processImpl(SampleFrame* buf, const fpp_t frames
 
 
 
+void EqEffect::updateLinearPhaseFilter()
+{
+	// set up outside of the lock, the old filter waits for its design when destroyed
+	const auto sampleRate = Engine::audioEngine()->outputSampleRate();
+	auto filter = m_eqControls.m_linearPhaseModel.value()
+		? std::make_unique<LinearPhaseFilter>(LinearPhaseFilter::lengthFor(sampleRate), sampleRate)
+		: nullptr;
+
+	Engine::audioEngine()->requestChangeInModel();
+	std::swap(m_linearPhase, filter);
+	m_linearPhaseState.reset();
+	Engine::audioEngine()->doneChangeInModel();
+}
+
+
+
+
+void EqEffect::designLinearPhase(int sampleRate, float dry, float wet)
+{
+	const auto& c = m_eqControls;
+	const bool hpActive = c.m_hpActiveModel.value();
+	const bool hp24Active = hpActive && (c.m_hp24Model.value() || c.m_hp48Model.value());
+	const bool hp48Active = hpActive && c.m_hp48Model.value();
+	const bool lpActive = c.m_lpActiveModel.value();
+	const bool lp24Active = lpActive && (c.m_lp24Model.value() || c.m_lp48Model.value());
+	const bool lp48Active = lpActive && c.m_lp48Model.value();
+
+	// the filters are already set up for these parameters
+	const auto state = std::array{
+		c.m_hpFeqModel.value(), c.m_hpResModel.value(),
+		c.m_lowShelfFreqModel.value(), c.m_lowShelfResModel.value(), c.m_lowShelfGainModel.value(),
+		c.m_para1FreqModel.value(), c.m_para1BwModel.value(), c.m_para1GainModel.value(),
+		c.m_para2FreqModel.value(), c.m_para2BwModel.value(), c.m_para2GainModel.value(),
+		c.m_para3FreqModel.value(), c.m_para3BwModel.value(), c.m_para3GainModel.value(),
+		c.m_para4FreqModel.value(), c.m_para4BwModel.value(), c.m_para4GainModel.value(),
+		c.m_highShelfFreqModel.value(), c.m_highShelfResModel.value(), c.m_highShelfGainModel.value(),
+		c.m_lpFreqModel.value(), c.m_lpResModel.value(), dry, wet,
+		static_cast<float>(hpActive | hp24Active << 1 | hp48Active << 2
+			| c.m_lowShelfActiveModel.value() << 3 | c.m_para1ActiveModel.value() << 4
+			| c.m_para2ActiveModel.value() << 5 | c.m_para3ActiveModel.value() << 6
+			| c.m_para4ActiveModel.value() << 7 | c.m_highShelfActiveModel.value() << 8
+			| lpActive << 9 | lp24Active << 10 | lp48Active << 11)
+	};
+	if (m_linearPhaseState == state) { return; }
+	m_linearPhaseState = state;
+
+	// the filters in the same order as when filtering sample by sample
+	auto stages = std::vector<StereoBiQuad>{};
+	const auto addStage = [&stages](bool active, const EqFilter& filter)
+	{
+		if (active) { stages.push_back(filter.biQuad()); }
+	};
+	addStage(hpActive, m_hp12);
+	addStage(hp24Active, m_hp24);
+	addStage(hp48Active, m_hp480);
+	addStage(hp48Active, m_hp481);
+	addStage(c.m_lowShelfActiveModel.value(), m_lowShelf);
+	addStage(c.m_para1ActiveModel.value(), m_para1);
+	addStage(c.m_para2ActiveModel.value(), m_para2);
+	addStage(c.m_para3ActiveModel.value(), m_para3);
+	addStage(c.m_para4ActiveModel.value(), m_para4);
+	addStage(c.m_highShelfActiveModel.value(), m_highShelf);
+	addStage(lpActive, m_lp12);
+	addStage(lp24Active, m_lp24);
+	addStage(lp48Active, m_lp480);
+	addStage(lp48Active, m_lp481);
+
+	// without a phase shift, the dry signal adds up with the filtered one
+	m_linearPhase->setMagnitude([stages = std::move(stages), sampleRate, dry, wet](float freq)
+	{
+		const float w = 2 * std::numbers::pi_v<float> * freq / sampleRate;
+		float gain = 1.f;
+		for (const auto& stage : stages) { gain *= stage.magnitude(w); }
+		return dry + wet * gain;
+	});
+}
+
+
+
+
 float EqEffect::linearPeakBand(float minF, float maxF, EqAnalyser* fft, int sr)
 {
 	auto const fftEnergy = fft->getEnergy();
@@ -27,8 +27,12 @@
 #include "Effect.h"
 #include "EqControls.h"
 #include "EqFilter.h"
+#include "LinearPhaseFilter.h"
 
 #include <algorithm>
+#include <array>
+#include <memory>
+#include <optional>
 
 
 namespace lmms
@@ -47,6 +51,14 @@ public:
 	{
 		return &m_eqControls;
 	}
+
+	f_cnt_t latency() const override
+	{
+		return m_linearPhase ? m_linearPhase->latency() : 0;
+	}
+
+	//! Sets up or removes the linear phase filter, depending on the controls
+	void updateLinearPhaseFilter();
 	inline void gain( SampleFrame* buf, const fpp_t frames, float scale, SampleFrame* peak )
 	{
 		peak[0][0] = 0.0f; peak[0][1] = 0.0f;
@@ -89,6 +101,13 @@ private:
 	float m_inGain;
 	float m_outGain;
 
+	//! Replaces the filters while linear phase is on
+	std::unique_ptr<LinearPhaseFilter> m_linearPhase;
+	//! The parameters the linear phase filter was last designed for
+	std::optional<std::array<float, 25>> m_linearPhaseState;
+
+	void designLinearPhase(int sampleRate, float dry, float wet);
+
 	float linearPeakBand(float minF, float maxF, EqAnalyser*, int);
 
 	inline float bandToFreq ( int index , int sampleRate )
@@ -119,6 +119,16 @@ public:
 	}
 
 
+	///
+	/// \brief biQuad
+	/// \return the BiQuad with the latest coefficents, which update() fades to
+	///
+	inline const StereoBiQuad& biQuad() const
+	{
+		return m_biQuadFrameTarget;
+	}
+
+
 	///
 	/// \brief update
 	/// filters using two BiQuads, then crossfades,
@@ -22,13 +22,11 @@
 
 #include "EqSpectrumView.h"
 
+#include <algorithm>
 #include <cmath>
-#include <numbers>
 #include <QPainter>
 #include <QPen>
 
-#include "AudioEngine.h"
-#include "Engine.h"
 #include "EqCurve.h"
 #include "GuiApplication.h"
 #include "MainWindow.h"
@@ -38,30 +36,13 @@ namespace lmms
 
 
 EqAnalyser::EqAnalyser() :
-	m_framesFilledUp ( 0 ),
-	m_energy ( 0 ),
-	m_sampleRate ( 1 ),
-	m_active ( true )
+	m_analysis( FFT_BUFFER_SIZE, FFTWindow::BlackmanHarris, false, 2 ),
+	m_energy( 0 ),
+	m_sampleRate( 1 ),
+	m_inProgress( false )
 {
-	using namespace std::numbers;
-	m_inProgress=false;
-	m_specBuf = ( fftwf_complex * ) fftwf_malloc( ( FFT_BUFFER_SIZE + 1 ) * sizeof( fftwf_complex ) );
-	m_fftPlan = fftwf_plan_dft_r2c_1d( FFT_BUFFER_SIZE*2, m_buffer, m_specBuf, FFTW_MEASURE );
-
-	//initialize Blackman-Harris window, constants taken from
-	//https://en.wikipedia.org/wiki/Window_function#A_list_of_window_functions
-	const float a0 = 0.35875f;
-	const float a1 = 0.48829f;
-	const float a2 = 0.14128f;
-	const float a3 = 0.01168f;
-
-	for (auto i = std::size_t{0}; i < FFT_BUFFER_SIZE; i++)
-	{
-		m_fftWindow[i] = a0 - a1 * std::cos(2 * pi_v<float> * i / static_cast<float>(FFT_BUFFER_SIZE - 1.0))
-			+ a2 * std::cos(4 * pi_v<float> * i / static_cast<float>(FFT_BUFFER_SIZE - 1.0))
-			- a3 * std::cos(6 * pi_v<float> * i / static_cast<float>(FFT_BUFFER_SIZE - 1.0));
-	}
-	clear();
+	std::fill( std::begin( m_bands ), std::end( m_bands ), 0.f );
+	m_subscription = m_analysis.subscribe( [this]( const SpectrumAnalysis::Spectrum& spectrum ) { update( spectrum ); } );
 }
 
 
@@ -69,8 +50,7 @@ EqAnalyser::EqAnalyser() :
 
 EqAnalyser::~EqAnalyser()
 {
-	fftwf_destroy_plan( m_fftPlan );
-	fftwf_free( m_specBuf );
+	m_analysis.unsubscribe( m_subscription );
 }
 
 
@@ -78,54 +58,22 @@ EqAnalyser::~EqAnalyser()
 
 void EqAnalyser::analyze( SampleFrame* buf, const fpp_t frames )
 {
-	//only analyse if the view is visible
-	if ( m_active )
-	{
-		m_inProgress=true;
-		const int FFT_BUFFER_SIZE = 2048;
-		fpp_t f = 0;
-		if( frames > FFT_BUFFER_SIZE )
-		{
-			m_framesFilledUp = 0;
-			f = frames - FFT_BUFFER_SIZE;
-		}
-		// meger channels
-		for( ; f < frames; ++f )
-		{
-			m_buffer[m_framesFilledUp] =
-					( buf[f][0] + buf[f][1] ) * 0.5;
-			++m_framesFilledUp;
-		}
+	m_analysis.write( buf, frames );
+}
 
-		if( m_framesFilledUp < FFT_BUFFER_SIZE )
-		{
-			m_inProgress = false;
-			return;
-		}
 
-		m_sampleRate = Engine::audioEngine()->outputSampleRate();
-		const int LOWEST_FREQ = 0;
-		const int HIGHEST_FREQ = m_sampleRate / 2;
 
-		//apply FFT window
-		for( int i = 0; i < FFT_BUFFER_SIZE; i++ )
-		{
-			m_buffer[i] = m_buffer[i] * m_fftWindow[i];
-		}
 
-		fftwf_execute( m_fftPlan );
-		absspec( m_specBuf, m_absSpecBuf, FFT_BUFFER_SIZE+1 );
+void EqAnalyser::update( const SpectrumAnalysis::Spectrum& spectrum )
+{
+	m_inProgress = true;
+	m_sampleRate = spectrum.sampleRate;
 
-		compressbands( m_absSpecBuf, m_bands, FFT_BUFFER_SIZE+1,
-					   MAX_BANDS,
-					   ( int )( LOWEST_FREQ * ( FFT_BUFFER_SIZE + 1 ) / ( float )( m_sampleRate / 2 ) ),
-					   ( int )( HIGHEST_FREQ * ( FFT_BUFFER_SIZE +  1) / ( float )( m_sampleRate / 2 ) ) );
-		m_energy = maximum( m_bands, MAX_BANDS ) / maximum( m_buffer, FFT_BUFFER_SIZE );
+	const int bins = static_cast<int>( spectrum.left.size() );
+	compressbands( spectrum.left.data(), m_bands, bins, MAX_BANDS, 0, bins );
+	m_energy = maximum( m_bands, MAX_BANDS ) / spectrum.peakLeft;
 
-		m_framesFilledUp = 0;
-		m_inProgress = false;
-		m_active = false;
-	}
+	m_inProgress = false;
 }
 
 
@@ -149,7 +97,7 @@ int EqAnalyser::getSampleRate() const
 
 bool EqAnalyser::getActive() const
 {
-	return m_active;
+	return m_analysis.isActive();
 }
 
 
@@ -157,7 +105,7 @@ bool EqAnalyser::getActive() const
 
 void EqAnalyser::setActive(bool active)
 {
-	m_active = active;
+	m_analysis.setActive( active );
 }
 
 
@@ -171,12 +119,10 @@ bool EqAnalyser::getInProgress()
 
 
 
+// the bands only count while the energy is positive, so the analysis thread can keep writing them
 void EqAnalyser::clear()
 {
-	m_framesFilledUp = 0;
 	m_energy = 0;
-	memset( m_buffer, 0, sizeof( m_buffer ) );
-	memset( m_bands, 0, sizeof( m_bands ) );
 }
 
 
@@ -234,7 +180,7 @@ void EqSpectrumView::paintEvent(QPaintEvent *event)
 	const float fallOff = 1.07f;
 	for( int x = 0; x < MAX_BANDS; ++x, ++bands )
 	{
-		float peak = *bands != 0. ? (fh * 2.0 / 3.0 * (20. * std::log10(*bands / energy) - LOWER_Y) / (-LOWER_Y)) : 0.;
+		float peak = *bands != 0. && energy > 0. ? (fh * 2.0 / 3.0 * (20. * std::log10(*bands / energy) - LOWER_Y) / (-LOWER_Y)) : 0.;
 
 		if( peak < 0 )
 		{
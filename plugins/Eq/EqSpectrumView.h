@@ -25,6 +25,7 @@
 
 #include <QPainterPath>
 #include <QWidget>
+#include <atomic>
 
 #include "fft_helpers.h"
 #include "LmmsTypes.h"
@@ -35,6 +36,8 @@ namespace lmms
 class SampleFrame;
 
 const int MAX_BANDS = 2048;
+
+//! Spectrum of the signal before or after the EQ, analysed in the background by a SpectrumAnalysis
 class EqAnalyser
 {
 public:
@@ -45,6 +48,7 @@ public:
 	bool getInProgress();
 	void clear();
 
+	//! Passes a period to the analysis, audio thread only
 	void analyze( SampleFrame* buf, const fpp_t frames );
 
 	float getEnergy() const;
@@ -54,16 +58,14 @@ public:
 	void setActive(bool active);
 
 private:
-	fftwf_plan m_fftPlan;
-	fftwf_complex * m_specBuf;
-	float m_absSpecBuf[FFT_BUFFER_SIZE+1];
-	float m_buffer[FFT_BUFFER_SIZE*2];
-	int m_framesFilledUp;
-	float m_energy;
-	int m_sampleRate;
-	bool m_active;
-	bool m_inProgress;
-	float m_fftWindow[FFT_BUFFER_SIZE];
+	//! Compresses a new spectrum into m_bands, on the analysis thread
+	void update(const SpectrumAnalysis::Spectrum& spectrum);
+
+	SpectrumAnalysis m_analysis;
+	int m_subscription;
+	std::atomic<float> m_energy;
+	std::atomic<int> m_sampleRate;
+	std::atomic<bool> m_inProgress;
 };
 
 
@@ -23,7 +23,6 @@
  */
 
 #include "MonoDelay.h"
-#include "string.h"
 
 namespace lmms
 {
@@ -31,12 +30,8 @@ namespace lmms
 
 MonoDelay::MonoDelay( int maxTime , int sampleRate )
 {
-	m_buffer = 0;
 	m_maxTime = static_cast<float>(maxTime);
-	m_maxLength = maxTime * sampleRate;
-	m_length = static_cast<float>(m_maxLength);
-
-	m_writeIndex = 0;
+	m_length = static_cast<float>(maxTime * sampleRate);
 	m_feedback = 0.0f;
 	setSampleRate( sampleRate );
 }
@@ -44,39 +39,11 @@ MonoDelay::MonoDelay( int maxTime , int sampleRate )
 
 
 
-MonoDelay::~MonoDelay()
-{
-	if( m_buffer )
-	{
-		delete m_buffer;
-	}
-}
-
-
-
-void MonoDelay::tick( sample_t* sample )
-{
-	m_writeIndex = ( m_writeIndex + 1 ) % ( int )m_maxLength;
-	int readIndex = m_writeIndex - static_cast<int>(m_length);
-	if (readIndex < 0 ) { readIndex += m_maxLength; }
-	float out = m_buffer[ readIndex ];
-	m_buffer[ m_writeIndex ] = *sample + ( out * m_feedback );
-	*sample = out;
-}
-
-
-
-
 void MonoDelay::setSampleRate( int sampleRate )
 {
-	if( m_buffer )
-	{
-		delete m_buffer;
-	}
-
-
-	m_buffer = new sample_t[( int )( sampleRate * m_maxTime ) ];
-	memset( m_buffer, 0, sizeof(float) * ( int )( sampleRate * m_maxTime ) );
+	m_maxLength = static_cast<int>(sampleRate * m_maxTime);
+	m_length = std::min(m_length, static_cast<float>(m_maxLength));
+	m_delay.setMaxDelay(m_maxLength);
 }
 
 
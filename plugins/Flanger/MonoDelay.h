@@ -25,6 +25,9 @@
 #ifndef MONODELAY_H
 #define MONODELAY_H
 
+#include <algorithm>
+
+#include "Delay.h"
 #include "LmmsTypes.h"
 
 namespace lmms
@@ -35,12 +38,11 @@ class MonoDelay
 {
 public:
 	MonoDelay( int maxTime , int sampleRate );
-	~MonoDelay();
 	inline void setLength( float length )
 	{
 		if( length <= m_maxLength && length >= 0 )
 		{
-			m_length = length;
+			m_length = std::max(length, 1.0f);
 		}
 	}
 
@@ -49,14 +51,19 @@ public:
 		m_feedback = feedback;
 	}
 
-	void tick( sample_t* sample );
+	inline void tick( sample_t* sample )
+	{
+		const float out = m_delay.read(m_length)[0];
+		m_delay.write({*sample + out * m_feedback});
+		*sample = out;
+	}
+
 	void setSampleRate( int sampleRate );
 
 private:
-	sample_t* m_buffer;
+	DelayLine<1> m_delay;
 	int m_maxLength;
 	float m_length;
-	int m_writeIndex;
 	float m_feedback;
 	float m_maxTime;
 };
@@ -47,9 +47,19 @@ long GbApuWrapper::readSamples(blip_sample_t* out, long count)
 	return m_buf.read_samples(out, count);
 }
 
+// Wrap Gb_Apu::treble_eq(...)
+void GbApuWrapper::trebleEq(double treble)
+{
+	if (treble == m_treble) { return; }
+	m_treble = treble;
+	Gb_Apu::treble_eq(blip_eq_t{treble});
+}
+
 // Wrap Stereo_Buffer::bass_freq(...)
 void GbApuWrapper::bassFreq(int freq)
 {
+	if (freq == m_bassFreq) { return; }
+	m_bassFreq = freq;
 	m_buf.bass_freq(freq);
 }
 
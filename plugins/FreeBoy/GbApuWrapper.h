@@ -27,6 +27,8 @@
 #include <Gb_Apu.h>
 #include <Multi_Buffer.h>
 
+#include <limits>
+
 namespace lmms
 {
 
@@ -41,7 +43,7 @@ public:
 	void writeRegister(unsigned addr, int data) { Gb_Apu::write_register(fakeClock(), addr, data); }
 	long samplesAvail() const;
 	long readSamples(blip_sample_t* out, long count);
-	void trebleEq(const blip_eq_t& eq) { Gb_Apu::treble_eq(eq); }
+	void trebleEq(double treble);
 	void bassFreq(int freq);
 	void endFrame(blip_time_t endTime);
 
@@ -51,6 +53,11 @@ private:
 	// Fake CPU timing
 	blip_time_t fakeClock() { return m_time += 4; }
 	blip_time_t m_time = 0;
+
+	// Recomputing the band-limited steps takes longer than emulating a period,
+	// so the filters are only set up again when they change
+	double m_treble = std::numeric_limits<double>::quiet_NaN();
+	int m_bassFreq = -1;
 };
 
 
@@ -31,6 +31,9 @@
 #include "GigPlayer.h"
 
 #include <cstring>
+#include <map>
+#include <set>
+#include <vector>
 #include <QDebug>
 #include <QLayout>
 #include <QLabel>
@@ -80,6 +83,137 @@ Plugin::Descriptor PLUGIN_EXPORT gigplayer_plugin_descriptor =
 
 
 
+std::shared_ptr<GigInstance> GigInstance::get( const QString & filename )
+{
+	static QMutex s_instancesMutex;
+	static std::map<QString, std::weak_ptr<GigInstance>> s_instances;
+
+	QMutexLocker locker( &s_instancesMutex );
+	std::weak_ptr<GigInstance> & shared = s_instances[filename];
+	if( auto instance = shared.lock() )
+	{
+		return instance;
+	}
+
+	auto instance = std::make_shared<GigInstance>( filename );
+	shared = instance;
+	return instance;
+}
+
+
+
+
+void GigInstance::preload( gig::Instrument * instrument )
+{
+	// About as much as LinuxSampler preloads, i.e. the first 0.7 s at 44.1 kHz
+	const unsigned long PreloadFrames = 32768;
+
+	// The samples to preload by their index in the file's list of samples,
+	// which the second handle on the file has in the same order
+	std::vector<std::pair<std::size_t, gig::Sample *>> samples;
+	{
+		QMutexLocker locker( &mutex );
+		std::set<gig::Sample *> wanted;
+		for( gig::Region * pRegion = instrument->GetFirstRegion();
+				pRegion != nullptr; pRegion = instrument->GetNextRegion() )
+		{
+			for( uint32_t i = 0; i < pRegion->DimensionRegions; ++i )
+			{
+				gig::Sample * pSample = pRegion->pDimensionRegions[i]->pSample;
+				if( pSample != nullptr && m_preloaded.find( pSample ) == m_preloaded.end() )
+				{
+					wanted.insert( pSample );
+				}
+			}
+		}
+		if( wanted.empty() )
+		{
+			return;
+		}
+
+		std::size_t index = 0;
+		for( gig::Sample * pSample = gig.GetFirstSample(); pSample != nullptr;
+				pSample = gig.GetNextSample(), ++index )
+		{
+			if( wanted.count( pSample ) != 0 )
+			{
+				samples.emplace_back( index, pSample );
+			}
+		}
+	}
+
+	// Read from disk through the second handle without holding the mutex, so
+	// notes of other instruments keep playing, and only hand the data over
+	// under it
+	QMutexLocker preloadLocker( &m_preloadMutex );
+	try
+	{
+		if( !m_preloadGig )
+		{
+			m_preloadRiff = std::make_unique<RIFF::File>( m_filename.toUtf8().constData() );
+			m_preloadGig = std::make_unique<gig::File>( m_preloadRiff.get() );
+		}
+	}
+	catch( ... )
+	{
+		// The samples are read from disk then
+		m_preloadGig.reset();
+		m_preloadRiff.reset();
+		return;
+	}
+
+	auto next = samples.begin();
+	std::size_t index = 0;
+	for( gig::Sample * pSample = m_preloadGig->GetFirstSample(); pSample != nullptr && next != samples.end();
+			pSample = m_preloadGig->GetNextSample(), ++index )
+	{
+		if( index != next->first )
+		{
+			continue;
+		}
+
+		std::vector<int8_t> data( std::min<unsigned long>( PreloadFrames, pSample->SamplesTotal ) * pSample->FrameSize );
+		try
+		{
+			pSample->SetPos( 0 );
+			data.resize( pSample->Read( data.data(), data.size() / pSample->FrameSize ) * pSample->FrameSize );
+		}
+		catch( ... )
+		{
+			// The sample is read from disk then
+			data.clear();
+		}
+
+		if( !data.empty() )
+		{
+			QMutexLocker locker( &mutex );
+			m_preloaded.emplace( next->second, std::move( data ) );
+		}
+		++next;
+	}
+}
+
+
+
+
+unsigned long GigInstance::read( gig::Sample * sample, void * buffer, unsigned long frames )
+{
+	const auto preloaded = m_preloaded.find( sample );
+	const unsigned long pos = sample->GetPos();
+
+	if( preloaded != m_preloaded.end() && ( pos + frames ) * sample->FrameSize <= preloaded->second.size() )
+	{
+		std::memcpy( buffer, preloaded->second.data() + pos * sample->FrameSize, frames * sample->FrameSize );
+		sample->SetPos( pos + frames );
+		return frames;
+	}
+
+	return sample->Read( buffer, frames );
+}
+
+
+
+
 GigInstrument::GigInstrument( InstrumentTrack * _instrument_track ) :
 	Instrument(_instrument_track, &gigplayer_plugin_descriptor, nullptr, Flag::IsSingleStreamed | Flag::IsNotBendable),
 	m_instance( nullptr ),
@@ -88,10 +222,16 @@ GigInstrument::GigInstrument( InstrumentTrack * _instrument_track ) :
 	m_bankNum( 0, 0, 999, this, tr( "Bank" ) ),
 	m_patchNum( 0, 0, 127, this, tr( "Patch" ) ),
 	m_gain( 1.0f, 0.0f, 5.0f, 0.01f, this, tr( "Gain" ) ),
+#if (QT_VERSION < QT_VERSION_CHECK(5,14,0))
+	m_notesMutex(QMutex::Recursive),
+#endif
 	m_interpolation( SRC_LINEAR ),
 	m_RandomSeed( 0 ),
 	m_currentKeyDimension( 0 )
 {
+	// notes are resampled by as many threads as there are
+	setVoiceGroups(Engine::audioEngine()->numJobThreads());
+
 	auto iph = new InstrumentPlayHandle(this, _instrument_track);
 	Engine::audioEngine()->addPlayHandle( iph );
 
@@ -189,8 +329,7 @@ void GigInstrument::freeInstance()
 
 	if( m_instance != nullptr )
 	{
-		delete m_instance;
-		m_instance = nullptr;
+		m_instance.reset();
 
 		// If we're changing instruments, we got to make sure that we
 		// remove all pointers to the old samples and don't try accessing
@@ -215,7 +354,7 @@ void GigInstrument::openFile( const QString & _gigFile, bool updateTrackName )
 
 		try
 		{
-			m_instance = new GigInstance( PathUtil::toAbsolute( _gigFile ) );
+			m_instance = GigInstance::get( PathUtil::toAbsolute( _gigFile ) );
 			m_filename = PathUtil::toShortestRelative( _gigFile );
 		}
 		catch( ... )
@@ -260,6 +399,7 @@ QString GigInstrument::getCurrentPatchName()
 	int iBankSelected = m_bankNum.value();
 	int iProgSelected = m_patchNum.value();
 
+	QMutexLocker instanceLock( &m_instance->mutex );
 	gig::Instrument * pInstrument = m_instance->gig.GetFirstInstrument();
 
 	while( pInstrument != nullptr )
@@ -323,7 +463,6 @@ void GigInstrument::playNote( NotePlayHandle * _n, SampleFrame* )
 void GigInstrument::play( SampleFrame* _working_buffer )
 {
 	const fpp_t frames = Engine::audioEngine()->framesPerPeriod();
-	const auto rate = Engine::audioEngine()->outputSampleRate();
 
 	// Initialize to zeros
 	std::memset( &_working_buffer[0][0], 0, DEFAULT_CHANNELS * frames * sizeof( float ) );
@@ -404,16 +543,42 @@ void GigInstrument::play( SampleFrame* _working_buffer )
 		}
 	}
 
-	// Fill buffer with portions of the note samples
+	// Fill buffer with portions of the note samples. The notes are split into
+	// groups rendered in parallel, as resampling them is what takes long.
+	m_playingNotes.clear();
 	for (auto& note : m_notes)
 	{
 		// Only process the notes if we're in a playing state
-		if (!(note.state == GigState::PlayingKeyDown || note.state == GigState::PlayingKeyUp ))
+		if (note.state == GigState::PlayingKeyDown || note.state == GigState::PlayingKeyUp)
 		{
-			continue;
+			m_playingNotes.push_back(&note);
 		}
+	}
+	renderVoiceGroups(_working_buffer, frames);
 
-		for (auto& sample : note.samples)
+	m_notesMutex.unlock();
+	m_synthMutex.unlock();
+
+	// Set gain properly based on volume control
+	for( f_cnt_t i = 0; i < frames; ++i )
+	{
+		_working_buffer[i][0] *= m_gain.value();
+		_working_buffer[i][1] *= m_gain.value();
+	}
+}
+
+
+
+
+// Render every voiceGroups()-th of the playing notes. Each note belongs to one
+// group only, and reading the file is guarded by the mutex of the instance.
+void GigInstrument::renderVoiceGroup(int group, SampleFrame* buffer, fpp_t frames)
+{
+	const auto rate = Engine::audioEngine()->outputSampleRate();
+
+	for (auto note = static_cast<std::size_t>(group); note < m_playingNotes.size(); note += voiceGroups())
+	{
+		for (auto& sample : m_playingNotes[note]->samples)
 		{
 			if (sample.sample == nullptr || sample.region == nullptr) { continue; }
 
@@ -465,8 +630,8 @@ void GigInstrument::play( SampleFrame* _working_buffer )
 				{
 					for( f_cnt_t i = 0; i < frames; ++i )
 					{
-						_working_buffer[i][0] += convertBuf[i][0];
-						_working_buffer[i][1] += convertBuf[i][1];
+						buffer[i][0] += convertBuf[i][0];
+						buffer[i][1] += convertBuf[i][1];
 					}
 				}
 			}
@@ -474,8 +639,8 @@ void GigInstrument::play( SampleFrame* _working_buffer )
 			{
 				for( f_cnt_t i = 0; i < frames; ++i )
 				{
-					_working_buffer[i][0] += sampleData[i][0];
-					_working_buffer[i][1] += sampleData[i][1];
+					buffer[i][0] += sampleData[i][0];
+					buffer[i][1] += sampleData[i][1];
 				}
 			}
 
@@ -484,16 +649,6 @@ void GigInstrument::play( SampleFrame* _working_buffer )
 			sample.adsr.inc(used);
 		}
 	}
-
-	m_notesMutex.unlock();
-	m_synthMutex.unlock();
-
-	// Set gain properly based on volume control
-	for( f_cnt_t i = 0; i < frames; ++i )
-	{
-		_working_buffer[i][0] *= m_gain.value();
-		_working_buffer[i][1] *= m_gain.value();
-	}
 }
 
 
@@ -529,6 +684,8 @@ void GigInstrument::loadSample( GigSample& sample, SampleFrame* sampleData, f_cn
 	unsigned long allocationsize = samples * sample.sample->FrameSize;
 	int8_t buffer[allocationsize];
 
+	QMutexLocker instanceLock( &m_instance->mutex );
+
 	// Load the sample in different ways depending on if we're looping or not
 	if( loop == true && ( sample.pos >= loopStart || sample.pos + samples > loopStart ) )
 	{
@@ -556,7 +713,7 @@ void GigInstrument::loadSample( GigSample& sample, SampleFrame* sampleData, f_cn
 		do
 		{
 			samplestoloopend = loopEnd - sample.sample->GetPos();
-			readsamples = sample.sample->Read( &buffer[totalreadsamples * sample.sample->FrameSize],
+			readsamples = m_instance->read( sample.sample, &buffer[totalreadsamples * sample.sample->FrameSize],
 					std::min( samplestoread, samplestoloopend ) );
 			samplestoread -= readsamples;
 			totalreadsamples += readsamples;
@@ -572,7 +729,7 @@ void GigInstrument::loadSample( GigSample& sample, SampleFrame* sampleData, f_cn
 	{
 		sample.sample->SetPos( sample.pos );
 
-		unsigned long size = sample.sample->Read( &buffer, samples ) * sample.sample->FrameSize;
+		unsigned long size = m_instance->read( sample.sample, &buffer, samples ) * sample.sample->FrameSize;
 		std::memset( (int8_t*) &buffer + size, 0, allocationsize - size );
 	}
 
@@ -719,6 +876,7 @@ void GigInstrument::addSamples( GigNote & gignote, bool wantReleaseSample )
 					m_instrument->DimensionKeyRange.low + 1 );
 	}
 
+	QMutexLocker instanceLock( &m_instance->mutex );
 	gig::Region* pRegion = m_instrument->GetFirstRegion();
 
 	while( pRegion != nullptr )
@@ -860,9 +1018,11 @@ void GigInstrument::getInstrument()
 	int iProgSelected = m_patchNum.value();
 
 	QMutexLocker locker( &m_synthMutex );
+	const std::shared_ptr<GigInstance> instance = m_instance;
 
 	if( m_instance != nullptr )
 	{
+		QMutexLocker instanceLock( &m_instance->mutex );
 		gig::Instrument * pInstrument = m_instance->gig.GetFirstInstrument();
 
 		while( pInstrument != nullptr )
@@ -880,6 +1040,15 @@ void GigInstrument::getInstrument()
 
 		m_instrument = pInstrument;
 	}
+
+	gig::Instrument * instrument = m_instrument;
+	locker.unlock();
+
+	// Without holding our lock, so this track keeps playing while loading
+	if( instrument != nullptr )
+	{
+		instance->preload( instrument );
+	}
 }
 
 
@@ -1074,7 +1243,7 @@ void GigInstrumentView::showPatchDialog()
 {
 	auto k = castModel<GigInstrument>();
 	PatchesDialog pd( this );
-	pd.setup( k->m_instance, 1, k->instrumentTrack()->name(), &k->m_bankNum, &k->m_patchNum, m_patchLabel );
+	pd.setup( k->m_instance.get(), 1, k->instrumentTrack()->name(), &k->m_bankNum, &k->m_patchNum, m_patchLabel );
 	pd.exec();
 }
 
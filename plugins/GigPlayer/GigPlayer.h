@@ -30,6 +30,12 @@
 #include <QList>
 #include <QMutex>
 #include <QMutexLocker>
+#if (QT_VERSION >= QT_VERSION_CHECK(5,14,0))
+#include <QRecursiveMutex>  // IWYU pragma: keep
+#endif
+#include <map>
+#include <memory>
+#include <vector>
 #include <samplerate.h>
 
 #include "Instrument.h"
@@ -68,19 +74,47 @@ struct GIGPluginData
 
 
 // Load a GIG file using libgig
+//
+// Instruments using the same file share one instance, so its samples are only
+// preloaded once. libgig keeps read positions and iterators in the file's
+// objects, so lock the mutex while using them.
 class GigInstance
 {
 public:
 	GigInstance( QString filename ) :
 		riff( filename.toUtf8().constData() ),
+		m_filename( filename ),
 		gig( &riff )
 	{}
 
+	// Open the file or get the instance already opened by another instrument,
+	// throws like the constructor if the file can't be opened
+	static std::shared_ptr<GigInstance> get( const QString & filename );
+
+	// Keep the beginning of the samples of an instrument in memory, so notes
+	// start without waiting for the disk
+	void preload( gig::Instrument * instrument );
+
+	// Read frames from the sample, from memory if they have been preloaded,
+	// must be called with the mutex held
+	unsigned long read( gig::Sample * sample, void * buffer, unsigned long frames );
+
 private:
 	RIFF::File riff;
+	QString m_filename;
+
+	// A second handle on the file, which preloading reads through without
+	// holding the mutex of the one notes are played from
+	std::unique_ptr<RIFF::File> m_preloadRiff;
+	std::unique_ptr<gig::File> m_preloadGig;
+	QMutex m_preloadMutex;
+
+	// The beginning of the samples preloaded, guarded by the mutex
+	std::map<gig::Sample *, std::vector<int8_t>> m_preloaded;
 
 public:
 	gig::File gig;
+	QMutex mutex;
 } ;
 
 
@@ -275,7 +309,7 @@ public slots:
 
 private:
 	// The GIG file and instrument we're using
-	GigInstance * m_instance;
+	std::shared_ptr<GigInstance> m_instance;
 	gig::Instrument * m_instrument;
 
 	// Part of the UI
@@ -286,15 +320,24 @@ private:
 
 	FloatModel m_gain;
 
-	// Locking for the data
+	// Locking for the data. play() holds the notes while waiting for its
+	// voice groups, meanwhile running other jobs which may play notes of ours.
 	QMutex m_synthMutex;
+#if (QT_VERSION >= QT_VERSION_CHECK(5,14,0))
+	QRecursiveMutex m_notesMutex;
+#else
 	QMutex m_notesMutex;
+#endif
 
 	// Used for resampling
 	int m_interpolation;
 
 	// List of all the currently playing notes
 	QList<GigNote> m_notes;
+	// The notes in a playing state in the current period, which the voice
+	// groups are made of. Notes added meanwhile don't move them, as QList
+	// keeps notes in nodes of their own.
+	std::vector<GigNote*> m_playingNotes;
 
 	// Used when determining which samples to use
 	uint32_t m_RandomSeed;
@@ -320,6 +363,11 @@ private:
 	// samples
 	void addSamples( GigNote & gignote, bool wantReleaseSample );
 
+protected:
+	void renderVoiceGroup(int group, SampleFrame* buffer, fpp_t frames) override;
+
+private:
+
 	friend class gui::GigInstrumentView;
 
 signals:
@@ -143,6 +143,7 @@ void PatchesDialog::setup( GigInstance * pSynth, int iChan,
 	int iBankDefault = -1;
 	int iProgDefault = -1;
 
+	QMutexLocker synthLock( &m_pSynth->mutex );
 	gig::Instrument * pInstrument = m_pSynth->gig.GetFirstInstrument();
 
 	while( pInstrument )
@@ -168,6 +169,7 @@ void PatchesDialog::setup( GigInstance * pSynth, int iChan,
 
 		pInstrument = m_pSynth->gig.GetNextInstrument();
 	}
+	synthLock.unlock();
 
 	m_bankListView->setSortingEnabled( true );
 
@@ -341,6 +343,7 @@ void PatchesDialog::bankChanged()
 	m_progListView->clear();
 	QTreeWidgetItem * pProgItem = nullptr;
 
+	QMutexLocker synthLock( &m_pSynth->mutex );
 	gig::Instrument * pInstrument = m_pSynth->gig.GetFirstInstrument();
 
 	while( pInstrument )
@@ -368,6 +371,7 @@ void PatchesDialog::bankChanged()
 
 		pInstrument = m_pSynth->gig.GetNextInstrument();
 	}
+	synthLock.unlock();
 
 	m_progListView->setSortingEnabled( true );
 
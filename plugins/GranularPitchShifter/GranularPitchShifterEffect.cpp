@@ -57,6 +57,9 @@ GranularPitchShifterEffect::GranularPitchShifterEffect(Model* parent, const Desc
 {
 	autoQuitModel()->setValue(autoQuitModel()->maxValue());
 	
+	// grains are never allocated while processing
+	m_grains.reserve(MaxGrains);
+	
 	changeSampleRate();
 }
 
@@ -152,8 +155,8 @@ Effect::ProcessStatus GranularPitchShifterEffect::processImpl(SampleFrame* buf,
 		std::array<float, 2> s = {0, 0};
 		std::array<float, 2> filtered = {buf[f][0], buf[f][1]};
 		
-		// spawn a new grain if it's time
-		if (++m_timeSinceLastGrain >= m_nextWaitRandomization * waitMult)
+		// spawn a new grain if it's time, and skip it if too many grains are still playing
+		if (++m_timeSinceLastGrain >= m_nextWaitRandomization * waitMult && m_grainCount < MaxGrains)
 		{
 			m_timeSinceLastGrain = 0;
 			auto randThing = fastRand<double>(-1.0, +1.0);
@@ -228,8 +231,7 @@ Effect::ProcessStatus GranularPitchShifterEffect::processImpl(SampleFrame* buf,
 			filtered[1] = m_prefilter[1].process(filtered[1]);
 		}
 		
-		m_ringBuf[m_writePoint][0] = filtered[0] + s[0] * feedback;
-		m_ringBuf[m_writePoint][1] = filtered[1] + s[1] * feedback;
+		writeRingBuf(m_writePoint, filtered[0] + s[0] * feedback, filtered[1] + s[1] * feedback);
 			
 		buf[f][0] = d * buf[f][0] + w * s[0];
 		buf[f][1] = d * buf[f][1] + w * s[1];
@@ -253,12 +255,7 @@ void GranularPitchShifterEffect::changeSampleRate()
 	m_nyquist = m_sampleRate / 2;
 	
 	m_ringBufLength = m_sampleRate * ringBufLength;
-	m_ringBuf.resize(m_ringBufLength);
-	for (size_t i = 0; i < static_cast<std::size_t>(m_ringBufLength); ++i)
-	{
-		m_ringBuf[i][0] = 0;
-		m_ringBuf[i][1] = 0;
-	}
+	m_ringBuf.assign(m_ringBufLength + 3, {0, 0});
 	m_writePoint = 0;
 	
 	m_oldGlide = -1;
@@ -267,7 +264,6 @@ void GranularPitchShifterEffect::changeSampleRate()
 	
 	m_grains.clear();
 	m_grainCount = 0;
-	m_grains.reserve(8);// arbitrary
 	
 	m_dcCoeff = std::exp(-2 * std::numbers::pi_v<float> * DcRemovalHz / m_sampleRate);
 
@@ -42,6 +42,8 @@ constexpr float RangeSeconds[5] = {5, 10, 40, 40, 120};
 constexpr float DcRemovalHz = 7.f;
 constexpr float SatuSafeVol = 16.f;
 constexpr float SatuStrength = 0.001f;
+// at the highest density and twitch, grains overlap about 64 times, the rest is headroom for when the size shrinks
+constexpr int MaxGrains = 128;
 
 
 class GranularPitchShifterEffect : public Effect
@@ -63,25 +65,18 @@ public:
 		const auto index_floor = static_cast<std::size_t>(index);
 		const double fraction = index - index_floor;
 		
-		float v0, v1, v2, v3;
-
-		if (index_floor == 0) { v0 = m_ringBuf[m_ringBuf.size() - 1][ch]; }
-		else { v0 = m_ringBuf[index_floor - 1][ch]; }
-		
-		v1 = m_ringBuf[index_floor][ch];
-		
-		if(index_floor >= m_ringBuf.size() - 2)
-		{
-			v2 = m_ringBuf[(index_floor + 1) % m_ringBuf.size()][ch];
-			v3 = m_ringBuf[(index_floor + 2) % m_ringBuf.size()][ch];
-		}
-		else
-		{
-			v2 = m_ringBuf[index_floor + 1][ch];
-			v3 = m_ringBuf[index_floor + 2][ch];
-		}
-		
-		return hermiteInterpolate(v0, v1, v2, v3, static_cast<float>(fraction));
+		// the ring buffer is padded with copies of the frames around the wrap point, see writeRingBuf()
+		const auto* v = &m_ringBuf[index_floor];
+		return hermiteInterpolate(v[0][ch], v[1][ch], v[2][ch], v[3][ch], static_cast<float>(fraction));
+	}
+	
+	// frame i is stored at i + 1, with the last frame also before the first one
+	// and the first two also after the last one, so reading never needs to wrap around
+	void writeRingBuf(int index, float left, float right)
+	{
+		m_ringBuf[index + 1] = {left, right};
+		if (index == m_ringBufLength - 1) { m_ringBuf[0] = {left, right}; }
+		if (index < 2) { m_ringBuf[m_ringBufLength + 1 + index] = {left, right}; }
 	}
 	
 	// adapted from signalsmith's crossfade approximation:
@@ -1,6 +1,8 @@
 #include "HydrogenImport.h"
 
 #include <QDomDocument>
+#include <QStringList>
+#include <vector>
 
 #include "LocalFileMng.h"
 #include "Song.h"
@@ -10,6 +12,7 @@
 #include "Note.h"
 #include "MidiClip.h"
 #include "PatternStore.h"
+#include "SampleCache.h"
 #include "Track.h"
 
 #include "plugin_export.h"
@@ -169,6 +172,20 @@ bool HydrogenImport::readSong()
 	QString sMode = LocalFileMng::readXmlString( songNode, "mode", "pattern" );
 
 	QDomNode instrumentListNode = songNode.firstChildElement( "instrumentList" );
+
+	// Start decoding the samples of all instruments in the background; the
+	// instruments created below then take them from the cache without
+	// waiting, and instruments sharing a sample share its buffer
+	QStringList sampleFiles;
+	for (QDomElement instrumentNode = instrumentListNode.firstChildElement("instrument");
+		!instrumentNode.isNull(); instrumentNode = instrumentNode.nextSiblingElement("instrument"))
+	{
+		QDomElement componentNode = instrumentNode.firstChildElement("instrumentComponent");
+		if (componentNode.isNull()) { componentNode = instrumentNode; }
+		const QString sampleFile = LocalFileMng::readXmlString(componentNode.firstChildElement("layer"), "filename", "", true, false);
+		if (!sampleFile.isEmpty() && !sampleFiles.contains(sampleFile)) { sampleFiles << sampleFile; }
+	}
+	const auto prefetchedSamples = SampleCache::prefetch(sampleFiles);
 	if ( ( ! instrumentListNode.isNull()  ) ) 
 	{
 
@@ -264,6 +281,7 @@ bool HydrogenImport::readSong()
 		nSize = LocalFileMng::readXmlInt( patternNode, "size", nSize, false, false );
 		pattern_length[sName] = nSize;
 		QDomNode pNoteListNode = patternNode.firstChildElement( "noteList" );
+		QHash<MidiClip*, std::vector<Note>> patternNotes;
 		if ( ! pNoteListNode.isNull() ) {
 			QDomNode noteNode = pNoteListNode.firstChildElement( "note" );
 			while ( ! noteNode.isNull()  ) {
@@ -291,11 +309,15 @@ bool HydrogenImport::readSong()
 				n.setVolume( fVelocity * 100 );
 				n.setPanning( ( fPan_R - fPan_L ) * 100 );
 				n.setKey( NoteKey::stringToNoteKey( sKey ) );
-				p->addNote( n,false );
+				patternNotes[p].push_back(n);
 				pn = pn + 1;
 				noteNode = ( QDomNode ) noteNode.nextSiblingElement( "note" );
 			}        
 		}
+		for (auto it = patternNotes.begin(); it != patternNotes.end(); ++it)
+		{
+			it.key()->addNotes(it.value(), false);
+		}
 		patternNode = ( QDomNode ) patternNode.nextSiblingElement( "pattern" );
 	}
 	// MidiClip sequence
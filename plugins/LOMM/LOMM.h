@@ -51,6 +51,12 @@ public:
 	{
 		return &m_lommControls;
 	}
+
+	//! With lookahead, the audio is delayed by the whole lookahead buffer
+	f_cnt_t latency() const override
+	{
+		return m_lommControls.m_lookaheadEnableModel.value() ? m_lookBufLength : 0;
+	}
 	
 	inline float msToCoeff(float ms)
 	{
@@ -24,8 +24,8 @@
  */
 
 
-#include <QVarLengthArray>
 #include <QMessageBox>
+#include <algorithm>
 
 #include "LadspaEffect.h"
 #include "DataFile.h"
@@ -139,73 +139,53 @@ Effect::ProcessStatus LadspaEffect::processImpl(SampleFrame* buf, const fpp_t fr
 
 	auto outFrames = frames;
 	SampleFrame* outBuf = nullptr;
-	QVarLengthArray<SampleFrame> sBuf(frames);
 
-	if( m_maxSampleRate < Engine::audioEngine()->outputSampleRate() )
+	// Only the few plugins limited to a lower sample rate need resampling,
+	// all others run at the engine's rate directly on the period
+	if (!m_resampleBuffer.empty())
 	{
 		outBuf = buf;
-		buf = sBuf.data();
+		buf = m_resampleBuffer.data();
 		sampleDown(outBuf, buf, m_maxSampleRate);
 		outFrames = frames * m_maxSampleRate /
 				Engine::audioEngine()->outputSampleRate();
 	}
 
-	// Copy the LMMS audio buffer to the LADSPA input buffer and initialize
-	// the control ports.
-	ch_cnt_t channel = 0;
-	for( ch_cnt_t proc = 0; proc < processorCount(); ++proc )
+	// Copy the LMMS audio buffer to the LADSPA input buffers, which stay
+	// connected to the ports, and initialize the control ports.
+	for (std::size_t channel = 0; channel < m_channelIns.size(); ++channel)
 	{
-		for( int port = 0; port < m_portCount; ++port )
+		LADSPA_Data* buffer = m_channelIns[channel]->buffer;
+		for (fpp_t frame = 0; frame < outFrames; ++frame)
 		{
-			port_desc_t * pp = m_ports.at( proc ).at( port );
-			switch( pp->rate )
+			buffer[frame] = buf[frame][channel];
+		}
+	}
+	for (port_desc_t* pp : m_portControls)
+	{
+		if (pp->rate == BufferRate::AudioRateInput)
+		{
+			ValueBuffer * vb = pp->control->valueBuffer();
+			if( vb )
 			{
-				case BufferRate::ChannelIn:
-					for (fpp_t frame = 0; frame < outFrames; ++frame)
-					{
-						pp->buffer[frame] = buf[frame][channel];
-					}
-					++channel;
-					break;
-				case BufferRate::AudioRateInput:
-				{
-					ValueBuffer * vb = pp->control->valueBuffer();
-					if( vb )
-					{
-						memcpy(pp->buffer, vb->values(), outFrames * sizeof(float));
-					}
-					else
-					{
-						pp->value = static_cast<LADSPA_Data>(
-											pp->control->value() / pp->scale );
-						// This only supports control rate ports, so the audio rates are
-						// treated as though they were control rate by setting the
-						// port buffer to all the same value.
-						for (fpp_t frame = 0; frame < outFrames; ++frame)
-						{
-							pp->buffer[frame] = pp->value;
-						}
-					}
-					break;
-				}
-				case BufferRate::ControlRateInput:
-					if( pp->control == nullptr )
-					{
-						break;
-					}
-					pp->value = static_cast<LADSPA_Data>(
-										pp->control->value() / pp->scale );
-					pp->buffer[0] =
-						pp->value;
-					break;
-				case BufferRate::ChannelOut:
-				case BufferRate::AudioRateOutput:
-				case BufferRate::ControlRateOutput:
-					break;
-				default:
-					break;
+				memcpy(pp->buffer, vb->values(), outFrames * sizeof(float));
+			}
+			else
+			{
+				pp->value = static_cast<LADSPA_Data>(
+									pp->control->value() / pp->scale );
+				// This only supports control rate ports, so the audio rates are
+				// treated as though they were control rate by setting the
+				// port buffer to all the same value.
+				std::fill_n(pp->buffer, outFrames, pp->value);
 			}
 		}
+		else if (pp->control != nullptr)
+		{
+			pp->value = static_cast<LADSPA_Data>(
+								pp->control->value() / pp->scale );
+			pp->buffer[0] = pp->value;
+		}
 	}
 
 
@@ -216,33 +196,14 @@ Effect::ProcessStatus LadspaEffect::processImpl(SampleFrame* buf, const fpp_t fr
 	}
 
 	// Copy the LADSPA output buffers to the LMMS buffer.
-	channel = 0;
 	const float d = dryLevel();
 	const float w = wetLevel();
-	for( ch_cnt_t proc = 0; proc < processorCount(); ++proc )
+	for (std::size_t channel = 0; channel < m_channelOuts.size(); ++channel)
 	{
-		for( int port = 0; port < m_portCount; ++port )
+		const LADSPA_Data* buffer = m_channelOuts[channel]->buffer;
+		for (fpp_t frame = 0; frame < outFrames; ++frame)
 		{
-			port_desc_t * pp = m_ports.at( proc ).at( port );
-			switch( pp->rate )
-			{
-				case BufferRate::ChannelIn:
-				case BufferRate::AudioRateInput:
-				case BufferRate::ControlRateInput:
-					break;
-				case BufferRate::ChannelOut:
-					for (fpp_t frame = 0; frame < outFrames; ++frame)
-					{
-						buf[frame][channel] = d * buf[frame][channel] + w * pp->buffer[frame];
-					}
-					++channel;
-					break;
-				case BufferRate::AudioRateOutput:
-				case BufferRate::ControlRateOutput:
-					break;
-				default:
-					break;
-			}
+			buf[frame][channel] = d * buf[frame][channel] + w * buffer[frame];
 		}
 	}
 
@@ -274,6 +235,10 @@ void LadspaEffect::setControl( int _control, LADSPA_Data _value )
 void LadspaEffect::pluginInstantiation()
 {
 	m_maxSampleRate = maxSamplerate( displayName() );
+	if( m_maxSampleRate < Engine::audioEngine()->outputSampleRate() )
+	{
+		m_resampleBuffer.resize( Engine::audioEngine()->maxFramesPerPeriod() );
+	}
 
 	Ladspa2LMMS * manager = Engine::getLADSPAManager();
 
@@ -312,7 +277,7 @@ void LadspaEffect::pluginInstantiation()
 					manager->isPortInput( m_key, port ) )
 				{
 					p->rate = BufferRate::ChannelIn;
-					p->buffer = new LADSPA_Data[Engine::audioEngine()->framesPerPeriod()];
+					p->buffer = new LADSPA_Data[Engine::audioEngine()->maxFramesPerPeriod()];
 					inbuf[ inputch ] = p->buffer;
 					inputch++;
 				}
@@ -327,19 +292,19 @@ void LadspaEffect::pluginInstantiation()
 					}
 					else
 					{
-						p->buffer = new LADSPA_Data[Engine::audioEngine()->framesPerPeriod()];
+						p->buffer = new LADSPA_Data[Engine::audioEngine()->maxFramesPerPeriod()];
 						m_inPlaceBroken = true;
 					}
 				}
 				else if( manager->isPortInput( m_key, port ) )
 				{
 					p->rate = BufferRate::AudioRateInput;
-					p->buffer = new LADSPA_Data[Engine::audioEngine()->framesPerPeriod()];
+					p->buffer = new LADSPA_Data[Engine::audioEngine()->maxFramesPerPeriod()];
 				}
 				else
 				{
 					p->rate = BufferRate::AudioRateOutput;
-					p->buffer = new LADSPA_Data[Engine::audioEngine()->framesPerPeriod()];
+					p->buffer = new LADSPA_Data[Engine::audioEngine()->maxFramesPerPeriod()];
 				}
 			}
 			else
@@ -449,6 +414,16 @@ void LadspaEffect::pluginInstantiation()
 
 			ports.append( p );
 
+			// The audio channels in the order they are interleaved in
+			if( p->rate == BufferRate::ChannelIn )
+			{
+				m_channelIns.push_back( p );
+			}
+			else if( p->rate == BufferRate::ChannelOut )
+			{
+				m_channelOuts.push_back( p );
+			}
+
 	// For convenience, keep a separate list of the ports that are used
 	// to control the processors.
 			if( p->rate == BufferRate::AudioRateInput ||
@@ -552,6 +527,9 @@ void LadspaEffect::pluginDestruction()
 	m_ports.clear();
 	m_handles.clear();
 	m_portControls.clear();
+	m_channelIns.clear();
+	m_channelOuts.clear();
+	m_resampleBuffer.clear();
 }
 
 
@@ -27,6 +27,7 @@
 #define _LADSPA_EFFECT_H
 
 #include <QMutex>
+#include <vector>
 
 #include "Effect.h"
 #include "ladspa.h"
@@ -90,6 +91,11 @@ private:
 
 	QVector<multi_proc_t> m_ports;
 	multi_proc_t m_portControls;
+	//! Audio ports of all processors, one per channel of the LMMS buffer
+	std::vector<port_desc_t*> m_channelIns;
+	std::vector<port_desc_t*> m_channelOuts;
+	//! Only allocated if the plugin must run at a lower sample rate
+	std::vector<SampleFrame> m_resampleBuffer;
 
 	ch_cnt_t m_processors = 1;
 };
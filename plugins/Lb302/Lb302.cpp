@@ -499,6 +499,26 @@ int Lb302Synth::process(SampleFrame* outbuf, const std::size_t size)
 	// hard coded value of 0.99897516.
 	auto decay = computeDecayFactor(0.245260770975f, 1.f / 65536.f);
 
+	// the shape, the slide decay and the attack time don't change during a period
+	switch(int(rint(wave_shape.value()))) {
+		case 0: vco_shape = VcoShape::Sawtooth; break;
+		case 1: vco_shape = VcoShape::Triangle; break;
+		case 2: vco_shape = VcoShape::Square; break;
+		case 3: vco_shape = VcoShape::RoundSquare; break;
+		case 4: vco_shape = VcoShape::Moog; break;
+		case 5: vco_shape = VcoShape::Sine; break;
+		case 6: vco_shape = VcoShape::Exponential; break;
+		case 7: vco_shape = VcoShape::WhiteNoise; break;
+		case 8: vco_shape = VcoShape::BLSawtooth; break;
+		case 9: vco_shape = VcoShape::BLSquare; break;
+		case 10: vco_shape = VcoShape::BLTriangle; break;
+		case 11: vco_shape = VcoShape::BLMoog; break;
+		default:  vco_shape = VcoShape::Sawtooth; break;
+	}
+
+	const float slideDecay = (0.1f - slide_dec_knob.value() * 0.0999f) * sampleRatio;
+	const float attackSamples = 0.5f * Engine::audioEngine()->outputSampleRate();
+
 	for (auto i = std::size_t{0}; i < size; i++)
 	{
 		// start decay if we're past release
@@ -513,7 +533,7 @@ int Lb302Synth::process(SampleFrame* outbuf, const std::size_t size)
 			if (vco_slide) {
 					vco_inc = vco_slidebase - vco_slide;
 					// Calculate coeff from dec_knob on knob change.
-					vco_slide -= vco_slide * ( 0.1f - slide_dec_knob.value() * 0.0999f ) * sampleRatio; // TODO: Adjust for ENVINC
+					vco_slide -= vco_slide * slideDecay; // TODO: Adjust for ENVINC
 
 			}
 		}
@@ -530,22 +550,6 @@ int Lb302Synth::process(SampleFrame* outbuf, const std::size_t size)
 		if(vco_c > 0.5)
 			vco_c -= 1.0;
 
-		switch(int(rint(wave_shape.value()))) {
-			case 0: vco_shape = VcoShape::Sawtooth; break;
-			case 1: vco_shape = VcoShape::Triangle; break;
-			case 2: vco_shape = VcoShape::Square; break;
-			case 3: vco_shape = VcoShape::RoundSquare; break;
-			case 4: vco_shape = VcoShape::Moog; break;
-			case 5: vco_shape = VcoShape::Sine; break;
-			case 6: vco_shape = VcoShape::Exponential; break;
-			case 7: vco_shape = VcoShape::WhiteNoise; break;
-			case 8: vco_shape = VcoShape::BLSawtooth; break;
-			case 9: vco_shape = VcoShape::BLSquare; break;
-			case 10: vco_shape = VcoShape::BLTriangle; break;
-			case 11: vco_shape = VcoShape::BLMoog; break;
-			default:  vco_shape = VcoShape::Sawtooth; break;
-		}
-
 		// add vco_shape_param the changes the shape of each curve.
 		// merge sawtooths with triangle and square with round square?
 		switch (vco_shape) {
@@ -646,7 +650,7 @@ int Lb302Synth::process(SampleFrame* outbuf, const std::size_t size)
 		// Handle Envelope
 		if(vca_mode==VcaMode::Attack) {
 			vca_a+=(vca_a0-vca_a)*vca_attack;
-			if(sample_cnt>=0.5*Engine::audioEngine()->outputSampleRate())
+			if(sample_cnt >= attackSamples)
 				vca_mode = VcaMode::Idle;
 		}
 		else if(vca_mode == VcaMode::Decay) {
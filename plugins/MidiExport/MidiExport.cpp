@@ -27,11 +27,15 @@
 
 #include "MidiExport.h"
 
-#include "TrackContainer.h"
-#include "DataFile.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <QFile>
+
 #include "InstrumentTrack.h"
-#include "LocaleHelper.h"
-#include "PatternTrack.h"
+#include "MidiClip.h"
+#include "SmfWriter.h"
+#include "TrackContainer.h"
 
 #include "plugin_export.h"
 
@@ -72,103 +76,60 @@ bool MidiExport::tryExport(const TrackContainer::TrackList &tracks,
 			int tempo, int masterPitch, const QString &filename)
 {
 	QFile f(filename);
-	f.open(QIODevice::WriteOnly);
-	QDataStream midiout(&f);
-
-	QDomElement element;
-
+	if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) { return false; }
 
 	int nTracks = 0;
-	auto buffer = std::array<uint8_t, BUFFER_SIZE>{};
-
 	for (const Track* track : tracks) if (track->type() == Track::Type::Instrument) nTracks++;
 	for (const Track* track : patternStoreTracks) if (track->type() == Track::Type::Instrument) nTracks++;
 
-	// midi header
-	MidiFile::MIDIHeader header(nTracks);
-	uint32_t size = header.writeToBuffer(buffer.data());
-	midiout.writeRawData((char *)buffer.data(), size);
+	// the notes are read from the live clips and written out track by track,
+	// so only the notes of one track are held at a time
+	SmfWriter smf(f);
+	if (!smf.writeHeader(nTracks)) { return false; }
+
+	const auto basePitch = [masterPitch](InstrumentTrack* track) {
+		return 69 - track->baseNoteModel()->value() + (track->useMasterPitchModel()->value() ? masterPitch : 0);
+	};
 
 	std::vector<std::vector<std::pair<int,int>>> plists;
 
 	// midi tracks
 	for (Track* track : tracks)
 	{
-		DataFile dataFile(DataFile::Type::SongProject);
-		MTrack mtrack;
-
 		if (track->type() == Track::Type::Instrument)
 		{
-
-			mtrack.addName(track->name().toStdString(), 0);
-			//mtrack.addProgramChange(0, 0);
-			mtrack.addTempo(tempo, 0);
-
 			auto instTrack = dynamic_cast<InstrumentTrack *>(track);
-			element = instTrack->saveState(dataFile, dataFile.content());
-
-			int base_pitch = 0;
-			double base_volume = 1.0;
-			int base_time = 0;
+			const double base_volume = instTrack->volumeModel()->value() / 100.0;
 
 			MidiNoteVector midiClip;
-
-			for (QDomNode n = element.firstChild(); !n.isNull(); n = n.nextSibling())
+			for (const Clip* clip : track->getClips())
 			{
-
-				if (n.nodeName() == "instrumenttrack")
+				if (auto mc = dynamic_cast<const MidiClip*>(clip))
 				{
-					QDomElement it = n.toElement();
-					base_pitch = (69 - it.attribute("basenote", "69").toInt());
-					if (it.attribute("usemasterpitch", "1").toInt())
-					{
-						base_pitch += masterPitch;
-					}
-					base_volume = LocaleHelper::toDouble(it.attribute("volume", "100"))/100.0;
-				}
-
-				if (n.nodeName() == "midiclip")
-				{
-					base_time = n.toElement().attribute("pos", "0").toInt();
-					writeMidiClip(midiClip, n, base_pitch, base_volume, base_time);
+					writeMidiClip(midiClip, *mc, basePitch(instTrack), base_volume, mc->startPosition());
 				}
-
 			}
 			processPatternNotes(midiClip, INT_MAX);
-			writeMidiClipToTrack(mtrack, midiClip);
-			size = mtrack.writeToBuffer(buffer.data());
-			midiout.writeRawData((char *)buffer.data(), size);
+			if (!writeMidiClipToTrack(smf, *instTrack, tempo, midiClip)) { return false; }
 		}
 
 		if (track->type() == Track::Type::Pattern)
 		{
-			auto patternTrack = dynamic_cast<PatternTrack*>(track);
-			element = patternTrack->saveState(dataFile, dataFile.content());
-
 			std::vector<std::pair<int,int>> plist;
-			for (QDomNode n = element.firstChild(); !n.isNull(); n = n.nextSibling())
+			for (const Clip* clip : track->getClips())
 			{
-
-				if (n.nodeName() == "patternclip")
-				{
-					QDomElement it = n.toElement();
-					int pos = it.attribute("pos", "0").toInt();
-					int len = it.attribute("len", "0").toInt();
-					plist.emplace_back(pos, pos+len);
-				}
+				const int pos = clip->startPosition();
+				const int len = clip->length();
+				plist.emplace_back(pos, pos + len);
 			}
 			std::sort(plist.begin(), plist.end());
 			plists.push_back(plist);
-
 		}
 	} // for each track
 
 	// for each instrument in the pattern editor
 	for (Track* track : patternStoreTracks)
 	{
-		DataFile dataFile(DataFile::Type::SongProject);
-		MTrack mtrack;
-
 		// begin at the first pattern track (first pattern)
 		auto itr = plists.begin();
 
@@ -176,83 +137,67 @@ bool MidiExport::tryExport(const TrackContainer::TrackList &tracks,
 
 		if (track->type() != Track::Type::Instrument) continue;
 
-		mtrack.addName(track->name().toStdString(), 0);
-		//mtrack.addProgramChange(0, 0);
-		mtrack.addTempo(tempo, 0);
-
 		auto instTrack = dynamic_cast<InstrumentTrack *>(track);
-		element = instTrack->saveState(dataFile, dataFile.content());
+		const double base_volume = instTrack->volumeModel()->value() / 100.0;
 
-		int base_pitch = 0;
-		double base_volume = 1.0;
+		MidiNoteVector trackNotes;
 
 		// for each pattern in the pattern editor
-		for (QDomNode n = element.firstChild(); !n.isNull(); n = n.nextSibling())
+		for (const Clip* clip : track->getClips())
 		{
-			if (n.nodeName() == "instrumenttrack")
-			{
-				QDomElement it = n.toElement();
-				base_pitch = (69 - it.attribute("basenote", "69").toInt());
-				if (it.attribute("usemasterpitch", "1").toInt())
-				{
-					base_pitch += masterPitch;
-				}
-				base_volume = LocaleHelper::toDouble(it.attribute("volume", "100")) / 100.0;
-			}
+			auto mc = dynamic_cast<const MidiClip*>(clip);
+			if (!mc || itr == plists.end()) { continue; }
 
-			if (n.nodeName() == "midiclip")
-			{
-				std::vector<std::pair<int,int>> &plist = *itr;
+			std::vector<std::pair<int,int>> &plist = *itr;
 
-				MidiNoteVector nv, midiClip;
-				writeMidiClip(midiClip, n, base_pitch, base_volume, 0);
+			MidiNoteVector nv, midiClip;
+			writeMidiClip(midiClip, *mc, basePitch(instTrack), base_volume, 0);
 
+			// FIXME better variable names and comments
+			int pos = 0;
+			int len = mc->steps() * (DefaultTicksPerBar / DefaultStepsPerBar);
 
-				// FIXME better variable names and comments
-				int pos = 0;
-				int len = n.toElement().attribute("steps", "1").toInt() * 12;
+			// for each pattern clip of the current pattern track (in song editor)
+			for (const auto& position : plist)
+			{
+				const auto& [start, end] = position;
+				while (!st.empty() && st.back().second <= start)
+				{
+					writePatternClip(midiClip, nv, len, st.back().first, pos, st.back().second);
+					pos = st.back().second;
+					st.pop_back();
+				}
 
-				// for each pattern clip of the current pattern track (in song editor)
-				for (const auto& position : plist)
+				if (!st.empty() && st.back().second <= end)
 				{
-					const auto& [start, end] = position;
-					while (!st.empty() && st.back().second <= start)
+					writePatternClip(midiClip, nv, len, st.back().first, pos, start);
+					pos = start;
+					while (!st.empty() && st.back().second <= end)
 					{
-						writePatternClip(midiClip, nv, len, st.back().first, pos, st.back().second);
-						pos = st.back().second;
 						st.pop_back();
 					}
-
-					if (!st.empty() && st.back().second <= end)
-					{
-						writePatternClip(midiClip, nv, len, st.back().first, pos, start);
-						pos = start;
-						while (!st.empty() && st.back().second <= end)
-						{
-							st.pop_back();
-						}
-					}
-
-					st.push_back(position);
-					pos = start;
 				}
 
-				while (!st.empty())
-				{
-					writePatternClip(midiClip, nv, len, st.back().first, pos, st.back().second);
-					pos = st.back().second;
-					st.pop_back();
-				}
-
-				processPatternNotes(nv, pos);
-				writeMidiClipToTrack(mtrack, nv);
+				st.push_back(position);
+				pos = start;
+			}
 
-				// next pattern track
-				++itr;
+			while (!st.empty())
+			{
+				writePatternClip(midiClip, nv, len, st.back().first, pos, st.back().second);
+				pos = st.back().second;
+				st.pop_back();
 			}
+
+			processPatternNotes(nv, pos);
+			trackNotes.insert(trackNotes.end(), nv.begin(), nv.end());
+
+			// next pattern track
+			++itr;
 		}
-		size = mtrack.writeToBuffer(buffer.data());
-		midiout.writeRawData((char *)buffer.data(), size);
+
+		std::stable_sort(trackNotes.begin(), trackNotes.end());
+		if (!writeMidiClipToTrack(smf, *instTrack, tempo, trackNotes)) { return false; }
 	}
 
 	return true;
@@ -261,34 +206,37 @@ bool MidiExport::tryExport(const TrackContainer::TrackList &tracks,
 
 
 
-void MidiExport::writeMidiClip(MidiNoteVector &midiClip, const QDomNode& n,
+void MidiExport::writeMidiClip(MidiNoteVector &midiClip, const MidiClip& clip,
 				int base_pitch, double base_volume, int base_time)
 {
-	// TODO interpret steps="12" muted="0" type="1" name="Piano1"  len="2592"
-	for (QDomNode nn = n.firstChild(); !nn.isNull(); nn = nn.nextSibling())
+	midiClip.reserve(midiClip.size() + clip.notes().size());
+	for (const Note* note : clip.notes())
 	{
-		QDomElement note = nn.toElement();
-		if (note.attribute("len", "0") == "0") continue;
-		// TODO interpret pan="0" mixch="0" pitchrange="1"
+		if (note->length() == 0) continue;
+		// TODO interpret panning and detuning
 		MidiNote mnote;
-		mnote.pitch = qMax(0, qMin(127, note.attribute("key", "0").toInt() + base_pitch));
+		mnote.pitch = qMax(0, qMin(127, note->key() + base_pitch));
 		 // Map from LMMS volume to MIDI velocity
-		mnote.volume = qMin(qRound(base_volume * LocaleHelper::toDouble(note.attribute("vol", "100")) * (127.0 / 200.0)), 127);
-		mnote.time = base_time + note.attribute("pos", "0").toInt();
-		mnote.duration = note.attribute("len", "0").toInt();
-		mnote.type = static_cast<Note::Type>(note.attribute("type", "0").toInt());
+		mnote.volume = qMin(qRound(base_volume * note->getVolume() * (127.0 / 200.0)), 127);
+		mnote.time = base_time + note->pos();
+		mnote.duration = note->length();
+		mnote.type = note->type();
 		midiClip.push_back(mnote);
 	}
 }
 
 
 
-void MidiExport::writeMidiClipToTrack(MTrack &mtrack, MidiNoteVector &nv)
+bool MidiExport::writeMidiClipToTrack(SmfWriter& smf, const InstrumentTrack& track, int tempo, MidiNoteVector& nv)
 {
+	smf.beginTrack();
+	smf.writeTrackName(track.name());
+	smf.writeTempo(tempo);
 	for (const auto& note : nv)
 	{
-		mtrack.addNote(note.pitch, note.volume, note.time / 48.0, note.duration / 48.0);
+		smf.writeNote(std::max(note.time, 0), std::max(note.duration, 0), note.pitch, note.volume);
 	}
+	return smf.endTrack();
 }
 
 
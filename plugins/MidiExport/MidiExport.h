@@ -26,19 +26,19 @@
 #ifndef _MIDI_EXPORT_H
 #define _MIDI_EXPORT_H
 
+#include <cstdint>
+#include <vector>
 
 #include "ExportFilter.h"
-#include "MidiFile.hpp"
 #include "Note.h"
 
-class QDomNode;
-
 namespace lmms
 {
 
+class InstrumentTrack;
+class MidiClip;
+class SmfWriter;
 
-const int BUFFER_SIZE = 50*1024;
-using MTrack = MidiFile::MIDITrack<BUFFER_SIZE>;
 
 struct MidiNote
 {
@@ -84,9 +84,9 @@ public:
 				int tempo, int masterPitch, const QString &filename) override;
 	
 private:
-	void writeMidiClip(MidiNoteVector &midiClip, const QDomNode& n,
+	void writeMidiClip(MidiNoteVector &midiClip, const MidiClip& clip,
 				int base_pitch, double base_volume, int base_time);
-	void writeMidiClipToTrack(MTrack &mtrack, MidiNoteVector &nv);
+	bool writeMidiClipToTrack(SmfWriter& smf, const InstrumentTrack& track, int tempo, MidiNoteVector& nv);
 	void writePatternClip(MidiNoteVector &src, MidiNoteVector &dst,
 				int len, int base, int start, int end);
 	void processPatternNotes(MidiNoteVector &nv, int cutPos);
@@ -0,0 +1,217 @@
+/*
+ * SmfWriter.cpp - writes Standard MIDI Files as the events come in
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "SmfWriter.h"
+
+#include <algorithm>
+#include <array>
+#include <QIODevice>
+#include <QString>
+
+#include "TimePos.h"
+
+namespace lmms
+{
+
+namespace
+{
+
+constexpr int BufferSize = 64 * 1024;
+constexpr std::uint8_t Channel = 0;
+constexpr std::uint8_t ReleaseVelocity = 64;
+
+} // namespace
+
+
+SmfWriter::SmfWriter(QIODevice& out) :
+	m_out(out)
+{
+	m_buffer.reserve(BufferSize + 256);
+}
+
+
+
+
+SmfWriter::~SmfWriter()
+{
+	flush();
+}
+
+
+
+
+bool SmfWriter::writeHeader(int trackCount)
+{
+	m_buffer.append("MThd", 4);
+	writeBigEndian(6, 4);
+	writeBigEndian(1, 2); // one track per instrument, played at once
+	writeBigEndian(static_cast<std::uint32_t>(std::clamp(trackCount, 0, 0xffff)), 2);
+	writeBigEndian(DefaultTicksPerBar / 4, 2); // ticks per quarter note
+	return flush();
+}
+
+
+
+
+void SmfWriter::beginTrack()
+{
+	m_buffer.append("MTrk", 4);
+	m_trackStart = m_out.pos() + m_buffer.size();
+	writeBigEndian(0, 4); // filled in by endTrack()
+	m_lastTime = 0;
+}
+
+
+
+
+void SmfWriter::writeTrackName(const QString& name)
+{
+	const auto utf8 = name.toUtf8();
+	writeVarLength(0);
+	m_buffer.append('\xff');
+	m_buffer.append('\x03');
+	writeVarLength(static_cast<std::uint32_t>(utf8.size()));
+	m_buffer.append(utf8);
+}
+
+
+
+
+void SmfWriter::writeTempo(int bpm)
+{
+	const auto microsecondsPerBeat = static_cast<std::uint32_t>(60000000 / std::max(bpm, 1));
+	writeVarLength(0);
+	m_buffer.append('\xff');
+	m_buffer.append('\x51');
+	m_buffer.append('\x03');
+	writeBigEndian(microsecondsPerBeat, 3);
+}
+
+
+
+
+void SmfWriter::writeNote(std::uint32_t time, std::uint32_t length, std::uint8_t key, std::uint8_t velocity)
+{
+	time = std::max(time, m_lastTime);
+	writeNoteOffsUntil(time);
+	writeEvent(time, {static_cast<std::uint8_t>(0x90 | Channel), key, velocity});
+	m_noteOffs.emplace(time + length, key);
+
+	if (m_buffer.size() >= BufferSize) { flush(); }
+}
+
+
+
+
+bool SmfWriter::endTrack()
+{
+	writeNoteOffsUntil(UINT32_MAX);
+	writeEvent(m_lastTime, {0xff, 0x2f, 0x00});
+	if (!flush()) { return false; }
+
+	const auto end = m_out.pos();
+	const auto length = static_cast<std::uint32_t>(end - m_trackStart - 4);
+	if (!m_out.seek(m_trackStart)) { return false; }
+	writeBigEndian(length, 4);
+	return flush() && m_out.seek(end);
+}
+
+
+
+
+void SmfWriter::writeEvent(std::uint32_t time, std::initializer_list<std::uint8_t> bytes)
+{
+	writeDeltaTime(time);
+	for (const auto byte : bytes)
+	{
+		m_buffer.append(static_cast<char>(byte));
+	}
+}
+
+
+
+
+void SmfWriter::writeDeltaTime(std::uint32_t time)
+{
+	writeVarLength(time - m_lastTime);
+	m_lastTime = time;
+}
+
+
+
+
+void SmfWriter::writeVarLength(std::uint32_t value)
+{
+	// 7 bits per byte, most significant first, all but the last one with the top bit set
+	auto bytes = std::array<char, 5>{};
+	auto count = std::size_t{0};
+	do
+	{
+		bytes[count++] = static_cast<char>(value & 0x7f);
+		value >>= 7;
+	} while (value > 0);
+
+	while (count > 0)
+	{
+		--count;
+		m_buffer.append(static_cast<char>(bytes[count] | (count > 0 ? 0x80 : 0)));
+	}
+}
+
+
+
+
+void SmfWriter::writeBigEndian(std::uint32_t value, int bytes)
+{
+	for (int shift = (bytes - 1) * 8; shift >= 0; shift -= 8)
+	{
+		m_buffer.append(static_cast<char>((value >> shift) & 0xff));
+	}
+}
+
+
+
+
+void SmfWriter::writeNoteOffsUntil(std::uint32_t time)
+{
+	while (!m_noteOffs.empty() && m_noteOffs.top().first <= time)
+	{
+		const auto [offTime, key] = m_noteOffs.top();
+		m_noteOffs.pop();
+		writeEvent(offTime, {static_cast<std::uint8_t>(0x80 | Channel), key, ReleaseVelocity});
+	}
+}
+
+
+
+
+bool SmfWriter::flush()
+{
+	if (!m_buffer.isEmpty())
+	{
+		m_failed = m_failed || m_out.write(m_buffer) != m_buffer.size();
+		m_buffer.resize(0); // keeps the reserved capacity, unlike clear()
+	}
+	return !m_failed;
+}
+
+} // namespace lmms
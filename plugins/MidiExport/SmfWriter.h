@@ -0,0 +1,88 @@
+/*
+ * SmfWriter.h - writes Standard MIDI Files as the events come in
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_SMF_WRITER_H
+#define LMMS_SMF_WRITER_H
+
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include <QByteArray>
+
+class QIODevice;
+class QString;
+
+namespace lmms
+{
+
+/**
+ * Writes a format 1 Standard MIDI File to a seekable device.
+ *
+ * Events are encoded and written while they are added, so memory use
+ * doesn't grow with the length of the song: only the note-offs of the notes
+ * still sounding are kept. The length of each track chunk is filled in when
+ * the track ends.
+ *
+ * Times are in LMMS ticks, which are also used as the file's division.
+ */
+class SmfWriter
+{
+public:
+	explicit SmfWriter(QIODevice& out);
+	~SmfWriter();
+
+	bool writeHeader(int trackCount);
+
+	void beginTrack();
+	void writeTrackName(const QString& name);
+	void writeTempo(int bpm);
+	//! Notes must be added in the order of their start times
+	void writeNote(std::uint32_t time, std::uint32_t length, std::uint8_t key, std::uint8_t velocity);
+	//! Ends the track started last, returns false if writing failed
+	bool endTrack();
+
+private:
+	void writeEvent(std::uint32_t time, std::initializer_list<std::uint8_t> bytes);
+	void writeDeltaTime(std::uint32_t time);
+	void writeVarLength(std::uint32_t value);
+	void writeBigEndian(std::uint32_t value, int bytes);
+	void writeNoteOffsUntil(std::uint32_t time);
+	bool flush();
+
+	QIODevice& m_out;
+	QByteArray m_buffer;
+	bool m_failed = false;
+
+	qint64 m_trackStart = 0;
+	std::uint32_t m_lastTime = 0;
+
+	//! (time, key) of the notes still sounding, earliest first
+	using NoteOff = std::pair<std::uint32_t, std::uint8_t>;
+	std::priority_queue<NoteOff, std::vector<NoteOff>, std::greater<>> m_noteOffs;
+};
+
+} // namespace lmms
+
+#endif // LMMS_SMF_WRITER_H
@@ -29,8 +29,12 @@
 #include <QMessageBox>
 #include <QProgressDialog>
 
+#include <algorithm>
+#include <chrono>
+#include <memory>
 #include <sstream>
 #include <unordered_map>
+#include <vector>
 
 #include "MidiImport.h"
 #include "TrackContainer.h"
@@ -44,6 +48,8 @@
 #include "MainWindow.h"
 #include "TimePos.h"
 #include "Song.h"
+#include "SongEditor.h"
+#include "ThreadPool.h"
 
 #include "plugin_export.h"
 
@@ -155,6 +161,8 @@ public:
 	AutomationTrack * at;
 	AutomationClip * ap;
 	TimePos lastPos;
+	//! Values for ap, put all at once by flush()
+	std::vector<std::pair<TimePos, float>> values;
 
 	smfMidiCC & create( TrackContainer* tc, QString tn )
 	{
@@ -175,6 +183,7 @@ public:
 
 	void clear()
 	{
+		flush();
 		at = nullptr;
 		ap = nullptr;
 		lastPos = 0;
@@ -185,6 +194,7 @@ public:
 	{
 		if( !ap || time > lastPos + DefaultTicksPerBar )
 		{
+			flush();
 			TimePos pPos = TimePos( time.getBar(), 0 );
 			ap = dynamic_cast<AutomationClip*>(
 				at->createClip(pPos));
@@ -192,12 +202,21 @@ public:
 		}
 
 		lastPos = time;
-		time = time - ap->startPosition();
-		ap->putValue( time, value, false );
-		ap->changeLength( TimePos( time.getBar() + 1, 0 ) );
+		values.emplace_back(time - ap->startPosition(), value);
 
 		return *this;
 	}
+
+
+	void flush()
+	{
+		if (ap && !values.empty())
+		{
+			ap->putValues(values);
+			ap->changeLength(TimePos(values.back().first.getBar() + 1, 0));
+		}
+		values.clear();
+	}
 };
 
 
@@ -220,6 +239,7 @@ public:
 	bool isSF2;
 	bool hasNotes;
 	QString trackName;
+	std::vector<Note> notes;
 
 	smfMidiChannel * create( TrackContainer* tc, QString tn )
 	{
@@ -261,11 +281,7 @@ public:
 
 	void addNote( Note & n )
 	{
-		if (!p)
-		{
-			p = dynamic_cast<MidiClip*>(it->createClip(0));
-		}
-		p->addNote(n, false);
+		notes.push_back(n);
 		hasNotes = true;
 	}
 
@@ -273,21 +289,29 @@ public:
 	{
 		MidiClip * newMidiClip = nullptr;
 		TimePos lastEnd(0);
+		std::vector<Note> clipNotes;
 
-		p->rearrangeAllNotes();
-		for (auto n : p->notes())
+		// each clip takes its notes at once, which keeps big files fast
+		std::stable_sort(notes.begin(), notes.end(),
+			[](const Note& lhs, const Note& rhs) { return Note::lessThan(&lhs, &rhs); });
+		for (const auto& n : notes)
 		{
-			if (!newMidiClip || n->pos() > lastEnd + DefaultTicksPerBar)
+			if (!newMidiClip || n.pos() > lastEnd + DefaultTicksPerBar)
 			{
-				TimePos pPos = TimePos(n->pos().getBar(), 0);
+				if (newMidiClip) { newMidiClip->addNotes(clipNotes, false); }
+				clipNotes.clear();
+
+				TimePos pPos = TimePos(n.pos().getBar(), 0);
 				newMidiClip = dynamic_cast<MidiClip*>(it->createClip(pPos));
 			}
-			lastEnd = n->pos() + n->length();
+			lastEnd = n.pos() + n.length();
 
-			Note newNote(*n);
-			newNote.setPos(n->pos(newMidiClip->startPosition()));
-			newMidiClip->addNote(newNote, false);
+			Note newNote(n);
+			newNote.setPos(n.pos(newMidiClip->startPosition()));
+			clipNotes.push_back(newNote);
 		}
+		if (newMidiClip) { newMidiClip->addNotes(clipNotes, false); }
+		notes.clear();
 
 		delete p;
 		p = nullptr;
@@ -308,9 +332,36 @@ bool MidiImport::readSMF( TrackContainer* tc )
 
 	pd.setValue( 0 );
 
-	std::istringstream stream(readAllData().toStdString());
-	auto seq = new Alg_seq(stream, true);
-	seq->convert_to_beats();
+	// Parse on a worker, so big files don't freeze the dialog
+	struct Parsed
+	{
+		std::unique_ptr<Alg_seq> seq;
+		std::unordered_map<long, std::size_t> noteCounts;
+	};
+	auto parsing = ThreadPool::instance().enqueue([data = readAllData().toStdString()] {
+		std::istringstream stream(data);
+		auto parsed = Parsed{std::make_unique<Alg_seq>(stream, true), {}};
+		parsed.seq->convert_to_beats();
+		for (int t = 0; t < parsed.seq->tracks(); ++t)
+		{
+			Alg_track_ptr trk = parsed.seq->track(t);
+			for (int e = 0; e < trk->length(); ++e)
+			{
+				if ((*trk)[e]->is_note()) { ++parsed.noteCounts[(*trk)[e]->chan]; }
+			}
+		}
+		return parsed;
+	});
+	while (parsing.wait_for(std::chrono::milliseconds(20)) != std::future_status::ready)
+	{
+		qApp->processEvents();
+	}
+	auto [seq, noteCounts] = parsing.get();
+
+	// The song editor would otherwise lay out and repaint itself for every
+	// track and clip created below
+	QWidget* songEditor = gui::getGUI()->songEditor();
+	songEditor->setUpdatesEnabled(false);
 
 	pd.setMaximum( seq->tracks()  + preTrackSteps );
 	pd.setValue( 1 );
@@ -325,6 +376,10 @@ bool MidiImport::readSMF( TrackContainer* tc )
 	// using unordered_map should fix most invalid loads and crashes while loading
 	std::unordered_map<long, smfMidiChannel> chs;
 	// NOTE: unordered_map::operator[] creates a new element if none exists
+	for (const auto& [chan, count] : noteCounts)
+	{
+		chs[chan].notes.reserve(count);
+	}
 
 	MeterModel & timeSigMM = Engine::getSong()->getTimeSigModel();
 	auto nt = dynamic_cast<AutomationTrack*>(Track::create(Track::Type::Automation, Engine::getSong()));
@@ -559,8 +614,16 @@ bool MidiImport::readSMF( TrackContainer* tc )
 		}
 	}
 
-	delete seq;
+	seq.reset();
 
+	for (auto& cc : ccs)
+	{
+		cc.flush();
+	}
+	for (auto& pc : pcs)
+	{
+		pc.second.flush();
+	}
 
 	for( auto& c: chs )
 	{
@@ -584,6 +647,8 @@ bool MidiImport::readSMF( TrackContainer* tc )
 		}
 	}
 
+	songEditor->setUpdatesEnabled(true);
+
 	return true;
 }
 
@@ -24,6 +24,8 @@
 
 #include "Monstro.h"
 
+#include <algorithm>
+#include <cmath>
 
 #include "ComboBox.h"
 #include "Engine.h"
@@ -104,44 +106,20 @@ MonstroSynth::MonstroSynth( MonstroInstrument * _i, NotePlayHandle * _nph ) :
 	m_lfo[1].resize( m_parent->m_fpp );
 	m_env[0].resize( m_parent->m_fpp );
 	m_env[1].resize( m_parent->m_fpp );
+
+	for( int i = 0; i < 3; ++i )
+	{
+		m_pitchMod[i].resize( m_parent->m_fpp );
+		m_phaseMod[i].resize( m_parent->m_fpp );
+		m_volumeMod[i].resize( m_parent->m_fpp );
+	}
+	m_pwMod.resize( m_parent->m_fpp );
+	m_subMod.resize( m_parent->m_fpp );
 }
 
 
 void MonstroSynth::renderOutput( fpp_t _frames, SampleFrame* _buf  )
 {
-	float modtmp; // temp variable for freq modulation
-// macros for modulating with env/lfos
-#define modulatefreq( car, mod ) \
-		modtmp = 0.0f; \
-		if( mod##_e1 != 0.0f ) modtmp += m_env[0][f] * mod##_e1; \
-		if( mod##_e2 != 0.0f ) modtmp += m_env[1][f] * mod##_e2; \
-		if( mod##_l1 != 0.0f ) modtmp += m_lfo[0][f] * mod##_l1; \
-		if( mod##_l2 != 0.0f ) modtmp += m_lfo[1][f] * mod##_l2; \
-		(car) = qBound( MIN_FREQ, (car) * std::exp2(modtmp), MAX_FREQ);
-
-#define modulateabs( car, mod ) \
-		if( mod##_e1 != 0.0f ) car += m_env[0][f] * mod##_e1; \
-		if( mod##_e2 != 0.0f ) car += m_env[1][f] * mod##_e2; \
-		if( mod##_l1 != 0.0f ) car += m_lfo[0][f] * mod##_l1; \
-		if( mod##_l2 != 0.0f ) car += m_lfo[1][f] * mod##_l2;
-
-#define modulatephs( car, mod ) \
-		if( mod##_e1 != 0.0f ) car += m_env[0][f] * mod##_e1; \
-		if( mod##_e2 != 0.0f ) car += m_env[1][f] * mod##_e2; \
-		if( mod##_l1 != 0.0f ) car += m_lfo[0][f] * mod##_l1; \
-		if( mod##_l2 != 0.0f ) car += m_lfo[1][f] * mod##_l2;
-
-#define modulatevol( car, mod ) \
-		if( mod##_e1 > 0.0f ) car *= ( 1.0f - mod##_e1 + mod##_e1 * m_env[0][f] ); \
-		if( mod##_e1 < 0.0f ) car *= ( 1.0f + mod##_e1 * m_env[0][f] );	\
-		if( mod##_e2 > 0.0f ) car *= ( 1.0f - mod##_e2 + mod##_e2 * m_env[1][f] );	\
-		if( mod##_e2 < 0.0f ) car *= ( 1.0f + mod##_e2 * m_env[1][f] );	\
-		if( mod##_l1 != 0.0f ) car *= ( 1.0f + mod##_l1 * m_lfo[0][f] ); \
-		if( mod##_l2 != 0.0f ) car *= ( 1.0f + mod##_l2 * m_lfo[1][f] ); \
-		car = qBound( -MODCLIP, car, MODCLIP );
-
-
-
 	////////////////////
 	//                //
 	//   MODULATORS   //
@@ -342,6 +320,29 @@ void MonstroSynth::renderOutput( fpp_t _frames, SampleFrame* _buf  )
 	// render modulators: envelopes, lfos
 	updateModulators( m_env[0].data(), m_env[1].data(), m_lfo[0].data(), m_lfo[1].data(), _frames );
 
+	// apply the modulation matrix to the whole block, the oscillators only read the results
+	if( o1f_mod ) { pitchModulation( m_pitchMod[0].data(), o1f_e1, o1f_e2, o1f_l1, o1f_l2, _frames ); }
+	if( o2f_mod ) { pitchModulation( m_pitchMod[1].data(), o2f_e1, o2f_e2, o2f_l1, o2f_l2, _frames ); }
+	if( o3f_mod ) { pitchModulation( m_pitchMod[2].data(), o3f_e1, o3f_e2, o3f_l1, o3f_l2, _frames ); }
+	if( o1p_mod ) { sumModulation( m_phaseMod[0].data(), o1p_e1, o1p_e2, o1p_l1, o1p_l2, _frames ); }
+	if( o2p_mod ) { sumModulation( m_phaseMod[1].data(), o2p_e1, o2p_e2, o2p_l1, o2p_l2, _frames ); }
+	if( o3p_mod ) { sumModulation( m_phaseMod[2].data(), o3p_e1, o3p_e2, o3p_l1, o3p_l2, _frames ); }
+	if( o1v_mod ) { volumeModulation( m_volumeMod[0].data(), o1v_e1, o1v_e2, o1v_l1, o1v_l2, _frames ); }
+	if( o2v_mod ) { volumeModulation( m_volumeMod[1].data(), o2v_e1, o2v_e2, o2v_l1, o2v_l2, _frames ); }
+	if( o3v_mod ) { volumeModulation( m_volumeMod[2].data(), o3v_e1, o3v_e2, o3v_l1, o3v_l2, _frames ); }
+	if( o1pw_mod )
+	{
+		sumModulation( m_pwMod.data(), o1pw_e1, o1pw_e2, o1pw_l1, o1pw_l2, _frames );
+		for( f_cnt_t f = 0; f < _frames; ++f ) { m_pwMod[f] = qBound( PW_MIN, pw + m_pwMod[f], PW_MAX ); }
+	}
+	if( o3s_mod )
+	{
+		sumModulation( m_subMod.data(), o3s_e1, o3s_e2, o3s_l1, o3s_l2, _frames );
+		for( f_cnt_t f = 0; f < _frames; ++f ) { m_subMod[f] = qBound( 0.0f, o3sub + m_subMod[f], 1.0f ); }
+	}
+
+	const float srInv = 1.0f / m_parent->m_samplerate;
+
 	// begin for loop
 	for( f_cnt_t f = 0; f < _frames; ++f )
 	{
@@ -364,24 +365,19 @@ void MonstroSynth::renderOutput( fpp_t _frames, SampleFrame* _buf  )
 		o1r_f = o1rfb;
 		if( o1f_mod )
 		{
-			modulatefreq( o1l_f, o1f )
-			modulatefreq( o1r_f, o1f )
+			o1l_f = qBound( MIN_FREQ, o1l_f * m_pitchMod[0][f], MAX_FREQ );
+			o1r_f = qBound( MIN_FREQ, o1r_f * m_pitchMod[0][f], MAX_FREQ );
 		}
 		// calc and modulate pulse
-		o1_pw = pw;
-		if( o1pw_mod )
-		{
-			modulateabs( o1_pw, o1pw )
-			o1_pw = qBound( PW_MIN, o1_pw, PW_MAX );
-		}
+		o1_pw = o1pw_mod ? m_pwMod[f] : pw;
 
 		// calc and modulate phase
 		leftph = o1l_p;
 		rightph = o1r_p;
 		if( o1p_mod )
 		{
-			modulatephs( leftph, o1p )
-			modulatephs( rightph, o1p )
+			leftph += m_phaseMod[0][f];
+			rightph += m_phaseMod[0][f];
 		}
 
 		// pulse wave osc
@@ -458,13 +454,13 @@ void MonstroSynth::renderOutput( fpp_t _frames, SampleFrame* _buf  )
 		O1R *= o1rv;
 		if( o1v_mod )
 		{
-			modulatevol( O1L, o1v )
-			modulatevol( O1R, o1v )
+			O1L = qBound( -MODCLIP, O1L * m_volumeMod[0][f], MODCLIP );
+			O1R = qBound( -MODCLIP, O1R * m_volumeMod[0][f], MODCLIP );
 		}
 
 		// update osc1 phase working variable
-		o1l_p += 1.0f / ( static_cast<float>( m_parent->m_samplerate ) / o1l_f );
-		o1r_p += 1.0f / ( static_cast<float>( m_parent->m_samplerate ) / o1r_f );
+		o1l_p += o1l_f * srInv;
+		o1r_p += o1r_f * srInv;
 
 		/////////////////////////////
 		//				           //
@@ -477,8 +473,8 @@ void MonstroSynth::renderOutput( fpp_t _frames, SampleFrame* _buf  )
 		o2r_f = o2rfb;
 		if( o2f_mod )
 		{
-			modulatefreq( o2l_f, o2f )
-			modulatefreq( o2r_f, o2f )
+			o2l_f = qBound( MIN_FREQ, o2l_f * m_pitchMod[1][f], MAX_FREQ );
+			o2r_f = qBound( MIN_FREQ, o2r_f * m_pitchMod[1][f], MAX_FREQ );
 		}
 
 		// calc and modulate phase
@@ -486,8 +482,8 @@ void MonstroSynth::renderOutput( fpp_t _frames, SampleFrame* _buf  )
 		rightph = o2r_p;
 		if( o2p_mod )
 		{
-			modulatephs( leftph, o2p )
-			modulatephs( rightph, o2p )
+			leftph += m_phaseMod[1][f];
+			rightph += m_phaseMod[1][f];
 		}
 		leftph = absFraction( leftph );
 		rightph = absFraction( rightph );
@@ -526,8 +522,8 @@ void MonstroSynth::renderOutput( fpp_t _frames, SampleFrame* _buf  )
 		O2R *= o2rv;
 		if( o2v_mod )
 		{
-			modulatevol( O2L, o2v )
-			modulatevol( O2R, o2v )
+			O2L = qBound( -MODCLIP, O2L * m_volumeMod[1][f], MODCLIP );
+			O2R = qBound( -MODCLIP, O2R * m_volumeMod[1][f], MODCLIP );
 		}
 
 		// reverse sync - invert waveforms when needed
@@ -537,8 +533,8 @@ void MonstroSynth::renderOutput( fpp_t _frames, SampleFrame* _buf  )
 		// update osc2 phases
 		m_ph2l_last = leftph;
 		m_ph2r_last = rightph;
-		o2l_p += 1.0f / ( static_cast<float>( m_parent->m_samplerate ) / o2l_f );
-		o2r_p += 1.0f / ( static_cast<float>( m_parent->m_samplerate ) / o2r_f );
+		o2l_p += o2l_f * srInv;
+		o2r_p += o2r_f * srInv;
 
 		/////////////////////////////
 		//				           //
@@ -551,16 +547,16 @@ void MonstroSynth::renderOutput( fpp_t _frames, SampleFrame* _buf  )
 		o3r_f = o3fb;
 		if( o3f_mod )
 		{
-			modulatefreq( o3l_f, o3f )
-			modulatefreq( o3r_f, o3f )
+			o3l_f = qBound( MIN_FREQ, o3l_f * m_pitchMod[2][f], MAX_FREQ );
+			o3r_f = qBound( MIN_FREQ, o3r_f * m_pitchMod[2][f], MAX_FREQ );
 		}
 		// calc and modulate phase
 		leftph = o3l_p;
 		rightph = o3r_p;
 		if( o3p_mod )
 		{
-			modulatephs( leftph, o3p )
-			modulatephs( rightph, o3p )
+			leftph += m_phaseMod[2][f];
+			rightph += m_phaseMod[2][f];
 		}
 
 		// o2 modulation?
@@ -615,12 +611,7 @@ void MonstroSynth::renderOutput( fpp_t _frames, SampleFrame* _buf  )
 		}
 
 		// calc and modulate sub
-		sub = o3sub;
-		if( o3s_mod )
-		{
-			modulateabs( sub, o3s )
-			sub = qBound( 0.0f, sub, 1.0f );
-		}
+		sub = o3s_mod ? m_subMod[f] : o3sub;
 
 		sample_t O3L = std::lerp(O3AL, O3BL, sub);
 		sample_t O3R = std::lerp(O3AR, O3BR, sub);
@@ -630,8 +621,8 @@ void MonstroSynth::renderOutput( fpp_t _frames, SampleFrame* _buf  )
 		O3R *= o3rv;
 		if( o3v_mod )
 		{
-			modulatevol( O3L, o3v )
-			modulatevol( O3R, o3v )
+			O3L = qBound( -MODCLIP, O3L * m_volumeMod[2][f], MODCLIP );
+			O3R = qBound( -MODCLIP, O3R * m_volumeMod[2][f], MODCLIP );
 		}
 		// o2 modulation?
 		if( omod == MOD_AM )
@@ -647,8 +638,8 @@ void MonstroSynth::renderOutput( fpp_t _frames, SampleFrame* _buf  )
 		// update osc3 phases
 		m_ph3l_last = leftph;
 		m_ph3r_last = rightph;
-		len_l = 1.0f / ( static_cast<float>( m_parent->m_samplerate ) / o3l_f );
-		len_r = 1.0f / ( static_cast<float>( m_parent->m_samplerate ) / o3r_f );
+		len_l = o3l_f * srInv;
+		len_r = o3r_f * srInv;
 		// handle FM as PM
 		if( omod == MOD_FM )
 		{
@@ -682,6 +673,57 @@ void MonstroSynth::renderOutput( fpp_t _frames, SampleFrame* _buf  )
 }
 
 
+void MonstroSynth::sumModulation( float * out, float e1, float e2, float l1, float l2, f_cnt_t frames )
+{
+	// one loop per source, so the unused ones cost nothing and the rest vectorize
+	std::fill_n( out, frames, 0.0f );
+	const auto add = [&]( const std::vector<float> & source, float amount )
+	{
+		if( amount == 0.0f ) { return; }
+		for( f_cnt_t f = 0; f < frames; ++f ) { out[f] += source[f] * amount; }
+	};
+	add( m_env[0], e1 );
+	add( m_env[1], e2 );
+	add( m_lfo[0], l1 );
+	add( m_lfo[1], l2 );
+}
+
+
+void MonstroSynth::pitchModulation( float * out, float e1, float e2, float l1, float l2, f_cnt_t frames )
+{
+	// both channels share the factor, so it's only computed once per frame
+	sumModulation( out, e1, e2, l1, l2, frames );
+	for( f_cnt_t f = 0; f < frames; ++f ) { out[f] = std::exp2( out[f] ); }
+}
+
+
+void MonstroSynth::volumeModulation( float * out, float e1, float e2, float l1, float l2, f_cnt_t frames )
+{
+	// positive envelope amounts attenuate from full volume, negative ones towards silence
+	std::fill_n( out, frames, 1.0f );
+	const auto scaleEnv = [&]( const std::vector<float> & env, float amount )
+	{
+		if( amount > 0.0f )
+		{
+			for( f_cnt_t f = 0; f < frames; ++f ) { out[f] *= 1.0f - amount + amount * env[f]; }
+		}
+		else if( amount < 0.0f )
+		{
+			for( f_cnt_t f = 0; f < frames; ++f ) { out[f] *= 1.0f + amount * env[f]; }
+		}
+	};
+	const auto scaleLfo = [&]( const std::vector<float> & lfo, float amount )
+	{
+		if( amount == 0.0f ) { return; }
+		for( f_cnt_t f = 0; f < frames; ++f ) { out[f] *= 1.0f + amount * lfo[f]; }
+	};
+	scaleEnv( m_env[0], e1 );
+	scaleEnv( m_env[1], e2 );
+	scaleLfo( m_lfo[0], l1 );
+	scaleLfo( m_lfo[1], l2 );
+}
+
+
 inline void MonstroSynth::updateModulators(float * env1, float * env2, float * lfo1, float * lfo2, f_cnt_t frames)
 {
 	// frames played before
@@ -1041,7 +1083,7 @@ MonstroInstrument::MonstroInstrument( InstrumentTrack * _instrument_track ) :
 
 	connect( Engine::audioEngine(), SIGNAL( sampleRateChanged() ), this, SLOT( updateSamplerate() ) );
 
-	m_fpp = Engine::audioEngine()->framesPerPeriod();
+	m_fpp = Engine::audioEngine()->maxFramesPerPeriod();
 
 	updateSamplerate();
 	updateVolume1();
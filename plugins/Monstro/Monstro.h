@@ -186,6 +186,13 @@ private:
 
 	inline void updateModulators(float * env1, float * env2, float * lfo1, float * lfo2, f_cnt_t frames);
 
+	// modulation of a parameter by env1, env2, lfo1 and lfo2 with the given amounts, for a whole block
+	void sumModulation( float * out, float e1, float e2, float l1, float l2, f_cnt_t frames );
+	// factor the frequency is multiplied with
+	void pitchModulation( float * out, float e1, float e2, float l1, float l2, f_cnt_t frames );
+	// factor the volume is multiplied with
+	void volumeModulation( float * out, float e1, float e2, float l1, float l2, f_cnt_t frames );
+
 	// linear interpolation
 /*	inline sample_t interpolate( sample_t s1, sample_t s2, float x )
 	{
@@ -315,6 +322,13 @@ private:
 
 	std::vector<float> m_lfo[2];
 	std::vector<float> m_env[2];
+
+	// modulation of the oscillators for the current block
+	std::vector<float> m_pitchMod[3];
+	std::vector<float> m_phaseMod[3];
+	std::vector<float> m_volumeMod[3];
+	std::vector<float> m_pwMod;
+	std::vector<float> m_subMod;
 };
 
 class MonstroInstrument : public Instrument
@@ -27,6 +27,7 @@
 #include "embed.h"
 #include "LmmsTypes.h"
 #include "lmms_math.h"
+#include "MixHelpers.h"
 #include "plugin_export.h"
 
 namespace lmms
@@ -60,7 +61,7 @@ MultitapEchoEffect::MultitapEchoEffect( Model* parent, const Descriptor::SubPlug
 	m_sampleRate( Engine::audioEngine()->outputSampleRate() ),
 	m_sampleRatio( 1.0f / m_sampleRate )
 {
-	m_work = new SampleFrame[Engine::audioEngine()->framesPerPeriod()];
+	m_work = new SampleFrame[Engine::audioEngine()->maxFramesPerPeriod()];
 	m_buffer.reset();
 	m_stages = static_cast<int>( m_controls.m_stages.value() );
 	updateFilters( 0, 19 );
@@ -147,11 +148,7 @@ Effect::ProcessStatus MultitapEchoEffect::processImpl(SampleFrame* buf, const fp
 	// pop the buffer and mix it into output
 	m_buffer.pop( m_work );
 
-	for (auto f = std::size_t{0}; f < frames; ++f)
-	{
-		buf[f][0] = d * buf[f][0] + w * m_work[f][0];
-		buf[f][1] = d * buf[f][1] + w * m_work[f][1];
-	}
+	MixHelpers::multiplyAndAddMultiplied(buf, m_work, d, w, frames);
 
 	return ProcessStatus::ContinueIfNotQuiet;
 }
@@ -158,7 +158,7 @@ OpulenzInstrument::OpulenzInstrument( InstrumentTrack * _instrument_track ) :
 	updatePatch();
 
 	// Can the buffer size change suddenly? I bet that would break lots of stuff
-	frameCount = Engine::audioEngine()->framesPerPeriod();
+	frameCount = Engine::audioEngine()->maxFramesPerPeriod();
 	renderbuffer = new short[frameCount];
 
 	// Some kind of sane defaults
@@ -392,9 +392,10 @@ gui::PluginView* OpulenzInstrument::instantiateView( QWidget * _parent )
 void OpulenzInstrument::play( SampleFrame* _working_buffer )
 {
 	emulatorMutex.lock();
-	theEmulator->update(renderbuffer, frameCount);
+	const fpp_t frames = Engine::audioEngine()->framesPerPeriod();
+	theEmulator->update(renderbuffer, frames);
 
-	for( fpp_t frame = 0; frame < frameCount; ++frame )
+	for( fpp_t frame = 0; frame < frames; ++frame )
         {
                 sample_t s = float(renderbuffer[frame]) / 8192.0;
                 for( ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch )
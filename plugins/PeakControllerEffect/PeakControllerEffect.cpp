@@ -29,6 +29,7 @@
 #include "PeakController.h"
 #include "PeakControllerEffect.h"
 #include "lmms_math.h"
+#include "MixHelpers.h"
 
 #include "embed.h"
 #include "plugin_export.h"
@@ -102,11 +103,9 @@ Effect::ProcessStatus PeakControllerEffect::processImpl(SampleFrame* buf, const
 
 	if( c.m_absModel.value() )
 	{
-		for (auto i = std::size_t{0}; i < frames; ++i)
-		{
-			// absolute value is achieved because the squares are > 0
-			sum += buf[i][0] * buf[i][0] + buf[i][1] * buf[i][1];
-		}
+		// absolute value is achieved because the squares are > 0
+		const auto squares = MixHelpers::sumOfSquares(buf, frames);
+		sum = squares.left() + squares.right();
 	}
 	else
 	{
@@ -22,6 +22,9 @@
 
 #include "ReverbSC.h"
 
+#include <algorithm>
+#include <array>
+
 #include "embed.h"
 #include "lmms_math.h"
 #include "plugin_export.h"
@@ -78,40 +81,45 @@ Effect::ProcessStatus ReverbSCEffect::processImpl(SampleFrame* buf, const fpp_t
 	const float d = dryLevel();
 	const float w = wetLevel();
 
-	SPFLOAT tmpL, tmpR;
-	SPFLOAT dcblkL, dcblkR;
-
-	ValueBuffer * inGainBuf = m_reverbSCControls.m_inputGainModel.valueBuffer();
-	ValueBuffer * sizeBuf = m_reverbSCControls.m_sizeModel.valueBuffer();
-	ValueBuffer * colorBuf = m_reverbSCControls.m_colorModel.valueBuffer();
-	ValueBuffer * outGainBuf = m_reverbSCControls.m_outputGainModel.valueBuffer();
+	auto& c = m_reverbSCControls;
+	ValueBuffer * inGainBuf = c.m_inputGainModel.valueBuffer();
+	ValueBuffer * outGainBuf = c.m_outputGainModel.valueBuffer();
 
-	for( fpp_t f = 0; f < frames; ++f )
+	// the delay network is computed in blocks with the same size and color
+	processControlBlocks(frames, {&c.m_sizeModel, &c.m_colorModel}, [&](fpp_t start, fpp_t end)
 	{
-		auto s = std::array{buf[f][0], buf[f][1]};
-
-		const auto inGain = static_cast<SPFLOAT>(fastPow10f(
-			(inGainBuf ? inGainBuf->values()[f] : m_reverbSCControls.m_inputGainModel.value()) / 20.f));
-		const auto outGain = static_cast<SPFLOAT>(fastPow10f(
-			(outGainBuf ? outGainBuf->values()[f] : m_reverbSCControls.m_outputGainModel.value()) / 20.f));
-
-		s[0] *= inGain;
-		s[1] *= inGain;
-		revsc->feedback = (SPFLOAT)(sizeBuf ?
-			sizeBuf->values()[f]
-			: m_reverbSCControls.m_sizeModel.value());
-
-		revsc->lpfreq = (SPFLOAT)(colorBuf ?
-			colorBuf->values()[f]
-			: m_reverbSCControls.m_colorModel.value());
-
-
-		sp_revsc_compute(sp, revsc, &s[0], &s[1], &tmpL, &tmpR);
-		sp_dcblock_compute(sp, dcblk[0], &tmpL, &dcblkL);
-		sp_dcblock_compute(sp, dcblk[1], &tmpR, &dcblkR);
-		buf[f][0] = d * buf[f][0] + w * dcblkL * outGain;
-		buf[f][1] = d * buf[f][1] + w * dcblkR * outGain;
-	}
+		revsc->feedback = static_cast<SPFLOAT>(controlValue(c.m_sizeModel, start, end));
+		revsc->lpfreq = static_cast<SPFLOAT>(controlValue(c.m_colorModel, start, end));
+
+		for (fpp_t block = start; block < end; block += BlockFrames)
+		{
+			const fpp_t blockEnd = std::min<fpp_t>(block + BlockFrames, end);
+			const auto count = static_cast<uint32_t>(blockEnd - block);
+
+			std::array<SPFLOAT, BlockFrames> inL, inR, outL, outR;
+			for (fpp_t f = block; f < blockEnd; ++f)
+			{
+				const auto inGain = static_cast<SPFLOAT>(fastPow10f(
+					(inGainBuf ? inGainBuf->values()[f] : c.m_inputGainModel.value()) / 20.f));
+				inL[f - block] = buf[f][0] * inGain;
+				inR[f - block] = buf[f][1] * inGain;
+			}
+
+			sp_revsc_compute_block(sp, revsc, inL.data(), inR.data(), outL.data(), outR.data(), count);
+
+			for (fpp_t f = block; f < blockEnd; ++f)
+			{
+				const auto outGain = static_cast<SPFLOAT>(fastPow10f(
+					(outGainBuf ? outGainBuf->values()[f] : c.m_outputGainModel.value()) / 20.f));
+
+				SPFLOAT dcblkL, dcblkR;
+				sp_dcblock_compute(sp, dcblk[0], &outL[f - block], &dcblkL);
+				sp_dcblock_compute(sp, dcblk[1], &outR[f - block], &dcblkR);
+				buf[f][0] = d * buf[f][0] + w * dcblkL * outGain;
+				buf[f][1] = d * buf[f][1] + w * dcblkR * outGain;
+			}
+		}
+	});
 
 	return ProcessStatus::ContinueIfNotQuiet;
 }
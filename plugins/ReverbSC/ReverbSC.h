@@ -56,6 +56,9 @@ public:
 	void changeSampleRate();
 
 private:
+	//! Frames passed to the delay network at once
+	static constexpr fpp_t BlockFrames = 64;
+
 	ReverbSCControls m_reverbSCControls;
 	sp_data *sp;
 	sp_revsc *revsc;
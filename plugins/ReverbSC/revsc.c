@@ -16,6 +16,11 @@
 #include "base.h"
 #include "revsc.h"
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define REVSC_AVX2
+#include <immintrin.h>
+#endif
+
 #define DEFAULT_SRATE   44100.f
 #define MIN_SRATE       5000.0
 #define MAX_SRATE       1000000.0
@@ -65,15 +70,22 @@ int sp_revsc_init(sp_data *sp, sp_revsc *p)
     p->dampFact = 1.0;
     p->prv_LPFreq = 0.0;
     p->initDone = 1;
+#ifdef REVSC_AVX2
+    __builtin_cpu_init();
+    p->useAvx2 = __builtin_cpu_supports("avx2");
+#else
+    p->useAvx2 = 0;
+#endif
     int i, nBytes = 0;
-    for(i = 0; i < 8; i++){
+    for(i = 0; i < SP_REVSC_LINES; i++){
         nBytes += delay_line_bytes_alloc((float) sp->sr, 1, i);
     }
     sp_auxdata_alloc(&p->aux, nBytes);
+    p->delayLines.buf = (SPFLOAT*) p->aux.ptr;
     nBytes = 0;
-    for (i = 0; i < 8; i++) {
-        p->delayLines[i].buf = (SPFLOAT*) (((char*) p->aux.ptr) + nBytes);
-        init_delay_line(p, &p->delayLines[i], i);
+    for (i = 0; i < SP_REVSC_LINES; i++) {
+        p->delayLines.bufferStart[i] = nBytes / (int) sizeof(SPFLOAT);
+        init_delay_line(p, &p->delayLines, i);
         nBytes += delay_line_bytes_alloc((float) sp->sr, 1, i);
     }
 
@@ -111,26 +123,26 @@ static void next_random_lineseg(sp_revsc *p, sp_revsc_dl *lp, int n)
     SPFLOAT prvDel, nxtDel, phs_incVal;
 
     /* update random seed */
-    if (lp->seedVal < 0)
-      lp->seedVal += 0x10000;
-    lp->seedVal = (lp->seedVal * 15625 + 1) & 0xFFFF;
-    if (lp->seedVal >= 0x8000)
-      lp->seedVal -= 0x10000;
+    if (lp->seedVal[n] < 0)
+      lp->seedVal[n] += 0x10000;
+    lp->seedVal[n] = (lp->seedVal[n] * 15625 + 1) & 0xFFFF;
+    if (lp->seedVal[n] >= 0x8000)
+      lp->seedVal[n] -= 0x10000;
     /* length of next segment in samples */
-    lp->randLine_cnt = (int) ((p->sampleRate / reverbParams[n][2]) + 0.5);
-    prvDel = (SPFLOAT) lp->writePos;
-    prvDel -= ((SPFLOAT) lp->readPos
-               + ((SPFLOAT) lp->readPosFrac / (SPFLOAT) DELAYPOS_SCALE));
+    lp->randLine_cnt[n] = (int) ((p->sampleRate / reverbParams[n][2]) + 0.5);
+    prvDel = (SPFLOAT) lp->writePos[n];
+    prvDel -= ((SPFLOAT) lp->readPos[n]
+               + ((SPFLOAT) lp->readPosFrac[n] / (SPFLOAT) DELAYPOS_SCALE));
     while (prvDel < 0.0)
-      prvDel += lp->bufferSize;
+      prvDel += lp->bufferSize[n];
     prvDel = prvDel / p->sampleRate;    /* previous delay time in seconds */
-    nxtDel = (SPFLOAT) lp->seedVal * reverbParams[n][1] / 32768.0;
+    nxtDel = (SPFLOAT) lp->seedVal[n] * reverbParams[n][1] / 32768.0;
     /* next delay time in seconds */
     nxtDel = reverbParams[n][0] + (nxtDel * (SPFLOAT) p->iPitchMod);
     /* calculate phase increment per sample */
-    phs_incVal = (prvDel - nxtDel) / (SPFLOAT) lp->randLine_cnt;
+    phs_incVal = (prvDel - nxtDel) / (SPFLOAT) lp->randLine_cnt[n];
     phs_incVal = phs_incVal * p->sampleRate + 1.0;
-    lp->readPosFrac_inc = (int) (phs_incVal * DELAYPOS_SCALE + 0.5);
+    lp->readPosFrac_inc[n] = (int) (phs_incVal * DELAYPOS_SCALE + 0.5);
 }
 
 static int init_delay_line(sp_revsc *p, sp_revsc_dl *lp, int n)
@@ -139,138 +151,261 @@ static int init_delay_line(sp_revsc *p, sp_revsc_dl *lp, int n)
     /* int     i; */
 
     /* calculate length of delay line */
-    lp->bufferSize = delay_line_max_samples(p->sampleRate, 1, n);
-    lp->dummy = 0;
-    lp->writePos = 0;
+    lp->bufferSize[n] = delay_line_max_samples(p->sampleRate, 1, n);
+    lp->writePos[n] = 0;
     /* set random seed */
-    lp->seedVal = (int) (reverbParams[n][3] + 0.5);
+    lp->seedVal[n] = (int) (reverbParams[n][3] + 0.5);
     /* set initial delay time */
-    readPos = (SPFLOAT) lp->seedVal * reverbParams[n][1] / 32768;
+    readPos = (SPFLOAT) lp->seedVal[n] * reverbParams[n][1] / 32768;
     readPos = reverbParams[n][0] + (readPos * (SPFLOAT) p->iPitchMod);
-    readPos = (SPFLOAT) lp->bufferSize - (readPos * p->sampleRate);
-    lp->readPos = (int) readPos;
-    readPos = (readPos - (SPFLOAT) lp->readPos) * (SPFLOAT) DELAYPOS_SCALE;
-    lp->readPosFrac = (int) (readPos + 0.5);
+    readPos = (SPFLOAT) lp->bufferSize[n] - (readPos * p->sampleRate);
+    lp->readPos[n] = (int) readPos;
+    readPos = (readPos - (SPFLOAT) lp->readPos[n]) * (SPFLOAT) DELAYPOS_SCALE;
+    lp->readPosFrac[n] = (int) (readPos + 0.5);
     /* initialise first random line segment */
     next_random_lineseg(p, lp, n);
     /* clear delay line to zero */
-    lp->filterState = 0.0;
-    memset(lp->buf, 0, sizeof(SPFLOAT) * lp->bufferSize);
+    lp->filterState[n] = 0.0;
+    memset(lp->buf + lp->bufferStart[n], 0, sizeof(SPFLOAT) * lp->bufferSize[n]);
     return SP_OK;
 }
 
-
-int sp_revsc_compute(sp_data *sp, sp_revsc *p, SPFLOAT *in1, SPFLOAT *in2, SPFLOAT *out1, SPFLOAT *out2)
+/* calculate "resultant junction pressure" and send it with the input
+ * signals and the feedback to the delay lines */
+static inline void send_to_lines(sp_revsc_dl *lp, SPFLOAT inL, SPFLOAT inR)
 {
-    SPFLOAT ainL, ainR, aoutL, aoutR;
-    SPFLOAT vm1, v0, v1, v2, am1, a0, a1, a2, frac;
-    sp_revsc_dl *lp;
-    int readPos;
-    uint32_t n;
-    int bufferSize; /* Local copy */
-    SPFLOAT dampFact = p->dampFact;
-
-    if (p->initDone <= 0) return SP_NOT_OK;
+    SPFLOAT ainL, ainR;
+    int n;
 
-    /* calculate tone filter coefficient if frequency changed */
-
-    if (p->lpfreq != p->prv_LPFreq) {
-        p->prv_LPFreq = p->lpfreq;
-        dampFact = 2.0 - cos(p->prv_LPFreq * (2 * M_PI) / p->sampleRate);
-        dampFact = p->dampFact = dampFact - sqrt(dampFact * dampFact - 1.0);
-    }
-
-    /* calculate "resultant junction pressure" and mix to input signals */
-
-    ainL = aoutL = aoutR = 0.0;
-    for (n = 0; n < 8; n++) {
-        ainL += p->delayLines[n].filterState;
+    ainL = 0.0;
+    for (n = 0; n < SP_REVSC_LINES; n++) {
+        ainL += lp->filterState[n];
     }
     ainL *= jpScale;
-    ainR = ainL + *in2;
-    ainL = ainL + *in1;
+    ainR = ainL + inR;
+    ainL = ainL + inL;
 
-    /* loop through all delay lines */
+    for (n = 0; n < SP_REVSC_LINES; n++) {
+        lp->buf[lp->bufferStart[n] + lp->writePos[n]] = (SPFLOAT) ((n & 1 ? ainR : ainL)
+                                                        - lp->filterState[n]);
+    }
+}
 
-    for (n = 0; n < 8; n++) {
-        lp = &p->delayLines[n];
-        bufferSize = lp->bufferSize;
+/* read the delay lines, with the results left in the filter states */
+static inline void read_lines(sp_revsc_dl *lp, SPFLOAT feedback, SPFLOAT dampFact)
+{
+    SPFLOAT vm1, v0, v1, v2, am1, a0, a1, a2, frac;
+    const SPFLOAT *buf;
+    int readPos, im1, i1, i2, bufferSize;
+    int n;
 
-        /* send input signal and feedback to delay line */
+    for (n = 0; n < SP_REVSC_LINES; n++) {
+        bufferSize = lp->bufferSize[n];
+        buf = lp->buf + lp->bufferStart[n];
 
-        lp->buf[lp->writePos] = (SPFLOAT) ((n & 1 ? ainR : ainL)
-                                 - lp->filterState);
-        if (++lp->writePos >= bufferSize) {
-            lp->writePos -= bufferSize;
+        if (++lp->writePos[n] >= bufferSize) {
+            lp->writePos[n] -= bufferSize;
         }
 
         /* read from delay line with cubic interpolation */
 
-        if (lp->readPosFrac >= DELAYPOS_SCALE) {
-            lp->readPos += (lp->readPosFrac >> DELAYPOS_SHIFT);
-            lp->readPosFrac &= DELAYPOS_MASK;
+        if (lp->readPosFrac[n] >= DELAYPOS_SCALE) {
+            lp->readPos[n] += (lp->readPosFrac[n] >> DELAYPOS_SHIFT);
+            lp->readPosFrac[n] &= DELAYPOS_MASK;
         }
-        if (lp->readPos >= bufferSize)
-        lp->readPos -= bufferSize;
-        readPos = lp->readPos;
-        frac = (SPFLOAT) lp->readPosFrac * (1.0 / (SPFLOAT) DELAYPOS_SCALE);
+        if (lp->readPos[n] >= bufferSize)
+        lp->readPos[n] -= bufferSize;
+        readPos = lp->readPos[n];
+        frac = (SPFLOAT) lp->readPosFrac[n] * (1.f / (SPFLOAT) DELAYPOS_SCALE);
 
         /* calculate interpolation coefficients */
 
-        a2 = frac * frac; a2 -= 1.0; a2 *= (1.f / 6.f);
-        a1 = frac; a1 += 1.0; a1 *= 0.5; am1 = a1 - 1.0;
-        a0 = 3.0 * a2; a1 -= a0; am1 -= a2; a0 -= frac;
+        a2 = frac * frac; a2 -= 1.f; a2 *= (1.f / 6.f);
+        a1 = frac; a1 += 1.f; a1 *= 0.5f; am1 = a1 - 1.f;
+        a0 = 3.f * a2; a1 -= a0; am1 -= a2; a0 -= frac;
 
         /* read four samples for interpolation */
 
         if (readPos > 0 && readPos < (bufferSize - 2)) {
-            vm1 = (SPFLOAT) (lp->buf[readPos - 1]);
-            v0  = (SPFLOAT) (lp->buf[readPos]);
-            v1  = (SPFLOAT) (lp->buf[readPos + 1]);
-            v2  = (SPFLOAT) (lp->buf[readPos + 2]);
+            vm1 = buf[readPos - 1];
+            v0  = buf[readPos];
+            v1  = buf[readPos + 1];
+            v2  = buf[readPos + 2];
         }
         else {
 
         /* at buffer wrap-around, need to check index */
 
-        if (--readPos < 0) readPos += bufferSize;
-            vm1 = (SPFLOAT) lp->buf[readPos];
-        if (++readPos >= bufferSize) readPos -= bufferSize;
-            v0 = (SPFLOAT) lp->buf[readPos];
-        if (++readPos >= bufferSize) readPos -= bufferSize;
-            v1 = (SPFLOAT) lp->buf[readPos];
-        if (++readPos >= bufferSize) readPos -= bufferSize;
-            v2 = (SPFLOAT) lp->buf[readPos];
+            im1 = readPos - 1;
+            if (im1 < 0) im1 += bufferSize;
+            i1 = readPos + 1;
+            if (i1 >= bufferSize) i1 -= bufferSize;
+            i2 = i1 + 1;
+            if (i2 >= bufferSize) i2 -= bufferSize;
+            vm1 = buf[im1];
+            v0  = buf[readPos];
+            v1  = buf[i1];
+            v2  = buf[i2];
         }
         v0 = (am1 * vm1 + a0 * v0 + a1 * v1 + a2 * v2) * frac + v0;
 
         /* update buffer read position */
 
-        lp->readPosFrac += lp->readPosFrac_inc;
+        lp->readPosFrac[n] += lp->readPosFrac_inc[n];
 
         /* apply feedback gain and lowpass filter */
 
-        v0 *= (SPFLOAT) p->feedback;
-        v0 = (lp->filterState - v0) * dampFact + v0;
-        lp->filterState = v0;
+        v0 *= feedback;
+        v0 = (lp->filterState[n] - v0) * dampFact + v0;
+        lp->filterState[n] = v0;
+    }
+}
 
-        /* mix to output */
+#ifdef REVSC_AVX2
+/* the same as read_lines(), with the eight lines in one AVX register */
+__attribute__((target("avx2")))
+static inline void read_lines_avx2(sp_revsc_dl *lp, SPFLOAT feedback, SPFLOAT dampFact)
+{
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i bufferSize = _mm256_loadu_si256((const __m256i*) lp->bufferSize);
+    const __m256i lastPos = _mm256_sub_epi32(bufferSize, one);
+    const __m256i start = _mm256_loadu_si256((const __m256i*) lp->bufferStart);
+    __m256i writePos = _mm256_loadu_si256((const __m256i*) lp->writePos);
+    __m256i readPos = _mm256_loadu_si256((const __m256i*) lp->readPos);
+    __m256i readPosFrac = _mm256_loadu_si256((const __m256i*) lp->readPosFrac);
+    __m256i im1, i1, i2;
+    __m256 filterState = _mm256_loadu_ps(lp->filterState);
+    __m256 vm1, v0, v1, v2, am1, a0, a1, a2, frac;
+
+    /* positions past the end of the buffers wrap around */
+#define REVSC_WRAP(pos) _mm256_sub_epi32(pos, _mm256_and_si256(_mm256_cmpgt_epi32(pos, lastPos), bufferSize))
+
+    writePos = REVSC_WRAP(_mm256_add_epi32(writePos, one));
+
+    /* read from delay lines with cubic interpolation */
+
+    readPos = _mm256_add_epi32(readPos, _mm256_srai_epi32(readPosFrac, DELAYPOS_SHIFT));
+    readPosFrac = _mm256_and_si256(readPosFrac, _mm256_set1_epi32(DELAYPOS_MASK));
+    readPos = REVSC_WRAP(readPos);
+    frac = _mm256_mul_ps(_mm256_cvtepi32_ps(readPosFrac), _mm256_set1_ps(1.f / (SPFLOAT) DELAYPOS_SCALE));
+
+    /* calculate interpolation coefficients */
+
+    a2 = _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(frac, frac), _mm256_set1_ps(1.f)), _mm256_set1_ps(1.f / 6.f));
+    a1 = _mm256_mul_ps(_mm256_add_ps(frac, _mm256_set1_ps(1.f)), _mm256_set1_ps(0.5f));
+    am1 = _mm256_sub_ps(a1, _mm256_set1_ps(1.f));
+    a0 = _mm256_mul_ps(_mm256_set1_ps(3.f), a2);
+    a1 = _mm256_sub_ps(a1, a0);
+    am1 = _mm256_sub_ps(am1, a2);
+    a0 = _mm256_sub_ps(a0, frac);
+
+    /* gather four samples for interpolation */
+
+    im1 = _mm256_sub_epi32(readPos, one);
+    im1 = _mm256_add_epi32(im1, _mm256_and_si256(_mm256_cmpgt_epi32(_mm256_setzero_si256(), im1), bufferSize));
+    i1 = REVSC_WRAP(_mm256_add_epi32(readPos, one));
+    i2 = REVSC_WRAP(_mm256_add_epi32(i1, one));
+#undef REVSC_WRAP
+    vm1 = _mm256_i32gather_ps(lp->buf, _mm256_add_epi32(start, im1), sizeof(SPFLOAT));
+    v0  = _mm256_i32gather_ps(lp->buf, _mm256_add_epi32(start, readPos), sizeof(SPFLOAT));
+    v1  = _mm256_i32gather_ps(lp->buf, _mm256_add_epi32(start, i1), sizeof(SPFLOAT));
+    v2  = _mm256_i32gather_ps(lp->buf, _mm256_add_epi32(start, i2), sizeof(SPFLOAT));
+    v1 = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(am1, vm1), _mm256_mul_ps(a0, v0)),
+                                     _mm256_mul_ps(a1, v1)), _mm256_mul_ps(a2, v2));
+    v0 = _mm256_add_ps(_mm256_mul_ps(v1, frac), v0);
+
+    /* update buffer read positions */
+
+    readPosFrac = _mm256_add_epi32(readPosFrac, _mm256_loadu_si256((const __m256i*) lp->readPosFrac_inc));
+
+    /* apply feedback gain and lowpass filter */
+
+    v0 = _mm256_mul_ps(v0, _mm256_set1_ps(feedback));
+    filterState = _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(filterState, v0), _mm256_set1_ps(dampFact)), v0);
+
+    _mm256_storeu_si256((__m256i*) lp->writePos, writePos);
+    _mm256_storeu_si256((__m256i*) lp->readPos, readPos);
+    _mm256_storeu_si256((__m256i*) lp->readPosFrac, readPosFrac);
+    _mm256_storeu_ps(lp->filterState, filterState);
+}
+#endif
 
-        if (n & 1) {
-            aoutR += v0;
-        }else{
-            aoutL += v0;
-        }
+/* mix the lines to the output and start the next random line segments of the
+ * lines which have reached their endpoints */
+static inline void mix_from_lines(sp_revsc *p, SPFLOAT *outL, SPFLOAT *outR)
+{
+    sp_revsc_dl *lp = &p->delayLines;
+    SPFLOAT aoutL, aoutR;
+    int n;
+
+    aoutL = aoutR = 0.0;
+    for (n = 0; n < SP_REVSC_LINES; n += 2) {
+        aoutL += lp->filterState[n];
+        aoutR += lp->filterState[n + 1];
+    }
+    /* someday, use aoutR for multimono out */
 
-        /* start next random line segment if current one has reached endpoint */
+    *outL = aoutL * outputGain;
+    *outR = aoutR * outputGain;
 
-        if (--(lp->randLine_cnt) <= 0) {
+    for (n = 0; n < SP_REVSC_LINES; n++) {
+        if (--(lp->randLine_cnt[n]) <= 0) {
             next_random_lineseg(p, lp, n);
         }
     }
-    /* someday, use aoutR for multimono out */
+}
+
+static void compute_block(sp_revsc *p, const SPFLOAT *in1, const SPFLOAT *in2,
+                          SPFLOAT *out1, SPFLOAT *out2, uint32_t frames)
+{
+    uint32_t i;
+    for (i = 0; i < frames; i++) {
+        send_to_lines(&p->delayLines, in1[i], in2[i]);
+        read_lines(&p->delayLines, p->feedback, p->dampFact);
+        mix_from_lines(p, &out1[i], &out2[i]);
+    }
+}
+
+#ifdef REVSC_AVX2
+__attribute__((target("avx2")))
+static void compute_block_avx2(sp_revsc *p, const SPFLOAT *in1, const SPFLOAT *in2,
+                               SPFLOAT *out1, SPFLOAT *out2, uint32_t frames)
+{
+    uint32_t i;
+    for (i = 0; i < frames; i++) {
+        send_to_lines(&p->delayLines, in1[i], in2[i]);
+        read_lines_avx2(&p->delayLines, p->feedback, p->dampFact);
+        mix_from_lines(p, &out1[i], &out2[i]);
+    }
+}
+#endif
+
+int sp_revsc_compute_block(sp_data *sp, sp_revsc *p, const SPFLOAT *in1, const SPFLOAT *in2,
+                           SPFLOAT *out1, SPFLOAT *out2, uint32_t frames)
+{
+    SPFLOAT dampFact;
+
+    if (p->initDone <= 0) return SP_NOT_OK;
+
+    /* calculate tone filter coefficient if frequency changed */
+
+    if (p->lpfreq != p->prv_LPFreq) {
+        p->prv_LPFreq = p->lpfreq;
+        dampFact = 2.0 - cos(p->prv_LPFreq * (2 * M_PI) / p->sampleRate);
+        p->dampFact = dampFact - sqrt(dampFact * dampFact - 1.0);
+    }
 
-    *out1  = aoutL * outputGain;
-    *out2 = aoutR * outputGain;
+#ifdef REVSC_AVX2
+    if (p->useAvx2) {
+        compute_block_avx2(p, in1, in2, out1, out2, frames);
+        return SP_OK;
+    }
+#endif
+    compute_block(p, in1, in2, out1, out2, frames);
     return SP_OK;
 }
+
+int sp_revsc_compute(sp_data *sp, sp_revsc *p, SPFLOAT *in1, SPFLOAT *in2, SPFLOAT *out1, SPFLOAT *out2)
+{
+    return sp_revsc_compute_block(sp, p, in1, in2, out1, out2, 1);
+}
@@ -1,13 +1,18 @@
+#define SP_REVSC_LINES 8
+
+/* the state of all delay lines, one lane per line so that they can be
+ * processed side by side in SIMD registers */
 typedef struct {
-    int writePos;
-    int bufferSize;
-    int readPos;
-    int readPosFrac;
-    int readPosFrac_inc;
-    int dummy;
-    int seedVal;
-    int randLine_cnt;
-    SPFLOAT filterState;
+    int writePos[SP_REVSC_LINES];
+    int bufferSize[SP_REVSC_LINES];
+    int bufferStart[SP_REVSC_LINES];
+    int readPos[SP_REVSC_LINES];
+    int readPosFrac[SP_REVSC_LINES];
+    int readPosFrac_inc[SP_REVSC_LINES];
+    int seedVal[SP_REVSC_LINES];
+    int randLine_cnt[SP_REVSC_LINES];
+    SPFLOAT filterState[SP_REVSC_LINES];
+    /* the buffers of all lines one after another */
     SPFLOAT *buf;
 } sp_revsc_dl;
 
@@ -18,7 +23,8 @@ typedef struct  {
     SPFLOAT dampFact;
     SPFLOAT prv_LPFreq;
     int initDone;
-    sp_revsc_dl delayLines[8];
+    int useAvx2;
+    sp_revsc_dl delayLines;
     sp_auxdata aux;
 } sp_revsc;
 
@@ -26,3 +32,6 @@ int sp_revsc_create(sp_revsc **p);
 int sp_revsc_destroy(sp_revsc **p);
 int sp_revsc_init(sp_data *sp, sp_revsc *p);
 int sp_revsc_compute(sp_data *sp, sp_revsc *p, SPFLOAT *in1, SPFLOAT *in2, SPFLOAT *out1, SPFLOAT *out2);
+/* computes a block of frames with the same feedback and lpfreq */
+int sp_revsc_compute_block(sp_data *sp, sp_revsc *p, const SPFLOAT *in1, const SPFLOAT *in2,
+                           SPFLOAT *out1, SPFLOAT *out2, uint32_t frames);
@@ -154,6 +154,10 @@ Sf2Instrument::Sf2Instrument( InstrumentTrack * _instrument_track ) :
 #endif
 	m_settings = new_fluid_settings();
 
+	// Let fluidsynth render large numbers of voices on as many cores as the
+	// audio engine uses. Its helper threads only run while we render.
+	fluid_settings_setint( m_settings, (char *) "synth.cpu-cores", Engine::audioEngine()->numJobThreads() );
+
 	//fluid_settings_setint( m_settings, (char *) "audio.period-size", engine::audioEngine()->framesPerPeriod() );
 
 	// This sets up m_synth and updates reverb/chorus/gain
@@ -643,6 +647,8 @@ void Sf2Instrument::reloadSynth()
 		{
 			qCritical("error while creating libsamplerate data structure in Sf2Instrument::reloadSynth()");
 		}
+		// fluidsynth renders fewer frames than a period at its lower rate
+		m_resampleBuffer.resize( Engine::audioEngine()->maxFramesPerPeriod() );
 		m_synthMutex.unlock();
 	}
 	updateReverb();
@@ -890,11 +896,7 @@ void Sf2Instrument::renderFrames( f_cnt_t frames, SampleFrame* buf )
 							m_srcState != nullptr )
 	{
 		const fpp_t f = frames * m_internalSampleRate / Engine::audioEngine()->outputSampleRate();
-#ifdef __GNUC__
-		SampleFrame tmp[f];
-#else
-		SampleFrame* tmp = new SampleFrame[f];
-#endif
+		SampleFrame* tmp = m_resampleBuffer.data();
 		fluid_synth_write_float( m_synth, f, tmp, 0, 2, tmp, 1, 2 );
 
 		SRC_DATA src_data;
@@ -905,9 +907,6 @@ void Sf2Instrument::renderFrames( f_cnt_t frames, SampleFrame* buf )
 		src_data.src_ratio = (double) frames / f;
 		src_data.end_of_input = 0;
 		int error = src_process( m_srcState, &src_data );
-#ifndef __GNUC__
-		delete[] tmp;
-#endif
 		if( error )
 		{
 			qCritical( "Sf2Instrument: error while resampling: %s", src_strerror( error ) );
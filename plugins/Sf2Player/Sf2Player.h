@@ -31,6 +31,7 @@
 #include <fluidsynth/types.h>
 #include <QMutex>
 #include <samplerate.h>
+#include <vector>
 
 #include "Instrument.h"
 #include "InstrumentView.h"
@@ -104,6 +105,8 @@ public slots:
 
 private:
 	SRC_STATE * m_srcState;
+	//! What fluidsynth renders before resampling, if it can't run at the engine's rate
+	std::vector<SampleFrame> m_resampleBuffer;
 
 	fluid_settings_t* m_settings;
 	fluid_synth_t* m_synth;
@@ -47,6 +47,7 @@ float frnd(float range)
 #include "NotePlayHandle.h"
 #include "PixmapButton.h"
 #include "MidiEvent.h"
+#include "lmms_math.h"
 
 #include "embed.h"
 
@@ -145,7 +146,7 @@ void SfxrSynth::resetSample( bool restart )
 		phaser_buffer.fill(0.0f);
 		for (auto& noiseSample : noise_buffer) 
 		{
-			noiseSample = frnd(2.0f) - 1.0f; 
+			noiseSample = fastRand(-1.0f, +1.0f); 
 		}
 
 		rep_time=0;
@@ -243,7 +244,7 @@ void SfxrSynth::update( SampleFrame* buffer, const int32_t frameNum )
 				if(s->m_waveFormModel.value()==3)
 					for (auto& noiseSample : noise_buffer) 
 					{
-						noiseSample = frnd(2.0f) - 1.0f;
+						noiseSample = fastRand(-1.0f, +1.0f);
 					}
 			}
 			// base waveform
@@ -24,16 +24,20 @@
 
 #include "SlicerT.h"
 
+#include <QCoreApplication>
 #include <QDomElement>
+#include <QPointer>
 #include <cmath>
-#include <fftw3.h>
 
+#include "AudioAnalysis.h"
+#include "DataFile.h"
 #include "Engine.h"
 #include "InstrumentTrack.h"
 #include "PathUtil.h"
 #include "SampleLoader.h"
 #include "SlicerTView.h"
 #include "Song.h"
+#include "ThreadPool.h"
 #include "embed.h"
 #include "interpolation.h"
 #include "plugin_export.h"
@@ -156,84 +160,95 @@ void SlicerT::deleteNotePluginData(NotePlayHandle* handle)
 	emit isPlaying(-1, 0, 0);
 }
 
-// uses the spectral flux to determine the change in magnitude
-// resources:
-// http://www.iro.umontreal.ca/~pift6080/H09/documents/papers/bello_onset_tutorial.pdf
 void SlicerT::findSlices()
 {
 	if (m_originalSample.sampleSize() <= 1) { return; }
-	m_slicePoints = {};
-
-	const int windowSize = 512;
-	const float minBeatLength = 0.05f; // in seconds, ~ 1/4 length at 220 bpm
 
-	int sampleRate = m_originalSample.sampleRate();
-	int minDist = sampleRate * minBeatLength;
-
-	float maxMag = -1;
-	std::vector<float> singleChannel(m_originalSample.sampleSize(), 0);
-	for (auto i = std::size_t{0}; i < m_originalSample.sampleSize(); i++)
+	// the analysis doesn't depend on the threshold, so it is only done once per sample
+	if (m_analysis && m_analysis->buffer == m_originalSample.buffer())
 	{
-		singleChannel[i] = (m_originalSample.data()[i][0] + m_originalSample.data()[i][1]) / 2;
-		maxMag = std::max(maxMag, singleChannel[i]);
+		findSlices(*m_analysis);
+		return;
 	}
+	analyze();
+}
 
-	// normalize and find 0 crossings
-	std::vector<int> zeroCrossings;
-	float lastValue = 1;
-	for (auto i = std::size_t{0}; i < singleChannel.size(); i++)
-	{
-		singleChannel[i] /= maxMag;
-		if ((lastValue >= 0) != (singleChannel[i] >= 0))
+// uses the spectral flux to determine the change in magnitude
+void SlicerT::analyze()
+{
+	const auto buffer = m_originalSample.buffer();
+	if (m_analyzing == buffer) { return; }
+	m_analyzing = buffer;
+
+	const int windowSize = 512;
+
+	ThreadPool::instance().enqueue([slicer = QPointer<SlicerT>{this}, buffer] {
+		auto analysis = std::make_shared<Analysis>();
+		analysis->buffer = buffer;
+
+		const auto frames = buffer->size();
+		float maxMag = -1;
+		std::vector<float> singleChannel(frames, 0);
+		for (auto i = std::size_t{0}; i < frames; i++)
 		{
-			zeroCrossings.push_back(i);
-			lastValue = singleChannel[i];
+			singleChannel[i] = (buffer->data()[i][0] + buffer->data()[i][1]) / 2;
+			maxMag = std::max(maxMag, singleChannel[i]);
 		}
-	}
 
-	std::vector<float> prevMags(windowSize / 2, 0);
-	std::vector<float> fftIn(windowSize, 0);
-	std::array<fftwf_complex, windowSize> fftOut;
+		// normalize and find 0 crossings
+		float lastValue = 1;
+		for (auto i = std::size_t{0}; i < singleChannel.size(); i++)
+		{
+			singleChannel[i] /= maxMag;
+			if ((lastValue >= 0) != (singleChannel[i] >= 0))
+			{
+				analysis->zeroCrossings.push_back(i);
+				lastValue = singleChannel[i];
+			}
+		}
 
-	fftwf_plan fftPlan = fftwf_plan_dft_r2c_1d(windowSize, fftIn.data(), fftOut.data(), FFTW_MEASURE);
+		float prevFlux = 1E-10f; // small value, no divison by zero
+		for (const float flux : spectralFlux(singleChannel.data(), singleChannel.size(), windowSize))
+		{
+			analysis->fluxRatios.push_back(flux / prevFlux);
+			prevFlux = flux;
+		}
 
-	int lastPoint = -minDist - 1; // to always store 0 first
-	float spectralFlux = 0;
-	float prevFlux = 1E-10f; // small value, no divison by zero
+		QMetaObject::invokeMethod(QCoreApplication::instance(), [slicer, analysis] {
+			if (!slicer) { return; }
 
-	for (int i = 0; i < static_cast<int>(singleChannel.size()) - windowSize; i += windowSize)
-	{
-		// fft
-		std::copy_n(singleChannel.data() + i, windowSize, fftIn.data());
-		fftwf_execute(fftPlan);
+			if (slicer->m_analyzing == analysis->buffer) { slicer->m_analyzing = nullptr; }
+			slicer->m_analysis = analysis;
+			if (analysis->buffer == slicer->m_originalSample.buffer()) { slicer->findSlices(*analysis); }
+		}, Qt::QueuedConnection);
+	});
+}
 
-		// calculate spectral flux in regard to last window
-		for (int j = 0; j < windowSize / 2; j++) // only use niquistic frequencies
-		{
-			float real = fftOut[j][0];
-			float imag = fftOut[j][1];
-			float magnitude = std::sqrt(real * real + imag * imag);
+void SlicerT::findSlices(const Analysis& analysis)
+{
+	m_slicePoints = {};
 
-			// using L2-norm (euclidean distance)
-			float diff = std::abs(magnitude - prevMags[j]);
-			spectralFlux += diff;
+	const int windowSize = 512;
+	const float minBeatLength = 0.05f; // in seconds, ~ 1/4 length at 220 bpm
 
-			prevMags[j] = magnitude;
-		}
+	int sampleRate = m_originalSample.sampleRate();
+	int minDist = sampleRate * minBeatLength;
 
-		if (spectralFlux / prevFlux > 1.0f + m_noteThreshold.value() && i - lastPoint > minDist)
+	int lastPoint = -minDist - 1; // to always store 0 first
+	for (auto window = std::size_t{0}; window < analysis.fluxRatios.size(); window++)
+	{
+		const int i = window * windowSize;
+		if (analysis.fluxRatios[window] > 1.0f + m_noteThreshold.value() && i - lastPoint > minDist)
 		{
 			m_slicePoints.push_back(i);
 			lastPoint = i;
 			if (m_slicePoints.size() > 128) { break; } // no more keys on the keyboard
 		}
-
-		prevFlux = spectralFlux;
-		spectralFlux = 1E-10f; // again for no divison by zero
 	}
 
 	m_slicePoints.push_back(m_originalSample.sampleSize());
 
+	const auto& zeroCrossings = analysis.zeroCrossings;
 	for (float& sliceValue : m_slicePoints)
 	{
 		auto closestZeroCrossing = std::lower_bound(zeroCrossings.begin(), zeroCrossings.end(), sliceValue);
@@ -338,7 +353,8 @@ void SlicerT::saveSettings(QDomDocument& document, QDomElement& element)
 {
 	element.setAttribute("version", "1");
 	element.setAttribute("src", m_originalSample.sampleFile());
-	if (m_originalSample.sampleFile().isEmpty())
+	if (m_originalSample.sampleFile().isEmpty()
+		&& !DataFile::bundleSample(document, element, m_originalSample.buffer()))
 	{
 		element.setAttribute("sampledata", m_originalSample.toBase64());
 	}
@@ -25,6 +25,7 @@
 #ifndef LMMS_SLICERT_H
 #define LMMS_SLICERT_H
 
+#include <memory>
 #include <stdexcept>
 
 #include "AutomatableModel.h"
@@ -93,6 +94,19 @@ public:
 	std::vector<Note> getMidi();
 
 private:
+	//! The onsets found in a sample, independent of the threshold
+	struct Analysis
+	{
+		std::shared_ptr<const SampleBuffer> buffer;
+		std::vector<int> zeroCrossings;
+		//! The spectral flux of each window relative to the window before
+		std::vector<float> fluxRatios;
+	};
+
+	//! Analyzes the current sample on the thread pool, then finds the slices
+	void analyze();
+	void findSlices(const Analysis& analysis);
+
 	FloatModel m_noteThreshold;
 	FloatModel m_fadeOutFrames;
 	IntModel m_originalBPM;
@@ -103,6 +117,10 @@ private:
 
 	std::vector<float> m_slicePoints;
 
+	std::shared_ptr<const Analysis> m_analysis;
+	//! The buffer being analyzed on the thread pool, if any
+	std::shared_ptr<const SampleBuffer> m_analyzing;
+
 	InstrumentTrack* m_parentTrack;
 
 	friend class gui::SlicerTView;
@@ -153,7 +153,7 @@ void SlicerTView::exportMidi()
 		note.saveState(dataFile, noteList);
 	}
 
-	copyString(dataFile.toString(), MimeType::Default);
+	copyDataFile(dataFile, MimeType::Default);
 }
 
 void SlicerTView::openFiles()
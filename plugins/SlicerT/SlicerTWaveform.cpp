@@ -28,6 +28,7 @@
 #include <QMouseEvent>
 #include <QPainter>
 #include <QPainterPath>
+#include <QTimer>
 
 #include "SampleThumbnail.h"
 #include "SlicerT.h"
@@ -292,6 +293,12 @@ void SlicerTWaveform::updateUI()
 	drawSeeker();
 	drawEditor();
 	update();
+
+	if (m_sampleThumbnail.isIncomplete())
+	{
+		// draw the waveforms again once they are available
+		QTimer::singleShot(100, this, &SlicerTWaveform::updateUI);
+	}
 }
 
 // updates the closest object and changes the cursor respectivly
@@ -54,6 +54,7 @@ SaProcessor::SaProcessor(const SaControls *controls) :
 	m_fftBlockSize(FFT_BLOCK_SIZES[0]),
 	m_sampleRate(Engine::audioEngine()->outputSampleRate()),
 	m_framesFilledUp(0),
+	m_historyTop(0),
 	m_spectrumActive(false),
 	m_waterfallActive(false),
 	m_waterfallNotEmpty(0),
@@ -64,12 +65,13 @@ SaProcessor::SaProcessor(const SaControls *controls) :
 
 	m_bufferL.resize(m_inBlockSize, 0);
 	m_bufferR.resize(m_inBlockSize, 0);
-	m_filteredBufferL.resize(m_fftBlockSize, 0);
-	m_filteredBufferR.resize(m_fftBlockSize, 0);
-	m_spectrumL = (fftwf_complex *) fftwf_malloc(binCount() * sizeof (fftwf_complex));
-	m_spectrumR = (fftwf_complex *) fftwf_malloc(binCount() * sizeof (fftwf_complex));
-	m_fftPlanL = fftwf_plan_dft_r2c_1d(m_fftBlockSize, m_filteredBufferL.data(), m_spectrumL, FFTW_MEASURE);
-	m_fftPlanR = fftwf_plan_dft_r2c_1d(m_fftBlockSize, m_filteredBufferR.data(), m_spectrumR, FFTW_MEASURE);
+	m_filteredBufferL = makeFftwBuffer<float>(m_fftBlockSize);
+	m_filteredBufferR = makeFftwBuffer<float>(m_fftBlockSize);
+	std::fill_n(m_filteredBufferL.get(), m_fftBlockSize, 0.f);
+	std::fill_n(m_filteredBufferR.get(), m_fftBlockSize, 0.f);
+	m_spectrumL = makeFftwBuffer<fftwf_complex>(binCount());
+	m_spectrumR = makeFftwBuffer<fftwf_complex>(binCount());
+	m_fftPlan = realFftPlan(m_fftBlockSize);
 
 	m_absSpectrumL.resize(binCount(), 0);
 	m_absSpectrumR.resize(binCount(), 0);
@@ -82,18 +84,7 @@ SaProcessor::SaProcessor(const SaControls *controls) :
 }
 
 
-SaProcessor::~SaProcessor()
-{
-	if (m_fftPlanL != nullptr) {fftwf_destroy_plan(m_fftPlanL);}
-	if (m_fftPlanR != nullptr) {fftwf_destroy_plan(m_fftPlanR);}
-	if (m_spectrumL != nullptr) {fftwf_free(m_spectrumL);}
-	if (m_spectrumR != nullptr) {fftwf_free(m_spectrumR);}
-
-	m_fftPlanL = nullptr;
-	m_fftPlanR = nullptr;
-	m_spectrumL = nullptr;
-	m_spectrumR = nullptr;
-}
+SaProcessor::~SaProcessor() = default;
 
 
 // Load data from audio thread ringbuffer and run FFT analysis if buffer is full enough.
@@ -176,15 +167,15 @@ void SaProcessor::analyze(LocklessRingBuffer<SampleFrame> &ring_buffer)
 
 				// Run FFT on left channel, convert the result to absolute magnitude
 				// spectrum and normalize it.
-				fftwf_execute(m_fftPlanL);
-				absspec(m_spectrumL, m_absSpectrumL.data(), binCount());
+				fftwf_execute_dft_r2c(m_fftPlan, m_filteredBufferL.get(), m_spectrumL.get());
+				absspec(m_spectrumL.get(), m_absSpectrumL.data(), binCount());
 				normalize(m_absSpectrumL, m_normSpectrumL, m_inBlockSize);
 
 				// repeat analysis for right channel if stereo processing is enabled
 				if (stereo)
 				{
-					fftwf_execute(m_fftPlanR);
-					absspec(m_spectrumR, m_absSpectrumR.data(), binCount());
+					fftwf_execute_dft_r2c(m_fftPlan, m_filteredBufferR.get(), m_spectrumR.get());
+					absspec(m_spectrumR.get(), m_absSpectrumR.data(), binCount());
 					normalize(m_absSpectrumR, m_normSpectrumR, m_inBlockSize);
 				}
 
@@ -200,11 +191,10 @@ void SaProcessor::analyze(LocklessRingBuffer<SampleFrame> &ring_buffer)
 
 				if (m_waterfallActive && m_waterfallNotEmpty)
 				{
-					// move waterfall history one line down and clear the top line
-					auto pixel = (QRgb*)m_history_work.data();
-					std::copy(pixel,
-							  pixel + waterfallWidth() * m_waterfallHeight - waterfallWidth(),
-							  pixel + waterfallWidth());
+					// The history is a ring of lines: the newest line replaces the
+					// oldest one instead of moving all others one line down.
+					m_historyTop = (m_historyTop + m_waterfallHeight - 1) % m_waterfallHeight;
+					auto pixel = (QRgb*)m_history_work.data() + m_historyTop * waterfallWidth();
 					memset(pixel, 0, waterfallWidth() * sizeof (QRgb));
 
 					// add newest result on top
@@ -279,12 +269,14 @@ void SaProcessor::analyze(LocklessRingBuffer<SampleFrame> &ring_buffer)
 						}
 					}
 
-					// Copy work buffer to result buffer. Done only if requested, so
-					// that time isn't wasted on updating faster than display FPS.
-					// (The copy is about as expensive as the movement.)
+					// Copy work buffer to result buffer, unrolled so the newest line
+					// is on top. Done only if requested, so that time isn't wasted
+					// on updating faster than display FPS.
 					if (m_flipRequest)
 					{
-						m_history = m_history_work;
+						const auto top = m_history_work.begin() + m_historyTop * waterfallWidth() * sizeof (QRgb);
+						const auto rest = std::copy(top, m_history_work.end(), m_history.begin());
+						std::copy(m_history_work.begin(), top, rest);
 						m_flipRequest = false;
 					}
 				}
@@ -389,25 +381,18 @@ void SaProcessor::reallocateBuffers()
 	QMutexLocker reloc_lock(&m_reallocationAccess);
 	QMutexLocker data_lock(&m_dataAccess);
 
-	// destroy old FFT plan and free the result buffer
-	if (m_fftPlanL != nullptr) {fftwf_destroy_plan(m_fftPlanL);}
-	if (m_fftPlanR != nullptr) {fftwf_destroy_plan(m_fftPlanR);}
-	if (m_spectrumL != nullptr) {fftwf_free(m_spectrumL);}
-	if (m_spectrumR != nullptr) {fftwf_free(m_spectrumR);}
-
-	// allocate new space, create new plan and resize containers
+	// allocate new space, get the plan for the new size and resize containers
 	m_fftWindow.resize(new_in_size, 1.0);
 	precomputeWindow(m_fftWindow.data(), new_in_size, (FFTWindow) m_controls->m_windowModel.value());
 	m_bufferL.resize(new_in_size, 0);
 	m_bufferR.resize(new_in_size, 0);
-	m_filteredBufferL.resize(new_fft_size, 0);
-	m_filteredBufferR.resize(new_fft_size, 0);
-	m_spectrumL = (fftwf_complex *) fftwf_malloc(new_bins * sizeof (fftwf_complex));
-	m_spectrumR = (fftwf_complex *) fftwf_malloc(new_bins * sizeof (fftwf_complex));
-	m_fftPlanL = fftwf_plan_dft_r2c_1d(new_fft_size, m_filteredBufferL.data(), m_spectrumL, FFTW_MEASURE);
-	m_fftPlanR = fftwf_plan_dft_r2c_1d(new_fft_size, m_filteredBufferR.data(), m_spectrumR, FFTW_MEASURE);
-
-	if (m_fftPlanL == nullptr || m_fftPlanR == nullptr)
+	m_filteredBufferL = makeFftwBuffer<float>(new_fft_size);
+	m_filteredBufferR = makeFftwBuffer<float>(new_fft_size);
+	m_spectrumL = makeFftwBuffer<fftwf_complex>(new_bins);
+	m_spectrumR = makeFftwBuffer<fftwf_complex>(new_bins);
+	m_fftPlan = realFftPlan(new_fft_size);
+
+	if (m_fftPlan == nullptr)
 	{
 		#ifdef SA_DEBUG
 			std::cerr << "Analyzer: failed to create new FFT plan!" << std::endl;
@@ -425,6 +410,7 @@ void SaProcessor::reallocateBuffers()
 	m_history.resize((new_bins < m_waterfallMaxWidth ? new_bins : m_waterfallMaxWidth)
 						* m_waterfallHeight
 						* sizeof qRgb(0,0,0), 0);
+	m_historyTop = 0;
 
 	// done; publish new sizes and clean up
 	m_inBlockSize = new_in_size;
@@ -459,14 +445,15 @@ void SaProcessor::clear()
 	m_framesFilledUp = m_inBlockSize - m_inBlockSize / overlaps;
 	std::fill(m_bufferL.begin(), m_bufferL.end(), 0);
 	std::fill(m_bufferR.begin(), m_bufferR.end(), 0);
-	std::fill(m_filteredBufferL.begin(), m_filteredBufferL.end(), 0);
-	std::fill(m_filteredBufferR.begin(), m_filteredBufferR.end(), 0);
+	std::fill_n(m_filteredBufferL.get(), m_fftBlockSize, 0.f);
+	std::fill_n(m_filteredBufferR.get(), m_fftBlockSize, 0.f);
 	std::fill(m_absSpectrumL.begin(), m_absSpectrumL.end(), 0);
 	std::fill(m_absSpectrumR.begin(), m_absSpectrumR.end(), 0);
 	std::fill(m_normSpectrumL.begin(), m_normSpectrumL.end(), 0);
 	std::fill(m_normSpectrumR.begin(), m_normSpectrumR.end(), 0);
 	std::fill(m_history_work.begin(), m_history_work.end(), 0);
 	std::fill(m_history.begin(), m_history.end(), 0);
+	m_historyTop = 0;
 }
 
 // Clear only history work buffer. Used to flush old data when waterfall
@@ -33,6 +33,8 @@
 #include <QRgb>
 #include <vector>
 
+#include "fft_helpers.h"
+
 
 
 namespace lmms
@@ -128,12 +130,11 @@ private:
 	std::vector<float> m_bufferL;			//!< time domain samples (left)
 	std::vector<float> m_bufferR;			//!< time domain samples (right)
 	std::vector<float> m_fftWindow;			//!< precomputed window function coefficients
-	std::vector<float> m_filteredBufferL;	//!< time domain samples with window function applied (left)
-	std::vector<float> m_filteredBufferR;	//!< time domain samples with window function applied (right)
-	fftwf_plan m_fftPlanL;
-	fftwf_plan m_fftPlanR;
-	fftwf_complex *m_spectrumL;				//!< frequency domain samples (complex) (left)
-	fftwf_complex *m_spectrumR;				//!< frequency domain samples (complex) (right)
+	FftwBuffer<float> m_filteredBufferL;	//!< time domain samples with window function applied (left)
+	FftwBuffer<float> m_filteredBufferR;	//!< time domain samples with window function applied (right)
+	fftwf_plan m_fftPlan;					//!< shared plan for m_fftBlockSize, see realFftPlan()
+	FftwBuffer<fftwf_complex> m_spectrumL;	//!< frequency domain samples (complex) (left)
+	FftwBuffer<fftwf_complex> m_spectrumR;	//!< frequency domain samples (complex) (right)
 	std::vector<float> m_absSpectrumL;		//!< frequency domain samples (absolute) (left)
 	std::vector<float> m_absSpectrumR;		//!< frequency domain samples (absolute) (right)
 	std::vector<float> m_normSpectrumL;		//!< frequency domain samples (normalized) (left)
@@ -142,6 +143,7 @@ private:
 	// spectrum history for waterfall: new normSpectrum lines are added on top
 	std::vector<uchar> m_history_work;		//!< local history buffer for render
 	std::vector<uchar> m_history;			//!< public buffer for reading
+	unsigned int m_historyTop;				//!< line of the work buffer holding the newest line
 	bool m_flipRequest;						//!< update public buffer only when requested
 	std::atomic<unsigned int> m_waterfallHeight;	//!< number of stored lines in history buffer
 											// Note: high values may make it harder to see transients.
@@ -811,8 +811,8 @@ std::vector<std::pair<float, std::string>> SaSpectrumView::makeLinearAmpTics(int
 // Periodic update is called by LMMS.
 void SaSpectrumView::periodicUpdate()
 {
-	// check if the widget is visible; if it is not, processing can be paused
-	m_processor->setSpectrumActive(isVisible());
+	// check if the widget can be seen; if it can't, processing can be paused
+	m_processor->setSpectrumActive(isVisible() && !visibleRegion().isEmpty());
 	// tell Qt it is time for repaint
 	update();
 }
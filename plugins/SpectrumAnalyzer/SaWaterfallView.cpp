@@ -149,12 +149,9 @@ void SaWaterfallView::paintEvent(QPaintEvent *event)
 							 m_processor->waterfallHeight(),	// height = number of history lines
 							 QImage::Format_RGB32);
 		lock.unlock();
-		temp.setDevicePixelRatio(devicePixelRatio());			// display at native resolution
-		painter.drawImage(m_displayLeft, m_displayTop,
-						  temp.scaled(m_displayWidth * devicePixelRatio(),
-									  m_displayHeight * devicePixelRatio(),
-									  Qt::IgnoreAspectRatio,
-									  Qt::SmoothTransformation));
+		// scaled while drawing, rather than into a new image on every frame
+		painter.setRenderHint(QPainter::SmoothPixmapTransform, true);
+		painter.drawImage(QRectF(m_displayLeft, m_displayTop, m_displayWidth, m_displayHeight), temp);
 		m_processor->flipRequest();
 	}
 	else
@@ -241,12 +238,14 @@ std::vector<std::pair<float, std::string>> SaWaterfallView::makeTimeTics()
 }
 
 
-// Periodically trigger repaint and check if the widget is visible.
-// If it is not, stop drawing and inform the processor.
+// Periodically trigger repaint and check if the widget can be seen.
+// If it can't, stop drawing and inform the processor.
 void SaWaterfallView::periodicUpdate()
 {
-	m_processor->setWaterfallActive(isVisible());
-	if (isVisible()) {update();}
+	// a widget covered by other windows is visible as well, but can't be seen
+	const bool visible = isVisible() && !visibleRegion().isEmpty();
+	m_processor->setWaterfallActive(visible);
+	if (visible) {update();}
 }
 
 
@@ -0,0 +1,346 @@
+/*
+ * Splitter.cpp - splits the signal into effect chains processed in parallel
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "Splitter.h"
+
+#include <algorithm>
+
+#include "AudioEngine.h"
+#include "AudioEngineWorkerThread.h"
+#include "EffectChain.h"
+#include "ThreadableJob.h"
+#include "embed.h"
+#include "plugin_export.h"
+
+namespace lmms
+{
+
+extern "C"
+{
+
+Plugin::Descriptor PLUGIN_EXPORT splitter_plugin_descriptor =
+{
+	LMMS_STRINGIFY(PLUGIN_NAME),
+	"Splitter",
+	QT_TRANSLATE_NOOP("PluginBrowser", "Splits the signal into effect chains processed in parallel"),
+	"LMMS team",
+	0x0100,
+	Plugin::Type::Effect,
+	new PluginPixmapLoader("logo"),
+	nullptr,
+	nullptr
+};
+
+}
+
+
+
+
+//! The effects of a branch, processed by one job in a buffer of its own
+class SplitterEffect::Branch : public ThreadableJob
+{
+public:
+	Branch(Model* parent) :
+		m_chain(parent)
+	{
+	}
+
+	bool requiresProcessing() const override
+	{
+		return true;
+	}
+
+	EffectChain m_chain;
+	//! The part of the input the branch processes, its output afterwards
+	std::vector<SampleFrame> m_buffer = std::vector<SampleFrame>(Engine::audioEngine()->maxFramesPerPeriod());
+	fpp_t m_frames = 0;
+	//! Whether any effect of the branch still produces output without input
+	bool m_moreEffects = false;
+	//! Lines the output up with the branch of the highest latency
+	CompensationDelay m_compensation;
+
+protected:
+	void doProcessing() override
+	{
+		m_moreEffects = m_chain.processAudioBuffer(m_buffer.data(), m_frames, true);
+	}
+};
+
+
+
+
+SplitterEffect::SplitterEffect(Model* parent, const Descriptor::SubPluginFeatures::Key* key) :
+	Effect(&splitter_plugin_descriptor, parent, key),
+	m_controls(this),
+	m_lowpass1(Engine::audioEngine()->outputSampleRate()),
+	m_highpass1(Engine::audioEngine()->outputSampleRate()),
+	m_lowpass2(Engine::audioEngine()->outputSampleRate()),
+	m_highpass2(Engine::audioEngine()->outputSampleRate()),
+	m_allpassLowpass(Engine::audioEngine()->outputSampleRate()),
+	m_allpassHighpass(Engine::audioEngine()->outputSampleRate())
+{
+	for (auto& branch : m_branches)
+	{
+		branch = std::make_unique<Branch>(this);
+	}
+	m_queuedBranches.reserve(MaxBranches);
+	updateCrossovers();
+}
+
+
+
+
+SplitterEffect::~SplitterEffect() = default;
+
+
+
+
+Effect::ProcessStatus SplitterEffect::processImpl(SampleFrame* buf, const fpp_t frames)
+{
+	const auto branches = activeBranches();
+	split(buf, frames, branches);
+
+	for (auto i = std::size_t{1}; i < branches; ++i)
+	{
+		m_branches[i]->reset();
+		m_branches[i]->m_frames = frames;
+		if (AudioEngineWorkerThread::addJob(m_branches[i].get())) { m_queuedBranches.push_back(m_branches[i].get()); }
+	}
+
+	// process the first branch meanwhile, and the queued ones nobody has taken yet
+	auto& first = *m_branches.front();
+	first.m_frames = frames;
+	first.queue();
+	first.process();
+	AudioEngineWorkerThread::waitForJobs(m_queuedBranches);
+	m_queuedBranches.clear();
+
+	bool moreEffects = false;
+	for (auto i = std::size_t{0}; i < branches; ++i)
+	{
+		auto& branch = *m_branches[i];
+		if (branch.state() != ThreadableJob::ProcessingState::Done)
+		{
+			// the job queue is full
+			branch.queue();
+			branch.process();
+		}
+		moreEffects |= branch.m_moreEffects;
+	}
+
+	compensate(buf, frames, branches);
+	merge(buf, frames, branches);
+
+	// effects with a tail in any branch keep the splitter running
+	return moreEffects ? ProcessStatus::Continue : ProcessStatus::ContinueIfNotQuiet;
+}
+
+
+
+
+f_cnt_t SplitterEffect::latency() const
+{
+	auto latency = f_cnt_t{0};
+	for (auto i = std::size_t{0}; i < activeBranches(); ++i)
+	{
+		latency = std::max(latency, m_branches[i]->m_chain.latency());
+	}
+	return latency;
+}
+
+
+
+
+std::size_t SplitterEffect::activeBranches() const
+{
+	switch (static_cast<Mode>(m_controls.m_modeModel.value()))
+	{
+		case Mode::MidSide: return 2;
+		case Mode::Multiband: return 3;
+		default: return static_cast<std::size_t>(m_controls.m_branchesModel.value());
+	}
+}
+
+
+
+
+EffectChain* SplitterEffect::branch(std::size_t index)
+{
+	return &m_branches[index]->m_chain;
+}
+
+
+
+
+void SplitterEffect::sampleRateChanged()
+{
+	const auto sampleRate = Engine::audioEngine()->outputSampleRate();
+	for (auto filter : {&m_lowpass1, &m_highpass1, &m_lowpass2, &m_highpass2, &m_allpassLowpass, &m_allpassHighpass})
+	{
+		filter->setSampleRate(sampleRate);
+	}
+	updateCrossovers();
+}
+
+
+
+
+void SplitterEffect::updateCrossovers()
+{
+	const auto low = m_controls.m_lowCrossoverModel.value();
+	const auto high = m_controls.m_highCrossoverModel.value();
+	m_lowpass1.setLowpass(low);
+	m_highpass1.setHighpass(low);
+	m_lowpass2.setLowpass(high);
+	m_highpass2.setHighpass(high);
+	m_allpassLowpass.setLowpass(high);
+	m_allpassHighpass.setHighpass(high);
+}
+
+
+
+
+void SplitterEffect::split(const SampleFrame* buf, fpp_t frames, std::size_t branches)
+{
+	const float w = wetLevel();
+	switch (static_cast<Mode>(m_controls.m_modeModel.value()))
+	{
+		case Mode::MidSide:
+		{
+			auto& mid = m_branches[0]->m_buffer;
+			auto& side = m_branches[1]->m_buffer;
+			for (fpp_t f = 0; f < frames; ++f)
+			{
+				const float m = (buf[f][0] + buf[f][1]) * 0.5f * w;
+				const float s = (buf[f][0] - buf[f][1]) * 0.5f * w;
+				mid[f] = SampleFrame(m, m);
+				side[f] = SampleFrame(s, s);
+			}
+			break;
+		}
+		case Mode::Multiband:
+		{
+			auto& low = m_branches[0]->m_buffer;
+			auto& mid = m_branches[1]->m_buffer;
+			auto& high = m_branches[2]->m_buffer;
+			for (fpp_t f = 0; f < frames; ++f)
+			{
+				for (ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+				{
+					const float in = buf[f][ch] * w;
+					const float lowBand = m_lowpass1.update(in, ch);
+					const float rest = m_highpass1.update(in, ch);
+					low[f][ch] = m_allpassLowpass.update(lowBand, ch) + m_allpassHighpass.update(lowBand, ch);
+					mid[f][ch] = m_lowpass2.update(rest, ch);
+					high[f][ch] = m_highpass2.update(rest, ch);
+				}
+			}
+			break;
+		}
+		default:
+			for (auto i = std::size_t{0}; i < branches; ++i)
+			{
+				auto& buffer = m_branches[i]->m_buffer;
+				for (fpp_t f = 0; f < frames; ++f)
+				{
+					buffer[f] = buf[f] * w;
+				}
+			}
+			break;
+	}
+}
+
+
+
+
+void SplitterEffect::compensate(SampleFrame* buf, fpp_t frames, std::size_t branches)
+{
+	// summing branches of different latencies would comb filter, e.g. the
+	// bands of the multiband mode wouldn't sum up flat anymore
+	const auto total = latency();
+	for (auto i = std::size_t{0}; i < branches; ++i)
+	{
+		auto& branch = *m_branches[i];
+		branch.m_compensation.setDelay(total - branch.m_chain.latency());
+		if (branch.m_compensation.delay() > 0)
+		{
+			branch.m_compensation.process(branch.m_buffer.data(), branch.m_buffer.data(), frames);
+		}
+	}
+
+	m_dryCompensation.setDelay(total);
+	if (m_dryCompensation.delay() > 0)
+	{
+		m_dryCompensation.process(buf, buf, frames);
+	}
+}
+
+
+
+
+void SplitterEffect::merge(SampleFrame* buf, fpp_t frames, std::size_t branches)
+{
+	const float d = dryLevel();
+	for (fpp_t f = 0; f < frames; ++f)
+	{
+		buf[f] *= d;
+	}
+
+	if (static_cast<Mode>(m_controls.m_modeModel.value()) == Mode::MidSide)
+	{
+		// effects may have made the mid or side signal stereo, only their sum is used
+		const auto& mid = m_branches[0]->m_buffer;
+		const auto& side = m_branches[1]->m_buffer;
+		for (fpp_t f = 0; f < frames; ++f)
+		{
+			const float m = (mid[f][0] + mid[f][1]) * 0.5f;
+			const float s = (side[f][0] + side[f][1]) * 0.5f;
+			buf[f] += SampleFrame(m + s, m - s);
+		}
+		return;
+	}
+
+	for (auto i = std::size_t{0}; i < branches; ++i)
+	{
+		const auto& buffer = m_branches[i]->m_buffer;
+		for (fpp_t f = 0; f < frames; ++f)
+		{
+			buf[f] += buffer[f];
+		}
+	}
+}
+
+
+
+
+extern "C"
+{
+
+// necessary for getting instance out of shared lib
+PLUGIN_EXPORT Plugin* lmms_plugin_main(Model* parent, void* data)
+{
+	return new SplitterEffect(parent, static_cast<const Plugin::Descriptor::SubPluginFeatures::Key*>(data));
+}
+
+}
+
+} // namespace lmms
@@ -0,0 +1,114 @@
+/*
+ * Splitter.h - splits the signal into effect chains processed in parallel
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_SPLITTER_H
+#define LMMS_SPLITTER_H
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "BasicFilters.h"
+#include "CompensationDelay.h"
+#include "Effect.h"
+#include "SplitterControls.h"
+
+namespace lmms
+{
+
+class EffectChain;
+class ThreadableJob;
+
+/**
+ * Splits its input into branches, each one an effect chain of its own, and
+ * sums what they produce. The branches are processed as jobs of their own on
+ * the worker threads, so that a single heavy channel can use more than one
+ * core, e.g. for multiband or mid/side processing without sends to extra
+ * mixer channels.
+ */
+class SplitterEffect : public Effect
+{
+public:
+	//! How the input is split into the branches
+	enum class Mode
+	{
+		//! Every branch processes a copy of the input
+		Parallel,
+		//! The first branch processes the mid, the second one the side signal
+		MidSide,
+		//! The branches process the bands between the crossovers, the lowest first
+		Multiband
+	};
+
+	static constexpr std::size_t MaxBranches = 4;
+
+	SplitterEffect(Model* parent, const Descriptor::SubPluginFeatures::Key* key);
+	~SplitterEffect() override;
+
+	ProcessStatus processImpl(SampleFrame* buf, const fpp_t frames) override;
+
+	EffectControls* controls() override
+	{
+		return &m_controls;
+	}
+
+	//! The largest latency of the branches, which the other branches and the
+	//! dry signal are delayed to
+	f_cnt_t latency() const override;
+
+	//! The number of branches used in the current mode, always the first ones
+	std::size_t activeBranches() const;
+
+	EffectChain* branch(std::size_t index);
+
+	void sampleRateChanged();
+	void updateCrossovers();
+
+private:
+	class Branch;
+
+	void split(const SampleFrame* buf, fpp_t frames, std::size_t branches);
+	void compensate(SampleFrame* buf, fpp_t frames, std::size_t branches);
+	void merge(SampleFrame* buf, fpp_t frames, std::size_t branches);
+
+	SplitterControls m_controls;
+
+	std::array<std::unique_ptr<Branch>, MaxBranches> m_branches;
+	std::vector<ThreadableJob*> m_queuedBranches;
+	CompensationDelay m_dryCompensation;
+
+	// the crossovers of the multiband mode, the low band is passed through an
+	// all-pass made of the second crossover, so that the bands sum up flat
+	StereoLinkwitzRiley m_lowpass1;
+	StereoLinkwitzRiley m_highpass1;
+	StereoLinkwitzRiley m_lowpass2;
+	StereoLinkwitzRiley m_highpass2;
+	StereoLinkwitzRiley m_allpassLowpass;
+	StereoLinkwitzRiley m_allpassHighpass;
+
+	friend class SplitterControls;
+};
+
+
+} // namespace lmms
+
+#endif // LMMS_SPLITTER_H
@@ -0,0 +1,102 @@
+/*
+ * SplitterControlDialog.cpp - dialog showing the branches of the splitter effect
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "SplitterControlDialog.h"
+
+#include <QHBoxLayout>
+#include <QVBoxLayout>
+
+#include "ComboBox.h"
+#include "EffectRackView.h"
+#include "Knob.h"
+#include "LcdSpinBox.h"
+#include "Splitter.h"
+#include "SplitterControls.h"
+
+namespace lmms::gui
+{
+
+
+SplitterControlDialog::SplitterControlDialog(SplitterControls* controls) :
+	EffectControlDialog(controls),
+	m_controls(controls)
+{
+	setAutoFillBackground(true);
+	auto layout = new QVBoxLayout(this);
+
+	auto controlsLayout = new QHBoxLayout();
+	controlsLayout->setSpacing(5);
+	layout->addLayout(controlsLayout);
+
+	auto modeBox = new ComboBox(this);
+	modeBox->setFixedSize(120, ComboBox::DEFAULT_HEIGHT);
+	modeBox->setModel(&controls->m_modeModel);
+	controlsLayout->addWidget(modeBox);
+
+	m_branchesBox = new LcdSpinBox(1, this, "Branches");
+	m_branchesBox->setModel(&controls->m_branchesModel);
+	m_branchesBox->setLabel(tr("BRANCHES"));
+	m_branchesBox->setToolTip(tr("Number of branches processing a copy of the input"));
+	controlsLayout->addWidget(m_branchesBox);
+
+	m_lowCrossoverKnob = new Knob(KnobType::Bright26, tr("LOW"), this);
+	m_lowCrossoverKnob->setModel(&controls->m_lowCrossoverModel);
+	m_lowCrossoverKnob->setHintText(tr("Low crossover:"), " Hz");
+	controlsLayout->addWidget(m_lowCrossoverKnob);
+
+	m_highCrossoverKnob = new Knob(KnobType::Bright26, tr("HIGH"), this);
+	m_highCrossoverKnob->setModel(&controls->m_highCrossoverModel);
+	m_highCrossoverKnob->setHintText(tr("High crossover:"), " Hz");
+	controlsLayout->addWidget(m_highCrossoverKnob);
+	controlsLayout->addStretch();
+
+	auto racksLayout = new QHBoxLayout();
+	layout->addLayout(racksLayout, 1);
+	for (auto i = std::size_t{0}; i < SplitterEffect::MaxBranches; ++i)
+	{
+		m_racks.push_back(new EffectRackView(controls->m_effect->branch(i), this));
+		racksLayout->addWidget(m_racks.back());
+	}
+
+	connect(controls, &SplitterControls::branchesChanged, this, &SplitterControlDialog::updateBranches);
+	updateBranches();
+}
+
+
+
+
+void SplitterControlDialog::updateBranches()
+{
+	const auto mode = static_cast<SplitterEffect::Mode>(m_controls->m_modeModel.value());
+	m_branchesBox->setVisible(mode == SplitterEffect::Mode::Parallel);
+	m_lowCrossoverKnob->setVisible(mode == SplitterEffect::Mode::Multiband);
+	m_highCrossoverKnob->setVisible(mode == SplitterEffect::Mode::Multiband);
+
+	const auto branches = m_controls->m_effect->activeBranches();
+	for (auto i = std::size_t{0}; i < m_racks.size(); ++i)
+	{
+		m_racks[i]->setVisible(i < branches);
+	}
+}
+
+
+} // namespace lmms::gui
@@ -0,0 +1,68 @@
+/*
+ * SplitterControlDialog.h - dialog showing the branches of the splitter effect
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_GUI_SPLITTER_CONTROL_DIALOG_H
+#define LMMS_GUI_SPLITTER_CONTROL_DIALOG_H
+
+#include <vector>
+
+#include "EffectControlDialog.h"
+
+namespace lmms
+{
+
+class SplitterControls;
+
+namespace gui
+{
+
+class EffectRackView;
+class Knob;
+class LcdSpinBox;
+
+
+class SplitterControlDialog : public EffectControlDialog
+{
+	Q_OBJECT
+public:
+	SplitterControlDialog(SplitterControls* controls);
+	~SplitterControlDialog() override = default;
+
+	bool isResizable() const override { return true; }
+
+private:
+	//! Shows the racks of the branches used and the controls of the mode
+	void updateBranches();
+
+	SplitterControls* m_controls;
+	LcdSpinBox* m_branchesBox;
+	Knob* m_lowCrossoverKnob;
+	Knob* m_highCrossoverKnob;
+	std::vector<EffectRackView*> m_racks;
+};
+
+
+} // namespace gui
+
+} // namespace lmms
+
+#endif // LMMS_GUI_SPLITTER_CONTROL_DIALOG_H
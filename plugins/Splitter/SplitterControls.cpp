@@ -0,0 +1,112 @@
+/*
+ * SplitterControls.cpp - controls of the splitter effect
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "SplitterControls.h"
+
+#include <QDomElement>
+
+#include "EffectChain.h"
+#include "Splitter.h"
+
+namespace lmms
+{
+
+
+SplitterControls::SplitterControls(SplitterEffect* effect) :
+	EffectControls(effect),
+	m_effect(effect),
+	m_modeModel(this, tr("Mode")),
+	m_branchesModel(2, 2, SplitterEffect::MaxBranches, this, tr("Branches")),
+	m_lowCrossoverModel(200.f, 20.f, 20000.f, 1.f, this, tr("Low crossover")),
+	m_highCrossoverModel(2000.f, 20.f, 20000.f, 1.f, this, tr("High crossover"))
+{
+	m_modeModel.addItem(tr("Parallel"));
+	m_modeModel.addItem(tr("Mid/side"));
+	m_modeModel.addItem(tr("Multiband"));
+
+	m_lowCrossoverModel.setScaleLogarithmic(true);
+	m_highCrossoverModel.setScaleLogarithmic(true);
+
+	connect(&m_modeModel, &ComboBoxModel::dataChanged, this, &SplitterControls::branchesChanged);
+	connect(&m_branchesModel, &IntModel::dataChanged, this, &SplitterControls::branchesChanged);
+
+	// the crossovers mustn't cross, the one changed last wins
+	connect(&m_lowCrossoverModel, &FloatModel::dataChanged, this, [this] {
+		if (m_highCrossoverModel.value() < m_lowCrossoverModel.value())
+		{
+			m_highCrossoverModel.setValue(m_lowCrossoverModel.value());
+		}
+		m_effect->updateCrossovers();
+	});
+	connect(&m_highCrossoverModel, &FloatModel::dataChanged, this, [this] {
+		if (m_lowCrossoverModel.value() > m_highCrossoverModel.value())
+		{
+			m_lowCrossoverModel.setValue(m_highCrossoverModel.value());
+		}
+		m_effect->updateCrossovers();
+	});
+	connect(Engine::audioEngine(), &AudioEngine::sampleRateChanged, this, [this] { m_effect->sampleRateChanged(); });
+}
+
+
+
+
+void SplitterControls::saveSettings(QDomDocument& doc, QDomElement& parent)
+{
+	m_modeModel.saveSettings(doc, parent, "mode");
+	m_branchesModel.saveSettings(doc, parent, "branches");
+	m_lowCrossoverModel.saveSettings(doc, parent, "lowcrossover");
+	m_highCrossoverModel.saveSettings(doc, parent, "highcrossover");
+
+	for (auto i = std::size_t{0}; i < SplitterEffect::MaxBranches; ++i)
+	{
+		// unused branches keep their effects in case the mode is changed back
+		auto branch = doc.createElement("branch");
+		parent.appendChild(branch);
+		m_effect->branch(i)->saveState(doc, branch);
+	}
+}
+
+
+
+
+void SplitterControls::loadSettings(const QDomElement& parent)
+{
+	m_modeModel.loadSettings(parent, "mode");
+	m_branchesModel.loadSettings(parent, "branches");
+	m_lowCrossoverModel.loadSettings(parent, "lowcrossover");
+	m_highCrossoverModel.loadSettings(parent, "highcrossover");
+
+	auto branch = parent.firstChildElement("branch");
+	for (auto i = std::size_t{0}; i < SplitterEffect::MaxBranches; ++i)
+	{
+		const auto chain = branch.firstChildElement(m_effect->branch(i)->nodeName());
+		if (chain.isNull()) { m_effect->branch(i)->clear(); }
+		else { m_effect->branch(i)->restoreState(chain); }
+		branch = branch.nextSiblingElement("branch");
+	}
+
+	m_effect->updateCrossovers();
+}
+
+
+} // namespace lmms
@@ -0,0 +1,78 @@
+/*
+ * SplitterControls.h - controls of the splitter effect
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_SPLITTER_CONTROLS_H
+#define LMMS_SPLITTER_CONTROLS_H
+
+#include "ComboBoxModel.h"
+#include "EffectControls.h"
+#include "SplitterControlDialog.h"
+
+namespace lmms
+{
+
+class SplitterEffect;
+
+class SplitterControls : public EffectControls
+{
+	Q_OBJECT
+public:
+	SplitterControls(SplitterEffect* effect);
+	~SplitterControls() override = default;
+
+	//! Saves the effect chains of the branches as well
+	void saveSettings(QDomDocument& doc, QDomElement& parent) override;
+	void loadSettings(const QDomElement& parent) override;
+	inline QString nodeName() const override
+	{
+		return "SplitterControls";
+	}
+
+	int controlCount() override
+	{
+		return 4;
+	}
+
+	gui::EffectControlDialog* createView() override
+	{
+		return new gui::SplitterControlDialog(this);
+	}
+
+signals:
+	//! Emitted when the number of branches used changes
+	void branchesChanged();
+
+private:
+	SplitterEffect* m_effect;
+	ComboBoxModel m_modeModel;
+	IntModel m_branchesModel;
+	FloatModel m_lowCrossoverModel;
+	FloatModel m_highCrossoverModel;
+
+	friend class gui::SplitterControlDialog;
+	friend class SplitterEffect;
+};
+
+
+} // namespace lmms
+
+#endif // LMMS_SPLITTER_CONTROLS_H
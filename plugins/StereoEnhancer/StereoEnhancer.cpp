@@ -83,11 +83,26 @@ StereoEnhancerEffect::~StereoEnhancerEffect()
 
 
 Effect::ProcessStatus StereoEnhancerEffect::processImpl(SampleFrame* buf, const fpp_t frames)
+{
+	processFrames(buf, 0, frames);
+
+	if( !isRunning() )
+	{
+		clearMyBuffer();
+	}
+
+	return ProcessStatus::ContinueIfNotQuiet;
+}
+
+
+
+
+void StereoEnhancerEffect::processFrames(SampleFrame* buf, fpp_t start, fpp_t end)
 {
 	const float d = dryLevel();
 	const float w = wetLevel();
 
-	for (fpp_t f = 0; f < frames; ++f)
+	for (fpp_t f = start; f < end; ++f)
 	{
 
 		// copy samples into the delay buffer
@@ -118,13 +133,6 @@ Effect::ProcessStatus StereoEnhancerEffect::processImpl(SampleFrame* buf, const
 		m_currFrame += 1;
 		m_currFrame %= DEFAULT_BUFFER_SIZE;
 	}
-
-	if( !isRunning() )
-	{
-		clearMyBuffer();
-	}
-
-	return ProcessStatus::ContinueIfNotQuiet;
 }
 
 
@@ -42,6 +42,12 @@ public:
 	~StereoEnhancerEffect() override;
 
 	ProcessStatus processImpl(SampleFrame* buf, const fpp_t frames) override;
+	void processFrames(SampleFrame* buf, fpp_t start, fpp_t end) override;
+
+	bool isFusible() const override
+	{
+		return true;
+	}
 
 	EffectControls * controls() override
 	{
@@ -66,7 +66,16 @@ StereoMatrixEffect::StereoMatrixEffect(
 
 Effect::ProcessStatus StereoMatrixEffect::processImpl(SampleFrame* buf, const fpp_t frames)
 {
-	for (fpp_t f = 0; f < frames; ++f)
+	processFrames(buf, 0, frames);
+	return ProcessStatus::ContinueIfNotQuiet;
+}
+
+
+
+
+void StereoMatrixEffect::processFrames(SampleFrame* buf, fpp_t start, fpp_t end)
+{
+	for (fpp_t f = start; f < end; ++f)
 	{	
 		const float d = dryLevel();
 		const float w = wetLevel();
@@ -85,8 +94,6 @@ Effect::ProcessStatus StereoMatrixEffect::processImpl(SampleFrame* buf, const fp
 		buf[f][1] += ( m_smControls.m_lrModel.value( f ) * l  +
 					m_smControls.m_rrModel.value( f ) * r ) * w;
 	}
-
-	return ProcessStatus::ContinueIfNotQuiet;
 }
 
 
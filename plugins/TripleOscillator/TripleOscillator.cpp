@@ -128,6 +128,7 @@ OscillatorObject::OscillatorObject( Model * _parent, int _idx ) :
 			this, SLOT( updatePhaseOffsetLeft() ), Qt::DirectConnection );
 	connect ( &m_useWaveTableModel, SIGNAL(dataChanged()),
 			this, SLOT( updateUseWaveTable()));
+	connect(&m_waveShapeModel, SIGNAL(dataChanged()), this, SLOT(prepareWaveTable()));
 
 	updatePhaseOffsetLeft();
 	updatePhaseOffsetRight();
@@ -207,13 +208,26 @@ void OscillatorObject::updatePhaseOffsetRight()
 void OscillatorObject::updateUseWaveTable()
 {
 	m_useWaveTable = m_useWaveTableModel.value();
+	prepareWaveTable();
+}
+
+
+
+
+void OscillatorObject::prepareWaveTable()
+{
+	// generate the wavetables before the first note needs them on the audio thread
+	if (m_useWaveTable)
+	{
+		Oscillator::prepareWaveTable(static_cast<Oscillator::WaveShape>(m_waveShapeModel.value()));
+	}
 }
 
 
 
 
 TripleOscillator::TripleOscillator( InstrumentTrack * _instrument_track ) :
-	Instrument( _instrument_track, &tripleoscillator_plugin_descriptor )
+	Instrument(_instrument_track, &tripleoscillator_plugin_descriptor, nullptr, Flag::BatchesNotes)
 {
 	for( int i = 0; i < NUM_OF_OSCILLATORS; ++i )
 	{
@@ -97,6 +97,7 @@ private slots:
 	void updatePhaseOffsetLeft();
 	void updatePhaseOffsetRight();
 	void updateUseWaveTable();
+	void prepareWaveTable();
 
 } ;
 
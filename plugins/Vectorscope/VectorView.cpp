@@ -28,6 +28,7 @@
 #include <cmath>
 
 #include <QPainter>
+#include <QVector>
 
 #include "ColorChooser.h"
 #include "GuiApplication.h"
@@ -98,18 +99,12 @@ void VectorView::paintEvent(QPaintEvent *event)
 
 	const auto traceWidth = 2. / (scaleValue * m_zoom);
 
-	// This will add colors so that line intersections produce lighter colors/intensities
-	painter.setCompositionMode(QPainter::CompositionMode_Plus);
-	painter.setTransform(tracePaintingTransform);
-
 	// Get new samples from the lockless input FIFO buffer
 	const auto inBuffer = m_bufferReader.read_max(m_inputBuffer->capacity());
 	const std::size_t frameCount = inBuffer.size();
 
-	for (std::size_t frame = 0; frame < frameCount; ++frame)
+	const auto pointOf = [logScale](SampleFrame sampleFrame)
 	{
-		auto sampleFrame = inBuffer[frame];
-
 		if (logScale)
 		{
 			const float distance = std::sqrt(sampleFrame.sumOfSquaredAmplitudes());
@@ -138,24 +133,88 @@ void VectorView::paintEvent(QPaintEvent *event)
 		const auto side = sampleFrame.left() - sampleFrame.right();
 
 		// We negate the mid value of the coordinate so that it tilts correctly if we pan hard left and hard right
-		QPointF currentPoint(side, -mid);
+		return QPointF(side, -mid);
+	};
 
-		const auto darkenedColor(m_colorTrace.darker(100 + frame));
-		painter.setPen(QPen(darkenedColor, traceWidth));
-
-		// Only draw a line if we can draw a line, i.e. if the point really changes.
-		// Otherwise just produce a point.
-		// Without this check Qt will draw horizontal lines when silence is processed.
-		if (linesMode && m_lastPoint != currentPoint)
+	if (linesMode)
+	{
+		// This will add colors so that line intersections produce lighter colors/intensities
+		painter.setCompositionMode(QPainter::CompositionMode_Plus);
+		painter.setTransform(tracePaintingTransform);
+
+		// The lines of neighbouring frames hardly differ in color, so they
+		// are drawn in batches of one color instead of one by one
+		constexpr std::size_t FramesPerBatch = 16;
+		QVector<QLineF> lines;
+		QVector<QPointF> points;
+		for (std::size_t first = 0; first < frameCount; first += FramesPerBatch)
 		{
-			painter.drawLine(QLineF(m_lastPoint, currentPoint));
+			lines.clear();
+			points.clear();
+			for (std::size_t frame = first; frame < std::min(first + FramesPerBatch, frameCount); ++frame)
+			{
+				const QPointF currentPoint = pointOf(inBuffer[frame]);
+
+				// Only draw a line if we can draw a line, i.e. if the point really changes.
+				// Otherwise just produce a point.
+				// Without this check Qt will draw horizontal lines when silence is processed.
+				if (m_lastPoint != currentPoint) { lines.push_back(QLineF(m_lastPoint, currentPoint)); }
+				else { points.push_back(currentPoint); }
+
+				m_lastPoint = currentPoint;
+			}
+
+			painter.setPen(QPen(m_colorTrace.darker(100 + static_cast<int>(first)), traceWidth));
+			painter.drawLines(lines);
+			painter.drawPoints(points);
 		}
-		else
+	}
+	else
+	{
+		// Points are plotted into an image directly, which takes a fraction of
+		// the time QPainter needs for every single point
+		const qreal ratio = devicePixelRatioF();
+		const QSize imageSize = size() * ratio;
+		if (m_pointImage.size() != imageSize) { m_pointImage = QImage(imageSize, QImage::Format_RGB32); }
+		m_pointImage.fill(Qt::black);
+
+		const QTransform imageTransform = tracePaintingTransform * QTransform::fromScale(ratio, ratio);
+		// as wide as the pen the lines are drawn with
+		const int pointSize = std::max(1, qRound(2 * ratio));
+		const int imageWidth = m_pointImage.width();
+		const int imageHeight = m_pointImage.height();
+		auto pixels = reinterpret_cast<QRgb*>(m_pointImage.bits());
+		const auto pixelsPerLine = m_pointImage.bytesPerLine() / static_cast<int>(sizeof(QRgb));
+
+		const float alpha = m_colorTrace.alphaF();
+		for (std::size_t frame = 0; frame < frameCount; ++frame)
 		{
-			painter.drawPoint(currentPoint);
+			const QPointF currentPoint = pointOf(inBuffer[frame]);
+			m_lastPoint = currentPoint;
+
+			// older frames are darker, like QColor::darker(100 + frame)
+			const float brightness = alpha * 100.f / (100.f + frame);
+			const int red = static_cast<int>(m_colorTrace.red() * brightness);
+			const int green = static_cast<int>(m_colorTrace.green() * brightness);
+			const int blue = static_cast<int>(m_colorTrace.blue() * brightness);
+
+			// intensities add up where points overlap, like with CompositionMode_Plus
+			const QPointF center = imageTransform.map(currentPoint);
+			const int left = qRound(center.x() - pointSize / 2.);
+			const int top = qRound(center.y() - pointSize / 2.);
+			for (int y = std::max(top, 0); y < std::min(top + pointSize, imageHeight); ++y)
+			{
+				QRgb* line = pixels + y * pixelsPerLine;
+				for (int x = std::max(left, 0); x < std::min(left + pointSize, imageWidth); ++x)
+				{
+					line[x] = qRgb(std::min(qRed(line[x]) + red, 255),
+						std::min(qGreen(line[x]) + green, 255),
+						std::min(qBlue(line[x]) + blue, 255));
+				}
+			}
 		}
 
-		m_lastPoint = currentPoint;
+		painter.drawImage(rect(), m_pointImage);
 	}
 
 	// Draw grid and labels overlay
@@ -215,10 +274,10 @@ void VectorView::paintEvent(QPaintEvent *event)
 }
 
 
-// Periodically trigger repaint and check if the widget is visible
+// Periodically trigger repaint and check if the widget can be seen
 void VectorView::periodicUpdate()
 {
-	if (isVisible())
+	if (isVisible() && !visibleRegion().isEmpty())
 	{
 		update();
 	}
@@ -24,6 +24,7 @@
 #ifndef VECTORVIEW_H
 #define VECTORVIEW_H
 
+#include <QImage>
 #include <QWidget>
 
 #include "LocklessRingBuffer.h"
@@ -77,6 +78,8 @@ private:
 	unsigned int m_zoomTimestamp;
 
 	QPointF m_lastPoint = QPoint();
+	//! Target of the points, when not drawing lines
+	QImage m_pointImage;
 
 	QColor m_colorTrace = QColor(60, 255, 130, 255);	// ~LMMS green
 	QColor m_colorGrid = QColor(76, 80, 84, 128);		// ~60 % gray (slightly cold / blue), 50 % transparent
@@ -67,19 +67,26 @@ Plugin::Descriptor PLUGIN_EXPORT vibedstrings_plugin_descriptor =
 class Vibed::StringContainer
 {
 public:
-	StringContainer(float pitch, sample_rate_t sampleRate, int bufferLength) :
-		m_pitch(pitch), m_sampleRate(sampleRate), m_bufferLength(bufferLength) {}
-
+	StringContainer() = default;
 	~StringContainer() = default;
 
+	//! Starts a new note, the strings keep their memory
+	void start(float pitch, sample_rate_t sampleRate, int bufferLength)
+	{
+		m_pitch = pitch;
+		m_sampleRate = sampleRate;
+		m_bufferLength = bufferLength;
+		m_exists.fill(false);
+	}
+
 	void addString(std::size_t harm, float pick, float pickup, const float* impulse, float randomize,
 		float stringLoss, float detune, int oversample, bool state, int id)
 	{
 		constexpr auto octave = std::array{0.25f, 0.5f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f};
 		assert(harm < octave.size());
 
-		m_strings[id] = VibratingString{m_pitch * octave[harm], pick, pickup, impulse, m_bufferLength,
-			m_sampleRate, oversample, randomize, stringLoss, detune, state};
+		m_strings[id].pluck(m_pitch * octave[harm], pick, pickup, impulse, m_bufferLength,
+			m_sampleRate, oversample, randomize, stringLoss, detune, state);
 
 		m_exists[id] = true;
 	}
@@ -89,9 +96,9 @@ public:
 	sample_t getStringSample(int id) { return m_strings[id].nextSample(); }
 
 private:
-	const float m_pitch;
-	const sample_rate_t m_sampleRate;
-	const int m_bufferLength;
+	float m_pitch = 0.f;
+	sample_rate_t m_sampleRate = 0;
+	int m_bufferLength = 0;
 	std::array<VibratingString, s_stringCount> m_strings{};
 	std::array<bool, s_stringCount> m_exists{};
 };
@@ -124,8 +131,12 @@ Vibed::Vibed(InstrumentTrack* instrumentTrack) :
 		m_graphModels[harm] = std::make_unique<graphModel>(-1.0, 1.0, s_sampleLength, this);
 		m_graphModels[harm]->setWaveToSine();
 	}
+
+	m_containerPool.reserve(s_containerPoolSize);
 }
 
+Vibed::~Vibed() = default;
+
 void Vibed::saveSettings(QDomDocument& doc, QDomElement& elem)
 {
 	// Save plugin version
@@ -205,8 +216,8 @@ void Vibed::playNote(NotePlayHandle* n, SampleFrame* workingBuffer)
 {
 	if (!n->m_pluginData)
 	{
-		const auto newContainer = new StringContainer{n->frequency(),
-			Engine::audioEngine()->outputSampleRate(), s_sampleLength};
+		const auto newContainer = takeContainer().release();
+		newContainer->start(n->frequency(), Engine::audioEngine()->outputSampleRate(), s_sampleLength);
 
 		n->m_pluginData = newContainer;
 
@@ -253,7 +264,28 @@ void Vibed::playNote(NotePlayHandle* n, SampleFrame* workingBuffer)
 
 void Vibed::deleteNotePluginData(NotePlayHandle* n)
 {
-	delete static_cast<StringContainer*>(n->m_pluginData);
+	auto container = std::unique_ptr<StringContainer>{static_cast<StringContainer*>(n->m_pluginData)};
+
+	// notes are played on several threads, but none of them waits for another
+	const auto lock = std::unique_lock{m_containerPoolMutex, std::try_to_lock};
+	if (lock && m_containerPool.size() < s_containerPoolSize)
+	{
+		m_containerPool.push_back(std::move(container));
+	}
+}
+
+auto Vibed::takeContainer() -> std::unique_ptr<StringContainer>
+{
+	{
+		const auto lock = std::unique_lock{m_containerPoolMutex, std::try_to_lock};
+		if (lock && !m_containerPool.empty())
+		{
+			auto container = std::move(m_containerPool.back());
+			m_containerPool.pop_back();
+			return container;
+		}
+	}
+	return std::make_unique<StringContainer>();
 }
 
 gui::PluginView* Vibed::instantiateView(QWidget* parent)
@@ -35,6 +35,8 @@
 
 #include <array>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 namespace lmms
 {
@@ -52,7 +54,7 @@ class Vibed : public Instrument
 	Q_OBJECT
 public:
 	Vibed(InstrumentTrack* instrumentTrack);
-	~Vibed() override = default;
+	~Vibed() override;
 
 	void playNote(NotePlayHandle* n, SampleFrame* workingBuffer) override;
 	void deleteNotePluginData(NotePlayHandle* n) override;
@@ -69,6 +71,11 @@ private:
 
 	static constexpr int s_sampleLength = 128;
 	static constexpr int s_stringCount = 9;
+	//! How many containers of released notes are kept for new ones
+	static constexpr std::size_t s_containerPoolSize = 8;
+
+	//! A container from the pool, or a new one if there is none
+	auto takeContainer() -> std::unique_ptr<StringContainer>;
 
 	std::array<std::unique_ptr<FloatModel>, s_stringCount> m_pickModels;
 	std::array<std::unique_ptr<FloatModel>, s_stringCount> m_pickupModels;
@@ -83,6 +90,9 @@ private:
 	std::array<std::unique_ptr<BoolModel>, s_stringCount> m_impulseModels;
 	std::array<std::unique_ptr<NineButtonSelectorModel>, s_stringCount> m_harmonicModels;
 
+	std::vector<std::unique_ptr<StringContainer>> m_containerPool;
+	std::mutex m_containerPoolMutex;
+
 	friend class gui::VibedView;
 };
 
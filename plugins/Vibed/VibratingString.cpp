@@ -27,71 +27,92 @@
 #include "AudioEngine.h"
 #include "Engine.h"
 #include "LmmsTypes.h"
+#include "lmms_math.h"
 
 #include <algorithm>
-#include <cstdlib>
 
 namespace lmms
 {
 
 
-VibratingString::VibratingString(float pitch, float pick, float pickup, const float* impulse, int len,
-	sample_rate_t sampleRate, int oversample, float randomize, float stringLoss, float detune, bool state) :
-	m_oversample{2 * oversample / static_cast<int>(sampleRate / Engine::audioEngine()->baseSampleRate())},
-	m_randomize{randomize},
-	m_stringLoss{1.0f - stringLoss},
-	m_choice{static_cast<int>(m_oversample * static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX))},
-	m_state{0.1f},
-	m_outsamp{std::make_unique<sample_t[]>(m_oversample)}
+void VibratingString::pluck(float pitch, float pick, float pickup, const float* impulse, int len,
+	sample_rate_t sampleRate, int oversample, float randomize, float stringLoss, float detune, bool state)
 {
+	m_oversample = 2 * oversample / static_cast<int>(sampleRate / Engine::audioEngine()->baseSampleRate());
+	m_randomize = randomize;
+	m_stringLoss = 1.0f - stringLoss;
+	m_choice = static_cast<int>(m_oversample * fastRand(1.0f));
+	m_state = 0.1f;
+	m_outsamp.assign(m_oversample, 0.f);
+
 	int stringLength = static_cast<int>(m_oversample * sampleRate / pitch) + 1;
 	stringLength += static_cast<int>(stringLength * -detune);
 
 	const int pickInt = static_cast<int>(std::ceil(stringLength * pick));
 
+	m_length = std::max(stringLength, 2);
+	m_shape.resize(m_length);
+
+	const float* values = impulse;
 	if (!state)
 	{
-		m_impulse = std::make_unique<float[]>(stringLength);
-		resample(impulse, len, stringLength);
+		m_impulse.resize(m_length);
+		resample(impulse, len, m_length);
+		values = m_impulse.data();
 	}
-	else
+
+	m_toBridge.setMaxDelay(m_length);
+	setShape(pickInt, values, len, 0.5f, state);
+	for (int i = 0; i < m_length; ++i)
 	{
-		m_impulse = std::make_unique<float[]>(len);
-		std::copy_n(impulse, len, m_impulse.get());
+		m_toBridge.write({m_shape[i]});
 	}
 
-	m_toBridge = VibratingString::initDelayLine(stringLength);
-	m_fromBridge = VibratingString::initDelayLine(stringLength);
-
-	VibratingString::setDelayLine(m_toBridge.get(), pickInt, m_impulse.get(), len, 0.5f, state);
-	VibratingString::setDelayLine(m_fromBridge.get(), pickInt, m_impulse.get(), len, 0.5f, state);
+	// written from x = L to x = 0, as its samples travel the other way
+	m_fromBridge.setMaxDelay(m_length);
+	setShape(pickInt, values, len, 0.5f, state);
+	for (int i = m_length - 1; i >= 0; --i)
+	{
+		m_fromBridge.write({m_shape[i]});
+	}
 
-	m_pickupLoc = static_cast<int>(pickup * stringLength);
+	m_pickupLoc = static_cast<int>(pickup * stringLength) % m_length;
 }
 
-std::unique_ptr<VibratingString::DelayLine> VibratingString::initDelayLine(int len)
+void VibratingString::setShape(int pick, const float* values, int len, float scale, bool state)
 {
-	auto dl = std::make_unique<VibratingString::DelayLine>();
-	dl->length = len;
-	if (len > 0)
+	const auto randomOffset = [this] { return (m_randomize / 2.0f - m_randomize) * fastRand(1.0f); };
+
+	for (auto& sample : m_shape)
+	{
+		sample = randomOffset();
+	}
+
+	if (!state)
 	{
-		dl->data = std::make_unique<sample_t[]>(len);
-		for (int i = 0; i < dl->length; ++i)
+		for (int i = 0; i < pick; ++i)
+		{
+			m_shape[i] = scale * values[m_length - i - 1] + randomOffset();
+		}
+		for (int i = pick; i < m_length; ++i)
 		{
-			float r = static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX);
-			float offset = (m_randomize / 2.0f - m_randomize) * r;
-			dl->data[i] = offset;
+			m_shape[i] = scale * values[i - pick] + randomOffset();
+		}
+	}
+	else if (len + pick > m_length)
+	{
+		for (int i = pick; i < m_length; ++i)
+		{
+			m_shape[i] = scale * values[i - pick] + randomOffset();
 		}
 	}
 	else
 	{
-		dl->data = nullptr;
+		for (int i = 0; i < len; ++i)
+		{
+			m_shape[i + pick] = scale * values[i] + randomOffset();
+		}
 	}
-
-	dl->pointer = dl->data.get();
-	dl->end = dl->data.get() + len - 1;
-
-	return dl;
 }
 
 void VibratingString::resample(const float* src, f_cnt_t srcFrames, f_cnt_t dstFrames)
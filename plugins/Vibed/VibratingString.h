@@ -25,9 +25,9 @@
 #ifndef LMMS_VIBRATING_STRING_H
 #define LMMS_VIBRATING_STRING_H
 
-#include <memory>
-#include <cstdlib>
+#include <vector>
 
+#include "Delay.h"
 #include "LmmsTypes.h"
 
 namespace lmms
@@ -38,202 +38,96 @@ class VibratingString
 {
 public:
 	VibratingString() = default;
-	VibratingString(float pitch, float pick, float pickup, const float* impulse, int len,
-		sample_rate_t sampleRate, int oversample, float randomize, float stringLoss, float detune, bool state);
 	~VibratingString() = default;
 
 	VibratingString(const VibratingString&) = delete;
 	VibratingString& operator=(const VibratingString&) = delete;
-	VibratingString(VibratingString&&) noexcept = delete;
-	VibratingString& operator=(VibratingString&&) noexcept = default;
+
+	//! Sets the string up for a new note. The memory of the last note is reused where it is large enough,
+	//! so strings kept from released notes can be plucked without allocating.
+	void pluck(float pitch, float pick, float pickup, const float* impulse, int len,
+		sample_rate_t sampleRate, int oversample, float randomize, float stringLoss, float detune, bool state);
 
 	sample_t nextSample()
 	{
 		for (int i = 0; i < m_oversample; ++i)
 		{
 			// Output at pickup position
-			m_outsamp[i] = fromBridgeAccess(m_fromBridge.get(), m_pickupLoc);
-			m_outsamp[i] += toBridgeAccess(m_toBridge.get(), m_pickupLoc);
+			m_outsamp[i] = fromBridgeAccess(m_pickupLoc);
+			m_outsamp[i] += toBridgeAccess(m_pickupLoc);
 
 			// Sample traveling into "bridge"
-			sample_t ym0 = toBridgeAccess(m_toBridge.get(), 1);
+			sample_t ym0 = toBridgeAccess(1);
 			// Sample to "nut"
-			sample_t ypM = fromBridgeAccess(m_fromBridge.get(), m_fromBridge->length - 2);
+			sample_t ypM = fromBridgeAccess(m_length - 2);
 
 			// String state update
-
-			// Decrement pointer and then update
-			fromBridgeUpdate(m_fromBridge.get(), -bridgeReflection(ym0));
-			// Update and then increment pointer
-			toBridgeUpdate(m_toBridge.get(), -ypM);
+			m_fromBridge.write({-bridgeReflection(ym0) * m_stringLoss});
+			m_toBridge.write({-ypM * m_stringLoss});
 		}
 
 		return m_outsamp[m_choice];
 	}
 
 private:
-	struct DelayLine
-	{
-		std::unique_ptr<sample_t[]> data;
-		int length;
-		sample_t* pointer;
-		sample_t* end;
-	};
-
-	std::unique_ptr<DelayLine> m_fromBridge;
-	std::unique_ptr<DelayLine> m_toBridge;
-	int m_pickupLoc;
-	int m_oversample;
-	float m_randomize;
-	float m_stringLoss;
-
-	std::unique_ptr<float[]> m_impulse;
-	int m_choice;
-	float m_state;
-
-	std::unique_ptr<sample_t[]> m_outsamp;
-
-	std::unique_ptr<DelayLine> initDelayLine(int len);
-	void resample(const float* src, f_cnt_t srcFrames, f_cnt_t dstFrames);
-
-	/**
-	 * setDelayLine initializes the string with an impulse at the pick
-	 * position unless the impulse is longer than the string, in which
-	 * case the impulse gets truncated.
-	 */
-	void setDelayLine(DelayLine* dl, int pick, const float* values, int len, float scale, bool state)
-	{
-		if (!state)
-		{
-			for (int i = 0; i < pick; ++i)
-			{
-				float r = static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX);
-				float offset = (m_randomize / 2.0f - m_randomize) * r;
-				dl->data[i] = scale * values[dl->length - i - 1] + offset;
-			}
-			for (int i = pick; i < dl->length; ++i)
-			{
-				float r = static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX);
-				float offset = (m_randomize / 2.0f - m_randomize) * r;
-				dl->data[i] = scale * values[i - pick]  + offset;
-			}
-		}
-		else
-		{
-			if (len + pick > dl->length)
-			{
-				for (int i = pick; i < dl->length; ++i)
-				{
-					float r = static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX);
-					float offset = (m_randomize / 2.0f - m_randomize) * r;
-					dl->data[i] = scale * values[i - pick] + offset;
-				}
-			}
-			else
-			{
-				for (int i = 0; i < len; ++i)
-				{
-					float r = static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX);
-					float offset = (m_randomize / 2.0f - m_randomize) * r;
-					dl->data[i+pick] = scale * values[i] + offset;
-				}
-			}
-		}
-	}
-
-	/**
-	 * toBridgeUpdate(dl, insamp);
-	 * Places "nut-reflected" sample from upper delay-line into
-	 * current lower delay-line pointer position (which represents
-	 * x = 0 position). The pointer is then incremented (i.e. the
-	 * wave travels one sample to the left), turning the previous
-	 * position into an "effective" x = L position for the next
-	 * iteration.
-	 */
-	void toBridgeUpdate(DelayLine* dl, sample_t insamp)
-	{
-		sample_t* ptr = dl->pointer;
-		*ptr = insamp * m_stringLoss;
-		++ptr;
-		if (ptr > dl->end)
-		{
-			ptr = dl->data.get();
-		}
-		dl->pointer = ptr;
-	}
-
-	/**
-	 * fromBridgeUpdate(dl, insamp);
-	 * Decrements current upper delay-line pointer position (i.e.
-	 * the wave travels one sample to the right), moving it to the
-	 * "effective" x = 0 position for the next iteration. The
-	 * "bridge-reflected" sample from lower delay-line is then placed
-	 * into this position.
-	 */
-	void fromBridgeUpdate(DelayLine* dl, sample_t insamp)
-	{
-		sample_t* ptr = dl->pointer;
-		--ptr;
-		if (ptr < dl->data.get())
-		{
-			ptr = dl->end;
-		}
-		*ptr = insamp * m_stringLoss;
-		dl->pointer = ptr;
-	}
-
-	/**
-	 * dlAccess(dl, position);
-	 * Returns sample "position" samples into delay-line's past.
-	 * Position "0" points to the most recently inserted sample.
-	 */
-	static sample_t dlAccess(DelayLine* dl, int position)
-	{
-		sample_t* outpos = dl->pointer + position;
-		while (outpos < dl->data.get())
-		{
-			outpos += dl->length;
-		}
-		while (outpos > dl->end)
-		{
-			outpos -= dl->length;
-		}
-		return *outpos;
-	}
-
 	/*
 	 * Right-going delay line:
 	 * -->---->---->---
 	 * x=0
-	 * (pointer)
 	 * Left-going delay line:
 	 * --<----<----<---
 	 * x=0
-	 * (pointer)
+	 *
+	 * Both are m_length samples long. Each sample step, the sample
+	 * reflected at the bridge is written at x = 0 of the right-going
+	 * line, and the one reflected at the nut at x = L of the left-going
+	 * one, so that every sample written travels one position further.
+	 */
+	DelayLine<1> m_fromBridge;
+	DelayLine<1> m_toBridge;
+	int m_length = 0;
+	int m_pickupLoc = 0;
+	int m_oversample = 0;
+	float m_randomize = 0.f;
+	float m_stringLoss = 0.f;
+
+	int m_choice = 0;
+	float m_state = 0.f;
+
+	//! The initial shape of a delay line, from x = 0 to x = L
+	std::vector<sample_t> m_shape;
+	std::vector<float> m_impulse;
+	std::vector<sample_t> m_outsamp;
+
+	void resample(const float* src, f_cnt_t srcFrames, f_cnt_t dstFrames);
+
+	/**
+	 * setShape initializes the string with an impulse at the pick
+	 * position unless the impulse is longer than the string, in which
+	 * case the impulse gets truncated.
 	 */
+	void setShape(int pick, const float* values, int len, float scale, bool state);
 
 	/**
-	 * fromBridgeAccess(dl, position);
-	 * Returns spatial sample at position "position", where position zero
-	 * is equal to the current upper delay-line pointer position (x = 0).
-	 * In a right-going delay-line, position increases to the right, and
-	 * delay increases to the right => left = past and right = future.
+	 * fromBridgeAccess(position);
+	 * Returns spatial sample at position "position" of the right-going
+	 * delay line. Delay increases to the right => left = past and
+	 * right = future, and position zero is the sample written last.
 	 */
-	static sample_t fromBridgeAccess(DelayLine* dl, int position)
+	sample_t fromBridgeAccess(int position) const
 	{
-		return dlAccess(dl, position);
+		return m_fromBridge.read(static_cast<std::size_t>(position + 1))[0];
 	}
 
 	/**
-	 * toBridgeAccess(dl, position);
-	 * Returns spatial sample at position "position", where position zero
-	 * is equal to the current lower delay-line pointer position (x = 0).
-	 * In a left-going delay-line, position increases to the right, and
-	 * delay DEcreases to the right => left = future and right = past.
+	 * toBridgeAccess(position);
+	 * Returns spatial sample at position "position" of the left-going
+	 * delay line. Delay DEcreases to the right => left = future and
+	 * right = past, and position zero is the sample written L samples ago.
 	 */
-	static sample_t toBridgeAccess(DelayLine* dl, int position)
+	sample_t toBridgeAccess(int position) const
 	{
-		return dlAccess(dl, position);
+		return m_toBridge.read(static_cast<std::size_t>(m_length - position))[0];
 	}
 
 	sample_t bridgeReflection(sample_t insamp)
@@ -83,6 +83,7 @@
 #undef Unsorted
 #endif
 
+#include <atomic>
 #include <mutex>
 
 #include <algorithm>
@@ -114,6 +115,7 @@ struct ERect
 #include "LmmsTypes.h"
 #include "Midi.h"
 #include "communication.h"
+#include "denormals.h"
 #include "IoHelper.h"
 
 #include "VstSyncData.h"
@@ -126,19 +128,28 @@ static bool EMBED = false;
 static bool EMBED_X11 = false;
 static bool EMBED_WIN32 = false;
 static bool HEADLESS = false;
+// whether this process hosts several plugins, see RemotePluginHost
+static bool SHARED = false;
 
 namespace lmms
 {
 class RemoteVstPlugin;
 }
 
+// the plugin being loaded, which is the only one unless SHARED
 lmms::RemoteVstPlugin * __plugin = nullptr;
 
+// all plugins hosted by this process, only changed on the GUI thread
+std::vector<lmms::RemoteVstPlugin *> __plugins;
+std::mutex __pluginsMutex;
+
 #ifndef NATIVE_LINUX_VST
 HWND __MessageHwnd = nullptr;
-DWORD __processingThreadId = 0;
 #else
-pthread_t __processingThreadId = 0;
+// plugins to add and whether to quit, posted by the control channel thread
+std::vector<lmms::RemotePluginClient::message> __pendingPlugins;
+std::mutex __pendingPluginsMutex;
+std::atomic<bool> __hostQuit = false;
 #endif
 
 namespace lmms
@@ -368,13 +379,32 @@ public:
 #else
 	static void * processingThread( void * _param );
 #endif
-	
+	static bool startProcessingThread( RemoteVstPlugin * _plugin );
+#ifdef NATIVE_LINUX_VST
+	void joinProcessingThread()
+	{
+		pthread_join( m_processingThreadId, nullptr );
+	}
+#endif
+
+	// add a plugin talking through the channel given by an
+	// IdHostAddInstance message, called on the GUI thread
+	static void addPlugin( const message & _m );
+	// delete a plugin whose processing thread has quit, called on the
+	// GUI thread
+	static void closePlugin( RemoteVstPlugin * _plugin );
+
 	static bool setupMessageWindow();
 	
 #ifndef NATIVE_LINUX_VST
 	static DWORD WINAPI guiEventLoop();
 #else
-	void guiEventLoop();
+	static void guiEventLoop();
+#endif
+
+#ifndef NATIVE_LINUX_VST
+	static void postAddPlugin( const message & _m );
+	static void postCloseHost();
 #endif
 	
 #ifndef NATIVE_LINUX_VST
@@ -388,9 +418,20 @@ private:
 		None,
 		ProcessPluginMessage,
 		GiveIdle,
-		ClosePlugin
+		ClosePlugin,
+		AddPlugin,
+		CloseHost
 	} ;
 
+	struct GuiThreadPluginMessage
+	{
+		RemoteVstPlugin * plugin;
+		message m;
+	} ;
+
+	// find the plugin an effect calling back belongs to
+	static RemoteVstPlugin * fromEffect( AEffect * _effect );
+
 	struct SuspendPlugin {
 		SuspendPlugin( RemoteVstPlugin * plugin ) :
 			m_plugin( plugin ),
@@ -454,7 +495,10 @@ private:
 
 	bool m_processing;
 
-#ifdef NATIVE_LINUX_VST
+#ifndef NATIVE_LINUX_VST
+	DWORD m_processingThreadId = 0;
+#else
+	pthread_t m_processingThreadId = 0;
 	pthread_mutex_t message_mutex = PTHREAD_MUTEX_INITIALIZER;
 	bool m_shouldQuit = false;
 #endif
@@ -484,6 +528,7 @@ private:
 	};
 
 	Sync m_sync;
+	VstTimeInfo m_timeInfo;
 };
 
 
@@ -515,6 +560,10 @@ RemoteVstPlugin::RemoteVstPlugin( const char * socketPath ) :
 	m_currentProgram(-1)
 {
 	__plugin = this;
+	{
+		const auto lock = std::lock_guard{__pluginsMutex};
+		__plugins.push_back( this );
+	}
 
 	// process until we have loaded the plugin
 	while( 1 )
@@ -549,6 +598,13 @@ RemoteVstPlugin::~RemoteVstPlugin()
 
 	delete[] m_inputs;
 	delete[] m_outputs;
+
+	const auto lock = std::lock_guard{__pluginsMutex};
+	__plugins.erase( std::find( __plugins.begin(), __plugins.end(), this ) );
+	if( __plugin == this )
+	{
+		__plugin = nullptr;
+	}
 }
 
 
@@ -1687,9 +1743,9 @@ int RemoteVstPlugin::updateInOutCount()
 	}
 	
 #ifndef NATIVE_LINUX_VST
-	if( GetCurrentThreadId() == __processingThreadId )
+	if( GetCurrentThreadId() == m_processingThreadId )
 #else
-	if( pthread_equal(pthread_self(), __processingThreadId) )
+	if( pthread_equal(pthread_self(), m_processingThreadId) )
 #endif
 	{
 		debugMessage( "Plugin requested I/O change from processing "
@@ -1732,12 +1788,30 @@ int RemoteVstPlugin::updateInOutCount()
 
 //#define DEBUG_CALLBACKS
 #ifdef DEBUG_CALLBACKS
-#define SHOW_CALLBACK __plugin->debugMessage
+#define SHOW_CALLBACK plugin->debugMessage
 #else
 #define SHOW_CALLBACK(...)
 #endif
 
 
+RemoteVstPlugin * RemoteVstPlugin::fromEffect( AEffect * _effect )
+{
+	if( !SHARED )
+	{
+		return __plugin;
+	}
+
+	const auto lock = std::lock_guard{__pluginsMutex};
+	const auto it = std::find_if( __plugins.begin(), __plugins.end(),
+		[_effect]( RemoteVstPlugin * p ) { return p->m_plugin == _effect; } );
+	// effects calling back before they are known, e.g. from their entry
+	// point, belong to the plugin being loaded
+	return it != __plugins.end() ? *it : __plugin;
+}
+
+
+
+
 /* TODO:
  * - complete audioMasterGetTime-handling (bars etc.)
  * - implement audioMasterProcessEvents
@@ -1749,7 +1823,11 @@ intptr_t RemoteVstPlugin::hostCallback( AEffect * _effect, int32_t _opcode,
 					int32_t _index, intptr_t _value,
 						void * _ptr, float _opt )
 {
-	static VstTimeInfo _timeInfo;
+	RemoteVstPlugin * plugin = fromEffect( _effect );
+	if( plugin == nullptr )
+	{
+		return 0;
+	}
 #ifdef DEBUG_CALLBACKS
 	char buf[64];
 	sprintf( buf, "host-callback, opcode = %d\n", (int) _opcode );
@@ -1757,10 +1835,11 @@ intptr_t RemoteVstPlugin::hostCallback( AEffect * _effect, int32_t _opcode,
 #endif
 
 	// workaround for early callbacks by some plugins
-	if( __plugin && __plugin->m_plugin == nullptr )
+	if( plugin->m_plugin == nullptr )
 	{
-		__plugin->m_plugin = _effect;
+		plugin->m_plugin = _effect;
 	}
+	VstTimeInfo & _timeInfo = plugin->m_timeInfo;
 
 	switch( _opcode )
 	{
@@ -1784,9 +1863,10 @@ intptr_t RemoteVstPlugin::hostCallback( AEffect * _effect, int32_t _opcode,
 			// call application idle routine (this will
 			// call effEditIdle for all open editors too)
 #ifndef NATIVE_LINUX_VST
-			PostMessage( __MessageHwnd, WM_USER, static_cast<WPARAM>(GuiThreadMessage::GiveIdle), 0 );
+			PostMessage( __MessageHwnd, WM_USER, static_cast<WPARAM>(GuiThreadMessage::GiveIdle),
+						reinterpret_cast<LPARAM>(plugin) );
 #else
-			__plugin->sendX11Idle();
+			plugin->sendX11Idle();
 #endif
 			return 0;
 
@@ -1807,11 +1887,11 @@ intptr_t RemoteVstPlugin::hostCallback( AEffect * _effect, int32_t _opcode,
 			// fields are required (see valid masks above), as some
 			// items may require extensive conversions
 
-			const auto syncData = __plugin->getVstSyncData();
+			const auto syncData = plugin->getVstSyncData();
 			assert(syncData != nullptr);
 
 			memset( &_timeInfo, 0, sizeof( _timeInfo ) );
-			_timeInfo.samplePos = __plugin->m_currentSamplePos;
+			_timeInfo.samplePos = plugin->m_currentSamplePos;
 			_timeInfo.sampleRate = syncData->sampleRate;
 			_timeInfo.flags = 0;
 			_timeInfo.tempo = syncData->bpm;
@@ -1828,19 +1908,19 @@ intptr_t RemoteVstPlugin::hostCallback( AEffect * _effect, int32_t _opcode,
 				_timeInfo.flags |= kVstTransportCycleActive;
 			}
 
-			if (syncData->ppqPos != __plugin->m_sync.timestamp)
+			if (syncData->ppqPos != plugin->m_sync.timestamp)
 			{
 				_timeInfo.ppqPos = syncData->ppqPos;
-				__plugin->m_sync.lastppqPos = syncData->ppqPos;
-				__plugin->m_sync.timestamp = syncData->ppqPos;
+				plugin->m_sync.lastppqPos = syncData->ppqPos;
+				plugin->m_sync.timestamp = syncData->ppqPos;
 			}
 			else if (syncData->isPlaying)
 			{
-				__plugin->m_sync.lastppqPos +=
+				plugin->m_sync.lastppqPos +=
 					syncData->bpm / 60.0
 					* syncData->bufferSize
 					/ syncData->sampleRate;
-				_timeInfo.ppqPos = __plugin->m_sync.lastppqPos;
+				_timeInfo.ppqPos = plugin->m_sync.lastppqPos;
 			}
 //			_timeInfo.ppqPos = syncData->ppqPos;
 			_timeInfo.flags |= kVstPpqPosValid;
@@ -1856,12 +1936,12 @@ intptr_t RemoteVstPlugin::hostCallback( AEffect * _effect, int32_t _opcode,
 			_timeInfo.flags |= kVstBarsValid;
 
 			if ((_timeInfo.flags & (kVstTransportPlaying | kVstTransportCycleActive))
-				!= (__plugin->m_sync.lastFlags & (kVstTransportPlaying | kVstTransportCycleActive))
+				!= (plugin->m_sync.lastFlags & (kVstTransportPlaying | kVstTransportCycleActive))
 				|| syncData->playbackJumped)
 			{
 				_timeInfo.flags |= kVstTransportChanged;
 			}
-			__plugin->m_sync.lastFlags = _timeInfo.flags;
+			plugin->m_sync.lastFlags = _timeInfo.flags;
 
 			return (intptr_t) &_timeInfo;
 		}
@@ -1874,7 +1954,7 @@ intptr_t RemoteVstPlugin::hostCallback( AEffect * _effect, int32_t _opcode,
 		case audioMasterIOChanged:
 			SHOW_CALLBACK( "amc: audioMasterIOChanged\n" );
 			// numInputs, numOutputs, and/or latency has changed
-			return __plugin->updateInOutCount();
+			return plugin->updateInOutCount();
 
 #ifdef OLD_VST_SDK
 		case audioMasterWantMidi:
@@ -1890,7 +1970,7 @@ intptr_t RemoteVstPlugin::hostCallback( AEffect * _effect, int32_t _opcode,
 
 		case audioMasterTempoAt:
 			SHOW_CALLBACK( "amc: audioMasterTempoAt\n" );
-			return __plugin->m_bpm * 10000;
+			return plugin->m_bpm * 10000;
 
 		case audioMasterGetNumAutomatableParameters:
 			SHOW_CALLBACK( "amc: audioMasterGetNumAutomatable"
@@ -1963,14 +2043,14 @@ intptr_t RemoteVstPlugin::hostCallback( AEffect * _effect, int32_t _opcode,
 		case audioMasterSizeWindow:
 		{
 			SHOW_CALLBACK( "amc: audioMasterSizeWindow\n" );
-			if( __plugin->m_window == 0 )
+			if( plugin->m_window == 0 )
 			{
 				return 0;
 			}
-			__plugin->m_windowWidth = _index;
-			__plugin->m_windowHeight = _value;
+			plugin->m_windowWidth = _index;
+			plugin->m_windowHeight = _value;
 #ifndef NATIVE_LINUX_VST
-			HWND window = __plugin->m_window;
+			HWND window = plugin->m_window;
 			DWORD dwStyle = GetWindowLongPtr( window, GWL_STYLE );
 			RECT windowSize = { 0, 0, (int) _index, (int) _value };
 			AdjustWindowRect( &windowSize, dwStyle, false );
@@ -1980,32 +2060,32 @@ intptr_t RemoteVstPlugin::hostCallback( AEffect * _effect, int32_t _opcode,
 					SWP_NOACTIVATE | SWP_NOMOVE |
 					SWP_NOOWNERZORDER | SWP_NOZORDER );
 #else
-			XResizeWindow(__plugin->m_display, __plugin->m_window, (int) _index, (int) _value);
-			XFlush(__plugin->m_display);
+			XResizeWindow(plugin->m_display, plugin->m_window, (int) _index, (int) _value);
+			XFlush(plugin->m_display);
 #endif
-			__plugin->sendMessage(
+			plugin->sendMessage(
 				message( IdVstPluginEditorGeometry ).
-					addInt( __plugin->m_windowWidth ).
-					addInt( __plugin->m_windowHeight ) );
+					addInt( plugin->m_windowWidth ).
+					addInt( plugin->m_windowHeight ) );
 			return 1;
 		}
 
 		case audioMasterGetSampleRate:
 			SHOW_CALLBACK( "amc: audioMasterGetSampleRate\n" );
-			return __plugin->sampleRate();
+			return plugin->sampleRate();
 
 		case audioMasterGetBlockSize:
 			SHOW_CALLBACK( "amc: audioMasterGetBlockSize\n" );
 
-			return __plugin->bufferSize();
+			return plugin->bufferSize();
 
 		case audioMasterGetInputLatency:
 			SHOW_CALLBACK( "amc: audioMasterGetInputLatency\n" );
-			return __plugin->bufferSize();
+			return plugin->bufferSize();
 
 		case audioMasterGetOutputLatency:
 			SHOW_CALLBACK( "amc: audioMasterGetOutputLatency\n" );
-			return __plugin->bufferSize();
+			return plugin->bufferSize();
 
 		case audioMasterGetCurrentProcessLevel:
 			SHOW_CALLBACK( "amc: audioMasterGetCurrentProcess"
@@ -2098,9 +2178,10 @@ intptr_t RemoteVstPlugin::hostCallback( AEffect * _effect, int32_t _opcode,
 			SHOW_CALLBACK( "amc: audioMasterUpdateDisplay\n" );
 			// something has changed, update 'multi-fx' display
 #ifndef NATIVE_LINUX_VST
-			PostMessage( __MessageHwnd, WM_USER, static_cast<WPARAM>(GuiThreadMessage::GiveIdle), 0 );
+			PostMessage( __MessageHwnd, WM_USER, static_cast<WPARAM>(GuiThreadMessage::GiveIdle),
+						reinterpret_cast<LPARAM>(plugin) );
 #else
-			__plugin->sendX11Idle();
+			plugin->sendX11Idle();
 #endif
 			return 0;
 
@@ -2226,14 +2307,16 @@ DWORD WINAPI RemoteVstPlugin::processingThread( LPVOID _param )
 void * RemoteVstPlugin::processingThread(void * _param)
 #endif
 {
+	RemoteVstPlugin * _this = static_cast<RemoteVstPlugin *>( _param );
+
+	disable_denormals();
+
 #ifndef NATIVE_LINUX_VST
-	__processingThreadId = GetCurrentThreadId();
+	_this->m_processingThreadId = GetCurrentThreadId();
 #else
-	__processingThreadId = pthread_self();
+	_this->m_processingThreadId = pthread_self();
 #endif
 
-	RemoteVstPlugin * _this = static_cast<RemoteVstPlugin *>( _param );
-
 	RemotePluginClient::message m;
 	while( ( m = _this->receiveMessage() ).id != IdQuit )
 	{
@@ -2241,7 +2324,8 @@ void * RemoteVstPlugin::processingThread(void * _param)
 		if( m.id == IdStartProcessing
 			|| m.id == IdMidiEvent
 			|| m.id == IdVstSetParameter
-			|| m.id == IdVstSetTempo)
+			|| m.id == IdVstSetTempo
+			|| m.id == IdChangeProcessSyncKey)
 		{
 			_this->processMessage( m );
 		}
@@ -2256,7 +2340,7 @@ void * RemoteVstPlugin::processingThread(void * _param)
 			PostMessage( __MessageHwnd,
 					WM_USER,
 					static_cast<WPARAM>(GuiThreadMessage::ProcessPluginMessage),
-					reinterpret_cast<LPARAM>(new message(m)));
+					reinterpret_cast<LPARAM>(new GuiThreadPluginMessage{_this, m}));
 #else
 		_this->queueMessage( m );
 #endif
@@ -2265,7 +2349,8 @@ void * RemoteVstPlugin::processingThread(void * _param)
 
 	// notify GUI thread about shutdown
 #ifndef NATIVE_LINUX_VST
-	PostMessage( __MessageHwnd, WM_USER, static_cast<WPARAM>(GuiThreadMessage::ClosePlugin), 0 );
+	PostMessage( __MessageHwnd, WM_USER, static_cast<WPARAM>(GuiThreadMessage::ClosePlugin),
+					reinterpret_cast<LPARAM>(_this) );
 
 	return 0;
 #else
@@ -2279,14 +2364,71 @@ void * RemoteVstPlugin::processingThread(void * _param)
 }
 
 
+
+
+bool RemoteVstPlugin::startProcessingThread( RemoteVstPlugin * _plugin )
+{
+#ifndef NATIVE_LINUX_VST
+	if( CreateThread( nullptr, 0, RemoteVstPlugin::processingThread,
+					_plugin, 0, nullptr ) == nullptr )
+#else
+	if( pthread_create( &_plugin->m_processingThreadId, nullptr,
+			&RemoteVstPlugin::processingThread, _plugin ) != 0 )
+#endif
+	{
+		_plugin->debugMessage( "could not create processingThread\n" );
+		return false;
+	}
+	return true;
+}
+
+
+
+
+void RemoteVstPlugin::addPlugin( const message & _m )
+{
+	// constructor automatically will process messages until it receives
+	// a IdVstLoadPlugin message and processes it
+#ifdef SYNC_WITH_SHM_FIFO
+	auto plugin = new RemoteVstPlugin( _m.getString( 0 ), _m.getString( 1 ) );
+#else
+	auto plugin = new RemoteVstPlugin( _m.getString( 0 ).c_str() );
+#endif
+
+	if( !plugin->isInitialized() || !startProcessingThread( plugin ) )
+	{
+		delete plugin;
+	}
+}
+
+
+
+
+void RemoteVstPlugin::closePlugin( RemoteVstPlugin * _plugin )
+{
+	if( !SHARED )
+	{
+		// the process is done with its only plugin, main() deletes it
+#ifndef NATIVE_LINUX_VST
+		PostQuitMessage( 0 );
+#endif
+		return;
+	}
+
+#ifdef NATIVE_LINUX_VST
+	_plugin->joinProcessingThread();
+#endif
+	delete _plugin;
+}
+
+
 bool RemoteVstPlugin::setupMessageWindow()
 {
 #ifndef NATIVE_LINUX_VST
 	HMODULE hInst = GetModuleHandle( nullptr );
 	if( hInst == nullptr )
 	{
-		__plugin->debugMessage( "setupMessageWindow(): can't get "
-							"module handle\n" );
+		std::cerr << "setupMessageWindow(): can't get module handle" << std::endl;
 		return false;
 	}
 
@@ -2314,6 +2456,23 @@ DWORD WINAPI RemoteVstPlugin::guiEventLoop()
 
 	return 0;
 }
+
+
+
+
+void RemoteVstPlugin::postAddPlugin( const message & _m )
+{
+	PostMessage( __MessageHwnd, WM_USER, static_cast<WPARAM>(GuiThreadMessage::AddPlugin),
+					reinterpret_cast<LPARAM>(new message(_m)) );
+}
+
+
+
+
+void RemoteVstPlugin::postCloseHost()
+{
+	PostMessage( __MessageHwnd, WM_USER, static_cast<WPARAM>(GuiThreadMessage::CloseHost), 0 );
+}
 #else
 void RemoteVstPlugin::guiEventLoop()
 {
@@ -2324,33 +2483,61 @@ void RemoteVstPlugin::guiEventLoop()
 	XEvent e;
 	while(true)
 	{
-		//if (XQLength(m_display) > 0)
-		if (m_display && XPending(m_display) > 0)
+		if (SHARED)
 		{
-			XNextEvent(m_display, &e);
-		
-			if (e.type == ClientMessage && static_cast<Atom>(e.xclient.data.l[0]) == m_wmDeleteMessage)
+			std::vector<message> pending;
 			{
-				hideEditor();
+				const auto lock = std::lock_guard{__pendingPluginsMutex};
+				pending.swap(__pendingPlugins);
+			}
+			for (const auto& m : pending)
+			{
+				addPlugin(m);
 			}
 		}
 
-		// needed by ZynAddSubFX UI
-		if (__plugin->isInitialized())
+		// plugins are only added and removed on this thread, but may be
+		// closed while iterating
+		const auto plugins = __plugins;
+		for (const auto plugin : plugins)
 		{
-			__plugin->idle();
-		}
-		
-		if(__plugin->isInitialized() && !__plugin->isProcessing() )
-		{
-			__plugin->processUIThreadMessages();
+			//if (XQLength(m_display) > 0)
+			if (plugin->m_display && XPending(plugin->m_display) > 0)
+			{
+				XNextEvent(plugin->m_display, &e);
+
+				if (e.type == ClientMessage && static_cast<Atom>(e.xclient.data.l[0]) == plugin->m_wmDeleteMessage)
+				{
+					plugin->hideEditor();
+				}
+			}
+
+			// needed by ZynAddSubFX UI
+			if (plugin->isInitialized())
+			{
+				plugin->idle();
+			}
+
+			if(plugin->isInitialized() && !plugin->isProcessing() )
+			{
+				plugin->processUIThreadMessages();
+			}
+
+			if (plugin->m_shouldQuit)
+			{
+				plugin->hideEditor();
+				if (!SHARED)
+				{
+					return;
+				}
+				closePlugin(plugin);
+			}
 		}
-		
+
 		nanosleep(&tim, &tim2);
-		
-		if (m_shouldQuit) 
+
+		if (SHARED && __hostQuit)
 		{
-			__plugin->hideEditor();
 			break;
 		}
 	}
@@ -2362,10 +2549,17 @@ void RemoteVstPlugin::guiEventLoop()
 LRESULT CALLBACK RemoteVstPlugin::wndProc( HWND hwnd, UINT uMsg,
 						WPARAM wParam, LPARAM lParam )
 {
-	if( uMsg == WM_TIMER && __plugin->isInitialized() )
+	if( uMsg == WM_TIMER )
 	{
-		// give plugin some idle-time for GUI-update
-		__plugin->idle();
+		// give plugins some idle-time for GUI-update
+		const auto plugins = __plugins;
+		for( const auto plugin : plugins )
+		{
+			if( plugin->isInitialized() )
+			{
+				plugin->idle();
+			}
+		}
 		return 0;
 	}
 	else if( uMsg == WM_USER )
@@ -2374,21 +2568,33 @@ LRESULT CALLBACK RemoteVstPlugin::wndProc( HWND hwnd, UINT uMsg,
 		{
 			case GuiThreadMessage::ProcessPluginMessage:
 			{
-				message * m = (message *) lParam;
-				__plugin->queueMessage( *m );
-				delete m;
-				if( !__plugin->isProcessing() )
+				auto pm = reinterpret_cast<GuiThreadPluginMessage *>( lParam );
+				pm->plugin->queueMessage( pm->m );
+				if( !pm->plugin->isProcessing() )
 				{
-					__plugin->processUIThreadMessages();
+					pm->plugin->processUIThreadMessages();
 				}
+				delete pm;
 				return 0;
 			}
 
 			case GuiThreadMessage::GiveIdle:
-				__plugin->idle();
+				reinterpret_cast<RemoteVstPlugin *>( lParam )->idle();
 				return 0;
 
 			case GuiThreadMessage::ClosePlugin:
+				closePlugin( reinterpret_cast<RemoteVstPlugin *>( lParam ) );
+				return 0;
+
+			case GuiThreadMessage::AddPlugin:
+			{
+				auto m = reinterpret_cast<message *>( lParam );
+				addPlugin( *m );
+				delete m;
+				return 0;
+			}
+
+			case GuiThreadMessage::CloseHost:
 				PostQuitMessage(0);
 				return 0;
 
@@ -2398,7 +2604,13 @@ LRESULT CALLBACK RemoteVstPlugin::wndProc( HWND hwnd, UINT uMsg,
 	}
 	else if( uMsg == WM_SYSCOMMAND && (wParam & 0xfff0) == SC_CLOSE )
 	{
-		__plugin->hideEditor();
+		for( const auto plugin : __plugins )
+		{
+			if( plugin->m_window == hwnd )
+			{
+				plugin->hideEditor();
+			}
+		}
 		return 0;
 	}
 
@@ -2408,11 +2620,67 @@ LRESULT CALLBACK RemoteVstPlugin::wndProc( HWND hwnd, UINT uMsg,
 
 #endif // NATIVE_LINUX_VST
 
+
+
+
+/**
+ * Control channel of a process hosting several plugins. It receives the
+ * channels of plugins to add, and tells the GUI thread to quit when the
+ * host closes it.
+ */
+class RemoteVstHost : public RemotePluginClient
+{
+public:
+	using RemotePluginClient::RemotePluginClient;
+
+	bool processMessage( const message & _m ) override
+	{
+		if( _m.id != IdHostAddInstance )
+		{
+			return RemotePluginClient::processMessage( _m );
+		}
+
+		// plugins have to be loaded and run their editors on the GUI thread
+#ifndef NATIVE_LINUX_VST
+		RemoteVstPlugin::postAddPlugin( _m );
+#else
+		const auto lock = std::lock_guard{__pendingPluginsMutex};
+		__pendingPlugins.push_back( _m );
+#endif
+		return true;
+	}
+
+	void process( const SampleFrame*, SampleFrame* ) override
+	{
+	}
+
+#ifndef NATIVE_LINUX_VST
+	static DWORD WINAPI controlThread( LPVOID _param )
+#else
+	static void * controlThread( void * _param )
+#endif
+	{
+		auto _this = static_cast<RemoteVstHost *>( _param );
+		while( _this->processMessage( _this->receiveMessage() ) )
+		{
+		}
+
+#ifndef NATIVE_LINUX_VST
+		RemoteVstPlugin::postCloseHost();
+		return 0;
+#else
+		__hostQuit = true;
+		return nullptr;
+#endif
+	}
+} ;
+
 } // namespace lmms
 
 
 int main( int _argc, char * * _argv )
 {
+	using lmms::RemoteVstHost;
 	using lmms::RemoteVstPlugin;
 
 #ifdef SYNC_WITH_SHM_FIFO
@@ -2514,6 +2782,8 @@ int main( int _argc, char * * _argv )
 			std::cerr << "Unknown embed method " << embedMethod << ". Starting detached instead." << std::endl;
 			EMBED = EMBED_X11 = EMBED_WIN32 = HEADLESS = false;
 		}
+
+		SHARED = _argc > embedMethodIndex + 1 && std::string{_argv[embedMethodIndex + 1]} == "shared";
 	}
 
 #ifdef NATIVE_LINUX_VST
@@ -2523,6 +2793,43 @@ int main( int _argc, char * * _argv )
 	}
 #endif
 	
+	if( SHARED )
+	{
+		// the channel given on the command line only adds plugins, which
+		// then connect through channels of their own
+#ifdef SYNC_WITH_SHM_FIFO
+		RemoteVstHost host( _argv[1], _argv[2] );
+#else
+		RemoteVstHost host( _argv[1] );
+#endif
+		if( RemoteVstPlugin::setupMessageWindow() == false )
+		{
+			return -1;
+		}
+#ifndef NATIVE_LINUX_VST
+		if( CreateThread( nullptr, 0, RemoteVstHost::controlThread,
+						&host, 0, nullptr ) == nullptr )
+#else
+		pthread_t hostThread;
+		if( pthread_create( &hostThread, nullptr,
+				&RemoteVstHost::controlThread, &host ) != 0 )
+#endif
+		{
+			return -1;
+		}
+
+		RemoteVstPlugin::guiEventLoop();
+#ifdef NATIVE_LINUX_VST
+		pthread_join( hostThread, nullptr );
+#endif
+
+		// plugins left over are still being processed, so don't delete them
+#ifndef NATIVE_LINUX_VST
+		OleUninitialize();
+#endif
+		return 0;
+	}
+
 	// constructor automatically will process messages until it receives
 	// a IdVstLoadPlugin message and processes it
 #ifdef SYNC_WITH_SHM_FIFO
@@ -2530,34 +2837,27 @@ int main( int _argc, char * * _argv )
 #else
 	__plugin = new RemoteVstPlugin( _argv[1] );
 #endif
+	// deleting the plugin resets __plugin
+	const auto plugin = __plugin;
 
-	if( __plugin->isInitialized() )
+	if( plugin->isInitialized() )
 	{
 		if( RemoteVstPlugin::setupMessageWindow() == false )
 		{
 			return -1;
 		}
-#ifndef NATIVE_LINUX_VST
-		if( CreateThread( nullptr, 0, RemoteVstPlugin::processingThread,
-						__plugin, 0, nullptr ) == nullptr )
-#else
-		int err = 0;
-		err = pthread_create(&__processingThreadId, nullptr, &RemoteVstPlugin::processingThread, __plugin);
-		if (err != 0)
-#endif
+		if( RemoteVstPlugin::startProcessingThread( plugin ) == false )
 		{
-			__plugin->debugMessage( "could not create "
-							"processingThread\n" );
 			return -1;
 		}
 
-		__plugin->guiEventLoop();
+		RemoteVstPlugin::guiEventLoop();
 #ifdef NATIVE_LINUX_VST
-		pthread_join(__processingThreadId, nullptr);
+		plugin->joinProcessingThread();
 #endif
 	}
 
-	delete __plugin;
+	delete plugin;
 #ifndef NATIVE_LINUX_VST
 	OleUninitialize();
 #endif
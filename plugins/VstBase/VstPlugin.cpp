@@ -131,6 +131,7 @@ VstPlugin::VstPlugin( const QString & _plugin ) :
 	m_currentProgram()
 {
 	setSplittedChannels( true );
+	setSharedProcess( ConfigManager::inst()->value( "ui", "vstsharedprocess" ).toInt() );
 
 	auto pluginType = ExecutableType::Unknown;
 #ifdef LMMS_BUILD_LINUX
@@ -82,7 +82,7 @@ VstEffect::VstEffect( Model * _parent,
 Effect::ProcessStatus VstEffect::processImpl(SampleFrame* buf, const fpp_t frames)
 {
 	assert(m_plugin != nullptr);
-	static thread_local auto tempBuf = std::array<SampleFrame, MAXIMUM_BUFFER_SIZE>();
+	static thread_local auto tempBuf = std::array<SampleFrame, MAXIMUM_RENDER_BUFFER_SIZE>();
 
 	std::memcpy(tempBuf.data(), buf, sizeof(SampleFrame) * frames);
 	if (m_pluginMutex.tryLock(Engine::getSong()->isExporting() ? -1 : 0))
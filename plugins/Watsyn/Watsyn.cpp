@@ -62,8 +62,8 @@ Plugin::Descriptor PLUGIN_EXPORT watsyn_plugin_descriptor =
 
 
 
-WatsynObject::WatsynObject( float * _A1wave, float * _A2wave,
-					float * _B1wave, float * _B2wave,
+WatsynObject::WatsynObject( std::shared_ptr<const WaveTable> _A1wave, std::shared_ptr<const WaveTable> _A2wave,
+					std::shared_ptr<const WaveTable> _B1wave, std::shared_ptr<const WaveTable> _B2wave,
 					int _amod, int _bmod, const sample_rate_t _samplerate, NotePlayHandle * _nph, fpp_t _frames,
 					WatsynInstrument * _w ) :
 				m_amod( _amod ),
@@ -71,7 +71,11 @@ WatsynObject::WatsynObject( float * _A1wave, float * _A2wave,
 				m_samplerate( _samplerate ),
 				m_nph( _nph ),
 				m_fpp( _frames ),
-				m_parent( _w )
+				m_parent( _w ),
+				m_A1wave( std::move( _A1wave ) ),
+				m_A2wave( std::move( _A2wave ) ),
+				m_B1wave( std::move( _B1wave ) ),
+				m_B2wave( std::move( _B2wave ) )
 {
 	m_abuf = new SampleFrame[_frames];
 	m_bbuf = new SampleFrame[_frames];
@@ -85,13 +89,6 @@ WatsynObject::WatsynObject( float * _A1wave, float * _A2wave,
 	m_rphase[A2_OSC] = 0.0f;
 	m_rphase[B1_OSC] = 0.0f;
 	m_rphase[B2_OSC] = 0.0f;
-
-	// copy wavegraphs to the synth object to prevent race conditions
-
-	memcpy( &m_A1wave, _A1wave, sizeof( m_A1wave ) );
-	memcpy( &m_A2wave, _A2wave, sizeof( m_A2wave ) );
-	memcpy( &m_B1wave, _B1wave, sizeof( m_B1wave ) );
-	memcpy( &m_B2wave, _B2wave, sizeof( m_B2wave ) );
 }
 
 
@@ -110,6 +107,21 @@ void WatsynObject::renderOutput( fpp_t _frames )
 	if( m_bbuf == nullptr )
 		m_bbuf = new SampleFrame[m_fpp];
 
+	const float * A1wave = m_A1wave->data();
+	const float * A2wave = m_A2wave->data();
+	const float * B1wave = m_B1wave->data();
+	const float * B2wave = m_B2wave->data();
+
+	// the pitch and crosstalk only change between periods
+	float linc [NUM_OSCS];
+	float rinc [NUM_OSCS];
+	for( int i = 0; i < NUM_OSCS; i++ )
+	{
+		linc[i] = WAVELEN * m_nph->frequency() * m_parent->m_lfreq[i] / m_samplerate;
+		rinc[i] = WAVELEN * m_nph->frequency() * m_parent->m_rfreq[i] / m_samplerate;
+	}
+	const float xt = m_parent->m_xtalk.value();
+
 	for( fpp_t frame = 0; frame < _frames; frame++ )
 	{
 		// put phases of 1-series oscs into variables because phase modulation might happen
@@ -122,13 +134,13 @@ void WatsynObject::renderOutput( fpp_t _frames )
 
 		// A2
 		sample_t A2_L = m_parent->m_lvol[A2_OSC] * std::lerp(
-			m_A2wave[static_cast<int>(m_lphase[A2_OSC])],
-			m_A2wave[static_cast<int>(m_lphase[A2_OSC] + 1) % WAVELEN],
+			A2wave[static_cast<int>(m_lphase[A2_OSC])],
+			A2wave[static_cast<int>(m_lphase[A2_OSC] + 1) % WAVELEN],
 			fraction(m_lphase[A2_OSC])
 		);
 		sample_t A2_R = m_parent->m_rvol[A2_OSC] * std::lerp(
-			m_A2wave[static_cast<int>(m_rphase[A2_OSC])],
-			m_A2wave[static_cast<int>(m_rphase[A2_OSC] + 1) % WAVELEN],
+			A2wave[static_cast<int>(m_rphase[A2_OSC])],
+			A2wave[static_cast<int>(m_rphase[A2_OSC] + 1) % WAVELEN],
 			fraction(m_rphase[A2_OSC])
 		);
 
@@ -142,13 +154,13 @@ void WatsynObject::renderOutput( fpp_t _frames )
 		}
 		// A1
 		sample_t A1_L = m_parent->m_lvol[A1_OSC] * std::lerp(
-			m_A1wave[static_cast<int>(A1_lphase)],
-			m_A1wave[static_cast<int>(A1_lphase + 1) % WAVELEN],
+			A1wave[static_cast<int>(A1_lphase)],
+			A1wave[static_cast<int>(A1_lphase + 1) % WAVELEN],
 			fraction(A1_lphase)
 		);
 		sample_t A1_R = m_parent->m_rvol[A1_OSC] * std::lerp(
-			m_A1wave[static_cast<int>(A1_rphase)],
-			m_A1wave[static_cast<int>(A1_rphase + 1) % WAVELEN],
+			A1wave[static_cast<int>(A1_rphase)],
+			A1wave[static_cast<int>(A1_rphase + 1) % WAVELEN],
 			fraction(A1_rphase)
 		);
 
@@ -156,18 +168,17 @@ void WatsynObject::renderOutput( fpp_t _frames )
 
 		// B2
 		sample_t B2_L = m_parent->m_lvol[B2_OSC] * std::lerp(
-			m_B2wave[static_cast<int>(m_lphase[B2_OSC])],
-			m_B2wave[static_cast<int>(m_lphase[B2_OSC] + 1) % WAVELEN],
+			B2wave[static_cast<int>(m_lphase[B2_OSC])],
+			B2wave[static_cast<int>(m_lphase[B2_OSC] + 1) % WAVELEN],
 			fraction(m_lphase[B2_OSC])
 		);
 		sample_t B2_R = m_parent->m_rvol[B2_OSC] * std::lerp(
-			m_B2wave[static_cast<int>(m_rphase[B2_OSC])],
-			m_B2wave[static_cast<int>(m_rphase[B2_OSC] + 1) % WAVELEN],
+			B2wave[static_cast<int>(m_rphase[B2_OSC])],
+			B2wave[static_cast<int>(m_rphase[B2_OSC] + 1) % WAVELEN],
 			fraction(m_rphase[B2_OSC])
 		);
 
 		// if crosstalk active, add a1
-		const float xt = m_parent->m_xtalk.value();
 		if( xt > 0.0 )
 		{
 			B2_L += ( A1_L * xt ) * 0.01f;
@@ -184,13 +195,13 @@ void WatsynObject::renderOutput( fpp_t _frames )
 		}
 		// B1
 		sample_t B1_L = m_parent->m_lvol[B1_OSC] * std::lerp(
-			m_B1wave[static_cast<int>(B1_lphase) % WAVELEN],
-			m_B1wave[static_cast<int>(B1_lphase + 1) % WAVELEN],
+			B1wave[static_cast<int>(B1_lphase) % WAVELEN],
+			B1wave[static_cast<int>(B1_lphase + 1) % WAVELEN],
 			fraction(B1_lphase)
 		);
 		sample_t B1_R = m_parent->m_rvol[B1_OSC] * std::lerp(
-			m_B1wave[static_cast<int>(B1_rphase) % WAVELEN],
-			m_B1wave[static_cast<int>(B1_rphase + 1) % WAVELEN],
+			B1wave[static_cast<int>(B1_rphase) % WAVELEN],
+			B1wave[static_cast<int>(B1_rphase + 1) % WAVELEN],
 			fraction(B1_rphase)
 		);
 
@@ -236,10 +247,10 @@ void WatsynObject::renderOutput( fpp_t _frames )
 		// update phases
 		for( int i = 0; i < NUM_OSCS; i++ )
 		{
-			m_lphase[i] += ( static_cast<float>( WAVELEN ) / ( m_samplerate / ( m_nph->frequency() * m_parent->m_lfreq[i] ) ) );
-			m_lphase[i] = std::fmod(m_lphase[i], WAVELEN);
-			m_rphase[i] += ( static_cast<float>( WAVELEN ) / ( m_samplerate / ( m_nph->frequency() * m_parent->m_rfreq[i] ) ) );
-			m_rphase[i] = std::fmod(m_rphase[i], WAVELEN);
+			m_lphase[i] += linc[i];
+			if( m_lphase[i] >= WAVELEN ) { m_lphase[i] = std::fmod(m_lphase[i], WAVELEN); }
+			m_rphase[i] += rinc[i];
+			if( m_rphase[i] >= WAVELEN ) { m_rphase[i] = std::fmod(m_rphase[i], WAVELEN); }
 		}
 	}
 
@@ -346,8 +357,9 @@ void WatsynInstrument::playNote( NotePlayHandle * _n,
 {
 	if (!_n->m_pluginData)
 	{
-		auto w = new WatsynObject(&A1_wave[0], &A2_wave[0], &B1_wave[0], &B2_wave[0], m_amod.value(), m_bmod.value(),
-			Engine::audioEngine()->outputSampleRate(), _n, Engine::audioEngine()->framesPerPeriod(), this);
+		auto w = new WatsynObject(std::atomic_load(&A1_wave), std::atomic_load(&A2_wave),
+			std::atomic_load(&B1_wave), std::atomic_load(&B2_wave), m_amod.value(), m_bmod.value(),
+			Engine::audioEngine()->outputSampleRate(), _n, Engine::audioEngine()->maxFramesPerPeriod(), this);
 
 		_n->m_pluginData = w;
 	}
@@ -643,28 +655,28 @@ void WatsynInstrument::updateFreqB2()
 void WatsynInstrument::updateWaveA1()
 {
 	// do sinc+oversampling on the wavetables to improve quality
-	srccpy( &A1_wave[0], const_cast<float*>( a1_graph.samples() ) );
+	std::atomic_store( &A1_wave, makeWave( a1_graph.samples() ) );
 }
 
 
 void WatsynInstrument::updateWaveA2()
 {
 	// do sinc+oversampling on the wavetables to improve quality
-	srccpy( &A2_wave[0], const_cast<float*>( a2_graph.samples() ) );
+	std::atomic_store( &A2_wave, makeWave( a2_graph.samples() ) );
 }
 
 
 void WatsynInstrument::updateWaveB1()
 {
 	// do sinc+oversampling on the wavetables to improve quality
-	srccpy( &B1_wave[0], const_cast<float*>( b1_graph.samples() ) );
+	std::atomic_store( &B1_wave, makeWave( b1_graph.samples() ) );
 }
 
 
 void WatsynInstrument::updateWaveB2()
 {
 	// do sinc+oversampling on the wavetables to improve quality
-	srccpy( &B2_wave[0], const_cast<float*>( b2_graph.samples() ) );
+	std::atomic_store( &B2_wave, makeWave( b2_graph.samples() ) );
 }
 
 
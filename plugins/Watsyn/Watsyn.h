@@ -26,6 +26,9 @@
 #ifndef WATSYN_H
 #define WATSYN_H
 
+#include <array>
+#include <memory>
+
 #include "Instrument.h"
 #include "InstrumentView.h"
 #include "Graph.h"
@@ -64,6 +67,9 @@ const int WAVERATIO = 32; // oversampling ratio
 const int WAVELEN = GRAPHLEN * WAVERATIO;
 const int PMOD_AMT = WAVELEN / 2;
 
+// an oversampled wavetable, shared by all notes playing it
+using WaveTable = std::array<float, WAVELEN>;
+
 const int	MOD_MIX = 0;
 const int	MOD_AM = 1;
 const int	MOD_RM = 2;
@@ -88,8 +94,8 @@ class WatsynView;
 class WatsynObject
 {
 public:
-	WatsynObject( 	float * _A1wave, float * _A2wave,
-					float * _B1wave, float * _B2wave,
+	WatsynObject( 	std::shared_ptr<const WaveTable> _A1wave, std::shared_ptr<const WaveTable> _A2wave,
+					std::shared_ptr<const WaveTable> _B1wave, std::shared_ptr<const WaveTable> _B2wave,
 					int _amod, int _bmod, const sample_rate_t _samplerate, NotePlayHandle * _nph, fpp_t _frames,
 					WatsynInstrument * _w );
 	virtual ~WatsynObject();
@@ -126,10 +132,11 @@ private:
 	float m_lphase [NUM_OSCS];
 	float m_rphase [NUM_OSCS];
 
-	float m_A1wave [WAVELEN];
-	float m_A2wave [WAVELEN];
-	float m_B1wave [WAVELEN];
-	float m_B2wave [WAVELEN];
+	// the wavetables when the note started, edits only affect new notes
+	std::shared_ptr<const WaveTable> m_A1wave;
+	std::shared_ptr<const WaveTable> m_A2wave;
+	std::shared_ptr<const WaveTable> m_B1wave;
+	std::shared_ptr<const WaveTable> m_B2wave;
 };
 
 class WatsynInstrument : public Instrument
@@ -186,6 +193,14 @@ private:
 		return ( _pan >= 0 ? 1.0 : 1.0 + ( _pan / 100.0 ) ) * _vol / 100.0;
 	}
 
+	// oversamples a graph into a new wavetable
+	inline std::shared_ptr<const WaveTable> makeWave( const float * _src )
+	{
+		auto wave = std::make_shared<WaveTable>();
+		srccpy( wave->data(), const_cast<float*>( _src ) );
+		return wave;
+	}
+
 	// memcpy utilizing libsamplerate (src) for sinc interpolation
 	inline void srccpy( float * _dst, float * _src )
 	{
@@ -288,10 +303,11 @@ private:
 
 	IntModel m_selectedGraph;
 	
-	float A1_wave [WAVELEN];
-	float A2_wave [WAVELEN];
-	float B1_wave [WAVELEN];
-	float B2_wave [WAVELEN];
+	// replaced as a whole on every edit, so notes can keep playing the old ones without copying them
+	std::shared_ptr<const WaveTable> A1_wave;
+	std::shared_ptr<const WaveTable> A2_wave;
+	std::shared_ptr<const WaveTable> B1_wave;
+	std::shared_ptr<const WaveTable> B2_wave;
 
 	friend class WatsynObject;
 	friend class gui::WatsynView;
@@ -58,7 +58,9 @@ Plugin::Descriptor PLUGIN_EXPORT waveshaper_plugin_descriptor =
 WaveShaperEffect::WaveShaperEffect( Model * _parent,
 			const Descriptor::SubPluginFeatures::Key * _key ) :
 	Effect( &waveshaper_plugin_descriptor, _parent, _key ),
-	m_wsControls( this )
+	m_wsControls( this ),
+	m_oversampler(Engine::audioEngine()->maxFramesPerPeriod()),
+	m_wetBuffer(Engine::audioEngine()->maxFramesPerPeriod())
 {
 }
 
@@ -80,19 +82,25 @@ Effect::ProcessStatus WaveShaperEffect::processImpl(SampleFrame* buf, const fpp_
 	ValueBuffer *inputBuffer = m_wsControls.m_inputModel.valueBuffer();
 	ValueBuffer *outputBufer = m_wsControls.m_outputModel.valueBuffer();
 
-	int inputInc = inputBuffer ? 1 : 0;
-	int outputInc = outputBufer ? 1 : 0;
-
 	const float *inputPtr = inputBuffer ? &( inputBuffer->values()[ 0 ] ) : &input;
 	const float *outputPtr = outputBufer ? &( outputBufer->values()[ 0 ] ) : &output;
 
-	for (fpp_t f = 0; f < frames; ++f)
+	// shape the signal at the oversampled rate, the gains change once per frame of the period.
+	// An export rendering oversampled already counts towards the stages, so they aren't doubled.
+	const int engineStages = Engine::audioEngine()->currentQualitySettings().oversamplingStages();
+	m_oversampler.setStages(m_wsControls.m_oversamplingModel.value() - engineStages);
+	const int stages = m_oversampler.stages();
+	const auto shaped = m_oversampler.upsample(buf, frames);
+
+	for (std::size_t f = 0; f < shaped.size(); ++f)
 	{
-		auto s = std::array{buf[f][0], buf[f][1]};
+		auto s = std::array{shaped[f][0], shaped[f][1]};
+		const float inputGain = inputBuffer ? inputPtr[f >> stages] : *inputPtr;
+		const float outputGain = outputBufer ? outputPtr[f >> stages] : *outputPtr;
 
 // apply input gain
-		s[0] *= *inputPtr;
-		s[1] *= *inputPtr;
+		s[0] *= inputGain;
+		s[1] *= inputGain;
 
 // clip if clip enabled
 		if( clip )
@@ -124,15 +132,16 @@ Effect::ProcessStatus WaveShaperEffect::processImpl(SampleFrame* buf, const fpp_
 		}
 
 // apply output gain
-		s[0] *= *outputPtr;
-		s[1] *= *outputPtr;
+		shaped[f][0] = s[0] * outputGain;
+		shaped[f][1] = s[1] * outputGain;
+	}
 
-// mix wet/dry signals
-		buf[f][0] = d * buf[f][0] + w * s[0];
-		buf[f][1] = d * buf[f][1] + w * s[1];
+	m_oversampler.downsample(m_wetBuffer.data(), frames);
 
-		outputPtr += outputInc;
-		inputPtr += inputInc;
+// mix wet/dry signals
+	for (fpp_t f = 0; f < frames; ++f)
+	{
+		buf[f] = buf[f] * d + m_wetBuffer[f] * w;
 	}
 
 	return ProcessStatus::ContinueIfNotQuiet;
@@ -141,6 +150,14 @@ Effect::ProcessStatus WaveShaperEffect::processImpl(SampleFrame* buf, const fpp_
 
 
 
+void WaveShaperEffect::onEnabledChanged()
+{
+	m_oversampler.clear();
+}
+
+
+
+
 
 extern "C"
 {
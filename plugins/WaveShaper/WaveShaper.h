@@ -28,6 +28,7 @@
 #define _WAVESHAPER_H
 
 #include "Effect.h"
+#include "Oversampler.h"
 #include "WaveShaperControls.h"
 
 namespace lmms
@@ -48,11 +49,16 @@ public:
 		return( &m_wsControls );
 	}
 
+protected:
+	void onEnabledChanged() override;
 
 private:
 
 	WaveShaperControls m_wsControls;
 
+	Oversampler m_oversampler;
+	std::vector<SampleFrame> m_wetBuffer;
+
 	friend class WaveShaperControls;
 
 } ;
@@ -74,6 +74,12 @@ WaveShaperControlDialog::WaveShaperControlDialog(
 	outputKnob->setModel( &_controls->m_outputModel );
 	outputKnob->setHintText( tr( "Output gain:" ), "" );
 
+	auto oversamplingKnob = new Knob(KnobType::Bright26, this);
+	oversamplingKnob->move(184, 224);
+	oversamplingKnob->setModel(&_controls->m_oversamplingModel);
+	oversamplingKnob->setHintText(tr("Oversampling stages:"), "");
+	oversamplingKnob->setToolTip(tr("Shape at 2, 4 or 8 times the sample rate to reduce aliasing"));
+
 	auto resetButton = new PixmapButton(this, tr("Reset wavegraph"));
 	resetButton -> move( 162, 221 );
 	resetButton -> resize( 13, 46 );
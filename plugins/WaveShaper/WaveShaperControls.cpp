@@ -45,7 +45,8 @@ WaveShaperControls::WaveShaperControls( WaveShaperEffect * _eff ) :
 	m_inputModel( 1.0f, 0.0f, 5.0f, 0.01f, this, tr( "Input gain" ) ),
 	m_outputModel( 1.0f, 0.0f, 5.0f, 0.01f, this, tr( "Output gain" ) ),
 	m_wavegraphModel( 0.0f, 1.0f, 200, this ),
-	m_clipModel( false, this )
+	m_clipModel( false, this ),
+	m_oversamplingModel(0, 0, Oversampler::MaxStages, this, tr("Oversampling"))
 {
 	connect( &m_wavegraphModel, SIGNAL( samplesChanged( int, int ) ),
 			this, SLOT( samplesChanged( int, int ) ) );
@@ -71,6 +72,7 @@ void WaveShaperControls::loadSettings( const QDomElement & _this )
 	m_outputModel.loadSettings( _this, "outputGain" );
 
 	m_clipModel.loadSettings( _this, "clipInput" );
+	m_oversamplingModel.loadSettings(_this, "oversampling");
 
 //load waveshape
 	int size = 0;
@@ -93,6 +95,7 @@ void WaveShaperControls::saveSettings( QDomDocument & _doc,
 	m_outputModel.saveSettings( _doc, _this, "outputGain" );
 
 	m_clipModel.saveSettings( _doc, _this, "clipInput" );
+	m_oversamplingModel.saveSettings(_doc, _this, "oversampling");
 
 //save waveshape
 	QString sampleString;
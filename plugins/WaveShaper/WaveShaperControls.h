@@ -55,7 +55,7 @@ public:
 
 	int controlCount() override
 	{
-		return( 4 );
+		return( 5 );
 	}
 
 	gui::EffectControlDialog* createView() override
@@ -79,6 +79,8 @@ private:
 	FloatModel m_outputModel;
 	graphModel m_wavegraphModel;
 	BoolModel  m_clipModel;
+	//! The number of times the sample rate is doubled while shaping
+	IntModel m_oversamplingModel;
 
 	friend class gui::WaveShaperControlDialog;
 	friend class WaveShaperEffect;
@@ -524,12 +524,48 @@ struct harmonic_semitone
 static freefunc1<float,harmonic_semitone,true> harmonic_semitone_func;
 
 
+size_t find_occurances(const std::string& haystack, const char* const needle)
+{
+	size_t last_pos = 0;
+	size_t count = 0;
+	const size_t len = strlen(needle);
+	if (len > 0)
+	{
+		while (last_pos + len <= haystack.length())
+		{
+			last_pos = haystack.find(needle, last_pos);
+			if (last_pos == std::string::npos)
+				break;
+			++count;
+			last_pos += len;
+		}
+	}
+	return count;
+}
+
+//! Building a parser is expensive and notes are started on the audio threads,
+//! so every thread compiles all expressions with a parser of its own
+static parser_t& threadParser()
+{
+	thread_local auto parser = [] {
+		parser_t::settings_store sstore;
+		sstore.disable_all_logic_ops();
+		sstore.disable_all_assignment_ops();
+		sstore.disable_all_control_structures();
+		return parser_t(sstore);
+	}();
+	return parser;
+}
+
 ExprFront::ExprFront(const char * expr, int last_func_samples)
 {
 	m_valid = false;
 	try
 	{
-		m_data = new ExprFrontData(last_func_samples);
+		// every note creates its expressions, so only allocate the history
+		// of the "last" function if it is used
+		const bool usesLast = find_occurances(expr, "last") > 0;
+		m_data = new ExprFrontData(usesLast ? last_func_samples : 1);
 
 		m_data->m_expression_string = expr;
 		m_data->m_symbol_table.add_pi();
@@ -576,13 +612,8 @@ bool ExprFront::compile()
 	try
 	{
 		m_data->m_expression.register_symbol_table(m_data->m_symbol_table);
-		parser_t::settings_store sstore;
-		sstore.disable_all_logic_ops();
-		sstore.disable_all_assignment_ops();
-		sstore.disable_all_control_structures();
-		parser_t parser(sstore);
 
-		m_valid=parser.compile(m_data->m_expression_string, m_data->m_expression);
+		m_valid = threadParser().compile(m_data->m_expression_string, m_data->m_expression);
 	}
 	catch(...)
 	{
@@ -655,25 +686,6 @@ bool ExprFront::add_cyclic_vector(const char* name, const float* data, size_t le
 	}
 	return false;
 }
-size_t find_occurances(const std::string& haystack, const char* const needle)
-{
-	size_t last_pos = 0;
-	size_t count = 0;
-	const size_t len = strlen(needle);
-	if (len > 0)
-	{
-		while (last_pos + len <= haystack.length())
-		{
-			last_pos = haystack.find(needle, last_pos);
-			if (last_pos == std::string::npos)
-				break;
-			++count;
-			last_pos += len;
-		}
-	}
-	return count;
-}
-
 void ExprFront::setIntegrate(const unsigned int* const frameCounter, const unsigned int sample_rate)
 {
 	if (m_data->m_integ_func == nullptr)
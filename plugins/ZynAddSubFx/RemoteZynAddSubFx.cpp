@@ -35,6 +35,7 @@
 #undef CursorShape // is, by mistake, not undefed in FL
 
 #include "RemotePluginClient.h"
+#include "denormals.h"
 #include "LocalZynAddSubFx.h"
 
 #include <Nio/Nio.h>
@@ -83,6 +84,9 @@ public:
 
 	void messageLoop()
 	{
+		// audio is rendered while processing the messages
+		disable_denormals();
+
 		message m;
 		while( ( m = receiveMessage() ).id != IdQuit )
 		{
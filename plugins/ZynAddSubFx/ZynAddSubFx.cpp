@@ -118,6 +118,8 @@ ZynAddSubFxInstrument::ZynAddSubFxInstrument(
 	m_resBandwidthModel( 64, 0, 127, 1, this, tr( "Resonance bandwidth" ) ),
 	m_forwardMidiCcModel( true, this, tr( "Forward MIDI control change events" ) )
 {
+	// ZynAddSubFX sizes its voices for one period length
+	Engine::audioEngine()->holdFramesPerPeriod();
 	initPlugin();
 
 	connect( &m_portamentoModel, SIGNAL( dataChanged() ),
@@ -161,6 +163,8 @@ ZynAddSubFxInstrument::~ZynAddSubFxInstrument()
 	m_plugin = nullptr;
 	m_remotePlugin = nullptr;
 	m_pluginMutex.unlock();
+
+	Engine::audioEngine()->releaseFramesPerPeriod();
 }
 
 
@@ -392,6 +396,18 @@ void ZynAddSubFxInstrument::reloadPlugin()
 
 
 
+void ZynAddSubFxInstrument::hideUI()
+{
+	if( m_hasGUI )
+	{
+		m_hasGUI = false;
+		reloadPlugin();
+		emit uiHidden();
+	}
+}
+
+
+
 void ZynAddSubFxInstrument::updatePitchRange()
 {
 	m_pluginMutex.lock();
@@ -457,16 +473,21 @@ void ZynAddSubFxInstrument::initPlugin()
 
 		// temporary workaround until the VST synchronization feature gets stripped out of the RemotePluginClient class
 		// causing not to send buffer size information requests
-		m_remotePlugin->sendMessage( RemotePlugin::message( IdBufferSizeInformation ).addInt( Engine::audioEngine()->framesPerPeriod() ) );
+		m_remotePlugin->sendMessage( RemotePlugin::message( IdBufferSizeInformation ).addInt( Engine::audioEngine()->maxFramesPerPeriod() ) );
 
 		m_remotePlugin->showUI();
 		m_remotePlugin->unlock();
+
+		// the remote process is only needed for the GUI, so go back to
+		// running in-process once it is closed, even if our view isn't open
+		connect( m_remotePlugin, SIGNAL( clickedCloseButton() ),
+				this, SLOT( hideUI() ), Qt::QueuedConnection );
 	}
 	else
 	{
 		m_plugin = new LocalZynAddSubFx;
 		m_plugin->setSampleRate( Engine::audioEngine()->outputSampleRate() );
-		m_plugin->setBufferSize( Engine::audioEngine()->framesPerPeriod() );
+		m_plugin->setBufferSize( Engine::audioEngine()->maxFramesPerPeriod() );
 	}
 
 	m_pluginMutex.unlock();
@@ -620,6 +641,8 @@ void ZynAddSubFxView::modelChanged()
 	m_forwardMidiCC->setModel( &m->m_forwardMidiCcModel );
 
 	m_toggleUIButton->setChecked( m->m_hasGUI );
+	connect( m, &ZynAddSubFxInstrument::uiHidden, m_toggleUIButton,
+			[this] { m_toggleUIButton->setChecked( false ); } );
 }
 
 
@@ -632,12 +655,6 @@ void ZynAddSubFxView::toggleUI()
 	{
 		model->m_hasGUI = m_toggleUIButton->isChecked();
 		model->reloadPlugin();
-
-		if( model->m_remotePlugin )
-		{
-			connect( model->m_remotePlugin, SIGNAL( clickedCloseButton() ),
-						m_toggleUIButton, SLOT( toggle() ) );
-		}
 	}
 }
 
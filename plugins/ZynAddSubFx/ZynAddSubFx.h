@@ -91,6 +91,7 @@ public:
 
 private slots:
 	void reloadPlugin();
+	void hideUI();
 
 	void updatePitchRange();
 
@@ -128,6 +129,8 @@ private:
 
 signals:
 	void settingsChanged();
+	//! The GUI has been closed from the remote process
+	void uiHidden();
 
 } ;
 
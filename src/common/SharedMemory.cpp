@@ -23,8 +23,11 @@
 
 #include "SharedMemory.h"
 
+#include <atomic>
+#include <chrono>
 #include <random>
 #include <system_error>
+#include <thread>
 #include <utility>
 
 #include "lmmsconfig.h"
@@ -44,6 +47,16 @@
 #	error "No shared memory implementation available"
 #endif
 
+#ifdef __linux__
+#	include <ctime>
+#	include <linux/futex.h>
+#	include <sys/syscall.h>
+#endif
+
+#if defined(__i386__) || defined(__x86_64__)
+#	include <immintrin.h>
+#endif
+
 namespace lmms::detail {
 
 #if _POSIX_SHARED_MEMORY_OBJECTS > 0 || defined(LMMS_BUILD_APPLE)
@@ -262,3 +275,73 @@ auto SharedMemoryData::size_bytes() const noexcept -> std::size_t
 }
 
 } // namespace lmms::detail
+
+
+namespace lmms {
+
+namespace {
+
+void relax() noexcept
+{
+#if defined(__i386__) || defined(__x86_64__)
+	_mm_pause();
+#else
+	std::this_thread::yield();
+#endif
+}
+
+} // namespace
+
+auto SharedEvent::count() noexcept -> std::uint32_t
+{
+	return std::atomic_ref{m_count}.load(std::memory_order_acquire);
+}
+
+void SharedEvent::post() noexcept
+{
+	// sequentially consistent, so that either the waiter sees the new count
+	// before it sleeps or we see it sleeping
+	std::atomic_ref{m_count}.fetch_add(1, std::memory_order_seq_cst);
+#ifdef __linux__
+	if (std::atomic_ref{m_sleeping}.load(std::memory_order_seq_cst))
+	{
+		// the memory is shared between processes, so no FUTEX_PRIVATE_FLAG
+		syscall(SYS_futex, &m_count, FUTEX_WAKE, 1, nullptr, nullptr, 0);
+	}
+#endif
+}
+
+auto SharedEvent::wait(std::uint32_t seen, int spins, int timeoutMs) noexcept -> bool
+{
+	auto counter = std::atomic_ref{m_count};
+	for (int i = 0; i < spins; ++i)
+	{
+		if (counter.load(std::memory_order_acquire) != seen) { return true; }
+		relax();
+	}
+
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds{timeoutMs};
+#ifdef __linux__
+	auto sleeping = std::atomic_ref{m_sleeping};
+	sleeping.store(1, std::memory_order_seq_cst);
+	while (counter.load(std::memory_order_seq_cst) == seen)
+	{
+		const auto left = deadline - std::chrono::steady_clock::now();
+		if (left <= std::chrono::nanoseconds::zero()) { break; }
+
+		const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(left).count();
+		auto timeout = timespec{static_cast<time_t>(ns / 1'000'000'000), static_cast<long>(ns % 1'000'000'000)};
+		// returns right away if the count changed in the meantime
+		syscall(SYS_futex, &m_count, FUTEX_WAIT, seen, &timeout, nullptr, 0);
+	}
+	sleeping.store(0, std::memory_order_relaxed);
+#else
+	while (counter.load(std::memory_order_acquire) == seen && std::chrono::steady_clock::now() < deadline)
+	{
+		std::this_thread::yield();
+	}
+#endif
+	return counter.load(std::memory_order_acquire) != seen;
+}
+
+} // namespace lmms
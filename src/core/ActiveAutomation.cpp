@@ -0,0 +1,325 @@
+/*
+ * ActiveAutomation.cpp - applies the automation clips playing at the song position
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "ActiveAutomation.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "AutomationClip.h"
+#include "Engine.h"
+#include "PatternClip.h"
+#include "PatternStore.h"
+#include "PatternTrack.h"
+#include "TrackContainer.h"
+
+namespace lmms {
+
+namespace {
+
+auto automatesClips(const Track* track) -> bool
+{
+	switch (track->type())
+	{
+	case Track::Type::Automation:
+	case Track::Type::HiddenAutomation:
+	case Track::Type::Pattern:
+		return true;
+	default:
+		return false;
+	}
+}
+
+} // namespace
+
+void ActiveAutomation::process(const TrackContainer& container, Track* globalTrack, TimePos time, int clipNum)
+{
+	if (&container != m_container || clipNum != m_clipNum || TrackContainer::arrangementRevision() != m_revision
+		|| time < m_validFrom || time >= m_validUntil)
+	{
+		rebuild(container, globalTrack, time, clipNum);
+	}
+
+	for (auto& entry : m_entries)
+	{
+		entry.automated = false;
+		entry.recorded = false;
+	}
+
+	for (const auto& candidate : m_recordingCandidates)
+	{
+		auto clip = candidate.clip;
+		const TimePos relTime = time - clip->startPosition();
+		if (!clip->isRecording() || relTime < 0 || relTime >= clip->length()) { continue; }
+
+		// The automation system really needs to be reworked.
+		// For whatever reason, the values in an automation clip are stored in un-un-scaled format, so if you
+		// are automating a log knob, when you draw an curve, the values being stored are not the actual values the
+		// knob will take, but instead the unscaled version of the unscaled numbers. The tooltip shows the number you expect, but if you double-click,
+		// you can see that the true values are stored by their inverse scaled value....which is wrong, since they weren't scaled in the first place...?
+		// Anyhow, in the meantime before we redo the automation system, when recording automations, we have to get the inverseScaledValue
+		// and store that so that when playing it back, it scales the value correctly.
+		const AutomatableModel* recordedModel = clip->firstObject();
+		clip->recordValue(relTime, recordedModel->inverseScaledValue(recordedModel->value<float>()));
+
+		if (candidate.entry != None) { m_entries[candidate.entry].recorded = true; }
+	}
+
+	// in a pattern, the clips of pattern clipNum are played from its start on
+	const auto patternStore = Engine::patternStore();
+	if (clipNum >= 0)
+	{
+		time = std::min<int>(time, patternStore->lengthOfPattern(clipNum) * TimePos::ticksPerBar())
+			+ TimePos::ticksPerBar() * clipNum;
+	}
+
+	const PatternClip* lastPatternClip = nullptr;
+	auto patternTime = TimePos{};
+	for (const auto& source : m_sources)
+	{
+		auto clipTime = time;
+		if (source.patternClip)
+		{
+			if (source.patternTrack->isMuted() || source.patternClip->isMuted()) { continue; }
+
+			if (source.patternClip != lastPatternClip)
+			{
+				const auto patternLength = patternStore->lengthOfPattern(source.patternIndex) * TimePos::ticksPerBar();
+				patternTime = std::min<int>(time - source.patternClip->startPosition(), source.patternClip->length())
+					% patternLength;
+				patternTime = std::min<int>(patternTime, patternLength) + TimePos::ticksPerBar() * source.patternIndex;
+				lastPatternClip = source.patternClip;
+			}
+			clipTime = patternTime;
+		}
+
+		const auto clip = source.clip;
+		if (source.track->isMuted() || clip->isMuted() || clip->startPosition() > clipTime
+			|| !clip->hasAutomation()) { continue; }
+
+		const int relTime = clipTime - clip->startPosition() - clip->startTimeOffset();
+		const int end = source.inPattern ? std::numeric_limits<int>::max() : clip->length() - clip->startTimeOffset();
+		const auto value = clip->valueAt(std::min(relTime, end));
+		// the models ramp to the value of the next tick within their value buffers
+		const auto target = clip->valueAt(std::min(relTime + 1, end));
+
+		// later clips override the values of earlier ones
+		for (const auto index : source.entries)
+		{
+			m_entries[index].value = value;
+			m_entries[index].target = target;
+			m_entries[index].automated = true;
+		}
+	}
+
+	const auto framesPerTick = static_cast<f_cnt_t>(Engine::framesPerTick());
+	for (auto& entry : m_entries)
+	{
+		const auto model = entry.model.data();
+		if (!model) { continue; }
+
+		if (entry.automated)
+		{
+			if (!entry.recorded) { model->setAutomatedRamp(entry.value, entry.target, framesPerTick); }
+			else if (!model->useControllerValue()) { model->setUseControllerValue(true); }
+		}
+		else if (entry.wasAutomated && model->controllerConnection())
+		{
+			// the model stopped being automated, move the control back to its controller
+			model->setUseControllerValue(true);
+		}
+		entry.wasAutomated = entry.automated;
+	}
+}
+
+void ActiveAutomation::release()
+{
+	for (const auto& entry : m_entries)
+	{
+		if (entry.wasAutomated && entry.model) { entry.model->setUseControllerValue(true); }
+	}
+	clear();
+}
+
+void ActiveAutomation::clear()
+{
+	m_entries.clear();
+	m_sources.clear();
+	m_recordingCandidates.clear();
+	m_patternAutomation.clear();
+	m_patternAutomationValid.clear();
+	m_container = nullptr;
+	m_clipNum = -1;
+	m_validFrom = std::numeric_limits<int>::max();
+	m_validUntil = std::numeric_limits<int>::min();
+}
+
+void ActiveAutomation::rebuild(const TrackContainer& container, Track* globalTrack, TimePos time, int clipNum)
+{
+	if (TrackContainer::arrangementRevision() != m_revision)
+	{
+		// some pattern may have been edited
+		m_patternAutomationValid.assign(m_patternAutomationValid.size(), false);
+	}
+
+	m_container = &container;
+	m_clipNum = clipNum;
+	m_revision = TrackContainer::arrangementRevision();
+	m_validFrom = 0;
+	m_validUntil = std::numeric_limits<int>::max();
+
+	auto entries = std::vector<Entry>{};
+	auto indices = std::unordered_map<const AutomatableModel*, std::size_t>{};
+	const auto entryOf = [&](AutomatableModel* model) {
+		const auto [it, added] = indices.try_emplace(model, entries.size());
+		if (added) { entries.push_back(Entry{model}); }
+		return it->second;
+	};
+
+	// the clips starting at or before the position, sorted by position like Track::getClipsInRange() does
+	auto clips = Track::clipVector{};
+	const auto collect = [&](Track* track) {
+		for (Clip* clip : track->getClips())
+		{
+			const auto start = clip->startPosition().getTicks();
+			if (start > time)
+			{
+				m_validUntil = std::min(m_validUntil, start);
+				continue;
+			}
+			m_validFrom = std::max(m_validFrom, start);
+			clips.insert(std::upper_bound(clips.begin(), clips.end(), clip, Clip::comparePosition), clip);
+		}
+	};
+
+	const auto addSource = [&](Source source) {
+		for (const auto& model : source.clip->objects())
+		{
+			if (model) { source.entries.push_back(entryOf(model)); }
+		}
+		source.inPattern = source.clip->isInPattern();
+		m_sources.push_back(std::move(source));
+	};
+
+	m_sources.clear();
+	if (clipNum < 0)
+	{
+		if (globalTrack) { collect(globalTrack); }
+		for (Track* track : container.tracks())
+		{
+			if (automatesClips(track)) { collect(track); }
+		}
+
+		for (Clip* clip : clips)
+		{
+			if (auto automationClip = dynamic_cast<AutomationClip*>(clip))
+			{
+				addSource(Source{automationClip, clip->getTrack()});
+			}
+			else if (auto patternClip = dynamic_cast<PatternClip*>(clip))
+			{
+				const auto patternIndex = static_cast<PatternTrack*>(clip->getTrack())->patternIndex();
+				for (const auto& automation : patternAutomation(patternIndex))
+				{
+					addSource(Source{automation.clip, automation.track, patternClip, clip->getTrack(), patternIndex});
+				}
+			}
+		}
+	}
+	else
+	{
+		for (Track* track : container.tracks())
+		{
+			if (!automatesClips(track)) { continue; }
+			Q_ASSERT(track->numOfClips() > clipNum);
+			if (auto automationClip = dynamic_cast<AutomationClip*>(track->getClip(clipNum)))
+			{
+				addSource(Source{automationClip, track});
+			}
+		}
+	}
+
+	// recording only looks at the position in the container, even in a pattern
+	m_recordingCandidates.clear();
+	for (Track* track : container.tracks())
+	{
+		if (track->type() != Track::Type::Automation) { continue; }
+		for (Clip* clip : track->getClips())
+		{
+			const auto start = clip->startPosition().getTicks();
+			if (start > time)
+			{
+				m_validUntil = std::min(m_validUntil, start);
+				continue;
+			}
+			m_validFrom = std::max(m_validFrom, start);
+
+			auto automationClip = static_cast<AutomationClip*>(clip);
+			const auto it = indices.find(automationClip->firstObject());
+			m_recordingCandidates.push_back({automationClip, it != indices.end() ? it->second : None});
+		}
+	}
+
+	for (const auto& entry : m_entries)
+	{
+		const auto model = entry.model.data();
+		if (!model) { continue; }
+
+		if (const auto it = indices.find(model); it != indices.end())
+		{
+			entries[it->second].wasAutomated = entry.wasAutomated;
+		}
+		else if (entry.wasAutomated && model->controllerConnection())
+		{
+			model->setUseControllerValue(true);
+		}
+	}
+	m_entries = std::move(entries);
+}
+
+auto ActiveAutomation::patternAutomation(int patternIndex) -> const std::vector<PatternAutomation>&
+{
+	const auto index = static_cast<std::size_t>(patternIndex);
+	if (index >= m_patternAutomation.size())
+	{
+		m_patternAutomation.resize(index + 1);
+		m_patternAutomationValid.resize(index + 1, false);
+	}
+
+	auto& automation = m_patternAutomation[index];
+	if (!m_patternAutomationValid[index])
+	{
+		automation.clear();
+		for (Track* track : Engine::patternStore()->tracks())
+		{
+			if (!automatesClips(track) || track->numOfClips() <= patternIndex) { continue; }
+			if (auto clip = dynamic_cast<AutomationClip*>(track->getClip(patternIndex)))
+			{
+				automation.push_back({clip, track});
+			}
+		}
+		m_patternAutomationValid[index] = true;
+	}
+	return automation;
+}
+
+} // namespace lmms
@@ -0,0 +1,486 @@
+/*
+ * AudioAnalysis.cpp - tempo, key and loudness of audio, computed locally
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "AudioAnalysis.h"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <numbers>
+#include <numeric>
+#include <QByteArray>
+#include <QCryptographicHash>
+
+#include "SampleBuffer.h"
+#include "ThreadPool.h"
+#include "fft_helpers.h"
+
+namespace lmms
+{
+
+namespace
+{
+
+using Result = AudioAnalysis::Result;
+//! Reads @p count frames starting at @p first into @p out
+using FrameReader = std::function<void(std::size_t first, std::size_t count, SampleFrame* out)>;
+
+constexpr auto OnsetWindow = 512u;
+constexpr auto ChromaWindow = 4096u;
+constexpr auto ReadChunk = std::size_t{4096};
+constexpr auto CacheSize = std::size_t{32};
+constexpr auto Silence = -70.f;
+
+// Krumhansl-Kessler probe tone profiles, starting at the tonic
+constexpr auto MajorProfile = std::array{6.35f, 2.23f, 3.48f, 2.33f, 4.38f, 4.09f, 2.52f, 5.19f, 2.39f, 3.66f, 2.29f, 2.88f};
+constexpr auto MinorProfile = std::array{6.33f, 2.68f, 3.52f, 5.38f, 2.60f, 3.53f, 2.54f, 4.75f, 3.98f, 2.69f, 3.34f, 3.17f};
+
+float toDb(double amplitude)
+{
+	return amplitude > 0 ? std::max(Silence, static_cast<float>(20 * std::log10(amplitude))) : Silence;
+}
+
+//! Transposed direct form II
+struct Biquad
+{
+	double b0, b1, b2, a1, a2;
+	double z1 = 0, z2 = 0;
+
+	double process(double in)
+	{
+		const double out = b0 * in + z1;
+		z1 = b1 * in - a1 * out + z2;
+		z2 = b2 * in - a2 * out;
+		return out;
+	}
+};
+
+//! The two stages of the K-weighting filter of BS.1770, for any sample rate
+std::array<Biquad, 2> kWeighting(sample_rate_t sampleRate)
+{
+	using std::numbers::pi;
+
+	// high shelf modelling the head
+	double k = std::tan(pi * 1681.974450955533 / sampleRate);
+	double q = 0.7071752369554196;
+	const double vh = std::pow(10.0, 3.999843853973347 / 20);
+	const double vb = std::pow(vh, 0.4996667741545416);
+	double a0 = 1 + k / q + k * k;
+	const auto shelf = Biquad{
+		(vh + vb * k / q + k * k) / a0, 2 * (k * k - vh) / a0, (vh - vb * k / q + k * k) / a0,
+		2 * (k * k - 1) / a0, (1 - k / q + k * k) / a0};
+
+	// high pass
+	k = std::tan(pi * 38.13547087602444 / sampleRate);
+	q = 0.5003270373238773;
+	a0 = 1 + k / q + k * k;
+	const auto highPass = Biquad{1, -2, 1, 2 * (k * k - 1) / a0, (1 - k / q + k * k) / a0};
+
+	return {shelf, highPass};
+}
+
+//! Mixes the frames to mono, and measures their loudness on the way
+std::vector<float> readFrames(const FrameReader& read, std::size_t count, sample_rate_t sampleRate, Result& result)
+{
+	auto mono = std::vector<float>(count);
+	auto chunk = std::vector<SampleFrame>(std::min(count, ReadChunk));
+
+	std::array<std::array<Biquad, 2>, 2> filters{kWeighting(sampleRate), kWeighting(sampleRate)};
+	const auto step = std::max<std::size_t>(sampleRate / 10, 1);
+	// K-weighted energy of every 100 ms, summed over both channels
+	auto energy = std::vector<double>{};
+	energy.reserve(count / step + 1);
+	double stepEnergy = 0;
+	std::size_t inStep = 0;
+	double peak = 0;
+	double sumSquares = 0;
+
+	for (std::size_t first = 0; first < count; first += chunk.size())
+	{
+		const auto frames = std::min(chunk.size(), count - first);
+		read(first, frames, chunk.data());
+		for (std::size_t i = 0; i < frames; ++i)
+		{
+			mono[first + i] = (chunk[i][0] + chunk[i][1]) / 2;
+			for (std::size_t ch = 0; ch < 2; ++ch)
+			{
+				const double sample = chunk[i][ch];
+				peak = std::max(peak, std::abs(sample));
+				sumSquares += sample * sample;
+				const double weighted = filters[ch][1].process(filters[ch][0].process(sample));
+				stepEnergy += weighted * weighted;
+			}
+			if (++inStep == step)
+			{
+				energy.push_back(stepEnergy);
+				stepEnergy = 0;
+				inStep = 0;
+			}
+		}
+	}
+
+	result.peak = toDb(peak);
+	result.rms = toDb(std::sqrt(sumSquares / (2.0 * count)));
+
+	// mean square of the 400 ms blocks, overlapping by 75 %
+	auto blocks = std::vector<double>{};
+	for (std::size_t i = 0; i + 4 <= energy.size(); ++i)
+	{
+		blocks.push_back((energy[i] + energy[i + 1] + energy[i + 2] + energy[i + 3]) / (4.0 * step));
+	}
+	if (blocks.empty())
+	{
+		// shorter than a block, which the standard doesn't cover
+		blocks.push_back((std::accumulate(energy.begin(), energy.end(), 0.0) + stepEnergy) / count);
+	}
+
+	const auto loudness = [](double meanSquare) {
+		return meanSquare > 0 ? -0.691 + 10 * std::log10(meanSquare) : -1000.0;
+	};
+	const auto gatedMean = [&](double gate) {
+		double sum = 0;
+		std::size_t n = 0;
+		for (const double block : blocks)
+		{
+			if (loudness(block) > gate)
+			{
+				sum += block;
+				++n;
+			}
+		}
+		return n > 0 ? sum / n : 0.0;
+	};
+
+	const double absoluteGated = gatedMean(Silence);
+	if (absoluteGated > 0)
+	{
+		const double relativeGate = std::max<double>(loudness(absoluteGated) - 10, Silence);
+		result.loudness = std::max(Silence, static_cast<float>(loudness(gatedMean(relativeGate))));
+	}
+
+	return mono;
+}
+
+void detectOnsets(const std::vector<float>& flux, double hop, Result& result)
+{
+	// SlicerT's default threshold, leaving out windows too quiet to matter
+	constexpr float MinRatio = 1.6f;
+	constexpr double MinDistance = 0.05;
+	if (flux.empty()) { return; }
+	const float floor = 0.01f * *std::max_element(flux.begin(), flux.end());
+
+	double last = -MinDistance;
+	for (std::size_t i = 0; i < flux.size(); ++i)
+	{
+		const double time = i * hop;
+		const float previous = i > 0 ? flux[i - 1] : 1E-10f;
+		if (flux[i] > floor && flux[i] / previous > MinRatio && time - last >= MinDistance)
+		{
+			result.onsets.push_back(time);
+			last = time;
+		}
+	}
+}
+
+//! Finds the beat period by autocorrelating the increase of the spectral flux
+void detectTempo(const std::vector<float>& flux, double hop, Result& result)
+{
+	constexpr double MinBpm = 60;
+	constexpr double MaxBpm = 200;
+	const auto minLag = std::max<std::size_t>(static_cast<std::size_t>(60 / (MaxBpm * hop)), 1);
+	const auto maxLag = static_cast<std::size_t>(std::ceil(60 / (MinBpm * hop)));
+	// at least a few beats at the slowest tempo
+	if (flux.size() < 4 * maxLag) { return; }
+
+	auto strength = std::vector<double>(flux.size(), 0.0);
+	for (std::size_t i = 1; i < flux.size(); ++i)
+	{
+		strength[i] = std::max(0.f, flux[i] - flux[i - 1]);
+	}
+	const double mean = std::accumulate(strength.begin(), strength.end(), 0.0) / strength.size();
+	for (double& value : strength) { value -= mean; }
+
+	const auto n = strength.size();
+	const auto correlation = [&](std::size_t lag) {
+		double sum = 0;
+		for (std::size_t i = 0; i + lag < n; ++i) { sum += strength[i] * strength[i + lag]; }
+		return sum / (n - lag);
+	};
+	const double energy = correlation(0);
+	if (energy <= 0) { return; }
+
+	auto correlations = std::vector<double>(maxLag + 2, 0.0);
+	for (std::size_t lag = minLag - 1; lag <= maxLag + 1; ++lag) { correlations[lag] = correlation(lag); }
+
+	// prefers tempos around 120 BPM, so the beat wins over its multiples
+	std::size_t best = 0;
+	double bestScore = 0;
+	for (std::size_t lag = minLag; lag <= maxLag; ++lag)
+	{
+		const double octaves = std::log2(60 / (lag * hop) / 120);
+		const double score = correlations[lag] * std::exp(-0.5 * octaves * octaves);
+		if (score > bestScore)
+		{
+			bestScore = score;
+			best = lag;
+		}
+	}
+	if (best == 0) { return; }
+
+	// parabolic interpolation between the neighbouring lags
+	double lag = best;
+	const double before = correlations[best - 1];
+	const double peak = correlations[best];
+	const double after = correlations[best + 1];
+	const double curvature = before - 2 * peak + after;
+	if (curvature < 0) { lag += 0.5 * (before - after) / curvature; }
+
+	result.bpm = static_cast<float>(60 / (lag * hop));
+	result.bpmConfidence = static_cast<float>(std::clamp(peak / energy, 0.0, 1.0));
+}
+
+//! Matches the chromagram with the key profiles
+void detectKey(const std::vector<float>& mono, sample_rate_t sampleRate, Result& result)
+{
+	if (mono.size() < ChromaWindow) { return; }
+
+	const auto bins = ChromaWindow / 2 + 1;
+	// the pitch class of every bin in the range of fundamentals, -1 outside
+	auto pitchClass = std::vector<int>(bins, -1);
+	for (unsigned int bin = 1; bin < bins; ++bin)
+	{
+		const double frequency = static_cast<double>(bin) * sampleRate / ChromaWindow;
+		if (frequency < 100 || frequency > 2100) { continue; }
+		const auto note = static_cast<int>(std::lround(69 + 12 * std::log2(frequency / 440)));
+		pitchClass[bin] = (note % 12 + 12) % 12;
+	}
+
+	auto window = std::vector<float>(ChromaWindow);
+	precomputeWindow(window.data(), ChromaWindow, FFTWindow::Hanning, false);
+	const auto plan = realFftPlan(ChromaWindow);
+	auto in = makeFftwBuffer<float>(ChromaWindow);
+	auto out = makeFftwBuffer<fftwf_complex>(bins);
+
+	auto chroma = std::array<double, 12>{};
+	for (std::size_t first = 0; first + ChromaWindow <= mono.size(); first += ChromaWindow)
+	{
+		for (unsigned int i = 0; i < ChromaWindow; ++i) { in[i] = mono[first + i] * window[i]; }
+		fftwf_execute_dft_r2c(plan, in.get(), out.get());
+		for (unsigned int bin = 1; bin < bins; ++bin)
+		{
+			if (pitchClass[bin] < 0) { continue; }
+			chroma[pitchClass[bin]] += std::sqrt(out[bin][0] * out[bin][0] + out[bin][1] * out[bin][1]);
+		}
+	}
+
+	const double strongest = *std::max_element(chroma.begin(), chroma.end());
+	if (strongest <= 0) { return; }
+	for (std::size_t i = 0; i < 12; ++i) { result.chroma[i] = static_cast<float>(chroma[i] / strongest); }
+
+	const auto pearson = [&](const std::array<float, 12>& profile, int tonic) {
+		const double meanChroma = std::accumulate(chroma.begin(), chroma.end(), 0.0) / 12;
+		const double meanProfile = std::accumulate(profile.begin(), profile.end(), 0.0) / 12;
+		double covariance = 0, chromaVariance = 0, profileVariance = 0;
+		for (int pc = 0; pc < 12; ++pc)
+		{
+			const double c = chroma[pc] - meanChroma;
+			const double p = profile[(pc - tonic + 12) % 12] - meanProfile;
+			covariance += c * p;
+			chromaVariance += c * c;
+			profileVariance += p * p;
+		}
+		return chromaVariance > 0 ? covariance / std::sqrt(chromaVariance * profileVariance) : 0.0;
+	};
+
+	result.keyConfidence = -1.f;
+	for (int tonic = 0; tonic < 12; ++tonic)
+	{
+		for (const bool minor : {false, true})
+		{
+			const auto correlation = static_cast<float>(pearson(minor ? MinorProfile : MajorProfile, tonic));
+			if (correlation > result.keyConfidence)
+			{
+				result.keyConfidence = correlation;
+				result.key = tonic;
+				result.minor = minor;
+			}
+		}
+	}
+}
+
+Result analyzeFrames(const FrameReader& read, std::size_t count, sample_rate_t sampleRate)
+{
+	auto result = Result{};
+	if (count == 0 || sampleRate == 0) { return result; }
+	result.duration = static_cast<double>(count) / sampleRate;
+
+	const auto mono = readFrames(read, count, sampleRate, result);
+
+	const auto flux = spectralFlux(mono.data(), mono.size(), OnsetWindow);
+	const double hop = static_cast<double>(OnsetWindow) / sampleRate;
+	detectOnsets(flux, hop, result);
+	detectTempo(flux, hop, result);
+
+	detectKey(mono, sampleRate, result);
+	return result;
+}
+
+struct Cache
+{
+	std::mutex mutex;
+	std::map<QByteArray, Result> results;
+	std::deque<QByteArray> order; //!< oldest first
+};
+
+Cache& cache()
+{
+	static auto s_cache = Cache{};
+	return s_cache;
+}
+
+QByteArray contentHash(const std::byte* data, std::size_t size, sample_rate_t sampleRate)
+{
+	auto hash = QCryptographicHash{QCryptographicHash::Sha1};
+	constexpr auto MaxChunk = std::size_t{1} << 30;
+	for (std::size_t offset = 0; offset < size; offset += MaxChunk)
+	{
+		hash.addData(reinterpret_cast<const char*>(data) + offset, static_cast<int>(std::min(MaxChunk, size - offset)));
+	}
+	hash.addData(QByteArray::number(sampleRate));
+	return hash.result();
+}
+
+template<typename Compute>
+Result cached(const QByteArray& hash, Compute compute)
+{
+	auto& c = cache();
+	{
+		const auto lock = std::lock_guard{c.mutex};
+		if (const auto it = c.results.find(hash); it != c.results.end()) { return it->second; }
+	}
+
+	// computed without the lock, so other analyses aren't held up
+	auto result = compute();
+
+	const auto lock = std::lock_guard{c.mutex};
+	if (c.results.emplace(hash, result).second)
+	{
+		c.order.push_back(hash);
+		if (c.order.size() > CacheSize)
+		{
+			c.results.erase(c.order.front());
+			c.order.pop_front();
+		}
+	}
+	return result;
+}
+
+} // namespace
+
+
+
+
+std::vector<float> spectralFlux(const float* mono, std::size_t frames, unsigned int windowSize)
+{
+	auto flux = std::vector<float>{};
+	if (frames <= windowSize) { return flux; }
+	flux.reserve(frames / windowSize);
+
+	const auto plan = realFftPlan(windowSize);
+	auto in = makeFftwBuffer<float>(windowSize);
+	auto out = makeFftwBuffer<fftwf_complex>(windowSize / 2 + 1);
+	auto prevMags = std::vector<float>(windowSize / 2, 0.f);
+
+	for (std::size_t i = 0; i + windowSize < frames; i += windowSize)
+	{
+		std::copy_n(mono + i, windowSize, in.get());
+		fftwf_execute_dft_r2c(plan, in.get(), out.get());
+
+		float sum = 1E-10f; // no division by zero
+		for (unsigned int j = 0; j < windowSize / 2; ++j) // only the frequencies below Nyquist
+		{
+			const float real = out[j][0];
+			const float imag = out[j][1];
+			const float magnitude = std::sqrt(real * real + imag * imag);
+			sum += std::abs(magnitude - prevMags[j]);
+			prevMags[j] = magnitude;
+		}
+		flux.push_back(sum);
+	}
+	return flux;
+}
+
+
+
+
+std::future<AudioAnalysis::Result> AudioAnalysis::analyze(std::shared_ptr<const SampleBuffer> buffer)
+{
+	return ThreadPool::instance().enqueue([buffer = std::move(buffer)] {
+		buffer->waitUntilDecoded();
+		const auto size = buffer->size();
+		const auto hash = contentHash(buffer->storageData(), buffer->memoryUsage(), buffer->sampleRate());
+		return cached(hash, [&] {
+			// read in chunks, so compact storage isn't converted as a whole
+			const auto read = [&](std::size_t first, std::size_t count, SampleFrame* out) {
+				buffer->read(first, count, out);
+			};
+			return analyzeFrames(read, size, buffer->sampleRate());
+		});
+	});
+}
+
+
+
+
+std::future<AudioAnalysis::Result> AudioAnalysis::analyze(std::vector<SampleFrame> frames, sample_rate_t sampleRate)
+{
+	return ThreadPool::instance().enqueue([frames = std::move(frames), sampleRate] {
+		const auto hash = contentHash(
+			reinterpret_cast<const std::byte*>(frames.data()), frames.size() * sizeof(SampleFrame), sampleRate);
+		return cached(hash, [&] { return compute(frames.data(), frames.size(), sampleRate); });
+	});
+}
+
+
+
+
+AudioAnalysis::Result AudioAnalysis::compute(const SampleFrame* frames, std::size_t count, sample_rate_t sampleRate)
+{
+	const auto read = [frames](std::size_t first, std::size_t n, SampleFrame* out) {
+		std::copy_n(frames + first, n, out);
+	};
+	return analyzeFrames(read, count, sampleRate);
+}
+
+
+
+
+const char* AudioAnalysis::keyName(int key)
+{
+	static constexpr const char* Names[] = {"C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B"};
+	return key >= 0 && key < 12 ? Names[key] : "";
+}
+
+} // namespace lmms
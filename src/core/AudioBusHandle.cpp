@@ -24,28 +24,59 @@
  */
 
 #include <QMutexLocker>
+#include <algorithm>
 
 #include "AudioBusHandle.h"
 #include "AudioDevice.h"
 #include "AudioEngine.h"
+#include "AudioEngineWorkerThread.h"
 #include "EffectChain.h"
+#include "FrozenAudio.h"
 #include "Mixer.h"
 #include "Engine.h"
 #include "MixHelpers.h"
 #include "BufferManager.h"
+#include "Song.h"
 
 namespace lmms
 {
 
+namespace
+{
+
+//! The position of the song, in ticks, which frozen audio is stored by
+double songPosition()
+{
+	const auto& pos = Engine::getSong()->getPlayPos(Song::PlayMode::Song);
+	return pos.getTicks() + pos.currentFrame() / Engine::framesPerTick();
+}
+
+//! Frozen audio only fits the periods it was rendered with
+bool fits(const FrozenAudio& audio)
+{
+	const AudioEngine* audioEngine = Engine::audioEngine();
+	return audio.periodSize() == audioEngine->framesPerPeriod()
+		&& audio.sampleRate() == audioEngine->outputSampleRate();
+}
+
+} // namespace
+
+
+
+
 AudioBusHandle::AudioBusHandle(const QString& name, bool hasEffectChain,
 	FloatModel* volumeModel, FloatModel* panningModel,
 	BoolModel* mutedModel) :
+	m_pendingPlayHandles(0),
 	m_bufferUsage(false),
+	m_bufferSilent(true),
+	m_hasOutput(false),
 	m_buffer(BufferManager::acquire()),
 	m_extOutputEnabled(false),
 	m_nextMixerChannel(0),
 	m_name(name),
 	m_effects(hasEffectChain ? new EffectChain(nullptr) : nullptr),
+	m_playHandles(&PlayHandle::Slots::bus),
 	m_volumeModel(volumeModel),
 	m_panningModel(panningModel),
 	m_mutedModel(mutedModel)
@@ -106,26 +137,92 @@ bool AudioBusHandle::processEffects()
 }
 
 
+
+
+f_cnt_t AudioBusHandle::latency() const
+{
+	// frozen audio still has the latency of the effects it was rendered with
+	if (const auto audio = playedAudio()) { return audio->latency(); }
+	return m_effects ? m_effects->latency() : 0;
+}
+
+
+
+
+void AudioBusHandle::setFrozenAudio(std::shared_ptr<const FrozenAudio> audio)
+{
+	std::atomic_store(&m_frozenAudio, std::move(audio));
+}
+
+
+
+
+bool AudioBusHandle::playsFrozenAudio() const
+{
+	return playedAudio() != nullptr;
+}
+
+
+
+
+std::shared_ptr<const FrozenAudio> AudioBusHandle::playedAudio() const
+{
+	// while exporting, only the output cached by earlier exports replaces the live output
+	const Song* song = Engine::getSong();
+	if (song->isExporting())
+	{
+		return m_renderCache && fits(*m_renderCache) ? m_renderCache : nullptr;
+	}
+
+	// frozen audio only follows the song
+	auto audio = std::atomic_load(&m_frozenAudio);
+	const bool plays = song->isPlaying() && song->playMode() == Song::PlayMode::Song;
+	return audio && plays && fits(*audio) ? audio : nullptr;
+}
+
+
 void AudioBusHandle::doProcessing()
+{
+	{
+		AudioEngineProfiler::TraceScope trace(Engine::audioEngine()->profiler(), "Bus", "Audio bus",
+			reinterpret_cast<std::uintptr_t>(this));
+		const auto time = CpuTime::Scope{&m_processingTime};
+		Engine::audioEngine()->seedRandom(AudioEngine::RandomDomain::BusHandle, m_randomKey);
+		process();
+	}
+
+	// let our mixer channel know it doesn't have to wait for us any longer
+	Engine::mixer()->busHandleProcessed(m_nextMixerChannel);
+}
+
+
+
+
+void AudioBusHandle::process()
 {
 	if (m_mutedModel && m_mutedModel->value())
 	{
+		m_hasOutput = false;
 		return;
 	}
 
+	if (processFrozen()) { return; }
+
 	const fpp_t fpp = Engine::audioEngine()->framesPerPeriod();
 
-	// clear the buffer
-	zeroSampleFrames(m_buffer, fpp);
+	// clear the buffer, unless nothing has been written to it since
+	if (!m_bufferSilent)
+	{
+		zeroSampleFrames(m_buffer, fpp);
+		m_bufferSilent = true;
+	}
 
 	//qDebug( "Playhandles: %d", m_playHandles.size() );
 	for (PlayHandle* ph : m_playHandles) // now we mix all playhandle buffers into our internal buffer
 	{
 		if (ph->buffer())
 		{
-			if (ph->usesBuffer()
-				&& (ph->type() == PlayHandle::Type::NotePlayHandle
-					|| !MixHelpers::isSilent(ph->buffer(), fpp)))
+			if (ph->usesBuffer() && !ph->isBufferSilent())
 			{
 				m_bufferUsage = true;
 				MixHelpers::add(m_buffer, ph->buffer(), fpp);
@@ -223,32 +320,119 @@ void AudioBusHandle::doProcessing()
 	// as of now there's no situation where we only have panning model but no volume model
 	// if we have neither, we don't have to do anything here - just pass the audio as is
 
-	// handle effects
+	// handle effects, which only touch our buffer if there's input or some
+	// effects are still running
+	if (m_bufferUsage || (m_effects && m_effects->isRunning()))
+	{
+		m_bufferSilent = false;
+	}
 	const bool anyOutputAfterEffects = processEffects();
-	if (anyOutputAfterEffects || m_bufferUsage)
+	m_hasOutput = anyOutputAfterEffects || m_bufferUsage;
+
+	// the output is frozen before compensation, which is applied again on playback
+	if (m_freezeCapture)
+	{
+		m_freezeCapture->append(m_hasOutput ? m_buffer : nullptr, songPosition());
+	}
+
+	// line the output up with the paths of higher latency into the same mixer channel
+	if (m_compensation.delay() > 0)
 	{
-		Engine::mixer()->mixToChannel(m_buffer, m_nextMixerChannel);	// send output to mixer
-																		// TODO: improve the flow here - convert to pull model
+		const bool delayedOutput = m_compensation.process(m_hasOutput ? m_buffer : nullptr, m_buffer, fpp);
+		if (delayedOutput) { m_bufferSilent = false; }
+		m_hasOutput = delayedOutput;
+	}
+
+	if (m_hasOutput)
+	{
+		// in deterministic mode the mixer channel pulls our buffer instead,
+		// so the buses are summed in a fixed order
+		if (!Engine::audioEngine()->isDeterministic())
+		{
+			Engine::mixer()->mixToChannel(m_buffer, m_nextMixerChannel);	// send output to mixer
+																			// TODO: improve the flow here - convert to pull model
+		}
 		m_bufferUsage = false;
 	}
 }
 
 
+bool AudioBusHandle::processFrozen()
+{
+	const auto audio = playedAudio();
+	if (!audio) { return false; }
+
+	// nothing of the play handles is heard, but their buffers have to be returned
+	for (PlayHandle* ph : m_playHandles)
+	{
+		if (ph->buffer()) { ph->releaseBuffer(); }
+	}
+
+	const fpp_t fpp = Engine::audioEngine()->framesPerPeriod();
+	const double position = songPosition();
+	m_hasOutput = audio->read(m_buffer, position, Engine::framesPerTick());
+	if (m_hasOutput) { m_bufferSilent = false; }
+
+	// what's played is the output of the track just as well
+	if (m_freezeCapture)
+	{
+		m_freezeCapture->append(m_hasOutput ? m_buffer : nullptr, position);
+	}
+
+	if (m_compensation.delay() > 0)
+	{
+		const bool delayedOutput = m_compensation.process(m_hasOutput ? m_buffer : nullptr, m_buffer, fpp);
+		if (delayedOutput) { m_bufferSilent = false; }
+		m_hasOutput = delayedOutput;
+	}
+
+	if (m_hasOutput && !Engine::audioEngine()->isDeterministic())
+	{
+		Engine::mixer()->mixToChannel(m_buffer, m_nextMixerChannel);
+	}
+	m_bufferUsage = false;
+	return true;
+}
+
+
+
+
+void AudioBusHandle::playHandleProcessed()
+{
+	if (--m_pendingPlayHandles == 0 && !AudioEngineWorkerThread::addJob(this))
+	{
+		// the mixer channel waits for us, so process right away if the
+		// job queue is full
+		queue();
+		ThreadableJob::process();
+	}
+}
+
+
 void AudioBusHandle::addPlayHandle(PlayHandle* handle)
 {
 	QMutexLocker lockGuard(&m_playHandleLock);
-	m_playHandles.append(handle);
+	if (Engine::audioEngine()->isDeterministic())
+	{
+		// summed up in a fixed order, not the one the handles are created in
+		const auto it = std::upper_bound(m_playHandles.begin(), m_playHandles.end(), handle,
+			[](const PlayHandle* a, const PlayHandle* b) { return a->order() < b->order(); });
+		m_playHandles.insert(static_cast<std::size_t>(it - m_playHandles.begin()), handle);
+		return;
+	}
+	m_playHandles.add(handle);
 }
 
 
 void AudioBusHandle::removePlayHandle(PlayHandle* handle)
 {
 	QMutexLocker lockGuard(&m_playHandleLock);
-	PlayHandleList::Iterator it = std::find(m_playHandles.begin(), m_playHandles.end(), handle);
-	if (it != m_playHandles.end())
+	if (Engine::audioEngine()->isDeterministic())
 	{
-		m_playHandles.erase(it);
+		m_playHandles.removeKeepingOrder(handle);
+		return;
 	}
+	m_playHandles.remove(handle);
 }
 
 } // namespace lmms
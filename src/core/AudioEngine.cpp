@@ -34,8 +34,13 @@
 #include "Mixer.h"
 #include "Song.h"
 #include "EnvelopeAndLfoParameters.h"
+#include "InstrumentTrack.h"
 #include "NotePlayHandle.h"
 #include "ConfigManager.h"
+#include "RealtimeChecker.h"
+#include "RealtimeMemory.h"
+#include "XRunRecorder.h"
+#include "lmms_math.h"
 
 // platform-specific audio-interface-classes
 #include "AudioAlsa.h"
@@ -44,6 +49,7 @@
 #include "AudioSndio.h"
 #include "AudioPortAudio.h"
 #include "AudioSoundIo.h"
+#include "AudioPipeWire.h"
 #include "AudioPulseAudio.h"
 #include "AudioSdl.h"
 #include "AudioDummy.h"
@@ -52,6 +58,7 @@
 #include "MidiAlsaRaw.h"
 #include "MidiAlsaSeq.h"
 #include "MidiJack.h"
+#include "MidiPipeWire.h"
 #include "MidiOss.h"
 #include "MidiSndio.h"
 #include "MidiWinMM.h"
@@ -74,12 +81,23 @@ AudioEngine::AudioEngine( bool renderOnly ) :
 	m_renderOnly( renderOnly ),
 	m_framesPerPeriod( DEFAULT_BUFFER_SIZE ),
 	m_baseSampleRate(std::max(ConfigManager::inst()->value("audioengine", "samplerate").toInt(), SUPPORTED_SAMPLERATES.front())),
-	m_inputBufferRead( 0 ),
-	m_inputBufferWrite( 1 ),
+	m_inputRing( DEFAULT_BUFFER_SIZE * 100 ),
+	m_inputRingReader( m_inputRing ),
+	m_inputBuffer( nullptr ),
+	m_inputBufferFrames( 0 ),
+	m_inputBacklogLimit( 0 ),
+	m_inputMonitorChannel( -1 ),
 	m_outputBufferRead(nullptr),
 	m_outputBufferWrite(nullptr),
+	m_displayed(false),
+	m_displayRing(4 * MAXIMUM_RENDER_BUFFER_SIZE),
+	m_displayRingReader(m_displayRing),
 	m_workers(),
 	m_numWorkers( QThread::idealThreadCount()-1 ),
+	m_numRenderWorkers( 0 ),
+	m_deterministic( false ),
+	m_playHandles(&PlayHandle::Slots::engine),
+	m_playHandlesOfType(PlayHandle::TypeCount, PlayHandleRegistry{&PlayHandle::Slots::type}),
 	m_newPlayHandles( PlayHandle::MaxNumber ),
 	m_qualitySettings(qualitySettings::Interpolation::Linear),
 	m_masterGain( 1.0f ),
@@ -89,14 +107,6 @@ AudioEngine::AudioEngine( bool renderOnly ) :
 	m_profiler(),
 	m_clearSignal(false)
 {
-	for( int i = 0; i < 2; ++i )
-	{
-		m_inputBufferFrames[i] = 0;
-		m_inputBufferSize[i] = DEFAULT_BUFFER_SIZE * 100;
-		m_inputBuffer[i] = new SampleFrame[ DEFAULT_BUFFER_SIZE * 100 ];
-		zeroSampleFrames(m_inputBuffer[i], m_inputBufferSize[i]);
-	}
-
 	// determine FIFO size and number of frames per period
 	int fifoSize = 1;
 
@@ -127,25 +137,133 @@ AudioEngine::AudioEngine( bool renderOnly ) :
 			m_framesPerPeriod = DEFAULT_BUFFER_SIZE;
 		}
 	}
+	// when rendering, there is no output latency to care about, so the period
+	// size can be lowered for benchmarking or raised to reduce the per-period
+	// overhead of the engine (automation stays sample-exact)
+	else
+	{
+		const auto renderFrames = ConfigManager::inst()->value("audioengine", "renderframesperperiod").toInt();
+		if (renderFrames >= static_cast<int>(MINIMUM_BUFFER_SIZE)
+			&& renderFrames <= static_cast<int>(MAXIMUM_RENDER_BUFFER_SIZE))
+		{
+			m_framesPerPeriod = renderFrames;
+		}
+	}
 
-	// allocte the FIFO from the determined size
-	m_fifo = new Fifo( fifoSize );
+	const auto config = ConfigManager::inst();
+	AudioEngineWorkerThread::setRealtimeScheduling(config->value("audioengine", "rtpriority").toInt(),
+		config->value("audioengine", "rtpolicy") == "rr" ? RealtimePolicy::RoundRobin : RealtimePolicy::Fifo);
 
-	// now that framesPerPeriod is fixed initialize global BufferManager
-	BufferManager::init( m_framesPerPeriod );
+	// the workers are kept on the cores given by the user, e.g. isolated ones,
+	// or else on the performance cores of hybrid processors
+	auto workerCpus = parseCpuList(config->value("audioengine", "workercpus").toStdString());
+	const auto nodes = config->value("audioengine", "numanodes", "1").toInt()
+		? numaNodes() : std::vector<std::vector<unsigned>>{};
+	if (workerCpus.empty() && !nodes.empty())
+	{
+		// on hosts with several NUMA nodes, they are kept on all cores node by
+		// node, so the workers of a node get neighbouring lanes
+		for (const auto& cores : nodes)
+		{
+			workerCpus.insert(workerCpus.end(), cores.begin(), cores.end());
+		}
+	}
+	else if (workerCpus.empty() && !config->value("audioengine", "efficiencycores").toInt())
+	{
+		workerCpus = performanceCores();
+	}
+	if (!workerCpus.empty())
+	{
+		m_numWorkers = static_cast<int>(workerCpus.size()) - 1;
+	}
+
+	// the number of threads processing jobs (including the rendering thread)
+	// can be limited by the user, by default all cores are used
+	const int workerThreads = config->value("audioengine", "workerthreads").toInt();
+	if (workerThreads > 0)
+	{
+		m_numWorkers = workerThreads - 1;
+	}
+	m_numRenderWorkers = std::max(config->value("audioengine", "renderworkerthreads").toInt(), 0);
+	AudioEngineWorkerThread::setSpinTime(std::chrono::microseconds{
+		std::max(config->value("audioengine", "workerspintime", "50").toInt(), 0)});
+
+	m_deterministic = config->value("audioengine", "deterministic").toInt();
+
+	NotePlayHandleManager::setVoiceStealing(static_cast<NotePlayHandleManager::VoiceStealing>(
+		ConfigManager::inst()->value("audioengine", "voicestealing").toInt()));
+
+	// exports have no deadline to miss
+	if (const auto incidents = config->value("audioengine", "xrunincidents", "100").toInt();
+		!renderOnly && incidents > 0)
+	{
+		m_xrunRecorder = std::make_unique<XRunRecorder>(static_cast<std::size_t>(incidents));
+		m_profiler.setTimingJobs(true);
+	}
+
+	// periods may be shortened later on, but never get longer than this
+	m_maxFramesPerPeriod = m_framesPerPeriod;
+	m_requestedFramesPerPeriod = m_framesPerPeriod.load();
+	m_recordingFramesPerPeriod = static_cast<fpp_t>(
+		std::max(config->value("audioengine", "recordingframesperperiod").toInt(), 0));
 
-	m_outputBufferRead = std::make_unique<SampleFrame[]>(m_framesPerPeriod);
-	m_outputBufferWrite = std::make_unique<SampleFrame[]>(m_framesPerPeriod);
+	// allocte the FIFO from the determined size
+	m_fifo = new Fifo(fifoSize, m_maxFramesPerPeriod);
 
+	// now that framesPerPeriod is fixed initialize global BufferManager
+	BufferManager::init(m_maxFramesPerPeriod);
+
+	m_inputBuffer = std::make_unique<SampleFrame[]>(m_maxFramesPerPeriod);
+	// the device may deliver one buffer of fifoSize periods at once
+	m_inputBacklogLimit = 2 * fifoSize * m_maxFramesPerPeriod;
+	m_outputBufferRead = std::make_unique<SampleFrame[]>(m_maxFramesPerPeriod);
+	m_outputBufferWrite = std::make_unique<SampleFrame[]>(m_maxFramesPerPeriod);
+	m_outputBufferReadFrames = m_framesPerPeriod;
+	m_outputBufferWriteFrames = m_framesPerPeriod;
+	// kept until exit, as the audio engine
+	RealtimeMemory::lock(m_inputBuffer.get(), m_maxFramesPerPeriod * sizeof(SampleFrame));
+	RealtimeMemory::lock(m_outputBufferRead.get(), m_maxFramesPerPeriod * sizeof(SampleFrame));
+	RealtimeMemory::lock(m_outputBufferWrite.get(), m_maxFramesPerPeriod * sizeof(SampleFrame));
+
+
+	// create all workers before starting any of them, as each one adds a lane
+	// to the job queue. The last one is processed inline by the rendering thread.
+	for( int i = 0; i < m_numWorkers; ++i )
+	{
+		const auto cpu = workerCpus.empty() ? std::nullopt : std::optional{workerCpus[i % workerCpus.size()]};
+		m_workers.push_back( new AudioEngineWorkerThread(this, cpu) );
+	}
+	for( int i = 0; i < m_numRenderWorkers; ++i )
+	{
+		m_workers.push_back( new AudioEngineWorkerThread(this, std::nullopt, true) );
+	}
+	m_workers.push_back( new AudioEngineWorkerThread(this) );
 
-	for( int i = 0; i < m_numWorkers+1; ++i )
+	// the jobs of a track are kept on the lanes of one node, see
+	// renderStageProcessing(), so they find its buffers in local memory
+	if (!nodes.empty() && !workerCpus.empty())
 	{
-		auto wt = new AudioEngineWorkerThread(this);
-		if( i < m_numWorkers )
+		auto laneNodes = std::vector<std::size_t>{};
+		for( int i = 0; i < m_numWorkers; ++i )
 		{
-			wt->start( QThread::TimeCriticalPriority );
+			const auto cpu = workerCpus[i % workerCpus.size()];
+			const auto node = std::find_if(nodes.begin(), nodes.end(), [cpu](const auto& cores) {
+				return std::find(cores.begin(), cores.end(), cpu) != cores.end();
+			});
+			if (node == nodes.end()) { break; }
+			laneNodes.push_back(node - nodes.begin());
 		}
-		m_workers.push_back( wt );
+		AudioEngineWorkerThread::setLaneNodes(laneNodes);
+	}
+	m_nodeJobs.assign(AudioEngineWorkerThread::numNodes(), 0);
+
+	for( int i = 0; i < m_numWorkers; ++i )
+	{
+		m_workers[i]->start( QThread::TimeCriticalPriority );
+	}
+	for( int i = m_numWorkers; i < m_numWorkers + m_numRenderWorkers; ++i )
+	{
+		m_workers[i]->start();
 	}
 }
 
@@ -154,32 +272,26 @@ AudioEngine::AudioEngine( bool renderOnly ) :
 
 AudioEngine::~AudioEngine()
 {
-	for( int w = 0; w < m_numWorkers; ++w )
+	for( int w = 0; w < m_numWorkers + m_numRenderWorkers; ++w )
 	{
 		m_workers[w]->quit();
 	}
 
+	// wakes the offline workers too, so they notice they quit
+	AudioEngineWorkerThread::setRenderingOffline(true);
 	AudioEngineWorkerThread::startAndWaitForJobs();
 
-	for( int w = 0; w < m_numWorkers; ++w )
+	for( int w = 0; w < m_numWorkers + m_numRenderWorkers; ++w )
 	{
 		m_workers[w]->wait( 500 );
 	}
 
-	while( m_fifo->available() )
-	{
-		delete[] m_fifo->read();
-	}
 	delete m_fifo;
 
+	m_midiClient->stopOutScheduler();
 	delete m_midiClient;
 	delete m_audioDev;
 
-
-	for (const auto& input : m_inputBuffer)
-	{
-		delete[] input;
-	}
 }
 
 
@@ -206,6 +318,10 @@ void AudioEngine::initDevices()
 
 void AudioEngine::startProcessing(bool needsFifo)
 {
+	// Drivers rendering in their own callback don't need the FIFO thread,
+	// a period is heard as soon as it is rendered then
+	if (m_audioDev->rendersInCallback()) { needsFifo = false; }
+
 	if (needsFifo)
 	{
 		m_fifoWriter = new fifoWriter( this, m_fifo );
@@ -251,29 +367,8 @@ bool AudioEngine::criticalXRuns() const
 
 void AudioEngine::pushInputFrames( SampleFrame* _ab, const f_cnt_t _frames )
 {
-	requestChangeInModel();
-
-	f_cnt_t frames = m_inputBufferFrames[ m_inputBufferWrite ];
-	auto size = m_inputBufferSize[m_inputBufferWrite];
-	SampleFrame* buf = m_inputBuffer[ m_inputBufferWrite ];
-
-	if( frames + _frames > size )
-	{
-		size = std::max(size * 2, frames + _frames);
-		auto ab = new SampleFrame[size];
-		memcpy( ab, buf, frames * sizeof( SampleFrame ) );
-		delete [] buf;
-
-		m_inputBufferSize[ m_inputBufferWrite ] = size;
-		m_inputBuffer[ m_inputBufferWrite ] = ab;
-
-		buf = ab;
-	}
-
-	memcpy( &buf[ frames ], _ab, _frames * sizeof( SampleFrame ) );
-	m_inputBufferFrames[ m_inputBufferWrite ] += _frames;
-
-	doneChangeInModel();
+	// if the engine stopped reading, the frames which don't fit are dropped
+	m_inputRing.write( _ab, _frames );
 }
 
 
@@ -289,25 +384,11 @@ void AudioEngine::renderStageNoteSetup()
 	}
 
 	// remove all play-handles that have to be deleted and delete
-	// them if they still exist...
-	// maybe this algorithm could be optimized...
-	ConstPlayHandleList::Iterator it_rem = m_playHandlesToRemove.begin();
-	while( it_rem != m_playHandlesToRemove.end() )
+	// them if they still exist
+	while (!m_playHandlesToRemove.empty())
 	{
-		PlayHandleList::Iterator it = std::find( m_playHandles.begin(), m_playHandles.end(), *it_rem );
-
-		if( it != m_playHandles.end() )
-		{
-			(*it)->audioBusHandle()->removePlayHandle(*it);
-			if((*it)->type() == PlayHandle::Type::NotePlayHandle)
-			{
-				NotePlayHandleManager::release((NotePlayHandle*)*it);
-			}
-			else delete *it;
-			m_playHandles.erase(it);
-		}
-
-		it_rem = m_playHandlesToRemove.erase( it_rem );
+		const auto handle = const_cast<PlayHandle*>(m_playHandlesToRemove.takeLast());
+		if (m_playHandles.contains(handle)) { deletePlayHandle(handle); }
 	}
 
 	swapBuffers();
@@ -316,68 +397,175 @@ void AudioEngine::renderStageNoteSetup()
 	Mixer * mixer = Engine::mixer();
 	mixer->prepareMasterMix();
 
+	// let the input be heard in the period it was captured in
+	const int monitorChannel = m_inputMonitorChannel;
+	if( monitorChannel >= 0 && monitorChannel < mixer->numChannels() && m_inputBufferFrames > 0 )
+	{
+		mixer->mixToChannel( m_inputBuffer.get(), monitorChannel );
+	}
+
 	// create play-handles for new notes, samples etc.
 	Engine::getSong()->processNextBuffer();
 
 	// add all play-handles that have to be added
+	const auto firstNewHandle = m_playHandles.size();
 	for( LocklessListElement * e = m_newPlayHandles.popList(); e; )
 	{
-		m_playHandles += e->value;
+		m_playHandles.add(e->value);
+		m_playHandlesOfType[PlayHandle::typeIndex(e->value->type())].add(e->value);
 		LocklessListElement * next = e->next;
 		m_newPlayHandles.free( e );
 		e = next;
 	}
+	if (m_deterministic)
+	{
+		// the worker threads add sub-notes in whichever order they finish
+		m_playHandles.sort(firstNewHandle,
+			[](const PlayHandle* a, const PlayHandle* b) { return a->order() < b->order(); });
+	}
+
+	NotePlayHandleManager::stealVoices(m_playHandles.handles());
 }
 
 
 
-void AudioEngine::renderStageInstruments()
+void AudioEngine::renderStageProcessing()
 {
 	AudioEngineProfiler::Probe profilerProbe(m_profiler, AudioEngineProfiler::DetailType::Instruments);
 
-	AudioEngineWorkerThread::fillJobQueue(m_playHandles);
-	AudioEngineWorkerThread::startAndWaitForJobs();
-}
+	// run play handles, effect chains of all instrument- and sampletracks
+	// and mixer channels as one dependency graph: an audio bus
+	// handle gets queued as soon as all of its play handles are done, and a
+	// mixer channel as soon as all of its bus handles and senders are done
+	AudioEngineWorkerThread::resetJobQueue(AudioEngineWorkerThread::JobQueue::OperationMode::Dynamic);
+
+	// a play handle may still refer to a bus handle that isn't registered,
+	// e.g. of a track being set up or removed, which has to be waited for
+	// all the same
+	++m_schedulingPeriod;
+	m_scheduledBusHandles.assign(m_audioBusHandles.begin(), m_audioBusHandles.end());
+	for (AudioBusHandle* busHandle : m_scheduledBusHandles)
+	{
+		busHandle->m_scheduledPeriod = m_schedulingPeriod;
+	}
+	for (PlayHandle* handle : m_playHandles)
+	{
+		AudioBusHandle* busHandle = handle->audioBusHandle();
+		if (busHandle && busHandle->m_scheduledPeriod != m_schedulingPeriod)
+		{
+			busHandle->m_scheduledPeriod = m_schedulingPeriod;
+			m_scheduledBusHandles.push_back(busHandle);
+		}
+	}
 
+	Engine::mixer()->scheduleChannels(m_scheduledBusHandles);
 
+	// on hosts with several NUMA nodes, the tracks are split among the nodes
+	// and the jobs of each track are spread among the workers of its node,
+	// so only mixing their output crosses nodes
+	std::fill(m_nodeJobs.begin(), m_nodeJobs.end(), 0);
+	std::size_t node = 0;
+	for (AudioBusHandle* busHandle : m_scheduledBusHandles)
+	{
+		busHandle->beginPeriod();
+		// the handles are scheduled in the same order in every render
+		busHandle->m_randomKey = node;
+		busHandle->m_node = node++ % m_nodeJobs.size();
+	}
+	const auto laneOf = [this](const AudioBusHandle* busHandle, std::size_t& lane) {
+		return busHandle ? AudioEngineWorkerThread::nodeLane(busHandle->m_node, m_nodeJobs[busHandle->m_node]++)
+			: lane++;
+	};
 
-void AudioEngine::renderStageEffects()
-{
-	AudioEngineProfiler::Probe profilerProbe(m_profiler, AudioEngineProfiler::DetailType::Effects);
+	std::size_t lane = 0;
+	for (PlayHandle* handle : m_playHandles)
+	{
+		AudioBusHandle* busHandle = handle->audioBusHandle();
+		if (busHandle) { busHandle->addPendingPlayHandle(); }
 
-	// STAGE 2: process effects of all instrument- and sampletracks
-	AudioEngineWorkerThread::fillJobQueue(m_audioBusHandles);
-	AudioEngineWorkerThread::startAndWaitForJobs();
+		if (handle->type() == PlayHandle::Type::NotePlayHandle && handle->requiresProcessing())
+		{
+			// notes of instruments batching them are rendered by one job per track
+			auto note = static_cast<NotePlayHandle*>(handle);
+			if (InstrumentTrack* track = note->instrumentTrack(); track->batchesNotes())
+			{
+				if (track->noteBatch().add(note))
+				{
+					m_noteBatches.emplace_back(&track->noteBatch(), laneOf(busHandle, lane));
+				}
+				continue;
+			}
+		}
+
+		if (!AudioEngineWorkerThread::addJob(handle, laneOf(busHandle, lane)) && busHandle)
+		{
+			// handle doesn't need processing, so it won't notify its bus handle
+			busHandle->playHandleProcessed();
+		}
+	}
 
-	// removed all play handles which are done
-	for( PlayHandleList::Iterator it = m_playHandles.begin();
-						it != m_playHandles.end(); )
+	for (const auto& [batch, batchLane] : m_noteBatches)
 	{
-		if( ( *it )->affinityMatters() &&
-			( *it )->affinity() != QThread::currentThread() )
+		if (!AudioEngineWorkerThread::addJob(batch, batchLane))
 		{
-			++it;
-			continue;
+			// the notes have to notify their bus handle anyway
+			batch->queue();
+			batch->process();
 		}
-		if( ( *it )->isFinished() )
+	}
+	m_noteBatches.clear();
+
+	// drop the references held while queueing, which queues all bus handles
+	// without any (remaining) play handles
+	for (AudioBusHandle* busHandle : m_scheduledBusHandles)
+	{
+		busHandle->playHandleProcessed();
+	}
+
+	AudioEngineWorkerThread::startAndWaitForJobs();
+
+	removeFinishedPlayHandles();
+}
+
+
+
+void AudioEngine::removeFinishedPlayHandles()
+{
+	// backwards, as removing a handle moves the last one into its place
+	for (auto i = m_playHandles.size(); i-- > 0;)
+	{
+		PlayHandle* handle = m_playHandles[i];
+		if (handle->affinityMatters() && handle->affinity() != QThread::currentThread())
 		{
-			(*it)->audioBusHandle()->removePlayHandle(*it);
-			if((*it)->type() == PlayHandle::Type::NotePlayHandle)
-			{
-				NotePlayHandleManager::release((NotePlayHandle*)*it);
-			}
-			else delete *it;
-			it = m_playHandles.erase(it);
+			continue;
 		}
-		else
+		if (handle->isFinished())
 		{
-			++it;
+			deletePlayHandle(handle);
 		}
 	}
 }
 
 
 
+
+void AudioEngine::deletePlayHandle(PlayHandle* handle)
+{
+	handle->audioBusHandle()->removePlayHandle(handle);
+	m_playHandles.remove(handle);
+	m_playHandlesOfType[PlayHandle::typeIndex(handle->type())].remove(handle);
+	// it mustn't be found there once it's gone
+	if (!m_playHandlesToRemove.empty()) { m_playHandlesToRemove.removeAll(handle); }
+
+	if (handle->type() == PlayHandle::Type::NotePlayHandle)
+	{
+		NotePlayHandleManager::release(static_cast<NotePlayHandle*>(handle));
+	}
+	else { delete handle; }
+}
+
+
+
 void AudioEngine::renderStageMix()
 {
 	AudioEngineProfiler::Probe profilerProbe(m_profiler, AudioEngineProfiler::DetailType::Mixing);
@@ -385,14 +573,34 @@ void AudioEngine::renderStageMix()
 	Mixer *mixer = Engine::mixer();
 	mixer->masterMix(m_outputBufferWrite.get());
 
-	MixHelpers::multiply(m_outputBufferWrite.get(), m_masterGain, m_framesPerPeriod);
+	const fpp_t frames = framesPerPeriod();
+	MixHelpers::multiply(m_outputBufferWrite.get(), m_masterGain, frames);
 
-	emit nextAudioBuffer(m_outputBufferRead.get());
+	// whole periods only, if the displays haven't read for a while this one is dropped
+	if (m_displayed.load(std::memory_order_relaxed) && m_displayRing.free() >= frames)
+	{
+		m_displayRing.write(m_outputBufferWrite.get(), frames);
+	}
 
 	// and trigger LFOs
 	EnvelopeAndLfoParameters::instances()->trigger();
-	Controller::triggerFrameCounter();
-	AutomatableModel::incrementPeriodCounter();
+	Controller::triggerFrameCounter(frames);
+	AutomatableModel::incrementPeriodCounter(frames);
+}
+
+
+
+bool AudioEngine::readDisplayBuffer(SampleFrame* buffer)
+{
+	// right after the period size changed, the latest frames may span periods
+	// of both sizes, which is good enough for displaying them
+	const fpp_t frames = framesPerPeriod();
+	const auto periods = m_displayRingReader.read_space() / frames;
+	if (periods == 0) { return false; }
+
+	m_displayRingReader.read((periods - 1) * frames);
+	m_displayRingReader.read(frames).copy(buffer, frames);
+	return true;
 }
 
 
@@ -401,16 +609,35 @@ const SampleFrame* AudioEngine::renderNextBuffer()
 {
 	const auto lock = std::lock_guard{m_changeMutex};
 
+	// before checking for realtime violations, as signalling the change allocates
+	updateFramesPerPeriod();
+
+	const auto realtime = RealtimeChecker::Scope{};
+	// whichever thread renders, e.g. the one of the audio device or of an export
+	disable_denormals();
+	AudioEngineWorkerThread::setRenderingOffline(Engine::getSong()->isExporting());
 	m_profiler.startPeriod();
 	s_renderingThread = true;
+	AudioEngineWorkerThread::setRenderingThread(true);
+	seedRandom(RandomDomain::Engine, 0);
+
+	// MIDI input received during the last period, before the notes get set up
+	if (m_midiClient)
+	{
+		m_midiClient->processQueuedInEvents(framesPerPeriod(), outputSampleRate());
+	}
 
 	renderStageNoteSetup();     // STAGE 0: clear old play handles and buffers, setup new play handles
-	renderStageInstruments();   // STAGE 1: run and render all play handles
-	renderStageEffects();       // STAGE 2: process effects of all instrument- and sampletracks
-	renderStageMix();           // STAGE 3: do master mix in mixer
+	renderStageProcessing();    // STAGE 1: run play handles, effects of all tracks and mixer channels
+	renderStageMix();           // STAGE 2: do master mix in mixer
 
 	s_renderingThread = false;
-	m_profiler.finishPeriod(outputSampleRate(), m_framesPerPeriod);
+	AudioEngineWorkerThread::setRenderingThread(false);
+	if (m_profiler.finishPeriod(outputSampleRate(), framesPerPeriod())
+		&& m_xrunRecorder && !Engine::getSong()->isExporting())
+	{
+		recordXRun();
+	}
 
 	return m_outputBufferRead.get();
 }
@@ -418,14 +645,130 @@ const SampleFrame* AudioEngine::renderNextBuffer()
 
 
 
+void AudioEngine::seedRandom(RandomDomain domain, std::uint64_t key) const
+{
+	if (!m_deterministic) { return; }
+
+	// splitmix64, so neighbouring keys and periods get unrelated seeds
+	auto seed = key * 0x9e3779b97f4a7c15
+		+ static_cast<std::uint64_t>(domain) * 0xbf58476d1ce4e5b9
+		+ m_schedulingPeriod * 0x94d049bb133111eb;
+	seed = (seed ^ (seed >> 30)) * 0xbf58476d1ce4e5b9;
+	seed = (seed ^ (seed >> 27)) * 0x94d049bb133111eb;
+	seedFastRand(static_cast<unsigned long>(seed ^ (seed >> 31)));
+}
+
+
+
+
+AudioEngine::SharedRandomScope::SharedRandomScope(const AudioEngine* audioEngine, std::uint64_t key) :
+	m_seeded(audioEngine->isDeterministic()),
+	m_jobState(fastRandState())
+{
+	audioEngine->seedRandom(RandomDomain::Shared, key);
+}
+
+
+
+
+AudioEngine::SharedRandomScope::~SharedRandomScope()
+{
+	if (m_seeded) { fastRandState() = m_jobState; }
+}
+
+
+
+
+void AudioEngine::recordXRun()
+{
+	auto incident = XRunRecorder::Incident{};
+	incident.time = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+	incident.period = m_profiler.period();
+	incident.frames = framesPerPeriod();
+	incident.sampleRate = outputSampleRate();
+	incident.renderTime = m_profiler.periodTime();
+	incident.deadline = static_cast<int>(1000000ull * incident.frames / incident.sampleRate);
+	for (std::size_t i = 0; i < AudioEngineProfiler::DetailCount; ++i)
+	{
+		incident.stageTimes[i] = m_profiler.detailTime(static_cast<AudioEngineProfiler::DetailType>(i));
+	}
+	incident.slowestJobCount = m_profiler.slowestJobs(incident.slowestJobs);
+	incident.playHandles = static_cast<int>(m_playHandles.size());
+	incident.workers = numJobThreads();
+	incident.sleepingWorkers = AudioEngineWorkerThread::sleepingWorkers();
+	incident.deviceInterval = m_xrunRecorder->deviceInterval();
+	incident.deviceWait = m_xrunRecorder->deviceWait();
+	m_xrunRecorder->record(incident);
+}
+
+
+
+
+void AudioEngine::setFramesPerPeriod(fpp_t frames)
+{
+	m_requestedFramesPerPeriod.store(std::clamp(frames, MINIMUM_BUFFER_SIZE, m_maxFramesPerPeriod),
+		std::memory_order_relaxed);
+}
+
+
+
+
+void AudioEngine::setRecordingFramesPerPeriod(fpp_t frames)
+{
+	m_recordingFramesPerPeriod.store(frames, std::memory_order_relaxed);
+}
+
+
+
+
+void AudioEngine::updateFramesPerPeriod()
+{
+	const Song* song = Engine::getSong();
+	auto frames = m_requestedFramesPerPeriod.load(std::memory_order_relaxed);
+	const auto recordingFrames = m_recordingFramesPerPeriod.load(std::memory_order_relaxed);
+	if (song->isExporting() || m_framesPerPeriodHolds.load(std::memory_order_relaxed) > 0)
+	{
+		// files are encoded in periods of the same size
+		frames = m_maxFramesPerPeriod;
+	}
+	else if (song->isRecording() && recordingFrames > 0)
+	{
+		frames = std::min(frames, recordingFrames);
+	}
+	frames = std::clamp(frames, std::min(MINIMUM_BUFFER_SIZE, m_maxFramesPerPeriod), m_maxFramesPerPeriod);
+
+	if (frames == framesPerPeriod()) { return; }
+
+	// everything holding a period is allocated for the longest one, so the
+	// rest of the engine picks up the new size with the next period
+	m_framesPerPeriod.store(frames, std::memory_order_relaxed);
+	emit framesPerPeriodChanged();
+}
+
+
+
+
 void AudioEngine::swapBuffers()
 {
-	m_inputBufferWrite = (m_inputBufferWrite + 1) % 2;
-	m_inputBufferRead = (m_inputBufferRead + 1) % 2;
-	m_inputBufferFrames[m_inputBufferWrite] = 0;
+	// take at most one period of input, so that devices delivering larger
+	// or irregular blocks don't make the monitored input stutter
+	const auto available = static_cast<f_cnt_t>( m_inputRingReader.read_space() );
+	if( available > m_inputBacklogLimit )
+	{
+		// input piled up while we weren't rendering
+		m_inputRingReader.read( available - m_inputBacklogLimit );
+	}
+	const fpp_t frames = framesPerPeriod();
+	m_inputBufferFrames = std::min<f_cnt_t>( m_inputRingReader.read_space(), frames );
+	m_inputRingReader.read( m_inputBufferFrames ).copy( m_inputBuffer.get(), m_inputBufferFrames );
+	zeroSampleFrames( m_inputBuffer.get() + m_inputBufferFrames, frames - m_inputBufferFrames );
 
+	// the period mixed last may have had another size
 	std::swap(m_outputBufferRead, m_outputBufferWrite);
-	zeroSampleFrames(m_outputBufferWrite.get(), m_framesPerPeriod);
+	m_outputBufferReadFrames = m_outputBufferWriteFrames;
+	m_outputBufferWriteFrames = frames;
+	zeroSampleFrames(m_outputBufferWrite.get(), frames);
 }
 
 void AudioEngine::clear()
@@ -620,10 +963,8 @@ void AudioEngine::removePlayHandle(PlayHandle * ph)
 			}
 		}
 		// Now check m_playHandles
-		PlayHandleList::Iterator it = std::find(m_playHandles.begin(), m_playHandles.end(), ph);
-		if (it != m_playHandles.end())
+		if (m_playHandles.contains(ph))
 		{
-			m_playHandles.erase(it);
 			removedFromList = true;
 		}
 		// Only deleting PlayHandles that were actually found in the list
@@ -631,11 +972,7 @@ void AudioEngine::removePlayHandle(PlayHandle * ph)
 		// (See tobydox's 2008 commit 4583e48)
 		if ( removedFromList )
 		{
-			if (ph->type() == PlayHandle::Type::NotePlayHandle)
-			{
-				NotePlayHandleManager::release(dynamic_cast<NotePlayHandle*>(ph));
-			}
-			else { delete ph; }
+			deletePlayHandle(ph);
 		}
 	}
 	else
@@ -651,22 +988,18 @@ void AudioEngine::removePlayHandle(PlayHandle * ph)
 void AudioEngine::removePlayHandlesOfTypes(Track * track, PlayHandle::Types types)
 {
 	requestChangeInModel();
-	PlayHandleList::Iterator it = m_playHandles.begin();
-	while( it != m_playHandles.end() )
+	// only the handles of the given types are looked at
+	for (auto& handlesOfType : m_playHandlesOfType)
 	{
-		if ((*it)->isFromTrack(track) && ((*it)->type() & types))
+		if (handlesOfType.empty() || !(handlesOfType[0]->type() & types)) { continue; }
+
+		// backwards, as removing a handle moves the last one into its place
+		for (auto i = handlesOfType.size(); i-- > 0;)
 		{
-			(*it)->audioBusHandle()->removePlayHandle(*it);
-			if((*it)->type() == PlayHandle::Type::NotePlayHandle)
+			if (handlesOfType[i]->isFromTrack(track))
 			{
-				NotePlayHandleManager::release((NotePlayHandle*)*it);
+				deletePlayHandle(handlesOfType[i]);
 			}
-			else delete *it;
-			it = m_playHandles.erase(it);
-		}
-		else
-		{
-			++it;
 		}
 	}
 	doneChangeInModel();
@@ -705,6 +1038,14 @@ bool AudioEngine::isAudioDevNameValid(QString name)
 #endif
 
 
+#ifdef LMMS_HAVE_PIPEWIRE
+	if (name == AudioPipeWire::name())
+	{
+		return true;
+	}
+#endif
+
+
 #ifdef LMMS_HAVE_PULSEAUDIO
 	if (name == AudioPulseAudio::name())
 	{
@@ -774,6 +1115,13 @@ bool AudioEngine::isMidiDevNameValid(QString name)
 	}
 #endif
 
+#ifdef LMMS_HAVE_PIPEWIRE
+	if (name == MidiPipeWire::name())
+	{
+		return true;
+	}
+#endif
+
 #ifdef LMMS_HAVE_OSS
 	if (name == MidiOss::name())
 	{
@@ -850,6 +1198,20 @@ AudioDevice * AudioEngine::tryAudioDevices()
 #endif
 
 
+#ifdef LMMS_HAVE_PIPEWIRE
+	if( dev_name == AudioPipeWire::name() || dev_name == "" )
+	{
+		dev = new AudioPipeWire( success_ful, this );
+		if( success_ful )
+		{
+			m_audioDevName = AudioPipeWire::name();
+			return dev;
+		}
+		delete dev;
+	}
+#endif
+
+
 #ifdef LMMS_HAVE_PULSEAUDIO
 	if( dev_name == AudioPulseAudio::name() || dev_name == "" )
 	{
@@ -1003,6 +1365,19 @@ MidiClient * AudioEngine::tryMidiClients()
 	}
 #endif
 
+#ifdef LMMS_HAVE_PIPEWIRE
+	if( client_name == MidiPipeWire::name() || client_name == "" )
+	{
+		auto mpw = new MidiPipeWire;
+		if( mpw->isRunning() )
+		{
+			m_midiClientName = MidiPipeWire::name();
+			return mpw;
+		}
+		delete mpw;
+	}
+#endif
+
 #ifdef LMMS_HAVE_OSS
 	if( client_name == MidiOss::name() || client_name == "" )
 	{
@@ -1103,17 +1478,17 @@ void AudioEngine::fifoWriter::run()
 {
 	disable_denormals();
 
-	const fpp_t frames = m_audioEngine->framesPerPeriod();
 	while( m_writing )
 	{
-		auto buffer = new SampleFrame[frames];
+		SampleFrame* buffer = m_fifo->writeBuffer();
 		const SampleFrame* b = m_audioEngine->renderNextBuffer();
+		const fpp_t frames = m_audioEngine->m_outputBufferReadFrames;
 		memcpy(buffer, b, frames * sizeof(SampleFrame));
-		m_fifo->write(buffer);
+		m_fifo->commit(frames);
 	}
 
 	// Let audio backend stop processing
-	m_fifo->write(nullptr);
+	m_fifo->commitEnd();
 	m_fifo->waitUntilRead();
 }
 
@@ -24,6 +24,7 @@
 
 #include "AudioEngineProfiler.h"
 
+#include <algorithm>
 #include <cstdint>
 
 namespace lmms
@@ -32,16 +33,26 @@ namespace lmms
 AudioEngineProfiler::AudioEngineProfiler() :
 	m_periodTimer(),
 	m_cpuLoad( 0 ),
-	m_outputFile()
+	m_outputFile(),
+	m_jobLanes(std::make_unique<JobLane[]>(MaxTraceLanes))
 {
 }
 
 
 
-void AudioEngineProfiler::finishPeriod( sample_rate_t sampleRate, fpp_t framesPerPeriod )
+
+AudioEngineProfiler::~AudioEngineProfiler()
+{
+	stopTracing();
+}
+
+
+
+bool AudioEngineProfiler::finishPeriod( sample_rate_t sampleRate, fpp_t framesPerPeriod )
 {
 	// Time taken to process all data and fill the audio buffer.
 	const unsigned int periodElapsed = m_periodTimer.elapsed();
+	m_periodTime = static_cast<int>(periodElapsed);
 	// Maximum time the processing can take before causing buffer underflow. Convert to us.
 	const uint64_t timeLimit = static_cast<uint64_t>(1000000) * framesPerPeriod / sampleRate;
 
@@ -57,12 +68,19 @@ void AudioEngineProfiler::finishPeriod( sample_rate_t sampleRate, fpp_t framesPe
 		const auto newLoad = 100.f * m_detailTime[i] / timeLimit;
 		const auto oldLoad = m_detailLoad[i].load(std::memory_order_relaxed);
 		m_detailLoad[i].store(newLoad * 0.05f + oldLoad * 0.95f, std::memory_order_relaxed);
+		m_totals.detailTime[i] += m_detailTime[i];
 	}
 
+	++m_totals.periods;
+	m_totals.frames += framesPerPeriod;
+	m_totals.periodTime += periodElapsed;
+
 	if( m_outputFile.isOpen() )
 	{
 		m_outputFile.write( QString( "%1\n" ).arg( periodElapsed ).toLatin1() );
 	}
+
+	return periodElapsed > timeLimit;
 }
 
 
@@ -74,4 +92,286 @@ void AudioEngineProfiler::setOutputFile( const QString& outputFile )
 	m_outputFile.open( QFile::WriteOnly | QFile::Truncate );
 }
 
+
+
+
+const char* AudioEngineProfiler::detailName(DetailType type)
+{
+	switch (type)
+	{
+		case DetailType::NoteSetup: return "Note setup";
+		case DetailType::Instruments: return "Instruments and effects";
+		case DetailType::Mixing: return "Mixing";
+		default: return "Unknown";
+	}
+}
+
+
+
+
+bool AudioEngineProfiler::startTracing(const QString& outputFile)
+{
+	stopTracing();
+
+	m_traceFile.setFileName(outputFile);
+	if (!m_traceFile.open(QFile::WriteOnly | QFile::Truncate))
+	{
+		return false;
+	}
+	m_traceFile.write("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+	m_firstTraceEvent = true;
+
+	m_traceLanes = std::make_unique<TraceLane[]>(MaxTraceLanes);
+	m_usedTraceLanes = 0;
+	m_droppedTraceEvents = 0;
+	m_traceStart = std::chrono::steady_clock::now();
+	m_traceGeneration.fetch_add(1, std::memory_order_relaxed);
+	m_traceWriterQuit = false;
+	m_traceWriter = std::thread(&AudioEngineProfiler::traceWriter, this);
+
+	m_tracing.store(true, std::memory_order_release);
+	return true;
+}
+
+
+
+
+void AudioEngineProfiler::stopTracing()
+{
+	if (!m_traceWriter.joinable())
+	{
+		return;
+	}
+
+	m_tracing.store(false, std::memory_order_seq_cst);
+	// wait for threads which are just recording an event
+	while (m_activeTraceRecorders.load(std::memory_order_seq_cst) > 0)
+	{
+		std::this_thread::yield();
+	}
+
+	m_traceWriterQuit = true;
+	m_traceWriter.join();
+	drainTrace();
+
+	m_traceFile.write(QString("\n],\"otherData\":{\"droppedEvents\":%1}}\n")
+		.arg(m_droppedTraceEvents.load()).toLatin1());
+	m_traceFile.close();
+	m_traceLanes.reset();
+}
+
+
+
+
+AudioEngineProfiler::TraceLane* AudioEngineProfiler::currentTraceLane()
+{
+	struct LaneCache
+	{
+		const AudioEngineProfiler* owner = nullptr;
+		unsigned generation = 0;
+		TraceLane* lane = nullptr;
+	};
+	thread_local LaneCache cache;
+
+	const auto generation = m_traceGeneration.load(std::memory_order_relaxed);
+	if (cache.owner != this || cache.generation != generation)
+	{
+		const auto index = m_usedTraceLanes.fetch_add(1, std::memory_order_relaxed);
+		cache.owner = this;
+		cache.generation = generation;
+		cache.lane = index < MaxTraceLanes ? &m_traceLanes[index] : nullptr;
+	}
+	return cache.lane;
+}
+
+
+
+
+AudioEngineProfiler::JobLane* AudioEngineProfiler::currentJobLane()
+{
+	struct LaneCache
+	{
+		const AudioEngineProfiler* owner = nullptr;
+		JobLane* lane = nullptr;
+	};
+	thread_local LaneCache cache;
+
+	if (cache.owner != this)
+	{
+		const auto index = m_usedJobLanes.fetch_add(1, std::memory_order_relaxed);
+		cache.owner = this;
+		cache.lane = index < MaxTraceLanes ? &m_jobLanes[index] : nullptr;
+	}
+	return cache.lane;
+}
+
+
+
+
+namespace
+{
+
+//! Inserts @p job into the @p count jobs sorted by descending duration, dropping the fastest one if full
+void insertSlowest(AudioEngineProfiler::SlowestJobs& jobs, std::size_t& count, const AudioEngineProfiler::JobTime& job)
+{
+	if (count == jobs.size() && job.duration <= jobs.back().duration) { return; }
+
+	auto i = count < jobs.size() ? count++ : jobs.size() - 1;
+	for (; i > 0 && jobs[i - 1].duration < job.duration; --i)
+	{
+		jobs[i] = jobs[i - 1];
+	}
+	jobs[i] = job;
+}
+
+} // namespace
+
+
+
+
+void AudioEngineProfiler::addJobTime(const JobTime& job)
+{
+	JobLane* lane = currentJobLane();
+	if (!lane) { return; }
+
+	// the first job of a period on this thread starts over
+	const auto period = m_period.load(std::memory_order_relaxed);
+	if (lane->period != period)
+	{
+		lane->period = period;
+		lane->count = 0;
+	}
+	insertSlowest(lane->jobs, lane->count, job);
+}
+
+
+
+
+std::size_t AudioEngineProfiler::slowestJobs(SlowestJobs& jobs) const
+{
+	const auto period = m_period.load(std::memory_order_relaxed);
+	const auto usedLanes = std::min(m_usedJobLanes.load(std::memory_order_relaxed), MaxTraceLanes);
+
+	auto count = std::size_t{0};
+	for (std::size_t i = 0; i < usedLanes; ++i)
+	{
+		const JobLane& lane = m_jobLanes[i];
+		if (lane.period != period) { continue; }
+		for (std::size_t j = 0; j < lane.count; ++j)
+		{
+			insertSlowest(jobs, count, lane.jobs[j]);
+		}
+	}
+	return count;
+}
+
+
+
+
+void AudioEngineProfiler::addTraceEvent(const char* category, const char* name, std::uintptr_t id, std::int64_t begin)
+{
+	if (m_timingJobs.load(std::memory_order_relaxed))
+	{
+		addJobTime(JobTime{category, name, id, traceClock() - begin});
+	}
+	if (!m_tracing.load(std::memory_order_relaxed)) { return; }
+
+	m_activeTraceRecorders.fetch_add(1, std::memory_order_seq_cst);
+	if (m_tracing.load(std::memory_order_seq_cst))
+	{
+		TraceLane* lane = currentTraceLane();
+		const auto write = lane ? lane->writeIndex.load(std::memory_order_relaxed) : 0;
+		if (lane && write - lane->readIndex.load(std::memory_order_acquire) < TraceLane::Size)
+		{
+			lane->events[write % TraceLane::Size] = TraceEvent{category, name, id, begin, traceClock()};
+			lane->writeIndex.store(write + 1, std::memory_order_release);
+		}
+		else
+		{
+			m_droppedTraceEvents.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+	m_activeTraceRecorders.fetch_sub(1, std::memory_order_seq_cst);
+}
+
+
+
+
+namespace
+{
+
+QByteArray jsonString(const char* text)
+{
+	QByteArray out = "\"";
+	for (const char* c = text ? text : ""; *c; ++c)
+	{
+		switch (*c)
+		{
+			case '"': out += "\\\""; break;
+			case '\\': out += "\\\\"; break;
+			default:
+				if (static_cast<unsigned char>(*c) < 0x20)
+				{
+					out += QString::asprintf("\\u%04x", *c).toLatin1();
+				}
+				else
+				{
+					out += *c;
+				}
+		}
+	}
+	return out + "\"";
+}
+
+} // namespace
+
+
+
+
+void AudioEngineProfiler::drainTrace()
+{
+	const auto usedLanes = std::min(m_usedTraceLanes.load(std::memory_order_relaxed), MaxTraceLanes);
+	for (std::size_t i = 0; i < usedLanes; ++i)
+	{
+		TraceLane& lane = m_traceLanes[i];
+		auto read = lane.readIndex.load(std::memory_order_relaxed);
+		const auto write = lane.writeIndex.load(std::memory_order_acquire);
+
+		// name the thread once the first event of it shows up
+		if (read == 0 && write > 0)
+		{
+			m_traceFile.write(QString("%1{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%2,"
+				"\"args\":{\"name\":\"Audio thread %2\"}}")
+				.arg(m_firstTraceEvent ? "" : ",\n").arg(i).toLatin1());
+			m_firstTraceEvent = false;
+		}
+
+		for (; read != write; ++read)
+		{
+			const TraceEvent& e = lane.events[read % TraceLane::Size];
+			m_traceFile.write(m_firstTraceEvent ? "{" : ",\n{");
+			m_traceFile.write("\"name\":" + jsonString(e.name) + ",\"cat\":" + jsonString(e.category));
+			m_traceFile.write(QString(",\"ph\":\"X\",\"pid\":1,\"tid\":%1,\"ts\":%2,\"dur\":%3,\"args\":{\"id\":%4}}")
+				.arg(i)
+				.arg(e.begin / 1000.0, 0, 'f', 3)
+				.arg((e.end - e.begin) / 1000.0, 0, 'f', 3)
+				.arg(static_cast<qulonglong>(e.id)).toLatin1());
+			m_firstTraceEvent = false;
+		}
+		lane.readIndex.store(read, std::memory_order_release);
+	}
+}
+
+
+
+
+void AudioEngineProfiler::traceWriter()
+{
+	while (!m_traceWriterQuit.load())
+	{
+		drainTrace();
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	}
+}
+
 } // namespace lmms
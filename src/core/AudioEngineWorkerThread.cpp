@@ -28,8 +28,14 @@
 #include <QMutex>
 #include <QWaitCondition>
 
+#include <algorithm>
+#include <limits>
+
 #include "denormals.h"
 #include "AudioEngine.h"
+#include "RealtimeChecker.h"
+#include "RealtimeMemory.h"
+#include "RealtimeThread.h"
 #include "ThreadableJob.h"
 
 #if __SSE__
@@ -41,56 +47,255 @@ namespace lmms
 
 AudioEngineWorkerThread::JobQueue AudioEngineWorkerThread::globalJobQueue;
 QWaitCondition * AudioEngineWorkerThread::queueReadyWaitCond = nullptr;
+QWaitCondition * AudioEngineWorkerThread::offlineReadyWaitCond = nullptr;
 QList<AudioEngineWorkerThread *> AudioEngineWorkerThread::workerThreads;
+std::atomic_int AudioEngineWorkerThread::s_realtimePriority = 0;
+std::atomic_bool AudioEngineWorkerThread::s_renderingOffline = false;
+std::atomic<std::uint32_t> AudioEngineWorkerThread::s_generation = 0;
+std::atomic_int AudioEngineWorkerThread::s_sleepingWorkers = 0;
+std::atomic_int AudioEngineWorkerThread::s_sleepingOfflineWorkers = 0;
+std::chrono::microseconds AudioEngineWorkerThread::s_spinTime{50};
+int AudioEngineWorkerThread::s_configuredPriority = 0;
+RealtimePolicy AudioEngineWorkerThread::s_realtimePolicy = RealtimePolicy::Fifo;
+
+namespace
+{
+
+// lane of the current thread, if it's a worker thread
+constexpr std::size_t NoLane = std::numeric_limits<std::size_t>::max();
+// the thread rendering, which processes the last worker "inline"
+constexpr std::size_t InlineLane = NoLane - 1;
+thread_local std::size_t s_currentLane = NoLane;
+
+// marks a slot whose job has already been claimed by some thread
+ThreadableJob* const s_takenJob = reinterpret_cast<ThreadableJob*>(std::uintptr_t{1});
+
+constexpr std::uint64_t makeHint(std::uint32_t epoch, std::size_t index)
+{
+	return (static_cast<std::uint64_t>(epoch) << 32) | static_cast<std::uint32_t>(index);
+}
+
+} // namespace
+
+
 
 // implementation of internal JobQueue
+AudioEngineWorkerThread::JobQueue::Lane::Lane() :
+	m_writeIndex( 0 ),
+	m_itemsDone( 0 ),
+	m_readHint( 0 )
+{
+	std::fill(m_items, m_items + JOB_QUEUE_SIZE, nullptr);
+}
+
+
+
+
+ThreadableJob* AudioEngineWorkerThread::JobQueue::Lane::take()
+{
+	auto hint = m_readHint.load(std::memory_order_acquire);
+	const auto epoch = static_cast<std::uint32_t>(hint >> 32);
+	const auto end = std::min(m_writeIndex.load(std::memory_order_acquire), JOB_QUEUE_SIZE);
+
+	for (auto i = std::size_t{static_cast<std::uint32_t>(hint)}; i < end; ++i)
+	{
+		ThreadableJob* job = m_items[i].load(std::memory_order_acquire);
+		if (job == nullptr || job == s_takenJob) { continue; }
+
+		// a slot may already contain a job of the next period while our view
+		// of this lane is stale - only claim jobs which have been published
+		if (i >= m_writeIndex.load(std::memory_order_acquire)) { return nullptr; }
+
+		if (m_items[i].compare_exchange_strong(job, s_takenJob, std::memory_order_acq_rel))
+		{
+			// advance the hint, unless the queue has been reset meanwhile
+			const auto newHint = makeHint(epoch, i + 1);
+			while (static_cast<std::uint32_t>(hint >> 32) == epoch && hint < newHint
+				&& !m_readHint.compare_exchange_weak(hint, newHint, std::memory_order_acq_rel)) {}
+			return job;
+		}
+	}
+	return nullptr;
+}
+
+
+
+
+void AudioEngineWorkerThread::JobQueue::setNumLanes( size_t _numLanes )
+{
+	while (m_lanes.size() < _numLanes + 1)
+	{
+		m_lanes.push_back(std::make_unique<Lane>());
+	}
+	updateStealOrder();
+	reset(m_opMode);
+}
+
+
+
+
+void AudioEngineWorkerThread::JobQueue::setLaneNodes( const std::vector<size_t>& _nodes )
+{
+	m_laneNodes = _nodes;
+	m_nodeLanes.clear();
+
+	// nodes without any lane are left out
+	auto nodeIndices = std::vector<size_t>{};
+	for (auto lane = std::size_t{0}; lane < m_laneNodes.size(); ++lane)
+	{
+		auto node = std::find(nodeIndices.begin(), nodeIndices.end(), m_laneNodes[lane]);
+		if (node == nodeIndices.end())
+		{
+			nodeIndices.push_back(m_laneNodes[lane]);
+			m_nodeLanes.emplace_back();
+			node = nodeIndices.end() - 1;
+		}
+		m_laneNodes[lane] = node - nodeIndices.begin();
+		m_nodeLanes[m_laneNodes[lane]].push_back(lane);
+	}
+	updateStealOrder();
+}
+
+
+
+
+size_t AudioEngineWorkerThread::JobQueue::nodeLane( size_t _node, size_t _index ) const
+{
+	if (m_nodeLanes.empty()) { return _index; }
+
+	const auto& lanes = m_nodeLanes[_node % m_nodeLanes.size()];
+	return lanes[_index % lanes.size()];
+}
+
+
+
+
+void AudioEngineWorkerThread::JobQueue::updateStealOrder()
+{
+	// every lane is visited in turn after the own one, starting with the
+	// lanes of the own node, so jobs only move between nodes once all lanes
+	// of a node ran dry
+	const auto nodeOf = [this](size_t lane) {
+		return lane < m_laneNodes.size() ? m_laneNodes[lane] : std::numeric_limits<size_t>::max();
+	};
+
+	m_stealOrder.assign(m_lanes.size(), {});
+	for (auto own = std::size_t{0}; own < m_lanes.size(); ++own)
+	{
+		auto& order = m_stealOrder[own];
+		for (const bool sameNode : {true, false})
+		{
+			for (auto i = std::size_t{0}; i < m_lanes.size(); ++i)
+			{
+				const auto lane = (own + i) % m_lanes.size();
+				if ((nodeOf(lane) == nodeOf(own)) == sameNode) { order.push_back(lane); }
+			}
+		}
+	}
+}
+
+
+
+
 void AudioEngineWorkerThread::JobQueue::reset( OperationMode _opMode )
 {
-	m_writeIndex = 0;
-	m_itemsDone = 0;
+	++m_epoch;
+	for (auto& lane : m_lanes)
+	{
+		lane->m_writeIndex.store(0, std::memory_order_release);
+		lane->m_itemsDone.store(0, std::memory_order_release);
+		lane->m_readHint.store(makeHint(m_epoch, 0), std::memory_order_release);
+	}
 	m_opMode = _opMode;
 }
 
 
 
 
-void AudioEngineWorkerThread::JobQueue::addJob( ThreadableJob * _job )
+bool AudioEngineWorkerThread::JobQueue::addJob( ThreadableJob * _job )
 {
-	if( _job->requiresProcessing() )
+	if (m_lanes.empty()) { return false; }
+	return push(_job, currentLane());
+}
+
+
+
+
+bool AudioEngineWorkerThread::JobQueue::addJob( ThreadableJob * _job, size_t _lane )
+{
+	if (m_lanes.empty()) { return false; }
+	// spread over the lanes of the workers, not the shared one
+	return push(_job, _lane % (m_lanes.size() - 1));
+}
+
+
+
+
+bool AudioEngineWorkerThread::JobQueue::push( ThreadableJob * _job, size_t _lane )
+{
+	if( !_job->requiresProcessing() )
+	{
+		return false;
+	}
+
+	// every lane but the shared one has a single writer at a time, so
+	// publishing the job only requires ordering the slot before the write index
+	const bool shared = _lane == sharedLane();
+	if (shared)
+	{
+		while (m_sharedLaneLock.test_and_set(std::memory_order_acquire))
+		{
+#ifdef __SSE__
+			_mm_pause();
+#endif
+		}
+	}
+
+	Lane& lane = *m_lanes[_lane];
+	const auto index = lane.m_writeIndex.load(std::memory_order_relaxed);
+	const bool queued = index < JOB_QUEUE_SIZE;
+	if (queued)
 	{
 		// update job state
 		_job->queue();
-		// actually queue the job via atomic operations
-		auto index = m_writeIndex++;
-		if (index < JOB_QUEUE_SIZE) {
-			m_items[index] = _job;
-		} else {
-			qWarning() << "Job queue is full!";
-			++m_itemsDone;
-		}
+		lane.m_items[index].store(_job, std::memory_order_release);
+		lane.m_writeIndex.store(index + 1, std::memory_order_release);
 	}
+
+	if (shared) { m_sharedLaneLock.clear(std::memory_order_release); }
+
+	if (!queued) { qWarning() << "Job queue is full!"; }
+	return queued;
 }
 
 
 
 void AudioEngineWorkerThread::JobQueue::run()
 {
-	bool processedJob = true;
-	while (processedJob && m_itemsDone < m_writeIndex)
+	if (m_lanes.empty()) { return; }
+
+	const auto ownLane = currentLane();
+	auto& itemsDone = m_lanes[ownLane]->m_itemsDone;
+
+	while (true)
 	{
-		processedJob = false;
-		for (auto i = std::size_t{0}; i < m_writeIndex && i < JOB_QUEUE_SIZE; ++i)
+		if (ThreadableJob* job = takeJob(ownLane))
 		{
-			ThreadableJob * job = m_items[i].exchange(nullptr);
-			if( job )
-			{
-				job->process();
-				processedJob = true;
-				++m_itemsDone;
-			}
+			job->process();
+			itemsDone.fetch_add(1, std::memory_order_release);
+		}
+		// in dynamic mode, jobs currently being processed by other threads
+		// may still queue further jobs, so keep looking until all are done
+		else if (m_opMode == OperationMode::Static || isDone())
+		{
+			break;
+		}
+		else
+		{
+#ifdef __SSE__
+			_mm_pause();
+#endif
 		}
-		// always exit loop if we're not in dynamic mode
-		processedJob = processedJob && ( m_opMode == OperationMode::Dynamic );
 	}
 }
 
@@ -99,7 +304,7 @@ void AudioEngineWorkerThread::JobQueue::run()
 
 void AudioEngineWorkerThread::JobQueue::wait()
 {
-	while (m_itemsDone < m_writeIndex)
+	while (!isDone())
 	{
 #ifdef __SSE__
 		_mm_pause();
@@ -110,17 +315,123 @@ void AudioEngineWorkerThread::JobQueue::wait()
 
 
 
+void AudioEngineWorkerThread::JobQueue::runUntilDone( std::span<ThreadableJob* const> _jobs )
+{
+	// jobs can't have been queued without any lanes
+	if (m_lanes.empty()) { return; }
+
+	const auto done = [_jobs] {
+		return std::all_of(_jobs.begin(), _jobs.end(),
+			[](const ThreadableJob* job) { return job->state() == ThreadableJob::ProcessingState::Done; });
+	};
+
+	const auto ownLane = currentLane();
+	auto& itemsDone = m_lanes[ownLane]->m_itemsDone;
+
+	while (!done())
+	{
+		// the jobs may still wait in some lane or be processed by another thread
+		if (ThreadableJob* job = takeJob(ownLane))
+		{
+			job->process();
+			itemsDone.fetch_add(1, std::memory_order_release);
+		}
+		else
+		{
+#ifdef __SSE__
+			_mm_pause();
+#endif
+		}
+	}
+}
+
+
+
+
+bool AudioEngineWorkerThread::JobQueue::runOne()
+{
+	if (m_lanes.empty()) { return false; }
+
+	const auto ownLane = currentLane();
+	ThreadableJob* job = takeJob(ownLane);
+	if (!job) { return false; }
+
+	job->process();
+	m_lanes[ownLane]->m_itemsDone.fetch_add(1, std::memory_order_release);
+	return true;
+}
+
+
+
+
+ThreadableJob* AudioEngineWorkerThread::JobQueue::takeJob( size_t _ownLane )
+{
+	// drain our own lane first, then try to steal from the other ones
+	for (const size_t lane : m_stealOrder[_ownLane])
+	{
+		if (ThreadableJob* job = m_lanes[lane]->take())
+		{
+			return job;
+		}
+	}
+	return nullptr;
+}
+
+
+
+
+size_t AudioEngineWorkerThread::JobQueue::currentLane() const
+{
+	switch (s_currentLane)
+	{
+	case NoLane: return sharedLane();
+	case InlineLane: return m_lanes.size() - 2;
+	default: return s_currentLane;
+	}
+}
+
+
+
+
+bool AudioEngineWorkerThread::JobQueue::isDone() const
+{
+	// jobs are counted as done by the lane of the thread which processed them,
+	// not by the lane they were taken from. Since a job is always published
+	// before it is processed, reading all done counters before the write
+	// indices guarantees we never see more finished than published jobs
+	auto done = std::size_t{0};
+	for (const auto& lane : m_lanes)
+	{
+		done += lane->m_itemsDone.load(std::memory_order_acquire);
+	}
+	auto written = std::size_t{0};
+	for (const auto& lane : m_lanes)
+	{
+		written += std::min(lane->m_writeIndex.load(std::memory_order_acquire), JOB_QUEUE_SIZE);
+	}
+	return done >= written;
+}
+
+
+
+
 
 // implementation of worker threads
 
-AudioEngineWorkerThread::AudioEngineWorkerThread( AudioEngine* audioEngine ) :
+AudioEngineWorkerThread::AudioEngineWorkerThread( AudioEngine* audioEngine, std::optional<unsigned> cpu,
+		bool offline ) :
 	QThread( audioEngine ),
-	m_quit( false )
+	m_lane( workerThreads.size() ),
+	m_cpu( cpu ),
+	m_offline( offline ),
+	m_quit( false ),
+	m_realtimePriority( 0 )
 {
 	// initialize global static data
 	if( queueReadyWaitCond == nullptr )
 	{
 		queueReadyWaitCond = new QWaitCondition;
+		offlineReadyWaitCond = new QWaitCondition;
 	}
 
 	// keep track of all instantiated worker threads - this is used for
@@ -128,7 +439,8 @@ AudioEngineWorkerThread::AudioEngineWorkerThread( AudioEngine* audioEngine ) :
 	// AudioEngineWorkerThread::startAndWaitForJobs() for details
 	workerThreads << this;
 
-	resetJobQueue();
+	// every worker thread (including the "inline" one) gets its own lane
+	globalJobQueue.setNumLanes( workerThreads.size() );
 }
 
 
@@ -153,7 +465,17 @@ void AudioEngineWorkerThread::quit()
 
 void AudioEngineWorkerThread::startAndWaitForJobs()
 {
-	queueReadyWaitCond->wakeAll();
+	// workers still spinning since the last stage pick the jobs up right
+	// away, only sleeping ones need the (much slower) wakeup by the kernel
+	s_generation.fetch_add( 1 );
+	if( s_sleepingWorkers.load() > 0 )
+	{
+		queueReadyWaitCond->wakeAll();
+	}
+	if( s_renderingOffline.load( std::memory_order_relaxed ) && s_sleepingOfflineWorkers.load() > 0 )
+	{
+		offlineReadyWaitCond->wakeAll();
+	}
 	// The last worker-thread is never started. Instead it's processed "inline"
 	// i.e. within the global AudioEngine thread. This way we can reduce latencies
 	// that otherwise would be caused by synchronizing with another thread.
@@ -164,18 +486,105 @@ void AudioEngineWorkerThread::startAndWaitForJobs()
 
 
 
+void AudioEngineWorkerThread::setRenderingThread( bool _rendering )
+{
+	s_currentLane = _rendering ? InlineLane : NoLane;
+}
+
+
+
+
+void AudioEngineWorkerThread::promoteWithCurrentThread()
+{
+	const int priority = makeCurrentThreadRealtime( s_configuredPriority, s_realtimePolicy );
+	if( priority > 0 )
+	{
+		s_realtimePriority = priority;
+	}
+}
+
+
+
+
+void AudioEngineWorkerThread::setRealtimeScheduling( int priority, RealtimePolicy policy )
+{
+	s_configuredPriority = priority;
+	s_realtimePolicy = policy;
+}
+
+
+
+
 void AudioEngineWorkerThread::run()
 {
-	disable_denormals();
+	s_currentLane = m_lane;
+	if( m_cpu )
+	{
+		pinCurrentThread( *m_cpu );
+	}
+	RealtimeMemory::prefaultStack();
 
-	QMutex m;
+	auto generation = s_generation.load();
 	while( m_quit == false )
 	{
-		m.lock();
-		queueReadyWaitCond->wait( &m );
-		globalJobQueue.run();
-		m.unlock();
+		awaitJobs( generation );
+		generation = s_generation.load();
+
+		// offline rendering has no deadline to meet
+		if( const int priority = s_realtimePriority.load( std::memory_order_relaxed );
+			!m_offline && priority != m_realtimePriority )
+		{
+			makeCurrentThreadRealtime( priority, s_realtimePolicy );
+			pinCurrentThread( m_cpu.value_or( m_lane ) );
+			m_realtimePriority = priority;
+		}
+		disable_denormals();
+		{
+			const auto realtime = RealtimeChecker::Scope{};
+			globalJobQueue.run();
+		}
+	}
+}
+
+
+
+
+bool AudioEngineWorkerThread::hasNewJobs( std::uint32_t generation ) const
+{
+	return s_generation.load() != generation
+		&& ( !m_offline || s_renderingOffline.load( std::memory_order_relaxed ) );
+}
+
+
+
+
+void AudioEngineWorkerThread::awaitJobs( std::uint32_t generation )
+{
+	using namespace std::chrono;
+
+	const auto spinEnd = steady_clock::now() + s_spinTime;
+	while( steady_clock::now() < spinEnd )
+	{
+		if( hasNewJobs( generation ) || m_quit ) { return; }
+#ifdef __SSE__
+		_mm_pause();
+#endif
+	}
+
+	// announcing the sleep before checking once more makes startAndWaitForJobs()
+	// see this worker as sleeping if it misses the jobs. The wakeup may still
+	// come before the wait starts, in which case the jobs are left to the
+	// other threads, like they always were.
+	auto& sleeping = m_offline ? s_sleepingOfflineWorkers : s_sleepingWorkers;
+	QMutex m;
+	m.lock();
+	sleeping.fetch_add( 1 );
+	if( !hasNewJobs( generation ) && !m_quit )
+	{
+		( m_offline ? offlineReadyWaitCond : queueReadyWaitCond )->wait( &m );
 	}
+	sleeping.fetch_sub( 1 );
+	m.unlock();
 }
 
 } // namespace lmms
@@ -26,6 +26,10 @@
 
 #include <QRegularExpression>
 
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
 #include "lmms_math.h"
 
 #include "AudioEngine.h"
@@ -39,6 +43,8 @@ namespace lmms
 {
 
 long AutomatableModel::s_periodCounter = 0;
+long long AutomatableModel::s_periodStartFrame = 0;
+f_cnt_t AutomatableModel::s_periodFrameOffset = 0;
 
 
 
@@ -56,9 +62,10 @@ AutomatableModel::AutomatableModel(
 	m_setValueDepth( 0 ),
 	m_hasStrictStepSize( false ),
 	m_controllerConnection( nullptr ),
-	m_valueBuffer( static_cast<int>( Engine::audioEngine()->framesPerPeriod() ) ),
-	m_lastUpdatedPeriod( -1 ),
-	m_hasSampleExactData(false),
+	m_valueBuffers{ ValueBuffer( static_cast<int>( Engine::audioEngine()->maxFramesPerPeriod() ) ),
+		ValueBuffer( static_cast<int>( Engine::audioEngine()->maxFramesPerPeriod() ) ) },
+	m_automationStepsPeriod( -1 ),
+	m_periodStartValue( 0 ),
 	m_useControllerValue(true)
 
 {
@@ -82,7 +89,10 @@ AutomatableModel::~AutomatableModel()
 		delete m_controllerConnection;
 	}
 
-	m_valueBuffer.clear();
+	for( auto& buffer : m_valueBuffers )
+	{
+		buffer.clear();
+	}
 
 	emit destroyed( id() );
 }
@@ -303,6 +313,8 @@ void AutomatableModel::setValue( const float value )
 	m_value = fittedValue( value );
 	if( old_val != m_value )
 	{
+		invalidateControllerValue();
+
 		// add changes to history so user can undo it
 		addJournalCheckPoint();
 
@@ -376,6 +388,9 @@ void AutomatableModel::setAutomatedValue( const float value )
 
 	if( oldValue != m_value )
 	{
+		invalidateControllerValue();
+		addAutomationStep( m_value, 0 );
+
 		// notify linked models
 		for (const auto& linkedModel : m_linkedModels)
 		{
@@ -394,6 +409,66 @@ void AutomatableModel::setAutomatedValue( const float value )
 
 
 
+void AutomatableModel::setAutomatedRamp( const float value, const float target, const f_cnt_t frames )
+{
+	setUseControllerValue(false);
+
+	m_oldValue = m_value;
+	++m_setValueDepth;
+	const float oldValue = m_value;
+
+	m_value = fittedValue( scaledValue( value ) );
+	const float to = fittedValue( scaledValue( target ) );
+
+	// nothing to do while the value stays where the last ramp ended
+	if( oldValue != m_value || to != m_value || m_lastAutomationStep.to != m_value )
+	{
+		addAutomationStep( to, frames );
+
+		for (const auto& linkedModel : m_linkedModels)
+		{
+			if (!(linkedModel->controllerConnection()) && linkedModel->m_setValueDepth < 1)
+			{
+				linkedModel->setAutomatedRamp(value, target, frames);
+			}
+		}
+	}
+
+	if( oldValue != m_value )
+	{
+		invalidateControllerValue();
+		m_valueChanged = true;
+		emit dataChanged();
+	}
+	--m_setValueDepth;
+}
+
+
+
+
+void AutomatableModel::addAutomationStep( const float target, const f_cnt_t frames )
+{
+	// remember where in the period the value changed
+	if( m_automationStepsPeriod != s_periodCounter )
+	{
+		const auto periodStart = s_periodStartFrame;
+		m_automationSteps.clear();
+		m_automationStepsPeriod = s_periodCounter;
+		m_periodStartValue = m_oldValue;
+		const float held = m_lastAutomationStep.frames > 0 ? m_lastAutomationStep.to : m_oldValue;
+		m_periodStartStep = m_lastAutomationStep.start + static_cast<long long>( m_lastAutomationStep.frames ) > periodStart
+			? m_lastAutomationStep
+			: AutomationStep{ periodStart, held, held, 0 };
+	}
+
+	const auto start = s_periodStartFrame + static_cast<long long>( s_periodFrameOffset );
+	m_lastAutomationStep = AutomationStep{ start, m_value, target, frames };
+	m_automationSteps.push_back( m_lastAutomationStep );
+}
+
+
+
+
 void AutomatableModel::setRange( const float min, const float max,
 							const float step )
 {
@@ -406,6 +481,7 @@ void AutomatableModel::setRange( const float min, const float max,
 			qSwap<float>( m_minValue, m_maxValue );
 		}
 		m_range = m_maxValue - m_minValue;
+		invalidateControllerValue();
 
 		setStep( step );
 
@@ -424,6 +500,7 @@ void AutomatableModel::setStep( const float step )
 	if( m_step != step )
 	{
 		m_step = step;
+		invalidateControllerValue();
 		emit propertiesChanged();
 	}
 }
@@ -466,6 +543,7 @@ void AutomatableModel::linkModel( AutomatableModel* model )
 	if (!containsModel && model != this)
 	{
 		m_linkedModels.push_back( model );
+		invalidateControllerValue();
 
 		if( !model->hasLinkedModels() )
 		{
@@ -484,6 +562,7 @@ void AutomatableModel::unlinkModel( AutomatableModel* model )
 	if( it != m_linkedModels.end() )
 	{
 		m_linkedModels.erase( it );
+		invalidateControllerValue();
 	}
 }
 
@@ -504,6 +583,7 @@ void AutomatableModel::linkModels( AutomatableModel* model1, AutomatableModel* m
 			std::copy_n(model2->valueBuffer()->data(),
 				model1->valueBuffer()->length(),
 				model1->valueBuffer()->data());
+			model1->valueBuffer()->markVarying();
 		}
 		// send dataChanged() before linking (because linking will
 		// connect the two dataChanged() signals)
@@ -537,9 +617,24 @@ void AutomatableModel::unlinkAllModels()
 
 
 
+void AutomatableModel::invalidateControllerValue()
+{
+	// controllers change their values every period anyway, only the models
+	// linked to this one read its value in between
+	m_controllerValuePeriod.store( -1, std::memory_order_relaxed );
+	for( const auto& linkedModel : m_linkedModels )
+	{
+		linkedModel->m_controllerValuePeriod.store( -1, std::memory_order_relaxed );
+	}
+}
+
+
+
+
 void AutomatableModel::setControllerConnection( ControllerConnection* c )
 {
 	m_controllerConnection = c;
+	invalidateControllerValue();
 	if( c )
 	{
 		QObject::connect( m_controllerConnection, SIGNAL(valueChanged()),
@@ -554,6 +649,29 @@ void AutomatableModel::setControllerConnection( ControllerConnection* c )
 
 
 float AutomatableModel::controllerValue( int frameOffset ) const
+{
+	// within the period the value may depend on the offset, only its start is cached
+	if( frameOffset != 0 )
+	{
+		return calculateControllerValue( frameOffset );
+	}
+
+	const long period = s_periodCounter;
+	if( m_controllerValuePeriod.load( std::memory_order_acquire ) == period )
+	{
+		return m_controllerValue.load( std::memory_order_relaxed );
+	}
+
+	const float value = calculateControllerValue( 0 );
+	m_controllerValue.store( value, std::memory_order_relaxed );
+	m_controllerValuePeriod.store( period, std::memory_order_release );
+	return value;
+}
+
+
+
+
+float AutomatableModel::calculateControllerValue( int frameOffset ) const
 {
 	if( m_controllerConnection )
 	{
@@ -591,15 +709,39 @@ float AutomatableModel::controllerValue( int frameOffset ) const
 
 ValueBuffer * AutomatableModel::valueBuffer()
 {
-	QMutexLocker m( &m_valueBufferMutex );
+	const long period = s_periodCounter;
+	ValueBuffer* buffer = &m_valueBuffers[period & 1];
+
 	// if we've already calculated the valuebuffer this period, return the cached buffer
-	if( m_lastUpdatedPeriod == s_periodCounter )
+	auto state = m_valueBufferState.load( std::memory_order_acquire );
+	if( ( state >> 1 ) == period )
+	{
+		return ( state & 1 ) ? buffer : nullptr;
+	}
+
+	// only one thread calculates it, the others just wait for it
+	auto claimed = m_valueBufferClaim.load( std::memory_order_relaxed );
+	if( claimed != period && m_valueBufferClaim.compare_exchange_strong( claimed, period, std::memory_order_acq_rel ) )
+	{
+		// within the capacity it was created with, as periods only get shorter
+		buffer->resize( Engine::audioEngine()->framesPerPeriod() );
+		ValueBuffer* result = renderValueBuffer( *buffer );
+		m_valueBufferState.store( period << 1 | ( result != nullptr ), std::memory_order_release );
+		return result;
+	}
+
+	while( ( ( state = m_valueBufferState.load( std::memory_order_acquire ) ) >> 1 ) != period )
 	{
-		return m_hasSampleExactData
-			? &m_valueBuffer
-			: nullptr;
+		std::this_thread::yield();
 	}
+	return ( state & 1 ) ? buffer : nullptr;
+}
+
 
+
+
+ValueBuffer * AutomatableModel::renderValueBuffer( ValueBuffer& buffer )
+{
 	float val = m_value; // make sure our m_value doesn't change midway
 
 	if (m_controllerConnection && m_useControllerValue && m_controllerConnection->getController()->isSampleExact())
@@ -608,17 +750,18 @@ ValueBuffer * AutomatableModel::valueBuffer()
 		if( vb )
 		{
 			float * values = vb->values();
-			float * nvalues = m_valueBuffer.values();
+			float * nvalues = buffer.values();
+			buffer.markVarying();
 			switch( m_scaleType )
 			{
 			case ScaleType::Linear:
-				for( int i = 0; i < m_valueBuffer.length(); i++ )
+				for( int i = 0; i < buffer.length(); i++ )
 				{
 					nvalues[i] = minValue<float>() + ( range() * values[i] );
 				}
 				break;
 			case ScaleType::Logarithmic:
-				for( int i = 0; i < m_valueBuffer.length(); i++ )
+				for( int i = 0; i < buffer.length(); i++ )
 				{
 					nvalues[i] = logToLinearScale( values[i] );
 				}
@@ -628,9 +771,7 @@ ValueBuffer * AutomatableModel::valueBuffer()
 					"lacks implementation for a scale type");
 				break;
 			}
-			m_lastUpdatedPeriod = s_periodCounter;
-			m_hasSampleExactData = true;
-			return &m_valueBuffer;
+			return &buffer;
 		}
 	}
 
@@ -646,30 +787,98 @@ ValueBuffer * AutomatableModel::valueBuffer()
 		{
 			auto vb = lm->valueBuffer();
 			float * values = vb->values();
-			float * nvalues = m_valueBuffer.values();
+			float * nvalues = buffer.values();
+			buffer.markVarying();
 			for (int i = 0; i < vb->length(); i++)
 			{
 				nvalues[i] = fittedValue(values[i]);
 			}
-			m_lastUpdatedPeriod = s_periodCounter;
-			m_hasSampleExactData = true;
-			return &m_valueBuffer;
+			return &buffer;
+		}
+	}
+
+	const f_cnt_t frames = buffer.length();
+	const auto periodStart = s_periodStartFrame;
+	const bool stepsInPeriod = m_automationStepsPeriod == s_periodCounter;
+	const auto ramps = [&]( const AutomationStep& step ) {
+		return step.frames > 0 && step.from != step.to
+			&& step.start < periodStart + buffer.length()
+			&& step.start + static_cast<long long>( step.frames ) > periodStart;
+	};
+
+	// automation clips ramp to the value of their next tick, which may be
+	// reached in one of the following periods
+	if( stepsInPeriod
+		? ramps( m_periodStartStep ) || std::any_of( m_automationSteps.begin(), m_automationSteps.end(), ramps )
+		: ramps( m_lastAutomationStep ) )
+	{
+		const auto valueAt = []( const AutomationStep& step, long long frame ) {
+			if( step.frames == 0 ) { return step.from; }
+			const float progress = static_cast<float>( frame - step.start ) / step.frames;
+			return std::lerp( step.from, step.to, std::clamp( progress, 0.f, 1.f ) );
+		};
+
+		float* values = buffer.values();
+		buffer.markVarying();
+		auto step = stepsInPeriod ? m_periodStartStep : m_lastAutomationStep;
+		f_cnt_t pos = 0;
+		if( stepsInPeriod )
+		{
+			for( const auto& next : m_automationSteps )
+			{
+				const f_cnt_t start = std::clamp( static_cast<f_cnt_t>( next.start - periodStart ), pos, frames );
+				for( ; pos < start; ++pos ) { values[pos] = valueAt( step, periodStart + pos ); }
+				step = next;
+			}
+		}
+		for( ; pos < frames; ++pos ) { values[pos] = valueAt( step, periodStart + pos ); }
+
+		m_oldValue = val;
+		return &buffer;
+	}
+
+	// automated values within a period longer than the default one: render
+	// it like periods of the default size would, each of them ramping to the
+	// last value set before it ends, so the values don't lag behind
+	if( stepsInPeriod && ( m_automationSteps.size() > 1 || frames > DEFAULT_BUFFER_SIZE ) )
+	{
+		float* values = buffer.values();
+		buffer.markVarying();
+		float from = m_periodStartValue;
+		std::size_t next = 0;
+		f_cnt_t pos = 0;
+		while( pos < frames )
+		{
+			const long long defaultPeriodStart = ( periodStart + pos ) / DEFAULT_BUFFER_SIZE * DEFAULT_BUFFER_SIZE;
+			const f_cnt_t end = std::min( frames,
+				static_cast<f_cnt_t>( defaultPeriodStart + DEFAULT_BUFFER_SIZE - periodStart ) );
+
+			float to = from;
+			for( ; next < m_automationSteps.size() && m_automationSteps[next].start < periodStart + end; ++next )
+			{
+				to = next + 1 < m_automationSteps.size() ? m_automationSteps[next].from : val;
+			}
+
+			for( ; pos < end; ++pos )
+			{
+				const float progress = static_cast<float>( periodStart + pos - defaultPeriodStart ) / DEFAULT_BUFFER_SIZE;
+				values[pos] = std::lerp( from, to, progress );
+			}
+			from = to;
 		}
+		m_oldValue = val;
+		return &buffer;
 	}
 
 	if( m_oldValue != val )
 	{
-		m_valueBuffer.interpolate( m_oldValue, val );
+		buffer.interpolate( m_oldValue, val );
 		m_oldValue = val;
-		m_lastUpdatedPeriod = s_periodCounter;
-		m_hasSampleExactData = true;
-		return &m_valueBuffer;
+		return &buffer;
 	}
 
 	// if we have no sample-exact source for a ValueBuffer, return NULL to signify that no data is available at the moment
 	// in which case the recipient knows to use the static value() instead
-	m_lastUpdatedPeriod = s_periodCounter;
-	m_hasSampleExactData = false;
 	return nullptr;
 }
 
@@ -682,6 +891,7 @@ void AutomatableModel::unlinkControllerConnection()
 	}
 
 	m_controllerConnection = nullptr;
+	invalidateControllerValue();
 }
 
 
@@ -771,11 +981,13 @@ void AutomatableModel::setUseControllerValue(bool b)
 	if (b)
 	{
 		m_useControllerValue = true;
+		invalidateControllerValue();
 		emit dataChanged();
 	}
 	else if (m_controllerConnection && m_useControllerValue)
 	{
 		m_useControllerValue = false;
+		invalidateControllerValue();
 		emit dataChanged();
 	}
 }
@@ -26,13 +26,24 @@
 
 #include "AutomationClip.h"
 
+#include <QTimer>
+#include <QtEndian>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <thread>
+#include <vector>
+
 #include "AutomationNode.h"
 #include "AutomationClipView.h"
 #include "AutomationTrack.h"
 #include "KeyboardShortcuts.h"
 #include "LocaleHelper.h"
+#include "LocklessRingBuffer.h"
 #include "Note.h"
 #include "PatternStore.h"
+#include "PerfLog.h"
 #include "ProjectJournal.h"
 #include "Song.h"
 
@@ -44,6 +55,115 @@ int AutomationClip::s_quantization = 1;
 const float AutomationClip::DEFAULT_MIN_VALUE = 0;
 const float AutomationClip::DEFAULT_MAX_VALUE = 1;
 
+namespace
+{
+
+//! Clips with more nodes (usually recorded ones) store them in a single base64 encoded
+//! <nodes> element instead of a <time> element per node, which is much faster to load
+constexpr auto CompactNodeCount = 64;
+
+//! Position relative to the previous node, in value, out value, in tangent, out tangent,
+//! locked tangents, all little endian
+constexpr auto CompactNodeSize = 4 + 4 * 4 + 1;
+
+void appendCompact(QByteArray& data, quint32 value)
+{
+	const auto le = qToLittleEndian(value);
+	data.append(reinterpret_cast<const char*>(&le), sizeof(le));
+}
+
+auto readCompact(const char* data) -> quint32
+{
+	return qFromLittleEndian<quint32>(data);
+}
+
+} // namespace
+
+
+//! The nodes of a clip in a sorted array, so looking up values doesn't have to lock the clip or walk the map
+struct AutomationClip::Curve
+{
+	struct Node
+	{
+		int pos;
+		float inValue;
+		float outValue;
+		float inTangent;
+		float outTangent;
+	};
+
+	std::vector<Node> nodes;
+	ProgressionType progressionType;
+	float tension;
+
+	float valueAt(int time) const
+	{
+		// the first node after time
+		const auto next = std::upper_bound(nodes.begin(), nodes.end(), time,
+			[](int t, const Node& node) { return t < node.pos; });
+		if (next == nodes.begin()) { return 0; }
+
+		const auto& node = *(next - 1);
+		// When the time is exactly the node's time, we want the inValue
+		if (node.pos == time) { return node.inValue; }
+		// When the time is after the last node, we want the outValue of it
+		if (next == nodes.end()) { return node.outValue; }
+
+		return interpolate(node, *next, time - node.pos);
+	}
+
+	//! Same as AutomationClip::valueAt(timeMap::const_iterator, int)
+	float interpolate(const Node& node, const Node& next, int offset) const
+	{
+		if (progressionType == ProgressionType::Discrete)
+		{
+			return node.outValue;
+		}
+		else if (progressionType == ProgressionType::Linear)
+		{
+			const float slope = (next.inValue - node.outValue) / (next.pos - node.pos);
+			return node.outValue + offset * slope;
+		}
+
+		const int numValues = next.pos - node.pos;
+		const float t = static_cast<float>(offset) / static_cast<float>(numValues);
+		const float m1 = node.outTangent * numValues * tension;
+		const float m2 = next.inTangent * numValues * tension;
+
+		const auto t2 = t * t, t3 = t2 * t;
+		return (2 * t3 - 3 * t2 + 1) * node.outValue
+			+ (t3 - 2 * t2 + t) * m1
+			+ (-2 * t3 + 3 * t2) * next.inValue
+			+ (t3 - t2) * m2;
+	}
+};
+
+
+//! Values recorded by the audio thread, added to the clip by a timer in the clip's thread
+struct AutomationClip::RecordQueue
+{
+	struct Value
+	{
+		int time;
+		float value;
+	};
+
+	//! Interval in which the recorded values are added to the clip
+	static constexpr auto Interval = 20;
+
+	LocklessRingBuffer<Value> values{4096};
+	LocklessRingBufferReader<Value> reader{values};
+	QTimer timer;
+
+	//! The last nodes recorded in a row, used to drop nodes in a straight line between their neighbours
+	std::array<std::pair<int, float>, 2> lastNodes;
+	std::size_t lastNodeCount = 0;
+	//! The nodes dropped since the first of lastNodes
+	std::vector<std::pair<int, float>> droppedNodes;
+};
+
+
+
 
 AutomationClip::AutomationClip( AutomationTrack * _auto_track ) :
 	Clip( _auto_track ),
@@ -74,9 +194,12 @@ AutomationClip::AutomationClip( const AutomationClip & _clip_to_copy ) :
 	m_tension( _clip_to_copy.m_tension ),
 	m_progressionType(_clip_to_copy.m_progressionType),
 	m_dragging(false),
-	m_isRecording(_clip_to_copy.m_isRecording),
-	m_lastRecordedValue(0)
+	m_isRecording(false),
+	m_lastRecordedValue(0),
+	m_simplificationTolerance(_clip_to_copy.m_simplificationTolerance)
 {
+	setRecording(_clip_to_copy.isRecording());
+
 	// Locks the mutex of the copied AutomationClip to make sure it
 	// doesn't change while it's being copied
 	QMutexLocker m(&_clip_to_copy.m_clipMutex);
@@ -89,6 +212,15 @@ AutomationClip::AutomationClip( const AutomationClip & _clip_to_copy ) :
 		// Sets the node's clip to this one
 		m_timeMap[POS(it)].setClip(this);
 	}
+	publishCurve();
+}
+
+
+
+
+AutomationClip::~AutomationClip()
+{
+	delete m_curve.load();
 }
 
 bool AutomationClip::addObject( AutomatableModel * _obj, bool _search_dup )
@@ -108,6 +240,7 @@ bool AutomationClip::addObject( AutomatableModel * _obj, bool _search_dup )
 	}
 
 	m_objects.push_back(_obj);
+	TrackContainer::arrangementChanged();
 
 	connect( _obj, SIGNAL(destroyed(lmms::jo_id_t)),
 			this, SLOT(objectDestroyed(lmms::jo_id_t)),
@@ -131,6 +264,7 @@ void AutomationClip::setProgressionType(
 		_new_progression_type == ProgressionType::CubicHermite )
 	{
 		m_progressionType = _new_progression_type;
+		publishCurve();
 		emit dataChanged();
 	}
 }
@@ -148,6 +282,7 @@ void AutomationClip::setTension( QString _new_tension )
 	if( ok && nt > -0.01 && nt < 1.01 )
 	{
 		m_tension = nt;
+		publishCurve();
 	}
 }
 
@@ -323,6 +458,29 @@ TimePos AutomationClip::putValues(
 
 
 
+void AutomationClip::putValues(const std::vector<std::pair<TimePos, float>>& values)
+{
+	if (values.empty()) { return; }
+
+	QMutexLocker m(&m_clipMutex);
+
+	cleanObjects();
+
+	for (const auto& [time, value] : values)
+	{
+		const auto newTime = std::max(TimePos(0), time);
+		m_timeMap[newTime] = AutomationNode(this, value, newTime);
+	}
+	generateTangents();
+
+	updateLength();
+
+	emit dataChanged();
+}
+
+
+
+
 void AutomationClip::removeNode(const TimePos & time)
 {
 	QMutexLocker m(&m_clipMutex);
@@ -434,22 +592,196 @@ void AutomationClip::resetTangents(const int tick0, const int tick1)
 
 void AutomationClip::recordValue(TimePos time, float value)
 {
+	// adding the nodes would lock the clip, which the editor may be drawing
+	if (!m_recordQueue) { return; }
+	const auto recorded = RecordQueue::Value{time - startTimeOffset(), value};
+	m_recordQueue->values.write(&recorded, 1);
+}
+
+
+
+
+void AutomationClip::setRecording(const bool b)
+{
+	if (b && !m_recordQueue)
+	{
+		m_recordQueue = std::make_unique<RecordQueue>();
+		m_recordQueue->timer.moveToThread(thread());
+		connect(&m_recordQueue->timer, &QTimer::timeout, this, &AutomationClip::addRecordedValues);
+	}
+	if (b)
+	{
+		// the timer has to be started in the thread of the clip, which adds the values
+		QMetaObject::invokeMethod(this, [this] {
+			m_recordQueue->lastNodeCount = 0;
+			m_recordQueue->droppedNodes.clear();
+			m_recordQueue->timer.start(RecordQueue::Interval);
+		});
+	}
+	// the timer stops once it has added the last values
+	m_isRecording.store(b, std::memory_order_release);
+}
+
+
+
+
+void AutomationClip::addRecordedValues()
+{
+	auto& queue = *m_recordQueue;
+	const bool finished = !isRecording();
+	if (finished) { queue.timer.stop(); }
+
+	auto recorded = std::vector<RecordQueue::Value>(queue.reader.read_space());
+	queue.reader.read(recorded.size()).copy(recorded.data(), recorded.size());
+
 	QMutexLocker m(&m_clipMutex);
 
-	if( value != m_lastRecordedValue )
+	// points closer than this to the line between their neighbours are dropped
+	const float tolerance = std::abs(getMax() - getMin()) * 0.001f;
+	auto& lastNodes = queue.lastNodes;
+	auto& count = queue.lastNodeCount;
+
+	for (auto it = recorded.begin(); it != recorded.end(); ++it)
 	{
-		putValue(time - startTimeOffset(), value, true);
+		// only the last value recorded at the same time counts
+		if (std::next(it) != recorded.end() && std::next(it)->time == it->time) { continue; }
+		const auto [time, value] = *it;
+
+		if (value == m_lastRecordedValue)
+		{
+			if (valueAt(time) != value) { removeNode(time); }
+			continue;
+		}
 		m_lastRecordedValue = value;
+
+		const int pos = putValue(time, value, true);
+		if (count > 0 && pos <= lastNodes[count - 1].first)
+		{
+			// quantized onto the last node, or recording started over
+			count = 0;
+			queue.droppedNodes.clear();
+		}
+
+		if (count == 2 && m_progressionType != ProgressionType::Discrete)
+		{
+			// the nodes dropped before have to stay close to the line as well,
+			// otherwise a slow curve would be flattened bit by bit
+			const auto [firstPos, firstValue] = lastNodes[0];
+			const auto onLine = [&](const std::pair<int, float>& node) {
+				const float expected = firstValue
+					+ (value - firstValue) * (node.first - firstPos) / static_cast<float>(pos - firstPos);
+				return std::abs(expected - node.second) <= tolerance;
+			};
+			if (onLine(lastNodes[1]) && std::all_of(queue.droppedNodes.begin(), queue.droppedNodes.end(), onLine))
+			{
+				removeNode(lastNodes[1].first);
+				queue.droppedNodes.push_back(lastNodes[1]);
+				count = 1;
+			}
+		}
+		if (count == 2)
+		{
+			lastNodes[0] = lastNodes[1];
+			queue.droppedNodes.clear();
+			count = 1;
+		}
+		lastNodes[count++] = {pos, value};
+	}
+
+	if (finished && m_simplificationTolerance > 0) { simplify(m_simplificationTolerance); }
+}
+
+
+
+
+void AutomationClip::simplify(float tolerance)
+{
+	QMutexLocker m(&m_clipMutex);
+	if (m_timeMap.size() < 3) { return; }
+
+	struct Point
+	{
+		int pos;
+		float inValue;
+		float outValue;
+	};
+	auto points = std::vector<Point>{};
+	points.reserve(m_timeMap.size());
+	auto keep = std::vector<bool>{};
+	keep.reserve(m_timeMap.size());
+	for (auto it = m_timeMap.cbegin(); it != m_timeMap.cend(); ++it)
+	{
+		points.push_back({POS(it), INVAL(it), OUTVAL(it)});
+		// jumps and tangents set by hand are part of the curve
+		keep.push_back(INVAL(it) != OUTVAL(it) || LOCKEDTAN(it));
+	}
+	keep.front() = keep.back() = true;
+
+	if (m_progressionType == ProgressionType::Discrete)
+	{
+		// a node setting about the value the curve already has changes nothing
+		float value = points.front().outValue;
+		for (std::size_t i = 1; i + 1 < points.size(); ++i)
+		{
+			keep[i] = keep[i] || std::abs(points[i].inValue - value) > tolerance;
+			if (keep[i]) { value = points[i].outValue; }
+		}
+	}
+	else
+	{
+		// Ramer-Douglas-Peucker between the nodes which are kept anyway
+		auto ranges = std::vector<std::pair<std::size_t, std::size_t>>{};
+		for (std::size_t first = 0, i = 1; i < points.size(); ++i)
+		{
+			if (keep[i])
+			{
+				ranges.emplace_back(first, i);
+				first = i;
+			}
+		}
+
+		while (!ranges.empty())
+		{
+			const auto [first, last] = ranges.back();
+			ranges.pop_back();
+
+			const auto& a = points[first];
+			const auto& b = points[last];
+			auto furthest = first;
+			auto maxDistance = tolerance;
+			for (auto i = first + 1; i < last; ++i)
+			{
+				const float t = static_cast<float>(points[i].pos - a.pos) / (b.pos - a.pos);
+				const float distance = std::abs(points[i].inValue - std::lerp(a.outValue, b.inValue, t));
+				if (distance > maxDistance)
+				{
+					maxDistance = distance;
+					furthest = i;
+				}
+			}
+
+			if (furthest != first)
+			{
+				keep[furthest] = true;
+				ranges.emplace_back(first, furthest);
+				ranges.emplace_back(furthest, last);
+			}
+		}
 	}
-	else if( valueAt(time - startTimeOffset()) != value )
+
+	for (std::size_t i = 0; i < points.size(); ++i)
 	{
-		removeNode(time - startTimeOffset());
+		if (!keep[i]) { m_timeMap.remove(points[i].pos); }
 	}
+	generateTangents();
+
+	emit dataChanged();
 }
 
 
 
 
+
 /**
  * @brief Set the position of the point that is being dragged.
  *        Calling this function will also automatically set m_dragging to true.
@@ -535,6 +867,7 @@ TimePos AutomationClip::setDragValue(
 			it.value().setInTangent(m_dragInTan);
 			it.value().setOutTangent(m_dragOutTan);
 			it.value().setLockedTangents(true);
+			publishCurve();
 		}
 	}
 
@@ -559,36 +892,12 @@ void AutomationClip::applyDragValue()
 
 float AutomationClip::valueAt( const TimePos & _time ) const
 {
-	QMutexLocker m(&m_clipMutex);
-
-	if( m_timeMap.isEmpty() )
-	{
-		return 0;
-	}
-
-	// If we have a node at that time, just return its value
-	if (m_timeMap.contains(_time))
-	{
-		// When the time is exactly the node's time, we want the inValue
-		return m_timeMap[_time].getInValue();
-	}
-
-	// lowerBound returns next value with equal or greater key. Since we already
-	// checked if the key contains a node, we know the returned node has a greater
-	// key than _time. Therefore we take the previous element to calculate the current value
-	timeMap::const_iterator v = m_timeMap.lowerBound(_time);
-
-	if( v == m_timeMap.begin() )
-	{
-		return 0;
-	}
-	if( v == m_timeMap.end() )
-	{
-		// When the time is after the last node, we want the outValue of it
-		return OUTVAL(v - 1);
-	}
-
-	return valueAt(v - 1, _time - POS(v - 1));
+	// the curve isn't deleted while it's being read, see publishCurve()
+	m_curveReaders.fetch_add(1);
+	const Curve* curve = m_curve.load();
+	const float value = curve ? curve->valueAt(_time) : 0;
+	m_curveReaders.fetch_sub(1, std::memory_order_release);
+	return value;
 }
 
 
@@ -666,6 +975,26 @@ float *AutomationClip::valuesAfter( const TimePos & _time ) const
 
 
 
+std::vector<float> AutomationClip::valuesAfter(const TimePos& time, int step) const
+{
+	QMutexLocker m(&m_clipMutex);
+
+	auto values = std::vector<float>();
+	const auto v = m_timeMap.lowerBound(time);
+	if (v == m_timeMap.end() || (v + 1) == m_timeMap.end()) { return values; }
+
+	const int numValues = POS(v + 1) - POS(v);
+	values.reserve((numValues + step - 1) / step);
+	for (int i = 0; i < numValues; i += step)
+	{
+		values.push_back(valueAt(v, i));
+	}
+	return values;
+}
+
+
+
+
 void AutomationClip::flipY(int min, int max)
 {
 	QMutexLocker m(&m_clipMutex);
@@ -786,14 +1115,38 @@ void AutomationClip::saveSettings( QDomDocument & _doc, QDomElement & _this )
 	_this.setAttribute( "mute", QString::number( isMuted() ) );
 	_this.setAttribute("off", startTimeOffset());
 	_this.setAttribute("autoresize", QString::number(getAutoResize()));
+	if (m_simplificationTolerance > 0)
+	{
+		_this.setAttribute("simplify", QString::number(m_simplificationTolerance));
+	}
 
 	if (const auto& c = color())
 	{
 		_this.setAttribute("color", c->name());
 	}
 
-	for( timeMap::const_iterator it = m_timeMap.begin();
-						it != m_timeMap.end(); ++it )
+	if (m_timeMap.size() > CompactNodeCount)
+	{
+		auto data = QByteArray{};
+		data.reserve(m_timeMap.size() * CompactNodeSize);
+		int lastPos = 0;
+		for (auto it = m_timeMap.cbegin(); it != m_timeMap.cend(); ++it)
+		{
+			appendCompact(data, static_cast<quint32>(POS(it) - lastPos));
+			appendCompact(data, std::bit_cast<quint32>(INVAL(it)));
+			appendCompact(data, std::bit_cast<quint32>(OUTVAL(it)));
+			appendCompact(data, std::bit_cast<quint32>(INTAN(it)));
+			appendCompact(data, std::bit_cast<quint32>(OUTTAN(it)));
+			data.append(static_cast<char>(LOCKEDTAN(it)));
+			lastPos = POS(it);
+		}
+
+		QDomElement element = _doc.createElement("nodes");
+		element.setAttribute("count", m_timeMap.size());
+		element.appendChild(_doc.createTextNode(QString::fromLatin1(data.toBase64())));
+		_this.appendChild(element);
+	}
+	else for (timeMap::const_iterator it = m_timeMap.begin(); it != m_timeMap.end(); ++it)
 	{
 		QDomElement element = _doc.createElement( "time" );
 		element.setAttribute("pos", POS(it));
@@ -838,6 +1191,7 @@ void AutomationClip::loadSettings( const QDomElement & _this )
 	setMuted(_this.attribute( "mute", QString::number( false ) ).toInt() );
 	setAutoResize(_this.attribute("autoresize", "1").toInt());
 	setStartTimeOffset(_this.attribute("off").toInt());
+	m_simplificationTolerance = LocaleHelper::toFloat(_this.attribute("simplify", "0"));
 
 	for( QDomNode node = _this.firstChild(); !node.isNull();
 						node = node.nextSibling() )
@@ -871,6 +1225,20 @@ void AutomationClip::loadSettings( const QDomElement & _this )
 				shouldGenerateTangents = true;
 			}
 		}
+		else if (element.tagName() == "nodes")
+		{
+			const auto data = QByteArray::fromBase64(element.text().toLatin1());
+			int pos = 0;
+			for (auto record = data.constData(); record + CompactNodeSize <= data.constEnd(); record += CompactNodeSize)
+			{
+				pos += static_cast<qint32>(readCompact(record));
+				auto& timeMapNode = m_timeMap[pos] = AutomationNode(this,
+					std::bit_cast<float>(readCompact(record + 4)), std::bit_cast<float>(readCompact(record + 8)), pos);
+				timeMapNode.setInTangent(std::bit_cast<float>(readCompact(record + 12)));
+				timeMapNode.setOutTangent(std::bit_cast<float>(readCompact(record + 16)));
+				timeMapNode.setLockedTangents(record[20] != 0);
+			}
+		}
 		else if( element.tagName() == "object" )
 		{
 			m_idsToResolve.push_back(element.attribute("id").toInt());
@@ -894,6 +1262,7 @@ void AutomationClip::loadSettings( const QDomElement & _this )
 	}
 
 	if (shouldGenerateTangents) { generateTangents(); }
+	publishCurve();
 }
 
 
@@ -1024,6 +1393,7 @@ AutomationClip * AutomationClip::globalAutomationClip(
 
 void AutomationClip::resolveAllIDs()
 {
+	const auto timer = PerfLogReport::Timer("Automation", "resolve IDs");
 	auto l = combineAllTracks();
 	for (const auto& track : l)
 	{
@@ -1054,7 +1424,7 @@ void AutomationClip::resolveAllIDs()
 							{
 								// FIXME: Remove this block once the automation system gets fixed
 								// This is a temporary fix for https://github.com/LMMS/lmms/issues/4781
-								o = Engine::projectJournal()->journallingObject(ProjectJournal::idToSave(id));
+								o = Engine::projectJournal()->journallingObject(ProjectJournal::idFromLegacySave(id));
 								if( o && dynamic_cast<AutomatableModel *>( o ) )
 								{
 									a->addObject( dynamic_cast<AutomatableModel *>( o ), false );
@@ -1078,6 +1448,7 @@ void AutomationClip::clear()
 	QMutexLocker m(&m_clipMutex);
 
 	m_timeMap.clear();
+	publishCurve();
 
 	emit dataChanged();
 }
@@ -1102,6 +1473,7 @@ void AutomationClip::objectDestroyed( jo_id_t _id )
 		{
 			//Assign to objIt so that this loop work even break; is removed.
 			objIt = m_objects.erase( objIt );
+			TrackContainer::arrangementChanged();
 			break;
 		}
 	}
@@ -1198,8 +1570,29 @@ void AutomationClip::generateTangents(timeMap::iterator it, int numToGenerate)
 			}
 		}
 	}
+
+	publishCurve();
 }
 
+
+
+
+void AutomationClip::publishCurve()
+{
+	QMutexLocker m(&m_clipMutex);
+
+	auto curve = new Curve{{}, m_progressionType, m_tension};
+	curve->nodes.reserve(m_timeMap.size());
+	for (auto it = m_timeMap.cbegin(); it != m_timeMap.cend(); ++it)
+	{
+		curve->nodes.push_back({POS(it), INVAL(it), OUTVAL(it), INTAN(it), OUTTAN(it)});
+	}
+
+	const Curve* old = m_curve.exchange(curve);
+	// readers which might still use the old curve have loaded it before the exchange
+	while (m_curveReaders.load() != 0) { std::this_thread::yield(); }
+	delete old;
+}
 std::vector<Track*> AutomationClip::combineAllTracks()
 {
 	std::vector<Track*> combinedTrackList;
@@ -0,0 +1,546 @@
+/*
+ * BinaryDataFile.cpp - compact binary encoding of DataFile documents
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "BinaryDataFile.h"
+
+#include <QDomDocument>
+#include <QHash>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace lmms::BinaryDataFile
+{
+
+namespace
+{
+
+constexpr char Magic[] = {'L', 'M', 'M', 'B'};
+constexpr std::uint8_t FormatVersion = 1;
+constexpr int HeaderSize = sizeof(Magic) + 1;
+
+//! Siblings are only stored as a block if there are at least that many
+constexpr std::size_t MinBlockRows = 4;
+
+//! Limits recursion on corrupt files
+constexpr int MaxDepth = 256;
+
+enum class NodeTag : std::uint8_t
+{
+	Element = 1,
+	Text,
+	CData,
+	Comment,
+	ProcessingInstruction,
+	ElementBlock
+};
+
+enum class ColumnType : std::uint8_t
+{
+	Strings,
+	Integers
+};
+
+struct Attribute
+{
+	QString name;
+	QString value;
+};
+
+//! The attributes of @p element sorted by name, as QDom doesn't keep their order
+std::vector<Attribute> sortedAttributes(const QDomElement& element)
+{
+	const QDomNamedNodeMap map = element.attributes();
+	auto attributes = std::vector<Attribute>();
+	attributes.reserve(map.count());
+	for (int i = 0; i < map.count(); ++i)
+	{
+		const QDomAttr attr = map.item(i).toAttr();
+		attributes.push_back({attr.name(), attr.value()});
+	}
+	std::sort(attributes.begin(), attributes.end(),
+		[](const Attribute& a, const Attribute& b) { return a.name < b.name; });
+	return attributes;
+}
+
+//! Whether @p value is an integer which reads back to the same string
+bool toInteger(const QString& value, qlonglong& integer)
+{
+	bool ok = false;
+	integer = value.toLongLong(&ok);
+	return ok && QString::number(integer) == value;
+}
+
+
+class Writer
+{
+public:
+	QByteArray finish()
+	{
+		auto payload = QByteArray();
+		writeVarint(payload, m_strings.size());
+		for (const QString& string : m_strings)
+		{
+			const QByteArray utf8 = string.toUtf8();
+			writeVarint(payload, utf8.size());
+			payload.append(utf8);
+		}
+		payload.append(m_nodes);
+		return payload;
+	}
+
+	void writeChildren(const QDomNode& parent)
+	{
+		auto children = std::vector<QDomNode>();
+		for (QDomNode child = parent.firstChild(); !child.isNull(); child = child.nextSibling())
+		{
+			if (isStored(child)) { children.push_back(child); }
+		}
+		writeVarint(m_nodes, countNodes(children));
+
+		for (std::size_t i = 0; i < children.size();)
+		{
+			const std::size_t rows = blockRows(children, i);
+			if (rows >= MinBlockRows)
+			{
+				writeBlock(children, i, rows);
+				i += rows;
+			}
+			else
+			{
+				writeNode(children[i]);
+				++i;
+			}
+		}
+	}
+
+private:
+	//! Whether @p node is of a type the format stores, which are all types
+	//! DataFile documents contain
+	static bool isStored(const QDomNode& node)
+	{
+		switch (node.nodeType())
+		{
+			case QDomNode::ElementNode:
+			case QDomNode::TextNode:
+			case QDomNode::CDATASectionNode:
+			case QDomNode::CommentNode:
+			case QDomNode::ProcessingInstructionNode:
+				return true;
+			default:
+				return false;
+		}
+	}
+
+	//! How many siblings starting at @p first can be stored in one block
+	static std::size_t blockRows(const std::vector<QDomNode>& nodes, std::size_t first)
+	{
+		const auto isLeafElement = [](const QDomNode& node) {
+			return node.isElement() && !node.hasChildNodes();
+		};
+		if (!isLeafElement(nodes[first])) { return 0; }
+
+		const QDomElement head = nodes[first].toElement();
+		const auto headAttributes = sortedAttributes(head);
+		if (headAttributes.empty()) { return 0; }
+		std::size_t last = first + 1;
+		for (; last < nodes.size() && isLeafElement(nodes[last]); ++last)
+		{
+			const QDomElement element = nodes[last].toElement();
+			if (element.tagName() != head.tagName()) { break; }
+
+			const auto attributes = sortedAttributes(element);
+			if (!std::equal(attributes.begin(), attributes.end(), headAttributes.begin(), headAttributes.end(),
+				[](const Attribute& a, const Attribute& b) { return a.name == b.name; }))
+			{
+				break;
+			}
+		}
+		return last - first;
+	}
+
+	//! Number of entries in the node stream, where a block counts as one
+	static std::size_t countNodes(const std::vector<QDomNode>& nodes)
+	{
+		std::size_t count = 0;
+		for (std::size_t i = 0; i < nodes.size(); ++count)
+		{
+			const std::size_t rows = blockRows(nodes, i);
+			i += rows >= MinBlockRows ? rows : 1;
+		}
+		return count;
+	}
+
+	void writeNode(const QDomNode& node)
+	{
+		switch (node.nodeType())
+		{
+			case QDomNode::ElementNode:
+			{
+				const QDomElement element = node.toElement();
+				writeTag(NodeTag::Element);
+				writeString(element.tagName());
+				const auto attributes = sortedAttributes(element);
+				writeVarint(m_nodes, attributes.size());
+				for (const auto& attribute : attributes)
+				{
+					writeString(attribute.name);
+					writeString(attribute.value);
+				}
+				writeChildren(node);
+				break;
+			}
+			case QDomNode::TextNode:
+				writeTag(NodeTag::Text);
+				writeString(node.nodeValue());
+				break;
+			case QDomNode::CDATASectionNode:
+				writeTag(NodeTag::CData);
+				writeString(node.nodeValue());
+				break;
+			case QDomNode::CommentNode:
+				writeTag(NodeTag::Comment);
+				writeString(node.nodeValue());
+				break;
+			case QDomNode::ProcessingInstructionNode:
+			{
+				const QDomProcessingInstruction instruction = node.toProcessingInstruction();
+				writeTag(NodeTag::ProcessingInstruction);
+				writeString(instruction.target());
+				writeString(instruction.data());
+				break;
+			}
+			default:
+				break;
+		}
+	}
+
+	void writeBlock(const std::vector<QDomNode>& nodes, std::size_t first, std::size_t rows)
+	{
+		const auto head = sortedAttributes(nodes[first].toElement());
+
+		writeTag(NodeTag::ElementBlock);
+		writeString(nodes[first].toElement().tagName());
+		writeVarint(m_nodes, head.size());
+		for (const auto& attribute : head) { writeString(attribute.name); }
+		writeVarint(m_nodes, rows);
+
+		// column by column, so the integer deltas of one attribute follow each other
+		auto values = std::vector<std::vector<Attribute>>();
+		values.reserve(rows);
+		for (std::size_t row = 0; row < rows; ++row)
+		{
+			values.push_back(sortedAttributes(nodes[first + row].toElement()));
+		}
+
+		for (std::size_t column = 0; column < head.size(); ++column)
+		{
+			auto integers = std::vector<qlonglong>(rows);
+			bool allIntegers = true;
+			for (std::size_t row = 0; row < rows && allIntegers; ++row)
+			{
+				allIntegers = toInteger(values[row][column].value, integers[row]);
+			}
+
+			if (allIntegers)
+			{
+				writeTag(ColumnType::Integers);
+				auto previous = std::uint64_t{0};
+				for (qlonglong integer : integers)
+				{
+					// wraps around instead of overflowing
+					const auto delta = static_cast<std::int64_t>(static_cast<std::uint64_t>(integer) - previous);
+					writeVarint(m_nodes, (static_cast<std::uint64_t>(delta) << 1) ^ static_cast<std::uint64_t>(delta >> 63));
+					previous = static_cast<std::uint64_t>(integer);
+				}
+			}
+			else
+			{
+				writeTag(ColumnType::Strings);
+				for (std::size_t row = 0; row < rows; ++row) { writeString(values[row][column].value); }
+			}
+		}
+	}
+
+	template<typename Tag>
+	void writeTag(Tag tag)
+	{
+		m_nodes.append(static_cast<char>(tag));
+	}
+
+	void writeString(const QString& string)
+	{
+		auto it = m_stringIndices.constFind(string);
+		if (it == m_stringIndices.constEnd())
+		{
+			it = m_stringIndices.insert(string, static_cast<std::uint64_t>(m_strings.size()));
+			m_strings.push_back(string);
+		}
+		writeVarint(m_nodes, *it);
+	}
+
+	static void writeVarint(QByteArray& out, std::uint64_t value)
+	{
+		while (value >= 0x80)
+		{
+			out.append(static_cast<char>((value & 0x7f) | 0x80));
+			value >>= 7;
+		}
+		out.append(static_cast<char>(value));
+	}
+
+	QByteArray m_nodes;
+	std::vector<QString> m_strings;
+	QHash<QString, std::uint64_t> m_stringIndices;
+};
+
+
+class Reader
+{
+public:
+	Reader(const QByteArray& payload, QDomDocument& doc) :
+		m_data(reinterpret_cast<const std::uint8_t*>(payload.constData())),
+		m_size(static_cast<std::size_t>(payload.size())),
+		m_doc(doc)
+	{
+	}
+
+	bool read(QString* error)
+	{
+		const std::uint64_t count = readVarint();
+		// every string takes at least one byte
+		if (count > m_size)
+		{
+			return fail(error, "invalid string table");
+		}
+		m_strings.reserve(count);
+		for (std::uint64_t i = 0; i < count && !m_failed; ++i)
+		{
+			const std::uint64_t length = readVarint();
+			if (length > m_size - m_pos) { return fail(error, "truncated string table"); }
+			m_strings.push_back(QString::fromUtf8(reinterpret_cast<const char*>(m_data + m_pos), length));
+			m_pos += length;
+		}
+
+		readChildren(m_doc, 0);
+		if (m_failed) { return fail(error, "invalid node data"); }
+		if (m_pos != m_size) { return fail(error, "unexpected data after the document"); }
+		return true;
+	}
+
+private:
+	void readChildren(QDomNode parent, int depth)
+	{
+		if (depth > MaxDepth) { m_failed = true; return; }
+
+		const std::uint64_t count = readVarint();
+		for (std::uint64_t i = 0; i < count && !m_failed; ++i)
+		{
+			switch (static_cast<NodeTag>(readByte()))
+			{
+				case NodeTag::Element:
+				{
+					QDomElement element = m_doc.createElement(readString());
+					const std::uint64_t attributes = readVarint();
+					for (std::uint64_t a = 0; a < attributes && !m_failed; ++a)
+					{
+						const QString& name = readString();
+						element.setAttribute(name, readString());
+					}
+					parent.appendChild(element);
+					readChildren(element, depth + 1);
+					break;
+				}
+				case NodeTag::Text:
+					parent.appendChild(m_doc.createTextNode(readString()));
+					break;
+				case NodeTag::CData:
+					parent.appendChild(m_doc.createCDATASection(readString()));
+					break;
+				case NodeTag::Comment:
+					parent.appendChild(m_doc.createComment(readString()));
+					break;
+				case NodeTag::ProcessingInstruction:
+				{
+					const QString& target = readString();
+					parent.appendChild(m_doc.createProcessingInstruction(target, readString()));
+					break;
+				}
+				case NodeTag::ElementBlock:
+					readBlock(parent);
+					break;
+				default:
+					m_failed = true;
+					break;
+			}
+		}
+	}
+
+	void readBlock(QDomNode parent)
+	{
+		const QString& tagName = readString();
+		const std::uint64_t columns = readVarint();
+		if (columns == 0 || columns > m_size) { m_failed = true; return; }
+
+		auto names = std::vector<const QString*>();
+		names.reserve(columns);
+		for (std::uint64_t c = 0; c < columns && !m_failed; ++c) { names.push_back(&readString()); }
+
+		// every value takes at least one byte
+		const std::uint64_t rows = readVarint();
+		if (m_failed || rows == 0 || rows > m_size) { m_failed = true; return; }
+
+		auto elements = std::vector<QDomElement>();
+		elements.reserve(rows);
+		for (std::uint64_t row = 0; row < rows; ++row)
+		{
+			elements.push_back(m_doc.createElement(tagName));
+		}
+
+		for (std::uint64_t c = 0; c < columns && !m_failed; ++c)
+		{
+			const auto type = static_cast<ColumnType>(readByte());
+			if (type == ColumnType::Integers)
+			{
+				auto value = std::uint64_t{0};
+				for (auto& element : elements)
+				{
+					const std::uint64_t zigzag = readVarint();
+					value += (zigzag >> 1) ^ (~(zigzag & 1) + 1);
+					element.setAttribute(*names[c], static_cast<qlonglong>(value));
+				}
+			}
+			else if (type == ColumnType::Strings)
+			{
+				for (auto& element : elements) { element.setAttribute(*names[c], readString()); }
+			}
+			else
+			{
+				m_failed = true;
+			}
+		}
+
+		for (const auto& element : elements) { parent.appendChild(element); }
+	}
+
+	std::uint8_t readByte()
+	{
+		if (m_pos >= m_size) { m_failed = true; return 0; }
+		return m_data[m_pos++];
+	}
+
+	std::uint64_t readVarint()
+	{
+		auto value = std::uint64_t{0};
+		for (int shift = 0; shift < 64; shift += 7)
+		{
+			const std::uint8_t byte = readByte();
+			value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+			if (!(byte & 0x80)) { return value; }
+		}
+		m_failed = true;
+		return 0;
+	}
+
+	const QString& readString()
+	{
+		const std::uint64_t index = readVarint();
+		if (index >= m_strings.size())
+		{
+			m_failed = true;
+			return m_empty;
+		}
+		return m_strings[index];
+	}
+
+	bool fail(QString* error, const char* message)
+	{
+		m_failed = true;
+		if (error) { *error = QString::fromLatin1(message); }
+		return false;
+	}
+
+	const std::uint8_t* m_data;
+	std::size_t m_size;
+	std::size_t m_pos = 0;
+	bool m_failed = false;
+
+	QDomDocument& m_doc;
+	std::vector<QString> m_strings;
+	const QString m_empty;
+};
+
+} // namespace
+
+
+
+
+bool isBinary(const QByteArray& data)
+{
+	return data.size() >= HeaderSize && std::equal(std::begin(Magic), std::end(Magic), data.constData());
+}
+
+
+
+
+QByteArray encode(const QDomDocument& doc)
+{
+	auto writer = Writer();
+	writer.writeChildren(doc);
+
+	auto data = QByteArray(Magic, sizeof(Magic));
+	data.append(static_cast<char>(FormatVersion));
+	data.append(qCompress(writer.finish()));
+	return data;
+}
+
+
+
+
+bool decode(const QByteArray& data, QDomDocument& doc, QString* error)
+{
+	if (!isBinary(data))
+	{
+		if (error) { *error = "not a binary document"; }
+		return false;
+	}
+
+	const auto version = static_cast<std::uint8_t>(data[sizeof(Magic)]);
+	if (version > FormatVersion)
+	{
+		if (error) { *error = QString("format version %1 is newer than this version of LMMS supports").arg(version); }
+		return false;
+	}
+
+	const QByteArray payload = qUncompress(data.mid(HeaderSize));
+	if (payload.isEmpty())
+	{
+		if (error) { *error = "corrupt compressed data"; }
+		return false;
+	}
+
+	return Reader(payload, doc).read(error);
+}
+
+
+} // namespace lmms::BinaryDataFile
@@ -26,30 +26,320 @@
 
 #include "BufferManager.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+
+#include "LmmsSemaphore.h"
+#include "RealtimeMemory.h"
 #include "SampleFrame.h"
 
 
 namespace lmms
 {
 
-fpp_t BufferManager::s_framesPerPeriod;
+fpp_t BufferManager::s_framesPerPeriod = 0;
+
+namespace
+{
+
+//! Number of buffers allocated by init()
+constexpr std::size_t InitialBuffers = 512;
+//! The background thread adds this many buffers when running low
+constexpr std::size_t GrowBuffers = 256;
+//! Free buffer count below which the background thread is woken up
+constexpr std::size_t LowWatermark = 64;
+//! Upper limit of pooled buffers, more are allocated and freed directly
+constexpr std::size_t MaxBuffers = 16384;
+
+constexpr std::uint32_t NoNode = 0xffffffff;
+
+// Each buffer is preceded by a header of one alignment unit which stores
+// the index of its node, so release() doesn't need any lookup.
+struct BufferHeader
+{
+	std::uint32_t node;
+};
+
+static_assert(sizeof(BufferHeader) <= BufferManager::Alignment);
+
+
+class BufferPool
+{
+public:
+	BufferPool() :
+		m_nodes(std::make_unique<Node[]>(MaxBuffers)),
+		m_grower([this] { growLoop(); })
+	{
+	}
+
+	~BufferPool()
+	{
+		m_quit = true;
+		m_growSignal.post();
+		m_grower.join();
+
+		// buffers still in use are leaked deliberately - their owners may
+		// well be destroyed after us
+		for (auto index = m_free.pop(m_nodes.get()); index != NoNode; index = m_free.pop(m_nodes.get()))
+		{
+			RealtimeMemory::unlock(header(m_nodes[index].buffer), bufferSize());
+			freeBuffer(m_nodes[index].buffer);
+		}
+	}
+
+	void init(fpp_t frames)
+	{
+		m_frames = frames;
+		reserve(InitialBuffers);
+	}
+
+	SampleFrame* acquire()
+	{
+		SampleFrame* buf = nullptr;
+		const auto index = m_free.pop(m_nodes.get());
+		if (index != NoNode)
+		{
+			buf = m_nodes[index].buffer;
+			if (m_freeCount.fetch_sub(1, std::memory_order_relaxed) - 1 < LowWatermark) { requestGrowth(); }
+		}
+		else
+		{
+			// pool exhausted - we have no choice but to allocate right here
+			m_misses.fetch_add(1, std::memory_order_relaxed);
+			requestGrowth();
+			buf = allocateNode();
+			if (!buf) { buf = allocateBuffer(NoNode); }
+		}
+
+		const auto inUse = m_inUse.fetch_add(1, std::memory_order_relaxed) + 1;
+		auto highWaterMark = m_highWaterMark.load(std::memory_order_relaxed);
+		while (inUse > highWaterMark
+			&& !m_highWaterMark.compare_exchange_weak(highWaterMark, inUse, std::memory_order_relaxed)) {}
+
+		zeroSampleFrames(buf, m_frames);
+		return buf;
+	}
+
+	void release(SampleFrame* buf)
+	{
+		m_inUse.fetch_sub(1, std::memory_order_relaxed);
+
+		const auto index = header(buf)->node;
+		if (index == NoNode)
+		{
+			freeBuffer(buf);
+			return;
+		}
+		m_free.push(m_nodes.get(), index);
+		m_freeCount.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void reserve(std::size_t count)
+	{
+		const auto lock = std::lock_guard{m_growMutex};
+		while (m_numNodes.load(std::memory_order_relaxed) < std::min(count, MaxBuffers))
+		{
+			SampleFrame* buf = allocateNode();
+			if (!buf) { break; }
+			m_free.push(m_nodes.get(), header(buf)->node);
+			m_freeCount.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	BufferManager::Stats stats() const
+	{
+		return {
+			m_numNodes.load(std::memory_order_relaxed),
+			m_inUse.load(std::memory_order_relaxed),
+			m_highWaterMark.load(std::memory_order_relaxed),
+			m_misses.load(std::memory_order_relaxed)
+		};
+	}
+
+private:
+	struct Node
+	{
+		SampleFrame* buffer = nullptr;
+		std::atomic<std::uint32_t> next = NoNode;
+	};
+
+	//! Treiber stack of node indices. The head is tagged with a counter to
+	//! avoid the ABA problem; nodes are never freed, so reading the next
+	//! index of a node that has been popped meanwhile is harmless.
+	class FreeList
+	{
+	public:
+		void push(Node* nodes, std::uint32_t index)
+		{
+			auto head = m_head.load(std::memory_order_relaxed);
+			do
+			{
+				nodes[index].next.store(static_cast<std::uint32_t>(head), std::memory_order_relaxed);
+			}
+			while (!m_head.compare_exchange_weak(head, tagged(head, index),
+				std::memory_order_release, std::memory_order_relaxed));
+		}
+
+		std::uint32_t pop(Node* nodes)
+		{
+			auto head = m_head.load(std::memory_order_acquire);
+			while (static_cast<std::uint32_t>(head) != NoNode)
+			{
+				const auto index = static_cast<std::uint32_t>(head);
+				const auto next = nodes[index].next.load(std::memory_order_relaxed);
+				if (m_head.compare_exchange_weak(head, tagged(head, next),
+					std::memory_order_acquire, std::memory_order_acquire))
+				{
+					return index;
+				}
+			}
+			return NoNode;
+		}
+
+	private:
+		static std::uint64_t tagged(std::uint64_t oldHead, std::uint32_t index)
+		{
+			return ((oldHead >> 32) + 1) << 32 | index;
+		}
+
+		std::atomic<std::uint64_t> m_head = NoNode;
+	};
+
+	static BufferHeader* header(SampleFrame* buf)
+	{
+		return reinterpret_cast<BufferHeader*>(reinterpret_cast<char*>(buf) - BufferManager::Alignment);
+	}
+
+	SampleFrame* allocateBuffer(std::uint32_t node)
+	{
+		auto mem = static_cast<char*>(::operator new(bufferSize(), std::align_val_t{BufferManager::Alignment}));
+		auto buf = reinterpret_cast<SampleFrame*>(mem + BufferManager::Alignment);
+		std::uninitialized_default_construct_n(buf, m_frames);
+		header(buf)->node = node;
+		return buf;
+	}
+
+	std::size_t bufferSize() const
+	{
+		return BufferManager::Alignment + m_frames * sizeof(SampleFrame);
+	}
+
+	static void freeBuffer(SampleFrame* buf)
+	{
+		::operator delete(reinterpret_cast<char*>(buf) - BufferManager::Alignment,
+			std::align_val_t{BufferManager::Alignment});
+	}
+
+	//! Allocates a new buffer owned by the pool, or returns nullptr if the
+	//! pool is full
+	SampleFrame* allocateNode()
+	{
+		const auto index = m_numNodes.fetch_add(1, std::memory_order_relaxed);
+		if (index >= MaxBuffers)
+		{
+			m_numNodes.fetch_sub(1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		// the node only becomes visible to other threads once it is pushed
+		// to the free list, which orders this store
+		SampleFrame* buf = allocateBuffer(static_cast<std::uint32_t>(index));
+		// the pool is never shrunk, so its buffers stay locked
+		RealtimeMemory::lock(header(buf), bufferSize());
+		m_nodes[index].buffer = buf;
+		return buf;
+	}
+
+	void requestGrowth()
+	{
+		if (!m_growRequested.exchange(true, std::memory_order_relaxed))
+		{
+			m_growSignal.post();
+		}
+	}
+
+	void growLoop()
+	{
+		while (true)
+		{
+			m_growSignal.wait();
+			if (m_quit) { return; }
+
+			reserve(m_numNodes.load(std::memory_order_relaxed) + GrowBuffers);
+			m_growRequested = false;
+		}
+	}
+
+	fpp_t m_frames = 0;
+
+	std::unique_ptr<Node[]> m_nodes;
+	std::atomic_size_t m_numNodes = 0;
+	FreeList m_free;
+
+	std::atomic_size_t m_freeCount = 0;
+	std::atomic_size_t m_inUse = 0;
+	std::atomic_size_t m_highWaterMark = 0;
+	std::atomic_size_t m_misses = 0;
+
+	// serializes growing the pool from non-realtime threads
+	std::mutex m_growMutex;
+	std::atomic<bool> m_growRequested = false;
+	std::atomic<bool> m_quit = false;
+	Semaphore m_growSignal{0};
+	std::thread m_grower;
+};
+
+
+BufferPool& pool()
+{
+	static BufferPool s_pool;
+	return s_pool;
+}
+
+} // namespace
+
+
 
 void BufferManager::init( fpp_t fpp )
 {
 	s_framesPerPeriod = fpp;
+	pool().init( fpp );
 }
 
 
 SampleFrame* BufferManager::acquire()
 {
-	return new SampleFrame[s_framesPerPeriod];
+	return pool().acquire();
 }
 
 
 
 void BufferManager::release( SampleFrame* buf )
 {
-	delete[] buf;
+	if( buf )
+	{
+		pool().release( buf );
+	}
+}
+
+
+
+void BufferManager::reserve( std::size_t count )
+{
+	pool().reserve( count );
+}
+
+
+
+BufferManager::Stats BufferManager::stats()
+{
+	return pool().stats();
 }
 
 } // namespace lmms
@@ -120,6 +120,8 @@ void Clip::movePosition( const TimePos & pos )
 		Engine::audioEngine()->requestChangeInModel();
 		m_startPosition = newPos;
 		Engine::audioEngine()->doneChangeInModel();
+		if (m_track) { m_track->clipMoved(); }
+		TrackContainer::arrangementChanged();
 		Engine::getSong()->updateLength();
 		emit positionChanged();
 	}
@@ -137,7 +139,9 @@ void Clip::movePosition( const TimePos & pos )
  */
 void Clip::changeLength( const TimePos & length )
 {
+	if (m_length != length) { TrackContainer::arrangementChanged(); }
 	m_length = length;
+	if (m_track) { m_track->clipMoved(); }
 	Engine::getSong()->updateLength();
 	emit lengthChanged();
 }
@@ -81,6 +81,11 @@ namespace lmms::Clipboard
 
 	QString decodeKey( const QMimeData * mimeData )
 	{
+		if (const auto dataFileMimeData = dynamic_cast<const DataFileMimeData*>(mimeData);
+			dataFileMimeData && dataFileMimeData->type() == MimeType::StringPair)
+		{
+			return dataFileMimeData->key();
+		}
 		return( QString::fromUtf8( mimeData->data( mimeType( MimeType::StringPair ) ) ).section( ':', 0, 0 ) );
 	}
 
@@ -93,4 +98,74 @@ namespace lmms::Clipboard
 	}
 
 
+
+	void copyDataFile(const DataFile& dataFile, MimeType mT, const QString& key)
+	{
+		QApplication::clipboard()->setMimeData(new DataFileMimeData(dataFile, mT, key), QClipboard::Clipboard);
+	}
+
+
+
+
+	DataFile decodeDataFile(const QMimeData* mimeData, MimeType mT)
+	{
+		if (const auto dataFileMimeData = dynamic_cast<const DataFileMimeData*>(mimeData);
+			dataFileMimeData && dataFileMimeData->type() == mT)
+		{
+			return dataFileMimeData->dataFile();
+		}
+
+		if (!mimeData->hasFormat(mimeType(mT)))
+		{
+			return DataFile(DataFile::Type::Unknown);
+		}
+		const auto value = mT == MimeType::StringPair
+			? decodeValue(mimeData)
+			: QString::fromUtf8(mimeData->data(mimeType(mT)));
+		return DataFile(value.toUtf8());
+	}
+
+
+
+
+	DataFileMimeData::DataFileMimeData(const DataFile& dataFile, MimeType mT, const QString& key) :
+		m_dataFile(dataFile),
+		m_type(mT),
+		m_key(key)
+	{
+	}
+
+
+
+
+	bool DataFileMimeData::hasFormat(const QString& mimeType) const
+	{
+		return mimeType == Clipboard::mimeType(m_type);
+	}
+
+
+
+
+	QStringList DataFileMimeData::formats() const
+	{
+		return {Clipboard::mimeType(m_type)};
+	}
+
+
+
+
+	QVariant DataFileMimeData::retrieveData(const QString& mimeType, QVariant::Type) const
+	{
+		if (!hasFormat(mimeType)) { return QVariant(); }
+
+		if (m_serialized.isEmpty())
+		{
+			m_serialized = m_type == MimeType::StringPair
+				? (m_key + ":" + m_dataFile.toString()).toUtf8()
+				: m_dataFile.toString().toUtf8();
+		}
+		return m_serialized;
+	}
+
+
 } // namespace lmms::Clipboard
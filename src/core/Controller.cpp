@@ -26,6 +26,7 @@
 
 #include <QDomElement>
 
+#include <algorithm>
 #include <vector>
 
 #include "AudioEngine.h"
@@ -40,6 +41,7 @@ namespace lmms
 
 
 long Controller::s_periods = 0;
+long long Controller::s_frames = 0;
 std::vector<Controller*> Controller::s_controllers;
 
 
@@ -48,16 +50,23 @@ Controller::Controller( ControllerType _type, Model * _parent,
 					const QString & _display_name ) :
 	Model( _parent, _display_name ),
 	JournallingObject(),
-	m_valueBuffer( Engine::audioEngine()->framesPerPeriod() ),
+	m_valueBuffer( Engine::audioEngine()->maxFramesPerPeriod() ),
 	m_bufferLastUpdated( -1 ),
 	m_connectionCount( 0 ),
 	m_type( _type )
 {
-	if( _type != ControllerType::Dummy && _type != ControllerType::Midi )
+	if( _type != ControllerType::Dummy )
 	{
+		// MIDI controllers only get to tell about their changes once per period.
+		// The audio thread walks the controllers in triggerFrameCounter().
+		const auto guard = Engine::audioEngine()->requestChangesGuard();
 		s_controllers.push_back(this);
+	}
+	if( _type != ControllerType::Dummy && _type != ControllerType::Midi )
+	{
 		// Determine which name to use
-		for ( uint i=s_controllers.size(); ; i++ )
+		for (auto i = static_cast<uint>(std::count_if(s_controllers.begin(), s_controllers.end(),
+			[](const Controller* c) { return c->type() != ControllerType::Midi; })); ; i++)
 		{
 			QString new_name = QString( tr( "Controller %1" ) )
 					.arg( i );
@@ -86,10 +95,16 @@ Controller::Controller( ControllerType _type, Model * _parent,
 
 Controller::~Controller()
 {
-	auto it = std::find(s_controllers.begin(), s_controllers.end(), this);
-	if (it != s_controllers.end())
 	{
-		s_controllers.erase(it);
+		// controllers of the song may outlive the audio engine
+		const auto guard = Engine::audioEngine()
+			? Engine::audioEngine()->requestChangesGuard()
+			: AudioEngine::RequestChangesGuard{};
+		auto it = std::find(s_controllers.begin(), s_controllers.end(), this);
+		if (it != s_controllers.end())
+		{
+			s_controllers.erase(it);
+		}
 	}
 
 	m_valueBuffer.clear();
@@ -115,6 +130,8 @@ float Controller::value( int offset )
 {
 	if( m_bufferLastUpdated != s_periods )
 	{
+		// within the capacity it was created with, as periods only get shorter
+		m_valueBuffer.resize(Engine::audioEngine()->framesPerPeriod());
 		updateValueBuffer();
 	}
 	return m_valueBuffer.values()[ offset ];
@@ -125,6 +142,7 @@ ValueBuffer * Controller::valueBuffer()
 {
 	if( m_bufferLastUpdated != s_periods )
 	{
+		m_valueBuffer.resize(Engine::audioEngine()->framesPerPeriod());
 		updateValueBuffer();
 	}
 	return &m_valueBuffer;
@@ -141,7 +159,7 @@ void Controller::updateValueBuffer()
 // Get position in frames
 unsigned int Controller::runningFrames()
 {
-	return s_periods * Engine::audioEngine()->framesPerPeriod();
+	return static_cast<unsigned int>(s_frames);
 }
 
 
@@ -154,7 +172,7 @@ float Controller::runningTime()
 
 
 
-void Controller::triggerFrameCounter()
+void Controller::triggerFrameCounter(fpp_t frames)
 {
 	for (Controller * controller : s_controllers)
 	{
@@ -162,10 +180,14 @@ void Controller::triggerFrameCounter()
 		// painting.  If we ever get all the widgets to use or at least check
 		// currentValue() then we can throttle the signal and only use it for
 		// GUI.
-		emit controller->valueChanged();
+		if (controller->valueChangedInPeriod())
+		{
+			emit controller->valueChanged();
+		}
 	}
 
 	s_periods ++;
+	s_frames += frames;
 	//emit s_signaler.triggerValueChanged();
 }
 
@@ -178,6 +200,7 @@ void Controller::resetFrameCounter()
 		controller->m_bufferLastUpdated = 0;
 	}
 	s_periods = 0;
+	s_frames = 0;
 }
 
 
@@ -0,0 +1,39 @@
+/*
+ * CpuTime.cpp - the processing time spent on a part of the project
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "CpuTime.h"
+
+namespace lmms {
+
+std::atomic<int> CpuTime::s_observers = 0;
+
+void CpuTime::addObserver()
+{
+	s_observers.fetch_add(1, std::memory_order_relaxed);
+}
+
+void CpuTime::removeObserver()
+{
+	s_observers.fetch_sub(1, std::memory_order_relaxed);
+}
+
+} // namespace lmms
@@ -29,7 +29,10 @@
 #include <algorithm>
 #include <cmath>
 #include <map>
+#include <mutex>
+#include <optional>
 
+#include <QDataStream>
 #include <QDebug>
 #include <QFile>
 #include <QFileInfo>
@@ -37,21 +40,26 @@
 #include <QMessageBox>
 #include <QRegularExpression>
 #include <QSaveFile>
+#include <QSet>
 
 #include "base64.h"
+#include "BinaryDataFile.h"
 #include "ConfigManager.h"
 #include "Effect.h"
 #include "embed.h"
 #include "GuiApplication.h"
 #include "LocaleHelper.h"
 #include "Note.h"
+#include "PerfLog.h"
 #include "PluginFactory.h"
 #include "ProjectVersion.h"
+#include "SampleBuffer.h"
 #include "SongEditor.h"
 #include "TextFloat.h"
 #include "Track.h"
 #include "PathUtil.h"
 #include "UpgradeExtendedNoteRange.h"
+#include "ZlibDevice.h"
 
 #include "lmmsversion.h"
 
@@ -66,27 +74,54 @@ static void findIds(const QDomElement& elem, QList<jo_id_t>& idList);
 const DataFile::ResourcesMap DataFile::ELEMENTS_WITH_RESOURCES = {
 { "sampleclip", {"src"} },
 { "audiofileprocessor", {"src"} },
+{ "slicert", {"src"} },
 };
 
+std::vector<DataFile*> DataFile::s_bundlingFiles;
+
+namespace
+{
+// DataFiles are also saved and destroyed on other threads, e.g. autosave snapshots
+std::mutex s_bundlingFilesMutex;
+}
+
 // Vector with all the upgrade methods
-const std::vector<DataFile::UpgradeMethod> DataFile::UPGRADE_METHODS = {
-	&DataFile::upgrade_0_2_1_20070501   ,   &DataFile::upgrade_0_2_1_20070508,
-	&DataFile::upgrade_0_3_0_rc2        ,   &DataFile::upgrade_0_3_0,
-	&DataFile::upgrade_0_4_0_20080104   ,   &DataFile::upgrade_0_4_0_20080118,
-	&DataFile::upgrade_0_4_0_20080129   ,   &DataFile::upgrade_0_4_0_20080409,
-	&DataFile::upgrade_0_4_0_20080607   ,   &DataFile::upgrade_0_4_0_20080622,
-	&DataFile::upgrade_0_4_0_beta1      ,   &DataFile::upgrade_0_4_0_rc2,
-	&DataFile::upgrade_1_0_99           ,   &DataFile::upgrade_1_1_0,
-	&DataFile::upgrade_1_1_91           ,   &DataFile::upgrade_1_2_0_rc3,
-	&DataFile::upgrade_1_3_0            ,   &DataFile::upgrade_noHiddenClipNames,
-	&DataFile::upgrade_automationNodes  ,   &DataFile::upgrade_extendedNoteRange,
-	&DataFile::upgrade_defaultTripleOscillatorHQ,
-	&DataFile::upgrade_mixerRename      ,   &DataFile::upgrade_bbTcoRename,
-	&DataFile::upgrade_sampleAndHold    ,   &DataFile::upgrade_midiCCIndexing,
-	&DataFile::upgrade_loopsRename      ,   &DataFile::upgrade_noteTypes,
-	&DataFile::upgrade_fixCMTDelays     ,   &DataFile::upgrade_fixBassLoopsTypo,
-	&DataFile::findProblematicLadspaPlugins,
-	&DataFile::upgrade_noHiddenAutomationTracks
+const std::vector<DataFile::UpgradeStep> DataFile::UPGRADE_METHODS = {
+	{&DataFile::upgrade_0_2_1_20070501},
+	{&DataFile::upgrade_0_2_1_20070508},
+	{&DataFile::upgrade_0_3_0_rc2},
+	{&DataFile::upgrade_0_3_0},
+	{&DataFile::upgrade_0_4_0_20080104},
+	{&DataFile::upgrade_0_4_0_20080118},
+	{&DataFile::upgrade_0_4_0_20080129},
+	{&DataFile::upgrade_0_4_0_20080409},
+	{&DataFile::upgrade_0_4_0_20080607},
+	{&DataFile::upgrade_0_4_0_20080622},
+	{&DataFile::upgrade_0_4_0_beta1},
+	{&DataFile::upgrade_0_4_0_rc2},
+	{&DataFile::upgrade_1_0_99},
+	{&DataFile::upgrade_1_1_0},
+	{&DataFile::upgrade_1_1_91},
+	{&DataFile::upgrade_1_2_0_rc3},
+	{&DataFile::upgrade_1_3_0},
+	{.method = &DataFile::upgrade_noHiddenClipNames, .tagNames = {"track"}},
+	{.method = &DataFile::upgrade_automationNodes, .tagNames = {"automationpattern"}},
+	{.method = &DataFile::upgrade_extendedNoteRange, .tagNames = {"song", "instrumenttrack"}},
+	{.elementUpgrade = &DataFile::upgrade_defaultTripleOscillatorHQ, .tagNames = {"tripleoscillator"}},
+	{.elementUpgrade = &DataFile::upgrade_mixerRename,
+		.tagNames = {"fxmixer", "fxchannel", "instrumenttrack", "sampletrack"},
+		.addedTagNames = {"mixer", "mixerchannel"}},
+	{.elementUpgrade = &DataFile::upgrade_bbTcoRename,
+		.tagNames = {"automationpattern", "bbtco", "pattern", "sampletco", "bbtrack", "bbtrackcontainer", "track"},
+		.addedTagNames = {"automationclip", "patternclip", "midiclip", "sampleclip", "patterntrack", "patternstore"}},
+	{.elementUpgrade = &DataFile::upgrade_sampleAndHold, .tagNames = {"lfocontroller"}},
+	{.elementUpgrade = &DataFile::upgrade_midiCCIndexing, .tagNames = {"Midicontroller"}},
+	{.elementUpgrade = &DataFile::upgrade_loopsRename, .tagNames = {"sampleclip", "audiofileprocessor", "slicert"}},
+	{.elementUpgrade = &DataFile::upgrade_noteTypes, .tagNames = {"note"}},
+	{.elementUpgrade = &DataFile::upgrade_fixCMTDelays, .tagNames = {"effect"}},
+	{.elementUpgrade = &DataFile::upgrade_fixBassLoopsTypo, .tagNames = {"sampleclip", "audiofileprocessor", "slicert"}},
+	{.method = &DataFile::findProblematicLadspaPlugins, .tagNames = {"ladspacontrols"}},
+	{.method = &DataFile::upgrade_noHiddenAutomationTracks, .tagNames = {"track"}, .addedTagNames = {"automationtrack"}},
 };
 
 // Vector of all versions that have upgrade routines.
@@ -174,7 +209,14 @@ DataFile::DataFile( const QString & _fileName ) :
 		return;
 	}
 
-	loadData( inFile.readAll(), _fileName );
+	if (isZlibCompressed(inFile.peek(6)))
+	{
+		loadCompressedData(inFile, _fileName);
+	}
+	else
+	{
+		loadData(inFile.readAll(), _fileName);
+	}
 }
 
 
@@ -193,13 +235,21 @@ DataFile::DataFile( const QByteArray & _data ) :
 
 
 
+DataFile::~DataFile()
+{
+	setBundlesSamples(false);
+}
+
+
+
+
 
 bool DataFile::validate( QString extension )
 {
 	switch( m_type )
 	{
 	case Type::SongProject:
-		if( extension == "mmp" || extension == "mmpz" )
+		if( extension == "mmp" || extension == "mmpz" || extension == BinaryDataFile::SongProjectExtension )
 		{
 			return true;
 		}
@@ -224,6 +274,7 @@ bool DataFile::validate( QString extension )
 		break;
 	case Type::Unknown:
 		if (! ( extension == "mmp" || extension == "mpt" || extension == "mmpz" ||
+				extension == BinaryDataFile::SongProjectExtension ||
 				extension == "xpf" || extension == "xml" ||
 				( extension == "xiz" && ! getPluginFactory()->pluginSupportingExtension(extension).isNull()) ||
 				extension == "sf2" || extension == "sf3" || extension == "pat" || extension == "mid" ||
@@ -265,7 +316,8 @@ QString DataFile::nameWithExtension( const QString & _fn ) const
 		case Type::SongProject:
 			if( extension != "mmp" &&
 					extension != "mpt" &&
-					extension != "mmpz" )
+					extension != "mmpz" &&
+					extension != BinaryDataFile::SongProjectExtension )
 			{
 				if( ConfigManager::inst()->value( "app",
 						"nommpz" ).toInt() == 0 )
@@ -296,14 +348,21 @@ QString DataFile::nameWithExtension( const QString & _fn ) const
 
 
 void DataFile::write( QTextStream & _strm )
+{
+	prepareForWriting();
+	save(_strm, 2);
+}
+
+
+
+
+void DataFile::prepareForWriting()
 {
 	if( type() == Type::SongProject || type() == Type::SongProjectTemplate
 					|| type() == Type::InstrumentTrackSettings )
 	{
 		cleanMetaNodes( documentElement() );
 	}
-
-	save(_strm, 2);
 }
 
 
@@ -384,6 +443,14 @@ bool DataFile::writeFile(const QString& filename, bool withResources)
 				SongEditor::tr("Failed to copy resources."));
 			return false;
 		}
+
+		// Write the samples that aren't stored in a file
+		if (!writeBundledSamples(resourcesDir))
+		{
+			showError(SongEditor::tr("Error"),
+				SongEditor::tr("Failed to write embedded samples."));
+			return false;
+		}
 	}
 
 	QSaveFile outfile(fullNameTemp);
@@ -398,19 +465,7 @@ bool DataFile::writeFile(const QString& filename, bool withResources)
 		return false;
 	}
 
-	const QString extension = fullName.section('.', -1);
-	if (extension == "mmpz" || extension == "xptz")
-	{
-		QString xml;
-		QTextStream ts( &xml );
-		write( ts );
-		outfile.write( qCompress( xml.toUtf8() ) );
-	}
-	else
-	{
-		QTextStream ts( &outfile );
-		write( ts );
-	}
+	writeContent(outfile, fullName.section('.', -1));
 
 	if (!outfile.commit())
 	{
@@ -440,6 +495,63 @@ bool DataFile::writeFile(const QString& filename, bool withResources)
 
 
 
+bool DataFile::writeFileAtomically(const QString& filename)
+{
+	QSaveFile outfile(filename);
+	if (!outfile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		qWarning() << "Could not open" << filename << "for writing";
+		return false;
+	}
+
+	writeContent(outfile, filename.section('.', -1));
+
+	if (!outfile.commit())
+	{
+		qWarning() << "Could not write" << filename;
+		return false;
+	}
+	return true;
+}
+
+
+
+
+void DataFile::writeContent(QSaveFile& outfile, const QString& extension)
+{
+	if (extension == BinaryDataFile::SongProjectExtension)
+	{
+		prepareForWriting();
+		outfile.write(BinaryDataFile::encode(*this));
+	}
+	else if (extension == "mmpz" || extension == "xptz")
+	{
+		// compressed on worker threads while being written, instead of
+		// holding the XML text, its UTF-8 and the compressed data at once
+		auto deflating = DeflatingDevice(&outfile);
+		if (!deflating.open(QIODevice::WriteOnly))
+		{
+			outfile.cancelWriting();
+		}
+		else
+		{
+			QTextStream ts(&deflating);
+			write(ts);
+			ts.flush();
+			deflating.close();
+			if (deflating.error()) { outfile.cancelWriting(); }
+		}
+	}
+	else
+	{
+		QTextStream ts( &outfile );
+		write( ts );
+	}
+}
+
+
+
+
 bool DataFile::copyResources(const QString& resourcesDir)
 {
 	// List of filenames used so we can append a counter to any
@@ -463,8 +575,8 @@ bool DataFile::copyResources(const QString& resourcesDir)
 			// Search for attributes that point to resources
 			while (res != it->second.end())
 			{
-				// If the element has that attribute
-				if (el.hasAttribute(*res))
+				// If the element has that attribute (empty for embedded samples)
+				if (!el.attribute(*res).isEmpty())
 				{
 					// Get absolute path to resource
 					bool error;
@@ -524,6 +636,115 @@ bool DataFile::copyResources(const QString& resourcesDir)
 
 
 
+void DataFile::setBundlesSamples(bool bundlesSamples)
+{
+	if (bundlesSamples == m_bundlesSamples) { return; }
+	m_bundlesSamples = bundlesSamples;
+
+	const auto lock = std::lock_guard{s_bundlingFilesMutex};
+	if (bundlesSamples) { s_bundlingFiles.push_back(this); }
+	else
+	{
+		std::erase(s_bundlingFiles, this);
+		m_bundledSamples.clear();
+	}
+}
+
+
+
+
+bool DataFile::bundleSample(QDomDocument& doc, const QDomElement& element, std::shared_ptr<const SampleBuffer> buffer)
+{
+	if (!buffer || buffer->empty()) { return false; }
+
+	const auto lock = std::lock_guard{s_bundlingFilesMutex};
+	const auto it = std::find_if(s_bundlingFiles.begin(), s_bundlingFiles.end(),
+		[&doc](const DataFile* file) { return static_cast<const QDomDocument*>(file) == &doc; });
+	if (it == s_bundlingFiles.end()) { return false; }
+
+	(*it)->m_bundledSamples.emplace_back(element, std::move(buffer));
+	return true;
+}
+
+
+
+
+bool DataFile::writeBundledSamples(const QString& resourcesDir)
+{
+	// Frames converted and written at once
+	constexpr auto ChunkFrames = std::size_t{65536};
+
+	for (auto i = std::size_t{0}; i < m_bundledSamples.size(); ++i)
+	{
+		auto& [element, buffer] = m_bundledSamples[i];
+
+		// Plain 32 bit float WAV files, SampleBuffer maps their frames into memory
+		// when loading them instead of decoding them
+		const auto dataBytes = static_cast<quint64>(buffer->size()) * sizeof(SampleFrame);
+		if (dataBytes > 0xffffffffu - 36)
+		{
+			qWarning("ERROR: Embedded sample too large for a WAV file");
+			return false;
+		}
+
+		const QString fileName = QString("embedded-sample-%1.wav").arg(i + 1);
+		QSaveFile file(resourcesDir + "/" + fileName);
+		if (!file.open(QIODevice::WriteOnly)) { return false; }
+
+		QDataStream stream(&file);
+		stream.setByteOrder(QDataStream::LittleEndian);
+		stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+		const auto sampleRate = static_cast<quint32>(buffer->sampleRate());
+		stream.writeRawData("RIFF", 4);
+		stream << static_cast<quint32>(36 + dataBytes);
+		stream.writeRawData("WAVE", 4);
+		stream.writeRawData("fmt ", 4);
+		stream << quint32{16}
+			<< quint16{3} // IEEE float
+			<< quint16{DEFAULT_CHANNELS}
+			<< sampleRate
+			<< static_cast<quint32>(sampleRate * sizeof(SampleFrame))
+			<< static_cast<quint16>(sizeof(SampleFrame))
+			<< quint16{32};
+		stream.writeRawData("data", 4);
+		stream << static_cast<quint32>(dataBytes);
+
+		auto chunk = std::vector<SampleFrame>(std::min(ChunkFrames, buffer->size()));
+		for (auto first = std::size_t{0}; first < buffer->size(); first += chunk.size())
+		{
+			const auto count = std::min(chunk.size(), buffer->size() - first);
+			buffer->read(first, count, chunk.data());
+
+			if (QSysInfo::ByteOrder == QSysInfo::LittleEndian)
+			{
+				stream.writeRawData(reinterpret_cast<const char*>(chunk.data()),
+					static_cast<int>(count * sizeof(SampleFrame)));
+			}
+			else
+			{
+				for (auto frame = std::size_t{0}; frame < count; ++frame)
+				{
+					stream << chunk[frame].left() << chunk[frame].right();
+				}
+			}
+		}
+
+		if (stream.status() != QDataStream::Ok || !file.commit())
+		{
+			qWarning("ERROR: Failed to write embedded sample");
+			return false;
+		}
+
+		element.setAttribute("src", PathUtil::basePrefix(PathUtil::Base::LocalDir) + "resources/" + fileName);
+	}
+
+	return true;
+}
+
+
+
+
 /**
  * @brief This recursive method will go through all XML nodes of the DataFile
  *        and check whether any of them have local paths. If they are not on
@@ -647,28 +868,19 @@ void DataFile::cleanMetaNodes( QDomElement _de )
 	}
 }
 
-void DataFile::mapSrcAttributeInElementsWithResources(const QMap<QString, QString>& map)
+void DataFile::mapSrcAttributes(QDomElement& element, const QMap<QString, QString>& map)
 {
-	for (const auto& [elem, srcAttrs] : ELEMENTS_WITH_RESOURCES)
+	const auto srcAttrs = ELEMENTS_WITH_RESOURCES.find(element.tagName());
+	if (srcAttrs == ELEMENTS_WITH_RESOURCES.end()) { return; }
+
+	for (const auto& srcAttr : srcAttrs->second)
 	{
-		auto elements = elementsByTagName(elem);
+		if (!element.hasAttribute(srcAttr)) { continue; }
 
-		for (const auto& srcAttr : srcAttrs)
+		const auto it = map.constFind(element.attribute(srcAttr));
+		if (it != map.constEnd())
 		{
-			for (int i = 0; i < elements.length(); ++i)
-			{
-				auto item = elements.item(i).toElement();
-
-				if (item.isNull() || !item.hasAttribute(srcAttr)) { continue; }
-
-				const QString srcVal = item.attribute(srcAttr);
-
-				const auto it = map.constFind(srcVal);
-				if (it != map.constEnd())
-				{
-					item.setAttribute(srcAttr, *it);
-				}
-			}
+			element.setAttribute(srcAttr, *it);
 		}
 	}
 }
@@ -1745,24 +1957,17 @@ void DataFile::upgrade_automationNodes()
 }
 
 // Convert the negative length notes to StepNotes
-void DataFile::upgrade_noteTypes()
+void DataFile::upgrade_noteTypes(QDomElement& note)
 {
-	const auto notes = elementsByTagName("note");
-
-	for (int i = 0; i < notes.size(); ++i)
+	const auto noteSize = note.attribute("len").toInt();
+	if (noteSize < 0)
 	{
-		auto note = notes.item(i).toElement();
-
-		const auto noteSize = note.attribute("len").toInt();
-		if (noteSize < 0)
-		{
-			note.setAttribute("len", DefaultTicksPerBar / 16);
-			note.setAttribute("type", static_cast<int>(Note::Type::Step));
-		}
+		note.setAttribute("len", DefaultTicksPerBar / 16);
+		note.setAttribute("type", static_cast<int>(Note::Type::Step));
 	}
 }
 
-void DataFile::upgrade_fixCMTDelays()
+void DataFile::upgrade_fixCMTDelays(QDomElement& effect)
 {
 	static const QMap<QString, QString> nameMap {
 		{ "delay_0,01s", "delay_0.01s" },
@@ -1771,30 +1976,23 @@ void DataFile::upgrade_fixCMTDelays()
 		{ "fbdelay_0,1s", "fbdelay_0.1s" }
 	};
 
-	const auto effects = elementsByTagName("effect");
+	// We are only interested in LADSPA plugins
+	if (effect.attribute("name") != "ladspaeffect") { return; }
 
-	for (int i = 0; i < effects.size(); ++i)
+	// Fetch all attributes (LMMS) beneath the LADSPA effect so that we can check the value of the plugin attribute (XML)
+	auto attributes = effect.elementsByTagName("attribute");
+	for (int j = 0; j < attributes.size(); ++j)
 	{
-		auto effect = effects.item(i).toElement();
-
-		// We are only interested in LADSPA plugins
-		if (effect.attribute("name") != "ladspaeffect") { continue; }
+		auto attribute = attributes.item(j).toElement();
 
-		// Fetch all attributes (LMMS) beneath the LADSPA effect so that we can check the value of the plugin attribute (XML)
-		auto attributes = effect.elementsByTagName("attribute");
-		for (int j = 0; j < attributes.size(); ++j)
+		if (attribute.attribute("name") == "plugin")
 		{
-			auto attribute = attributes.item(j).toElement();
+			const auto attributeValue = attribute.attribute("value");
 
-			if (attribute.attribute("name") == "plugin")
+			const auto it = nameMap.constFind(attributeValue);
+			if (it != nameMap.constEnd())
 			{
-				const auto attributeValue = attribute.attribute("value");
-
-				const auto it = nameMap.constFind(attributeValue);
-				if (it != nameMap.constEnd())
-				{
-					attribute.setAttribute("value", *it);
-				}
+				attribute.setAttribute("value", *it);
 			}
 		}
 	}
@@ -1820,87 +2018,45 @@ void DataFile::upgrade_extendedNoteRange()
  * Older projects were made without this feature and would sound differently if loaded
  * with the new default setting. This upgrade routine preserves their old behavior.
  */
-void DataFile::upgrade_defaultTripleOscillatorHQ()
+void DataFile::upgrade_defaultTripleOscillatorHQ(QDomElement& tripleoscillator)
 {
-	QDomNodeList tripleoscillators = elementsByTagName("tripleoscillator");
-	for (int i = 0; !tripleoscillators.item(i).isNull(); i++)
+	for (int j = 1; j <= 3; j++)
 	{
-		for (int j = 1; j <= 3; j++)
+		// Only set the attribute if it does not exist (default template has it but reports as 1.2.0)
+		if (tripleoscillator.attribute("useWaveTable" + QString::number(j)) == "")
 		{
-			// Only set the attribute if it does not exist (default template has it but reports as 1.2.0)
-			if (tripleoscillators.item(i).toElement().attribute("useWaveTable" + QString::number(j)) == "")
-			{
-				tripleoscillators.item(i).toElement().setAttribute("useWaveTable" + QString::number(j), 0);
-			}
+			tripleoscillator.setAttribute("useWaveTable" + QString::number(j), 0);
 		}
 	}
 }
 
 
 // Remove FX prefix from mixer and related nodes
-void DataFile::upgrade_mixerRename()
+void DataFile::upgrade_mixerRename(QDomElement& element)
 {
 	// Change nodename <fxmixer> to <mixer>
-	QDomNodeList fxmixer = elementsByTagName("fxmixer");
-	for (int i = 0; i < fxmixer.length(); ++i)
+	if (element.tagName() == "fxmixer")
 	{
-		auto item = fxmixer.item(i).toElement();
-		if (item.isNull())
-		{
-			continue;
-		}
-		item.setTagName("mixer");
+		element.setTagName("mixer");
 	}
-
 	// Change nodename <fxchannel> to <mixerchannel>
-	QDomNodeList fxchannel = elementsByTagName("fxchannel");
-	for (int i = 0; i < fxchannel.length(); ++i)
+	else if (element.tagName() == "fxchannel")
 	{
-		auto item = fxchannel.item(i).toElement();
-		if (item.isNull())
-		{
-			continue;
-		}
-		item.setTagName("mixerchannel");
+		element.setTagName("mixerchannel");
 	}
-
-	// Change the attribute fxch of element <instrumenttrack> to mixch
-	QDomNodeList fxch = elementsByTagName("instrumenttrack");
-	for (int i = 0; i < fxch.length(); ++i)
+	// Change the attribute fxch of elements <instrumenttrack> and <sampletrack> to mixch
+	else if (element.hasAttribute("fxch"))
 	{
-		auto item = fxch.item(i).toElement();
-		if (item.isNull())
-		{
-			continue;
-		}
-		if (item.hasAttribute("fxch"))
-		{
-			item.setAttribute("mixch", item.attribute("fxch"));
-			item.removeAttribute("fxch");
-		}
-	}
-	// Change the attribute fxch of element <sampletrack> to mixch
-	fxch = elementsByTagName("sampletrack");
-	for (int i = 0; i < fxch.length(); ++i)
-	{
-		auto item = fxch.item(i).toElement();
-		if (item.isNull())
-		{
-			continue;
-		}
-		if (item.hasAttribute("fxch"))
-		{
-			item.setAttribute("mixch", item.attribute("fxch"));
-			item.removeAttribute("fxch");
-		}
+		element.setAttribute("mixch", element.attribute("fxch"));
+		element.removeAttribute("fxch");
 	}
 }
 
 
 // Rename BB to pattern and TCO to clip
-void DataFile::upgrade_bbTcoRename()
+void DataFile::upgrade_bbTcoRename(QDomElement& element)
 {
-	std::vector<std::pair<const char *, const char *>> names {
+	static const QMap<QString, QString> names {
 		{"automationpattern", "automationclip"},
 		{"bbtco", "patternclip"},
 		{"pattern", "midiclip"},
@@ -1909,41 +2065,29 @@ void DataFile::upgrade_bbTcoRename()
 		{"bbtrackcontainer", "patternstore"},
 	};
 	// Replace names of XML tags
-	for (auto name : names)
+	const auto name = names.constFind(element.tagName());
+	if (name != names.constEnd())
 	{
-		QDomNodeList elements = elementsByTagName(name.first);
-		for (int i = 0; !elements.item(i).isNull(); ++i)
-		{
-			elements.item(i).toElement().setTagName(name.second);
-		}
+		element.setTagName(*name);
+		return;
 	}
+
 	// Replace "Beat/Bassline" with "Pattern" in track names
-	QDomNodeList elements = elementsByTagName("track");
-	for (int i = 0; !elements.item(i).isNull(); ++i)
+	static_assert(Track::Type::Pattern == static_cast<Track::Type>(1), "Must be type=1 for backwards compatibility");
+	if (static_cast<Track::Type>(element.attribute("type").toInt()) == Track::Type::Pattern)
 	{
-		auto e = elements.item(i).toElement();
-		static_assert(Track::Type::Pattern == static_cast<Track::Type>(1), "Must be type=1 for backwards compatibility");
-		if (static_cast<Track::Type>(e.attribute("type").toInt()) == Track::Type::Pattern)
-		{
-			e.setAttribute("name", e.attribute("name").replace("Beat/Bassline", "Pattern"));
-		}
+		element.setAttribute("name", element.attribute("name").replace("Beat/Bassline", "Pattern"));
 	}
 }
 
 
 // Set LFO speed to 0.01 on projects made before sample-and-hold PR
-void DataFile::upgrade_sampleAndHold()
+void DataFile::upgrade_sampleAndHold(QDomElement& lfoController)
 {
-	QDomNodeList elements = elementsByTagName("lfocontroller");
-	for (int i = 0; i < elements.length(); ++i)
+	// Correct old random wave LFO speeds
+	if (lfoController.attribute("wave").toInt() == 6)
 	{
-		if (elements.item(i).isNull()) { continue; }
-		auto e = elements.item(i).toElement();
-		// Correct old random wave LFO speeds
-		if (e.attribute("wave").toInt() == 6)
-		{
-			e.setAttribute("speed", 0.01f);
-		}
+		lfoController.setAttribute("speed", 0.01f);
 	}
 }
 
@@ -2001,31 +2145,25 @@ static QMap<QString, QString> buildReplacementMap()
 }
 
 // Change loops' filenames in <sampleclip>s
-void DataFile::upgrade_loopsRename()
+void DataFile::upgrade_loopsRename(QDomElement& element)
 {
 	static const QMap<QString, QString> namesToNamesWithBPMsMap = buildReplacementMap();
 
-	mapSrcAttributeInElementsWithResources(namesToNamesWithBPMsMap);
+	mapSrcAttributes(element, namesToNamesWithBPMsMap);
 }
 
 //! Update MIDI CC indexes, so that they are counted from 0. Older releases of LMMS
 //! count the CCs from 1.
-void DataFile::upgrade_midiCCIndexing()
+void DataFile::upgrade_midiCCIndexing(QDomElement& midiController)
 {
 	static constexpr std::array attributesToUpdate{"inputcontroller", "outputcontroller"};
 
-	QDomNodeList elements = elementsByTagName("Midicontroller");
-	for(int i = 0; i < elements.length(); i++)
+	for (const char* attrName : attributesToUpdate)
 	{
-		if (elements.item(i).isNull()) { continue; }
-		auto element = elements.item(i).toElement();
-		for (const char* attrName : attributesToUpdate)
+		if (midiController.hasAttribute(attrName))
 		{
-			if (element.hasAttribute(attrName))
-			{
-				int cc = element.attribute(attrName).toInt();
-				element.setAttribute(attrName, cc - 1);
-			}
+			int cc = midiController.attribute(attrName).toInt();
+			midiController.setAttribute(attrName, cc - 1);
 		}
 	}
 }
@@ -2063,7 +2201,7 @@ void DataFile::findProblematicLadspaPlugins()
 	}
 }
 
-void DataFile::upgrade_fixBassLoopsTypo()
+void DataFile::upgrade_fixBassLoopsTypo(QDomElement& element)
 {
 	static const QMap<QString, QString> replacementMap = {
 		{ "bassloopes/briff01.ogg", "bassloops/briff01 - 140 BPM.ogg" },
@@ -2078,19 +2216,109 @@ void DataFile::upgrade_fixBassLoopsTypo()
 		{ "bassloopes/techno_synth04.ogg", "bassloops/techno_synth04 - 140 BPM.ogg" }
 	};
 
-	mapSrcAttributeInElementsWithResources(replacementMap);
+	mapSrcAttributes(element, replacementMap);
 }
 
+namespace
+{
+
+//! Calls @p function for @p root and all elements below it, in document order
+template<typename Function>
+void forEachElement(QDomElement root, Function function)
+{
+	auto element = root;
+	while (!element.isNull())
+	{
+		function(element);
+
+		auto next = element.firstChildElement();
+		for (auto e = element; next.isNull() && !e.isNull() && e != root; e = e.parentNode().toElement())
+		{
+			next = e.nextSiblingElement();
+		}
+		element = next;
+	}
+}
+
+bool containsTagName(const std::vector<QString>& tagNames, const QString& tagName)
+{
+	return std::find(tagNames.begin(), tagNames.end(), tagName) != tagNames.end();
+}
+
+} // namespace
+
+
+
+
+void DataFile::upgradeElements(const std::vector<const UpgradeStep*>& steps)
+{
+	const auto timer = PerfLogReport::Timer("Upgrade", QString("to versions %1-%2")
+		.arg(steps.front() - UPGRADE_METHODS.data() + 1).arg(steps.back() - UPGRADE_METHODS.data() + 1));
+	forEachElement(documentElement(), [&steps](QDomElement& element)
+	{
+		// in the order of the steps, and checking the tag name before each
+		// one, as steps may rename elements for the later ones
+		for (const auto step : steps)
+		{
+			if (containsTagName(step->tagNames, element.tagName()))
+			{
+				step->elementUpgrade(element);
+			}
+		}
+	});
+}
+
+
+
+
 void DataFile::upgrade()
 {
-	// Runs all necessary upgrade methods
+	// The tag names in the document, to skip the steps which would find
+	// nothing to upgrade. Only collected once needed, and again after any
+	// step which may add any element.
+	auto tagNames = std::optional<QSet<QString>>();
+	const auto hasElementsFor = [this, &tagNames](const UpgradeStep& step)
+	{
+		if (step.tagNames.empty()) { return true; }
+		if (!tagNames)
+		{
+			tagNames.emplace();
+			forEachElement(documentElement(), [&tagNames](QDomElement& e) { tagNames->insert(e.tagName()); });
+		}
+		return std::any_of(step.tagNames.begin(), step.tagNames.end(),
+			[&tagNames](const QString& tagName) { return tagNames->contains(tagName); });
+	};
+
+	// Runs all necessary upgrade steps, consecutive element upgrades at once
+	auto elementSteps = std::vector<const UpgradeStep*>();
 	std::size_t max = std::min(static_cast<std::size_t>(m_fileVersion), UPGRADE_METHODS.size());
-	std::for_each( UPGRADE_METHODS.begin() + max, UPGRADE_METHODS.end(),
-		[this](UpgradeMethod um)
+	for (auto step = UPGRADE_METHODS.begin() + max; step != UPGRADE_METHODS.end(); ++step)
+	{
+		if (!hasElementsFor(*step)) { continue; }
+
+		if (step->elementUpgrade)
+		{
+			elementSteps.push_back(&*step);
+		}
+		else
 		{
-			(this->*um)();
+			if (!elementSteps.empty())
+			{
+				upgradeElements(elementSteps);
+				elementSteps.clear();
+			}
+			const auto timer = PerfLogReport::Timer("Upgrade",
+				QString("to version %1").arg(step - UPGRADE_METHODS.begin() + 1));
+			(this->*step->method)();
 		}
-	);
+
+		if (step->tagNames.empty()) { tagNames.reset(); }
+		else if (tagNames)
+		{
+			for (const auto& tagName : step->addedTagNames) { tagNames->insert(tagName); }
+		}
+	}
+	if (!elementSteps.empty()) { upgradeElements(elementSteps); }
 
 	// Bump the file version (which should be the size of the upgrade methods vector)
 	m_fileVersion = UPGRADE_METHODS.size();
@@ -2122,9 +2350,20 @@ void DataFile::upgrade()
 
 void DataFile::loadData( const QByteArray & _data, const QString & _sourceFile )
 {
+	auto parseTimer = PerfLogReport::Timer("Parse", QFileInfo(_sourceFile).fileName());
 	QString errorMsg;
 	int line = -1, col = -1;
-	if( !setContent( _data, &errorMsg, &line, &col ) )
+	if (BinaryDataFile::isBinary(_data))
+	{
+		// built right from the binary data, without going through XML
+		if (!BinaryDataFile::decode(_data, *this, &errorMsg))
+		{
+			qWarning() << "Error in binary file" << _sourceFile << ":" << errorMsg;
+			showLoadError(_sourceFile);
+			return;
+		}
+	}
+	else if( !setContent( _data, &errorMsg, &line, &col ) )
 	{
 		// parsing failed? then try to uncompress data
 		QByteArray uncompressed = qUncompress( _data );
@@ -2137,23 +2376,58 @@ void DataFile::loadData( const QByteArray & _data, const QString & _sourceFile )
 		}
 		if( line >= 0 && col >= 0 )
 		{
-			using gui::SongEditor;
-
 			qWarning() << "at line" << line << "column" << errorMsg;
-			if (gui::getGUI() != nullptr)
-			{
-				QMessageBox::critical( nullptr,
-					SongEditor::tr( "Error in file" ),
-					SongEditor::tr( "The file %1 seems to contain "
-							"errors and therefore can't be "
-							"loaded." ).
-								arg( _sourceFile ) );
-			}
-
+			showLoadError(_sourceFile);
 			return;
 		}
 	}
+	parseTimer.end();
+
+	loadContent(_sourceFile);
+}
+
+
+
+
+void DataFile::loadCompressedData(QIODevice& compressed, const QString& sourceFile)
+{
+	// decompressed while parsing, so the uncompressed XML is never held in memory as a whole
+	auto parseTimer = PerfLogReport::Timer("Parse", QFileInfo(sourceFile).fileName());
+	auto inflating = InflatingDevice(&compressed);
+	QString errorMsg;
+	int line = -1, col = -1;
+	if (!inflating.open(QIODevice::ReadOnly) || !setContent(&inflating, &errorMsg, &line, &col)
+		|| inflating.error())
+	{
+		qWarning() << "at line" << line << "column" << col << errorMsg;
+		showLoadError(sourceFile);
+		return;
+	}
+	parseTimer.end();
+
+	loadContent(sourceFile);
+}
+
 
+
+
+void DataFile::showLoadError(const QString& sourceFile)
+{
+	if (gui::getGUI() != nullptr)
+	{
+		QMessageBox::critical(nullptr,
+			gui::SongEditor::tr("Error in file"),
+			gui::SongEditor::tr("The file %1 seems to contain "
+					"errors and therefore can't be "
+					"loaded.").arg(sourceFile));
+	}
+}
+
+
+
+
+void DataFile::loadContent(const QString& _sourceFile)
+{
 	QDomElement root = documentElement();
 	m_type = type( root.attribute( "type" ) );
 	m_head = root.elementsByTagName( "head" ).item( 0 ).toElement();
@@ -139,6 +139,54 @@ bool Effect::processAudioBuffer(SampleFrame* buf, const fpp_t frames)
 
 
 
+bool Effect::processFused(std::span<Effect* const> effects, SampleFrame* buf, const fpp_t frames,
+	bool hasInputNoise)
+{
+	bool anyActive = false;
+	for (const auto effect : effects)
+	{
+		effect->m_fusedActive = false;
+		if (!hasInputNoise && !effect->isRunning()) { continue; }
+
+		if (!effect->isOkay() || effect->dontRun() || !effect->isEnabled() || !effect->isRunning())
+		{
+			effect->processBypassedImpl();
+			continue;
+		}
+		effect->m_fusedActive = true;
+		// only check for silence if it matters
+		effect->m_fusedQuiet = effect->m_autoQuitEnabled;
+		anyActive = true;
+	}
+	if (!anyActive) { return false; }
+
+	for (fpp_t start = 0; start < frames; start += FusedBlockFrames)
+	{
+		const auto end = std::min<fpp_t>(start + FusedBlockFrames, frames);
+		for (const auto effect : effects)
+		{
+			if (!effect->m_fusedActive) { continue; }
+
+			const auto time = CpuTime::Scope{&effect->m_cpuTime};
+			effect->processFrames(buf, start, end);
+			if (effect->m_fusedQuiet) { effect->m_fusedQuiet = isQuiet({buf + start, buf + end}); }
+		}
+	}
+
+	bool moreEffects = false;
+	for (const auto effect : effects)
+	{
+		if (!effect->m_fusedActive) { continue; }
+
+		if (effect->m_autoQuitEnabled) { effect->updateAutoQuit(effect->m_fusedQuiet); }
+		moreEffects |= effect->isRunning();
+	}
+	return moreEffects;
+}
+
+
+
+
 Effect * Effect::instantiate( const QString& pluginName,
 				Model * _parent,
 				Descriptor::SubPluginFeatures::Key * _key )
@@ -169,6 +217,14 @@ void Effect::handleAutoQuit(std::span<const SampleFrame> output)
 		return;
 	}
 
+	updateAutoQuit(isQuiet(output));
+}
+
+
+
+
+bool Effect::isQuiet(std::span<const SampleFrame> output)
+{
 	/*
 	 * In the past, the RMS was calculated then compared with a threshold of 10^(-10).
 	 * Now we use a different algorithm to determine whether a buffer is non-quiet, so
@@ -192,19 +248,29 @@ void Effect::handleAutoQuit(std::span<const SampleFrame> output)
 	 */
 	static constexpr auto threshold = 0.0001431f;
 
-	// Check whether we need to continue processing input. Restart the
-	// counter if the threshold has been exceeded.
-
 	for (const SampleFrame& frame : output)
 	{
 		const auto abs = frame.abs();
 		if (abs.left() >= threshold || abs.right() >= threshold)
 		{
-			// The output buffer is not quiet
-			m_quietBufferCount = 0;
-			return;
+			return false;
 		}
 	}
+	return true;
+}
+
+
+
+
+void Effect::updateAutoQuit(bool quiet)
+{
+	// Check whether we need to continue processing input. Restart the
+	// counter if the threshold has been exceeded.
+	if (!quiet)
+	{
+		m_quietBufferCount = 0;
+		return;
+	}
 
 	// The output buffer is quiet, so check if auto-quit should be activated yet
 	if (++m_quietBufferCount > timeout())
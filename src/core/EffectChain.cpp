@@ -25,22 +25,112 @@
 
 
 #include <QDomElement>
+#include <algorithm>
 #include <cassert>
+#include <span>
 
 #include "EffectChain.h"
+#include "AudioEngineWorkerThread.h"
 #include "Effect.h"
 #include "DummyEffect.h"
 #include "MixHelpers.h"
+#include "ThreadableJob.h"
 
 namespace lmms
 {
 
+namespace
+{
+
+bool processEffects(std::span<Effect* const> effects, SampleFrame* buf, const fpp_t frames, bool hasInputNoise)
+{
+	bool moreEffects = false;
+	for (auto it = effects.begin(); it != effects.end();)
+	{
+		const auto fusedEnd = std::find_if_not(it, effects.end(), [](const Effect* e) { return e->isFusible(); });
+		if (fusedEnd - it > 1)
+		{
+			AudioEngineProfiler::TraceScope trace(Engine::audioEngine()->profiler(), "Effect", "Fused effects",
+				reinterpret_cast<std::uintptr_t>(*it));
+			moreEffects |= Effect::processFused({it, fusedEnd}, buf, frames, hasInputNoise);
+			it = fusedEnd;
+			continue;
+		}
+
+		const auto effect = *it++;
+		if (hasInputNoise || effect->isRunning())
+		{
+			AudioEngineProfiler::TraceScope trace(Engine::audioEngine()->profiler(), "Effect",
+				effect->descriptor()->displayName, reinterpret_cast<std::uintptr_t>(effect));
+			const auto time = CpuTime::Scope{&effect->cpuTime()};
+			moreEffects |= effect->processAudioBuffer(buf, frames);
+		}
+	}
+	return moreEffects;
+}
+
+} // namespace
+
+
+
+
+//! Effects of a pipelined chain processed by one job, in a buffer of their own
+class EffectChain::Stage : public ThreadableJob
+{
+public:
+	Stage(const EffectChain* chain, std::size_t first, std::size_t last) :
+		m_chain(chain),
+		m_first(first),
+		m_last(last)
+	{
+	}
+
+	bool requiresProcessing() const override
+	{
+		return true;
+	}
+
+	//! Input of the stage before processing, its output afterwards.
+	//! Contains nothing but zeros if there's neither input nor output.
+	std::vector<SampleFrame> m_buffer = std::vector<SampleFrame>(Engine::audioEngine()->maxFramesPerPeriod());
+	fpp_t m_frames = 0;
+	bool m_hasInput = false;
+	//! Whether the stage produced any output in the last period
+	bool m_hasOutput = false;
+	bool m_moreEffects = false;
+
+protected:
+	void doProcessing() override
+	{
+		const auto effects = std::span{m_chain->m_effects}.subspan(m_first, m_last - m_first);
+		m_moreEffects = processEffects(effects, m_buffer.data(), m_frames, m_hasInput);
+		m_hasOutput = m_hasInput || m_moreEffects;
+		if (!m_hasOutput) { zeroSampleFrames(m_buffer.data(), m_frames); }
+	}
+
+private:
+	const EffectChain* m_chain;
+	std::size_t m_first;
+	std::size_t m_last;
+};
+
+
+
 
 EffectChain::EffectChain( Model * _parent ) :
 	Model( _parent ),
 	SerializingObject(),
-	m_enabledModel( false, nullptr, tr( "Effects enabled" ) )
+	m_enabledModel( false, nullptr, tr( "Effects enabled" ) ),
+	m_pipelinedModel(false, nullptr, tr("Pipeline effects"))
 {
+	connect(&m_pipelinedModel, &BoolModel::dataChanged, this, [this] {
+		Engine::audioEngine()->requestChangeInModel();
+		updateStages();
+		Engine::audioEngine()->doneChangeInModel();
+	}, Qt::DirectConnection);
+	// emitted between periods on the rendering thread, so no stage is running
+	connect(Engine::audioEngine(), &AudioEngine::framesPerPeriodChanged,
+		this, &EffectChain::flushStages, Qt::DirectConnection);
 }
 
 
@@ -57,6 +147,7 @@ EffectChain::~EffectChain()
 void EffectChain::saveSettings( QDomDocument & _doc, QDomElement & _this )
 {
 	m_enabledModel.saveSettings( _doc, _this, "enabled" );
+	if (m_pipelinedModel.value()) { m_pipelinedModel.saveSettings(_doc, _this, "pipelined"); }
 	_this.setAttribute("numofeffects", static_cast<int>(m_effects.size()));
 
 	for( Effect* effect : m_effects)
@@ -81,6 +172,8 @@ void EffectChain::loadSettings( const QDomElement & _this )
 	// TODO This method should probably also lock the audio engine
 
 	m_enabledModel.loadSettings( _this, "enabled" );
+	m_pipelinedModel.setValue(false);
+	m_pipelinedModel.loadSettings(_this, "pipelined");
 
 	const int plugin_cnt = _this.attribute( "numofeffects" ).toInt();
 
@@ -113,6 +206,10 @@ void EffectChain::loadSettings( const QDomElement & _this )
 		node = node.nextSibling();
 	}
 
+	Engine::audioEngine()->requestChangeInModel();
+	updateStages();
+	Engine::audioEngine()->doneChangeInModel();
+
 	emit dataChanged();
 }
 
@@ -123,6 +220,7 @@ void EffectChain::appendEffect( Effect * _effect )
 {
 	Engine::audioEngine()->requestChangeInModel();
 	m_effects.push_back(_effect);
+	updateStages();
 	Engine::audioEngine()->doneChangeInModel();
 
 	m_enabledModel.setValue( true );
@@ -144,6 +242,7 @@ void EffectChain::removeEffect( Effect * _effect )
 		return;
 	}
 	m_effects.erase( found );
+	updateStages();
 
 	Engine::audioEngine()->doneChangeInModel();
 
@@ -165,6 +264,7 @@ void EffectChain::moveDown( Effect * _effect )
 		auto it = std::find(m_effects.begin(), m_effects.end(), _effect);
 		assert(it != m_effects.end());
 		std::swap(*std::next(it), *it);
+		emit dataChanged();
 	}
 }
 
@@ -178,6 +278,7 @@ void EffectChain::moveUp( Effect * _effect )
 		auto it = std::find(m_effects.begin(), m_effects.end(), _effect);
 		assert(it != m_effects.end());
 		std::swap(*std::prev(it), *it);
+		emit dataChanged();
 	}
 }
 
@@ -191,24 +292,133 @@ bool EffectChain::processAudioBuffer( SampleFrame* _buf, const fpp_t _frames, bo
 		return false;
 	}
 
+	// nothing to do for silent buffers once all effects have quit
+	if (!hasInputNoise && !isRunning())
+	{
+		return false;
+	}
+
 	MixHelpers::sanitize( _buf, _frames );
 
 	bool moreEffects = false;
-	for (const auto& effect : m_effects)
+	if (m_stages.empty())
 	{
-		if (hasInputNoise || effect->isRunning())
+		moreEffects = processEffects(m_effects, _buf, _frames, hasInputNoise);
+	}
+	else
+	{
+		// every stage takes over the buffer with the output the previous one produced in the last period
+		for (auto i = m_stages.size() - 1; i > 0; --i)
+		{
+			std::swap(m_stages[i]->m_buffer, m_stages[i - 1]->m_buffer);
+			m_stages[i]->m_hasInput = m_stages[i - 1]->m_hasOutput;
+		}
+		auto& first = *m_stages.front();
+		std::copy_n(_buf, _frames, first.m_buffer.begin());
+		first.m_hasInput = hasInputNoise;
+
+		for (auto i = std::size_t{1}; i < m_stages.size(); ++i)
 		{
-			moreEffects |= effect->processAudioBuffer(_buf, _frames);
-			MixHelpers::sanitize(_buf, _frames);
+			m_stages[i]->reset();
+			m_stages[i]->m_frames = _frames;
+			if (AudioEngineWorkerThread::addJob(m_stages[i].get())) { m_queuedStages.push_back(m_stages[i].get()); }
 		}
+
+		// process the first stage meanwhile, and the queued ones nobody has taken yet
+		first.m_frames = _frames;
+		first.queue();
+		first.process();
+		AudioEngineWorkerThread::waitForJobs(m_queuedStages);
+		m_queuedStages.clear();
+
+		for (const auto& stage : m_stages)
+		{
+			if (stage->state() != ThreadableJob::ProcessingState::Done)
+			{
+				// the job queue is full
+				stage->queue();
+				stage->process();
+			}
+			// output still on its way through the pipeline keeps the chain running
+			moreEffects |= stage->m_moreEffects || (stage != m_stages.back() && stage->m_hasOutput);
+		}
+		std::copy_n(m_stages.back()->m_buffer.begin(), _frames, _buf);
 	}
 
+	// effects may produce invalid samples, which only have to be removed from the output of the chain
+	MixHelpers::sanitize(_buf, _frames);
+
 	return moreEffects;
 }
 
 
 
 
+f_cnt_t EffectChain::latency() const
+{
+	if (m_enabledModel.value() == false)
+	{
+		return 0;
+	}
+
+	auto latency = m_stages.empty() ? f_cnt_t{0} : (m_stages.size() - 1) * Engine::audioEngine()->framesPerPeriod();
+	for (const Effect* effect : m_effects)
+	{
+		if (effect->isEnabled()) { latency += effect->latency(); }
+	}
+	return latency;
+}
+
+
+
+
+void EffectChain::updateStages()
+{
+	m_stages.clear();
+	m_queuedStages.clear();
+
+	const auto stages = std::min<std::size_t>(m_effects.size(), Engine::audioEngine()->numJobThreads());
+	if (!m_pipelinedModel.value() || stages < 2) { return; }
+
+	// split the effects as evenly as possible
+	for (auto i = std::size_t{0}; i < stages; ++i)
+	{
+		m_stages.push_back(std::make_unique<Stage>(this, i * m_effects.size() / stages, (i + 1) * m_effects.size() / stages));
+	}
+	m_queuedStages.reserve(stages);
+}
+
+
+
+
+void EffectChain::flushStages()
+{
+	for (const auto& stage : m_stages)
+	{
+		zeroSampleFrames(stage->m_buffer.data(), stage->m_buffer.size());
+		stage->m_hasInput = false;
+		stage->m_hasOutput = false;
+		stage->m_moreEffects = false;
+	}
+}
+
+
+
+
+bool EffectChain::isRunning() const
+{
+	if (m_enabledModel.value() == false)
+	{
+		return false;
+	}
+
+	return std::any_of(m_effects.begin(), m_effects.end(), [](const Effect* effect) { return effect->isRunning(); })
+		|| std::any_of(m_stages.begin(), m_stages.end(), [](const auto& stage) { return stage->m_hasOutput; });
+}
+
+
+
+
 void EffectChain::startRunning()
 {
 	if( m_enabledModel.value() == false )
@@ -237,6 +447,7 @@ void EffectChain::clear()
 		m_effects.pop_back();
 		delete e;
 	}
+	updateStages();
 
 	Engine::audioEngine()->doneChangeInModel();
 
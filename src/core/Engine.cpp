@@ -31,9 +31,11 @@
 #include "Lv2Manager.h"
 #include "PatternStore.h"
 #include "Plugin.h"
+#include "PluginFactory.h"
 #include "PresetPreviewPlayHandle.h"
 #include "ProjectJournal.h"
 #include "Song.h"
+#include "StartupScheduler.h"
 #include "BandLimitedWave.h"
 #include "Oscillator.h"
 
@@ -59,33 +61,48 @@ void Engine::init( bool renderOnly )
 {
 	Engine *engine = inst();
 
-	emit engine->initProgress(tr("Generating wavetables"));
-	// generate (load from file) bandlimited wavetables
-	BandLimitedWave::generateWaves();
-	//initilize oscillators
-	Oscillator::waveTableInit();
+	// none of these depend on the engine, so they run while it is set up
+	StartupScheduler::start(tr("Generating wavetables"), [] {
+		// generate (load from file) bandlimited wavetables
+		BandLimitedWave::generateWaves();
+	});
+	StartupScheduler::start(tr("Discovering plugins"), [] { getPluginFactory(); });
+	StartupScheduler::start(tr("Scanning LADSPA plugins"), [] { s_ladspaManager = new Ladspa2LMMS; });
 
 	emit engine->initProgress(tr("Initializing data structures"));
 	s_projectJournal = new ProjectJournal;
 	s_audioEngine = new AudioEngine( renderOnly );
-	s_song = new Song;
-	s_mixer = new Mixer;
-	s_patternStore = new PatternStore;
 
 #ifdef LMMS_HAVE_LV2
-	s_lv2Manager = new Lv2Manager;
-	s_lv2Manager->initPlugins();
+	// needs the audio engine's period size only
+	StartupScheduler::start(tr("Scanning LV2 plugins"), [] {
+		auto manager = new Lv2Manager;
+		manager->initPlugins();
+		s_lv2Manager = manager;
+	});
 #endif
-	s_ladspaManager = new Ladspa2LMMS;
+
+	s_song = new Song;
+	s_mixer = new Mixer;
+	s_patternStore = new PatternStore;
 
 	s_projectJournal->setJournalling( true );
 
 	emit engine->initProgress(tr("Opening audio and midi devices"));
 	s_audioEngine->initDevices();
 
-	PresetPreviewPlayHandle::init();
+	emit engine->initProgress(tr("Scanning plugins"));
+	StartupScheduler::wait(tr("Discovering plugins"));
+	StartupScheduler::wait(tr("Scanning LADSPA plugins"));
+#ifdef LMMS_HAVE_LV2
+	StartupScheduler::wait(tr("Scanning LV2 plugins"));
+#endif
+
+	// presets are only previewed from the GUI
+	if (!renderOnly) { PresetPreviewPlayHandle::init(); }
 
 	emit engine->initProgress(tr("Launching audio engine threads"));
+	StartupScheduler::wait(tr("Generating wavetables"));
 	s_audioEngine->startProcessing();
 }
 
@@ -26,6 +26,7 @@
 
 #include <QDomElement>
 #include <QFileInfo>
+#include <algorithm>
 
 #include "AudioEngine.h"
 #include "Engine.h"
@@ -55,6 +56,7 @@ void EnvelopeAndLfoParameters::LfoInstances::trigger()
 	{
 		lfo->m_lfoFrame += Engine::audioEngine()->framesPerPeriod();
 		lfo->m_bad_lfoShapeData = true;
+		lfo->m_levelCacheValid = false;
 	}
 }
 
@@ -68,6 +70,7 @@ void EnvelopeAndLfoParameters::LfoInstances::reset()
 	{
 		lfo->m_lfoFrame = 0;
 		lfo->m_bad_lfoShapeData = true;
+		lfo->m_levelCacheValid = false;
 	}
 }
 
@@ -122,7 +125,8 @@ EnvelopeAndLfoParameters::EnvelopeAndLfoParameters(
 	m_controlEnvAmountModel( false, this, tr( "Modulate env amount" ) ),
 	m_lfoFrame( 0 ),
 	m_lfoAmountIsZero( false ),
-	m_lfoShapeData(nullptr)
+	m_lfoShapeData(nullptr),
+	m_randomKey(Engine::audioEngine()->newSharedRandomKey())
 {
 	m_amountModel.setCenterValue( 0 );
 	m_lfoAmountModel.setCenterValue( 0 );
@@ -167,7 +171,8 @@ EnvelopeAndLfoParameters::EnvelopeAndLfoParameters(
 
 
 	m_lfoShapeData =
-		new sample_t[Engine::audioEngine()->framesPerPeriod()];
+		new sample_t[Engine::audioEngine()->maxFramesPerPeriod()];
+	m_levelCache.resize( Engine::audioEngine()->maxFramesPerPeriod() );
 
 	updateSampleVars();
 }
@@ -247,6 +252,8 @@ inline sample_t EnvelopeAndLfoParameters::lfoShapeSample( fpp_t _frame_offset )
 
 void EnvelopeAndLfoParameters::updateLfoShapeData()
 {
+	// shared by all notes of the track, computed by whichever comes first
+	const auto random = AudioEngine::SharedRandomScope{Engine::audioEngine(), m_randomKey};
 	const fpp_t frames = Engine::audioEngine()->framesPerPeriod();
 	for( fpp_t offset = 0; offset < frames; ++offset )
 	{
@@ -258,15 +265,67 @@ void EnvelopeAndLfoParameters::updateLfoShapeData()
 
 
 
-inline void EnvelopeAndLfoParameters::fillLfoLevel( float * _buf,
+inline void EnvelopeAndLfoParameters::fillEnvLevel( float * _buf,
 							f_cnt_t _frame,
+							const f_cnt_t _release_begin,
 							const fpp_t _frames )
 {
+	// fill the frames of every envelope segment in one go
+	const f_cnt_t end = _frame + _frames;
+	while( _frame < end )
+	{
+		f_cnt_t count;
+		if( _frame < _release_begin )
+		{
+			if( _frame < m_pahdFrames )
+			{
+				count = std::min({end, _release_begin, m_pahdFrames}) - _frame;
+				std::copy_n( m_pahdEnv + _frame, count, _buf );
+			}
+			else
+			{
+				count = std::min(end, _release_begin) - _frame;
+				std::fill_n( _buf, count, m_sustainLevel );
+			}
+		}
+		else if( ( _frame - _release_begin ) < m_rFrames )
+		{
+			count = std::min(end, _release_begin + m_rFrames) - _frame;
+			const float releaseLevel = ( _release_begin < m_pahdFrames ) ?
+				m_pahdEnv[_release_begin] : m_sustainLevel;
+			const sample_t * rEnv = m_rEnv + ( _frame - _release_begin );
+			for( f_cnt_t i = 0; i < count; ++i )
+			{
+				_buf[i] = rEnv[i] * releaseLevel;
+			}
+		}
+		else
+		{
+			count = end - _frame;
+			std::fill_n( _buf, count, 0.0f );
+		}
+		_buf += count;
+		_frame += count;
+	}
+}
+
+
+
+
+inline void EnvelopeAndLfoParameters::applyLfoLevel( float * _buf,
+							f_cnt_t _frame,
+							const fpp_t _frames )
+{
+	const bool controlEnvAmount = m_controlEnvAmountModel.value();
+
 	if( m_lfoAmountIsZero || _frame <= m_lfoPredelayFrames )
 	{
-		for( fpp_t offset = 0; offset < _frames; ++offset )
+		if( controlEnvAmount )
 		{
-			*_buf++ = 0.0f;
+			for( fpp_t offset = 0; offset < _frames; ++offset )
+			{
+				_buf[offset] *= 0.5f;
+			}
 		}
 		return;
 	}
@@ -277,17 +336,30 @@ inline void EnvelopeAndLfoParameters::fillLfoLevel( float * _buf,
 		updateLfoShapeData();
 	}
 
-	fpp_t offset = 0;
-	const float lafI = 1.0f / std::max(minimumFrames, m_lfoAttackFrames);
-	for( ; offset < _frames && _frame < m_lfoAttackFrames; ++offset,
-								++_frame )
-	{
-		*_buf++ = m_lfoShapeData[offset] * _frame * lafI;
-	}
-	for( ; offset < _frames; ++offset )
+	const auto apply = [&]( fpp_t begin, fpp_t end, auto lfoLevel )
 	{
-		*_buf++ = m_lfoShapeData[offset];
-	}
+		if( controlEnvAmount )
+		{
+			for( fpp_t offset = begin; offset < end; ++offset )
+			{
+				_buf[offset] *= 0.5f + lfoLevel( offset );
+			}
+		}
+		else
+		{
+			for( fpp_t offset = begin; offset < end; ++offset )
+			{
+				_buf[offset] += lfoLevel( offset );
+			}
+		}
+	};
+
+	// fade the LFO in during its attack
+	const fpp_t attackEnd = static_cast<fpp_t>( std::clamp<f_cnt_t>( m_lfoAttackFrames - _frame, 0, _frames ) );
+	const float lafI = 1.0f / std::max(minimumFrames, m_lfoAttackFrames);
+	apply( 0, attackEnd, [&]( fpp_t offset )
+		{ return m_lfoShapeData[offset] * ( _frame + offset ) * lafI; } );
+	apply( attackEnd, _frames, [&]( fpp_t offset ) { return m_lfoShapeData[offset]; } );
 }
 
 
@@ -299,37 +371,25 @@ void EnvelopeAndLfoParameters::fillLevel( float * _buf, f_cnt_t _frame,
 {
 	QMutexLocker m(&m_paramMutex);
 
-	fillLfoLevel( _buf, _frame, _frames );
-
-	for( fpp_t offset = 0; offset < _frames; ++offset, ++_buf, ++_frame )
+	// voices started at the same time, e.g. the notes of a chord, need the
+	// same levels, so only compute them once per period
+	if( m_levelCacheValid && _frame == m_levelCacheFrame && _release_begin == m_levelCacheReleaseBegin &&
+		_frames == m_levelCacheFrames )
 	{
-		float env_level;
-		if( _frame < _release_begin )
-		{
-			if( _frame < m_pahdFrames )
-			{
-				env_level = m_pahdEnv[_frame];
-			}
-			else
-			{
-				env_level = m_sustainLevel;
-			}
-		}
-		else if( ( _frame - _release_begin ) < m_rFrames )
-		{
-			env_level = m_rEnv[_frame - _release_begin] *
-				( ( _release_begin < m_pahdFrames ) ?
-				m_pahdEnv[_release_begin] : m_sustainLevel );
-		}
-		else
-		{
-			env_level = 0.0f;
-		}
+		std::copy_n( m_levelCache.data(), _frames, _buf );
+		return;
+	}
+
+	fillEnvLevel( _buf, _frame, _release_begin, _frames );
+	applyLfoLevel( _buf, _frame, _frames );
 
-		// at this point, *_buf is LFO level
-		*_buf = m_controlEnvAmountModel.value() ?
-			env_level * ( 0.5f + *_buf ) :
-			env_level + *_buf;
+	if( static_cast<std::size_t>( _frames ) <= m_levelCache.size() )
+	{
+		std::copy_n( _buf, _frames, m_levelCache.data() );
+		m_levelCacheFrame = _frame;
+		m_levelCacheReleaseBegin = _release_begin;
+		m_levelCacheFrames = _frames;
+		m_levelCacheValid = true;
 	}
 }
 
@@ -404,6 +464,8 @@ void EnvelopeAndLfoParameters::updateSampleVars()
 {
 	QMutexLocker m(&m_paramMutex);
 
+	m_levelCacheValid = false;
+
 	const float frames_per_env_seg = SECS_PER_ENV_SEGMENT *
 				Engine::audioEngine()->outputSampleRate();
 
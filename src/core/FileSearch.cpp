@@ -26,7 +26,6 @@
 
 #include <atomic>
 #include <chrono>
-#include <thread>
 
 namespace lmms {
 FileSearch::FileSearch(const QString& filter, const QStringList& paths, const QStringList& extensions,
@@ -42,43 +41,72 @@ FileSearch::FileSearch(const QString& filter, const QStringList& paths, const QS
 
 void FileSearch::operator()()
 {
-	auto stack = QFileInfoList{};
-	for (const auto& path : m_paths)
-	{
-		if (m_excludedPaths.contains(path)) { continue; }
-
-		auto dir = QDir{path};
-		stack.append(dir.entryInfoList(m_dirFilters, m_sortFlags));
+	using Clock = std::chrono::steady_clock;
+	auto batch = QStringList{};
+	auto lastBatch = Clock::now();
+	const auto addMatch = [&](const QString& match) {
+		batch.append(match);
+		if (Clock::now() - lastBatch >= std::chrono::milliseconds{MillisecondsBetweenResults})
+		{
+			emit foundMatches(this, batch);
+			batch.clear();
+			lastBatch = Clock::now();
+		}
+	};
 
-		while (!stack.empty())
+	if (m_index)
+	{
+		for (const auto& entryPath : *m_index)
 		{
 			if (m_cancel.load(std::memory_order_relaxed)) { return; }
 
-			const auto info = stack.takeFirst();
-			const auto entryPath = info.absoluteFilePath();
-			if (m_excludedPaths.contains(entryPath)) { continue; }
+			const auto name = QStringView{entryPath}.mid(entryPath.lastIndexOf('/') + 1);
+			if (name.contains(m_filter, Qt::CaseInsensitive)) { addMatch(entryPath); }
+		}
+	}
+	else
+	{
+		auto index = std::make_shared<Index>();
+		auto stack = QFileInfoList{};
+		for (const auto& path : m_paths)
+		{
+			if (m_excludedPaths.contains(path)) { continue; }
 
-			const auto name = info.fileName();
-			const auto validFile = info.isFile() && m_extensions.contains(info.suffix(), Qt::CaseInsensitive);
-			const auto passesFilter = name.contains(m_filter, Qt::CaseInsensitive);
-			
-			if ((validFile || info.isDir()) && passesFilter)
-			{
-				std::this_thread::sleep_for(std::chrono::milliseconds{MillisecondsBetweenResults});
-				emit foundMatch(this, entryPath);
-			}
+			auto dir = QDir{path};
+			stack.append(dir.entryInfoList(m_dirFilters, m_sortFlags));
 
-			if (info.isDir())
+			while (!stack.empty())
 			{
-				dir.setPath(entryPath);
-				const auto entries = dir.entryInfoList(m_dirFilters, m_sortFlags);
+				if (m_cancel.load(std::memory_order_relaxed)) { return; }
+
+				const auto info = stack.takeFirst();
+				const auto entryPath = info.absoluteFilePath();
+				if (m_excludedPaths.contains(entryPath)) { continue; }
+
+				const auto name = info.fileName();
+				const auto validFile = info.isFile() && m_extensions.contains(info.suffix(), Qt::CaseInsensitive);
+				const auto passesFilter = name.contains(m_filter, Qt::CaseInsensitive);
+
+				if (validFile || info.isDir())
+				{
+					index->append(entryPath);
+					if (passesFilter) { addMatch(entryPath); }
+				}
+
+				if (info.isDir())
+				{
+					dir.setPath(entryPath);
+					const auto entries = dir.entryInfoList(m_dirFilters, m_sortFlags);
 
-				// Reverse to maintain the sorting within this directory when popped
-				std::for_each(entries.rbegin(), entries.rend(), [&stack](const auto& entry) { stack.push_front(entry); });
+					// Reverse to maintain the sorting within this directory when popped
+					std::for_each(entries.rbegin(), entries.rend(), [&stack](const auto& entry) { stack.push_front(entry); });
+				}
 			}
 		}
+		m_index = std::move(index);
 	}
 
+	if (!batch.isEmpty()) { emit foundMatches(this, batch); }
 	emit searchCompleted(this);
 }
 
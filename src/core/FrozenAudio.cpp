@@ -0,0 +1,133 @@
+/*
+ * FrozenAudio.cpp - output of a track rendered ahead of time
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "FrozenAudio.h"
+
+#include <QDataStream>
+#include <algorithm>
+#include <cmath>
+
+namespace lmms
+{
+
+FrozenAudio::FrozenAudio(fpp_t periodSize, sample_rate_t sampleRate)
+	: m_periodSize(periodSize)
+	, m_sampleRate(sampleRate)
+{
+}
+
+void FrozenAudio::append(const SampleFrame* buf, double ticks)
+{
+	if (!m_ticks.empty() && ticks <= m_ticks.back()) { return; }
+
+	m_ticks.push_back(ticks);
+	if (buf)
+	{
+		m_starts.push_back(m_frames.size());
+		m_frames.insert(m_frames.end(), buf, buf + m_periodSize);
+	}
+	else { m_starts.push_back(SilentPeriod); }
+}
+
+bool FrozenAudio::read(SampleFrame* buf, double ticks, float framesPerTick) const
+{
+	// the last period rendered at or before the position
+	const auto next = std::upper_bound(m_ticks.begin(), m_ticks.end(), ticks);
+	if (next == m_ticks.begin()) { return false; }
+	const auto period = static_cast<std::size_t>(next - m_ticks.begin() - 1);
+
+	// past the end of the period, nothing was rendered there
+	const auto offset = static_cast<std::size_t>(std::lround((ticks - m_ticks[period]) * framesPerTick));
+	if (offset >= m_periodSize) { return false; }
+
+	// the rest of the period, followed by the start of the next one
+	if (!isAudible(period) && (offset == 0 || !isAudible(period + 1))) { return false; }
+	const auto head = m_periodSize - offset;
+	copy(period, offset, head, buf);
+	copy(period + 1, 0, offset, buf + head);
+	return true;
+}
+
+bool FrozenAudio::isAudible(std::size_t period) const
+{
+	return period < m_starts.size() && m_starts[period] != SilentPeriod;
+}
+
+void FrozenAudio::copy(std::size_t period, std::size_t offset, std::size_t count, SampleFrame* buf) const
+{
+	if (isAudible(period)) { std::copy_n(m_frames.begin() + m_starts[period] + offset, count, buf); }
+	else { std::fill_n(buf, count, SampleFrame{}); }
+}
+
+void FrozenAudio::save(QDataStream& stream) const
+{
+	stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+	stream << static_cast<quint32>(m_periodSize) << static_cast<quint32>(m_sampleRate)
+		<< static_cast<qint64>(m_latency) << static_cast<quint64>(m_ticks.size());
+	for (std::size_t period = 0; period < m_ticks.size(); ++period)
+	{
+		// the ticks need all of their precision to be found again
+		stream.setFloatingPointPrecision(QDataStream::DoublePrecision);
+		stream << m_ticks[period] << isAudible(period);
+		stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+		if (!isAudible(period)) { continue; }
+
+		const auto frames = m_frames.begin() + m_starts[period];
+		std::for_each(frames, frames + m_periodSize, [&stream](const SampleFrame& frame)
+		{
+			stream << frame.left() << frame.right();
+		});
+	}
+}
+
+auto FrozenAudio::load(QDataStream& stream) -> std::shared_ptr<FrozenAudio>
+{
+	quint32 periodSize = 0;
+	quint32 sampleRate = 0;
+	qint64 latency = 0;
+	quint64 periods = 0;
+	stream >> periodSize >> sampleRate >> latency >> periods;
+	if (stream.status() != QDataStream::Ok || periodSize == 0) { return nullptr; }
+
+	auto audio = std::make_shared<FrozenAudio>(periodSize, sampleRate);
+	audio->setLatency(static_cast<f_cnt_t>(latency));
+
+	auto buf = std::vector<SampleFrame>(periodSize);
+	for (quint64 period = 0; period < periods; ++period)
+	{
+		double ticks = 0;
+		bool audible = false;
+		stream.setFloatingPointPrecision(QDataStream::DoublePrecision);
+		stream >> ticks >> audible;
+		stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+		if (audible)
+		{
+			for (auto& frame : buf) { stream >> frame.left() >> frame.right(); }
+		}
+		if (stream.status() != QDataStream::Ok) { return nullptr; }
+
+		audio->append(audible ? buf.data() : nullptr, ticks);
+	}
+	return audio;
+}
+
+} // namespace lmms
@@ -27,9 +27,13 @@
 #include <cmath>
 #include <numbers>
 
+#include "AudioEngine.h"
+#include "AudioEngineWorkerThread.h"
 #include "DummyInstrument.h"
 #include "InstrumentTrack.h"
 #include "LmmsTypes.h"
+#include "MixHelpers.h"
+#include "ThreadableJob.h"
 
 namespace lmms
 {
@@ -45,6 +49,54 @@ Instrument::Instrument(InstrumentTrack * _instrument_track,
 {
 }
 
+
+
+
+//! Renders one voice group into a buffer of its own
+class Instrument::VoiceGroupJob : public ThreadableJob
+{
+public:
+	VoiceGroupJob(Instrument* instrument, int group) :
+		m_instrument(instrument),
+		m_group(group),
+		m_buffer(Engine::audioEngine()->maxFramesPerPeriod())
+	{
+	}
+
+	void setFrames(fpp_t frames)
+	{
+		m_frames = frames;
+	}
+
+	const SampleFrame* buffer() const
+	{
+		return m_buffer.data();
+	}
+
+	bool requiresProcessing() const override
+	{
+		return true;
+	}
+
+protected:
+	void doProcessing() override
+	{
+		zeroSampleFrames(m_buffer.data(), m_frames);
+		m_instrument->renderVoiceGroup(m_group, m_buffer.data(), m_frames);
+	}
+
+private:
+	Instrument* m_instrument;
+	int m_group;
+	std::vector<SampleFrame> m_buffer;
+	fpp_t m_frames = 0;
+};
+
+
+
+
+Instrument::~Instrument() = default;
+
 void Instrument::play( SampleFrame* )
 {
 }
@@ -52,6 +104,62 @@ void Instrument::play( SampleFrame* )
 
 
 
+void Instrument::playNotes( std::span<NotePlayHandle* const> notes )
+{
+	for( NotePlayHandle* n : notes )
+	{
+		playNote( n, n->workingBuffer() );
+	}
+}
+
+
+
+
+void Instrument::setVoiceGroups(int groups)
+{
+	m_voiceGroupJobs.clear();
+	for (int group = 1; group < groups; ++group)
+	{
+		m_voiceGroupJobs.push_back(std::make_unique<VoiceGroupJob>(this, group));
+	}
+	m_queuedVoiceGroups.reserve(m_voiceGroupJobs.size());
+}
+
+
+
+
+void Instrument::renderVoiceGroups(SampleFrame* buffer, fpp_t frames)
+{
+	for (const auto& job : m_voiceGroupJobs)
+	{
+		job->reset();
+		job->setFrames(frames);
+		if (AudioEngineWorkerThread::addJob(job.get()))
+		{
+			m_queuedVoiceGroups.push_back(job.get());
+		}
+	}
+
+	// render the first group meanwhile, and the queued ones nobody has taken yet
+	renderVoiceGroup(0, buffer, frames);
+	AudioEngineWorkerThread::waitForJobs(m_queuedVoiceGroups);
+	m_queuedVoiceGroups.clear();
+
+	for (const auto& job : m_voiceGroupJobs)
+	{
+		if (job->state() != ThreadableJob::ProcessingState::Done)
+		{
+			// the job queue is full
+			job->queue();
+			job->process();
+		}
+		MixHelpers::add(buffer, job->buffer(), frames);
+	}
+}
+
+
+
+
 void Instrument::deleteNotePluginData( NotePlayHandle * )
 {
 }
@@ -29,6 +29,7 @@
 #include "Engine.h"
 #include "InstrumentTrack.h"
 #include "PresetPreviewPlayHandle.h"
+#include "lmms_math.h"
 
 #include <vector>
 #include <algorithm>
@@ -36,6 +37,62 @@
 namespace lmms
 {
 
+namespace
+{
+
+using ArpDirection = InstrumentFunctionArpeggio::ArpDirection;
+
+//! Index into the notes of the arpeggio played at @p step, for every direction but ArpDirection::Random
+int arpIndex(int step, ArpDirection dir, int range, int repeats, int cycle)
+{
+	int index = 0;
+	if (dir == ArpDirection::Up || dir == ArpDirection::Down)
+	{
+		index = step % range;
+	}
+	else if ((dir == ArpDirection::UpAndDown || dir == ArpDirection::DownAndUp) && range > 1)
+	{
+		// imagine, we had to play the arp once up and then
+		// once down -> makes 2 * range possible notes...
+		// because we don't play the lower and upper notes
+		// twice, we have to subtract 2
+		const int period = range * 2 - 2 * repeats;
+		index = period > 0 ? step % period : 0;
+		// if greater than range, we have to play down...
+		// looks like the code for arp_dir==DOWN... :)
+		if (index >= range)
+		{
+			index = range - index % (range - 1) - repeats;
+		}
+	}
+
+	// Divide index with wanted repeats
+	index /= repeats;
+
+	// Cycle notes
+	if (cycle)
+	{
+		index *= cycle + 1;
+		index %= range / repeats;
+	}
+
+	// If ArpDirection::Down or ArpDirection::DownAndUp, invert the final range.
+	if (dir == ArpDirection::Down || dir == ArpDirection::DownAndUp)
+	{
+		index = range / repeats - index - 1;
+	}
+	return index;
+}
+
+//! Number of steps after which arpIndex() repeats itself
+int arpPeriod(ArpDirection dir, int range, int repeats)
+{
+	if (dir == ArpDirection::Up || dir == ArpDirection::Down) { return range; }
+	return range > 1 ? std::max(range * 2 - 2 * repeats, 1) : 1;
+}
+
+} // namespace
+
 std::array<InstrumentFunctionNoteStacking::ChordTable::Init, InstrumentFunctionNoteStacking::NUM_CHORD_TABLES>
 	InstrumentFunctionNoteStacking::ChordTable::s_initTable =
 	std::array<InstrumentFunctionNoteStacking::ChordTable::Init, NUM_CHORD_TABLES>
@@ -219,6 +276,37 @@ InstrumentFunctionNoteStacking::InstrumentFunctionNoteStacking( Model * _parent
 	{
 		m_chordsModel.addItem(chord.getName());
 	}
+
+	const auto invalidate = [this] { m_scheduleRevision.fetch_add(1, std::memory_order_release); };
+	connect(&m_chordsModel, &Model::dataChanged, this, invalidate, Qt::DirectConnection);
+	connect(&m_chordRangeModel, &Model::dataChanged, this, invalidate, Qt::DirectConnection);
+}
+
+
+
+
+auto InstrumentFunctionNoteStacking::chordSchedule() const -> std::shared_ptr<const ChordSchedule>
+{
+	auto schedule = std::atomic_load(&m_schedule);
+	const unsigned revision = m_scheduleRevision.load(std::memory_order_acquire);
+	if (!schedule || schedule->revision != revision)
+	{
+		const Chord& chord = ChordTable::getInstance().chords()[m_chordsModel.value()];
+
+		auto newSchedule = std::make_shared<ChordSchedule>();
+		newSchedule->revision = revision;
+		newSchedule->chordSize = chord.size();
+		for (int octave = 0; octave < m_chordRangeModel.value(); ++octave)
+		{
+			for (int i = 0; i < chord.size(); ++i)
+			{
+				newSchedule->offsets.push_back(octave * KeysPerOctave + chord[i]);
+			}
+		}
+		schedule = std::move(newSchedule);
+		std::atomic_store(&m_schedule, schedule);
+	}
+	return schedule;
 }
 
 
@@ -230,7 +318,6 @@ InstrumentFunctionNoteStacking::InstrumentFunctionNoteStacking( Model * _parent
 void InstrumentFunctionNoteStacking::processNote( NotePlayHandle * _n )
 {
 	const int base_note_key = _n->key();
-	const ChordTable & chord_table = ChordTable::getInstance();
 	// we add chord-subnotes to note if either note is a base-note and
 	// arpeggio is not used or note is part of an arpeggio
 	// at the same time we only add sub-notes if nothing of the note was
@@ -241,33 +328,28 @@ void InstrumentFunctionNoteStacking::processNote( NotePlayHandle * _n )
 			m_chordsEnabledModel.value() == true && ! _n->isReleased() )
 	{
 		// then insert sub-notes for chord
-		const int selected_chord = m_chordsModel.value();
+		const auto schedule = chordSchedule();
+		const auto& offsets = schedule->offsets;
 
-		for( int octave_cnt = 0; octave_cnt < m_chordRangeModel.value(); ++octave_cnt )
+		for (std::size_t i = 0; i < offsets.size(); ++i)
 		{
-			const int sub_note_key_base = base_note_key + octave_cnt * KeysPerOctave;
-
-			// process all notes in the chord
-			for( int i = 0; i < chord_table.chords()[selected_chord].size(); ++i )
+			// add interval to sub-note-key
+			const int sub_note_key = base_note_key + offsets[i];
+			// maybe we're out of range -> let's go on with the next octave
+			if( sub_note_key > NumKeys )
 			{
-				// add interval to sub-note-key
-				const int sub_note_key = sub_note_key_base + (int) chord_table.chords()[selected_chord][i];
-				// maybe we're out of range -> let's get outta
-				// here!
-				if( sub_note_key > NumKeys )
-				{
-					break;
-				}
-				// create copy of base-note
-				Note note_copy( _n->length(), 0, sub_note_key, _n->getVolume(), _n->getPanning(), _n->detuning() );
-
-				// create sub-note-play-handle, only note is
-				// different
-				Engine::audioEngine()->addPlayHandle(
-						NotePlayHandleManager::acquire( _n->instrumentTrack(), _n->offset(), _n->frames(), note_copy,
-									_n, -1, NotePlayHandle::Origin::NoteStacking )
-						);
+				i += schedule->chordSize - 1 - i % schedule->chordSize;
+				continue;
 			}
+			// create copy of base-note
+			Note note_copy( _n->length(), 0, sub_note_key, _n->getVolume(), _n->getPanning(), _n->detuning() );
+
+			// create sub-note-play-handle, only note is
+			// different
+			Engine::audioEngine()->addPlayHandle(
+					NotePlayHandleManager::acquire( _n->instrumentTrack(), _n->offset(), _n->frames(), note_copy,
+								_n, -1, NotePlayHandle::Origin::NoteStacking )
+					);
 		}
 	}
 }
@@ -328,6 +410,50 @@ InstrumentFunctionArpeggio::InstrumentFunctionArpeggio( Model * _parent ) :
 	m_arpModeModel.addItem( tr( "Free" ), std::make_unique<PixmapLoader>( "arp_free" ) );
 	m_arpModeModel.addItem( tr( "Sort" ), std::make_unique<PixmapLoader>( "arp_sort" ) );
 	m_arpModeModel.addItem( tr( "Sync" ), std::make_unique<PixmapLoader>( "arp_sync" ) );
+
+	const auto invalidate = [this] { m_scheduleRevision.fetch_add(1, std::memory_order_release); };
+	connect(&m_arpModel, &Model::dataChanged, this, invalidate, Qt::DirectConnection);
+	connect(&m_arpRangeModel, &Model::dataChanged, this, invalidate, Qt::DirectConnection);
+	connect(&m_arpRepeatsModel, &Model::dataChanged, this, invalidate, Qt::DirectConnection);
+	connect(&m_arpCycleModel, &Model::dataChanged, this, invalidate, Qt::DirectConnection);
+	connect(&m_arpDirectionModel, &Model::dataChanged, this, invalidate, Qt::DirectConnection);
+}
+
+
+
+
+auto InstrumentFunctionArpeggio::arpSchedule() const -> std::shared_ptr<const ArpSchedule>
+{
+	auto schedule = std::atomic_load(&m_schedule);
+	const unsigned revision = m_scheduleRevision.load(std::memory_order_acquire);
+	if (!schedule || schedule->revision != revision)
+	{
+		const auto& chord = InstrumentFunctionNoteStacking::ChordTable::getInstance().chords()[m_arpModel.value()];
+		const auto dir = static_cast<ArpDirection>(m_arpDirectionModel.value());
+		const int repeats = static_cast<int>(m_arpRepeatsModel.value());
+		const int cycle = static_cast<int>(m_arpCycleModel.value());
+
+		auto newSchedule = std::make_shared<ArpSchedule>();
+		newSchedule->revision = revision;
+		newSchedule->direction = dir;
+		newSchedule->repeats = repeats;
+		newSchedule->cycle = cycle;
+		newSchedule->chordSize = chord.size();
+		newSchedule->range = static_cast<int>(chord.size() * m_arpRangeModel.value() * m_arpRepeatsModel.value());
+		if (dir != ArpDirection::Random)
+		{
+			const int period = arpPeriod(dir, newSchedule->range, repeats);
+			newSchedule->offsets.resize(period);
+			for (int step = 0; step < period; ++step)
+			{
+				const int index = arpIndex(step, dir, newSchedule->range, repeats, cycle);
+				newSchedule->offsets[step] = (index / chord.size()) * KeysPerOctave + chord[index % chord.size()];
+			}
+		}
+		schedule = std::move(newSchedule);
+		std::atomic_store(&m_schedule, schedule);
+	}
+	return schedule;
 }
 
 
@@ -352,17 +478,22 @@ void InstrumentFunctionArpeggio::processNote( NotePlayHandle * _n )
 	const int selected_arp = m_arpModel.value();
 	const auto arpMode = static_cast<ArpMode>(m_arpModeModel.value());
 
-	ConstNotePlayHandleList cnphv = NotePlayHandle::nphsOfInstrumentTrack(_n->instrumentTrack());
-
-	if(arpMode != ArpMode::Free && cnphv.size() == 0 )
+	// only the sort and sync modes depend on the other notes, looking for
+	// them would make every note scan all the others on every period
+	ConstNotePlayHandleList cnphv;
+	if (arpMode != ArpMode::Free)
 	{
-		// maybe we're playing only a preset-preview-note?
-		cnphv = PresetPreviewPlayHandle::nphsOfInstrumentTrack( _n->instrumentTrack() );
-		if( cnphv.size() == 0 )
+		cnphv = NotePlayHandle::nphsOfInstrumentTrack(_n->instrumentTrack());
+		if (cnphv.size() == 0)
 		{
-			// still nothing found here, so lets return
-			//return;
-			cnphv.push_back( _n );
+			// maybe we're playing only a preset-preview-note?
+			cnphv = PresetPreviewPlayHandle::nphsOfInstrumentTrack( _n->instrumentTrack() );
+			if( cnphv.size() == 0 )
+			{
+				// still nothing found here, so lets return
+				//return;
+				cnphv.push_back( _n );
+			}
 		}
 	}
 
@@ -370,13 +501,13 @@ void InstrumentFunctionArpeggio::processNote( NotePlayHandle * _n )
 	// currently playing notes if sort mode is enabled
 	if (arpMode == ArpMode::Sort && _n != cnphv.first()) { return; }
 
+	const auto schedule = arpSchedule();
 	const InstrumentFunctionNoteStacking::ChordTable & chord_table = InstrumentFunctionNoteStacking::ChordTable::getInstance();
-	const int cur_chord_size = chord_table.chords()[selected_arp].size();
+	const int cur_chord_size = schedule->chordSize;
 	const int total_chord_size = cur_chord_size * cnphv.size();
-	// how many notes are in a single chord (multiplied by range)
-	const int singleNoteRange = static_cast<int>(cur_chord_size * m_arpRangeModel.value() * m_arpRepeatsModel.value());
+	const int repeats = schedule->repeats;
 	// how many notes are in the final chord
-	const int range = arpMode == ArpMode::Sort ? singleNoteRange * cnphv.size() : singleNoteRange;
+	const int range = arpMode == ArpMode::Sort ? schedule->range * cnphv.size() : schedule->range;
 
 	if (arpMode == ArpMode::Sort)
 	{
@@ -416,7 +547,7 @@ void InstrumentFunctionArpeggio::processNote( NotePlayHandle * _n )
 		// Skip notes randomly
 		if( m_arpSkipModel.value() )
 		{
-			if (100 * static_cast<float>(rand()) / (static_cast<float>(RAND_MAX) + 1.0f) < m_arpSkipModel.value())
+			if (fastRand(100.f) < m_arpSkipModel.value())
 			{
 				// update counters
 				frames_processed += arp_frames;
@@ -425,78 +556,48 @@ void InstrumentFunctionArpeggio::processNote( NotePlayHandle * _n )
 			}
 		}
 
-		auto dir = static_cast<ArpDirection>(m_arpDirectionModel.value());
-
-		// Miss notes randomly. We intercept int dir and abuse it
-		// after need.  :)
-
-		if( m_arpMissModel.value() )
-		{
-			if (100 * static_cast<float>(rand()) / (static_cast<float>(RAND_MAX) + 1.0f) < m_arpMissModel.value())
-			{
-				dir = ArpDirection::Random;
-			}
-		}
-
-		int cur_arp_idx = 0;
-		// process according to arpeggio-direction...
-		if (dir == ArpDirection::Up || dir == ArpDirection::Down)
-		{
-			cur_arp_idx = (cur_frame / arp_frames) % range;
-		}
-		else if ((dir == ArpDirection::UpAndDown || dir == ArpDirection::DownAndUp) && range > 1)
-		{
-			// imagine, we had to play the arp once up and then
-			// once down -> makes 2 * range possible notes...
-			// because we don't play the lower and upper notes
-			// twice, we have to subtract 2
-			cur_arp_idx = (cur_frame / arp_frames) % (range * 2 - (2 * static_cast<int>(m_arpRepeatsModel.value())));
-			// if greater than range, we have to play down...
-			// looks like the code for arp_dir==DOWN... :)
-			if (cur_arp_idx >= range)
-			{
-				cur_arp_idx = range - cur_arp_idx % (range - 1) - static_cast<int>(m_arpRepeatsModel.value());
-			}
-		}
-		else if( dir == ArpDirection::Random )
-		{
-			// just pick a random chord-index
-			cur_arp_idx = static_cast<int>(range * static_cast<float>(rand()) / static_cast<float>(RAND_MAX));
-		}
-
-		// Divide cur_arp_idx with wanted repeats. The repeat feature will not affect random notes.
-		cur_arp_idx = static_cast<int>(cur_arp_idx / m_arpRepeatsModel.value());
-
-		// Cycle notes
-		if( m_arpCycleModel.value() && dir != ArpDirection::Random )
-		{
-			cur_arp_idx *= m_arpCycleModel.value() + 1;
-			cur_arp_idx %= static_cast<int>(range / m_arpRepeatsModel.value());
-		}
-
-		// If ArpDirection::Down or ArpDirection::DownAndUp, invert the final range.
-		if (dir == ArpDirection::Down || dir == ArpDirection::DownAndUp)
-		{
-			cur_arp_idx = static_cast<int>(range / m_arpRepeatsModel.value()) - cur_arp_idx - 1;
-		}
+		// Miss notes randomly by playing a random one instead
+		const bool missed = m_arpMissModel.value()
+			&& fastRand(100.f) < m_arpMissModel.value();
+		const bool random = missed || schedule->direction == ArpDirection::Random;
+		const int step = cur_frame / arp_frames;
 
 		// now calculate final key for our arp-note
 		int sub_note_key = 0;
-		if (arpMode != ArpMode::Sort)
+		if (arpMode != ArpMode::Sort && !random)
 		{
-			sub_note_key = base_note_key + (cur_arp_idx / cur_chord_size) *
-							KeysPerOctave + chord_table.chords()[selected_arp][cur_arp_idx % cur_chord_size];
+			sub_note_key = base_note_key + schedule->offsets[step % schedule->offsets.size()];
 		}
 		else
 		{
-			const auto octaveDiv = std::div(cur_arp_idx, total_chord_size);
-			const int octave = octaveDiv.quot;
-			const auto arpDiv = std::div(octaveDiv.rem, cnphv.size());
-			const int arpIndex = arpDiv.rem;
-			const int chordIndex = arpDiv.quot;
-			sub_note_key = cnphv[arpIndex]->key()
-				+ chord_table.chords()[selected_arp][chordIndex]
-				+ octave * KeysPerOctave;
+			int cur_arp_idx = 0;
+			if (random)
+			{
+				// just pick a random chord-index. The repeat feature will not affect random notes.
+				cur_arp_idx = static_cast<int>(fastRand(static_cast<float>(range)));
+				cur_arp_idx /= repeats;
+			}
+			else
+			{
+				cur_arp_idx = arpIndex(step, schedule->direction, range, repeats, schedule->cycle);
+			}
+
+			if (arpMode != ArpMode::Sort)
+			{
+				sub_note_key = base_note_key + (cur_arp_idx / cur_chord_size) *
+								KeysPerOctave + chord_table.chords()[selected_arp][cur_arp_idx % cur_chord_size];
+			}
+			else
+			{
+				const auto octaveDiv = std::div(cur_arp_idx, total_chord_size);
+				const int octave = octaveDiv.quot;
+				const auto arpDiv = std::div(octaveDiv.rem, cnphv.size());
+				const int noteIndex = arpDiv.rem;
+				const int chordIndex = arpDiv.quot;
+				sub_note_key = cnphv[noteIndex]->key()
+					+ chord_table.chords()[selected_arp][chordIndex]
+					+ octave * KeysPerOctave;
+			}
 		}
 
 		// range-checking
@@ -26,8 +26,11 @@
 #include "InstrumentPlayHandle.h"
 #include "Instrument.h"
 #include "InstrumentTrack.h"
+#include "ConfigManager.h"
 #include "Engine.h"
 #include "AudioEngine.h"
+#include "AudioBusHandle.h"
+#include "MixHelpers.h"
 
 namespace lmms
 {
@@ -35,7 +38,9 @@ namespace lmms
 
 InstrumentPlayHandle::InstrumentPlayHandle(Instrument * instrument, InstrumentTrack* instrumentTrack) :
 	PlayHandle(Type::InstrumentPlayHandle),
-	m_instrument(instrument)
+	m_instrument(instrument),
+	m_suspendable(ConfigManager::inst()->value("ui", "disableautoquit", "1").toInt() == 0),
+	m_wakeRequests(instrument->wakeRequests())
 {
 	setAudioBusHandle(instrumentTrack->audioBusHandle());
 }
@@ -44,6 +49,12 @@ void InstrumentPlayHandle::play(SampleFrame* working_buffer)
 {
 	InstrumentTrack * instrumentTrack = m_instrument->instrumentTrack();
 
+	// the frozen output of the track is heard instead
+	if (instrumentTrack->audioBusHandle()->playsFrozenAudio()) { return; }
+
+	// taken before the notes, so that events arriving meanwhile wake the instrument up again
+	const auto wakeRequests = m_instrument->wakeRequests();
+
 	// ensure that all our nph's have been processed first
 	auto nphv = NotePlayHandle::nphsOfInstrumentTrack(instrumentTrack, true);
 
@@ -67,6 +78,22 @@ void InstrumentPlayHandle::play(SampleFrame* working_buffer)
 	// Process the audio buffer that the instrument has just worked on...
 	const fpp_t frames = Engine::audioEngine()->framesPerPeriod();
 	instrumentTrack->processAudioBuffer(working_buffer, frames, nullptr);
+
+	if (!nphv.empty() || wakeRequests != m_wakeRequests || !MixHelpers::isSilent(working_buffer, frames))
+	{
+		m_idleFrames = 0;
+	}
+	else
+	{
+		m_idleFrames += frames;
+	}
+	m_wakeRequests = wakeRequests;
+}
+
+bool InstrumentPlayHandle::isSuspended() const
+{
+	const auto timeout = static_cast<f_cnt_t>(Engine::audioEngine()->outputSampleRate() * SuspendTimeout.count());
+	return m_suspendable && m_idleFrames >= timeout && m_instrument->wakeRequests() == m_wakeRequests;
 }
 
 bool InstrumentPlayHandle::isFromTrack(const Track* track) const
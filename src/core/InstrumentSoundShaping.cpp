@@ -32,6 +32,7 @@
 #include "Engine.h"
 #include "Instrument.h"
 #include "InstrumentTrack.h"
+#include "MixHelpers.h"
 
 namespace lmms
 {
@@ -156,6 +157,19 @@ void InstrumentSoundShaping::processAudioBuffer( SampleFrame* buffer,
 		const float fcv = m_filterCutModel.value();
 		const float frv = m_filterResModel.value();
 
+		BasicFilters<>& filter = *n->m_filter;
+
+		// the frames are filtered in blocks of frames using the same coefficients
+		fpp_t blockBegin = 0;
+		const auto filterBlock = [&]( fpp_t end )
+		{
+			if( end > blockBegin )
+			{
+				filter.process( buffer[blockBegin].data(), end - blockBegin );
+			}
+			blockBegin = end;
+		};
+
 		if (cutoffParameters.isUsed() && resonanceParameters.isUsed())
 		{
 			for( fpp_t frame = 0; frame < frames; ++frame )
@@ -168,13 +182,11 @@ void InstrumentSoundShaping::processAudioBuffer( SampleFrame* buffer,
 				if( static_cast<int>( new_cut_val ) != old_filter_cut ||
 					static_cast<int>( new_res_val*RES_PRECISION ) != old_filter_res )
 				{
-					n->m_filter->calcFilterCoeffs( new_cut_val, new_res_val );
+					filterBlock( frame );
+					filter.calcFilterCoeffs( new_cut_val, new_res_val );
 					old_filter_cut = static_cast<int>( new_cut_val );
 					old_filter_res = static_cast<int>( new_res_val*RES_PRECISION );
 				}
-
-				buffer[frame][0] = n->m_filter->update( buffer[frame][0], 0 );
-				buffer[frame][1] = n->m_filter->update( buffer[frame][1], 1 );
 			}
 		}
 		else if (cutoffParameters.isUsed())
@@ -186,12 +198,10 @@ void InstrumentSoundShaping::processAudioBuffer( SampleFrame* buffer,
 
 				if( static_cast<int>( new_cut_val ) != old_filter_cut )
 				{
-					n->m_filter->calcFilterCoeffs( new_cut_val, frv );
+					filterBlock( frame );
+					filter.calcFilterCoeffs( new_cut_val, frv );
 					old_filter_cut = static_cast<int>( new_cut_val );
 				}
-
-				buffer[frame][0] = n->m_filter->update( buffer[frame][0], 0 );
-				buffer[frame][1] = n->m_filter->update( buffer[frame][1], 1 );
 			}
 		}
 		else if(resonanceParameters.isUsed() )
@@ -202,24 +212,18 @@ void InstrumentSoundShaping::processAudioBuffer( SampleFrame* buffer,
 
 				if( static_cast<int>( new_res_val*RES_PRECISION ) != old_filter_res )
 				{
-					n->m_filter->calcFilterCoeffs( fcv, new_res_val );
+					filterBlock( frame );
+					filter.calcFilterCoeffs( fcv, new_res_val );
 					old_filter_res = static_cast<int>( new_res_val*RES_PRECISION );
 				}
-
-				buffer[frame][0] = n->m_filter->update( buffer[frame][0], 0 );
-				buffer[frame][1] = n->m_filter->update( buffer[frame][1], 1 );
 			}
 		}
 		else
 		{
-			n->m_filter->calcFilterCoeffs( fcv, frv );
-
-			for( fpp_t frame = 0; frame < frames; ++frame )
-			{
-				buffer[frame][0] = n->m_filter->update( buffer[frame][0], 0 );
-				buffer[frame][1] = n->m_filter->update( buffer[frame][1], 1 );
-			}
+			filter.calcFilterCoeffs( fcv, frv );
 		}
+
+		filterBlock( frames );
 	}
 
 	auto& volumeParameters = getVolumeParameters();
@@ -229,13 +233,8 @@ void InstrumentSoundShaping::processAudioBuffer( SampleFrame* buffer,
 		QVarLengthArray<float> volBuffer(frames);
 		volumeParameters.fillLevel(volBuffer.data(), envTotalFrames, envReleaseBegin, frames);
 
-		for( fpp_t frame = 0; frame < frames; ++frame )
-		{
-			float vol_level = volBuffer[frame];
-			vol_level = vol_level * vol_level;
-			buffer[frame][0] = vol_level * buffer[frame][0];
-			buffer[frame][1] = vol_level * buffer[frame][1];
-		}
+		for (auto& level : volBuffer) { level *= level; }
+		MixHelpers::multiplyByBuffer(buffer, volBuffer.data(), frames);
 	}
 
 /*	else if( m_envLfoParameters[static_cast<std::size_t>(Target::Volume)]->isUsed() == false && m_envLfoParameters[PANNING]->isUsed() )
@@ -0,0 +1,201 @@
+/*
+ * JournalDiff.cpp - line based differences between journalled states
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "JournalDiff.h"
+
+#include <QHash>
+
+#include <algorithm>
+#include <utility>
+
+namespace lmms
+{
+
+namespace
+{
+
+//! Beyond that many inserted and removed lines, the changed range is
+//! stored as a whole instead of searching for a shorter difference
+constexpr int MaxEdits = 1000;
+
+//! A line pair which is the same in both lists
+using Match = std::pair<int, int>;
+
+
+//! Finds the longest common subsequence of @p a and @p b with the O(ND)
+//! algorithm by Myers. Returns false if the lists differ in more than
+//! MaxEdits lines.
+bool commonLines(const QStringList& a, const QStringList& b, int offset, std::vector<Match>& matches)
+{
+	const int n = a.size();
+	const int m = b.size();
+	const int maxEdits = std::min(n + m, MaxEdits);
+
+	// compare hashes first, most lines differ in their first characters anyway
+	std::vector<uint> hashA(n);
+	std::vector<uint> hashB(m);
+	for (int i = 0; i < n; ++i) { hashA[i] = qHash(a[i]); }
+	for (int i = 0; i < m; ++i) { hashB[i] = qHash(b[i]); }
+	const auto equal = [&](int x, int y) { return hashA[x] == hashB[y] && a[x] == b[y]; };
+
+	// furthest x reached on each diagonal k = x - y, for every number of edits d
+	std::vector<std::vector<int>> trace;
+	auto v = std::vector<int>(2 * maxEdits + 3, 0);
+	const int center = maxEdits + 1;
+
+	int edits = -1;
+	for (int d = 0; d <= maxEdits && edits < 0; ++d)
+	{
+		for (int k = -d; k <= d; k += 2)
+		{
+			int x = (k == -d || (k != d && v[center + k - 1] < v[center + k + 1]))
+				? v[center + k + 1]
+				: v[center + k - 1] + 1;
+			int y = x - k;
+			while (x < n && y < m && equal(x, y)) { ++x; ++y; }
+			v[center + k] = x;
+
+			if (x >= n && y >= m)
+			{
+				edits = d;
+				break;
+			}
+		}
+		trace.emplace_back(v.begin() + center - d, v.begin() + center + d + 1);
+	}
+	if (edits < 0) { return false; }
+
+	// walk back from the end, collecting the diagonals
+	const auto firstMatch = matches.size();
+	int x = n;
+	int y = m;
+	for (int d = edits; d > 0; --d)
+	{
+		const std::vector<int>& prev = trace[d - 1];
+		const auto at = [&](int k) { return prev[k + d - 1]; };
+
+		const int k = x - y;
+		const int prevK = (k == -d || (k != d && at(k - 1) < at(k + 1))) ? k + 1 : k - 1;
+		const int prevX = at(prevK);
+		const int prevY = prevX - prevK;
+
+		while (x > prevX && y > prevY)
+		{
+			--x; --y;
+			matches.emplace_back(offset + x, offset + y);
+		}
+		x = prevX;
+		y = prevY;
+	}
+	while (x > 0 && y > 0)
+	{
+		--x; --y;
+		matches.emplace_back(offset + x, offset + y);
+	}
+
+	std::reverse(matches.begin() + firstMatch, matches.end());
+	return true;
+}
+
+} // namespace
+
+
+
+
+JournalDiff JournalDiff::between(const QStringList& from, const QStringList& to)
+{
+	auto diff = JournalDiff();
+
+	// most changes are local, so skip the common start and end first
+	int prefix = 0;
+	const int maxPrefix = std::min(from.size(), to.size());
+	while (prefix < maxPrefix && from[prefix] == to[prefix]) { ++prefix; }
+
+	int suffix = 0;
+	const int maxSuffix = maxPrefix - prefix;
+	while (suffix < maxSuffix && from[from.size() - 1 - suffix] == to[to.size() - 1 - suffix]) { ++suffix; }
+
+	const int fromEnd = from.size() - suffix;
+	const int toEnd = to.size() - suffix;
+	if (prefix == fromEnd && prefix == toEnd) { return diff; }
+
+	auto matches = std::vector<Match>();
+	if (!commonLines(from.mid(prefix, fromEnd - prefix), to.mid(prefix, toEnd - prefix), prefix, matches))
+	{
+		matches.clear();
+	}
+	matches.emplace_back(fromEnd, toEnd);
+
+	// every gap between two matching lines is a hunk
+	int posFrom = prefix;
+	int posTo = prefix;
+	for (const auto& [matchFrom, matchTo] : matches)
+	{
+		if (matchFrom > posFrom || matchTo > posTo)
+		{
+			diff.m_hunks.push_back(Hunk{posFrom, matchFrom - posFrom, to.mid(posTo, matchTo - posTo)});
+		}
+		posFrom = matchFrom + 1;
+		posTo = matchTo + 1;
+	}
+
+	return diff;
+}
+
+
+
+
+QStringList JournalDiff::applyTo(const QStringList& from) const
+{
+	auto result = QStringList();
+	result.reserve(from.size());
+
+	int pos = 0;
+	for (const auto& hunk : m_hunks)
+	{
+		for (; pos < hunk.pos; ++pos) { result.append(from[pos]); }
+		result.append(hunk.inserted);
+		pos += hunk.removed;
+	}
+	for (; pos < from.size(); ++pos) { result.append(from[pos]); }
+
+	return result;
+}
+
+
+
+
+std::size_t JournalDiff::memoryUsage() const
+{
+	std::size_t bytes = sizeof(JournalDiff) + m_hunks.capacity() * sizeof(Hunk);
+	for (const auto& hunk : m_hunks)
+	{
+		for (const auto& line : hunk.inserted)
+		{
+			bytes += sizeof(QString) + line.capacity() * sizeof(QChar);
+		}
+	}
+	return bytes;
+}
+
+
+} // namespace lmms
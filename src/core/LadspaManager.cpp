@@ -32,10 +32,14 @@
 #include <QRegularExpression>
 
 #include <cmath>
+#include <future>
+#include <vector>
 
 #include "ConfigManager.h"
 #include "LadspaManager.h"
 #include "PluginFactory.h"
+#include "PluginMetadataCache.h"
+#include "ThreadPool.h"
 #include "lmms_constants.h"
 
 
@@ -64,6 +68,16 @@ LadspaManager::LadspaManager()
 	ladspaDirectories.push_back( "/Library/Audio/Plug-Ins/LADSPA" );
 #endif
 
+	struct Library
+	{
+		QString path;
+		QString file;
+		std::optional<QVariantList> plugins;
+		LADSPA_Descriptor_Function descriptorFunction = nullptr;
+		bool scanned = false;
+	};
+	std::vector<Library> libraries;
+
 	for (const auto& ladspaDirectory : ladspaDirectories)
 	{
 		// Skip empty entries as QDir will interpret it as the working directory
@@ -91,22 +105,35 @@ LadspaManager::LadspaManager()
 				continue;
 			}
 
-			QLibrary plugin_lib( f.absoluteFilePath() );
+			libraries.push_back({f.absoluteFilePath(), f.fileName()});
+		}
+	}
 
-			if( plugin_lib.load() == true )
-			{
-				auto descriptorFunction = (LADSPA_Descriptor_Function)plugin_lib.resolve("ladspa_descriptor");
-				if( descriptorFunction != nullptr )
-				{
-					addPlugins( descriptorFunction,
-							f.fileName() );
-				}
-			}
-			else
-			{
-				qWarning() << plugin_lib.errorString();
-			}
+	// Libraries are only loaded if they changed since they were last
+	// scanned, the others are loaded when one of their plugins is used
+	PluginMetadataCache cache(QStringLiteral("ladspa"), 1);
+	std::vector<std::future<void>> scans;
+	for (auto& library : libraries)
+	{
+		if (const auto cached = cache.find(library.path))
+		{
+			library.plugins = cached->toList();
+			continue;
 		}
+		library.scanned = true;
+		scans.push_back(ThreadPool::instance().enqueue([&library] {
+			library.plugins = scanLibrary(library.path, library.descriptorFunction);
+		}));
+	}
+	for (auto& scan : scans) { scan.wait(); }
+
+	// Merged in search path order, so the first library of a name still wins
+	for (const auto& library : libraries)
+	{
+		if (!library.plugins) { continue; }
+		if (library.scanned) { cache.insert(library.path, *library.plugins); }
+		addPlugins(*library.plugins, library.descriptorFunction,
+				library.path, library.file);
 	}
 	
 	l_ladspa_key_t keys = m_ladspaManagerMap.keys();
@@ -142,13 +169,49 @@ LadspaManagerDescription * LadspaManager::getDescription(
 
 
 
-void LadspaManager::addPlugins(
-		LADSPA_Descriptor_Function _descriptor_func,
-						const QString & _file )
+std::optional<QVariantList> LadspaManager::scanLibrary(
+		const QString & _library,
+		LADSPA_Descriptor_Function & _descriptor_func )
 {
+	QLibrary plugin_lib( _library );
+	if( plugin_lib.load() == false )
+	{
+		qWarning() << plugin_lib.errorString();
+		return std::nullopt;
+	}
+
+	QVariantList plugins;
+	_descriptor_func = (LADSPA_Descriptor_Function)plugin_lib.resolve("ladspa_descriptor");
+	if( _descriptor_func == nullptr )
+	{
+		return plugins;
+	}
+
 	for (long pluginIndex = 0; const auto descriptor = _descriptor_func(pluginIndex); ++pluginIndex)
 	{
-		ladspa_key_t key( _file, QString( descriptor->Label ) );
+		QVariantMap plugin;
+		plugin["label"] = QString( descriptor->Label );
+		plugin["index"] = static_cast<uint>( pluginIndex );
+		plugin["name"] = QString( descriptor->Name );
+		plugin["realTimeCapable"] = LADSPA_IS_HARD_RT_CAPABLE( descriptor->Properties ) != 0;
+		plugin["inputs"] = getPluginInputs( descriptor );
+		plugin["outputs"] = getPluginOutputs( descriptor );
+		plugins.append( plugin );
+	}
+	return plugins;
+}
+
+
+
+
+void LadspaManager::addPlugins( const QVariantList & _plugins,
+		LADSPA_Descriptor_Function _descriptor_func,
+		const QString & _library, const QString & _file )
+{
+	for (const auto& entry : _plugins)
+	{
+		const QVariantMap plugin = entry.toMap();
+		ladspa_key_t key( _file, plugin["label"].toString() );
 		if( m_ladspaManagerMap.contains( key ) )
 		{
 			continue;
@@ -156,9 +219,12 @@ void LadspaManager::addPlugins(
 
 		auto plugIn = new LadspaManagerDescription;
 		plugIn->descriptorFunction = _descriptor_func;
-		plugIn->index = pluginIndex;
-		plugIn->inputChannels = getPluginInputs( descriptor );
-		plugIn->outputChannels = getPluginOutputs( descriptor );
+		plugIn->library = _library;
+		plugIn->index = plugin["index"].toUInt();
+		plugIn->inputChannels = plugin["inputs"].toUInt();
+		plugIn->outputChannels = plugin["outputs"].toUInt();
+		plugIn->name = plugin["name"].toString();
+		plugIn->realTimeCapable = plugin["realTimeCapable"].toBool();
 
 		if( plugIn->inputChannels == 0 && plugIn->outputChannels > 0 )
 		{
@@ -299,9 +365,8 @@ bool LadspaManager::isInplaceBroken( const ladspa_key_t &  _plugin )
 bool LadspaManager::isRealTimeCapable(
 					const ladspa_key_t &  _plugin )
 {
-	const LADSPA_Descriptor * descriptor = getDescriptor( _plugin );
-	return( descriptor ? LADSPA_IS_HARD_RT_CAPABLE( descriptor->Properties )
-					   : false );
+	const LadspaManagerDescription * plugin = getDescription( _plugin );
+	return( plugin ? plugin->realTimeCapable : false );
 }
 
 
@@ -309,8 +374,8 @@ bool LadspaManager::isRealTimeCapable(
 
 QString LadspaManager::getName( const ladspa_key_t & _plugin )
 {
-	const LADSPA_Descriptor * descriptor = getDescriptor( _plugin );
-	return( descriptor ? descriptor->Name : "" );
+	const LadspaManagerDescription * plugin = getDescription( _plugin );
+	return( plugin ? plugin->name : "" );
 }
 
 
@@ -567,6 +632,19 @@ const LADSPA_Descriptor * LadspaManager::getDescriptor(const ladspa_key_t & _plu
 	{
 		auto const plugin = *it;
 
+		if (plugin->descriptorFunction == nullptr)
+		{
+			QLibrary plugin_lib(plugin->library);
+			if (!plugin_lib.load())
+			{
+				qWarning() << plugin_lib.errorString();
+				return nullptr;
+			}
+			plugin->descriptorFunction =
+				(LADSPA_Descriptor_Function)plugin_lib.resolve("ladspa_descriptor");
+			if (plugin->descriptorFunction == nullptr) { return nullptr; }
+		}
+
 		LADSPA_Descriptor_Function descriptorFunction = plugin->descriptorFunction;
 		const LADSPA_Descriptor* descriptor = descriptorFunction(plugin->index);
 
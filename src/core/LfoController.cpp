@@ -27,6 +27,7 @@
 
 #include <QDomElement>
 #include <QFileInfo>
+#include <algorithm>
 
 #include "AudioEngine.h"
 #include "Oscillator.h"
@@ -37,6 +38,22 @@
 namespace lmms
 {
 
+namespace
+{
+
+//! Calculates every frame from its own phase instead of the previous one's,
+//! so the loop can be vectorized
+template<sample_t (*sample)(const float)>
+void fillWave(float* values, f_cnt_t frames, float phase, float phaseIncrement)
+{
+	for (f_cnt_t f = 0; f < frames; ++f)
+	{
+		values[f] = sample(phase + f * phaseIncrement);
+	}
+}
+
+} // namespace
+
 
 LfoController::LfoController( Model * _parent ) :
 	Controller( ControllerType::Lfo, _parent, tr( "LFO Controller" ) ),
@@ -50,7 +67,8 @@ LfoController::LfoController( Model * _parent ) :
 	m_duration( 1000 ),
 	m_phaseOffset( 0 ),
 	m_currentPhase( 0 ),
-	m_sampleFunction( &Oscillator::sinSample ),
+	m_waveFunction( &fillWave<&Oscillator::sinSample> ),
+	m_randomKey(Engine::audioEngine()->newSharedRandomKey()),
 	m_userDefSampleBuffer(std::make_shared<SampleBuffer>())
 {
 	setSampleExact( true );
@@ -101,46 +119,60 @@ void LfoController::updateValueBuffer()
 		m_bufferLastUpdated += diff;
 	}
 
-	float amount = m_amountModel.value();
-	ValueBuffer *amountBuffer = m_amountModel.valueBuffer();
-	int amountInc = amountBuffer ? 1 : 0;
-	float *amountPtr = amountBuffer ? &(amountBuffer->values()[ 0 ] ) : &amount;
-	Oscillator::WaveShape waveshape = static_cast<Oscillator::WaveShape>(m_waveModel.value());
+	const auto frames = static_cast<f_cnt_t>( m_valueBuffer.length() );
+	const float phaseIncrement = 1.0 / m_duration;
+	float* values = m_valueBuffer.values();
+	m_valueBuffer.markVarying();
+	// computed by whichever job reads the controller first
+	const auto random = AudioEngine::SharedRandomScope{Engine::audioEngine(), m_randomKey};
 
-	for( float& f : m_valueBuffer )
+	// generate the wave for the whole period first
+	switch( static_cast<Oscillator::WaveShape>( m_waveModel.value() ) )
 	{
-		float currentSample = 0;
-		switch (waveshape)
-		{
-		case Oscillator::WaveShape::WhiteNoise:
+	case Oscillator::WaveShape::WhiteNoise:
+		for( f_cnt_t f = 0; f < frames; ++f )
 		{
-			if (absFraction(phase) < absFraction(phasePrev))
+			if( absFraction( phase ) < absFraction( phasePrev ) )
 			{
 				// Resample when phase period has completed
-				m_heldSample = m_sampleFunction(phase);
+				m_heldSample = Oscillator::noiseSample( phase );
 			}
-			currentSample = m_heldSample;
-			break;
+			values[f] = m_heldSample;
+			phasePrev = phase;
+			phase += phaseIncrement;
 		}
-		case Oscillator::WaveShape::UserDefined:
+		break;
+	case Oscillator::WaveShape::UserDefined:
+		for( f_cnt_t f = 0; f < frames; ++f )
 		{
-			currentSample = Oscillator::userWaveSample(m_userDefSampleBuffer.get(), phase);
-			break;
+			values[f] = Oscillator::userWaveSample( m_userDefSampleBuffer.get(), phase + f * phaseIncrement );
 		}
-		default:
+		phase += frames * phaseIncrement;
+		break;
+	default:
+		if( m_waveFunction ) { m_waveFunction( values, frames, phase, phaseIncrement ); }
+		else { std::fill_n( values, frames, 0.f ); }
+		phase += frames * phaseIncrement;
+		break;
+	}
+
+	// then scale it around the base value
+	const float base = m_baseModel.value();
+	if( const ValueBuffer* amountBuffer = m_amountModel.valueBuffer() )
+	{
+		const float* amounts = amountBuffer->values();
+		for( f_cnt_t f = 0; f < frames; ++f )
 		{
-			if (m_sampleFunction != nullptr)
-			{
-				currentSample = m_sampleFunction(phase);
-			}
+			values[f] = std::clamp( base + amounts[f] * values[f] * 0.5f, 0.0f, 1.0f );
 		}
 	}
-
-		f = std::clamp(m_baseModel.value() + (*amountPtr * currentSample / 2.0f), 0.0f, 1.0f);
-
-		phasePrev = phase;
-		phase += 1.0 / m_duration;
-		amountPtr += amountInc;
+	else
+	{
+		const float amount = m_amountModel.value() * 0.5f;
+		for( f_cnt_t f = 0; f < frames; ++f )
+		{
+			values[f] = std::clamp( base + amount * values[f], 0.0f, 1.0f );
+		}
 	}
 
 	m_currentPhase = absFraction(phase - m_phaseOffset);
@@ -181,33 +213,29 @@ void LfoController::updateSampleFunction()
 	{
 		case Oscillator::WaveShape::Sine:
 		default:
-			m_sampleFunction = &Oscillator::sinSample;
+			m_waveFunction = &fillWave<&Oscillator::sinSample>;
 			break;
 		case Oscillator::WaveShape::Triangle:
-			m_sampleFunction = &Oscillator::triangleSample;
+			m_waveFunction = &fillWave<&Oscillator::triangleSample>;
 			break;
 		case Oscillator::WaveShape::Saw:
-			m_sampleFunction = &Oscillator::sawSample;
+			m_waveFunction = &fillWave<&Oscillator::sawSample>;
 			break;
 		case Oscillator::WaveShape::Square:
-			m_sampleFunction = &Oscillator::squareSample;
+			m_waveFunction = &fillWave<&Oscillator::squareSample>;
 			break;
 		case Oscillator::WaveShape::MoogSaw:
-			m_sampleFunction = &Oscillator::moogSawSample;
+			m_waveFunction = &fillWave<&Oscillator::moogSawSample>;
 			break;
 		case Oscillator::WaveShape::Exponential:
-			m_sampleFunction = &Oscillator::expSample;
+			m_waveFunction = &fillWave<&Oscillator::expSample>;
 			break;
 		case Oscillator::WaveShape::WhiteNoise:
-			m_sampleFunction = &Oscillator::noiseSample;
+			m_waveFunction = &fillWave<&Oscillator::noiseSample>;
 			break;
 		case Oscillator::WaveShape::UserDefined:
-			m_sampleFunction = nullptr;
-			/*TODO: If C++11 is allowed, should change the type of
-			 m_sampleFunction be std::function<sample_t(const float)>
-			 and use the line below:
-			*/
-			//m_sampleFunction = &(m_userDefSampleBuffer->userWaveSample)
+			// needs the buffer, see updateValueBuffer()
+			m_waveFunction = nullptr;
 			break;
 	}
 }
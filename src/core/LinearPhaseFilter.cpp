@@ -0,0 +1,149 @@
+/*
+ * LinearPhaseFilter.cpp - FIR filter with a linear phase, designed from a magnitude response
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "LinearPhaseFilter.h"
+
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <numbers>
+#include <vector>
+
+#include "AudioEngine.h"
+#include "Engine.h"
+#include "SampleFrame.h"
+#include "ThreadPool.h"
+
+namespace lmms
+{
+
+LinearPhaseFilter::LinearPhaseFilter(std::size_t length, sample_rate_t sampleRate)
+	: m_length(length)
+	, m_periodSize(Engine::audioEngine()->maxFramesPerPeriod())
+	, m_sampleRate(sampleRate)
+	, m_fadeOut(makeFftwBuffer<float>(m_periodSize))
+{
+	Engine::audioEngine()->holdFramesPerPeriod();
+
+	const auto partitions = (m_length + m_periodSize - 1) / m_periodSize;
+	for (int ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+	{
+		m_channels[ch] = std::make_unique<UniformConvolver>(m_periodSize, partitions);
+		m_in[ch] = makeFftwBuffer<float>(m_periodSize);
+		m_out[ch] = makeFftwBuffer<float>(m_periodSize);
+	}
+
+	// only a delay until the first response is designed
+	auto impulse = std::vector<float>(m_length);
+	impulse[m_length / 2] = 1.f;
+	m_responses[m_played] = PartitionedResponse::partition(impulse.data(), m_length, m_periodSize);
+}
+
+LinearPhaseFilter::~LinearPhaseFilter()
+{
+	if (m_job.valid()) { m_job.wait(); }
+	Engine::audioEngine()->releaseFramesPerPeriod();
+}
+
+auto LinearPhaseFilter::lengthFor(sample_rate_t sampleRate) -> std::size_t
+{
+	return std::bit_ceil(static_cast<std::size_t>(sampleRate / 10));
+}
+
+void LinearPhaseFilter::setMagnitude(Magnitude magnitude)
+{
+	m_pending = std::move(magnitude);
+}
+
+void LinearPhaseFilter::process(SampleFrame* buf, fpp_t frames)
+{
+	if (static_cast<std::size_t>(frames) != m_periodSize) { return; }
+
+	if (m_job.valid() && m_job.wait_for(std::chrono::seconds{0}) == std::future_status::ready)
+	{
+		m_job.get();
+		m_played = 1 - m_played;
+		m_fading = true;
+	}
+
+	const auto& played = m_responses[m_played];
+	const auto& previous = m_responses[1 - m_played];
+	for (int ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+	{
+		float* x = m_in[ch].get();
+		float* y = m_out[ch].get();
+		for (fpp_t f = 0; f < frames; ++f) { x[f] = buf[f][ch]; }
+
+		m_channels[ch]->process(x, played, y);
+		if (m_fading)
+		{
+			// the input is the same for both responses, only the output is convolved twice
+			float* old = m_fadeOut.get();
+			m_channels[ch]->convolve(previous, old);
+			for (fpp_t f = 0; f < frames; ++f)
+			{
+				const float t = (f + 1.f) / frames;
+				y[f] = old[f] + t * (y[f] - old[f]);
+			}
+		}
+
+		for (fpp_t f = 0; f < frames; ++f) { buf[f][ch] = y[f]; }
+	}
+	m_fading = false;
+
+	// the response not played is free again once the output faded over
+	if (m_pending && !m_job.valid())
+	{
+		const int target = 1 - m_played;
+		m_job = ThreadPool::instance().enqueue(
+			[this, target, magnitude = std::move(m_pending)] { design(magnitude, target); });
+		m_pending = nullptr;
+	}
+}
+
+void LinearPhaseFilter::design(const Magnitude& magnitude, int target)
+{
+	const auto bins = m_length / 2 + 1;
+	auto spectrum = makeFftwBuffer<fftwf_complex>(bins);
+	auto kernel = makeFftwBuffer<float>(m_length);
+
+	// a real spectrum has no phase, alternating signs delay the kernel by half its length
+	for (std::size_t bin = 0; bin < bins; ++bin)
+	{
+		const float gain = magnitude(static_cast<float>(bin) * m_sampleRate / m_length);
+		spectrum[bin][0] = bin % 2 == 0 ? gain : -gain;
+		spectrum[bin][1] = 0.f;
+	}
+	fftwf_execute_dft_c2r(inverseRealFftPlan(m_length), spectrum.get(), kernel.get());
+
+	// the window smooths the ends of the truncated kernel, the scale undoes the one of the FFT
+	using std::numbers::pi_v;
+	for (std::size_t n = 0; n < m_length; ++n)
+	{
+		const float window = 0.5f - 0.5f * std::cos(2 * pi_v<float> * n / m_length);
+		kernel[n] *= window / m_length;
+	}
+
+	m_responses[target] = PartitionedResponse::partition(kernel.get(), m_length, m_periodSize);
+}
+
+} // namespace lmms
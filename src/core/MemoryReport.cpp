@@ -0,0 +1,202 @@
+/*
+ * MemoryReport.cpp - tells where the memory of the loaded project goes
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "MemoryReport.h"
+
+#include <algorithm>
+#include <array>
+
+#include "AudioEngine.h"
+#include "BandLimitedWave.h"
+#include "BufferManager.h"
+#include "Effect.h"
+#include "EffectChain.h"
+#include "Engine.h"
+#include "Instrument.h"
+#include "InstrumentTrack.h"
+#include "Mixer.h"
+#include "NotePlayHandle.h"
+#include "Oscillator.h"
+#include "PatternStore.h"
+#include "ProjectJournal.h"
+#include "SampleCache.h"
+#include "SampleThumbnail.h"
+#include "SampleTrack.h"
+#include "Song.h"
+
+namespace lmms {
+
+namespace {
+
+//! Calls @p add with the name of the track and each plugin of @p tracks
+template<typename Add>
+void addPlugins(const TrackContainer::TrackList& tracks, const Add& add)
+{
+	for (const auto track : tracks)
+	{
+		EffectChain* effects = nullptr;
+		if (const auto instrumentTrack = dynamic_cast<InstrumentTrack*>(track))
+		{
+			if (instrumentTrack->instrument()) { add(track->name(), instrumentTrack->instrument()); }
+			effects = instrumentTrack->audioBusHandle()->effects();
+		}
+		else if (const auto sampleTrack = dynamic_cast<SampleTrack*>(track))
+		{
+			effects = sampleTrack->audioBusHandle()->effects();
+		}
+
+		if (!effects) { continue; }
+		for (const auto effect : effects->effects())
+		{
+			add(track->name(), effect);
+		}
+	}
+}
+
+} // namespace
+
+auto MemoryReport::collect() -> MemoryReport
+{
+	auto report = MemoryReport{};
+
+	for (const auto& usage : SampleCache::usage())
+	{
+		report.add(Category::Samples, usage.inUse ? usage.file : usage.file + " (cached)", usage.bytes);
+	}
+
+	report.add(Category::Wavetables, "Oscillator", Oscillator::waveTableMemoryUsage());
+	report.add(Category::Wavetables, "Band-limited waves", BandLimitedWave::memoryUsage());
+
+	{
+		// plugins may swap what they hold while processing
+		Engine::audioEngine()->requestChangeInModel();
+
+		const auto addPlugin = [&report](const QString& owner, const Plugin* plugin) {
+			report.add(Category::Plugins, owner + ": " + plugin->displayName(), plugin->memoryUsage());
+		};
+		addPlugins(Engine::getSong()->tracks(), addPlugin);
+		addPlugins(Engine::patternStore()->tracks(), addPlugin);
+
+		Mixer* mixer = Engine::mixer();
+		for (int i = 0; i < mixer->numChannels(); ++i)
+		{
+			const MixerChannel* channel = mixer->mixerChannel(i);
+			for (const auto effect : channel->m_fxChain.effects())
+			{
+				addPlugin(channel->m_name, effect);
+			}
+		}
+		report.add(Category::MixerBuffers, "Mixer channels", mixer->memoryUsage());
+
+		Engine::audioEngine()->doneChangeInModel();
+	}
+
+	report.add(Category::UndoJournal, "Undo and redo checkpoints", Engine::projectJournal()->memoryUsage());
+	report.add(Category::Thumbnails, "Sample thumbnails", SampleThumbnail::memoryUsage());
+	report.add(Category::NotePlayHandles, "Voice pools", NotePlayHandleManager::memoryUsage());
+
+	const auto bufferBytes = BufferManager::Alignment + BufferManager::framesPerPeriod() * sizeof(SampleFrame);
+	report.add(Category::MixerBuffers, "Buffer pool", BufferManager::stats().capacity * bufferBytes);
+
+	std::stable_sort(report.m_entries.begin(), report.m_entries.end(),
+		[](const Entry& a, const Entry& b) { return a.bytes > b.bytes; });
+	return report;
+}
+
+auto MemoryReport::total() const -> std::size_t
+{
+	auto bytes = std::size_t{0};
+	for (const auto& entry : m_entries) { bytes += entry.bytes; }
+	return bytes;
+}
+
+auto MemoryReport::total(Category category) const -> std::size_t
+{
+	auto bytes = std::size_t{0};
+	for (const auto& entry : m_entries)
+	{
+		if (entry.category == category) { bytes += entry.bytes; }
+	}
+	return bytes;
+}
+
+auto MemoryReport::categoryName(Category category) -> QString
+{
+	switch (category)
+	{
+		case Category::Samples: return "Samples";
+		case Category::Wavetables: return "Wavetables";
+		case Category::Plugins: return "Plugins";
+		case Category::UndoJournal: return "Undo journal";
+		case Category::Thumbnails: return "Thumbnails";
+		case Category::NotePlayHandles: return "Note play handles";
+		case Category::MixerBuffers: return "Mixer buffers";
+		default: return QString{};
+	}
+}
+
+auto MemoryReport::formatBytes(std::size_t bytes) -> QString
+{
+	constexpr auto units = std::array{"B", "KiB", "MiB", "GiB", "TiB"};
+
+	auto value = static_cast<double>(bytes);
+	auto unit = std::size_t{0};
+	while (value >= 1024. && unit + 1 < units.size())
+	{
+		value /= 1024.;
+		++unit;
+	}
+	return unit == 0
+		? QString("%1 B").arg(bytes)
+		: QString("%1 %2").arg(value, 0, 'f', 1).arg(units[unit]);
+}
+
+auto MemoryReport::toString() const -> QString
+{
+	const auto bytes = [](std::size_t b) { return formatBytes(b).rightJustified(12); };
+
+	auto text = QString("Category").leftJustified(56) + QString("Memory").rightJustified(12) + '\n';
+	for (auto c = std::size_t{0}; c < static_cast<std::size_t>(Category::Count); ++c)
+	{
+		const auto category = static_cast<Category>(c);
+		text += categoryName(category).leftJustified(56) + bytes(total(category)) + '\n';
+	}
+	text += QString("Total").leftJustified(56) + bytes(total()) + "\n\n";
+
+	text += QString("Category").leftJustified(20) + QString("Name").leftJustified(36)
+		+ QString("Memory").rightJustified(12) + '\n';
+	for (const auto& entry : m_entries)
+	{
+		text += categoryName(entry.category).leftJustified(19) + ' ' + entry.name.leftJustified(35) + ' '
+			+ bytes(entry.bytes) + '\n';
+	}
+	return text;
+}
+
+void MemoryReport::add(Category category, const QString& name, std::size_t bytes)
+{
+	// e.g. plugins which can't tell, or subsystems not used so far
+	if (bytes == 0) { return; }
+	m_entries.push_back(Entry{category, name, bytes});
+}
+
+} // namespace lmms
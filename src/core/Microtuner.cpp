@@ -55,6 +55,15 @@ Microtuner::Microtuner() :
 	}
 	connect(Engine::getSong(), SIGNAL(scaleListChanged(int)), this, SLOT(updateScaleList(int)));
 	connect(Engine::getSong(), SIGNAL(keymapListChanged(int)), this, SLOT(updateKeymapList(int)));
+
+	// direct, so the frequencies are up to date for whoever else is notified
+	const auto update = [this] { updateFrequencies(); };
+	connect(&m_scaleModel, &Model::dataChanged, this, update, Qt::DirectConnection);
+	connect(&m_keymapModel, &Model::dataChanged, this, update, Qt::DirectConnection);
+	connect(&m_keyRangeImportModel, &Model::dataChanged, this, update, Qt::DirectConnection);
+	connect(Engine::getSong(), &Song::scaleListChanged, this, update, Qt::DirectConnection);
+	connect(Engine::getSong(), &Song::keymapListChanged, this, update, Qt::DirectConnection);
+	updateFrequencies();
 }
 
 
@@ -65,47 +74,65 @@ Microtuner::Microtuner() :
 float Microtuner::keyToFreq(int key, int userBaseNote) const
 {
 	if (key < 0 || key >= NumKeys) {return 0;}
-	Song *song = Engine::getSong();
-	if (!song) {return 0;}
 
-	// Get keymap and scale selected at this moment
-	std::shared_ptr<const Keymap> keymap = song->getKeymap(m_keymapModel.value());
-	std::shared_ptr<const Scale> scale = song->getScale(m_scaleModel.value());
+	const auto table = std::atomic_load(&m_frequencies);
+	const int baseNote = table->baseKey >= 0 ? table->baseKey : userBaseNote;
+	if (baseNote < 0 || baseNote >= NumKeys) {return 0;}
+
+	return table->middleFrequencies[baseNote] * table->ratios[key];
+}
+
+/** \brief Computes the frequency tables for the scale and keymap selected at this moment.
+ *
+ * The octaves are primarily driven by the keymap wraparound: octave count is increased or decreased if the key
+ * goes over or under keymap range. In case the keymap refers to a degree that does not exist in the scale, it is
+ * assumed the keymap is non-repeating or just really big, so the octaves are also driven by the scale wraparound.
+ */
+void Microtuner::updateFrequencies()
+{
+	const Song* song = Engine::getSong();
+	const std::shared_ptr<const Keymap> keymap = song->getKeymap(m_keymapModel.value());
+	const std::shared_ptr<const Scale> scale = song->getScale(m_scaleModel.value());
 	const std::vector<Interval> &intervals = scale->getIntervals();
 
-	// Convert MIDI key to scale degree + octave offset.
-	// The octaves are primarily driven by the keymap wraparound: octave count is increased or decreased if the key
-	// goes over or under keymap range. In case the keymap refers to a degree that does not exist in the scale, it is
-	// assumed the keymap is non-repeating or just really big, so the octaves are also driven by the scale wraparound.
-	const int keymapDegree = keymap->getDegree(key);		// which interval should be used according to the keymap
-	if (keymapDegree == -1) {return 0;}						// key is not mapped, abort
-	const int keymapOctave = keymap->getOctave(key);		// how many times did the keymap repeat
-	const int octaveDegree = intervals.size() - 1;			// index of the interval with octave ratio
-	if (octaveDegree == 0) {								// octave interval is 1/1, i.e. constant base frequency
-		return keymap->getBaseFreq();						// → return the baseFreq directly
-	}
-	const int scaleOctave = keymapDegree / octaveDegree;
+	auto table = std::make_shared<FrequencyTable>();
+	table->baseKey = m_keyRangeImportModel.value() ? keymap->getBaseKey() : -1;
 
-	// which interval should be used according to the scale and keymap together
-	const int degree_rem = keymapDegree % octaveDegree;
-	const int scaleDegree = degree_rem >= 0 ? degree_rem : degree_rem + octaveDegree;	// get true modulo
+	const int octaveDegree = intervals.size() - 1;			// index of the interval with octave ratio
+	// converts a MIDI key to scale degree + octave offset, returns false if the key is not mapped
+	const auto degreeAndOctave = [&](int key, int& degree, int& octave)
+	{
+		const int keymapDegree = keymap->getDegree(key);	// which interval should be used according to the keymap
+		if (keymapDegree == -1) {return false;}
+		const int degree_rem = keymapDegree % octaveDegree;
+		degree = degree_rem >= 0 ? degree_rem : degree_rem + octaveDegree;	// get true modulo
+		octave = keymap->getOctave(key) + keymapDegree / octaveDegree;
+		return true;
+	};
+
+	for (int key = 0; key < NumKeys; ++key)
+	{
+		if (octaveDegree == 0)								// octave interval is 1/1, i.e. constant base frequency
+		{
+			table->middleFrequencies[key] = keymap->getBaseFreq();
+			table->ratios[key] = keymap->getDegree(key) == -1 ? 0. : 1.;
+			continue;
+		}
 
-	// Compute base note (the "A4 reference") degree and octave
-	const int baseNote = m_keyRangeImportModel.value() ? keymap->getBaseKey() : userBaseNote;
-	const int baseKeymapDegree = keymap->getDegree(baseNote);
-	if (baseKeymapDegree == -1) {return 0;}					// base key is not mapped, umm...
-	const int baseKeymapOctave = keymap->getOctave(baseNote);
-	const int baseScaleOctave = baseKeymapDegree / octaveDegree;
+		int degree = 0, octave = 0;
+		const double octaveRatio = intervals[octaveDegree].getRatio();
 
-	const int baseDegree_rem = baseKeymapDegree % octaveDegree;
-	const int baseScaleDegree = baseDegree_rem >= 0 ? baseDegree_rem : baseDegree_rem + octaveDegree;
+		// the frequency of the middle note if this key is the base note (the "A4 reference")
+		table->middleFrequencies[key] = degreeAndOctave(key, degree, octave)
+			? (keymap->getBaseFreq() / std::pow(octaveRatio, octave)) / intervals[degree].getRatio()
+			: 0.f;														// base key is not mapped, umm...
 
-	// Compute frequency of the middle note and return the final frequency
-	const double octaveRatio = intervals[octaveDegree].getRatio();
-	const float middleFreq = (keymap->getBaseFreq() / std::pow(octaveRatio, baseScaleOctave + baseKeymapOctave))
-		/ intervals[baseScaleDegree].getRatio();
+		table->ratios[key] = degreeAndOctave(key, degree, octave)
+			? intervals[degree].getRatio() * std::pow(octaveRatio, octave)
+			: 0.;														// key is not mapped
+	}
 
-	return middleFreq * intervals[scaleDegree].getRatio() * std::pow(octaveRatio, keymapOctave + scaleOctave);
+	std::atomic_store(&m_frequencies, std::shared_ptr<const FrequencyTable>(std::move(table)));
 }
 
 int Microtuner::octaveSize() const
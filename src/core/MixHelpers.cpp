@@ -28,11 +28,24 @@
 #include <cstdio>
 #endif
 
+#include <algorithm>
 #include <cmath>
 
 #include "ValueBuffer.h"
 #include "SampleFrame.h"
 
+#if defined(__SSE2__) || defined(_M_X64)
+#	define LMMS_MIXHELPERS_SSE2
+#	include <emmintrin.h>
+#	if defined(__GNUC__)
+#		define LMMS_MIXHELPERS_AVX2
+#		include <immintrin.h>
+#	endif
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#	define LMMS_MIXHELPERS_NEON
+#	include <arm_neon.h>
+#endif
+
 
 
 static bool s_NaNHandler;
@@ -64,13 +77,57 @@ static inline void run( SampleFrame* dst, const sample_t* srcLeft, const sample_
 
 
 
-bool isSilent( const SampleFrame* src, int frames )
+namespace
+{
+
+constexpr float SilenceThreshold = 0.0000001f;
+constexpr float SanitizeLimit = 1000.0f;
+
+
+/*! \brief Implementations of the hot mixing functions for one instruction set
+ *
+ * All of them must compute exactly the same operations in the same order as
+ * the scalar versions (in particular no fused multiply-add), so the results
+ * don't depend on the CPU.
+ */
+struct Kernels
+{
+	bool (*isSilent)(const SampleFrame* src, int frames);
+	bool (*sanitize)(SampleFrame* src, int frames);
+	void (*add)(SampleFrame* dst, const SampleFrame* src, int frames);
+	void (*multiply)(SampleFrame* dst, float coeff, int frames);
+	void (*addMultiplied)(SampleFrame* dst, const SampleFrame* src, float coeffSrc, int frames);
+	void (*addMultipliedByBuffer)(SampleFrame* dst, const SampleFrame* src, float coeffSrc,
+		const float* coeffSrcBuf, int frames);
+	void (*addMultipliedByBuffers)(SampleFrame* dst, const SampleFrame* src,
+		const float* coeffSrcBuf1, const float* coeffSrcBuf2, int frames);
+	void (*addSanitizedMultiplied)(SampleFrame* dst, const SampleFrame* src, float coeffSrc, int frames);
+	void (*addSanitizedMultipliedByBuffer)(SampleFrame* dst, const SampleFrame* src, float coeffSrc,
+		const float* coeffSrcBuf, int frames);
+	void (*addSanitizedMultipliedByBuffers)(SampleFrame* dst, const SampleFrame* src,
+		const float* coeffSrcBuf1, const float* coeffSrcBuf2, int frames);
+	void (*multiplyStereo)(SampleFrame* dst, float coeffLeft, float coeffRight, int frames);
+	void (*multiplyByBuffer)(SampleFrame* dst, const float* coeffBuf, int frames);
+	void (*multiplyAndAddMultiplied)(SampleFrame* dst, const SampleFrame* src, float coeffDst, float coeffSrc,
+		int frames);
+	SampleFrame (*absPeak)(const SampleFrame* src, int frames);
+	SampleFrame (*sumOfSquares)(const SampleFrame* src, int frames);
+	void (*levels)(const SampleFrame* src, int frames, SampleFrame& peak, SampleFrame& sumOfSquares);
+	void (*interleave)(SampleFrame* dst, const float* left, const float* right, int frames);
+	void (*deinterleave)(float* left, float* right, const SampleFrame* src, int frames);
+};
+
+
+
+
+namespace scalar
 {
-	const float silenceThreshold = 0.0000001f;
 
+bool isSilent( const SampleFrame* src, int frames )
+{
 	for( int i = 0; i < frames; ++i )
 	{
-		if (std::abs(src[i][0]) >= silenceThreshold || std::abs(src[i][1]) >= silenceThreshold)
+		if (std::abs(src[i][0]) >= SilenceThreshold || std::abs(src[i][1]) >= SilenceThreshold)
 		{
 			return false;
 		}
@@ -79,24 +136,8 @@ bool isSilent( const SampleFrame* src, int frames )
 	return true;
 }
 
-bool useNaNHandler()
-{
-	return s_NaNHandler;
-}
-
-void setNaNHandler( bool use )
-{
-	s_NaNHandler = use;
-}
-
-/*! \brief Function for sanitizing a buffer of infs/nans - returns true if those are found */
 bool sanitize( SampleFrame* src, int frames )
 {
-	if( !useNaNHandler() )
-	{
-		return false;
-	}
-
 	for (int f = 0; f < frames; ++f)
 	{
 		auto& currentFrame = src[f];
@@ -116,7 +157,7 @@ bool sanitize( SampleFrame* src, int frames )
 		}
 		else
 		{
-			currentFrame.clamp(sample_t(-1000.0), sample_t(1000.0));
+			currentFrame.clamp(-SanitizeLimit, SanitizeLimit);
 		}
 	};
 
@@ -138,6 +179,14 @@ void add( SampleFrame* dst, const SampleFrame* src, int frames )
 }
 
 
+void multiply(SampleFrame* dst, float coeff, int frames)
+{
+	for (int i = 0; i < frames; ++i)
+	{
+		dst[i] *= coeff;
+	}
+}
+
 
 struct AddMultipliedOp
 {
@@ -151,119 +200,1404 @@ struct AddMultipliedOp
 	const float m_coeff;
 } ;
 
-
 void addMultiplied( SampleFrame* dst, const SampleFrame* src, float coeffSrc, int frames )
 {
 	run<>( dst, src, frames, AddMultipliedOp(coeffSrc) );
 }
 
 
-struct AddSwappedMultipliedOp
+void addMultipliedByBuffer( SampleFrame* dst, const SampleFrame* src, float coeffSrc, const float* coeffSrcBuf, int frames )
 {
-	AddSwappedMultipliedOp( float coeff ) : m_coeff( coeff ) { }
+	for( int f = 0; f < frames; ++f )
+	{
+		dst[f][0] += src[f][0] * coeffSrc * coeffSrcBuf[f];
+		dst[f][1] += src[f][1] * coeffSrc * coeffSrcBuf[f];
+	}
+}
+
+void addMultipliedByBuffers( SampleFrame* dst, const SampleFrame* src, const float* coeffSrcBuf1, const float* coeffSrcBuf2, int frames )
+{
+	for( int f = 0; f < frames; ++f )
+	{
+		dst[f][0] += src[f][0] * coeffSrcBuf1[f] * coeffSrcBuf2[f];
+		dst[f][1] += src[f][1] * coeffSrcBuf1[f] * coeffSrcBuf2[f];
+	}
+
+}
+
+
+struct AddSanitizedMultipliedOp
+{
+	AddSanitizedMultipliedOp( float coeff ) : m_coeff( coeff ) { }
 
 	void operator()( SampleFrame& dst, const SampleFrame& src ) const
 	{
-		dst[0] += src[1] * m_coeff;
-		dst[1] += src[0] * m_coeff;
+		dst[0] += ( std::isinf( src[0] ) || std::isnan( src[0] ) ) ? 0.0f : src[0] * m_coeff;
+		dst[1] += ( std::isinf( src[1] ) || std::isnan( src[1] ) ) ? 0.0f : src[1] * m_coeff;
 	}
 
 	const float m_coeff;
 };
 
-void multiply(SampleFrame* dst, float coeff, int frames)
+void addSanitizedMultiplied( SampleFrame* dst, const SampleFrame* src, float coeffSrc, int frames )
 {
-	for (int i = 0; i < frames; ++i)
+	run<>( dst, src, frames, AddSanitizedMultipliedOp(coeffSrc) );
+}
+
+
+void addSanitizedMultipliedByBuffer( SampleFrame* dst, const SampleFrame* src, float coeffSrc, const float* coeffSrcBuf, int frames )
+{
+	for( int f = 0; f < frames; ++f )
 	{
-		dst[i] *= coeff;
+		dst[f][0] += ( std::isinf( src[f][0] ) || std::isnan( src[f][0] ) ) ? 0.0f : src[f][0] * coeffSrc * coeffSrcBuf[f];
+		dst[f][1] += ( std::isinf( src[f][1] ) || std::isnan( src[f][1] ) ) ? 0.0f : src[f][1] * coeffSrc * coeffSrcBuf[f];
 	}
 }
 
-void addSwappedMultiplied( SampleFrame* dst, const SampleFrame* src, float coeffSrc, int frames )
+void addSanitizedMultipliedByBuffers( SampleFrame* dst, const SampleFrame* src, const float* coeffSrcBuf1, const float* coeffSrcBuf2, int frames )
 {
-	run<>( dst, src, frames, AddSwappedMultipliedOp(coeffSrc) );
+	for( int f = 0; f < frames; ++f )
+	{
+		dst[f][0] += ( std::isinf( src[f][0] ) || std::isnan( src[f][0] ) )
+			? 0.0f
+			: src[f][0] * coeffSrcBuf1[f] * coeffSrcBuf2[f];
+		dst[f][1] += ( std::isinf( src[f][1] ) || std::isnan( src[f][1] ) )
+			? 0.0f
+			: src[f][1] * coeffSrcBuf1[f] * coeffSrcBuf2[f];
+	}
+
 }
 
+void multiplyStereo(SampleFrame* dst, float coeffLeft, float coeffRight, int frames)
+{
+	for (int f = 0; f < frames; ++f)
+	{
+		dst[f][0] *= coeffLeft;
+		dst[f][1] *= coeffRight;
+	}
+}
 
-void addMultipliedByBuffer( SampleFrame* dst, const SampleFrame* src, float coeffSrc, ValueBuffer * coeffSrcBuf, int frames )
+void multiplyByBuffer(SampleFrame* dst, const float* coeffBuf, int frames)
 {
-	for( int f = 0; f < frames; ++f )
+	for (int f = 0; f < frames; ++f)
 	{
-		dst[f][0] += src[f][0] * coeffSrc * coeffSrcBuf->values()[f];
-		dst[f][1] += src[f][1] * coeffSrc * coeffSrcBuf->values()[f];
+		dst[f][0] *= coeffBuf[f];
+		dst[f][1] *= coeffBuf[f];
 	}
 }
 
-void addMultipliedByBuffers( SampleFrame* dst, const SampleFrame* src, ValueBuffer * coeffSrcBuf1, ValueBuffer * coeffSrcBuf2, int frames )
+void multiplyAndAddMultiplied(SampleFrame* dst, const SampleFrame* src, float coeffDst, float coeffSrc, int frames)
 {
-	for( int f = 0; f < frames; ++f )
+	for (int f = 0; f < frames; ++f)
 	{
-		dst[f][0] += src[f][0] * coeffSrcBuf1->values()[f] * coeffSrcBuf2->values()[f];
-		dst[f][1] += src[f][1] * coeffSrcBuf1->values()[f] * coeffSrcBuf2->values()[f];
+		dst[f][0] = dst[f][0] * coeffDst + src[f][0] * coeffSrc;
+		dst[f][1] = dst[f][1] * coeffDst + src[f][1] * coeffSrc;
 	}
+}
 
+SampleFrame absPeak(const SampleFrame* src, int frames)
+{
+	// nans are skipped, like the vectorised versions do
+	auto peak = SampleFrame{};
+	for (int f = 0; f < frames; ++f)
+	{
+		const auto value = src[f].abs();
+		if (value[0] > peak[0]) { peak[0] = value[0]; }
+		if (value[1] > peak[1]) { peak[1] = value[1]; }
+	}
+	return peak;
 }
 
-void addSanitizedMultipliedByBuffer( SampleFrame* dst, const SampleFrame* src, float coeffSrc, ValueBuffer * coeffSrcBuf, int frames )
+//! Frames the sums of squares are accumulated in separately, the vectorised
+//! versions keep them in one lane each
+constexpr int SquaresLaneFrames = 4;
+
+//! Sums up the lanes of @p lanes, which hold the squares of the first frames of
+//! @p src, and the squares of the remaining @p tailFrames frames starting at @p tail
+SampleFrame reduceSquares(const float* lanes, const SampleFrame* tail, int tailFrames)
 {
-	if ( !useNaNHandler() )
+	auto sums = SampleFrame{(lanes[0] + lanes[2]) + (lanes[4] + lanes[6]), (lanes[1] + lanes[3]) + (lanes[5] + lanes[7])};
+	for (int f = 0; f < tailFrames; ++f)
 	{
-		addMultipliedByBuffer( dst, src, coeffSrc, coeffSrcBuf,
-								frames );
-		return;
+		sums[0] += tail[f][0] * tail[f][0];
+		sums[1] += tail[f][1] * tail[f][1];
 	}
+	return sums;
+}
 
-	for( int f = 0; f < frames; ++f )
+SampleFrame sumOfSquares(const SampleFrame* src, int frames)
+{
+	const float* s = src->data();
+	float lanes[2 * SquaresLaneFrames] = {};
+	const int vecFrames = frames - frames % SquaresLaneFrames;
+	for (int f = 0; f < vecFrames; f += SquaresLaneFrames)
 	{
-		dst[f][0] += ( std::isinf( src[f][0] ) || std::isnan( src[f][0] ) ) ? 0.0f : src[f][0] * coeffSrc * coeffSrcBuf->values()[f];
-		dst[f][1] += ( std::isinf( src[f][1] ) || std::isnan( src[f][1] ) ) ? 0.0f : src[f][1] * coeffSrc * coeffSrcBuf->values()[f];
+		for (int lane = 0; lane < 2 * SquaresLaneFrames; ++lane)
+		{
+			lanes[lane] += s[2 * f + lane] * s[2 * f + lane];
+		}
 	}
+	return reduceSquares(lanes, src + vecFrames, frames - vecFrames);
 }
 
-void addSanitizedMultipliedByBuffers( SampleFrame* dst, const SampleFrame* src, ValueBuffer * coeffSrcBuf1, ValueBuffer * coeffSrcBuf2, int frames )
+void levels(const SampleFrame* src, int frames, SampleFrame& peak, SampleFrame& sumOfSquares)
 {
-	if ( !useNaNHandler() )
+	peak = absPeak(src, frames);
+	sumOfSquares = scalar::sumOfSquares(src, frames);
+}
+
+void interleave(SampleFrame* dst, const float* left, const float* right, int frames)
+{
+	for (int f = 0; f < frames; ++f)
 	{
-		addMultipliedByBuffers( dst, src, coeffSrcBuf1, coeffSrcBuf2,
-								frames );
-		return;
+		dst[f] = SampleFrame(left[f], right[f]);
 	}
+}
 
-	for( int f = 0; f < frames; ++f )
+void deinterleave(float* left, float* right, const SampleFrame* src, int frames)
+{
+	for (int f = 0; f < frames; ++f)
 	{
-		dst[f][0] += ( std::isinf( src[f][0] ) || std::isnan( src[f][0] ) )
-			? 0.0f
-			: src[f][0] * coeffSrcBuf1->values()[f] * coeffSrcBuf2->values()[f];
-		dst[f][1] += ( std::isinf( src[f][1] ) || std::isnan( src[f][1] ) )
-			? 0.0f
-			: src[f][1] * coeffSrcBuf1->values()[f] * coeffSrcBuf2->values()[f];
+		left[f] = src[f][0];
+		right[f] = src[f][1];
 	}
+}
+
+constexpr Kernels kernels = {
+	isSilent, sanitize, add, multiply, addMultiplied, addMultipliedByBuffer, addMultipliedByBuffers,
+	addSanitizedMultiplied, addSanitizedMultipliedByBuffer, addSanitizedMultipliedByBuffers,
+	multiplyStereo, multiplyByBuffer, multiplyAndAddMultiplied, absPeak, sumOfSquares, levels,
+	interleave, deinterleave
+};
+
+} // namespace scalar
+
+
+
+
+// The vectorised kernels treat the interleaved frames as one float array
+// (SampleFrame is two packed floats) and leave the remaining frames that
+// don't fill a whole register to the scalar kernels.
 
+inline float* samples( SampleFrame* buf ) { return buf->data(); }
+inline const float* samples( const SampleFrame* buf ) { return buf->data(); }
+
+
+#ifdef LMMS_MIXHELPERS_SSE2
+namespace sse2
+{
+
+constexpr int FramesPerVector = 2;
+
+// [b0 b1] -> [b0 b0 b1 b1], matching the interleaved frames
+inline __m128 loadPerFrame( const float* buf )
+{
+	const __m128 v = _mm_castpd_ps( _mm_load_sd( reinterpret_cast<const double*>( buf ) ) );
+	return _mm_unpacklo_ps( v, v );
 }
 
+// all bits set in lanes which are neither inf nor nan
+inline __m128 finiteMask( __m128 x )
+{
+	return _mm_cmpeq_ps( _mm_sub_ps( x, x ), _mm_setzero_ps() );
+}
 
-struct AddSanitizedMultipliedOp
+bool isSilent( const SampleFrame* src, int frames )
 {
-	AddSanitizedMultipliedOp( float coeff ) : m_coeff( coeff ) { }
+	const float* s = samples( src );
+	const __m128 absMask = _mm_castsi128_ps( _mm_set1_epi32( 0x7fffffff ) );
+	const __m128 threshold = _mm_set1_ps( SilenceThreshold );
+	const int vecFrames = frames - frames % FramesPerVector;
+	for( int f = 0; f < vecFrames; f += FramesPerVector )
+	{
+		const __m128 x = _mm_and_ps( _mm_loadu_ps( s + 2 * f ), absMask );
+		if( _mm_movemask_ps( _mm_cmpge_ps( x, threshold ) ) ) { return false; }
+	}
+	return scalar::isSilent( src + vecFrames, frames - vecFrames );
+}
 
-	void operator()( SampleFrame& dst, const SampleFrame& src ) const
+bool sanitize( SampleFrame* src, int frames )
+{
+	float* s = samples( src );
+	const int vecFrames = frames - frames % FramesPerVector;
+	bool bad = false;
+	for( int f = 0; f < vecFrames && !bad; f += FramesPerVector )
 	{
-		dst[0] += ( std::isinf( src[0] ) || std::isnan( src[0] ) ) ? 0.0f : src[0] * m_coeff;
-		dst[1] += ( std::isinf( src[1] ) || std::isnan( src[1] ) ) ? 0.0f : src[1] * m_coeff;
+		bad = _mm_movemask_ps( finiteMask( _mm_loadu_ps( s + 2 * f ) ) ) != 0xf;
+	}
+	for( int f = vecFrames; f < frames && !bad; ++f )
+	{
+		bad = src[f].containsInf() || src[f].containsNaN();
+	}
+	if( bad )
+	{
+		// Clear the whole buffer if a problem is found
+		zeroSampleFrames( src, frames );
+		return true;
 	}
 
-	const float m_coeff;
-};
+	const __m128 lo = _mm_set1_ps( -SanitizeLimit );
+	const __m128 hi = _mm_set1_ps( SanitizeLimit );
+	for( int f = 0; f < vecFrames; f += FramesPerVector )
+	{
+		const __m128 x = _mm_loadu_ps( s + 2 * f );
+		_mm_storeu_ps( s + 2 * f, _mm_min_ps( _mm_max_ps( x, lo ), hi ) );
+	}
+	return scalar::sanitize( src + vecFrames, frames - vecFrames );
+}
+
+void add( SampleFrame* dst, const SampleFrame* src, int frames )
+{
+	float* d = samples( dst );
+	const float* s = samples( src );
+	const int vecFrames = frames - frames % FramesPerVector;
+	for( int f = 0; f < vecFrames; f += FramesPerVector )
+	{
+		_mm_storeu_ps( d + 2 * f, _mm_add_ps( _mm_loadu_ps( d + 2 * f ), _mm_loadu_ps( s + 2 * f ) ) );
+	}
+	scalar::add( dst + vecFrames, src + vecFrames, frames - vecFrames );
+}
+
+void multiply( SampleFrame* dst, float coeff, int frames )
+{
+	float* d = samples( dst );
+	const __m128 c = _mm_set1_ps( coeff );
+	const int vecFrames = frames - frames % FramesPerVector;
+	for( int f = 0; f < vecFrames; f += FramesPerVector )
+	{
+		_mm_storeu_ps( d + 2 * f, _mm_mul_ps( _mm_loadu_ps( d + 2 * f ), c ) );
+	}
+	scalar::multiply( dst + vecFrames, coeff, frames - vecFrames );
+}
+
+void addMultiplied( SampleFrame* dst, const SampleFrame* src, float coeffSrc, int frames )
+{
+	float* d = samples( dst );
+	const float* s = samples( src );
+	const __m128 c = _mm_set1_ps( coeffSrc );
+	const int vecFrames = frames - frames % FramesPerVector;
+	for( int f = 0; f < vecFrames; f += FramesPerVector )
+	{
+		const __m128 x = _mm_mul_ps( _mm_loadu_ps( s + 2 * f ), c );
+		_mm_storeu_ps( d + 2 * f, _mm_add_ps( _mm_loadu_ps( d + 2 * f ), x ) );
+	}
+	scalar::addMultiplied( dst + vecFrames, src + vecFrames, coeffSrc, frames - vecFrames );
+}
+
+void addMultipliedByBuffer( SampleFrame* dst, const SampleFrame* src, float coeffSrc, const float* coeffSrcBuf, int frames )
+{
+	float* d = samples( dst );
+	const float* s = samples( src );
+	const __m128 c = _mm_set1_ps( coeffSrc );
+	const int vecFrames = frames - frames % FramesPerVector;
+	for( int f = 0; f < vecFrames; f += FramesPerVector )
+	{
+		const __m128 x = _mm_mul_ps( _mm_mul_ps( _mm_loadu_ps( s + 2 * f ), c ), loadPerFrame( coeffSrcBuf + f ) );
+		_mm_storeu_ps( d + 2 * f, _mm_add_ps( _mm_loadu_ps( d + 2 * f ), x ) );
+	}
+	scalar::addMultipliedByBuffer( dst + vecFrames, src + vecFrames, coeffSrc, coeffSrcBuf + vecFrames, frames - vecFrames );
+}
+
+void addMultipliedByBuffers( SampleFrame* dst, const SampleFrame* src, const float* coeffSrcBuf1, const float* coeffSrcBuf2, int frames )
+{
+	float* d = samples( dst );
+	const float* s = samples( src );
+	const int vecFrames = frames - frames % FramesPerVector;
+	for( int f = 0; f < vecFrames; f += FramesPerVector )
+	{
+		const __m128 x = _mm_mul_ps( _mm_mul_ps( _mm_loadu_ps( s + 2 * f ), loadPerFrame( coeffSrcBuf1 + f ) ),
+			loadPerFrame( coeffSrcBuf2 + f ) );
+		_mm_storeu_ps( d + 2 * f, _mm_add_ps( _mm_loadu_ps( d + 2 * f ), x ) );
+	}
+	scalar::addMultipliedByBuffers( dst + vecFrames, src + vecFrames, coeffSrcBuf1 + vecFrames, coeffSrcBuf2 + vecFrames,
+		frames - vecFrames );
+}
 
 void addSanitizedMultiplied( SampleFrame* dst, const SampleFrame* src, float coeffSrc, int frames )
 {
-	if ( !useNaNHandler() )
+	float* d = samples( dst );
+	const float* s = samples( src );
+	const __m128 c = _mm_set1_ps( coeffSrc );
+	const int vecFrames = frames - frames % FramesPerVector;
+	for( int f = 0; f < vecFrames; f += FramesPerVector )
 	{
-		addMultiplied( dst, src, coeffSrc, frames );
-		return;
+		const __m128 in = _mm_loadu_ps( s + 2 * f );
+		const __m128 x = _mm_and_ps( finiteMask( in ), _mm_mul_ps( in, c ) );
+		_mm_storeu_ps( d + 2 * f, _mm_add_ps( _mm_loadu_ps( d + 2 * f ), x ) );
 	}
+	scalar::addSanitizedMultiplied( dst + vecFrames, src + vecFrames, coeffSrc, frames - vecFrames );
+}
 
-	run<>( dst, src, frames, AddSanitizedMultipliedOp(coeffSrc) );
+void addSanitizedMultipliedByBuffer( SampleFrame* dst, const SampleFrame* src, float coeffSrc, const float* coeffSrcBuf, int frames )
+{
+	float* d = samples( dst );
+	const float* s = samples( src );
+	const __m128 c = _mm_set1_ps( coeffSrc );
+	const int vecFrames = frames - frames % FramesPerVector;
+	for( int f = 0; f < vecFrames; f += FramesPerVector )
+	{
+		const __m128 in = _mm_loadu_ps( s + 2 * f );
+		const __m128 x = _mm_mul_ps( _mm_mul_ps( in, c ), loadPerFrame( coeffSrcBuf + f ) );
+		_mm_storeu_ps( d + 2 * f, _mm_add_ps( _mm_loadu_ps( d + 2 * f ), _mm_and_ps( finiteMask( in ), x ) ) );
+	}
+	scalar::addSanitizedMultipliedByBuffer( dst + vecFrames, src + vecFrames, coeffSrc, coeffSrcBuf + vecFrames,
+		frames - vecFrames );
+}
+
+void addSanitizedMultipliedByBuffers( SampleFrame* dst, const SampleFrame* src, const float* coeffSrcBuf1, const float* coeffSrcBuf2, int frames )
+{
+	float* d = samples( dst );
+	const float* s = samples( src );
+	const int vecFrames = frames - frames % FramesPerVector;
+	for( int f = 0; f < vecFrames; f += FramesPerVector )
+	{
+		const __m128 in = _mm_loadu_ps( s + 2 * f );
+		const __m128 x = _mm_mul_ps( _mm_mul_ps( in, loadPerFrame( coeffSrcBuf1 + f ) ), loadPerFrame( coeffSrcBuf2 + f ) );
+		_mm_storeu_ps( d + 2 * f, _mm_add_ps( _mm_loadu_ps( d + 2 * f ), _mm_and_ps( finiteMask( in ), x ) ) );
+	}
+	scalar::addSanitizedMultipliedByBuffers( dst + vecFrames, src + vecFrames, coeffSrcBuf1 + vecFrames,
+		coeffSrcBuf2 + vecFrames, frames - vecFrames );
+}
+
+void multiplyStereo(SampleFrame* dst, float coeffLeft, float coeffRight, int frames)
+{
+	float* d = samples(dst);
+	const __m128 c = _mm_setr_ps(coeffLeft, coeffRight, coeffLeft, coeffRight);
+	const int vecFrames = frames - frames % FramesPerVector;
+	for (int f = 0; f < vecFrames; f += FramesPerVector)
+	{
+		_mm_storeu_ps(d + 2 * f, _mm_mul_ps(_mm_loadu_ps(d + 2 * f), c));
+	}
+	scalar::multiplyStereo(dst + vecFrames, coeffLeft, coeffRight, frames - vecFrames);
+}
+
+void multiplyByBuffer(SampleFrame* dst, const float* coeffBuf, int frames)
+{
+	float* d = samples(dst);
+	const int vecFrames = frames - frames % FramesPerVector;
+	for (int f = 0; f < vecFrames; f += FramesPerVector)
+	{
+		_mm_storeu_ps(d + 2 * f, _mm_mul_ps(_mm_loadu_ps(d + 2 * f), loadPerFrame(coeffBuf + f)));
+	}
+	scalar::multiplyByBuffer(dst + vecFrames, coeffBuf + vecFrames, frames - vecFrames);
+}
+
+void multiplyAndAddMultiplied(SampleFrame* dst, const SampleFrame* src, float coeffDst, float coeffSrc, int frames)
+{
+	float* d = samples(dst);
+	const float* s = samples(src);
+	const __m128 cd = _mm_set1_ps(coeffDst);
+	const __m128 cs = _mm_set1_ps(coeffSrc);
+	const int vecFrames = frames - frames % FramesPerVector;
+	for (int f = 0; f < vecFrames; f += FramesPerVector)
+	{
+		const __m128 x = _mm_mul_ps(_mm_loadu_ps(d + 2 * f), cd);
+		_mm_storeu_ps(d + 2 * f, _mm_add_ps(x, _mm_mul_ps(_mm_loadu_ps(s + 2 * f), cs)));
+	}
+	scalar::multiplyAndAddMultiplied(dst + vecFrames, src + vecFrames, coeffDst, coeffSrc, frames - vecFrames);
+}
+
+SampleFrame absPeak(const SampleFrame* src, int frames)
+{
+	const float* s = samples(src);
+	const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+	const int vecFrames = frames - frames % FramesPerVector;
+	__m128 peak = _mm_setzero_ps();
+	for (int f = 0; f < vecFrames; f += FramesPerVector)
+	{
+		// returns the second operand for nans
+		peak = _mm_max_ps(_mm_and_ps(_mm_loadu_ps(s + 2 * f), absMask), peak);
+	}
+	peak = _mm_max_ps(peak, _mm_movehl_ps(peak, peak));
+
+	auto result = scalar::absPeak(src + vecFrames, frames - vecFrames);
+	result[0] = std::max(result[0], _mm_cvtss_f32(peak));
+	result[1] = std::max(result[1], _mm_cvtss_f32(_mm_shuffle_ps(peak, peak, 1)));
+	return result;
+}
+
+SampleFrame sumOfSquares(const SampleFrame* src, int frames)
+{
+	const float* s = samples(src);
+	const int vecFrames = frames - frames % scalar::SquaresLaneFrames;
+	__m128 lanes0 = _mm_setzero_ps();
+	__m128 lanes1 = _mm_setzero_ps();
+	for (int f = 0; f < vecFrames; f += scalar::SquaresLaneFrames)
+	{
+		const __m128 x0 = _mm_loadu_ps(s + 2 * f);
+		const __m128 x1 = _mm_loadu_ps(s + 2 * f + 4);
+		lanes0 = _mm_add_ps(lanes0, _mm_mul_ps(x0, x0));
+		lanes1 = _mm_add_ps(lanes1, _mm_mul_ps(x1, x1));
+	}
+
+	float lanes[2 * scalar::SquaresLaneFrames];
+	_mm_storeu_ps(lanes, lanes0);
+	_mm_storeu_ps(lanes + 4, lanes1);
+	return scalar::reduceSquares(lanes, src + vecFrames, frames - vecFrames);
+}
+
+void levels(const SampleFrame* src, int frames, SampleFrame& peak, SampleFrame& sumOfSquares)
+{
+	const float* s = samples(src);
+	const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+	const int vecFrames = frames - frames % scalar::SquaresLaneFrames;
+	__m128 peaks = _mm_setzero_ps();
+	__m128 lanes0 = _mm_setzero_ps();
+	__m128 lanes1 = _mm_setzero_ps();
+	for (int f = 0; f < vecFrames; f += scalar::SquaresLaneFrames)
+	{
+		const __m128 x0 = _mm_loadu_ps(s + 2 * f);
+		const __m128 x1 = _mm_loadu_ps(s + 2 * f + 4);
+		peaks = _mm_max_ps(_mm_and_ps(x0, absMask), peaks);
+		peaks = _mm_max_ps(_mm_and_ps(x1, absMask), peaks);
+		lanes0 = _mm_add_ps(lanes0, _mm_mul_ps(x0, x0));
+		lanes1 = _mm_add_ps(lanes1, _mm_mul_ps(x1, x1));
+	}
+	peaks = _mm_max_ps(peaks, _mm_movehl_ps(peaks, peaks));
+
+	peak = scalar::absPeak(src + vecFrames, frames - vecFrames);
+	peak[0] = std::max(peak[0], _mm_cvtss_f32(peaks));
+	peak[1] = std::max(peak[1], _mm_cvtss_f32(_mm_shuffle_ps(peaks, peaks, 1)));
+
+	float lanes[2 * scalar::SquaresLaneFrames];
+	_mm_storeu_ps(lanes, lanes0);
+	_mm_storeu_ps(lanes + 4, lanes1);
+	sumOfSquares = scalar::reduceSquares(lanes, src + vecFrames, frames - vecFrames);
+}
+
+void interleave(SampleFrame* dst, const float* left, const float* right, int frames)
+{
+	float* d = samples(dst);
+	const int vecFrames = frames - frames % 4;
+	for (int f = 0; f < vecFrames; f += 4)
+	{
+		const __m128 l = _mm_loadu_ps(left + f);
+		const __m128 r = _mm_loadu_ps(right + f);
+		_mm_storeu_ps(d + 2 * f, _mm_unpacklo_ps(l, r));
+		_mm_storeu_ps(d + 2 * f + 4, _mm_unpackhi_ps(l, r));
+	}
+	scalar::interleave(dst + vecFrames, left + vecFrames, right + vecFrames, frames - vecFrames);
+}
+
+void deinterleave(float* left, float* right, const SampleFrame* src, int frames)
+{
+	const float* s = samples(src);
+	const int vecFrames = frames - frames % 4;
+	for (int f = 0; f < vecFrames; f += 4)
+	{
+		const __m128 a = _mm_loadu_ps(s + 2 * f);
+		const __m128 b = _mm_loadu_ps(s + 2 * f + 4);
+		_mm_storeu_ps(left + f, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+		_mm_storeu_ps(right + f, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+	}
+	scalar::deinterleave(left + vecFrames, right + vecFrames, src + vecFrames, frames - vecFrames);
+}
+
+constexpr Kernels kernels = {
+	isSilent, sanitize, add, multiply, addMultiplied, addMultipliedByBuffer, addMultipliedByBuffers,
+	addSanitizedMultiplied, addSanitizedMultipliedByBuffer, addSanitizedMultipliedByBuffers,
+	multiplyStereo, multiplyByBuffer, multiplyAndAddMultiplied, absPeak, sumOfSquares, levels,
+	interleave, deinterleave
+};
+
+} // namespace sse2
+#endif // LMMS_MIXHELPERS_SSE2
+
+
+
+
+#ifdef LMMS_MIXHELPERS_AVX2
+namespace avx2
+{
+
+#define LMMS_AVX2 __attribute__((target("avx2")))
+
+constexpr int FramesPerVector = 4;
+
+// [b0 b1 b2 b3] -> [b0 b0 b1 b1 b2 b2 b3 b3], matching the interleaved frames
+LMMS_AVX2 inline __m256 loadPerFrame( const float* buf )
+{
+	const __m256i idx = _mm256_setr_epi32( 0, 0, 1, 1, 2, 2, 3, 3 );
+	return _mm256_permutevar8x32_ps( _mm256_castps128_ps256( _mm_loadu_ps( buf ) ), idx );
+}
+
+// all bits set in lanes which are neither inf nor nan
+LMMS_AVX2 inline __m256 finiteMask( __m256 x )
+{
+	return _mm256_cmp_ps( _mm256_sub_ps( x, x ), _mm256_setzero_ps(), _CMP_EQ_OQ );
+}
+
+LMMS_AVX2 bool isSilent( const SampleFrame* src, int frames )
+{
+	const float* s = samples( src );
+	const __m256 absMask = _mm256_castsi256_ps( _mm256_set1_epi32( 0x7fffffff ) );
+	const __m256 threshold = _mm256_set1_ps( SilenceThreshold );
+	const int vecFrames = frames - frames % FramesPerVector;
+	for( int f = 0; f < vecFrames; f += FramesPerVector )
+	{
+		const __m256 x = _mm256_and_ps( _mm256_loadu_ps( s + 2 * f ), absMask );
+		if( _mm256_movemask_ps( _mm256_cmp_ps( x, threshold, _CMP_GE_OQ ) ) ) { return false; }
+	}
+	return scalar::isSilent( src + vecFrames, frames - vecFrames );
+}
+
+LMMS_AVX2 bool sanitize( SampleFrame* src, int frames )
+{
+	float* s = samples( src );
+	const int vecFrames = frames - frames % FramesPerVector;
+	bool bad = false;
+	for( int f = 0; f < vecFrames && !bad; f += FramesPerVector )
+	{
+		bad = _mm256_movemask_ps( finiteMask( _mm256_loadu_ps( s + 2 * f ) ) ) != 0xff;
+	}
+	for( int f = vecFrames; f < frames && !bad; ++f )
+	{
+		bad = src[f].containsInf() || src[f].containsNaN();
+	}
+	if( bad )
+	{
+		// Clear the whole buffer if a problem is found
+		zeroSampleFrames( src, frames );
+		return true;
+	}
+
+	const __m256 lo = _mm256_set1_ps( -SanitizeLimit );
+	const __m256 hi = _mm256_set1_ps( SanitizeLimit );
+	for( int f = 0; f < vecFrames; f += FramesPerVector )
+	{
+		const __m256 x = _mm256_loadu_ps( s + 2 * f );
+		_mm256_storeu_ps( s + 2 * f, _mm256_min_ps( _mm256_max_ps( x, lo ), hi ) );
+	}
+	return scalar::sanitize( src + vecFrames, frames - vecFrames );
+}
+
+LMMS_AVX2 void add( SampleFrame* dst, const SampleFrame* src, int frames )
+{
+	float* d = samples( dst );
+	const float* s = samples( src );
+	const int vecFrames = frames - frames % FramesPerVector;
+	for( int f = 0; f < vecFrames; f += FramesPerVector )
+	{
+		_mm256_storeu_ps( d + 2 * f, _mm256_add_ps( _mm256_loadu_ps( d + 2 * f ), _mm256_loadu_ps( s + 2 * f ) ) );
+	}
+	scalar::add( dst + vecFrames, src + vecFrames, frames - vecFrames );
+}
+
+LMMS_AVX2 void multiply( SampleFrame* dst, float coeff, int frames )
+{
+	float* d = samples( dst );
+	const __m256 c = _mm256_set1_ps( coeff );
+	const int vecFrames = frames - frames % FramesPerVector;
+	for( int f = 0; f < vecFrames; f += FramesPerVector )
+	{
+		_mm256_storeu_ps( d + 2 * f, _mm256_mul_ps( _mm256_loadu_ps( d + 2 * f ), c ) );
+	}
+	scalar::multiply( dst + vecFrames, coeff, frames - vecFrames );
+}
+
+LMMS_AVX2 void addMultiplied( SampleFrame* dst, const SampleFrame* src, float coeffSrc, int frames )
+{
+	float* d = samples( dst );
+	const float* s = samples( src );
+	const __m256 c = _mm256_set1_ps( coeffSrc );
+	const int vecFrames = frames - frames % FramesPerVector;
+	for( int f = 0; f < vecFrames; f += FramesPerVector )
+	{
+		const __m256 x = _mm256_mul_ps( _mm256_loadu_ps( s + 2 * f ), c );
+		_mm256_storeu_ps( d + 2 * f, _mm256_add_ps( _mm256_loadu_ps( d + 2 * f ), x ) );
+	}
+	scalar::addMultiplied( dst + vecFrames, src + vecFrames, coeffSrc, frames - vecFrames );
+}
+
+LMMS_AVX2 void addMultipliedByBuffer( SampleFrame* dst, const SampleFrame* src, float coeffSrc, const float* coeffSrcBuf, int frames )
+{
+	float* d = samples( dst );
+	const float* s = samples( src );
+	const __m256 c = _mm256_set1_ps( coeffSrc );
+	const int vecFrames = frames - frames % FramesPerVector;
+	for( int f = 0; f < vecFrames; f += FramesPerVector )
+	{
+		const __m256 x = _mm256_mul_ps( _mm256_mul_ps( _mm256_loadu_ps( s + 2 * f ), c ), loadPerFrame( coeffSrcBuf + f ) );
+		_mm256_storeu_ps( d + 2 * f, _mm256_add_ps( _mm256_loadu_ps( d + 2 * f ), x ) );
+	}
+	scalar::addMultipliedByBuffer( dst + vecFrames, src + vecFrames, coeffSrc, coeffSrcBuf + vecFrames, frames - vecFrames );
+}
+
+LMMS_AVX2 void addMultipliedByBuffers( SampleFrame* dst, const SampleFrame* src, const float* coeffSrcBuf1, const float* coeffSrcBuf2, int frames )
+{
+	float* d = samples( dst );
+	const float* s = samples( src );
+	const int vecFrames = frames - frames % FramesPerVector;
+	for( int f = 0; f < vecFrames; f += FramesPerVector )
+	{
+		const __m256 x = _mm256_mul_ps( _mm256_mul_ps( _mm256_loadu_ps( s + 2 * f ), loadPerFrame( coeffSrcBuf1 + f ) ),
+			loadPerFrame( coeffSrcBuf2 + f ) );
+		_mm256_storeu_ps( d + 2 * f, _mm256_add_ps( _mm256_loadu_ps( d + 2 * f ), x ) );
+	}
+	scalar::addMultipliedByBuffers( dst + vecFrames, src + vecFrames, coeffSrcBuf1 + vecFrames, coeffSrcBuf2 + vecFrames,
+		frames - vecFrames );
+}
+
+LMMS_AVX2 void addSanitizedMultiplied( SampleFrame* dst, const SampleFrame* src, float coeffSrc, int frames )
+{
+	float* d = samples( dst );
+	const float* s = samples( src );
+	const __m256 c = _mm256_set1_ps( coeffSrc );
+	const int vecFrames = frames - frames % FramesPerVector;
+	for( int f = 0; f < vecFrames; f += FramesPerVector )
+	{
+		const __m256 in = _mm256_loadu_ps( s + 2 * f );
+		const __m256 x = _mm256_and_ps( finiteMask( in ), _mm256_mul_ps( in, c ) );
+		_mm256_storeu_ps( d + 2 * f, _mm256_add_ps( _mm256_loadu_ps( d + 2 * f ), x ) );
+	}
+	scalar::addSanitizedMultiplied( dst + vecFrames, src + vecFrames, coeffSrc, frames - vecFrames );
+}
+
+LMMS_AVX2 void addSanitizedMultipliedByBuffer( SampleFrame* dst, const SampleFrame* src, float coeffSrc, const float* coeffSrcBuf, int frames )
+{
+	float* d = samples( dst );
+	const float* s = samples( src );
+	const __m256 c = _mm256_set1_ps( coeffSrc );
+	const int vecFrames = frames - frames % FramesPerVector;
+	for( int f = 0; f < vecFrames; f += FramesPerVector )
+	{
+		const __m256 in = _mm256_loadu_ps( s + 2 * f );
+		const __m256 x = _mm256_mul_ps( _mm256_mul_ps( in, c ), loadPerFrame( coeffSrcBuf + f ) );
+		_mm256_storeu_ps( d + 2 * f, _mm256_add_ps( _mm256_loadu_ps( d + 2 * f ), _mm256_and_ps( finiteMask( in ), x ) ) );
+	}
+	scalar::addSanitizedMultipliedByBuffer( dst + vecFrames, src + vecFrames, coeffSrc, coeffSrcBuf + vecFrames,
+		frames - vecFrames );
+}
+
+LMMS_AVX2 void addSanitizedMultipliedByBuffers( SampleFrame* dst, const SampleFrame* src, const float* coeffSrcBuf1, const float* coeffSrcBuf2, int frames )
+{
+	float* d = samples( dst );
+	const float* s = samples( src );
+	const int vecFrames = frames - frames % FramesPerVector;
+	for( int f = 0; f < vecFrames; f += FramesPerVector )
+	{
+		const __m256 in = _mm256_loadu_ps( s + 2 * f );
+		const __m256 x = _mm256_mul_ps( _mm256_mul_ps( in, loadPerFrame( coeffSrcBuf1 + f ) ), loadPerFrame( coeffSrcBuf2 + f ) );
+		_mm256_storeu_ps( d + 2 * f, _mm256_add_ps( _mm256_loadu_ps( d + 2 * f ), _mm256_and_ps( finiteMask( in ), x ) ) );
+	}
+	scalar::addSanitizedMultipliedByBuffers( dst + vecFrames, src + vecFrames, coeffSrcBuf1 + vecFrames,
+		coeffSrcBuf2 + vecFrames, frames - vecFrames );
+}
+
+LMMS_AVX2 void multiplyStereo(SampleFrame* dst, float coeffLeft, float coeffRight, int frames)
+{
+	float* d = samples(dst);
+	const __m256 c = _mm256_setr_ps(coeffLeft, coeffRight, coeffLeft, coeffRight,
+		coeffLeft, coeffRight, coeffLeft, coeffRight);
+	const int vecFrames = frames - frames % FramesPerVector;
+	for (int f = 0; f < vecFrames; f += FramesPerVector)
+	{
+		_mm256_storeu_ps(d + 2 * f, _mm256_mul_ps(_mm256_loadu_ps(d + 2 * f), c));
+	}
+	scalar::multiplyStereo(dst + vecFrames, coeffLeft, coeffRight, frames - vecFrames);
+}
+
+LMMS_AVX2 void multiplyByBuffer(SampleFrame* dst, const float* coeffBuf, int frames)
+{
+	float* d = samples(dst);
+	const int vecFrames = frames - frames % FramesPerVector;
+	for (int f = 0; f < vecFrames; f += FramesPerVector)
+	{
+		_mm256_storeu_ps(d + 2 * f, _mm256_mul_ps(_mm256_loadu_ps(d + 2 * f), loadPerFrame(coeffBuf + f)));
+	}
+	scalar::multiplyByBuffer(dst + vecFrames, coeffBuf + vecFrames, frames - vecFrames);
+}
+
+LMMS_AVX2 void multiplyAndAddMultiplied(SampleFrame* dst, const SampleFrame* src, float coeffDst, float coeffSrc,
+	int frames)
+{
+	float* d = samples(dst);
+	const float* s = samples(src);
+	const __m256 cd = _mm256_set1_ps(coeffDst);
+	const __m256 cs = _mm256_set1_ps(coeffSrc);
+	const int vecFrames = frames - frames % FramesPerVector;
+	for (int f = 0; f < vecFrames; f += FramesPerVector)
+	{
+		const __m256 x = _mm256_mul_ps(_mm256_loadu_ps(d + 2 * f), cd);
+		_mm256_storeu_ps(d + 2 * f, _mm256_add_ps(x, _mm256_mul_ps(_mm256_loadu_ps(s + 2 * f), cs)));
+	}
+	scalar::multiplyAndAddMultiplied(dst + vecFrames, src + vecFrames, coeffDst, coeffSrc, frames - vecFrames);
+}
+
+LMMS_AVX2 SampleFrame absPeak(const SampleFrame* src, int frames)
+{
+	const float* s = samples(src);
+	const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+	const int vecFrames = frames - frames % FramesPerVector;
+	__m256 peak = _mm256_setzero_ps();
+	for (int f = 0; f < vecFrames; f += FramesPerVector)
+	{
+		// returns the second operand for nans
+		peak = _mm256_max_ps(_mm256_and_ps(_mm256_loadu_ps(s + 2 * f), absMask), peak);
+	}
+	__m128 half = _mm_max_ps(_mm256_castps256_ps128(peak), _mm256_extractf128_ps(peak, 1));
+	half = _mm_max_ps(half, _mm_movehl_ps(half, half));
+
+	auto result = scalar::absPeak(src + vecFrames, frames - vecFrames);
+	result[0] = std::max(result[0], _mm_cvtss_f32(half));
+	result[1] = std::max(result[1], _mm_cvtss_f32(_mm_shuffle_ps(half, half, 1)));
+	return result;
+}
+
+LMMS_AVX2 SampleFrame sumOfSquares(const SampleFrame* src, int frames)
+{
+	static_assert(FramesPerVector == scalar::SquaresLaneFrames);
+
+	const float* s = samples(src);
+	const int vecFrames = frames - frames % FramesPerVector;
+	__m256 lanes = _mm256_setzero_ps();
+	for (int f = 0; f < vecFrames; f += FramesPerVector)
+	{
+		const __m256 x = _mm256_loadu_ps(s + 2 * f);
+		lanes = _mm256_add_ps(lanes, _mm256_mul_ps(x, x));
+	}
+
+	float sums[2 * FramesPerVector];
+	_mm256_storeu_ps(sums, lanes);
+	return scalar::reduceSquares(sums, src + vecFrames, frames - vecFrames);
+}
+
+LMMS_AVX2 void levels(const SampleFrame* src, int frames, SampleFrame& peak, SampleFrame& sumOfSquares)
+{
+	const float* s = samples(src);
+	const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+	const int vecFrames = frames - frames % FramesPerVector;
+	__m256 peaks = _mm256_setzero_ps();
+	__m256 lanes = _mm256_setzero_ps();
+	for (int f = 0; f < vecFrames; f += FramesPerVector)
+	{
+		const __m256 x = _mm256_loadu_ps(s + 2 * f);
+		peaks = _mm256_max_ps(_mm256_and_ps(x, absMask), peaks);
+		lanes = _mm256_add_ps(lanes, _mm256_mul_ps(x, x));
+	}
+	__m128 half = _mm_max_ps(_mm256_castps256_ps128(peaks), _mm256_extractf128_ps(peaks, 1));
+	half = _mm_max_ps(half, _mm_movehl_ps(half, half));
+
+	peak = scalar::absPeak(src + vecFrames, frames - vecFrames);
+	peak[0] = std::max(peak[0], _mm_cvtss_f32(half));
+	peak[1] = std::max(peak[1], _mm_cvtss_f32(_mm_shuffle_ps(half, half, 1)));
+
+	float sums[2 * FramesPerVector];
+	_mm256_storeu_ps(sums, lanes);
+	sumOfSquares = scalar::reduceSquares(sums, src + vecFrames, frames - vecFrames);
+}
+
+LMMS_AVX2 void interleave(SampleFrame* dst, const float* left, const float* right, int frames)
+{
+	float* d = samples(dst);
+	const int vecFrames = frames - frames % 8;
+	for (int f = 0; f < vecFrames; f += 8)
+	{
+		const __m256 l = _mm256_loadu_ps(left + f);
+		const __m256 r = _mm256_loadu_ps(right + f);
+		// unpacking works within each half: [l0 r0 l1 r1 | l4 r4 l5 r5] and [l2 r2 l3 r3 | l6 r6 l7 r7]
+		const __m256 lo = _mm256_unpacklo_ps(l, r);
+		const __m256 hi = _mm256_unpackhi_ps(l, r);
+		_mm256_storeu_ps(d + 2 * f, _mm256_permute2f128_ps(lo, hi, 0x20));
+		_mm256_storeu_ps(d + 2 * f + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+	}
+	scalar::interleave(dst + vecFrames, left + vecFrames, right + vecFrames, frames - vecFrames);
+}
+
+LMMS_AVX2 void deinterleave(float* left, float* right, const SampleFrame* src, int frames)
+{
+	const float* s = samples(src);
+	const int vecFrames = frames - frames % 8;
+	for (int f = 0; f < vecFrames; f += 8)
+	{
+		const __m256 a = _mm256_loadu_ps(s + 2 * f);
+		const __m256 b = _mm256_loadu_ps(s + 2 * f + 8);
+		// [l0 r0 l1 r1 | l4 r4 l5 r5] and [l2 r2 l3 r3 | l6 r6 l7 r7], so shuffling works within each half
+		const __m256 lo = _mm256_permute2f128_ps(a, b, 0x20);
+		const __m256 hi = _mm256_permute2f128_ps(a, b, 0x31);
+		_mm256_storeu_ps(left + f, _mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0)));
+		_mm256_storeu_ps(right + f, _mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1)));
+	}
+	scalar::deinterleave(left + vecFrames, right + vecFrames, src + vecFrames, frames - vecFrames);
+}
+
+#undef LMMS_AVX2
+
+constexpr Kernels kernels = {
+	isSilent, sanitize, add, multiply, addMultiplied, addMultipliedByBuffer, addMultipliedByBuffers,
+	addSanitizedMultiplied, addSanitizedMultipliedByBuffer, addSanitizedMultipliedByBuffers,
+	multiplyStereo, multiplyByBuffer, multiplyAndAddMultiplied, absPeak, sumOfSquares, levels,
+	interleave, deinterleave
+};
+
+} // namespace avx2
+#endif // LMMS_MIXHELPERS_AVX2
+
+
+
+
+#ifdef LMMS_MIXHELPERS_NEON
+namespace neon
+{
+
+constexpr int FramesPerVector = 2;
+
+// [b0 b1] -> [b0 b0 b1 b1], matching the interleaved frames
+inline float32x4_t loadPerFrame( const float* buf )
+{
+	const float32x2_t v = vld1_f32( buf );
+	return vzip1q_f32( vcombine_f32( v, v ), vcombine_f32( v, v ) );
+}
+
+// all bits set in lanes which are neither inf nor nan
+inline uint32x4_t finiteMask( float32x4_t x )
+{
+	return vceqq_f32( vsubq_f32( x, x ), vdupq_n_f32( 0.0f ) );
+}
+
+inline float32x4_t select( uint32x4_t mask, float32x4_t x )
+{
+	return vreinterpretq_f32_u32( vandq_u32( mask, vreinterpretq_u32_f32( x ) ) );
+}
+
+bool isSilent( const SampleFrame* src, int frames )
+{
+	const float* s = samples( src );
+	const float32x4_t threshold = vdupq_n_f32( SilenceThreshold );
+	const int vecFrames = frames - frames % FramesPerVector;
+	for( int f = 0; f < vecFrames; f += FramesPerVector )
+	{
+		if( vmaxvq_u32( vcgeq_f32( vabsq_f32( vld1q_f32( s + 2 * f ) ), threshold ) ) ) { return false; }
+	}
+	return scalar::isSilent( src + vecFrames, frames - vecFrames );
+}
+
+bool sanitize( SampleFrame* src, int frames )
+{
+	float* s = samples( src );
+	const int vecFrames = frames - frames % FramesPerVector;
+	bool bad = false;
+	for( int f = 0; f < vecFrames && !bad; f += FramesPerVector )
+	{
+		bad = vminvq_u32( finiteMask( vld1q_f32( s + 2 * f ) ) ) == 0;
+	}
+	for( int f = vecFrames; f < frames && !bad; ++f )
+	{
+		bad = src[f].containsInf() || src[f].containsNaN();
+	}
+	if( bad )
+	{
+		// Clear the whole buffer if a problem is found
+		zeroSampleFrames( src, frames );
+		return true;
+	}
+
+	const float32x4_t lo = vdupq_n_f32( -SanitizeLimit );
+	const float32x4_t hi = vdupq_n_f32( SanitizeLimit );
+	for( int f = 0; f < vecFrames; f += FramesPerVector )
+	{
+		vst1q_f32( s + 2 * f, vminq_f32( vmaxq_f32( vld1q_f32( s + 2 * f ), lo ), hi ) );
+	}
+	return scalar::sanitize( src + vecFrames, frames - vecFrames );
+}
+
+void add( SampleFrame* dst, const SampleFrame* src, int frames )
+{
+	float* d = samples( dst );
+	const float* s = samples( src );
+	const int vecFrames = frames - frames % FramesPerVector;
+	for( int f = 0; f < vecFrames; f += FramesPerVector )
+	{
+		vst1q_f32( d + 2 * f, vaddq_f32( vld1q_f32( d + 2 * f ), vld1q_f32( s + 2 * f ) ) );
+	}
+	scalar::add( dst + vecFrames, src + vecFrames, frames - vecFrames );
+}
+
+void multiply( SampleFrame* dst, float coeff, int frames )
+{
+	float* d = samples( dst );
+	const int vecFrames = frames - frames % FramesPerVector;
+	for( int f = 0; f < vecFrames; f += FramesPerVector )
+	{
+		vst1q_f32( d + 2 * f, vmulq_n_f32( vld1q_f32( d + 2 * f ), coeff ) );
+	}
+	scalar::multiply( dst + vecFrames, coeff, frames - vecFrames );
+}
+
+void addMultiplied( SampleFrame* dst, const SampleFrame* src, float coeffSrc, int frames )
+{
+	float* d = samples( dst );
+	const float* s = samples( src );
+	const int vecFrames = frames - frames % FramesPerVector;
+	for( int f = 0; f < vecFrames; f += FramesPerVector )
+	{
+		const float32x4_t x = vmulq_n_f32( vld1q_f32( s + 2 * f ), coeffSrc );
+		vst1q_f32( d + 2 * f, vaddq_f32( vld1q_f32( d + 2 * f ), x ) );
+	}
+	scalar::addMultiplied( dst + vecFrames, src + vecFrames, coeffSrc, frames - vecFrames );
+}
+
+void addMultipliedByBuffer( SampleFrame* dst, const SampleFrame* src, float coeffSrc, const float* coeffSrcBuf, int frames )
+{
+	float* d = samples( dst );
+	const float* s = samples( src );
+	const int vecFrames = frames - frames % FramesPerVector;
+	for( int f = 0; f < vecFrames; f += FramesPerVector )
+	{
+		const float32x4_t x = vmulq_f32( vmulq_n_f32( vld1q_f32( s + 2 * f ), coeffSrc ), loadPerFrame( coeffSrcBuf + f ) );
+		vst1q_f32( d + 2 * f, vaddq_f32( vld1q_f32( d + 2 * f ), x ) );
+	}
+	scalar::addMultipliedByBuffer( dst + vecFrames, src + vecFrames, coeffSrc, coeffSrcBuf + vecFrames, frames - vecFrames );
+}
+
+void addMultipliedByBuffers( SampleFrame* dst, const SampleFrame* src, const float* coeffSrcBuf1, const float* coeffSrcBuf2, int frames )
+{
+	float* d = samples( dst );
+	const float* s = samples( src );
+	const int vecFrames = frames - frames % FramesPerVector;
+	for( int f = 0; f < vecFrames; f += FramesPerVector )
+	{
+		const float32x4_t x = vmulq_f32( vmulq_f32( vld1q_f32( s + 2 * f ), loadPerFrame( coeffSrcBuf1 + f ) ),
+			loadPerFrame( coeffSrcBuf2 + f ) );
+		vst1q_f32( d + 2 * f, vaddq_f32( vld1q_f32( d + 2 * f ), x ) );
+	}
+	scalar::addMultipliedByBuffers( dst + vecFrames, src + vecFrames, coeffSrcBuf1 + vecFrames, coeffSrcBuf2 + vecFrames,
+		frames - vecFrames );
+}
+
+void addSanitizedMultiplied( SampleFrame* dst, const SampleFrame* src, float coeffSrc, int frames )
+{
+	float* d = samples( dst );
+	const float* s = samples( src );
+	const int vecFrames = frames - frames % FramesPerVector;
+	for( int f = 0; f < vecFrames; f += FramesPerVector )
+	{
+		const float32x4_t in = vld1q_f32( s + 2 * f );
+		const float32x4_t x = select( finiteMask( in ), vmulq_n_f32( in, coeffSrc ) );
+		vst1q_f32( d + 2 * f, vaddq_f32( vld1q_f32( d + 2 * f ), x ) );
+	}
+	scalar::addSanitizedMultiplied( dst + vecFrames, src + vecFrames, coeffSrc, frames - vecFrames );
+}
+
+void addSanitizedMultipliedByBuffer( SampleFrame* dst, const SampleFrame* src, float coeffSrc, const float* coeffSrcBuf, int frames )
+{
+	float* d = samples( dst );
+	const float* s = samples( src );
+	const int vecFrames = frames - frames % FramesPerVector;
+	for( int f = 0; f < vecFrames; f += FramesPerVector )
+	{
+		const float32x4_t in = vld1q_f32( s + 2 * f );
+		const float32x4_t x = vmulq_f32( vmulq_n_f32( in, coeffSrc ), loadPerFrame( coeffSrcBuf + f ) );
+		vst1q_f32( d + 2 * f, vaddq_f32( vld1q_f32( d + 2 * f ), select( finiteMask( in ), x ) ) );
+	}
+	scalar::addSanitizedMultipliedByBuffer( dst + vecFrames, src + vecFrames, coeffSrc, coeffSrcBuf + vecFrames,
+		frames - vecFrames );
+}
+
+void addSanitizedMultipliedByBuffers( SampleFrame* dst, const SampleFrame* src, const float* coeffSrcBuf1, const float* coeffSrcBuf2, int frames )
+{
+	float* d = samples( dst );
+	const float* s = samples( src );
+	const int vecFrames = frames - frames % FramesPerVector;
+	for( int f = 0; f < vecFrames; f += FramesPerVector )
+	{
+		const float32x4_t in = vld1q_f32( s + 2 * f );
+		const float32x4_t x = vmulq_f32( vmulq_f32( in, loadPerFrame( coeffSrcBuf1 + f ) ), loadPerFrame( coeffSrcBuf2 + f ) );
+		vst1q_f32( d + 2 * f, vaddq_f32( vld1q_f32( d + 2 * f ), select( finiteMask( in ), x ) ) );
+	}
+	scalar::addSanitizedMultipliedByBuffers( dst + vecFrames, src + vecFrames, coeffSrcBuf1 + vecFrames,
+		coeffSrcBuf2 + vecFrames, frames - vecFrames );
+}
+
+void multiplyStereo(SampleFrame* dst, float coeffLeft, float coeffRight, int frames)
+{
+	float* d = samples(dst);
+	const float coeffs[] = {coeffLeft, coeffRight, coeffLeft, coeffRight};
+	const float32x4_t c = vld1q_f32(coeffs);
+	const int vecFrames = frames - frames % FramesPerVector;
+	for (int f = 0; f < vecFrames; f += FramesPerVector)
+	{
+		vst1q_f32(d + 2 * f, vmulq_f32(vld1q_f32(d + 2 * f), c));
+	}
+	scalar::multiplyStereo(dst + vecFrames, coeffLeft, coeffRight, frames - vecFrames);
+}
+
+void multiplyByBuffer(SampleFrame* dst, const float* coeffBuf, int frames)
+{
+	float* d = samples(dst);
+	const int vecFrames = frames - frames % FramesPerVector;
+	for (int f = 0; f < vecFrames; f += FramesPerVector)
+	{
+		vst1q_f32(d + 2 * f, vmulq_f32(vld1q_f32(d + 2 * f), loadPerFrame(coeffBuf + f)));
+	}
+	scalar::multiplyByBuffer(dst + vecFrames, coeffBuf + vecFrames, frames - vecFrames);
+}
+
+void multiplyAndAddMultiplied(SampleFrame* dst, const SampleFrame* src, float coeffDst, float coeffSrc, int frames)
+{
+	float* d = samples(dst);
+	const float* s = samples(src);
+	const int vecFrames = frames - frames % FramesPerVector;
+	for (int f = 0; f < vecFrames; f += FramesPerVector)
+	{
+		const float32x4_t x = vmulq_n_f32(vld1q_f32(d + 2 * f), coeffDst);
+		vst1q_f32(d + 2 * f, vaddq_f32(x, vmulq_n_f32(vld1q_f32(s + 2 * f), coeffSrc)));
+	}
+	scalar::multiplyAndAddMultiplied(dst + vecFrames, src + vecFrames, coeffDst, coeffSrc, frames - vecFrames);
+}
+
+SampleFrame absPeak(const SampleFrame* src, int frames)
+{
+	const float* s = samples(src);
+	const int vecFrames = frames - frames % FramesPerVector;
+	float32x4_t peak = vdupq_n_f32(0.0f);
+	for (int f = 0; f < vecFrames; f += FramesPerVector)
+	{
+		// vmaxq_f32 would return nans, skip them instead
+		const float32x4_t x = vabsq_f32(vld1q_f32(s + 2 * f));
+		peak = vbslq_f32(vcgtq_f32(x, peak), x, peak);
+	}
+	const float32x2_t half = vmax_f32(vget_low_f32(peak), vget_high_f32(peak));
+
+	auto result = scalar::absPeak(src + vecFrames, frames - vecFrames);
+	result[0] = std::max(result[0], vget_lane_f32(half, 0));
+	result[1] = std::max(result[1], vget_lane_f32(half, 1));
+	return result;
+}
+
+SampleFrame sumOfSquares(const SampleFrame* src, int frames)
+{
+	const float* s = samples(src);
+	const int vecFrames = frames - frames % scalar::SquaresLaneFrames;
+	float32x4_t lanes0 = vdupq_n_f32(0.0f);
+	float32x4_t lanes1 = vdupq_n_f32(0.0f);
+	for (int f = 0; f < vecFrames; f += scalar::SquaresLaneFrames)
+	{
+		const float32x4_t x0 = vld1q_f32(s + 2 * f);
+		const float32x4_t x1 = vld1q_f32(s + 2 * f + 4);
+		lanes0 = vaddq_f32(lanes0, vmulq_f32(x0, x0));
+		lanes1 = vaddq_f32(lanes1, vmulq_f32(x1, x1));
+	}
+
+	float lanes[2 * scalar::SquaresLaneFrames];
+	vst1q_f32(lanes, lanes0);
+	vst1q_f32(lanes + 4, lanes1);
+	return scalar::reduceSquares(lanes, src + vecFrames, frames - vecFrames);
+}
+
+void levels(const SampleFrame* src, int frames, SampleFrame& peak, SampleFrame& sumOfSquares)
+{
+	const float* s = samples(src);
+	const int vecFrames = frames - frames % scalar::SquaresLaneFrames;
+	float32x4_t peaks = vdupq_n_f32(0.0f);
+	float32x4_t lanes0 = vdupq_n_f32(0.0f);
+	float32x4_t lanes1 = vdupq_n_f32(0.0f);
+	for (int f = 0; f < vecFrames; f += scalar::SquaresLaneFrames)
+	{
+		const float32x4_t x0 = vld1q_f32(s + 2 * f);
+		const float32x4_t x1 = vld1q_f32(s + 2 * f + 4);
+		// vmaxq_f32 would return nans, skip them instead
+		const float32x4_t a0 = vabsq_f32(x0);
+		peaks = vbslq_f32(vcgtq_f32(a0, peaks), a0, peaks);
+		const float32x4_t a1 = vabsq_f32(x1);
+		peaks = vbslq_f32(vcgtq_f32(a1, peaks), a1, peaks);
+		lanes0 = vaddq_f32(lanes0, vmulq_f32(x0, x0));
+		lanes1 = vaddq_f32(lanes1, vmulq_f32(x1, x1));
+	}
+	const float32x2_t half = vmax_f32(vget_low_f32(peaks), vget_high_f32(peaks));
+
+	peak = scalar::absPeak(src + vecFrames, frames - vecFrames);
+	peak[0] = std::max(peak[0], vget_lane_f32(half, 0));
+	peak[1] = std::max(peak[1], vget_lane_f32(half, 1));
+
+	float lanes[2 * scalar::SquaresLaneFrames];
+	vst1q_f32(lanes, lanes0);
+	vst1q_f32(lanes + 4, lanes1);
+	sumOfSquares = scalar::reduceSquares(lanes, src + vecFrames, frames - vecFrames);
+}
+
+void interleave(SampleFrame* dst, const float* left, const float* right, int frames)
+{
+	float* d = samples(dst);
+	const int vecFrames = frames - frames % 4;
+	for (int f = 0; f < vecFrames; f += 4)
+	{
+		vst2q_f32(d + 2 * f, float32x4x2_t{vld1q_f32(left + f), vld1q_f32(right + f)});
+	}
+	scalar::interleave(dst + vecFrames, left + vecFrames, right + vecFrames, frames - vecFrames);
+}
+
+void deinterleave(float* left, float* right, const SampleFrame* src, int frames)
+{
+	const float* s = samples(src);
+	const int vecFrames = frames - frames % 4;
+	for (int f = 0; f < vecFrames; f += 4)
+	{
+		const float32x4x2_t v = vld2q_f32(s + 2 * f);
+		vst1q_f32(left + f, v.val[0]);
+		vst1q_f32(right + f, v.val[1]);
+	}
+	scalar::deinterleave(left + vecFrames, right + vecFrames, src + vecFrames, frames - vecFrames);
+}
+
+constexpr Kernels kernels = {
+	isSilent, sanitize, add, multiply, addMultiplied, addMultipliedByBuffer, addMultipliedByBuffers,
+	addSanitizedMultiplied, addSanitizedMultipliedByBuffer, addSanitizedMultipliedByBuffers,
+	multiplyStereo, multiplyByBuffer, multiplyAndAddMultiplied, absPeak, sumOfSquares, levels,
+	interleave, deinterleave
+};
+
+} // namespace neon
+#endif // LMMS_MIXHELPERS_NEON
+
+
+
+
+const Kernels* kernelsFor( SimdLevel level )
+{
+	switch( level )
+	{
+		case SimdLevel::Scalar: return &scalar::kernels;
+#ifdef LMMS_MIXHELPERS_SSE2
+		case SimdLevel::Sse2: return &sse2::kernels;
+#endif
+#ifdef LMMS_MIXHELPERS_AVX2
+		case SimdLevel::Avx2:
+			// might run before libgcc initialized the CPU model
+			__builtin_cpu_init();
+			return __builtin_cpu_supports( "avx2" ) ? &avx2::kernels : nullptr;
+#endif
+#ifdef LMMS_MIXHELPERS_NEON
+		case SimdLevel::Neon: return &neon::kernels;
+#endif
+		default: return nullptr;
+	}
+}
+
+SimdLevel detectSimdLevel()
+{
+	for( auto level : { SimdLevel::Avx2, SimdLevel::Sse2, SimdLevel::Neon } )
+	{
+		if( kernelsFor( level ) ) { return level; }
+	}
+	return SimdLevel::Scalar;
+}
+
+// start with the scalar kernels, so we're safe even if used during static
+// initialization of other translation units
+SimdLevel s_simdLevel = SimdLevel::Scalar;
+const Kernels* s_kernels = &scalar::kernels;
+
+const bool s_kernelsInitialized = setSimdLevel( detectSimdLevel() );
+
+} // namespace
+
+
+
+SimdLevel simdLevel()
+{
+	return s_simdLevel;
+}
+
+SimdLevel bestSimdLevel()
+{
+	static const SimdLevel s_best = detectSimdLevel();
+	return s_best;
+}
+
+bool setSimdLevel( SimdLevel level )
+{
+	if( const Kernels* kernels = kernelsFor( level ) )
+	{
+		s_kernels = kernels;
+		s_simdLevel = level;
+		return true;
+	}
+	return false;
+}
+
+
+
+bool isSilent( const SampleFrame* src, int frames )
+{
+	return s_kernels->isSilent( src, frames );
+}
+
+void interleave(SampleFrame* dst, const float* left, const float* right, int frames)
+{
+	s_kernels->interleave(dst, left, right, frames);
+}
+
+void deinterleave(float* left, float* right, const SampleFrame* src, int frames)
+{
+	s_kernels->deinterleave(left, right, src, frames);
+}
+
+bool useNaNHandler()
+{
+	return s_NaNHandler;
+}
+
+void setNaNHandler( bool use )
+{
+	s_NaNHandler = use;
+}
+
+/*! \brief Function for sanitizing a buffer of infs/nans - returns true if those are found */
+bool sanitize( SampleFrame* src, int frames )
+{
+	if( !useNaNHandler() )
+	{
+		return false;
+	}
+
+	return s_kernels->sanitize( src, frames );
+}
+
+
+void add( SampleFrame* dst, const SampleFrame* src, int frames )
+{
+	s_kernels->add( dst, src, frames );
+}
+
+
+void addMultiplied( SampleFrame* dst, const SampleFrame* src, float coeffSrc, int frames )
+{
+	s_kernels->addMultiplied( dst, src, coeffSrc, frames );
+}
+
+
+struct AddSwappedMultipliedOp
+{
+	AddSwappedMultipliedOp( float coeff ) : m_coeff( coeff ) { }
+
+	void operator()( SampleFrame& dst, const SampleFrame& src ) const
+	{
+		dst[0] += src[1] * m_coeff;
+		dst[1] += src[0] * m_coeff;
+	}
+
+	const float m_coeff;
+};
+
+void multiply(SampleFrame* dst, float coeff, int frames)
+{
+	s_kernels->multiply( dst, coeff, frames );
+}
+
+void multiplyStereo(SampleFrame* dst, float coeffLeft, float coeffRight, int frames)
+{
+	s_kernels->multiplyStereo(dst, coeffLeft, coeffRight, frames);
+}
+
+void multiplyByBuffer(SampleFrame* dst, const float* coeffBuf, int frames)
+{
+	s_kernels->multiplyByBuffer(dst, coeffBuf, frames);
+}
+
+SampleFrame absPeak(const SampleFrame* src, int frames)
+{
+	return s_kernels->absPeak(src, frames);
+}
+
+SampleFrame sumOfSquares(const SampleFrame* src, int frames)
+{
+	return s_kernels->sumOfSquares(src, frames);
+}
+
+void levels(const SampleFrame* src, int frames, SampleFrame& peak, SampleFrame& sumOfSquares)
+{
+	s_kernels->levels(src, frames, peak, sumOfSquares);
+}
+
+SampleFrame rms(const SampleFrame* src, int frames)
+{
+	if (frames <= 0) { return SampleFrame{}; }
+
+	const auto sums = sumOfSquares(src, frames);
+	return SampleFrame{std::sqrt(sums[0] / frames), std::sqrt(sums[1] / frames)};
+}
+
+void addSwappedMultiplied( SampleFrame* dst, const SampleFrame* src, float coeffSrc, int frames )
+{
+	run<>( dst, src, frames, AddSwappedMultipliedOp(coeffSrc) );
+}
+
+
+void addMultipliedByBuffer( SampleFrame* dst, const SampleFrame* src, float coeffSrc, ValueBuffer * coeffSrcBuf, int frames )
+{
+	if( coeffSrcBuf->isConstant() )
+	{
+		s_kernels->addMultiplied( dst, src, coeffSrc * coeffSrcBuf->values()[0], frames );
+		return;
+	}
+	s_kernels->addMultipliedByBuffer( dst, src, coeffSrc, coeffSrcBuf->values(), frames );
+}
+
+void addMultipliedByBuffers( SampleFrame* dst, const SampleFrame* src, ValueBuffer * coeffSrcBuf1, ValueBuffer * coeffSrcBuf2, int frames )
+{
+	if( coeffSrcBuf1->isConstant() )
+	{
+		addMultipliedByBuffer( dst, src, coeffSrcBuf1->values()[0], coeffSrcBuf2, frames );
+		return;
+	}
+	if( coeffSrcBuf2->isConstant() )
+	{
+		addMultipliedByBuffer( dst, src, coeffSrcBuf2->values()[0], coeffSrcBuf1, frames );
+		return;
+	}
+	s_kernels->addMultipliedByBuffers( dst, src, coeffSrcBuf1->values(), coeffSrcBuf2->values(), frames );
+}
+
+void addSanitizedMultipliedByBuffer( SampleFrame* dst, const SampleFrame* src, float coeffSrc, ValueBuffer * coeffSrcBuf, int frames )
+{
+	if ( !useNaNHandler() )
+	{
+		addMultipliedByBuffer( dst, src, coeffSrc, coeffSrcBuf,
+								frames );
+		return;
+	}
+
+	if( coeffSrcBuf->isConstant() )
+	{
+		s_kernels->addSanitizedMultiplied( dst, src, coeffSrc * coeffSrcBuf->values()[0], frames );
+		return;
+	}
+	s_kernels->addSanitizedMultipliedByBuffer( dst, src, coeffSrc, coeffSrcBuf->values(), frames );
+}
+
+void addSanitizedMultipliedByBuffers( SampleFrame* dst, const SampleFrame* src, ValueBuffer * coeffSrcBuf1, ValueBuffer * coeffSrcBuf2, int frames )
+{
+	if ( !useNaNHandler() )
+	{
+		addMultipliedByBuffers( dst, src, coeffSrcBuf1, coeffSrcBuf2,
+								frames );
+		return;
+	}
+
+	if( coeffSrcBuf1->isConstant() )
+	{
+		addSanitizedMultipliedByBuffer( dst, src, coeffSrcBuf1->values()[0], coeffSrcBuf2, frames );
+		return;
+	}
+	if( coeffSrcBuf2->isConstant() )
+	{
+		addSanitizedMultipliedByBuffer( dst, src, coeffSrcBuf2->values()[0], coeffSrcBuf1, frames );
+		return;
+	}
+	s_kernels->addSanitizedMultipliedByBuffers( dst, src, coeffSrcBuf1->values(), coeffSrcBuf2->values(), frames );
+}
+
+
+void addSanitizedMultiplied( SampleFrame* dst, const SampleFrame* src, float coeffSrc, int frames )
+{
+	if ( !useNaNHandler() )
+	{
+		addMultiplied( dst, src, coeffSrc, frames );
+		return;
+	}
+
+	s_kernels->addSanitizedMultiplied( dst, src, coeffSrc, frames );
 }
 
 
@@ -316,7 +1650,7 @@ struct MultiplyAndAddMultipliedOp
 
 void multiplyAndAddMultiplied( SampleFrame* dst, const SampleFrame* src, float coeffDst, float coeffSrc, int frames )
 {
-	run<>( dst, src, frames, MultiplyAndAddMultipliedOp(coeffDst, coeffSrc) );
+	s_kernels->multiplyAndAddMultiplied( dst, src, coeffDst, coeffSrc, frames );
 }
 
 
@@ -23,9 +23,15 @@
  */
 
 #include <QDomElement>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <new>
 
+#include "AudioBusHandle.h"
 #include "AudioEngine.h"
 #include "AudioEngineWorkerThread.h"
+#include "BufferManager.h"
 #include "Mixer.h"
 #include "MixHelpers.h"
 #include "Song.h"
@@ -61,30 +67,29 @@ MixerChannel::MixerChannel( int idx, Model * _parent ) :
 	m_fxChain( nullptr ),
 	m_hasInput( false ),
 	m_stillRunning( false ),
-	m_peakLeft( 0.0f ),
-	m_peakRight( 0.0f ),
-	m_buffer( new SampleFrame[Engine::audioEngine()->framesPerPeriod()] ),
+	m_bufferSilent( true ),
+	m_buffer( nullptr ),
 	m_muteModel( false, _parent ),
 	m_soloModel( false, _parent ),
 	m_volumeModel(1.f, 0.f, 2.f, 0.001f, _parent),
 	m_name(),
 	m_lock(),
 	m_queued( false ),
+	m_busInputs( 0 ),
+	m_inputLatency( 0 ),
+	m_outputLatency( 0 ),
+	m_compensationBuffer( Engine::audioEngine()->maxFramesPerPeriod() ),
 	m_dependenciesMet(0),
-	m_channelIndex(idx)
+	m_channelIndex(idx),
+	m_metered(true),
+	m_levels(LevelsQueueSize),
+	m_levelsReader(m_levels)
 {
-	zeroSampleFrames(m_buffer, Engine::audioEngine()->framesPerPeriod());
 }
 
 
 
 
-MixerChannel::~MixerChannel()
-{
-	delete[] m_buffer;
-}
-
-
 inline void MixerChannel::processed()
 {
 	for( const MixerRoute * receiverRoute : m_sends )
@@ -99,7 +104,7 @@ inline void MixerChannel::processed()
 void MixerChannel::incrementDeps()
 {
 	const auto i = m_dependenciesMet++ + 1;
-	if( i >= m_receives.size() && ! m_queued )
+	if( i >= m_receives.size() + m_busInputs && ! m_queued )
 	{
 		m_queued = true;
 		AudioEngineWorkerThread::addJob( this );
@@ -163,25 +168,48 @@ void MixerChannel::unmuteReceiverForSolo()
 
 void MixerChannel::doProcessing()
 {
+	AudioEngineProfiler::TraceScope trace(Engine::audioEngine()->profiler(), "Mixer", "Mixer channel", m_channelIndex);
+	const auto time = CpuTime::Scope{&m_cpuTime};
 	const fpp_t fpp = Engine::audioEngine()->framesPerPeriod();
+	Engine::audioEngine()->seedRandom(AudioEngine::RandomDomain::MixerChannel, m_channelIndex);
 
 	if( m_muted == false )
 	{
+		for( AudioBusHandle * busHandle : m_busHandles )
+		{
+			if( busHandle->hasOutput() )
+			{
+				MixHelpers::add( m_buffer, busHandle->buffer(), fpp );
+				m_hasInput = true;
+			}
+		}
+
 		for( MixerRoute * senderRoute : m_receives )
 		{
 			MixerChannel * sender = senderRoute->sender();
 			FloatModel * sendModel = senderRoute->amount();
 			if( ! sendModel ) qFatal( "Error: no send model found from %d to %d", senderRoute->senderIndex(), m_channelIndex );
 
-			if( sender->m_hasInput || sender->m_stillRunning )
+			// a delayed send may still output what the sender sent earlier
+			CompensationDelay& compensation = senderRoute->compensation();
+			if( !sender->isSilent() || compensation.delay() > 0 )
 			{
+				// mix it's output with this one's output
+				SampleFrame* ch_buf = sender->m_buffer;
+				if( compensation.delay() > 0 )
+				{
+					if( !compensation.process( sender->isSilent() ? nullptr : ch_buf,
+									m_compensationBuffer.data(), fpp ) )
+					{
+						continue;
+					}
+					ch_buf = m_compensationBuffer.data();
+				}
+
 				// figure out if we're getting sample-exact input
 				ValueBuffer * sendBuf = sendModel->valueBuffer();
 				ValueBuffer * volBuf = sender->m_volumeModel.valueBuffer();
 
-				// mix it's output with this one's output
-				SampleFrame* ch_buf = sender->m_buffer;
-
 				// use sample-exact mixing if sample-exact values are available
 				if( ! volBuf && ! sendBuf ) // neither volume nor send has sample-exact data...
 				{
@@ -215,15 +243,30 @@ void MixerChannel::doProcessing()
 			m_fxChain.startRunning();
 		}
 
-		m_stillRunning = m_fxChain.processAudioBuffer( m_buffer, fpp, m_hasInput );
+		// without input, the buffer only has to be touched while there are
+		// effects still running, otherwise it is known to be silent
+		if( m_hasInput || m_fxChain.isRunning() )
+		{
+			m_stillRunning = m_fxChain.processAudioBuffer( m_buffer, fpp, m_hasInput );
+			m_bufferSilent = false;
 
-		SampleFrame peakSamples = getAbsPeakValues(m_buffer, fpp);
-		m_peakLeft = std::max(m_peakLeft, peakSamples[0] * v);
-		m_peakRight = std::max(m_peakRight, peakSamples[1] * v);
+			if (m_metered.load(std::memory_order_relaxed))
+			{
+				auto peak = SampleFrame{};
+				auto sumOfSquares = SampleFrame{};
+				MixHelpers::levels(m_buffer, fpp, peak, sumOfSquares);
+				const auto rms = SampleFrame{std::sqrt(sumOfSquares[0] / fpp), std::sqrt(sumOfSquares[1] / fpp)};
+				publishLevels({peak * v, rms * v});
+			}
+		}
+		else
+		{
+			m_stillRunning = false;
+		}
 	}
-	else
+	else if (m_metered.load(std::memory_order_relaxed))
 	{
-		m_peakLeft = m_peakRight = 0.0f;
+		publishLevels({});
 	}
 
 	// increment dependency counter of all receivers
@@ -232,6 +275,38 @@ void MixerChannel::doProcessing()
 
 
 
+
+void MixerChannel::publishLevels(const Levels& levels)
+{
+	// if the meters haven't read for a while, the levels of this period are dropped
+	m_levels.write(&levels, 1);
+}
+
+
+
+
+bool MixerChannel::readLevels(Levels& levels)
+{
+	auto pending = std::array<Levels, LevelsQueueSize>{};
+	const auto count = std::min(m_levelsReader.read_space(), pending.size());
+	if (count == 0) { return false; }
+	m_levelsReader.read(count).copy(pending.data(), count);
+
+	auto peak = SampleFrame{};
+	auto sumOfSquares = SampleFrame{};
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		peak = peak.absMax(pending[i].peak);
+		sumOfSquares += pending[i].rms * pending[i].rms;
+	}
+	// all periods have the same length
+	levels.peak = peak;
+	levels.rms = SampleFrame{std::sqrt(sumOfSquares[0] / count), std::sqrt(sumOfSquares[1] / count)};
+	return true;
+}
+
+
+
 Mixer::Mixer() :
 	Model( nullptr ),
 	JournallingObject(),
@@ -264,7 +339,11 @@ int Mixer::createChannel()
 {
 	const int index = m_mixerChannels.size();
 	// create new channel
+	Engine::audioEngine()->requestChangeInModel();
 	m_mixerChannels.push_back( new MixerChannel( index, this ) );
+	allocateChannelBuffers();
+	compileRoutingPlan();
+	Engine::audioEngine()->doneChangeInModel();
 
 	// reset channel state
 	clearChannel( index );
@@ -400,6 +479,7 @@ void Mixer::deleteChannel( int index )
 	// actually delete the channel
 	m_mixerChannels.erase(m_mixerChannels.begin() + index);
 	delete ch;
+	allocateChannelBuffers();
 
 	for (auto i = static_cast<std::size_t>(index); i < m_mixerChannels.size(); ++i)
 	{
@@ -419,6 +499,9 @@ void Mixer::deleteChannel( int index )
 		}
 	}
 
+	// the plan refers to the channels by their indices
+	compileRoutingPlan();
+
 	Engine::audioEngine()->doneChangeInModel();
 }
 
@@ -532,6 +615,7 @@ MixerRoute * Mixer::createRoute( MixerChannel * from, MixerChannel * to, float a
 
 	// add us to mixer's list
 	Engine::mixer()->m_mixerRoutes.push_back(route);
+	Engine::mixer()->compileRoutingPlan();
 	Engine::audioEngine()->doneChangeInModel();
 
 	return route;
@@ -577,6 +661,7 @@ void Mixer::deleteChannelSend( MixerRoute * route )
 	removeFromMixerRoute(Engine::mixer()->m_mixerRoutes);
 
 	delete route;
+	compileRoutingPlan();
 	Engine::audioEngine()->doneChangeInModel();
 }
 
@@ -663,51 +748,184 @@ void Mixer::prepareMasterMix()
 
 
 
-void Mixer::masterMix( SampleFrame* _buf )
+void Mixer::compileRoutingPlan()
 {
-	const int fpp = Engine::audioEngine()->framesPerPeriod();
+	// length of the longest chain of sends from each channel to a channel not sending anywhere,
+	// sends can't form loops (see isInfiniteLoop())
+	auto depths = std::vector<int>(m_mixerChannels.size(), -1);
+	const auto depthOf = [&](const auto& depthOf, MixerChannel* ch) -> int {
+		auto& depth = depths[ch->index()];
+		if (depth < 0)
+		{
+			int maxDepth = 0;
+			for (const MixerRoute* send : ch->m_sends)
+			{
+				maxDepth = std::max(maxDepth, depthOf(depthOf, send->receiver()) + 1);
+			}
+			depth = maxDepth;
+		}
+		return depth;
+	};
+
+	m_processingOrder = m_mixerChannels;
+	for (MixerChannel* ch : m_processingOrder) { depthOf(depthOf, ch); }
+	std::stable_sort(m_processingOrder.begin(), m_processingOrder.end(), [&](MixerChannel* a, MixerChannel* b) {
+		return depths[a->index()] > depths[b->index()];
+	});
+}
+
+
+
+
+void Mixer::AlignedDeleter::operator()(SampleFrame* frames) const
+{
+	::operator delete[](frames, std::align_val_t{BufferManager::Alignment});
+}
+
+
+
+
+void Mixer::allocateChannelBuffers()
+{
+	constexpr auto FramesPerLine = BufferManager::Alignment / sizeof(SampleFrame);
+	const auto fpp = Engine::audioEngine()->maxFramesPerPeriod();
+	m_channelBufferStride = (fpp + FramesPerLine - 1) / FramesPerLine * FramesPerLine;
+
+	const auto frames = m_channelBufferStride * m_mixerChannels.size();
+	auto buffers = std::unique_ptr<SampleFrame[], AlignedDeleter>{static_cast<SampleFrame*>(
+		::operator new[](frames * sizeof(SampleFrame), std::align_val_t{BufferManager::Alignment}))};
+	zeroSampleFrames(buffers.get(), frames);
+
+	// the buffers are cleared after every period, so nothing has to be copied
+	for (auto i = std::size_t{0}; i < m_mixerChannels.size(); ++i)
+	{
+		m_mixerChannels[i]->m_buffer = buffers.get() + i * m_channelBufferStride;
+		m_mixerChannels[i]->m_bufferSilent = true;
+	}
+	m_channelBuffers = std::move(buffers);
+}
+
+
+
+
+std::size_t Mixer::memoryUsage() const
+{
+	auto memory = std::size_t{m_channelBufferStride} * m_mixerChannels.size() * sizeof(SampleFrame);
+	for (const MixerChannel* ch : m_mixerChannels)
+	{
+		memory += ch->m_compensationBuffer.capacity() * sizeof(SampleFrame);
+		for (MixerRoute* route : ch->m_sends)
+		{
+			memory += route->compensation().memoryUsage();
+		}
+	}
+	return memory;
+}
+
+
+
+
+void Mixer::compensateLatencies( const std::vector<AudioBusHandle*>& _busHandles )
+{
+	for (MixerChannel* ch : m_processingOrder) { ch->m_inputLatency = 0; }
+
+	const auto validChannel = [this](mix_ch_t ch) { return ch >= 0 && ch < numChannels(); };
+	for (AudioBusHandle* busHandle : _busHandles)
+	{
+		if (const mix_ch_t ch = busHandle->nextMixerChannel(); validChannel(ch))
+		{
+			m_mixerChannels[ch]->m_inputLatency = std::max(m_mixerChannels[ch]->m_inputLatency, busHandle->latency());
+		}
+	}
+
+	// senders always come before their receivers
+	for (MixerChannel* ch : m_processingOrder)
+	{
+		for (const MixerRoute* receive : ch->m_receives)
+		{
+			ch->m_inputLatency = std::max(ch->m_inputLatency, receive->sender()->m_outputLatency);
+		}
+		ch->m_outputLatency = ch->m_inputLatency + ch->m_fxChain.latency();
+	}
+
+	for (AudioBusHandle* busHandle : _busHandles)
+	{
+		const mix_ch_t ch = busHandle->nextMixerChannel();
+		busHandle->setCompensation(validChannel(ch) ? m_mixerChannels[ch]->m_inputLatency - busHandle->latency() : 0);
+	}
+	for (MixerRoute* route : m_mixerRoutes)
+	{
+		route->compensation().setDelay(route->receiver()->m_inputLatency - route->sender()->m_outputLatency);
+	}
+
+	m_latency = m_mixerChannels[0]->m_outputLatency;
+}
+
+
+
+
+void Mixer::scheduleChannels( const std::vector<AudioBusHandle*>& _busHandles )
+{
+	compensateLatencies(_busHandles);
+
+	for( MixerChannel * ch : m_processingOrder )
+	{
+		ch->m_muted = ch->m_muteModel.value();
+	}
+
+	// a channel has to wait for all bus handles sending into it
+	const bool deterministic = Engine::audioEngine()->isDeterministic();
+	for( AudioBusHandle * busHandle : _busHandles )
+	{
+		const mix_ch_t ch = busHandle->nextMixerChannel();
+		if( ch < numChannels() && ! m_mixerChannels[ch]->m_muted )
+		{
+			++m_mixerChannels[ch]->m_busInputs;
+			if( deterministic )
+			{
+				m_mixerChannels[ch]->m_busHandles.push_back( busHandle );
+			}
+		}
+	}
 
 	// add the channels that have no dependencies (no incoming senders, ie.
-	// no receives) to the jobqueue. The channels that have receives get
-	// added when their senders get processed, which is detected by
-	// dependency counting.
+	// no receives, and no bus handles) to the jobqueue. The channels that
+	// have dependencies get added when their senders get processed, which
+	// is detected by dependency counting.
 	// also instantly add all muted channels as they don't need to care
 	// about their senders, and can just increment the deps of their
 	// recipients right away.
-	AudioEngineWorkerThread::resetJobQueue( AudioEngineWorkerThread::JobQueue::OperationMode::Dynamic );
-	for( MixerChannel * ch : m_mixerChannels )
+	for( MixerChannel * ch : m_processingOrder )
 	{
-		ch->m_muted = ch->m_muteModel.value();
 		if( ch->m_muted ) // instantly "process" muted channels
 		{
 			ch->processed();
 			ch->done();
 		}
-		else if( ch->m_receives.size() == 0 )
+		else if( ch->m_receives.size() == 0 && ch->m_busInputs == 0 )
 		{
 			ch->m_queued = true;
 			AudioEngineWorkerThread::addJob( ch );
 		}
 	}
-	while (m_mixerChannels[0]->state() != ThreadableJob::ProcessingState::Done)
+}
+
+
+
+
+void Mixer::busHandleProcessed( mix_ch_t _ch )
+{
+	if( _ch >= 0 && _ch < numChannels() && ! m_mixerChannels[_ch]->m_muted )
 	{
-		bool found = false;
-		for( MixerChannel * ch : m_mixerChannels )
-		{
-			const auto s = ch->state();
-			if (s == ThreadableJob::ProcessingState::Queued
-				|| s == ThreadableJob::ProcessingState::InProgress)
-			{
-				found = true;
-				break;
-			}
-		}
-		if( !found )
-		{
-			break;
-		}
-		AudioEngineWorkerThread::startAndWaitForJobs();
+		m_mixerChannels[_ch]->incrementDeps();
 	}
+}
+
+
+
+void Mixer::masterMix( SampleFrame* _buf )
+{
+	const int fpp = Engine::audioEngine()->framesPerPeriod();
 
 	// handle sample-exact data in master volume fader
 	ValueBuffer * volBuf = m_mixerChannels[0]->m_volumeModel.valueBuffer();
@@ -724,18 +942,31 @@ void Mixer::masterMix( SampleFrame* _buf )
 	const float v = volBuf
 		? 1.0f
 		: m_mixerChannels[0]->m_volumeModel.value();
-	MixHelpers::addSanitizedMultiplied( _buf, m_mixerChannels[0]->m_buffer, v, fpp );
-
-	// clear all channel buffers and
-	// reset channel process state
-	for( int i = 0; i < numChannels(); ++i)
-	{
-		zeroSampleFrames(m_mixerChannels[i]->m_buffer, Engine::audioEngine()->framesPerPeriod());
-		m_mixerChannels[i]->reset();
-		m_mixerChannels[i]->m_queued = false;
-		// also reset hasInput
-		m_mixerChannels[i]->m_hasInput = false;
-		m_mixerChannels[i]->m_dependenciesMet = 0;
+	if( !m_mixerChannels[0]->isSilent() )
+	{
+		MixHelpers::addSanitizedMultiplied( _buf, m_mixerChannels[0]->m_buffer, v, fpp );
+	}
+
+	// clear the buffers of channels which have been written to, all at once
+	// if that's most of them, and reset channel process state
+	const auto written = std::count_if(m_mixerChannels.begin(), m_mixerChannels.end(),
+		[](const MixerChannel* ch) { return !ch->isSilent(); });
+	const bool clearAll = written > numChannels() / 2;
+	if (clearAll) { zeroSampleFrames(m_channelBuffers.get(), m_channelBufferStride * m_mixerChannels.size()); }
+
+	for (MixerChannel* ch : m_processingOrder)
+	{
+		if (!ch->isSilent())
+		{
+			if (!clearAll) { zeroSampleFrames(ch->m_buffer, fpp); }
+			ch->m_bufferSilent = true;
+		}
+		ch->reset();
+		ch->m_queued = false;
+		ch->m_hasInput = false;
+		ch->m_busInputs = 0;
+		ch->m_busHandles.clear();
+		ch->m_dependenciesMet = 0;
 	}
 }
 
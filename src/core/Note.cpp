@@ -204,17 +204,41 @@ void Note::saveSettings( QDomDocument & doc, QDomElement & parent )
 
 
 
-void Note::loadSettings( const QDomElement & _this )
+auto Note::parseAttributes(const QDomElement& element) -> Attributes
 {
-	const int oldKey = _this.attribute( "tone" ).toInt() + _this.attribute( "oct" ).toInt() * KeysPerOctave;
-	m_key = std::max(oldKey, _this.attribute("key").toInt());
-	m_volume = _this.attribute( "vol" ).toInt();
-	m_panning = _this.attribute( "pan" ).toInt();
-	m_length = _this.attribute( "len" ).toInt();
-	m_pos = _this.attribute( "pos" ).toInt();
+	const int oldKey = element.attribute("tone").toInt() + element.attribute("oct").toInt() * KeysPerOctave;
+
 	// Default m_type value is 0, which corresponds to RegularNote
 	static_assert(0 == static_cast<int>(Type::Regular));
-	m_type = static_cast<Type>(_this.attribute("type", "0").toInt());
+	return Attributes{
+		std::max(oldKey, element.attribute("key").toInt()),
+		static_cast<volume_t>(element.attribute("vol").toInt()),
+		static_cast<panning_t>(element.attribute("pan").toInt()),
+		element.attribute("len").toInt(),
+		element.attribute("pos").toInt(),
+		static_cast<Type>(element.attribute("type", "0").toInt())
+	};
+}
+
+
+
+
+void Note::loadAttributes(const Attributes& attributes)
+{
+	m_key = attributes.key;
+	m_volume = attributes.volume;
+	m_panning = attributes.panning;
+	m_length = attributes.length;
+	m_pos = attributes.pos;
+	m_type = attributes.type;
+}
+
+
+
+
+void Note::loadSettings( const QDomElement & _this )
+{
+	loadAttributes(parseAttributes(_this));
 
 	if( _this.hasChildNodes() )
 	{
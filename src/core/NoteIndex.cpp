@@ -0,0 +1,100 @@
+/*
+ * NoteIndex.cpp - finds the notes in a range of time and keys
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "NoteIndex.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+namespace lmms
+{
+
+
+void NoteIndex::build(const NoteVector& notes)
+{
+	for (auto& entries : m_keys) { entries.clear(); }
+
+	for (std::size_t i = 0; i < notes.size(); ++i)
+	{
+		Note* note = notes[i];
+		const tick_t length = note->length().getTicks();
+		if (length == 0) { continue; }
+
+		const tick_t pos = note->pos().getTicks();
+		const tick_t end = pos + std::max(length, MinLength);
+		m_keys[note->key()].push_back(Entry{pos, end, end, i, note});
+	}
+
+	const auto byPos = [](const Entry& a, const Entry& b) { return a.pos < b.pos; };
+	for (auto& entries : m_keys)
+	{
+		// the notes of a clip are kept sorted, apart from while being edited
+		if (!std::is_sorted(entries.begin(), entries.end(), byPos))
+		{
+			std::stable_sort(entries.begin(), entries.end(), byPos);
+		}
+
+		auto maxEnd = std::numeric_limits<tick_t>::min();
+		for (auto& entry : entries)
+		{
+			maxEnd = std::max(maxEnd, entry.end);
+			entry.maxEnd = maxEnd;
+		}
+	}
+
+	m_valid = true;
+}
+
+
+
+
+NoteVector NoteIndex::notesIn(tick_t from, tick_t to, int firstKey, int lastKey) const
+{
+	auto found = std::vector<std::pair<std::size_t, Note*>>();
+
+	for (int key = std::max(firstKey, 0); key <= std::min(lastKey, NumKeys - 1); ++key)
+	{
+		const auto& entries = m_keys[key];
+
+		// the notes before the first entry reaching from all end before it
+		auto it = std::partition_point(entries.begin(), entries.end(),
+			[from](const Entry& entry) { return entry.maxEnd < from; });
+		const auto last = std::partition_point(it, entries.end(),
+			[to](const Entry& entry) { return entry.pos <= to; });
+
+		for (; it != last; ++it)
+		{
+			if (it->end >= from) { found.emplace_back(it->order, it->note); }
+		}
+	}
+
+	std::sort(found.begin(), found.end());
+
+	auto notes = NoteVector();
+	notes.reserve(found.size());
+	for (const auto& [order, note] : found) { notes.push_back(note); }
+	return notes;
+}
+
+
+} // namespace lmms
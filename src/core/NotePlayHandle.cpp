@@ -25,11 +25,19 @@
 
 #include "NotePlayHandle.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <new>
+#include <utility>
+#include <vector>
+
 #include "AudioEngine.h"
 #include "DetuningHelper.h"
 #include "InstrumentSoundShaping.h"
 #include "InstrumentTrack.h"
 #include "Instrument.h"
+#include "LocklessAllocator.h"
 #include "Song.h"
 #include "lmms_math.h"
 
@@ -59,12 +67,16 @@ NotePlayHandle::NotePlayHandle( InstrumentTrack* instrumentTrack,
 	m_instrumentTrack( instrumentTrack ),
 	m_frames( 0 ),
 	m_totalFramesPlayed( 0 ),
+	m_framesThisPeriod( 0 ),
 	m_framesBeforeRelease( 0 ),
 	m_releaseFramesToDo( 0 ),
 	m_releaseFramesDone( 0 ),
 	m_subNotes(),
+	m_subNotesCreated( 0 ),
 	m_released( false ),
 	m_releaseStarted( false ),
+	m_stolen( false ),
+	m_stolenFadeFrames( 0 ),
 	m_hasMidiNote( false ),
 	m_hasParent( parent != nullptr  ),
 	m_parent( parent ),
@@ -94,6 +106,13 @@ NotePlayHandle::NotePlayHandle( InstrumentTrack* instrumentTrack,
 		parent->m_subNotes.push_back( this );
 		parent->m_hadChildren = true;
 
+		// sub-notes are created by whichever worker thread plays their
+		// parent, so they can't take the next order like the other handles;
+		// 12 bits for the sub-notes of a note and 12 for theirs
+		const auto shift = parent->hasParent() ? 0 : 12;
+		const auto index = std::uint64_t{parent->m_subNotesCreated++ % 0xfff + 1};
+		setOrder(parent->order() | (index << shift));
+
 		m_patternTrack = parent->m_patternTrack;
 
 		parent->setUsesBuffer( false );
@@ -112,6 +131,8 @@ NotePlayHandle::NotePlayHandle( InstrumentTrack* instrumentTrack,
 	if (m_instrumentTrack->instrument() && m_instrumentTrack->instrument()->isSingleStreamed())
 	{
 		setUsesBuffer( false );
+		// the instrument may have been suspended while idle
+		m_instrumentTrack->instrument()->wake();
 	}
 
 	setAudioBusHandle(instrumentTrack->audioBusHandle());
@@ -185,16 +206,38 @@ int NotePlayHandle::midiKey() const
 
 void NotePlayHandle::play( SampleFrame* _working_buffer )
 {
-	if (m_muted)
+	if( !beginPeriod() )
 	{
 		return;
 	}
 
+	// under some circumstances we're called even if there's nothing to play
+	// therefore do an additional check which fixes crash e.g. when
+	// decreasing release of an instrument-track while the note is active
+	if( framesLeft() > 0 )
+	{
+		// play note!
+		m_instrumentTrack->playNote( this, _working_buffer );
+	}
+
+	finishPeriod();
+}
+
+
+
+
+bool NotePlayHandle::beginPeriod()
+{
+	if (m_muted)
+	{
+		return false;
+	}
+
 	// if the note offset falls over to next period, then don't start playback yet
 	if( offset() >= Engine::audioEngine()->framesPerPeriod() )
 	{
 		setOffset( offset() - Engine::audioEngine()->framesPerPeriod() );
-		return;
+		return false;
 	}
 
 	lock();
@@ -211,7 +254,7 @@ void NotePlayHandle::play( SampleFrame* _working_buffer )
 		if (m_totalFramesPlayed == 0)
 		{
 			unlock();
-			return;
+			return false;
 		}
 	}
 
@@ -240,35 +283,34 @@ void NotePlayHandle::play( SampleFrame* _working_buffer )
 	}
 
 	// number of frames that can be played this period
-	f_cnt_t framesThisPeriod = m_totalFramesPlayed == 0
+	m_framesThisPeriod = m_totalFramesPlayed == 0
 		? Engine::audioEngine()->framesPerPeriod() - offset()
 		: Engine::audioEngine()->framesPerPeriod();
 
 	// check if we start release during this period
 	if( m_released == false &&
 		instrumentTrack()->isSustainPedalPressed() == false &&
-		m_totalFramesPlayed + framesThisPeriod > m_frames )
+		m_totalFramesPlayed + m_framesThisPeriod > m_frames )
 	{
 		noteOff( m_totalFramesPlayed == 0
 			? ( m_frames + offset() ) // if we have noteon and noteoff during the same period, take offset in account for release frame
 			: ( m_frames - m_totalFramesPlayed ) ); // otherwise, the offset is already negated and can be ignored
 	}
 
-	// under some circumstances we're called even if there's nothing to play
-	// therefore do an additional check which fixes crash e.g. when
-	// decreasing release of an instrument-track while the note is active
-	if( framesLeft() > 0 )
-	{
-		// play note!
-		m_instrumentTrack->playNote( this, _working_buffer );
-	}
+	return true;
+}
+
+
+
 
-	if( m_released && (!instrumentTrack()->isSustainPedalPressed() ||
+void NotePlayHandle::finishPeriod()
+{
+	if( m_released && (m_stolen || !instrumentTrack()->isSustainPedalPressed() ||
 		m_releaseStarted) )
 	{
 		m_releaseStarted = true;
 
-		f_cnt_t todo = framesThisPeriod;
+		f_cnt_t todo = m_framesThisPeriod;
 
 		// if this note is base-note for arpeggio, always set
 		// m_releaseFramesToDo to bigger value than m_releaseFramesDone
@@ -284,7 +326,7 @@ void NotePlayHandle::play( SampleFrame* _working_buffer )
 		{
 			// yes, then look whether these samples can be played
 			// within one audio-buffer
-			if( m_framesBeforeRelease <= framesThisPeriod )
+			if( m_framesBeforeRelease <= m_framesThisPeriod )
 			{
 				// yes, then we did less releaseFramesDone
 				todo -= m_framesBeforeRelease;
@@ -296,7 +338,7 @@ void NotePlayHandle::play( SampleFrame* _working_buffer )
 				// and wait for next loop... (we're not in
 				// release-phase yet)
 				todo = 0;
-				m_framesBeforeRelease -= framesThisPeriod;
+				m_framesBeforeRelease -= m_framesThisPeriod;
 			}
 		}
 		// look whether we're in release-phase
@@ -319,7 +361,7 @@ void NotePlayHandle::play( SampleFrame* _working_buffer )
 	}
 
 	// update internal data
-	m_totalFramesPlayed += framesThisPeriod;
+	m_totalFramesPlayed += m_framesThisPeriod;
 	unlock();
 }
 
@@ -328,7 +370,11 @@ void NotePlayHandle::play( SampleFrame* _working_buffer )
 
 f_cnt_t NotePlayHandle::framesLeft() const
 {
-	if( instrumentTrack()->isSustainPedalPressed() )
+	if( m_stolen )
+	{
+		return m_releaseFramesToDo - m_releaseFramesDone;
+	}
+	else if( instrumentTrack()->isSustainPedalPressed() )
 	{
 		return 4 * Engine::audioEngine()->framesPerPeriod();
 	}
@@ -411,6 +457,39 @@ void NotePlayHandle::noteOff( const f_cnt_t _s )
 
 
 
+void NotePlayHandle::steal()
+{
+	if( m_stolen )
+	{
+		return;
+	}
+
+	const bool wasReleased = m_released;
+	noteOff( 0 );
+
+	for( NotePlayHandle * n : m_subNotes )
+	{
+		n->lock();
+		n->steal();
+		n->unlock();
+	}
+
+	// fade out right away instead of playing the release, unless the
+	// remaining release is shorter anyway
+	if( !wasReleased || m_framesBeforeRelease > 0 ||
+		m_releaseFramesToDo - m_releaseFramesDone > StolenFadeFrames )
+	{
+		m_releaseFramesToDo = m_releaseFramesDone + StolenFadeFrames;
+	}
+	m_framesBeforeRelease = 0;
+	m_releaseStarted = true;
+	m_stolenFadeFrames = std::max<f_cnt_t>(1, m_releaseFramesToDo - m_releaseFramesDone);
+	m_stolen = true;
+}
+
+
+
+
 f_cnt_t NotePlayHandle::actualReleaseFramesToDo() const
 {
 	return m_instrumentTrack->m_soundShaping.releaseFrames();
@@ -602,25 +681,146 @@ void NotePlayHandle::resize( const bpm_t _new_tempo )
 }
 
 
-NotePlayHandle ** NotePlayHandleManager::s_available;
-QReadWriteLock NotePlayHandleManager::s_mutex;
-std::atomic_int NotePlayHandleManager::s_availableIndex;
-int NotePlayHandleManager::s_size;
+namespace
+{
 
+using NotePlayHandlePool = LocklessAllocatorT<NotePlayHandle>;
 
-void NotePlayHandleManager::init()
+//! Pools of note play handles, once added they are kept until NotePlayHandleManager::free()
+constexpr std::size_t MaxPools = 64;
+std::array<std::atomic<NotePlayHandlePool*>, MaxPools> s_pools;
+
+//! Voices are aligned to cache lines, so voices rendered by different threads don't share any
+constexpr std::size_t VoiceAlignment = 64;
+
+//! Voices reserved at load time, voice stealing releases the voices exceeding them
+std::atomic_int s_reservedVoices = 0;
+std::atomic_int s_capacity = 0;
+std::atomic_int s_voicesInUse = 0;
+std::atomic<NotePlayHandleManager::VoiceStealing> s_voiceStealing = NotePlayHandleManager::VoiceStealing::None;
+
+//! The voices are reduced to CpuLoadTarget percent when the CPU load reaches
+//! CpuLoadLimit percent of the period's time budget
+constexpr int CpuLoadLimit = 90;
+constexpr int CpuLoadTarget = 75;
+//! The CPU load is averaged over several periods, so voices are stolen again
+//! only after the ones stolen before have shown up in it
+constexpr int CpuLoadPeriods = 16;
+int s_periodsSinceCpuLimit = CpuLoadPeriods;
+
+//! Voices of the tracks with a voice limit, only used by the audio thread
+constexpr std::size_t TrackVoicesReserved = 64;
+std::vector<std::pair<const InstrumentTrack*, int>> s_trackVoices;
+
+//! Returns the pool @p index, adding one with @p voices voices if there's none yet
+NotePlayHandlePool* pool( std::size_t index, int voices )
+{
+	auto existing = s_pools[index].load(std::memory_order_acquire);
+	if (existing) { return existing; }
+
+	auto added = new NotePlayHandlePool(voices, VoiceAlignment);
+	if (s_pools[index].compare_exchange_strong(existing, added, std::memory_order_acq_rel))
+	{
+		s_capacity += static_cast<int>(added->capacity());
+		return added;
+	}
+
+	// added concurrently
+	delete added;
+	return existing;
+}
+
+//! Returns @p handle if it's a note voice stealing may release, nullptr otherwise
+NotePlayHandle* stealable( PlayHandle* handle )
+{
+	if (handle->type() != PlayHandle::Type::NotePlayHandle) { return nullptr; }
+
+	const auto nph = static_cast<NotePlayHandle*>(handle);
+	// master notes of chords and arpeggios don't play anything on their own
+	return nph->isReleased() || nph->isMasterNote() ? nullptr : nph;
+}
+
+//! Steals the note rated highest by @p voiceStealing among the ones @p canSteal returns true for
+template<class Predicate>
+bool stealVoice( const PlayHandleList& playHandles, NotePlayHandleManager::VoiceStealing voiceStealing,
+	Predicate canSteal )
+{
+	NotePlayHandle* victim = nullptr;
+	float victimRating = 0.f;
+	for (const auto handle : playHandles)
+	{
+		const auto nph = stealable(handle);
+		if (!nph || !canSteal(nph)) { continue; }
+
+		const float rating = voiceStealing == NotePlayHandleManager::VoiceStealing::Oldest
+			? static_cast<float>(nph->totalFramesPlayed())
+			: -nph->getVolume() * nph->volumeLevel(nph->totalFramesPlayed());
+		if (!victim || rating > victimRating)
+		{
+			victim = nph;
+			victimRating = rating;
+		}
+	}
+
+	if (!victim) { return false; }
+	victim->steal();
+	return true;
+}
+
+void limitTrackVoices( const PlayHandleList& playHandles, NotePlayHandleManager::VoiceStealing voiceStealing )
+{
+	s_trackVoices.clear();
+	for (const auto handle : playHandles)
+	{
+		const auto nph = stealable(handle);
+		if (!nph || nph->instrumentTrack()->maxVoices() == 0) { continue; }
+
+		const auto track = nph->instrumentTrack();
+		const auto it = std::find_if(s_trackVoices.begin(), s_trackVoices.end(),
+			[track](const auto& trackVoices) { return trackVoices.first == track; });
+		if (it != s_trackVoices.end()) { ++it->second; }
+		else { s_trackVoices.emplace_back(track, 1); }
+	}
+
+	for (const auto& trackVoices : s_trackVoices)
+	{
+		const auto track = trackVoices.first;
+		for (int voices = trackVoices.second; voices > track->maxVoices(); --voices)
+		{
+			stealVoice(playHandles, voiceStealing,
+				[track](const NotePlayHandle* nph) { return nph->instrumentTrack() == track; });
+		}
+	}
+}
+
+//! Steals voices before the CPU load makes the audio device run out of frames
+void limitCpuLoad( const PlayHandleList& playHandles, NotePlayHandleManager::VoiceStealing voiceStealing )
 {
-	s_available = new NotePlayHandle*[INITIAL_NPH_CACHE];
+	if (s_periodsSinceCpuLimit < CpuLoadPeriods)
+	{
+		++s_periodsSinceCpuLimit;
+		return;
+	}
 
-	auto n = static_cast<NotePlayHandle *>(std::malloc(sizeof(NotePlayHandle) * INITIAL_NPH_CACHE));
+	const int load = Engine::audioEngine()->cpuLoad();
+	if (load < CpuLoadLimit || Engine::getSong()->isExporting()) { return; }
 
-	for( int i=0; i < INITIAL_NPH_CACHE; ++i )
+	const auto voices = static_cast<int>(std::count_if(playHandles.begin(), playHandles.end(),
+		[](PlayHandle* handle) { return stealable(handle) != nullptr; }));
+	for (int excess = std::max(1, voices - voices * CpuLoadTarget / load); excess > 0; --excess)
 	{
-		s_available[ i ] = n;
-		++n;
+		if (!stealVoice(playHandles, voiceStealing, [](const NotePlayHandle*) { return true; })) { break; }
 	}
-	s_availableIndex = INITIAL_NPH_CACHE - 1;
-	s_size = INITIAL_NPH_CACHE;
+	s_periodsSinceCpuLimit = 0;
+}
+
+} // namespace
+
+
+void NotePlayHandleManager::init()
+{
+	reserve(INITIAL_NPH_CACHE);
+	s_trackVoices.reserve(TrackVoicesReserved);
 }
 
 
@@ -632,11 +832,18 @@ NotePlayHandle * NotePlayHandleManager::acquire( InstrumentTrack* instrumentTrac
 				int midiEventChannel,
 				NotePlayHandle::Origin origin )
 {
-	// TODO: use some lockless data structures
-	s_mutex.lockForWrite();
-	if (s_availableIndex < 0) { extend(NPH_CACHE_INCREMENT); }
-	NotePlayHandle * nph = s_available[s_availableIndex--];
-	s_mutex.unlock();
+	NotePlayHandle* nph = nullptr;
+	for (std::size_t i = 0; i < MaxPools && !nph; ++i)
+	{
+		// all pools so far are in use, which only allocates when the reserved voices don't suffice
+		nph = pool(i, NPH_CACHE_INCREMENT)->tryAlloc();
+	}
+	if (!nph)
+	{
+		// the last resort, release() tells it from the pooled ones
+		nph = static_cast<NotePlayHandle*>(::operator new(sizeof(NotePlayHandle), std::align_val_t{VoiceAlignment}));
+	}
+	++s_voicesInUse;
 
 	new( (void*)nph ) NotePlayHandle( instrumentTrack, offset, frames, noteToPlay, parent, midiEventChannel, origin );
 	return nph;
@@ -646,31 +853,88 @@ NotePlayHandle * NotePlayHandleManager::acquire( InstrumentTrack* instrumentTrac
 void NotePlayHandleManager::release( NotePlayHandle * nph )
 {
 	nph->NotePlayHandle::~NotePlayHandle();
-	s_mutex.lockForRead();
-	s_available[++s_availableIndex] = nph;
-	s_mutex.unlock();
+	--s_voicesInUse;
+
+	for (const auto& entry : s_pools)
+	{
+		const auto pool = entry.load(std::memory_order_acquire);
+		if (!pool) { break; }
+		if (pool->owns(nph))
+		{
+			pool->free(nph);
+			return;
+		}
+	}
+	::operator delete(nph, std::align_val_t{VoiceAlignment});
 }
 
 
-void NotePlayHandleManager::extend( int c )
+void NotePlayHandleManager::reserve( int voices )
 {
-	s_size += c;
-	auto tmp = new NotePlayHandle*[s_size];
-	delete[] s_available;
-	s_available = tmp;
+	for (std::size_t i = 0; i < MaxPools && s_capacity < voices; ++i)
+	{
+		if (!s_pools[i].load(std::memory_order_acquire)) { pool(i, voices - s_capacity); }
+	}
+	s_reservedVoices = std::max(s_reservedVoices.load(), voices);
+}
 
-	auto n = static_cast<NotePlayHandle *>(std::malloc(sizeof(NotePlayHandle) * c));
 
-	for( int i=0; i < c; ++i )
+std::size_t NotePlayHandleManager::memoryUsage()
+{
+	std::size_t memory = 0;
+	for (const auto& entry : s_pools)
 	{
-		s_available[++s_availableIndex] = n;
-		++n;
+		const auto pool = entry.load(std::memory_order_acquire);
+		if (!pool) { break; }
+		memory += pool->memoryUsage();
 	}
+	return memory;
 }
 
+
 void NotePlayHandleManager::free()
 {
-	delete[] s_available;
+	for (auto& entry : s_pools)
+	{
+		delete entry.exchange(nullptr);
+	}
+	s_capacity = 0;
+	s_reservedVoices = 0;
+}
+
+
+void NotePlayHandleManager::setVoiceStealing( VoiceStealing voiceStealing )
+{
+	s_voiceStealing = voiceStealing;
+}
+
+
+void NotePlayHandleManager::stealVoices( const PlayHandleList& playHandles )
+{
+	const auto voiceStealing = s_voiceStealing.load(std::memory_order_relaxed);
+
+	// the limits of the tracks apply even if voices aren't stolen otherwise
+	limitTrackVoices(playHandles, voiceStealing == VoiceStealing::None ? VoiceStealing::Oldest : voiceStealing);
+
+	if (voiceStealing == VoiceStealing::None) { return; }
+
+	// released notes are going to free their voices anyway
+	int excess = s_voicesInUse - s_reservedVoices;
+	for (const auto handle : playHandles)
+	{
+		if (excess <= 0) { break; }
+		if (handle->type() == PlayHandle::Type::NotePlayHandle && static_cast<NotePlayHandle*>(handle)->isReleased())
+		{
+			--excess;
+		}
+	}
+
+	for (; excess > 0; --excess)
+	{
+		if (!stealVoice(playHandles, voiceStealing, [](const NotePlayHandle*) { return true; })) { break; }
+	}
+
+	limitCpuLoad(playHandles, voiceStealing);
 }
 
 
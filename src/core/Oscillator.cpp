@@ -26,14 +26,18 @@
 #include "Oscillator.h"
 
 #include <algorithm>
-#if !defined(__MINGW32__) && !defined(__MINGW64__)
-	#include <thread>
-#endif
+#include <atomic>
+#include <mutex>
+#include <new>
 #include <numbers>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 #include "Engine.h"
 #include "AudioEngine.h"
 #include "AutomatableModel.h"
+#include "RealtimeMemory.h"
 #include "fftw3.h"
 #include "fft_helpers.h"
 
@@ -42,15 +46,40 @@ namespace lmms
 {
 
 
-void Oscillator::waveTableInit()
+namespace
 {
-	createFFTPlans();
-	generateWaveTables();
-	// The oscillator FFT plans remain throughout the application lifecycle
-	// due to being expensive to create, and being used whenever a userwave form is changed
-	// deleted in main.cpp main()
 
-}
+constexpr int SpectrumSize = OscillatorConstants::WAVETABLE_LENGTH * 2 + 1;
+
+//! Guards the FFT plans and their buffers
+std::mutex s_fftMutex;
+//! Guards generating the wavetables of the wave shapes
+std::mutex s_waveTableMutex;
+
+//! The wavetables are read by every oscillator, so they may use huge pages and are locked in RAM
+struct WaveformDeleter
+{
+	void operator()(OscillatorConstants::waveform_t* waveform) const
+	{
+		RealtimeMemory::unlock(waveform, sizeof(*waveform));
+		RealtimeMemory::deallocate(waveform, sizeof(*waveform));
+	}
+};
+using WaveformStorage = std::unique_ptr<OscillatorConstants::waveform_t, WaveformDeleter>;
+
+std::array<WaveformStorage, Oscillator::NumWaveShapeTables> s_waveTableStorage;
+
+struct UserWaveTable
+{
+	std::vector<float> wave;
+	std::weak_ptr<const OscillatorConstants::waveform_t> waveform;
+};
+
+//! Waveforms of the user waves in use by the hash of the wave, guarded by s_fftMutex
+std::unordered_multimap<std::size_t, UserWaveTable> s_userWaveTables;
+
+} // namespace
+
 
 Oscillator::Oscillator(const IntModel *wave_shape_model,
 			const IntModel *mod_algo_model,
@@ -72,6 +101,60 @@ Oscillator::Oscillator(const IntModel *wave_shape_model,
 	m_useWaveTable(false),
 	m_isModulator(false)
 {
+	// different seeds for every oscillator, so unison voices don't play the same noise
+	static auto s_noiseSeed = std::atomic<std::uint32_t>{0};
+	// oscillators of notes get created by the jobs rendering them, which only
+	// draw the same numbers in every render from the generator seeded for them
+	const bool deterministic = Engine::audioEngine() && Engine::audioEngine()->isDeterministic();
+	for (auto& state : m_noiseState)
+	{
+		// scramble the seeds, as xorshift generators take a while to recover from similar ones
+		auto seed = s_noiseSeed.fetch_add(0x9e3779b9, std::memory_order_relaxed);
+		if (deterministic)
+		{
+			seed = static_cast<std::uint32_t>(fastRand() << 16);
+			seed ^= static_cast<std::uint32_t>(fastRand());
+		}
+		seed = (seed ^ (seed >> 16)) * 0x85ebca6b;
+		seed = (seed ^ (seed >> 13)) * 0xc2b2ae35;
+		state = (seed ^ (seed >> 16)) | 1;
+	}
+}
+
+
+
+
+template<std::size_t Algo, Oscillator::WaveShape W>
+void Oscillator::updateKernel(SampleFrame* ab, const fpp_t frames, const ch_cnt_t chnl)
+{
+	if constexpr (Algo == NoSubOsc) { updateNoSub<W>(ab, frames, chnl); }
+	else
+	{
+		constexpr auto algo = static_cast<ModulationAlgo>(Algo);
+		if constexpr (algo == ModulationAlgo::PhaseModulation) { updatePM<W>(ab, frames, chnl); }
+		else if constexpr (algo == ModulationAlgo::AmplitudeModulation) { updateAM<W>(ab, frames, chnl); }
+		else if constexpr (algo == ModulationAlgo::SignalMix) { updateMix<W>(ab, frames, chnl); }
+		else if constexpr (algo == ModulationAlgo::SynchronizedBySubOsc) { updateSync<W>(ab, frames, chnl); }
+		else { updateFM<W>(ab, frames, chnl); }
+	}
+}
+
+
+
+
+template<std::size_t Algo, std::size_t... Shapes>
+constexpr auto Oscillator::kernelRow(std::index_sequence<Shapes...>) -> std::array<Kernel, NumWaveShapes>
+{
+	return {&Oscillator::updateKernel<Algo, static_cast<WaveShape>(Shapes)>...};
+}
+
+
+
+
+template<std::size_t... Algos>
+constexpr auto Oscillator::kernelTable(std::index_sequence<Algos...>) -> KernelTable
+{
+	return {kernelRow<Algos>(std::make_index_sequence<NumWaveShapes>{})...};
 }
 
 
@@ -88,34 +171,24 @@ void Oscillator::update(SampleFrame* ab, const fpp_t frames, const ch_cnt_t chnl
 	// The sampling functions will check this variable and avoid using band-limited
 	// wavetables, since they contain ringing that would lead to unexpected results.
 	m_isModulator = modulator;
-	if (m_subOsc != nullptr)
-	{
-		switch (static_cast<ModulationAlgo>(m_modulationAlgoModel->value()))
-		{
-			case ModulationAlgo::PhaseModulation:
-				updatePM(ab, frames, chnl);
-				break;
-			case ModulationAlgo::AmplitudeModulation:
-				updateAM(ab, frames, chnl);
-				break;
-			case ModulationAlgo::SignalMix:
-			default:
-				updateMix(ab, frames, chnl);
-				break;
-			case ModulationAlgo::SynchronizedBySubOsc:
-				updateSync(ab, frames, chnl);
-				break;
-			case ModulationAlgo::FrequencyModulation:
-				updateFM(ab, frames, chnl);
-		}
-	}
-	else
-	{
-		updateNoSub(ab, frames, chnl);
-	}
+	// the frequency doesn't change within a buffer, so the wavetable band is only looked up once
+	m_waveTableBand = waveTableBandFromFreq(
+		m_freq * m_detuning_div_samplerate * Engine::audioEngine()->outputSampleRate());
+
+	// the wave shape and modulation are only looked up here, the kernels render them without any branches
+	static constexpr auto s_kernels = kernelTable(std::make_index_sequence<NumModulationAlgos + 1>{});
+	auto algo = static_cast<std::size_t>(m_modulationAlgoModel->value());
+	if (algo >= NumModulationAlgos) { algo = static_cast<std::size_t>(ModulationAlgo::SignalMix); }
+	auto shape = static_cast<std::size_t>(m_waveShapeModel->value());
+	if (shape >= NumWaveShapes) { shape = static_cast<std::size_t>(WaveShape::Sine); }
+
+	const auto kernel = s_kernels[m_subOsc != nullptr ? algo : NoSubOsc][shape];
+	(this->*kernel)(ab, frames, chnl);
 }
 
 
+
+
 void Oscillator::generateSawWaveTable(int bands, sample_t* table, int firstBand)
 {
 	using namespace std::numbers;
@@ -188,45 +261,68 @@ void Oscillator::generateFromFFT(int bands, sample_t* table)
 	normalize(s_sampleBuffer.data(), table, OscillatorConstants::WAVETABLE_LENGTH, 2*OscillatorConstants::WAVETABLE_LENGTH + 1);
 }
 
-std::unique_ptr<OscillatorConstants::waveform_t> Oscillator::generateAntiAliasUserWaveTable(const SampleBuffer* sampleBuffer)
+// Expects the lock of the FFT buffers and the waveform converted to frequency domain in the spectrum buffer
+void Oscillator::generateFromFFT(OscillatorConstants::waveform_t& waveform)
 {
-	auto userAntiAliasWaveTable = std::make_unique<OscillatorConstants::waveform_t>();
+	// the inverse FFT overwrites the spectrum, so it is restored for every band
+	const auto spectrum = std::vector<float>(&s_specBuf[0][0], &s_specBuf[0][0] + SpectrumSize * 2);
 	for (int i = 0; i < OscillatorConstants::WAVE_TABLES_PER_WAVEFORM_COUNT; ++i)
 	{
-		// TODO: This loop seems to be doing the same thing for each iteration of the outer loop,
-		// and could probably be moved out of it
-		for (int j = 0; j < OscillatorConstants::WAVETABLE_LENGTH; ++j)
-		{
-			s_sampleBuffer[j] = Oscillator::userWaveSample(
-				sampleBuffer, static_cast<float>(j) / OscillatorConstants::WAVETABLE_LENGTH);
-		}
-		fftwf_execute(s_fftPlan);
-		Oscillator::generateFromFFT(OscillatorConstants::MAX_FREQ / freqFromWaveTableBand(i), (*userAntiAliasWaveTable)[i].data());
+		std::copy(spectrum.begin(), spectrum.end(), &s_specBuf[0][0]);
+		generateFromFFT(OscillatorConstants::MAX_FREQ / freqFromWaveTableBand(i), waveform[i].data());
 	}
+}
+
+std::shared_ptr<const OscillatorConstants::waveform_t> Oscillator::generateAntiAliasUserWaveTable(
+	const SampleBuffer* sampleBuffer)
+{
+	auto wave = std::vector<float>(OscillatorConstants::WAVETABLE_LENGTH);
+	for (int j = 0; j < OscillatorConstants::WAVETABLE_LENGTH; ++j)
+	{
+		wave[j] = Oscillator::userWaveSample(sampleBuffer, static_cast<float>(j) / OscillatorConstants::WAVETABLE_LENGTH);
+	}
+	const auto hash = std::hash<std::string_view>{}(
+		std::string_view{reinterpret_cast<const char*>(wave.data()), wave.size() * sizeof(float)});
+
+	const auto lock = std::lock_guard{s_fftMutex};
+	std::erase_if(s_userWaveTables, [](const auto& entry) { return entry.second.waveform.expired(); });
+
+	// e.g. several instances loading the same preset
+	const auto [first, last] = s_userWaveTables.equal_range(hash);
+	for (auto it = first; it != last; ++it)
+	{
+		if (it->second.wave != wave) { continue; }
+		if (auto waveform = it->second.waveform.lock()) { return waveform; }
+	}
+
+	if (!s_specBuf) { createFFTPlans(); }
+	std::copy(wave.begin(), wave.end(), s_sampleBuffer.begin());
+	fftwf_execute(s_fftPlan);
 
-	return userAntiAliasWaveTable;
+	auto waveform = std::make_shared<OscillatorConstants::waveform_t>();
+	generateFromFFT(*waveform);
+	s_userWaveTables.emplace(hash, UserWaveTable{std::move(wave), waveform});
+	return waveform;
 }
 
 
 
-sample_t Oscillator::s_waveTables
-	[Oscillator::NumWaveShapeTables]
-	[OscillatorConstants::WAVE_TABLES_PER_WAVEFORM_COUNT]
-	[OscillatorConstants::WAVETABLE_LENGTH];
+std::array<std::atomic<const OscillatorConstants::waveform_t*>, Oscillator::NumWaveShapeTables> Oscillator::s_waveTables;
 fftwf_plan Oscillator::s_fftPlan;
 fftwf_plan Oscillator::s_ifftPlan;
-fftwf_complex * Oscillator::s_specBuf;
+fftwf_complex * Oscillator::s_specBuf = nullptr;
 std::array<float, OscillatorConstants::WAVETABLE_LENGTH> Oscillator::s_sampleBuffer;
 
 
 
+// Expects the lock of the FFT buffers
 void Oscillator::createFFTPlans()
 {
-	Oscillator::s_specBuf = ( fftwf_complex * ) fftwf_malloc( ( OscillatorConstants::WAVETABLE_LENGTH * 2 + 1 ) * sizeof( fftwf_complex ) );
+	Oscillator::s_specBuf = ( fftwf_complex * ) fftwf_malloc( SpectrumSize * sizeof( fftwf_complex ) );
 	Oscillator::s_fftPlan = fftwf_plan_dft_r2c_1d(OscillatorConstants::WAVETABLE_LENGTH, s_sampleBuffer.data(), s_specBuf, FFTW_MEASURE );
 	Oscillator::s_ifftPlan = fftwf_plan_dft_c2r_1d(OscillatorConstants::WAVETABLE_LENGTH, s_specBuf, s_sampleBuffer.data(), FFTW_MEASURE);
 	// initialize s_specBuf content to zero, since the values are used in a condition inside generateFromFFT()
-	for (int i = 0; i < OscillatorConstants::WAVETABLE_LENGTH * 2 + 1; i++)
+	for (int i = 0; i < SpectrumSize; i++)
 	{
 		s_specBuf[i][0] = 0.0f;
 		s_specBuf[i][1] = 0.0f;
@@ -235,304 +331,115 @@ void Oscillator::createFFTPlans()
 
 void Oscillator::destroyFFTPlans()
 {
+	const auto lock = std::lock_guard{s_fftMutex};
+	if (!s_specBuf) { return; }
+
 	fftwf_destroy_plan(s_fftPlan);
 	fftwf_destroy_plan(s_ifftPlan);
 	fftwf_free(s_specBuf);
+	s_specBuf = nullptr;
+}
+
+void Oscillator::prepareWaveTable(WaveShape shape)
+{
+	const auto index = static_cast<std::size_t>(shape);
+	if (index >= FirstWaveShapeTable && index < FirstWaveShapeTable + NumWaveShapeTables)
+	{
+		generateWaveTable(shape);
+	}
 }
 
-void Oscillator::generateWaveTables()
+std::size_t Oscillator::waveTableMemoryUsage()
 {
+	auto memory = std::size_t{0};
+	{
+		const auto lock = std::lock_guard{s_waveTableMutex};
+		for (const auto& waveform : s_waveTableStorage)
+		{
+			if (waveform) { memory += sizeof(OscillatorConstants::waveform_t); }
+		}
+	}
+
+	const auto lock = std::lock_guard{s_fftMutex};
+	for (const auto& [hash, table] : s_userWaveTables)
+	{
+		if (table.waveform.expired()) { continue; }
+		memory += sizeof(OscillatorConstants::waveform_t) + table.wave.capacity() * sizeof(float);
+	}
+	return memory;
+}
+
+const OscillatorConstants::waveform_t& Oscillator::generateWaveTable(WaveShape shape)
+{
+	const auto shapeID = static_cast<std::size_t>(shape) - FirstWaveShapeTable;
+
+	const auto lock = std::lock_guard{s_waveTableMutex};
+	if (const auto waveform = s_waveTables[shapeID].load(std::memory_order_acquire)) { return *waveform; }
+
+	auto waveform = WaveformStorage{
+		new (RealtimeMemory::allocate(sizeof(OscillatorConstants::waveform_t))) OscillatorConstants::waveform_t{}};
+
 	// Generate tables for simple shaped (constructed by summing sine waves).
 	// Start from the table that contains the least number of bands, and re-use each table in the following
 	// iteration, adding more bands in each step and avoiding repeated computation of earlier bands.
 	using generator_t = void (*)(int, sample_t*, int);
-	auto simpleGen = [](WaveShape shape, generator_t generator)
+	auto simpleGen = [&waveform](generator_t generator)
 	{
-		const int shapeID = static_cast<std::size_t>(shape) - FirstWaveShapeTable;
 		int lastBands = 0;
-
-		// Clear the first wave table
-		std::fill(
-		    std::begin(s_waveTables[shapeID][OscillatorConstants::WAVE_TABLES_PER_WAVEFORM_COUNT - 1]),
-		    std::end(s_waveTables[shapeID][OscillatorConstants::WAVE_TABLES_PER_WAVEFORM_COUNT - 1]),
-		    0.f);
-
 		for (int i = OscillatorConstants::WAVE_TABLES_PER_WAVEFORM_COUNT - 1; i >= 0; i--)
 		{
 			const int bands = OscillatorConstants::MAX_FREQ / freqFromWaveTableBand(i);
-			generator(bands, s_waveTables[shapeID][i], lastBands + 1);
+			generator(bands, (*waveform)[i].data(), lastBands + 1);
 			lastBands = bands;
 			if (i)
 			{
-				std::copy(
-					s_waveTables[shapeID][i],
-					s_waveTables[shapeID][i] + OscillatorConstants::WAVETABLE_LENGTH,
-					s_waveTables[shapeID][i - 1]);
+				(*waveform)[i - 1] = (*waveform)[i];
 			}
 		}
 	};
 
 	// FFT-based wave shapes: make standard wave table without band limit, convert to frequency domain, remove bands
 	// above maximum frequency and convert back to time domain.
-	auto fftGen = []()
+	using sample_function_t = sample_t (*)(float);
+	auto fftGen = [&waveform](sample_function_t sampleFunction)
 	{
-		// Generate moogSaw tables
-		for (int i = 0; i < OscillatorConstants::WAVE_TABLES_PER_WAVEFORM_COUNT; ++i)
-		{
-			for (int i = 0; i < OscillatorConstants::WAVETABLE_LENGTH; ++i)
-			{
-				Oscillator::s_sampleBuffer[i] = moogSawSample((float)i / (float)OscillatorConstants::WAVETABLE_LENGTH);
-			}
-			fftwf_execute(s_fftPlan);
-			generateFromFFT(OscillatorConstants::MAX_FREQ / freqFromWaveTableBand(i), s_waveTables[static_cast<std::size_t>(WaveShape::MoogSaw) - FirstWaveShapeTable][i]);
-		}
+		const auto fftLock = std::lock_guard{s_fftMutex};
+		if (!s_specBuf) { createFFTPlans(); }
 
-		// Generate exponential tables
-		for (int i = 0; i < OscillatorConstants::WAVE_TABLES_PER_WAVEFORM_COUNT; ++i)
+		for (int i = 0; i < OscillatorConstants::WAVETABLE_LENGTH; ++i)
 		{
-			for (int i = 0; i < OscillatorConstants::WAVETABLE_LENGTH; ++i)
-			{
-				s_sampleBuffer[i] = expSample((float)i / (float)OscillatorConstants::WAVETABLE_LENGTH);
-			}
-			fftwf_execute(s_fftPlan);
-			generateFromFFT(OscillatorConstants::MAX_FREQ / freqFromWaveTableBand(i), s_waveTables[static_cast<std::size_t>(WaveShape::Exponential) - FirstWaveShapeTable][i]);
+			s_sampleBuffer[i] = sampleFunction((float)i / (float)OscillatorConstants::WAVETABLE_LENGTH);
 		}
+		fftwf_execute(s_fftPlan);
+		generateFromFFT(*waveform);
 	};
 
-// TODO: Mingw compilers currently do not support std::thread. There are some 3rd-party workarounds available,
-// but since threading is not essential in this case, it is easier and more reliable to simply generate
-// the wavetables serially. Remove the the check and #else branch once std::thread is well supported.
-#if !defined(__MINGW32__) && !defined(__MINGW64__)
-	std::thread sawThread(simpleGen, WaveShape::Saw, generateSawWaveTable);
-	std::thread squareThread(simpleGen, WaveShape::Square, generateSquareWaveTable);
-	std::thread triangleThread(simpleGen, WaveShape::Triangle, generateTriangleWaveTable);
-	std::thread fftThread(fftGen);
-	sawThread.join();
-	squareThread.join();
-	triangleThread.join();
-	fftThread.join();
-#else
-	simpleGen(WaveShape::Saw, generateSawWaveTable);
-	simpleGen(WaveShape::Square, generateSquareWaveTable);
-	simpleGen(WaveShape::Triangle, generateTriangleWaveTable);
-	fftGen();
-#endif
-}
-
-
-
-
-void Oscillator::updateNoSub( SampleFrame* _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl )
-{
-	switch( static_cast<WaveShape>(m_waveShapeModel->value()) )
+	switch (shape)
 	{
-		case WaveShape::Sine:
-		default:
-			updateNoSub<WaveShape::Sine>( _ab, _frames, _chnl );
-			break;
 		case WaveShape::Triangle:
-			updateNoSub<WaveShape::Triangle>( _ab, _frames, _chnl );
+			simpleGen(generateTriangleWaveTable);
 			break;
 		case WaveShape::Saw:
-			updateNoSub<WaveShape::Saw>( _ab, _frames, _chnl );
+			simpleGen(generateSawWaveTable);
 			break;
 		case WaveShape::Square:
-			updateNoSub<WaveShape::Square>( _ab, _frames, _chnl );
+			simpleGen(generateSquareWaveTable);
 			break;
 		case WaveShape::MoogSaw:
-			updateNoSub<WaveShape::MoogSaw>( _ab, _frames, _chnl );
+			fftGen(moogSawSample);
 			break;
 		case WaveShape::Exponential:
-			updateNoSub<WaveShape::Exponential>( _ab, _frames, _chnl );
-			break;
-		case WaveShape::WhiteNoise:
-			updateNoSub<WaveShape::WhiteNoise>( _ab, _frames, _chnl );
+			fftGen(expSample);
 			break;
-		case WaveShape::UserDefined:
-			updateNoSub<WaveShape::UserDefined>( _ab, _frames, _chnl );
-			break;
-	}
-}
-
-
-
-
-void Oscillator::updatePM( SampleFrame* _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl )
-{
-	switch( static_cast<WaveShape>(m_waveShapeModel->value()) )
-	{
-		case WaveShape::Sine:
 		default:
-			updatePM<WaveShape::Sine>( _ab, _frames, _chnl );
-			break;
-		case WaveShape::Triangle:
-			updatePM<WaveShape::Triangle>( _ab, _frames, _chnl );
-			break;
-		case WaveShape::Saw:
-			updatePM<WaveShape::Saw>( _ab, _frames, _chnl );
-			break;
-		case WaveShape::Square:
-			updatePM<WaveShape::Square>( _ab, _frames, _chnl );
-			break;
-		case WaveShape::MoogSaw:
-			updatePM<WaveShape::MoogSaw>( _ab, _frames, _chnl );
-			break;
-		case WaveShape::Exponential:
-			updatePM<WaveShape::Exponential>( _ab, _frames, _chnl );
-			break;
-		case WaveShape::WhiteNoise:
-			updatePM<WaveShape::WhiteNoise>( _ab, _frames, _chnl );
-			break;
-		case WaveShape::UserDefined:
-			updatePM<WaveShape::UserDefined>( _ab, _frames, _chnl );
+			assert(false && "wave shape without wavetables");
 			break;
 	}
-}
-
 
-
-
-void Oscillator::updateAM( SampleFrame* _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl )
-{
-	switch( static_cast<WaveShape>(m_waveShapeModel->value()) )
-	{
-		case WaveShape::Sine:
-		default:
-			updateAM<WaveShape::Sine>( _ab, _frames, _chnl );
-			break;
-		case WaveShape::Triangle:
-			updateAM<WaveShape::Triangle>( _ab, _frames, _chnl );
-			break;
-		case WaveShape::Saw:
-			updateAM<WaveShape::Saw>( _ab, _frames, _chnl );
-			break;
-		case WaveShape::Square:
-			updateAM<WaveShape::Square>( _ab, _frames, _chnl );
-			break;
-		case WaveShape::MoogSaw:
-			updateAM<WaveShape::MoogSaw>( _ab, _frames, _chnl );
-			break;
-		case WaveShape::Exponential:
-			updateAM<WaveShape::Exponential>( _ab, _frames, _chnl );
-			break;
-		case WaveShape::WhiteNoise:
-			updateAM<WaveShape::WhiteNoise>( _ab, _frames, _chnl );
-			break;
-		case WaveShape::UserDefined:
-			updateAM<WaveShape::UserDefined>( _ab, _frames, _chnl );
-			break;
-	}
-}
-
-
-
-
-void Oscillator::updateMix( SampleFrame* _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl )
-{
-	switch( static_cast<WaveShape>(m_waveShapeModel->value()) )
-	{
-		case WaveShape::Sine:
-		default:
-			updateMix<WaveShape::Sine>( _ab, _frames, _chnl );
-			break;
-		case WaveShape::Triangle:
-			updateMix<WaveShape::Triangle>( _ab, _frames, _chnl );
-			break;
-		case WaveShape::Saw:
-			updateMix<WaveShape::Saw>( _ab, _frames, _chnl );
-			break;
-		case WaveShape::Square:
-			updateMix<WaveShape::Square>( _ab, _frames, _chnl );
-			break;
-		case WaveShape::MoogSaw:
-			updateMix<WaveShape::MoogSaw>( _ab, _frames, _chnl );
-			break;
-		case WaveShape::Exponential:
-			updateMix<WaveShape::Exponential>( _ab, _frames, _chnl );
-			break;
-		case WaveShape::WhiteNoise:
-			updateMix<WaveShape::WhiteNoise>( _ab, _frames, _chnl );
-			break;
-		case WaveShape::UserDefined:
-			updateMix<WaveShape::UserDefined>( _ab, _frames, _chnl );
-			break;
-	}
-}
-
-
-
-
-void Oscillator::updateSync( SampleFrame* _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl )
-{
-	switch( static_cast<WaveShape>(m_waveShapeModel->value()) )
-	{
-		case WaveShape::Sine:
-		default:
-			updateSync<WaveShape::Sine>( _ab, _frames, _chnl );
-			break;
-		case WaveShape::Triangle:
-			updateSync<WaveShape::Triangle>( _ab, _frames, _chnl );
-			break;
-		case WaveShape::Saw:
-			updateSync<WaveShape::Saw>( _ab, _frames, _chnl );
-			break;
-		case WaveShape::Square:
-			updateSync<WaveShape::Square>( _ab, _frames, _chnl );
-			break;
-		case WaveShape::MoogSaw:
-			updateSync<WaveShape::MoogSaw>( _ab, _frames, _chnl );
-			break;
-		case WaveShape::Exponential:
-			updateSync<WaveShape::Exponential>( _ab, _frames, _chnl );
-			break;
-		case WaveShape::WhiteNoise:
-			updateSync<WaveShape::WhiteNoise>( _ab, _frames, _chnl );
-			break;
-		case WaveShape::UserDefined:
-			updateSync<WaveShape::UserDefined>( _ab, _frames, _chnl );
-			break;
-	}
-}
-
-
-
-
-void Oscillator::updateFM( SampleFrame* _ab, const fpp_t _frames,
-							const ch_cnt_t _chnl )
-{
-	switch( static_cast<WaveShape>(m_waveShapeModel->value()) )
-	{
-		case WaveShape::Sine:
-		default:
-			updateFM<WaveShape::Sine>( _ab, _frames, _chnl );
-			break;
-		case WaveShape::Triangle:
-			updateFM<WaveShape::Triangle>( _ab, _frames, _chnl );
-			break;
-		case WaveShape::Saw:
-			updateFM<WaveShape::Saw>( _ab, _frames, _chnl );
-			break;
-		case WaveShape::Square:
-			updateFM<WaveShape::Square>( _ab, _frames, _chnl );
-			break;
-		case WaveShape::MoogSaw:
-			updateFM<WaveShape::MoogSaw>( _ab, _frames, _chnl );
-			break;
-		case WaveShape::Exponential:
-			updateFM<WaveShape::Exponential>( _ab, _frames, _chnl );
-			break;
-		case WaveShape::WhiteNoise:
-			updateFM<WaveShape::WhiteNoise>( _ab, _frames, _chnl );
-			break;
-		case WaveShape::UserDefined:
-			updateFM<WaveShape::UserDefined>( _ab, _frames, _chnl );
-			break;
-	}
+	RealtimeMemory::lock(waveform.get(), sizeof(OscillatorConstants::waveform_t));
+	s_waveTableStorage[shapeID] = std::move(waveform);
+	s_waveTables[shapeID].store(s_waveTableStorage[shapeID].get(), std::memory_order_release);
+	return *s_waveTableStorage[shapeID];
 }
 
 
@@ -578,6 +485,34 @@ float Oscillator::syncInit( SampleFrame* _ab, const fpp_t _frames,
 
 
 
+// renders the samples in blocks: the phases of a block are computed first, like
+// that the samples can be evaluated in a loop without any branches
+template<Oscillator::WaveShape W, typename PhaseFn, typename WriteFn>
+void Oscillator::render(SampleFrame* ab, const fpp_t frames, const ch_cnt_t chnl, PhaseFn nextPhase, WriteFn write)
+{
+	std::array<float, BlockFrames> phases;
+	std::array<sample_t, BlockFrames> samples;
+
+	for (fpp_t block = 0; block < frames; block += BlockFrames)
+	{
+		const fpp_t count = std::min<fpp_t>(BlockFrames, frames - block);
+		for (fpp_t i = 0; i < count; ++i)
+		{
+			phases[i] = nextPhase(block + i);
+		}
+
+		getSamples<W>(phases.data(), samples.data(), count);
+
+		for (fpp_t i = 0; i < count; ++i)
+		{
+			write(ab[block + i][chnl], samples[i]);
+		}
+	}
+}
+
+
+
+
 // if we have no sub-osc, we can't do any modulation... just get our samples
 template<Oscillator::WaveShape W>
 void Oscillator::updateNoSub( SampleFrame* _ab, const fpp_t _frames,
@@ -585,12 +520,12 @@ void Oscillator::updateNoSub( SampleFrame* _ab, const fpp_t _frames,
 {
 	recalcPhase();
 	const float osc_coeff = m_freq * m_detuning_div_samplerate;
+	// a copy, the samples written could alias the referenced volume otherwise
+	const float volume = m_volume;
 
-	for( fpp_t frame = 0; frame < _frames; ++frame )
-	{
-		_ab[frame][_chnl] = getSample<W>( m_phase ) * m_volume;
-		m_phase += osc_coeff;
-	}
+	render<W>(_ab, _frames, _chnl,
+		[&](fpp_t) { const float phase = m_phase; m_phase += osc_coeff; return phase; },
+		[&](sample_t& out, sample_t sample) { out = sample * volume; });
 }
 
 
@@ -604,14 +539,11 @@ void Oscillator::updatePM( SampleFrame* _ab, const fpp_t _frames,
 	m_subOsc->update( _ab, _frames, _chnl, true );
 	recalcPhase();
 	const float osc_coeff = m_freq * m_detuning_div_samplerate;
+	const float volume = m_volume;
 
-	for( fpp_t frame = 0; frame < _frames; ++frame )
-	{
-		_ab[frame][_chnl] = getSample<W>( m_phase +
-					_ab[frame][_chnl] )
-							* m_volume;
-		m_phase += osc_coeff;
-	}
+	render<W>(_ab, _frames, _chnl,
+		[&](fpp_t frame) { const float phase = m_phase + _ab[frame][_chnl]; m_phase += osc_coeff; return phase; },
+		[&](sample_t& out, sample_t sample) { out = sample * volume; });
 }
 
 
@@ -625,12 +557,11 @@ void Oscillator::updateAM( SampleFrame* _ab, const fpp_t _frames,
 	m_subOsc->update( _ab, _frames, _chnl, false );
 	recalcPhase();
 	const float osc_coeff = m_freq * m_detuning_div_samplerate;
+	const float volume = m_volume;
 
-	for( fpp_t frame = 0; frame < _frames; ++frame )
-	{
-		_ab[frame][_chnl] *= getSample<W>( m_phase ) * m_volume;
-		m_phase += osc_coeff;
-	}
+	render<W>(_ab, _frames, _chnl,
+		[&](fpp_t) { const float phase = m_phase; m_phase += osc_coeff; return phase; },
+		[&](sample_t& out, sample_t sample) { out *= sample * volume; });
 }
 
 
@@ -644,12 +575,11 @@ void Oscillator::updateMix( SampleFrame* _ab, const fpp_t _frames,
 	m_subOsc->update( _ab, _frames, _chnl, false );
 	recalcPhase();
 	const float osc_coeff = m_freq * m_detuning_div_samplerate;
+	const float volume = m_volume;
 
-	for( fpp_t frame = 0; frame < _frames; ++frame )
-	{
-		_ab[frame][_chnl] += getSample<W>( m_phase ) * m_volume;
-		m_phase += osc_coeff;
-	}
+	render<W>(_ab, _frames, _chnl,
+		[&](fpp_t) { const float phase = m_phase; m_phase += osc_coeff; return phase; },
+		[&](sample_t& out, sample_t sample) { out += sample * volume; });
 }
 
 
@@ -664,16 +594,20 @@ void Oscillator::updateSync( SampleFrame* _ab, const fpp_t _frames,
 	const float sub_osc_coeff = m_subOsc->syncInit( _ab, _frames, _chnl );
 	recalcPhase();
 	const float osc_coeff = m_freq * m_detuning_div_samplerate;
+	const float volume = m_volume;
 
-	for( fpp_t frame = 0; frame < _frames ; ++frame )
-	{
-		if( m_subOsc->syncOk( sub_osc_coeff ) )
+	render<W>(_ab, _frames, _chnl,
+		[&](fpp_t)
 		{
-			m_phase = m_phaseOffset;
-		}
-		_ab[frame][_chnl] = getSample<W>( m_phase ) * m_volume;
-		m_phase += osc_coeff;
-	}
+			if( m_subOsc->syncOk( sub_osc_coeff ) )
+			{
+				m_phase = m_phaseOffset;
+			}
+			const float phase = m_phase;
+			m_phase += osc_coeff;
+			return phase;
+		},
+		[&](sample_t& out, sample_t sample) { out = sample * volume; });
 }
 
 
@@ -687,13 +621,51 @@ void Oscillator::updateFM( SampleFrame* _ab, const fpp_t _frames,
 	m_subOsc->update( _ab, _frames, _chnl, true );
 	recalcPhase();
 	const float osc_coeff = m_freq * m_detuning_div_samplerate;
+	const float volume = m_volume;
 	const float sampleRateCorrection = 44100.0f / Engine::audioEngine()->outputSampleRate();
 
-	for( fpp_t frame = 0; frame < _frames; ++frame )
+	render<W>(_ab, _frames, _chnl,
+		[&](fpp_t frame)
+		{
+			m_phase += _ab[frame][_chnl] * sampleRateCorrection;
+			const float phase = m_phase;
+			m_phase += osc_coeff;
+			return phase;
+		},
+		[&](sample_t& out, sample_t sample) { out = sample * volume; });
+}
+
+
+
+
+void Oscillator::wtSamples(const sample_t* table, const float* phases, sample_t* samples, const fpp_t count) const
+{
+	for (fpp_t i = 0; i < count; ++i)
+	{
+		const float frame = absFraction(phases[i]) * OscillatorConstants::WAVETABLE_LENGTH;
+		const auto f1 = static_cast<f_cnt_t>(frame);
+		const auto f2 = f1 < OscillatorConstants::WAVETABLE_LENGTH - 1 ? f1 + 1 : 0;
+		samples[i] = std::lerp(table[f1], table[f2], fraction(frame));
+	}
+}
+
+
+
+
+void Oscillator::noiseSamples(sample_t* samples, const fpp_t count)
+{
+	// xorshift generators, interleaved so the compiler can run the lanes in parallel
+	fpp_t i = 0;
+	for (; i + static_cast<fpp_t>(NoiseLanes) <= count; i += NoiseLanes)
+	{
+		for (std::size_t lane = 0; lane < NoiseLanes; ++lane)
+		{
+			samples[i + lane] = nextNoise(m_noiseState[lane]);
+		}
+	}
+	for (std::size_t lane = 0; i < count; ++i, ++lane)
 	{
-		m_phase += _ab[frame][_chnl] * sampleRateCorrection;
-		_ab[frame][_chnl] = getSample<W>( m_phase ) * m_volume;
-		m_phase += osc_coeff;
+		samples[i] = nextNoise(m_noiseState[lane]);
 	}
 }
 
@@ -701,17 +673,18 @@ void Oscillator::updateFM( SampleFrame* _ab, const fpp_t _frames,
 
 
 template<>
-inline sample_t Oscillator::getSample<Oscillator::WaveShape::Sine>(const float sample)
+inline void Oscillator::getSamples<Oscillator::WaveShape::Sine>(const float* phases, sample_t* samples,
+	const fpp_t count)
 {
 	const float current_freq = m_freq * m_detuning_div_samplerate * Engine::audioEngine()->outputSampleRate();
 
 	if (!m_useWaveTable || current_freq < OscillatorConstants::MAX_FREQ)
 	{
-		return sinSample(sample);
+		for (fpp_t i = 0; i < count; ++i) { samples[i] = sinSample(phases[i]); }
 	}
 	else
 	{
-		return 0;
+		std::fill(samples, samples + count, 0.f);
 	}
 }
 
@@ -719,16 +692,16 @@ inline sample_t Oscillator::getSample<Oscillator::WaveShape::Sine>(const float s
 
 
 template<>
-inline sample_t Oscillator::getSample<Oscillator::WaveShape::Triangle>(
-		const float _sample )
+inline void Oscillator::getSamples<Oscillator::WaveShape::Triangle>(const float* phases, sample_t* samples,
+	const fpp_t count)
 {
 	if (m_useWaveTable && !m_isModulator)
 	{
-		return wtSample(s_waveTables[static_cast<std::size_t>(WaveShape::Triangle) - FirstWaveShapeTable],_sample);
+		wtSamples(waveTable(WaveShape::Triangle), phases, samples, count);
 	}
 	else
 	{
-		return triangleSample(_sample);
+		for (fpp_t i = 0; i < count; ++i) { samples[i] = triangleSample(phases[i]); }
 	}
 }
 
@@ -736,16 +709,16 @@ inline sample_t Oscillator::getSample<Oscillator::WaveShape::Triangle>(
 
 
 template<>
-inline sample_t Oscillator::getSample<Oscillator::WaveShape::Saw>(
-		const float _sample )
+inline void Oscillator::getSamples<Oscillator::WaveShape::Saw>(const float* phases, sample_t* samples,
+	const fpp_t count)
 {
 	if (m_useWaveTable && !m_isModulator)
 	{
-		return wtSample(s_waveTables[static_cast<std::size_t>(WaveShape::Saw) - FirstWaveShapeTable], _sample);
+		wtSamples(waveTable(WaveShape::Saw), phases, samples, count);
 	}
 	else
 	{
-		return sawSample(_sample);
+		for (fpp_t i = 0; i < count; ++i) { samples[i] = sawSample(phases[i]); }
 	}
 }
 
@@ -753,16 +726,16 @@ inline sample_t Oscillator::getSample<Oscillator::WaveShape::Saw>(
 
 
 template<>
-inline sample_t Oscillator::getSample<Oscillator::WaveShape::Square>(
-		const float _sample )
+inline void Oscillator::getSamples<Oscillator::WaveShape::Square>(const float* phases, sample_t* samples,
+	const fpp_t count)
 {
 	if (m_useWaveTable && !m_isModulator)
 	{
-		return wtSample(s_waveTables[static_cast<std::size_t>(WaveShape::Square) - FirstWaveShapeTable], _sample);
+		wtSamples(waveTable(WaveShape::Square), phases, samples, count);
 	}
 	else
 	{
-		return squareSample(_sample);
+		for (fpp_t i = 0; i < count; ++i) { samples[i] = squareSample(phases[i]); }
 	}
 }
 
@@ -770,16 +743,16 @@ inline sample_t Oscillator::getSample<Oscillator::WaveShape::Square>(
 
 
 template<>
-inline sample_t Oscillator::getSample<Oscillator::WaveShape::MoogSaw>(
-							const float _sample )
+inline void Oscillator::getSamples<Oscillator::WaveShape::MoogSaw>(const float* phases, sample_t* samples,
+	const fpp_t count)
 {
 	if (m_useWaveTable && !m_isModulator)
 	{
-		return wtSample(s_waveTables[static_cast<std::size_t>(WaveShape::MoogSaw) - FirstWaveShapeTable], _sample);
+		wtSamples(waveTable(WaveShape::MoogSaw), phases, samples, count);
 	}
 	else
 	{
-		return moogSawSample(_sample);
+		for (fpp_t i = 0; i < count; ++i) { samples[i] = moogSawSample(phases[i]); }
 	}
 }
 
@@ -787,16 +760,16 @@ inline sample_t Oscillator::getSample<Oscillator::WaveShape::MoogSaw>(
 
 
 template<>
-inline sample_t Oscillator::getSample<Oscillator::WaveShape::Exponential>(
-							const float _sample )
+inline void Oscillator::getSamples<Oscillator::WaveShape::Exponential>(const float* phases, sample_t* samples,
+	const fpp_t count)
 {
 	if (m_useWaveTable && !m_isModulator)
 	{
-		return wtSample(s_waveTables[static_cast<std::size_t>(WaveShape::Exponential) - FirstWaveShapeTable], _sample);
+		wtSamples(waveTable(WaveShape::Exponential), phases, samples, count);
 	}
 	else
 	{
-		return expSample(_sample);
+		for (fpp_t i = 0; i < count; ++i) { samples[i] = expSample(phases[i]); }
 	}
 }
 
@@ -804,26 +777,27 @@ inline sample_t Oscillator::getSample<Oscillator::WaveShape::Exponential>(
 
 
 template<>
-inline sample_t Oscillator::getSample<Oscillator::WaveShape::WhiteNoise>(
-							const float _sample )
+inline void Oscillator::getSamples<Oscillator::WaveShape::WhiteNoise>(const float*, sample_t* samples,
+	const fpp_t count)
 {
-	return( noiseSample( _sample ) );
+	noiseSamples(samples, count);
 }
 
 
 
 
 template<>
-inline sample_t Oscillator::getSample<Oscillator::WaveShape::UserDefined>(
-							const float _sample )
+inline void Oscillator::getSamples<Oscillator::WaveShape::UserDefined>(const float* phases, sample_t* samples,
+	const fpp_t count)
 {
 	if (m_useWaveTable && m_userAntiAliasWaveTable && !m_isModulator)
 	{
-		return wtSample(m_userAntiAliasWaveTable.get(), _sample);
+		wtSamples((*m_userAntiAliasWaveTable)[m_waveTableBand].data(), phases, samples, count);
 	}
 	else
 	{
-		return userWaveSample(m_userWave.get(), _sample);
+		const SampleBuffer* wave = m_userWave.get();
+		for (fpp_t i = 0; i < count; ++i) { samples[i] = userWaveSample(wave, phases[i]); }
 	}
 }
 
@@ -0,0 +1,129 @@
+/*
+ * PartitionedConvolution.cpp - uniformly partitioned convolution with overlap-save
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "PartitionedConvolution.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace lmms
+{
+
+namespace
+{
+
+template<typename T>
+auto allocate(std::size_t count) -> FftwBuffer<T>
+{
+	auto data = makeFftwBuffer<T>(count);
+	if (!data) { throw std::bad_alloc{}; }
+	std::memset(data.get(), 0, sizeof(T) * count);
+	return data;
+}
+
+} // namespace
+
+
+
+
+auto PartitionedResponse::partition(const float* samples, std::size_t count, std::size_t blockSize) -> PartitionedResponse
+{
+	auto response = PartitionedResponse{};
+	response.blockSize = blockSize;
+	response.partitions = (count + blockSize - 1) / blockSize;
+	if (response.partitions == 0) { return response; }
+	response.spectra = allocate<fftwf_complex>(response.partitions * response.bins());
+
+	// scaled for the inverse FFT, which doesn't normalize
+	const auto forward = realFftPlan(2 * blockSize);
+	const auto scale = 1.f / (2 * blockSize);
+	auto block = allocate<float>(2 * blockSize);
+	for (std::size_t p = 0; p < response.partitions; ++p)
+	{
+		const float* first = samples + p * blockSize;
+		const float* last = samples + std::min((p + 1) * blockSize, count);
+		std::fill_n(std::copy(first, last, block.get()), 2 * blockSize - (last - first), 0.f);
+
+		auto spectrum = response.spectra.get() + p * response.bins();
+		fftwf_execute_dft_r2c(forward, block.get(), spectrum);
+		for (std::size_t bin = 0; bin < response.bins(); ++bin)
+		{
+			spectrum[bin][0] *= scale;
+			spectrum[bin][1] *= scale;
+		}
+	}
+	return response;
+}
+
+
+
+
+UniformConvolver::UniformConvolver(std::size_t blockSize, std::size_t partitions)
+	: m_blockSize(blockSize)
+	, m_partitions(std::max<std::size_t>(partitions, 1))
+	, m_forward(realFftPlan(2 * blockSize))
+	, m_inverse(inverseRealFftPlan(2 * blockSize))
+	, m_input(allocate<float>(2 * blockSize))
+	, m_output(allocate<float>(2 * blockSize))
+	, m_history(allocate<fftwf_complex>(m_partitions * (blockSize + 1)))
+	, m_sum(allocate<fftwf_complex>(blockSize + 1))
+{
+}
+
+void UniformConvolver::push(const float* in)
+{
+	const auto bins = m_blockSize + 1;
+
+	// overlap-save: the spectrum of the last two blocks of input
+	float* input = m_input.get();
+	std::copy(input + m_blockSize, input + 2 * m_blockSize, input);
+	std::copy(in, in + m_blockSize, input + m_blockSize);
+	m_newest = (m_newest + m_partitions - 1) % m_partitions;
+	fftwf_execute_dft_r2c(m_forward, input, m_history.get() + m_newest * bins);
+}
+
+void UniformConvolver::convolve(const PartitionedResponse& response, float* out)
+{
+	const auto bins = m_blockSize + 1;
+	const auto partitions = std::min(response.partitions, m_partitions);
+
+	// partition p is applied to the input p blocks ago
+	fftwf_complex* sum = m_sum.get();
+	std::memset(sum, 0, sizeof(fftwf_complex) * bins);
+	for (std::size_t p = 0; p < partitions; ++p)
+	{
+		const fftwf_complex* x = m_history.get() + (m_newest + p) % m_partitions * bins;
+		const fftwf_complex* h = response.spectrum(p);
+		for (std::size_t bin = 0; bin < bins; ++bin)
+		{
+			sum[bin][0] += x[bin][0] * h[bin][0] - x[bin][1] * h[bin][1];
+			sum[bin][1] += x[bin][0] * h[bin][1] + x[bin][1] * h[bin][0];
+		}
+	}
+
+	// the first half is wrapped around, the second one is the output of the block
+	fftwf_execute_dft_c2r(m_inverse, sum, m_output.get());
+	std::copy(m_output.get() + m_blockSize, m_output.get() + 2 * m_blockSize, out);
+}
+
+} // namespace lmms
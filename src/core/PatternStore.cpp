@@ -39,6 +39,10 @@ PatternStore::PatternStore() :
 	m_patternComboBoxModel(this)
 {
 	setType(Type::Pattern);
+
+	// lengths are compiled in bars
+	connect(Engine::getSong(), &Song::timeSignatureChanged, this, &PatternStore::compilePatterns, Qt::DirectConnection);
+	compilePatterns();
 }
 
 
@@ -83,19 +87,60 @@ void PatternStore::updateAfterTrackAdd()
 
 bar_t PatternStore::lengthOfPattern(int pattern) const
 {
-	TimePos maxLength = TimePos::ticksPerBar();
+	return compiledPattern(pattern).length;
+}
 
-	const TrackList & tl = tracks();
-	for (Track * t : tl)
+
+
+
+PatternTrack* PatternStore::patternTrack(int pattern) const
+{
+	return compiledPattern(pattern).patternTrack;
+}
+
+
+
+
+auto PatternStore::compiledPattern(int pattern) const -> CompiledPattern
+{
+	const auto compiled = std::atomic_load(&m_compiledPatterns);
+	if (!compiled || pattern < 0 || static_cast<std::size_t>(pattern) >= compiled->patterns.size())
+	{
+		return {1, PatternTrack::findPatternTrack(pattern)};
+	}
+	return compiled->patterns[pattern];
+}
+
+
+
+
+void PatternStore::compilePatterns()
+{
+	const auto lock = std::lock_guard{m_compileMutex};
+	auto compiled = std::make_shared<CompiledPatterns>();
+
+	const TrackList& tl = tracks();
+	auto maxLengths = std::vector<TimePos>{};
+	for (Track* t : tl)
 	{
 		// Don't create Clips here if they don't exist
-		if (pattern < t->numOfClips())
+		if (static_cast<std::size_t>(t->numOfClips()) > maxLengths.size())
+		{
+			maxLengths.resize(t->numOfClips(), TimePos::ticksPerBar());
+		}
+		for (int i = 0; i < t->numOfClips(); ++i)
 		{
-			maxLength = std::max(maxLength, t->getClip(pattern)->length());
+			maxLengths[i] = std::max(maxLengths[i], t->getClip(i)->length());
 		}
 	}
 
-	return maxLength.nextFullBar();
+	compiled->patterns.reserve(maxLengths.size());
+	for (std::size_t i = 0; i < maxLengths.size(); ++i)
+	{
+		compiled->patterns.push_back({maxLengths[i].nextFullBar(), PatternTrack::findPatternTrack(i)});
+	}
+
+	std::atomic_store(&m_compiledPatterns, std::shared_ptr<const CompiledPatterns>{std::move(compiled)});
 }
 
 
@@ -133,6 +178,8 @@ void PatternStore::swapPattern(int pattern1, int pattern2)
 	{
 		t->swapPositionOfClips(pattern1, pattern2);
 	}
+	// the pattern tracks playing them have been swapped as well
+	compilePatterns();
 	updateComboBox();
 }
 
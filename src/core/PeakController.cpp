@@ -92,20 +92,18 @@ void PeakController::updateValueBuffer()
 		{
 			const f_cnt_t frames = Engine::audioEngine()->framesPerPeriod();
 			float * values = m_valueBuffer.values();
+			m_valueBuffer.markVarying();
 
+			// the sample moves towards the target without ever crossing it,
+			// so it keeps going up or down for the whole period
+			const float coeff = m_currentSample < targetSample ? m_attackCoeff : m_decayCoeff;
+			float currentSample = m_currentSample;
 			for( f_cnt_t f = 0; f < frames; ++f )
 			{
-				const float diff = ( targetSample - m_currentSample );
-				if( m_currentSample < targetSample ) // going up...
-				{
-					m_currentSample += diff * m_attackCoeff;
-				}
-				else if( m_currentSample > targetSample ) // going down
-				{
-					m_currentSample += diff * m_decayCoeff;
-				}
-				values[f] = m_currentSample;
+				currentSample += ( targetSample - currentSample ) * coeff;
+				values[f] = currentSample;
 			}
+			m_currentSample = currentSample;
 		}
 		else
 		{
@@ -24,6 +24,15 @@
 
 #include "PerfLog.h"
 
+#include <QHash>
+#include <QPair>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <utility>
+
 #include "lmmsconfig.h"
 
 #if defined(LMMS_HAVE_SYS_TIMES_H) && defined(LMMS_HAVE_UNISTD_H)
@@ -136,4 +145,169 @@ void PerfLogTimer::end()
 }
 
 
+
+
+namespace
+{
+
+struct Report
+{
+	std::mutex mutex;
+	//! The number of the report being collected, or 0 if none is
+	std::atomic<int> collecting = 0;
+	//! The number of the latest report, which timers may still add to
+	int current = 0;
+	//! The number of timers still running for the latest report
+	int running = 0;
+	std::condition_variable stopped;
+	QString title;
+	std::vector<PerfLogReport::Entry> entries;
+	QHash<QPair<QString, QString>, std::size_t> index;
+};
+
+Report& report()
+{
+	static Report r;
+	return r;
+}
+
+} // namespace
+
+
+
+
+PerfLogReport::Timer::Timer(const QString& stage, const QString& name) :
+	m_report(report().collecting.load(std::memory_order_relaxed))
+{
+	if (m_report == 0) { return; }
+
+	{
+		auto& r = report();
+		const auto lock = std::lock_guard{r.mutex};
+		if (m_report != r.current)
+		{
+			m_report = 0;
+			return;
+		}
+		++r.running;
+	}
+
+	m_stage = stage;
+	m_name = name;
+	m_begin = std::chrono::steady_clock::now();
+}
+
+
+
+
+PerfLogReport::Timer::~Timer()
+{
+	end();
+}
+
+
+
+
+void PerfLogReport::Timer::end()
+{
+	if (m_report == 0) { return; }
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_begin).count();
+	const int timedReport = std::exchange(m_report, 0);
+
+	auto& r = report();
+	const auto lock = std::lock_guard{r.mutex};
+	if (timedReport != r.current) { return; }
+
+	if (--r.running == 0) { r.stopped.notify_all(); }
+
+	const auto key = qMakePair(m_stage, m_name);
+	const auto it = r.index.constFind(key);
+	if (it == r.index.constEnd())
+	{
+		r.index.insert(key, r.entries.size());
+		r.entries.push_back(Entry{m_stage, m_name, 1, seconds, seconds});
+		return;
+	}
+
+	auto& entry = r.entries[*it];
+	++entry.count;
+	entry.seconds += seconds;
+	entry.maxSeconds = std::max(entry.maxSeconds, seconds);
+}
+
+
+
+
+void PerfLogReport::begin(const QString& title)
+{
+	auto& r = report();
+	const auto lock = std::lock_guard{r.mutex};
+	++r.current;
+	r.running = 0;
+	r.title = title;
+	r.entries.clear();
+	r.index.clear();
+	r.collecting.store(r.current, std::memory_order_relaxed);
+}
+
+
+
+
+void PerfLogReport::end()
+{
+	report().collecting.store(0, std::memory_order_relaxed);
+}
+
+
+
+
+void PerfLogReport::waitForTimers()
+{
+	auto& r = report();
+	auto lock = std::unique_lock{r.mutex};
+	r.stopped.wait(lock, [&r] { return r.running == 0; });
+}
+
+
+
+
+QString PerfLogReport::title()
+{
+	auto& r = report();
+	const auto lock = std::lock_guard{r.mutex};
+	return r.title;
+}
+
+
+
+
+std::vector<PerfLogReport::Entry> PerfLogReport::entries()
+{
+	auto& r = report();
+	const auto lock = std::lock_guard{r.mutex};
+	return r.entries;
+}
+
+
+
+
+QString PerfLogReport::toString()
+{
+	const auto seconds = [](double s) { return QString::number(s, 'f', 3).rightJustified(10); };
+
+	auto text = QString("Load report: %1\n\n").arg(title());
+	text += QString("Stage").leftJustified(16) + QString("Name").leftJustified(40)
+		+ QString("Count").rightJustified(7) + QString("Total s").rightJustified(10)
+		+ QString("Max s").rightJustified(10) + '\n';
+	for (const auto& entry : entries())
+	{
+		text += entry.stage.leftJustified(15) + ' ' + entry.name.leftJustified(39) + ' '
+			+ QString::number(entry.count).rightJustified(7) + seconds(entry.seconds)
+			+ seconds(entry.maxSeconds) + '\n';
+	}
+	return text;
+}
+
+
 } // namespace lmms
\ No newline at end of file
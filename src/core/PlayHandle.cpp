@@ -23,23 +23,34 @@
  */
  
 #include "PlayHandle.h"
+#include "AudioBusHandle.h"
 #include "AudioEngine.h"
 #include "BufferManager.h"
 #include "Engine.h"
+#include "MixHelpers.h"
 
 #include <QThread>
+#include <atomic>
 
 
 namespace lmms
 {
 
+//! Leaves the lower 24 bits of the order to the sub-notes of a note
+static std::atomic<std::uint64_t> s_nextOrder = 1;
+
+
 PlayHandle::PlayHandle(const Type type, f_cnt_t offset) :
 		m_type(type),
 		m_offset(offset),
 		m_affinity(QThread::currentThread()),
 		m_playHandleBuffer(BufferManager::acquire()),
 		m_bufferReleased(true),
-		m_usesBuffer(true)
+		m_bufferSilent(false),
+		m_usesBuffer(true),
+		m_audioBusHandle(nullptr),
+		m_order(s_nextOrder.fetch_add(1, std::memory_order_relaxed) << 24),
+		m_slots{Unlisted, Unlisted, Unlisted}
 {
 }
 
@@ -50,17 +61,53 @@ PlayHandle::~PlayHandle()
 }
 
 
+static const char* playHandleTypeName(PlayHandle::Type type)
+{
+	switch (type)
+	{
+		case PlayHandle::Type::NotePlayHandle: return "Note";
+		case PlayHandle::Type::InstrumentPlayHandle: return "Instrument";
+		case PlayHandle::Type::SamplePlayHandle: return "Sample";
+		case PlayHandle::Type::PresetPreviewHandle: return "Preset preview";
+	}
+	return "Unknown";
+}
+
+
 void PlayHandle::doProcessing()
+{
+	AudioEngineProfiler::TraceScope trace(Engine::audioEngine()->profiler(), "Play handle",
+		playHandleTypeName(type()), reinterpret_cast<std::uintptr_t>(this));
+	const auto time = CpuTime::Scope{m_audioBusHandle ? &m_audioBusHandle->playHandlesTime() : nullptr};
+	Engine::audioEngine()->seedRandom(AudioEngine::RandomDomain::PlayHandle, order());
+
+	beginProcessing();
+	play( workingBuffer() );
+	finishProcessing();
+}
+
+
+void PlayHandle::beginProcessing()
 {
 	if( m_usesBuffer )
 	{
 		m_bufferReleased = false;
 		zeroSampleFrames(m_playHandleBuffer, Engine::audioEngine()->framesPerPeriod());
-		play( buffer() );
 	}
-	else
+}
+
+
+void PlayHandle::finishProcessing()
+{
+	if( m_usesBuffer )
+	{
+		m_bufferSilent = m_type != Type::NotePlayHandle
+			&& MixHelpers::isSilent(m_playHandleBuffer, Engine::audioEngine()->framesPerPeriod());
+	}
+
+	if( m_audioBusHandle )
 	{
-		play( nullptr );
+		m_audioBusHandle->playHandleProcessed();
 	}
 }
 
@@ -34,6 +34,7 @@
 #include "DummyPlugin.h"
 #include "AutomatableModel.h"
 #include "Song.h"
+#include "PerfLog.h"
 #include "PluginFactory.h"
 
 namespace lmms
@@ -208,6 +209,7 @@ Plugin * Plugin::instantiateWithKey(const QString& pluginName, Model * parent,
 Plugin * Plugin::instantiate(const QString& pluginName, Model * parent,
 								void *data)
 {
+	const auto timer = PerfLogReport::Timer("Plugin", pluginName);
 	const PluginFactory::PluginInfo& pi = getPluginFactory()->pluginInfo(pluginName.toUtf8());
 
 	Plugin* inst;
@@ -0,0 +1,123 @@
+/*
+ * PluginMetadataCache.cpp - keeps plugin metadata between runs
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "PluginMetadataCache.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <algorithm>
+
+namespace {
+	constexpr auto CacheFileMagic = quint32{0x4c504d43};
+} // namespace
+
+namespace lmms {
+
+PluginMetadataCache::PluginMetadataCache(const QString& name, quint16 version)
+	: m_path(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+		+ QStringLiteral("/plugins/") + name + QStringLiteral(".cache"))
+	, m_version(version)
+{
+	auto file = QFile{m_path};
+	if (!file.open(QIODevice::ReadOnly)) { return; }
+
+	auto stream = QDataStream{&file};
+	stream.setVersion(QDataStream::Qt_5_0);
+
+	auto magic = quint32{0};
+	auto storedVersion = quint16{0};
+	auto count = quint32{0};
+	stream >> magic >> storedVersion >> count;
+	if (stream.status() != QDataStream::Ok || magic != CacheFileMagic || storedVersion != m_version) { return; }
+
+	for (auto i = quint32{0}; i < count; ++i)
+	{
+		auto path = QString{};
+		auto entry = Entry{};
+		stream >> path >> entry.modified >> entry.data;
+		if (stream.status() != QDataStream::Ok)
+		{
+			// better scan everything again than trusting a damaged file
+			m_entries.clear();
+			return;
+		}
+		m_entries.insert(path, entry);
+	}
+}
+
+PluginMetadataCache::~PluginMetadataCache()
+{
+	const auto unused = std::count_if(m_entries.begin(), m_entries.end(), [](const Entry& e) { return !e.used; });
+	if ((!m_changed && unused == 0) || !QDir{}.mkpath(QFileInfo{m_path}.path())) { return; }
+
+	// written to a temporary file first, so other instances never read a partial one
+	auto file = QSaveFile{m_path};
+	if (!file.open(QIODevice::WriteOnly)) { return; }
+
+	auto stream = QDataStream{&file};
+	stream.setVersion(QDataStream::Qt_5_0);
+	stream << CacheFileMagic << m_version << static_cast<quint32>(m_entries.size() - unused);
+	for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it)
+	{
+		if (it->used) { stream << it.key() << it->modified << it->data; }
+	}
+
+	if (stream.status() == QDataStream::Ok) { file.commit(); }
+}
+
+auto PluginMetadataCache::find(const QString& path) -> std::optional<QVariant>
+{
+	const auto it = m_entries.find(path);
+	if (it == m_entries.end() || it->modified != modificationTime(path)) { return std::nullopt; }
+
+	it->used = true;
+	return it->data;
+}
+
+void PluginMetadataCache::insert(const QString& path, const QVariant& data)
+{
+	m_entries.insert(path, Entry{modificationTime(path), data, true});
+	m_changed = true;
+}
+
+auto PluginMetadataCache::modificationTime(const QString& path) -> qint64
+{
+	const auto info = QFileInfo{path};
+	auto modified = info.lastModified().toMSecsSinceEpoch();
+	if (!info.isDir()) { return modified; }
+
+	// editing a file inside a bundle does not always touch the directory
+	auto it = QDirIterator{path, QDir::Files, QDirIterator::Subdirectories};
+	while (it.hasNext())
+	{
+		it.next();
+		modified = std::max(modified, it.fileInfo().lastModified().toMSecsSinceEpoch());
+	}
+	return modified;
+}
+
+} // namespace lmms
@@ -0,0 +1,254 @@
+/*
+ * PolyphaseResampler.cpp - fast resampler for constant ratios
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "PolyphaseResampler.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numbers>
+#include <samplerate.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#	define LMMS_POLYPHASE_SSE2
+#	include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#	define LMMS_POLYPHASE_NEON
+#	include <arm_neon.h>
+#endif
+
+namespace lmms {
+
+struct PolyphaseResampler::Kernel
+{
+	enum class Type
+	{
+		ZeroOrderHold,
+		Linear,
+		Sinc
+	};
+
+	Type type;
+	//! Input frames used on either side of the output position
+	int halfTaps;
+	//! Number of fractional positions the coefficients are computed for
+	int phases;
+	//! phases + 1 rows of 2 * halfTaps coefficients, each one stored twice
+	//! (for the left and the right channel)
+	std::vector<float> coefficients;
+
+	auto row(int phase) const -> const float* { return coefficients.data() + phase * halfTaps * 4; }
+};
+
+namespace {
+
+auto besselI0(double x) -> double
+{
+	auto sum = 1.0;
+	auto term = 1.0;
+	for (int k = 1; term > 1e-12 * sum; ++k)
+	{
+		term *= (x / (2 * k)) * (x / (2 * k));
+		sum += term;
+	}
+	return sum;
+}
+
+//! Kaiser windowed sinc low-pass, normalized to unity gain for every phase
+auto sincCoefficients(int halfTaps, int phases, double cutoff, double beta) -> std::vector<float>
+{
+	const auto taps = 2 * halfTaps;
+	auto coefficients = std::vector<float>((phases + 1) * taps * 2);
+	auto row = std::vector<double>(taps);
+
+	for (int phase = 0; phase <= phases; ++phase)
+	{
+		const auto fraction = static_cast<double>(phase) / phases;
+		auto sum = 0.0;
+		for (int tap = 0; tap < taps; ++tap)
+		{
+			const auto x = tap - halfTaps + 1 - fraction;
+			const auto relative = x / halfTaps;
+			const auto window = std::abs(relative) < 1.0
+				? besselI0(beta * std::sqrt(1.0 - relative * relative)) / besselI0(beta)
+				: 0.0;
+			const auto arg = std::numbers::pi * cutoff * x;
+			const auto sinc = std::abs(arg) < 1e-9 ? 1.0 : std::sin(arg) / arg;
+			row[tap] = sinc * window;
+			sum += row[tap];
+		}
+
+		auto out = coefficients.data() + phase * taps * 2;
+		for (int tap = 0; tap < taps; ++tap)
+		{
+			out[2 * tap] = out[2 * tap + 1] = static_cast<float>(row[tap] / sum);
+		}
+	}
+	return coefficients;
+}
+
+//! Computes one output frame from 2 * halfTaps input frames, interpolating
+//! linearly between the coefficients of two adjacent phases
+inline void convolve(const float* row0, const float* row1, float weight, const float* in, int halfTaps, float* out)
+{
+	const auto values = halfTaps * 4; // two channels of 2 * halfTaps frames
+#if defined(LMMS_POLYPHASE_SSE2)
+	const auto w = _mm_set1_ps(weight);
+	auto acc = _mm_setzero_ps();
+	for (int i = 0; i < values; i += 4)
+	{
+		const auto c0 = _mm_loadu_ps(row0 + i);
+		const auto c = _mm_add_ps(c0, _mm_mul_ps(w, _mm_sub_ps(_mm_loadu_ps(row1 + i), c0)));
+		acc = _mm_add_ps(acc, _mm_mul_ps(c, _mm_loadu_ps(in + i)));
+	}
+	// lanes hold left, right, left, right
+	acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+	_mm_storel_pi(reinterpret_cast<__m64*>(out), acc);
+#elif defined(LMMS_POLYPHASE_NEON)
+	const auto w = vdupq_n_f32(weight);
+	auto acc = vdupq_n_f32(0.f);
+	for (int i = 0; i < values; i += 4)
+	{
+		const auto c0 = vld1q_f32(row0 + i);
+		const auto c = vmlaq_f32(c0, w, vsubq_f32(vld1q_f32(row1 + i), c0));
+		acc = vmlaq_f32(acc, c, vld1q_f32(in + i));
+	}
+	vst1_f32(out, vadd_f32(vget_low_f32(acc), vget_high_f32(acc)));
+#else
+	auto left = 0.f;
+	auto right = 0.f;
+	for (int i = 0; i < values; i += 2)
+	{
+		left += (row0[i] + weight * (row1[i] - row0[i])) * in[i];
+		right += (row0[i + 1] + weight * (row1[i + 1] - row0[i + 1])) * in[i + 1];
+	}
+	out[0] = left;
+	out[1] = right;
+#endif
+}
+
+} // namespace
+
+PolyphaseResampler::PolyphaseResampler(int interpolationMode)
+	: m_interpolationMode(interpolationMode)
+	, m_kernel(&kernel(interpolationMode))
+{
+}
+
+auto PolyphaseResampler::supports(int interpolationMode, double ratio) -> bool
+{
+	if (ratio <= 0.0) { return false; }
+
+	// libsamplerate doesn't filter with these either
+	if (interpolationMode == SRC_ZERO_ORDER_HOLD || interpolationMode == SRC_LINEAR) { return true; }
+
+	return ratio >= 1.0;
+}
+
+auto PolyphaseResampler::kernel(int interpolationMode) -> const Kernel&
+{
+	// indexed by the libsamplerate converter type
+	static const auto s_kernels = std::array<Kernel, 5>{
+		Kernel{Kernel::Type::Sinc, 32, 512, sincCoefficients(32, 512, 0.97, 10.0)}, // SRC_SINC_BEST_QUALITY
+		Kernel{Kernel::Type::Sinc, 16, 256, sincCoefficients(16, 256, 0.95, 9.0)}, // SRC_SINC_MEDIUM_QUALITY
+		Kernel{Kernel::Type::Sinc, 8, 128, sincCoefficients(8, 128, 0.9, 7.0)}, // SRC_SINC_FASTEST
+		Kernel{Kernel::Type::ZeroOrderHold, 1, 0, {}}, // SRC_ZERO_ORDER_HOLD
+		Kernel{Kernel::Type::Linear, 1, 0, {}} // SRC_LINEAR
+	};
+
+	const auto index = std::clamp<int>(interpolationMode, 0, static_cast<int>(s_kernels.size()) - 1);
+	return s_kernels[index];
+}
+
+auto PolyphaseResampler::resample(const SampleFrame* in, long inputFrames, SampleFrame* out, long outputFrames,
+	double ratio) -> ProcessResult
+{
+	if (outputFrames <= 0 || ratio <= 0.0) { return {0, 0, 0}; }
+
+	const auto halfTaps = m_kernel->halfTaps;
+	const auto step = 1.0 / ratio;
+
+	if (!m_started)
+	{
+		// center the first output frame on the first input frame
+		m_buffer.assign(halfTaps - 1, SampleFrame{});
+		m_position = halfTaps - 1;
+		m_started = true;
+	}
+
+	// only take the input needed for the requested output, like that the
+	// caller's position stays close to what has actually been played
+	const auto lastPosition = m_position + (outputFrames - 1) * step;
+	const auto framesNeeded = static_cast<long>(lastPosition) + halfTaps + 1 - static_cast<long>(m_buffer.size());
+	const auto inputFramesUsed = std::clamp(framesNeeded, 0L, std::max(inputFrames, 0L));
+	m_buffer.insert(m_buffer.end(), in, in + inputFramesUsed);
+
+	const auto bufferFrames = static_cast<long>(m_buffer.size());
+	const auto buffer = m_buffer.data();
+	auto outputFramesGenerated = 0L;
+
+	while (outputFramesGenerated < outputFrames && static_cast<long>(m_position) + halfTaps < bufferFrames)
+	{
+		const auto index = static_cast<long>(m_position);
+		const auto fraction = static_cast<float>(m_position - index);
+		auto& frame = out[outputFramesGenerated++];
+
+		if (m_kernel->type == Kernel::Type::ZeroOrderHold || (fraction == 0.f && step == 1.0))
+		{
+			// nothing to interpolate at the original rate
+			frame = buffer[index];
+		}
+		else if (m_kernel->type == Kernel::Type::Linear)
+		{
+			frame = buffer[index] * (1.f - fraction) + buffer[index + 1] * fraction;
+		}
+		else
+		{
+			const auto phase = fraction * m_kernel->phases;
+			const auto row = std::min(static_cast<int>(phase), m_kernel->phases - 1); // fraction may round up to 1
+			convolve(m_kernel->row(row), m_kernel->row(row + 1), phase - row,
+				buffer[index - halfTaps + 1].data(), halfTaps, frame.data());
+		}
+
+		m_position += step;
+	}
+
+	// drop the frames the kernel won't need anymore, when downsampling the
+	// position may already be past the end of the buffer
+	const auto consumed = std::min(static_cast<long>(m_position) - halfTaps + 1, bufferFrames);
+	if (consumed > 0)
+	{
+		m_buffer.erase(m_buffer.begin(), m_buffer.begin() + consumed);
+		m_position -= consumed;
+	}
+
+	return {0, inputFramesUsed, outputFramesGenerated};
+}
+
+void PolyphaseResampler::reset()
+{
+	m_buffer.clear();
+	m_position = 0.0;
+	m_started = false;
+}
+
+} // namespace lmms
@@ -33,7 +33,9 @@
 #include "ProjectJournal.h"
 #include "TrackContainer.h"
 
+#include <algorithm>
 #include <atomic>
+#include <vector>
 
 namespace lmms
 {
@@ -42,15 +44,17 @@ namespace lmms
 class PreviewTrackContainer : public TrackContainer
 {
 public:
+	//! Preview tracks kept with their instrument loaded, so previewing the
+	//! presets of a few instruments by turns doesn't instantiate them again
+	//! and again
+	static constexpr std::size_t MaxWarmTracks = 4;
+
 	PreviewTrackContainer() :
-		m_previewInstrumentTrack( nullptr ),
 		m_previewNote( nullptr ),
 		m_dataMutex()
 	{
 		setJournalling( false );
-		m_previewInstrumentTrack = dynamic_cast<InstrumentTrack *>( Track::create( Track::Type::Instrument, this ) );
-		m_previewInstrumentTrack->setJournalling( false );
-		m_previewInstrumentTrack->setPreviewMode( true );
+		m_warmTracks.push_back( createPreviewTrack() );
 	}
 
 	~PreviewTrackContainer() override = default;
@@ -62,7 +66,27 @@ public:
 
 	InstrumentTrack* previewInstrumentTrack()
 	{
-		return m_previewInstrumentTrack;
+		return m_warmTracks.front();
+	}
+
+	//! Makes the warm track @p matches is true for the preview track. If there
+	//! is none, a new one is taken, or the least recently used one, whose
+	//! instrument is replaced by the caller then.
+	template<typename Predicate>
+	InstrumentTrack* selectPreviewTrack( Predicate matches )
+	{
+		auto it = std::find_if( m_warmTracks.begin(), m_warmTracks.end(), matches );
+		if( it == m_warmTracks.end() )
+		{
+			if( m_warmTracks.size() < MaxWarmTracks )
+			{
+				m_warmTracks.push_back( createPreviewTrack() );
+			}
+			it = m_warmTracks.end() - 1;
+		}
+		// the most recently used one first
+		std::rotate( m_warmTracks.begin(), it, it + 1 );
+		return m_warmTracks.front();
 	}
 
 	NotePlayHandle* previewNote()
@@ -102,7 +126,16 @@ public:
 
 
 private:
-	InstrumentTrack* m_previewInstrumentTrack;
+	InstrumentTrack* createPreviewTrack()
+	{
+		auto track = dynamic_cast<InstrumentTrack *>( Track::create( Track::Type::Instrument, this ) );
+		track->setJournalling( false );
+		track->setPreviewMode( true );
+		return track;
+	}
+
+	//! Owned by the container, only used by the GUI thread
+	std::vector<InstrumentTrack*> m_warmTracks;
 	std::atomic<NotePlayHandle*> m_previewNote;
 	QMutex m_dataMutex;
 
@@ -133,15 +166,20 @@ PresetPreviewPlayHandle::PresetPreviewPlayHandle( const QString & _preset_file,
 
 	if( _load_by_plugin )
 	{
-		Instrument * i = s_previewTC->previewInstrumentTrack()->instrument();
 		const QString ext = QFileInfo( _preset_file ).
 							suffix().toLower();
-		if( i == nullptr || !i->descriptor()->supportsFileType( ext ) )
+		const auto supportsFile = [&ext]( const InstrumentTrack* track )
+		{
+			const Instrument* i = track->instrument();
+			return i != nullptr && i->descriptor()->supportsFileType( ext );
+		};
+		InstrumentTrack* track = s_previewTC->selectPreviewTrack( supportsFile );
+		Instrument * i = track->instrument();
+		if( !supportsFile( track ) )
 		{
 			const PluginFactory::PluginInfoAndKey& infoAndKey =
 				getPluginFactory()->pluginSupportingExtension(ext);
-			i = s_previewTC->previewInstrumentTrack()->
-				loadInstrument(infoAndKey.info.name(), &infoAndKey.key);
+			i = track->loadInstrument(infoAndKey.info.name(), &infoAndKey.key);
 		}
 		if( i != nullptr )
 		{
@@ -157,8 +195,15 @@ PresetPreviewPlayHandle::PresetPreviewPlayHandle( const QString & _preset_file,
 			dataFileCreated = true;
 		}
 
-		s_previewTC->previewInstrumentTrack()->loadTrackSpecificSettings(
-					dataFile->content().firstChild().toElement());
+		const QDomElement settings = dataFile->content().firstChild().toElement();
+		// a track with the same instrument only loads its settings, see
+		// InstrumentTrack::loadTrackSpecificSettings()
+		const QString instrumentName = settings.firstChildElement( "instrument" ).attribute( "name" );
+		InstrumentTrack* track = s_previewTC->selectPreviewTrack( [&instrumentName]( const InstrumentTrack* track )
+		{
+			return track->instrument() != nullptr && track->instrument()->nodeName() == instrumentName;
+		} );
+		track->loadTrackSpecificSettings( settings );
 
 		if( dataFileCreated )
 		{
@@ -225,7 +270,7 @@ bool PresetPreviewPlayHandle::isFinished() const
 
 bool PresetPreviewPlayHandle::isFromTrack( const Track * _track ) const
 {
-	return s_previewTC && s_previewTC->previewInstrumentTrack() == _track;
+	return m_previewNote->instrumentTrack() == _track;
 }
 
 
@@ -255,7 +300,7 @@ ConstNotePlayHandleList PresetPreviewPlayHandle::nphsOfInstrumentTrack(
 						const InstrumentTrack * _it )
 {
 	ConstNotePlayHandleList cnphv;
-	if( s_previewTC->previewNote() != nullptr &&
+	if (s_previewTC && s_previewTC->previewNote() != nullptr &&
 		s_previewTC->previewNote()->instrumentTrack() == _it )
 	{
 		cnphv.push_back( s_previewTC->previewNote() );
@@ -22,8 +22,10 @@
  *
  */
 
-#include <cstdlib>
+#include <algorithm>
+#include <random>
 #include <QDomElement>
+#include <QTextStream>
 
 #include "ProjectJournal.h"
 #include "Engine.h"
@@ -34,14 +36,14 @@
 namespace lmms
 {
 
-//! Avoid clashes between loaded IDs (have the bit cleared)
-//! and newly created IDs (have the bit set)
-static const int EO_ID_MSB = 1 << 23;
-
 const int ProjectJournal::MAX_UNDO_STATES = 100; // TODO: make this configurable in settings
+const std::size_t ProjectJournal::MAX_UNDO_MEMORY = 64 * 1024 * 1024;
+const jo_id_t ProjectJournal::s_savedIDOffset = std::random_device{}() % EO_ID_MSB;
 
 ProjectJournal::ProjectJournal() :
-	m_joIDs(),
+	m_allocatedObjects(),
+	m_reusableIDs(),
+	m_loadedObjects(),
 	m_undoCheckPoints(),
 	m_redoCheckPoints(),
 	m_journalling( false )
@@ -55,23 +57,22 @@ void ProjectJournal::undo()
 {
 	while( !m_undoCheckPoints.isEmpty() )
 	{
-		CheckPoint c = m_undoCheckPoints.pop();
-		JournallingObject *jo = m_joIDs[c.joID];
+		CheckPoint c = popCheckPoint( m_undoCheckPoints );
+		JournallingObject *jo = journallingObject( c.joID );
 
 		if( jo )
 		{
-			DataFile curState( DataFile::Type::JournalData );
-			jo->saveState( curState, curState.content() );
-			m_redoCheckPoints.push( CheckPoint( c.joID, curState ) );
+			pushCheckPoint( m_redoCheckPoints, c.joID, saveState( jo ) );
 
+			DataFile data = loadState( c.state );
 			bool prev = isJournalling();
 			setJournalling( false );
-			jo->restoreState( c.data.content().firstChildElement() );
+			jo->restoreState( data.content().firstChildElement() );
 			setJournalling( prev );
 			Engine::getSong()->setModified();
 
 			// loading AutomationClip connections correctly
-			if (!c.data.content().elementsByTagName("automationclip").isEmpty())
+			if (!data.content().elementsByTagName("automationclip").isEmpty())
 			{
 				AutomationClip::resolveAllIDs();
 			}
@@ -86,18 +87,17 @@ void ProjectJournal::redo()
 {
 	while( !m_redoCheckPoints.isEmpty() )
 	{
-		CheckPoint c = m_redoCheckPoints.pop();
-		JournallingObject *jo = m_joIDs[c.joID];
+		CheckPoint c = popCheckPoint( m_redoCheckPoints );
+		JournallingObject *jo = journallingObject( c.joID );
 
 		if( jo )
 		{
-			DataFile curState( DataFile::Type::JournalData );
-			jo->saveState( curState, curState.content() );
-			m_undoCheckPoints.push( CheckPoint( c.joID, curState ) );
+			pushCheckPoint( m_undoCheckPoints, c.joID, saveState( jo ) );
 
+			DataFile data = loadState( c.state );
 			bool prev = isJournalling();
 			setJournalling( false );
-			jo->restoreState( c.data.content().firstChildElement() );
+			jo->restoreState( data.content().firstChildElement() );
 			setJournalling( prev );
 			Engine::getSong()->setModified();
 			break;
@@ -117,21 +117,143 @@ bool ProjectJournal::canRedo() const
 
 
 
+std::size_t ProjectJournal::memoryUsage() const
+{
+	std::size_t memory = 0;
+	for( const auto& c : m_undoCheckPoints )
+	{
+		memory += c.memoryUsage();
+	}
+	for( const auto& c : m_redoCheckPoints )
+	{
+		memory += c.memoryUsage();
+	}
+	return memory;
+}
+
+
+
 void ProjectJournal::addJournalCheckPoint( JournallingObject *jo )
 {
 	if( isJournalling() )
 	{
 		m_redoCheckPoints.clear();
 
-		DataFile dataFile( DataFile::Type::JournalData );
-		jo->saveState( dataFile, dataFile.content() );
+		pushCheckPoint( m_undoCheckPoints, jo->id(), saveState( jo ) );
+		limitCheckPoints( m_undoCheckPoints );
+	}
+}
+
+
+
+
+std::size_t ProjectJournal::CheckPoint::memoryUsage() const
+{
+	return sizeof( CheckPoint ) + state.capacity() * sizeof( QChar ) + diff.memoryUsage();
+}
+
+
+
+
+QString ProjectJournal::saveState( JournallingObject* jo )
+{
+	DataFile dataFile( DataFile::Type::JournalData );
+	jo->saveState( dataFile, dataFile.content() );
+
+	// indented, so that every element is on a line of its own, which the
+	// differences between checkpoints are made of
+	QString state;
+	QTextStream stream( &state );
+	dataFile.content().firstChildElement().save( stream, 1 );
+	stream.flush();
+	return state;
+}
+
+
+
+
+DataFile ProjectJournal::loadState( const QString& state )
+{
+	DataFile dataFile( DataFile::Type::JournalData );
+
+	QDomDocument doc;
+	if( doc.setContent( state ) )
+	{
+		dataFile.content().appendChild( dataFile.importNode( doc.documentElement(), true ) );
+	}
+	return dataFile;
+}
+
+
+
+
+void ProjectJournal::pushCheckPoint( CheckPointStack& stack, jo_id_t id, const QString& state )
+{
+	// the previous checkpoint of the object only keeps what differs
+	for( int i = stack.size() - 1; i >= 0; --i )
+	{
+		CheckPoint& older = stack[i];
+		if( older.joID == id )
+		{
+			older.diff = JournalDiff::between( state.split( '\n' ), older.state.split( '\n' ) );
+			older.state = QString();
+			older.isDiff = true;
+			break;
+		}
+	}
+
+	CheckPoint c;
+	c.joID = id;
+	c.state = state;
+	stack.push( c );
+}
+
+
+
+
+ProjectJournal::CheckPoint ProjectJournal::popCheckPoint( CheckPointStack& stack )
+{
+	CheckPoint c = stack.pop();
 
-		m_undoCheckPoints.push( CheckPoint( jo->id(), dataFile ) );
-		if( m_undoCheckPoints.size() > MAX_UNDO_STATES )
+	// the previous checkpoint of the object is the newest one now
+	for( int i = stack.size() - 1; i >= 0; --i )
+	{
+		CheckPoint& older = stack[i];
+		if( older.joID == c.joID )
 		{
-			m_undoCheckPoints.remove( 0, m_undoCheckPoints.size() - MAX_UNDO_STATES );
+			older.state = older.diff.applyTo( c.state.split( '\n' ) ).join( '\n' );
+			older.diff = JournalDiff();
+			older.isDiff = false;
+			break;
 		}
 	}
+
+	return c;
+}
+
+
+
+
+void ProjectJournal::limitCheckPoints( CheckPointStack& stack )
+{
+	if( stack.size() > MAX_UNDO_STATES )
+	{
+		stack.remove( 0, stack.size() - MAX_UNDO_STATES );
+	}
+
+	// no checkpoint depends on the oldest one, so it can always be dropped
+	std::size_t memory = 0;
+	for( const auto& c : stack )
+	{
+		memory += c.memoryUsage();
+	}
+	int dropped = 0;
+	while( memory > MAX_UNDO_MEMORY && stack.size() - dropped > 1 )
+	{
+		memory -= stack[dropped].memoryUsage();
+		++dropped;
+	}
+	stack.remove( 0, dropped );
 }
 
 
@@ -139,15 +261,36 @@ void ProjectJournal::addJournalCheckPoint( JournallingObject *jo )
 
 jo_id_t ProjectJournal::allocID( JournallingObject * _obj )
 {
-	jo_id_t id;
-	for( jo_id_t tid = rand(); m_joIDs.contains( id = tid % EO_ID_MSB
-							| EO_ID_MSB ); tid++ )
+	// IDs are handed out one after another, so they index the objects
+	// directly. Freed ones are only reused once clearJournal() dropped
+	// everything which may refer to them.
+	jo_id_t index;
+	if( !m_reusableIDs.empty() )
 	{
+		index = m_reusableIDs.back();
+		m_reusableIDs.pop_back();
+		m_allocatedObjects[index] = _obj;
+	}
+	else if( m_allocatedObjects.size() < EO_ID_MSB )
+	{
+		index = static_cast<jo_id_t>( m_allocatedObjects.size() );
+		m_allocatedObjects.push_back( _obj );
+	}
+	else
+	{
+		// all IDs were used since the journal was cleared, take back a
+		// freed one even if the journal may still refer to it
+		const auto it = std::find( m_allocatedObjects.begin(), m_allocatedObjects.end(), nullptr );
+		if( it == m_allocatedObjects.end() )
+		{
+			qFatal( "ProjectJournal: out of journalling object IDs" );
+		}
+		qWarning( "ProjectJournal: reusing journalling object IDs before clearing the journal" );
+		*it = _obj;
+		index = static_cast<jo_id_t>( it - m_allocatedObjects.begin() );
 	}
 
-	m_joIDs[id] = _obj;
-	//printf("new id: %d\n", id );
-	return id;
+	return index | EO_ID_MSB;
 }
 
 
@@ -155,10 +298,13 @@ jo_id_t ProjectJournal::allocID( JournallingObject * _obj )
 
 void ProjectJournal::reallocID( const jo_id_t _id, JournallingObject * _obj )
 {
-	//printf("realloc %d %d\n", _id, _obj );
-//	if( m_joIDs.contains( _id ) )
+	if( isAllocatedID( _id ) )
 	{
-		m_joIDs[_id] = _obj;
+		m_allocatedObjects[_id - EO_ID_MSB] = _obj;
+	}
+	else
+	{
+		m_loadedObjects[_id] = _obj;
 	}
 }
 
@@ -167,12 +313,19 @@ void ProjectJournal::reallocID( const jo_id_t _id, JournallingObject * _obj )
 
 jo_id_t ProjectJournal::idToSave( jo_id_t id )
 {
-	return id & ~EO_ID_MSB;
+	// IDs from loaded files are saved as they were
+	if( !( id & EO_ID_MSB ) ) { return id; }
+	return ( id + s_savedIDOffset ) & ( EO_ID_MSB - 1 );
 }
 
 jo_id_t ProjectJournal::idFromSave( jo_id_t id )
 {
-	return id | EO_ID_MSB;
+	return ( ( id - s_savedIDOffset ) & ( EO_ID_MSB - 1 ) ) | EO_ID_MSB;
+}
+
+jo_id_t ProjectJournal::idFromLegacySave( jo_id_t id )
+{
+	return id & ~EO_ID_MSB;
 }
 
 
@@ -183,11 +336,20 @@ void ProjectJournal::clearJournal()
 	m_undoCheckPoints.clear();
 	m_redoCheckPoints.clear();
 
-	for( JoIdMap::Iterator it = m_joIDs.begin(); it != m_joIDs.end(); )
+	m_reusableIDs.clear();
+	for( auto index = static_cast<jo_id_t>( m_allocatedObjects.size() ); index > 0; --index )
+	{
+		if( m_allocatedObjects[index - 1] == nullptr )
+		{
+			m_reusableIDs.push_back( index - 1 );
+		}
+	}
+
+	for( JoIdMap::Iterator it = m_loadedObjects.begin(); it != m_loadedObjects.end(); )
 	{
 		if( it.value() == nullptr )
 		{
-			it = m_joIDs.erase( it );
+			it = m_loadedObjects.erase( it );
 		}
 		else
 		{
@@ -198,7 +360,14 @@ void ProjectJournal::clearJournal()
 
 void ProjectJournal::stopAllJournalling()
 {
-	for( JoIdMap::Iterator it = m_joIDs.begin(); it != m_joIDs.end(); ++it)
+	for( const auto& jo : m_allocatedObjects )
+	{
+		if( jo != nullptr )
+		{
+			jo->setJournalling(false);
+		}
+	}
+	for( JoIdMap::Iterator it = m_loadedObjects.begin(); it != m_loadedObjects.end(); ++it)
 	{
 		if( it.value() != nullptr )
 		{
@@ -26,6 +26,8 @@
 #include <QFile>
 
 #include "ProjectRenderer.h"
+#include "AudioBusHandle.h"
+#include "RenderCache.h"
 #include "Song.h"
 #include "PerfLog.h"
 
@@ -38,6 +40,25 @@
 namespace lmms
 {
 
+namespace
+{
+
+//! Has the engine render at a multiple of the rate of the files, while
+//! ProjectRenderer writes the decimated periods into them
+class OversampledDevice : public AudioDevice
+{
+public:
+	OversampledDevice(sample_rate_t sampleRate, AudioEngine* audioEngine) :
+		AudioDevice(DEFAULT_CHANNELS, audioEngine)
+	{
+		setSampleRate(sampleRate);
+	}
+};
+
+} // namespace
+
+
+
 
 const std::array<ProjectRenderer::FileEncodeDevice, 5> ProjectRenderer::fileEncodeDevices
 {
@@ -83,26 +104,82 @@ ProjectRenderer::ProjectRenderer( const AudioEngine::qualitySettings & qualitySe
 					ExportFileFormat exportFileFormat,
 					const QString & outputFilename ) :
 	QThread( Engine::audioEngine() ),
-	m_fileDev( nullptr ),
+	m_fileDev( createFileDevice( exportFileFormat, outputSettings, outputFilename ) ),
 	m_qualitySettings( qualitySettings ),
+	m_outputSettings( outputSettings ),
+	m_fileFormat( exportFileFormat ),
 	m_progress( 0 ),
 	m_abort( false )
 {
-	AudioFileDeviceInstantiaton audioEncoderFactory = fileEncodeDevices[static_cast<std::size_t>(exportFileFormat)].m_getDevInst;
+}
+
+
+
+
+AudioFileDevice* ProjectRenderer::createFileDevice(ExportFileFormat fileFormat,
+	const OutputSettings& outputSettings, const QString& outputFile)
+{
+	AudioFileDeviceInstantiaton audioEncoderFactory = fileEncodeDevices[static_cast<std::size_t>(fileFormat)].m_getDevInst;
 
 	if (audioEncoderFactory)
 	{
 		bool successful = false;
 
-		m_fileDev = audioEncoderFactory(
-					outputFilename, outputSettings, DEFAULT_CHANNELS,
+		AudioFileDevice* fileDev = audioEncoderFactory(
+					outputFile, outputSettings, DEFAULT_CHANNELS,
 					Engine::audioEngine(), successful );
-		if( !successful )
+		if( successful )
 		{
-			delete m_fileDev;
-			m_fileDev = nullptr;
+			return fileDev;
 		}
+		delete fileDev;
+	}
+	return nullptr;
+}
+
+
+
+
+bool ProjectRenderer::addOutput(ExportFileFormat fileFormat, const OutputSettings& outputSettings,
+	const QString& outputFile)
+{
+	auto fileDev = std::unique_ptr<AudioFileDevice>(
+		createFileDevice(fileFormat, withRenderedRate(outputSettings), outputFile));
+	if (!fileDev)
+	{
+		return false;
 	}
+
+	m_outputs.push_back(Output{std::move(fileDev), nullptr});
+	return true;
+}
+
+
+
+
+bool ProjectRenderer::addStem(AudioBusHandle* busHandle, const QString& outputFile, ExportFileFormat fileFormat,
+	const OutputSettings& outputSettings)
+{
+	auto fileDev = std::unique_ptr<AudioFileDevice>(
+		createFileDevice(fileFormat, withRenderedRate(outputSettings), outputFile));
+	if (!fileDev)
+	{
+		return false;
+	}
+
+	m_stems.push_back(Stem{busHandle, Output{std::move(fileDev), nullptr}, nullptr});
+	return true;
+}
+
+
+
+
+OutputSettings ProjectRenderer::withRenderedRate(const OutputSettings& outputSettings) const
+{
+	// every file gets the same rendered periods, there's no resampling per file
+	auto settings = outputSettings;
+	settings.setSampleRate(m_outputSettings.getSampleRate());
+	return settings;
 }
 
 
@@ -143,9 +220,29 @@ void ProjectRenderer::startProcessing()
 
 	if( isReady() )
 	{
+		// the decimated periods have to be whole frames
+		const fpp_t frames = Engine::audioEngine()->maxFramesPerPeriod();
+		while (frames % m_qualitySettings.oversamplingFactor() != 0)
+		{
+			m_qualitySettings.oversampling = static_cast<AudioEngine::qualitySettings::Oversampling>(
+				m_qualitySettings.oversamplingStages() - 1);
+		}
+
+		// When oversampling, the engine renders for a device of its own and the
+		// file device is finished by this renderer instead
+		AudioDevice* device = m_fileDev;
+		if (m_qualitySettings.oversamplingStages() > 0)
+		{
+			device = new OversampledDevice(m_fileDev->sampleRate() * m_qualitySettings.oversamplingFactor(),
+				Engine::audioEngine());
+		}
+
 		// Have to do audio engine stuff with GUI-thread affinity in order to
 		// make slots connected to sampleRateChanged()-signals being called immediately.
-		Engine::audioEngine()->setAudioDevice( m_fileDev, m_qualitySettings, false, false );
+		Engine::audioEngine()->setAudioDevice(device, m_qualitySettings, false, false);
+
+		// only the tracks changed since the last export are rendered again
+		RenderCache::beginRender();
 
 		start(
 #ifndef LMMS_BUILD_WIN32
@@ -160,6 +257,7 @@ void ProjectRenderer::startProcessing()
 void ProjectRenderer::run()
 {
 	PerfLogTimer perfLog("Project Render");
+	const auto writeStatsBefore = AudioFileDevice::writeStats();
 
 	Engine::getSong()->startExport();
 	// Skip first empty buffer.
@@ -167,13 +265,47 @@ void ProjectRenderer::run()
 
 	m_progress = 0;
 
+	// Encode on other threads, so rendering doesn't wait for the encoders
+	const fpp_t frames = Engine::audioEngine()->maxFramesPerPeriod();
+	const int stages = m_qualitySettings.oversamplingStages();
+	const fpp_t fileFrames = frames >> stages;
+	auto encoder = std::make_unique<AudioFileEncoder>(m_fileDev, fileFrames);
+	for (auto& output : m_outputs)
+	{
+		output.encoder = std::make_unique<AudioFileEncoder>(output.fileDev.get(), fileFrames);
+	}
+	for (auto& stem : m_stems)
+	{
+		stem.output.encoder = std::make_unique<AudioFileEncoder>(stem.output.fileDev.get(), fileFrames);
+	}
+
+	if (stages > 0)
+	{
+		m_decimator = std::make_unique<Decimator>(fileFrames, stages);
+		for (auto& stem : m_stems)
+		{
+			stem.decimator = std::make_unique<Decimator>(fileFrames, stages);
+		}
+	}
+
 	// Now start processing
 	Engine::audioEngine()->startProcessing(false);
 
 	// Continually track and emit progress percentage to listeners.
 	while (!Engine::getSong()->isExportDone() && !m_abort)
 	{
-		m_fileDev->processNextBuffer();
+		const SampleFrame* buffer = Engine::audioEngine()->nextBuffer();
+		if (m_decimator)
+		{
+			buffer = m_decimator->process(buffer);
+		}
+		encoder->write(buffer);
+		for (auto& output : m_outputs)
+		{
+			output.encoder->write(buffer);
+		}
+		writeStems(frames);
+
 		const int nprog = Engine::getSong()->getExportProgress();
 		if (m_progress != nprog)
 		{
@@ -186,11 +318,37 @@ void ProjectRenderer::run()
 	Engine::audioEngine()->stopProcessing();
 
 	Engine::getSong()->stopExport();
+	RenderCache::endRender(!m_abort);
+
+	// the main file device belongs to the audio engine, which finishes it,
+	// unless the engine rendered for a device of its own
+	encoder.reset();
+	const QString f = m_fileDev->outputFile();
+	if (stages > 0)
+	{
+		delete m_fileDev;
+		m_fileDev = nullptr;
+	}
+	else { m_fileDev->flushOutput(); }
+	for (auto& output : m_outputs)
+	{
+		finishOutput(output);
+	}
+	for (auto& stem : m_stems)
+	{
+		finishOutput(stem.output);
+	}
 
 	perfLog.end();
 
+	const auto writeStats = AudioFileDevice::writeStats();
+	const auto mebibytes = (writeStats.bytes - writeStatsBefore.bytes) / double{1 << 20};
+	const auto writeSeconds = writeStats.seconds - writeStatsBefore.seconds;
+	qWarning("PERFLOG | %20s | %.1f MiB in %llu writes, %.2fs writing (%.1f MiB/s)", "File Output", mebibytes,
+		static_cast<unsigned long long>(writeStats.writes - writeStatsBefore.writes), writeSeconds,
+		writeSeconds > 0 ? mebibytes / writeSeconds : 0.);
+
 	// If the user aborted export-process, the file has to be deleted.
-	const QString f = m_fileDev->outputFile();
 	if( m_abort )
 	{
 		QFile( f ).remove();
@@ -200,6 +358,52 @@ void ProjectRenderer::run()
 
 
 
+void ProjectRenderer::finishOutput(Output& output)
+{
+	const QString file = output.fileDev->outputFile();
+	output.encoder.reset();
+	// finish writing the file
+	output.fileDev.reset();
+	if (m_abort)
+	{
+		QFile(file).remove();
+	}
+}
+
+
+
+
+void ProjectRenderer::writeStems(fpp_t frames)
+{
+	// the period which has just been rendered is still in the buffers of
+	// the audio bus handles, as rendering happens in this thread
+	for (const auto& stem : m_stems)
+	{
+		const SampleFrame* buffer = nullptr;
+		if (stem.busHandle->hasOutput())
+		{
+			buffer = stem.busHandle->buffer();
+		}
+		else
+		{
+			if (m_silence.size() < frames)
+			{
+				m_silence.resize(frames);
+			}
+			buffer = m_silence.data();
+		}
+
+		if (stem.decimator)
+		{
+			buffer = stem.decimator->process(buffer);
+		}
+		stem.output.encoder->write(buffer);
+	}
+}
+
+
+
+
 void ProjectRenderer::abortProcessing()
 {
 	m_abort = true;
@@ -0,0 +1,306 @@
+/*
+ * RealtimeChecker.cpp - reports calls which may block threads rendering audio
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "RealtimeChecker.h"
+
+#ifdef LMMS_DEBUG_REALTIME
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <dlfcn.h> // For dlsym
+#include <execinfo.h> // For backtrace and backtrace_symbols_fd
+#include <linux/futex.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// The allocator of glibc, which the functions below forward to. Looking them
+// up with dlsym() doesn't work, as dlsym() allocates itself.
+extern "C"
+{
+void* __libc_malloc(std::size_t size);
+void* __libc_calloc(std::size_t count, std::size_t size);
+void* __libc_realloc(void* ptr, std::size_t size);
+void* __libc_memalign(std::size_t alignment, std::size_t size);
+void __libc_free(void* ptr);
+}
+
+namespace lmms {
+
+namespace {
+
+constexpr auto MaxFrames = 32;
+constexpr auto MaxSites = std::size_t{4096};
+
+//! How many scopes rendering audio the current thread is in
+thread_local int t_realtimeDepth = 0;
+//! Set while reporting, so what the report calls itself isn't reported
+thread_local bool t_reporting = false;
+
+//! Hashes of the stack traces reported so far, 0 marks free slots
+std::array<std::atomic<std::uint64_t>, MaxSites> s_reportedSites{};
+
+void writeString(const char* text)
+{
+	// unlike stdio, write() doesn't allocate
+	[[maybe_unused]] const auto written = ::write(STDERR_FILENO, text, std::strlen(text));
+}
+
+//! Returns whether the site with @p hash wasn't reported before, and marks it as reported
+bool markReported(std::uint64_t hash)
+{
+	hash = std::max<std::uint64_t>(hash, 1);
+	for (auto i = std::size_t{0}; i < MaxSites; ++i)
+	{
+		auto& site = s_reportedSites[(hash + i) % MaxSites];
+		auto expected = std::uint64_t{0};
+		if (site.compare_exchange_strong(expected, hash) || expected == hash)
+		{
+			return expected == 0;
+		}
+	}
+	// with every slot taken, better report too much than nothing
+	return true;
+}
+
+[[gnu::noinline]] void check(const char* call)
+{
+	if (t_realtimeDepth == 0 || t_reporting) { return; }
+	t_reporting = true;
+
+	void* frames[MaxFrames];
+	const int count = backtrace(frames, MaxFrames);
+
+	// FNV-1a over the return addresses
+	auto hash = std::uint64_t{14695981039346656037u};
+	for (int i = 0; i < count; ++i)
+	{
+		hash = (hash ^ reinterpret_cast<std::uintptr_t>(frames[i])) * 1099511628211u;
+	}
+
+	if (markReported(hash))
+	{
+		writeString("Realtime violation: ");
+		writeString(call);
+		writeString(" called while rendering audio\n");
+		// leave out check() itself
+		backtrace_symbols_fd(frames + 1, std::max(count - 1, 0), STDERR_FILENO);
+		writeString("\n");
+
+		const char* mode = std::getenv("LMMS_REALTIME_CHECK");
+		if (mode && std::strcmp(mode, "abort") == 0) { std::abort(); }
+	}
+
+	t_reporting = false;
+}
+
+//! Returns the implementation of @p name the intercepting function replaces
+template<typename F>
+F* next(std::atomic<F*>& cached, const char* name)
+{
+	F* function = cached.load(std::memory_order_relaxed);
+	if (!function)
+	{
+		// looked up on first use, races only look it up more than once
+		function = reinterpret_cast<F*>(dlsym(RTLD_NEXT, name));
+		cached.store(function, std::memory_order_relaxed);
+	}
+	return function;
+}
+
+} // namespace
+
+void RealtimeChecker::enter()
+{
+	++t_realtimeDepth;
+}
+
+void RealtimeChecker::leave()
+{
+	--t_realtimeDepth;
+}
+
+} // namespace lmms
+
+
+
+
+// Definitions in the executable take precedence over the C library for all
+// code in the process, so these intercept the calls of plugins too.
+extern "C"
+{
+
+void* malloc(std::size_t size) noexcept
+{
+	lmms::check("malloc");
+	return __libc_malloc(size);
+}
+
+void* calloc(std::size_t count, std::size_t size) noexcept
+{
+	lmms::check("calloc");
+	return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, std::size_t size) noexcept
+{
+	lmms::check("realloc");
+	return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr) noexcept
+{
+	if (ptr) { lmms::check("free"); }
+	__libc_free(ptr);
+}
+
+void* memalign(std::size_t alignment, std::size_t size) noexcept
+{
+	lmms::check("memalign");
+	return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(std::size_t alignment, std::size_t size) noexcept
+{
+	lmms::check("aligned_alloc");
+	return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** ptr, std::size_t alignment, std::size_t size) noexcept
+{
+	lmms::check("posix_memalign");
+	if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0) { return EINVAL; }
+	void* allocated = __libc_memalign(alignment, size);
+	if (!allocated) { return ENOMEM; }
+	*ptr = allocated;
+	return 0;
+}
+
+int pthread_mutex_lock(pthread_mutex_t* mutex) noexcept
+{
+	using Function = int(pthread_mutex_t*);
+	static auto s_next = std::atomic<Function*>{};
+	lmms::check("pthread_mutex_lock");
+	return lmms::next(s_next, "pthread_mutex_lock")(mutex);
+}
+
+int pthread_cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex)
+{
+	using Function = int(pthread_cond_t*, pthread_mutex_t*);
+	static auto s_next = std::atomic<Function*>{};
+	lmms::check("pthread_cond_wait");
+	return lmms::next(s_next, "pthread_cond_wait")(cond, mutex);
+}
+
+int sem_wait(sem_t* sem)
+{
+	using Function = int(sem_t*);
+	static auto s_next = std::atomic<Function*>{};
+	lmms::check("sem_wait");
+	return lmms::next(s_next, "sem_wait")(sem);
+}
+
+int nanosleep(const timespec* duration, timespec* remaining)
+{
+	using Function = int(const timespec*, timespec*);
+	static auto s_next = std::atomic<Function*>{};
+	lmms::check("nanosleep");
+	return lmms::next(s_next, "nanosleep")(duration, remaining);
+}
+
+int usleep(useconds_t duration)
+{
+	using Function = int(useconds_t);
+	static auto s_next = std::atomic<Function*>{};
+	lmms::check("usleep");
+	return lmms::next(s_next, "usleep")(duration);
+}
+
+// Not declared through <fcntl.h>, which may define them inline when fortified.
+// Qt opens files with open64(), as does stdio internally, although not through
+// the intercepted function. The mode is only passed when creating files, but
+// reading it regardless is what the C library does too.
+int open(const char* path, int flags, ...)
+{
+	using Function = int(const char*, int, ...);
+	static auto s_next = std::atomic<Function*>{};
+	lmms::check("open");
+
+	va_list args;
+	va_start(args, flags);
+	const auto mode = va_arg(args, unsigned int);
+	va_end(args);
+	return lmms::next(s_next, "open")(path, flags, mode);
+}
+
+int open64(const char* path, int flags, ...)
+{
+	using Function = int(const char*, int, ...);
+	static auto s_next = std::atomic<Function*>{};
+	lmms::check("open64");
+
+	va_list args;
+	va_start(args, flags);
+	const auto mode = va_arg(args, unsigned int);
+	va_end(args);
+	return lmms::next(s_next, "open64")(path, flags, mode);
+}
+
+// Contended QMutexes and std::atomic::wait() wait on futexes directly
+long syscall(long number, ...) noexcept
+{
+	using Function = long(long, ...);
+	static auto s_next = std::atomic<Function*>{};
+
+	va_list args;
+	va_start(args, number);
+	long arguments[6];
+	for (auto& argument : arguments)
+	{
+		argument = va_arg(args, long);
+	}
+	va_end(args);
+
+	if (number == SYS_futex)
+	{
+		const auto operation = static_cast<int>(arguments[1]) & FUTEX_CMD_MASK;
+		if (operation == FUTEX_WAIT || operation == FUTEX_WAIT_BITSET || operation == FUTEX_LOCK_PI)
+		{
+			lmms::check("futex wait");
+		}
+	}
+
+	return lmms::next(s_next, "syscall")(number, arguments[0], arguments[1], arguments[2],
+		arguments[3], arguments[4], arguments[5]);
+}
+
+} // extern "C"
+
+#endif // LMMS_DEBUG_REALTIME
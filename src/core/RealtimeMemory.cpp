@@ -0,0 +1,252 @@
+/*
+ * RealtimeMemory.cpp - keeps memory used by the audio threads resident
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "RealtimeMemory.h"
+
+#include <QDebug>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+#include "ConfigManager.h"
+#include "lmmsconfig.h"
+
+#if defined(LMMS_BUILD_LINUX) || defined(LMMS_BUILD_APPLE)
+#include <sys/mman.h>
+#elif defined(LMMS_BUILD_WIN32)
+#include <windows.h>
+#endif
+
+namespace lmms
+{
+
+namespace
+{
+
+//! Size of the huge pages used for anonymous memory on x86-64 and most ARM64 systems
+constexpr std::size_t HugePageSize = std::size_t{2} << 20;
+//! Smallest page size of the supported systems
+constexpr std::size_t PageSize = 4096;
+//! Stack faulted in by prefaultStack(), plenty for the processing of a period
+constexpr std::size_t PrefaultedStackSize = 256 * 1024;
+//! Alignment of memory from allocate(), as for the buffers of BufferManager
+constexpr std::size_t Alignment = 64;
+
+struct Policy
+{
+	bool locking;
+	RealtimeMemory::HugePages hugePages;
+};
+
+const Policy& policy()
+{
+	static const auto s_policy = [] {
+		const auto config = ConfigManager::inst();
+		return Policy{
+			config->value("audioengine", "lockmemory").toInt() != 0,
+			static_cast<RealtimeMemory::HugePages>(
+				std::clamp(config->value("audioengine", "hugepages").toInt(), 0, 2))};
+	}();
+	return s_policy;
+}
+
+std::atomic_size_t s_lockedBytes = 0;
+std::atomic_bool s_lockFailed = false;
+
+std::size_t roundUp(std::size_t size, std::size_t alignment)
+{
+	return (size + alignment - 1) / alignment * alignment;
+}
+
+#ifdef LMMS_BUILD_LINUX
+//! Whether memory from allocate() is mapped by it instead of being taken from the heap
+bool mapsMemory()
+{
+	return policy().hugePages != RealtimeMemory::HugePages::Off;
+}
+#endif
+
+} // namespace
+
+
+
+
+bool RealtimeMemory::lockingEnabled()
+{
+	return policy().locking;
+}
+
+
+
+
+RealtimeMemory::HugePages RealtimeMemory::hugePages()
+{
+	return policy().hugePages;
+}
+
+
+
+
+bool RealtimeMemory::lock(const void* data, std::size_t size)
+{
+	if (!lockingEnabled() || !data || size == 0) { return false; }
+
+#if defined(LMMS_BUILD_LINUX) || defined(LMMS_BUILD_APPLE)
+	const bool locked = ::mlock(data, size) == 0;
+#elif defined(LMMS_BUILD_WIN32)
+	const bool locked = VirtualLock(const_cast<void*>(data), size) != 0;
+#else
+	const bool locked = false;
+#endif
+
+	if (locked)
+	{
+		s_lockedBytes.fetch_add(size, std::memory_order_relaxed);
+	}
+	else if (!s_lockFailed.exchange(true, std::memory_order_relaxed))
+	{
+		// most likely the limit of locked memory (ulimit -l) has been reached
+		qWarning() << "Could not lock audio memory into RAM:" << std::strerror(errno)
+			<< "- raise the limit of locked memory, e.g. by joining the audio group";
+	}
+	return locked;
+}
+
+
+
+
+void RealtimeMemory::unlock(const void* data, std::size_t size)
+{
+	if (!lockingEnabled() || !data || size == 0) { return; }
+
+#if defined(LMMS_BUILD_LINUX) || defined(LMMS_BUILD_APPLE)
+	const bool unlocked = ::munlock(data, size) == 0;
+#elif defined(LMMS_BUILD_WIN32)
+	const bool unlocked = VirtualUnlock(const_cast<void*>(data), size) != 0;
+#else
+	const bool unlocked = false;
+#endif
+
+	if (unlocked) { s_lockedBytes.fetch_sub(size, std::memory_order_relaxed); }
+}
+
+
+
+
+void* RealtimeMemory::allocate(std::size_t size)
+{
+#ifdef LMMS_BUILD_LINUX
+	if (mapsMemory())
+	{
+		const auto mapped = roundUp(std::max<std::size_t>(size, 1), HugePageSize);
+
+		if (hugePages() == HugePages::Explicit)
+		{
+			void* data = ::mmap(nullptr, mapped, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+			if (data != MAP_FAILED) { return data; }
+			// no huge pages reserved (or left), so fall back to transparent ones
+		}
+
+		// only whole huge pages can be used transparently, so the mapping is
+		// aligned to them by cutting off what's in front of the first one
+		auto data = static_cast<char*>(::mmap(nullptr, mapped + HugePageSize, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+		if (data == MAP_FAILED) { throw std::bad_alloc{}; }
+
+		const auto offset = roundUp(reinterpret_cast<std::uintptr_t>(data), HugePageSize)
+			- reinterpret_cast<std::uintptr_t>(data);
+		if (offset > 0) { ::munmap(data, offset); }
+		if (offset < HugePageSize) { ::munmap(data + offset + mapped, HugePageSize - offset); }
+
+		::madvise(data + offset, mapped, MADV_HUGEPAGE);
+		return data + offset;
+	}
+#endif
+	return ::operator new(size, std::align_val_t{Alignment});
+}
+
+
+
+
+void RealtimeMemory::deallocate(void* data, std::size_t size)
+{
+	if (!data) { return; }
+
+#ifdef LMMS_BUILD_LINUX
+	if (mapsMemory())
+	{
+		::munmap(data, roundUp(std::max<std::size_t>(size, 1), HugePageSize));
+		return;
+	}
+#endif
+	::operator delete(data, std::align_val_t{Alignment});
+}
+
+
+
+
+void RealtimeMemory::adviseHugePages(const void* data, std::size_t size)
+{
+#ifdef LMMS_BUILD_LINUX
+	if (hugePages() == HugePages::Off) { return; }
+
+	// only the huge pages lying completely inside the range may be collapsed
+	const auto begin = roundUp(reinterpret_cast<std::uintptr_t>(data), HugePageSize);
+	const auto end = (reinterpret_cast<std::uintptr_t>(data) + size) / HugePageSize * HugePageSize;
+	if (end > begin)
+	{
+		::madvise(reinterpret_cast<void*>(begin), end - begin, MADV_HUGEPAGE);
+	}
+#else
+	(void)data;
+	(void)size;
+#endif
+}
+
+
+
+
+void RealtimeMemory::prefaultStack()
+{
+	// the frames of the functions called later on take the place of this array
+	volatile char stack[PrefaultedStackSize];
+	for (std::size_t i = 0; i < sizeof(stack); i += PageSize)
+	{
+		stack[i] = 0;
+	}
+	lock(const_cast<const char*>(stack), sizeof(stack));
+}
+
+
+
+
+std::size_t RealtimeMemory::lockedBytes()
+{
+	return s_lockedBytes.load(std::memory_order_relaxed);
+}
+
+} // namespace lmms
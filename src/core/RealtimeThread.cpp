@@ -0,0 +1,191 @@
+/*
+ * RealtimeThread.cpp - scheduling helpers for audio threads
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "RealtimeThread.h"
+
+#include "lmmsconfig.h"
+
+#ifdef LMMS_BUILD_WIN32
+#include <windows.h>
+#include <avrt.h>
+#endif
+
+#if defined(LMMS_HAVE_PTHREAD_H) && defined(LMMS_HAVE_SCHED_H)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <string>
+#include <thread>
+
+namespace lmms
+{
+
+int makeCurrentThreadRealtime(int priority, RealtimePolicy policy)
+{
+#if defined(LMMS_BUILD_WIN32)
+	(void)priority;
+	(void)policy;
+	DWORD taskIndex = 0;
+	return AvSetMmThreadCharacteristicsW(L"Pro Audio", &taskIndex) ? 1 : 0;
+#elif defined(LMMS_HAVE_PTHREAD_H) && defined(LMMS_HAVE_SCHED_H)
+	int currentPolicy;
+	sched_param param;
+	if (pthread_getschedparam(pthread_self(), &currentPolicy, &param) != 0) { return 0; }
+	if (currentPolicy == SCHED_FIFO || currentPolicy == SCHED_RR) { return param.sched_priority; }
+
+	const int newPolicy = policy == RealtimePolicy::RoundRobin ? SCHED_RR : SCHED_FIFO;
+	const int min = sched_get_priority_min(newPolicy);
+	const int max = sched_get_priority_max(newPolicy);
+	param.sched_priority = priority > 0 ? std::clamp(priority, min, max) : (min + max) / 2;
+	// fails without the rights to use real-time scheduling, e.g. no rtprio limit
+	return pthread_setschedparam(pthread_self(), newPolicy, &param) == 0 ? param.sched_priority : 0;
+#else
+	(void)priority;
+	(void)policy;
+	return 0;
+#endif
+}
+
+
+
+
+void pinCurrentThread(unsigned cpu)
+{
+#if defined(LMMS_BUILD_LINUX) && defined(LMMS_HAVE_PTHREAD_H) && defined(LMMS_HAVE_SCHED_H)
+	const unsigned cores = std::max(std::thread::hardware_concurrency(), 1u);
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu % cores, &set);
+	pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#elif defined(LMMS_BUILD_WIN32)
+	const unsigned cores = std::max(std::thread::hardware_concurrency(), 1u);
+	if (cores <= sizeof(DWORD_PTR) * 8)
+	{
+		SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR{1} << (cpu % cores));
+	}
+#else
+	(void)cpu;
+#endif
+}
+
+std::vector<unsigned> performanceCores()
+{
+#ifdef LMMS_BUILD_LINUX
+	// hybrid processors of Intel list their performance cores as a PMU of their own
+	if (auto file = std::ifstream{"/sys/devices/cpu_core/cpus"})
+	{
+		auto list = std::string{};
+		std::getline(file, list);
+		return parseCpuList(list);
+	}
+
+	// ARM's big.LITTLE and its successors report the relative speed of each core
+	auto capacities = std::vector<long>{};
+	for (unsigned cpu = 0; cpu < std::thread::hardware_concurrency(); ++cpu)
+	{
+		auto file = std::ifstream{"/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/cpu_capacity"};
+		long capacity = 0;
+		if (!(file >> capacity)) { return {}; }
+		capacities.push_back(capacity);
+	}
+	if (capacities.empty()) { return {}; }
+
+	const auto [slowest, fastest] = std::minmax_element(capacities.begin(), capacities.end());
+	if (*slowest == *fastest) { return {}; }
+
+	auto cores = std::vector<unsigned>{};
+	for (auto cpu = std::size_t{0}; cpu < capacities.size(); ++cpu)
+	{
+		if (capacities[cpu] == *fastest) { cores.push_back(static_cast<unsigned>(cpu)); }
+	}
+	return cores;
+#else
+	return {};
+#endif
+}
+
+
+
+
+std::vector<std::vector<unsigned>> numaNodes()
+{
+#ifdef LMMS_BUILD_LINUX
+	auto online = std::ifstream{"/sys/devices/system/node/online"};
+	auto list = std::string{};
+	if (!std::getline(online, list)) { return {}; }
+
+	auto nodes = std::vector<std::vector<unsigned>>{};
+	for (const unsigned node : parseCpuList(list))
+	{
+		auto file = std::ifstream{"/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"};
+		auto cpus = std::string{};
+		std::getline(file, cpus);
+		// nodes of memory only, e.g. CXL expanders, have no cores
+		if (auto cores = parseCpuList(cpus); !cores.empty()) { nodes.push_back(std::move(cores)); }
+	}
+	if (nodes.size() < 2) { return {}; }
+	return nodes;
+#else
+	return {};
+#endif
+}
+
+
+
+
+std::vector<unsigned> parseCpuList(std::string_view list)
+{
+	const auto parse = [](std::string_view text, unsigned& value)
+	{
+		while (!text.empty() && text.front() == ' ') { text.remove_prefix(1); }
+		while (!text.empty() && (text.back() == ' ' || text.back() == '\n')) { text.remove_suffix(1); }
+		const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+		return error == std::errc{} && end == text.data() + text.size();
+	};
+
+	auto cores = std::vector<unsigned>{};
+	while (!list.empty())
+	{
+		const auto comma = list.find(',');
+		const auto entry = list.substr(0, comma);
+		list = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1);
+
+		const auto dash = entry.find('-');
+		unsigned first = 0;
+		unsigned last = 0;
+		if (dash == std::string_view::npos)
+		{
+			if (parse(entry, first)) { cores.push_back(first); }
+		}
+		else if (parse(entry.substr(0, dash), first) && parse(entry.substr(dash + 1), last))
+		{
+			for (unsigned cpu = first; cpu <= last; ++cpu) { cores.push_back(cpu); }
+		}
+	}
+	return cores;
+}
+
+} // namespace lmms
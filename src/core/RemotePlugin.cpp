@@ -34,10 +34,16 @@
 #endif
 
 #include "AudioEngine.h"
+#include "AudioEngineWorkerThread.h"
 #include "Engine.h"
 #include "MidiEvent.h"
+#include "RealtimeMemory.h"
 #include "Song.h"
 
+#include <map>
+#include <mutex>
+#include <thread>
+
 #include <QCoreApplication>
 #include <QDebug>
 #include <QDir>
@@ -143,7 +149,9 @@ RemotePlugin::RemotePlugin() :
 	m_commMutex(QMutex::Recursive),
 #endif
 	m_splitChannels( false ),
+	m_sharedProcess( false ),
 	m_audioBufferSize( 0 ),
+	m_bufferFrames( Engine::audioEngine()->maxFramesPerPeriod() ),
 	m_inputCount( DEFAULT_CHANNELS ),
 	m_outputCount( DEFAULT_CHANNELS )
 {
@@ -201,11 +209,16 @@ RemotePlugin::~RemotePlugin()
 			lock();
 			sendMessage( IdQuit );
 
-			m_process.waitForFinished( 1000 );
-			if( m_process.state() != QProcess::NotRunning )
+			// a shared process only drops this plugin and keeps running
+			// for the others, see RemotePluginHost
+			if( !m_host )
 			{
-				m_process.terminate();
-				m_process.kill();
+				m_process.waitForFinished( 1000 );
+				if( m_process.state() != QProcess::NotRunning )
+				{
+					m_process.terminate();
+					m_process.kill();
+				}
 			}
 			unlock();
 		}
@@ -218,6 +231,9 @@ RemotePlugin::~RemotePlugin()
 	}
 	remove( m_socketFile.toUtf8().constData() );
 #endif
+
+	RealtimeMemory::unlock(m_audioBuffer.get(), m_audioBuffer.size_bytes());
+	RealtimeMemory::unlock(m_processSync.get(), m_processSync.size_bytes());
 }
 
 
@@ -280,13 +296,26 @@ bool RemotePlugin::init(const QString &pluginExecutable,
 #endif
 	args << extraArgs;
 #ifndef DEBUG_REMOTE_PLUGIN
-	m_process.setProcessChannelMode( QProcess::ForwardedChannels );
-	m_process.setWorkingDirectory( QCoreApplication::applicationDirPath() );
-	m_exec = exec;
-	m_args = args;
-	// we start the process on the watcher thread to work around QTBUG-8819
-	m_process.moveToThread( &m_watcher );
-	m_watcher.start( QThread::LowestPriority );
+#ifndef SYNC_WITH_SHM_FIFO
+	if( m_sharedProcess )
+	{
+		m_host = RemotePluginHost::get( exec, extraArgs );
+		if( m_host )
+		{
+			m_host->addInstance( args );
+		}
+	}
+#endif
+	if( !m_host )
+	{
+		m_process.setProcessChannelMode( QProcess::ForwardedChannels );
+		m_process.setWorkingDirectory( QCoreApplication::applicationDirPath() );
+		m_exec = exec;
+		m_args = args;
+		// we start the process on the watcher thread to work around QTBUG-8819
+		m_process.moveToThread( &m_watcher );
+		m_watcher.start( QThread::LowestPriority );
+	}
 #else
 	qDebug() << exec << args;
 #endif
@@ -316,6 +345,7 @@ bool RemotePlugin::init(const QString &pluginExecutable,
 #endif
 
 	sendMessage(message(IdSyncKey).addString(Engine::getSong()->syncKey()));
+	createProcessSync();
 	resizeSharedProcessingMemory();
 
 	if( waitForInitDoneMsg )
@@ -330,6 +360,22 @@ bool RemotePlugin::init(const QString &pluginExecutable,
 
 
 
+bool RemotePlugin::isRunning()
+{
+#ifdef DEBUG_REMOTE_PLUGIN
+	return true;
+#else
+	if( m_host )
+	{
+		return m_host->isRunning();
+	}
+	return m_process.state() != QProcess::NotRunning;
+#endif // DEBUG_REMOTE_PLUGIN
+}
+
+
+
+
 bool RemotePlugin::process( const SampleFrame* _in_buf, SampleFrame* _out_buf )
 {
 	const fpp_t frames = Engine::audioEngine()->framesPerPeriod();
@@ -398,7 +444,18 @@ bool RemotePlugin::process( const SampleFrame* _in_buf, SampleFrame* _out_buf )
 	}
 
 	lock();
-	sendMessage( IdStartProcessing );
+	if (frames != m_bufferFrames)
+	{
+		// handled before the processing request, so both sides lay out the
+		// shared memory the same way
+		sendMessage(message(IdBufferSizeInformation).addInt(frames));
+		m_bufferFrames = frames;
+	}
+	// whether the remote process, once attached, posts processed periods
+	// through m_processSync or answers with IdProcessingDone
+	const bool sharedSync = m_processSync && m_processSync->attached();
+	const auto seen = sharedSync ? m_processSync->processed.count() : 0;
+	sendMessage(message(IdStartProcessing).addInt(sharedSync));
 
 	if( m_failed || _out_buf == nullptr || m_outputCount == 0 )
 	{
@@ -406,7 +463,21 @@ bool RemotePlugin::process( const SampleFrame* _in_buf, SampleFrame* _out_buf )
 		return false;
 	}
 
-	waitForMessage( IdProcessingDone );
+	// instead of blocking this thread while the remote process renders, help
+	// with the other jobs of the period, which lets several remote plugins
+	// render in parallel with each other and with the in-process ones
+	AudioEngineWorkerThread::runJobsWhile([&] {
+		return !m_failed && (sharedSync ? m_processSync->processed.count() == seen : !messagesLeft());
+	});
+
+	if (sharedSync)
+	{
+		waitForProcessing(seen);
+	}
+	else
+	{
+		waitForMessage( IdProcessingDone );
+	}
 	unlock();
 
 	const ch_cnt_t outputs = std::min<ch_cnt_t>(m_outputCount,
@@ -482,7 +553,9 @@ void RemotePlugin::hideUI()
 
 void RemotePlugin::resizeSharedProcessingMemory()
 {
-	const size_t s = (m_inputCount + m_outputCount) * Engine::audioEngine()->framesPerPeriod();
+	const size_t s = (m_inputCount + m_outputCount) * Engine::audioEngine()->maxFramesPerPeriod();
+	// unmapping the old buffer unlocks it anyway, but it mustn't be counted any longer
+	RealtimeMemory::unlock(m_audioBuffer.get(), m_audioBuffer.size_bytes());
 	try
 	{
 		m_audioBuffer.create(s);
@@ -494,12 +567,59 @@ void RemotePlugin::resizeSharedProcessingMemory()
 		return;
 	}
 	m_audioBufferSize = s * sizeof(float);
+	RealtimeMemory::lock(m_audioBuffer.get(), m_audioBuffer.size_bytes());
 	sendMessage(message(IdChangeSharedMemoryKey).addString(m_audioBuffer.key()));
 }
 
 
 
 
+void RemotePlugin::createProcessSync()
+{
+	if constexpr (!SharedEvent::Supported) { return; }
+
+	try
+	{
+		m_processSync.create();
+		RealtimeMemory::lock(m_processSync.get(), m_processSync.size_bytes());
+	}
+	catch (const std::runtime_error& error)
+	{
+		qWarning() << "Failed to allocate process sync memory:" << error.what();
+		m_processSync.detach();
+		return;
+	}
+	sendMessage(message(IdChangeProcessSyncKey).addString(m_processSync.key()));
+}
+
+
+
+
+void RemotePlugin::waitForProcessing(std::uint32_t seen)
+{
+	// spinning for a little while catches plugins done within a fraction of
+	// the period without the wakeup latency of sleeping, but only helps if the
+	// remote process has another core to run on meanwhile
+	static const int spins = std::thread::hardware_concurrency() > 1 ? 4000 : 0;
+	constexpr int timeoutMs = 100;
+
+	while (!m_processSync->processed.wait(seen, spins, timeoutMs))
+	{
+		if (m_failed || isInvalid() || !isRunning()) { return; }
+	}
+
+	// the remote process may have sent messages of its own meanwhile, e.g.
+	// changed its channel counts, which used to be handled while waiting for
+	// IdProcessingDone
+	if (messagesLeft())
+	{
+		fetchAndProcessAllMessages();
+	}
+}
+
+
+
+
 void RemotePlugin::processFinished( int exitCode,
 					QProcess::ExitStatus exitStatus )
 {
@@ -546,7 +666,7 @@ bool RemotePlugin::processMessage( const message & _m )
 
 		case IdBufferSizeInformation:
 			reply = true;
-			reply_message.addInt( Engine::audioEngine()->framesPerPeriod() );
+			reply_message.addInt( Engine::audioEngine()->maxFramesPerPeriod() );
 			break;
 
 		case IdChangeInputCount:
@@ -585,4 +705,51 @@ bool RemotePlugin::processMessage( const message & _m )
 }
 
 
+
+
+
+std::shared_ptr<RemotePluginHost> RemotePluginHost::get( const QString& executable,
+							const QStringList& args )
+{
+	static std::mutex mutex;
+	static std::map<QString, std::weak_ptr<RemotePluginHost>> hosts;
+
+	const auto key = (QStringList{executable} + args).join('\n');
+	const auto guard = std::lock_guard{mutex};
+	if( auto host = hosts[key].lock(); host && host->isRunning() && !host->isInvalid() )
+	{
+		return host;
+	}
+
+	auto host = std::shared_ptr<RemotePluginHost>( new RemotePluginHost );
+	if( host->init( executable, false, args + QStringList{"shared"} ) )
+	{
+		return nullptr;
+	}
+	host->waitForHostInfoGotten();
+	if( host->failed() )
+	{
+		return nullptr;
+	}
+
+	hosts[key] = host;
+	return host;
+}
+
+
+
+
+void RemotePluginHost::addInstance( const QStringList& channelArgs )
+{
+	message m( IdHostAddInstance );
+	for( const auto& arg : channelArgs )
+	{
+		m.addString( QSTR_TO_STDSTR( arg ) );
+	}
+	lock();
+	sendMessage( m );
+	unlock();
+}
+
+
 } // namespace lmms
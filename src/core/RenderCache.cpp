@@ -0,0 +1,248 @@
+/*
+ * RenderCache.cpp - keeps the output of tracks rendered by earlier exports
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "RenderCache.h"
+
+#include <QCryptographicHash>
+#include <QDomDocument>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "AudioBusHandle.h"
+#include "AudioEngine.h"
+#include "AutomationClip.h"
+#include "AutomationTrack.h"
+#include "EffectChain.h"
+#include "FrozenAudio.h"
+#include "InstrumentTrack.h"
+#include "Song.h"
+
+namespace lmms {
+
+namespace {
+
+constexpr auto DefaultMemoryBudget = std::size_t{1024} * 1024 * 1024;
+
+//! Output kept by the cache, the most recently used first
+using RecentList = std::list<std::pair<QByteArray, std::shared_ptr<const FrozenAudio>>>;
+
+struct Capture
+{
+	AudioBusHandle* busHandle;
+	QByteArray key;
+	std::shared_ptr<FrozenAudio> audio;
+};
+
+struct Cache
+{
+	std::mutex mutex;
+	std::map<QByteArray, RecentList::iterator> entries;
+	RecentList recent;
+	std::size_t bytes = 0;
+	std::size_t memoryBudget = DefaultMemoryBudget;
+
+	//! The tracks of the export being rendered
+	std::vector<AudioBusHandle*> reused;
+	std::vector<Capture> captures;
+};
+
+auto cache() -> Cache&
+{
+	static auto s_cache = Cache{};
+	return s_cache;
+}
+
+void saveAutomation(QDomDocument& doc, QDomElement& element, const AutomatableModel* model)
+{
+	for (AutomationClip* clip : AutomationClip::clipsForModel(model))
+	{
+		clip->saveState(doc, element);
+	}
+}
+
+//! Everything in the song the output of all tracks depends on
+auto songKey() -> QByteArray
+{
+	Song* song = Engine::getSong();
+	const AudioEngine* audioEngine = Engine::audioEngine();
+	const auto& timeline = song->getTimeline(Song::PlayMode::Song);
+
+	auto doc = QDomDocument{};
+	auto element = doc.createElement("song");
+	doc.appendChild(element);
+	element.setAttribute("samplerate", audioEngine->outputSampleRate());
+	element.setAttribute("fpp", audioEngine->maxFramesPerPeriod());
+	element.setAttribute("interpolation", static_cast<int>(audioEngine->currentQualitySettings().interpolation));
+	element.setAttribute("length", song->length());
+	element.setAttribute("ticksperbar", song->ticksPerBar());
+	element.setAttribute("loopbegin", timeline.loopBegin().getTicks());
+	element.setAttribute("loopend", timeline.loopEnd().getTicks());
+	element.setAttribute("exportloop", song->exportLoop());
+	element.setAttribute("markers", song->renderBetweenMarkers());
+
+	song->tempoModel().saveSettings(doc, element, "bpm");
+	song->masterPitchModel().saveSettings(doc, element, "masterpitch");
+	saveAutomation(doc, element, &song->tempoModel());
+	saveAutomation(doc, element, &song->masterPitchModel());
+	song->globalAutomationTrack()->saveState(doc, element);
+
+	return doc.toByteArray();
+}
+
+//! Everything the output of @p track depends on, hashed, or nothing if it can't be cached
+auto trackKey(InstrumentTrack* track, const QByteArray& songState) -> QByteArray
+{
+	auto doc = QDomDocument{};
+	auto element = doc.createElement("render");
+	doc.appendChild(element);
+	track->saveState(doc, element);
+
+	auto models = track->findChildren<AutomatableModel*>();
+	models += track->audioBusHandle()->effects()->findChildren<AutomatableModel*>();
+	for (const AutomatableModel* model : models)
+	{
+		// controllers may follow other tracks, like peak controllers do
+		if (model->controllerConnection()) { return {}; }
+		saveAutomation(doc, element, model);
+	}
+
+	auto hash = QCryptographicHash{QCryptographicHash::Sha1};
+	hash.addData(songState);
+	hash.addData(doc.toByteArray());
+	return hash.result();
+}
+
+// The functions below expect the cache to be locked
+
+void evict(Cache& c)
+{
+	while (c.bytes > c.memoryBudget && !c.recent.empty())
+	{
+		const auto& [key, audio] = c.recent.back();
+		c.bytes -= audio->memoryUsage();
+		c.entries.erase(key);
+		c.recent.pop_back();
+	}
+}
+
+void store(Cache& c, const QByteArray& key, std::shared_ptr<const FrozenAudio> audio)
+{
+	// tracks with the same key, e.g. clones, are only cached once
+	if (c.entries.count(key) > 0) { return; }
+
+	// output exceeding the budget on its own would only evict everything else
+	const auto bytes = audio->memoryUsage();
+	if (bytes > c.memoryBudget) { return; }
+
+	c.recent.emplace_front(key, std::move(audio));
+	c.entries[key] = c.recent.begin();
+	c.bytes += bytes;
+	evict(c);
+}
+
+} // namespace
+
+void RenderCache::beginRender()
+{
+	endRender(false);
+
+	Song* song = Engine::getSong();
+	// each pass of a loop continues from the tails of the one before
+	if (song->getLoopRenderCount() > 1) { return; }
+
+	const AudioEngine* audioEngine = Engine::audioEngine();
+	const auto songState = songKey();
+
+	auto& c = cache();
+	const auto lock = std::lock_guard{c.mutex};
+
+	// tracks of the pattern editor play along with pattern tracks, which aren't part of the key
+	for (Track* track : song->tracks())
+	{
+		auto instrumentTrack = dynamic_cast<InstrumentTrack*>(track);
+		if (!instrumentTrack || instrumentTrack->isMuted()) { continue; }
+
+		const auto key = trackKey(instrumentTrack, songState);
+		if (key.isEmpty()) { continue; }
+
+		AudioBusHandle* busHandle = instrumentTrack->audioBusHandle();
+		if (const auto it = c.entries.find(key); it != c.entries.end())
+		{
+			c.recent.splice(c.recent.begin(), c.recent, it->second);
+			busHandle->setRenderCache(it->second->second);
+			c.reused.push_back(busHandle);
+		}
+		else
+		{
+			auto audio = std::make_shared<FrozenAudio>(audioEngine->maxFramesPerPeriod(), audioEngine->outputSampleRate());
+			audio->setLatency(busHandle->latency());
+			busHandle->setFreezeCapture(audio.get());
+			c.captures.push_back(Capture{busHandle, key, std::move(audio)});
+		}
+	}
+}
+
+void RenderCache::endRender(bool completed)
+{
+	auto& c = cache();
+	const auto lock = std::lock_guard{c.mutex};
+
+	for (AudioBusHandle* busHandle : c.reused)
+	{
+		busHandle->setRenderCache(nullptr);
+	}
+	c.reused.clear();
+
+	for (auto& capture : c.captures)
+	{
+		capture.busHandle->setFreezeCapture(nullptr);
+		// the output of an aborted export ends early
+		if (completed)
+		{
+			capture.audio->shrinkToFit();
+			store(c, capture.key, std::move(capture.audio));
+		}
+	}
+	c.captures.clear();
+}
+
+void RenderCache::setMemoryBudget(std::size_t bytes)
+{
+	auto& c = cache();
+	const auto lock = std::lock_guard{c.mutex};
+	c.memoryBudget = bytes;
+	evict(c);
+}
+
+void RenderCache::clear()
+{
+	auto& c = cache();
+	const auto lock = std::lock_guard{c.mutex};
+	c.entries.clear();
+	c.recent.clear();
+	c.bytes = 0;
+}
+
+} // namespace lmms
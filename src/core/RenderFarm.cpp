@@ -0,0 +1,594 @@
+/*
+ * RenderFarm.cpp - renders the tracks of a project on several hosts
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "RenderFarm.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QFile>
+#include <QFileInfo>
+#include <QTcpSocket>
+#include <QThread>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdio>
+
+#include "AudioBusHandle.h"
+#include "AudioDevice.h"
+#include "Controller.h"
+#include "FrozenAudio.h"
+#include "InstrumentTrack.h"
+#include "PatternStore.h"
+#include "Song.h"
+
+namespace lmms
+{
+
+namespace
+{
+
+constexpr auto ProtocolMagic = quint32{0x4c4d5246}; // "LMRF"
+constexpr auto ProtocolVersion = quint32{2};
+
+//! Every message is its size, followed by its type and its payload
+enum class Message : quint32
+{
+	Job,      //!< to the worker: the project, the render settings and the tracks to render
+	Progress, //!< to the coordinator: how far the worker got, in percent
+	Stem,     //!< to the coordinator: the index of a track and its output
+	Done,     //!< to the coordinator: all tracks have been sent
+	Error     //!< to the coordinator: why the job can't be rendered
+};
+
+constexpr auto HeaderSize = qint64{sizeof(quint64)};
+//! The largest job a worker accepts, far more than the project path and the track indices take
+constexpr auto MaxJobSize = quint64{1} << 20;
+//! The largest message a coordinator accepts, which has to hold the output of a whole track
+constexpr auto MaxStemSize = quint64{1} << 30;
+
+void sendMessage(QTcpSocket* socket, Message type, const QByteArray& payload = {})
+{
+	QByteArray header;
+	QDataStream stream(&header, QIODevice::WriteOnly);
+	stream << static_cast<quint64>(sizeof(quint32) + payload.size()) << static_cast<quint32>(type);
+	socket->write(header);
+	socket->write(payload);
+}
+
+//! Takes the next message from @p socket, returns false if it hasn't been received completely yet.
+//! Aborts the connection if the message would be larger than @p maxSize.
+bool receiveMessage(QTcpSocket* socket, Message& type, QByteArray& payload, quint64 maxSize)
+{
+	if (socket->bytesAvailable() < HeaderSize) { return false; }
+
+	quint64 size = 0;
+	QDataStream header(socket->peek(HeaderSize));
+	header >> size;
+	if (size < sizeof(quint32) || size > maxSize)
+	{
+		socket->abort();
+		return false;
+	}
+	if (static_cast<quint64>(socket->bytesAvailable() - HeaderSize) < size) { return false; }
+
+	socket->read(HeaderSize);
+	payload = socket->read(static_cast<qint64>(size));
+	quint32 messageType = 0;
+	QDataStream stream(payload);
+	stream >> messageType;
+	type = static_cast<Message>(messageType);
+	payload.remove(0, sizeof(quint32));
+	return true;
+}
+
+//! Has to be given to workers listening on other interfaces than the loopback one
+auto sharedSecret() -> QByteArray
+{
+	return qgetenv("LMMS_RENDER_SECRET");
+}
+
+auto trackContainers() -> std::array<const TrackContainer*, 2>
+{
+	return {Engine::getSong(), Engine::patternStore()};
+}
+
+//! The tracks which may be rendered elsewhere, in the same order on every host loading the project
+auto renderableTracks() -> std::vector<InstrumentTrack*>
+{
+	auto tracks = std::vector<InstrumentTrack*>{};
+	for (const TrackContainer* container : trackContainers())
+	{
+		for (Track* track : container->tracks())
+		{
+			if (auto instrumentTrack = dynamic_cast<InstrumentTrack*>(track)) { tracks.push_back(instrumentTrack); }
+		}
+	}
+	return tracks;
+}
+
+auto projectHash(const QString& projectFile) -> QByteArray
+{
+	QFile file(projectFile);
+	if (!file.open(QIODevice::ReadOnly)) { return {}; }
+
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+	hash.addData(&file);
+	return hash.result();
+}
+
+//! Renders into nothing, the output of the tracks is captured instead
+class RenderDevice : public AudioDevice
+{
+public:
+	RenderDevice(sample_rate_t sampleRate, AudioEngine* audioEngine) :
+		AudioDevice(DEFAULT_CHANNELS, audioEngine)
+	{
+		setSampleRate(sampleRate);
+	}
+};
+
+} // namespace
+
+
+
+
+RenderCoordinator::RenderCoordinator(const QString& projectFile, const QStringList& workers,
+		const AudioEngine::qualitySettings& qualitySettings, sample_rate_t sampleRate, QObject* parent) :
+	QObject(parent),
+	m_projectFile(QFileInfo(projectFile).absoluteFilePath()),
+	m_workerNames(workers),
+	m_qualitySettings(qualitySettings),
+	m_sampleRate(sampleRate)
+{
+}
+
+
+
+
+RenderCoordinator::~RenderCoordinator() = default;
+
+
+
+
+void RenderCoordinator::start()
+{
+	// peak controllers follow the effects of their track, which don't run if it's rendered elsewhere
+	const auto& controllers = Engine::getSong()->controllers();
+	const bool followsTracks = std::any_of(controllers.begin(), controllers.end(),
+		[](const Controller* controller) { return controller->type() == Controller::ControllerType::Peak; });
+	if (followsTracks)
+	{
+		printf("The project uses peak controllers, rendering all tracks here\n");
+	}
+	if (followsTracks || m_workerNames.isEmpty())
+	{
+		QTimer::singleShot(0, this, &RenderCoordinator::finished);
+		return;
+	}
+
+	for (const auto& name : m_workerNames)
+	{
+		auto worker = std::make_unique<Worker>();
+		worker->name = name;
+		worker->socket = new QTcpSocket(this);
+		m_workers.push_back(std::move(worker));
+	}
+
+	// muted tracks aren't rendered at all
+	const auto tracks = renderableTracks();
+	std::size_t next = 0;
+	for (quint32 index = 0; index < tracks.size(); ++index)
+	{
+		if (tracks[index]->isMuted()) { continue; }
+		m_workers[next]->tracks.push_back(index);
+		next = (next + 1) % m_workers.size();
+	}
+
+	for (auto& worker : m_workers)
+	{
+		Worker* w = worker.get();
+		connect(w->socket, &QTcpSocket::connected, this, [this, w] { sendJob(*w); });
+		connect(w->socket, &QTcpSocket::readyRead, this, [this, w] { receive(*w); });
+		connect(w->socket, &QTcpSocket::disconnected, this, [this, w] { fail(*w, tr("Connection closed")); });
+		connect(w->socket, QOverload<QAbstractSocket::SocketError>::of(&QAbstractSocket::error), this,
+			[this, w] { fail(*w, w->socket->errorString()); });
+
+		if (w->tracks.empty())
+		{
+			w->done = true;
+			continue;
+		}
+
+		const auto separator = w->name.lastIndexOf(':');
+		const auto host = separator < 0 ? w->name : w->name.left(separator);
+		const auto port = separator < 0 ? RenderWorker::DefaultPort : w->name.mid(separator + 1).toUShort();
+		w->socket->connectToHost(host, port);
+	}
+
+	if (std::all_of(m_workers.begin(), m_workers.end(), [](const auto& w) { return w->done; }))
+	{
+		QTimer::singleShot(0, this, &RenderCoordinator::finished);
+	}
+}
+
+
+
+
+void RenderCoordinator::sendJob(Worker& worker)
+{
+	QByteArray job;
+	QDataStream stream(&job, QIODevice::WriteOnly);
+	stream << ProtocolMagic << ProtocolVersion << sharedSecret()
+		<< m_projectFile << projectHash(m_projectFile)
+		<< static_cast<quint32>(m_sampleRate)
+		<< static_cast<quint32>(Engine::audioEngine()->maxFramesPerPeriod())
+		<< static_cast<qint32>(m_qualitySettings.interpolation)
+		<< Engine::getSong()->exportLoop()
+		<< static_cast<quint32>(worker.tracks.size());
+	for (const auto index : worker.tracks) { stream << index; }
+
+	sendMessage(worker.socket, Message::Job, job);
+}
+
+
+
+
+void RenderCoordinator::receive(Worker& worker)
+{
+	Message type;
+	QByteArray payload;
+	while (!worker.done && receiveMessage(worker.socket, type, payload, MaxStemSize))
+	{
+		QDataStream stream(payload);
+		switch (type)
+		{
+		case Message::Progress:
+		{
+			stream >> worker.progress;
+			int total = 0;
+			for (const auto& w : m_workers) { total += w->done ? 100 : w->progress; }
+			fprintf(stderr, "\rRendering tracks on %d hosts: %3d%%", static_cast<int>(m_workers.size()),
+				total / static_cast<int>(m_workers.size()));
+			break;
+		}
+		case Message::Stem:
+		{
+			quint32 index = 0;
+			stream >> index;
+			const bool requested = std::find(worker.tracks.begin(), worker.tracks.end(), index) != worker.tracks.end();
+			if (auto audio = FrozenAudio::load(stream); audio && requested) { m_stems[index] = std::move(audio); }
+			break;
+		}
+		case Message::Done:
+			finishWorker(worker);
+			break;
+		case Message::Error:
+		{
+			QString reason;
+			stream >> reason;
+			fail(worker, reason);
+			break;
+		}
+		default:
+			fail(worker, tr("Unexpected message"));
+			break;
+		}
+	}
+}
+
+
+
+
+void RenderCoordinator::fail(Worker& worker, const QString& reason)
+{
+	if (worker.done) { return; }
+
+	printf("\nWorker %s failed, rendering its tracks here: %s\n", qPrintable(worker.name), qPrintable(reason));
+	for (const auto index : worker.tracks) { m_stems.erase(index); }
+	finishWorker(worker);
+}
+
+
+
+
+void RenderCoordinator::finishWorker(Worker& worker)
+{
+	worker.done = true;
+	worker.socket->disconnect(this);
+	worker.socket->abort();
+
+	if (!std::all_of(m_workers.begin(), m_workers.end(), [](const auto& w) { return w->done; })) { return; }
+
+	// the tracks rendered elsewhere are played like cached output while exporting
+	const auto tracks = renderableTracks();
+	Engine::audioEngine()->requestChangeInModel();
+	for (const auto& [index, audio] : m_stems)
+	{
+		if (index < tracks.size()) { tracks[index]->audioBusHandle()->setRenderCache(audio); }
+	}
+	Engine::audioEngine()->doneChangeInModel();
+
+	printf("\n%zu of %zu tracks rendered on other hosts\n", m_stems.size(), tracks.size());
+	emit finished();
+}
+
+
+
+
+/**
+ * Renders the song on its own thread, like an export, while the tracks of
+ * the job are captured
+ */
+class RenderWorker::Renderer : public QThread
+{
+public:
+	std::atomic_int progress = 0;
+	std::atomic_bool abort = false;
+
+private:
+	void run() override
+	{
+		Engine::getSong()->startExport();
+		// Skip first empty buffer.
+		Engine::audioEngine()->nextBuffer();
+
+		Engine::audioEngine()->startProcessing(false);
+
+		while (!Engine::getSong()->isExportDone() && !abort)
+		{
+			Engine::audioEngine()->nextBuffer();
+			progress = Engine::getSong()->getExportProgress();
+		}
+
+		Engine::audioEngine()->stopProcessing();
+		Engine::getSong()->stopExport();
+	}
+};
+
+
+
+
+RenderWorker::RenderWorker(QObject* parent) :
+	QObject(parent)
+{
+	connect(&m_server, &QTcpServer::newConnection, this, &RenderWorker::acceptConnections);
+	connect(&m_progressTimer, &QTimer::timeout, this, &RenderWorker::sendProgress);
+}
+
+
+
+
+RenderWorker::~RenderWorker()
+{
+	if (m_renderer)
+	{
+		m_renderer->abort = true;
+		m_renderer->wait();
+	}
+}
+
+
+
+
+bool RenderWorker::listen(const QHostAddress& address, quint16 port)
+{
+	// anyone reaching the port could have any file on this host rendered
+	if (!address.isLoopback() && sharedSecret().isEmpty())
+	{
+		printf("Set LMMS_RENDER_SECRET to listen on other interfaces than the loopback one\n");
+		return false;
+	}
+	return m_server.listen(address, port);
+}
+
+
+
+
+void RenderWorker::acceptConnections()
+{
+	while (QTcpSocket* socket = m_server.nextPendingConnection())
+	{
+		connect(socket, &QTcpSocket::readyRead, this, [this, socket] { receive(socket); });
+		connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+		connect(socket, &QTcpSocket::disconnected, this, [this, socket]
+		{
+			// nobody is waiting for the job anymore
+			if (m_renderer && socket == m_coordinator) { m_renderer->abort = true; }
+		});
+	}
+}
+
+
+
+
+void RenderWorker::receive(QTcpSocket* socket)
+{
+	Message type;
+	QByteArray payload;
+	while (receiveMessage(socket, type, payload, MaxJobSize))
+	{
+		if (type == Message::Job) { startJob(socket, payload); }
+	}
+}
+
+
+
+
+void RenderWorker::startJob(QTcpSocket* socket, const QByteArray& job)
+{
+	const auto refuse = [socket](const QString& reason)
+	{
+		QByteArray payload;
+		QDataStream stream(&payload, QIODevice::WriteOnly);
+		stream << reason;
+		sendMessage(socket, Message::Error, payload);
+		printf("Refused job: %s\n", qPrintable(reason));
+	};
+
+	if (m_renderer) { return refuse(tr("Busy with another job")); }
+
+	QDataStream stream(job);
+	quint32 magic = 0, version = 0, sampleRate = 0, framesPerPeriod = 0, count = 0;
+	qint32 interpolation = 0;
+	QString projectFile;
+	QByteArray secret, hash;
+	bool exportLoop = false;
+	stream >> magic >> version;
+	if (magic != ProtocolMagic || version != ProtocolVersion) { return refuse(tr("Incompatible version")); }
+	stream >> secret;
+	if (secret != sharedSecret()) { return refuse(tr("Wrong secret")); }
+	stream >> projectFile >> hash >> sampleRate >> framesPerPeriod >> interpolation >> exportLoop >> count;
+
+	// checked before allocating the indices, which the rest of the job has to hold
+	const auto remaining = job.size() - stream.device()->pos();
+	if (stream.status() != QDataStream::Ok || count > remaining / sizeof(quint32))
+	{
+		return refuse(tr("Malformed job"));
+	}
+
+	auto indices = std::vector<quint32>(count);
+	for (auto& index : indices) { stream >> index; }
+	if (stream.status() != QDataStream::Ok) { return refuse(tr("Malformed job")); }
+
+	// the tracks are identified by their position in the project
+	if (projectHash(projectFile) != hash) { return refuse(tr("%1 differs from the coordinator's").arg(projectFile)); }
+	if (framesPerPeriod != Engine::audioEngine()->maxFramesPerPeriod())
+	{
+		return refuse(tr("Started with a block size of %1 instead of %2")
+			.arg(Engine::audioEngine()->maxFramesPerPeriod()).arg(framesPerPeriod));
+	}
+
+	printf("Rendering %u tracks of %s\n", count, qPrintable(projectFile));
+	Song* song = Engine::getSong();
+	song->loadProject(projectFile);
+
+	const auto tracks = renderableTracks();
+	if (std::any_of(indices.begin(), indices.end(), [&tracks](quint32 index) { return index >= tracks.size(); }))
+	{
+		return refuse(tr("Malformed job"));
+	}
+
+	// only the tracks of the job are heard
+	for (const TrackContainer* container : trackContainers())
+	{
+		for (Track* track : container->tracks())
+		{
+			const auto it = std::find(tracks.begin(), tracks.end(), track);
+			const auto index = static_cast<quint32>(it - tracks.begin());
+			const bool inJob = it != tracks.end() && std::find(indices.begin(), indices.end(), index) != indices.end();
+			if (!inJob && !track->isMuted()
+				&& (track->type() == Track::Type::Instrument || track->type() == Track::Type::Sample))
+			{
+				track->setMuted(true);
+				m_muted.push_back(track);
+			}
+		}
+	}
+
+	song->setExportLoop(exportLoop);
+	song->setRenderBetweenMarkers(false);
+	song->setLoopRenderCount(1);
+
+	AudioEngine* audioEngine = Engine::audioEngine();
+	audioEngine->storeAudioDevice();
+	audioEngine->setAudioDevice(new RenderDevice(sampleRate, audioEngine),
+		AudioEngine::qualitySettings(static_cast<AudioEngine::qualitySettings::Interpolation>(interpolation)),
+		false, false);
+
+	for (const auto index : indices)
+	{
+		AudioBusHandle* busHandle = tracks[index]->audioBusHandle();
+		auto audio = std::make_shared<FrozenAudio>(audioEngine->maxFramesPerPeriod(), audioEngine->outputSampleRate());
+		audio->setLatency(busHandle->latency());
+		busHandle->setFreezeCapture(audio.get());
+		m_stems.emplace_back(index, std::move(audio));
+	}
+
+	m_coordinator = socket;
+	m_progress = 0;
+	m_renderer = std::make_unique<Renderer>();
+	connect(m_renderer.get(), &QThread::finished, this, &RenderWorker::finishJob);
+	m_renderer->start(
+#ifndef LMMS_BUILD_WIN32
+		QThread::HighPriority
+#endif
+	);
+	m_progressTimer.start(500);
+}
+
+
+
+
+void RenderWorker::sendProgress()
+{
+	if (!m_renderer || !m_coordinator || m_renderer->progress == m_progress) { return; }
+
+	m_progress = m_renderer->progress;
+	QByteArray payload;
+	QDataStream stream(&payload, QIODevice::WriteOnly);
+	stream << m_progress;
+	sendMessage(m_coordinator, Message::Progress, payload);
+}
+
+
+
+
+void RenderWorker::finishJob()
+{
+	m_progressTimer.stop();
+	m_renderer->wait();
+
+	const auto tracks = renderableTracks();
+	for (const auto& [index, audio] : m_stems)
+	{
+		tracks[index]->audioBusHandle()->setFreezeCapture(nullptr);
+	}
+	Engine::audioEngine()->restoreAudioDevice();  // Also deletes audio dev.
+
+	for (Track* track : m_muted)
+	{
+		track->setMuted(false);
+	}
+	m_muted.clear();
+
+	if (m_coordinator && !m_renderer->abort)
+	{
+		for (const auto& [index, audio] : m_stems)
+		{
+			QByteArray payload;
+			QDataStream stream(&payload, QIODevice::WriteOnly);
+			stream << index;
+			audio->save(stream);
+			sendMessage(m_coordinator, Message::Stem, payload);
+		}
+		sendMessage(m_coordinator, Message::Done);
+		printf("Sent %zu tracks\n", m_stems.size());
+	}
+
+	m_stems.clear();
+	m_coordinator.clear();
+	m_renderer.reset();
+}
+
+} // namespace lmms
@@ -25,9 +25,13 @@
 #include <QDir>
 #include <QRegularExpression>
 
+#include <algorithm>
+
 #include "RenderManager.h"
 
+#include "InstrumentTrack.h"
 #include "PatternStore.h"
+#include "SampleTrack.h"
 #include "Song.h"
 
 
@@ -55,6 +59,21 @@ RenderManager::~RenderManager()
 	Engine::audioEngine()->changeQuality( m_oldQualitySettings );
 }
 
+void RenderManager::addFormat(ProjectRenderer::ExportFileFormat fmt)
+{
+	addFormat(fmt, m_outputSettings);
+}
+
+void RenderManager::addFormat(ProjectRenderer::ExportFileFormat fmt, const OutputSettings& outputSettings)
+{
+	// each format is written to one file per output, named by its extension
+	const auto sameFormat = [fmt](const auto& extra) { return extra.first == fmt; };
+	if (fmt != m_format && std::none_of(m_extraFormats.begin(), m_extraFormats.end(), sameFormat))
+	{
+		m_extraFormats.emplace_back(fmt, outputSettings);
+	}
+}
+
 void RenderManager::abortProcessing()
 {
 	if ( m_activeRenderer ) {
@@ -95,8 +114,8 @@ void RenderManager::renderNextTrack()
 	}
 }
 
-// Render the song into individual tracks
-void RenderManager::renderTracks()
+// Find all tracks to render into individual files
+void RenderManager::collectTracksToRender()
 {
 	const TrackContainer::TrackList& tl = Engine::getSong()->tracks();
 
@@ -126,6 +145,13 @@ void RenderManager::renderTracks()
 		}
 	}
 
+}
+
+// Render the song into individual tracks
+void RenderManager::renderTracks()
+{
+	collectTracksToRender();
+
 	// copy the list of unmuted tracks into our rendering queue.
 	// we need to remember which tracks were unmuted to restore state at the end.
 	m_tracksToRender = m_unmuted;
@@ -133,13 +159,27 @@ void RenderManager::renderTracks()
 	renderNextTrack();
 }
 
+// Render the song into individual tracks, taking the output of all of them
+// at once instead of muting all others while rendering each track
+void RenderManager::renderTracksSinglePass()
+{
+	collectTracksToRender();
+
+	// nothing gets muted, so there's nothing to restore afterwards
+	std::vector<Track*> stems;
+	stems.swap(m_unmuted);
+
+	const QString extension = ProjectRenderer::getFileExtensionFromFormat(m_format);
+	render(QDir(m_outputPath).filePath("Master" + extension), stems);
+}
+
 // Render the song into a single track
 void RenderManager::renderProject()
 {
 	render( m_outputPath );
 }
 
-void RenderManager::render(QString outputPath)
+void RenderManager::render(QString outputPath, const std::vector<Track*>& stems)
 {
 	m_activeRenderer = std::make_unique<ProjectRenderer>(
 			m_qualitySettings,
@@ -147,6 +187,32 @@ void RenderManager::render(QString outputPath)
 			m_format,
 			outputPath);
 
+	for (const auto& [fmt, outputSettings] : m_extraFormats)
+	{
+		if (!m_activeRenderer->addOutput(fmt, outputSettings, pathForFormat(outputPath, fmt)))
+		{
+			qDebug("Renderer failed to acquire a file device for %s!", qPrintable(pathForFormat(outputPath, fmt)));
+		}
+	}
+
+	// number the stems just like renderTracks() does
+	for (std::size_t i = 0; i < stems.size(); ++i)
+	{
+		AudioBusHandle* busHandle = stems[i]->type() == Track::Type::Instrument
+			? static_cast<InstrumentTrack*>(stems[i])->audioBusHandle()
+			: static_cast<SampleTrack*>(stems[i])->audioBusHandle();
+
+		const QString stemPath = pathForTrack(stems[i], i + 1);
+		if (!m_activeRenderer->addStem(busHandle, stemPath, m_format, m_outputSettings))
+		{
+			qDebug("Renderer failed to acquire a file device for track %s!", qPrintable(stems[i]->name()));
+		}
+		for (const auto& [fmt, outputSettings] : m_extraFormats)
+		{
+			m_activeRenderer->addStem(busHandle, pathForFormat(stemPath, fmt), fmt, outputSettings);
+		}
+	}
+
 	if( m_activeRenderer->isReady() )
 	{
 		// pass progress signals through
@@ -188,6 +254,18 @@ QString RenderManager::pathForTrack(const Track *track, int num)
 	return QDir(m_outputPath).filePath(name);
 }
 
+// Swap the extension of the main format in a path for the one of another format
+QString RenderManager::pathForFormat(const QString& path, ProjectRenderer::ExportFileFormat fmt) const
+{
+	const QString extension = ProjectRenderer::getFileExtensionFromFormat(m_format);
+	QString base = path;
+	if (base.endsWith(extension, Qt::CaseInsensitive))
+	{
+		base.chop(extension.size());
+	}
+	return base + ProjectRenderer::getFileExtensionFromFormat(fmt);
+}
+
 void RenderManager::updateConsoleProgress()
 {
 	if ( m_activeRenderer )
@@ -0,0 +1,227 @@
+/*
+ * RenderServer.cpp - renders projects sent over a local socket, one after another
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "RenderServer.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QLocalSocket>
+
+#include <cstdio>
+
+#include "OutputSettings.h"
+#include "RenderManager.h"
+#include "Song.h"
+
+namespace lmms
+{
+
+RenderServer::RenderServer(const AudioEngine::qualitySettings& qualitySettings, QObject* parent) :
+	QObject(parent),
+	m_qualitySettings(qualitySettings)
+{
+	connect(&m_server, &QLocalServer::newConnection, this, &RenderServer::acceptConnections);
+}
+
+
+
+
+RenderServer::~RenderServer()
+{
+	if (m_renderManager) { m_renderManager->abortProcessing(); }
+}
+
+
+
+
+bool RenderServer::listen(const QString& name)
+{
+	// the server renders any project it gets and writes wherever it is told to, which only
+	// the user running it may ask for
+	m_server.setSocketOptions(QLocalServer::UserAccessOption);
+	if (m_server.listen(name)) { return true; }
+
+	// only the socket file of a server which crashed is in the way, as listening fails otherwise
+	if (m_server.serverError() != QAbstractSocket::AddressInUseError) { return false; }
+
+	QLocalSocket probe;
+	probe.connectToServer(name);
+	if (probe.waitForConnected(1000)) { return false; }
+
+	QLocalServer::removeServer(name);
+	return m_server.listen(name);
+}
+
+
+
+
+void RenderServer::acceptConnections()
+{
+	while (QLocalSocket* socket = m_server.nextPendingConnection())
+	{
+		connect(socket, &QLocalSocket::readyRead, this, [this, socket] { receive(socket); });
+		connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+	}
+}
+
+
+
+
+void RenderServer::receive(QLocalSocket* socket)
+{
+	while (socket->canReadLine())
+	{
+		const auto line = socket->readLine().trimmed();
+		if (line.isEmpty()) { continue; }
+
+		auto job = Job{++m_lastId, socket, {}};
+
+		auto error = QJsonParseError{};
+		const auto document = QJsonDocument::fromJson(line, &error);
+		if (!document.isObject())
+		{
+			fail(job, error.error != QJsonParseError::NoError ? error.errorString() : tr("Expected an object"));
+			continue;
+		}
+
+		job.request = document.object();
+		if (job.request.value("project").toString().isEmpty() || job.request.value("output").toString().isEmpty())
+		{
+			fail(job, tr("Both \"project\" and \"output\" are required"));
+			continue;
+		}
+
+		m_queue.push_back(job);
+		reply(job, {{"status", "queued"}, {"position", static_cast<int>(m_queue.size()) - 1}});
+	}
+
+	if (!m_job) { startNextJob(); }
+}
+
+
+
+
+void RenderServer::startNextJob()
+{
+	while (!m_job && !m_queue.empty())
+	{
+		auto job = std::make_unique<Job>(m_queue.front());
+		m_queue.pop_front();
+
+		const auto projectFile = job->request.value("project").toString();
+		const auto outputFile = job->request.value("output").toString();
+		if (!QFileInfo{projectFile}.isFile())
+		{
+			fail(*job, tr("%1 does not exist").arg(projectFile));
+			continue;
+		}
+
+		m_jobTimer.start();
+		m_writeStats = AudioFileDevice::writeStats();
+		printf("Rendering %s to %s\n", qPrintable(projectFile), qPrintable(outputFile));
+
+		Song* song = Engine::getSong();
+		song->loadProject(projectFile);
+		if (song->isEmpty())
+		{
+			fail(*job, tr("%1 is empty").arg(projectFile));
+			song->clearProject();
+			continue;
+		}
+		song->setExportLoop(job->request.value("loop").toBool(false));
+
+		auto outputSettings = OutputSettings{
+			static_cast<sample_rate_t>(job->request.value("samplerate").toInt(44100)),
+			static_cast<bitrate_t>(job->request.value("bitrate").toInt(160)),
+			OutputSettings::BitDepth::Depth16Bit,
+			OutputSettings::StereoMode::JointStereo};
+		const auto format = ProjectRenderer::getFileFormatFromExtension("." + QFileInfo{outputFile}.suffix());
+
+		// whether the job succeeded is told by the output file
+		QFile::remove(outputFile);
+
+		m_job = std::move(job);
+		m_progress = 0;
+		m_renderManager = std::make_unique<RenderManager>(m_qualitySettings, outputSettings, format, outputFile);
+		connect(m_renderManager.get(), &RenderManager::progressChanged, this, [this](int progress)
+		{
+			if (progress == m_progress) { return; }
+			m_progress = progress;
+			reply(*m_job, {{"status", "progress"}, {"progress", progress}});
+		});
+		// the manager is deleted in finishJob(), which can't be done while it emits the signal
+		connect(m_renderManager.get(), &RenderManager::finished, this, &RenderServer::finishJob, Qt::QueuedConnection);
+
+		reply(*m_job, {{"status", "rendering"}});
+		m_renderManager->renderProject();
+	}
+}
+
+
+
+
+void RenderServer::finishJob()
+{
+	m_renderManager.reset();
+
+	const auto outputFile = m_job->request.value("output").toString();
+	if (QFileInfo{outputFile}.exists())
+	{
+		const auto seconds = m_jobTimer.elapsed() / 1000.;
+		const auto writeStats = AudioFileDevice::writeStats();
+		const auto written = static_cast<qint64>(writeStats.bytes - m_writeStats.bytes);
+		const auto writeSeconds = writeStats.seconds - m_writeStats.seconds;
+		reply(*m_job, {{"status", "done"}, {"seconds", seconds}, {"written", written}, {"writeSeconds", writeSeconds}});
+		printf("Done after %.1f s, wrote %.1f MiB in %.2f s\n", seconds, written / double{1 << 20}, writeSeconds);
+	}
+	else { fail(*m_job, tr("Could not write %1").arg(outputFile)); }
+
+	// the project isn't needed anymore, but the samples it used stay cached for the next jobs
+	Engine::getSong()->clearProject();
+
+	m_job.reset();
+	startNextJob();
+}
+
+
+
+
+void RenderServer::reply(const Job& job, QJsonObject message)
+{
+	// the job is rendered anyway if the client is gone, e.g. a script which doesn't wait for it
+	if (!job.client) { return; }
+
+	message.insert("id", static_cast<qint64>(job.id));
+	job.client->write(QJsonDocument{message}.toJson(QJsonDocument::Compact) + '\n');
+}
+
+
+
+
+void RenderServer::fail(const Job& job, const QString& error)
+{
+	reply(job, {{"status", "failed"}, {"error", error}});
+	printf("Job %llu failed: %s\n", static_cast<unsigned long long>(job.id), qPrintable(error));
+}
+
+} // namespace lmms
@@ -33,7 +33,7 @@ namespace lmms
 
  
 RingBuffer::RingBuffer( f_cnt_t size ) : 
-	m_fpp( Engine::audioEngine()->framesPerPeriod() ),
+	m_fpp( Engine::audioEngine()->maxFramesPerPeriod() ),
 	m_samplerate( Engine::audioEngine()->outputSampleRate() ),
 	m_size( size + m_fpp )
 {
@@ -44,7 +44,7 @@ RingBuffer::RingBuffer( f_cnt_t size ) :
 
 
 RingBuffer::RingBuffer( float size ) : 
-	m_fpp( Engine::audioEngine()->framesPerPeriod() ),
+	m_fpp( Engine::audioEngine()->maxFramesPerPeriod() ),
 	m_samplerate( Engine::audioEngine()->outputSampleRate() )
 {
 	m_size = msToFrames( size ) + m_fpp;
@@ -102,7 +102,8 @@ void RingBuffer::setSamplerateAware( bool b )
 
 void RingBuffer::advance()
 {
-	m_position = ( m_position + m_fpp ) % m_size;
+	const fpp_t fpp = Engine::audioEngine()->framesPerPeriod();
+	m_position = ( m_position + fpp ) % m_size;
 }
 
 
@@ -120,15 +121,16 @@ void RingBuffer::movePosition( float amount )
 
 void RingBuffer::pop( SampleFrame* dst )
 {
-	if( m_position + m_fpp <= m_size ) // we won't go over the edge so we can just memcpy here
+	const fpp_t fpp = Engine::audioEngine()->framesPerPeriod();
+	if( m_position + fpp <= m_size ) // we won't go over the edge so we can just memcpy here
 	{
-		memcpy( dst, & m_buffer [ m_position ], m_fpp * sizeof( SampleFrame ) );
-		zeroSampleFrames(&m_buffer[m_position], m_fpp);
+		memcpy( dst, & m_buffer [ m_position ], fpp * sizeof( SampleFrame ) );
+		zeroSampleFrames(&m_buffer[m_position], fpp);
 	}
 	else
 	{
 		f_cnt_t first = m_size - m_position;
-		f_cnt_t second = m_fpp - first;
+		f_cnt_t second = fpp - first;
 		
 		memcpy( dst, & m_buffer [ m_position ], first * sizeof( SampleFrame ) );
 		zeroSampleFrames(&m_buffer[m_position], first);
@@ -137,22 +139,23 @@ void RingBuffer::pop( SampleFrame* dst )
 		zeroSampleFrames(m_buffer, second);
 	}
 	
-	m_position = ( m_position + m_fpp ) % m_size;
+	m_position = ( m_position + fpp ) % m_size;
 }
 
 
 void RingBuffer::read( SampleFrame* dst, f_cnt_t offset )
 {
+	const fpp_t fpp = Engine::audioEngine()->framesPerPeriod();
 	f_cnt_t pos = ( m_position + offset ) % m_size;
 	
-	if( pos + m_fpp <= m_size ) // we won't go over the edge so we can just memcpy here
+	if( pos + fpp <= m_size ) // we won't go over the edge so we can just memcpy here
 	{
-		memcpy( dst, & m_buffer [pos], m_fpp * sizeof( SampleFrame ) );
+		memcpy( dst, & m_buffer [pos], fpp * sizeof( SampleFrame ) );
 	}
 	else
 	{
 		f_cnt_t first = m_size - pos;
-		f_cnt_t second = m_fpp - first;
+		f_cnt_t second = fpp - first;
 		
 		memcpy( dst, & m_buffer [pos], first * sizeof( SampleFrame ) );
 		
@@ -196,7 +199,7 @@ void RingBuffer::read( SampleFrame* dst, float offset, f_cnt_t length )
 void RingBuffer::write( SampleFrame* src, f_cnt_t offset, f_cnt_t length )
 {
 	const f_cnt_t pos = ( m_position + offset ) % m_size;
-	if( length == 0 ) { length = m_fpp; }
+	if( length == 0 ) { length = Engine::audioEngine()->framesPerPeriod(); }
 	
 	if( pos + length <= m_size ) // we won't go over the edge so we can just memcpy here
 	{
@@ -223,7 +226,7 @@ void RingBuffer::write( SampleFrame* src, float offset, f_cnt_t length )
 void RingBuffer::writeAdding( SampleFrame* src, f_cnt_t offset, f_cnt_t length )
 {
 	const f_cnt_t pos = ( m_position + offset ) % m_size;
-	if( length == 0 ) { length = m_fpp; }
+	if( length == 0 ) { length = Engine::audioEngine()->framesPerPeriod(); }
 	
 	if( pos + length <= m_size ) // we won't go over the edge so we can just memcpy here
 	{
@@ -251,7 +254,7 @@ void RingBuffer::writeAddingMultiplied( SampleFrame* src, f_cnt_t offset, f_cnt_
 {
 	const f_cnt_t pos = ( m_position + offset ) % m_size;
 	//qDebug( "pos %d m_pos %d ofs %d siz %d", pos, m_position, offset, m_size );
-	if( length == 0 ) { length = m_fpp; }
+	if( length == 0 ) { length = Engine::audioEngine()->framesPerPeriod(); }
 	
 	if( pos + length <= m_size ) // we won't go over the edge so we can just memcpy here
 	{
@@ -279,7 +282,7 @@ void RingBuffer::writeAddingMultiplied( SampleFrame* src, float offset, f_cnt_t
 void RingBuffer::writeSwappedAddingMultiplied( SampleFrame* src, f_cnt_t offset, f_cnt_t length, float level )
 {
 	const f_cnt_t pos = ( m_position + offset ) % m_size;
-	if( length == 0 ) { length = m_fpp; }
+	if( length == 0 ) { length = Engine::audioEngine()->framesPerPeriod(); }
 	
 	if( pos + length <= m_size ) // we won't go over the edge so we can just memcpy here
 	{
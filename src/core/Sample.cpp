@@ -24,6 +24,8 @@
 
 #include "Sample.h"
 
+#include "SampleCache.h"
+#include "Song.h"
 #include "lmms_math.h"
 
 #include <cassert>
@@ -31,7 +33,7 @@
 namespace lmms {
 
 Sample::Sample(const QString& audioFile)
-	: m_buffer(std::make_shared<SampleBuffer>(audioFile))
+	: m_buffer(SampleCache::get(audioFile))
 	, m_startFrame(0)
 	, m_endFrame(m_buffer->size())
 	, m_loopStartFrame(0)
@@ -126,24 +128,69 @@ bool Sample::play(SampleFrame* dst, PlaybackState* state, size_t numFrames, floa
 	const auto pastBounds = state->m_frameIndex >= m_endFrame || (state->m_frameIndex < 0 && state->m_backwards);
 	if (loopMode == Loop::Off && pastBounds) { return false; }
 
-	const auto outputSampleRate = Engine::audioEngine()->outputSampleRate() * m_frequency / desiredFrequency;
+	const auto engineSampleRate = Engine::audioEngine()->outputSampleRate();
+	const auto outputSampleRate = engineSampleRate * m_frequency / desiredFrequency;
 	const auto inputSampleRate = m_buffer->sampleRate();
 	const auto resampleRatio = outputSampleRate / inputSampleRate;
 	const auto marginSize = s_interpolationMargins[state->resampler().interpolationMode()];
 
 	state->m_frameIndex = std::max<int>(m_startFrame, state->m_frameIndex);
 
-	auto playBuffer = std::vector<SampleFrame>(numFrames / resampleRatio + marginSize);
-	playRaw(playBuffer.data(), playBuffer.size(), state, loopMode);
+	// streamed buffers are read ahead by a prefetch thread, only forwards though
+	if (m_buffer->streamed() && !m_reversed)
+	{
+		const auto position = static_cast<std::size_t>(std::max(state->m_frameIndex, 0));
+		if (state->m_stream.buffer() != m_buffer.get()) { state->m_stream.open(m_buffer, position); }
+		if (state->m_stream.isOpen()) { state->m_stream.seek(position); }
+	}
+	else { state->m_stream.close(); }
+
+	// libsamplerate has a considerable overhead per call, so the polyphase
+	// resampler is used instead whenever it can handle the ratio, and nothing
+	// at all if the sample is played at its own pitch and rate (see SampleBuffer::resampleOnLoad())
+	using Resampling = PlaybackState::Resampling;
+	const auto resampling = state->m_varyingPitch ? Resampling::Generic
+		: inputSampleRate == engineSampleRate && m_frequency == desiredFrequency ? Resampling::None
+		: PolyphaseResampler::supports(state->m_polyphaseResampler.interpolationMode(), resampleRatio)
+			? Resampling::Polyphase
+			: Resampling::Generic;
+	if (resampling != state->m_resampling)
+	{
+		// whatever the other resampler has buffered is outdated
+		if (resampling == Resampling::Polyphase) { state->m_polyphaseResampler.reset(); }
+		else if (resampling == Resampling::Generic) { state->resampler().reset(); }
+		state->m_resampling = resampling;
+	}
 
-	state->resampler().setRatio(resampleRatio);
+	if (resampling == Resampling::None)
+	{
+		// frames past the end aren't written
+		std::fill_n(dst, numFrames, SampleFrame{});
+		playRaw(dst, numFrames, state, loopMode);
+		advance(state, numFrames, loopMode);
+	}
+	else
+	{
+		auto playBuffer = std::vector<SampleFrame>(numFrames / resampleRatio + marginSize);
+		playRaw(playBuffer.data(), playBuffer.size(), state, loopMode);
 
-	const auto resampleResult
-		= state->resampler().resample(&playBuffer[0][0], playBuffer.size(), &dst[0][0], numFrames, resampleRatio);
-	advance(state, resampleResult.inputFramesUsed, loopMode);
+		auto resampleResult = AudioResampler::ProcessResult{};
+		if (resampling == Resampling::Polyphase)
+		{
+			resampleResult = state->m_polyphaseResampler.resample(
+				playBuffer.data(), playBuffer.size(), dst, numFrames, resampleRatio);
+		}
+		else
+		{
+			state->resampler().setRatio(resampleRatio);
+			resampleResult = state->resampler().resample(
+				&playBuffer[0][0], playBuffer.size(), &dst[0][0], numFrames, resampleRatio);
+		}
+		advance(state, resampleResult.inputFramesUsed, loopMode);
 
-	const auto outputFrames = static_cast<f_cnt_t>(resampleResult.outputFramesGenerated);
-	if (outputFrames < numFrames) { std::fill_n(dst + outputFrames, numFrames - outputFrames, SampleFrame{}); }
+		const auto outputFrames = static_cast<f_cnt_t>(resampleResult.outputFramesGenerated);
+		if (outputFrames < numFrames) { std::fill_n(dst + outputFrames, numFrames - outputFrames, SampleFrame{}); }
+	}
 
 	if (!approximatelyEqual(m_amplification, 1.0f))
 	{
@@ -176,38 +223,68 @@ void Sample::playRaw(SampleFrame* dst, size_t numFrames, const PlaybackState* st
 {
 	if (m_buffer->size() < 1) { return; }
 
-	auto index = state->m_frameIndex;
-	auto backwards = state->m_backwards;
-
-	for (size_t i = 0; i < numFrames; ++i)
+	// large files are decoded in the background: when rendering, wait for
+	// them to be available, otherwise play what hasn't been decoded yet as silence
+	if (m_buffer->decodedFrames() < m_buffer->size() && Engine::getSong()->isExporting())
 	{
-		switch (loopMode)
+		m_buffer->waitUntilDecoded();
+	}
+	const auto data = m_buffer->storageData();
+	const auto decodedFrames = static_cast<int>(m_buffer->decodedFrames());
+	const auto size = static_cast<int>(m_buffer->size());
+	const auto preload = m_buffer->preloadedData();
+	const auto preloadedFrames = static_cast<int>(m_buffer->preloadedFrames());
+	const auto stream = state->m_stream.isOpen() ? &state->m_stream : nullptr;
+
+	// instantiated for every storage format, so the frames are converted inline
+	const auto fetch = [&]<SampleBuffer::Storage S>() {
+		auto index = state->m_frameIndex;
+		auto backwards = state->m_backwards;
+
+		for (size_t i = 0; i < numFrames; ++i)
 		{
-		case Loop::Off:
-			if (index < 0 || index >= m_endFrame) { return; }
-			break;
-		case Loop::On:
-			if (index < m_loopStartFrame && backwards) { index = m_loopEndFrame - 1; }
-			else if (index >= m_loopEndFrame) { index = m_loopStartFrame; }
-			break;
-		case Loop::PingPong:
-			if (index < m_loopStartFrame && backwards)
+			switch (loopMode)
 			{
-				index = m_loopStartFrame;
-				backwards = false;
+			case Loop::Off:
+				if (index < 0 || index >= m_endFrame) { return; }
+				break;
+			case Loop::On:
+				if (index < m_loopStartFrame && backwards) { index = m_loopEndFrame - 1; }
+				else if (index >= m_loopEndFrame) { index = m_loopStartFrame; }
+				break;
+			case Loop::PingPong:
+				if (index < m_loopStartFrame && backwards)
+				{
+					index = m_loopStartFrame;
+					backwards = false;
+				}
+				else if (index >= m_loopEndFrame)
+				{
+					index = m_loopEndFrame - 1;
+					backwards = true;
+				}
+				break;
+			default:
+				break;
 			}
-			else if (index >= m_loopEndFrame)
+
+			const auto frame = m_reversed ? size - index - 1 : index;
+			if (frame < preloadedFrames) { dst[i] = preload[frame]; }
+			else if (!stream || !stream->read(static_cast<std::size_t>(frame), dst[i]))
 			{
-				index = m_loopEndFrame - 1;
-				backwards = true;
+				// not read ahead (yet), which may have to wait for the disk
+				dst[i] = frame < decodedFrames ? SampleBuffer::frameAt<S>(data, frame) : SampleFrame{};
 			}
-			break;
-		default:
-			break;
+			backwards ? --index : ++index;
 		}
+	};
 
-		dst[i] = m_buffer->data()[m_reversed ? m_buffer->size() - index - 1 : index];
-		backwards ? --index : ++index;
+	switch (m_buffer->storage())
+	{
+	case SampleBuffer::Storage::Float32: fetch.template operator()<SampleBuffer::Storage::Float32>(); break;
+	case SampleBuffer::Storage::Int16: fetch.template operator()<SampleBuffer::Storage::Int16>(); break;
+	case SampleBuffer::Storage::Int24: fetch.template operator()<SampleBuffer::Storage::Int24>(); break;
+	case SampleBuffer::Storage::Float16: fetch.template operator()<SampleBuffer::Storage::Float16>(); break;
 	}
 }
 
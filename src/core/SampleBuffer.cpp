@@ -23,28 +23,440 @@
  */
 
 #include "SampleBuffer.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryFile>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <condition_variable>
 #include <cstring>
+#include <mutex>
+#include <optional>
+#include <samplerate.h>
 
+#include "ConfigManager.h"
 #include "PathUtil.h"
+#include "PerfLog.h"
+#include "RealtimeMemory.h"
 #include "SampleDecoder.h"
+#include "SampleStream.h"
+#include "ThreadPool.h"
 
 namespace lmms {
 
+namespace {
+
+//! Files taking up more than this once decoded are always decoded in the
+//! background, and kept in a file mapped into memory
+constexpr auto StreamingThreshold = std::size_t{64} * 1024 * 1024;
+
+//! Number of frames decoded at once in the background
+constexpr auto StreamingChunkFrames = std::size_t{65536};
+
+//! Length of the beginning of files decoded for streaming which is kept in memory, so notes can start
+//! playing before the prefetch thread has read ahead
+constexpr auto StreamingPreloadMilliseconds = std::size_t{250};
+
+auto preloadFrames(SampleBuffer::Decoding decoding, std::size_t frames, sample_rate_t sampleRate) -> std::size_t
+{
+	if (decoding != SampleBuffer::Decoding::Streaming) { return 0; }
+	return std::min(frames, sampleRate * StreamingPreloadMilliseconds / 1000);
+}
+
+//! Converts @p count frames from @p in to @p storage
+void storeFrames(SampleBuffer::Storage storage, const SampleFrame* in, std::size_t count, std::byte* out)
+{
+	using Storage = SampleBuffer::Storage;
+
+	const auto toInteger = [](float value, float scale, long max) {
+		return std::clamp(std::lrint(value * scale), -max - 1, max);
+	};
+
+	switch (storage)
+	{
+	case Storage::Float32:
+		std::memcpy(out, in, count * sizeof(SampleFrame));
+		break;
+	case Storage::Int16:
+		for (auto i = std::size_t{0}; i < count; ++i, out += 4)
+		{
+			const auto values = std::array<std::int16_t, 2>{
+				static_cast<std::int16_t>(toInteger(in[i].left(), 32768.f, 32767)),
+				static_cast<std::int16_t>(toInteger(in[i].right(), 32768.f, 32767))};
+			std::memcpy(out, values.data(), sizeof(values));
+		}
+		break;
+	case Storage::Int24:
+		for (auto i = std::size_t{0}; i < count; ++i)
+		{
+			for (const auto value : {in[i].left(), in[i].right()})
+			{
+				const auto sample = static_cast<std::uint32_t>(toInteger(value, 8388608.f, 8388607));
+				*out++ = static_cast<std::byte>(sample);
+				*out++ = static_cast<std::byte>(sample >> 8);
+				*out++ = static_cast<std::byte>(sample >> 16);
+			}
+		}
+		break;
+	case Storage::Float16:
+		for (auto i = std::size_t{0}; i < count; ++i, out += 4)
+		{
+			const auto values = std::array<std::uint16_t, 2>{floatToHalf(in[i].left()), floatToHalf(in[i].right())};
+			std::memcpy(out, values.data(), sizeof(values));
+		}
+		break;
+	}
+}
+
+struct WaveData
+{
+	qint64 offset;
+	qint64 bytes;
+	sample_rate_t sampleRate;
+};
+
+//! Finds the frames of a WAV file with 32 bit float stereo frames, which can be used as SampleFrames as they are
+auto floatWaveData(QFile& file) -> std::optional<WaveData>
+{
+	const auto readUInt = [&file](int bytes) {
+		auto value = std::uint32_t{0};
+		auto data = std::array<unsigned char, 4>{};
+		if (file.read(reinterpret_cast<char*>(data.data()), bytes) != bytes) { return std::optional<std::uint32_t>{}; }
+		for (auto i = bytes - 1; i >= 0; --i) { value = value << 8 | data[i]; }
+		return std::optional{value};
+	};
+
+	if (file.read(4) != "RIFF" || !readUInt(4) || file.read(4) != "WAVE") { return std::nullopt; }
+
+	auto formatFound = false;
+	auto sampleRate = sample_rate_t{0};
+	while (!file.atEnd())
+	{
+		const auto id = file.read(4);
+		const auto size = readUInt(4);
+		if (id.size() != 4 || !size) { return std::nullopt; }
+
+		const auto chunkStart = file.pos();
+		if (id == "fmt ")
+		{
+			constexpr auto IeeeFloat = 3;
+			constexpr auto Extensible = 0xfffe;
+
+			auto format = readUInt(2);
+			const auto channels = readUInt(2);
+			const auto rate = readUInt(4);
+			file.skip(6); // byte rate and block align
+			const auto bits = readUInt(2);
+			if (format == Extensible && *size >= 40)
+			{
+				file.skip(8); // extension size, valid bits and channel mask
+				format = readUInt(2); // the start of the sub format GUID
+			}
+
+			if (format != IeeeFloat || channels != DEFAULT_CHANNELS || bits != 32 || !rate || *rate == 0)
+			{
+				return std::nullopt;
+			}
+			formatFound = true;
+			sampleRate = *rate;
+		}
+		else if (id == "data")
+		{
+			if (!formatFound || chunkStart % alignof(SampleFrame) != 0) { return std::nullopt; }
+
+			// the size may be wrong for files written while streaming, never map beyond the end
+			return WaveData{chunkStart, std::min<qint64>(*size, file.size() - chunkStart), sampleRate};
+		}
+
+		// chunks are padded to an even size
+		if (!file.seek(chunkStart + *size + (*size & 1))) { return std::nullopt; }
+	}
+
+	return std::nullopt;
+}
+
+} // namespace
+
+/**
+ * Decodes an audio file, on the global thread pool unless asked to block.
+ * Large files are decoded into a temporary file mapped into memory, the
+ * operating system pages their frames in and out as needed, so they don't
+ * need to be kept in RAM as a whole. The frames are kept in the storage
+ * format requested.
+ */
+class SampleBuffer::StreamedData
+{
+public:
+	//! Returns nullptr if there is no room for the decoded frames. @p timer is ended once decoding is done.
+	static auto create(std::unique_ptr<SampleDecoder::Stream> stream, Storage storage, Decoding decoding,
+		std::shared_ptr<PerfLogReport::Timer> timer) -> std::shared_ptr<StreamedData>
+	{
+		auto streamedData = std::shared_ptr<StreamedData>{new StreamedData{stream->frames(), storage}};
+		streamedData->m_streaming = decoding == Decoding::Streaming;
+		streamedData->m_preload.resize(preloadFrames(decoding, stream->frames(), stream->sampleRate()));
+
+		const auto bytes = streamedData->m_frames * bytesPerFrame(storage);
+		if (bytes >= StreamingThreshold || (streamedData->m_streaming && bytes > 0))
+		{
+			auto file = std::make_unique<QTemporaryFile>();
+			if (!file->open() || !file->resize(static_cast<qint64>(bytes))) { return nullptr; }
+
+			streamedData->m_data = reinterpret_cast<std::byte*>(file->map(0, static_cast<qint64>(bytes)));
+			if (!streamedData->m_data) { return nullptr; }
+			streamedData->m_file = std::move(file);
+		}
+		else
+		{
+			streamedData->m_memory.resize(bytes);
+			streamedData->m_data = streamedData->m_memory.data();
+		}
+
+		if (decoding == Decoding::Blocking)
+		{
+			streamedData->decode(*stream);
+			return streamedData;
+		}
+
+		// the data is only held on to while a chunk is decoded, so dropping the last
+		// buffer using it stops decoding instead of having to wait for it
+		ThreadPool::instance().enqueue(
+			[weakData = std::weak_ptr{streamedData}, stream = std::shared_ptr<SampleDecoder::Stream>{std::move(stream)},
+				timer] {
+				auto chunk = std::vector<SampleFrame>{};
+				auto position = std::size_t{0};
+				while (const auto data = weakData.lock())
+				{
+					if (!data->decodeChunk(*stream, position, chunk))
+					{
+						data->finishDecoding();
+						break;
+					}
+				}
+				timer->end();
+			});
+		return streamedData;
+	}
+
+	//! Reads the frames of a 32 bit float stereo WAV file, which don't need to be decoded.
+	//! Returns nullptr for any other file, and for files large enough to be decoded in the background.
+	static auto load(const QString& path, Decoding decoding, sample_rate_t& sampleRate) -> std::shared_ptr<StreamedData>
+	{
+		// the frames have to be stored just like SampleFrames
+		if constexpr (std::endian::native != std::endian::little) { return nullptr; }
+
+		auto file = QFile{path};
+		if (!file.open(QIODevice::ReadOnly)) { return nullptr; }
+
+		const auto wave = floatWaveData(file);
+		if (!wave || static_cast<std::size_t>(wave->bytes) >= StreamingThreshold) { return nullptr; }
+
+		// read rather than mapped, as a mapped file that gets truncated by someone
+		// else would crash us as soon as the missing frames are touched
+		const auto frames = static_cast<std::size_t>(wave->bytes / sizeof(SampleFrame));
+		auto streamedData = std::shared_ptr<StreamedData>{new StreamedData{frames, Storage::Float32}};
+		streamedData->m_memory.resize(frames * sizeof(SampleFrame));
+		streamedData->m_data = streamedData->m_memory.data();
+		const auto bytes = static_cast<qint64>(streamedData->m_memory.size());
+		if (!file.seek(wave->offset)
+			|| file.read(reinterpret_cast<char*>(streamedData->m_data), bytes) != bytes)
+		{
+			return nullptr;
+		}
+
+		// nothing to decode
+		streamedData->m_decodedFrames = frames;
+		streamedData->m_finished = true;
+
+		streamedData->m_streaming = decoding == Decoding::Streaming;
+		const auto frameData = reinterpret_cast<const SampleFrame*>(streamedData->m_data);
+		streamedData->m_preload.assign(frameData, frameData + preloadFrames(decoding, frames, wave->sampleRate));
+		streamedData->m_preloadedFrames = streamedData->m_preload.size();
+
+		sampleRate = wave->sampleRate;
+		return streamedData;
+	}
+
+	auto data() const -> std::byte* { return m_data; }
+	auto storage() const -> Storage { return m_storage; }
+	auto frames() const -> std::size_t { return m_frames; }
+	auto decodedFrames() const -> std::size_t { return m_decodedFrames.load(std::memory_order_acquire); }
+
+	auto streamed() const -> bool { return m_streaming && m_frames > m_preload.size(); }
+	auto preload() const -> const SampleFrame* { return m_preload.data(); }
+	auto preloadedFrames() const -> std::size_t { return m_preloadedFrames.load(std::memory_order_acquire); }
+
+	void waitUntilDecoded() const
+	{
+		if (decodedFrames() == m_frames) { return; }
+
+		auto lock = std::unique_lock{m_mutex};
+		m_finishedCondition.wait(lock, [this] { return m_finished; });
+	}
+
+	//! All frames as SampleFrames, which have to be converted once for compact storage formats
+	auto sampleFrames() -> SampleFrame*
+	{
+		waitUntilDecoded();
+		if (m_storage == Storage::Float32) { return reinterpret_cast<SampleFrame*>(m_data); }
+
+		std::call_once(m_convertedOnce, [this] {
+			m_converted.resize(m_frames);
+			read(m_data, m_storage, 0, m_frames, m_converted.data());
+		});
+		return m_converted.data();
+	}
+
+	static void read(const std::byte* data, Storage storage, std::size_t first, std::size_t count, SampleFrame* out)
+	{
+		const auto convert = [&]<Storage S>() {
+			for (auto i = std::size_t{0}; i < count; ++i) { out[i] = frameAt<S>(data, first + i); }
+		};
+
+		switch (storage)
+		{
+		case Storage::Float32: convert.template operator()<Storage::Float32>(); break;
+		case Storage::Int16: convert.template operator()<Storage::Int16>(); break;
+		case Storage::Int24: convert.template operator()<Storage::Int24>(); break;
+		case Storage::Float16: convert.template operator()<Storage::Float16>(); break;
+		}
+	}
+
+private:
+	StreamedData(std::size_t frames, Storage storage)
+		: m_storage(storage)
+		, m_frames(frames)
+	{
+	}
+
+	void decode(SampleDecoder::Stream& stream)
+	{
+		auto chunk = std::vector<SampleFrame>{};
+		auto position = std::size_t{0};
+		while (decodeChunk(stream, position, chunk)) {}
+		finishDecoding();
+	}
+
+	//! Decodes the frames at @p position on, returns false once there are none left
+	auto decodeChunk(SampleDecoder::Stream& stream, std::size_t& position, std::vector<SampleFrame>& chunk) -> bool
+	{
+		if (position >= m_frames) { return false; }
+
+		// compact formats are converted from SampleFrames decoded into a chunk buffer first
+		if (m_storage != Storage::Float32) { chunk.resize(StreamingChunkFrames); }
+
+		const auto framesToRead = std::min(StreamingChunkFrames, m_frames - position);
+		const auto target = chunk.empty() ? reinterpret_cast<SampleFrame*>(m_data) + position : chunk.data();
+
+		const auto framesRead = stream.read(target, framesToRead);
+		if (framesRead == 0) { return false; } // broken or truncated file, the rest stays silent
+
+		if (!chunk.empty())
+		{
+			storeFrames(m_storage, chunk.data(), framesRead, m_data + position * bytesPerFrame(m_storage));
+		}
+
+		if (position < m_preload.size())
+		{
+			const auto preloaded = std::min(framesRead, m_preload.size() - position);
+			std::copy_n(target, preloaded, m_preload.begin() + position);
+			m_preloadedFrames.store(position + preloaded, std::memory_order_release);
+		}
+
+		position += framesRead;
+		m_decodedFrames.store(position, std::memory_order_release);
+		return true;
+	}
+
+	void finishDecoding()
+	{
+		// the frames were zero-initialized, so anything left is silence now
+		m_decodedFrames.store(m_frames, std::memory_order_release);
+		{
+			const auto lock = std::lock_guard{m_mutex};
+			m_finished = true;
+		}
+		m_finishedCondition.notify_all();
+	}
+
+	//! The file the frames are mapped from, if any
+	std::unique_ptr<QFile> m_file;
+	std::vector<std::byte> m_memory;
+	std::byte* m_data = nullptr;
+	const Storage m_storage;
+	const std::size_t m_frames;
+	std::atomic<std::size_t> m_decodedFrames = 0;
+
+	mutable std::mutex m_mutex;
+	mutable std::condition_variable m_finishedCondition;
+	bool m_finished = false;
+
+	std::once_flag m_convertedOnce;
+	std::vector<SampleFrame> m_converted;
+
+	bool m_streaming = false;
+	std::vector<SampleFrame> m_preload;
+	std::atomic<std::size_t> m_preloadedFrames = 0;
+};
+
 SampleBuffer::SampleBuffer(const SampleFrame* data, size_t numFrames, int sampleRate)
 	: m_data(data, data + numFrames)
 	, m_sampleRate(sampleRate)
 {
 }
 
-SampleBuffer::SampleBuffer(const QString& audioFile)
+SampleBuffer::SampleBuffer(const QString& audioFile, Decoding decoding, Storage storage)
 {
 	if (audioFile.isEmpty()) { throw std::runtime_error{"Failure loading audio file: Audio file path is empty."}; }
 	const auto absolutePath = PathUtil::toAbsolute(audioFile);
+	const auto decodeTimer = std::make_shared<PerfLogReport::Timer>("Sample decode", QFileInfo(absolutePath).fileName());
+	// the read-ahead buffers of the voices playing it are taken from its pool
+	if (decoding == Decoding::Streaming) { SampleStream::prepare(); }
 
+	if (storage == Storage::Float32)
+	{
+		if ((m_streamedData = StreamedData::load(absolutePath, decoding, m_sampleRate)))
+		{
+			m_audioFile = PathUtil::toShortestRelative(audioFile);
+			return;
+		}
+	}
+
+	if (auto stream = SampleDecoder::Stream::open(absolutePath))
+	{
+		const auto sampleRate = stream->sampleRate();
+		if (decoding == Decoding::Blocking && storage == Storage::Float32
+			&& stream->frames() * sizeof(SampleFrame) < StreamingThreshold)
+		{
+			// small enough to decode right away, through the file already open
+			m_data.resize(stream->frames());
+			m_data.resize(stream->read(m_data.data(), m_data.size()));
+			RealtimeMemory::adviseHugePages(m_data.data(), m_data.size() * sizeof(SampleFrame));
+			m_sampleRate = sampleRate;
+			m_audioFile = PathUtil::toShortestRelative(audioFile);
+			return;
+		}
+
+		const auto large = stream->frames() * bytesPerFrame(storage) >= StreamingThreshold;
+		if ((m_streamedData = StreamedData::create(
+			std::move(stream), storage, large && decoding == Decoding::Blocking ? Decoding::Background : decoding,
+			decodeTimer)))
+		{
+			m_sampleRate = sampleRate;
+			m_audioFile = PathUtil::toShortestRelative(audioFile);
+			return;
+		}
+	}
+
+	// formats libsndfile can't open, e.g. DrumSynth files
 	if (auto decodedResult = SampleDecoder::decode(absolutePath))
 	{
 		auto& [data, sampleRate] = *decodedResult;
 		m_data = std::move(data);
+		RealtimeMemory::adviseHugePages(m_data.data(), m_data.size() * sizeof(SampleFrame));
 		m_sampleRate = sampleRate;
 		m_audioFile = PathUtil::toShortestRelative(audioFile);
 		return;
@@ -67,12 +479,14 @@ SampleBuffer::SampleBuffer(std::vector<SampleFrame> data, int sampleRate)
 	: m_data(std::move(data))
 	, m_sampleRate(sampleRate)
 {
+	RealtimeMemory::adviseHugePages(m_data.data(), m_data.size() * sizeof(SampleFrame));
 }
 
 void swap(SampleBuffer& first, SampleBuffer& second) noexcept
 {
 	using std::swap;
 	swap(first.m_data, second.m_data);
+	swap(first.m_streamedData, second.m_streamedData);
 	swap(first.m_audioFile, second.m_audioFile);
 	swap(first.m_sampleRate, second.m_sampleRate);
 }
@@ -80,12 +494,138 @@ void swap(SampleBuffer& first, SampleBuffer& second) noexcept
 QString SampleBuffer::toBase64() const
 {
 	// TODO: Replace with non-Qt equivalent
-	const auto data = reinterpret_cast<const char*>(m_data.data());
-	const auto size = static_cast<int>(m_data.size() * sizeof(SampleFrame));
+	const auto data = reinterpret_cast<const char*>(this->data());
+	const auto size = static_cast<int>(this->size() * sizeof(SampleFrame));
 	const auto byteArray = QByteArray{data, size};
 	return byteArray.toBase64();
 }
 
+auto SampleBuffer::data() const -> const SampleFrame*
+{
+	return m_streamedData ? m_streamedData->sampleFrames() : m_data.data();
+}
+
+auto SampleBuffer::size() const -> size_type
+{
+	return m_streamedData ? m_streamedData->frames() : m_data.size();
+}
+
+auto SampleBuffer::partialData() const -> const SampleFrame*
+{
+	if (!m_streamedData) { return m_data.data(); }
+	return m_streamedData->storage() == Storage::Float32
+		? reinterpret_cast<const SampleFrame*>(m_streamedData->data())
+		: nullptr;
+}
+
+auto SampleBuffer::decodedFrames() const -> size_type
+{
+	return m_streamedData ? m_streamedData->decodedFrames() : m_data.size();
+}
+
+void SampleBuffer::waitUntilDecoded() const
+{
+	if (m_streamedData) { m_streamedData->waitUntilDecoded(); }
+}
+
+auto SampleBuffer::streamed() const -> bool
+{
+	return m_streamedData && m_streamedData->streamed();
+}
+
+auto SampleBuffer::preloadedData() const -> const SampleFrame*
+{
+	return m_streamedData ? m_streamedData->preload() : nullptr;
+}
+
+auto SampleBuffer::preloadedFrames() const -> size_type
+{
+	return m_streamedData ? m_streamedData->preloadedFrames() : 0;
+}
+
+auto SampleBuffer::storage() const -> Storage
+{
+	return m_streamedData ? m_streamedData->storage() : Storage::Float32;
+}
+
+auto SampleBuffer::storageData() const -> const std::byte*
+{
+	return m_streamedData ? m_streamedData->data() : reinterpret_cast<const std::byte*>(m_data.data());
+}
+
+void SampleBuffer::read(size_type first, size_type count, SampleFrame* out) const
+{
+	StreamedData::read(storageData(), storage(), first, count, out);
+}
+
+auto SampleBuffer::bytesPerFrame(Storage storage) -> std::size_t
+{
+	switch (storage)
+	{
+	case Storage::Int16: return 2 * sizeof(std::int16_t);
+	case Storage::Int24: return 2 * 3;
+	case Storage::Float16: return 2 * sizeof(std::uint16_t);
+	default: return sizeof(SampleFrame);
+	}
+}
+
+auto SampleBuffer::defaultStorage() -> Storage
+{
+	const auto storage = ConfigManager::inst()->value("audioengine", "samplestorage");
+	if (storage == "int16") { return Storage::Int16; }
+	if (storage == "int24") { return Storage::Int24; }
+	if (storage == "float16") { return Storage::Float16; }
+	return Storage::Float32;
+}
+
+auto SampleBuffer::resampled(sample_rate_t sampleRate) const -> SampleBuffer
+{
+	auto result = SampleBuffer{};
+	result.m_audioFile = m_audioFile;
+	result.m_sampleRate = sampleRate;
+	if (empty() || sampleRate == m_sampleRate)
+	{
+		result.m_data.assign(begin(), end());
+		return result;
+	}
+
+	const auto ratio = static_cast<double>(sampleRate) / m_sampleRate;
+	result.m_data.resize(static_cast<std::size_t>(std::ceil(size() * ratio)) + 1);
+
+	auto srcData = SRC_DATA{};
+	srcData.data_in = &data()[0][0];
+	srcData.data_out = &result.m_data[0][0];
+	srcData.input_frames = static_cast<long>(size());
+	srcData.output_frames = static_cast<long>(result.m_data.size());
+	srcData.src_ratio = ratio;
+	if (src_simple(&srcData, SRC_SINC_BEST_QUALITY, DEFAULT_CHANNELS) != 0)
+	{
+		// play it resampled in realtime instead
+		result.m_data.assign(begin(), end());
+		result.m_sampleRate = m_sampleRate;
+		return result;
+	}
+
+	result.m_data.resize(srcData.output_frames_gen);
+	return result;
+}
+
+auto SampleBuffer::resampleOnLoad() -> bool
+{
+	return ConfigManager::inst()->value("audioengine", "resampleonload").toInt();
+}
+
+auto SampleBuffer::streamSamples() -> bool
+{
+	return ConfigManager::inst()->value("audioengine", "streamsamples").toInt();
+}
+
+auto SampleBuffer::mutableData() -> SampleFrame*
+{
+	// changes to the frames of compact storage formats only affect the converted frames
+	return m_streamedData ? m_streamedData->sampleFrames() : m_data.data();
+}
+
 auto SampleBuffer::emptyBuffer() -> std::shared_ptr<const SampleBuffer>
 {
 	static auto s_buffer = std::make_shared<const SampleBuffer>();
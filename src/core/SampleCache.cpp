@@ -0,0 +1,275 @@
+/*
+ * SampleCache.cpp - shares the buffers of audio files used several times
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "SampleCache.h"
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <list>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <tuple>
+
+#include "AudioEngine.h"
+#include "Engine.h"
+#include "PathUtil.h"
+#include "SampleDecoder.h"
+
+namespace lmms {
+
+namespace {
+
+constexpr auto DefaultMemoryBudget = std::size_t{256} * 1024 * 1024;
+//! Larger files are kept at their sample rate, like SampleBuffer decodes them in the background
+constexpr auto MaxResampledBytes = std::size_t{64} * 1024 * 1024;
+
+struct Key
+{
+	QString path;
+	qint64 size;
+	qint64 lastModified;
+	SampleBuffer::Storage storage;
+	//! The sample rate the file is converted to or synthesized at, 0 if it is kept at its own
+	sample_rate_t sampleRate;
+
+	friend auto operator<(const Key& a, const Key& b) -> bool
+	{
+		return std::tie(a.path, a.size, a.lastModified, a.storage, a.sampleRate)
+			< std::tie(b.path, b.size, b.lastModified, b.storage, b.sampleRate);
+	}
+};
+
+//! Buffers kept alive by the cache, the most recently used first
+using RecentList = std::list<std::pair<Key, std::shared_ptr<const SampleBuffer>>>;
+
+struct Entry
+{
+	std::weak_ptr<const SampleBuffer> buffer;
+	RecentList::iterator recent;
+	bool retained = false;
+};
+
+struct Cache
+{
+	std::mutex mutex;
+	std::map<Key, Entry> entries;
+	RecentList recent;
+	std::size_t retainedBytes = 0;
+	std::size_t memoryBudget = DefaultMemoryBudget;
+	std::size_t hits = 0;
+	std::size_t misses = 0;
+};
+
+auto cache() -> Cache&
+{
+	static auto s_cache = Cache{};
+	return s_cache;
+}
+
+auto bufferBytes(const SampleBuffer& buffer) -> std::size_t
+{
+	return buffer.memoryUsage();
+}
+
+// The functions below expect the cache to be locked
+
+void evict(Cache& c)
+{
+	while (c.retainedBytes > c.memoryBudget && !c.recent.empty())
+	{
+		const auto& [key, buffer] = c.recent.back();
+		c.retainedBytes -= bufferBytes(*buffer);
+		if (const auto it = c.entries.find(key); it != c.entries.end()) { it->second.retained = false; }
+		c.recent.pop_back();
+	}
+}
+
+void retain(Cache& c, const Key& key, Entry& entry, const std::shared_ptr<const SampleBuffer>& buffer)
+{
+	if (entry.retained)
+	{
+		c.recent.splice(c.recent.begin(), c.recent, entry.recent);
+		return;
+	}
+
+	// a buffer exceeding the budget on its own would only evict everything else
+	const auto bytes = bufferBytes(*buffer);
+	if (bytes > c.memoryBudget) { return; }
+
+	c.recent.emplace_front(key, buffer);
+	entry.recent = c.recent.begin();
+	entry.retained = true;
+	c.retainedBytes += bytes;
+	evict(c);
+}
+
+//! Removes the entries of buffers neither in use nor kept alive anymore
+void prune(Cache& c)
+{
+	for (auto it = c.entries.begin(); it != c.entries.end();)
+	{
+		if (!it->second.retained && it->second.buffer.expired()) { it = c.entries.erase(it); }
+		else { ++it; }
+	}
+}
+
+} // namespace
+
+auto SampleCache::get(const QString& audioFile, SampleBuffer::Decoding decoding, SampleBuffer::Storage storage)
+	-> std::shared_ptr<const SampleBuffer>
+{
+	const auto info = QFileInfo{PathUtil::toAbsolute(audioFile)};
+	const auto path = info.canonicalFilePath();
+
+	// let SampleBuffer report missing files
+	if (audioFile.isEmpty() || path.isEmpty())
+	{
+		return std::make_shared<const SampleBuffer>(audioFile, decoding, storage);
+	}
+
+	// background decoding is used for files too large to be converted in one go
+	const auto resample = decoding == SampleBuffer::Decoding::Blocking && SampleBuffer::resampleOnLoad();
+	const auto sampleRate = resample || SampleDecoder::isSynthesized(path)
+		? Engine::audioEngine()->outputSampleRate()
+		: sample_rate_t{0};
+	const auto key = Key{path, info.size(), info.lastModified().toMSecsSinceEpoch(), storage, sampleRate};
+	auto& c = cache();
+
+	// the file decoded at its own sample rate, e.g. when it has been prefetched
+	auto decoded = std::shared_ptr<const SampleBuffer>{};
+	{
+		const auto lock = std::lock_guard{c.mutex};
+		if (const auto it = c.entries.find(key); it != c.entries.end())
+		{
+			if (auto buffer = it->second.buffer.lock())
+			{
+				++c.hits;
+				retain(c, key, it->second, buffer);
+				return buffer;
+			}
+		}
+		if (resample)
+		{
+			auto decodedKey = key;
+			decodedKey.sampleRate = 0;
+			if (const auto it = c.entries.find(decodedKey); it != c.entries.end()) { decoded = it->second.buffer.lock(); }
+		}
+		++c.misses;
+	}
+
+	// decode without holding the lock, so other files can be loaded meanwhile
+	auto buffer = decoded ? decoded : std::make_shared<const SampleBuffer>(audioFile, decoding, storage);
+	// a buffer decoded in the background is waited for rather than decoded once more
+	if (resample && buffer->sampleRate() != sampleRate && !buffer->streamed()
+		&& (decoded || buffer->decodedFrames() == buffer->size())
+		&& buffer->size() * sizeof(SampleFrame) < MaxResampledBytes)
+	{
+		buffer = std::make_shared<const SampleBuffer>(buffer->resampled(sampleRate));
+	}
+
+	const auto lock = std::lock_guard{c.mutex};
+	prune(c);
+
+	auto& entry = c.entries[key];
+	if (auto existing = entry.buffer.lock())
+	{
+		// the same file has been decoded concurrently, share that one
+		retain(c, key, entry, existing);
+		return existing;
+	}
+
+	entry.buffer = buffer;
+	retain(c, key, entry, buffer);
+	return buffer;
+}
+
+auto SampleCache::prefetch(const QStringList& audioFiles) -> std::vector<std::shared_ptr<const SampleBuffer>>
+{
+	// the buffers are shared whatever decoding is requested later on, so streaming
+	// instruments would get buffers held in memory completely otherwise
+	const auto decoding = SampleBuffer::streamSamples()
+		? SampleBuffer::Decoding::Streaming
+		: SampleBuffer::Decoding::Background;
+
+	auto buffers = std::vector<std::shared_ptr<const SampleBuffer>>{};
+	for (const auto& audioFile : audioFiles)
+	{
+		try
+		{
+			buffers.push_back(get(audioFile, decoding));
+		}
+		catch (const std::runtime_error&)
+		{
+			// reported by whoever loads the file for real
+		}
+	}
+	return buffers;
+}
+
+auto SampleCache::statistics() -> Statistics
+{
+	auto& c = cache();
+	const auto lock = std::lock_guard{c.mutex};
+	return Statistics{c.hits, c.misses, c.retainedBytes};
+}
+
+auto SampleCache::usage() -> std::vector<Usage>
+{
+	auto& c = cache();
+	const auto lock = std::lock_guard{c.mutex};
+
+	auto usage = std::vector<Usage>{};
+	for (const auto& [key, entry] : c.entries)
+	{
+		const auto buffer = entry.buffer.lock();
+		if (!buffer) { continue; }
+
+		// besides the one locked here, the list of recent buffers may hold a reference
+		const auto references = 1 + (entry.retained ? 1 : 0);
+		usage.push_back(Usage{key.path, bufferBytes(*buffer), buffer.use_count() > references});
+	}
+	return usage;
+}
+
+void SampleCache::setMemoryBudget(std::size_t bytes)
+{
+	auto& c = cache();
+	const auto lock = std::lock_guard{c.mutex};
+	c.memoryBudget = bytes;
+	evict(c);
+}
+
+void SampleCache::clear()
+{
+	auto& c = cache();
+	const auto lock = std::lock_guard{c.mutex};
+	for (auto& [key, buffer] : c.recent)
+	{
+		if (const auto it = c.entries.find(key); it != c.entries.end()) { it->second.retained = false; }
+	}
+	c.recent.clear();
+	c.retainedBytes = 0;
+	prune(c);
+}
+
+} // namespace lmms
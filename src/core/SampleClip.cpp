@@ -24,18 +24,34 @@
  
 #include "SampleClip.h"
 
+#include <chrono>
+#include <utility>
+
+#include <QCoreApplication>
 #include <QDomElement>
 #include <QFileInfo>
+#include <QPointer>
 
+#include "DataFile.h"
 #include "PathUtil.h"
 #include "SampleClipView.h"
 #include "SampleLoader.h"
+#include "SampleRecordHandle.h"
 #include "SampleTrack.h"
 #include "Song.h"
+#include "ThreadPool.h"
 
 namespace lmms
 {
 
+namespace
+{
+
+constexpr auto StretchDelay = std::chrono::milliseconds{200};
+
+} // namespace
+
+
 SampleClip::SampleClip(Track* _track, Sample sample, bool isPlaying)
 	: Clip(_track)
 	, m_sample(std::move(sample))
@@ -49,6 +65,7 @@ SampleClip::SampleClip(Track* _track, Sample sample, bool isPlaying)
 	// change length of this Clip
 	connect( Engine::getSong(), SIGNAL(tempoChanged(lmms::bpm_t)),
 					this, SLOT(updateLength()), Qt::DirectConnection );
+	connect(Engine::getSong(), SIGNAL(tempoChanged(lmms::bpm_t)), &m_stretchTimer, SLOT(start()));
 	connect( Engine::getSong(), SIGNAL(timeSignatureChanged(int,int)),
 					this, SLOT(updateLength()));
 
@@ -66,6 +83,12 @@ SampleClip::SampleClip(Track* _track, Sample sample, bool isPlaying)
 	//care about Clip position
 	connect( this, SIGNAL(positionChanged()), this, SLOT(updateTrackClips()));
 
+	m_stretchTimer.setSingleShot(true);
+	m_stretchTimer.setInterval(StretchDelay);
+	connect(&m_stretchTimer, &QTimer::timeout, this, &SampleClip::updateStretch);
+
+	connect(&m_recordModel, &BoolModel::dataChanged, this, &SampleClip::updateRecording);
+
 	updateTrackClips();
 }
 
@@ -77,7 +100,8 @@ SampleClip::SampleClip(Track* track)
 SampleClip::SampleClip(const SampleClip& orig) :
 	Clip(orig),
 	m_sample(std::move(orig.m_sample)),
-	m_isPlaying(orig.m_isPlaying)
+	m_isPlaying(orig.m_isPlaying),
+	m_originalTempo(orig.m_originalTempo)
 {
 	saveJournallingState( false );
 	setSampleFile( "" );
@@ -87,6 +111,7 @@ SampleClip::SampleClip(const SampleClip& orig) :
 	// change length of this Clip
 	connect( Engine::getSong(), SIGNAL(tempoChanged(lmms::bpm_t)),
 					this, SLOT(updateLength()), Qt::DirectConnection );
+	connect(Engine::getSong(), SIGNAL(tempoChanged(lmms::bpm_t)), &m_stretchTimer, SLOT(start()));
 	connect( Engine::getSong(), SIGNAL(timeSignatureChanged(int,int)),
 					this, SLOT(updateLength()));
 
@@ -104,7 +129,14 @@ SampleClip::SampleClip(const SampleClip& orig) :
 	//care about Clip position
 	connect( this, SIGNAL(positionChanged()), this, SLOT(updateTrackClips()));
 
+	m_stretchTimer.setSingleShot(true);
+	m_stretchTimer.setInterval(StretchDelay);
+	connect(&m_stretchTimer, &QTimer::timeout, this, &SampleClip::updateStretch);
+
+	connect(&m_recordModel, &BoolModel::dataChanged, this, &SampleClip::updateRecording);
+
 	updateTrackClips();
+	if (m_originalTempo > 0) { updateStretch(); }
 }
 
 
@@ -146,6 +178,7 @@ void SampleClip::setSampleBuffer(std::shared_ptr<const SampleBuffer> sb)
 		m_sample = Sample(std::move(sb));
 	}
 	updateLength();
+	updateStretch();
 
 	emit sampleChanged();
 
@@ -160,6 +193,7 @@ void SampleClip::setSampleFile(const QString& sf)
 	{
 		m_sample = Sample(gui::SampleLoader::createBufferFromFile(sf));
 		updateLength();
+		updateStretch();
 	}
 	else
 	{
@@ -242,7 +276,8 @@ void SampleClip::updateLength()
 
 TimePos SampleClip::sampleLength() const
 {
-	return static_cast<int>(m_sample.sampleSize() / Engine::framesPerTick(m_sample.sampleRate()));
+	// the same whatever the tempo if the sample is stretched to it
+	return static_cast<int>(m_sample.sampleSize() / Engine::framesPerTick(m_sample.sampleRate()) * stretchRatio());
 }
 
 
@@ -250,7 +285,7 @@ TimePos SampleClip::sampleLength() const
 
 void SampleClip::setSampleStartFrame(f_cnt_t startFrame)
 {
-	m_sample.setStartFrame(startFrame);
+	playbackSample().setStartFrame(startFrame);
 }
 
 
@@ -258,7 +293,121 @@ void SampleClip::setSampleStartFrame(f_cnt_t startFrame)
 
 void SampleClip::setSamplePlayLength(f_cnt_t length)
 {
-	m_sample.setEndFrame(length);
+	playbackSample().setEndFrame(length);
+}
+
+
+
+
+void SampleClip::setOriginalTempo(bpm_t tempo)
+{
+	if (tempo == m_originalTempo) { return; }
+
+	m_originalTempo = tempo;
+	updateLength();
+	updateStretch();
+}
+
+
+
+
+Sample& SampleClip::playbackSample()
+{
+	// waiting here would stall the audio thread for as long as stretching takes, which finishStretch()
+	// does for exports before they begin
+	if (m_stretchRender.valid() && m_stretchRender.wait_for(std::chrono::seconds{0}) == std::future_status::ready)
+	{
+		m_stretchedSample = Sample(m_stretchRender.get());
+		m_stretchRender = {};
+	}
+
+	if (m_stretchedSample.sampleSize() == 0) { return m_sample; }
+
+	m_stretchedSample.setReversed(m_sample.reversed());
+	return m_stretchedSample;
+}
+
+
+
+
+void SampleClip::finishStretch()
+{
+	// a tempo change may still be waiting for the timer
+	const auto render = requestStretch();
+	if (render.valid()) { render.wait(); }
+}
+
+
+
+
+TimeStretch::Render SampleClip::requestStretch()
+{
+	const auto ratio = stretchRatio();
+	const auto render = ratio != 1.0 && m_sample.sampleSize() > 0
+		? TimeStretch::render(m_sample.buffer(), ratio)
+		: TimeStretch::Render{};
+
+	const auto guard = Engine::audioEngine()->requestChangesGuard();
+	m_stretchRender = render;
+	// the render of the previous tempo is played until the new one is done
+	if (!render.valid()) { m_stretchedSample = Sample(); }
+	return render;
+}
+
+
+
+
+void SampleClip::updateStretch()
+{
+	m_stretchTimer.stop();
+	const auto render = requestStretch();
+
+	if (!render.valid() || render.wait_for(std::chrono::seconds{0}) == std::future_status::ready)
+	{
+		playbackPositionChanged();
+		return;
+	}
+
+	// restart the clip once the render is done, so it is played from then on
+	ThreadPool::instance().enqueue([clip = QPointer<SampleClip>{this}, render] {
+		render.wait();
+		QMetaObject::invokeMethod(QCoreApplication::instance(), [clip] {
+			if (clip) { clip->playbackPositionChanged(); }
+		}, Qt::QueuedConnection);
+	});
+}
+
+
+
+
+std::shared_ptr<SampleRecording> SampleClip::takeRecording()
+{
+	return std::exchange(m_recording, nullptr);
+}
+
+
+
+
+void SampleClip::updateRecording()
+{
+	// a take has been handed over to the audio engine already
+	if (isRecord() == (m_recording != nullptr)) { return; }
+
+	// opening and closing the file would stall the audio thread, which only
+	// picks up the recording once recording starts
+	auto recording = isRecord() ? std::make_shared<SampleRecording>() : nullptr;
+	{
+		const auto guard = Engine::audioEngine()->requestChangesGuard();
+		std::swap(m_recording, recording);
+	}
+}
+
+
+
+
+double SampleClip::stretchRatio() const
+{
+	return m_originalTempo > 0 ? static_cast<double>(m_originalTempo) / Engine::getSong()->getTempo() : 1.0;
 }
 
 
@@ -279,9 +428,8 @@ void SampleClip::saveSettings( QDomDocument & _doc, QDomElement & _this )
 	_this.setAttribute( "src", sampleFile() );
 	_this.setAttribute( "off", startTimeOffset() );
 	_this.setAttribute("autoresize", QString::number(getAutoResize()));
-	if( sampleFile() == "" )
+	if (sampleFile().isEmpty() && !DataFile::bundleSample(_doc, _this, m_sample.buffer()))
 	{
-		QString s;
 		_this.setAttribute("data", m_sample.toBase64());
 	}
 
@@ -294,6 +442,10 @@ void SampleClip::saveSettings( QDomDocument & _doc, QDomElement & _this )
 	{
 		_this.setAttribute("reversed", "true");
 	}
+	if (m_originalTempo > 0)
+	{
+		_this.setAttribute("synctempo", m_originalTempo);
+	}
 	// TODO: start- and end-frame
 }
 
@@ -307,6 +459,9 @@ void SampleClip::loadSettings( const QDomElement & _this )
 		movePosition( _this.attribute( "pos" ).toInt() );
 	}
 
+	// before the sample is loaded, which is then stretched right away
+	m_originalTempo = _this.attribute("synctempo", "0").toInt();
+
 	if (const auto srcFile = _this.attribute("src"); !srcFile.isEmpty())
 	{
 		if (QFileInfo(PathUtil::toAbsolute(srcFile)).exists())
@@ -323,6 +478,7 @@ void SampleClip::loadSettings( const QDomElement & _this )
 
 		auto buffer = gui::SampleLoader::createBufferFromBase64(_this.attribute("data"), sampleRate);
 		m_sample = Sample(std::move(buffer));
+		updateStretch();
 	}
 	changeLength( _this.attribute( "len" ).toInt() );
 	setMuted( _this.attribute( "muted" ).toInt() );
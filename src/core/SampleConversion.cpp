@@ -0,0 +1,409 @@
+/*
+ * SampleConversion.cpp - conversion of sample frames to integer formats
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "SampleConversion.h"
+
+#include <cmath>
+
+#include "MixHelpers.h"
+#include "SampleFrame.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#	define LMMS_CONVERSION_SSE2
+#	include <emmintrin.h>
+#	if defined(__GNUC__)
+#		define LMMS_CONVERSION_AVX2
+#		include <immintrin.h>
+#	endif
+#endif
+
+
+namespace lmms::SampleConversion
+{
+
+DitherState::DitherState(Dither dither) :
+	dither(dither),
+	error{}
+{
+	for (std::size_t i = 0; i < random.size(); ++i)
+	{
+		// any non-zero seed will do, as long as the lanes differ
+		random[i] = 0x9E3779B9u * static_cast<std::uint32_t>(i + 1);
+	}
+}
+
+
+
+
+namespace
+{
+
+constexpr int RandomLanes = 8;
+constexpr float RandomScale = 1.f / 4294967296.f;
+
+
+//! Scaling and clamping for one integer resolution
+struct Format
+{
+	float scale; //!< 1.0 maps to this, which is also the largest value
+	float lo; //!< smallest value
+	int shift; //!< left shift to align the value to 32 bits
+};
+
+Format formatFor(int bits)
+{
+	const double max = std::ldexp(1.0, bits - 1) - 1.0;
+	auto hi = static_cast<float>(max);
+	// above 24 bits the largest value isn't representable, don't let it round up
+	if (hi > max) { hi = std::nextafter(hi, 0.f); }
+	return { hi, -static_cast<float>(std::ldexp(1.0, bits - 1)), 32 - bits };
+}
+
+
+
+
+/*! \brief Reference implementation, also converting what the vector code leaves over
+ *
+ * The vector versions must compute exactly the same operations in the same
+ * order, so the output doesn't depend on the CPU.
+ */
+namespace scalar
+{
+
+// same semantics as _mm_max_ps and _mm_min_ps, so NaNs come out the same as in the vector code
+inline float max(float a, float b) { return a > b ? a : b; }
+inline float min(float a, float b) { return a < b ? a : b; }
+
+inline std::uint32_t nextRandom(std::uint32_t& x)
+{
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return x;
+}
+
+//! TPDF noise in [-1, 1)
+inline float triangular(std::uint32_t& x)
+{
+	const auto a = static_cast<float>(static_cast<std::int32_t>(nextRandom(x)));
+	const auto b = static_cast<float>(static_cast<std::int32_t>(nextRandom(x)));
+	return (a + b) * RandomScale;
+}
+
+inline std::int32_t quantize(float x, const Format& format)
+{
+	return static_cast<std::int32_t>(std::lrint(min(max(x, format.lo), format.scale)));
+}
+
+/*! \brief Converts samples [begin, end) of \p src and passes them to \p store
+ *
+ * \param stride distance between two samples in \p src, 2 to only take the left channel
+ */
+template<typename Store>
+void convert(const float* src, int stride, int begin, int end, ch_cnt_t channels,
+	const Format& format, DitherState* dither, Store store)
+{
+	const Dither mode = dither ? dither->dither : Dither::None;
+	for (int i = begin; i < end; ++i)
+	{
+		float x = min(max(src[i * stride], -1.f), 1.f) * format.scale;
+		if (mode == Dither::NoiseShaped)
+		{
+			// subtract the previous rounding error of this channel
+			float& error = dither->error[i % channels];
+			const float wanted = x - error;
+			const std::int32_t q = quantize(wanted + triangular(dither->random[i % RandomLanes]), format);
+			error = static_cast<float>(q) - wanted;
+			store(i, q);
+			continue;
+		}
+		if (mode == Dither::Triangular) { x += triangular(dither->random[i % RandomLanes]); }
+		store(i, quantize(x, format));
+	}
+}
+
+inline std::int16_t swapped(std::int16_t x)
+{
+	const auto u = static_cast<std::uint16_t>(x);
+	return static_cast<std::int16_t>(static_cast<std::uint16_t>(u << 8 | u >> 8));
+}
+
+void toS16(const float* src, int stride, int begin, int end, ch_cnt_t channels, std::int16_t* dst,
+	bool swapBytes, DitherState* dither, const Format& format)
+{
+	convert(src, stride, begin, end, channels, format, dither, [=](int i, std::int32_t x) {
+		const auto s = static_cast<std::int16_t>(x);
+		dst[i] = swapBytes ? swapped(s) : s;
+	});
+}
+
+void toS32(const float* src, int stride, int begin, int end, ch_cnt_t channels, std::int32_t* dst,
+	DitherState* dither, const Format& format)
+{
+	convert(src, stride, begin, end, channels, format, dither, [=](int i, std::int32_t x) {
+		dst[i] = static_cast<std::int32_t>(static_cast<std::uint32_t>(x) << format.shift);
+	});
+}
+
+} // namespace scalar
+
+
+
+
+// The vector versions take interleaved stereo samples, either without dither
+// or with Dither::Triangular, and return how many samples they converted.
+
+#ifdef LMMS_CONVERSION_SSE2
+namespace sse2
+{
+
+constexpr int SamplesPerIteration = 8;
+
+inline __m128i nextRandom(__m128i& x)
+{
+	x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+	x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+	x = _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+	return x;
+}
+
+inline __m128 triangular(__m128i& x)
+{
+	const __m128 a = _mm_cvtepi32_ps(nextRandom(x));
+	const __m128 b = _mm_cvtepi32_ps(nextRandom(x));
+	return _mm_mul_ps(_mm_add_ps(a, b), _mm_set1_ps(RandomScale));
+}
+
+inline __m128i quantize(__m128 x, const Format& format, __m128i* random)
+{
+	x = _mm_mul_ps(_mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-1.f)), _mm_set1_ps(1.f)), _mm_set1_ps(format.scale));
+	if (random) { x = _mm_add_ps(x, triangular(*random)); }
+	return _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(x, _mm_set1_ps(format.lo)), _mm_set1_ps(format.scale)));
+}
+
+int toS16(const float* src, int samples, std::int16_t* dst, bool swapBytes, DitherState* dither,
+	const Format& format)
+{
+	const bool dithered = dither && dither->dither == Dither::Triangular;
+	auto random = reinterpret_cast<__m128i*>(dither ? dither->random.data() : nullptr);
+	__m128i randomLo = dithered ? _mm_loadu_si128(random) : _mm_setzero_si128();
+	__m128i randomHi = dithered ? _mm_loadu_si128(random + 1) : _mm_setzero_si128();
+
+	const int vecSamples = samples - samples % SamplesPerIteration;
+	for (int i = 0; i < vecSamples; i += SamplesPerIteration)
+	{
+		const __m128i lo = quantize(_mm_loadu_ps(src + i), format, dithered ? &randomLo : nullptr);
+		const __m128i hi = quantize(_mm_loadu_ps(src + i + 4), format, dithered ? &randomHi : nullptr);
+		__m128i packed = _mm_packs_epi32(lo, hi);
+		if (swapBytes) { packed = _mm_or_si128(_mm_slli_epi16(packed, 8), _mm_srli_epi16(packed, 8)); }
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), packed);
+	}
+
+	if (dithered)
+	{
+		_mm_storeu_si128(random, randomLo);
+		_mm_storeu_si128(random + 1, randomHi);
+	}
+	return vecSamples;
+}
+
+int toS32(const float* src, int samples, std::int32_t* dst, DitherState* dither, const Format& format)
+{
+	const bool dithered = dither && dither->dither == Dither::Triangular;
+	auto random = reinterpret_cast<__m128i*>(dither ? dither->random.data() : nullptr);
+	__m128i randomLo = dithered ? _mm_loadu_si128(random) : _mm_setzero_si128();
+	__m128i randomHi = dithered ? _mm_loadu_si128(random + 1) : _mm_setzero_si128();
+	const __m128i shift = _mm_cvtsi32_si128(format.shift);
+
+	const int vecSamples = samples - samples % SamplesPerIteration;
+	for (int i = 0; i < vecSamples; i += SamplesPerIteration)
+	{
+		const __m128i lo = quantize(_mm_loadu_ps(src + i), format, dithered ? &randomLo : nullptr);
+		const __m128i hi = quantize(_mm_loadu_ps(src + i + 4), format, dithered ? &randomHi : nullptr);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_sll_epi32(lo, shift));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 4), _mm_sll_epi32(hi, shift));
+	}
+
+	if (dithered)
+	{
+		_mm_storeu_si128(random, randomLo);
+		_mm_storeu_si128(random + 1, randomHi);
+	}
+	return vecSamples;
+}
+
+} // namespace sse2
+#endif // LMMS_CONVERSION_SSE2
+
+
+
+
+#ifdef LMMS_CONVERSION_AVX2
+namespace avx2
+{
+
+#define LMMS_AVX2 __attribute__((target("avx2")))
+
+constexpr int SamplesPerIteration = 8;
+
+LMMS_AVX2 inline __m256i nextRandom(__m256i& x)
+{
+	x = _mm256_xor_si256(x, _mm256_slli_epi32(x, 13));
+	x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 17));
+	x = _mm256_xor_si256(x, _mm256_slli_epi32(x, 5));
+	return x;
+}
+
+LMMS_AVX2 inline __m256 triangular(__m256i& x)
+{
+	const __m256 a = _mm256_cvtepi32_ps(nextRandom(x));
+	const __m256 b = _mm256_cvtepi32_ps(nextRandom(x));
+	return _mm256_mul_ps(_mm256_add_ps(a, b), _mm256_set1_ps(RandomScale));
+}
+
+LMMS_AVX2 inline __m256i quantize(__m256 x, const Format& format, __m256i* random)
+{
+	x = _mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-1.f)), _mm256_set1_ps(1.f)),
+		_mm256_set1_ps(format.scale));
+	if (random) { x = _mm256_add_ps(x, triangular(*random)); }
+	return _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(format.lo)),
+		_mm256_set1_ps(format.scale)));
+}
+
+LMMS_AVX2 int toS16(const float* src, int samples, std::int16_t* dst, bool swapBytes, DitherState* dither,
+	const Format& format)
+{
+	const bool dithered = dither && dither->dither == Dither::Triangular;
+	auto random = reinterpret_cast<__m256i*>(dither ? dither->random.data() : nullptr);
+	__m256i lanes = dithered ? _mm256_loadu_si256(random) : _mm256_setzero_si256();
+
+	const int vecSamples = samples - samples % SamplesPerIteration;
+	for (int i = 0; i < vecSamples; i += SamplesPerIteration)
+	{
+		const __m256i x = quantize(_mm256_loadu_ps(src + i), format, dithered ? &lanes : nullptr);
+		__m128i packed = _mm_packs_epi32(_mm256_castsi256_si128(x), _mm256_extracti128_si256(x, 1));
+		if (swapBytes) { packed = _mm_or_si128(_mm_slli_epi16(packed, 8), _mm_srli_epi16(packed, 8)); }
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), packed);
+	}
+
+	if (dithered) { _mm256_storeu_si256(random, lanes); }
+	return vecSamples;
+}
+
+LMMS_AVX2 int toS32(const float* src, int samples, std::int32_t* dst, DitherState* dither, const Format& format)
+{
+	const bool dithered = dither && dither->dither == Dither::Triangular;
+	auto random = reinterpret_cast<__m256i*>(dither ? dither->random.data() : nullptr);
+	__m256i lanes = dithered ? _mm256_loadu_si256(random) : _mm256_setzero_si256();
+	const __m128i shift = _mm_cvtsi32_si128(format.shift);
+
+	const int vecSamples = samples - samples % SamplesPerIteration;
+	for (int i = 0; i < vecSamples; i += SamplesPerIteration)
+	{
+		const __m256i x = quantize(_mm256_loadu_ps(src + i), format, dithered ? &lanes : nullptr);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_sll_epi32(x, shift));
+	}
+
+	if (dithered) { _mm256_storeu_si256(random, lanes); }
+	return vecSamples;
+}
+
+#undef LMMS_AVX2
+
+} // namespace avx2
+#endif // LMMS_CONVERSION_AVX2
+
+
+
+
+//! Whether the vector code can convert this input
+bool vectorisable(ch_cnt_t channels, const DitherState* dither)
+{
+	// noise shaping feeds every sample's error into the next one
+	return channels == DEFAULT_CHANNELS && (!dither || dither->dither != Dither::NoiseShaped);
+}
+
+int vectorToS16(const float* src, int samples, std::int16_t* dst, bool swapBytes, DitherState* dither,
+	const Format& format)
+{
+	switch (MixHelpers::simdLevel())
+	{
+#ifdef LMMS_CONVERSION_AVX2
+	case MixHelpers::SimdLevel::Avx2: return avx2::toS16(src, samples, dst, swapBytes, dither, format);
+#endif
+#ifdef LMMS_CONVERSION_SSE2
+	case MixHelpers::SimdLevel::Sse2: return sse2::toS16(src, samples, dst, swapBytes, dither, format);
+#endif
+	default: return 0;
+	}
+}
+
+int vectorToS32(const float* src, int samples, std::int32_t* dst, DitherState* dither, const Format& format)
+{
+	switch (MixHelpers::simdLevel())
+	{
+#ifdef LMMS_CONVERSION_AVX2
+	case MixHelpers::SimdLevel::Avx2: return avx2::toS32(src, samples, dst, dither, format);
+#endif
+#ifdef LMMS_CONVERSION_SSE2
+	case MixHelpers::SimdLevel::Sse2: return sse2::toS32(src, samples, dst, dither, format);
+#endif
+	default: return 0;
+	}
+}
+
+} // namespace
+
+
+
+
+void toS16(const SampleFrame* src, int frames, ch_cnt_t channels, std::int16_t* dst,
+	bool swapBytes, DitherState* dither)
+{
+	if (frames <= 0) { return; }
+
+	const Format format = formatFor(16);
+	const float* samples = src->data();
+	const int count = frames * channels;
+
+	const int done = vectorisable(channels, dither)
+		? vectorToS16(samples, count, dst, swapBytes, dither, format)
+		: 0;
+	scalar::toS16(samples, DEFAULT_CHANNELS / channels, done, count, channels, dst, swapBytes, dither, format);
+}
+
+void toS32(const SampleFrame* src, int frames, ch_cnt_t channels, std::int32_t* dst,
+	int bits, DitherState* dither)
+{
+	if (frames <= 0) { return; }
+
+	const Format format = formatFor(bits);
+	const float* samples = src->data();
+	const int count = frames * channels;
+
+	const int done = vectorisable(channels, dither)
+		? vectorToS32(samples, count, dst, dither, format)
+		: 0;
+	scalar::toS32(samples, DEFAULT_CHANNELS / channels, done, count, channels, dst, dither, format);
+}
+
+} // namespace lmms::SampleConversion
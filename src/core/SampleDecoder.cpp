@@ -24,8 +24,16 @@
 
 #include "SampleDecoder.h"
 
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
 #include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
 #include <QString>
+#include <QtEndian>
 #include <memory>
 #include <sndfile.h>
 
@@ -56,6 +64,28 @@ static constexpr std::array<Decoder, 3> decoders = {&decodeSampleSF,
 #endif
 	&decodeSampleDS};
 
+constexpr auto RenderFileMagic = quint32{0x5244534c}; // "LSDR"
+constexpr auto RenderFileVersion = quint16{1};
+
+void toSampleFrames(const sample_t* src, int channels, SampleFrame* dst, std::size_t frames)
+{
+	for (auto i = std::size_t{0}; i < frames; ++i)
+	{
+		if (channels == 1)
+		{
+			// Upmix from mono to stereo
+			dst[i] = {src[i], src[i]};
+		}
+		else if (channels > 1)
+		{
+			// TODO: Add support for higher number of channels (i.e., 5.1 channel systems)
+			// The current behavior assumes stereo in all cases excluding mono.
+			// This may not be the expected behavior, given some audio files with a higher number of channels.
+			dst[i] = {src[i * channels], src[i * channels + 1]};
+		}
+	}
+}
+
 auto decodeSampleSF(const QString& audioFile) -> std::optional<SampleDecoder::Result>
 {
 	SNDFILE* sndFile = nullptr;
@@ -75,41 +105,103 @@ auto decodeSampleSF(const QString& audioFile) -> std::optional<SampleDecoder::Re
 	file.close();
 
 	auto result = std::vector<SampleFrame>(sfInfo.frames);
-	for (int i = 0; i < static_cast<int>(result.size()); ++i)
+	toSampleFrames(buf.data(), sfInfo.channels, result.data(), result.size());
+
+	return SampleDecoder::Result{std::move(result), static_cast<int>(sfInfo.samplerate)};
+}
+
+//! The file the render of @p info at @p sampleRate is cached in, changes whenever the file does
+auto renderFilePath(const QFileInfo& info, sample_rate_t sampleRate) -> QString
+{
+	const auto key = QStringLiteral("%1\n%2\n%3\n%4")
+		.arg(info.canonicalFilePath())
+		.arg(info.size())
+		.arg(info.lastModified().toMSecsSinceEpoch())
+		.arg(sampleRate);
+	const auto hash = QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex();
+
+	return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+		+ QStringLiteral("/drumsynth/") + QString::fromLatin1(hash) + QStringLiteral(".pcm");
+}
+
+//! Returns the interleaved samples stored in @p path, or nothing if it doesn't exist or is corrupt
+auto readRenderFile(const QString& path) -> std::vector<int_sample_t>
+{
+	auto file = QFile{path};
+	if (!file.open(QIODevice::ReadOnly)) { return {}; }
+
+	auto stream = QDataStream{&file};
+	stream.setByteOrder(QDataStream::LittleEndian);
+
+	auto magic = quint32{0};
+	auto version = quint16{0};
+	auto samples = quint64{0};
+	stream >> magic >> version >> samples;
+	const auto bytes = samples * sizeof(int_sample_t);
+	if (stream.status() != QDataStream::Ok || magic != RenderFileMagic || version != RenderFileVersion
+		|| samples == 0 || bytes != static_cast<quint64>(file.size() - file.pos()))
 	{
-		if (sfInfo.channels == 1)
-		{
-			// Upmix from mono to stereo
-			result[i] = {buf[i], buf[i]};
-		}
-		else if (sfInfo.channels > 1)
-		{
-			// TODO: Add support for higher number of channels (i.e., 5.1 channel systems)
-			// The current behavior assumes stereo in all cases excluding mono.
-			// This may not be the expected behavior, given some audio files with a higher number of channels.
-			result[i] = {buf[i * sfInfo.channels], buf[i * sfInfo.channels + 1]};
-		}
+		return {};
 	}
 
-	return SampleDecoder::Result{std::move(result), static_cast<int>(sfInfo.samplerate)};
+	auto data = std::vector<int_sample_t>(samples);
+	if (stream.readRawData(reinterpret_cast<char*>(data.data()), static_cast<int>(bytes)) != static_cast<int>(bytes))
+	{
+		return {};
+	}
+	qFromLittleEndian<qint16>(data.data(), data.size(), data.data());
+	return data;
+}
+
+void writeRenderFile(const QString& path, const int_sample_t* data, std::size_t samples)
+{
+	if (!QDir{}.mkpath(QFileInfo{path}.path())) { return; }
+
+	// written to a temporary file first, so other instances never read a partial one
+	auto file = QSaveFile{path};
+	if (!file.open(QIODevice::WriteOnly)) { return; }
+
+	auto stream = QDataStream{&file};
+	stream.setByteOrder(QDataStream::LittleEndian);
+	stream << RenderFileMagic << RenderFileVersion << static_cast<quint64>(samples);
+
+	auto littleEndian = std::vector<int_sample_t>(samples);
+	qToLittleEndian<qint16>(data, samples, littleEndian.data());
+	stream.writeRawData(reinterpret_cast<const char*>(littleEndian.data()),
+		static_cast<int>(samples * sizeof(int_sample_t)));
+
+	if (stream.status() == QDataStream::Ok) { file.commit(); }
 }
 
 auto decodeSampleDS(const QString& audioFile) -> std::optional<SampleDecoder::Result>
 {
+	const auto engineRate = Engine::audioEngine()->outputSampleRate();
+	const auto toResult = [engineRate](const int_sample_t* data, std::size_t frames) {
+		auto result = std::vector<SampleFrame>(frames);
+		src_short_to_float_array(data, &result[0][0], frames * DEFAULT_CHANNELS);
+		return SampleDecoder::Result{std::move(result), static_cast<int>(engineRate)};
+	};
+
+	// synthesizing a hit takes far longer than reading its render
+	const auto info = QFileInfo{audioFile};
+	const auto renderFile = info.exists() ? renderFilePath(info, engineRate) : QString{};
+	if (!renderFile.isEmpty())
+	{
+		const auto cached = readRenderFile(renderFile);
+		if (!cached.empty()) { return toResult(cached.data(), cached.size() / DEFAULT_CHANNELS); }
+	}
+
 	// Populated by DrumSynth::GetDSFileSamples
 	int_sample_t* dataPtr = nullptr;
 
 	auto ds = DrumSynth{};
-	const auto engineRate = Engine::audioEngine()->outputSampleRate();
 	const auto frames = ds.GetDSFileSamples(audioFile, dataPtr, DEFAULT_CHANNELS, engineRate);
 	const auto data = std::unique_ptr<int_sample_t[]>{dataPtr}; // NOLINT, we have to use a C-style array here
 
 	if (frames <= 0 || !data) { return std::nullopt; }
 
-	auto result = std::vector<SampleFrame>(frames);
-	src_short_to_float_array(data.get(), &result[0][0], frames * DEFAULT_CHANNELS);
-
-	return SampleDecoder::Result{std::move(result), static_cast<int>(engineRate)};
+	if (!renderFile.isEmpty()) { writeRenderFile(renderFile, data.get(), frames * DEFAULT_CHANNELS); }
+	return toResult(data.get(), frames);
 }
 
 #ifdef LMMS_HAVE_OGGVORBIS
@@ -185,6 +277,39 @@ auto decodeSampleOggVorbis(const QString& audioFile) -> std::optional<SampleDeco
 #endif // LMMS_HAVE_OGGVORBIS
 } // namespace
 
+auto SampleDecoder::Stream::open(const QString& audioFile) -> std::unique_ptr<Stream>
+{
+	auto stream = std::unique_ptr<Stream>{new Stream{}};
+
+	// TODO: Remove use of QFile
+	stream->m_file.setFileName(audioFile);
+	if (!stream->m_file.open(QIODevice::ReadOnly)) { return nullptr; }
+
+	auto sfInfo = SF_INFO{};
+	stream->m_sndFile = sf_open_fd(stream->m_file.handle(), SFM_READ, &sfInfo, false);
+	if (sf_error(stream->m_sndFile) != 0 || sfInfo.channels < 1) { return nullptr; }
+
+	stream->m_channels = sfInfo.channels;
+	stream->m_frames = static_cast<std::size_t>(sfInfo.frames);
+	stream->m_sampleRate = sfInfo.samplerate;
+	return stream;
+}
+
+SampleDecoder::Stream::~Stream()
+{
+	if (m_sndFile) { sf_close(m_sndFile); }
+}
+
+auto SampleDecoder::Stream::read(SampleFrame* dst, std::size_t frames) -> std::size_t
+{
+	m_readBuffer.resize(frames * m_channels);
+	const auto framesRead = sf_readf_float(m_sndFile, m_readBuffer.data(), static_cast<sf_count_t>(frames));
+	if (framesRead <= 0) { return 0; }
+
+	toSampleFrames(m_readBuffer.data(), m_channels, dst, static_cast<std::size_t>(framesRead));
+	return static_cast<std::size_t>(framesRead);
+}
+
 auto SampleDecoder::supportedAudioTypes() -> const std::vector<AudioType>&
 {
 	static const auto s_audioTypes = [] {
@@ -220,6 +345,11 @@ auto SampleDecoder::supportedAudioTypes() -> const std::vector<AudioType>&
 	return s_audioTypes;
 }
 
+auto SampleDecoder::isSynthesized(const QString& audioFile) -> bool
+{
+	return QFileInfo{audioFile}.suffix().compare("ds", Qt::CaseInsensitive) == 0;
+}
+
 auto SampleDecoder::decode(const QString& audioFile) -> std::optional<Result>
 {
 	auto result = std::optional<Result>{};
@@ -24,119 +24,288 @@
 
 
 #include "SampleRecordHandle.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QPointer>
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
 #include "AudioEngine.h"
+#include "ConfigManager.h"
 #include "Engine.h"
 #include "PatternTrack.h"
 #include "SampleBuffer.h"
+#include "SampleCache.h"
 #include "SampleClip.h"
+#include "ThreadPool.h"
+#include "lmmsconfig.h"
 
 
 namespace lmms
 {
 
+namespace
+{
 
-SampleRecordHandle::SampleRecordHandle( SampleClip* clip ) :
-	PlayHandle( Type::SamplePlayHandle ),
-	m_framesRecorded( 0 ),
-	m_minLength( clip->length() ),
-	m_track( clip->getTrack() ),
-	m_patternTrack( nullptr ),
-	m_clip( clip )
+//! How much input the ring buffer can hold, the writer must never fall behind by more than that
+constexpr auto RingBufferSeconds = 4;
+
+//! How often the writer looks for new frames
+constexpr auto WriterInterval = std::chrono::milliseconds{20};
+
+} // namespace
+
+
+SampleRecording::SampleRecording() :
+	m_ringBuffer(Engine::audioEngine()->inputSampleRate() * RingBufferSeconds),
+	m_ringBufferReader(m_ringBuffer)
 {
+	openFile();
+	if (m_sndFile)
+	{
+		m_writer = std::thread{&SampleRecording::runWriter, this};
+	}
 }
 
 
 
 
-SampleRecordHandle::~SampleRecordHandle()
+SampleRecording::~SampleRecording()
 {
-	if (!m_buffers.empty()) { m_clip->setSampleBuffer(createSampleBuffer()); }
+	finishWriting();
+	if (m_framesRecorded == 0 && !m_fileName.isEmpty()) { QFile::remove(m_fileName); }
+}
+
+
+
+
+std::shared_ptr<const SampleBuffer> SampleRecording::createSampleBuffer()
+{
+	finishWriting();
+
+	if (m_fileName.isEmpty())
+	{
+		return std::make_shared<const SampleBuffer>(std::move(m_memoryBuffer), Engine::audioEngine()->inputSampleRate());
+	}
 
-	while( !m_buffers.empty() )
+	if (m_framesDropped > 0)
+	{
+		qWarning() << "Recording could not be written fast enough," << m_framesDropped.load()
+			<< "frames were replaced by silence";
+	}
+
+	try
+	{
+		// long takes don't need to be read back completely before they can be used
+		return SampleCache::get(m_fileName, SampleBuffer::Decoding::Background);
+	}
+	catch (const std::runtime_error& error)
 	{
-		delete[] m_buffers.front().first;
-		m_buffers.erase( m_buffers.begin() );
+		qWarning() << "Could not load the recording" << m_fileName << ":" << error.what();
+		return SampleBuffer::emptyBuffer();
 	}
-	m_clip->setRecord( false );
 }
 
 
 
 
-void SampleRecordHandle::play( SampleFrame* /*_working_buffer*/ )
+void SampleRecording::write(const SampleFrame* frames, f_cnt_t count)
 {
-	const SampleFrame* recbuf = Engine::audioEngine()->inputBuffer();
-	const f_cnt_t frames = Engine::audioEngine()->inputBufferFrames();
-	writeBuffer( recbuf, frames );
-	m_framesRecorded += frames;
+	m_framesRecorded += count;
 
-	TimePos len = (tick_t)( m_framesRecorded / Engine::framesPerTick() );
-	if( len > m_minLength )
+	if (!m_sndFile)
 	{
-//		m_clip->changeLength( len );
-		m_minLength = len;
+		m_memoryBuffer.insert(m_memoryBuffer.end(), frames, frames + count);
+		return;
+	}
+
+	// never wait for the writer in the audio thread. Frames that don't fit are
+	// replaced by silence, so the rest of the take stays in time; until the
+	// writer got to that silence, any further frames are dropped as well
+	if (m_pendingSilence.load(std::memory_order_acquire) > 0)
+	{
+		m_pendingSilence.fetch_add(count, std::memory_order_acq_rel);
+		m_framesDropped += count;
+		return;
+	}
+
+	const auto written = m_ringBuffer.write(frames, count);
+	if (written < count)
+	{
+		m_pendingSilence.fetch_add(count - written, std::memory_order_acq_rel);
+		m_framesDropped += count - written;
 	}
 }
 
 
 
 
-bool SampleRecordHandle::isFinished() const
+void SampleRecording::openFile()
 {
-	return false;
+	static auto s_recordings = std::atomic<int>{0};
+
+	const auto dir = QDir{ConfigManager::inst()->userSamplesDir() + "recordings/"};
+	if (!dir.mkpath("."))
+	{
+		qWarning() << "Could not create" << dir.path() << "- keeping the recording in memory";
+		return;
+	}
+
+	m_fileName = dir.filePath(QString{"recording-%1-%2.wav"}
+		.arg(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss"))
+		.arg(s_recordings++));
+
+	auto info = SF_INFO{};
+	info.samplerate = Engine::audioEngine()->inputSampleRate();
+	info.channels = DEFAULT_CHANNELS;
+	info.format = SF_FORMAT_WAV | SF_FORMAT_FLOAT;
+
+	m_sndFile = sf_open(
+#ifdef LMMS_BUILD_WIN32
+		m_fileName.toLocal8Bit().constData(),
+#else
+		m_fileName.toUtf8().constData(),
+#endif
+		SFM_WRITE,
+		&info
+	);
+
+	if (!m_sndFile)
+	{
+		qWarning() << "Could not create" << m_fileName << "- keeping the recording in memory:" << sf_strerror(nullptr);
+		m_fileName.clear();
+	}
 }
 
 
 
 
-bool SampleRecordHandle::isFromTrack( const Track * _track ) const
+void SampleRecording::runWriter()
 {
-	return (m_track == _track || m_patternTrack == _track);
-}
+	auto frames = std::vector<SampleFrame>(m_ringBuffer.capacity());
 
+	while (true)
+	{
+		// read once more after having been stopped, so nothing written before is lost
+		const auto stopping = m_stopWriter.load();
 
+		// the frames before any silence were all written to the ring before it's set
+		const auto silence = m_pendingSilence.load(std::memory_order_acquire) > 0;
 
+		while (const auto available = std::min(m_ringBufferReader.read_space(), frames.size()))
+		{
+			m_ringBufferReader.read(available).copy(frames.data(), available);
+			sf_writef_float(m_sndFile, frames.data()->data(), available);
+		}
 
-f_cnt_t SampleRecordHandle::framesRecorded() const
-{
-	return( m_framesRecorded );
+		if (silence)
+		{
+			std::fill(frames.begin(), frames.end(), SampleFrame{});
+			for (auto left = m_pendingSilence.exchange(0, std::memory_order_acq_rel); left > 0;)
+			{
+				const auto count = std::min<std::size_t>(left, frames.size());
+				sf_writef_float(m_sndFile, frames.data()->data(), count);
+				left -= count;
+			}
+		}
+
+		if (stopping) { break; }
+		std::this_thread::sleep_for(WriterInterval);
+	}
 }
 
 
 
 
-std::shared_ptr<const SampleBuffer> SampleRecordHandle::createSampleBuffer()
+void SampleRecording::finishWriting()
 {
-	const f_cnt_t frames = framesRecorded();
-	// create buffer to store all recorded buffers in
-	auto bigBuffer = std::vector<SampleFrame>(frames);
+	if (m_writer.joinable())
+	{
+		m_stopWriter = true;
+		m_writer.join();
+	}
 
-	// now copy all buffers into big buffer
-	auto framesCopied = 0;
-	for (const auto& [buf, numFrames] : m_buffers)
+	if (m_sndFile)
 	{
-		std::copy_n(buf, numFrames, bigBuffer.begin() + framesCopied);
-		framesCopied += numFrames;
+		sf_close(m_sndFile);
+		m_sndFile = nullptr;
 	}
+}
+
+
+
+
+
+SampleRecordHandle::SampleRecordHandle(SampleClip* clip, std::shared_ptr<SampleRecording> recording) :
+	PlayHandle( Type::SamplePlayHandle ),
+	m_minLength( clip->length() ),
+	m_track( clip->getTrack() ),
+	m_patternTrack( nullptr ),
+	m_clip( clip ),
+	m_recording(std::move(recording))
+{
+}
+
+
+
 
-	// create according sample-buffer out of big buffer
-	return std::make_shared<const SampleBuffer>(std::move(bigBuffer), Engine::audioEngine()->inputSampleRate());
+SampleRecordHandle::~SampleRecordHandle()
+{
+	// closing the file and loading the take would stall the audio thread
+	ThreadPool::instance().enqueue([clip = QPointer<SampleClip>{m_clip}, recording = std::move(m_recording)] {
+		auto buffer = recording->framesRecorded() > 0 ? recording->createSampleBuffer() : nullptr;
+		QMetaObject::invokeMethod(QCoreApplication::instance(), [clip, buffer = std::move(buffer)] {
+			if (!clip) { return; }
+			if (buffer) { clip->setSampleBuffer(buffer); }
+			clip->setRecord(false);
+		}, Qt::QueuedConnection);
+	});
 }
 
 
 
 
-void SampleRecordHandle::writeBuffer( const SampleFrame* _ab, const f_cnt_t _frames )
+void SampleRecordHandle::play( SampleFrame* /*_working_buffer*/ )
 {
-	auto buf = new SampleFrame[_frames];
-	for( f_cnt_t frame = 0; frame < _frames; ++frame )
+	const SampleFrame* recbuf = Engine::audioEngine()->inputBuffer();
+	const f_cnt_t frames = Engine::audioEngine()->inputBufferFrames();
+	m_recording->write(recbuf, frames);
+
+	TimePos len = (tick_t)( m_recording->framesRecorded() / Engine::framesPerTick() );
+	if( len > m_minLength )
 	{
-		for( ch_cnt_t chnl = 0; chnl < DEFAULT_CHANNELS; ++chnl )
-		{
-			buf[frame][chnl] = _ab[frame][chnl];
-		}
+//		m_clip->changeLength( len );
+		m_minLength = len;
 	}
-	m_buffers.push_back( qMakePair( buf, _frames ) );
+}
+
+
+
+
+bool SampleRecordHandle::isFinished() const
+{
+	return false;
+}
+
+
+
+
+bool SampleRecordHandle::isFromTrack( const Track * _track ) const
+{
+	return (m_track == _track || m_patternTrack == _track);
+}
+
+
+
+
+f_cnt_t SampleRecordHandle::framesRecorded() const
+{
+	return m_recording->framesRecorded();
 }
 
 
@@ -0,0 +1,275 @@
+/*
+ * SampleStream.cpp - reads the frames of a streamed sample ahead for a voice
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "SampleStream.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "SampleBuffer.h"
+
+namespace lmms {
+
+namespace {
+
+//! Interval in which the prefetch thread tops up the read-ahead buffers
+constexpr auto PrefetchInterval = std::chrono::milliseconds{5};
+
+//! Read-ahead buffers the prefetch thread keeps free, so voices starting at once all get one
+constexpr auto SpareSlots = std::size_t{16};
+
+//! Read-ahead buffers there can be at most, about 128 MiB
+constexpr auto MaxSlots = std::size_t{1024};
+
+} // namespace
+
+/*
+ * The voice only reads frames from its position on, which only moves forward
+ * until it requests a restart, and the prefetch thread only writes frames
+ * less than ReadAheadFrames after the position it has seen last. Like that,
+ * the frames the voice may read are never overwritten while it reads them.
+ */
+struct SampleStream::Slot
+{
+	enum class State
+	{
+		Free,
+		Opening, //!< Claimed by a voice which is setting it up
+		Open,
+		Closed //!< The prefetch thread releases the buffer and frees it
+	};
+
+	std::atomic<State> state = State::Free;
+	std::shared_ptr<const SampleBuffer> buffer;
+	std::vector<SampleFrame> frames = std::vector<SampleFrame>(ReadAheadFrames);
+
+	// written by the voice
+	std::atomic<std::size_t> position = 0;
+	std::atomic<unsigned> requestedRestart = 0;
+
+	// written by the prefetch thread
+	std::atomic<std::size_t> end = 0;
+	std::atomic<unsigned> restart = 0;
+	std::size_t readEnd = 0;
+};
+
+//! Thread reading ahead for all streams, which also owns their read-ahead buffers
+class SampleStream::Prefetcher
+{
+public:
+	static auto instance() -> Prefetcher&
+	{
+		static auto s_prefetcher = Prefetcher{};
+		return s_prefetcher;
+	}
+
+	~Prefetcher()
+	{
+		{
+			const auto lock = std::lock_guard{m_mutex};
+			m_quit = true;
+		}
+		m_wake.notify_one();
+		m_thread.join();
+	}
+
+	//! Returns nullptr if all slots are in use
+	auto claim() -> Slot*
+	{
+		const auto count = m_slotCount.load(std::memory_order_acquire);
+		for (auto i = std::size_t{0}; i < count; ++i)
+		{
+			auto expected = Slot::State::Free;
+			if (m_slots[i]->state.compare_exchange_strong(expected, Slot::State::Opening, std::memory_order_acquire))
+			{
+				return m_slots[i].get();
+			}
+		}
+		return nullptr;
+	}
+
+	void wake() { m_wake.notify_one(); }
+
+private:
+	Prefetcher()
+		: m_slots(MaxSlots)
+	{
+		addSlots();
+		m_thread = std::thread{[this] { run(); }};
+	}
+
+	//! Makes sure there are SpareSlots free slots, only called by the prefetch thread once it runs
+	void addSlots()
+	{
+		auto count = m_slotCount.load(std::memory_order_relaxed);
+		const auto free = std::count_if(m_slots.begin(), m_slots.begin() + count,
+			[](const auto& slot) { return slot->state.load(std::memory_order_relaxed) == Slot::State::Free; });
+
+		for (auto i = static_cast<std::size_t>(free); i < SpareSlots && count < MaxSlots; ++i)
+		{
+			m_slots[count++] = std::make_unique<Slot>();
+		}
+		m_slotCount.store(count, std::memory_order_release);
+	}
+
+	void run()
+	{
+		while (true)
+		{
+			{
+				auto lock = std::unique_lock{m_mutex};
+				// woken early by voices (re)starting to read
+				if (!m_quit) { m_wake.wait_for(lock, PrefetchInterval); }
+				if (m_quit) { return; }
+			}
+
+			const auto count = m_slotCount.load(std::memory_order_relaxed);
+			for (auto i = std::size_t{0}; i < count; ++i)
+			{
+				auto& slot = *m_slots[i];
+				switch (slot.state.load(std::memory_order_acquire))
+				{
+				case Slot::State::Open:
+					prefetch(slot);
+					break;
+				case Slot::State::Closed:
+					// usually the last reference, so voices don't have to free buffers
+					slot.buffer.reset();
+					slot.state.store(Slot::State::Free, std::memory_order_release);
+					break;
+				default:
+					break;
+				}
+			}
+
+			addSlots();
+		}
+	}
+
+	static void prefetch(Slot& slot)
+	{
+		const auto requestedRestart = slot.requestedRestart.load(std::memory_order_acquire);
+		const auto restart = requestedRestart != slot.restart.load(std::memory_order_relaxed);
+
+		const auto position = slot.position.load(std::memory_order_acquire);
+		if (restart) { slot.readEnd = position; }
+
+		// frames before the position won't be read anymore
+		auto first = std::max(slot.readEnd, position);
+		const auto last = std::min(position + ReadAheadFrames, slot.buffer->decodedFrames());
+		while (first < last)
+		{
+			const auto index = first % ReadAheadFrames;
+			const auto count = std::min(last - first, ReadAheadFrames - index);
+			slot.buffer->read(first, count, slot.frames.data() + index);
+			first += count;
+		}
+
+		slot.readEnd = std::max(slot.readEnd, first);
+		slot.end.store(slot.readEnd, std::memory_order_release);
+		if (restart) { slot.restart.store(requestedRestart, std::memory_order_release); }
+	}
+
+	//! Only the first m_slotCount are allocated, the others are added by the prefetch thread
+	std::vector<std::unique_ptr<Slot>> m_slots;
+	std::atomic<std::size_t> m_slotCount = 0;
+
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	bool m_quit = false;
+	std::thread m_thread;
+};
+
+SampleStream::~SampleStream()
+{
+	close();
+}
+
+void SampleStream::prepare()
+{
+	Prefetcher::instance();
+}
+
+auto SampleStream::open(const std::shared_ptr<const SampleBuffer>& buffer, std::size_t position) -> bool
+{
+	close();
+
+	m_slot = Prefetcher::instance().claim();
+	if (!m_slot) { return false; }
+
+	// the prefetch thread doesn't touch the slot until it's open, and restarts reading ahead
+	// as the restart requested differs from the one it has done last
+	m_slot->buffer = buffer;
+	m_slot->position.store(position, std::memory_order_relaxed);
+	m_restart = m_slot->restart.load(std::memory_order_relaxed) + 1;
+	m_slot->requestedRestart.store(m_restart, std::memory_order_relaxed);
+	m_slot->state.store(Slot::State::Open, std::memory_order_release);
+
+	m_frames = m_slot->frames.data();
+	m_position = position;
+	m_available = 0;
+	Prefetcher::instance().wake();
+	return true;
+}
+
+void SampleStream::close()
+{
+	if (!m_slot) { return; }
+	m_slot->state.store(Slot::State::Closed, std::memory_order_release);
+	m_slot = nullptr;
+	m_frames = nullptr;
+}
+
+auto SampleStream::buffer() const -> const SampleBuffer*
+{
+	return m_slot ? m_slot->buffer.get() : nullptr;
+}
+
+void SampleStream::seek(std::size_t position)
+{
+	auto& slot = *m_slot;
+	const auto restarted = slot.restart.load(std::memory_order_acquire) == m_restart;
+	const auto end = restarted ? slot.end.load(std::memory_order_acquire) : std::size_t{0};
+
+	if (position >= m_position && (!restarted || position <= end))
+	{
+		// nothing can be read before the prefetch thread has restarted
+		m_available = end;
+		m_position = position;
+		slot.position.store(position, std::memory_order_release);
+		return;
+	}
+
+	m_available = 0;
+	m_position = position;
+	slot.position.store(position, std::memory_order_release);
+	slot.requestedRestart.store(++m_restart, std::memory_order_release);
+	Prefetcher::instance().wake();
+}
+
+} // namespace lmms
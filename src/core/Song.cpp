@@ -27,10 +27,13 @@
 #include <QCoreApplication>
 #include <QDebug>
 #include <QFile>
+#include <QFileInfo>
 #include <QMessageBox>
 
 #include <algorithm>
 #include <cmath>
+#include <utility>
+#include <vector>
 
 #include "AutomationTrack.h"
 #include "AutomationEditor.h"
@@ -48,12 +51,18 @@
 #include "MidiClip.h"
 #include "PatternEditor.h"
 #include "PatternStore.h"
+#include "PathUtil.h"
 #include "PatternTrack.h"
+#include "PerfLog.h"
 #include "PianoRoll.h"
 #include "ProjectJournal.h"
 #include "ProjectNotes.h"
+#include "RenderCache.h"
+#include "SampleCache.h"
+#include "SampleDecoder.h"
 #include "Scale.h"
 #include "SongEditor.h"
+#include "TimeStretch.h"
 #include "PeakController.h"
 
 
@@ -62,6 +71,79 @@ namespace lmms
 
 tick_t TimePos::s_ticksPerBar = DefaultTicksPerBar;
 
+namespace
+{
+
+//! Returns the existing audio files the clips, instruments etc. in a project refer to
+QStringList referencedAudioFiles(const QDomElement& content)
+{
+	auto extensions = QStringList{};
+	for (const auto& audioType : SampleDecoder::supportedAudioTypes())
+	{
+		extensions.append(QString::fromStdString(audioType.extension));
+	}
+
+	auto audioFiles = QStringList{};
+	const auto elements = content.elementsByTagName("*");
+	for (int i = 0; i < elements.count(); ++i)
+	{
+		const auto attributes = elements.at(i).attributes();
+		for (int j = 0; j < attributes.count(); ++j)
+		{
+			const auto attribute = attributes.item(j).toAttr();
+			if (attribute.name() != "src" && !attribute.name().startsWith("userwavefile")) { continue; }
+
+			const auto file = attribute.value();
+			const auto info = QFileInfo{PathUtil::toAbsolute(file)};
+			if (!file.isEmpty() && !audioFiles.contains(file)
+				&& extensions.contains(info.suffix().toLower()) && info.isFile())
+			{
+				audioFiles.append(file);
+			}
+		}
+	}
+	return audioFiles;
+}
+
+//! Returns the most notes the MIDI clips of @p tracks play at the same time, summed up over the tracks
+int maxPolyphony(const TrackContainer::TrackList& tracks)
+{
+	auto polyphony = 0;
+	for (const auto track : tracks)
+	{
+		if (track->type() != Track::Type::Instrument) { continue; }
+
+		auto trackPolyphony = 0;
+		for (const auto clip : track->getClips())
+		{
+			const auto midiClip = dynamic_cast<const MidiClip*>(clip);
+			if (!midiClip) { continue; }
+
+			// note starts and ends, ends sorted before starts at the same position
+			auto events = std::vector<std::pair<int, int>>{};
+			for (const auto note : midiClip->notes())
+			{
+				const int start = note->pos();
+				const int end = note->endPos();
+				events.emplace_back(start, 1);
+				events.emplace_back(std::max(end, start + 1), -1);
+			}
+			std::sort(events.begin(), events.end());
+
+			auto playing = 0;
+			for (const auto& [pos, change] : events)
+			{
+				playing += change;
+				trackPolyphony = std::max(trackPolyphony, playing);
+			}
+		}
+		polyphony += trackPolyphony;
+	}
+	return polyphony;
+}
+
+} // namespace
+
 
 
 Song::Song() :
@@ -95,8 +177,7 @@ Song::Song() :
 	m_elapsedTicks( 0 ),
 	m_elapsedBars( 0 ),
 	m_loopRenderCount(1),
-	m_loopRenderRemaining(1),
-	m_oldAutomatedValues()
+	m_loopRenderRemaining(1)
 {
 	for (double& millisecondsElapsed : m_elapsedMilliSeconds) { millisecondsElapsed = 0; }
 	connect( &m_tempoModel, SIGNAL(dataChanged()),
@@ -146,7 +227,7 @@ void Song::setTempo()
 {
 	Engine::audioEngine()->requestChangeInModel();
 	const auto tempo = (bpm_t)m_tempoModel.value();
-	PlayHandleList & playHandles = Engine::audioEngine()->playHandles();
+	const PlayHandleList & playHandles = Engine::audioEngine()->playHandles();
 	for (const auto& playHandle : playHandles)
 	{
 		auto nph = dynamic_cast<NotePlayHandle*>(playHandle);
@@ -263,22 +344,32 @@ void Song::processNextBuffer()
 		getPlayPos().setJumped(false);
 	}
 
-	const auto framesPerTick = Engine::framesPerTick();
 	const auto framesPerPeriod = Engine::audioEngine()->framesPerPeriod();
+	const auto sampleRate = Engine::audioEngine()->outputSampleRate();
 
 	f_cnt_t frameOffsetInPeriod = 0;
 
 	while (frameOffsetInPeriod < framesPerPeriod)
 	{
-		auto frameOffsetInTick = getPlayPos().currentFrame();
+		// Tempo automation may have changed the tempo on the last tick
+		if (!m_transportSchedule.fits(sampleRate, getTempo()))
+		{
+			m_transportSchedule = TransportSchedule{sampleRate, getTempo(), getPlayPos().getTicks()};
+		}
+
+		auto frameOffsetInTick = static_cast<f_cnt_t>(getPlayPos().currentFrame());
 
 		// If a whole tick has elapsed, update the frame and tick count, and check any loops
-		if (frameOffsetInTick >= framesPerTick)
+		if (frameOffsetInTick >= m_transportSchedule.tickLength(getPlayPos().getTicks()))
 		{
 			// Transfer any whole ticks from the frame count to the tick count
-			const auto elapsedTicks = static_cast<int>(frameOffsetInTick / framesPerTick);
-			getPlayPos().setTicks(getPlayPos().getTicks() + elapsedTicks);
-			frameOffsetInTick -= elapsedTicks * framesPerTick;
+			auto ticks = getPlayPos().getTicks();
+			while (frameOffsetInTick >= m_transportSchedule.tickLength(ticks))
+			{
+				frameOffsetInTick -= m_transportSchedule.tickLength(ticks);
+				++ticks;
+			}
+			getPlayPos().setTicks(ticks);
 			getPlayPos().setCurrentFrame(frameOffsetInTick);
 
 			// If we are playing a pattern track, or a MIDI clip with no loop enabled,
@@ -312,10 +403,11 @@ void Song::processNextBuffer()
 		}
 
 		const f_cnt_t framesUntilNextPeriod = framesPerPeriod - frameOffsetInPeriod;
-		const auto framesUntilNextTick = static_cast<f_cnt_t>(std::ceil(framesPerTick - frameOffsetInTick));
+		const f_cnt_t framesUntilNextTick = m_transportSchedule.tickLength(getPlayPos().getTicks()) - frameOffsetInTick;
 
 		// We want to proceed to the next buffer or tick, whichever is closer
 		const auto framesToPlay = std::min(framesUntilNextPeriod, framesUntilNextTick);
+		const auto framesPerTick = Engine::framesPerTick();
 
 		if (frameOffsetInPeriod == 0)
 		{
@@ -323,13 +415,14 @@ void Song::processNextBuffer()
 			// This must be done after we've corrected the frame/tick count,
 			// but before actually playing any frames.
 			m_vstSyncController.setAbsolutePosition(getPlayPos().getTicks()
-				+ getPlayPos().currentFrame() / static_cast<double>(framesPerTick));
+				+ frameOffsetInTick / static_cast<double>(framesPerTick));
 			m_vstSyncController.update();
 		}
 
-		if (static_cast<f_cnt_t>(frameOffsetInTick) == 0)
+		if (frameOffsetInTick == 0)
 		{
 			// First frame of tick: process automation and play tracks
+			AutomatableModel::setPeriodFrameOffset(frameOffsetInPeriod);
 			processAutomations(trackList, getPlayPos(), framesToPlay);
 			processMetronome(frameOffsetInPeriod);
 
@@ -347,91 +440,28 @@ void Song::processNextBuffer()
 		m_elapsedBars = getPlayPos(PlayMode::Song).getBar();
 		m_elapsedTicks = (getPlayPos(PlayMode::Song).getTicks() % ticksPerBar()) / 48;
 	}
+	AutomatableModel::setPeriodFrameOffset(0);
 }
 
 
 void Song::processAutomations(const TrackList &tracklist, TimePos timeStart, fpp_t)
 {
-	AutomatedValueMap values;
-
-	QSet<const AutomatableModel*> recordedModels;
-
-	TrackContainer* container = this;
-	int clipNum = -1;
-
 	switch (m_playMode)
 	{
 	case PlayMode::Song:
+		m_activeAutomation.process(*this, m_globalAutomationTrack, timeStart, -1);
 		break;
 	case PlayMode::Pattern:
 	{
 		if (tracklist.empty()) { return; }
 		Q_ASSERT(tracklist.at(0)->type() == Track::Type::Pattern);
 		auto patternTrack = dynamic_cast<PatternTrack*>(tracklist.at(0));
-		container = Engine::patternStore();
-		clipNum = patternTrack->patternIndex();
+		m_activeAutomation.process(*Engine::patternStore(), nullptr, timeStart, patternTrack->patternIndex());
 	}
 		break;
 	default:
 		return;
 	}
-
-	values = container->automatedValuesAt(timeStart, clipNum);
-	const TrackList& tracks = container->tracks();
-
-	Track::clipVector clips;
-	for (Track* track : tracks)
-	{
-		if (track->type() == Track::Type::Automation) {
-			track->getClipsInRange(clips, 0, timeStart);
-		}
-	}
-
-	// Process recording
-	for (Clip* clip : clips)
-	{
-		auto p = dynamic_cast<AutomationClip *>(clip);
-		TimePos relTime = timeStart - p->startPosition();
-		if (p->isRecording() && relTime >= 0 && relTime < p->length())
-		{
-			const AutomatableModel* recordedModel = p->firstObject();
-			// The automation system really needs to be reworked.
-			// For whatever reason, the values in an automation clip are stored in un-un-scaled format, so if you
-			// are automating a log knob, when you draw an curve, the values being stored are not the actual values the
-			// knob will take, but instead the unscaled version of the unscaled numbers. The tooltip shows the number you expect, but if you double-click,
-			// you can see that the true values are stored by their inverse scaled value....which is wrong, since they weren't scaled in the first place...?
-			// Anyhow, in the meantime before we redo the automation system, when recording automations, we have to get the inverseScaledValue
-			// and store that so that when playing it back, it scales the value correctly.
-			p->recordValue(relTime, recordedModel->inverseScaledValue(recordedModel->value<float>()));
-
-			recordedModels << recordedModel;
-		}
-	}
-
-	// Checks if an automated model stopped being automated by automation clip
-	// so we can move the control back to any connected controller again
-	for (auto it = m_oldAutomatedValues.begin(); it != m_oldAutomatedValues.end(); it++)
-	{
-		AutomatableModel * am = it.key();
-		if (am->controllerConnection() && !values.contains(am))
-		{
-			am->setUseControllerValue(true);
-		}
-	}
-	m_oldAutomatedValues = values;
-
-	// Apply values
-	for (auto it = values.begin(); it != values.end(); it++)
-	{
-		if (! recordedModels.contains(it.key()))
-		{
-			it.key()->setAutomatedValue(it.value());
-		}
-		else if (!it.key()->useControllerValue())
-		{
-			it.key()->setUseControllerValue(true);
-		}
-	}
 }
 
 void Song::processMetronome(size_t bufferOffset)
@@ -710,12 +740,7 @@ void Song::stop()
 
 	// Moves the control of the models that were processed on the last frame
 	// back to their controllers.
-	for (auto it = m_oldAutomatedValues.begin(); it != m_oldAutomatedValues.end(); it++)
-	{
-		AutomatableModel * am = it.key();
-		am->setUseControllerValue(true);
-	}
-	m_oldAutomatedValues.clear();
+	m_activeAutomation.release();
 
 	m_playMode = PlayMode::None;
 
@@ -772,6 +797,12 @@ void Song::startExport()
 		* m_loopRenderCount + (m_exportSongEnd - m_exportLoopEnd);
 	m_loopRenderRemaining = m_loopRenderCount;
 
+	// the audio engine never waits for stretched samples, which have to be
+	// rendered before exporting, so they are played stretched from the start.
+	// Patterns may contain sample tracks as well.
+	finishStretch();
+	Engine::patternStore()->finishStretch();
+
 	playSong();
 
 	m_vstSyncController.setPlaybackState( true );
@@ -914,8 +945,7 @@ void Song::clearProject()
 	m_masterPitchModel.reset();
 	m_timeSigModel.reset();
 
-	// Clear the m_oldAutomatedValues AutomatedValueMap
-	m_oldAutomatedValues.clear();
+	m_activeAutomation.clear();
 
 	AutomationClip::globalAutomationClip( &m_tempoModel )->clear();
 	AutomationClip::globalAutomationClip( &m_masterVolumeModel )->
@@ -931,6 +961,8 @@ void Song::clearProject()
 	}
 
 	removeAllControllers();
+	RenderCache::clear();
+	TimeStretch::clear();
 
 	emit dataChanged();
 
@@ -1033,6 +1065,9 @@ void Song::loadProject( const QString & fileName )
 	m_oldFileName = m_fileName;
 	setProjectFileName(fileName);
 
+	// time the stages of loading, see PerfLogReport::toString()
+	PerfLogReport::begin(fileName);
+
 	DataFile dataFile( m_fileName );
 
 	bool cantLoadProject = false;
@@ -1071,6 +1106,7 @@ void Song::loadProject( const QString & fileName )
 
 	if (cantLoadProject)
 	{
+		PerfLogReport::end();
 		if( m_loadOnLaunch )
 		{
 			createNewProject();
@@ -1098,6 +1134,8 @@ void Song::loadProject( const QString & fileName )
 	//Backward compatibility for LMMS <= 0.4.15
 	PeakController::initGetControllerBySetting();
 
+	auto mixerTimer = PerfLogReport::Timer("Load", "mixer");
+
 	// Load mixer first to be able to set the correct range for mixer channels
 	node = dataFile.content().firstChildElement( Engine::mixer()->nodeName() );
 	if( !node.isNull() )
@@ -1110,6 +1148,13 @@ void Song::loadProject( const QString & fileName )
 		}
 	}
 
+	// start decoding all samples in parallel, the tracks pick them up from the
+	// sample cache while being loaded and play silence until they are ready
+	const auto prefetchedSamples = SampleCache::prefetch(referencedAudioFiles(dataFile.content()));
+	mixerTimer.end();
+
+	auto tracksTimer = PerfLogReport::Timer("Load", "tracks");
+
 	node = dataFile.content().firstChild();
 
 	QDomNodeList tclist=dataFile.content().elementsByTagName("trackcontainer");
@@ -1179,6 +1224,10 @@ void Song::loadProject( const QString & fileName )
 		node = node.nextSibling();
 	}
 
+	tracksTimer.end();
+
+	auto connectionsTimer = PerfLogReport::Timer("Load", "connections");
+
 	// quirk for fixing projects with broken positions of Clips inside pattern tracks
 	Engine::patternStore()->fixIncorrectPositions();
 
@@ -1194,6 +1243,12 @@ void Song::loadProject( const QString & fileName )
 	// resolve all IDs so that autoModels are automated
 	AutomationClip::resolveAllIDs();
 
+	// released notes keep their voices until their release is done, so the
+	// next notes may need as many again
+	NotePlayHandleManager::reserve(INITIAL_NPH_CACHE
+		+ 2 * (maxPolyphony(tracks()) + maxPolyphony(Engine::patternStore()->tracks())));
+	connectionsTimer.end();
+	PerfLogReport::end();
 
 	Engine::audioEngine()->doneChangeInModel();
 
@@ -1236,10 +1291,19 @@ void Song::loadProject( const QString & fileName )
 
 // only save current song as filename and do nothing else
 bool Song::saveProjectFile(const QString & filename, bool withResources)
+{
+	return projectSnapshot(withResources).writeFile(filename, withResources);
+}
+
+
+
+
+DataFile Song::projectSnapshot(bool withResources)
 {
 	using gui::getGUI;
 
 	DataFile dataFile( DataFile::Type::SongProject );
+	dataFile.setBundlesSamples(withResources);
 	m_savingProject = true;
 
 	m_tempoModel.saveSettings( dataFile, dataFile.head(), "bpm" );
@@ -1266,7 +1330,7 @@ bool Song::saveProjectFile(const QString & filename, bool withResources)
 
 	m_savingProject = false;
 
-	return dataFile.writeFile(filename, withResources);
+	return dataFile;
 }
 
 
@@ -1402,22 +1466,20 @@ void Song::restoreKeymapStates(const QDomElement &element)
 }
 
 
-void Song::exportProjectMidi(QString const & exportFileName) const
+bool Song::exportProjectMidi(QString const & exportFileName) const
 {
 	// instantiate midi export plugin
 	TrackContainer::TrackList const & tracks = this->tracks();
 	TrackContainer::TrackList const & patternStoreTracks = Engine::patternStore()->tracks();
 
-	ExportFilter *exf = dynamic_cast<ExportFilter *> (Plugin::instantiate("midiexport", nullptr, nullptr));
-	if (exf)
-	{
-		exf->tryExport(tracks, patternStoreTracks, getTempo(), m_masterPitchModel.value(), exportFileName);
-	}
-	else
+	auto exf = std::unique_ptr<Plugin>{Plugin::instantiate("midiexport", nullptr, nullptr)};
+	if (auto filter = dynamic_cast<ExportFilter*>(exf.get()))
 	{
-		qDebug() << "failed to load midi export filter!";
+		return filter->tryExport(tracks, patternStoreTracks, getTempo(), m_masterPitchModel.value(), exportFileName);
 	}
 
+	qDebug() << "failed to load midi export filter!";
+	return false;
 }
 
 
@@ -0,0 +1,247 @@
+/*
+ * StartupScheduler.cpp - parallel and deferred tasks while starting up
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "StartupScheduler.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QPointer>
+#include <QTimer>
+
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace lmms
+{
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+struct Entry
+{
+	QString kind;
+	QString name;
+	double start;
+	double seconds;
+};
+
+struct State
+{
+	std::mutex mutex;
+	//! Static initialization happens right when the program starts
+	Clock::time_point origin = Clock::now();
+	std::vector<Entry> entries;
+	std::map<QString, std::future<void>> tasks;
+
+	QString phase;
+	Clock::time_point phaseBegin;
+
+	int deferred = 0;
+	bool finished = false;
+	QString reportFile;
+};
+
+State& state()
+{
+	static auto s = State();
+	return s;
+}
+
+double secondsSince(Clock::time_point from, Clock::time_point to)
+{
+	return std::chrono::duration<double>(to - from).count();
+}
+
+//! Must be called with the mutex locked
+void addEntry(State& s, const QString& kind, const QString& name, Clock::time_point begin, Clock::time_point end)
+{
+	s.entries.push_back(Entry{kind, name, secondsSince(s.origin, begin), secondsSince(begin, end)});
+}
+
+void writeReportIfDone()
+{
+	State& s = state();
+	auto fileName = QString();
+	{
+		const auto lock = std::lock_guard{s.mutex};
+		if (!s.finished || s.deferred > 0 || s.reportFile.isEmpty()) { return; }
+		std::swap(fileName, s.reportFile);
+	}
+
+	auto file = QFile(fileName);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+	{
+		qWarning() << "Could not write the startup report to" << fileName;
+		return;
+	}
+	file.write(StartupScheduler::report().toUtf8());
+}
+
+} // namespace
+
+
+
+
+void StartupScheduler::start(const QString& name, std::function<void()> task)
+{
+	State& s = state();
+	auto done = std::async(std::launch::async, [name, task = std::move(task)] {
+		const auto begin = Clock::now();
+		task();
+		const auto end = Clock::now();
+
+		State& s = state();
+		const auto lock = std::lock_guard{s.mutex};
+		addEntry(s, "parallel", name, begin, end);
+	});
+
+	const auto lock = std::lock_guard{s.mutex};
+	s.tasks[name] = std::move(done);
+}
+
+
+
+
+void StartupScheduler::wait(const QString& name)
+{
+	State& s = state();
+	auto done = std::future<void>();
+	{
+		const auto lock = std::lock_guard{s.mutex};
+		const auto it = s.tasks.find(name);
+		if (it == s.tasks.end()) { return; }
+		done = std::move(it->second);
+		s.tasks.erase(it);
+	}
+	done.get();
+}
+
+
+
+
+void StartupScheduler::defer(const QString& name, QObject* context, std::function<void()> task)
+{
+	State& s = state();
+	{
+		const auto lock = std::lock_guard{s.mutex};
+		++s.deferred;
+	}
+
+	// the task is queued on the application, so the count of deferred tasks
+	// also goes down if the context is deleted before
+	const bool hasContext = context != nullptr;
+	QTimer::singleShot(0, QCoreApplication::instance(),
+		[name, guard = QPointer<QObject>(context), hasContext, task = std::move(task)] {
+			State& s = state();
+			if (!hasContext || guard)
+			{
+				const auto begin = Clock::now();
+				task();
+				const auto end = Clock::now();
+
+				const auto lock = std::lock_guard{s.mutex};
+				addEntry(s, "deferred", name, begin, end);
+			}
+			{
+				const auto lock = std::lock_guard{s.mutex};
+				--s.deferred;
+			}
+			writeReportIfDone();
+		});
+}
+
+
+
+
+void StartupScheduler::beginPhase(const QString& name)
+{
+	State& s = state();
+	const auto now = Clock::now();
+
+	const auto lock = std::lock_guard{s.mutex};
+	if (!s.phase.isEmpty()) { addEntry(s, "phase", s.phase, s.phaseBegin, now); }
+	s.phase = name;
+	s.phaseBegin = now;
+}
+
+
+
+
+void StartupScheduler::finish()
+{
+	beginPhase(QString());
+	{
+		State& s = state();
+		const auto lock = std::lock_guard{s.mutex};
+		s.finished = true;
+	}
+
+	// queued after the tasks deferred while starting up
+	QTimer::singleShot(0, QCoreApplication::instance(), &writeReportIfDone);
+}
+
+
+
+
+void StartupScheduler::reportTo(const QString& fileName)
+{
+	State& s = state();
+	const auto lock = std::lock_guard{s.mutex};
+	s.reportFile = fileName;
+}
+
+
+
+
+QString StartupScheduler::report()
+{
+	State& s = state();
+	auto entries = std::vector<Entry>();
+	{
+		const auto lock = std::lock_guard{s.mutex};
+		entries = s.entries;
+	}
+	std::stable_sort(entries.begin(), entries.end(),
+		[](const Entry& a, const Entry& b) { return a.start < b.start; });
+
+	const auto seconds = [](double value) { return QString::number(value, 'f', 3).rightJustified(10); };
+
+	auto text = QString("Startup report\n\n");
+	text += QString("Kind").leftJustified(10) + QString("Name").leftJustified(40)
+		+ QString("Start s").rightJustified(10) + QString("Took s").rightJustified(10) + '\n';
+	for (const auto& entry : entries)
+	{
+		text += entry.kind.leftJustified(9) + ' ' + entry.name.leftJustified(39) + ' '
+			+ seconds(entry.start) + seconds(entry.seconds) + '\n';
+	}
+	return text;
+}
+
+
+} // namespace lmms
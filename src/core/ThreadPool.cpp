@@ -25,6 +25,8 @@
 
 #include <cassert>
 
+#include "denormals.h"
+
 namespace lmms {
 ThreadPool::ThreadPool(size_t numWorkers)
 {
@@ -59,6 +61,9 @@ auto ThreadPool::numWorkers() const -> size_t
 
 void ThreadPool::run()
 {
+	// tasks may process audio, e.g. when rendering ahead of time
+	disable_denormals();
+
 	while (!m_done)
 	{
 		std::function<void()> task;
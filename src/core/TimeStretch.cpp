@@ -0,0 +1,206 @@
+/*
+ * TimeStretch.cpp - changes the length of samples without changing their pitch
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "TimeStretch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <numbers>
+#include <tuple>
+#include <vector>
+
+#include "SampleBuffer.h"
+#include "ThreadPool.h"
+
+namespace lmms {
+
+namespace {
+
+//! Length of the windows, long enough to hold a period of most bass notes
+constexpr auto WindowMilliseconds = 40;
+//! Renders of other ratios of a buffer kept around, e.g. for songs changing their tempo
+constexpr auto MaxRendersPerBuffer = std::size_t{4};
+//! Ratios closer than this share their render
+constexpr auto RatioResolution = 10000.0;
+
+struct Key
+{
+	const SampleBuffer* buffer;
+	std::int64_t ratio;
+
+	friend auto operator<(const Key& a, const Key& b) -> bool
+	{
+		return std::tie(a.buffer, a.ratio) < std::tie(b.buffer, b.ratio);
+	}
+};
+
+struct Entry
+{
+	//! Tells whether the buffer the key points to is still the one rendered
+	std::weak_ptr<const SampleBuffer> buffer;
+	TimeStretch::Render render;
+	std::uint64_t lastUsed = 0;
+};
+
+struct Cache
+{
+	std::mutex mutex;
+	std::map<Key, Entry> entries;
+	std::uint64_t uses = 0;
+};
+
+auto cache() -> Cache&
+{
+	static auto s_cache = Cache{};
+	return s_cache;
+}
+
+//! Drops the renders of buffers not in use anymore, and the least recently used ones of @p buffer
+//! beyond MaxRendersPerBuffer. Expects the cache to be locked.
+void prune(Cache& c, const SampleBuffer* buffer)
+{
+	auto renders = std::vector<std::map<Key, Entry>::iterator>{};
+	for (auto it = c.entries.begin(); it != c.entries.end();)
+	{
+		if (it->second.buffer.expired()) { it = c.entries.erase(it); continue; }
+		if (it->first.buffer == buffer) { renders.push_back(it); }
+		++it;
+	}
+
+	if (renders.size() <= MaxRendersPerBuffer) { return; }
+	std::sort(renders.begin(), renders.end(),
+		[](const auto& a, const auto& b) { return a->second.lastUsed > b->second.lastUsed; });
+	for (auto it = renders.begin() + MaxRendersPerBuffer; it != renders.end(); ++it)
+	{
+		c.entries.erase(*it);
+	}
+}
+
+} // namespace
+
+auto TimeStretch::stretch(const SampleBuffer& buffer, double ratio) -> SampleBuffer
+{
+	const auto input = buffer.data();
+	const auto inputFrames = static_cast<std::ptrdiff_t>(buffer.size());
+	const auto outputFrames = static_cast<std::ptrdiff_t>(std::lround(inputFrames * ratio));
+	if (inputFrames == 0 || outputFrames <= 0 || ratio == 1.0)
+	{
+		return SampleBuffer{input, buffer.size(), static_cast<int>(buffer.sampleRate())};
+	}
+
+	// the windows overlap by half, where Hann windows add up to 1
+	const auto window = std::max<std::ptrdiff_t>(64, buffer.sampleRate() * WindowMilliseconds / 1000 / 2 * 2);
+	const auto hop = window / 2;
+	const auto tolerance = hop / 2;
+	const auto inputHop = hop / ratio;
+
+	auto hann = std::vector<float>(window);
+	for (auto i = std::ptrdiff_t{0}; i < window; ++i)
+	{
+		hann[i] = 0.5f - 0.5f * static_cast<float>(std::cos(2 * std::numbers::pi * i / window));
+	}
+
+	// the similarity is measured on the sum of both channels, padded so no index is out of bounds
+	const auto padding = window + tolerance;
+	auto mono = std::vector<float>(inputFrames + 2 * padding);
+	for (auto i = std::ptrdiff_t{0}; i < inputFrames; ++i)
+	{
+		mono[padding + i] = input[i][0] + input[i][1];
+	}
+
+	auto output = std::vector<SampleFrame>(outputFrames + window);
+	auto weights = std::vector<float>(outputFrames + window);
+	auto position = std::ptrdiff_t{0};
+	for (auto k = std::ptrdiff_t{1}, outputPosition = std::ptrdiff_t{0}; outputPosition < outputFrames;
+		++k, outputPosition += hop)
+	{
+		for (auto i = std::ptrdiff_t{0}; i < window; ++i)
+		{
+			const auto frame = position + i;
+			if (frame >= 0 && frame < inputFrames) { output[outputPosition + i] += input[frame] * hann[i]; }
+			weights[outputPosition + i] += hann[i];
+		}
+
+		// the next window is shifted to where it continues the current one the most naturally
+		const auto natural = mono.data() + padding + std::min(position + hop, inputFrames);
+		const auto nominal = std::min(static_cast<std::ptrdiff_t>(std::lround(k * inputHop)), inputFrames);
+		auto bestShift = std::ptrdiff_t{0};
+		auto bestSimilarity = -1.f;
+		for (auto shift = -tolerance; shift <= tolerance; ++shift)
+		{
+			const auto candidate = mono.data() + padding + nominal + shift;
+			auto similarity = 0.f;
+			for (auto i = std::ptrdiff_t{0}; i < hop; i += 2)
+			{
+				similarity += natural[i] * candidate[i];
+			}
+			if (similarity > bestSimilarity)
+			{
+				bestSimilarity = similarity;
+				bestShift = shift;
+			}
+		}
+		position = nominal + bestShift;
+	}
+
+	// only the very beginning and end aren't covered by two windows
+	for (auto i = std::ptrdiff_t{0}; i < outputFrames; ++i)
+	{
+		if (weights[i] > 1e-3f) { output[i] *= 1.f / weights[i]; }
+	}
+	output.resize(outputFrames);
+
+	return SampleBuffer{std::move(output), static_cast<int>(buffer.sampleRate())};
+}
+
+auto TimeStretch::render(std::shared_ptr<const SampleBuffer> buffer, double ratio) -> Render
+{
+	auto& c = cache();
+	const auto lock = std::lock_guard{c.mutex};
+
+	const auto key = Key{buffer.get(), std::llround(ratio * RatioResolution)};
+	if (const auto it = c.entries.find(key); it != c.entries.end() && it->second.buffer.lock() == buffer)
+	{
+		it->second.lastUsed = ++c.uses;
+		return it->second.render;
+	}
+
+	auto render = ThreadPool::instance().enqueue([buffer, ratio] {
+		return std::make_shared<const SampleBuffer>(stretch(*buffer, ratio));
+	}).share();
+
+	c.entries[key] = Entry{buffer, render, ++c.uses};
+	prune(c, buffer.get());
+	return render;
+}
+
+void TimeStretch::clear()
+{
+	auto& c = cache();
+	const auto lock = std::lock_guard{c.mutex};
+	c.entries.clear();
+}
+
+} // namespace lmms
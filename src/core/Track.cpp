@@ -29,6 +29,8 @@
 
 #include "Track.h"
 
+#include <algorithm>
+#include <limits>
 #include <QDomElement>
 #include <QVariant>
 
@@ -341,6 +343,8 @@ void Track::loadSettings(const QDomElement& element)
 Clip * Track::addClip( Clip * clip )
 {
 	m_clips.push_back( clip );
+	clipMoved();
+	TrackContainer::arrangementChanged();
 
 	emit clipAdded( clip );
 
@@ -360,6 +364,8 @@ void Track::removeClip( Clip * clip )
 	if( it != m_clips.end() )
 	{
 		m_clips.erase( it );
+		clipMoved();
+		TrackContainer::arrangementChanged();
 		if( Engine::getSong() )
 		{
 			Engine::getSong()->updateLength();
@@ -456,18 +462,46 @@ int Track::getClipNum( const Clip * clip )
 void Track::getClipsInRange( clipVector & clipV, const TimePos & start,
 							const TimePos & end )
 {
-	for( Clip* clip : m_clips )
+	QMutexLocker locker(&m_clipIndexMutex);
+
+	// the revision is read first, so changes made while building are caught by the next query
+	const auto revision = m_clipsRevision.load(std::memory_order_acquire);
+	if (revision != m_clipIndexRevision)
 	{
-		int s = clip->startPosition();
-		int e = clip->endPosition();
-		if( ( s <= end ) && ( e >= start ) )
+		m_clipIndex.clear();
+		m_clipIndex.reserve(m_clips.size());
+		for (Clip* clip : m_clips)
+		{
+			m_clipIndex.push_back({clip->startPosition(), clip->endPosition(), 0, clip});
+		}
+		// stable, so clips at the same position keep their order like before
+		std::stable_sort(m_clipIndex.begin(), m_clipIndex.end(),
+			[](const ClipIndexEntry& a, const ClipIndexEntry& b) { return a.start < b.start; });
+
+		auto reach = std::numeric_limits<tick_t>::min();
+		for (auto& entry : m_clipIndex)
 		{
-			// Clip is within given range
-			// Insert sorted by Clip's position
-			clipV.insert(std::upper_bound(clipV.begin(), clipV.end(), clip, Clip::comparePosition),
-						clip);
+			reach = std::max(reach, entry.end);
+			entry.reach = reach;
 		}
+		m_clipIndexRevision = revision;
+	}
+
+	// Only clips starting at or before the end can be in range, and of those
+	// only the ones from the first one reaching the start on. Clips on a
+	// track rarely overlap, so nearly all of these are.
+	const auto last = std::upper_bound(m_clipIndex.begin(), m_clipIndex.end(), end.getTicks(),
+		[](tick_t pos, const ClipIndexEntry& entry) { return pos < entry.start; });
+	const auto first = std::lower_bound(m_clipIndex.begin(), last, start.getTicks(),
+		[](const ClipIndexEntry& entry, tick_t pos) { return entry.reach < pos; });
+
+	const auto previousSize = clipV.size();
+	for (auto it = first; it != last; ++it)
+	{
+		if (it->end >= start.getTicks()) { clipV.push_back(it->clip); }
 	}
+	// Insert sorted by Clip's position
+	std::inplace_merge(clipV.begin(), clipV.begin() + previousSize, clipV.end(), Clip::comparePosition);
 }
 
 
@@ -484,6 +518,7 @@ void Track::getClipsInRange( clipVector & clipV, const TimePos & start,
 void Track::swapPositionOfClips( int clipNum1, int clipNum2 )
 {
 	qSwap( m_clips[clipNum1], m_clips[clipNum2] );
+	clipMoved();
 
 	const TimePos pos = m_clips[clipNum1]->startPosition();
 
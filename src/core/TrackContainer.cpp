@@ -27,14 +27,25 @@
 #include <QCoreApplication>
 #include <QProgressDialog>
 #include <QDomElement>
+#include <QTextStream>
+#include <QThread>
 #include <QWriteLocker>
 
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <optional>
+#include <vector>
+
 #include "AutomationClip.h"
 #include "embed.h"
+#include "Engine.h"
 #include "TrackContainer.h"
+#include "MidiClip.h"
 #include "PatternClip.h"
 #include "PatternStore.h"
 #include "PatternTrack.h"
+#include "SampleClip.h"
 #include "Song.h"
 
 #include "GuiApplication.h"
@@ -44,6 +55,117 @@
 namespace lmms
 {
 
+namespace
+{
+
+//! Parses the notes of tracks ahead of loading them, on worker threads. A
+//! track which isn't parsed yet when it is loaded is parsed by the loading
+//! thread itself instead of waiting.
+//!
+//! QDom isn't thread-safe, not even for reading, so the workers never touch
+//! the project's document: the clips are saved as text, which every worker
+//! parses into a document of its own.
+class NoteParser
+{
+public:
+	explicit NoteParser(const std::vector<QDomElement>& tracks) :
+		m_tracks(tracks.size()),
+		m_claimed(tracks.size()),
+		m_results(tracks.size())
+	{
+		for (std::size_t i = 0; i < tracks.size(); ++i)
+		{
+			for (auto clip = tracks[i].firstChildElement("midiclip"); !clip.isNull();
+				clip = clip.nextSiblingElement("midiclip"))
+			{
+				auto text = QString{};
+				{
+					QTextStream stream(&text);
+					clip.save(stream, -1);
+				}
+				m_tracks[i].clips.push_back(clip);
+				m_tracks[i].texts.push_back(std::move(text));
+			}
+		}
+
+		// the loading thread parses as well
+		const auto workers = std::min(static_cast<std::size_t>(std::max(QThread::idealThreadCount() - 1, 0)),
+			m_tracks.empty() ? 0 : m_tracks.size() - 1);
+		for (std::size_t i = 0; i < workers; ++i)
+		{
+			m_workers.push_back(std::async(std::launch::async, [this] { run(); }));
+		}
+	}
+
+	~NoteParser()
+	{
+		m_stop = true;
+		for (auto& worker : m_workers) { worker.wait(); }
+	}
+
+	//! The parsed notes of the track at @p index, may only be taken once
+	std::vector<MidiClip::ParsedNotes> take(std::size_t index)
+	{
+		auto parsed = claim(index) ? parse(index) : m_results[index].get_future().get();
+
+		// only the loading thread may use the elements of the project
+		auto notes = std::vector<MidiClip::ParsedNotes>();
+		for (std::size_t clip = 0; clip < parsed.size(); ++clip)
+		{
+			if (!parsed[clip]) { continue; }
+			notes.push_back(std::move(*parsed[clip]));
+			notes.back().clip = m_tracks[index].clips[clip];
+		}
+		return notes;
+	}
+
+private:
+	//! The midi clips of a track, and their elements saved as text
+	struct TrackClips
+	{
+		std::vector<QDomElement> clips;
+		std::vector<QString> texts;
+	};
+
+	using ParsedClips = std::vector<std::optional<MidiClip::ParsedNotes>>;
+
+	bool claim(std::size_t index)
+	{
+		return !m_claimed[index].exchange(true);
+	}
+
+	ParsedClips parse(std::size_t index) const
+	{
+		auto parsed = ParsedClips();
+		for (const auto& text : m_tracks[index].texts) { parsed.push_back(MidiClip::parseNotes(text)); }
+		return parsed;
+	}
+
+	void run()
+	{
+		for (std::size_t index = m_next++; index < m_tracks.size() && !m_stop; index = m_next++)
+		{
+			if (claim(index)) { m_results[index].set_value(parse(index)); }
+		}
+	}
+
+	std::vector<TrackClips> m_tracks;
+	std::vector<std::atomic<bool>> m_claimed;
+	std::vector<std::promise<ParsedClips>> m_results;
+	std::atomic<std::size_t> m_next = 0;
+	std::atomic<bool> m_stop = false;
+	std::vector<std::future<void>> m_workers;
+};
+
+bool isTrackElement(const QDomNode& node)
+{
+	return node.isElement() && !node.toElement().attribute("metadata").toInt();
+}
+
+} // namespace
+
+
+
 
 TrackContainer::TrackContainer() :
 	Model( nullptr ),
@@ -105,6 +227,17 @@ void TrackContainer::loadSettings( const QDomElement & _this )
 		}
 	}
 
+	// The notes of all tracks are parsed in parallel. The tracks themselves
+	// are created one after another, as that connects them with the rest of
+	// the project.
+	auto trackElements = std::vector<QDomElement>();
+	for (QDomNode node = _this.firstChild(); !node.isNull(); node = node.nextSibling())
+	{
+		if (isTrackElement(node)) { trackElements.push_back(node.toElement()); }
+	}
+	auto noteParser = NoteParser(trackElements);
+	std::size_t trackIndex = 0;
+
 	QDomNode node = _this.firstChild();
 	while( !node.isNull() )
 	{
@@ -127,8 +260,7 @@ void TrackContainer::loadSettings( const QDomElement & _this )
 			}
 		}
 
-		if( node.isElement() &&
-			!node.toElement().attribute( "metadata" ).toInt() )
+		if (isTrackElement(node))
 		{
 			QString trackName = node.toElement().hasAttribute( "name" ) ?
 						node.toElement().attribute( "name" ) :
@@ -138,7 +270,10 @@ void TrackContainer::loadSettings( const QDomElement & _this )
 				pd->setLabelText( tr("Loading Track %1 (%2/Total %3)").arg( trackName ).
 						  arg( pd->value() + 1 ).arg( Engine::getSong()->getLoadingTrackCount() ) );
 			}
+			auto parsedNotes = noteParser.take(trackIndex++);
+			const auto previousNotes = MidiClip::useParsedNotes(&parsedNotes);
 			Track::create( node.toElement(), this );
+			MidiClip::useParsedNotes(previousNotes);
 		}
 		node = node.nextSibling();
 	}
@@ -156,6 +291,23 @@ void TrackContainer::loadSettings( const QDomElement & _this )
 
 
 
+void TrackContainer::finishStretch() const
+{
+	m_tracksMutex.lockForRead();
+	for (const auto& track : m_tracks)
+	{
+		if (track->type() != Track::Type::Sample) { continue; }
+		for (Clip* clip : track->getClips())
+		{
+			static_cast<SampleClip*>(clip)->finishStretch();
+		}
+	}
+	m_tracksMutex.unlock();
+}
+
+
+
+
 int TrackContainer::countTracks( Track::Type _tt ) const
 {
 	int cnt = 0;
@@ -174,6 +326,17 @@ int TrackContainer::countTracks( Track::Type _tt ) const
 
 
 
+void TrackContainer::arrangementChanged()
+{
+	s_arrangementRevision.fetch_add(1, std::memory_order_release);
+
+	// on the side making the change, so the audio thread doesn't have to
+	if (const auto store = Engine::patternStore()) { store->compilePatterns(); }
+}
+
+
+
+
 void TrackContainer::addTrack( Track * _track )
 {
 	if( _track->type() != Track::Type::HiddenAutomation )
@@ -182,6 +345,7 @@ void TrackContainer::addTrack( Track * _track )
 		m_tracksMutex.lockForWrite();
 		m_tracks.push_back( _track );
 		m_tracksMutex.unlock();
+		arrangementChanged();
 		_track->unlock();
 		emit trackAdded( _track );
 	}
@@ -205,6 +369,7 @@ void TrackContainer::removeTrack( Track * _track )
 		}
 		m_tracks.erase(it);
 		lockTracksAccess.unlock();
+		arrangementChanged();
 
 		if( Engine::getSong() )
 		{
@@ -0,0 +1,154 @@
+/*
+ * TrackFreezer.cpp - renders an instrument track ahead of time to play it back frozen
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "TrackFreezer.h"
+
+#include "AudioBusHandle.h"
+#include "AudioDevice.h"
+#include "AudioEngine.h"
+#include "FrozenAudio.h"
+#include "InstrumentTrack.h"
+#include "PatternStore.h"
+#include "Song.h"
+
+namespace lmms
+{
+
+TrackFreezer::TrackFreezer(InstrumentTrack* track) :
+	QThread(Engine::audioEngine()),
+	m_track(track)
+{
+}
+
+
+
+
+void TrackFreezer::startProcessing()
+{
+	// render what the track plays now, not what it was frozen with
+	m_track->unfreeze();
+
+	// only the track itself is heard while rendering, just like when exporting tracks
+	const auto muteOthers = [this](const TrackContainer* container)
+	{
+		for (Track* track : container->tracks())
+		{
+			if (track != m_track && !track->isMuted()
+				&& (track->type() == Track::Type::Instrument || track->type() == Track::Type::Sample))
+			{
+				track->setMuted(true);
+				m_muted.push_back(track);
+			}
+		}
+	};
+	muteOthers(Engine::getSong());
+	muteOthers(Engine::patternStore());
+
+	m_trackWasMuted = m_track->isMuted();
+	m_track->setMuted(false);
+
+	Song* song = Engine::getSong();
+	song->setExportLoop(false);
+	song->setRenderBetweenMarkers(false);
+	song->setLoopRenderCount(1);
+
+	// a device which isn't driven by anything, the periods are rendered by this thread
+	AudioEngine* audioEngine = Engine::audioEngine();
+	audioEngine->storeAudioDevice();
+	audioEngine->setAudioDevice(new AudioDevice(DEFAULT_CHANNELS, audioEngine),
+		audioEngine->currentQualitySettings(), false, false);
+
+	AudioBusHandle* busHandle = m_track->audioBusHandle();
+	m_audio = std::make_shared<FrozenAudio>(audioEngine->maxFramesPerPeriod(), audioEngine->outputSampleRate());
+	m_audio->setLatency(busHandle->latency());
+	busHandle->setFreezeCapture(m_audio.get());
+
+	connect(this, &QThread::finished, this, &TrackFreezer::finish);
+	start(
+#ifndef LMMS_BUILD_WIN32
+		QThread::HighPriority
+#endif
+	);
+}
+
+
+
+
+void TrackFreezer::run()
+{
+	Engine::getSong()->startExport();
+	// Skip first empty buffer.
+	Engine::audioEngine()->nextBuffer();
+
+	Engine::audioEngine()->startProcessing(false);
+
+	while (!Engine::getSong()->isExportDone() && !m_abort)
+	{
+		Engine::audioEngine()->nextBuffer();
+
+		const int progress = Engine::getSong()->getExportProgress();
+		if (m_progress != progress)
+		{
+			m_progress = progress;
+			emit progressChanged(m_progress);
+		}
+	}
+
+	Engine::audioEngine()->stopProcessing();
+	Engine::getSong()->stopExport();
+}
+
+
+
+
+void TrackFreezer::finish()
+{
+	m_track->audioBusHandle()->setFreezeCapture(nullptr);
+	Engine::audioEngine()->restoreAudioDevice();  // Also deletes audio dev.
+
+	for (Track* track : m_muted)
+	{
+		track->setMuted(false);
+	}
+	m_muted.clear();
+	m_track->setMuted(m_trackWasMuted);
+
+	if (!m_abort)
+	{
+		m_track->freeze(std::move(m_audio));
+	}
+	m_audio.reset();
+
+	emit done();
+}
+
+
+
+
+void TrackFreezer::abortProcessing()
+{
+	m_abort = true;
+	wait();
+}
+
+
+} // namespace lmms
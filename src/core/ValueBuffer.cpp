@@ -1,45 +1,215 @@
 #include "ValueBuffer.h"
 
 #include <algorithm>
-#include <cmath>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "BufferManager.h"
 
 namespace lmms
 {
 
+namespace
+{
+
+float* allocateValues(std::size_t count)
+{
+	auto values = static_cast<float*>(::operator new(count * sizeof(float),
+		std::align_val_t{BufferManager::Alignment}));
+	std::fill_n(values, count, 0.f);
+	return values;
+}
+
+void freeValues(float* values)
+{
+	::operator delete(values, std::align_val_t{BufferManager::Alignment});
+}
+
+//! Number of values fitting into a buffer of the BufferManager pool, 0 if
+//! the pool isn't set up yet
+std::size_t pooledCapacity()
+{
+	return static_cast<std::size_t>(BufferManager::framesPerPeriod()) * 2;
+}
 
-ValueBuffer::ValueBuffer(int length)
-	: std::vector<float>(length)
+} // namespace
+
+
+ValueBuffer::ValueBuffer(int length) :
+	m_length(static_cast<std::size_t>(std::max(length, 0))),
+	m_capacity(m_length)
+{}
+
+ValueBuffer::ValueBuffer(const ValueBuffer& other) :
+	m_length(other.m_length),
+	m_capacity(other.m_capacity),
+	m_constant(other.m_constant)
+{
+	if (other.m_data)
+	{
+		std::copy_n(other.m_data, m_length, values());
+	}
+}
+
+ValueBuffer::ValueBuffer(ValueBuffer&& other) noexcept :
+	m_data(std::exchange(other.m_data, nullptr)),
+	m_pooled(other.m_pooled),
+	m_length(std::exchange(other.m_length, 0)),
+	m_capacity(std::exchange(other.m_capacity, 0)),
+	m_constant(std::exchange(other.m_constant, false))
 {}
 
+ValueBuffer::~ValueBuffer()
+{
+	release();
+}
+
+ValueBuffer& ValueBuffer::operator=(const ValueBuffer& other)
+{
+	if (this != &other)
+	{
+		if (other.m_length > m_capacity)
+		{
+			release();
+			m_capacity = other.m_length;
+		}
+		m_length = other.m_length;
+		m_constant = other.m_constant;
+		if (other.m_data)
+		{
+			std::copy_n(other.m_data, m_length, values());
+		}
+	}
+	return *this;
+}
+
+ValueBuffer& ValueBuffer::operator=(ValueBuffer&& other) noexcept
+{
+	if (this != &other)
+	{
+		release();
+		m_data = std::exchange(other.m_data, nullptr);
+		m_pooled = other.m_pooled;
+		m_length = std::exchange(other.m_length, 0);
+		m_capacity = std::exchange(other.m_capacity, 0);
+		m_constant = std::exchange(other.m_constant, false);
+	}
+	return *this;
+}
+
 void ValueBuffer::fill(float value)
 {
-	std::fill(begin(), end(), value);
+	// aligned and without aliasing stores, so this gets vectorized
+	float* v = std::assume_aligned<BufferManager::Alignment>(values());
+	for (std::size_t i = 0; i < m_length; ++i)
+	{
+		v[i] = value;
+	}
+	m_constant = true;
 }
 
 float ValueBuffer::value(int offset) const
 {
-	return at(offset % length());
+	return values()[offset % length()];
 }
 
 const float *ValueBuffer::values() const
 {
-	return data();
+	if (!m_data) { acquire(); }
+	return m_data;
 }
 
 float *ValueBuffer::values()
 {
-	return data();
+	if (!m_data) { acquire(); }
+	return m_data;
 }
 
 int ValueBuffer::length() const
 {
-	return size();
+	return static_cast<int>(m_length);
+}
+
+void ValueBuffer::resize(std::size_t length)
+{
+	if (length > m_capacity)
+	{
+		if (m_data)
+		{
+			float* grown = allocateValues(length);
+			std::copy_n(m_data, m_length, grown);
+			release();
+			m_data = grown;
+			m_pooled = false;
+		}
+		m_capacity = length;
+	}
+	else if (m_data && length > m_length)
+	{
+		std::fill(m_data + m_length, m_data + length, 0.f);
+	}
+
+	if (length > m_length && m_length > 0) { m_constant = false; }
+	m_length = length;
+}
+
+void ValueBuffer::clear()
+{
+	release();
+	m_length = 0;
+	m_capacity = 0;
+	m_constant = false;
 }
 
 void ValueBuffer::interpolate(float start, float end_)
 {
-	float i = 0;
-	std::generate(begin(), end(), [&]() { return std::lerp(start, end_, i++ / length()); });
+	if (start == end_)
+	{
+		fill(start);
+		return;
+	}
+
+	// computing each value from its index rather than accumulating the step
+	// keeps the loop free of dependencies, so it gets vectorized
+	const int frames = length();
+	const float step = (end_ - start) / frames;
+	float* v = std::assume_aligned<BufferManager::Alignment>(values());
+	for (int i = 0; i < frames; ++i)
+	{
+		v[i] = start + static_cast<float>(i) * step;
+	}
+	m_constant = false;
+}
+
+void ValueBuffer::acquire() const
+{
+	if (m_capacity > 0 && m_capacity <= pooledCapacity())
+	{
+		m_data = reinterpret_cast<float*>(BufferManager::acquire());
+		m_pooled = true;
+	}
+	else
+	{
+		// the heap never hands out null, not even for 0 bytes
+		m_data = allocateValues(m_capacity);
+		m_pooled = false;
+	}
+}
+
+void ValueBuffer::release()
+{
+	if (!m_data) { return; }
+
+	if (m_pooled)
+	{
+		BufferManager::release(reinterpret_cast<SampleFrame*>(m_data));
+	}
+	else
+	{
+		freeValues(m_data);
+	}
+	m_data = nullptr;
 }
 
 
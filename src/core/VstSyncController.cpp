@@ -50,7 +50,7 @@ VstSyncController::VstSyncController()
 	}
 
 	m_syncData->isPlaying = false;
-	m_syncData->bufferSize = Engine::audioEngine()->framesPerPeriod();
+	m_syncData->bufferSize = Engine::audioEngine()->maxFramesPerPeriod();
 	m_syncData->timeSigNumer = 4;
 	m_syncData->timeSigDenom = 4;
 
@@ -139,7 +139,7 @@ void VstSyncController::update()
 {
 	if (!m_syncData) { return; }
 
-	m_syncData->bufferSize = Engine::audioEngine()->framesPerPeriod();
+	m_syncData->bufferSize = Engine::audioEngine()->maxFramesPerPeriod();
 
 #ifdef VST_SNC_LATENCY
 	m_syncData->latency = m_syncData->bufferSize * m_syncData->bpm / (static_cast<float>(m_syncData->sampleRate) * 60);
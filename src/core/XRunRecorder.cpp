@@ -0,0 +1,170 @@
+/*
+ * XRunRecorder.cpp - keeps what was going on when periods missed their deadline
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "XRunRecorder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <QDateTime>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+namespace lmms
+{
+
+XRunRecorder::XRunRecorder(std::size_t capacity) :
+	m_incidents(std::max<std::size_t>(capacity, 1))
+{
+}
+
+
+
+
+void XRunRecorder::record(const Incident& incident)
+{
+	m_total.fetch_add(1, std::memory_order_relaxed);
+
+	// never wait for a reader while rendering
+	const auto lock = std::unique_lock{m_mutex, std::try_to_lock};
+	if (!lock.owns_lock()) { return; }
+
+	m_incidents[m_next] = incident;
+	m_next = (m_next + 1) % m_incidents.size();
+	m_count = std::min(m_count + 1, m_incidents.size());
+}
+
+
+
+
+void XRunRecorder::beginDeviceRequest()
+{
+	const auto time = now();
+	const auto last = m_lastDeviceRequest.exchange(time, std::memory_order_relaxed);
+	if (last != 0)
+	{
+		m_deviceInterval.store(static_cast<int>(time - last), std::memory_order_relaxed);
+	}
+}
+
+
+
+
+void XRunRecorder::endDeviceRequest()
+{
+	const auto begin = m_lastDeviceRequest.load(std::memory_order_relaxed);
+	m_deviceWait.store(static_cast<int>(now() - begin), std::memory_order_relaxed);
+}
+
+
+
+
+std::vector<XRunRecorder::Incident> XRunRecorder::incidents() const
+{
+	const auto lock = std::lock_guard{m_mutex};
+
+	auto incidents = std::vector<Incident>{};
+	incidents.reserve(m_count);
+	const auto first = (m_next + m_incidents.size() - m_count) % m_incidents.size();
+	for (std::size_t i = 0; i < m_count; ++i)
+	{
+		incidents.push_back(m_incidents[(first + i) % m_incidents.size()]);
+	}
+	return incidents;
+}
+
+
+
+
+void XRunRecorder::clear()
+{
+	const auto lock = std::lock_guard{m_mutex};
+	m_next = 0;
+	m_count = 0;
+	m_total = 0;
+}
+
+
+
+
+bool XRunRecorder::exportTo(const QString& file) const
+{
+	auto incidents = QJsonArray{};
+	for (const auto& incident : this->incidents())
+	{
+		auto stages = QJsonObject{};
+		for (std::size_t i = 0; i < AudioEngineProfiler::DetailCount; ++i)
+		{
+			const auto type = static_cast<AudioEngineProfiler::DetailType>(i);
+			stages[AudioEngineProfiler::detailName(type)] = incident.stageTimes[i];
+		}
+
+		auto jobs = QJsonArray{};
+		for (std::size_t i = 0; i < incident.slowestJobCount; ++i)
+		{
+			const auto& job = incident.slowestJobs[i];
+			jobs.append(QJsonObject{
+				{"category", job.category},
+				{"name", job.name},
+				{"id", static_cast<qint64>(job.id)},
+				{"us", job.duration / 1000.0}
+			});
+		}
+
+		incidents.append(QJsonObject{
+			{"time", QDateTime::fromMSecsSinceEpoch(incident.time).toString(Qt::ISODateWithMs)},
+			{"period", static_cast<qint64>(incident.period)},
+			{"frames", incident.frames},
+			{"sampleRate", static_cast<qint64>(incident.sampleRate)},
+			{"renderUs", incident.renderTime},
+			{"deadlineUs", incident.deadline},
+			{"stagesUs", stages},
+			{"slowestJobs", jobs},
+			{"playHandles", incident.playHandles},
+			{"workers", incident.workers},
+			{"sleepingWorkers", incident.sleepingWorkers},
+			{"deviceIntervalUs", incident.deviceInterval},
+			{"deviceWaitUs", incident.deviceWait}
+		});
+	}
+
+	QFile out(file);
+	if (!out.open(QFile::WriteOnly | QFile::Truncate)) { return false; }
+
+	const auto report = QJsonObject{
+		{"total", static_cast<qint64>(total())},
+		{"incidents", incidents}
+	};
+	return out.write(QJsonDocument{report}.toJson()) != -1;
+}
+
+
+
+
+std::int64_t XRunRecorder::now()
+{
+	using namespace std::chrono;
+	return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace lmms
@@ -0,0 +1,349 @@
+/*
+ * ZlibDevice.cpp - streaming compression in the format of qCompress()
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "ZlibDevice.h"
+
+#include <QThread>
+
+#include <algorithm>
+#include <limits>
+#include <zlib.h>
+
+namespace lmms
+{
+
+namespace
+{
+
+// qCompress() writes the uncompressed size as 32 bit big endian integer,
+// followed by a zlib stream
+constexpr int SizeHeaderLength = 4;
+
+//! Chunks are compressed independently, apart from sharing a dictionary
+constexpr qint64 ChunkSize = 256 * 1024;
+constexpr int DictionarySize = 32 * 1024;
+
+//! Read from the source in steps of that many bytes
+constexpr qint64 InputSize = 64 * 1024;
+
+void appendBigEndian(QByteArray& out, std::uint32_t value)
+{
+	for (int shift = 24; shift >= 0; shift -= 8)
+	{
+		out.append(static_cast<char>((value >> shift) & 0xff));
+	}
+}
+
+} // namespace
+
+
+
+
+bool isZlibCompressed(const QByteArray& data)
+{
+	if (data.size() < SizeHeaderLength + 2) { return false; }
+
+	// a zlib header using deflate, whose check bits are valid
+	const auto cmf = static_cast<unsigned char>(data[SizeHeaderLength]);
+	const auto flg = static_cast<unsigned char>(data[SizeHeaderLength + 1]);
+	return (cmf & 0x0f) == Z_DEFLATED && (cmf >> 4) <= 7 && (cmf * 256 + flg) % 31 == 0;
+}
+
+
+
+
+DeflatingDevice::DeflatingDevice(QIODevice* target, int level) :
+	m_target(target),
+	m_level(level),
+	m_headerPos(0),
+	m_totalSize(0),
+	m_adler(adler32(0, nullptr, 0)),
+	m_error(false)
+{
+}
+
+
+
+
+DeflatingDevice::~DeflatingDevice()
+{
+	if (isOpen()) { close(); }
+}
+
+
+
+
+bool DeflatingDevice::open(OpenMode mode)
+{
+	if (mode != QIODevice::WriteOnly || !m_target->isWritable() || m_target->isSequential()) { return false; }
+
+	m_headerPos = m_target->pos();
+	m_totalSize = 0;
+	m_adler = adler32(0, nullptr, 0);
+	m_error = false;
+
+	// the size is filled in by close(), then the zlib header follows
+	auto header = QByteArray(SizeHeaderLength, '\0');
+	header.append(static_cast<char>(0x78));
+	header.append(static_cast<char>(0x9c));
+	m_error = m_target->write(header) != header.size();
+
+	return QIODevice::open(mode);
+}
+
+
+
+
+void DeflatingDevice::close()
+{
+	if (!isOpen()) { return; }
+
+	submitChunk(true);
+	while (!m_inFlight.empty())
+	{
+		writeChunk(m_inFlight.front().get());
+		m_inFlight.pop_front();
+	}
+
+	auto trailer = QByteArray();
+	appendBigEndian(trailer, m_adler);
+	m_error |= m_target->write(trailer) != trailer.size();
+
+	const qint64 end = m_target->pos();
+	auto size = QByteArray();
+	appendBigEndian(size, static_cast<std::uint32_t>(m_totalSize));
+	m_error |= !m_target->seek(m_headerPos) || m_target->write(size) != size.size() || !m_target->seek(end);
+
+	m_pending.clear();
+	m_dictionary.clear();
+	QIODevice::close();
+}
+
+
+
+
+qint64 DeflatingDevice::writeData(const char* data, qint64 length)
+{
+	qint64 written = 0;
+	while (written < length)
+	{
+		const qint64 count = std::min(length - written, ChunkSize - m_pending.size());
+		m_pending.append(data + written, count);
+		written += count;
+
+		if (m_pending.size() == ChunkSize) { submitChunk(false); }
+	}
+	return m_error ? -1 : length;
+}
+
+
+
+
+void DeflatingDevice::submitChunk(bool last)
+{
+	// keep as many chunks in flight as there are cores, but not more
+	const auto maxInFlight = static_cast<std::size_t>(std::max(QThread::idealThreadCount(), 1));
+	while (m_inFlight.size() >= maxInFlight)
+	{
+		writeChunk(m_inFlight.front().get());
+		m_inFlight.pop_front();
+	}
+
+	const QByteArray dictionary = m_dictionary;
+	m_dictionary = m_pending.right(DictionarySize);
+
+	m_inFlight.push_back(std::async(std::launch::async,
+		[input = std::move(m_pending), dictionary, last, level = m_level] {
+			auto chunk = Chunk{QByteArray(), 0, input.size(), false};
+
+			// raw deflate, the zlib header and trailer are written by the device
+			z_stream stream = {};
+			if (deflateInit2(&stream, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+			{
+				return chunk;
+			}
+			if (!dictionary.isEmpty())
+			{
+				deflateSetDictionary(&stream, reinterpret_cast<const Bytef*>(dictionary.constData()),
+					static_cast<uInt>(dictionary.size()));
+			}
+
+			stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.constData()));
+			stream.avail_in = static_cast<uInt>(input.size());
+
+			// all but the last chunk end with a sync flush, which aligns them to
+			// bytes so the next chunk's data can follow right away
+			const int flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+			chunk.compressed.resize(static_cast<int>(deflateBound(&stream, stream.avail_in)) + 16);
+			qint64 produced = 0;
+			while (true)
+			{
+				stream.next_out = reinterpret_cast<Bytef*>(chunk.compressed.data() + produced);
+				stream.avail_out = static_cast<uInt>(chunk.compressed.size() - produced);
+				const int result = deflate(&stream, flush);
+				produced = chunk.compressed.size() - stream.avail_out;
+
+				if (result == Z_STREAM_ERROR) { break; }
+				if (result == Z_STREAM_END || (!last && stream.avail_in == 0 && stream.avail_out > 0))
+				{
+					chunk.ok = true;
+					break;
+				}
+				chunk.compressed.resize(chunk.compressed.size() * 2);
+			}
+			deflateEnd(&stream);
+
+			chunk.compressed.resize(static_cast<int>(produced));
+			chunk.adler = adler32(adler32(0, nullptr, 0), reinterpret_cast<const Bytef*>(input.constData()),
+				static_cast<uInt>(input.size()));
+			return chunk;
+		}));
+	m_pending = QByteArray();
+}
+
+
+
+
+void DeflatingDevice::writeChunk(const Chunk& chunk)
+{
+	m_error |= !chunk.ok || m_target->write(chunk.compressed) != chunk.compressed.size();
+	m_adler = adler32_combine(m_adler, chunk.adler, chunk.size);
+	m_totalSize += chunk.size;
+}
+
+
+
+
+struct InflatingDevice::Stream
+{
+	z_stream z = {};
+};
+
+
+
+
+InflatingDevice::InflatingDevice(QIODevice* source) :
+	m_source(source),
+	m_stream(),
+	m_input(),
+	m_finished(false),
+	m_error(false)
+{
+}
+
+
+
+
+InflatingDevice::~InflatingDevice()
+{
+	close();
+}
+
+
+
+
+bool InflatingDevice::open(OpenMode mode)
+{
+	if (mode != QIODevice::ReadOnly || !m_source->isReadable()) { return false; }
+
+	// the uncompressed size is only a hint, which isn't needed when streaming
+	if (m_source->read(SizeHeaderLength).size() != SizeHeaderLength) { return false; }
+
+	m_stream = std::make_unique<Stream>();
+	if (inflateInit(&m_stream->z) != Z_OK)
+	{
+		m_stream.reset();
+		return false;
+	}
+
+	m_finished = false;
+	m_error = false;
+	return QIODevice::open(mode);
+}
+
+
+
+
+void InflatingDevice::close()
+{
+	if (m_stream)
+	{
+		inflateEnd(&m_stream->z);
+		m_stream.reset();
+	}
+	m_input.clear();
+	QIODevice::close();
+}
+
+
+
+
+bool InflatingDevice::atEnd() const
+{
+	return (m_finished || m_error) && QIODevice::bytesAvailable() == 0;
+}
+
+
+
+
+qint64 InflatingDevice::readData(char* data, qint64 maxLength)
+{
+	if (m_finished || m_error || !m_stream) { return -1; }
+
+	z_stream& z = m_stream->z;
+	z.next_out = reinterpret_cast<Bytef*>(data);
+	z.avail_out = static_cast<uInt>(std::min<qint64>(maxLength, std::numeric_limits<uInt>::max()));
+
+	while (z.avail_out > 0)
+	{
+		if (z.avail_in == 0)
+		{
+			m_input = m_source->read(InputSize);
+			if (m_input.isEmpty())
+			{
+				// the stream ended before its end marker
+				m_error = true;
+				break;
+			}
+			z.next_in = reinterpret_cast<Bytef*>(m_input.data());
+			z.avail_in = static_cast<uInt>(m_input.size());
+		}
+
+		const int result = inflate(&z, Z_NO_FLUSH);
+		if (result == Z_STREAM_END)
+		{
+			m_finished = true;
+			break;
+		}
+		if (result != Z_OK)
+		{
+			m_error = true;
+			break;
+		}
+	}
+
+	const qint64 produced = reinterpret_cast<char*>(z.next_out) - data;
+	return produced > 0 ? produced : -1;
+}
+
+
+} // namespace lmms
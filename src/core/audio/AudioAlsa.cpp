@@ -241,11 +241,11 @@ void AudioAlsa::stopProcessing()
 
 void AudioAlsa::run()
 {
-	auto temp = new SampleFrame[audioEngine()->framesPerPeriod()];
-	auto outbuf = new int_sample_t[audioEngine()->framesPerPeriod() * channels()];
+	auto temp = new SampleFrame[audioEngine()->maxFramesPerPeriod()];
+	auto outbuf = new int_sample_t[audioEngine()->maxFramesPerPeriod() * channels()];
 	auto pcmbuf = new int_sample_t[m_periodSize * channels()];
 
-	int outbuf_size = audioEngine()->framesPerPeriod() * channels();
+	int outbuf_size = audioEngine()->maxFramesPerPeriod() * channels();
 	int outbuf_pos = 0;
 	int pcmbuf_size = m_periodSize * channels();
 
@@ -368,7 +368,7 @@ int AudioAlsa::setHWParams( const ch_cnt_t _channels, snd_pcm_access_t _access )
 		}
 	}
 
-	m_periodSize = audioEngine()->framesPerPeriod();
+	m_periodSize = audioEngine()->maxFramesPerPeriod();
 	m_bufferSize = m_periodSize * 8;
 	int dir;
 	if (int err = snd_pcm_hw_params_set_period_size_near(m_handle, m_hwParams, &m_periodSize, &dir); err < 0)
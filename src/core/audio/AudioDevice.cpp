@@ -26,6 +26,8 @@
 
 #include "AudioDevice.h"
 #include "AudioEngine.h"
+#include "SampleConversion.h"
+#include "XRunRecorder.h"
 
 namespace lmms
 {
@@ -35,7 +37,7 @@ AudioDevice::AudioDevice( const ch_cnt_t _channels, AudioEngine*  _audioEngine )
 	m_sampleRate( _audioEngine->outputSampleRate() ),
 	m_channels( _channels ),
 	m_audioEngine( _audioEngine ),
-	m_buffer(new SampleFrame[audioEngine()->framesPerPeriod()])
+	m_buffer(new SampleFrame[audioEngine()->maxFramesPerPeriod()])
 {
 }
 
@@ -64,14 +66,17 @@ void AudioDevice::processNextBuffer()
 
 fpp_t AudioDevice::getNextBuffer(SampleFrame* _ab)
 {
-	fpp_t frames = audioEngine()->framesPerPeriod();
+	XRunRecorder* recorder = audioEngine()->xrunRecorder();
+	if (recorder) { recorder->beginDeviceRequest(); }
 	const SampleFrame* b = audioEngine()->nextBuffer();
+	if (recorder) { recorder->endDeviceRequest(); }
 
 	if (!b) { return 0; }
 
-	memcpy(_ab, b, frames * sizeof(SampleFrame));
+	// periods may be shorter than the buffer, e.g. while recording
+	const fpp_t frames = audioEngine()->nextBufferFrames();
 
-	if (audioEngine()->hasFifoWriter()) { delete[] b; }
+	memcpy(_ab, b, frames * sizeof(SampleFrame));
 	return frames;
 }
 
@@ -130,31 +135,7 @@ int AudioDevice::convertToS16(const SampleFrame* _ab,
 								int_sample_t * _output_buffer,
 								const bool _convert_endian )
 {
-	if( _convert_endian )
-	{
-		for( fpp_t frame = 0; frame < _frames; ++frame )
-		{
-			for( ch_cnt_t chnl = 0; chnl < channels(); ++chnl )
-			{
-				auto temp = static_cast<int_sample_t>(AudioEngine::clip(_ab[frame][chnl]) * OUTPUT_SAMPLE_MULTIPLIER);
-
-				( _output_buffer + frame * channels() )[chnl] =
-						( temp & 0x00ff ) << 8 |
-						( temp & 0xff00 ) >> 8;
-			}
-		}
-	}
-	else
-	{
-		for( fpp_t frame = 0; frame < _frames; ++frame )
-		{
-			for( ch_cnt_t chnl = 0; chnl < channels(); ++chnl )
-			{
-				(_output_buffer + frame * channels())[chnl]
-					= static_cast<int_sample_t>(AudioEngine::clip(_ab[frame][chnl]) * OUTPUT_SAMPLE_MULTIPLIER);
-			}
-		}
-	}
+	SampleConversion::toS16(_ab, _frames, channels(), _output_buffer, _convert_endian);
 
 	return _frames * channels() * BYTES_PER_INT_SAMPLE;
 }
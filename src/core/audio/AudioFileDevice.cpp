@@ -25,26 +25,50 @@
 
 #include <QMessageBox>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
 #include "AudioFileDevice.h"
+#include "ConfigManager.h"
 #include "ExportProjectDialog.h"
 #include "GuiApplication.h"
+#include "lmmsconfig.h"
+
+#ifdef LMMS_BUILD_LINUX
+#include <fcntl.h>
+#endif
 
 namespace lmms
 {
 
+namespace
+{
+
+std::atomic<std::uint64_t> s_writtenBytes = 0;
+std::atomic<std::uint64_t> s_writes = 0;
+std::atomic<std::uint64_t> s_writeNanoseconds = 0;
+
+} // namespace
+
+
 AudioFileDevice::AudioFileDevice( OutputSettings const & outputSettings,
 					const ch_cnt_t _channels,
 					const QString & _file,
 					AudioEngine*  _audioEngine ) :
 	AudioDevice( _channels, _audioEngine ),
 	m_outputFile( _file ),
-	m_outputSettings(outputSettings)
+	m_outputSettings(outputSettings),
+	m_dropWrittenPages(ConfigManager::inst()->value("audioengine", "dropwrittenpages").toInt() != 0)
 {
 	using gui::ExportProjectDialog;
 
 	setSampleRate( outputSettings.getSampleRate() );
+	m_buffer.reserve(BufferSize);
 
-	if( m_outputFile.open( QFile::WriteOnly | QFile::Truncate ) == false )
+	// the file is buffered by writeData() already, and read back by
+	// libsndfile, e.g. when finishing the header
+	if( m_outputFile.open( QFile::ReadWrite | QFile::Truncate | QFile::Unbuffered ) == false )
 	{
 		QString title, message;
 		title = ExportProjectDialog::tr( "Could not open file" );
@@ -68,6 +92,12 @@ AudioFileDevice::AudioFileDevice( OutputSettings const & outputSettings,
 			exit( EXIT_FAILURE );
 		}
 	}
+#ifdef LMMS_BUILD_LINUX
+	else
+	{
+		posix_fadvise(m_outputFile.handle(), 0, 0, POSIX_FADV_SEQUENTIAL);
+	}
+#endif
 }
 
 
@@ -75,20 +105,152 @@ AudioFileDevice::AudioFileDevice( OutputSettings const & outputSettings,
 
 AudioFileDevice::~AudioFileDevice()
 {
+	flushOutput();
 	m_outputFile.close();
 }
 
 
 
 
-int AudioFileDevice::writeData( const void* data, int len )
+void AudioFileDevice::flushOutput()
+{
+	if (m_buffer.empty() || !m_outputFile.isOpen()) { return; }
+
+	const auto start = std::chrono::steady_clock::now();
+	const auto begin = m_outputFile.pos();
+	const auto written = m_outputFile.write(m_buffer.data(), m_buffer.size());
+	if (written > 0) { adviseWritten(begin, begin + written); }
+	const auto elapsed = std::chrono::steady_clock::now() - start;
+
+	if (written != static_cast<qint64>(m_buffer.size()))
+	{
+		qWarning("AudioFileDevice: could not write to %s: %s", qPrintable(m_outputFile.fileName()),
+			qPrintable(m_outputFile.errorString()));
+	}
+	if (written > 0)
+	{
+		s_writtenBytes.fetch_add(written, std::memory_order_relaxed);
+		s_writes.fetch_add(1, std::memory_order_relaxed);
+	}
+	s_writeNanoseconds.fetch_add(
+		std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(), std::memory_order_relaxed);
+
+	m_buffer.clear();
+}
+
+
+
+
+void AudioFileDevice::adviseWritten(qint64 begin, qint64 end)
 {
-	if( m_outputFile.isOpen() )
+#ifdef LMMS_BUILD_LINUX
+	if (!m_dropWrittenPages) { return; }
+
+	// renders are written once and not read back, so they shouldn't push
+	// everything else out of the page cache: the writeback of each chunk is
+	// started right away, and waited for before dropping the chunk while
+	// writing the next one, by when it's usually done
+	const int fd = m_outputFile.handle();
+	if (m_pendingEnd > m_pendingBegin)
 	{
-		return m_outputFile.write( (const char *) data, len );
+		sync_file_range(fd, m_pendingBegin, m_pendingEnd - m_pendingBegin,
+			SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+		posix_fadvise(fd, m_pendingBegin, m_pendingEnd - m_pendingBegin, POSIX_FADV_DONTNEED);
 	}
+	sync_file_range(fd, begin, end - begin, SYNC_FILE_RANGE_WRITE);
+	m_pendingBegin = begin;
+	m_pendingEnd = end;
+#else
+	(void)begin;
+	(void)end;
+#endif
+}
+
+
+
+
+auto AudioFileDevice::writeStats() -> WriteStats
+{
+	return WriteStats{
+		s_writtenBytes.load(std::memory_order_relaxed),
+		s_writes.load(std::memory_order_relaxed),
+		s_writeNanoseconds.load(std::memory_order_relaxed) / 1e9};
+}
+
+
+
+
+int AudioFileDevice::writeData( const void* data, int len )
+{
+	if (!m_outputFile.isOpen() || len < 0) { return -1; }
+
+	const auto bytes = static_cast<const char*>(data);
+	m_buffer.insert(m_buffer.end(), bytes, bytes + len);
+	if (m_buffer.size() >= BufferSize) { flushOutput(); }
 
-	return -1;
+	return len;
+}
+
+
+
+
+SNDFILE* AudioFileDevice::openSndFile(SF_INFO* info)
+{
+	static auto s_io = SF_VIRTUAL_IO{&sndFileLength, &sndFileSeek, &sndFileRead, &sndFileWrite, &sndFileTell};
+	return sf_open_virtual(&s_io, SFM_WRITE, info, this);
+}
+
+
+
+
+sf_count_t AudioFileDevice::sndFileLength(void* device)
+{
+	auto self = static_cast<AudioFileDevice*>(device);
+	self->flushOutput();
+	return self->m_outputFile.size();
+}
+
+
+
+
+sf_count_t AudioFileDevice::sndFileSeek(sf_count_t offset, int whence, void* device)
+{
+	auto self = static_cast<AudioFileDevice*>(device);
+	self->flushOutput();
+
+	auto position = offset;
+	if (whence == SEEK_CUR) { position += self->m_outputFile.pos(); }
+	else if (whence == SEEK_END) { position += self->m_outputFile.size(); }
+
+	return self->m_outputFile.seek(position) ? position : -1;
+}
+
+
+
+
+sf_count_t AudioFileDevice::sndFileRead(void* data, sf_count_t size, void* device)
+{
+	auto self = static_cast<AudioFileDevice*>(device);
+	self->flushOutput();
+	return std::max<sf_count_t>(self->m_outputFile.read(static_cast<char*>(data), size), 0);
+}
+
+
+
+
+sf_count_t AudioFileDevice::sndFileWrite(const void* data, sf_count_t size, void* device)
+{
+	auto self = static_cast<AudioFileDevice*>(device);
+	return std::max(self->writeData(data, static_cast<int>(size)), 0);
+}
+
+
+
+
+sf_count_t AudioFileDevice::sndFileTell(void* device)
+{
+	auto self = static_cast<AudioFileDevice*>(device);
+	return self->m_outputFile.pos() + static_cast<sf_count_t>(self->m_buffer.size());
 }
 
 } // namespace lmms
@@ -0,0 +1,99 @@
+/*
+ * AudioFileEncoder.cpp - encodes into an AudioFileDevice on its own thread
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "AudioFileEncoder.h"
+
+#include <algorithm>
+
+#include "AudioFileDevice.h"
+
+
+namespace lmms
+{
+
+
+AudioFileEncoder::AudioFileEncoder(AudioFileDevice* device, fpp_t framesPerPeriod) :
+	m_device(device),
+	m_frames(framesPerPeriod),
+	m_fifo(FifoPeriods, framesPerPeriod),
+	m_batch(framesPerPeriod * BatchPeriods),
+	m_finished(false)
+{
+	setObjectName("AudioFileEncoder");
+	start();
+}
+
+
+
+
+AudioFileEncoder::~AudioFileEncoder()
+{
+	finish();
+}
+
+
+
+
+void AudioFileEncoder::write(const SampleFrame* buffer)
+{
+	SampleFrame* period = m_fifo.writeBuffer();
+	std::copy_n(buffer, m_frames, period);
+	m_fifo.commit(m_frames);
+}
+
+
+
+
+void AudioFileEncoder::finish()
+{
+	if (m_finished) { return; }
+	m_finished = true;
+
+	m_fifo.commitEnd();
+	wait();
+}
+
+
+
+
+void AudioFileEncoder::run()
+{
+	std::size_t frames = 0;
+	while (const SampleFrame* period = m_fifo.read())
+	{
+		std::copy_n(period, m_frames, m_batch.data() + frames);
+		frames += m_frames;
+		if (frames == m_batch.size())
+		{
+			m_device->writeBuffer(m_batch.data(), frames);
+			frames = 0;
+		}
+	}
+
+	if (frames > 0)
+	{
+		m_device->writeBuffer(m_batch.data(), frames);
+	}
+}
+
+
+} // namespace lmms
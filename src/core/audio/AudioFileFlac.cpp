@@ -23,10 +23,9 @@
  */
 
 
-#include <cmath>
+#include <vector>
 
 #include "AudioFileFlac.h"
-#include "endian_handling.h"
 #include "AudioEngine.h"
 
 namespace lmms
@@ -34,7 +33,8 @@ namespace lmms
 
 AudioFileFlac::AudioFileFlac(OutputSettings const& outputSettings, ch_cnt_t const channels, bool& successful, QString const& file, AudioEngine* audioEngine):
 	AudioFileDevice(outputSettings,channels,file,audioEngine),
-	m_sf(nullptr)
+	m_sf(nullptr),
+	m_dither(outputSettings.getDither())
 {
 	successful = outputFileOpened() && startEncoding();
 }
@@ -65,21 +65,19 @@ bool AudioFileFlac::startEncoding()
 			m_sfinfo.format |= SF_FORMAT_PCM_16;
 	}
 
+	m_sf = openSndFile(&m_sfinfo);
+
+	if (!m_sf)
+	{
+		qWarning("Error: AudioFileFlac::startEncoding: %s", sf_strerror(nullptr));
+		return false;
+	}
+
 #ifdef LMMS_HAVE_SF_COMPLEVEL
 	double compression = getOutputSettings().getCompressionLevel();
 	sf_command(m_sf, SFC_SET_COMPRESSION_LEVEL, &compression, sizeof(double));
 #endif
 
-	m_sf = sf_open(
-#ifdef LMMS_BUILD_WIN32
-		outputFile().toLocal8Bit().constData(),
-#else
-		outputFile().toUtf8().constData(),
-#endif
-		SFM_WRITE,
-		&m_sfinfo
-	);
-
 	sf_command(m_sf, SFC_SET_CLIPPING, nullptr, SF_TRUE);
 
 	sf_set_string(m_sf, SF_STR_SOFTWARE, "LMMS");
@@ -90,28 +88,20 @@ bool AudioFileFlac::startEncoding()
 void AudioFileFlac::writeBuffer(const SampleFrame* _ab, fpp_t const frames)
 {
 	OutputSettings::BitDepth depth = getOutputSettings().getBitDepth();
-	float clipvalue = std::nextafterf( -1.0f, 0.0f );
 
-	if (depth == OutputSettings::BitDepth::Depth24Bit || depth == OutputSettings::BitDepth::Depth32Bit) // Float encoding
+	if (depth == OutputSettings::BitDepth::Depth24Bit || depth == OutputSettings::BitDepth::Depth32Bit)
 	{
-		auto buf = std::vector<sample_t>(frames * channels());
-		for(fpp_t frame = 0; frame < frames; ++frame)
-		{
-			for(ch_cnt_t channel=0; channel<channels(); ++channel)
-			{
-				// Clip the negative side to just above -1.0 in order to prevent it from changing sign
-				// Upstream issue: https://github.com/erikd/libsndfile/issues/309
-				// When this commit is reverted libsndfile-1.0.29 must be made a requirement for FLAC
-				buf[frame*channels() + channel] = std::max(clipvalue, _ab[frame][channel]);
-			}
-		}
-		sf_writef_float(m_sf, static_cast<float*>(buf.data()), frames);
+		// the file is 24 bit in both cases, and libsndfile keeps the upper 24 bits of ints
+		auto buf = std::vector<int>(frames * channels());
+		SampleConversion::toS32(_ab, frames, channels(), buf.data(), 24, &m_dither);
+		sf_writef_int(m_sf, buf.data(), frames);
 	}
-	else // integer PCM encoding
+	else // 16 bit
 	{
-		auto buf = std::vector<int_sample_t>(frames * channels());
-		convertToS16(_ab, frames, buf.data(), !isLittleEndian());
-		sf_writef_short(m_sf, static_cast<short*>(buf.data()), frames);
+		// libsndfile takes shorts in host byte order
+		auto buf = std::vector<short>(frames * channels());
+		SampleConversion::toS16(_ab, frames, channels(), buf.data(), false, &m_dither);
+		sf_writef_short(m_sf, buf.data(), frames);
 	}
 
 }
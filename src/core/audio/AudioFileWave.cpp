@@ -23,8 +23,9 @@
  *
  */
 
+#include <vector>
+
 #include "AudioFileWave.h"
-#include "endian_handling.h"
 #include "AudioEngine.h"
 
 
@@ -36,7 +37,8 @@ AudioFileWave::AudioFileWave( OutputSettings const & outputSettings,
 				const QString & file,
 				AudioEngine* audioEngine ) :
 	AudioFileDevice( outputSettings, channels, file, audioEngine ),
-	m_sf( nullptr )
+	m_sf( nullptr ),
+	m_dither( outputSettings.getDither() )
 {
 	successful = outputFileOpened() && startEncoding();
 }
@@ -76,8 +78,7 @@ bool AudioFileWave::startEncoding()
 		break;
 	}
 
-	// Use file handle to handle unicode file name on Windows
-	m_sf = sf_open_fd( outputFileHandle(), SFM_WRITE, &m_si, false );
+	m_sf = openSndFile(&m_si);
 
 	if (!m_sf)
 	{
@@ -97,7 +98,7 @@ void AudioFileWave::writeBuffer(const SampleFrame* _ab, const fpp_t _frames)
 {
 	OutputSettings::BitDepth bitDepth = getOutputSettings().getBitDepth();
 
-	if( bitDepth == OutputSettings::BitDepth::Depth32Bit || bitDepth == OutputSettings::BitDepth::Depth24Bit )
+	if( bitDepth == OutputSettings::BitDepth::Depth32Bit )
 	{
 		auto buf = new float[_frames * channels()];
 		for( fpp_t frame = 0; frame < _frames; ++frame )
@@ -110,13 +111,19 @@ void AudioFileWave::writeBuffer(const SampleFrame* _ab, const fpp_t _frames)
 		sf_writef_float( m_sf, buf, _frames );
 		delete[] buf;
 	}
+	else if( bitDepth == OutputSettings::BitDepth::Depth24Bit )
+	{
+		// libsndfile keeps the upper 24 bits of ints
+		auto buf = std::vector<int>(_frames * channels());
+		SampleConversion::toS32(_ab, _frames, channels(), buf.data(), 24, &m_dither);
+		sf_writef_int( m_sf, buf.data(), _frames );
+	}
 	else
 	{
-		auto buf = new int_sample_t[_frames * channels()];
-		convertToS16(_ab, _frames, buf, !isLittleEndian());
-
-		sf_writef_short( m_sf, buf, _frames );
-		delete[] buf;
+		// libsndfile takes shorts in host byte order
+		auto buf = std::vector<short>(_frames * channels());
+		SampleConversion::toS16(_ab, _frames, channels(), buf.data(), false, &m_dither);
+		sf_writef_short( m_sf, buf.data(), _frames );
 	}
 }
 
@@ -26,6 +26,7 @@
 
 #ifdef LMMS_HAVE_JACK
 
+#include <QCheckBox>
 #include <QFormLayout>
 #include <QLabel>
 #include <QLineEdit>
@@ -33,12 +34,15 @@
 #include <QMessageBox>
 #include <QToolButton>
 #include <QStringList>
+#include <QThread>
 
 #include "AudioEngine.h"
+#include "AudioEngineWorkerThread.h"
 #include "ConfigManager.h"
 #include "GuiApplication.h"
 #include "MainWindow.h"
 #include "MidiJack.h"
+#include "denormals.h"
 
 #include <cstdio>
 
@@ -47,6 +51,7 @@ namespace
 {
 static const QString audioJackClass("audiojack");
 static const QString clientNameKey("clientname");
+static const QString renderInCallbackKey("renderincallback");
 static const QString disconnectedRepresentation("-");
 
 QString getOutputKeyByChannel(size_t channel)
@@ -100,9 +105,10 @@ AudioJack::AudioJack(bool& successful, AudioEngine* audioEngineParam)
 		audioEngineParam)
 	, m_client(nullptr)
 	, m_active(false)
+	, m_renderInCallback(ConfigManager::inst()->value(audioJackClass, renderInCallbackKey).toInt())
 	, m_midiClient(nullptr)
 	, m_tempOutBufs(new jack_default_audio_sample_t*[channels()])
-	, m_outBuf(new SampleFrame[audioEngine()->framesPerPeriod()])
+	, m_outBuf(new SampleFrame[audioEngine()->maxFramesPerPeriod()])
 	, m_framesDoneInCurBuf(0)
 	, m_framesToDoInCurBuf(0)
 {
@@ -333,6 +339,13 @@ void AudioJack::startProcessing()
 void AudioJack::stopProcessing()
 {
 	m_stopped = true;
+
+	// Without a FIFO thread, the callback renders itself and has to finish
+	// its period before the engine may change
+	while (m_inCallback)
+	{
+		QThread::yieldCurrentThread();
+	}
 }
 
 void AudioJack::registerPort(AudioBusHandle* port)
@@ -426,6 +439,15 @@ int AudioJack::processCallback(jack_nframes_t nframes)
 	}
 #endif
 
+	m_inCallback = true;
+	if (m_renderInCallback && !m_callbackPromoted)
+	{
+		// JACK keeps its process thread, so this is only needed once
+		disable_denormals();
+		AudioEngineWorkerThread::promoteWithCurrentThread();
+		m_callbackPromoted = true;
+	}
+
 	jack_nframes_t done = 0;
 	while (done < nframes && !m_stopped)
 	{
@@ -451,6 +473,7 @@ int AudioJack::processCallback(jack_nframes_t nframes)
 			}
 		}
 	}
+	m_inCallback = false;
 
 	if (nframes != done)
 	{
@@ -519,6 +542,12 @@ AudioJack::setupWidget::setupWidget(QWidget* parent)
 
 	form->addRow(tr("Client name"), m_clientName);
 
+	m_renderInCallback = new QCheckBox(tr("Render in JACK's process callback"), this);
+	m_renderInCallback->setChecked(cm->value(audioJackClass, renderInCallbackKey).toInt());
+	m_renderInCallback->setToolTip(tr("Renders each period right when JACK asks for it instead of one period "
+		"ahead, for the lowest latency. A period that takes too long to render is an xrun then."));
+	form->addRow(m_renderInCallback);
+
 	auto buildToolButton = [this](QWidget* parent, const QString& currentSelection, const std::vector<std::string>& names, const QString& filteredLMMSClientName)
 	{
 		auto toolButton = new QToolButton(parent);
@@ -569,6 +598,8 @@ AudioJack::setupWidget::setupWidget(QWidget* parent)
 void AudioJack::setupWidget::saveSettings()
 {
 	ConfigManager::inst()->setValue(audioJackClass, clientNameKey, m_clientName->text());
+	ConfigManager::inst()->setValue(audioJackClass, renderInCallbackKey,
+		QString::number(m_renderInCallback->isChecked()));
 
 	for (size_t i = 0; i < m_outputDevices.size(); ++i)
 	{
@@ -99,7 +99,7 @@ AudioOss::AudioOss( bool & _success_ful, AudioEngine*  _audioEngine ) :
 
 	int frag_spec;
 	for (frag_spec = 0;
-		1u << frag_spec < audioEngine()->framesPerPeriod() * channels() * BYTES_PER_INT_SAMPLE;
+		1u << frag_spec < audioEngine()->maxFramesPerPeriod() * channels() * BYTES_PER_INT_SAMPLE;
 		++frag_spec)
 	{
 	}
@@ -254,8 +254,8 @@ void AudioOss::stopProcessing()
 
 void AudioOss::run()
 {
-	auto temp = new SampleFrame[audioEngine()->framesPerPeriod()];
-	auto outbuf = new int_sample_t[audioEngine()->framesPerPeriod() * channels()];
+	auto temp = new SampleFrame[audioEngine()->maxFramesPerPeriod()];
+	auto outbuf = new int_sample_t[audioEngine()->maxFramesPerPeriod() * channels()];
 
 	while( true )
 	{
@@ -0,0 +1,470 @@
+/*
+ * AudioPipeWire.cpp - device-class that performs PCM-output via PipeWire
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "AudioPipeWire.h"
+
+#ifdef LMMS_HAVE_PIPEWIRE
+
+#include <spa/param/audio/format-utils.h>
+
+#include <QCheckBox>
+#include <QFormLayout>
+#include <QLineEdit>
+#include <QThread>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "AudioEngine.h"
+#include "AudioEngineWorkerThread.h"
+#include "ConfigManager.h"
+#include "denormals.h"
+
+#ifdef AUDIO_BUS_HANDLE_SUPPORT
+#include "AudioBusHandle.h"
+#include "Engine.h"
+#endif
+
+namespace lmms
+{
+
+namespace
+{
+
+const QString audioPipeWireClass("audiopipewire");
+const QString clientNameKey("clientname");
+const QString renderInCallbackKey("renderincallback");
+
+//! The planar channel buffers of @p buffer, or false if it has too few
+bool channelBuffers(pw_buffer* buffer, float** out, ch_cnt_t channels, f_cnt_t& frames)
+{
+	spa_buffer* spaBuffer = buffer->buffer;
+	if (spaBuffer->n_datas < channels) { return false; }
+
+	frames = spaBuffer->datas[0].maxsize / sizeof(float);
+#if PW_CHECK_VERSION(0, 3, 49)
+	if (buffer->requested) { frames = std::min<f_cnt_t>(frames, buffer->requested); }
+#endif
+
+	for (ch_cnt_t ch = 0; ch < channels; ++ch)
+	{
+		spa_data& data = spaBuffer->datas[ch];
+		out[ch] = static_cast<float*>(data.data);
+		if (!out[ch]) { return false; }
+		data.chunk->offset = 0;
+		data.chunk->stride = sizeof(float);
+		data.chunk->size = frames * sizeof(float);
+	}
+	return true;
+}
+
+} // namespace
+
+
+
+
+AudioPipeWire::AudioPipeWire(bool& successful, AudioEngine* audioEngine) :
+	AudioDevice(DEFAULT_CHANNELS, audioEngine),
+	m_loop(nullptr),
+	m_context(nullptr),
+	m_core(nullptr),
+	m_stream(nullptr),
+	m_streamListener(),
+	m_renderInCallback(ConfigManager::inst()->value(audioPipeWireClass, renderInCallbackKey).toInt()),
+	m_callbackPromoted(false),
+	m_stopped(true),
+	m_inCallback(false),
+	m_outBuf(audioEngine->maxFramesPerPeriod()),
+	m_outBufPos(0),
+	m_outBufSize(0)
+{
+	successful = false;
+
+	pw_init(nullptr, nullptr);
+
+	m_loop = pw_thread_loop_new("lmms-pipewire", nullptr);
+	if (!m_loop) { return; }
+
+	m_context = pw_context_new(pw_thread_loop_get_loop(m_loop), nullptr, 0);
+	if (!m_context) { return; }
+
+	// fails right away if there is no PipeWire daemon to fall back to another device
+	m_core = pw_context_connect(m_context, nullptr, 0);
+	if (!m_core)
+	{
+		std::fprintf(stderr, "Could not connect to PipeWire\n");
+		return;
+	}
+
+	static const pw_stream_events streamEvents = [] {
+		auto events = pw_stream_events{};
+		events.version = PW_VERSION_STREAM_EVENTS;
+		events.process = &AudioPipeWire::staticProcessCallback;
+		return events;
+	}();
+	m_stream = createStream(probeDevice(), &streamEvents, this, &m_streamListener);
+	if (!m_stream) { return; }
+
+	if (pw_thread_loop_start(m_loop) < 0)
+	{
+		std::fprintf(stderr, "Could not start the PipeWire thread loop\n");
+		return;
+	}
+
+	successful = true;
+}
+
+
+
+
+AudioPipeWire::~AudioPipeWire()
+{
+	AudioPipeWire::stopProcessing();
+
+	if (m_loop) { pw_thread_loop_stop(m_loop); }
+
+#ifdef AUDIO_BUS_HANDLE_SUPPORT
+	for (auto& [handle, bus] : m_busStreams)
+	{
+		pw_stream_destroy(bus->stream);
+	}
+	m_busStreams.clear();
+#endif
+
+	if (m_stream) { pw_stream_destroy(m_stream); }
+	if (m_core) { pw_core_disconnect(m_core); }
+	if (m_context) { pw_context_destroy(m_context); }
+	if (m_loop) { pw_thread_loop_destroy(m_loop); }
+}
+
+
+
+
+QString AudioPipeWire::probeDevice()
+{
+	const QString name = ConfigManager::inst()->value(audioPipeWireClass, clientNameKey);
+	return name.isEmpty() ? QString("lmms") : name;
+}
+
+
+
+
+pw_stream* AudioPipeWire::createStream(const QString& name, const pw_stream_events* events,
+	void* data, spa_hook* listener)
+{
+	// Asking for a quantum of one period at our rate lets PipeWire run the
+	// graph in step with the engine, without resampling where it can
+	const QByteArray latency = QString("%1/%2").arg(audioEngine()->maxFramesPerPeriod()).arg(sampleRate()).toUtf8();
+	const QByteArray rate = QString("1/%1").arg(sampleRate()).toUtf8();
+	const QByteArray nodeName = name.toUtf8();
+
+	pw_properties* props = pw_properties_new(
+		PW_KEY_MEDIA_TYPE, "Audio",
+		PW_KEY_MEDIA_CATEGORY, "Playback",
+		PW_KEY_MEDIA_ROLE, "Production",
+		PW_KEY_APP_NAME, "LMMS",
+		PW_KEY_NODE_NAME, nodeName.constData(),
+		PW_KEY_NODE_LATENCY, latency.constData(),
+		PW_KEY_NODE_RATE, rate.constData(),
+		nullptr);
+
+	pw_stream* stream = pw_stream_new(m_core, nodeName.constData(), props);
+	if (!stream)
+	{
+		std::fprintf(stderr, "Could not create PipeWire stream\n");
+		return nullptr;
+	}
+	pw_stream_add_listener(stream, listener, events, data);
+
+	auto info = spa_audio_info_raw{};
+	info.format = SPA_AUDIO_FORMAT_F32P;
+	info.rate = sampleRate();
+	info.channels = channels();
+	info.position[0] = SPA_AUDIO_CHANNEL_FL;
+	info.position[1] = SPA_AUDIO_CHANNEL_FR;
+
+	uint8_t podData[1024];
+	auto builder = spa_pod_builder{};
+	spa_pod_builder_init(&builder, podData, sizeof(podData));
+	const spa_pod* params[] = {spa_format_audio_raw_build(&builder, SPA_PARAM_EnumFormat, &info)};
+
+	const auto flags = static_cast<pw_stream_flags>(PW_STREAM_FLAG_AUTOCONNECT | PW_STREAM_FLAG_MAP_BUFFERS
+		| PW_STREAM_FLAG_RT_PROCESS | PW_STREAM_FLAG_INACTIVE);
+	if (pw_stream_connect(stream, PW_DIRECTION_OUTPUT, PW_ID_ANY, flags, params, 1) < 0)
+	{
+		std::fprintf(stderr, "Could not connect PipeWire stream\n");
+		pw_stream_destroy(stream);
+		return nullptr;
+	}
+	return stream;
+}
+
+
+
+
+void AudioPipeWire::setActive(bool active)
+{
+	pw_thread_loop_lock(m_loop);
+	pw_stream_set_active(m_stream, active);
+#ifdef AUDIO_BUS_HANDLE_SUPPORT
+	for (auto& [handle, bus] : m_busStreams)
+	{
+		pw_stream_set_active(bus->stream, active);
+	}
+#endif
+	pw_thread_loop_unlock(m_loop);
+}
+
+
+
+
+void AudioPipeWire::startProcessing()
+{
+	if (!m_stream) { return; }
+
+	m_outBufPos = m_outBufSize = 0;
+	m_stopped = false;
+	setActive(true);
+}
+
+
+
+
+void AudioPipeWire::stopProcessing()
+{
+	if (!m_stream) { return; }
+
+	m_stopped = true;
+
+	// Without a FIFO thread, the callback renders itself and has to finish
+	// its period before the engine may change
+	while (m_inCallback)
+	{
+		QThread::yieldCurrentThread();
+	}
+
+	setActive(false);
+}
+
+
+
+
+void AudioPipeWire::processCallback()
+{
+	pw_buffer* buffer = pw_stream_dequeue_buffer(m_stream);
+	if (!buffer) { return; }
+
+	float* out[DEFAULT_CHANNELS];
+	f_cnt_t frames = 0;
+	if (!channelBuffers(buffer, out, channels(), frames))
+	{
+		pw_stream_queue_buffer(m_stream, buffer);
+		return;
+	}
+
+	m_inCallback = true;
+	if (m_renderInCallback && !m_callbackPromoted)
+	{
+		// the data loop keeps its thread, so this is only needed once
+		disable_denormals();
+		AudioEngineWorkerThread::promoteWithCurrentThread();
+		m_callbackPromoted = true;
+	}
+
+	f_cnt_t done = 0;
+	while (done < frames && !m_stopped)
+	{
+		if (m_outBufPos == m_outBufSize)
+		{
+			m_outBufSize = getNextBuffer(m_outBuf.data());
+			m_outBufPos = 0;
+			if (!m_outBufSize)
+			{
+				m_stopped = true;
+				break;
+			}
+		}
+
+		const f_cnt_t todo = std::min(frames - done, m_outBufSize - m_outBufPos);
+		for (ch_cnt_t ch = 0; ch < channels(); ++ch)
+		{
+			for (f_cnt_t frame = 0; frame < todo; ++frame)
+			{
+				out[ch][done + frame] = m_outBuf[m_outBufPos + frame][ch];
+			}
+		}
+		done += todo;
+		m_outBufPos += todo;
+	}
+	m_inCallback = false;
+
+	if (done < frames)
+	{
+		for (ch_cnt_t ch = 0; ch < channels(); ++ch)
+		{
+			std::memset(out[ch] + done, 0, (frames - done) * sizeof(float));
+		}
+	}
+
+	pw_stream_queue_buffer(m_stream, buffer);
+}
+
+
+
+
+void AudioPipeWire::staticProcessCallback(void* data)
+{
+	static_cast<AudioPipeWire*>(data)->processCallback();
+}
+
+
+
+
+void AudioPipeWire::registerPort(AudioBusHandle* port)
+{
+#ifdef AUDIO_BUS_HANDLE_SUPPORT
+	// make sure, port is not already registered
+	unregisterPort(port);
+
+	static const pw_stream_events busStreamEvents = [] {
+		auto events = pw_stream_events{};
+		events.version = PW_VERSION_STREAM_EVENTS;
+		events.process = &AudioPipeWire::busProcessCallback;
+		return events;
+	}();
+
+	auto bus = std::make_unique<BusStream>();
+	bus->handle = port;
+
+	pw_thread_loop_lock(m_loop);
+	bus->stream = createStream(probeDevice() + ": " + port->name(), &busStreamEvents, bus.get(), &bus->listener);
+	if (bus->stream)
+	{
+		pw_stream_set_active(bus->stream, !m_stopped);
+		m_busStreams[port] = std::move(bus);
+	}
+	pw_thread_loop_unlock(m_loop);
+#else
+	(void)port;
+#endif
+}
+
+
+
+
+void AudioPipeWire::unregisterPort(AudioBusHandle* port)
+{
+#ifdef AUDIO_BUS_HANDLE_SUPPORT
+	const auto it = m_busStreams.find(port);
+	if (it == m_busStreams.end()) { return; }
+
+	pw_thread_loop_lock(m_loop);
+	pw_stream_destroy(it->second->stream);
+	pw_thread_loop_unlock(m_loop);
+	m_busStreams.erase(it);
+#else
+	(void)port;
+#endif
+}
+
+
+
+
+void AudioPipeWire::renamePort(AudioBusHandle* port)
+{
+#ifdef AUDIO_BUS_HANDLE_SUPPORT
+	const auto it = m_busStreams.find(port);
+	if (it == m_busStreams.end()) { return; }
+
+	const QByteArray description = port->name().toUtf8();
+	const spa_dict_item items[] = {{PW_KEY_NODE_DESCRIPTION, description.constData()}};
+	const spa_dict dict = SPA_DICT_INIT_ARRAY(items);
+
+	pw_thread_loop_lock(m_loop);
+	pw_stream_update_properties(it->second->stream, &dict);
+	pw_thread_loop_unlock(m_loop);
+#else
+	(void)port;
+#endif
+}
+
+
+
+
+#ifdef AUDIO_BUS_HANDLE_SUPPORT
+void AudioPipeWire::busProcessCallback(void* data)
+{
+	auto bus = static_cast<BusStream*>(data);
+	pw_buffer* buffer = pw_stream_dequeue_buffer(bus->stream);
+	if (!buffer) { return; }
+
+	float* out[DEFAULT_CHANNELS];
+	f_cnt_t frames = 0;
+	if (channelBuffers(buffer, out, DEFAULT_CHANNELS, frames))
+	{
+		const SampleFrame* in = bus->handle->buffer();
+		const f_cnt_t available = std::min<f_cnt_t>(frames, Engine::audioEngine()->framesPerPeriod());
+		for (ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+		{
+			for (f_cnt_t frame = 0; frame < available; ++frame)
+			{
+				out[ch][frame] = in[frame][ch];
+			}
+			std::memset(out[ch] + available, 0, (frames - available) * sizeof(float));
+		}
+	}
+	pw_stream_queue_buffer(bus->stream, buffer);
+}
+#endif
+
+
+
+
+AudioPipeWire::setupWidget::setupWidget(QWidget* parent) :
+	AudioDeviceSetupWidget(AudioPipeWire::name(), parent)
+{
+	auto form = new QFormLayout(this);
+
+	m_clientName = new QLineEdit(probeDevice(), this);
+	form->addRow(tr("Client name"), m_clientName);
+
+	m_renderInCallback = new QCheckBox(tr("Render in the stream's process callback"), this);
+	m_renderInCallback->setChecked(ConfigManager::inst()->value(audioPipeWireClass, renderInCallbackKey).toInt());
+	m_renderInCallback->setToolTip(tr("Renders each period right when PipeWire asks for it instead of one "
+		"period ahead, for the lowest latency. A period that takes too long to render is an xrun then."));
+	form->addRow(m_renderInCallback);
+}
+
+
+
+
+void AudioPipeWire::setupWidget::saveSettings()
+{
+	ConfigManager::inst()->setValue(audioPipeWireClass, clientNameKey, m_clientName->text());
+	ConfigManager::inst()->setValue(audioPipeWireClass, renderInCallbackKey,
+		QString::number(m_renderInCallback->isChecked()));
+}
+
+} // namespace lmms
+
+#endif // LMMS_HAVE_PIPEWIRE
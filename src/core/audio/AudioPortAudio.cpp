@@ -49,11 +49,14 @@ void AudioPortAudioSetupUtil::updateChannels()
 
 #ifdef LMMS_HAVE_PORTAUDIO
 
+#include <QCheckBox>
 #include <QFormLayout>
 
 #include "ConfigManager.h"
 #include "ComboBox.h"
 #include "AudioEngine.h"
+#include "AudioEngineWorkerThread.h"
+#include "denormals.h"
 
 namespace lmms
 {
@@ -66,12 +69,14 @@ AudioPortAudio::AudioPortAudio( bool & _success_ful, AudioEngine * _audioEngine
 		DEFAULT_CHANNELS), _audioEngine),
 	m_paStream( nullptr ),
 	m_wasPAInitError( false ),
-	m_outBuf(new SampleFrame[audioEngine()->framesPerPeriod()]),
-	m_outBufPos( 0 )
+	m_outBuf(new SampleFrame[audioEngine()->maxFramesPerPeriod()]),
+	m_outBufPos( 0 ),
+	m_renderInCallback( ConfigManager::inst()->value( "audioportaudio", "renderincallback" ).toInt() ),
+	m_callbackPromoted( false )
 {
 	_success_ful = false;
 
-	m_outBufSize = audioEngine()->framesPerPeriod();
+	m_outBufSize = audioEngine()->maxFramesPerPeriod();
 
 	PaError err = Pa_Initialize();
 	
@@ -122,7 +127,7 @@ AudioPortAudio::AudioPortAudio( bool & _success_ful, AudioEngine * _audioEngine
 
 	//inLatency = Pa_GetDeviceInfo( inDevIdx )->defaultLowInputLatency;
 	//outLatency = Pa_GetDeviceInfo( outDevIdx )->defaultLowOutputLatency;
-	const int samples = audioEngine()->framesPerPeriod();
+	const int samples = audioEngine()->maxFramesPerPeriod();
 	
 	// Configure output parameters.
 	m_outputParameters.device = outDevIdx;
@@ -201,6 +206,8 @@ AudioPortAudio::~AudioPortAudio()
 void AudioPortAudio::startProcessing()
 {
 	m_stopped = false;
+	// the stream may call back from a new thread
+	m_callbackPromoted = false;
 	PaError err = Pa_StartStream( m_paStream );
 	
 	if( err != paNoError )
@@ -242,6 +249,13 @@ int AudioPortAudio::process_callback(const float* _inputBuffer, float* _outputBu
 		return paComplete;
 	}
 
+	if( m_renderInCallback && !m_callbackPromoted )
+	{
+		disable_denormals();
+		AudioEngineWorkerThread::promoteWithCurrentThread();
+		m_callbackPromoted = true;
+	}
+
 	while( _framesPerBuffer )
 	{
 		if( m_outBufPos == 0 )
@@ -380,6 +394,12 @@ AudioPortAudio::setupWidget::setupWidget( QWidget * _parent ) :
 
 	m_device = new ComboBox( this, "DEVICE" );
 	form->addRow(tr("Device"), m_device);
+
+	m_renderInCallback = new QCheckBox( tr( "Render in the stream callback" ), this );
+	m_renderInCallback->setChecked( ConfigManager::inst()->value( "audioportaudio", "renderincallback" ).toInt() );
+	m_renderInCallback->setToolTip( tr( "Renders each period when the backend asks for it instead of one "
+		"period ahead. Use it with low-latency backends like ASIO or WASAPI." ) );
+	form->addRow(m_renderInCallback);
 	
 /*	LcdSpinBoxModel * m = new LcdSpinBoxModel(  );
 	m->setRange( DEFAULT_CHANNELS, DEFAULT_CHANNELS );
@@ -424,6 +444,8 @@ void AudioPortAudio::setupWidget::saveSettings()
 							m_setupUtil.m_backendModel.currentText() );
 	ConfigManager::inst()->setValue( "audioportaudio", "device",
 							m_setupUtil.m_deviceModel.currentText() );
+	ConfigManager::inst()->setValue( "audioportaudio", "renderincallback",
+							QString::number( m_renderInCallback->isChecked() ) );
 /*	ConfigManager::inst()->setValue( "audioportaudio", "channels",
 				QString::number( m_channels->value<int>() ) );*/
 
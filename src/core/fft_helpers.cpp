@@ -26,9 +26,17 @@
 
 #include "fft_helpers.h"
 
+#include <QThread>
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <condition_variable>
+#include <map>
 #include <numbers>
 
+#include "AudioEngine.h"
+#include "Engine.h"
+
 namespace lmms
 {
 
@@ -219,4 +227,226 @@ int compressbands(const float *absspec_buffer, float *compressedband, int num_ol
 }
 
 
+namespace
+{
+
+//! Planning isn't thread-safe, executing plans is
+std::mutex& plannerMutex()
+{
+	static auto mutex = std::mutex{};
+	return mutex;
+}
+
+} // namespace
+
+
+fftwf_plan realFftPlan(unsigned int size)
+{
+	static auto plans = std::map<unsigned int, fftwf_plan>{};
+
+	const auto lock = std::lock_guard{plannerMutex()};
+	auto& plan = plans[size];
+	if (!plan)
+	{
+		// planning overwrites the buffers, so it gets its own ones of the same alignment
+		auto in = makeFftwBuffer<float>(size);
+		auto out = makeFftwBuffer<fftwf_complex>(size / 2 + 1);
+		plan = fftwf_plan_dft_r2c_1d(size, in.get(), out.get(), FFTW_MEASURE);
+	}
+	return plan;
+}
+
+
+fftwf_plan inverseRealFftPlan(unsigned int size)
+{
+	static auto plans = std::map<unsigned int, fftwf_plan>{};
+
+	const auto lock = std::lock_guard{plannerMutex()};
+	auto& plan = plans[size];
+	if (!plan)
+	{
+		auto in = makeFftwBuffer<fftwf_complex>(size / 2 + 1);
+		auto out = makeFftwBuffer<float>(size);
+		plan = fftwf_plan_dft_c2r_1d(size, in.get(), out.get(), FFTW_MEASURE);
+	}
+	return plan;
+}
+
+
+
+
+//! The thread running all spectrum analyses, polling them at more than the display rate
+class AnalysisWorker : public QThread
+{
+public:
+	static AnalysisWorker& instance()
+	{
+		static auto worker = AnalysisWorker{};
+		return worker;
+	}
+
+	~AnalysisWorker() override
+	{
+		{
+			const auto lock = std::lock_guard{m_access};
+			m_quit = true;
+		}
+		m_wake.notify_all();
+		wait();
+	}
+
+	void add(SpectrumAnalysis* analysis)
+	{
+		const auto lock = std::lock_guard{m_access};
+		m_analyses.push_back(analysis);
+		if (!isRunning()) { start(QThread::LowestPriority); }
+	}
+
+	//! Once this returns, the worker won't touch the analysis anymore
+	void remove(SpectrumAnalysis* analysis)
+	{
+		const auto lock = std::lock_guard{m_access};
+		std::erase(m_analyses, analysis);
+	}
+
+private:
+	AnalysisWorker() = default;
+
+	static constexpr auto Interval = std::chrono::milliseconds{10};
+
+	void run() override
+	{
+		auto lock = std::unique_lock{m_access};
+		while (!m_quit)
+		{
+			for (auto analysis : m_analyses) { analysis->process(); }
+			m_wake.wait_for(lock, Interval, [this] { return m_quit; });
+		}
+	}
+
+	std::mutex m_access;
+	std::condition_variable m_wake;
+	std::vector<SpectrumAnalysis*> m_analyses;
+	bool m_quit = false;
+};
+
+
+
+
+SpectrumAnalysis::SpectrumAnalysis(unsigned int blockSize, FFTWindow window, bool stereo, unsigned int zeroPadFactor) :
+	m_blockSize(blockSize),
+	m_fftSize(blockSize * std::max(zeroPadFactor, 1u)),
+	m_stereo(stereo),
+	m_window(blockSize),
+	m_plan(realFftPlan(m_fftSize)),
+	// room for a few periods and blocks in case the worker is busy
+	m_input(4 * std::max<std::size_t>(blockSize, MAXIMUM_BUFFER_SIZE)),
+	m_reader(m_input),
+	m_block(blockSize),
+	m_fftInput(makeFftwBuffer<float>(m_fftSize)),
+	m_fftOutput(makeFftwBuffer<fftwf_complex>(binCount()))
+{
+	precomputeWindow(m_window.data(), m_blockSize, window, false);
+	std::fill_n(m_fftInput.get(), m_fftSize, 0.f);
+	m_spectrum.left.resize(binCount());
+	if (m_stereo) { m_spectrum.right.resize(binCount()); }
+
+	AnalysisWorker::instance().add(this);
+}
+
+
+
+
+SpectrumAnalysis::~SpectrumAnalysis()
+{
+	AnalysisWorker::instance().remove(this);
+}
+
+
+
+
+void SpectrumAnalysis::write(const SampleFrame* buf, fpp_t frames)
+{
+	if (m_active) { m_input.write(buf, frames); }
+}
+
+
+
+
+int SpectrumAnalysis::subscribe(Subscriber subscriber)
+{
+	const auto lock = std::lock_guard{m_subscriberAccess};
+	m_subscribers.emplace_back(m_nextId, std::move(subscriber));
+	return m_nextId++;
+}
+
+
+
+
+void SpectrumAnalysis::unsubscribe(int id)
+{
+	const auto lock = std::lock_guard{m_subscriberAccess};
+	std::erase_if(m_subscribers, [id](const auto& subscriber) { return subscriber.first == id; });
+}
+
+
+
+
+void SpectrumAnalysis::process()
+{
+	const auto input = m_reader.read_max(m_input.capacity());
+	if (!m_active)
+	{
+		// start over with fresh data when activated again
+		m_framesFilledUp = 0;
+		return;
+	}
+
+	for (std::size_t frame = 0; frame < input.size(); ++frame)
+	{
+		m_block[m_framesFilledUp++] = input[frame];
+		if (m_framesFilledUp == m_blockSize)
+		{
+			analyseBlock();
+			m_framesFilledUp = 0;
+		}
+	}
+}
+
+
+
+
+void SpectrumAnalysis::analyseBlock()
+{
+	const auto lock = std::lock_guard{m_subscriberAccess};
+	if (m_subscribers.empty()) { return; }
+
+	m_spectrum.sampleRate = Engine::audioEngine()->outputSampleRate();
+	for (unsigned int i = 0; i < m_blockSize; i++)
+	{
+		m_fftInput[i] = m_stereo ? m_block[i][0] : (m_block[i][0] + m_block[i][1]) * 0.5f;
+	}
+	m_spectrum.peakLeft = transform(m_spectrum.left);
+	if (m_stereo)
+	{
+		for (unsigned int i = 0; i < m_blockSize; i++) { m_fftInput[i] = m_block[i][1]; }
+		m_spectrum.peakRight = transform(m_spectrum.right);
+	}
+	else { m_spectrum.peakRight = m_spectrum.peakLeft; }
+
+	for (const auto& subscriber : m_subscribers) { subscriber.second(m_spectrum); }
+}
+
+
+
+
+float SpectrumAnalysis::transform(std::vector<float>& magnitudes)
+{
+	for (unsigned int i = 0; i < m_blockSize; i++) { m_fftInput[i] *= m_window[i]; }
+	fftwf_execute_dft_r2c(m_plan, m_fftInput.get(), m_fftOutput.get());
+	absspec(m_fftOutput.get(), magnitudes.data(), binCount());
+	return maximum(m_fftInput.get(), m_blockSize);
+}
+
+
 } // namespace lmms
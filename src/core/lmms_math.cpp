@@ -0,0 +1,60 @@
+/*
+ * lmms_math.cpp - state of the math functions
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "lmms_math.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace lmms
+{
+
+namespace
+{
+
+//! A different seed for every thread, so voices rendered by different workers don't get the same noise.
+//! The deterministic mode seeds every job anyway.
+unsigned long threadSeed() noexcept
+{
+	static auto s_threads = std::atomic<std::uint64_t>{0};
+
+	// splitmix64 of the thread count and the time
+	auto seed = s_threads.fetch_add(1, std::memory_order_relaxed) * 0x9e3779b97f4a7c15
+		+ static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+	seed = (seed ^ (seed >> 30)) * 0xbf58476d1ce4e5b9;
+	seed = (seed ^ (seed >> 27)) * 0x94d049bb133111eb;
+	return static_cast<unsigned long>(seed ^ (seed >> 31));
+}
+
+} // namespace
+
+
+unsigned long& fastRandState() noexcept
+{
+	// defined here rather than inline, so plugins share it with the core
+	static thread_local unsigned long state = threadSeed();
+	return state;
+}
+
+
+} // namespace lmms
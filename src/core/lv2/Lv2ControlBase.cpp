@@ -161,6 +161,19 @@ void Lv2ControlBase::copyBuffersToLmms(SampleFrame* buf, fpp_t frames) const {
 
 
 
+void Lv2ControlBase::mixBuffersToLmms(SampleFrame* buf, fpp_t frames,
+	float dry, float wet) const
+{
+	unsigned firstChan = 0; // tell the procs which channels they shall mix into
+	for (const auto& c : m_procs) {
+		c->mixBuffersToCore(buf, firstChan, m_channelsPerProc, frames, dry, wet);
+		firstChan += m_channelsPerProc;
+	}
+}
+
+
+
+
 void Lv2ControlBase::run(fpp_t frames) {
 	for (const auto& c : m_procs) { c->run(frames); }
 }
@@ -30,6 +30,7 @@
 
 #ifdef LMMS_HAVE_LV2
 
+#include <algorithm>
 #include <cassert>
 #include <cstdlib>
 #include <cstring>
@@ -44,7 +45,8 @@ struct LV2_Evbuf_Impl {
 	uint32_t capacity;
 	uint32_t atom_Chunk;
 	uint32_t atom_Sequence;
-	LV2_Atom_Sequence buf;
+	// atoms must be 64-bit aligned, as the events following it
+	alignas(8) LV2_Atom_Sequence buf;
 };
 
 static inline uint32_t
@@ -56,7 +58,10 @@ lv2_evbuf_pad_size(uint32_t size)
 LV2_Evbuf*
 lv2_evbuf_new(uint32_t capacity, uint32_t atom_Chunk, uint32_t atom_Sequence)
 {
-	// FIXME: memory must be 64-bit aligned
+	// events are padded to 64 bits, so the space left must be a multiple of
+	// that, too, or the check for it in lv2_evbuf_write would wrap around
+	capacity = lv2_evbuf_pad_size(capacity);
+	// malloc's alignment suffices for the alignment of the sequence
 	auto evbuf = (LV2_Evbuf*)malloc(sizeof(LV2_Evbuf) + sizeof(LV2_Atom_Sequence) + capacity);
 	evbuf->capacity = capacity;
 	evbuf->atom_Chunk = atom_Chunk;
@@ -83,6 +88,18 @@ lv2_evbuf_reset(LV2_Evbuf* evbuf, bool input)
 	}
 }
 
+uint32_t
+lv2_evbuf_get_capacity(LV2_Evbuf* evbuf)
+{
+	return evbuf->capacity;
+}
+
+uint32_t
+lv2_evbuf_capacity_for(uint32_t count, uint32_t size)
+{
+	return sizeof(LV2_Atom_Sequence) + count * lv2_evbuf_pad_size(sizeof(LV2_Atom_Event) + size);
+}
+
 uint32_t
 lv2_evbuf_get_size(LV2_Evbuf* evbuf)
 {
@@ -190,6 +207,42 @@ lv2_evbuf_write(LV2_Evbuf_Iterator* iter,
 	return true;
 }
 
+uint32_t
+lv2_evbuf_write_events(LV2_Evbuf_Iterator* iter,
+	const LV2_Evbuf_Event* events,
+	uint32_t count)
+{
+	LV2_Atom_Sequence* aseq = &iter->evbuf->buf;
+	uint32_t space = iter->evbuf->capacity - sizeof(LV2_Atom) - aseq->atom.size;
+
+	// find out how many events fit before writing any
+	uint32_t fitting = 0;
+	uint32_t total = 0;
+	for (; fitting < count; ++fitting) {
+		const uint32_t size = lv2_evbuf_pad_size(sizeof(LV2_Atom_Event) + events[fitting].size);
+		if (space < sizeof(LV2_Atom_Event) + events[fitting].size) {
+			break;
+		}
+		space -= std::min(space, size);
+		total += size;
+	}
+
+	auto contents = (char*)LV2_ATOM_CONTENTS(LV2_Atom_Sequence, aseq) + iter->offset;
+	for (uint32_t i = 0; i < fitting; ++i) {
+		auto aev = (LV2_Atom_Event*)contents;
+		aev->time.frames = events[i].frames;
+		aev->body.type = events[i].type;
+		aev->body.size = events[i].size;
+		memcpy(LV2_ATOM_BODY(&aev->body), events[i].data, events[i].size);
+		contents += lv2_evbuf_pad_size(sizeof(LV2_Atom_Event) + events[i].size);
+	}
+
+	aseq->atom.size += total;
+	iter->offset += total;
+
+	return fitting;
+}
+
 
 } // namespace lmms
 
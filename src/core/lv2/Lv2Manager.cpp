@@ -34,6 +34,7 @@
 #include <lv2/worker/worker.h>
 #include <QDebug>
 #include <QElapsedTimer>
+#include <QVariant>
 
 #include "AudioEngine.h"
 #include "ConfigManager.h"
@@ -42,6 +43,7 @@
 #include "Lv2ControlBase.h"
 #include "Lv2Options.h"
 #include "PluginIssue.h"
+#include "PluginMetadataCache.h"
 
 
 namespace lmms
@@ -180,9 +182,9 @@ Lv2Manager::Lv2Manager() :
 	m_supportedFeatureURIs.insert(LV2_WORKER__schedule);
 	// min/max is always passed in the options
 	m_supportedFeatureURIs.insert(LV2_BUF_SIZE__boundedBlockLength);
-	// block length is only changed initially in AudioEngine CTOR
+	// plugins relying on it keep the engine from changing the block length
 	m_supportedFeatureURIs.insert(LV2_BUF_SIZE__fixedBlockLength);
-	if (const auto fpp = Engine::audioEngine()->framesPerPeriod(); (fpp & (fpp - 1)) == 0)  // <=> ffp is power of 2 (for ffp > 0)
+	if (const auto fpp = Engine::audioEngine()->maxFramesPerPeriod(); (fpp & (fpp - 1)) == 0)  // <=> ffp is power of 2 (for ffp > 0)
 	{
 		m_supportedFeatureURIs.insert(LV2_BUF_SIZE__powerOf2BlockLength);
 	}
@@ -241,43 +243,87 @@ void Lv2Manager::initPlugins()
 	QElapsedTimer timer;
 	timer.start();
 
+	// Checking a plugin makes lilv read all of its data, so the results are
+	// kept for bundles which did not change since they were last checked
+	PluginMetadataCache cache(QStringLiteral("lv2"), 1);
+	const auto fpp = Engine::audioEngine()->maxFramesPerPeriod();
+	const QString checkConfig = QString("%1 %2 %3")
+		.arg(ConfigManager::enableBlockedPlugins())
+		.arg(fpp <= 32)
+		.arg(isFeatureSupported(LV2_BUF_SIZE__powerOf2BlockLength));
+	struct Bundle
+	{
+		QVariantMap cached, checked;
+		bool changed = false;
+	};
+	std::map<QString, Bundle> bundles;
+
 	unsigned blocked = 0;
 	LILV_FOREACH(plugins, itr, plugins)
 	{
 		const LilvPlugin* curPlug = lilv_plugins_get(plugins, itr);
-
-		std::vector<PluginIssue> issues;
-		Plugin::Type type = Lv2ControlBase::check(curPlug, issues);
-		std::sort(issues.begin(), issues.end());
-		auto last = std::unique(issues.begin(), issues.end());
-		issues.erase(last, issues.end());
-		if (m_debug && issues.size())
+		const char* pluginUri = lilv_node_as_uri(lilv_plugin_get_uri(curPlug));
+
+		auto bundlePath = AutoLilvPtr<char>(lilv_file_uri_parse(
+			lilv_node_as_uri(lilv_plugin_get_bundle_uri(curPlug)), nullptr));
+		auto [bundleItr, added] = bundles.try_emplace(QString::fromUtf8(bundlePath.get()));
+		Bundle& bundle = bundleItr->second;
+		// in debug mode, all plugins are checked to print their issues
+		if (added && !m_debug)
 		{
-			qDebug() << "Lv2 plugin"
-				<< qStringFromPluginNode(curPlug, lilv_plugin_get_name)
-				<< "(URI:"
-				<< lilv_node_as_uri(lilv_plugin_get_uri(curPlug))
-				<< ") can not be loaded:";
-			for (const PluginIssue& iss : issues) { qDebug() << "  - " << iss; }
+			const QVariantMap data = cache.find(bundleItr->first).value_or(QVariant()).toMap();
+			if (data["config"].toString() == checkConfig) { bundle.cached = data["plugins"].toMap(); }
 		}
 
-		Lv2Info info(curPlug, type, issues.empty());
-
-		m_lv2InfoMap[lilv_node_as_uri(lilv_plugin_get_uri(curPlug))]
-			= std::move(info);
-		if(issues.empty()) { ++pluginsLoaded; }
+		Plugin::Type type;
+		bool valid, isBlocked;
+		if (const auto cached = bundle.cached.find(pluginUri); cached != bundle.cached.end())
+		{
+			const QVariantList result = cached->toList();
+			type = static_cast<Plugin::Type>(result.value(0).toInt());
+			valid = result.value(1).toBool();
+			isBlocked = result.value(2).toBool();
+		}
 		else
 		{
-			if(std::any_of(issues.begin(), issues.end(),
-				[](const PluginIssue& iss) {
-				return iss.type() == PluginIssueType::Blocked; }))
+			std::vector<PluginIssue> issues;
+			type = Lv2ControlBase::check(curPlug, issues);
+			std::sort(issues.begin(), issues.end());
+			auto last = std::unique(issues.begin(), issues.end());
+			issues.erase(last, issues.end());
+			if (m_debug && issues.size())
 			{
-				++blocked;
+				qDebug() << "Lv2 plugin"
+					<< qStringFromPluginNode(curPlug, lilv_plugin_get_name)
+					<< "(URI:"
+					<< pluginUri
+					<< ") can not be loaded:";
+				for (const PluginIssue& iss : issues) { qDebug() << "  - " << iss; }
 			}
+			valid = issues.empty();
+			isBlocked = std::any_of(issues.begin(), issues.end(),
+				[](const PluginIssue& iss) {
+				return iss.type() == PluginIssueType::Blocked; });
+			bundle.changed = true;
 		}
+		bundle.checked[pluginUri] = QVariantList{static_cast<int>(type), valid, isBlocked};
+
+		Lv2Info info(curPlug, type, valid);
+
+		m_lv2InfoMap[pluginUri] = std::move(info);
+		if(valid) { ++pluginsLoaded; }
+		else if(isBlocked) { ++blocked; }
 		++pluginCount;
 	}
 
+	for (const auto& [path, bundle] : bundles)
+	{
+		if (bundle.changed)
+		{
+			cache.insert(path, QVariantMap{{"config", checkConfig}, {"plugins", bundle.checked}});
+		}
+	}
+
 	qDebug() << "Lv2 plugin SUMMARY:"
 		<< pluginsLoaded << "of" << pluginCount << " loaded in"
 		<< timer.elapsed() << "msecs.";
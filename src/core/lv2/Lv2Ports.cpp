@@ -348,6 +348,18 @@ void Audio::copyBuffersToCore(SampleFrame* lmmsBuf,
 
 
 
+void Audio::mixBuffersToCore(SampleFrame* lmmsBuf,
+	unsigned channel, fpp_t frames, float dry, float wet) const
+{
+	for (std::size_t f = 0; f < static_cast<unsigned>(frames); ++f)
+	{
+		lmmsBuf[f][channel] = lmmsBuf[f][channel] * dry + m_buffer[f] * wet;
+	}
+}
+
+
+
+
 void AtomSeq::Lv2EvbufDeleter::operator()(LV2_Evbuf *n) { lv2_evbuf_free(n); }
 
 
@@ -26,9 +26,12 @@
 
 #ifdef LMMS_HAVE_LV2
 
+#include <algorithm>
 #include <cmath>
+#include <utility>
 #include <lv2/midi/midi.h>
 #include <lv2/atom/atom.h>
+#include <lv2/buf-size/buf-size.h>
 #include <lv2/resize-port/resize-port.h>
 #include <lv2/worker/worker.h>
 #include <QDebug>
@@ -85,7 +88,7 @@ Plugin::Type Lv2Proc::check(const LilvPlugin *plugin,
 			(!Lv2Manager::wantUi() &&
 			Lv2Manager::pluginIsOnlyUsefulWithUi(pluginUri)) ||
 			// plugin unstable with 32 or less fpp?
-			(Engine::audioEngine()->framesPerPeriod() <= 32 &&
+			(Engine::audioEngine()->maxFramesPerPeriod() <= 32 &&
 			Lv2Manager::pluginIsUnstableWithBuffersizeLessEqual32(pluginUri)) )
 		{
 			issues.emplace_back(PluginIssueType::Blocked);
@@ -195,8 +198,18 @@ Lv2Proc::Lv2Proc(const LilvPlugin *plugin, Model* parent) :
 	m_plugin(plugin),
 	m_workLock(1),
 	m_midiInputBuf(m_maxMidiInputEvents),
-	m_midiInputReader(m_midiInputBuf)
+	m_midiInputReader(m_midiInputBuf),
+	m_midiInputBytes(m_maxMidiInputEvents),
+	m_midiInputAtoms(m_maxMidiInputEvents)
 {
+	Lv2Manager* mgr = Engine::getLv2Manager();
+	for (const char* feature : {LV2_BUF_SIZE__fixedBlockLength, LV2_BUF_SIZE__powerOf2BlockLength})
+	{
+		AutoLilvNode featureNode(mgr->uri(feature));
+		m_fixedBlockLength = m_fixedBlockLength || lilv_plugin_has_feature(m_plugin, featureNode.get());
+	}
+	if (m_fixedBlockLength) { Engine::audioEngine()->holdFramesPerPeriod(); }
+
 	createPorts();
 	initPlugin();
 }
@@ -204,7 +217,11 @@ Lv2Proc::Lv2Proc(const LilvPlugin *plugin, Model* parent) :
 
 
 
-Lv2Proc::~Lv2Proc() { shutdownPlugin(); }
+Lv2Proc::~Lv2Proc()
+{
+	shutdownPlugin();
+	if (m_fixedBlockLength) { Engine::audioEngine()->releaseFramesPerPeriod(); }
+}
 
 
 
@@ -244,8 +261,16 @@ void Lv2Proc::copyModelsFromCore()
 
 	struct Copy : public Lv2Ports::Visitor
 	{
+		bool m_all; // in
+		// models without automation or controllers mostly keep their
+		// values, so skip reading them and writing the ports
+		bool changed(AutomatableModel& model) const
+		{
+			return model.isValueChanged() || m_all;
+		}
 		void visit(Lv2Ports::Control& ctrl) override
 		{
+			if (!changed(*ctrl.m_connectedModel)) { return; }
 			FloatFromModelVisitor ffm;
 			ffm.m_scalePointMap = &ctrl.m_scalePointMap;
 			ctrl.m_connectedModel->accept(ffm);
@@ -253,6 +278,7 @@ void Lv2Proc::copyModelsFromCore()
 		}
 		void visit(Lv2Ports::Cv& cv) override
 		{
+			if (!changed(*cv.m_connectedModel)) { return; }
 			FloatFromModelVisitor ffm;
 			ffm.m_scalePointMap = &cv.m_scalePointMap;
 			cv.m_connectedModel->accept(ffm);
@@ -264,6 +290,7 @@ void Lv2Proc::copyModelsFromCore()
 			lv2_evbuf_reset(atomPort.m_buf.get(), true);
 		}
 	} copy;
+	copy.m_all = std::exchange(m_copyAllModels, false);
 
 	// feed each input port with the respective data from the LMMS core
 	for (const std::unique_ptr<Lv2Ports::PortBase>& port : m_ports)
@@ -277,22 +304,37 @@ void Lv2Proc::copyModelsFromCore()
 	// send pending MIDI events to atom port
 	if(m_midiIn)
 	{
-		LV2_Evbuf_Iterator iter = lv2_evbuf_begin(m_midiIn->m_buf.get());
+		const uint32_t type = Engine::getLv2Manager()->
+			uridCache()[Lv2UridCache::Id::midi_MidiEvent];
+		const auto byTime = [](const LV2_Evbuf_Event& a, const LV2_Evbuf_Event& b) { return a.frames < b.frames; };
+
 		// MIDI events waiting to go to the plugin?
-		while(m_midiInputReader.read_space() > 0)
+		const auto count = std::min(m_midiInputReader.read_space(), m_midiInputAtoms.size());
+		const auto events = m_midiInputReader.read(count);
+		const auto atoms = m_midiInputAtoms.begin();
+		std::size_t converted = 0;
+		for (std::size_t i = 0; i < count; ++i)
 		{
-			const MidiInputEvent ev = m_midiInputReader.read(1)[0];
-			uint32_t atomStamp =
-				ev.time.frames(Engine::framesPerTick()) + ev.offset;
-			uint32_t type = Engine::getLv2Manager()->
-				uridCache()[Lv2UridCache::Id::midi_MidiEvent];
-			auto buf = std::array<uint8_t, 4>{};
-			std::size_t bufsize = writeToByteSeq(ev.ev, buf.data(), buf.size());
-			if(bufsize)
-			{
-				lv2_evbuf_write(&iter, atomStamp, type, bufsize, buf.data());
-			}
+			const MidiInputEvent& ev = events[i];
+			auto& bytes = m_midiInputBytes[converted];
+			const std::size_t size = writeToByteSeq(ev.ev, bytes.data(), bytes.size());
+			if (!size) { continue; }
+
+			// events from different sources arrive in any order, but a
+			// sequence must be sorted by time, so each one is inserted where
+			// it belongs, which is cheap as they are mostly sorted already
+			const auto atom = LV2_Evbuf_Event{
+				static_cast<uint32_t>(ev.time.frames(Engine::framesPerTick()) + ev.offset),
+				type, static_cast<uint32_t>(size), bytes.data()};
+			const auto pos = std::upper_bound(atoms, atoms + converted, atom, byTime);
+			std::move_backward(pos, atoms + converted, atoms + converted + 1);
+			*pos = atom;
+			++converted;
 		}
+
+		// the buffer has room for all the events the ringbuffer can hold
+		LV2_Evbuf_Iterator iter = lv2_evbuf_begin(m_midiIn->m_buf.get());
+		lv2_evbuf_write_events(&iter, m_midiInputAtoms.data(), static_cast<uint32_t>(converted));
 	}
 }
 
@@ -368,6 +410,23 @@ void Lv2Proc::copyBuffersToCore(SampleFrame* buf,
 
 
 
+void Lv2Proc::mixBuffersToCore(SampleFrame* buf,
+								unsigned firstChan, unsigned num,
+								fpp_t frames, float dry, float wet) const
+{
+	outPorts().m_left->mixBuffersToCore(buf, firstChan + 0, frames, dry, wet);
+	if (num > 1)
+	{
+		// duplicate mono output, see copyBuffersToCore()
+		Lv2Ports::Audio* ap = outPorts().m_right
+			? outPorts().m_right : outPorts().m_left;
+		ap->mixBuffersToCore(buf, firstChan + 1, frames, dry, wet);
+	}
+}
+
+
+
+
 void Lv2Proc::run(fpp_t frames)
 {
 	if (m_worker)
@@ -509,13 +568,18 @@ void Lv2Proc::initMOptions()
 		executed again, creating a new option vector.
 	*/
 	float sampleRate = Engine::audioEngine()->outputSampleRate();
-	int32_t blockLength = Engine::audioEngine()->framesPerPeriod();
-	int32_t sequenceSize = defaultEvbufSize();
+	int32_t blockLength = Engine::audioEngine()->maxFramesPerPeriod();
+	// shorter periods are only rendered if the plugin can handle them
+	int32_t minBlockLength = m_fixedBlockLength
+		? blockLength
+		: std::min<int32_t>(MINIMUM_BUFFER_SIZE, blockLength);
+	// the largest of the atom port buffers, see createPort()
+	int32_t sequenceSize = m_sequenceSize;
 
 	using Id = Lv2UridCache::Id;
 	m_options.initOption<float>(Id::param_sampleRate, sampleRate);
 	m_options.initOption<int32_t>(Id::bufsz_maxBlockLength, blockLength);
-	m_options.initOption<int32_t>(Id::bufsz_minBlockLength, blockLength);
+	m_options.initOption<int32_t>(Id::bufsz_minBlockLength, minBlockLength);
 	m_options.initOption<int32_t>(Id::bufsz_nominalBlockLength, blockLength);
 	m_options.initOption<int32_t>(Id::bufsz_sequenceSize, sequenceSize);
 	m_options.createOptionVectors();
@@ -655,7 +719,7 @@ void Lv2Proc::createPort(std::size_t portNum)
 		}
 		case Lv2Ports::Type::Audio:
 		{
-			auto audio = new Lv2Ports::Audio(static_cast<std::size_t>(Engine::audioEngine()->framesPerPeriod()),
+			auto audio = new Lv2Ports::Audio(static_cast<std::size_t>(Engine::audioEngine()->maxFramesPerPeriod()),
 				portIsSideChain(m_plugin, lilvPort));
 			port = audio;
 			break;
@@ -693,10 +757,21 @@ void Lv2Proc::createPort(std::size_t portNum)
 				}
 			}
 
+			// MIDI input must fit all the events queued during a period,
+			// 3 bytes at most each (see writeToByteSeq)
+			if (meta.m_flow == Lv2Ports::Flow::Input && (atomPort->flags & Lv2Ports::AtomSeq::FlagType::Midi))
+			{
+				minimumSize = std::max(minimumSize,
+					static_cast<int>(lv2_evbuf_capacity_for(m_maxMidiInputEvents, 3)));
+			}
+
 			atomPort->m_buf.reset(
 				lv2_evbuf_new(static_cast<uint32_t>(minimumSize),
 								mgr->uridMap().map(LV2_ATOM__Chunk),
 								mgr->uridMap().map(LV2_ATOM__Sequence)));
+			// told to the plugin as the size of sequences (bufsz:sequenceSize)
+			m_sequenceSize = std::max(m_sequenceSize,
+				static_cast<int32_t>(lv2_evbuf_get_capacity(atomPort->m_buf.get())));
 
 			port = atomPort;
 			break;
@@ -802,6 +877,7 @@ void Lv2Proc::createPorts()
 	}
 
 	// initially assign model values to port values
+	m_copyAllModels = true;
 	copyModelsFromCore();
 
 	// debugging:
@@ -27,6 +27,10 @@
 
 #ifdef LMMS_HAVE_LV2
 
+#include <bit>
+#include <cstring>
+#include <string_view>
+
 namespace lmms
 {
 
@@ -43,64 +47,111 @@ static const char* staticUnmap(LV2_URID_Unmap_Handle handle, LV2_URID urid)
 	return map->unmap(urid);
 }
 
+//! The chunk of the unmap table holding @p index, and the position in it
+static std::pair<std::size_t, std::size_t> unmapPosition(std::size_t index, std::size_t firstChunkSize)
+{
+	const auto chunk = static_cast<std::size_t>(std::bit_width(index / firstChunkSize + 1)) - 1;
+	return {chunk, index - firstChunkSize * ((std::size_t{1} << chunk) - 1)};
+}
+
 UridMap::UridMap()
 {
+	m_tables.push_back(std::make_unique<Table>(1024));
+	m_table.store(m_tables.back().get(), std::memory_order_release);
+
 	m_mapFeature.handle = static_cast<LV2_URID_Map_Handle>(this);
 	m_mapFeature.map = staticMap;
 	m_unmapFeature.handle = static_cast<LV2_URID_Unmap_Handle>(this);
 	m_unmapFeature.unmap = staticUnmap;
 }
 
+LV2_URID UridMap::find(const Table& table, const char* uri, std::size_t hash)
+{
+	const std::size_t mask = table.slots.size() - 1;
+	for (std::size_t i = hash & mask;; i = (i + 1) & mask)
+	{
+		const Slot& slot = table.slots[i];
+		const char* slotUri = slot.uri.load(std::memory_order_acquire);
+		if (slotUri == nullptr) { return 0u; }
+		if (std::strcmp(slotUri, uri) == 0) { return slot.urid.load(std::memory_order_relaxed); }
+	}
+}
+
+void UridMap::insert(Table& table, const char* uri, std::size_t hash, LV2_URID urid)
+{
+	const std::size_t mask = table.slots.size() - 1;
+	std::size_t i = hash & mask;
+	while (table.slots[i].uri.load(std::memory_order_relaxed) != nullptr) { i = (i + 1) & mask; }
+	table.slots[i].urid.store(urid, std::memory_order_relaxed);
+	table.slots[i].uri.store(uri, std::memory_order_release);
+}
+
 LV2_URID UridMap::map(const char *uri)
 {
+	const auto hash = std::hash<std::string_view>{}(uri);
+
+	// fast path, without locking nor allocating
+	if (const auto result = find(*m_table.load(std::memory_order_acquire), uri, hash)) { return result; }
+
 	LV2_URID result = 0u;
 
 	// the Lv2 docs say that 0 should be returned in any case
 	// where creating an ID for the given URI fails
 	try
 	{
-		// TODO:
-		// when using C++14, we can get around any string allocation
-		// in the case the URI is already inside the map:
-		// * use `m_map.find(uri)` instead of `m_map.find(uriStr)`
-		// * to avoid temporary string construction in the `find` call, create
-		//   m_map like this:
-		//   std::unordered_map<std::string, LV2_URID,
-		//     std::hash<std::string>, std::equal<>> m_map;
-		// * move the try block inside the case where the URI is not in the map
-		const std::string uriStr = uri;
-
 		std::lock_guard<std::mutex> guard (m_MapMutex);
 
-		auto itr = m_map.find(uriStr);
-		if (itr == m_map.end())
+		// another thread may have mapped it meanwhile
+		Table* table = m_table.load(std::memory_order_relaxed);
+		if ((result = find(*table, uri, hash))) { return result; }
+
+		// 1 is the first free URID
+		const auto index = m_uris.size();
+		const auto [chunk, offset] = unmapPosition(index, FirstChunkSize);
+		if (chunk >= ChunkCount) { return 0u; }
+
+		if (offset == 0)
 		{
-			// 1 is the first free URID
-			const auto index = static_cast<LV2_URID>(1u + m_unMap.size());
-			auto pr = m_map.emplace(std::move(uriStr), index);
-			if (pr.second)
+			const std::size_t chunkSize = FirstChunkSize << chunk;
+			m_unmapStorage.push_back(std::make_unique<std::atomic<const char*>[]>(chunkSize));
+			m_unmapChunks[chunk].store(m_unmapStorage.back().get(), std::memory_order_release);
+		}
+
+		if (2 * (m_uris.size() + 1) > table->slots.size())
+		{
+			auto grown = std::make_unique<Table>(2 * table->slots.size());
+			for (std::size_t i = 0; i < m_uris.size(); ++i)
 			{
-				m_unMap.emplace_back(pr.first->first.c_str());
-				result = index;
+				const char* mapped = m_uris[i].c_str();
+				insert(*grown, mapped, std::hash<std::string_view>{}(mapped), static_cast<LV2_URID>(i + 1));
 			}
+			table = grown.get();
+			m_tables.push_back(std::move(grown));
+			m_table.store(table, std::memory_order_release);
 		}
-		else { result = itr->second; }
+
+		const char* stored = m_uris.emplace_back(uri).c_str();
+		result = static_cast<LV2_URID>(index + 1);
+		m_unmapChunks[chunk].load(std::memory_order_relaxed)[offset].store(stored, std::memory_order_release);
+		insert(*table, stored, hash, result);
 	}
-	catch(...) { /* result variable is already 0 */ }
+	catch(...) { result = 0u; }
 
 	return result;
 }
 
 const char *UridMap::unmap(LV2_URID urid)
 {
-	std::size_t idx = static_cast<std::size_t>(urid) - 1;
+	if (urid == 0u) { return nullptr; }
+
+	const auto [chunk, offset] = unmapPosition(static_cast<std::size_t>(urid) - 1, FirstChunkSize);
+	if (chunk >= ChunkCount) { return nullptr; }
 
-	std::lock_guard<std::mutex> guard (m_MapMutex);
-	return (idx < m_unMap.size()) ? m_unMap[idx] : nullptr;
+	const auto uris = m_unmapChunks[chunk].load(std::memory_order_acquire);
+	return uris ? uris[offset].load(std::memory_order_acquire) : nullptr;
 }
 
 
 } // namespace lmms
 
 #endif // LMMS_HAVE_LV2
-
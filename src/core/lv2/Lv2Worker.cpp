@@ -24,10 +24,19 @@
 
 #include "Lv2Worker.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
 
 #ifdef LMMS_HAVE_LV2
 
+#include "denormals.h"
+#include "Engine.h"
+#include "Song.h"
 
 
 namespace lmms
@@ -47,6 +56,114 @@ staticWorkerRespond(LV2_Worker_Respond_Handle handle,
 
 
 
+/**
+	Threads running the requests of all threaded workers
+
+	The audio thread only writes a request into the worker's ringbuffer and
+	posts a semaphore. A woken pool thread then claims a worker with queued
+	requests and runs all of them, so no two threads work for the same
+	worker at a time.
+*/
+class Lv2WorkerPool
+{
+public:
+	static Lv2WorkerPool& instance()
+	{
+		static Lv2WorkerPool pool;
+		return pool;
+	}
+
+	~Lv2WorkerPool()
+	{
+		m_exit = true;
+		for (std::size_t i = 0; i < m_threads.size(); ++i) { m_sem.post(); }
+		for (auto& thread : m_threads) { thread.join(); }
+	}
+
+	void add(Lv2Worker* worker)
+	{
+		const auto lock = std::lock_guard{m_mutex};
+		m_workers.push_back(worker);
+	}
+
+	//! Remove @p worker, waiting for a thread still working for it
+	void remove(Lv2Worker* worker)
+	{
+		auto lock = std::unique_lock{m_mutex};
+		m_workers.erase(std::find(m_workers.begin(), m_workers.end(), worker));
+		m_released.wait(lock, [worker] { return !worker->m_busy; });
+	}
+
+	//! Whether no thread works or is about to work for @p worker
+	bool isIdle(const Lv2Worker* worker)
+	{
+		const auto lock = std::lock_guard{m_mutex};
+		return !worker->m_busy && !worker->hasRequests();
+	}
+
+	//! Let a thread look for queued requests, realtime safe
+	void notify() { m_sem.post(); }
+
+private:
+	Lv2WorkerPool() :
+		m_sem(0)
+	{
+		// requests mostly load files, so a few threads are enough to keep
+		// one slow request from holding up the other workers
+		const auto numThreads = std::clamp(std::thread::hardware_concurrency(), 1u, 4u);
+		for (unsigned i = 0; i < numThreads; ++i)
+		{
+			m_threads.emplace_back(&Lv2WorkerPool::run, this);
+		}
+	}
+
+	void run()
+	{
+		// plugins may process audio in their work, e.g. to prepare samples
+		disable_denormals();
+
+		while (true)
+		{
+			m_sem.wait();
+			if (m_exit) { break; }
+
+			Lv2Worker* worker = nullptr;
+			{
+				const auto lock = std::lock_guard{m_mutex};
+				const auto it = std::find_if(m_workers.begin(), m_workers.end(),
+					[](const Lv2Worker* w) { return !w->m_busy && w->hasRequests(); });
+				// otherwise, another thread has taken care of the request
+				if (it == m_workers.end()) { continue; }
+				worker = *it;
+				worker->m_busy = true;
+			}
+
+			worker->workOnRequests();
+
+			bool moreRequests;
+			{
+				const auto lock = std::lock_guard{m_mutex};
+				// requests scheduled while we were working may have woken a
+				// thread that skipped the worker because it was busy
+				moreRequests = worker->hasRequests();
+				worker->m_busy = false;
+			}
+			m_released.notify_all();
+			if (moreRequests) { notify(); }
+		}
+	}
+
+	std::vector<std::thread> m_threads;
+	std::vector<Lv2Worker*> m_workers;
+	std::mutex m_mutex; //!< guards m_workers and their m_busy flags
+	std::condition_variable m_released;
+	Semaphore m_sem;
+	std::atomic<bool> m_exit = false;
+};
+
+
+
+
 std::size_t Lv2Worker::bufferSize() const
 {
 	// ardour uses this fixed size for ALSA:
@@ -60,12 +177,14 @@ std::size_t Lv2Worker::bufferSize() const
 
 Lv2Worker::Lv2Worker(Semaphore* commonWorkLock, bool threaded) :
 	m_threaded(threaded),
+	m_request(bufferSize()),
 	m_response(bufferSize()),
+	m_scheduled(bufferSize()),
+	m_responded(bufferSize()),
 	m_requests(bufferSize()),
 	m_responses(bufferSize()),
 	m_requestsReader(m_requests),
 	m_responsesReader(m_responses),
-	m_sem(0),
 	m_workLock(commonWorkLock)
 {
 	m_scheduleFeature.handle = static_cast<LV2_Worker_Schedule_Handle>(this);
@@ -76,7 +195,7 @@ Lv2Worker::Lv2Worker(Semaphore* commonWorkLock, bool threaded) :
 			return worker->scheduleWork(size, data);
 		};
 
-	if (threaded) { m_thread = std::thread(&Lv2Worker::workerFunc, this); }
+	if (threaded) { Lv2WorkerPool::instance().add(this); }
 
 	m_requests.mlock();
 	m_responses.mlock();
@@ -105,11 +224,24 @@ void Lv2Worker::setInterface(const LV2_Worker_Interface* newInterface)
 
 Lv2Worker::~Lv2Worker()
 {
-	m_exit = true;
-	if(m_threaded) {
-		m_sem.post();
-		m_thread.join();
+	if (m_threaded) { Lv2WorkerPool::instance().remove(this); }
+}
+
+
+
+
+LV2_Worker_Status Lv2Worker::write(LocklessRingBuffer<char>& ring, std::vector<char>& buf,
+	uint32_t size, const void* data)
+{
+	const std::size_t total = sizeof(size) + size;
+	if (ring.free() < total || buf.size() < total)
+	{
+		return LV2_WORKER_ERR_NO_SPACE;
 	}
+	std::memcpy(buf.data(), &size, sizeof(size));
+	if (size && data) { std::memcpy(buf.data() + sizeof(size), data, size); }
+	ring.write(buf.data(), total);
+	return LV2_WORKER_SUCCESS;
 }
 
 
@@ -118,51 +250,32 @@ Lv2Worker::~Lv2Worker()
 // Let the worker send responses to the audio thread
 LV2_Worker_Status Lv2Worker::respond(uint32_t size, const void* data)
 {
-	if(m_threaded)
-	{
-		if(m_responses.free() < sizeof(size) + size)
-		{
-			return LV2_WORKER_ERR_NO_SPACE;
-		}
-		else
-		{
-			m_responses.write((const char*)&size, sizeof(size));
-			if(size && data) { m_responses.write((const char*)data, size); }
-		}
-	}
-	else
+	if (m_inline)
 	{
 		assert(m_handle);
 		assert(m_interface);
 		m_interface->work_response(m_handle, size, data);
+		return LV2_WORKER_SUCCESS;
 	}
-	return LV2_WORKER_SUCCESS;
+	return write(m_responses, m_responded, size, data);
 }
 
 
 
 
-// Let the worker receive work from the audio thread and "work" on it
-void Lv2Worker::workerFunc()
+// Let a pool thread "work" on the requests the audio thread has queued
+void Lv2Worker::workOnRequests()
 {
-	std::vector<char> buf;
 	uint32_t size;
-	while (true) {
-		m_sem.wait();
-		if (m_exit) { break; }
-
-		const std::size_t readSpace = m_requestsReader.read_space();
-		if (readSpace <= sizeof(size)) { continue; } // (should not happen)
-
+	while (m_requestsReader.read_space() >= sizeof(size))
+	{
 		m_requestsReader.read(sizeof(size)).copy((char*)&size, sizeof(size));
-		assert(size <= readSpace - sizeof(size));
-		if(size > buf.size()) { buf.resize(size); }
-		if(size) { m_requestsReader.read(size).copy(buf.data(), size); }
+		if (size) { m_requestsReader.read(size).copy(m_request.data(), size); }
 
 		assert(m_handle);
 		assert(m_interface);
 		m_workLock->wait();
-		m_interface->work(m_handle, staticWorkerRespond, this, size, buf.data());
+		m_interface->work(m_handle, staticWorkerRespond, this, size, m_request.data());
 		m_workLock->post();
 	}
 }
@@ -170,34 +283,37 @@ void Lv2Worker::workerFunc()
 
 
 
+void Lv2Worker::workInline(uint32_t size, const void* data)
+{
+	assert(m_handle);
+	assert(m_interface);
+	m_inline = true;
+	m_workLock->wait();
+	m_interface->work(m_handle, staticWorkerRespond, this, size, data);
+	m_workLock->post();
+	m_inline = false;
+}
+
+
+
+
 // Let the audio thread schedule work for the worker
 LV2_Worker_Status Lv2Worker::scheduleWork(uint32_t size, const void *data)
 {
-	if (m_threaded)
+	// when exporting, nobody waits for the audio thread, so run the request
+	// right away unless earlier ones are still queued
+	if (!m_threaded || (Engine::getSong()->isExporting()
+		&& Lv2WorkerPool::instance().isIdle(this)))
 	{
-		if(m_requests.free() < sizeof(size) + size)
-		{
-			return LV2_WORKER_ERR_NO_SPACE;
-		}
-		else
-		{
-			// Schedule a request to be executed by the worker thread
-			m_requests.write((const char*)&size, sizeof(size));
-			if(size && data) { m_requests.write((const char*)data, size); }
-			m_sem.post();
-		}
-	}
-	else
-	{
-		assert(m_handle);
-		assert(m_interface);
 		// Execute work immediately in this thread
-		m_workLock->wait();
-		m_interface->work(m_handle, staticWorkerRespond, this, size, data);
-		m_workLock->post();
+		workInline(size, data);
+		return LV2_WORKER_SUCCESS;
 	}
 
-	return LV2_WORKER_SUCCESS;
+	// Schedule a request to be executed by a pool thread
+	const LV2_Worker_Status status = write(m_requests, m_scheduled, size, data);
+	if (status == LV2_WORKER_SUCCESS) { Lv2WorkerPool::instance().notify(); }
+	return status;
 }
 
 
@@ -30,8 +30,13 @@
 #include "denormals.h"
 
 #include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QDomDocument>
 #include <QFileInfo>
 #include <QLocale>
+#include <QProcess>
+#include <QThread>
 #include <QTimer>
 #include <QTranslator>
 #include <QApplication>
@@ -56,8 +61,11 @@
 #endif
 
 #include <csignal>  // To register the signal handler
+#include <deque>
+#include <memory>
 
 #include "MainApplication.h"
+#include "BinaryDataFile.h"
 #include "ConfigManager.h"
 #include "DataFile.h"
 #include "NotePlayHandle.h"
@@ -66,11 +74,17 @@
 #include "GuiApplication.h"
 #include "ImportFilter.h"
 #include "MainWindow.h"
+#include "MemoryReport.h"
 #include "MixHelpers.h"
 #include "OutputSettings.h"
+#include "PerfLog.h"
 #include "ProjectRenderer.h"
+#include "RenderFarm.h"
 #include "RenderManager.h"
+#include "RenderServer.h"
 #include "Song.h"
+#include "StartupScheduler.h"
+#include "XRunRecorder.h"
 
 #ifdef LMMS_DEBUG_FPE
 #include <fenv.h> // For feenableexcept
@@ -162,13 +176,30 @@ void printHelp()
 		"Usage: lmms [global options...] [<action> [action parameters...]]\n\n"
 		"Actions:\n"
 		"  <no action> [options...] [<project>]  Start LMMS in normal GUI mode\n"
-		"  dump <in>                             Dump XML of compressed file <in>\n"
+		"  dump <in>                             Dump XML of compressed or binary file <in>\n"
 		"  compress <in>                         Compress file <in>\n"
 		"  render <project> [options...]         Render given project file\n"
 		"  rendertracks <project> [options...]   Render each track to a different file\n"
+		"  renderworker [options...]             Render tracks for \"render --workers\"\n"
+		"                                        on other hosts\n"
+		"  renderserver [options...]             Render projects sent over a local socket\n"
+		"                                        one after another, see RenderServer.h\n"
 		"  upgrade <in> [out]                    Upgrade file <in> and save as <out>\n"
 		"                                        Standard out is used if no output file\n"
-		"                                        is specified\n"
+		"                                        is specified. Convert between XML and\n"
+		"                                        binary projects by giving <out> the\n"
+		"                                        extension .mmp, .mmpz or .mmpb\n"
+		"  upgrade --batch <dir>                 Upgrade all projects, templates and\n"
+		"                                        presets in <dir> and its subdirectories\n"
+		"                                        in place, in parallel processes\n"
+		"  profileload <project>                 Load the given project and print the\n"
+		"                                        time spent in each stage of loading\n"
+		"  memoryreport <project>                Load the given project and print the\n"
+		"                                        memory used by samples, plugins and\n"
+		"                                        the other parts of the engine\n"
+		"  exportmidi [-o <dir>] <project>...    Export the given projects to MIDI\n"
+		"                                        files, written next to each project\n"
+		"                                        or into <dir>\n"
 		"  makebundle <in> [out]                 Make a project bundle from the project\n"
 		"                                        file <in> saving the resulting bundle\n"
 		"                                        as <out>\n"
@@ -184,12 +215,22 @@ void printHelp()
 		"          geometry is <xsizexysize+xoffset+yoffsety>.\n"
 		"      --import <in> [-e]         Import MIDI or Hydrogen file <in>.\n"
 		"          If -e is specified lmms exits after importing the file.\n"
+		"      --xruns <out>              On exit, write the last periods which\n"
+		"          missed their deadline to <out>, with what took the time\n"
 		"\nOptions for \"render\" and \"rendertracks\":\n"
 		"  -a, --float                    Use 32bit float bit depth\n"
 		"  -b, --bitrate <bitrate>        Specify output bitrate in KBit/s\n"
 		"          Default: 160.\n"
+		"      --block-size <frames>      Render in blocks of <frames> frames,\n"
+		"          between %zu and %zu. Larger blocks render faster\n"
+		"          Default: %zu.\n"
+		"      --deterministic            Sum the tracks up in a fixed order, so\n"
+		"          the output doesn't depend on the number of threads\n"
 		"  -f, --format <format>         Specify format of render-output where\n"
 		"          Format is either 'wav', 'flac', 'ogg' or 'mp3'.\n"
+		"          Several formats separated by commas, e.g. 'wav,mp3',\n"
+		"          are encoded at the same time from one render pass.\n"
+		"          Each may set its own bitrate, e.g. 'wav,mp3:128,ogg:192'.\n"
 		"  -i, --interpolation <method>   Specify interpolation method\n"
 		"          Possible values:\n"
 		"            - linear\n"
@@ -208,12 +249,38 @@ void printHelp()
 		"          For \"rendertracks\", provide a directory path\n"
 		"          If not specified, render will overwrite the input file\n"
 		"          For \"rendertracks\", this might be required\n"
+		"      --oversampling <factor>    Render at <factor> times the sample rate\n"
+		"          and decimate the output, which reduces aliasing\n"
+		"          Possible values: 1, 2, 4, 8. Default: 1\n"
 		"  -p, --profile <out>            Dump profiling information to file <out>\n"
+		"          When starting the GUI, the time each step of starting up took\n"
+		"      --trace <out>              Write per-job timings to <out> in Chrome trace format\n"
+		"      --single-pass              For \"rendertracks\", render all tracks at once\n"
+		"          Files contain the output of the tracks before the mixer\n"
 		"  -s, --samplerate <samplerate>  Specify output samplerate in Hz\n"
 		"          Range: 44100 (default) to 192000\n"
 		"          Possible values: 1, 2, 4, 8\n"
-		"          Default: 2\n\n",
-		LMMS_VERSION, LMMS_PROJECT_COPYRIGHT );
+		"          Default: 2\n"
+		"      --workers <hosts>          For \"render\", render the instrument tracks\n"
+		"          on the given hosts running \"renderworker\", separated by commas,\n"
+		"          e.g. 'farm1,farm2:9000'. The hosts need the project and its\n"
+		"          samples at the same paths, and the same block size.\n"
+		"\nOptions for \"renderworker\":\n"
+		"      --block-size <frames>      Render in blocks of <frames> frames\n"
+		"      --deterministic            Sum the tracks up in a fixed order\n"
+		"      --listen <address>         Listen on the interface with <address>.\n"
+		"          Default: 127.0.0.1. Other interfaces than the loopback one need\n"
+		"          the same LMMS_RENDER_SECRET set for the worker and \"render\"\n"
+		"      --port <port>              Listen on <port>. Default: %u\n"
+		"\nOptions for \"renderserver\":\n"
+		"      --block-size <frames>      Render in blocks of <frames> frames\n"
+		"      --deterministic            Sum the tracks up in a fixed order\n"
+		"  -i, --interpolation <method>   Interpolation of the jobs, as for \"render\"\n"
+		"      --oversampling <factor>    Oversampling of the jobs, as for \"render\"\n"
+		"      --socket <name>            Listen on the local socket <name>. Default: %s\n\n",
+		LMMS_VERSION, LMMS_PROJECT_COPYRIGHT,
+		MINIMUM_BUFFER_SIZE, MAXIMUM_RENDER_BUFFER_SIZE, DEFAULT_BUFFER_SIZE,
+		static_cast<unsigned>(RenderWorker::DefaultPort), RenderServer::DefaultName );
 }
 
 
@@ -250,6 +317,61 @@ int noInputFileError()
 }
 
 
+
+
+int upgradeBatch(const QString& directory, bool allowRoot)
+{
+	if (!QFileInfo(directory).isDir())
+	{
+		return usageError(QString("%1 is not a directory").arg(directory));
+	}
+
+	QStringList files;
+	QDirIterator it(directory, {"*.mmp", "*.mmpz", "*.mmpb", "*.mpt", "*.xpf", "*.xptz"},
+		QDir::Files, QDirIterator::Subdirectories);
+	while (it.hasNext())
+	{
+		files.append(it.next());
+	}
+
+	// one process per file, so a file which crashes the upgrade doesn't
+	// stop the others, and as many at once as there are cores
+	const auto maxProcesses = static_cast<std::size_t>(std::max(QThread::idealThreadCount(), 1));
+	std::deque<std::pair<QString, std::unique_ptr<QProcess>>> running;
+	int failed = 0;
+
+	const auto finishOldest = [&running, &failed]
+	{
+		auto& [file, process] = running.front();
+		process->waitForFinished(-1);
+		if (process->exitStatus() != QProcess::NormalExit || process->exitCode() != EXIT_SUCCESS)
+		{
+			printf("Failed to upgrade %s\n", file.toUtf8().constData());
+			++failed;
+		}
+		running.pop_front();
+	};
+
+	for (const auto& file : files)
+	{
+		if (running.size() >= maxProcesses) { finishOldest(); }
+
+		QStringList arguments;
+		if (allowRoot) { arguments << "--allowroot"; }
+		arguments << "upgrade" << file << file;
+
+		auto process = std::make_unique<QProcess>();
+		process->setProcessChannelMode(QProcess::ForwardedChannels);
+		process->start(QCoreApplication::applicationFilePath(), arguments);
+		running.emplace_back(file, std::move(process));
+	}
+	while (!running.empty()) { finishOldest(); }
+
+	printf("Upgraded %d of %d files\n", files.size() - failed, files.size());
+	return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
 int main( int argc, char * * argv )
 {
 	using namespace lmms;
@@ -260,7 +382,20 @@ int main( int argc, char * * argv )
 	bool allowRoot = false;
 	bool renderLoop = false;
 	bool renderTracks = false;
-	QString fileToLoad, fileToImport, renderOut, profilerOutputFile, configFile;
+	bool renderSinglePass = false;
+	bool renderDeterministic = false;
+	bool renderWorker = false;
+	quint16 workerPort = RenderWorker::DefaultPort;
+	QHostAddress workerAddress = QHostAddress::LocalHost;
+	bool renderServer = false;
+	QString serverName = RenderServer::DefaultName;
+	QStringList renderWorkers;
+	fpp_t renderBlockSize = 0;
+	QString fileToLoad, fileToImport, renderOut, profilerOutputFile, traceOutputFile, xrunOutputFile, configFile;
+	QString fileToProfile;
+	QString fileToReportMemory;
+	QStringList filesToExportMidi;
+	QString midiExportDir;
 
 	// first of two command-line parsing stages
 	for (int i = 1; i < argc; ++i)
@@ -286,6 +421,28 @@ int main( int argc, char * * argv )
 			coreOnly = true;
 			renderTracks = true;
 		}
+		else if (arg == "renderworker")
+		{
+			coreOnly = true;
+			renderWorker = true;
+		}
+		else if (arg == "renderserver")
+		{
+			coreOnly = true;
+			renderServer = true;
+		}
+		else if (arg == "profileload" || arg == "--profile-load")
+		{
+			coreOnly = true;
+		}
+		else if (arg == "memoryreport" || arg == "--memory-report")
+		{
+			coreOnly = true;
+		}
+		else if (arg == "exportmidi")
+		{
+			coreOnly = true;
+		}
 		else if (arg == "--allowroot")
 		{
 			allowRoot = true;
@@ -378,6 +535,9 @@ int main( int argc, char * * argv )
 	AudioEngine::qualitySettings qs(AudioEngine::qualitySettings::Interpolation::Linear);
 	OutputSettings os(44100, 160, OutputSettings::BitDepth::Depth16Bit, OutputSettings::StereoMode::JointStereo);
 	ProjectRenderer::ExportFileFormat eff = ProjectRenderer::ExportFileFormat::Wave;
+	// formats encoded alongside eff, with their own bitrate or 0 for the one of os
+	std::vector<std::pair<ProjectRenderer::ExportFileFormat, int>> extraFormats;
+	int mainFormatBitrate = 0;
 
 	// second of two command-line parsing stages
 	for( int i = 1; i < argc; ++i )
@@ -393,12 +553,29 @@ int main( int argc, char * * argv )
 				return noInputFileError();
 			}
 
+			if (QString(argv[i]) == "--batch")
+			{
+				if (++i == argc)
+				{
+					return usageError("No directory specified");
+				}
+				return upgradeBatch(QString::fromLocal8Bit(argv[i]), allowRoot);
+			}
 
 			DataFile dataFile( QString::fromLocal8Bit( argv[i] ) );
+			if (dataFile.documentElement().isNull())
+			{
+				// don't replace a file which couldn't be read with an empty one
+				printf("Could not load %s\n", argv[i]);
+				return EXIT_FAILURE;
+			}
 
 			if( argc > i+1 ) // output file specified
 			{
-				dataFile.writeFile( QString::fromLocal8Bit( argv[i+1] ) );
+				if (!dataFile.writeFile(QString::fromLocal8Bit(argv[i+1])))
+				{
+					return EXIT_FAILURE;
+				}
 			}
 			else // no output file specified; use stdout
 			{
@@ -454,7 +631,22 @@ int main( int argc, char * * argv )
 
 			QFile f( QString::fromLocal8Bit( argv[i] ) );
 			f.open( QIODevice::ReadOnly );
-			QString d = qUncompress( f.readAll() );
+			const QByteArray data = f.readAll();
+			QString d;
+			if( BinaryDataFile::isBinary( data ) )
+			{
+				QDomDocument doc;
+				QString error;
+				if( !BinaryDataFile::decode( data, doc, &error ) )
+				{
+					return usageError( error );
+				}
+				d = doc.toString( 2 );
+			}
+			else
+			{
+				d = qUncompress( data );
+			}
 			printf( "%s\n", d.toUtf8().constData() );
 
 			return EXIT_SUCCESS;
@@ -489,10 +681,141 @@ int main( int argc, char * * argv )
 			fileToLoad = QString::fromLocal8Bit( argv[i] );
 			renderOut = fileToLoad;
 		}
+		else if (arg == "exportmidi")
+		{
+			// everything after the action is its own
+			for (++i; i < argc; ++i)
+			{
+				if (QString(argv[i]) == "-o" || QString(argv[i]) == "--output")
+				{
+					if (++i == argc)
+					{
+						return usageError("No output directory specified");
+					}
+					midiExportDir = QString::fromLocal8Bit(argv[i]);
+				}
+				else
+				{
+					filesToExportMidi << QString::fromLocal8Bit(argv[i]);
+				}
+			}
+			if (filesToExportMidi.isEmpty())
+			{
+				return noInputFileError();
+			}
+		}
+		else if (arg == "profileload" || arg == "--profile-load")
+		{
+			++i;
+
+			if (i == argc)
+			{
+				return noInputFileError();
+			}
+
+			fileToProfile = QString::fromLocal8Bit(argv[i]);
+			fileToLoad = fileToProfile;
+		}
+		else if (arg == "memoryreport" || arg == "--memory-report")
+		{
+			++i;
+
+			if (i == argc)
+			{
+				return noInputFileError();
+			}
+
+			fileToReportMemory = QString::fromLocal8Bit(argv[i]);
+			fileToLoad = fileToReportMemory;
+		}
 		else if( arg == "--loop" || arg == "-l" )
 		{
 			renderLoop = true;
 		}
+		else if (arg == "--single-pass")
+		{
+			renderSinglePass = true;
+		}
+		else if (arg == "--deterministic")
+		{
+			renderDeterministic = true;
+		}
+		else if (arg == "renderworker" || arg == "renderserver")
+		{
+			// handled in the first stage
+		}
+		else if (arg == "--socket")
+		{
+			++i;
+
+			if (i == argc)
+			{
+				return usageError("No socket name specified");
+			}
+
+			serverName = QString::fromLocal8Bit(argv[i]);
+		}
+		else if (arg == "--listen")
+		{
+			++i;
+
+			if (i == argc)
+			{
+				return usageError("No address specified");
+			}
+
+			if (!workerAddress.setAddress(QString(argv[i])))
+			{
+				return usageError(QString("Invalid address %1").arg(argv[i]));
+			}
+		}
+		else if (arg == "--port")
+		{
+			++i;
+
+			if (i == argc)
+			{
+				return usageError("No port specified");
+			}
+
+			bool valid = false;
+			workerPort = QString(argv[i]).toUShort(&valid);
+			if (!valid || workerPort == 0)
+			{
+				return usageError(QString("Invalid port %1").arg(argv[i]));
+			}
+		}
+		else if (arg == "--workers")
+		{
+			++i;
+
+			if (i == argc)
+			{
+				return usageError("No workers specified");
+			}
+
+			renderWorkers = QString(argv[i]).split(',');
+			renderWorkers.removeAll(QString{});
+		}
+		else if (arg == "--block-size")
+		{
+			++i;
+
+			if (i == argc)
+			{
+				return usageError("No block size specified");
+			}
+
+			const auto blockSize = QString(argv[i]).toUInt();
+			if (blockSize >= MINIMUM_BUFFER_SIZE && blockSize <= MAXIMUM_RENDER_BUFFER_SIZE)
+			{
+				renderBlockSize = blockSize;
+			}
+			else
+			{
+				return usageError(QString("Invalid block size %1").arg(argv[i]));
+			}
+		}
 		else if( arg == "--output" || arg == "-o" )
 		{
 			++i;
@@ -515,31 +838,56 @@ int main( int argc, char * * argv )
 			}
 
 
-			const QString ext = QString( argv[i] );
+			// the first format is the main one, the others are encoded alongside
+			const QStringList exts = QString( argv[i] ).split( ',' );
+			extraFormats.clear();
 
-			if( ext == "wav" )
+			for( int e = 0; e < exts.size(); ++e )
 			{
-				eff = ProjectRenderer::ExportFileFormat::Wave;
-			}
+				// each format may carry its own bitrate, e.g. "mp3:128"
+				const QString ext = exts[e].section( ':', 0, 0 );
+				int formatBitrate = 0;
+				if( exts[e].contains( ':' ) )
+				{
+					formatBitrate = exts[e].section( ':', 1 ).toInt();
+					if( formatBitrate < 64 || formatBitrate > 384 )
+					{
+						return usageError( QString( "Invalid bitrate in %1" ).arg( exts[e] ) );
+					}
+				}
+				ProjectRenderer::ExportFileFormat format;
+
+				if( ext == "wav" )
+				{
+					format = ProjectRenderer::ExportFileFormat::Wave;
+				}
 #ifdef LMMS_HAVE_OGGVORBIS
-			else if( ext == "ogg" )
-			{
-				eff = ProjectRenderer::ExportFileFormat::Ogg;
-			}
+				else if( ext == "ogg" )
+				{
+					format = ProjectRenderer::ExportFileFormat::Ogg;
+				}
 #endif
 #ifdef LMMS_HAVE_MP3LAME
-			else if( ext == "mp3" )
-			{
-				eff = ProjectRenderer::ExportFileFormat::MP3;
-			}
+				else if( ext == "mp3" )
+				{
+					format = ProjectRenderer::ExportFileFormat::MP3;
+				}
 #endif
-			else if (ext == "flac")
-			{
-				eff = ProjectRenderer::ExportFileFormat::Flac;
-			}
-			else
-			{
-				return usageError( QString( "Invalid output format %1" ).arg( argv[i] ) );
+				else if (ext == "flac")
+				{
+					format = ProjectRenderer::ExportFileFormat::Flac;
+				}
+				else
+				{
+					return usageError( QString( "Invalid output format %1" ).arg( ext ) );
+				}
+
+				if( e == 0 )
+				{
+					eff = format;
+					mainFormatBitrate = formatBitrate;
+				}
+				else { extraFormats.emplace_back( format, formatBitrate ); }
 			}
 		}
 		else if( arg == "--samplerate" || arg == "-s" )
@@ -648,6 +996,37 @@ int main( int argc, char * * argv )
 				return usageError( QString( "Invalid interpolation method %1" ).arg( argv[i] ) );
 			}
 		}
+		else if (arg == "--oversampling")
+		{
+			++i;
+
+			if (i == argc)
+			{
+				return usageError("No oversampling factor specified");
+			}
+
+			const auto factor = QString(argv[i]);
+			if (factor == "1")
+			{
+				qs.oversampling = AudioEngine::qualitySettings::Oversampling::None;
+			}
+			else if (factor == "2")
+			{
+				qs.oversampling = AudioEngine::qualitySettings::Oversampling::X2;
+			}
+			else if (factor == "4")
+			{
+				qs.oversampling = AudioEngine::qualitySettings::Oversampling::X4;
+			}
+			else if (factor == "8")
+			{
+				qs.oversampling = AudioEngine::qualitySettings::Oversampling::X8;
+			}
+			else
+			{
+				return usageError(QString("Invalid oversampling factor %1").arg(argv[i]));
+			}
+		}
 		else if( arg == "--import" )
 		{
 			++i;
@@ -678,6 +1057,28 @@ int main( int argc, char * * argv )
 
 			profilerOutputFile = QString::fromLocal8Bit( argv[i] );
 		}
+		else if (arg == "--trace")
+		{
+			++i;
+
+			if (i == argc)
+			{
+				return usageError("No trace file specified");
+			}
+
+			traceOutputFile = QString::fromLocal8Bit(argv[i]);
+		}
+		else if (arg == "--xruns")
+		{
+			++i;
+
+			if (i == argc)
+			{
+				return usageError("No xrun report file specified");
+			}
+
+			xrunOutputFile = QString::fromLocal8Bit(argv[i]);
+		}
 		else if( arg == "--config" || arg == "-c" )
 		{
 			++i;
@@ -699,6 +1100,11 @@ int main( int argc, char * * argv )
 		}
 	}
 
+	if (renderTracks && !renderWorkers.isEmpty())
+	{
+		return usageError("Only \"render\" can be distributed over several hosts");
+	}
+
 	// Test file argument before continuing
 	if( !fileToLoad.isEmpty() )
 	{
@@ -709,6 +1115,7 @@ int main( int argc, char * * argv )
 		fileCheck( fileToImport );
 	}
 
+	StartupScheduler::beginPhase("Loading configuration");
 	ConfigManager::inst()->loadConfigFile(configFile);
 
 	// Hidden settings
@@ -723,15 +1130,19 @@ int main( int argc, char * * argv )
 	}
 
 	// load actual translation for LMMS
+	StartupScheduler::beginPhase("Loading translations");
 	loadTranslation( pos );
 
-	// load translation for Qt-widgets/-dialogs
+	// load translation for Qt-widgets/-dialogs, which headless commands never show
+	if (!coreOnly)
+	{
 #ifdef QT_TRANSLATIONS_DIR
-	// load from the original path first
-	loadTranslation(QString("qt_") + pos, QT_TRANSLATIONS_DIR);
+		// load from the original path first
+		loadTranslation(QString("qt_") + pos, QT_TRANSLATIONS_DIR);
 #endif
-	// override it with bundled/custom one, if exists
-	loadTranslation(QString("qt_") + pos, ConfigManager::inst()->localeDir());
+		// override it with bundled/custom one, if exists
+		loadTranslation(QString("qt_") + pos, ConfigManager::inst()->localeDir());
+	}
 
 #if _POSIX_C_SOURCE >= 1 || _XOPEN_SOURCE || _POSIX_SOURCE
 	struct sigaction sa;
@@ -749,12 +1160,143 @@ int main( int argc, char * * argv )
 
 	bool destroyEngine = false;
 
+	// load the project without the GUI and print how long each stage took
+	if (!fileToProfile.isEmpty())
+	{
+		Engine::init(true);
+		Engine::getSong()->loadProject(fileToProfile);
+		PerfLogReport::waitForTimers();
+		printf("%s", PerfLogReport::toString().toUtf8().constData());
+
+		Engine::destroy();
+		delete app;
+		NotePlayHandleManager::free();
+		return EXIT_SUCCESS;
+	}
+
+	// load the project without the GUI and print where its memory goes
+	if (!fileToReportMemory.isEmpty())
+	{
+		Engine::init(true);
+		Engine::getSong()->loadProject(fileToReportMemory);
+		// samples decoded in the background are only complete then
+		PerfLogReport::waitForTimers();
+		printf("Memory report: %s\n\n%s", fileToReportMemory.toUtf8().constData(),
+			MemoryReport::collect().toString().toUtf8().constData());
+
+		Engine::destroy();
+		delete app;
+		NotePlayHandleManager::free();
+		return EXIT_SUCCESS;
+	}
+
+	// export each project to MIDI without the GUI, loading them one after another
+	if (!filesToExportMidi.isEmpty())
+	{
+		Engine::init(true);
+		int failures = 0;
+		for (const auto& file : filesToExportMidi)
+		{
+			const auto info = QFileInfo{file};
+			const auto outDir = QDir{midiExportDir.isEmpty() ? info.absolutePath() : midiExportDir};
+			const auto out = outDir.filePath(info.completeBaseName() + ".mid");
+
+			Engine::getSong()->loadProject(file);
+			if (Engine::getSong()->isEmpty() || !Engine::getSong()->exportProjectMidi(out))
+			{
+				printf("Failed to export %s\n", file.toUtf8().constData());
+				++failures;
+				continue;
+			}
+			printf("%s -> %s\n", file.toUtf8().constData(), out.toUtf8().constData());
+		}
+
+		Engine::destroy();
+		delete app;
+		NotePlayHandleManager::free();
+		return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	// once the engine is up, but before it renders anything
+	bool tracing = false;
+	const auto startTracing = [&] {
+		if (tracing || traceOutputFile.isEmpty()) { return; }
+		tracing = true;
+		if (!Engine::audioEngine()->profiler().startTracing(traceOutputFile))
+		{
+			printf("Could not open trace file %s\n", traceOutputFile.toUtf8().constData());
+		}
+	};
+
+	// render tracks for coordinators on other hosts until terminated
+	if (renderWorker)
+	{
+		if (renderBlockSize > 0)
+		{
+			ConfigManager::inst()->setValue("audioengine", "renderframesperperiod",
+				QString::number(renderBlockSize));
+		}
+		Engine::init(true);
+		destroyEngine = true;
+		if (renderBlockSize > 0)
+		{
+			// only meant for this process, don't save it to the configuration
+			ConfigManager::inst()->deleteValue("audioengine", "renderframesperperiod");
+		}
+		if (renderDeterministic) { Engine::audioEngine()->setDeterministic(true); }
+
+		auto worker = new RenderWorker(app);
+		if (!worker->listen(workerAddress, workerPort))
+		{
+			printf("Could not listen on %s port %u\n", qPrintable(workerAddress.toString()),
+				static_cast<unsigned>(workerPort));
+			return EXIT_FAILURE;
+		}
+		printf("Waiting for jobs on %s port %u\n", qPrintable(workerAddress.toString()),
+			static_cast<unsigned>(workerPort));
+	}
+	// render the projects sent by clients until terminated, without starting up again for each one
+	else if (renderServer)
+	{
+		if (renderBlockSize > 0)
+		{
+			ConfigManager::inst()->setValue("audioengine", "renderframesperperiod",
+				QString::number(renderBlockSize));
+		}
+		Engine::init(true);
+		destroyEngine = true;
+		if (renderBlockSize > 0)
+		{
+			// only meant for this process, don't save it to the configuration
+			ConfigManager::inst()->deleteValue("audioengine", "renderframesperperiod");
+		}
+		if (renderDeterministic) { Engine::audioEngine()->setDeterministic(true); }
+
+		auto server = new RenderServer(qs, app);
+		if (!server->listen(serverName))
+		{
+			printf("Could not listen on %s\n", qPrintable(serverName));
+			return EXIT_FAILURE;
+		}
+		printf("Waiting for jobs on %s\n", qPrintable(server->fullServerName()));
+	}
 	// if we have an output file for rendering, just render the song
 	// without starting the GUI
-	if( !renderOut.isEmpty() )
+	else if( !renderOut.isEmpty() )
 	{
+		if (renderBlockSize > 0)
+		{
+			ConfigManager::inst()->setValue("audioengine", "renderframesperperiod",
+				QString::number(renderBlockSize));
+		}
 		Engine::init( true );
 		destroyEngine = true;
+		if (renderBlockSize > 0)
+		{
+			// only meant for this render, don't save it to the configuration
+			ConfigManager::inst()->deleteValue("audioengine", "renderframesperperiod");
+		}
+		if (renderDeterministic) { Engine::audioEngine()->setDeterministic(true); }
 
 		printf( "Loading project...\n" );
 		Engine::getSong()->loadProject( fileToLoad );
@@ -775,8 +1317,22 @@ int main( int argc, char * * argv )
 				ProjectRenderer::getFileExtensionFromFormat(eff);
 		}
 
+		if (mainFormatBitrate > 0)
+		{
+			os.setBitrate(mainFormatBitrate);
+		}
+
 		// create renderer
 		auto r = new RenderManager(qs, os, eff, renderOut);
+		for (const auto& [format, bitrate] : extraFormats)
+		{
+			auto formatSettings = os;
+			if (bitrate > 0)
+			{
+				formatSettings.setBitrate(bitrate);
+			}
+			r->addFormat(format, formatSettings);
+		}
 		QCoreApplication::instance()->connect( r,
 				SIGNAL(finished()), SLOT(quit()));
 
@@ -791,11 +1347,27 @@ int main( int argc, char * * argv )
 			Engine::audioEngine()->profiler().setOutputFile( profilerOutputFile );
 		}
 
+		// the first periods have to be in the trace as well
+		startTracing();
+
 		// start now!
-		if ( renderTracks )
+		if ( renderTracks && renderSinglePass )
+		{
+			r->renderTracksSinglePass();
+		}
+		else if ( renderTracks )
 		{
 			r->renderTracks();
 		}
+		else if (!renderWorkers.isEmpty())
+		{
+			// the other hosts render the instrument tracks, the export mixes their output
+			// at the rate it renders at, which is higher when oversampling
+			auto coordinator = new RenderCoordinator(fileToLoad, renderWorkers, qs,
+				os.getSampleRate() * qs.oversamplingFactor(), r);
+			r->connect(coordinator, &RenderCoordinator::finished, r, &RenderManager::renderProject);
+			coordinator->start();
+		}
 		else
 		{
 			r->renderProject();
@@ -805,6 +1377,11 @@ int main( int argc, char * * argv )
 	{
 		using namespace lmms::gui;
 
+		if (!profilerOutputFile.isEmpty())
+		{
+			StartupScheduler::reportTo(profilerOutputFile);
+		}
+
 		new GuiApplication();
 
 		// re-intialize RNG - shared libraries might have srand() or
@@ -886,6 +1463,7 @@ int main( int argc, char * * argv )
 		}
 
 		// first show the Main Window and then try to load given file
+		StartupScheduler::beginPhase(MainWindow::tr("Showing main window"));
 
 		// [Settel] workaround: showMaximized() doesn't work with
 		// FVWM2 unless the window is already visible -> show() first
@@ -895,6 +1473,8 @@ int main( int argc, char * * argv )
 			getGUI()->mainWindow()->showMaximized();
 		}
 
+		StartupScheduler::beginPhase(MainWindow::tr("Loading project"));
+
 		// Handle macOS-style FileOpen QEvents
 		QString queuedFile = static_cast<MainApplication *>( app )->queuedFile();
 		if ( !queuedFile.isEmpty() ) {
@@ -954,11 +1534,30 @@ int main( int argc, char * * argv )
 		{
 			gui::getGUI()->mainWindow()->autoSaveTimerReset();
 		}
+
+		// the rest, like filling the file browsers, is done once the event
+		// loop runs
+		StartupScheduler::finish();
 	}
 
+	startTracing();
+
 	const int ret = app->exec();
 	delete app;
 
+	if (!xrunOutputFile.isEmpty())
+	{
+		const XRunRecorder* recorder = Engine::audioEngine()->xrunRecorder();
+		if (!recorder)
+		{
+			printf("Xruns are not recorded, as audioengine/xrunincidents is 0\n");
+		}
+		else if (!recorder->exportTo(xrunOutputFile))
+		{
+			printf("Could not write xrun report %s\n", xrunOutputFile.toUtf8().constData());
+		}
+	}
+
 	if( destroyEngine )
 	{
 		Engine::destroy();
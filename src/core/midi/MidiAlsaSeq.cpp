@@ -28,6 +28,8 @@
 #include "Song.h"
 #include "MidiPort.h"
 
+#include <algorithm>
+
 
 #ifdef LMMS_HAVE_ALSA
 
@@ -156,7 +158,25 @@ QString MidiAlsaSeq::probeDevice()
 
 
 
-void MidiAlsaSeq::processOutEvent( const MidiEvent& event, const TimePos& time, const MidiPort* port )
+void MidiAlsaSeq::processOutEvent( const MidiEvent& event, const TimePos&, const MidiPort* port )
+{
+	outputEvent( event, port, std::chrono::nanoseconds::zero() );
+}
+
+
+
+
+void MidiAlsaSeq::processOutEvent( const MidiEvent& event, const TimePos&, f_cnt_t offset, const MidiPort* port )
+{
+	const auto delay = outputTime( offset ) - std::chrono::steady_clock::now();
+	outputEvent( event, port, std::max( std::chrono::duration_cast<std::chrono::nanoseconds>( delay ),
+										std::chrono::nanoseconds::zero() ) );
+}
+
+
+
+
+void MidiAlsaSeq::outputEvent( const MidiEvent& event, const MidiPort* port, std::chrono::nanoseconds delay )
 {
 	// HACK!!! - need a better solution which isn't that easy since we
 	// cannot store const-ptrs in our map because we need to call non-const
@@ -168,7 +188,11 @@ void MidiAlsaSeq::processOutEvent( const MidiEvent& event, const TimePos& time,
 	snd_seq_ev_set_source( &ev, ( m_portIDs[p][1] != -1 ) ?
 					m_portIDs[p][1] : m_portIDs[p][0] );
 	snd_seq_ev_set_subs( &ev );
-	snd_seq_ev_schedule_tick( &ev, m_queueID, 1, static_cast<int>( time ) );
+	// relative to the queue's current time
+	snd_seq_real_time_t rt;
+	rt.tv_sec = static_cast<unsigned int>( delay.count() / 1000000000 );
+	rt.tv_nsec = static_cast<unsigned int>( delay.count() % 1000000000 );
+	snd_seq_ev_schedule_real( &ev, m_queueID, 1, &rt );
 	ev.queue =  m_queueID;
 	switch( event.type() )
 	{
@@ -26,14 +26,34 @@
 #include "MidiClient.h"
 
 #include <array>
+#include <chrono>
 
+#include "AudioEngine.h"
+#include "Engine.h"
+#include "MidiOutScheduler.h"
 #include "MidiPort.h"
 
 namespace lmms
 {
 
+namespace
+{
+
+// the audio thread walks the ports in processQueuedInEvents()
+AudioEngine::RequestChangesGuard portListGuard()
+{
+	// ports of the dummy client may go away after the engine
+	AudioEngine* audioEngine = Engine::audioEngine();
+	return audioEngine ? audioEngine->requestChangesGuard() : AudioEngine::RequestChangesGuard{};
+}
+
+} // namespace
+
+
 MidiClient::~MidiClient()
 {
+	stopOutScheduler();
+
 	//TODO: noteOffAll(); / clear all ports
 	for (MidiPort* port : m_midiPorts)
 	{
@@ -60,6 +80,7 @@ void MidiClient::applyPortName( MidiPort* )
 
 void MidiClient::addPort( MidiPort* port )
 {
+	const auto guard = portListGuard();
 	m_midiPorts.push_back( port );
 }
 
@@ -73,11 +94,91 @@ void MidiClient::removePort( MidiPort* port )
 		return;
 	}
 
+	const auto guard = portListGuard();
 	auto it = std::find(m_midiPorts.begin(), m_midiPorts.end(), port);
 	if( it != m_midiPorts.end() )
 	{
 		m_midiPorts.erase( it );
 	}
+
+	if( m_outScheduler )
+	{
+		m_outScheduler->removePort( port );
+	}
+}
+
+
+
+
+void MidiClient::processOutEvent( const MidiEvent& event, const TimePos& time, f_cnt_t offset,
+									const MidiPort* port )
+{
+	std::call_once( m_outSchedulerCreated, [this] {
+		m_outScheduler = std::make_unique<MidiOutScheduler>(
+			[this]( const MidiEvent& e, const TimePos& t, const MidiPort* p ) { processOutEvent( e, t, p ); } );
+	} );
+
+	if( m_outScheduler )
+	{
+		m_outScheduler->schedule( outputTime( offset ), event, time, port );
+	}
+	else
+	{
+		// stopped already
+		processOutEvent( event, time, port );
+	}
+}
+
+
+
+
+void MidiClient::stopOutScheduler()
+{
+	// make sure no scheduler gets created afterwards
+	std::call_once( m_outSchedulerCreated, [] {} );
+	m_outScheduler.reset();
+}
+
+
+
+
+std::chrono::steady_clock::time_point MidiClient::outputTime( f_cnt_t offset ) const
+{
+	using namespace std::chrono;
+
+	const auto periodStart = steady_clock::time_point( steady_clock::duration( m_periodStart.load() ) );
+	const sample_rate_t sampleRate = m_periodSampleRate.load();
+	if( sampleRate == 0 )
+	{
+		// no period rendered yet
+		return steady_clock::now();
+	}
+
+	// everything rendered in this period is played in the next one
+	const auto delay = duration<double>( static_cast<double>( m_periodFrames.load() + offset ) / sampleRate );
+	return periodStart + duration_cast<steady_clock::duration>( delay );
+}
+
+
+
+
+void MidiClient::processQueuedInEvents( fpp_t frames, sample_rate_t sampleRate )
+{
+	// the events were queued during the last period, play them back one period
+	// later, at the same distances from each other
+	const auto period = std::chrono::duration<double>( static_cast<double>( frames ) / sampleRate );
+	const auto now = std::chrono::steady_clock::now();
+	const auto periodStart = now - std::chrono::duration_cast<std::chrono::steady_clock::duration>( period );
+
+	// the events sent while rendering this period are timed from here
+	m_periodStart = now.time_since_epoch().count();
+	m_periodFrames = frames;
+	m_periodSampleRate = sampleRate;
+
+	for( MidiPort* port : m_midiPorts )
+	{
+		port->processQueuedInEvents( periodStart, frames, sampleRate );
+	}
 }
 
 
@@ -249,7 +350,7 @@ void MidiClientRaw::processParsedEvent()
 
 void MidiClientRaw::processOutEvent(const MidiEvent& event, const TimePos&, const MidiPort* port)
 {
-	// TODO: also evaluate _time and queue event if necessary
+	// called when the event is due, see MidiClient::processOutEvent()
 	switch (event.type())
 	{
 		case MidiNoteOn:
@@ -24,6 +24,8 @@
  */
 
 
+#include <algorithm>
+
 #include "AudioEngine.h"
 #include "MidiController.h"
 
@@ -48,19 +50,114 @@ MidiController::MidiController( Model * _parent ) :
 
 void MidiController::updateValueBuffer()
 {
-	if( m_previousValue != m_lastValue )
+	startRampPeriod();
+	processUnqueuedEvents();
+
+	if (m_rampPointCount == 0)
 	{
-		m_valueBuffer.interpolate( m_previousValue, m_lastValue );
-		m_previousValue = m_lastValue;
+		m_valueBuffer.fill(m_previousValue);
+		m_bufferLastUpdated = s_periods;
+		return;
 	}
-	else
+
+	// from one value received to the next, starting from where the last
+	// period ended and holding the last one until the end of this one
+	const auto frames = static_cast<f_cnt_t>(m_valueBuffer.length());
+	float* values = m_valueBuffer.values();
+	auto offset = f_cnt_t{0};
+	auto value = m_previousValue;
+	for (std::size_t i = 0; i < m_rampPointCount; ++i)
 	{
-		m_valueBuffer.fill( m_lastValue );
+		const auto& point = m_rampPoints[i];
+		const auto end = std::min(point.offset, frames);
+		const auto step = end > offset ? (point.value - value) / (end - offset) : 0.f;
+		for (auto frame = offset; frame < end; ++frame)
+		{
+			values[frame] = value + static_cast<float>(frame - offset) * step;
+		}
+		offset = end;
+		value = point.value;
 	}
+	std::fill(values + offset, values + frames, value);
+	m_valueBuffer.markVarying();
+
+	m_previousValue = value;
+	m_rampPointCount = 0;
 	m_bufferLastUpdated = s_periods;
 }
 
 
+
+
+bool MidiController::valueChangedInPeriod()
+{
+	return m_valueChangedInPeriod.exchange(false, std::memory_order_relaxed);
+}
+
+
+
+
+void MidiController::startRampPeriod()
+{
+	if (m_rampPeriod == s_periods) { return; }
+
+	if (m_rampPointCount > 0)
+	{
+		m_previousValue = m_rampPoints[m_rampPointCount - 1].value;
+		m_rampPointCount = 0;
+	}
+	m_rampPeriod = s_periods;
+}
+
+
+
+
+void MidiController::processUnqueuedEvents()
+{
+	using Element = LocklessList<MidiEvent>::Element;
+
+	// the list is newest first, reverse it to process the events in order
+	Element* oldest = nullptr;
+	for (Element* e = m_unqueuedEvents.popList(); e;)
+	{
+		Element* next = e->next;
+		e->next = oldest;
+		oldest = e;
+		e = next;
+	}
+
+	for (Element* e = oldest; e;)
+	{
+		if (receiveValue(e->value)) { addRampPoint(0, m_lastValue); }
+
+		Element* next = e->next;
+		m_unqueuedEvents.free(e);
+		e = next;
+	}
+}
+
+
+
+
+void MidiController::addRampPoint(f_cnt_t offset, float value)
+{
+	startRampPeriod();
+
+	// events not queued for the audio thread all come at offset 0
+	if (m_rampPointCount > 0)
+	{
+		auto& last = m_rampPoints[m_rampPointCount - 1];
+		offset = std::max(offset, last.offset);
+		if (offset == last.offset || m_rampPointCount == MaxRampPoints)
+		{
+			last = RampPoint{offset, value};
+			return;
+		}
+	}
+	m_rampPoints[m_rampPointCount++] = RampPoint{offset, value};
+}
+
+
 void MidiController::updateName()
 {
 	setName( QString("MIDI ch%1 ctrl%2").
@@ -73,26 +170,62 @@ void MidiController::updateName()
 
 void MidiController::processInEvent(const MidiEvent& event, const TimePos& time, f_cnt_t offset)
 {
-	switch(event.type())
+	// Don't care about other events - maybe add special cases for pitch and mod later
+	if (event.type() != MidiControlChange) { return; }
+
+	// the MIDI port only comes here when its own queue is full, so there is no
+	// point in waiting for room in this one either
+	m_unqueuedEvents.tryPush(event);
+}
+
+
+
+
+void MidiController::processInEvents(const TimedMidiEvent* events, std::size_t count)
+{
+	// they arrived before the queued ones, which the port had no room for
+	processUnqueuedEvents();
+
+	for (std::size_t i = 0; i < count; ++i)
 	{
-		case MidiControlChange:
-		{
-			unsigned char controllerNum = event.controllerNumber();
-
-			if (m_midiPort.inputController() == controllerNum &&
-				(m_midiPort.inputChannel() == event.channel() + 1 || m_midiPort.inputChannel() == 0))
-			{
-				unsigned char val = event.controllerValue();
-				m_previousValue = m_lastValue;
-				m_lastValue = static_cast<float>(val) / 127.0f;
-				emit valueChanged();
-			}
-			break;
-		}
-		default:
-			// Don't care - maybe add special cases for pitch and mod later
-			break;
+		if (receiveValue(events[i].event)) { addRampPoint(events[i].offset, m_lastValue); }
+	}
+}
+
+
+
+
+bool MidiController::receiveValue(const MidiEvent& event)
+{
+	if (event.type() != MidiControlChange) { return false; }
+
+	const int controllerNum = event.controllerNumber();
+	const int inputController = m_midiPort.inputController();
+
+	if (inputController < 0 ||
+		(m_midiPort.inputChannel() != event.channel() + 1 && m_midiPort.inputChannel() != 0))
+	{
+		return false;
+	}
+
+	if (controllerNum == inputController)
+	{
+		m_coarseValue = event.controllerValue();
+		// the least significant bits follow, if the controller sends them
+		if (m_fineValue >= 0) { m_fineValue = 0; }
+	}
+	else if (inputController < 32 && controllerNum == inputController + 32)
+	{
+		m_fineValue = event.controllerValue();
 	}
+	else { return false; }
+
+	m_lastValue = m_fineValue >= 0
+		? static_cast<float>(m_coarseValue * 128 + m_fineValue) / 16383.0f
+		: static_cast<float>(m_coarseValue) / 127.0f;
+	// models are told once the period has been rendered
+	m_valueChangedInPeriod.store(true, std::memory_order_relaxed);
+	return true;
 }
 
 
@@ -0,0 +1,136 @@
+/*
+ * MidiOutScheduler.cpp - sends MIDI events at the time they are due
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "MidiOutScheduler.h"
+
+#include <algorithm>
+
+#include "RealtimeThread.h"
+
+
+namespace lmms
+{
+
+
+MidiOutScheduler::MidiOutScheduler(Send send) :
+	m_send(std::move(send)),
+	m_sequence(0),
+	m_quit(false),
+	m_thread(&MidiOutScheduler::run, this)
+{
+}
+
+
+
+
+MidiOutScheduler::~MidiOutScheduler()
+{
+	{
+		const auto lock = std::lock_guard{m_mutex};
+		m_quit = true;
+	}
+	m_wake.notify_one();
+	m_thread.join();
+}
+
+
+
+
+void MidiOutScheduler::schedule(Clock::time_point due, const MidiEvent& event, const TimePos& time,
+	const MidiPort* port)
+{
+	bool earliest;
+	{
+		const auto lock = std::lock_guard{m_mutex};
+		const auto sequence = m_sequence++;
+		m_queue.push_back(Entry{due, sequence, event, time, port});
+		std::push_heap(m_queue.begin(), m_queue.end(), later);
+		earliest = m_queue.front().sequence == sequence;
+	}
+
+	// the thread only needs to wake up earlier if this is the next event
+	if (earliest)
+	{
+		m_wake.notify_one();
+	}
+}
+
+
+
+
+void MidiOutScheduler::removePort(const MidiPort* port)
+{
+	{
+		const auto lock = std::lock_guard{m_mutex};
+		std::erase_if(m_queue, [port](const Entry& entry) { return entry.port == port; });
+		std::make_heap(m_queue.begin(), m_queue.end(), later);
+	}
+
+	// an event taken from the queue before is sent while holding this
+	const auto sending = std::lock_guard{m_sendMutex};
+}
+
+
+
+
+bool MidiOutScheduler::later(const Entry& a, const Entry& b)
+{
+	return a.due != b.due ? a.due > b.due : a.sequence > b.sequence;
+}
+
+
+
+
+void MidiOutScheduler::run()
+{
+	// wake-up latency is the timing error of every event sent
+	makeCurrentThreadRealtime();
+
+	auto lock = std::unique_lock{m_mutex};
+	while (!m_quit)
+	{
+		if (m_queue.empty())
+		{
+			m_wake.wait(lock);
+			continue;
+		}
+
+		if (Clock::now() < m_queue.front().due)
+		{
+			m_wake.wait_until(lock, m_queue.front().due);
+			continue;
+		}
+
+		std::pop_heap(m_queue.begin(), m_queue.end(), later);
+		const Entry entry = m_queue.back();
+		m_queue.pop_back();
+
+		// taken before releasing the queue, see removePort()
+		const auto sending = std::lock_guard{m_sendMutex};
+		lock.unlock();
+		m_send(entry.event, entry.time, entry.port);
+		lock.lock();
+	}
+}
+
+
+} // namespace lmms
@@ -0,0 +1,161 @@
+/*
+ * MidiPipeWire.cpp - MIDI client for PipeWire
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "MidiPipeWire.h"
+
+#ifdef LMMS_HAVE_PIPEWIRE
+
+#include <pipewire/filter.h>
+#include <spa/control/control.h>
+#include <spa/pod/iter.h>
+
+#include <cstdio>
+
+#include "ConfigManager.h"
+
+namespace lmms
+{
+
+
+MidiPipeWire::MidiPipeWire() :
+	MidiClientRaw(),
+	m_loop(nullptr),
+	m_context(nullptr),
+	m_core(nullptr),
+	m_filter(nullptr),
+	m_filterListener(),
+	m_inputPort(nullptr)
+{
+	pw_init(nullptr, nullptr);
+
+	m_loop = pw_thread_loop_new("lmms-pipewire-midi", nullptr);
+	if (!m_loop) { return; }
+
+	m_context = pw_context_new(pw_thread_loop_get_loop(m_loop), nullptr, 0);
+	if (!m_context) { return; }
+
+	m_core = pw_context_connect(m_context, nullptr, 0);
+	if (!m_core)
+	{
+		std::fprintf(stderr, "Could not connect to PipeWire\n");
+		return;
+	}
+
+	static const pw_filter_events filterEvents = [] {
+		auto events = pw_filter_events{};
+		events.version = PW_VERSION_FILTER_EVENTS;
+		events.process = &MidiPipeWire::staticProcessCallback;
+		return events;
+	}();
+
+	const QByteArray nodeName = probeDevice().toUtf8();
+	pw_filter* filter = pw_filter_new(m_core, nodeName.constData(), pw_properties_new(
+		PW_KEY_MEDIA_TYPE, "Midi",
+		PW_KEY_MEDIA_CATEGORY, "Capture",
+		PW_KEY_MEDIA_ROLE, "Production",
+		PW_KEY_APP_NAME, "LMMS",
+		PW_KEY_NODE_NAME, nodeName.constData(),
+		nullptr));
+	if (!filter) { return; }
+	pw_filter_add_listener(filter, &m_filterListener, &filterEvents, this);
+
+	m_inputPort = pw_filter_add_port(filter, PW_DIRECTION_INPUT, PW_FILTER_PORT_FLAG_MAP_BUFFERS, 0,
+		pw_properties_new(
+			PW_KEY_FORMAT_DSP, "8 bit raw midi",
+			PW_KEY_PORT_NAME, "MIDI in",
+			nullptr),
+		nullptr, 0);
+
+	if (!m_inputPort || pw_filter_connect(filter, PW_FILTER_FLAG_RT_PROCESS, nullptr, 0) < 0
+		|| pw_thread_loop_start(m_loop) < 0)
+	{
+		std::fprintf(stderr, "Could not connect PipeWire MIDI filter\n");
+		pw_filter_destroy(filter);
+		return;
+	}
+
+	m_filter = filter;
+}
+
+
+
+
+MidiPipeWire::~MidiPipeWire()
+{
+	if (m_loop) { pw_thread_loop_stop(m_loop); }
+	if (m_filter) { pw_filter_destroy(m_filter); }
+	if (m_core) { pw_core_disconnect(m_core); }
+	if (m_context) { pw_context_destroy(m_context); }
+	if (m_loop) { pw_thread_loop_destroy(m_loop); }
+}
+
+
+
+
+QString MidiPipeWire::probeDevice()
+{
+	const QString name = ConfigManager::inst()->value(configSection(), "device");
+	return name.isEmpty() ? QString("lmms") : name;
+}
+
+
+
+
+// we read data from PipeWire
+void MidiPipeWire::processCallback()
+{
+	pw_buffer* buffer = pw_filter_dequeue_buffer(m_inputPort);
+	if (!buffer) { return; }
+
+	const spa_data& data = buffer->buffer->datas[0];
+	auto pod = static_cast<spa_pod*>(spa_pod_from_data(data.data, data.maxsize, data.chunk->offset, data.chunk->size));
+	if (pod && spa_pod_is_sequence(pod))
+	{
+		spa_pod_control* control;
+		SPA_POD_SEQUENCE_FOREACH(reinterpret_cast<spa_pod_sequence*>(pod), control)
+		{
+			if (control->type != SPA_CONTROL_Midi) { continue; }
+
+			// lmms is setup to parse bytes coming from a device
+			const auto bytes = static_cast<const unsigned char*>(SPA_POD_BODY(&control->value));
+			for (uint32_t b = 0; b < SPA_POD_BODY_SIZE(&control->value); ++b)
+			{
+				parseData(bytes[b]);
+			}
+		}
+	}
+
+	pw_filter_queue_buffer(m_inputPort, buffer);
+}
+
+
+
+
+void MidiPipeWire::staticProcessCallback(void* data, spa_io_position*)
+{
+	static_cast<MidiPipeWire*>(data)->processCallback();
+}
+
+
+} // namespace lmms
+
+#endif // LMMS_HAVE_PIPEWIRE
@@ -25,6 +25,8 @@
 
 #include <QDomElement>
 
+#include <algorithm>
+
 #include "MidiPort.h"
 #include "MidiClient.h"
 #include "MidiDummy.h"
@@ -53,6 +55,9 @@ MidiPort::MidiPort( const QString& name,
 	m_midiClient( client ),
 	m_midiEventProcessor( eventProcessor ),
 	m_mode( mode ),
+	m_queuedInEvents( InEventQueueSize ),
+	m_queueInEvents( true ),
+	m_inEventBatch(),
 	m_inputChannelModel( 0, 0, MidiChannelCount, this, tr( "Input channel" ) ),
 	m_outputChannelModel( 1, 0, MidiChannelCount, this, tr( "Output channel" ) ),
 	m_inputControllerModel(MidiController::NONE, MidiController::NONE, MidiControllerCount - 1, this, tr( "Input controller" )),
@@ -65,6 +70,7 @@ MidiPort::MidiPort( const QString& name,
 	m_readableModel( false, this, tr( "Receive MIDI-events" ) ),
 	m_writableModel( false, this, tr( "Send MIDI-events" ) )
 {
+	m_inEventBatch.reserve( InEventQueueSize );
 	m_midiClient->addPort( this );
 
 	m_readableModel.setValue( m_mode == Mode::Input || m_mode == Mode::Duplex );
@@ -129,34 +135,114 @@ void MidiPort::setMode( Mode mode )
 
 void MidiPort::processInEvent( const MidiEvent& event, const TimePos& time )
 {
-	// mask event
-	if( isInputEnabled() &&
-		( inputChannel() == 0 || inputChannel()-1 == event.channel() ) )
+	if( !isInputEnabled() )
 	{
-		MidiEvent inEvent = event;
-		if( event.type() == MidiNoteOn ||
-			event.type() == MidiNoteOff ||
-			event.type() == MidiKeyPressure )
+		return;
+	}
+
+	// SysEx data belongs to the client, so it can't wait for the audio thread
+	if( m_queueInEvents && event.sysExData() == nullptr )
+	{
+		auto queued = QueuedInEvent{ event, time, std::chrono::steady_clock::now() };
+		// the source port is only valid during this call as well
+		queued.event.setSourcePort( nullptr );
+		if( m_queuedInEvents.tryPush( queued ) )
 		{
-			if( inEvent.key() < 0 || inEvent.key() >= NumKeys )
-			{
-				return;
-			}
+			return;
+		}
+	}
 
-			if( fixedInputVelocity() >= 0 && inEvent.velocity() > 0 )
-			{
-				inEvent.setVelocity( fixedInputVelocity() );
-			}
+	// not queued, or the audio thread doesn't keep up
+	dispatchInEvent( event, time, 0 );
+}
+
+
+
+
+void MidiPort::processQueuedInEvents( std::chrono::steady_clock::time_point periodStart,
+	fpp_t frames, sample_rate_t sampleRate )
+{
+	using Element = LocklessList<QueuedInEvent>::Element;
+
+	// the list is newest first, reverse it to process the events in order
+	Element* oldest = nullptr;
+	for( Element* e = m_queuedInEvents.popList(); e; )
+	{
+		Element* next = e->next;
+		e->next = oldest;
+		oldest = e;
+		e = next;
+	}
+
+	// no more events can be queued than the batch has room for
+	m_inEventBatch.clear();
+	for( Element* e = oldest; e; )
+	{
+		MidiEvent event = e->value.event;
+		if( maskInEvent( event ) )
+		{
+			const double sinceStart = std::chrono::duration<double>( e->value.arrival - periodStart ).count();
+			const auto offset = static_cast<f_cnt_t>(
+				std::clamp( sinceStart * sampleRate, 0.0, std::max<double>( frames, 1 ) - 1 ) );
+			m_inEventBatch.push_back( { event, e->value.time, offset } );
 		}
 
-		m_midiEventProcessor->processInEvent( inEvent, time );
+		Element* next = e->next;
+		m_queuedInEvents.free( e );
+		e = next;
+	}
+
+	if( !m_inEventBatch.empty() )
+	{
+		m_midiEventProcessor->processInEvents( m_inEventBatch.data(), m_inEventBatch.size() );
 	}
 }
 
 
 
 
-void MidiPort::processOutEvent( const MidiEvent& event, const TimePos& time )
+void MidiPort::dispatchInEvent( const MidiEvent& event, const TimePos& time, f_cnt_t offset )
+{
+	MidiEvent inEvent = event;
+	if( maskInEvent( inEvent ) )
+	{
+		m_midiEventProcessor->processInEvent( inEvent, time, offset );
+	}
+}
+
+
+
+
+bool MidiPort::maskInEvent( MidiEvent& event ) const
+{
+	if( !isInputEnabled() ||
+		( inputChannel() != 0 && inputChannel()-1 != event.channel() ) )
+	{
+		return false;
+	}
+
+	if( event.type() == MidiNoteOn ||
+		event.type() == MidiNoteOff ||
+		event.type() == MidiKeyPressure )
+	{
+		if( event.key() < 0 || event.key() >= NumKeys )
+		{
+			return false;
+		}
+
+		if( fixedInputVelocity() >= 0 && event.velocity() > 0 )
+		{
+			event.setVelocity( fixedInputVelocity() );
+		}
+	}
+
+	return true;
+}
+
+
+
+
+void MidiPort::processOutEvent( const MidiEvent& event, const TimePos& time, f_cnt_t offset )
 {
 	// When output is enabled, route midi events if the selected channel matches
 	// the event channel or if there's no selected channel (value 0, represented by "--")
@@ -176,7 +262,7 @@ void MidiPort::processOutEvent( const MidiEvent& event, const TimePos& time )
 			outEvent.setKey( fixedOutputNote() );
 		}
 
-		m_midiClient->processOutEvent( outEvent, time, this );
+		m_midiClient->processOutEvent( outEvent, time, offset, this );
 	}
 }
 
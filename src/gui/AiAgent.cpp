@@ -1,5 +1,8 @@
 #include "AiAgent.h"
 #include "AiSidebar.h"
+#include "ProjectStateObserver.h"
+#include "AudioEngine.h"
+#include "ProjectJournal.h"
 #include "Song.h"
 #include "Engine.h"
 #include "Track.h"
@@ -31,15 +34,12 @@ AiAgent::AiAgent(AiSidebar* sidebar, QObject* parent)
     , m_currentStepIndex(0)
     , m_maxRetries(3)
 {
-    // Initialize timers
-    m_executionTimer = new QTimer(this);
-    m_executionTimer->setSingleShot(true);
-    connect(m_executionTimer, &QTimer::timeout, this, &AiAgent::onExecutionTimer);
+    m_net = new QNetworkAccessManager(this);
     
-    m_stateUpdateTimer = new QTimer(this);
-    m_stateUpdateTimer->setInterval(1000); // Update state every second
-    connect(m_stateUpdateTimer, &QTimer::timeout, this, &AiAgent::onStateUpdateTimer);
-    m_stateUpdateTimer->start();
+    // Project state follows the song's change signals instead of being polled
+    if (Song* song = Engine::getSong()) {
+        m_stateObserver = new ProjectStateObserver(song, this);
+    }
     
     // Initialize knowledge bases
     initializeMusicalKnowledge();
@@ -250,20 +250,57 @@ void AiAgent::executeToolSequence(const QJsonArray& toolSequence)
     
     qDebug() << "Executing tool sequence with" << toolSequence.size() << "steps";
     
-    if (!toolSequence.isEmpty()) {
-        executeNextStep();
-    } else {
+    if (toolSequence.isEmpty()) {
         emit executionCompleted(false, "Empty tool sequence");
+        return;
+    }
+    
+    m_sequenceRunning = true;
+    m_sequenceSucceeded = true;
+    m_sequenceSummary = "All tools executed successfully";
+    m_recoveryError.clear();
+    
+    // The whole sequence is one transaction: a single undo step restores the
+    // song as it was before, and the audio engine waits once instead of for
+    // every tool. Journalling is off meanwhile, so tools don't add their own
+    // checkpoints.
+    Song* song = Engine::getSong();
+    ProjectJournal* journal = Engine::projectJournal();
+    if (song) {
+        song->addJournalCheckPoint();
+        
+        // Tempo and time signature aren't part of the song's state, so they
+        // get checkpoints of their own, if the sequence changes them
+        for (const QJsonValue& step : toolSequence) {
+            const QString tool = step.toObject()["tool"].toString();
+            if (tool == "set_tempo") {
+                song->tempoModel().addJournalCheckPoint();
+            } else if (tool == "set_time_signature") {
+                song->getTimeSigModel().numeratorModel().addJournalCheckPoint();
+                song->getTimeSigModel().denominatorModel().addJournalCheckPoint();
+            }
+        }
     }
+    const bool wasJournalling = journal->isJournalling();
+    journal->setJournalling(false);
+    {
+        const auto guard = Engine::audioEngine()->requestChangesGuard();
+        while (m_sequenceRunning && m_currentStepIndex < m_currentSequence.size()) {
+            executeNextStep();
+        }
+    }
+    journal->setJournalling(wasJournalling);
+    m_sequenceRunning = false;
+    
+    // Listeners may change the song themselves, so they're told afterwards
+    if (!m_recoveryError.isEmpty()) {
+        emit errorRecoveryNeeded(m_recoveryError, suggestRecoveryActions(m_recoveryError));
+    }
+    emit executionCompleted(m_sequenceSucceeded, m_sequenceSummary);
 }
 
 void AiAgent::executeNextStep()
 {
-    if (m_currentStepIndex >= m_currentSequence.size()) {
-        emit executionCompleted(true, "All tools executed successfully");
-        return;
-    }
-    
     QJsonObject step = m_currentSequence[m_currentStepIndex].toObject();
     QString toolName = step["tool"].toString();
     QJsonObject params = step["params"].toObject();
@@ -277,33 +314,32 @@ void AiAgent::executeNextStep()
     
     // Execute via sidebar (which has the actual tool implementations)
     if (m_sidebar) {
-        // Call through the public runTool API and synthesize completion
-        AiToolResult res = m_sidebar->runTool(toolName, params);
-        handleToolResult(res);
+        handleToolResult(m_sidebar->runTool(toolName, params));
+    } else {
+        handleExecutionError("No tool implementations available", toolName);
     }
-    
-    // Start timeout timer - increased for complex operations like Fred Again beats
-    m_executionTimer->start(30000); // 30 second timeout per tool
 }
 
 void AiAgent::handleToolResult(const AiToolResult& result)
 {
-    m_executionTimer->stop();
-    
     // Track tool usage
     trackToolUsage(result.toolName, result.success);
     
     if (result.success) {
         updateMusicalContext(result);
         m_currentStepIndex++;
-        
-        // Short delay before next step
-        QTimer::singleShot(100, this, &AiAgent::executeNextStep);
     } else {
         handleExecutionError(result.output, result.toolName);
     }
 }
 
+void AiAgent::finishSequence(bool success, const QString& summary)
+{
+    m_sequenceRunning = false;
+    m_sequenceSucceeded = success;
+    m_sequenceSummary = summary;
+}
+
 void AiAgent::handleExecutionError(const QString& error, const QString& toolName)
 {
     m_context.errorCount++;
@@ -319,14 +355,14 @@ void AiAgent::handleExecutionError(const QString& error, const QString& toolName
     // Circuit breaker: Stop execution if too many errors
     if (m_context.errorCount > 5) {
         qDebug() << "CIRCUIT BREAKER: Too many errors (" << m_context.errorCount << "), stopping execution";
-        emit executionCompleted(false, QString("Execution stopped due to excessive errors. Last error: %1").arg(error));
+        finishSequence(false, QString("Execution stopped due to excessive errors. Last error: %1").arg(error));
         return;
     }
     
     // Check for specific repeated error patterns that indicate infinite loops
     if (toolName == "create_midi_clip" && error.contains("Track not found")) {
         qDebug() << "PREVENTING INFINITE LOOP: create_midi_clip failing repeatedly";
-        emit executionCompleted(false, "Track creation/lookup system is broken. Cannot continue execution.");
+        finishSequence(false, "Track creation/lookup system is broken. Cannot continue execution.");
         return;
     }
     
@@ -335,20 +371,19 @@ void AiAgent::handleExecutionError(const QString& error, const QString& toolName
         QJsonArray recoveryActions = suggestRecoveryActions(error);
         if (!recoveryActions.isEmpty()) {
             qDebug() << "Attempting error recovery with" << recoveryActions.size() << "actions";
-            // Insert recovery actions into current sequence
+            // Insert recovery actions into current sequence, they run next
             for (int i = recoveryActions.size() - 1; i >= 0; i--) {
                 m_currentSequence.insert(m_currentStepIndex, recoveryActions[i]);
             }
-            executeNextStep();
             return;
         }
     }
     
-    emit errorRecoveryNeeded(error, suggestRecoveryActions(error));
-    emit executionCompleted(false, QString("Failed at step %1 (%2): %3")
-                                     .arg(m_currentStepIndex)
-                                     .arg(toolName)
-                                     .arg(error));
+    m_recoveryError = error;
+    finishSequence(false, QString("Failed at step %1 (%2): %3")
+                              .arg(m_currentStepIndex)
+                              .arg(toolName)
+                              .arg(error));
 }
 
 bool AiAgent::canRecoverFromError(const QString& error)
@@ -453,19 +488,13 @@ QJsonObject AiAgent::sanitizeParameters(const QJsonObject& params, const QString
 
 void AiAgent::updateProjectState()
 {
-    Song* song = Engine::getSong();
-    if (!song) return;
+    if (!m_stateObserver) return;
     
-    m_context.projectState["tempo"] = song->getTempo();
-    m_context.projectState["time_signature"] = QString("%1/%2")
-        .arg(song->getTimeSigModel().getNumerator())
-        .arg(song->getTimeSigModel().getDenominator());
-    
-    QStringList trackNames;
-    for (Track* track : song->tracks()) {
-        trackNames.append(track->name());
-    }
-    m_context.availableTracks = trackNames;
+    // Only the tracks changed since the last call are looked at again
+    const QJsonObject digest = m_stateObserver->digest();
+    m_context.projectState = digest["song"].toObject();
+    m_context.projectState["version"] = digest["version"];
+    m_context.availableTracks = m_stateObserver->trackNames();
 }
 
 void AiAgent::initializeMusicalKnowledge()
@@ -557,18 +586,6 @@ void AiAgent::resetSession()
     m_recentErrors.clear();
 }
 
-void AiAgent::onExecutionTimer()
-{
-    // Tool execution timeout
-    qDebug() << "Tool execution timeout at step" << m_currentStepIndex;
-    handleExecutionError("Tool execution timeout", "timeout");
-}
-
-void AiAgent::onStateUpdateTimer()
-{
-    updateProjectState();
-}
-
 void AiAgent::updateMusicalContext(const AiToolResult& result)
 {
     // Update context based on successful tool execution
@@ -1364,8 +1381,8 @@ QJsonObject AiAgent::makeAIAPICall(const QString& message)
     ).arg(message, availableTools, availableInstruments);
     
     // Make HTTP request to OpenAI API
-    QNetworkAccessManager* manager = new QNetworkAccessManager(this);
     QNetworkRequest request(QUrl("https://api.openai.com/v1/responses"));
+    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
     
     request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
     request.setRawHeader("Authorization", ("Bearer " + apiKey).toUtf8());
@@ -1387,7 +1404,7 @@ QJsonObject AiAgent::makeAIAPICall(const QString& message)
     
     // Send request synchronously (for simplicity)
     QEventLoop loop;
-    QNetworkReply* reply = manager->post(request, requestData);
+    QNetworkReply* reply = m_net->post(request, requestData);
     connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
     loop.exec();
     
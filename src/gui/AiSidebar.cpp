@@ -15,6 +15,9 @@
 #include "EffectChain.h"
 #include "ConfigManager.h"
 #include "VibeAnalyzer.h"
+#include "ProjectStateObserver.h"
+#include "AudioAnalysis.h"
+#include "SampleBuffer.h"
 
 #include <QVBoxLayout>
 #include <QHBoxLayout>
@@ -29,9 +32,11 @@
 #include <QJsonDocument>
 #include <QTime>
 #include <QDateTime>
+#include <algorithm>
 #include <cstdlib>  // For random functions
 #include <QRandomGenerator>
 #include <QDir>
+#include <QFileInfo>
 #include <QProgressBar>
 #include <QDateTime>
 #include <QCryptographicHash>
@@ -48,6 +53,10 @@ AiSidebar::AiSidebar(QWidget* parent)
 {
     setupUI();
     
+    if (Song* s = Engine::getSong()) {
+        m_stateObserver = new ProjectStateObserver(s, this);
+    }
+    
     // Load API key from .env file or environment
     loadApiKeyFromEnv();
     
@@ -462,6 +471,7 @@ QJsonArray AiSidebar::getToolDefinitions() const
     add("get_track_notes", "Get all notes in a track with musical analysis (parameters: track_name, start_bar, end_bar)");
     add("modify_notes", "Modify specific notes in a track (parameters: track_name, operation, target_notes, value)");
     add("analyze_before_writing", "Analyze track content before writing new data (parameters: track_name, target_bar, intended_content)");
+    add("analyze_audio", "Measure tempo, key, onsets and loudness of the samples of a sample track or of an audio file, computed locally (parameters: track_name or file)");
     
     // Effect management tools
     add("list_effects", "List all effects on a track (parameters: track_name)");
@@ -568,10 +578,31 @@ void AiSidebar::sendToGPT5(const QString& message)
         "FX: 'FX-Sweep', 'Vocal-Chop', 'String-Sustain', 'Bell-Sparkle'\n\n"
         "🚀 REMEMBER: Think like a professional producer! Create depth, layers, and professional arrangements, not just basic tracks!";
     QJsonObject usr; usr["role"] = "user"; usr["content"] = message;
-    input.append(sys); input.append(usr);
+    input.append(sys);
+    
+    // The full project state goes with the first request, later ones only
+    // carry what changed since the last request that got through
+    if (m_stateObserver) {
+        const QJsonObject delta = m_stateObserver->deltaSince(
+            m_previousResponseId.isEmpty() ? 0 : m_sentStateVersion);
+        m_pendingStateVersion = m_stateObserver->version();
+        if (delta.contains("full") || delta.contains("song") || delta.contains("tracks")
+            || delta.contains("removed_tracks")) {
+            QJsonObject state; state["role"] = "system";
+            state["content"] = QString(delta.contains("full")
+                ? "PROJECT STATE: %1"
+                : "PROJECT STATE CHANGES since your last message: %1")
+                .arg(QString::fromUtf8(QJsonDocument(delta).toJson(QJsonDocument::Compact)));
+            input.append(state);
+        }
+    }
+    input.append(usr);
 
     QJsonObject body;
     body["model"] = "gpt-5";
+    if (!m_previousResponseId.isEmpty()) {
+        body["previous_response_id"] = m_previousResponseId;
+    }
     QJsonObject reasoning; reasoning["effort"] = "medium"; body["reasoning"] = reasoning;
     QJsonObject text;
     QJsonObject format; format["type"] = "text";
@@ -579,6 +610,7 @@ void AiSidebar::sendToGPT5(const QString& message)
     text["verbosity"] = "medium";
     body["text"] = text;
     body["input"] = input;
+    body["stream"] = true;
     body["tools"] = getToolDefinitions();
     QJsonObject toolChoice;
     toolChoice["type"] = "allowed_tools";
@@ -598,22 +630,87 @@ void AiSidebar::sendToGPT5(const QString& message)
     QNetworkRequest req(QUrl("https://api.openai.com/v1/responses"));
     req.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
     req.setRawHeader("Authorization", QByteArray("Bearer ") + m_apiKey.toUtf8());
+    req.setRawHeader("Accept", "text/event-stream");
+    req.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
     QJsonDocument doc(body);
     
     // Debug logging
     qDebug() << "AI Sidebar: Sending API request";
     qDebug() << "Request body:" << doc.toJson(QJsonDocument::Compact);
     
-    m_reply = m_net->post(req, doc.toJson());
+    m_streamBuffer.clear();
+    m_streamText.clear();
+    m_streamedResponse = QJsonObject{};
+    m_streamLabel = nullptr;
+    
+    m_reply = m_net->post(req, doc.toJson(QJsonDocument::Compact));
+    connect(m_reply, &QNetworkReply::readyRead, this, &AiSidebar::onNetworkReadyRead);
     connect(m_reply, &QNetworkReply::finished, this, &AiSidebar::onNetworkFinished);
 }
 
+void AiSidebar::onNetworkReadyRead()
+{
+    if (!m_reply) return;
+    
+    // Errors come as one JSON document, which is read once the reply finished
+    const QString contentType = m_reply->header(QNetworkRequest::ContentTypeHeader).toString();
+    if (!contentType.startsWith("text/event-stream")) return;
+    
+    consumeStream(m_reply->readAll());
+}
+
+void AiSidebar::consumeStream(const QByteArray& data)
+{
+    m_streamBuffer += data;
+    m_streamBuffer.replace("\r\n", "\n");
+    
+    // Events are separated by blank lines, only complete ones are parsed
+    int end;
+    while ((end = m_streamBuffer.indexOf("\n\n")) >= 0) {
+        const QByteArray block = m_streamBuffer.left(end);
+        m_streamBuffer.remove(0, end + 2);
+        
+        QByteArray payload;
+        for (const QByteArray& line : block.split('\n')) {
+            if (!line.startsWith("data:")) continue;
+            if (!payload.isEmpty()) payload += '\n';
+            payload += line.mid(5).trimmed();
+        }
+        if (payload.isEmpty() || payload == "[DONE]") continue;
+        
+        const QJsonDocument event = QJsonDocument::fromJson(payload);
+        if (event.isObject()) {
+            handleStreamEvent(event.object());
+        }
+    }
+}
+
+void AiSidebar::handleStreamEvent(const QJsonObject& event)
+{
+    const QString type = event.value("type").toString();
+    
+    if (type == "response.output_text.delta") {
+        m_streamText += event.value("delta").toString();
+        if (!m_streamLabel) {
+            m_streamLabel = new QLabel(m_msgs);
+            m_streamLabel->setWordWrap(true);
+            m_msgsLayout->insertWidget(m_msgsLayout->count()-1, m_streamLabel);
+        }
+        m_streamLabel->setText(QString("[assistant] %1").arg(m_streamText));
+    } else if (type == "response.completed" || type == "response.incomplete" || type == "response.failed") {
+        m_streamedResponse = event.value("response").toObject();
+    } else if (type == "error") {
+        m_streamedResponse = QJsonObject{{"error", event}};
+    }
+}
+
 void AiSidebar::onNetworkFinished()
 {
     if (!m_reply) return;
     
     const QByteArray data = m_reply->readAll();
     const int statusCode = m_reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    const QString contentType = m_reply->header(QNetworkRequest::ContentTypeHeader).toString();
     
     // Debug logging
     qDebug() << "AI Sidebar: Received API response";
@@ -645,17 +742,35 @@ void AiSidebar::onNetworkFinished()
         }
     }
     
-    QJsonDocument d = QJsonDocument::fromJson(data);
-    qDebug() << "AI Sidebar: JSON parsing result - isNull:" << d.isNull();
-    if (d.isNull()) {
-        addMessage("Invalid JSON response from API", "system");
-        addMessage(QString("Raw response: %1").arg(QString::fromUtf8(data.left(300))), "system");
-        setState(ProcessingState::Error);
-        m_retryCount = 0;
-        return;
+    // The streamed text is replaced by the messages of the complete response
+    if (m_streamLabel) {
+        m_streamLabel->deleteLater();
+        m_streamLabel = nullptr;
+    }
+    
+    QJsonObject obj;
+    if (contentType.startsWith("text/event-stream")) {
+        consumeStream(data);
+        if (m_streamedResponse.isEmpty()) {
+            addMessage("Response stream ended before the response was complete", "system");
+            setState(ProcessingState::Error);
+            m_retryCount = 0;
+            return;
+        }
+        obj = m_streamedResponse;
+    } else {
+        QJsonDocument d = QJsonDocument::fromJson(data);
+        qDebug() << "AI Sidebar: JSON parsing result - isNull:" << d.isNull();
+        if (d.isNull()) {
+            addMessage("Invalid JSON response from API", "system");
+            addMessage(QString("Raw response: %1").arg(QString::fromUtf8(data.left(300))), "system");
+            setState(ProcessingState::Error);
+            m_retryCount = 0;
+            return;
+        }
+        obj = d.object();
     }
     
-    const QJsonObject obj = d.object();
     qDebug() << "AI Sidebar: Parsed JSON object - keys:" << obj.keys();
     qDebug() << "AI Sidebar: Checking for error key...";
     if (obj.contains("error") && !obj.value("error").isNull()) {
@@ -677,6 +792,8 @@ void AiSidebar::onNetworkFinished()
     
     // Reset retry count on successful response
     m_retryCount = 0;
+    m_previousResponseId = obj.value("id").toString();
+    m_sentStateVersion = m_pendingStateVersion;
     qDebug() << "AI Sidebar: About to call setState(ExecutingTools)";
     setState(ProcessingState::ExecutingTools);
     qDebug() << "AI Sidebar: setState completed, about to call processResponse with keys:" << obj.keys();
@@ -1052,6 +1169,7 @@ void AiSidebar::executeToolCall(const QJsonObject& toolCall)
     else if (name == "get_track_notes") r = toolGetTrackNotes(args);
     else if (name == "modify_notes") r = toolModifyNotes(args);
     else if (name == "analyze_before_writing") r = toolAnalyzeBeforeWriting(args);
+    else if (name == "analyze_audio") r = toolAnalyzeAudio(args);
     
     // Effect management tools
     else if (name == "list_effects") r = toolListEffects(args);
@@ -1430,6 +1548,9 @@ AiToolResult AiSidebar::toolWriteNotes(const QJsonObject& p)
     auto* it = findInstrumentTrack(trackName); if (!it) { r.output = "track not found"; return r; }
     auto& clips = it->getClips(); if (clipIndex < 0 || (size_t)clipIndex >= clips.size()) { r.output = "bad clip index"; return r; }
     auto* mc = dynamic_cast<MidiClip*>(clips[clipIndex]); if (!mc) { r.output = "not midi"; return r; }
+
+    // Collected first, so the clip takes them in one go
+    std::vector<Note> newNotes;
     
     const QJsonArray notes = p.value("notes").toArray();
     for (const auto& n : notes) {
@@ -1447,9 +1568,11 @@ AiToolResult AiSidebar::toolWriteNotes(const QJsonObject& p)
         
         int key = o.value("key").toInt(DefaultKey);
         int vel = o.value("velocity").toInt(100);
-        mc->addNote(Note(TimePos(len), TimePos(start), key, (volume_t)vel), false);
+        newNotes.push_back(Note(TimePos(len), TimePos(start), key, (volume_t)vel));
     }
     
+    mc->addNotes(newNotes, false);
+
     r.success = true; 
     r.output = QString("%1 notes added").arg(notes.size()); 
     return r;
@@ -1464,6 +1587,7 @@ AiToolResult AiSidebar::toolQuantizeTrack(const QJsonObject& p)
     int div = 16; if (grid=="1/8") div=8; else if (grid=="1/32") div=32; else if (grid=="1/4") div=4;
     const int q = TimePos::ticksPerBar()/div;
     for (auto* c : it->getClips()) if (auto* mc = dynamic_cast<MidiClip*>(c)) {
+        mc->detachNotes();
         for (auto* n : mc->notes()) { n->quantizePos(q); n->quantizeLength(q); }
         mc->rearrangeAllNotes();
     }
@@ -1479,6 +1603,7 @@ AiToolResult AiSidebar::toolApplyGroove(const QJsonObject& p)
     const int unit = TimePos::ticksPerBar()/resolution;
     const int offset = (int)(unit * swing);
     for (auto* c : it->getClips()) if (auto* mc = dynamic_cast<MidiClip*>(c)) {
+        mc->detachNotes();
         for (auto* n : mc->notes()) {
             int pos = n->pos(); int idx = pos / unit; if (idx % 2 == 1) n->setPos(TimePos(pos + offset));
         }
@@ -1645,6 +1770,7 @@ AiToolResult AiSidebar::toolMutatePattern(const QJsonObject& p)
             qDebug() << "AI Sidebar: Processing MIDI clip with" << mc->notes().size() << "notes";
             
             // First pass: add timing and velocity variations
+            mc->detachNotes();
             for (auto* n : mc->notes()) {
                 notesModified++;
                 
@@ -1661,13 +1787,16 @@ AiToolResult AiSidebar::toolMutatePattern(const QJsonObject& p)
             if (variationAmount > 0.2) {
                 // Add some ghost notes between existing beats
                 int ghostNotes = static_cast<int>(mc->notes().size() * variationAmount);
+                std::vector<Note> newNotes;
+                newNotes.reserve(ghostNotes);
                 for (int i = 0; i < ghostNotes; i++) {
                     int randomTick = rand() % mc->length();
                     int randomKey = 42; // Hi-hat key
                     int ghostVel = 30 + (rand() % 20); // Low velocity ghost notes
-                    mc->addNote(Note(TimePos(TimePos::ticksPerBar() / 16), TimePos(randomTick), randomKey, ghostVel), false);
+                    newNotes.push_back(Note(TimePos(TimePos::ticksPerBar() / 16), TimePos(randomTick), randomKey, ghostVel));
                     notesModified++;
                 }
+                mc->addNotes(newNotes, false);
             }
             
             mc->rearrangeAllNotes();
@@ -1714,6 +1843,8 @@ AiToolResult AiSidebar::toolCreateChordProgression(const QJsonObject& p)
     }
     
     if (!mc) { r.output = "clip creation failed"; return r; }
+
+    std::vector<Note> newNotes;
     
     // IMPROVED CHORD VOICING WITH PROPER SPACING
     int chordIndex = 0;
@@ -1765,14 +1896,16 @@ AiToolResult AiSidebar::toolCreateChordProgression(const QJsonObject& p)
             else if (i == chordNotes.size() - 1) velocity = 70;  // Top note softer
             else velocity = 65;  // Inner voices quieter
             
-            mc->addNote(Note(TimePos(duration), TimePos(startTick), 
-                           baseNote + noteOffset, velocity), false);
+            newNotes.push_back(Note(TimePos(duration), TimePos(startTick), 
+                               baseNote + noteOffset, velocity));
         }
         
         lastChordEnd = startTick + duration;
         chordIndex++;
     }
     
+    mc->addNotes(newNotes, false);
+
     r.success = true;
     r.output = QString("%1 progression in %2").arg(progression, key);
     return r;
@@ -1831,6 +1964,8 @@ AiToolResult AiSidebar::toolCreateMelody(const QJsonObject& p)
     }
     
     if (!mc) { r.output = "clip creation failed"; return r; }
+
+    std::vector<Note> newNotes;
     
     // Extended scale definitions
     QMap<QString, QVector<int>> scales;
@@ -1952,8 +2087,8 @@ AiToolResult AiSidebar::toolCreateMelody(const QJsonObject& p)
             }
             noteVelocity = std::clamp(noteVelocity, 60, 120);  // Keep in musical range
             
-            mc->addNote(Note(TimePos(noteDuration), TimePos(currentTick), 
-                           baseNote + noteOffset, noteVelocity), false);
+            newNotes.push_back(Note(TimePos(noteDuration), TimePos(currentTick), 
+                               baseNote + noteOffset, noteVelocity));
             
             lastNoteEnd = currentTick + noteDuration;  // Track for overlap prevention
             motifIndex++;
@@ -1961,6 +2096,8 @@ AiToolResult AiSidebar::toolCreateMelody(const QJsonObject& p)
         }
     }
     
+    mc->addNotes(newNotes, false);
+
     r.success = true;
     r.output = QString("melody created: %1 scale, %2 bars, style: %3").arg(scale).arg(lengthBars).arg(style);
     return r;
@@ -2043,6 +2180,8 @@ AiToolResult AiSidebar::toolCreateDrumPattern(const QJsonObject& p)
     }
     
     if (!mc) { r.output = "clip creation failed"; return r; }
+
+    std::vector<Note> newNotes;
     
     // Complete General MIDI Drum Map for AI to use intelligently
     const int kick = 36;       // C1 - Bass Drum 1
@@ -2095,74 +2234,74 @@ AiToolResult AiSidebar::toolCreateDrumPattern(const QJsonObject& p)
                         continue;
                     }
                     
-                    mc->addNote(Note(TimePos(ticksPerBeat/4), TimePos(tick), kick, velocity), false);
+                    newNotes.push_back(Note(TimePos(ticksPerBeat/4), TimePos(tick), kick, velocity));
                     
                     // Double kick at phrase endings
                     if (complexity > 0.7 && bar % 8 == 7 && beat == 3) {
-                        mc->addNote(Note(TimePos(ticksPerBeat/8), TimePos(tick + ticksPerBeat - ticksPerBeat/4), kick, 100), false);
+                        newNotes.push_back(Note(TimePos(ticksPerBeat/8), TimePos(tick + ticksPerBeat - ticksPerBeat/4), kick, 100));
                     }
                 }
             } else if (currentBpm <= 90 || style.contains("trap") || style.contains("hip")) {
                 // Trap/Hip-hop patterns with 808 characteristics
-                mc->addNote(Note(TimePos(ticksPerBeat/3), TimePos(barStartTick), kick, 127), false);
+                newNotes.push_back(Note(TimePos(ticksPerBeat/3), TimePos(barStartTick), kick, 127));
                 
                 // AI places additional kicks based on groove requirements
                 if (complexity > 0.3) {
-                    mc->addNote(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + ticksPerBeat*2 + ticksPerBeat/2), kick, 110), false);
+                    newNotes.push_back(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + ticksPerBeat*2 + ticksPerBeat/2), kick, 110));
                 }
                 if (complexity > 0.6 && bar % 2 == 0) {
-                    mc->addNote(Note(TimePos(ticksPerBeat/6), TimePos(barStartTick + ticksPerBeat + ticksPerBeat/4), kick, 95), false);
+                    newNotes.push_back(Note(TimePos(ticksPerBeat/6), TimePos(barStartTick + ticksPerBeat + ticksPerBeat/4), kick, 95));
                 }
                 // Long 808 sub-bass kick
                 if (style == "trap" && aiParams["use_808"].toBool(true)) {
-                    mc->addNote(Note(TimePos(ticksPerBeat*2), TimePos(barStartTick), kick2, 90), false);
+                    newNotes.push_back(Note(TimePos(ticksPerBeat*2), TimePos(barStartTick), kick2, 90));
                 }
             } else if (style == "dnb" || style == "drum and bass" || style == "jungle") {
                 // Drum & Bass syncopated kicks
-                mc->addNote(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick), kick, 120), false);
-                mc->addNote(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + ticksPerBeat*2 + ticksPerBeat/2), kick, 115), false);
+                newNotes.push_back(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick), kick, 120));
+                newNotes.push_back(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + ticksPerBeat*2 + ticksPerBeat/2), kick, 115));
                 if (complexity > 0.6) {
-                    mc->addNote(Note(TimePos(ticksPerBeat/6), TimePos(barStartTick + ticksPerBeat + ticksPerBeat*3/4), kick, 90), false);
+                    newNotes.push_back(Note(TimePos(ticksPerBeat/6), TimePos(barStartTick + ticksPerBeat + ticksPerBeat*3/4), kick, 90));
                 }
             } else if (style == "reggaeton" || style == "dembow") {
                 // Reggaeton/Dembow pattern
                 int dembow[] = {0, 3, 6, 10}; // Classic dembow in 16ths
                 for (int i = 0; i < 4; i++) {
                     int tick = barStartTick + dembow[i] * (ticksPerBeat / 4);
-                    mc->addNote(Note(TimePos(ticksPerBeat/4), TimePos(tick), kick, 115), false);
+                    newNotes.push_back(Note(TimePos(ticksPerBeat/4), TimePos(tick), kick, 115));
                 }
             } else if (style == "breakbeat" || style == "breaks") {
                 // Breakbeat patterns
-                mc->addNote(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick), kick, 120), false);
-                mc->addNote(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + ticksPerBeat + ticksPerBeat/2), kick, 100), false);
-                mc->addNote(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + ticksPerBeat*3), kick, 110), false);
+                newNotes.push_back(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick), kick, 120));
+                newNotes.push_back(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + ticksPerBeat + ticksPerBeat/2), kick, 100));
+                newNotes.push_back(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + ticksPerBeat*3), kick, 110));
             } else if (style == "funk" || style == "disco") {
                 // Funk/Disco syncopation
-                mc->addNote(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick), kick, 120), false);
-                mc->addNote(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + ticksPerBeat*2), kick, 115), false);
+                newNotes.push_back(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick), kick, 120));
+                newNotes.push_back(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + ticksPerBeat*2), kick, 115));
                 if (complexity > 0.5) {
-                    mc->addNote(Note(TimePos(ticksPerBeat/8), TimePos(barStartTick + ticksPerBeat + ticksPerBeat/4), kick, 85), false);
-                    mc->addNote(Note(TimePos(ticksPerBeat/8), TimePos(barStartTick + ticksPerBeat*3 - ticksPerBeat/8), kick, 80), false);
+                    newNotes.push_back(Note(TimePos(ticksPerBeat/8), TimePos(barStartTick + ticksPerBeat + ticksPerBeat/4), kick, 85));
+                    newNotes.push_back(Note(TimePos(ticksPerBeat/8), TimePos(barStartTick + ticksPerBeat*3 - ticksPerBeat/8), kick, 80));
                 }
             } else {
                 // AI creates adaptive pattern based on context analysis
                 qDebug() << "AI creating adaptive kick pattern for style:" << style;
                 
                 // Base kick on 1
-                mc->addNote(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick), kick, 120), false);
+                newNotes.push_back(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick), kick, 120));
                 
                 // AI determines additional placements
                 float energy = aiParams["energy"].toDouble(0.5);
                 float groove = aiParams["groove"].toDouble(0.5);
                 
                 if (energy > 0.4) {
-                    mc->addNote(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + ticksPerBeat*2 + ticksPerBeat/2), kick, 110), false);
+                    newNotes.push_back(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + ticksPerBeat*2 + ticksPerBeat/2), kick, 110));
                 }
                 if (groove > 0.6 && complexity > 0.5) {
-                    mc->addNote(Note(TimePos(ticksPerBeat/6), TimePos(barStartTick + ticksPerBeat*3 + ticksPerBeat*3/4), kick, 95), false);
+                    newNotes.push_back(Note(TimePos(ticksPerBeat/6), TimePos(barStartTick + ticksPerBeat*3 + ticksPerBeat*3/4), kick, 95));
                 }
                 if (energy > 0.7 && bar % 4 == 3) {
-                    mc->addNote(Note(TimePos(ticksPerBeat/8), TimePos(barStartTick + ticksPerBeat*3 + ticksPerBeat/2), kick, 105), false);
+                    newNotes.push_back(Note(TimePos(ticksPerBeat/8), TimePos(barStartTick + ticksPerBeat*3 + ticksPerBeat/2), kick, 105));
                 }
             }
             
@@ -2170,73 +2309,73 @@ AiToolResult AiSidebar::toolCreateDrumPattern(const QJsonObject& p)
             // BPM-DRIVEN SNARE PATTERNS - Different patterns for different tempos
             if (currentBpm >= 160 || style.contains("dnb") || style.contains("jungle")) {
                 // DnB snare on 2 and 4 with complex ghost notes
-                mc->addNote(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + ticksPerBeat), snare, 120), false);
-                mc->addNote(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + 3 * ticksPerBeat), snare, 120), false);
+                newNotes.push_back(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + ticksPerBeat), snare, 120));
+                newNotes.push_back(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + 3 * ticksPerBeat), snare, 120));
                 
                 // Complex ghost note patterns
                 if (complexity > 0.4) {
-                    mc->addNote(Note(TimePos(ticksPerBeat/16), TimePos(barStartTick + ticksPerBeat - ticksPerBeat/8), snare, 35), false);
-                    mc->addNote(Note(TimePos(ticksPerBeat/16), TimePos(barStartTick + ticksPerBeat*3 - ticksPerBeat/8), snare, 35), false);
+                    newNotes.push_back(Note(TimePos(ticksPerBeat/16), TimePos(barStartTick + ticksPerBeat - ticksPerBeat/8), snare, 35));
+                    newNotes.push_back(Note(TimePos(ticksPerBeat/16), TimePos(barStartTick + ticksPerBeat*3 - ticksPerBeat/8), snare, 35));
                 }
                 if (complexity > 0.7) {
-                    mc->addNote(Note(TimePos(ticksPerBeat/16), TimePos(barStartTick + ticksPerBeat/2), snare, 30), false);
-                    mc->addNote(Note(TimePos(ticksPerBeat/16), TimePos(barStartTick + ticksPerBeat*2 + ticksPerBeat/4), snare, 25), false);
+                    newNotes.push_back(Note(TimePos(ticksPerBeat/16), TimePos(barStartTick + ticksPerBeat/2), snare, 30));
+                    newNotes.push_back(Note(TimePos(ticksPerBeat/16), TimePos(barStartTick + ticksPerBeat*2 + ticksPerBeat/4), snare, 25));
                 }
             } else if (currentBpm <= 90 || style.contains("trap") || style.contains("hip")) {
                 // Trap snare with triplet rolls
-                mc->addNote(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + ticksPerBeat), snare, 115), false);
-                mc->addNote(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + 3 * ticksPerBeat), snare, 115), false);
+                newNotes.push_back(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + ticksPerBeat), snare, 115));
+                newNotes.push_back(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + 3 * ticksPerBeat), snare, 115));
                 
                 // Trap rolls at high complexity
                 if (complexity > 0.6 && bar % 2 == 1) {
                     // Triplet roll before snare
                     for (int i = 0; i < 3; i++) {
                         int tick = barStartTick + ticksPerBeat - (3-i) * (ticksPerBeat/12);
-                        mc->addNote(Note(TimePos(ticksPerBeat/12), TimePos(tick), snare, 60 + i*10), false);
+                        newNotes.push_back(Note(TimePos(ticksPerBeat/12), TimePos(tick), snare, 60 + i*10));
                     }
                 }
             } else if (style == "funk" || style == "breakbeat") {
                 // Funky snare with syncopation
-                mc->addNote(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + ticksPerBeat), snare, 110), false);
-                mc->addNote(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + 3 * ticksPerBeat), snare, 110), false);
+                newNotes.push_back(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + ticksPerBeat), snare, 110));
+                newNotes.push_back(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + 3 * ticksPerBeat), snare, 110));
                 
                 // Funk ghost notes
                 if (complexity > 0.5) {
-                    mc->addNote(Note(TimePos(ticksPerBeat/16), TimePos(barStartTick + ticksPerBeat/2), snare, 40), false);
-                    mc->addNote(Note(TimePos(ticksPerBeat/16), TimePos(barStartTick + ticksPerBeat + ticksPerBeat/2 + ticksPerBeat/8), snare, 35), false);
-                    mc->addNote(Note(TimePos(ticksPerBeat/16), TimePos(barStartTick + ticksPerBeat*2 - ticksPerBeat/8), snare, 30), false);
+                    newNotes.push_back(Note(TimePos(ticksPerBeat/16), TimePos(barStartTick + ticksPerBeat/2), snare, 40));
+                    newNotes.push_back(Note(TimePos(ticksPerBeat/16), TimePos(barStartTick + ticksPerBeat + ticksPerBeat/2 + ticksPerBeat/8), snare, 35));
+                    newNotes.push_back(Note(TimePos(ticksPerBeat/16), TimePos(barStartTick + ticksPerBeat*2 - ticksPerBeat/8), snare, 30));
                 }
                 // Extra snare hit for funk groove
                 if (complexity > 0.7) {
-                    mc->addNote(Note(TimePos(ticksPerBeat/8), TimePos(barStartTick + ticksPerBeat*2 + ticksPerBeat*3/4), snare, 85), false);
+                    newNotes.push_back(Note(TimePos(ticksPerBeat/8), TimePos(barStartTick + ticksPerBeat*2 + ticksPerBeat*3/4), snare, 85));
                 }
             } else if (style == "reggaeton" || style == "dembow") {
                 // Reggaeton snare pattern
-                mc->addNote(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + ticksPerBeat*3/4), snare, 100), false);
-                mc->addNote(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + ticksPerBeat*2 + ticksPerBeat/2), snare, 110), false);
+                newNotes.push_back(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + ticksPerBeat*3/4), snare, 100));
+                newNotes.push_back(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + ticksPerBeat*2 + ticksPerBeat/2), snare, 110));
                 if (bar % 2 == 1) {
-                    mc->addNote(Note(TimePos(ticksPerBeat/8), TimePos(barStartTick + ticksPerBeat*3 + ticksPerBeat*3/4), snare, 95), false);
+                    newNotes.push_back(Note(TimePos(ticksPerBeat/8), TimePos(barStartTick + ticksPerBeat*3 + ticksPerBeat*3/4), snare, 95));
                 }
             } else {
                 // AI adaptive snare based on context
                 // Standard backbeat as foundation
-                mc->addNote(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + ticksPerBeat), snare, 110), false);
-                mc->addNote(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + 3 * ticksPerBeat), snare, 110), false);
+                newNotes.push_back(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + ticksPerBeat), snare, 110));
+                newNotes.push_back(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + 3 * ticksPerBeat), snare, 110));
                 
                 // AI adds ghost notes based on groove requirements
                 float groove = aiParams["groove"].toDouble(0.5);
                 if (groove > 0.4) {
-                    mc->addNote(Note(TimePos(ticksPerBeat/16), TimePos(barStartTick + ticksPerBeat/2), snare, 40), false);
+                    newNotes.push_back(Note(TimePos(ticksPerBeat/16), TimePos(barStartTick + ticksPerBeat/2), snare, 40));
                 }
                 if (groove > 0.6 && complexity > 0.5) {
-                    mc->addNote(Note(TimePos(ticksPerBeat/16), TimePos(barStartTick + ticksPerBeat*2 - ticksPerBeat/4), snare, 35), false);
-                    mc->addNote(Note(TimePos(ticksPerBeat/16), TimePos(barStartTick + ticksPerBeat*2 + ticksPerBeat/3), snare, 30), false);
+                    newNotes.push_back(Note(TimePos(ticksPerBeat/16), TimePos(barStartTick + ticksPerBeat*2 - ticksPerBeat/4), snare, 35));
+                    newNotes.push_back(Note(TimePos(ticksPerBeat/16), TimePos(barStartTick + ticksPerBeat*2 + ticksPerBeat/3), snare, 30));
                 }
                 // AI decides on fills
                 if (bar % 4 == 3 && aiParams["add_fills"].toBool(false)) {
                     for (int i = 0; i < 4; i++) {
                         int tick = barStartTick + ticksPerBeat*3 + i * (ticksPerBeat/4);
-                        mc->addNote(Note(TimePos(ticksPerBeat/8), TimePos(tick), snare, 70 + i*5), false);
+                        newNotes.push_back(Note(TimePos(ticksPerBeat/8), TimePos(tick), snare, 70 + i*5));
                     }
                 }
             }
@@ -2252,12 +2391,12 @@ AiToolResult AiSidebar::toolCreateDrumPattern(const QJsonObject& p)
                     // Classic disco/house off-beat open hats
                     for (int eighth = 1; eighth < 8; eighth += 2) {
                         int tick = barStartTick + eighth * (ticksPerBeat / 2);
-                        mc->addNote(Note(TimePos(ticksPerBeat/3), TimePos(tick), openhat, 75), false);
+                        newNotes.push_back(Note(TimePos(ticksPerBeat/3), TimePos(tick), openhat, 75));
                     }
                 } else if (style == "trap") {
                     // Sparse trap open hats for emphasis
                     if (bar % 2 == 0) {
-                        mc->addNote(Note(TimePos(ticksPerBeat/2), TimePos(barStartTick + ticksPerBeat*3 + ticksPerBeat/2), openhat, 70), false);
+                        newNotes.push_back(Note(TimePos(ticksPerBeat/2), TimePos(barStartTick + ticksPerBeat*3 + ticksPerBeat/2), openhat, 70));
                     }
                 } else {
                     // AI places open hats based on energy and groove
@@ -2265,7 +2404,7 @@ AiToolResult AiSidebar::toolCreateDrumPattern(const QJsonObject& p)
                     for (int beat = 0; beat < 4; beat++) {
                         if ((beat == 1 || beat == 3) && energy > 0.4) {
                             int tick = barStartTick + beat * ticksPerBeat + ticksPerBeat/2;
-                            mc->addNote(Note(TimePos(ticksPerBeat/3), TimePos(tick), openhat, 70), false);
+                            newNotes.push_back(Note(TimePos(ticksPerBeat/3), TimePos(tick), openhat, 70));
                         }
                     }
                 }
@@ -2281,11 +2420,11 @@ AiToolResult AiSidebar::toolCreateDrumPattern(const QJsonObject& p)
                             // 32nd note rolls at phrase ends
                             for (int roll = 0; roll < 4; roll++) {
                                 int rollTick = tick - (3-roll) * (ticksPerBeat / 16);
-                                mc->addNote(Note(TimePos(ticksPerBeat/32), TimePos(rollTick), hihat, 50 + roll*5), false);
+                                newNotes.push_back(Note(TimePos(ticksPerBeat/32), TimePos(rollTick), hihat, 50 + roll*5));
                             }
                         } else if (sixteenth % 2 == 0 || (complexity > 0.5 && rand() % 100 < 30)) {
                             int velocity = 70 - (sixteenth % 4) * 10;
-                            mc->addNote(Note(TimePos(ticksPerBeat/8), TimePos(tick), hihat, velocity), false);
+                            newNotes.push_back(Note(TimePos(ticksPerBeat/8), TimePos(tick), hihat, velocity));
                         }
                     }
                 } else if (style == "dnb" || style == "drum and bass") {
@@ -2294,7 +2433,7 @@ AiToolResult AiSidebar::toolCreateDrumPattern(const QJsonObject& p)
                         if (sixteenth % 2 == 0) {
                             int tick = barStartTick + sixteenth * (ticksPerBeat / 4);
                             int velocity = (sixteenth % 4 == 0) ? 75 : 55;
-                            mc->addNote(Note(TimePos(ticksPerBeat/16), TimePos(tick), hihat, velocity), false);
+                            newNotes.push_back(Note(TimePos(ticksPerBeat/16), TimePos(tick), hihat, velocity));
                         }
                     }
                 } else if (style == "house" || style == "techno" || style == "4-on-floor") {
@@ -2303,7 +2442,7 @@ AiToolResult AiSidebar::toolCreateDrumPattern(const QJsonObject& p)
                         int tick = barStartTick + sixteenth * (ticksPerBeat / 4);
                         if (sixteenth % 2 == 1) { // Off-beats
                             int velocity = (sixteenth % 4 == 1) ? 70 : 60;
-                            mc->addNote(Note(TimePos(ticksPerBeat/8), TimePos(tick), hihat, velocity), false);
+                            newNotes.push_back(Note(TimePos(ticksPerBeat/8), TimePos(tick), hihat, velocity));
                         }
                     }
                 } else if (style == "funk" || style == "disco") {
@@ -2313,7 +2452,7 @@ AiToolResult AiSidebar::toolCreateDrumPattern(const QJsonObject& p)
                         // Skip some notes for funk groove
                         if (sixteenth != 0 && sixteenth != 4 && sixteenth != 8 && sixteenth != 12) {
                             int velocity = 65 - (sixteenth % 2) * 15;
-                            mc->addNote(Note(TimePos(ticksPerBeat/8), TimePos(tick), hihat, velocity), false);
+                            newNotes.push_back(Note(TimePos(ticksPerBeat/8), TimePos(tick), hihat, velocity));
                         }
                     }
                 } else {
@@ -2330,11 +2469,11 @@ AiToolResult AiSidebar::toolCreateDrumPattern(const QJsonObject& p)
                             if (eighth % 2 == 1) velocity += 5; // Slight off-beat accent
                             if (groove > 0.6 && eighth == 3) velocity -= 10; // Ghost note for groove
                             
-                            mc->addNote(Note(TimePos(ticksPerBeat/8), TimePos(tick), hihat, velocity), false);
+                            newNotes.push_back(Note(TimePos(ticksPerBeat/8), TimePos(tick), hihat, velocity));
                             
                             // Add 16th notes at high complexity
                             if (complexity > 0.7 && eighth % 2 == 1) {
-                                mc->addNote(Note(TimePos(ticksPerBeat/16), TimePos(tick + ticksPerBeat/4), hihat, 45), false);
+                                newNotes.push_back(Note(TimePos(ticksPerBeat/16), TimePos(tick + ticksPerBeat/4), hihat, 45));
                             }
                         }
                     }
@@ -2345,22 +2484,22 @@ AiToolResult AiSidebar::toolCreateDrumPattern(const QJsonObject& p)
             // AI-DRIVEN CLAP PATTERNS
             if (style == "trap" || style == "hip-hop") {
                 // Trap clap with slight delay for groove
-                mc->addNote(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + ticksPerBeat + ticksPerBeat/16), clap, 110), false);
-                mc->addNote(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + 3 * ticksPerBeat + ticksPerBeat/16), clap, 110), false);
+                newNotes.push_back(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + ticksPerBeat + ticksPerBeat/16), clap, 110));
+                newNotes.push_back(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + 3 * ticksPerBeat + ticksPerBeat/16), clap, 110));
                 // Double clap at phrase ends
                 if (bar % 4 == 3 && complexity > 0.6) {
-                    mc->addNote(Note(TimePos(ticksPerBeat/16), TimePos(barStartTick + 3 * ticksPerBeat + ticksPerBeat/8), clap, 90), false);
+                    newNotes.push_back(Note(TimePos(ticksPerBeat/16), TimePos(barStartTick + 3 * ticksPerBeat + ticksPerBeat/8), clap, 90));
                 }
             } else if (style == "house" || style == "disco") {
                 // House clap on 2 and 4
-                mc->addNote(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + ticksPerBeat), clap, 100), false);
-                mc->addNote(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + 3 * ticksPerBeat), clap, 100), false);
+                newNotes.push_back(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + ticksPerBeat), clap, 100));
+                newNotes.push_back(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + 3 * ticksPerBeat), clap, 100));
             } else {
                 // AI adaptive clap placement
-                mc->addNote(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + ticksPerBeat), clap, 100), false);
-                mc->addNote(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + 3 * ticksPerBeat), clap, 100), false);
+                newNotes.push_back(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + ticksPerBeat), clap, 100));
+                newNotes.push_back(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + 3 * ticksPerBeat), clap, 100));
                 if (aiParams["add_variation"].toBool(false) && bar % 2 == 1) {
-                    mc->addNote(Note(TimePos(ticksPerBeat/8), TimePos(barStartTick + ticksPerBeat*2 + ticksPerBeat*3/4), clap, 75), false);
+                    newNotes.push_back(Note(TimePos(ticksPerBeat/8), TimePos(barStartTick + ticksPerBeat*2 + ticksPerBeat*3/4), clap, 75));
                 }
             }
             
@@ -2370,17 +2509,17 @@ AiToolResult AiSidebar::toolCreateDrumPattern(const QJsonObject& p)
                 // Jazz ride pattern with swing
                 for (int quarter = 0; quarter < 4; quarter++) {
                     int tick = barStartTick + quarter * ticksPerBeat;
-                    mc->addNote(Note(TimePos(ticksPerBeat/4), TimePos(tick), ride, 70), false);
+                    newNotes.push_back(Note(TimePos(ticksPerBeat/4), TimePos(tick), ride, 70));
                     // Swing 8th note
                     if (complexity > 0.4) {
-                        mc->addNote(Note(TimePos(ticksPerBeat/6), TimePos(tick + ticksPerBeat*2/3), ride, 50), false);
+                        newNotes.push_back(Note(TimePos(ticksPerBeat/6), TimePos(tick + ticksPerBeat*2/3), ride, 50));
                     }
                 }
             } else if (style == "rock" || aiParams["use_ride"].toBool(false)) {
                 // Rock ride replacing hi-hat
                 for (int eighth = 0; eighth < 8; eighth++) {
                     int tick = barStartTick + eighth * (ticksPerBeat / 2);
-                    mc->addNote(Note(TimePos(ticksPerBeat/8), TimePos(tick), ride, 65), false);
+                    newNotes.push_back(Note(TimePos(ticksPerBeat/8), TimePos(tick), ride, 65));
                 }
             }
             
@@ -2393,12 +2532,12 @@ AiToolResult AiSidebar::toolCreateDrumPattern(const QJsonObject& p)
             if (isPhraseBoundary || isTransition) {
                 int crashVelocity = 100;
                 if (bar % 16 == 0) crashVelocity = 110; // Louder on major boundaries
-                mc->addNote(Note(TimePos(ticksPerBeat*2), TimePos(barStartTick), crash, crashVelocity), false);
+                newNotes.push_back(Note(TimePos(ticksPerBeat*2), TimePos(barStartTick), crash, crashVelocity));
             }
             
             // AI adds variation crashes
             if (complexity > 0.7 && bar % 8 == 7) {
-                mc->addNote(Note(TimePos(ticksPerBeat), TimePos(barStartTick + ticksPerBeat*3 + ticksPerBeat/2), crash2, 80), false);
+                newNotes.push_back(Note(TimePos(ticksPerBeat), TimePos(barStartTick + ticksPerBeat*3 + ticksPerBeat/2), crash2, 80));
             }
             
         } else if (drumType == "tom") {
@@ -2412,13 +2551,13 @@ AiToolResult AiSidebar::toolCreateDrumPattern(const QJsonObject& p)
                     int toms[] = {tom_hi, tom_hi, tom_mid, tom_mid, tom_low, tom_low};
                     for (int i = 0; i < 6; i++) {
                         int tick = barStartTick + ticksPerBeat*3 + i * (ticksPerBeat/6);
-                        mc->addNote(Note(TimePos(ticksPerBeat/8), TimePos(tick), toms[i], 80 + i*3), false);
+                        newNotes.push_back(Note(TimePos(ticksPerBeat/8), TimePos(tick), toms[i], 80 + i*3));
                     }
                 } else {
                     // Simple tom fill
-                    mc->addNote(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + ticksPerBeat*3), tom_hi, 85), false);
-                    mc->addNote(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + ticksPerBeat*3 + ticksPerBeat/2), tom_mid, 90), false);
-                    mc->addNote(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + ticksPerBeat*3 + ticksPerBeat*3/4), tom_low, 95), false);
+                    newNotes.push_back(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + ticksPerBeat*3), tom_hi, 85));
+                    newNotes.push_back(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + ticksPerBeat*3 + ticksPerBeat/2), tom_mid, 90));
+                    newNotes.push_back(Note(TimePos(ticksPerBeat/4), TimePos(barStartTick + ticksPerBeat*3 + ticksPerBeat*3/4), tom_low, 95));
                 }
             }
             
@@ -2426,15 +2565,15 @@ AiToolResult AiSidebar::toolCreateDrumPattern(const QJsonObject& p)
             // RIMSHOT - Ghost notes and accents
             if (style == "funk" || style == "jazz") {
                 // Funk/jazz rimshot patterns
-                mc->addNote(Note(TimePos(ticksPerBeat/16), TimePos(barStartTick + ticksPerBeat - ticksPerBeat/8), rimshot, 50), false);
-                mc->addNote(Note(TimePos(ticksPerBeat/16), TimePos(barStartTick + ticksPerBeat*2 + ticksPerBeat/4), rimshot, 45), false);
-                mc->addNote(Note(TimePos(ticksPerBeat/16), TimePos(barStartTick + ticksPerBeat*3 - ticksPerBeat/8), rimshot, 50), false);
+                newNotes.push_back(Note(TimePos(ticksPerBeat/16), TimePos(barStartTick + ticksPerBeat - ticksPerBeat/8), rimshot, 50));
+                newNotes.push_back(Note(TimePos(ticksPerBeat/16), TimePos(barStartTick + ticksPerBeat*2 + ticksPerBeat/4), rimshot, 45));
+                newNotes.push_back(Note(TimePos(ticksPerBeat/16), TimePos(barStartTick + ticksPerBeat*3 - ticksPerBeat/8), rimshot, 50));
                 if (complexity > 0.6) {
-                    mc->addNote(Note(TimePos(ticksPerBeat/32), TimePos(barStartTick + ticksPerBeat/3), rimshot, 35), false);
+                    newNotes.push_back(Note(TimePos(ticksPerBeat/32), TimePos(barStartTick + ticksPerBeat/3), rimshot, 35));
                 }
             } else if (complexity > 0.5) {
                 // Subtle rimshot accents
-                mc->addNote(Note(TimePos(ticksPerBeat/16), TimePos(barStartTick + ticksPerBeat*2 - ticksPerBeat/16), rimshot, 55), false);
+                newNotes.push_back(Note(TimePos(ticksPerBeat/16), TimePos(barStartTick + ticksPerBeat*2 - ticksPerBeat/16), rimshot, 55));
             }
             
         } else if (drumType == "cowbell") {
@@ -2444,14 +2583,14 @@ AiToolResult AiSidebar::toolCreateDrumPattern(const QJsonObject& p)
                 int pattern[] = {0, 3, 6, 10, 12}; // Clave-inspired
                 for (int i = 0; i < 5; i++) {
                     int tick = barStartTick + pattern[i] * (ticksPerBeat / 4);
-                    mc->addNote(Note(TimePos(ticksPerBeat/8), TimePos(tick), cowbell, 65), false);
+                    newNotes.push_back(Note(TimePos(ticksPerBeat/8), TimePos(tick), cowbell, 65));
                 }
             } else if (aiParams["needs_more_cowbell"].toBool(true)) {
                 // Classic cowbell pattern
                 for (int quarter = 0; quarter < 4; quarter++) {
                     if (quarter % 2 == 1 || complexity > 0.6) {
                         int tick = barStartTick + quarter * ticksPerBeat + ticksPerBeat/2;
-                        mc->addNote(Note(TimePos(ticksPerBeat/8), TimePos(tick), cowbell, 60), false);
+                        newNotes.push_back(Note(TimePos(ticksPerBeat/8), TimePos(tick), cowbell, 60));
                     }
                 }
             }
@@ -2467,7 +2606,7 @@ AiToolResult AiSidebar::toolCreateDrumPattern(const QJsonObject& p)
                     int tick = barStartTick + sixteenth * (ticksPerBeat / 4);
                     if (sixteenth % 2 == 1 || (sixteenth == 0 || sixteenth == 10)) {
                         int velocity = 60 + (sixteenth == 0 ? 10 : 0);
-                        mc->addNote(Note(TimePos(ticksPerBeat/16), TimePos(tick), percNote, velocity), false);
+                        newNotes.push_back(Note(TimePos(ticksPerBeat/16), TimePos(tick), percNote, velocity));
                     }
                 }
             } else {
@@ -2477,7 +2616,7 @@ AiToolResult AiSidebar::toolCreateDrumPattern(const QJsonObject& p)
                     if (rand() % 100 < density * 100) {
                         int velocity = 50 + (sixteenth % 4 == 0 ? 15 : 0);
                         if (complexity > 0.7 && sixteenth % 8 == 4) velocity -= 15; // Ghost notes
-                        mc->addNote(Note(TimePos(ticksPerBeat/16), TimePos(tick), percNote, velocity), false);
+                        newNotes.push_back(Note(TimePos(ticksPerBeat/16), TimePos(tick), percNote, velocity));
                     }
                 }
             }
@@ -2495,7 +2634,7 @@ AiToolResult AiSidebar::toolCreateDrumPattern(const QJsonObject& p)
                     bool isAccent = (i == 0 || i == 3);
                     int note = isAccent ? drumLow : drumHigh;
                     int velocity = isAccent ? 85 : 60;
-                    mc->addNote(Note(TimePos(ticksPerBeat/8), TimePos(tick), note, velocity), false);
+                    newNotes.push_back(Note(TimePos(ticksPerBeat/8), TimePos(tick), note, velocity));
                 }
             } else {
                 // AI adaptive hand drum pattern
@@ -2505,7 +2644,7 @@ AiToolResult AiSidebar::toolCreateDrumPattern(const QJsonObject& p)
                         bool useLow = (eighth == 2 || eighth == 6);
                         int note = useLow ? drumLow : drumHigh;
                         int velocity = useLow ? 75 : 55;
-                        mc->addNote(Note(TimePos(ticksPerBeat/8), TimePos(tick), note, velocity), false);
+                        newNotes.push_back(Note(TimePos(ticksPerBeat/8), TimePos(tick), note, velocity));
                     }
                 }
             }
@@ -2526,7 +2665,7 @@ AiToolResult AiSidebar::toolCreateDrumPattern(const QJsonObject& p)
                 int tick = barStartTick + division * (ticksPerBeat / 2);
                 if (rand() % 100 < density * 100) {
                     int velocity = 55 + (division % 4 == 0 ? 10 : 0);
-                    mc->addNote(Note(TimePos(ticksPerBeat/8), TimePos(tick), percNote, velocity), false);
+                    newNotes.push_back(Note(TimePos(ticksPerBeat/8), TimePos(tick), percNote, velocity));
                 }
             }
             
@@ -2544,6 +2683,8 @@ AiToolResult AiSidebar::toolCreateDrumPattern(const QJsonObject& p)
         }
     }
     
+    mc->addNotes(newNotes, false);
+
     r.success = true;
     r.output = QString("%1 drum pattern: %2 bars").arg(style).arg(lengthBars);
     return r;
@@ -3285,6 +3426,61 @@ AiToolResult AiSidebar::toolAnalyzeBeforeWriting(const QJsonObject& p)
     return r;
 }
 
+AiToolResult AiSidebar::toolAnalyzeAudio(const QJsonObject& p)
+{
+    AiToolResult r; r.toolName = "analyze_audio";
+    
+    // Each distinct sample is analysed once, all of them in parallel
+    QList<QPair<QString, std::shared_ptr<const SampleBuffer>>> sources;
+    const QString file = p.value("file").toString();
+    if (!file.isEmpty()) {
+        sources.append({file, std::make_shared<const SampleBuffer>(file)});
+    } else {
+        auto* st = dynamic_cast<SampleTrack*>(findTrack(p.value("track_name").toString()));
+        if (!st) { r.output = "sample track or file required"; return r; }
+        for (Clip* c : st->getClips()) {
+            auto* clip = dynamic_cast<SampleClip*>(c);
+            if (!clip || !clip->sample().buffer() || clip->sample().buffer()->empty()) continue;
+            const auto buffer = clip->sample().buffer();
+            const bool known = std::any_of(sources.begin(), sources.end(),
+                [&](const auto& source) { return source.second == buffer; });
+            if (!known) sources.append({clip->sample().sampleFile(), buffer});
+        }
+    }
+    if (sources.isEmpty()) { r.output = "no audio to analyze"; return r; }
+    
+    std::vector<std::future<AudioAnalysis::Result>> pending;
+    for (const auto& source : sources) {
+        pending.push_back(AudioAnalysis::analyze(source.second));
+    }
+    
+    QJsonArray results;
+    for (int i = 0; i < sources.size(); ++i) {
+        const AudioAnalysis::Result a = pending[i].get();
+        QJsonArray chroma;
+        for (float c : a.chroma) chroma.append(c);
+        QJsonObject o;
+        o["source"] = QFileInfo(sources[i].first).fileName();
+        o["duration_s"] = a.duration;
+        o["bpm"] = a.bpm;
+        o["bpm_confidence"] = a.bpmConfidence;
+        o["onset_count"] = static_cast<int>(a.onsets.size());
+        o["key"] = a.key >= 0
+            ? QString("%1 %2").arg(AudioAnalysis::keyName(a.key), a.minor ? "minor" : "major")
+            : QString("none");
+        o["key_confidence"] = a.keyConfidence;
+        o["chroma"] = chroma;
+        o["loudness_lufs"] = a.loudness;
+        o["peak_dbfs"] = a.peak;
+        o["rms_dbfs"] = a.rms;
+        results.append(o);
+    }
+    
+    r.success = true;
+    r.output = QString::fromUtf8(QJsonDocument(results).toJson(QJsonDocument::Compact));
+    return r;
+}
+
 AiToolResult AiSidebar::toolListEffects(const QJsonObject& p)
 {
     AiToolResult r; r.toolName = "list_effects";
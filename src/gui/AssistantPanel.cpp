@@ -156,6 +156,7 @@ bool AssistantPanel::tryQuantize(const QString& text)
     for (auto* clip : it->getClips()) {
         auto* mc = dynamic_cast<MidiClip*>(clip);
         if (!mc) { continue; }
+        mc->detachNotes();
         const auto& notes = mc->notes();
         for (auto* note : notes) {
             note->quantizePos(ticks);
@@ -274,6 +275,7 @@ bool AssistantPanel::transposeInstrumentTrack(InstrumentTrack* track, int semito
     for (auto* clip : track->getClips()) {
         auto* mc = dynamic_cast<MidiClip*>(clip);
         if (!mc) { continue; }
+        mc->detachNotes();
         const auto& notes = mc->notes();
         for (auto* note : notes) {
             note->setKey(note->key() + semitones);
@@ -309,6 +311,7 @@ bool AssistantPanel::addEffectToInstrumentTrack(InstrumentTrack* track, const QS
 // Simple style macros
 static void adjustNoteVelocities(lmms::MidiClip* mc, int delta)
 {
+    mc->detachNotes();
     const auto& notes = mc->notes();
     for (auto* note : notes) {
         note->setVolume(std::clamp<volume_t>(note->getVolume() + delta, MinVolume, MaxVolume));
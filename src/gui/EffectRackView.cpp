@@ -35,6 +35,7 @@
 #include "EffectSelectDialog.h"
 #include "EffectView.h"
 #include "GroupBox.h"
+#include "LedCheckBox.h"
 
 
 namespace lmms::gui
@@ -69,6 +70,11 @@ EffectRackView::EffectRackView( EffectChain* model, QWidget* parent ) :
 
 	effectsLayout->addWidget( addButton );
 
+	m_pipelinedCheckBox = new LedCheckBox(tr("Pipeline"), this);
+	m_pipelinedCheckBox->setToolTip(tr("Process the effects on several threads, "
+		"which delays the output by one buffer for every additional thread"));
+	effectsLayout->addWidget(m_pipelinedCheckBox);
+
 	connect( addButton, SIGNAL(clicked()), this, SLOT(addEffect()));
 
 
@@ -269,6 +275,7 @@ void EffectRackView::modelChanged()
 {
 	//clearViews();
 	m_effectsGroupBox->setModel( &fxChain()->m_enabledModel );
+	m_pipelinedCheckBox->setModel(&fxChain()->m_pipelinedModel);
 	connect( fxChain(), SIGNAL(aboutToClear()), this, SLOT(clearViews()));
 	update();
 }
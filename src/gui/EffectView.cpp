@@ -32,6 +32,7 @@
 #include "EffectView.h"
 #include "DummyEffect.h"
 #include "CaptionMenu.h"
+#include "CpuUsageLabel.h"
 #include "embed.h"
 #include "GuiApplication.h"
 #include "FontHelper.h"
@@ -74,6 +75,10 @@ EffectView::EffectView( Effect * _model, QWidget * _parent ) :
 	m_autoQuit->setEnabled(isEnabled && effect()->autoQuitEnabled());
 	m_autoQuit->setHintText( tr( "Time:" ), "ms" );
 
+	auto cpuUsage = new CpuUsageLabel([effect = effect()] { return effect->cpuTime().total(); }, this);
+	cpuUsage->setFixedHeight(16);
+	cpuUsage->move(114, 16);
+
 	setModel( _model );
 
 	if( effect()->controls()->controlCount() > 0 )
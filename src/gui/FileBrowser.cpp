@@ -62,8 +62,8 @@
 #include "SamplePlayHandle.h"
 #include "SampleTrack.h"
 #include "Song.h"
+#include "StartupScheduler.h"
 #include "StringPairDrag.h"
-#include "TextFloat.h"
 #include "ThreadPool.h"
 #include "embed.h"
 
@@ -141,7 +141,8 @@ FileBrowser::FileBrowser(Type type, const QString& directories, const QString& f
 		});
 	}
 
-	reloadTree();
+	// listing the directories isn't needed to show the main window
+	StartupScheduler::defer(title, this, [this] { reloadTree(); });
 	show();
 }
 
@@ -203,11 +204,21 @@ void FileBrowser::restoreDirectoriesStates()
 	expandItems(m_savedExpandedDirs);
 }
 
-void FileBrowser::foundSearchMatch(FileSearch* search, const QString& match)
+void FileBrowser::foundSearchMatches(FileSearch* search, const QStringList& matches)
 {
 	assert(search != nullptr);
 	if (m_currentSearch.get() != search) { return; }
 
+	m_searchTreeWidget->setUpdatesEnabled(false);
+	for (const auto& match : matches)
+	{
+		addSearchMatch(match);
+	}
+	m_searchTreeWidget->setUpdatesEnabled(true);
+}
+
+void FileBrowser::addSearchMatch(const QString& match)
+{
 	auto basePath = QString{};
 	for (const auto& path : m_directories.split('*'))
 	{
@@ -228,19 +239,8 @@ void FileBrowser::foundSearchMatch(FileSearch* search, const QString& match)
 
 	for (const auto& pathPart : pathParts)
 	{
-		auto childCount = currentItem ? currentItem->childCount() : m_searchTreeWidget->topLevelItemCount();
-		auto childItem = static_cast<QTreeWidgetItem*>(nullptr);
-
-		for (int i = 0; i < childCount; ++i)
-		{
-			auto item = currentItem ? currentItem->child(i) : m_searchTreeWidget->topLevelItem(i);
-			if (item->text(0) == pathPart)
-			{
-				childItem = item;
-				break;
-			}
-
-		}
+		const auto itemPath = currentDir.filePath(pathPart);
+		auto childItem = m_searchItems.value(itemPath);
 
 		if (!childItem)
 		{
@@ -263,6 +263,7 @@ void FileBrowser::foundSearchMatch(FileSearch* search, const QString& match)
 				currentItem ? currentItem->addChild(item) : m_searchTreeWidget->addTopLevelItem(item);
 				childItem = item;
 			}
+			m_searchItems.insert(itemPath, childItem);
 		}
 
 		currentItem = childItem;
@@ -275,6 +276,7 @@ void FileBrowser::searchCompleted(FileSearch* search)
 	assert(search != nullptr);
 	if (m_currentSearch.get() != search) { return; }
 
+	m_searchIndex = search->index();
 	m_currentSearch.reset();
 	m_searchIndicator->setMaximum(100);
 }
@@ -295,6 +297,7 @@ void FileBrowser::onSearch(const QString& filter)
 	if (directories.isEmpty()) { return; }
 
 	m_searchTreeWidget->clear();
+	m_searchItems.clear();
 	displaySearch(true);
 
 	auto browserExtensions = m_filter;
@@ -302,7 +305,17 @@ void FileBrowser::onSearch(const QString& filter)
 
 	auto search = std::make_shared<FileSearch>(
 		filter, directories, searchExtensions, excludedPaths(), dirFilters(), sortFlags());
-	connect(search.get(), &FileSearch::foundMatch, this, &FileBrowser::foundSearchMatch, Qt::QueuedConnection);
+
+	// after the first search, the others only go through the entries it found
+	const auto searchPaths = directories.join('*');
+	if (m_searchIndex && searchPaths == m_searchIndexPaths) { search->setIndex(m_searchIndex); }
+	else
+	{
+		m_searchIndex.reset();
+		m_searchIndexPaths = searchPaths;
+	}
+
+	connect(search.get(), &FileSearch::foundMatches, this, &FileBrowser::foundSearchMatches, Qt::QueuedConnection);
 	connect(search.get(), &FileSearch::searchCompleted, this, &FileBrowser::searchCompleted, Qt::QueuedConnection);
 
 	m_currentSearch = search;
@@ -333,6 +346,8 @@ void FileBrowser::reloadTree()
 	}
 
 	m_fileBrowserTreeWidget->clear();
+	// the files may have changed since the last search
+	m_searchIndex.reset();
 
 	auto paths = m_directories.isEmpty() ? QStringList{} : m_directories.split('*');
 
@@ -803,19 +818,14 @@ void FileBrowserTreeWidget::previewFileItem(FileItem* file)
 	// handling() rather than directly creating a SamplePlayHandle
 	if (file->type() == FileItem::FileType::Sample)
 	{
-		TextFloat * tf = TextFloat::displayMessage(
-			tr("Loading sample"),
-			tr("Please wait, loading sample for preview..."),
-			embed::getIconPixmap("sample_file", 24, 24), 0);
-		// TODO: this can be removed once we do this outside the event thread
-		qApp->processEvents(QEventLoop::ExcludeUserInputEvents);
-		if (auto buffer = SampleLoader::createBufferFromFile(fileName))
+		// only the beginning is decoded before playing, the rest is
+		// decoded in the background and streamed from disk
+		if (auto buffer = SampleLoader::createBufferFromFile(fileName, SampleBuffer::Decoding::Streaming))
 		{
 			auto s = new SamplePlayHandle(new lmms::Sample{std::move(buffer)});
 			s->setDoneMayReturnTrue(false);
 			newPPH = s;
 		}
-		delete tf;
 	}
 	else if (
 		(ext == "xiz" || ext == "sf2" || ext == "sf3" ||
@@ -1247,7 +1257,7 @@ void FileItem::determineFileType()
 	m_handling = FileHandling::NotSupported;
 
 	const QString ext = extension();
-	if( ext == "mmp" || ext == "mpt" || ext == "mmpz" )
+	if( ext == "mmp" || ext == "mpt" || ext == "mmpz" || ext == "mmpb" )
 	{
 		m_type = FileType::Project;
 		m_handling = FileHandling::LoadAsProject;
@@ -1331,7 +1341,7 @@ QString FileItem::extension(const QString & file )
 
 QString FileItem::defaultFilters()
 {
-	const auto projectFilters = QStringList{"*.mmp", "*.mpt", "*.mmpz"};
+	const auto projectFilters = QStringList{"*.mmp", "*.mpt", "*.mmpz", "*.mmpb"};
 	const auto presetFilters = QStringList{"*.xpf", "*.xml", "*.xiz", "*.lv2"};
 	const auto soundFontFilters = QStringList{"*.sf2", "*.sf3"};
 	const auto patchFilters = QStringList{"*.pat"};
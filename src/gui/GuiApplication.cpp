@@ -39,6 +39,7 @@
 #include "PianoRoll.h"
 #include "ProjectNotes.h"
 #include "SongEditor.h"
+#include "StartupScheduler.h"
 
 #include <QApplication>
 #include <QDebug>
@@ -103,6 +104,7 @@ GuiApplication::GuiApplication()
 		ConfigManager::inst()->createWorkingDir();
 	}
 	// Init style and palette
+	StartupScheduler::beginPhase(tr("Loading theme"));
 	QDir::addSearchPath("artwork", ConfigManager::inst()->themeDir());
 	QDir::addSearchPath("artwork", ConfigManager::inst()->defaultThemeDir());
 	QDir::addSearchPath("artwork", ":/artwork");
@@ -207,7 +209,8 @@ GuiApplication::~GuiApplication()
 void GuiApplication::displayInitProgress(const QString &msg)
 {
 	Q_ASSERT(m_loadingProgressLabel != nullptr);
-	
+
+	StartupScheduler::beginPhase(msg);
 	m_loadingProgressLabel->setText(msg);
 	// must force a UI update and process events, as there may be long gaps between processEvents() calls during init
 	m_loadingProgressLabel->repaint();
@@ -27,18 +27,25 @@
 #include <QApplication>
 #include <QCloseEvent>
 #include <QDesktopServices>
+#include <QDialog>
+#include <QDialogButtonBox>
 #include <QDomElement>
 #include <QFileInfo>
+#include <QLabel>
 #include <QMdiArea>
 #include <QMenuBar>
 #include <QMessageBox>
+#include <QPushButton>
 #include <QShortcut>
 #include <QSplitter>
+#include <QTreeWidget>
+#include <QVBoxLayout>
 
 #include "AboutDialog.h"
 #include "AiSidebar.h"
 #include "AutomationEditor.h"
 #include "ControllerRackView.h"
+#include "DataFile.h"
 #include "DeprecationHelper.h"
 #include "embed.h"
 #include "Engine.h"
@@ -51,8 +58,10 @@
 #include "ImportFilter.h"
 #include "InstrumentTrackView.h"
 #include "InstrumentTrackWindow.h"
+#include "MemoryReport.h"
 #include "MicrotunerConfig.h"
 #include "PatternEditor.h"
+#include "PerfLog.h"
 #include "PianoRoll.h"
 #include "PianoView.h"
 #include "PluginBrowser.h"
@@ -71,6 +80,7 @@
 #include "SubWindow.h"
 #include "TemplatesMenu.h"
 #include "TextFloat.h"
+#include "ThreadPool.h"
 #include "ToolButton.h"
 #include "ToolPlugin.h"
 #include "VersionedSaveDialog.h"
@@ -121,7 +131,7 @@ MainWindow::MainWindow() :
 		embed::getIconPixmap("star").transformed(QTransform().rotate(90)), splitter, false, "", ""));
 
 	sideBar->appendTab(new FileBrowser(FileBrowser::Type::Normal,
-		confMgr->userProjectsDir() + "*" + confMgr->factoryProjectsDir(), "*.mmp *.mmpz *.xml *.mid *.mpt",
+		confMgr->userProjectsDir() + "*" + confMgr->factoryProjectsDir(), "*.mmp *.mmpz *.mmpb *.xml *.mid *.mpt",
 		tr("My Projects"), embed::getIconPixmap("project_file").transformed(QTransform().rotate(90)), splitter, false,
 		confMgr->userProjectsDir(), confMgr->factoryProjectsDir()));
 
@@ -417,6 +427,9 @@ void MainWindow::finalize()
 							this, SLOT(help()));
 	}
 
+	help_menu->addAction(tr("Project load report"), this, SLOT(showLoadReport()));
+	help_menu->addAction(tr("Memory report"), this, SLOT(showMemoryReport()));
+
 	help_menu->addSeparator();
 	help_menu->addAction( embed::getIconPixmap( "icon_small" ), tr( "About" ),
 				  this, SLOT(aboutLMMS()));
@@ -774,7 +787,7 @@ void MainWindow::openProject()
 {
 	if( mayChangeProject(false) )
 	{
-		FileDialog ofd( this, tr( "Open Project" ), "", tr( "LMMS (*.mmp *.mmpz)" ) );
+		FileDialog ofd( this, tr( "Open Project" ), "", tr( "LMMS (*.mmp *.mmpz *.mmpb)" ) );
 
 		ofd.setDirectory( ConfigManager::inst()->userProjectsDir() );
 		ofd.setFileMode( FileDialog::ExistingFiles );
@@ -819,6 +832,7 @@ bool MainWindow::saveProjectAs()
 	auto optionsWidget = new SaveOptionsWidget(Engine::getSong()->getSaveOptions());
 	VersionedSaveDialog sfd( this, optionsWidget, tr( "Save Project" ), "",
 			tr( "LMMS Project" ) + " (*.mmpz *.mmp);;" +
+				tr( "LMMS Binary Project" ) + " (*.mmpb);;" +
 				tr( "LMMS Project Template" ) + " (*.mpt)" );
 	QString f = Engine::getSong()->projectFileName();
 	if( f != "" )
@@ -842,6 +856,11 @@ bool MainWindow::saveProjectAs()
 		!sfd.selectedFiles().isEmpty() && sfd.selectedFiles()[0] != "" )
 	{
 		QString fname = sfd.selectedFiles()[0] ;
+		if( sfd.selectedNameFilter().contains( "(*.mmpb)" ) && !fname.endsWith( ".mmpb" ) )
+		{
+			fname.remove( "." + suffix );
+			fname += ".mmpb";
+		}
 		if( sfd.selectedNameFilter().contains( "(*.mpt)" ) )
 		{
 			// Remove the default suffix
@@ -943,6 +962,86 @@ void MainWindow::help()
 
 
 
+void MainWindow::showLoadReport()
+{
+	const QString title = PerfLogReport::title();
+	if (title.isEmpty())
+	{
+		QMessageBox::information(this, tr("Project load report"), tr("No project has been loaded yet."));
+		return;
+	}
+
+	QMessageBox box(this);
+	box.setWindowTitle(tr("Project load report"));
+	box.setIcon(QMessageBox::Information);
+	box.setText(tr("The details show the time spent in each stage of loading %1. "
+		"Please attach them when reporting projects which load slowly.").arg(QFileInfo(title).fileName()));
+	box.setDetailedText(PerfLogReport::toString());
+	box.exec();
+}
+
+
+
+
+void MainWindow::showMemoryReport()
+{
+	auto dialog = new QDialog(this);
+	dialog->setAttribute(Qt::WA_DeleteOnClose);
+	dialog->setWindowTitle(tr("Memory report"));
+
+	auto tree = new QTreeWidget(dialog);
+	tree->setHeaderLabels({tr("Name"), tr("Memory")});
+
+	// collected again on request, e.g. after freezing tracks
+	const auto refresh = [tree] {
+		using Category = MemoryReport::Category;
+		const auto report = MemoryReport::collect();
+		const auto addItem = [](QTreeWidgetItem* item, const QString& name, std::size_t bytes) {
+			item->setText(0, name);
+			item->setText(1, MemoryReport::formatBytes(bytes));
+			item->setTextAlignment(1, Qt::AlignRight);
+			return item;
+		};
+
+		tree->clear();
+		for (auto c = std::size_t{0}; c < static_cast<std::size_t>(Category::Count); ++c)
+		{
+			const auto category = static_cast<Category>(c);
+			auto categoryItem = addItem(new QTreeWidgetItem(tree), MemoryReport::categoryName(category),
+				report.total(category));
+			for (const auto& entry : report.entries())
+			{
+				if (entry.category == category)
+				{
+					addItem(new QTreeWidgetItem(categoryItem), entry.name, entry.bytes);
+				}
+			}
+		}
+		addItem(new QTreeWidgetItem(tree), tr("Total"), report.total());
+		tree->resizeColumnToContents(0);
+	};
+	refresh();
+
+	auto buttons = new QDialogButtonBox(QDialogButtonBox::Close, dialog);
+	connect(buttons->addButton(tr("Refresh"), QDialogButtonBox::ActionRole), &QPushButton::clicked, dialog, refresh);
+	connect(buttons, &QDialogButtonBox::rejected, dialog, &QDialog::close);
+
+	auto note = new QLabel(tr("Memory used by the current project, as far as each part of LMMS can tell. "
+		"Plugins which don't report their memory aren't listed."), dialog);
+	note->setWordWrap(true);
+
+	auto layout = new QVBoxLayout(dialog);
+	layout->addWidget(note);
+	layout->addWidget(tree);
+	layout->addWidget(buttons);
+
+	dialog->resize(640, 480);
+	dialog->show();
+}
+
+
+
+
 void MainWindow::toggleWindow( QWidget *window, bool forceShow )
 {
 	QWidget *parent = window->parentWidget();
@@ -1133,6 +1232,12 @@ void MainWindow::updateViewMenu()
 	qa->setChecked( ConfigManager::inst()->value( "ui", "printnotelabels" ).toInt() );
 	m_viewMenu->addAction(qa);
 
+	qa = new QAction(tr("Show CPU usage of tracks and effects"), this);
+	qa->setData("showcpuusage");
+	qa->setCheckable(true);
+	qa->setChecked(ConfigManager::inst()->value("ui", "showcpuusage").toInt());
+	m_viewMenu->addAction(qa);
+
 }
 
 
@@ -1167,6 +1272,10 @@ void MainWindow::updateConfig( QAction * _who )
 		ConfigManager::inst()->setValue( "ui", "printnotelabels",
 						 QString::number(checked) );
 	}
+	else if (tag == "showcpuusage")
+	{
+		ConfigManager::inst()->setValue("ui", "showcpuusage", QString::number(checked));
+	}
 }
 
 
@@ -1288,7 +1397,11 @@ void MainWindow::closeEvent( QCloseEvent * _ce )
 
 void MainWindow::sessionCleanup()
 {
-	// delete recover session files
+	// delete recover session files, after a running autosave wrote them
+	if( m_autoSaveResult.valid() )
+	{
+		m_autoSaveResult.wait();
+	}
 	QFile::remove( ConfigManager::inst()->recoveryFile() );
 	setSession( SessionState::Normal );
 }
@@ -1427,7 +1540,12 @@ void MainWindow::browseHelp()
 
 void MainWindow::autoSave()
 {
-	if( !Engine::getSong()->isExporting() &&
+	// the previous autosave may still be writing on a slow disk
+	const bool writing = m_autoSaveResult.valid()
+		&& m_autoSaveResult.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+
+	if( !writing &&
+		!Engine::getSong()->isExporting() &&
 		!Engine::getSong()->isLoadingProject() &&
 		!RemotePluginBase::isMainThreadWaiting() &&
 		!QApplication::mouseButtons() &&
@@ -1435,7 +1553,13 @@ void MainWindow::autoSave()
 				"enablerunningautosave" ).toInt() ||
 			! Engine::getSong()->isPlaying() ) )
 	{
-		Engine::getSong()->saveProjectFile(ConfigManager::inst()->recoveryFile());
+		// only taking the snapshot blocks editing, serializing, compressing
+		// and writing it happen on a worker thread
+		auto snapshot = std::make_shared<DataFile>(Engine::getSong()->projectSnapshot());
+		m_autoSaveResult = ThreadPool::instance().enqueue(
+			[snapshot, fileName = ConfigManager::inst()->recoveryFile()] {
+				return snapshot->writeFileAtomically(fileName);
+			});
 		autoSaveTimerReset();  // Reset timer
 	}
 	else
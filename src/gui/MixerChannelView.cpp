@@ -40,6 +40,7 @@
 #include "CaptionMenu.h"
 #include "ColorChooser.h"
 #include "ConfigManager.h"
+#include "CpuUsageLabel.h"
 #include "EffectRackView.h"
 #include "Fader.h"
 #include "FontHelper.h"
@@ -139,6 +140,9 @@ MixerChannelView::MixerChannelView(QWidget* parent, MixerView* mixerView, int ch
 	m_peakIndicator = new PeakIndicator(this);
 	connect(m_fader, &Fader::peakChanged, m_peakIndicator, &PeakIndicator::updatePeak);
 
+	// summing up the senders, the effects and the fader
+	auto cpuUsage = new CpuUsageLabel{[this] { return mixerChannel()->m_cpuTime.total(); }, this};
+
 	m_effectRackView = new EffectRackView{&mixerChannel->m_fxChain, mixerView->m_racksWidget};
 	m_effectRackView->setFixedWidth(EffectRackView::DEFAULT_WIDTH);
 
@@ -153,6 +157,7 @@ MixerChannelView::MixerChannelView(QWidget* parent, MixerView* mixerView, int ch
 	mainLayout->addWidget(m_renameLineEditView, 0, Qt::AlignHCenter);
 	mainLayout->addLayout(soloMuteLayout);
 	mainLayout->addWidget(m_peakIndicator);
+	mainLayout->addWidget(cpuUsage, 0, Qt::AlignHCenter);
 	mainLayout->addWidget(m_fader, 1, Qt::AlignHCenter);
 
 	connect(m_renameLineEdit, &QLineEdit::editingFinished, this, &MixerChannelView::renameFinished);
@@ -33,6 +33,7 @@
 #include <QKeyEvent>
 #include <QStackedLayout>
 #include <QStackedWidget>
+#include <algorithm>
 
 #include "EffectRackView.h"
 #include "Engine.h"
@@ -595,30 +596,21 @@ void MixerView::updateFaders()
 
 	for (int i = 0; i < m_mixerChannelViews.size(); ++i)
 	{
-		const float opl = m_mixerChannelViews[i]->m_fader->getPeak_L();
-		const float opr = m_mixerChannelViews[i]->m_fader->getPeak_R();
-		const float fallOff = 1.25;
-		if (m->mixerChannel(i)->m_peakLeft >= opl/fallOff)
-		{
-			m_mixerChannelViews[i]->m_fader->setPeak_L(m->mixerChannel(i)->m_peakLeft);
-			// Set to -1 so later we'll know if this value has been refreshed yet.
-			m->mixerChannel(i)->m_peakLeft = -1;
-		}
-		else if (m->mixerChannel(i)->m_peakLeft != -1)
-		{
-			m_mixerChannelViews[i]->m_fader->setPeak_L(opl/fallOff);
-		}
+		MixerChannelView* view = m_mixerChannelViews[i];
+		MixerChannel* channel = m->mixerChannel(i);
 
-		if (m->mixerChannel(i)->m_peakRight >= opr/fallOff)
-		{
-			m_mixerChannelViews[i]->m_fader->setPeak_R(m->mixerChannel(i)->m_peakRight);
-			// Set to -1 so later we'll know if this value has been refreshed yet.
-			m->mixerChannel(i)->m_peakRight = -1;
-		}
-		else if (m->mixerChannel(i)->m_peakRight != -1)
-		{
-			m_mixerChannelViews[i]->m_fader->setPeak_R(opr/fallOff);
-		}
+		// the levels of channels scrolled out of view or hidden aren't measured
+		const bool visible = isVisible() && !view->visibleRegion().isEmpty();
+		channel->setMetered(visible);
+
+		auto levels = MixerChannel::Levels{};
+		if (!visible || !channel->readLevels(levels)) { continue; }
+
+		const float opl = view->m_fader->getPeak_L();
+		const float opr = view->m_fader->getPeak_R();
+		const float fallOff = 1.25;
+		view->m_fader->setPeak_L(std::max(levels.peak[0], opl / fallOff));
+		view->m_fader->setPeak_R(std::max(levels.peak[1], opr / fallOff));
 	}
 }
 
@@ -0,0 +1,139 @@
+/*
+ * ModelChangeNotifier.cpp - passes changes of models made by other threads on to views at display rate
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "ModelChangeNotifier.h"
+
+#include <QCoreApplication>
+#include <QThread>
+#include <bit>
+
+#include "Model.h"
+
+namespace lmms::gui
+{
+
+namespace
+{
+
+constexpr auto BitsPerWord = std::size_t{64};
+
+//! Same rate as MainWindow::periodicUpdate()
+constexpr auto RefreshInterval = 1000 / 60;
+
+} // namespace
+
+
+ModelChangeNotifier::ModelChangeNotifier() :
+	QObject(QCoreApplication::instance())
+{
+	connect(&m_timer, &QTimer::timeout, this, &ModelChangeNotifier::collect);
+	m_timer.start(RefreshInterval);
+}
+
+
+
+
+auto ModelChangeNotifier::instance() -> ModelChangeNotifier&
+{
+	// owned by the application, so it goes away together with the views
+	static auto s_instance = new ModelChangeNotifier;
+	return *s_instance;
+}
+
+
+
+
+void ModelChangeNotifier::connectDataChanged(Model* model, QObject* receiver, std::function<void()> update)
+{
+	auto& notifier = instance();
+	const auto bit = notifier.bitOf(receiver);
+	notifier.m_receivers[bit].update = std::move(update);
+
+	auto& word = notifier.m_changed[bit / BitsPerWord];
+	const auto mask = std::uint64_t{1} << (bit % BitsPerWord);
+	const auto thread = receiver->thread();
+	connect(model, &Model::dataChanged, receiver, [&notifier, &word, mask, bit, thread] {
+		if (QThread::currentThread() == thread) { notifier.m_receivers[bit].update(); }
+		else { word.fetch_or(mask, std::memory_order_relaxed); }
+	}, Qt::DirectConnection);
+}
+
+
+
+
+auto ModelChangeNotifier::bitOf(QObject* object) -> std::size_t
+{
+	if (const auto it = m_bits.find(object); it != m_bits.end()) { return it->second; }
+
+	auto bit = m_receivers.size();
+	if (!m_freeBits.empty())
+	{
+		bit = m_freeBits.back();
+		m_freeBits.pop_back();
+	}
+	else
+	{
+		m_receivers.emplace_back();
+		if (bit % BitsPerWord == 0) { m_changed.emplace_back(0); }
+	}
+
+	m_receivers[bit].object = object;
+	m_bits.emplace(object, bit);
+	connect(object, &QObject::destroyed, this, [this, object] { release(object); });
+	return bit;
+}
+
+
+
+
+void ModelChangeNotifier::release(QObject* object)
+{
+	const auto it = m_bits.find(object);
+	if (it == m_bits.end()) { return; }
+
+	// a change set in between only leads to an unnecessary update of the next receiver
+	const auto bit = it->second;
+	m_changed[bit / BitsPerWord].fetch_and(~(std::uint64_t{1} << (bit % BitsPerWord)), std::memory_order_relaxed);
+	m_receivers[bit] = Receiver{};
+	m_freeBits.push_back(bit);
+	m_bits.erase(it);
+}
+
+
+
+
+void ModelChangeNotifier::collect()
+{
+	for (std::size_t word = 0; word < m_changed.size(); ++word)
+	{
+		auto changed = m_changed[word].exchange(0, std::memory_order_relaxed);
+		while (changed != 0)
+		{
+			const auto& receiver = m_receivers[word * BitsPerWord + std::countr_zero(changed)];
+			if (receiver.update) { receiver.update(); }
+			changed &= changed - 1;
+		}
+	}
+}
+
+
+} // namespace lmms::gui
@@ -0,0 +1,260 @@
+#include "ProjectStateObserver.h"
+#include "Song.h"
+#include "Track.h"
+#include "Clip.h"
+#include "TimePos.h"
+
+#include <QJsonArray>
+#include <algorithm>
+
+namespace lmms::gui
+{
+
+namespace
+{
+
+QString trackTypeName(Track::Type type)
+{
+    switch (type) {
+    case Track::Type::Instrument: return "instrument";
+    case Track::Type::Pattern: return "pattern";
+    case Track::Type::Sample: return "sample";
+    case Track::Type::Automation:
+    case Track::Type::HiddenAutomation: return "automation";
+    default: return "other";
+    }
+}
+
+} // namespace
+
+ProjectStateObserver::ProjectStateObserver(Song* song, QObject* parent)
+    : QObject(parent)
+    , m_song(song)
+{
+    connect(m_song, &Song::tempoChanged, this, &ProjectStateObserver::markSongDirty);
+    connect(m_song, &Song::lengthChanged, this, &ProjectStateObserver::markSongDirty);
+    connect(m_song, &Song::timeSignatureChanged, this, [this]() {
+        // The end bars of all tracks depend on the bar length
+        markSongDirty();
+        for (auto it = m_trackIds.cbegin(); it != m_trackIds.cend(); ++it) {
+            markTrackDirty(it.key());
+        }
+    });
+    connect(m_song, &Song::trackAdded, this, [this](Track* track) {
+        observeTrack(track);
+        markTrackDirty(track);
+    });
+    connect(m_song, &Song::projectLoaded, this, &ProjectStateObserver::resync);
+
+    for (Track* track : m_song->tracks()) {
+        observeTrack(track);
+        markTrackDirty(track);
+    }
+}
+
+quint64 ProjectStateObserver::version()
+{
+    flush();
+    return m_version;
+}
+
+QJsonObject ProjectStateObserver::digest()
+{
+    flush();
+
+    QJsonObject tracks;
+    for (auto it = m_trackEntries.cbegin(); it != m_trackEntries.cend(); ++it) {
+        tracks[it.key()] = it.value();
+    }
+
+    return QJsonObject{
+        {"version", static_cast<qint64>(m_version)},
+        {"song", m_songEntry},
+        {"tracks", tracks}
+    };
+}
+
+QJsonObject ProjectStateObserver::deltaSince(quint64 since)
+{
+    flush();
+
+    if (since == 0 || since < m_base) {
+        QJsonObject full = digest();
+        full["full"] = true;
+        return full;
+    }
+
+    QJsonObject delta{
+        {"version", static_cast<qint64>(m_version)},
+        {"since", static_cast<qint64>(since)}
+    };
+
+    if (m_songVersion > since) {
+        delta["song"] = m_songEntry;
+    }
+
+    QJsonObject tracks;
+    for (auto it = m_trackVersions.cbegin(); it != m_trackVersions.cend(); ++it) {
+        if (it.value() > since) {
+            tracks[it.key()] = m_trackEntries.value(it.key());
+        }
+    }
+    if (!tracks.isEmpty()) {
+        delta["tracks"] = tracks;
+    }
+
+    QJsonArray removed;
+    for (auto it = m_removedTracks.cbegin(); it != m_removedTracks.cend(); ++it) {
+        if (it.value() > since) {
+            removed.append(it.key());
+        }
+    }
+    if (!removed.isEmpty()) {
+        delta["removed_tracks"] = removed;
+    }
+
+    return delta;
+}
+
+QStringList ProjectStateObserver::trackNames()
+{
+    flush();
+
+    QStringList names;
+    for (Track* track : m_song->tracks()) {
+        names.append(m_trackEntries.value(trackKey(track)).value("name").toString());
+    }
+    return names;
+}
+
+void ProjectStateObserver::observeTrack(Track* track)
+{
+    if (m_trackIds.contains(track)) { return; }
+    m_trackIds.insert(track, m_nextTrackId++);
+
+    connect(track, &Track::nameChanged, this, [this, track]() { markTrackDirty(track); });
+    connect(track, &Track::clipAdded, this, [this, track](Clip* clip) {
+        observeClip(track, clip);
+        markTrackDirty(track);
+    });
+    connect(track, &Track::destroyedTrack, this, [this, track]() { forgetTrack(track); });
+
+    for (Clip* clip : track->getClips()) {
+        observeClip(track, clip);
+    }
+}
+
+void ProjectStateObserver::observeClip(Track* track, Clip* clip)
+{
+    // Clips are destroyed after their track, so only tracks still around are marked
+    const auto changed = [this, track]() {
+        if (m_trackIds.contains(track)) { markTrackDirty(track); }
+    };
+    connect(clip, &Clip::lengthChanged, this, changed);
+    connect(clip, &Clip::positionChanged, this, changed);
+    connect(clip, &Clip::destroyedClip, this, changed);
+}
+
+void ProjectStateObserver::forgetTrack(Track* track)
+{
+    const QString key = trackKey(track);
+    m_trackIds.remove(track);
+    m_dirtyTracks.remove(track);
+
+    if (m_trackEntries.remove(key) > 0) {
+        m_trackVersions.remove(key);
+        m_removedTracks.insert(key, ++m_version);
+        if (!m_notified) {
+            m_notified = true;
+            emit stateChanged();
+        }
+    }
+}
+
+void ProjectStateObserver::markSongDirty()
+{
+    m_songDirty = true;
+    if (!m_notified) {
+        m_notified = true;
+        emit stateChanged();
+    }
+}
+
+void ProjectStateObserver::markTrackDirty(Track* track)
+{
+    m_dirtyTracks.insert(track);
+    if (!m_notified) {
+        m_notified = true;
+        emit stateChanged();
+    }
+}
+
+void ProjectStateObserver::resync()
+{
+    // Deltas from before the load would mostly consist of removals
+    m_base = ++m_version;
+    m_removedTracks.clear();
+
+    for (Track* track : m_song->tracks()) {
+        observeTrack(track);
+        markTrackDirty(track);
+    }
+    markSongDirty();
+}
+
+void ProjectStateObserver::flush()
+{
+    m_notified = false;
+
+    if (m_songDirty) {
+        m_songDirty = false;
+        const QJsonObject entry = songEntry();
+        if (entry != m_songEntry) {
+            m_songEntry = entry;
+            m_songVersion = ++m_version;
+        }
+    }
+
+    for (Track* track : m_dirtyTracks) {
+        const QString key = trackKey(track);
+        const QJsonObject entry = trackEntry(track);
+        if (!m_trackEntries.contains(key) || m_trackEntries.value(key) != entry) {
+            m_trackEntries.insert(key, entry);
+            m_trackVersions.insert(key, ++m_version);
+        }
+    }
+    m_dirtyTracks.clear();
+}
+
+QJsonObject ProjectStateObserver::songEntry() const
+{
+    return QJsonObject{
+        {"tempo", m_song->getTempo()},
+        {"time_signature", QString("%1/%2")
+            .arg(m_song->getTimeSigModel().getNumerator())
+            .arg(m_song->getTimeSigModel().getDenominator())},
+        {"length_bars", m_song->length()}
+    };
+}
+
+QJsonObject ProjectStateObserver::trackEntry(Track* track) const
+{
+    int endBar = 0;
+    for (const Clip* clip : track->getClips()) {
+        endBar = std::max(endBar, static_cast<int>(clip->endPosition().nextFullBar()));
+    }
+
+    return QJsonObject{
+        {"name", track->name()},
+        {"type", trackTypeName(track->type())},
+        {"clip_count", static_cast<int>(track->getClips().size())},
+        {"end_bar", endBar}
+    };
+}
+
+QString ProjectStateObserver::trackKey(Track* track) const
+{
+    return QString("t%1").arg(m_trackIds.value(track));
+}
+
+} // namespace lmms::gui
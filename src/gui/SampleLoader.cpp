@@ -32,6 +32,7 @@
 #include "FileDialog.h"
 #include "GuiApplication.h"
 #include "PathUtil.h"
+#include "SampleCache.h"
 #include "SampleDecoder.h"
 
 namespace lmms::gui {
@@ -87,13 +88,14 @@ QString SampleLoader::openWaveformFile(const QString& previousFile)
 		previousFile.isEmpty() ? ConfigManager::inst()->factorySamplesDir() + "waveforms/10saw.flac" : previousFile);
 }
 
-std::shared_ptr<const SampleBuffer> SampleLoader::createBufferFromFile(const QString& filePath)
+std::shared_ptr<const SampleBuffer> SampleLoader::createBufferFromFile(
+	const QString& filePath, SampleBuffer::Decoding decoding)
 {
 	if (filePath.isEmpty()) { return SampleBuffer::emptyBuffer(); }
 
 	try
 	{
-		return std::make_shared<SampleBuffer>(filePath);
+		return SampleCache::get(filePath, decoding);
 	}
 	catch (const std::runtime_error& error)
 	{
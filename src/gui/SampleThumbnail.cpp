@@ -25,34 +25,140 @@
 
 #include "SampleThumbnail.h"
 
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
 #include <QFileInfo>
 #include <QPainter>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 
+#include "PathUtil.h"
 #include "Sample.h"
+#include "ThreadPool.h"
 
 namespace {
 	constexpr auto MaxSampleThumbnailCacheSize = 32;
 	constexpr auto AggregationPerZoomStep = 10;
+
+	//! Samples (of all channels) below which thumbnails are generated right away and not stored on disk
+	constexpr auto MinBackgroundGenerationSize = std::size_t{1} << 20;
+
+	//! The preview published first has that many peaks, each computed from at most PreviewFramesPerPeak frames
+	constexpr auto PreviewWidth = std::size_t{4096};
+	constexpr auto PreviewFramesPerPeak = 32.0;
+
+	//! The finest level is split into chunks of at least that many peaks, generated in parallel
+	constexpr auto MinPeaksPerChunk = std::size_t{1} << 16;
+	constexpr auto ChunksPerWorker = std::size_t{4};
+
+	constexpr auto PeakFileMagic = quint32{0x4c504b53};
+	constexpr auto PeakFileVersion = quint16{1};
+	constexpr auto PeakQuantizationSteps = 32767.0f;
 }
 
 namespace lmms {
 
+namespace {
+
+//! The file the thumbnails of @p info are stored in, changes whenever the file does
+auto peakFilePath(const QFileInfo& info) -> QString
+{
+	const auto key = QStringLiteral("%1\n%2\n%3")
+		.arg(info.canonicalFilePath())
+		.arg(info.size())
+		.arg(info.lastModified().toMSecsSinceEpoch());
+	const auto hash = QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex();
+
+	return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+		+ QStringLiteral("/thumbnails/") + QString::fromLatin1(hash) + QStringLiteral(".peaks");
+}
+
+} // namespace
+
+SampleThumbnail::ThumbnailCache::ThumbnailCache(Levels levels)
+	: m_levels(std::make_shared<const Levels>(std::move(levels)))
+	, m_complete(true)
+{
+}
+
+auto SampleThumbnail::ThumbnailCache::levels() const -> std::shared_ptr<const Levels>
+{
+	const auto lock = std::lock_guard{m_mutex};
+	return m_levels;
+}
+
+auto SampleThumbnail::ThumbnailCache::complete() const -> bool
+{
+	const auto lock = std::lock_guard{m_mutex};
+	return m_complete;
+}
+
+void SampleThumbnail::ThumbnailCache::publish(Levels levels, bool complete)
+{
+	auto published = std::make_shared<const Levels>(std::move(levels));
+	const auto lock = std::lock_guard{m_mutex};
+
+	// a preview finishing late must not replace the final levels
+	if (m_complete) { return; }
+
+	m_levels = std::move(published);
+	m_complete = complete;
+}
+
 SampleThumbnail::Thumbnail::Thumbnail(std::vector<Peak> peaks, double samplesPerPeak)
 	: m_peaks(std::move(peaks))
 	, m_samplesPerPeak(samplesPerPeak)
 {
 }
 
-SampleThumbnail::Thumbnail::Thumbnail(const float* buffer, size_t size, size_t width)
+SampleThumbnail::Thumbnail::Thumbnail(const SampleBuffer& buffer, size_t width)
 	: m_peaks(width)
-	, m_samplesPerPeak(std::max(static_cast<double>(size) / width, 1.0))
+	, m_samplesPerPeak(std::max(static_cast<double>(buffer.size() * DEFAULT_CHANNELS) / width, 1.0))
 {
-	for (auto peakIndex = std::size_t{0}; peakIndex < width; ++peakIndex)
+	computePeaks(buffer, width, 0, width, m_peaks.data());
+}
+
+void SampleThumbnail::Thumbnail::computePeaks(
+	const SampleBuffer& buffer, size_t width, size_t first, size_t last, Peak* peaks)
+{
+	const auto size = buffer.size() * DEFAULT_CHANNELS;
+	const auto samplesPerPeak = std::max(static_cast<double>(size) / width, 1.0);
+	const auto sampleAt = [&](size_t peakIndex) {
+		return std::min(static_cast<size_t>(std::floor(peakIndex * samplesPerPeak)), size);
+	};
+	const auto sampleAfter = [&](size_t peakIndex) {
+		return std::min(static_cast<size_t>(std::ceil((peakIndex + 1) * samplesPerPeak)), size);
+	};
+
+	// compact storage formats are converted for the frames needed only
+	auto converted = std::vector<SampleFrame>{};
+	auto flatBuffer = static_cast<const float*>(nullptr);
+	auto offset = std::size_t{0};
+	if (buffer.storage() == SampleBuffer::Storage::Float32)
+	{
+		flatBuffer = buffer.data()->data();
+	}
+	else if (first < last)
+	{
+		const auto firstFrame = sampleAt(first) / DEFAULT_CHANNELS;
+		const auto lastFrame = (sampleAfter(last - 1) + DEFAULT_CHANNELS - 1) / DEFAULT_CHANNELS;
+		converted.resize(lastFrame - firstFrame);
+		buffer.read(firstFrame, converted.size(), converted.data());
+		flatBuffer = converted.data()->data();
+		offset = firstFrame * DEFAULT_CHANNELS;
+	}
+
+	for (auto peakIndex = first; peakIndex < last; ++peakIndex)
 	{
-		const auto beginSample = buffer + static_cast<size_t>(std::floor(peakIndex * m_samplesPerPeak));
-		const auto endSample = buffer + static_cast<size_t>(std::ceil((peakIndex + 1) * m_samplesPerPeak));
+		const auto beginSample = flatBuffer + sampleAt(peakIndex) - offset;
+		const auto endSample = flatBuffer + sampleAfter(peakIndex) - offset;
 		const auto [min, max] = std::minmax_element(beginSample, endSample);
-		m_peaks[peakIndex] = Peak{*min, *max};
+		peaks[peakIndex - first] = Peak{*min, *max};
 	}
 }
 
@@ -71,10 +177,206 @@ SampleThumbnail::Thumbnail SampleThumbnail::Thumbnail::zoomOut(float factor) con
 	return Thumbnail{std::move(peaks), m_samplesPerPeak * factor};
 }
 
+struct SampleThumbnail::Generation
+{
+	std::shared_ptr<ThumbnailCache> cache;
+	std::shared_ptr<const SampleBuffer> buffer;
+	QString peakFile;
+
+	std::vector<Thumbnail::Peak> finest;
+	std::atomic<std::size_t> remainingChunks = 0;
+};
+
+auto SampleThumbnail::zoomOutLevels(Thumbnail finest) -> ThumbnailCache::Levels
+{
+	auto levels = ThumbnailCache::Levels{};
+	levels.emplace_back(std::move(finest));
+
+	while (levels.back().width() >= AggregationPerZoomStep)
+	{
+		auto zoomedOutThumbnail = levels.back().zoomOut(AggregationPerZoomStep);
+		levels.emplace_back(std::move(zoomedOutThumbnail));
+	}
+
+	return levels;
+}
+
+auto SampleThumbnail::generateLevels(const SampleBuffer& buffer) -> ThumbnailCache::Levels
+{
+	return zoomOutLevels(Thumbnail{buffer, buffer.size() * DEFAULT_CHANNELS / AggregationPerZoomStep});
+}
+
+auto SampleThumbnail::generatePreview(const SampleBuffer& buffer) -> ThumbnailCache::Levels
+{
+	// only look at some frames of every peak, enough to get an idea of the waveform
+	const auto frames = buffer.size();
+	const auto width = std::min(PreviewWidth, frames);
+	const auto framesPerPeak = static_cast<double>(frames) / width;
+	const auto stride = std::max<std::size_t>(framesPerPeak / PreviewFramesPerPeak, 1);
+
+	auto peaks = std::vector<Thumbnail::Peak>(width);
+	auto frameBuffer = SampleFrame{};
+	for (auto peakIndex = std::size_t{0}; peakIndex < width; ++peakIndex)
+	{
+		const auto beginFrame = static_cast<std::size_t>(std::floor(peakIndex * framesPerPeak));
+		const auto endFrame = std::min(static_cast<std::size_t>(std::ceil((peakIndex + 1) * framesPerPeak)), frames);
+		for (auto frame = beginFrame; frame < endFrame; frame += stride)
+		{
+			buffer.read(frame, 1, &frameBuffer);
+			peaks[peakIndex] = peaks[peakIndex] + frameBuffer;
+		}
+	}
+
+	return zoomOutLevels(Thumbnail{std::move(peaks), framesPerPeak * DEFAULT_CHANNELS});
+}
+
+void SampleThumbnail::generateInBackground(std::shared_ptr<Generation> generation)
+{
+	auto& pool = ThreadPool::instance();
+
+	// queued first, so it is most likely published before the other tasks are done
+	pool.enqueue([generation] { generation->cache->publish(generatePreview(*generation->buffer), false); });
+
+	const auto flatBufferSize = generation->buffer->size() * DEFAULT_CHANNELS;
+	const auto width = flatBufferSize / AggregationPerZoomStep;
+	const auto chunks = std::clamp<std::size_t>(width / MinPeaksPerChunk, 1, pool.numWorkers() * ChunksPerWorker);
+
+	generation->finest.resize(width);
+	generation->remainingChunks = chunks;
+
+	// the chunks are never waited for, as that could block all workers of the pool. Instead, the last one done
+	// finishes the coarser levels.
+	for (auto chunk = std::size_t{0}; chunk < chunks; ++chunk)
+	{
+		const auto first = width * chunk / chunks;
+		const auto last = width * (chunk + 1) / chunks;
+		pool.enqueue([generation, flatBufferSize, width, first, last] {
+			Thumbnail::computePeaks(*generation->buffer, width, first, last, generation->finest.data() + first);
+			if (generation->remainingChunks.fetch_sub(1) != 1) { return; }
+
+			auto levels = zoomOutLevels(Thumbnail{std::move(generation->finest), static_cast<double>(flatBufferSize) / width});
+			if (!generation->peakFile.isEmpty())
+			{
+				writePeakFile(generation->peakFile, generation->buffer->size(), levels);
+			}
+			generation->cache->publish(std::move(levels), true);
+		});
+	}
+}
+
+/*
+ * Peak files start with a header (magic, version, number of sample frames, peak scale and number of levels),
+ * followed by every level: its width, the samples per peak and the peaks as pairs of 16 bit integers, relative to
+ * the largest magnitude in the sample. The finest level isn't stored, it is about a tenth of the size of the
+ * sample itself and visualize() reads the sample instead when zoomed in that far.
+ */
+auto SampleThumbnail::readPeakFile(const QString& path, std::size_t frames) -> ThumbnailCache::Levels
+{
+	auto file = QFile{path};
+	if (!file.open(QIODevice::ReadOnly)) { return {}; }
+
+	auto stream = QDataStream{&file};
+	stream.setByteOrder(QDataStream::LittleEndian);
+	stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+	auto magic = quint32{0};
+	auto version = quint16{0};
+	auto storedFrames = quint64{0};
+	auto scale = 0.0f;
+	auto levelCount = quint32{0};
+	stream >> magic >> version >> storedFrames >> scale >> levelCount;
+	if (stream.status() != QDataStream::Ok || magic != PeakFileMagic || version != PeakFileVersion
+		|| storedFrames != frames || levelCount == 0)
+	{
+		return {};
+	}
+
+	auto levels = ThumbnailCache::Levels{};
+	const auto toFloat = scale / PeakQuantizationSteps;
+	for (auto level = quint32{0}; level < levelCount; ++level)
+	{
+		auto width = quint32{0};
+		auto samplesPerPeak = 0.0;
+		stream >> width >> samplesPerPeak;
+
+		// a corrupt width must not make us allocate gigabytes
+		if (stream.status() != QDataStream::Ok || width > (file.size() - file.pos()) / (2 * sizeof(qint16)))
+		{
+			return {};
+		}
+
+		auto peaks = std::vector<Thumbnail::Peak>(width);
+		for (auto& peak : peaks)
+		{
+			auto min = qint16{0};
+			auto max = qint16{0};
+			stream >> min >> max;
+			peak = Thumbnail::Peak{min * toFloat, max * toFloat};
+		}
+		if (stream.status() != QDataStream::Ok) { return {}; }
+
+		levels.emplace_back(std::move(peaks), samplesPerPeak);
+	}
+
+	return levels;
+}
+
+void SampleThumbnail::writePeakFile(const QString& path, std::size_t frames, const ThumbnailCache::Levels& levels)
+{
+	if (levels.size() < 2 || !QDir{}.mkpath(QFileInfo{path}.path())) { return; }
+
+	const auto& coarsest = levels.back();
+	auto scale = 0.0f;
+	for (auto i = 0; i < coarsest.width(); ++i)
+	{
+		scale = std::max({scale, std::abs(coarsest[i].min), std::abs(coarsest[i].max)});
+	}
+	if (!std::isfinite(scale) || scale == 0.0f) { scale = 1.0f; }
+
+	// written to a temporary file first, so other instances never read a partial one
+	auto file = QSaveFile{path};
+	if (!file.open(QIODevice::WriteOnly)) { return; }
+
+	auto stream = QDataStream{&file};
+	stream.setByteOrder(QDataStream::LittleEndian);
+	stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+	stream << PeakFileMagic << PeakFileVersion << static_cast<quint64>(frames) << scale
+		<< static_cast<quint32>(levels.size() - 1);
+
+	const auto toSteps = PeakQuantizationSteps / scale;
+	const auto quantize = [toSteps](float value, auto round) {
+		const auto steps = std::isfinite(value) ? round(value * toSteps) : 0.0f;
+		return static_cast<qint16>(std::clamp(steps, -PeakQuantizationSteps, PeakQuantizationSteps));
+	};
+
+	for (auto level = std::next(levels.begin()); level != levels.end(); ++level)
+	{
+		stream << static_cast<quint32>(level->width()) << level->samplesPerPeak();
+		for (auto i = 0; i < level->width(); ++i)
+		{
+			// round outwards, so quantization never hides a peak
+			const auto& peak = (*level)[i];
+			stream << quantize(peak.min, [](float v) { return std::floor(v); })
+				<< quantize(peak.max, [](float v) { return std::ceil(v); });
+		}
+	}
+
+	if (stream.status() == QDataStream::Ok) { file.commit(); }
+}
+
 SampleThumbnail::SampleThumbnail(const Sample& sample)
 	: m_buffer(sample.buffer())
 {
-	auto entry = SampleThumbnailEntry{sample.sampleFile(), QFileInfo{sample.sampleFile()}.lastModified()};
+	// don't wait for samples decoded in the background
+	if (m_buffer->decodedFrames() < m_buffer->size())
+	{
+		m_incomplete = true;
+		return;
+	}
+
+	const auto info = QFileInfo{PathUtil::toAbsolute(sample.sampleFile())};
+	auto entry = SampleThumbnailEntry{sample.sampleFile(), info.lastModified()};
 	if (!entry.filePath.isEmpty())
 	{
 		const auto it = s_sampleThumbnailCacheMap.find(entry);
@@ -83,7 +385,40 @@ SampleThumbnail::SampleThumbnail(const Sample& sample)
 			m_thumbnailCache = it->second;
 			return;
 		}
+	}
+
+	if (m_buffer->size() * DEFAULT_CHANNELS < MinBackgroundGenerationSize)
+	{
+		m_thumbnailCache = std::make_shared<ThumbnailCache>(generateLevels(*m_buffer));
+	}
+	else
+	{
+		m_thumbnailCache = std::make_shared<ThumbnailCache>();
+
+		// only files can be found again next time
+		const auto peakFile = entry.filePath.isEmpty() || !info.exists() ? QString{} : peakFilePath(info);
+
+		auto generation = std::make_shared<Generation>();
+		generation->cache = m_thumbnailCache;
+		generation->buffer = m_buffer;
+		generation->peakFile = peakFile;
 
+		ThreadPool::instance().enqueue([generation] {
+			if (!generation->peakFile.isEmpty())
+			{
+				auto levels = readPeakFile(generation->peakFile, generation->buffer->size());
+				if (!levels.empty())
+				{
+					generation->cache->publish(std::move(levels), true);
+					return;
+				}
+			}
+			generateInBackground(generation);
+		});
+	}
+
+	if (!entry.filePath.isEmpty())
+	{
 		if (s_sampleThumbnailCacheMap.size() == MaxSampleThumbnailCacheSize)
 		{
 			const auto leastUsed = std::min_element(s_sampleThumbnailCacheMap.begin(), s_sampleThumbnailCacheMap.end(),
@@ -93,16 +428,22 @@ SampleThumbnail::SampleThumbnail(const Sample& sample)
 
 		s_sampleThumbnailCacheMap[std::move(entry)] = m_thumbnailCache;
 	}
+}
 
-	const auto flatBuffer = m_buffer->data()->data();
-	const auto flatBufferSize = m_buffer->size() * DEFAULT_CHANNELS;
-	m_thumbnailCache->emplace_back(flatBuffer, flatBufferSize, flatBufferSize / AggregationPerZoomStep);
-
-	while (m_thumbnailCache->back().width() >= AggregationPerZoomStep)
+auto SampleThumbnail::memoryUsage() -> std::size_t
+{
+	auto memory = std::size_t{0};
+	for (const auto& [entry, cache] : s_sampleThumbnailCacheMap)
 	{
-		auto zoomedOutThumbnail = m_thumbnailCache->back().zoomOut(AggregationPerZoomStep);
-		m_thumbnailCache->emplace_back(std::move(zoomedOutThumbnail));
+		const auto levels = cache->levels();
+		if (!levels) { continue; }
+
+		for (const auto& thumbnail : *levels)
+		{
+			memory += thumbnail.width() * sizeof(Thumbnail::Peak);
+		}
 	}
+	return memory;
 }
 
 void SampleThumbnail::visualize(VisualizeParameters parameters, QPainter& painter) const
@@ -111,17 +452,29 @@ void SampleThumbnail::visualize(VisualizeParameters parameters, QPainter& painte
 	const auto& viewportRect = parameters.viewportRect.isNull() ? sampleRect : parameters.viewportRect;
 
 	const auto renderRect = sampleRect.intersected(viewportRect);
-	if (renderRect.isNull()) { return; }
+	if (renderRect.isNull() || m_incomplete || m_buffer->size() == 0) { return; }
+
+	const auto levels = m_thumbnailCache->levels();
+	if (!levels || levels->empty()) { return; }
+	const auto complete = m_thumbnailCache->complete();
 
 	const auto sampleRange = parameters.sampleEnd - parameters.sampleStart;
 	if (sampleRange <= 0.0f || sampleRange > 1.0f) { return; }
 
 	const auto targetThumbnailWidth = static_cast<int>(sampleRect.width() / sampleRange);
-	const auto finerThumbnail = std::find_if(m_thumbnailCache->rbegin(), m_thumbnailCache->rend(),
+	auto finerThumbnail = std::find_if(levels->rbegin(), levels->rend(),
 		[&](const auto& thumbnail) { return thumbnail.width() >= targetThumbnailWidth; });
 
-	const auto useOriginalBuffer = finerThumbnail == m_thumbnailCache->rend();
-	const auto drawOriginalBuffer = static_cast<size_t>(targetThumbnailWidth) == m_buffer->size();
+	// scanning the sample itself could take far too long while only a preview is available, and samples in
+	// compact storage formats would have to be converted as a whole
+	if (finerThumbnail == levels->rend() && (!complete || m_buffer->storage() != SampleBuffer::Storage::Float32))
+	{
+		finerThumbnail = std::prev(levels->rend());
+	}
+
+	const auto useOriginalBuffer = finerThumbnail == levels->rend();
+	const auto originalBufferWidth = m_buffer->size() * DEFAULT_CHANNELS;
+	const auto drawOriginalBuffer = static_cast<size_t>(targetThumbnailWidth) == originalBufferWidth;
 
 	painter.save();
 	painter.setRenderHint(QPainter::Antialiasing, true);
@@ -132,7 +485,7 @@ void SampleThumbnail::visualize(VisualizeParameters parameters, QPainter& painte
 	const auto thumbnailEnd = parameters.reversed ? targetThumbnailWidth - thumbnailEndForward : thumbnailEndForward;
 	const auto advanceThumbnailBy = parameters.reversed ? -1 : 1;
 
-	const auto finerThumbnailWidth = useOriginalBuffer ? m_buffer->size() : finerThumbnail->width();
+	const auto finerThumbnailWidth = useOriginalBuffer ? originalBufferWidth : finerThumbnail->width();
 	const auto finerThumbnailScaleFactor = static_cast<double>(finerThumbnailWidth) / targetThumbnailWidth;
 	const auto yScale = renderRect.height() / 2 * parameters.amplification;
 
@@ -147,8 +500,8 @@ void SampleThumbnail::visualize(VisualizeParameters parameters, QPainter& painte
 		}
 		else
 		{
-			const auto beginIndex = std::clamp<size_t>(std::floor(i * finerThumbnailScaleFactor), 0, finerThumbnail->width() - 1);
-			const auto endIndex = std::clamp<size_t>(std::ceil((i + 1) * finerThumbnailScaleFactor), 0, finerThumbnail->width() - 1);
+			const auto beginIndex = std::clamp<size_t>(std::floor(i * finerThumbnailScaleFactor), 0, finerThumbnailWidth - 1);
+			const auto endIndex = std::clamp<size_t>(std::ceil((i + 1) * finerThumbnailScaleFactor), 0, finerThumbnailWidth - 1);
 
 			auto minPeak = 0.f;
 			auto maxPeak = 0.f;
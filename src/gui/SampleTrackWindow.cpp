@@ -36,6 +36,7 @@
 #include "embed.h"
 #include "GuiApplication.h"
 #include "Knob.h"
+#include "LedCheckBox.h"
 #include "MainWindow.h"
 #include "MixerChannelLcdSpinBox.h"
 #include "SampleTrackView.h"
@@ -158,6 +159,10 @@ SampleTrackWindow::SampleTrackWindow(SampleTrackView * tv) :
 
 	generalSettingsLayout->addLayout(basicControlsLayout);
 
+	m_monitorInputCheckBox = new LedCheckBox(tr("Monitor input"), this);
+	m_monitorInputCheckBox->setToolTip(tr("Hear the audio input on this track's mixer channel"));
+	generalSettingsLayout->addWidget(m_monitorInputCheckBox);
+
 	m_effectRack = new EffectRackView(tv->model()->audioBusHandle()->effects());
 	m_effectRack->setFixedSize(EffectRackView::DEFAULT_WIDTH, 242);
 
@@ -211,6 +216,7 @@ void SampleTrackWindow::modelChanged()
 	m_volumeKnob->setModel(&m_track->m_volumeModel);
 	m_panningKnob->setModel(&m_track->m_panningModel);
 	m_mixerChannelNumber->setModel(&m_track->m_mixerChannelModel);
+	m_monitorInputCheckBox->setModel(&m_track->m_monitorInputModel);
 
 	updateName();
 }
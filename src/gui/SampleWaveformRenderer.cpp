@@ -0,0 +1,150 @@
+/*
+ * SampleWaveformRenderer.cpp - draws waveforms of samples on the thread pool
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "SampleWaveformRenderer.h"
+
+#include <QCoreApplication>
+#include <QPainter>
+#include <QPointer>
+
+#include "ThreadPool.h"
+
+namespace lmms::gui
+{
+
+bool operator==(const SampleWaveformRenderer::Request& first, const SampleWaveformRenderer::Request& second)
+{
+	const auto& a = first.parameters;
+	const auto& b = second.parameters;
+	return first.thumbnail == second.thumbnail && first.size == second.size
+		&& first.devicePixelRatio == second.devicePixelRatio && first.color == second.color
+		&& a.sampleRect == b.sampleRect && a.viewportRect == b.viewportRect && a.amplification == b.amplification
+		&& a.sampleStart == b.sampleStart && a.sampleEnd == b.sampleEnd && a.reversed == b.reversed;
+}
+
+
+
+
+void SampleWaveformRenderer::draw(const SampleThumbnail& thumbnail,
+	const SampleThumbnail::VisualizeParameters& parameters, const QColor& color, QPainter& painter)
+{
+	// only a preview is drawn meanwhile, which is quick, and the views draw again until it's done
+	if (thumbnail.isIncomplete())
+	{
+		painter.save();
+		painter.setPen(color);
+		thumbnail.visualize(parameters, painter);
+		painter.restore();
+		return;
+	}
+
+	const auto* device = painter.device();
+	const auto request = Request{thumbnail, parameters, QSize{device->width(), device->height()},
+		device->devicePixelRatioF(), color.rgba()};
+	if (request == m_imageRequest)
+	{
+		painter.drawImage(0, 0, m_image);
+		return;
+	}
+
+	if (!(request == m_rendering))
+	{
+		if (m_rendering) { m_queued = request; }
+		else { render(request); }
+	}
+
+	// until then, stretch the last image so the frames it shows are where they go now
+	if (!m_imageRequest || !(m_imageRequest->thumbnail == thumbnail)) { return; }
+	const auto& last = m_imageRequest->parameters;
+	if (last.sampleRect.isEmpty() || parameters.sampleRect.isEmpty() || last.reversed != parameters.reversed
+		|| last.amplification != parameters.amplification || last.sampleStart == last.sampleEnd
+		|| parameters.sampleStart == parameters.sampleEnd)
+	{
+		return;
+	}
+
+	const auto toFrame = [](const SampleThumbnail::VisualizeParameters& from, double x) {
+		const auto position = (x - from.sampleRect.x()) / from.sampleRect.width();
+		return from.sampleStart + (from.reversed ? 1 - position : position) * (from.sampleEnd - from.sampleStart);
+	};
+	const auto toX = [](const SampleThumbnail::VisualizeParameters& to, double frame) {
+		const auto position = (frame - to.sampleStart) / (to.sampleEnd - to.sampleStart);
+		return to.sampleRect.x() + (to.reversed ? 1 - position : position) * to.sampleRect.width();
+	};
+	const auto left = toX(parameters, toFrame(last, last.sampleRect.x()));
+	const auto right = toX(parameters, toFrame(last, last.sampleRect.x() + last.sampleRect.width()));
+
+	const auto& from = last.sampleRect;
+	const auto& to = parameters.sampleRect;
+	painter.save();
+	painter.setClipRect(parameters.viewportRect.isNull() ? to : to.intersected(parameters.viewportRect));
+	painter.setTransform(QTransform{}
+		.translate(left, to.y())
+		.scale((right - left) / from.width(), static_cast<double>(to.height()) / from.height())
+		.translate(-from.x(), -from.y()), true);
+	painter.drawImage(0, 0, m_image);
+	painter.restore();
+}
+
+
+
+
+void SampleWaveformRenderer::render(const Request& request)
+{
+	m_rendering = request;
+	ThreadPool::instance().enqueue([renderer = QPointer<SampleWaveformRenderer>{this}, request] {
+		auto image = QImage{request.size, QImage::Format_ARGB32_Premultiplied};
+		image.setDevicePixelRatio(request.devicePixelRatio);
+		image.fill(Qt::transparent);
+
+		auto painter = QPainter{&image};
+		painter.setPen(QColor::fromRgba(request.color));
+		request.thumbnail.visualize(request.parameters, painter);
+		painter.end();
+
+		// the application outlives the renderer, which may be gone by then
+		QMetaObject::invokeMethod(QCoreApplication::instance(), [renderer, request, image = std::move(image)] {
+			if (renderer) { renderer->finish(request, image); }
+		}, Qt::QueuedConnection);
+	});
+}
+
+
+
+
+void SampleWaveformRenderer::finish(const Request& request, const QImage& image)
+{
+	m_image = image;
+	m_imageRequest = request;
+	m_rendering.reset();
+
+	if (m_queued)
+	{
+		const auto next = *m_queued;
+		m_queued.reset();
+		if (!(next == m_imageRequest)) { render(next); }
+	}
+
+	emit rendered();
+}
+
+} // namespace lmms::gui
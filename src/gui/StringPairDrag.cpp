@@ -46,22 +46,19 @@ StringPairDrag::StringPairDrag( const QString & _key, const QString & _value,
 	// For mimeType() and MimeType enum class
 	using namespace Clipboard;
 
-	if( _icon.isNull() && _w )
-	{
-		setPixmap( _w->grab().scaled(
-						64, 64,
-						Qt::KeepAspectRatio,
-						Qt::SmoothTransformation ) );
-	}
-	else
-	{
-		setPixmap( _icon );
-	}
 	QString txt = _key + ":" + _value;
 	auto m = new QMimeData();
 	m->setData( mimeType( MimeType::StringPair ), txt.toUtf8() );
-	setMimeData( m );
-	exec( Qt::CopyAction, Qt::CopyAction );
+	start( m, _icon, _w );
+}
+
+
+
+
+StringPairDrag::StringPairDrag(const QString& key, const DataFile& dataFile, const QPixmap& icon, QWidget* w) :
+	QDrag(w)
+{
+	start(new Clipboard::DataFileMimeData(dataFile, Clipboard::MimeType::StringPair, key), icon, w);
 }
 
 
@@ -90,8 +87,7 @@ bool StringPairDrag::processDragEnterEvent( QDragEnterEvent * _dee,
 	{
 		return( false );
 	}
-	QString txt = _dee->mimeData()->data( mimeType( MimeType::StringPair ) );
-	if( _allowed_keys.split( ',' ).contains( txt.section( ':', 0, 0 ) ) )
+	if( _allowed_keys.split( ',' ).contains( decodeKey( _dee->mimeData() ) ) )
 	{
 		_dee->acceptProposedAction();
 		return( true );
@@ -117,4 +113,21 @@ QString StringPairDrag::decodeValue( QDropEvent * _de )
 }
 
 
+
+
+void StringPairDrag::start(QMimeData* mimeData, const QPixmap& icon, QWidget* w)
+{
+	if (icon.isNull() && w)
+	{
+		setPixmap(w->grab().scaled(64, 64, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+	}
+	else
+	{
+		setPixmap(icon);
+	}
+	setMimeData(mimeData);
+	exec(Qt::CopyAction, Qt::CopyAction);
+}
+
+
 } // namespace lmms::gui
\ No newline at end of file
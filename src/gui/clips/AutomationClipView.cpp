@@ -24,11 +24,14 @@
 #include "AutomationClipView.h"
 
 #include <QApplication>
+#include <QInputDialog>
 #include <QMouseEvent>
 #include <QPainter>
-#include <QPainterPath>  // IWYU pragma: keep
 #include <QMenu>
 
+#include <bit>
+#include <cmath>
+
 #include "AutomationEditor.h"
 #include "embed.h"
 #include "GuiApplication.h"
@@ -140,6 +143,18 @@ void AutomationClipView::toggleRecording()
 
 
 
+void AutomationClipView::changeSimplification()
+{
+	bool ok;
+	const double tolerance = QInputDialog::getDouble(this, tr("Simplify recorded automation"),
+		tr("Remove recorded nodes changing the value by less than (0 keeps all of them)"),
+		m_clip->simplificationTolerance(), 0, std::abs(m_clip->getMax() - m_clip->getMin()), 3, &ok);
+	if (ok) { m_clip->setSimplificationTolerance(static_cast<float>(tolerance)); }
+}
+
+
+
+
 void AutomationClipView::flipY()
 {
 	m_clip->flipY( m_clip->getMin(), m_clip->getMax() );
@@ -179,6 +194,7 @@ void AutomationClipView::constructContextMenu( QMenu * _cm )
 	_cm->addAction( embed::getIconPixmap( "record" ),
 						tr( "Set/clear record" ),
 						this, SLOT(toggleRecording()));
+	_cm->addAction(tr("Simplify recorded automation..."), this, SLOT(changeSimplification()));
 	_cm->addAction( embed::getIconPixmap( "flip_y" ),
 						tr( "Flip Vertically (Visible)" ),
 						this, SLOT(flipY()));
@@ -288,55 +304,71 @@ void AutomationClipView::paintEvent( QPaintEvent * )
 	lin2grad.setColorAt( 0.5, col );
 	lin2grad.setColorAt( 0, col.darker( 150 ) );
 
-	p.setRenderHints( QPainter::Antialiasing, true );
-	for( AutomationClip::timeMap::const_iterator it =
-						m_clip->getTimeMap().begin();
-					it != m_clip->getTimeMap().end(); ++it )
+	// the values between the nodes are computed for every tick, so the
+	// shapes are only rebuilt when the nodes or the scale changed
+	auto curveState = std::vector<int>{width(), std::bit_cast<int>(ppTick), offset,
+		static_cast<int>(m_clip->progressionType())};
+	for (auto it = m_clip->getTimeMap().begin(); it != m_clip->getTimeMap().end(); ++it)
 	{
-		if( it+1 == m_clip->getTimeMap().end() )
+		curveState.insert(curveState.end(), {POS(it), std::bit_cast<int>(INVAL(it)), std::bit_cast<int>(OUTVAL(it)),
+			std::bit_cast<int>(INTAN(it)), std::bit_cast<int>(OUTTAN(it))});
+	}
+
+	if (curveState != m_curveState)
+	{
+		m_curve.clear();
+		for( AutomationClip::timeMap::const_iterator it =
+							m_clip->getTimeMap().begin();
+						it != m_clip->getTimeMap().end(); ++it )
 		{
-			const float x1 = POS(it) * ppTick + offset;
-			const auto x2 = (float)(width() - BORDER_WIDTH);
-			if( x1 > ( width() - BORDER_WIDTH ) ) break;
-			// We are drawing the space after the last node, so we use the outValue
-			if( gradient() )
+			if( it+1 == m_clip->getTimeMap().end() )
 			{
-				p.fillRect(QRectF(x1, 0.0f, x2 - x1, OUTVAL(it)), lin2grad);
+				const float x1 = POS(it) * ppTick + offset;
+				const auto x2 = (float)(width() - BORDER_WIDTH);
+				if( x1 > ( width() - BORDER_WIDTH ) ) break;
+				// We are drawing the space after the last node, so we use the outValue
+				QPainterPath path;
+				path.addRect(QRectF(x1, 0.0f, x2 - x1, OUTVAL(it)));
+				m_curve.push_back(path);
+				break;
 			}
-			else
+
+			float *values = m_clip->valuesAfter(POS(it));
+
+			// We are creating a path to draw a polygon representing the values between two
+			// nodes. When we have two nodes with discrete progression, we will basically have
+			// a rectangle with the outValue of the first node (that's why nextValue will match
+			// the outValue of the current node). When we have nodes with linear or cubic progression
+			// the value of the end of the shape between the two nodes will be the inValue of
+			// the next node.
+			float nextValue = m_clip->progressionType() == AutomationClip::ProgressionType::Discrete
+				? OUTVAL(it)
+				: INVAL(it + 1);
+
+			QPainterPath path;
+			QPointF origin = QPointF(POS(it) * ppTick + offset, 0.0f);
+			path.moveTo(origin);
+			path.moveTo(QPointF(POS(it) * ppTick + offset, values[0]));
+			for (int i = POS(it) + 1; i < POS(it + 1); i++)
 			{
-				p.fillRect(QRectF(x1, 0.0f, x2 - x1, OUTVAL(it)), col);
+				float x = i * ppTick + offset;
+				if(x > (width() - BORDER_WIDTH)) break;
+				float value = values[i - POS(it)];
+				path.lineTo(QPointF(x, value));
 			}
-			break;
-		}
+			path.lineTo((POS(it + 1)) * ppTick + offset, nextValue);
+			path.lineTo((POS(it + 1)) * ppTick + offset, 0.0f);
+			path.lineTo(origin);
 
-		float *values = m_clip->valuesAfter(POS(it));
-
-		// We are creating a path to draw a polygon representing the values between two
-		// nodes. When we have two nodes with discrete progression, we will basically have
-		// a rectangle with the outValue of the first node (that's why nextValue will match
-		// the outValue of the current node). When we have nodes with linear or cubic progression
-		// the value of the end of the shape between the two nodes will be the inValue of
-		// the next node.
-		float nextValue = m_clip->progressionType() == AutomationClip::ProgressionType::Discrete
-			? OUTVAL(it)
-			: INVAL(it + 1);
-
-		QPainterPath path;
-		QPointF origin = QPointF(POS(it) * ppTick + offset, 0.0f);
-		path.moveTo(origin);
-		path.moveTo(QPointF(POS(it) * ppTick + offset, values[0]));
-		for (int i = POS(it) + 1; i < POS(it + 1); i++)
-		{
-			float x = i * ppTick + offset;
-			if(x > (width() - BORDER_WIDTH)) break;
-			float value = values[i - POS(it)];
-			path.lineTo(QPointF(x, value));
+			m_curve.push_back(path);
+			delete [] values;
 		}
-		path.lineTo((POS(it + 1)) * ppTick + offset, nextValue);
-		path.lineTo((POS(it + 1)) * ppTick + offset, 0.0f);
-		path.lineTo(origin);
+		m_curveState = std::move(curveState);
+	}
 
+	p.setRenderHints( QPainter::Antialiasing, true );
+	for (const auto& path : m_curve)
+	{
 		if( gradient() )
 		{
 			p.fillPath( path, lin2grad );
@@ -345,7 +377,6 @@ void AutomationClipView::paintEvent( QPaintEvent * )
 		{
 			p.fillPath( path, col );
 		}
-		delete [] values;
 	}
 
 	p.setRenderHints( QPainter::Antialiasing, false );
@@ -447,7 +447,6 @@ void ClipView::dragEnterEvent( QDragEnterEvent * dee )
 void ClipView::dropEvent( QDropEvent * de )
 {
 	QString type = StringPairDrag::decodeKey( de );
-	QString value = StringPairDrag::decodeValue( de );
 
 	// Track must be the same type to paste into
 	if( type != ( "clip_" + QString::number( static_cast<int>(m_clip->getTrack()->type()) ) ) )
@@ -477,7 +476,7 @@ void ClipView::dropEvent( QDropEvent * de )
 	}
 
 	// Copy state into existing clip
-	DataFile dataFile( value.toUtf8() );
+	DataFile dataFile = Clipboard::decodeDataFile(de->mimeData(), Clipboard::MimeType::StringPair);
 	TimePos pos = m_clip->startPosition();
 	QDomElement clips = dataFile.content().firstChildElement("clips");
 	m_clip->restoreState( clips.firstChildElement().firstChildElement() );
@@ -826,7 +825,7 @@ void ClipView::mouseMoveEvent( QMouseEvent * me )
 				Qt::SmoothTransformation );
 			new StringPairDrag( QString( "clip_%1" ).arg(
 								static_cast<int>(m_clip->getTrack()->type()) ),
-								dataFile.toString(), thumbnail, this );
+								dataFile, thumbnail, this );
 		}
 	}
 
@@ -1198,15 +1197,15 @@ void ClipView::remove( QVector<ClipView *> clipvs )
 
 void ClipView::copy( QVector<ClipView *> clipvs )
 {
-	// For copyStringPair()
+	// For copyDataFile()
 	using namespace Clipboard;
 
 	// Write the Clips to a DataFile for copying
 	DataFile dataFile = createClipDataFiles( clipvs );
 
 	// Copy the Clip type as a key and the Clip data file to the clipboard
-	copyStringPair( QString( "clip_%1" ).arg( static_cast<int>(m_clip->getTrack()->type()) ),
-		dataFile.toString() );
+	copyDataFile(dataFile, MimeType::StringPair,
+		QString("clip_%1").arg(static_cast<int>(m_clip->getTrack()->type())));
 }
 
 void ClipView::cut( QVector<ClipView *> clipvs )
@@ -179,6 +179,7 @@ void MidiClipView::transposeSelection()
 			m_changedTracks.insert(track);
 		}
 
+		clip->detachNotes();
 		for (Note* note: clip->notes())
 		{
 			note->setKey(note->key() + semitones);
@@ -381,7 +382,7 @@ void MidiClipView::clearNotesOutOfBounds()
 	TimePos startBound = -m_clip->startTimeOffset();
 	TimePos endBound = m_clip->length() - m_clip->startTimeOffset();
 
-	for (Note const* note: m_clip->m_notes)
+	for (Note const* note: m_clip->notes())
 	{
 		const TimePos newNoteStart = std::max(note->pos(), startBound) - startBound;
 		const TimePos newNoteEnd = std::min(note->endPos(), endBound) - startBound;
@@ -509,6 +510,7 @@ void MidiClipView::wheelEvent(QWheelEvent * we)
 			return;
 		}
 
+		m_clip->detachNotes();
 		Note * n = m_clip->noteAtStep( step );
 		const int direction = (we->angleDelta().y() > 0 ? 1 : -1) * (we->inverted() ? -1 : 1);
 		if(!n && direction > 0)
@@ -630,7 +632,7 @@ void MidiClipView::paintEvent( QPaintEvent * )
 	const int x_base = BORDER_WIDTH;
 
 	bool displayPattern = fixedClips() || (pixelsPerBar >= 96 && m_legacySEPattern);
-	NoteVector const & noteCollection = m_clip->m_notes;
+	NoteVector const & noteCollection = m_clip->notes();
 
 	// Beat clip paint event (on BB Editor)
 	if (beatClip && displayPattern)
@@ -759,12 +761,6 @@ void MidiClipView::paintEvent( QPaintEvent * )
 
 		int const notesBorder = 4; // Border for the notes towards the top and bottom in pixels
 
-		// The relavant painting code starts here
-		p.save();
-
-		p.translate(0., distanceToTop + notesBorder);
-		p.scale(width(), height() - distanceToTop - 2 * notesBorder);
-
 		// set colour based on mute status
 		QColor noteFillColor = muted ? getMutedNoteFillColor().lighter(200)
 									 : (c.lightness() > 175 ? getNoteFillColor().darker(400) : getNoteFillColor());
@@ -772,50 +768,74 @@ void MidiClipView::paintEvent( QPaintEvent * )
 									   : (hasCustomColor() ? c.lighter(200) : getNoteBorderColor());
 
 		bool const drawAsLines = height() < 64;
-		if (drawAsLines)
-		{
-			p.setPen(noteFillColor);
-		}
-		else
+
+		// the notes are only redrawn when they or the way they are shown
+		// changed, not when just the selection or the marker did
+		auto notesState = std::vector<int>{width(), height(), m_clip->length(), offset, minKey,
+			adjustedNoteRange, static_cast<int>(distanceToTop * 100), drawAsLines,
+			static_cast<int>(noteFillColor.rgba()), static_cast<int>(noteBorderColor.rgba())};
+		notesState.reserve(notesState.size() + 3 * noteCollection.size());
+		for (Note const * note : noteCollection)
 		{
-			p.setPen(noteBorderColor);
-			p.setRenderHint(QPainter::Antialiasing);
+			notesState.insert(notesState.end(), {note->pos(), note->length(), note->key()});
 		}
 
-		// Needed for Qt5 although the documentation for QPainter::setPen(QColor) as it's used above
-		// states that it should already set a width of 0.
-		QPen pen = p.pen();
-		pen.setWidth(0);
-		p.setPen(pen);
-
-		float const noteHeight = 1. / adjustedNoteRange;
-
-		// scan through all the notes and draw them on the clip
-		for (Note const * currentNote : noteCollection)
+		if (notesState != m_notesPreviewState)
 		{
-			// Map to 0, 1, 2, ...
-			int mappedNoteKey = currentNote->key() - minKey;
-			int invertedMappedNoteKey = adjustedNoteRange - mappedNoteKey - 1;
+			m_notesPreview = QPixmap(size());
+			m_notesPreview.fill(Qt::transparent);
+			QPainter notes(&m_notesPreview);
 
-			float const noteStartX = (currentNote->pos() + offset) * tickLength;
-			float const noteLength = currentNote->length() * tickLength;
+			notes.translate(0., distanceToTop + notesBorder);
+			notes.scale(width(), height() - distanceToTop - 2 * notesBorder);
 
-			float const noteStartY = invertedMappedNoteKey * noteHeight;
-
-			QRectF noteRectF( noteStartX, noteStartY, noteLength, noteHeight);
 			if (drawAsLines)
 			{
-				p.drawLine(QPointF(noteStartX, noteStartY + 0.5 * noteHeight),
-					   QPointF(noteStartX + noteLength, noteStartY + 0.5 * noteHeight));
+				notes.setPen(noteFillColor);
 			}
 			else
 			{
-				p.fillRect( noteRectF, noteFillColor );
-				p.drawRect( noteRectF );
+				notes.setPen(noteBorderColor);
+				notes.setRenderHint(QPainter::Antialiasing);
 			}
+
+			// Needed for Qt5 although the documentation for QPainter::setPen(QColor) as it's used above
+			// states that it should already set a width of 0.
+			QPen pen = notes.pen();
+			pen.setWidth(0);
+			notes.setPen(pen);
+
+			float const noteHeight = 1. / adjustedNoteRange;
+
+			// scan through all the notes and draw them on the clip
+			for (Note const * currentNote : noteCollection)
+			{
+				// Map to 0, 1, 2, ...
+				int mappedNoteKey = currentNote->key() - minKey;
+				int invertedMappedNoteKey = adjustedNoteRange - mappedNoteKey - 1;
+
+				float const noteStartX = (currentNote->pos() + offset) * tickLength;
+				float const noteLength = currentNote->length() * tickLength;
+
+				float const noteStartY = invertedMappedNoteKey * noteHeight;
+
+				QRectF noteRectF( noteStartX, noteStartY, noteLength, noteHeight);
+				if (drawAsLines)
+				{
+					notes.drawLine(QPointF(noteStartX, noteStartY + 0.5 * noteHeight),
+						   QPointF(noteStartX + noteLength, noteStartY + 0.5 * noteHeight));
+				}
+				else
+				{
+					notes.fillRect( noteRectF, noteFillColor );
+					notes.drawRect( noteRectF );
+				}
+			}
+
+			m_notesPreviewState = std::move(notesState);
 		}
 
-		p.restore();
+		p.drawPixmap(0, 0, m_notesPreview);
 	}
 
 	// bar lines
@@ -889,7 +909,7 @@ bool MidiClipView::destructiveSplitClip(const TimePos pos)
 	auto rightClip =  m_clip->clone();
 	rightClip->clearNotes();
 
-	for (Note const* note : m_clip->m_notes)
+	for (Note const* note : m_clip->notes())
 	{
 		if (note->pos() >= internalSplitPos)
 		{
@@ -906,7 +926,7 @@ bool MidiClipView::destructiveSplitClip(const TimePos pos)
 		}
 	}
 
-	for (Note const* note : m_clip->m_notes)
+	for (Note const* note : m_clip->notes())
 	{
 		if (note->endPos() <= internalSplitPos)
 		{
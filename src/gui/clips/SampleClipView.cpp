@@ -25,8 +25,10 @@
 #include "SampleClipView.h"
 
 #include <QApplication>
+#include <QInputDialog>
 #include <QMenu>
 #include <QPainter>
+#include <QTimer>
 
 #include "GuiApplication.h"
 #include "AutomationEditor.h"
@@ -57,6 +59,7 @@ SampleClipView::SampleClipView( SampleClip * _clip, TrackView * _tv ) :
 	connect(m_clip, SIGNAL(sampleChanged()), this, SLOT(updateSample()));
 
 	connect(m_clip, SIGNAL(wasReversed()), this, SLOT(update()));
+	connect(&m_waveform, SIGNAL(rendered()), this, SLOT(update()));
 
 	setStyle( QApplication::style() );
 }
@@ -66,6 +69,11 @@ void SampleClipView::updateSample()
 	update();
 
 	m_sampleThumbnail = SampleThumbnail{m_clip->m_sample};
+	if (m_sampleThumbnail.isIncomplete())
+	{
+		// the sample is still being decoded, try again later
+		QTimer::singleShot(100, this, &SampleClipView::updateSample);
+	}
 
 	// set tooltip to filename so that user can see what sample this
 	// sample-clip contains
@@ -94,6 +102,12 @@ void SampleClipView::constructContextMenu(QMenu* cm)
 		SLOT(reverseSample())
 	);
 
+	cm->addAction(
+		m_clip->originalTempo() > 0 ? tr("Stop following song tempo") : tr("Follow song tempo..."),
+		this,
+		SLOT(syncToTempo())
+	);
+
 	cm->addAction(
 		embed::getIconPixmap("automation_ghost_note"),
 		tr("Set as ghost in automation editor"),
@@ -295,7 +309,7 @@ void SampleClipView::paintEvent( QPaintEvent * pe )
 			.reversed = sample.reversed()
 		};
 
-		m_sampleThumbnail.visualize(param, p);
+		m_waveform.draw(m_sampleThumbnail, param, p.pen().color(), p);
 	}
 
 	QString name = PathUtil::cleanName(m_clip->m_sample.sampleFile());
@@ -363,6 +377,27 @@ void SampleClipView::reverseSample()
 
 
 
+void SampleClipView::syncToTempo()
+{
+	if (m_clip->originalTempo() > 0)
+	{
+		m_clip->setOriginalTempo(0);
+	}
+	else
+	{
+		auto ok = false;
+		const auto tempo = QInputDialog::getInt(this, tr("Follow song tempo"),
+			tr("Tempo of the sample (BPM). It is stretched to the tempo of the song without changing its pitch."),
+			Engine::getSong()->getTempo(), MinTempo, MaxTempo, 1, &ok);
+		if (!ok) { return; }
+		m_clip->setOriginalTempo(tempo);
+	}
+	Engine::getSong()->setModified();
+	update();
+}
+
+
+
 void SampleClipView::setAutomationGhost()
 {
 	auto aEditor = gui::getGUI()->automationEditor();
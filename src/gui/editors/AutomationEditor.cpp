@@ -37,6 +37,7 @@
 #include <QScrollBar>
 #include <QStyleOption>
 #include <QToolTip>
+#include <bit>
 #include <cmath>
 
 #include "SampleClip.h"
@@ -182,6 +183,7 @@ void AutomationEditor::setCurrentClip(AutomationClip * new_clip )
 	}
 
 	m_clip = new_clip;
+	m_curveSegments.clear();
 
 	if (m_clip != nullptr)
 	{
@@ -895,6 +897,7 @@ void AutomationEditor::mouseMoveEvent(QMouseEvent * mouseEvent )
 					{
 						it.value().setInTangent(newTangent);
 					}
+					m_clip->publishCurve();
 				}
 				else if (m_mouseDownRight && m_action == Action::ResetTangents)
 				{
@@ -1313,49 +1316,28 @@ void AutomationEditor::paintEvent(QPaintEvent * pe )
 		//Don't bother doing/rendering anything if there is no automation points
 		if( time_map.size() > 0 )
 		{
-			timeMap::iterator it = time_map.begin();
+			// start at the last node before the visible area
+			const int firstTick = m_currentPosition - VALUES_WIDTH * TimePos::ticksPerBar() / std::max(m_ppb, 1);
+			timeMap::iterator it = time_map.upperBound(firstTick);
+			if (it != time_map.begin()) { --it; }
+
+			// the segments are cached in ticks and levels, so scrolling only moves them
+			const float levelOffset = yCoordOfLevel(0);
+			const auto toView = QTransform(
+				static_cast<float>(m_ppb) / TimePos::ticksPerBar(), 0, 0, yCoordOfLevel(1) - levelOffset,
+				VALUES_WIDTH - static_cast<float>(m_currentPosition) * m_ppb / TimePos::ticksPerBar(), levelOffset);
+
 			while( it+1 != time_map.end() )
 			{
-				// skip this section if it occurs completely before the
-				// visible area
-				int next_x = xCoordOfTick(POS(it+1));
-				if( next_x < 0 )
-				{
-					++it;
-					continue;
-				}
-
 				int x = xCoordOfTick(POS(it));
 				if( x > width() )
 				{
 					break;
 				}
 
-				float *values = m_clip->valuesAfter(POS(it));
-
-				// We are creating a path to draw a polygon representing the values between two
-				// nodes. When we have two nodes with discrete progression, we will basically have
-				// a rectangle with the outValue of the first node (that's why nextValue will match
-				// the outValue of the current node). When we have nodes with linear or cubic progression
-				// the value of the end of the shape between the two nodes will be the inValue of
-				// the next node.
-				float nextValue = m_clip->progressionType() == AutomationClip::ProgressionType::Discrete
-					? OUTVAL(it)
-					: INVAL(it + 1);
-
 				p.setRenderHints( QPainter::Antialiasing, true );
-				QPainterPath path;
-				path.moveTo(QPointF(xCoordOfTick(POS(it)), yCoordOfLevel(0)));
-				for (int i = 0; i < POS(it + 1) - POS(it); i++)
-				{
-					path.lineTo(QPointF(xCoordOfTick(POS(it) + i), yCoordOfLevel(values[i])));
-				}
-				path.lineTo(QPointF(xCoordOfTick(POS(it + 1)), yCoordOfLevel(nextValue)));
-				path.lineTo(QPointF(xCoordOfTick(POS(it + 1)), yCoordOfLevel(0)));
-				path.lineTo(QPointF(xCoordOfTick(POS(it)), yCoordOfLevel(0)));
-				p.fillPath(path, m_graphColor);
+				p.fillPath(toView.map(curveSegment(it)), m_graphColor);
 				p.setRenderHints( QPainter::Antialiasing, false );
-				delete [] values;
 
 				// Draw circle
 				drawAutomationPoint(p, it);
@@ -1368,8 +1350,14 @@ void AutomationEditor::paintEvent(QPaintEvent * pe )
 				++it;
 			}
 
+			// forget the segments of removed nodes
+			if (m_curveSegments.size() > static_cast<std::size_t>(time_map.size()))
+			{
+				std::erase_if(m_curveSegments, [&](const auto& segment) { return !time_map.contains(segment.first); });
+			}
+
 			for (
-				int i = POS(it), x = xCoordOfTick(i);
+				int i = std::max(POS(it), firstTick), x = xCoordOfTick(i);
 				x <= width();
 				i++, x = xCoordOfTick(i)
 			)
@@ -1525,6 +1513,46 @@ void AutomationEditor::drawLevelTick(QPainter & p, int tick, float value)
 
 
 
+const QPainterPath& AutomationEditor::curveSegment(timeMap::const_iterator it)
+{
+	// one point per pixel is enough, dense clips have many more ticks than that
+	const int step = std::max(1, TimePos::ticksPerBar() / std::max(m_ppb, 1));
+	const auto progression = m_clip->progressionType();
+
+	auto state = std::vector<int>{step, POS(it), POS(it + 1), static_cast<int>(progression),
+		std::bit_cast<int>(m_clip->getTension()), std::bit_cast<int>(OUTVAL(it)), std::bit_cast<int>(OUTTAN(it)),
+		std::bit_cast<int>(INVAL(it + 1)), std::bit_cast<int>(INTAN(it + 1))};
+
+	auto& segment = m_curveSegments[POS(it)];
+	if (state == segment.state) { return segment.path; }
+
+	// We are creating a path to draw a polygon representing the values between two
+	// nodes. When we have two nodes with discrete progression, we will basically have
+	// a rectangle with the outValue of the first node (that's why nextValue will match
+	// the outValue of the current node). When we have nodes with linear or cubic progression
+	// the value of the end of the shape between the two nodes will be the inValue of
+	// the next node.
+	const float nextValue = progression == AutomationClip::ProgressionType::Discrete ? OUTVAL(it) : INVAL(it + 1);
+	const auto values = m_clip->valuesAfter(POS(it), step);
+
+	auto path = QPainterPath();
+	path.moveTo(POS(it), 0);
+	for (std::size_t i = 0; i < values.size(); ++i)
+	{
+		path.lineTo(POS(it) + static_cast<int>(i) * step, values[i]);
+	}
+	path.lineTo(POS(it + 1), nextValue);
+	path.lineTo(POS(it + 1), 0);
+	path.closeSubpath();
+
+	segment.state = std::move(state);
+	segment.path = std::move(path);
+	return segment.path;
+}
+
+
+
+
 // Center the vertical scroll position on the first object's inValue
 void AutomationEditor::centerTopBottomScroll()
 {
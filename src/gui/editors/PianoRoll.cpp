@@ -43,6 +43,7 @@
 #include <QStyleOption>
 #include <QToolButton>
 
+#include <bit>
 #include <cmath>
 #include <utility>
 
@@ -849,6 +850,7 @@ void PianoRoll::setCurrentMidiClip( MidiClip* newMidiClip )
 
 	// set new data
 	m_midiClip = newMidiClip;
+	if (m_midiClip) { m_midiClip->detachNotes(); }
 	m_currentPosition = 0;
 	m_currentNote = nullptr;
 	m_startKey = INITIAL_START_KEY;
@@ -1083,6 +1085,17 @@ void PianoRoll::drawNoteRect( QPainter & p, int x, int y,
 
 
 
+QPixmap PianoRoll::createLayer() const
+{
+	auto layer = QPixmap(size() * devicePixelRatioF());
+	layer.setDevicePixelRatio(devicePixelRatioF());
+	layer.fill(Qt::transparent);
+	return layer;
+}
+
+
+
+
 void PianoRoll::drawDetuningInfo( QPainter & _p, const Note * _n, int _x,
 								int _y ) const
 {
@@ -1647,8 +1660,8 @@ void PianoRoll::mousePressEvent(QMouseEvent * me )
 	if (m_editMode == EditMode::Strum && me->button() == Qt::LeftButton)
 	{
 		// Only strum if the user is dragging a selected note
-		const auto& selectedNotes = getSelectedNotes();
-		if (std::find(selectedNotes.begin(), selectedNotes.end(), noteUnderMouse()) != selectedNotes.end())
+		const Note* note = noteUnderMouse();
+		if (note && note->selected())
 		{
 			updateStrumPos(me, true, me->modifiers() & Qt::ShiftModifier);
 			m_strumEnabled = true;
@@ -1720,14 +1733,16 @@ void PianoRoll::mousePressEvent(QMouseEvent * me )
 							m_currentPosition;
 
 
-			// get note-vector of current MIDI clip
-			const NoteVector & notes = m_midiClip->notes();
-
-			// will be our iterator in the following loop
-			auto it = notes.rbegin();
+			// only look at the notes around the click, the edit
+			// lines belong to notes of any key
+			const int editLineTicks = NOTE_EDIT_LINE_WIDTH * TimePos::ticksPerBar() / m_ppb;
+			const NoteVector notes = edit_note
+				? m_midiClip->notesIn(pos_ticks - editLineTicks, pos_ticks)
+				: m_midiClip->notesIn(pos_ticks, pos_ticks, key_num, key_num);
 
-			// loop through whole note-vector...
-			while (it != notes.rend())
+			// the note drawn last is the one on top
+			Note* clickedNote = nullptr;
+			for (auto it = notes.rbegin(); it != notes.rend() && !clickedNote; ++it)
 			{
 				Note *note = *it;
 				TimePos len = note->length();
@@ -1745,14 +1760,12 @@ void PianoRoll::mousePressEvent(QMouseEvent * me )
 					note->key() == key_num )
 					||
 					( edit_note &&
-					pos_ticks <= note->pos() +
-						NOTE_EDIT_LINE_WIDTH * TimePos::ticksPerBar() / m_ppb )
+					pos_ticks <= note->pos() + editLineTicks )
 					)
 					)
 				{
-					break;
+					clickedNote = note;
 				}
-				++it;
 			}
 
 			// first check whether the user clicked in note-edit-
@@ -1772,9 +1785,8 @@ void PianoRoll::mousePressEvent(QMouseEvent * me )
 				bool is_new_note = false;
 
 				Note * created_new_note = nullptr;
-				// did it reach end of vector because
-				// there's no note??
-				if (it == notes.rend())
+				// no note was clicked?
+				if (!clickedNote)
 				{
 					is_new_note = true;
 					m_midiClip->addJournalCheckPoint();
@@ -1818,17 +1830,12 @@ void PianoRoll::mousePressEvent(QMouseEvent * me )
 						}
 					}
 
-					// reset it so that it can be used for
-					// ops (move, resize) after this
-					// code-block
-					it = notes.rbegin();
-					while (it != notes.rend() && *it != created_new_note)
-					{
-						++it;
-					}
+					// the new note is used for ops (move,
+					// resize) after this code-block
+					clickedNote = created_new_note;
 				}
 
-				Note *current_note = *it;
+				Note *current_note = clickedNote;
 				m_currentNote = current_note;
 				m_lastNotePanning = current_note->getPanning();
 				m_lastNoteVolume = current_note->getVolume();
@@ -1938,10 +1945,10 @@ void PianoRoll::mousePressEvent(QMouseEvent * me )
 			{
 				// erase single note
 				m_mouseDownRight = true;
-				if (it != notes.rend())
+				if (clickedNote)
 				{
 					m_midiClip->addJournalCheckPoint();
-					m_midiClip->removeNote( *it );
+					m_midiClip->removeNote(clickedNote);
 					Engine::getSong()->setModified();
 				}
 			}
@@ -2255,14 +2262,17 @@ void PianoRoll::computeSelectedNotes(bool shift)
 	//int y_base = noteEditTop() - 1;
 	if( hasValidMidiClip() )
 	{
-		for( Note *note : m_midiClip->notes() )
+		// make a new selection unless they're holding shift
+		if( ! shift )
 		{
-			// make a new selection unless they're holding shift
-			if( ! shift )
-			{
-				note->setSelected( false );
-			}
+			clearSelectedNotes();
+		}
 
+		// only the notes overlapping the selection are looked at
+		const NoteVector notes = m_midiClip->notesIn(sel_pos_start + 1, sel_pos_end - 1,
+			sel_key_start + m_startKey, sel_key_end + m_startKey - 1);
+		for (Note* note : notes)
+		{
 			int len_ticks = note->length();
 
 			if( len_ticks == 0 )
@@ -2341,7 +2351,13 @@ void PianoRoll::mouseReleaseEvent( QMouseEvent * me )
 		{
 			bool deleteShortEnds = me->modifiers() & Qt::ShiftModifier;
 			const NoteVector selectedNotes = getSelectedNotes();
-			m_midiClip->splitNotesAlongLine(!selectedNotes.empty() ? selectedNotes : m_midiClip->notes(), TimePos(m_knifeStartTickPos), m_knifeStartKey, TimePos(m_knifeEndTickPos), m_knifeEndKey, deleteShortEnds);
+			// only the notes within the line's bounding box can be cut
+			const auto [minTick, maxTick] = std::minmax(m_knifeStartTickPos, m_knifeEndTickPos);
+			const auto [minKey, maxKey] = std::minmax(m_knifeStartKey, m_knifeEndKey);
+			const NoteVector notes = !selectedNotes.empty()
+				? selectedNotes
+				: m_midiClip->notesIn(minTick, maxTick, minKey + 1, maxKey);
+			m_midiClip->splitNotesAlongLine(notes, TimePos(m_knifeStartTickPos), m_knifeStartKey, TimePos(m_knifeEndTickPos), m_knifeEndKey, deleteShortEnds);
 			m_knifeDown = false;
 		}
 
@@ -2619,13 +2635,13 @@ void PianoRoll::mouseMoveEvent( QMouseEvent * me )
 			int pos_ticks = ( x * TimePos::ticksPerBar() ) /
 						m_ppb + m_currentPosition;
 
-			// get note-vector of current MIDI clip
-			const NoteVector & notes = m_midiClip->notes();
+			// get the notes around the cursor
+			const NoteVector notes = m_midiClip->notesIn(pos_ticks, pos_ticks, key_num, key_num);
 
 			// will be our iterator in the following loop
 			auto it = notes.rbegin();
 
-			// loop through whole note-vector...
+			// loop through the notes...
 			while (it != notes.rend())
 			{
 				Note *note = *it;
@@ -2696,16 +2712,15 @@ void PianoRoll::mouseMoveEvent( QMouseEvent * me )
 							m_currentPosition;
 
 
-			// get note-vector of current MIDI clip
-			const NoteVector & notes = m_midiClip->notes();
-
-			// will be our iterator in the following loop
-			auto it = notes.begin();
+			// get the notes around the cursor, the edit lines
+			// belong to notes of any key
+			const int editLineTicks = NOTE_EDIT_LINE_WIDTH * TimePos::ticksPerBar() / m_ppb;
+			const NoteVector notes = edit_note
+				? m_midiClip->notesIn(pos_ticks - editLineTicks, pos_ticks)
+				: m_midiClip->notesIn(pos_ticks, pos_ticks, key_num, key_num);
 
-			// loop through whole note-vector...
-			while( it != notes.end() )
+			for (Note* note : notes)
 			{
-				Note *note = *it;
 				TimePos len = note->length();
 				if( len < 0 )
 				{
@@ -2721,21 +2736,14 @@ void PianoRoll::mouseMoveEvent( QMouseEvent * me )
 					note->key() == key_num )
 					||
 					( edit_note &&
-					pos_ticks <= note->pos() +
-							NOTE_EDIT_LINE_WIDTH *
-						TimePos::ticksPerBar() /
-								m_ppb )
+					pos_ticks <= note->pos() + editLineTicks )
 					)
 					)
 				{
 					// delete this note
-					it = m_midiClip->removeNote(it);
+					m_midiClip->removeNote(note);
 					Engine::getSong()->setModified();
 				}
-				else
-				{
-					++it;
-				}
 			}
 		}
 		else if (me->buttons() == Qt::NoButton && m_editMode != EditMode::Draw && m_editMode != EditMode::Knife && m_editMode != EditMode::Strum)
@@ -3289,7 +3297,6 @@ void PianoRoll::paintEvent(QPaintEvent * pe )
 		}
 		int x, q = quantization(), tick;
 
-		// draw vertical quantization lines
 		// If we're over 100% zoom, we allow all quantization level grids
 		if (m_zoomingModel.value() <= 3)
 		{
@@ -3299,20 +3306,6 @@ void PianoRoll::paintEvent(QPaintEvent * pe )
 			// allow quantization grid up to 1/32 for normal notes
 			else if (q < 6) { q = 6; }
 		}
-    
-		p.setPen(m_lineColor);
-		for (tick = m_currentPosition - m_currentPosition % q,
-			x = xCoordOfTick(tick);
-			x <= width();
-			tick += q, x = xCoordOfTick(tick))
-		{
-			p.drawLine(x, keyAreaTop(), x, noteEditBottom());
-		}
-
-		// draw horizontal grid lines and piano notes
-		p.setClipRect(0, keyAreaTop(), width(), keyAreaBottom() - keyAreaTop());
-		// the first grid line from the top Y position
-		int grid_line_y = keyAreaTop() + m_keyLineHeight - 1;
 
 		// lambda function for returning the height of a key
 		auto keyHeight = [&](
@@ -3425,16 +3418,34 @@ void PianoRoll::paintEvent(QPaintEvent * pe )
 				p.drawText(textRect, Qt::AlignRight | Qt::AlignHCenter, noteString);
 			}
 		};
-		// lambda for drawing the horizontal grid line
-		auto drawHorizontalLine = [&](
-			const int key,
-			const int y
-		)
-		{
-			if (static_cast<Key>(key % KeysPerOctave) == Key::C) { p.setPen(m_beatLineColor); }
-			else { p.setPen(m_lineColor); }
-			p.drawLine(m_whiteKeyWidth, y, width(), y);
+		// lambda for going through the visible keys from the top, the
+		// white keys next to a black key come first so it is drawn over them
+		auto forEachVisibleKey = [&](auto&& draw)
+		{
+			// the first grid line from the top Y position
+			int grid_line_y = keyAreaTop() + m_keyLineHeight - 1;
+			const int lastKey = qMax(0, topKey - m_pianoKeysVisible);
+			for (int key = topKey; key > lastKey; --key)
+			{
+				if (Piano::isWhiteKey(key))
+				{
+					draw(key, grid_line_y);
+					grid_line_y += m_keyLineHeight;
+				}
+				else
+				{
+					draw(key - 1, grid_line_y + m_keyLineHeight);
+					draw(key, grid_line_y);
+					// drew two grid keys so skip ahead properly
+					grid_line_y += m_keyLineHeight + m_keyLineHeight;
+					// capture double key draw
+					--key;
+				}
+			}
 		};
+
+		// draw piano keys, they change while playing so they aren't cached
+		p.setClipRect(0, keyAreaTop(), width(), keyAreaBottom() - keyAreaTop());
 		// correct y offset of the top key
 		switch (prKeyOrder[topNote])
 		{
@@ -3443,94 +3454,116 @@ void PianoRoll::paintEvent(QPaintEvent * pe )
 			break;
 		case KeyType::Black:
 			// draw extra white key
-			drawKey(topKey + 1, grid_line_y - m_keyLineHeight);
+			drawKey(topKey + 1, keyAreaTop() - 1);
 		}
-		// loop through visible keys
-		const int lastKey = qMax(0, topKey - m_pianoKeysVisible);
-		for (int key = topKey; key > lastKey; --key)
-		{
-			bool whiteKey = Piano::isWhiteKey(key);
-			if (whiteKey)
+		forEachVisibleKey(drawKey);
+
+		// the grid only changes when scrolling, zooming or resizing, so
+		// it is drawn into a layer and only redrawn then
+		const int timeSigNumerator = Engine::getSong()->getTimeSigModel().getNumerator();
+		const int timeSigDenominator = Engine::getSong()->getTimeSigModel().getDenominator();
+		auto gridState = std::vector<int>{width(), height(), static_cast<int>(devicePixelRatioF() * 100),
+			m_currentPosition, m_ppb, m_zoomingModel.value(), q, topKey, m_pianoKeysVisible, m_keyLineHeight,
+			m_whiteKeyWidth, m_notesEditHeight, timeSigNumerator, timeSigDenominator};
+		gridState.insert(gridState.end(), m_markedSemiTones.begin(), m_markedSemiTones.end());
+
+		if (gridState != m_gridLayerState)
+		{
+			m_gridLayer = createLayer();
+			QPainter g(&m_gridLayer);
+
+			// draw vertical quantization lines, except where the keys are
+			// drawn over them
+			g.setClipRegion(QRegion(rect())
+				- QRect(0, keyAreaTop(), m_whiteKeyWidth + 1, keyAreaBottom() - keyAreaTop()));
+			g.setPen(m_lineColor);
+			for (tick = m_currentPosition - m_currentPosition % q,
+				x = xCoordOfTick(tick);
+				x <= width();
+				tick += q, x = xCoordOfTick(tick))
 			{
-				drawKey(key, grid_line_y);
-				drawHorizontalLine(key, grid_line_y);
-				grid_line_y += m_keyLineHeight;
+				g.drawLine(x, keyAreaTop(), x, noteEditBottom());
 			}
-			else
+
+			// draw horizontal grid lines
+			g.setClipRect(0, keyAreaTop(), width(), keyAreaBottom() - keyAreaTop());
+			// lambda for drawing the horizontal grid line
+			auto drawHorizontalLine = [&](
+				const int key,
+				const int y
+			)
 			{
-				// draw next white key
-				drawKey(key - 1, grid_line_y + m_keyLineHeight);
-				drawHorizontalLine(key - 1, grid_line_y + m_keyLineHeight);
-				// draw black key over previous and next white key
-				drawKey(key, grid_line_y);
-				drawHorizontalLine(key, grid_line_y);
-				// drew two grid keys so skip ahead properly
-				grid_line_y += m_keyLineHeight + m_keyLineHeight;
-				// capture double key draw
-				--key;
+				if (static_cast<Key>(key % KeysPerOctave) == Key::C) { g.setPen(m_beatLineColor); }
+				else { g.setPen(m_lineColor); }
+				g.drawLine(m_whiteKeyWidth, y, width(), y);
+			};
+			forEachVisibleKey(drawHorizontalLine);
+
+			// don't draw over keys
+			g.setClipRect(m_whiteKeyWidth, keyAreaTop(), width(), noteEditBottom() - keyAreaTop());
+
+			// draw alternating shading on bars
+			float timeSignature =
+				static_cast<float>(timeSigNumerator) /
+				static_cast<float>(timeSigDenominator);
+			float zoomFactor = m_zoomLevels[m_zoomingModel.value()];
+			//the bars which disappears at the left side by scrolling
+			int leftBars = m_currentPosition * zoomFactor / TimePos::ticksPerBar();
+			//iterates the visible bars and draw the shading on uneven bars
+			for (int x = m_whiteKeyWidth, barCount = leftBars;
+				x < width() + m_currentPosition * zoomFactor / timeSignature;
+				x += m_ppb, ++barCount)
+			{
+				if ((barCount + leftBars) % 2 != 0)
+				{
+					g.fillRect(x - m_currentPosition * zoomFactor / timeSignature,
+						PR_TOP_MARGIN,
+						m_ppb,
+						height() - (PR_BOTTOM_MARGIN + PR_TOP_MARGIN),
+						m_backgroundShade);
+				}
 			}
-		}
 
-		// don't draw over keys
-		p.setClipRect(m_whiteKeyWidth, keyAreaTop(), width(), noteEditBottom() - keyAreaTop());
-
-		// draw alternating shading on bars
-		float timeSignature =
-			static_cast<float>(Engine::getSong()->getTimeSigModel().getNumerator()) /
-			static_cast<float>(Engine::getSong()->getTimeSigModel().getDenominator());
-		float zoomFactor = m_zoomLevels[m_zoomingModel.value()];
-		//the bars which disappears at the left side by scrolling
-		int leftBars = m_currentPosition * zoomFactor / TimePos::ticksPerBar();
-		//iterates the visible bars and draw the shading on uneven bars
-		for (int x = m_whiteKeyWidth, barCount = leftBars;
-			x < width() + m_currentPosition * zoomFactor / timeSignature;
-			x += m_ppb, ++barCount)
-		{
-			if ((barCount + leftBars) % 2 != 0)
+			// draw vertical beat lines
+			int ticksPerBeat = DefaultTicksPerBar / timeSigDenominator;
+			g.setPen(m_beatLineColor);
+			for(tick = m_currentPosition - m_currentPosition % ticksPerBeat,
+				x = xCoordOfTick( tick );
+				x <= width();
+				tick += ticksPerBeat, x = xCoordOfTick(tick))
 			{
-				p.fillRect(x - m_currentPosition * zoomFactor / timeSignature,
-					PR_TOP_MARGIN,
-					m_ppb,
-					height() - (PR_BOTTOM_MARGIN + PR_TOP_MARGIN),
-					m_backgroundShade);
+				g.drawLine(x, PR_TOP_MARGIN, x, noteEditBottom());
 			}
-		}
 
-		// draw vertical beat lines
-		int ticksPerBeat = DefaultTicksPerBar /
-			Engine::getSong()->getTimeSigModel().getDenominator();
-		p.setPen(m_beatLineColor);
-		for(tick = m_currentPosition - m_currentPosition % ticksPerBeat,
-			x = xCoordOfTick( tick );
-			x <= width();
-			tick += ticksPerBeat, x = xCoordOfTick(tick))
-		{
-			p.drawLine(x, PR_TOP_MARGIN, x, noteEditBottom());
-		}
+			// draw vertical bar lines
+			g.setPen(m_barLineColor);
+			for(tick = m_currentPosition - m_currentPosition % TimePos::ticksPerBar(),
+				x = xCoordOfTick( tick );
+				x <= width();
+				tick += TimePos::ticksPerBar(), x = xCoordOfTick(tick))
+			{
+				g.drawLine(x, PR_TOP_MARGIN, x, noteEditBottom());
+			}
 
-		// draw vertical bar lines
-		p.setPen(m_barLineColor);
-		for(tick = m_currentPosition - m_currentPosition % TimePos::ticksPerBar(),
-			x = xCoordOfTick( tick );
-			x <= width();
-			tick += TimePos::ticksPerBar(), x = xCoordOfTick(tick))
-		{
-			p.drawLine(x, PR_TOP_MARGIN, x, noteEditBottom());
-		}
+			// draw marked semitones after the grid
+			for(x = 0; x < m_markedSemiTones.size(); ++x)
+			{
+				const int key_num = m_markedSemiTones.at(x);
+				const int y = keyAreaBottom() - 1 - m_keyLineHeight *
+					(key_num - m_startKey + 1);
+				if(y >= keyAreaBottom() - 1) { break; }
+				g.fillRect(m_whiteKeyWidth + 1,
+					y,
+					width() - 10,
+					m_keyLineHeight + 1,
+					m_markedSemitoneColor);
+			}
 
-		// draw marked semitones after the grid
-		for(x = 0; x < m_markedSemiTones.size(); ++x)
-		{
-			const int key_num = m_markedSemiTones.at(x);
-			const int y = keyAreaBottom() - 1 - m_keyLineHeight *
-				(key_num - m_startKey + 1);
-			if(y >= keyAreaBottom() - 1) { break; }
-			p.fillRect(m_whiteKeyWidth + 1,
-				y,
-				width() - 10,
-				m_keyLineHeight + 1,
-				m_markedSemitoneColor);
+			m_gridLayerState = std::move(gridState);
 		}
+
+		p.setClipRect(0, 0, width(), height());
+		p.drawPixmap(0, 0, m_gridLayer);
 	}
 
 	// reset MIDI clip
@@ -3588,18 +3621,101 @@ void PianoRoll::paintEvent(QPaintEvent * pe )
 		const int topKey = qBound(0, m_startKey + m_pianoKeysVisible - 1, NumKeys - 1);
 		const int bottomKey = topKey - m_pianoKeysVisible;
 
-		QPolygonF editHandles;
-
 		// Return a note's Y position on the grid
 		auto noteYPos = [&](const int key)
 		{
 			return (topKey - key) * m_keyLineHeight + keyAreaTop() - 1;
 		};
 
-		// -- Begin ghost MIDI clip
-		if( !m_ghostNotes.empty() )
+		// only look at the notes in the visible time range, give or
+		// take the pixels lost by rounding. Edit lines are drawn for the
+		// notes of all keys.
+		const int pixelMargin = 2 * ((TimePos::ticksPerBar() + m_ppb - 1) / m_ppb);
+		const int visibleTicks = (width() - m_whiteKeyWidth) * TimePos::ticksPerBar() / m_ppb;
+		const NoteVector visibleNotes = m_midiClip->notesIn(
+			m_currentPosition - pixelMargin, m_currentPosition + visibleTicks + pixelMargin);
+
+		// the notes only change when they are edited, so they are drawn into
+		// a layer too, which is only redrawn if what is drawn of them changed
+		// and not when just the keys, the selection or the position line did
+		auto notesState = std::vector<int>{width(), height(), static_cast<int>(devicePixelRatioF() * 100),
+			m_currentPosition, m_ppb, topKey, m_pianoKeysVisible, m_keyLineHeight, m_whiteKeyWidth,
+			m_notesEditHeight, static_cast<int>(m_noteEditMode), drawNoteNames, m_noteOpacity, m_noteBorders,
+			m_ghostNoteOpacity, m_ghostNoteBorders, static_cast<int>(m_ghostNotes.size())};
+		const auto addNoteState = [&notesState](const Note* note)
+		{
+			notesState.insert(notesState.end(), {note->pos(), note->length(), note->key(), note->getVolume(),
+				note->getPanning(), note->selected(), static_cast<int>(note->type()), note->hasDetuningInfo()});
+			if (note->hasDetuningInfo())
+			{
+				const AutomationClip* detuning = note->detuning()->automationClip();
+				notesState.push_back(static_cast<int>(detuning->progressionType()));
+				for (auto it = detuning->getTimeMap().begin(); it != detuning->getTimeMap().end(); ++it)
+				{
+					notesState.insert(notesState.end(),
+						{POS(it), std::bit_cast<int>(INVAL(it)), std::bit_cast<int>(OUTVAL(it))});
+				}
+			}
+		};
+		for (const Note* note : m_ghostNotes) { addNoteState(note); }
+		for (const Note* note : visibleNotes) { addNoteState(note); }
+
+		if (notesState != m_notesLayerState)
 		{
-			for( const Note *note : m_ghostNotes )
+			m_notesLayer = createLayer();
+			m_notesLayerEditHandles.clear();
+
+			QPainter layer(&m_notesLayer);
+			layer.setFont(p.font());
+			layer.setClipRect(
+				m_whiteKeyWidth,
+				PR_TOP_MARGIN,
+				width() - m_whiteKeyWidth,
+				height() - PR_TOP_MARGIN);
+
+			// -- Begin ghost MIDI clip
+			if( !m_ghostNotes.empty() )
+			{
+				for( const Note *note : m_ghostNotes )
+				{
+					int len_ticks = note->length();
+
+					if( len_ticks == 0 )
+					{
+						continue;
+					}
+					else if( len_ticks < 0 )
+					{
+						len_ticks = 4;
+					}
+
+					int pos_ticks = note->pos();
+
+					int note_width = len_ticks * m_ppb / TimePos::ticksPerBar();
+					const int x = ( pos_ticks - m_currentPosition ) *
+							m_ppb / TimePos::ticksPerBar();
+					// skip this note if not in visible area at all
+					if (!(x + note_width >= 0 && x <= width() - m_whiteKeyWidth))
+					{
+						continue;
+					}
+
+					// is the note in visible area?
+					if (note->key() > bottomKey && note->key() <= topKey)
+					{
+
+						// we've done and checked all, let's draw the note
+						drawNoteRect(
+							layer, x + m_whiteKeyWidth, noteYPos(note->key()), note_width,
+							note, m_ghostNoteColor, m_ghostNoteTextColor, m_selectedNoteColor,
+							m_ghostNoteOpacity, m_ghostNoteBorders, drawNoteNames);
+					}
+
+				}
+			}
+			// -- End ghost MIDI clip
+
+			for (const Note* note : visibleNotes)
 			{
 				int len_ticks = note->length();
 
@@ -3626,109 +3742,75 @@ void PianoRoll::paintEvent(QPaintEvent * pe )
 				// is the note in visible area?
 				if (note->key() > bottomKey && note->key() <= topKey)
 				{
+					// We've done and checked all, let's draw the note with
+					// the appropriate color
+					const auto fillColor = note->type() == Note::Type::Regular ? m_noteColor : m_stepNoteColor;
 
-					// we've done and checked all, let's draw the note
 					drawNoteRect(
-						p, x + m_whiteKeyWidth, noteYPos(note->key()), note_width,
-						note, m_ghostNoteColor, m_ghostNoteTextColor, m_selectedNoteColor,
-						m_ghostNoteOpacity, m_ghostNoteBorders, drawNoteNames);
+						layer, x + m_whiteKeyWidth, noteYPos(note->key()), note_width,
+						note, fillColor, m_noteTextColor, m_selectedNoteColor,
+						m_noteOpacity, m_noteBorders, drawNoteNames
+					);
 				}
 
-			}
-		}
-		// -- End ghost MIDI clip
-
-		for( const Note *note : m_midiClip->notes() )
-		{
-			int len_ticks = note->length();
+				// draw note editing stuff
+				int editHandleTop = 0;
+				if( m_noteEditMode == NoteEditMode::Volume )
+				{
+					QColor color = m_barColor.lighter(30 + (note->getVolume() * 90 / MaxVolume));
+					if( note->selected() )
+					{
+						color = m_selectedNoteColor;
+					}
+					layer.setPen( QPen( color, NOTE_EDIT_LINE_WIDTH ) );
 
-			if( len_ticks == 0 )
-			{
-				continue;
-			}
-			else if( len_ticks < 0 )
-			{
-				len_ticks = 4;
-			}
+					editHandleTop = noteEditBottom() -
+						( (float)( note->getVolume() - MinVolume ) ) /
+						( (float)( MaxVolume - MinVolume ) ) *
+						( (float)( noteEditBottom() - noteEditTop() ) );
 
-			int pos_ticks = note->pos();
+					layer.drawLine( QLineF ( noteEditLeft() + x + 0.5, editHandleTop + 0.5,
+								noteEditLeft() + x + 0.5, noteEditBottom() + 0.5 ) );
 
-			int note_width = len_ticks * m_ppb / TimePos::ticksPerBar();
-			const int x = ( pos_ticks - m_currentPosition ) *
-					m_ppb / TimePos::ticksPerBar();
-			// skip this note if not in visible area at all
-			if (!(x + note_width >= 0 && x <= width() - m_whiteKeyWidth))
-			{
-				continue;
-			}
+				}
+				else if( m_noteEditMode == NoteEditMode::Panning )
+				{
+					QColor color = m_noteColor;
+					if( note->selected() )
+					{
+						color = m_selectedNoteColor;
+					}
 
-			// is the note in visible area?
-			if (note->key() > bottomKey && note->key() <= topKey)
-			{
-				// We've done and checked all, let's draw the note with
-				// the appropriate color
-				const auto fillColor = note->type() == Note::Type::Regular ? m_noteColor : m_stepNoteColor;
+					layer.setPen( QPen( color, NOTE_EDIT_LINE_WIDTH ) );
 
-				drawNoteRect(
-					p, x + m_whiteKeyWidth, noteYPos(note->key()), note_width,
-					note, fillColor, m_noteTextColor, m_selectedNoteColor,
-					m_noteOpacity, m_noteBorders, drawNoteNames
-				);
-			}
+					editHandleTop = noteEditBottom() -
+						( (float)( note->getPanning() - PanningLeft ) ) /
+						( (float)( (PanningRight - PanningLeft ) ) ) *
+						( (float)( noteEditBottom() - noteEditTop() ) );
 
-			// draw note editing stuff
-			int editHandleTop = 0;
-			if( m_noteEditMode == NoteEditMode::Volume )
-			{
-				QColor color = m_barColor.lighter(30 + (note->getVolume() * 90 / MaxVolume));
-				if( note->selected() )
-				{
-					color = m_selectedNoteColor;
+					layer.drawLine( QLine( noteEditLeft() + x, noteEditTop() +
+							( (float)( noteEditBottom() - noteEditTop() ) ) / 2.0f,
+							    noteEditLeft() + x , editHandleTop ) );
 				}
-				p.setPen( QPen( color, NOTE_EDIT_LINE_WIDTH ) );
+				m_notesLayerEditHandles << QPoint ( x + noteEditLeft(),
+							editHandleTop );
 
-				editHandleTop = noteEditBottom() -
-					( (float)( note->getVolume() - MinVolume ) ) /
-					( (float)( MaxVolume - MinVolume ) ) *
-					( (float)( noteEditBottom() - noteEditTop() ) );
-
-				p.drawLine( QLineF ( noteEditLeft() + x + 0.5, editHandleTop + 0.5,
-							noteEditLeft() + x + 0.5, noteEditBottom() + 0.5 ) );
-
-			}
-			else if( m_noteEditMode == NoteEditMode::Panning )
-			{
-				QColor color = m_noteColor;
-				if( note->selected() )
+				if( note->hasDetuningInfo() )
 				{
-					color = m_selectedNoteColor;
+					drawDetuningInfo(layer, note, x + m_whiteKeyWidth, noteYPos(note->key()));
+					layer.setClipRect(
+						m_whiteKeyWidth,
+						PR_TOP_MARGIN,
+						width() - m_whiteKeyWidth,
+						height() - PR_TOP_MARGIN);
 				}
-
-				p.setPen( QPen( color, NOTE_EDIT_LINE_WIDTH ) );
-
-				editHandleTop = noteEditBottom() -
-					( (float)( note->getPanning() - PanningLeft ) ) /
-					( (float)( (PanningRight - PanningLeft ) ) ) *
-					( (float)( noteEditBottom() - noteEditTop() ) );
-
-				p.drawLine( QLine( noteEditLeft() + x, noteEditTop() +
-						( (float)( noteEditBottom() - noteEditTop() ) ) / 2.0f,
-						    noteEditLeft() + x , editHandleTop ) );
 			}
-			editHandles << QPoint ( x + noteEditLeft(),
-						editHandleTop );
 
-			if( note->hasDetuningInfo() )
-			{
-				drawDetuningInfo(p, note, x + m_whiteKeyWidth, noteYPos(note->key()));
-				p.setClipRect(
-					m_whiteKeyWidth,
-					PR_TOP_MARGIN,
-					width() - m_whiteKeyWidth,
-					height() - PR_TOP_MARGIN);
-			}
+			m_notesLayerState = std::move(notesState);
 		}
 
+		p.drawPixmap(0, 0, m_notesLayer);
+
 		// draw clip bounds
 		p.fillRect(
 			xCoordOfTick(m_midiClip->length() - m_midiClip->startTimeOffset()),
@@ -3793,7 +3875,7 @@ void PianoRoll::paintEvent(QPaintEvent * pe )
 		}
 
 		p.setPen(QPen(m_noteColor, NOTE_EDIT_LINE_WIDTH + 2));
-		p.drawPoints( editHandles );
+		p.drawPoints(m_notesLayerEditHandles);
 
 	}
 	else
@@ -4527,7 +4609,7 @@ void PianoRoll::updateYScroll()
 
 void PianoRoll::copyToClipboard( const NoteVector & notes ) const
 {
-	// For copyString() and MimeType enum class
+	// For copyDataFile() and MimeType enum class
 	using namespace Clipboard;
 
 	DataFile dataFile( DataFile::Type::ClipboardData );
@@ -4542,7 +4624,7 @@ void PianoRoll::copyToClipboard( const NoteVector & notes ) const
 		clip_note.saveState( dataFile, note_list );
 	}
 
-	copyString( dataFile.toString(), MimeType::Default );
+	copyDataFile(dataFile, MimeType::Default);
 }
 
 
@@ -4595,46 +4677,36 @@ void PianoRoll::cutSelectedNotes()
 
 void PianoRoll::pasteNotes()
 {
-	// For getString() and MimeType enum class
+	// For decodeDataFile() and MimeType enum class
 	using namespace Clipboard;
 
-	if( ! hasValidMidiClip() )
+	if( ! hasValidMidiClip() || ! hasFormat( MimeType::Default ) )
 	{
 		return;
 	}
 
-	QString value = getString( MimeType::Default );
+	DataFile dataFile = decodeDataFile( getMimeData(), MimeType::Default );
 
-	if( ! value.isEmpty() )
-	{
-		DataFile dataFile( value.toUtf8() );
+	QDomNodeList list = dataFile.elementsByTagName( Note::classNodeName() );
 
-		QDomNodeList list = dataFile.elementsByTagName( Note::classNodeName() );
+	// remove selection and select the newly pasted notes
+	clearSelectedNotes();
 
-		// remove selection and select the newly pasted notes
-		clearSelectedNotes();
-
-		if( ! list.isEmpty() )
-		{
-			m_midiClip->addJournalCheckPoint();
-		}
-
-		for( int i = 0; ! list.item( i ).isNull(); ++i )
-		{
-			// create the note
-			Note cur_note;
-			cur_note.restoreState( list.item( i ).toElement() );
-			cur_note.setPos( cur_note.pos() + Note::quantized( m_timeLine->pos(), quantization() ) );
-
-			// select it
-			cur_note.setSelected( true );
-
-			// add to MIDI clip
-			m_midiClip->addNote( cur_note, false );
-		}
+	auto notes = std::vector<Note>{};
+	notes.reserve( list.length() );
+	for( int i = 0; ! list.item( i ).isNull(); ++i )
+	{
+		Note cur_note;
+		cur_note.restoreState( list.item( i ).toElement() );
+		cur_note.setPos( cur_note.pos() + Note::quantized( m_timeLine->pos(), quantization() ) );
+		cur_note.setSelected( true );
+		notes.push_back( cur_note );
+	}
 
-		// we only have to do the following lines if we pasted at
-		// least one note...
+	// we only have to do the following lines if we pasted at
+	// least one note...
+	if( ! m_midiClip->addNotes( notes, false ).empty() )
+	{
 		Engine::getSong()->setModified();
 		update();
 		getGUI()->songEditor()->update();
@@ -4916,8 +4988,8 @@ Note * PianoRoll::noteUnderMouse()
 	int pos_ticks = (pos.x() - m_whiteKeyWidth) *
 			TimePos::ticksPerBar() / m_ppb + m_currentPosition;
 
-	// loop through whole note-vector...
-	for( Note* const& note : m_midiClip->notes() )
+	// loop through the notes around the cursor...
+	for (Note* note : m_midiClip->notesIn(pos_ticks, pos_ticks, key_num, key_num))
 	{
 		// and check whether the cursor is over an
 		// existing note
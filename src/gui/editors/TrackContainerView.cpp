@@ -206,6 +206,7 @@ void TrackContainerView::moveTrackView( TrackView * trackView, int indexTo )
 
 	m_tc->m_tracks.erase(m_tc->m_tracks.begin() + indexFrom);
 	m_tc->m_tracks.insert(m_tc->m_tracks.begin() + indexTo, track);
+	TrackContainer::arrangementChanged();
 	m_trackViews.move( indexFrom, indexTo );
 
 	realignTracks();
@@ -261,6 +261,17 @@ InstrumentTrackWindow::InstrumentTrackWindow( InstrumentTrackView * _itv ) :
 
 	instrumentFunctionsLayout->addWidget( m_noteStackingView );
 	instrumentFunctionsLayout->addWidget( m_arpeggioView );
+
+	auto maxVoicesLayout = new QHBoxLayout;
+	maxVoicesLayout->setContentsMargins(8, 0, 8, 0);
+	auto maxVoicesLabel = new QLabel(tr("Maximum number of voices (0 for no limit)"));
+	maxVoicesLabel->setWordWrap(true);
+	m_maxVoicesSpinBox = new LcdSpinBox(3, nullptr, tr("Maximum voices"));
+	m_maxVoicesSpinBox->setToolTip(tr("The oldest or quietest notes are faded out when more notes play at the same time."));
+	maxVoicesLayout->addWidget(maxVoicesLabel);
+	maxVoicesLayout->addStretch();
+	maxVoicesLayout->addWidget(m_maxVoicesSpinBox);
+	instrumentFunctionsLayout->addLayout(maxVoicesLayout);
 	instrumentFunctionsLayout->addStretch();
 
 	// MIDI tab
@@ -352,6 +363,9 @@ void InstrumentTrackWindow::modelChanged()
 {
 	m_track = castModel<InstrumentTrack>();
 
+	// the instrument of a muted track may not have been created yet
+	m_track->loadDeferredInstrument();
+
 	m_nameLineEdit->setText( m_track->name() );
 
 	m_track->disconnect( SIGNAL(nameChanged()), this );
@@ -400,6 +414,7 @@ void InstrumentTrackWindow::modelChanged()
 	m_ssView->setModel(&m_track->m_soundShaping);
 	m_noteStackingView->setModel(&m_track->m_noteStacking);
 	m_arpeggioView->setModel(&m_track->m_arpeggio);
+	m_maxVoicesSpinBox->setModel(&m_track->m_maxVoicesModel);
 	m_midiView->setModel(&m_track->m_midiPort);
 	m_effectView->setModel(m_track->m_audioBusHandle.effects());
 	m_tuningView->pitchGroupBox()->setModel(&m_track->m_useMasterPitchModel);
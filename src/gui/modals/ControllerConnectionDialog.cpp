@@ -56,6 +56,8 @@ public:
 		m_detectedMidiChannel( 0 ),
 		m_detectedMidiController(NONE)
 	{
+		// we need the source port of the event, which is only valid while it is delivered
+		m_midiPort.setQueueInEvents(false);
 		updateName();
 	}
 
@@ -163,13 +163,16 @@ OutputSettings::StereoMode mapToStereoMode(int index)
 void ExportProjectDialog::startExport()
 {
 	auto qs = AudioEngine::qualitySettings(
-		static_cast<AudioEngine::qualitySettings::Interpolation>(interpolationCB->currentIndex()));
+		static_cast<AudioEngine::qualitySettings::Interpolation>(interpolationCB->currentIndex()),
+		static_cast<AudioEngine::qualitySettings::Oversampling>(oversamplingCB->currentIndex()));
 	const auto bitrates = std::array{64, 128, 160, 192, 256, 320};
 
 	OutputSettings os = OutputSettings(samplerateCB->currentData().toInt(), bitrates[bitrateCB->currentIndex()],
 		static_cast<OutputSettings::BitDepth>(depthCB->currentIndex()),
 		mapToStereoMode(stereoModeComboBox->currentIndex()));
 
+	os.setDither(static_cast<SampleConversion::Dither>(ditherCB->currentIndex()));
+
 	if (compressionWidget->isVisible())
 	{
 		double level = compLevelCB->itemData(compLevelCB->currentIndex()).toDouble();
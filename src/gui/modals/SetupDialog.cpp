@@ -25,12 +25,16 @@
 
 #include <QCheckBox>
 #include <QComboBox>
+#include <QFormLayout>
 #include <QGroupBox>
 #include <QImageReader>
 #include <QLabel>
 #include <QLayout>
 #include <QLineEdit>
 #include <QScrollArea>
+#include <QSpinBox>
+
+#include <algorithm>
 
 #include "AudioEngine.h"
 #include "embed.h"
@@ -38,6 +42,7 @@
 #include "FileDialog.h"
 #include "MainWindow.h"
 #include "MidiSetupWidget.h"
+#include "NotePlayHandle.h"
 #include "ProjectJournal.h"
 #include "SetupDialog.h"
 #include "TabBar.h"
@@ -50,6 +55,7 @@
 #include "AudioDummy.h"
 #include "AudioJack.h"
 #include "AudioOss.h"
+#include "AudioPipeWire.h"
 #include "AudioPortAudio.h"
 #include "AudioPulseAudio.h"
 #include "AudioSdl.h"
@@ -63,6 +69,7 @@
 #include "MidiDummy.h"
 #include "MidiJack.h"
 #include "MidiOss.h"
+#include "MidiPipeWire.h"
 #include "MidiSndio.h"
 #include "MidiWinMM.h"
 
@@ -137,6 +144,8 @@ SetupDialog::SetupDialog(ConfigTab tab_to_open) :
 	m_vstEmbedMethod(ConfigManager::inst()->vstEmbedMethod()),
 	m_vstAlwaysOnTop(ConfigManager::inst()->value(
 			"ui", "vstalwaysontop").toInt()),
+	m_vstSharedProcess(ConfigManager::inst()->value(
+			"ui", "vstsharedprocess").toInt()),
 	m_disableAutoQuit(ConfigManager::inst()->value(
 			"ui", "disableautoquit", "1").toInt()),
 	m_NaNHandler(ConfigManager::inst()->value(
@@ -446,14 +455,113 @@ SetupDialog::SetupDialog(ConfigTab tab_to_open) :
 	m_vstAlwaysOnTopCheckBox = addCheckBox(tr("Keep plugin windows on top when not embedded"), pluginsBox, pluginsLayout,
 		m_vstAlwaysOnTop, SLOT(toggleVSTAlwaysOnTop(bool)), false);
 
+	addCheckBox(tr("Run VST plugins of the same kind in one process"), pluginsBox, pluginsLayout,
+		m_vstSharedProcess, SLOT(toggleVSTSharedProcess(bool)), false);
+
 	addCheckBox(tr("Keep effects running even without input"), pluginsBox, pluginsLayout,
 		m_disableAutoQuit, SLOT(toggleDisableAutoQuit(bool)), false);
 
 
+	// Processing threads group
+	auto threadsBox = new QGroupBox{tr("Processing threads"), performance_w};
+	auto threadsLayout = new QFormLayout{threadsBox};
+
+	m_workerThreadsSpinBox = new QSpinBox{threadsBox};
+	m_workerThreadsSpinBox->setRange(0, 256);
+	m_workerThreadsSpinBox->setSpecialValueText(tr("Automatic"));
+	m_workerThreadsSpinBox->setValue(ConfigManager::inst()->value("audioengine", "workerthreads").toInt());
+	m_workerThreadsSpinBox->setToolTip(tr("Threads processing audio, including the one of the audio interface. "
+		"By default, one for each core the threads are kept on."));
+	threadsLayout->addRow(tr("Audio threads:"), m_workerThreadsSpinBox);
+
+	m_renderWorkerThreadsSpinBox = new QSpinBox{threadsBox};
+	m_renderWorkerThreadsSpinBox->setRange(0, 256);
+	m_renderWorkerThreadsSpinBox->setValue(
+		ConfigManager::inst()->value("audioengine", "renderworkerthreads").toInt());
+	m_renderWorkerThreadsSpinBox->setToolTip(tr("Additional threads which only help when exporting, "
+		"e.g. on the cores left out above."));
+	threadsLayout->addRow(tr("Additional export threads:"), m_renderWorkerThreadsSpinBox);
+
+	m_workerCpusLineEdit = new QLineEdit{ConfigManager::inst()->value("audioengine", "workercpus"), threadsBox};
+	m_workerCpusLineEdit->setPlaceholderText(tr("All cores"));
+	m_workerCpusLineEdit->setToolTip(tr("Cores to keep the audio threads on, e.g. \"2-5,8\" for cores "
+		"isolated from the rest of the system."));
+	threadsLayout->addRow(tr("Cores:"), m_workerCpusLineEdit);
+
+	m_efficiencyCoresCheckBox = new QCheckBox{tr("Use efficiency cores of hybrid processors"), threadsBox};
+	m_efficiencyCoresCheckBox->setChecked(ConfigManager::inst()->value("audioengine", "efficiencycores").toInt());
+	m_efficiencyCoresCheckBox->setToolTip(tr("Unless cores are given, audio threads are only kept on the "
+		"performance cores, as the slower ones may not finish their part of a buffer in time."));
+	threadsLayout->addRow(m_efficiencyCoresCheckBox);
+
+	m_numaNodesCheckBox = new QCheckBox{tr("Keep tracks on one NUMA node"), threadsBox};
+	m_numaNodesCheckBox->setChecked(ConfigManager::inst()->value("audioengine", "numanodes", "1").toInt());
+	m_numaNodesCheckBox->setToolTip(tr("On computers with several processor sockets, the audio threads are "
+		"kept on the cores of each socket and every track is processed by the threads of one socket, "
+		"so its audio stays in the memory of that socket."));
+	threadsLayout->addRow(m_numaNodesCheckBox);
+
+	m_realtimePolicyComboBox = new QComboBox{threadsBox};
+	m_realtimePolicyComboBox->addItem(tr("First in, first out (SCHED_FIFO)"), "fifo");
+	m_realtimePolicyComboBox->addItem(tr("Round robin (SCHED_RR)"), "rr");
+	m_realtimePolicyComboBox->setCurrentIndex(std::max(0, m_realtimePolicyComboBox->findData(
+		ConfigManager::inst()->value("audioengine", "rtpolicy"))));
+	m_realtimePolicyComboBox->setToolTip(tr("Scheduling of audio threads with real-time priority, "
+		"which audio interfaces like JACK and PipeWire give them."));
+	threadsLayout->addRow(tr("Real-time scheduling:"), m_realtimePolicyComboBox);
+
+	m_realtimePrioritySpinBox = new QSpinBox{threadsBox};
+	m_realtimePrioritySpinBox->setRange(0, 99);
+	m_realtimePrioritySpinBox->setSpecialValueText(tr("Automatic"));
+	m_realtimePrioritySpinBox->setValue(ConfigManager::inst()->value("audioengine", "rtpriority").toInt());
+	threadsLayout->addRow(tr("Real-time priority:"), m_realtimePrioritySpinBox);
+
+	m_spinTimeSpinBox = new QSpinBox{threadsBox};
+	m_spinTimeSpinBox->setRange(0, 2000);
+	m_spinTimeSpinBox->setSuffix(tr(" µs"));
+	m_spinTimeSpinBox->setValue(ConfigManager::inst()->value("audioengine", "workerspintime", "50").toInt());
+	m_spinTimeSpinBox->setToolTip(tr("How long audio threads keep looking for work before going to sleep. "
+		"Longer times save waking them up at small buffer sizes, at the cost of CPU time."));
+	threadsLayout->addRow(tr("Wait actively for:"), m_spinTimeSpinBox);
+
+	m_lockMemoryCheckBox = new QCheckBox{tr("Lock audio memory into RAM"), threadsBox};
+	m_lockMemoryCheckBox->setChecked(ConfigManager::inst()->value("audioengine", "lockmemory").toInt());
+	m_lockMemoryCheckBox->setToolTip(tr("Keeps the memory used while processing audio from being paged out "
+		"while idle, which delays the first notes played afterwards. Requires a sufficient limit of "
+		"locked memory, e.g. by being in the audio group."));
+	threadsLayout->addRow(m_lockMemoryCheckBox);
+
+	m_hugePagesComboBox = new QComboBox{threadsBox};
+	m_hugePagesComboBox->addItem(tr("Off"));
+	m_hugePagesComboBox->addItem(tr("Transparent"));
+	m_hugePagesComboBox->addItem(tr("Reserved, or else transparent"));
+	m_hugePagesComboBox->setCurrentIndex(
+		std::clamp(ConfigManager::inst()->value("audioengine", "hugepages").toInt(), 0, 2));
+	m_hugePagesComboBox->setToolTip(tr("Backs wavetables and large samples with huge pages, "
+		"which saves address translations when reading them."));
+	threadsLayout->addRow(tr("Huge pages:"), m_hugePagesComboBox);
+
+	connect(m_workerThreadsSpinBox, qOverload<int>(&QSpinBox::valueChanged), this, &SetupDialog::showRestartWarning);
+	connect(m_renderWorkerThreadsSpinBox, qOverload<int>(&QSpinBox::valueChanged),
+		this, &SetupDialog::showRestartWarning);
+	connect(m_workerCpusLineEdit, &QLineEdit::textEdited, this, &SetupDialog::showRestartWarning);
+	connect(m_efficiencyCoresCheckBox, &QCheckBox::toggled, this, &SetupDialog::showRestartWarning);
+	connect(m_numaNodesCheckBox, &QCheckBox::toggled, this, &SetupDialog::showRestartWarning);
+	connect(m_realtimePolicyComboBox, qOverload<int>(&QComboBox::currentIndexChanged),
+		this, &SetupDialog::showRestartWarning);
+	connect(m_realtimePrioritySpinBox, qOverload<int>(&QSpinBox::valueChanged),
+		this, &SetupDialog::showRestartWarning);
+	connect(m_spinTimeSpinBox, qOverload<int>(&QSpinBox::valueChanged), this, &SetupDialog::showRestartWarning);
+	connect(m_lockMemoryCheckBox, &QCheckBox::toggled, this, &SetupDialog::showRestartWarning);
+	connect(m_hugePagesComboBox, qOverload<int>(&QComboBox::currentIndexChanged),
+		this, &SetupDialog::showRestartWarning);
+
+
 	// Performance layout ordering.
 	performance_layout->addWidget(autoSaveBox);
 	performance_layout->addWidget(uiFxBox);
 	performance_layout->addWidget(pluginsBox);
+	performance_layout->addWidget(threadsBox);
 	performance_layout->addStretch();
 
 
@@ -490,6 +598,11 @@ SetupDialog::SetupDialog(ConfigTab tab_to_open) :
 			new AudioAlsaSetupWidget(as_w);
 #endif
 
+#ifdef LMMS_HAVE_PIPEWIRE
+	m_audioIfaceSetupWidgets[AudioPipeWire::name()] =
+			new AudioPipeWire::setupWidget(as_w);
+#endif
+
 #ifdef LMMS_HAVE_PULSEAUDIO
 	m_audioIfaceSetupWidgets[AudioPulseAudio::name()] =
 			new AudioPulseAudio::setupWidget(as_w);
@@ -634,12 +747,74 @@ SetupDialog::SetupDialog(ConfigTab tab_to_open) :
 
 	setBufferSize(m_bufferSizeSlider->value());
 
+	auto recordingBufferSizeLayout = new QHBoxLayout{};
+	m_recordingBufferSizeSpinBox = new QSpinBox{bufferSizeBox};
+	m_recordingBufferSizeSpinBox->setRange(0, MAXIMUM_BUFFER_SIZE);
+	m_recordingBufferSizeSpinBox->setSingleStep(BUFFERSIZE_RESOLUTION);
+	m_recordingBufferSizeSpinBox->setSpecialValueText(tr("Same as above"));
+	m_recordingBufferSizeSpinBox->setSuffix(tr(" frames"));
+	m_recordingBufferSizeSpinBox->setValue(
+		ConfigManager::inst()->value("audioengine", "recordingframesperperiod").toInt());
+	m_recordingBufferSizeSpinBox->setToolTip(tr("Smaller buffer to switch to while recording, so what is "
+		"recorded is heard earlier, while playback uses the larger one above. Switching needs no restart."));
+	recordingBufferSizeLayout->addWidget(new QLabel{tr("While recording:"), bufferSizeBox});
+	recordingBufferSizeLayout->addWidget(m_recordingBufferSizeSpinBox, 1);
+	bufferSizeLayout->addLayout(recordingBufferSizeLayout);
+
+	// Sample storage group
+	auto sampleStorageBox = new QGroupBox{tr("Sample storage"), audio_w};
+	auto sampleStorageLayout = new QVBoxLayout{sampleStorageBox};
+
+	m_sampleStorageComboBox = new QComboBox{sampleStorageBox};
+	m_sampleStorageComboBox->addItem(tr("32-bit float"), "float32");
+	m_sampleStorageComboBox->addItem(tr("24-bit integer"), "int24");
+	m_sampleStorageComboBox->addItem(tr("16-bit float"), "float16");
+	m_sampleStorageComboBox->addItem(tr("16-bit integer"), "int16");
+	m_sampleStorageComboBox->setCurrentIndex(std::max(0, m_sampleStorageComboBox->findData(
+		ConfigManager::inst()->value("audioengine", "samplestorage"))));
+	m_sampleStorageComboBox->setToolTip(tr("Format audio files are kept in memory in. The smaller formats "
+		"need less memory, but may lose precision. They apply to samples loaded from now on."));
+	sampleStorageLayout->addWidget(m_sampleStorageComboBox);
+
+	m_streamSamplesCheckBox = new QCheckBox{tr("Stream samples from disk in AudioFileProcessor"), sampleStorageBox};
+	m_streamSamplesCheckBox->setChecked(ConfigManager::inst()->value("audioengine", "streamsamples").toInt());
+	m_streamSamplesCheckBox->setToolTip(tr("Only keep the beginning of samples in memory and read the rest "
+		"from disk while playing them, so large sample libraries don't need to fit into memory."));
+	sampleStorageLayout->addWidget(m_streamSamplesCheckBox);
+
+	m_resampleOnLoadCheckBox = new QCheckBox{tr("Convert samples to the output sample rate when loading"),
+		sampleStorageBox};
+	m_resampleOnLoadCheckBox->setChecked(ConfigManager::inst()->value("audioengine", "resampleonload").toInt());
+	m_resampleOnLoadCheckBox->setToolTip(tr("Resample samples in high quality once when loading them instead "
+		"of every time they are played, as long as they are played at their original pitch. Large and "
+		"streamed samples are still resampled while playing."));
+	sampleStorageLayout->addWidget(m_resampleOnLoadCheckBox);
+
+	// Voices group
+	auto voicesBox = new QGroupBox{tr("Voices"), audio_w};
+	auto voicesLayout = new QVBoxLayout{voicesBox};
+
+	m_voiceStealingComboBox = new QComboBox{voicesBox};
+	m_voiceStealingComboBox->addItem(tr("Play all notes to the end"),
+		static_cast<int>(NotePlayHandleManager::VoiceStealing::None));
+	m_voiceStealingComboBox->addItem(tr("Release the oldest notes"),
+		static_cast<int>(NotePlayHandleManager::VoiceStealing::Oldest));
+	m_voiceStealingComboBox->addItem(tr("Release the quietest notes"),
+		static_cast<int>(NotePlayHandleManager::VoiceStealing::Quietest));
+	m_voiceStealingComboBox->setCurrentIndex(std::max(0, m_voiceStealingComboBox->findData(
+		ConfigManager::inst()->value("audioengine", "voicestealing").toInt())));
+	m_voiceStealingComboBox->setToolTip(tr("What happens when more notes play at the same time than "
+		"the voices reserved for the project."));
+	voicesLayout->addWidget(m_voiceStealingComboBox);
+
 
 	// Audio layout ordering.
 	audio_layout->addWidget(audioInterfaceBox);
 	audio_layout->addWidget(as_w);
 	audio_layout->addWidget(sampleRateBox);
 	audio_layout->addWidget(bufferSizeBox);
+	audio_layout->addWidget(sampleStorageBox);
+	audio_layout->addWidget(voicesBox);
 	audio_layout->addStretch();
 
 
@@ -677,6 +852,11 @@ SetupDialog::SetupDialog(ConfigTab tab_to_open) :
 			MidiSetupWidget::create<MidiJack>(ms_w);
 #endif
 
+#ifdef LMMS_HAVE_PIPEWIRE
+	m_midiIfaceSetupWidgets[MidiPipeWire::name()] =
+			MidiSetupWidget::create<MidiPipeWire>(ms_w);
+#endif
+
 #ifdef LMMS_HAVE_OSS
 	m_midiIfaceSetupWidgets[MidiOss::name()] =
 			MidiSetupWidget::create<MidiOss>(ms_w);
@@ -997,8 +1177,30 @@ void SetupDialog::accept()
 					m_vstEmbedComboBox->currentData().toString());
 	ConfigManager::inst()->setValue("ui", "vstalwaysontop",
 					QString::number(m_vstAlwaysOnTop));
+	ConfigManager::inst()->setValue("ui", "vstsharedprocess",
+					QString::number(m_vstSharedProcess));
 	ConfigManager::inst()->setValue("ui", "disableautoquit",
 					QString::number(m_disableAutoQuit));
+	ConfigManager::inst()->setValue("audioengine", "workerthreads",
+					QString::number(m_workerThreadsSpinBox->value()));
+	ConfigManager::inst()->setValue("audioengine", "renderworkerthreads",
+					QString::number(m_renderWorkerThreadsSpinBox->value()));
+	ConfigManager::inst()->setValue("audioengine", "workercpus",
+					m_workerCpusLineEdit->text().trimmed());
+	ConfigManager::inst()->setValue("audioengine", "efficiencycores",
+					QString::number(m_efficiencyCoresCheckBox->isChecked()));
+	ConfigManager::inst()->setValue("audioengine", "numanodes",
+					QString::number(m_numaNodesCheckBox->isChecked()));
+	ConfigManager::inst()->setValue("audioengine", "rtpolicy",
+					m_realtimePolicyComboBox->currentData().toString());
+	ConfigManager::inst()->setValue("audioengine", "rtpriority",
+					QString::number(m_realtimePrioritySpinBox->value()));
+	ConfigManager::inst()->setValue("audioengine", "workerspintime",
+					QString::number(m_spinTimeSpinBox->value()));
+	ConfigManager::inst()->setValue("audioengine", "lockmemory",
+					QString::number(m_lockMemoryCheckBox->isChecked()));
+	ConfigManager::inst()->setValue("audioengine", "hugepages",
+					QString::number(m_hugePagesComboBox->currentIndex()));
 	ConfigManager::inst()->setValue("audioengine", "audiodev",
 					m_audioIfaceNames[m_audioInterfaces->currentText()]);
 	ConfigManager::inst()->setValue("app", "nanhandler",
@@ -1007,6 +1209,20 @@ void SetupDialog::accept()
 					QString::number(m_sampleRate));
 	ConfigManager::inst()->setValue("audioengine", "framesperaudiobuffer",
 					QString::number(m_bufferSize));
+	ConfigManager::inst()->setValue("audioengine", "recordingframesperperiod",
+					QString::number(m_recordingBufferSizeSpinBox->value()));
+	Engine::audioEngine()->setRecordingFramesPerPeriod(
+		static_cast<fpp_t>(m_recordingBufferSizeSpinBox->value()));
+	ConfigManager::inst()->setValue("audioengine", "samplestorage",
+					m_sampleStorageComboBox->currentData().toString());
+	ConfigManager::inst()->setValue("audioengine", "streamsamples",
+					QString::number(m_streamSamplesCheckBox->isChecked()));
+	ConfigManager::inst()->setValue("audioengine", "resampleonload",
+					QString::number(m_resampleOnLoadCheckBox->isChecked()));
+	ConfigManager::inst()->setValue("audioengine", "voicestealing",
+					m_voiceStealingComboBox->currentData().toString());
+	NotePlayHandleManager::setVoiceStealing(static_cast<NotePlayHandleManager::VoiceStealing>(
+		m_voiceStealingComboBox->currentData().toInt()));
 	ConfigManager::inst()->setValue("audioengine", "mididev",
 					m_midiIfaceNames[m_midiInterfaces->currentText()]);
 	ConfigManager::inst()->setValue("midi", "midiautoassign",
@@ -1200,6 +1416,12 @@ void SetupDialog::toggleVSTAlwaysOnTop(bool enabled)
 }
 
 
+void SetupDialog::toggleVSTSharedProcess(bool enabled)
+{
+	m_vstSharedProcess = enabled;
+}
+
+
 void SetupDialog::toggleDisableAutoQuit(bool enabled)
 {
 	m_disableAutoQuit = enabled;
@@ -31,16 +31,21 @@
 #include <QMdiArea>
 #include <QMdiSubWindow>
 #include <QMenu>
+#include <QProgressDialog>
 #include <QSpacerItem>
 #include <QVBoxLayout>
 
+#include <chrono>
+
 #include "AudioEngine.h"
 #include "ConfigManager.h"
+#include "CpuUsageLabel.h"
 #include "Engine.h"
 #include "FadeButton.h"
 #include "GuiApplication.h"
 #include "Instrument.h"
 #include "InstrumentTrackWindow.h"
+#include "InstrumentView.h"
 #include "Knob.h"
 #include "MainWindow.h"
 #include "MidiClient.h"
@@ -49,12 +54,21 @@
 #include "Mixer.h"
 #include "MixerChannelLcdSpinBox.h"
 #include "MixerView.h"
+#include "TrackFreezer.h"
 #include "TrackLabelButton.h"
 
 
 namespace lmms::gui
 {
 
+namespace
+{
+
+//! Time a window stays closed before it's destroyed, so switching between a few tracks stays instant
+constexpr auto WindowReleaseDelay = std::chrono::minutes{2};
+
+} // namespace
+
 
 InstrumentTrackView::InstrumentTrackView( InstrumentTrack * _it, TrackContainerView* tcv ) :
 	TrackView( _it, tcv ),
@@ -64,6 +78,12 @@ InstrumentTrackView::InstrumentTrackView( InstrumentTrack * _it, TrackContainerV
 	setAcceptDrops( true );
 	setFixedHeight( 32 );
 
+	// the windows of tracks, with the views of their instrument, effects etc.,
+	// are only created once opened and don't stay around for long after being closed
+	m_windowReleaseTimer.setSingleShot(true);
+	m_windowReleaseTimer.setInterval(WindowReleaseDelay);
+	connect(&m_windowReleaseTimer, &QTimer::timeout, this, &InstrumentTrackView::releaseInstrumentTrackWindow);
+
 	m_tlb = new TrackLabelButton( this, getTrackSettingsWidget() );
 	m_tlb->setCheckable( true );
 	m_tlb->setIcon(determinePixmap(_it));
@@ -142,12 +162,19 @@ InstrumentTrackView::InstrumentTrackView( InstrumentTrack * _it, TrackContainerV
 	m_activityIndicator->setFixedSize(8, 28);
 	m_activityIndicator->show();
 
+	// the voices and the effects of the track
+	auto busHandle = _it->audioBusHandle();
+	auto cpuUsage = new CpuUsageLabel([busHandle] {
+		return busHandle->playHandlesTime().total() + busHandle->processingTime().total();
+	}, getTrackSettingsWidget());
+
 	auto masterLayout = new QVBoxLayout(getTrackSettingsWidget());
 	masterLayout->setContentsMargins(0, 1, 0, 0);
 	auto layout = new QHBoxLayout();
 	layout->setContentsMargins(0, 0, 0, 0);
 	layout->setSpacing(0);
 	layout->addWidget(m_tlb);
+	layout->addWidget(cpuUsage);
 	layout->addWidget(m_mixerChannelNumber);
 	layout->addWidget(m_activityIndicator);
 	layout->addWidget(m_volumeKnob);
@@ -239,6 +266,29 @@ void InstrumentTrackView::createMixerLine()
 
 
 
+void InstrumentTrackView::toggleFreeze()
+{
+	if (model()->isFrozen())
+	{
+		model()->unfreeze();
+		return;
+	}
+
+	auto freezer = new TrackFreezer(model());
+	auto progress = new QProgressDialog(tr("Freezing %1...").arg(model()->name()), tr("Cancel"), 0, 100, this);
+	progress->setWindowModality(Qt::ApplicationModal);
+	progress->setMinimumDuration(0);
+
+	connect(freezer, &TrackFreezer::progressChanged, progress, &QProgressDialog::setValue);
+	connect(progress, &QProgressDialog::canceled, freezer, &TrackFreezer::abortProcessing);
+	connect(freezer, &TrackFreezer::done, progress, &QObject::deleteLater);
+	connect(freezer, &TrackFreezer::done, freezer, &QObject::deleteLater);
+	freezer->startProcessing();
+}
+
+
+
+
 /*! \brief Assign a specific mixer Channel for this track */
 void InstrumentTrackView::assignMixerLine(int channelIndex)
 {
@@ -254,11 +304,34 @@ InstrumentTrackWindow * InstrumentTrackView::getInstrumentTrackWindow()
 	if (!m_window)
 	{
 		m_window = new InstrumentTrackWindow(this);
+		// where the window was before it got released
+		if (m_lastPos.x() >= 0 && m_window->parentWidget()) { m_window->parentWidget()->move(m_lastPos); }
+		// e.g. for dropping a preset on the track, without opening the window
+		if (!m_tlb->isChecked()) { m_windowReleaseTimer.start(); }
 	}
 
 	return m_window;
 }
 
+
+
+
+void InstrumentTrackView::releaseInstrumentTrackWindow()
+{
+	if (!m_window || m_tlb->isChecked()) { return; }
+
+	// some plugins keep windows of their own open, which their view would close
+	if (const auto view = dynamic_cast<InstrumentView*>(m_window->m_instrumentView); view && !view->isDisposable())
+	{
+		m_windowReleaseTimer.start();
+		return;
+	}
+
+	if (m_window->parentWidget()) { m_lastPos = m_window->parentWidget()->pos(); }
+	delete m_window;
+	m_window = nullptr;
+}
+
 void InstrumentTrackView::handleConfigChange(QString cls, QString attr, QString value)
 {
 	// When one instrument track window mode is turned on,
@@ -307,6 +380,16 @@ void InstrumentTrackView::toggleInstrumentWindow( bool _on )
 		}
 	}
 
+	if (_on)
+	{
+		m_windowReleaseTimer.stop();
+	}
+	else
+	{
+		if (!m_window) { return; }
+		m_windowReleaseTimer.start();
+	}
+
 	getInstrumentTrackWindow()->toggleVisibility( _on );
 }
 
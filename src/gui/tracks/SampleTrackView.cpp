@@ -31,6 +31,7 @@
 #include <QVBoxLayout>
 
 #include "ConfigManager.h"
+#include "CpuUsageLabel.h"
 #include "embed.h"
 #include "Engine.h"
 #include "FadeButton.h"
@@ -86,12 +87,19 @@ SampleTrackView::SampleTrackView( SampleTrack * _t, TrackContainerView* tcv ) :
 	m_activityIndicator->setFixedSize(8, 28);
 	m_activityIndicator->show();
 
+	// the voices and the effects of the track
+	auto busHandle = _t->audioBusHandle();
+	auto cpuUsage = new CpuUsageLabel([busHandle] {
+		return busHandle->playHandlesTime().total() + busHandle->processingTime().total();
+	}, getTrackSettingsWidget());
+
 	auto masterLayout = new QVBoxLayout(getTrackSettingsWidget());
 	masterLayout->setContentsMargins(0, 1, 0, 0);
 	auto layout = new QHBoxLayout();
 	layout->setContentsMargins(0, 0, 0, 0);
 	layout->setSpacing(0);
 	layout->addWidget(m_tlb);
+	layout->addWidget(cpuUsage);
 	layout->addWidget(m_mixerChannelNumber);
 	layout->addWidget(m_activityIndicator);
 	layout->addWidget(m_volumeKnob);
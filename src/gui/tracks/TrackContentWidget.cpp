@@ -214,7 +214,8 @@ void TrackContentWidget::update()
 	for (const auto& clipView : m_clipViews)
 	{
 		clipView->setFixedHeight(height() - 1);
-		clipView->update();
+		// hidden views are updated when they are shown again
+		if (clipView->isVisible()) { clipView->update(); }
 	}
 	QWidget::update();
 }
@@ -265,13 +266,15 @@ void TrackContentWidget::changePosition( const TimePos & newPos )
 	const int end = endPosition( pos );
 	const float ppb = m_trackView->trackContainerView()->pixelsPerBar();
 
+	// Only the clips in the visible range are shown. Hidden widgets are
+	// skipped when laying out, painting and looking for the widget under
+	// the mouse, so songs with thousands of clips keep scrolling smoothly.
+	// The widths of the views are kept up to date by the views themselves.
 	setUpdatesEnabled( false );
 	for (const auto& clipView : m_clipViews)
 	{
 		Clip* clip = clipView->getClip();
 
-		clip->changeLength( clip->length() );
-
 		const int ts = clip->startPosition();
 		const int te = clip->endPosition()-3;
 		if( ( ts >= begin && ts <= end ) ||
@@ -281,13 +284,19 @@ void TrackContentWidget::changePosition( const TimePos & newPos )
 			clipView->move(static_cast<int>((ts - begin) * ppb / TimePos::ticksPerBar()), clipView->y());
 			if (!clipView->isVisible())
 			{
+				clipView->update();
 				clipView->show();
 			}
 		}
-		else
+		else if (clipView == QWidget::mouseGrabber())
 		{
+			// keep the clip that is being dragged, it would lose the mouse
 			clipView->move(-clipView->width() - 10, clipView->y());
 		}
+		else if (clipView->isVisible())
+		{
+			clipView->hide();
+		}
 	}
 	setUpdatesEnabled( true );
 
@@ -355,12 +364,11 @@ bool TrackContentWidget::canPasteSelection( TimePos clipPos, const QDropEvent* d
 // Overloaded method to make it possible to call this method without a Drag&Drop event
 bool TrackContentWidget::canPasteSelection( TimePos clipPos, const QMimeData* md , bool allowSameBar )
 {
-	// For decodeKey() and decodeValue()
+	// For decodeKey() and decodeDataFile()
 	using namespace Clipboard;
 
 	Track * t = getTrack();
 	QString type = decodeKey( md );
-	QString value = decodeValue( md );
 
 	// We can only paste into tracks of the same type
 	if (type != ("clip_" + QString::number(static_cast<int>(t->type()))))
@@ -368,8 +376,8 @@ bool TrackContentWidget::canPasteSelection( TimePos clipPos, const QMimeData* md
 		return false;
 	}
 
-	// value contains XML needed to reconstruct Clips and place them
-	DataFile dataFile( value.toUtf8() );
+	// The DataFile has what's needed to reconstruct Clips and place them
+	DataFile dataFile = decodeDataFile(md, MimeType::StringPair);
 
 	// Extract the metadata and which Clip was grabbed
 	QDomElement metadata = dataFile.content().firstChildElement( "copyMetadata" );
@@ -452,7 +460,7 @@ bool TrackContentWidget::pasteSelection( TimePos clipPos, QDropEvent * de )
 // Overloaded method so we can call it without a Drag&Drop event
 bool TrackContentWidget::pasteSelection( TimePos clipPos, const QMimeData * md, bool skipSafetyCheck )
 {
-	// For decodeKey() and decodeValue()
+	// For decodeDataFile()
 	using namespace Clipboard;
 
 	// When canPasteSelection was already called before, skipSafetyCheck will skip this
@@ -461,13 +469,10 @@ bool TrackContentWidget::pasteSelection( TimePos clipPos, const QMimeData * md,
 		return false;
 	}
 
-	QString type = decodeKey( md );
-	QString value = decodeValue( md );
-
 	getTrack()->addJournalCheckPoint();
 
-	// value contains XML needed to reconstruct Clips and place them
-	DataFile dataFile( value.toUtf8() );
+	// The DataFile has what's needed to reconstruct Clips and place them
+	DataFile dataFile = decodeDataFile(md, MimeType::StringPair);
 
 	// Extract the clip data
 	QDomElement clipParent = dataFile.content().firstChildElement("clips");
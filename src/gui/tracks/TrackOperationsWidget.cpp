@@ -314,6 +314,13 @@ void TrackOperationsWidget::updateMenu()
 	{
 		toMenu->addSeparator();
 		toMenu->addMenu(trackView->midiMenu());
+
+		// frozen audio follows the song, tracks of the pattern editor can't be frozen
+		if (trackView->model()->trackContainer() == Engine::getSong())
+		{
+			toMenu->addAction(trackView->model()->isFrozen() ? tr("Unfreeze track") : tr("Freeze track"),
+				trackView, SLOT(toggleFreeze()));
+		}
 	}
 	if( dynamic_cast<AutomationTrackView *>( m_trackView ) )
 	{
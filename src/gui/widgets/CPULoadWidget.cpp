@@ -25,12 +25,18 @@
 
 
 #include <algorithm>
+#include <QContextMenuEvent>
+#include <QFileInfo>
+#include <QMenu>
+#include <QMessageBox>
 #include <QPainter>
 
 #include "AudioEngine.h"
 #include "CPULoadWidget.h"
 #include "embed.h"
 #include "Engine.h"
+#include "FileDialog.h"
+#include "XRunRecorder.h"
 
 
 namespace lmms::gui
@@ -88,24 +94,56 @@ void CPULoadWidget::paintEvent( QPaintEvent *  )
 
 
 
+void CPULoadWidget::contextMenuEvent( QContextMenuEvent * _ev )
+{
+	XRunRecorder* recorder = Engine::audioEngine()->xrunRecorder();
+	if (!recorder)
+	{
+		QWidget::contextMenuEvent(_ev);
+		return;
+	}
+
+	QMenu menu(this);
+	menu.addAction(tr("Export dropout report..."), this, [this, recorder] {
+		QString fileName = FileDialog::getSaveFileName(this, tr("Export dropout report"), "",
+			tr("JSON files (*.json)"));
+		if (fileName.isEmpty()) { return; }
+		if (QFileInfo(fileName).suffix().isEmpty()) { fileName += ".json"; }
+		if (!recorder->exportTo(fileName))
+		{
+			QMessageBox::critical(this, tr("Export failed"), tr("Unable to open selected file for writing."));
+		}
+	});
+	menu.addAction(tr("Clear dropouts"), this, [recorder] { recorder->clear(); });
+	menu.exec(_ev->globalPos());
+}
+
+
+
+
 void CPULoadWidget::updateCpuLoad()
 {
 	// Additional display smoothing for the main load-value. Stronger averaging
 	// cannot be used directly in the profiler: cpuLoad() must react fast enough
 	// to be useful as overload indicator in AudioEngine::criticalXRuns().
 	const int new_load = (m_currentLoad + Engine::audioEngine()->cpuLoad()) / 2;
+	const XRunRecorder* recorder = Engine::audioEngine()->xrunRecorder();
+	const auto xruns = recorder ? recorder->total() : 0;
 
-	if (new_load != m_currentLoad)
+	if (new_load != m_currentLoad || xruns != m_xruns)
 	{
 		auto engine = Engine::audioEngine();
-		setToolTip(
-			tr("DSP total: %1%").arg(new_load) + "\n"
+		auto toolTip = tr("DSP total: %1%").arg(new_load) + "\n"
 			+ tr(" - Notes and setup: %1%").arg(engine->detailLoad(AudioEngineProfiler::DetailType::NoteSetup)) + "\n"
-			+ tr(" - Instruments: %1%").arg(engine->detailLoad(AudioEngineProfiler::DetailType::Instruments)) + "\n"
-			+ tr(" - Effects: %1%").arg(engine->detailLoad(AudioEngineProfiler::DetailType::Effects)) + "\n"
-			+ tr(" - Mixing: %1%").arg(engine->detailLoad(AudioEngineProfiler::DetailType::Mixing))
-		);
+			+ tr(" - Instruments and effects: %1%").arg(engine->detailLoad(AudioEngineProfiler::DetailType::Instruments)) + "\n"
+			+ tr(" - Mixing: %1%").arg(engine->detailLoad(AudioEngineProfiler::DetailType::Mixing));
+		if (recorder)
+		{
+			toolTip += "\n" + tr("Periods which missed their deadline: %1").arg(xruns);
+		}
+		setToolTip(toolTip);
 		m_currentLoad = new_load;
+		m_xruns = xruns;
 		m_changed = true;
 		update();
 	}
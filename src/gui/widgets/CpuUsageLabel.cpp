@@ -0,0 +1,116 @@
+/*
+ * CpuUsageLabel.cpp - shows the processing time a part of the project takes
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "CpuUsageLabel.h"
+
+#include "ConfigManager.h"
+#include "FontHelper.h"
+
+namespace lmms::gui {
+
+CpuUsageLabel::CpuUsageLabel(std::function<std::chrono::nanoseconds()> total, QWidget* parent) :
+	QLabel(parent),
+	m_total(std::move(total))
+{
+	setFont(adjustedToPixelSize(font(), SMALL_FONT_SIZE));
+	setAlignment(Qt::AlignCenter);
+	setFixedWidth(32);
+	setText("-");
+	setToolTip(tr("CPU usage, as a share of one core"));
+
+	connect(&m_updateTimer, &QTimer::timeout, this, &CpuUsageLabel::updateUsage);
+	connect(ConfigManager::inst(), &ConfigManager::valueChanged, this, &CpuUsageLabel::handleConfigChange);
+
+	setShown(isShown());
+}
+
+
+
+
+CpuUsageLabel::~CpuUsageLabel()
+{
+	setShown(false);
+}
+
+
+
+
+bool CpuUsageLabel::isShown()
+{
+	return ConfigManager::inst()->value("ui", "showcpuusage").toInt();
+}
+
+
+
+
+void CpuUsageLabel::updateUsage()
+{
+	const auto total = m_total();
+	const auto now = CpuTime::Clock::now();
+	const auto elapsed = std::chrono::duration<float>(now - m_lastUpdate).count();
+	if (elapsed <= 0.f) { return; }
+
+	// time spent by several threads can exceed the time passed
+	const auto usage = 100.f * std::chrono::duration<float>(total - m_lastTotal).count() / elapsed;
+	m_usage = usage * 0.5f + m_usage * 0.5f;
+	m_lastTotal = total;
+	m_lastUpdate = now;
+
+	setText(QString("%1%").arg(static_cast<int>(m_usage + 0.5f)));
+}
+
+
+
+
+void CpuUsageLabel::handleConfigChange(QString cls, QString attr, QString value)
+{
+	if (cls == "ui" && attr == "showcpuusage")
+	{
+		setShown(value.toInt());
+	}
+}
+
+
+
+
+void CpuUsageLabel::setShown(bool shown)
+{
+	if (shown == m_shown) { return; }
+	m_shown = shown;
+
+	if (shown)
+	{
+		CpuTime::addObserver();
+		m_lastTotal = m_total();
+		m_lastUpdate = CpuTime::Clock::now();
+		m_usage = 0.f;
+		m_updateTimer.start(500);
+	}
+	else
+	{
+		m_updateTimer.stop();
+		CpuTime::removeObserver();
+	}
+	setVisible(shown);
+}
+
+} // namespace lmms::gui
@@ -36,6 +36,7 @@
 #include "KeyboardShortcuts.h"
 #include "LocaleHelper.h"
 #include "MainWindow.h"
+#include "ModelChangeNotifier.h"
 #include "ProjectJournal.h"
 #include "SimpleTextFloat.h"
 #include "StringPairDrag.h"
@@ -420,7 +421,7 @@ void FloatModelEditorBase::friendlyUpdate()
 {
 	if (model() && (model()->controllerConnection() == nullptr ||
 		model()->controllerConnection()->getController()->frequentUpdates() == false ||
-				Controller::runningFrames() % (256*4) == 0))
+				Controller::runningFrames() % (256*4) == 0) && valueChangeVisible())
 	{
 		update();
 	}
@@ -448,8 +449,7 @@ void FloatModelEditorBase::doConnections()
 {
 	if (model() != nullptr)
 	{
-		QObject::connect(model(), SIGNAL(dataChanged()),
-					this, SLOT(friendlyUpdate()));
+		ModelChangeNotifier::connectDataChanged(model(), this, [this] { friendlyUpdate(); });
 
 		QObject::connect(model(), SIGNAL(propertiesChanged()),
 						this, SLOT(update()));
@@ -25,6 +25,7 @@
 #include "Knob.h"
 
 #include <QPainter>
+#include <QPixmapCache>
 #include <numbers>
 
 #include "DeprecationHelper.h"
@@ -358,13 +359,30 @@ QLineF Knob::calculateLine( const QPointF & _mid, float _radius, float _innerRad
 
 
 
-bool Knob::updateAngle()
+int Knob::currentAngle() const
 {
-	int angle = 0;
 	if( model() && model()->maxValue() != model()->minValue() )
 	{
-		angle = angleFromValue( model()->inverseScaledValue( model()->value() ), model()->minValue(), model()->maxValue(), m_totalAngle );
+		return angleFromValue( model()->inverseScaledValue( model()->value() ), model()->minValue(), model()->maxValue(), m_totalAngle );
 	}
+	return 0;
+}
+
+
+
+
+bool Knob::valueChangeVisible() const
+{
+	// the knob only shows whole degrees
+	return currentAngle() != m_angle;
+}
+
+
+
+
+bool Knob::updateAngle()
+{
+	const int angle = currentAngle();
 	if( qAbs( angle - m_angle ) > 0 )
 	{
 		m_angle = angle;
@@ -379,7 +397,6 @@ bool Knob::updateAngle()
 void Knob::drawKnob( QPainter * _p )
 {
 	bool enabled = this->isEnabled();
-	QColor currentArcColor = enabled ? m_arcActiveColor : m_arcInactiveColor;
 	QColor currentLineColor = enabled ? m_lineActiveColor : m_lineInactiveColor;
 
 	if( updateAngle() == false && !m_cache.isNull() )
@@ -429,19 +446,13 @@ void Knob::drawKnob( QPainter * _p )
 	const float radius = m_knobPixmap->width() / 2.0f - 1;
 	mid = QPoint( width() / 2, m_knobPixmap->height() / 2 );
 
-	p.drawPixmap( static_cast<int>(
-				width() / 2 - m_knobPixmap->width() / 2 ), 0,
-				*m_knobPixmap );
+	p.drawPixmap(0, 0, background());
 
 	p.setRenderHint( QPainter::Antialiasing );
 
 	const int centerAngle = angleFromValue( model()->inverseScaledValue( model()->centerValue() ), model()->minValue(), model()->maxValue(), m_totalAngle );
 
-	const int arcLineWidth = 2;
-	const int arcRectSize = m_knobPixmap->width() - arcLineWidth;
-
-	p.setPen(QPen(currentArcColor, 2));
-	p.drawArc( mid.x() - arcRectSize/2, 1, arcRectSize, arcRectSize, 315*16, 16*m_totalAngle );
+	const int arcRectSize = m_knobPixmap->width() - 2;
 
 	p.setPen(QPen(currentLineColor, 2));
 	switch( m_knobNum )
@@ -482,6 +493,34 @@ void Knob::drawKnob( QPainter * _p )
 	_p->drawImage( 0, 0, m_cache );
 }
 
+QPixmap Knob::background() const
+{
+	const bool enabled = isEnabled();
+	const QColor arcColor = enabled ? m_arcActiveColor : m_arcInactiveColor;
+	const auto cacheName = QStringLiteral("knob_%1_%2_%3_%4_%5x%6")
+		.arg(static_cast<int>(m_knobNum)).arg(enabled).arg(arcColor.rgba()).arg(m_totalAngle)
+		.arg(width()).arg(height());
+
+	if (auto pixmap = QPixmap{}; QPixmapCache::find(cacheName, &pixmap)) { return pixmap; }
+
+	auto pixmap = QPixmap(size());
+	pixmap.fill(Qt::transparent);
+
+	QPainter p(&pixmap);
+	p.drawPixmap(width() / 2 - m_knobPixmap->width() / 2, 0, *m_knobPixmap);
+
+	const int arcLineWidth = 2;
+	const int arcRectSize = m_knobPixmap->width() - arcLineWidth;
+
+	p.setRenderHint(QPainter::Antialiasing);
+	p.setPen(QPen(arcColor, arcLineWidth));
+	p.drawArc(width() / 2 - arcRectSize / 2, 1, arcRectSize, arcRectSize, 315 * 16, 16 * m_totalAngle);
+	p.end();
+
+	QPixmapCache::insert(cacheName, pixmap);
+	return pixmap;
+}
+
 void Knob::drawLabel(QPainter& p)
 {
 	if( !m_label.isEmpty() )
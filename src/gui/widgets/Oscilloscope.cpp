@@ -42,7 +42,7 @@ namespace lmms::gui
 Oscilloscope::Oscilloscope( QWidget * _p ) :
 	QWidget( _p ),
 	m_background( embed::getIconPixmap( "output_graph" ) ),
-	m_points( new QPointF[Engine::audioEngine()->framesPerPeriod()] ),
+	m_points( new QPointF[Engine::audioEngine()->maxFramesPerPeriod()] ),
 	m_active( false ),
 	m_leftChannelColor(71, 253, 133),
 	m_rightChannelColor(71, 253, 133),
@@ -52,7 +52,7 @@ Oscilloscope::Oscilloscope( QWidget * _p ) :
 	setFixedSize( m_background.width(), m_background.height() );
 	setActive( ConfigManager::inst()->value( "ui", "displaywaveform").toInt() );
 
-	const fpp_t frames = Engine::audioEngine()->framesPerPeriod();
+	const fpp_t frames = Engine::audioEngine()->maxFramesPerPeriod();
 	m_buffer = new SampleFrame[frames];
 
 	zeroSampleFrames(m_buffer, frames);
@@ -73,12 +73,12 @@ Oscilloscope::~Oscilloscope()
 
 
 
-void Oscilloscope::updateAudioBuffer(const SampleFrame* buffer)
+void Oscilloscope::updateAudioBuffer()
 {
-	if( !Engine::getSong()->isExporting() )
+	// only repaint if the audio engine rendered something since the last time
+	if (!Engine::getSong()->isExporting() && Engine::audioEngine()->readDisplayBuffer(m_buffer))
 	{
-		const fpp_t fpp = Engine::audioEngine()->framesPerPeriod();
-		memcpy(m_buffer, buffer, sizeof(SampleFrame) * fpp);
+		update();
 	}
 }
 
@@ -88,23 +88,18 @@ void Oscilloscope::updateAudioBuffer(const SampleFrame* buffer)
 void Oscilloscope::setActive( bool _active )
 {
 	m_active = _active;
+	Engine::audioEngine()->setDisplayed(m_active);
 	if( m_active )
 	{
 		connect( getGUI()->mainWindow(),
 					SIGNAL(periodicUpdate()),
-					this, SLOT(update()));
-		connect( Engine::audioEngine(),
-			SIGNAL(nextAudioBuffer(const lmms::SampleFrame*)),
-			this, SLOT(updateAudioBuffer(const lmms::SampleFrame*)));
+					this, SLOT(updateAudioBuffer()));
 	}
 	else
 	{
 		disconnect( getGUI()->mainWindow(),
 					SIGNAL(periodicUpdate()),
-					this, SLOT(update()));
-		disconnect( Engine::audioEngine(),
-			SIGNAL(nextAudioBuffer(const lmms::SampleFrame*)),
-			this, SLOT(updateAudioBuffer(const lmms::SampleFrame*)));
+					this, SLOT(updateAudioBuffer()));
 		// we have to update (remove last waves),
 		// because timer doesn't do that anymore
 		update();
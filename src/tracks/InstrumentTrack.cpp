@@ -23,11 +23,17 @@
  */
 #include "InstrumentTrack.h"
 
+#include <algorithm>
+#include <bitset>
+#include <iterator>
+
 #include "AudioEngine.h"
 #include "AutomationClip.h"
 #include "ConfigManager.h"
 #include "ControllerConnection.h"
 #include "DataFile.h"
+#include "EffectChain.h"
+#include "FrozenAudio.h"
 #include "GuiApplication.h"
 #include "Mixer.h"
 #include "InstrumentTrackView.h"
@@ -65,13 +71,19 @@ InstrumentTrack::InstrumentTrack(TrackContainer* tc) :
 	m_pitchRangeModel(1, 1, 60, this, tr("Pitch range")),
 	m_mixerChannelModel(0, 0, 0, this, tr("Mixer channel")),
 	m_useMasterPitchModel(true, this, tr("Master pitch")),
+	m_maxVoicesModel(0, 0, 999, this, tr("Maximum voices")),
 	m_instrument(nullptr),
+	m_deferredInstrument(),
 	m_soundShaping(this),
 	m_arpeggio(this),
 	m_noteStacking(this),
 	m_piano(this),
-	m_microtuner()
+	m_microtuner(),
+	m_noteBatch(this)
 {
+	// there are never more play handles, so batching notes doesn't allocate
+	m_batchedNotes.reserve(PlayHandle::MaxNumber);
+
 	m_pitchModel.setCenterValue( 0 );
 	m_pitchModel.setStrictStepSize(true);
 	m_panningModel.setCenterValue( DefaultPanning );
@@ -110,6 +122,11 @@ InstrumentTrack::InstrumentTrack(TrackContainer* tc) :
 	connect(&m_pitchRangeModel, SIGNAL(dataChanged()), this, SLOT(updatePitchRange()), Qt::DirectConnection);
 	connect(&m_mixerChannelModel, SIGNAL(dataChanged()), this, SLOT(updateMixerChannel()), Qt::DirectConnection);
 
+	// queued, as automation may unmute the track on the audio thread
+	connect(&m_mutedModel, &BoolModel::dataChanged, this, [this] {
+		if (!isMuted()) { loadDeferredInstrument(); }
+	}, Qt::QueuedConnection);
+
 	autoAssignMidiDevice(true);
 }
 
@@ -204,6 +221,8 @@ float InstrumentTrack::baseFreq() const
 
 InstrumentTrack::~InstrumentTrack()
 {
+	m_freezeWatcher.reset();
+
 	// De-assign midi device
 	if (m_hasAutoMidiDev)
 	{
@@ -270,11 +289,17 @@ void InstrumentTrack::processAudioBuffer( SampleFrame* buf, const fpp_t frames,
 		const float vol = ( (float) n->getVolume() * DefaultVolumeRatio );
 		const panning_t pan = std::clamp(n->getPanning(), PanningLeft, PanningRight);
 		StereoVolumeVector vv = panningToVolumeVector( pan, vol );
-		for( f_cnt_t f = offset; f < frames; ++f )
+		MixHelpers::multiplyStereo(buf + offset, vv.vol[0], vv.vol[1], frames - offset);
+
+		if (n->isStolen())
 		{
-			for( int c = 0; c < 2; ++c )
+			// fade out notes released by voice stealing
+			const float step = 1.f / n->stolenFadeFrames();
+			float level = n->framesLeft() * step;
+			for (fpp_t frame = offset; frame < frames; ++frame)
 			{
-				buf[f][c] *= vv.vol[c];
+				buf[frame] *= std::max(level, 0.f);
+				level -= step;
 			}
 		}
 	}
@@ -327,6 +352,8 @@ void InstrumentTrack::processInEvent( const MidiEvent& event, const TimePos& tim
 		return;
 	}
 
+	if (m_instrument) { m_instrument->wake(); }
+
 	bool eventHandled = false;
 
 	switch( event.type() )
@@ -465,6 +492,69 @@ void InstrumentTrack::processInEvent( const MidiEvent& event, const TimePos& tim
 
 
 
+void InstrumentTrack::processInEvents( const TimedMidiEvent* events, std::size_t count )
+{
+	// Controllers like MPE keyboards send a stream of pressure and pitch bend
+	// values, each of which costs a volume change or a model update with its
+	// signals. Only the last value before the end of the batch, or before
+	// the note it applies to changes, is audible, so skip the others.
+	constexpr std::size_t ChunkSize = 512;
+
+	for( std::size_t begin = 0; begin < count; begin += ChunkSize )
+	{
+		const std::size_t end = std::min( count, begin + ChunkSize );
+
+		std::bitset<ChunkSize> skip;
+		std::bitset<NumKeys> keyPressureSeen;
+		std::bitset<MidiChannelCount> pitchBendSeen;
+		std::bitset<MidiChannelCount> channelPressureSeen;
+
+		const auto seenBefore = []( auto& seen, int index ) {
+			if( index < 0 || index >= static_cast<int>( seen.size() ) ) { return false; }
+			const bool wasSeen = seen.test( index );
+			seen.set( index );
+			return wasSeen;
+		};
+
+		for( std::size_t i = end; i-- > begin; )
+		{
+			const MidiEvent& event = events[i].event;
+			switch( event.type() )
+			{
+				case MidiNoteOn:
+				case MidiNoteOff:
+					if( event.key() >= 0 && event.key() < NumKeys )
+					{
+						keyPressureSeen.reset( event.key() );
+					}
+					break;
+				case MidiKeyPressure:
+					skip[i - begin] = seenBefore( keyPressureSeen, event.key() );
+					break;
+				case MidiPitchBend:
+					skip[i - begin] = seenBefore( pitchBendSeen, event.channel() );
+					break;
+				case MidiChannelPressure:
+					skip[i - begin] = seenBefore( channelPressureSeen, event.channel() );
+					break;
+				default:
+					break;
+			}
+		}
+
+		for( std::size_t i = begin; i < end; ++i )
+		{
+			if( !skip[i - begin] )
+			{
+				processInEvent( events[i].event, events[i].time, events[i].offset );
+			}
+		}
+	}
+}
+
+
+
+
 void InstrumentTrack::processOutEvent( const MidiEvent& event, const TimePos& time, f_cnt_t offset )
 {
 	// do nothing if we do not have an instrument instance (e.g. when loading settings)
@@ -473,6 +563,8 @@ void InstrumentTrack::processOutEvent( const MidiEvent& event, const TimePos& ti
 		return;
 	}
 
+	m_instrument->wake();
+
 	const MidiEvent transposedEvent = applyMasterKey( event );
 	const int key = transposedEvent.key();
 
@@ -520,7 +612,7 @@ void InstrumentTrack::processOutEvent( const MidiEvent& event, const TimePos& ti
 	}
 
 	// if appropriate, midi-port does futher routing
-	m_midiPort.processOutEvent( event, time );
+	m_midiPort.processOutEvent( event, time, offset );
 }
 
 
@@ -598,6 +690,101 @@ void InstrumentTrack::playNote( NotePlayHandle* n, SampleFrame* workingBuffer )
 
 
 
+void InstrumentTrack::playNotes( std::span<NotePlayHandle* const> notes )
+{
+	for( NotePlayHandle* n : notes )
+	{
+		m_noteStacking.processNote( n );
+		m_arpeggio.processNote( n );
+	}
+
+	if( m_instrument == nullptr )
+	{
+		return;
+	}
+
+	m_batchedNotes.clear();
+	std::copy_if( notes.begin(), notes.end(), std::back_inserter( m_batchedNotes ),
+		[]( const NotePlayHandle* n ) { return !n->isMasterNote(); } );
+
+	m_instrument->playNotes( m_batchedNotes );
+
+	for( NotePlayHandle* n : m_batchedNotes )
+	{
+		if( n->usesBuffer() )
+		{
+			const fpp_t frames = n->framesLeftForCurrentPeriod();
+			const f_cnt_t offset = n->noteOffset();
+			processAudioBuffer( n->workingBuffer(), frames + offset, n );
+		}
+	}
+}
+
+
+
+
+bool InstrumentTrack::batchesNotes() const
+{
+	return m_instrument != nullptr && m_instrument->batchesNotes();
+}
+
+
+
+
+InstrumentTrack::NoteBatch::NoteBatch( InstrumentTrack* track ) :
+	m_track( track )
+{
+	m_notes.reserve( PlayHandle::MaxNumber );
+	m_begun.reserve( PlayHandle::MaxNumber );
+	m_playing.reserve( PlayHandle::MaxNumber );
+}
+
+
+
+
+void InstrumentTrack::NoteBatch::doProcessing()
+{
+	AudioEngineProfiler::TraceScope trace(Engine::audioEngine()->profiler(), "Play handle", "Note batch",
+		reinterpret_cast<std::uintptr_t>(this));
+	const auto time = CpuTime::Scope{&m_track->audioBusHandle()->playHandlesTime()};
+	// like the first note would be, if it had a job of its own
+	Engine::audioEngine()->seedRandom(AudioEngine::RandomDomain::PlayHandle, m_notes.front()->order());
+
+	m_begun.clear();
+	m_playing.clear();
+
+	for( NotePlayHandle* n : m_notes )
+	{
+		n->beginProcessing();
+		if( n->beginPeriod() )
+		{
+			m_begun.push_back( n );
+			// see NotePlayHandle::play()
+			if( n->framesLeft() > 0 )
+			{
+				m_playing.push_back( n );
+			}
+		}
+	}
+
+	m_track->playNotes( m_playing );
+
+	for( NotePlayHandle* n : m_begun )
+	{
+		n->finishPeriod();
+	}
+
+	// the bus handle may be processed as soon as the last note is done
+	for( NotePlayHandle* n : m_notes )
+	{
+		n->finishProcessing();
+	}
+	m_notes.clear();
+}
+
+
+
+
 QString InstrumentTrack::instrumentName() const
 {
 	if( m_instrument != nullptr )
@@ -705,6 +892,12 @@ bool InstrumentTrack::play( const TimePos & _start, const fpp_t _frames,
 	{
 		return false;
 	}
+	// the frozen audio is heard instead of the notes
+	if (m_audioBusHandle.playsFrozenAudio())
+	{
+		unlock();
+		return false;
+	}
 	const float frames_per_tick = Engine::framesPerTick();
 
 	clipVector clips;
@@ -715,7 +908,7 @@ bool InstrumentTrack::play( const TimePos & _start, const fpp_t _frames,
 		clips.push_back( clip );
 		if (trackContainer() == Engine::patternStore())
 		{
-			pattern_track = PatternTrack::findPatternTrack(_clip_num);
+			pattern_track = Engine::patternStore()->patternTrack(_clip_num);
 		}
 	}
 	else
@@ -754,36 +947,11 @@ bool InstrumentTrack::play( const TimePos & _start, const fpp_t _frames,
 			cur_start -= c->startPosition() + c->startTimeOffset();
 		}
 
-		// get all notes from the given clip...
-		const NoteVector & notes = c->notes();
-		// ...and set our index to zero
-		auto nit = notes.begin();
-
-		// very effective algorithm for playing notes that are
-		// posated within the current sample-frame
-
-		if( cur_start > 0 )
-		{
-			// skip notes which end before start-bar
-			while( nit != notes.end() && ( *nit )->endPos() < cur_start )
-			{
-				++nit;
-			}
-		}
-
-		while (nit != notes.end() && (*nit)->pos() < c->length() - c->startTimeOffset())
+		const auto clipEnd = c->length() - c->startTimeOffset();
+		const auto playNote = [&](const Note* currentNote)
 		{
-			const auto currentNote = *nit;
-			// Skip any notes note at the current time pos or not overlapping with the start.
-			if (!(currentNote->pos() == cur_start
-				|| (cur_start == -c->startTimeOffset() && (*nit)->pos() < cur_start && (*nit)->endPos() > cur_start)))
-			{
-				++nit;
-				continue;
-			}
-
 			// Calculate the overlap of the note over the clip end.
-			const auto noteOverlap = std::max(0, currentNote->endPos() - (c->length() - c->startTimeOffset()));
+			const auto noteOverlap = std::max(0, currentNote->endPos() - clipEnd);
 			// If the note is a Step Note, frames will be 0 so the NotePlayHandle
 			// plays for the whole length of the sample
 			const auto noteFrames = currentNote->type() == Note::Type::Step
@@ -802,7 +970,23 @@ bool InstrumentTrack::play( const TimePos & _start, const fpp_t _frames,
 
 			Engine::audioEngine()->addPlayHandle( notePlayHandle );
 			played_a_note = true;
-			++nit;
+		};
+
+		// notes overlapping the start of the clip are played from there on
+		if (cur_start == -c->startTimeOffset())
+		{
+			for (const auto currentNote : c->notes())
+			{
+				if (currentNote->pos() >= cur_start) { break; }
+				if (currentNote->endPos() > cur_start) { playNote(currentNote); }
+			}
+		}
+
+		// only the notes starting right now are looked at, not all notes of the clip
+		for (const auto currentNote : c->notesStartingAt(cur_start))
+		{
+			if (currentNote->pos() >= clipEnd) { break; }
+			playNote(currentNote);
 		}
 	}
 	unlock();
@@ -842,6 +1026,7 @@ void InstrumentTrack::saveTrackSpecificSettings(QDomDocument& doc, QDomElement&
 	m_firstKeyModel.saveSettings(doc, thisElement, "firstkey");
 	m_lastKeyModel.saveSettings(doc, thisElement, "lastkey");
 	m_useMasterPitchModel.saveSettings( doc, thisElement, "usemasterpitch");
+	m_maxVoicesModel.saveSettings(doc, thisElement, "maxvoices");
 	m_microtuner.saveSettings(doc, thisElement);
 
 	// Save MIDI CC stuff
@@ -863,6 +1048,11 @@ void InstrumentTrack::saveTrackSpecificSettings(QDomDocument& doc, QDomElement&
 		}
 		thisElement.appendChild( i );
 	}
+	else if( hasDeferredInstrument() )
+	{
+		// saved as it was loaded, the instrument can't have changed
+		thisElement.appendChild( doc.importNode( m_deferredInstrument.documentElement(), true ) );
+	}
 	m_soundShaping.saveState( doc, thisElement );
 	m_noteStacking.saveState( doc, thisElement );
 	m_arpeggio.saveState( doc, thisElement );
@@ -915,6 +1105,7 @@ void InstrumentTrack::loadTrackSpecificSettings( const QDomElement & thisElement
 	m_firstKeyModel.loadSettings(thisElement, "firstkey");
 	m_lastKeyModel.loadSettings(thisElement, "lastkey");
 	m_useMasterPitchModel.loadSettings( thisElement, "usemasterpitch");
+	m_maxVoicesModel.loadSettings(thisElement, "maxvoices");
 	m_microtuner.loadSettings(thisElement);
 
 	// clear effect-chain just in case we load an old preset without FX-data
@@ -951,22 +1142,25 @@ void InstrumentTrack::loadTrackSpecificSettings( const QDomElement & thisElement
 			}
 			else if(node.nodeName() == "instrument")
 			{
-				using PluginKey = Plugin::Descriptor::SubPluginFeatures::Key;
-				PluginKey key(node.toElement().elementsByTagName("key").item(0).toElement());
-
+				m_deferredInstrument = QDomDocument();
 				if (reuseInstrument)
 				{
 					m_instrument->restoreState(node.firstChildElement());
 				}
-				else
+				else if (mayDeferInstrument(node.toElement()))
 				{
+					// the instrument is created once the track is unmuted
+					// or opened, which saves loading plugins never played
 					delete m_instrument;
 					m_instrument = nullptr;
-					m_instrument = Instrument::instantiate(
-						node.toElement().attribute("name"), this, &key);
-					m_instrument->restoreState(node.firstChildElement());
+					m_deferredInstrument = QDomDocument("instrument");
+					m_deferredInstrument.appendChild(m_deferredInstrument.importNode(node, true));
 					emit instrumentChanged();
 				}
+				else
+				{
+					restoreInstrument(node.toElement());
+				}
 			}
 			else if (node.nodeName() == "midicontrollers")
 			{
@@ -1039,6 +1233,61 @@ void InstrumentTrack::replaceInstrument(DataFile dataFile)
 
 
 
+bool InstrumentTrack::mayDeferInstrument(const QDomElement& instrument) const
+{
+	if (!isMuted() || m_previewMode || !Engine::getSong()->isLoadingProject()) { return false; }
+
+	// automation or a controller may unmute the track while playing, when
+	// there's no time to create the instrument any more. The muted model was
+	// loaded already, but automation is only connected once the project is, so
+	// look for it being saved as an element with an ID.
+	const QDomElement track = instrument.parentNode().parentNode().toElement();
+	if (m_mutedModel.isAutomatedOrControlled() || !track.firstChildElement("muted").isNull()) { return false; }
+
+	// automated or controlled models of the instrument have to exist to be
+	// connected once the project is loaded
+	const QDomNodeList elements = instrument.elementsByTagName("*");
+	for (int i = 0; i < elements.count(); ++i)
+	{
+		const QDomElement element = elements.item(i).toElement();
+		if (element.hasAttribute("id") || element.tagName() == "connection") { return false; }
+	}
+	return true;
+}
+
+
+
+
+void InstrumentTrack::restoreInstrument(const QDomElement& instrument)
+{
+	using PluginKey = Plugin::Descriptor::SubPluginFeatures::Key;
+	PluginKey key(instrument.elementsByTagName("key").item(0).toElement());
+
+	delete m_instrument;
+	m_instrument = nullptr;
+	m_instrument = Instrument::instantiate(instrument.attribute("name"), this, &key);
+	m_instrument->restoreState(instrument.firstChildElement());
+	emit instrumentChanged();
+}
+
+
+
+
+void InstrumentTrack::loadDeferredInstrument()
+{
+	if (!hasDeferredInstrument()) { return; }
+
+	const QDomDocument deferred = m_deferredInstrument;
+	m_deferredInstrument = QDomDocument();
+
+	lock();
+	restoreInstrument(deferred.documentElement());
+	unlock();
+}
+
+
+
+
 QString InstrumentTrack::getSavedInstrumentName(const QDomElement &thisElement) const
 {
 	QDomElement elem = thisElement.firstChildElement("instrument");
@@ -1061,6 +1310,7 @@ Instrument * InstrumentTrack::loadInstrument(const QString & _plugin_name,
 	silenceAllNotes( true );
 
 	lock();
+	m_deferredInstrument = QDomDocument();
 	delete m_instrument;
 	m_instrument = Instrument::instantiate(_plugin_name, this,
 					key, keyFromDnd);
@@ -1074,6 +1324,60 @@ Instrument * InstrumentTrack::loadInstrument(const QString & _plugin_name,
 
 
 
+void InstrumentTrack::freeze(std::shared_ptr<const FrozenAudio> audio)
+{
+	unfreeze();
+	m_audioBusHandle.setFrozenAudio(std::move(audio));
+	m_freezeWatcher = std::make_unique<QObject>();
+	QObject* watcher = m_freezeWatcher.get();
+
+	// changing anything the audio was rendered from unfreezes the track
+	const auto watchClip = [this, watcher](Clip* clip)
+	{
+		connect(clip, &Clip::dataChanged, watcher, [this] { unfreeze(); });
+		connect(clip, &Clip::lengthChanged, watcher, [this] { unfreeze(); });
+		connect(clip, &Clip::positionChanged, watcher, [this] { unfreeze(); });
+		connect(clip, &Clip::destroyedClip, watcher, [this] { unfreeze(); });
+	};
+	for (Clip* clip : getClips()) { watchClip(clip); }
+	connect(this, &Track::clipAdded, watcher, [this] { unfreeze(); });
+	connect(this, &InstrumentTrack::instrumentChanged, watcher, [this] { unfreeze(); });
+	connect(m_audioBusHandle.effects(), &EffectChain::dataChanged, watcher, [this] { unfreeze(); });
+	connect(Engine::getSong(), &Song::tempoChanged, watcher, [this] { unfreeze(); });
+	connect(Engine::audioEngine(), &AudioEngine::sampleRateChanged, watcher, [this] { unfreeze(); });
+
+	// automated models were rendered along with their automation, which is watched instead
+	auto models = findChildren<AutomatableModel*>();
+	models += m_audioBusHandle.effects()->findChildren<AutomatableModel*>();
+	for (AutomatableModel* model : models)
+	{
+		if (model == &m_mutedModel || model == &m_soloModel || model == &m_mixerChannelModel) { continue; }
+
+		connect(model, &AutomatableModel::dataChanged, watcher, [this, model]
+		{
+			if (!model->isAutomatedOrControlled()) { unfreeze(); }
+		});
+		for (AutomationClip* clip : AutomationClip::clipsForModel(model)) { watchClip(clip); }
+	}
+
+	emit frozenChanged();
+}
+
+
+
+
+void InstrumentTrack::unfreeze()
+{
+	if (!isFrozen()) { return; }
+
+	m_freezeWatcher.reset();
+	m_audioBusHandle.setFrozenAudio(nullptr);
+	emit frozenChanged();
+}
+
+
+
+
 InstrumentTrack *InstrumentTrack::s_autoAssignedTrack = nullptr;
 
 /*! \brief Automatically assign a midi controller to this track, based on the midiautoassign setting
@@ -26,6 +26,8 @@
 #include "MidiClip.h"
 
 #include <algorithm>
+#include <functional>
+#include <unordered_map>
 #include <QDomElement>
 
 #include "GuiApplication.h"
@@ -39,10 +41,71 @@
 namespace lmms
 {
 
+std::vector<MidiClip::ParsedNotes>* MidiClip::s_parsedNotes = nullptr;
+std::size_t MidiClip::s_nextParsedNotes = 0;
+
+namespace
+{
+
+//! The notes of loaded clips by the hash of their notes, so clips loaded with
+//! the same notes can share them
+std::unordered_map<std::size_t, std::weak_ptr<NoteVector>> s_loadedNotes;
+std::size_t s_loadedNotesPruneSize = 64;
+
+std::shared_ptr<NoteVector> makeNoteStore(NoteVector notes = {})
+{
+	return std::shared_ptr<NoteVector>(new NoteVector(std::move(notes)), [](NoteVector* notes) {
+		for (const auto& note : *notes)
+		{
+			delete note;
+		}
+		delete notes;
+	});
+}
+
+bool sameNotes(const NoteVector& a, const NoteVector& b)
+{
+	return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const Note* n1, const Note* n2) {
+		return n1->pos() == n2->pos() && n1->length() == n2->length() && n1->key() == n2->key()
+			&& n1->getVolume() == n2->getVolume() && n1->getPanning() == n2->getPanning()
+			&& n1->type() == n2->type();
+	});
+}
+
+std::size_t hashNotes(const NoteVector& notes)
+{
+	auto hash = std::hash<std::size_t>{}(notes.size());
+	for (const auto& note : notes)
+	{
+		for (const auto value : {static_cast<int>(note->pos()), static_cast<int>(note->length()), note->key(),
+			static_cast<int>(note->getVolume()), static_cast<int>(note->getPanning()), static_cast<int>(note->type())})
+		{
+			hash ^= std::hash<int>{}(value) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+		}
+	}
+	return hash;
+}
+
+const MidiClip* pianoRollClip()
+{
+	return gui::getGUI() != nullptr && gui::getGUI()->pianoRoll()
+		? gui::getGUI()->pianoRoll()->currentMidiClip()
+		: nullptr;
+}
+
+bool isOpenInPianoRoll(const MidiClip* clip)
+{
+	return clip != nullptr && pianoRollClip() == clip;
+}
+
+} // namespace
+
+
 MidiClip::MidiClip( InstrumentTrack * _instrument_track ) :
 	Clip( _instrument_track ),
 	m_instrumentTrack( _instrument_track ),
 	m_clipType( Type::BeatClip ),
+	m_notes(makeNoteStore()),
 	m_steps( TimePos::stepsPerBar() )
 {
 	if (_instrument_track->trackContainer()	== Engine::patternStore())
@@ -59,12 +122,11 @@ MidiClip::MidiClip( const MidiClip& other ) :
 	Clip(other),
 	m_instrumentTrack( other.m_instrumentTrack ),
 	m_clipType( other.m_clipType ),
+	m_notes(other.m_notes),
 	m_steps( other.m_steps )
 {
-	for (const auto& note : other.m_notes)
-	{
-		m_notes.push_back(note->clone());
-	}
+	// the piano roll edits its clip's notes directly, so they must not be shared
+	if (isOpenInPianoRoll(&other)) { detachNotes(); }
 
 	init();
 }
@@ -73,13 +135,6 @@ MidiClip::MidiClip( const MidiClip& other ) :
 MidiClip::~MidiClip()
 {
 	emit destroyedMidiClip( this );
-
-	for (const auto& note : m_notes)
-	{
-		delete note;
-	}
-
-	m_notes.clear();
 }
 
 
@@ -114,6 +169,8 @@ void MidiClip::init()
 {
 	connect( Engine::getSong(), SIGNAL(timeSignatureChanged(int,int)),
 				this, SLOT(changeTimeSignature()));
+	// connected first, so anyone notified about changed notes finds the new ones
+	connect(this, &Model::dataChanged, this, [this] { m_noteIndex.invalidate(); });
 	saveJournallingState( false );
 
 	updateLength();
@@ -137,7 +194,7 @@ void MidiClip::updateLength()
 	{
 		tick_t max_length = TimePos::ticksPerBar();
 
-		for (const auto& note : m_notes)
+		for (const auto& note : *m_notes)
 		{
 			if (note->length() > 0)
 			{
@@ -158,7 +215,7 @@ TimePos MidiClip::beatClipLength() const
 {
 	tick_t max_length = TimePos::ticksPerBar();
 
-	for (const auto& note : m_notes)
+	for (const auto& note : *m_notes)
 	{
 		if (note->type() == Note::Type::Step)
 		{
@@ -177,8 +234,61 @@ TimePos MidiClip::beatClipLength() const
 
 
 
+void MidiClip::detachNotes()
+{
+	if (m_notes.use_count() == 1) { return; }
+
+	auto notes = NoteVector{};
+	notes.reserve(m_notes->size());
+	for (const auto& note : *m_notes)
+	{
+		notes.push_back(note->clone());
+	}
+
+	instrumentTrack()->lock();
+	m_notes = makeNoteStore(std::move(notes));
+	instrumentTrack()->unlock();
+	m_noteIndex.invalidate();
+}
+
+
+
+
+void MidiClip::shareNotes()
+{
+	if (m_notes->empty() || isOpenInPianoRoll(this)) { return; }
+	if (std::any_of(m_notes->begin(), m_notes->end(), [](const Note* note) { return note->hasDetuningInfo(); }))
+	{
+		return;
+	}
+
+	auto& loaded = s_loadedNotes[hashNotes(*m_notes)];
+	const auto openClip = pianoRollClip();
+	if (const auto notes = loaded.lock(); notes && notes != m_notes
+		&& (openClip == nullptr || openClip->m_notes != notes) && sameNotes(*notes, *m_notes))
+	{
+		instrumentTrack()->lock();
+		m_notes = notes;
+		instrumentTrack()->unlock();
+		m_noteIndex.invalidate();
+		return;
+	}
+	loaded = m_notes;
+
+	if (s_loadedNotes.size() >= s_loadedNotesPruneSize)
+	{
+		std::erase_if(s_loadedNotes, [](const auto& entry) { return entry.second.expired(); });
+		s_loadedNotesPruneSize = std::max<std::size_t>(64, s_loadedNotes.size() * 2);
+	}
+}
+
+
+
+
 Note * MidiClip::addNote( const Note & _new_note, const bool _quant_pos )
 {
+	detachNotes();
+
 	auto new_note = _new_note.clone();
 	if (_quant_pos && gui::getGUI()->pianoRoll())
 	{
@@ -186,7 +296,7 @@ Note * MidiClip::addNote( const Note & _new_note, const bool _quant_pos )
 	}
 
 	instrumentTrack()->lock();
-	m_notes.insert(std::upper_bound(m_notes.begin(), m_notes.end(), new_note, Note::lessThan), new_note);
+	m_notes->insert(std::upper_bound(m_notes->begin(), m_notes->end(), new_note, Note::lessThan), new_note);
 	instrumentTrack()->unlock();
 
 	checkType();
@@ -200,11 +310,54 @@ Note * MidiClip::addNote( const Note & _new_note, const bool _quant_pos )
 
 
 
+NoteVector MidiClip::addNotes(const std::vector<Note>& newNotes, const bool quantPos)
+{
+	if (newNotes.empty()) { return {}; }
+
+	addJournalCheckPoint();
+	detachNotes();
+
+	const int quantization = quantPos && gui::getGUI()->pianoRoll()
+		? gui::getGUI()->pianoRoll()->quantization()
+		: 0;
+
+	auto added = NoteVector{};
+	added.reserve(newNotes.size());
+	for (const auto& note : newNotes)
+	{
+		auto newNote = note.clone();
+		if (quantization > 0) { newNote->quantizePos(quantization); }
+		added.push_back(newNote);
+	}
+	std::stable_sort(added.begin(), added.end(), Note::lessThan);
+
+	// new notes go behind existing ones at the same position, like in addNote()
+	instrumentTrack()->lock();
+	const auto existing = m_notes->size();
+	m_notes->insert(m_notes->end(), added.begin(), added.end());
+	std::inplace_merge(m_notes->begin(), m_notes->begin() + existing, m_notes->end(), Note::lessThan);
+	instrumentTrack()->unlock();
+
+	checkType();
+	updateLength();
+
+	emit dataChanged();
+
+	return added;
+}
+
+
+
+
 NoteVector::const_iterator MidiClip::removeNote(NoteVector::const_iterator it)
 {
+	// the iterator may point into notes shared with other clips
+	const auto index = it - m_notes->cbegin();
+	detachNotes();
+
 	instrumentTrack()->lock();
-	delete *it;
-	auto new_it = m_notes.erase(it);
+	delete (*m_notes)[index];
+	auto new_it = m_notes->erase(m_notes->cbegin() + index);
 	instrumentTrack()->unlock();
 
 	checkType();
@@ -216,13 +369,16 @@ NoteVector::const_iterator MidiClip::removeNote(NoteVector::const_iterator it)
 
 NoteVector::const_iterator MidiClip::removeNote(Note* note)
 {
+	const auto index = std::find(m_notes->begin(), m_notes->end(), note) - m_notes->begin();
+	detachNotes();
+
 	instrumentTrack()->lock();
 
-	auto it = std::find(m_notes.begin(), m_notes.end(), note);
-	if (it != m_notes.end())
+	auto it = m_notes->begin() + index;
+	if (it != m_notes->end())
 	{
 		delete *it;
-		it = m_notes.erase(it);
+		it = m_notes->erase(it);
 	}
 
 	instrumentTrack()->unlock();
@@ -235,10 +391,40 @@ NoteVector::const_iterator MidiClip::removeNote(Note* note)
 }
 
 
+std::span<Note* const> MidiClip::notesStartingAt(const TimePos& pos) const
+{
+	// the notes may have changed since, so the cursor is only used if it's still right behind pos
+	auto first = m_playCursor;
+	if (first > m_notes->size() || (first > 0 && (*m_notes)[first - 1]->pos() >= pos))
+	{
+		first = std::lower_bound(m_notes->begin(), m_notes->end(), pos,
+			[](const Note* note, const TimePos& p) { return note->pos() < p; }) - m_notes->begin();
+	}
+	while (first < m_notes->size() && (*m_notes)[first]->pos() < pos) { ++first; }
+
+	auto last = first;
+	while (last < m_notes->size() && (*m_notes)[last]->pos() == pos) { ++last; }
+
+	m_playCursor = last;
+	return {m_notes->data() + first, last - first};
+}
+
+
+
+
+NoteVector MidiClip::notesIn(tick_t from, tick_t to, int firstKey, int lastKey) const
+{
+	if (!m_noteIndex.isValid()) { m_noteIndex.build(*m_notes); }
+	return m_noteIndex.notesIn(from, to, firstKey, lastKey);
+}
+
+
+
+
 // Returns a pointer to the note at specified step, or nullptr if note doesn't exist
 Note * MidiClip::noteAtStep(int step)
 {
-	for (const auto& note : m_notes)
+	for (const auto& note : *m_notes)
 	{
 		if (note->pos() == TimePos::stepPosition(step)
 			&& note->type() == Note::Type::Step)
@@ -253,20 +439,20 @@ Note * MidiClip::noteAtStep(int step)
 
 void MidiClip::rearrangeAllNotes()
 {
+	detachNotes();
+
 	// sort notes by start time
-	std::sort(m_notes.begin(), m_notes.end(), Note::lessThan);
+	std::sort(m_notes->begin(), m_notes->end(), Note::lessThan);
+	m_noteIndex.invalidate();
 }
 
 
 
 void MidiClip::clearNotes()
 {
+	// the notes are deleted along with the last clip using them
 	instrumentTrack()->lock();
-	for (const auto& note : m_notes)
-	{
-		delete note;
-	}
-	m_notes.clear();
+	m_notes = makeNoteStore();
 	instrumentTrack()->unlock();
 
 	checkType();
@@ -418,7 +604,7 @@ void MidiClip::setType( Type _new_clip_type )
 void MidiClip::checkType()
 {
 	// If all notes are StepNotes, we have a BeatClip
-	const auto beatClip = std::all_of(m_notes.begin(), m_notes.end(), [](auto note) { return note->type() == Note::Type::Step; });
+	const auto beatClip = std::all_of(m_notes->begin(), m_notes->end(), [](auto note) { return note->type() == Note::Type::Step; });
 
 	setType(beatClip ? Type::BeatClip : Type::MelodyClip);
 }
@@ -452,7 +638,7 @@ void MidiClip::exportToXML(QDomDocument& doc, QDomElement& midiClipElement, bool
 	midiClipElement.setAttribute("len", length());
 
 	// now save settings of all notes
-	for (auto& note : m_notes)
+	for (auto& note : *m_notes)
 	{
 		if (!onlySelectedNotes || note->selected())
 		{
@@ -492,18 +678,47 @@ void MidiClip::loadSettings( const QDomElement & _this )
 
 	clearNotes();
 
-	QDomNode node = _this.firstChild();
-	while( !node.isNull() )
+	// the clips are mostly loaded in the order they were parsed in
+	ParsedNotes* parsed = nullptr;
+	if (s_parsedNotes != nullptr)
+	{
+		const std::size_t count = s_parsedNotes->size();
+		for (std::size_t i = 0; i < count && parsed == nullptr; ++i)
+		{
+			const std::size_t index = (s_nextParsedNotes + i) % count;
+			if ((*s_parsedNotes)[index].clip == _this)
+			{
+				parsed = &(*s_parsedNotes)[index];
+				s_nextParsedNotes = index + 1;
+			}
+		}
+	}
+
+	if (parsed != nullptr)
 	{
-		if( node.isElement() &&
-			!node.toElement().attribute( "metadata" ).toInt() )
+		for (const auto& [attributes, element] : parsed->notes)
 		{
 			auto n = new Note;
-			n->restoreState( node.toElement() );
-			m_notes.push_back( n );
+			if (element.isNull()) { n->loadAttributes(attributes); }
+			else { n->restoreState(element); }
+			m_notes->push_back(n);
 		}
-		node = node.nextSibling();
-        }
+	}
+	else
+	{
+		QDomNode node = _this.firstChild();
+		while( !node.isNull() )
+		{
+			if( node.isElement() &&
+				!node.toElement().attribute( "metadata" ).toInt() )
+			{
+				auto n = new Note;
+				n->restoreState( node.toElement() );
+				m_notes->push_back( n );
+			}
+			node = node.nextSibling();
+		}
+	}
 
 	m_steps = _this.attribute( "steps" ).toInt();
 	if( m_steps == 0 )
@@ -511,6 +726,7 @@ void MidiClip::loadSettings( const QDomElement & _this )
 		m_steps = TimePos::stepsPerBar();
 	}
 
+	shareNotes();
 	checkType();
 
 	int len = _this.attribute("len").toInt();
@@ -533,6 +749,33 @@ void MidiClip::loadSettings( const QDomElement & _this )
 
 
 
+auto MidiClip::parseNotes(const QString& clip) -> std::optional<ParsedNotes>
+{
+	auto parsed = ParsedNotes{};
+	if (!parsed.document.setContent(clip)) { return std::nullopt; }
+
+	const auto element = parsed.document.documentElement();
+	for (auto note = element.firstChildElement(); !note.isNull(); note = note.nextSiblingElement())
+	{
+		if (note.attribute("metadata").toInt()) { continue; }
+
+		parsed.notes.emplace_back(Note::parseAttributes(note), note.hasChildNodes() ? note : QDomElement());
+	}
+	return parsed;
+}
+
+
+
+
+auto MidiClip::useParsedNotes(std::vector<ParsedNotes>* parsed) -> std::vector<ParsedNotes>*
+{
+	s_nextParsedNotes = 0;
+	return std::exchange(s_parsedNotes, parsed);
+}
+
+
+
+
 MidiClip *  MidiClip::previousMidiClip() const
 {
 	return adjacentMidiClipByOffset(-1);
@@ -578,6 +821,8 @@ void MidiClip::addSteps()
 
 void MidiClip::cloneSteps()
 {
+	detachNotes();
+
 	int oldLength = m_steps;
 	m_steps *= 2; // cloning doubles the track
 	for(int i = 0; i < oldLength; ++i )
@@ -633,9 +878,7 @@ void MidiClip::updatePatternTrack()
 		Engine::patternStore()->updatePatternTrack(this);
 	}
 
-	if (gui::getGUI() != nullptr
-		&& gui::getGUI()->pianoRoll()
-		&& gui::getGUI()->pianoRoll()->currentMidiClip() == this)
+	if (isOpenInPianoRoll(this))
 	{
 		gui::getGUI()->pianoRoll()->update();
 	}
@@ -646,7 +889,7 @@ void MidiClip::updatePatternTrack()
 
 bool MidiClip::empty()
 {
-	for (const auto& note : m_notes)
+	for (const auto& note : *m_notes)
 	{
 		if (note->length() != 0)
 		{
@@ -662,7 +905,7 @@ bool MidiClip::empty()
 void MidiClip::changeTimeSignature()
 {
 	TimePos last_pos = TimePos::ticksPerBar() - 1;
-	for (const auto& note : m_notes)
+	for (const auto& note : *m_notes)
 	{
 		if (note->length() < 0 && note->pos() > last_pos)
 		{
@@ -49,14 +49,18 @@ SampleTrack::SampleTrack(TrackContainer* tc) :
 	m_volumeModel(DefaultVolume, MinVolume, MaxVolume, 0.1f, this, tr("Volume")),
 	m_panningModel(DefaultPanning, PanningLeft, PanningRight, 0.1f, this, tr("Panning")),
 	m_mixerChannelModel(0, 0, 0, this, tr("Mixer channel")),
+	m_monitorInputModel(false, this, tr("Monitor input")),
 	m_audioBusHandle(tr("Sample track"), true, &m_volumeModel, &m_panningModel, &m_mutedModel),
-	m_isPlaying(false)
+	m_isPlaying(false),
+	m_monitoringInput(false)
 {
 	setName(tr("Sample track"));
 	m_panningModel.setCenterValue(DefaultPanning);
 	m_mixerChannelModel.setRange(0, Engine::mixer()->numChannels()-1, 1);
 
 	connect(&m_mixerChannelModel, SIGNAL(dataChanged()), this, SLOT(updateMixerChannel()));
+	connect(&m_mixerChannelModel, SIGNAL(dataChanged()), this, SLOT(updateInputMonitoring()));
+	connect(&m_monitorInputModel, SIGNAL(dataChanged()), this, SLOT(updateInputMonitoring()));
 }
 
 
@@ -64,6 +68,7 @@ SampleTrack::SampleTrack(TrackContainer* tc) :
 
 SampleTrack::~SampleTrack()
 {
+	if (m_monitoringInput) { Engine::audioEngine()->setInputMonitorChannel(-1); }
 	Engine::audioEngine()->removePlayHandlesOfTypes( this, PlayHandle::Type::SamplePlayHandle );
 }
 
@@ -92,7 +97,7 @@ bool SampleTrack::play( const TimePos & _start, const fpp_t _frames,
 		clips.push_back( getClip( _clip_num ) );
 		if (trackContainer() == Engine::patternStore())
 		{
-			pattern_track = PatternTrack::findPatternTrack(_clip_num);
+			pattern_track = Engine::patternStore()->patternTrack(_clip_num);
 			setPlaying(true);
 		}
 	}
@@ -108,10 +113,11 @@ bool SampleTrack::play( const TimePos & _start, const fpp_t _frames,
 			{
 				if( sClip->isPlaying() == false && _start >= (sClip->startPosition() + sClip->startTimeOffset()) )
 				{
-					auto bufferFramesPerTick = Engine::framesPerTick(sClip->sample().sampleRate());
+					const auto& sample = sClip->playbackSample();
+					auto bufferFramesPerTick = Engine::framesPerTick(sample.sampleRate());
 					f_cnt_t sampleStart = bufferFramesPerTick * ( _start - sClip->startPosition() - sClip->startTimeOffset() );
 					f_cnt_t clipFrameLength = bufferFramesPerTick * ( sClip->endPosition() - sClip->startPosition() - sClip->startTimeOffset() );
-					f_cnt_t sampleBufferLength = sClip->sample().sampleSize();
+					f_cnt_t sampleBufferLength = sample.sampleSize();
 					//if the Clip smaller than the sample length we play only until Clip end
 					//else we play the sample to the end but nothing more
 					f_cnt_t samplePlayLength = clipFrameLength > sampleBufferLength ? sampleBufferLength : clipFrameLength;
@@ -147,8 +153,12 @@ bool SampleTrack::play( const TimePos & _start, const fpp_t _frames,
 				{
 					return played_a_note;
 				}
-				auto smpHandle = new SampleRecordHandle(st);
-				handle = smpHandle;
+				auto recording = st->takeRecording();
+				if (!recording)
+				{
+					continue;
+				}
+				handle = new SampleRecordHandle(st, std::move(recording));
 			}
 			else
 			{
@@ -194,6 +204,7 @@ void SampleTrack::saveTrackSpecificSettings(QDomDocument& doc, QDomElement& this
 	m_volumeModel.saveSettings(doc, thisElem, "vol");
 	m_panningModel.saveSettings(doc, thisElem, "pan");
 	m_mixerChannelModel.saveSettings(doc, thisElem, "mixch");
+	m_monitorInputModel.saveSettings(doc, thisElem, "monitor");
 }
 
 
@@ -218,6 +229,7 @@ void SampleTrack::loadTrackSpecificSettings(const QDomElement & thisElem)
 	m_panningModel.loadSettings(thisElem, "pan");
 	m_mixerChannelModel.setRange(0, Engine::mixer()->numChannels() - 1);
 	m_mixerChannelModel.loadSettings(thisElem, "mixch");
+	m_monitorInputModel.loadSettings(thisElem, "monitor");
 }
 
 
@@ -251,4 +263,22 @@ void SampleTrack::updateMixerChannel()
 }
 
 
+
+
+void SampleTrack::updateInputMonitoring()
+{
+	// the engine monitors on one channel, the track enabling it last takes it over
+	if (m_monitorInputModel.value())
+	{
+		Engine::audioEngine()->setInputMonitorChannel(m_mixerChannelModel.value());
+		m_monitoringInput = true;
+	}
+	else if (m_monitoringInput)
+	{
+		Engine::audioEngine()->setInputMonitorChannel(-1);
+		m_monitoringInput = false;
+	}
+}
+
+
 } // namespace lmms
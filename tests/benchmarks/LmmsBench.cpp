@@ -0,0 +1,350 @@
+/*
+ * LmmsBench.cpp - headless benchmark rendering reference projects
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+// Every configuration is rendered in a child process of its own, so the
+// engine always starts from a clean state and the peak RSS can be measured
+// per run. The parent process only collects the results.
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <QThread>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+#include "lmmsconfig.h"
+#include "lmmsversion.h"
+
+#ifdef LMMS_BUILD_WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "AudioEngine.h"
+#include "AudioEngineProfiler.h"
+#include "ConfigManager.h"
+#include "Engine.h"
+#include "OutputSettings.h"
+#include "ProjectRenderer.h"
+#include "Song.h"
+
+using namespace lmms;
+
+namespace
+{
+
+void printUsage()
+{
+	std::printf("Usage: lmms-bench [options]\n\n"
+		"  --projects <dir>         Directory with the .mmp projects to render\n"
+		"          Default: " LMMS_BENCH_PROJECT_DIR "\n"
+		"  --threads <list>         Comma-separated numbers of processing threads\n"
+		"          Default: 1 and the number of CPU cores\n"
+		"  --frames <list>          Comma-separated frames per period, at most %zu\n"
+		"          Default: 64,%zu\n"
+		"  --repeat <n>             Render every configuration <n> times and keep the fastest run\n"
+		"          Default: 1\n"
+		"  --output <file>          Write the JSON report to <file> instead of stdout\n"
+		"  -h, --help               Show this usage information and exit\n\n",
+		MAXIMUM_RENDER_BUFFER_SIZE, DEFAULT_BUFFER_SIZE);
+}
+
+
+
+
+QList<int> parseList(const QString& list)
+{
+	QList<int> values;
+	for (const auto& item : list.split(','))
+	{
+		bool ok = false;
+		const int value = item.toInt(&ok);
+		if (!ok || value <= 0)
+		{
+			return {};
+		}
+		values.append(value);
+	}
+	return values;
+}
+
+
+
+
+//! Peak resident set size of this process in KiB
+qint64 peakRss()
+{
+#ifdef LMMS_BUILD_WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+	{
+		return counters.PeakWorkingSetSize / 1024;
+	}
+	return 0;
+#else
+	rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+#ifdef LMMS_BUILD_APPLE
+	return usage.ru_maxrss / 1024; // bytes on macOS
+#else
+	return usage.ru_maxrss;
+#endif
+#endif
+}
+
+
+
+
+//! Renders a single project and prints the result as one JSON object
+int runProject(const QString& project, int threads, int frames)
+{
+	// use a private configuration, so the settings below are never written
+	// to the user's configuration file
+	QTemporaryDir workDir;
+	ConfigManager::inst()->loadConfigFile(workDir.filePath("lmmsrc.xml"));
+	ConfigManager::inst()->setValue("audioengine", "workerthreads", QString::number(threads));
+	ConfigManager::inst()->setValue("audioengine", "renderframesperperiod", QString::number(frames));
+
+	Engine::init(true);
+
+	Engine::getSong()->loadProject(project);
+	if (Engine::getSong()->isEmpty())
+	{
+		std::fprintf(stderr, "The project %s is empty or could not be loaded\n", qPrintable(project));
+		Engine::destroy();
+		return EXIT_FAILURE;
+	}
+
+	const AudioEngine::qualitySettings qs(AudioEngine::qualitySettings::Interpolation::Linear);
+	const OutputSettings os(44100, 160, OutputSettings::BitDepth::Depth16Bit,
+		OutputSettings::StereoMode::Stereo);
+	ProjectRenderer renderer(qs, os, ProjectRenderer::ExportFileFormat::Wave, workDir.filePath("render.wav"));
+	if (!renderer.isReady())
+	{
+		std::fprintf(stderr, "Could not create the output file\n");
+		Engine::destroy();
+		return EXIT_FAILURE;
+	}
+
+	AudioEngineProfiler& profiler = Engine::audioEngine()->profiler();
+	profiler.resetTotals();
+
+	QElapsedTimer timer;
+	timer.start();
+	renderer.startProcessing();
+	renderer.wait();
+	const double wallSeconds = timer.nsecsElapsed() / 1e9;
+
+	const auto& totals = profiler.totals();
+	const double audioSeconds = static_cast<double>(totals.frames) / Engine::audioEngine()->outputSampleRate();
+	const auto detailSeconds = [&totals](AudioEngineProfiler::DetailType type) {
+		return totals.detailTime[static_cast<std::size_t>(type)] / 1e6;
+	};
+
+	QJsonObject stages;
+	stages["noteSetup"] = detailSeconds(AudioEngineProfiler::DetailType::NoteSetup);
+	stages["instrumentsAndEffects"] = detailSeconds(AudioEngineProfiler::DetailType::Instruments);
+	stages["mixing"] = detailSeconds(AudioEngineProfiler::DetailType::Mixing);
+
+	QJsonObject result;
+	result["project"] = QFileInfo(project).fileName();
+	result["threads"] = threads;
+	result["framesPerPeriod"] = Engine::audioEngine()->framesPerPeriod();
+	result["sampleRate"] = static_cast<int>(Engine::audioEngine()->outputSampleRate());
+	result["audioSeconds"] = audioSeconds;
+	result["wallSeconds"] = wallSeconds;
+	result["engineSeconds"] = totals.periodTime / 1e6;
+	result["realtimeFactor"] = wallSeconds > 0 ? audioSeconds / wallSeconds : 0.;
+	result["stageSeconds"] = stages;
+
+	Engine::destroy();
+
+	// measure after tearing down, so everything the render needed is included
+	result["peakRssKiB"] = peakRss();
+
+	std::printf("%s\n", QJsonDocument(result).toJson(QJsonDocument::Compact).constData());
+	return EXIT_SUCCESS;
+}
+
+} // namespace
+
+
+
+
+int main(int argc, char** argv)
+{
+	QCoreApplication app(argc, argv);
+
+	// use the plugins and samples of the build tree unless told otherwise
+	if (qEnvironmentVariableIsEmpty("LMMS_PLUGIN_DIR"))
+	{
+		qputenv("LMMS_PLUGIN_DIR", LMMS_BENCH_PLUGIN_DIR);
+	}
+	if (qEnvironmentVariableIsEmpty("LMMS_DATA_DIR"))
+	{
+		qputenv("LMMS_DATA_DIR", LMMS_BENCH_DATA_DIR);
+	}
+
+	QString projectDir = LMMS_BENCH_PROJECT_DIR;
+	QString outputFile;
+	QString runProjectFile;
+	QList<int> threadCounts = {1, QThread::idealThreadCount()};
+	QList<int> frameCounts = {64, DEFAULT_BUFFER_SIZE};
+	int repeat = 1;
+
+	const QStringList args = app.arguments();
+	for (int i = 1; i < args.size(); ++i)
+	{
+		const QString& arg = args[i];
+		const bool hasValue = i + 1 < args.size();
+
+		if (arg == "--help" || arg == "-h")
+		{
+			printUsage();
+			return EXIT_SUCCESS;
+		}
+		else if (arg == "--projects" && hasValue)
+		{
+			projectDir = args[++i];
+		}
+		else if (arg == "--threads" && hasValue)
+		{
+			threadCounts = parseList(args[++i]);
+		}
+		else if (arg == "--frames" && hasValue)
+		{
+			frameCounts = parseList(args[++i]);
+		}
+		else if (arg == "--repeat" && hasValue)
+		{
+			repeat = std::max(args[++i].toInt(), 1);
+		}
+		else if (arg == "--output" && hasValue)
+		{
+			outputFile = args[++i];
+		}
+		else if (arg == "--run" && hasValue)
+		{
+			runProjectFile = args[++i];
+		}
+		else
+		{
+			std::fprintf(stderr, "Invalid option %s\n\n", qPrintable(arg));
+			printUsage();
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (threadCounts.isEmpty() || frameCounts.isEmpty())
+	{
+		std::fprintf(stderr, "Thread and frame counts must be lists of positive numbers\n");
+		return EXIT_FAILURE;
+	}
+
+	if (!runProjectFile.isEmpty())
+	{
+		return runProject(runProjectFile, threadCounts.front(), frameCounts.front());
+	}
+
+	const QFileInfoList projects = QDir(projectDir).entryInfoList({"*.mmp", "*.mmpz"}, QDir::Files, QDir::Name);
+	if (projects.isEmpty())
+	{
+		std::fprintf(stderr, "No projects found in %s\n", qPrintable(projectDir));
+		return EXIT_FAILURE;
+	}
+
+	QJsonArray results;
+	bool failed = false;
+
+	for (const auto& project : projects)
+	{
+		for (const int threads : threadCounts)
+		{
+			for (const int frames : frameCounts)
+			{
+				QJsonObject best;
+				for (int run = 0; run < repeat; ++run)
+				{
+					std::fprintf(stderr, "Rendering %s with %d thread(s), %d frames per period...\n",
+						qPrintable(project.fileName()), threads, frames);
+
+					QProcess child;
+					child.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+					child.start(app.applicationFilePath(), {"--run", project.absoluteFilePath(),
+						"--threads", QString::number(threads), "--frames", QString::number(frames)});
+					child.waitForFinished(-1);
+
+					const auto result = QJsonDocument::fromJson(child.readAllStandardOutput().trimmed()).object();
+					if (child.exitStatus() != QProcess::NormalExit || child.exitCode() != EXIT_SUCCESS || result.isEmpty())
+					{
+						std::fprintf(stderr, "Rendering %s failed\n", qPrintable(project.fileName()));
+						failed = true;
+						break;
+					}
+					if (best.isEmpty() || result["wallSeconds"].toDouble() < best["wallSeconds"].toDouble())
+					{
+						best = result;
+					}
+				}
+				if (!best.isEmpty())
+				{
+					results.append(best);
+				}
+			}
+		}
+	}
+
+	QJsonObject report;
+	report["version"] = LMMS_VERSION;
+	report["date"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+	report["cpuThreads"] = QThread::idealThreadCount();
+	report["results"] = results;
+
+	const QByteArray json = QJsonDocument(report).toJson();
+	if (outputFile.isEmpty())
+	{
+		std::fwrite(json.constData(), 1, json.size(), stdout);
+	}
+	else
+	{
+		QFile file(outputFile);
+		if (!file.open(QFile::WriteOnly | QFile::Truncate) || file.write(json) != json.size())
+		{
+			std::fprintf(stderr, "Could not write %s\n", qPrintable(outputFile));
+			return EXIT_FAILURE;
+		}
+	}
+
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
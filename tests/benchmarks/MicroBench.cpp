@@ -0,0 +1,912 @@
+/*
+ * MicroBench.cpp - microbenchmarks of the hot core DSP functions
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+// Each benchmark runs its function with a growing number of iterations until
+// that takes at least the minimum time, then repeats the measurement a few
+// times. The report uses the JSON layout of Google Benchmark, so its
+// tools/compare.py can compare the results of two commits.
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QThread>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "lmmsconfig.h"
+#include "lmmsversion.h"
+
+#ifdef LMMS_BUILD_WIN32
+#include <windows.h>
+#else
+#include <ctime>
+#endif
+
+#include "AudioEngine.h"
+#include "AudioEngineWorkerThread.h"
+#include "AudioResampler.h"
+#include "AutomatableModel.h"
+#include "AutomationClip.h"
+#include "AutomationTrack.h"
+#include "BasicFilters.h"
+#include "ConfigManager.h"
+#include "Engine.h"
+#include "MixHelpers.h"
+#include "Oscillator.h"
+#include "Sample.h"
+#include "SampleBuffer.h"
+#include "SampleFrame.h"
+#include "SampleThumbnail.h"
+#include "Song.h"
+#include "ThreadableJob.h"
+#include "ValueBuffer.h"
+
+using namespace lmms;
+
+namespace
+{
+
+//! Frames processed per iteration by the benchmarks of per-period functions
+constexpr int Frames = DEFAULT_BUFFER_SIZE;
+constexpr int SampleRate = 44100;
+
+
+//! Keeps the compiler from optimizing away the computation of @p value
+template<typename T>
+inline void doNotOptimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	asm volatile("" : : "r,m"(value) : "memory");
+#else
+	static const volatile void* s_sink;
+	s_sink = &value;
+#endif
+}
+
+
+
+
+//! CPU time of the calling thread in seconds
+double threadCpuSeconds()
+{
+#ifdef LMMS_BUILD_WIN32
+	FILETIME creation, exit, kernel, user;
+	GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user);
+	const auto ticks = [](const FILETIME& t) {
+		return (static_cast<std::uint64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime;
+	};
+	return (ticks(kernel) + ticks(user)) * 1e-7;
+#else
+	timespec ts;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
+
+
+
+//! Runs the benchmarked code the given number of times
+using Runner = std::function<void(std::int64_t iterations)>;
+
+struct Benchmark
+{
+	QString name;
+	//! Items, e.g. frames, processed per iteration, 0 if not meaningful
+	std::int64_t items;
+	//! Prepares the data and returns the runner, which owns it
+	std::function<Runner()> setup;
+};
+
+
+struct Measurement
+{
+	std::int64_t iterations;
+	double realNs; //!< per iteration
+	double cpuNs; //!< per iteration
+};
+
+Measurement measure(const Runner& run, std::int64_t iterations)
+{
+	const auto cpuStart = threadCpuSeconds();
+	const auto start = std::chrono::steady_clock::now();
+	run(iterations);
+	const auto real = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	const auto cpu = threadCpuSeconds() - cpuStart;
+	return {iterations, real * 1e9 / iterations, cpu * 1e9 / iterations};
+}
+
+
+
+
+std::vector<SampleFrame> noise(std::size_t frames, unsigned seed = 1)
+{
+	auto rng = std::mt19937{seed};
+	auto dist = std::uniform_real_distribution<float>{-1.f, 1.f};
+	auto result = std::vector<SampleFrame>(frames);
+	for (auto& frame : result)
+	{
+		frame = SampleFrame(dist(rng), dist(rng));
+	}
+	return result;
+}
+
+
+
+
+const char* simdLevelName(MixHelpers::SimdLevel level)
+{
+	switch (level)
+	{
+		case MixHelpers::SimdLevel::Scalar: return "scalar";
+		case MixHelpers::SimdLevel::Sse2: return "sse2";
+		case MixHelpers::SimdLevel::Avx2: return "avx2";
+		case MixHelpers::SimdLevel::Neon: return "neon";
+	}
+	return "unknown";
+}
+
+
+void addMixHelpers(std::vector<Benchmark>& benchmarks)
+{
+	struct Data
+	{
+		std::vector<SampleFrame> dst = noise(Frames, 1);
+		std::vector<SampleFrame> src = noise(Frames, 2);
+		ValueBuffer coeffs1{Frames};
+		ValueBuffer coeffs2{Frames};
+	};
+
+	using Kernel = std::function<void(Data&)>;
+	const std::pair<const char*, Kernel> kernels[] = {
+		{"isSilent", [](Data& d) { doNotOptimize(MixHelpers::isSilent(d.src.data(), Frames)); }},
+		{"sanitize", [](Data& d) { doNotOptimize(MixHelpers::sanitize(d.dst.data(), Frames)); }},
+		{"add", [](Data& d) { MixHelpers::add(d.dst.data(), d.src.data(), Frames); }},
+		{"multiply", [](Data& d) { MixHelpers::multiply(d.dst.data(), 0.5f, Frames); }},
+		{"addMultiplied", [](Data& d) { MixHelpers::addMultiplied(d.dst.data(), d.src.data(), 0.5f, Frames); }},
+		{"addMultipliedByBuffer", [](Data& d) {
+			MixHelpers::addMultipliedByBuffer(d.dst.data(), d.src.data(), 0.5f, &d.coeffs1, Frames);
+		}},
+		{"addMultipliedByBuffers", [](Data& d) {
+			MixHelpers::addMultipliedByBuffers(d.dst.data(), d.src.data(), &d.coeffs1, &d.coeffs2, Frames);
+		}},
+		{"addSanitizedMultiplied", [](Data& d) {
+			MixHelpers::addSanitizedMultiplied(d.dst.data(), d.src.data(), 0.5f, Frames);
+		}},
+		{"multiplyAndAddMultiplied", [](Data& d) {
+			MixHelpers::multiplyAndAddMultiplied(d.dst.data(), d.src.data(), 0.5f, 0.5f, Frames);
+		}},
+		{"levels", [](Data& d) {
+			auto peak = SampleFrame{};
+			auto squares = SampleFrame{};
+			MixHelpers::levels(d.src.data(), Frames, peak, squares);
+			doNotOptimize(peak);
+			doNotOptimize(squares);
+		}},
+	};
+
+	const auto best = MixHelpers::simdLevel();
+	for (const auto level : {MixHelpers::SimdLevel::Scalar, MixHelpers::SimdLevel::Sse2,
+		MixHelpers::SimdLevel::Avx2, MixHelpers::SimdLevel::Neon})
+	{
+		if (!MixHelpers::setSimdLevel(level)) { continue; }
+
+		for (const auto& [name, kernel] : kernels)
+		{
+			benchmarks.push_back({QString("MixHelpers/%1/%2").arg(name, simdLevelName(level)), Frames,
+				[level, best, kernel = kernel] {
+					auto data = std::make_shared<Data>();
+					// a ramp, so the buffers aren't marked as constant
+					data->coeffs1.interpolate(0.f, 1.f);
+					data->coeffs2.interpolate(1.f, 0.f);
+					return Runner{[level, best, kernel, data](std::int64_t iterations) {
+						MixHelpers::setSimdLevel(level);
+						for (std::int64_t i = 0; i < iterations; ++i)
+						{
+							kernel(*data);
+							// keep the values from growing out of range
+							if ((i & 0xff) == 0xff) { data->dst = data->src; }
+						}
+						MixHelpers::setSimdLevel(best);
+					}};
+				}});
+		}
+	}
+	MixHelpers::setSimdLevel(best);
+}
+
+
+
+
+const char* waveShapeName(Oscillator::WaveShape shape)
+{
+	switch (shape)
+	{
+		case Oscillator::WaveShape::Sine: return "Sine";
+		case Oscillator::WaveShape::Triangle: return "Triangle";
+		case Oscillator::WaveShape::Saw: return "Saw";
+		case Oscillator::WaveShape::Square: return "Square";
+		case Oscillator::WaveShape::MoogSaw: return "MoogSaw";
+		case Oscillator::WaveShape::Exponential: return "Exponential";
+		case Oscillator::WaveShape::WhiteNoise: return "WhiteNoise";
+		case Oscillator::WaveShape::UserDefined: return "UserDefined";
+		default: return "unknown";
+	}
+}
+
+const char* modulationAlgoName(Oscillator::ModulationAlgo algo)
+{
+	switch (algo)
+	{
+		case Oscillator::ModulationAlgo::PhaseModulation: return "PhaseModulation";
+		case Oscillator::ModulationAlgo::AmplitudeModulation: return "AmplitudeModulation";
+		case Oscillator::ModulationAlgo::SignalMix: return "SignalMix";
+		case Oscillator::ModulationAlgo::SynchronizedBySubOsc: return "SynchronizedBySubOsc";
+		case Oscillator::ModulationAlgo::FrequencyModulation: return "FrequencyModulation";
+		default: return "unknown";
+	}
+}
+
+
+//! Two oscillators with the parameters TripleOscillator would pass
+struct OscillatorPair
+{
+	OscillatorPair(Oscillator::WaveShape shape, Oscillator::ModulationAlgo algo) :
+		shapeModel(static_cast<int>(shape), 0, Oscillator::NumWaveShapes - 1),
+		subShapeModel(static_cast<int>(Oscillator::WaveShape::Sine), 0, Oscillator::NumWaveShapes - 1),
+		algoModel(static_cast<int>(algo), 0, Oscillator::NumModulationAlgos - 1),
+		detuning(1.f / Engine::audioEngine()->outputSampleRate())
+	{
+		Oscillator::prepareWaveTable(shape);
+
+		auto sub = new Oscillator(&subShapeModel, &algoModel, frequency, detuning, phaseOffset, volume);
+		sub->setUseWaveTable(true);
+		oscillator = std::make_unique<Oscillator>(&shapeModel, &algoModel, frequency, detuning, phaseOffset,
+			volume, sub);
+		oscillator->setUseWaveTable(true);
+
+		if (shape == Oscillator::WaveShape::UserDefined)
+		{
+			// a single cycle of a saw
+			auto cycle = std::vector<SampleFrame>(256);
+			for (std::size_t f = 0; f < cycle.size(); ++f)
+			{
+				const float value = 2.f * f / cycle.size() - 1.f;
+				cycle[f] = SampleFrame(value, value);
+			}
+			const auto wave = std::make_shared<const SampleBuffer>(std::move(cycle), SampleRate);
+			oscillator->setUserWave(wave);
+			oscillator->setUserAntiAliasWaveTable(Oscillator::generateAntiAliasUserWaveTable(wave.get()));
+		}
+	}
+
+	IntModel shapeModel;
+	IntModel subShapeModel;
+	IntModel algoModel;
+	float frequency = 440.f;
+	float detuning;
+	float phaseOffset = 0.f;
+	float volume = 1.f;
+	std::unique_ptr<Oscillator> oscillator;
+	std::vector<SampleFrame> buffer = std::vector<SampleFrame>(Frames);
+};
+
+
+void addOscillator(std::vector<Benchmark>& benchmarks)
+{
+	const auto add = [&benchmarks](const QString& name, Oscillator::WaveShape shape, Oscillator::ModulationAlgo algo,
+		bool modulated) {
+		benchmarks.push_back({name, Frames, [shape, algo, modulated] {
+			auto pair = std::make_shared<OscillatorPair>(shape, algo);
+			if (!modulated)
+			{
+				// update() only runs the sub oscillator if there is one
+				pair->oscillator = std::make_unique<Oscillator>(&pair->shapeModel, &pair->algoModel,
+					pair->frequency, pair->detuning, pair->phaseOffset, pair->volume);
+				pair->oscillator->setUseWaveTable(true);
+			}
+			return Runner{[pair](std::int64_t iterations) {
+				for (std::int64_t i = 0; i < iterations; ++i)
+				{
+					pair->oscillator->update(pair->buffer.data(), Frames, 0);
+				}
+				doNotOptimize(pair->buffer.front());
+			}};
+		}});
+	};
+
+	for (std::size_t s = 0; s < Oscillator::NumWaveShapes; ++s)
+	{
+		const auto shape = static_cast<Oscillator::WaveShape>(s);
+		add(QString("Oscillator/update/%1").arg(waveShapeName(shape)), shape,
+			Oscillator::ModulationAlgo::SignalMix, false);
+	}
+	for (std::size_t a = 0; a < Oscillator::NumModulationAlgos; ++a)
+	{
+		const auto algo = static_cast<Oscillator::ModulationAlgo>(a);
+		add(QString("Oscillator/modulated/%1").arg(modulationAlgoName(algo)), Oscillator::WaveShape::Saw, algo,
+			true);
+	}
+}
+
+
+
+
+void addBasicFilters(std::vector<Benchmark>& benchmarks)
+{
+	using FilterType = BasicFilters<>::FilterType;
+	const std::pair<const char*, FilterType> types[] = {
+		{"LowPass", FilterType::LowPass},
+		{"Moog", FilterType::Moog},
+		{"DoubleLowPass", FilterType::DoubleLowPass},
+		{"Lowpass_RC24", FilterType::Lowpass_RC24},
+		{"Formantfilter", FilterType::Formantfilter},
+		{"Lowpass_SV", FilterType::Lowpass_SV},
+		{"Tripole", FilterType::Tripole},
+	};
+
+	for (const auto& [name, type] : types)
+	{
+		struct Data
+		{
+			BasicFilters<> filter{SampleRate};
+			std::vector<SampleFrame> input = noise(Frames);
+			std::vector<SampleFrame> buffer = std::vector<SampleFrame>(Frames);
+		};
+
+		const auto setup = [type = type] {
+			auto data = std::make_shared<Data>();
+			data->filter.setFilterType(type);
+			data->filter.calcFilterCoeffs(2000.f, 0.7f);
+			return data;
+		};
+
+		// per sample, as most instruments call it
+		benchmarks.push_back({QString("BasicFilters/update/%1").arg(name), Frames, [setup] {
+			return Runner{[data = setup()](std::int64_t iterations) {
+				for (std::int64_t i = 0; i < iterations; ++i)
+				{
+					for (int f = 0; f < Frames; ++f)
+					{
+						for (ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+						{
+							data->buffer[f][ch] = data->filter.update(data->input[f][ch], ch);
+						}
+					}
+				}
+				doNotOptimize(data->buffer.front());
+			}};
+		}});
+
+		benchmarks.push_back({QString("BasicFilters/process/%1").arg(name), Frames, [setup] {
+			return Runner{[data = setup()](std::int64_t iterations) {
+				for (std::int64_t i = 0; i < iterations; ++i)
+				{
+					data->buffer = data->input;
+					data->filter.process(data->buffer.front().data(), Frames);
+				}
+				doNotOptimize(data->buffer.front());
+			}};
+		}});
+	}
+}
+
+
+
+
+void addResampling(std::vector<Benchmark>& benchmarks)
+{
+	const std::pair<const char*, int> modes[] = {
+		{"ZeroOrderHold", SRC_ZERO_ORDER_HOLD},
+		{"Linear", SRC_LINEAR},
+		{"SincFastest", SRC_SINC_FASTEST},
+	};
+
+	// a fifth up, so the ratio isn't trivial
+	constexpr double Ratio = 2. / 3.;
+
+	for (const auto& [name, mode] : modes)
+	{
+		benchmarks.push_back({QString("AudioResampler/resample/%1").arg(name), Frames, [mode = mode] {
+			struct Data
+			{
+				Data(int mode) : resampler(mode, DEFAULT_CHANNELS) {}
+
+				AudioResampler resampler;
+				std::vector<SampleFrame> input = noise(SampleRate);
+				std::vector<SampleFrame> output = std::vector<SampleFrame>(Frames);
+				long position = 0;
+			};
+			auto data = std::make_shared<Data>(mode);
+			return Runner{[data](std::int64_t iterations) {
+				const auto inputSize = static_cast<long>(data->input.size());
+				for (std::int64_t i = 0; i < iterations; ++i)
+				{
+					if (data->position + 2 * Frames > inputSize) { data->position = 0; }
+					const auto result = data->resampler.resample(data->input[data->position].data(),
+						inputSize - data->position, data->output.front().data(), Frames, Ratio);
+					data->position += result.inputFramesUsed;
+				}
+				doNotOptimize(data->output.front());
+			}};
+		}});
+
+		// the frequency of the played note differs from the one of the sample
+		benchmarks.push_back({QString("Sample/play/%1").arg(name), Frames, [mode = mode] {
+			struct Data
+			{
+				Data(int mode) : state(false, mode) {}
+
+				Sample sample{noise(10 * SampleRate).data(), 10 * SampleRate, SampleRate};
+				Sample::PlaybackState state;
+				std::vector<SampleFrame> output = std::vector<SampleFrame>(Frames);
+			};
+			auto data = std::make_shared<Data>(mode);
+			return Runner{[data](std::int64_t iterations) {
+				for (std::int64_t i = 0; i < iterations; ++i)
+				{
+					data->sample.play(data->output.data(), &data->state, Frames, DefaultBaseFreq * 1.5f,
+						Sample::Loop::On);
+				}
+				doNotOptimize(data->output.front());
+			}};
+		}});
+	}
+
+	benchmarks.push_back({"Sample/play/Unpitched", Frames, [] {
+		struct Data
+		{
+			Sample sample{noise(10 * SampleRate).data(), 10 * SampleRate, SampleRate};
+			Sample::PlaybackState state;
+			std::vector<SampleFrame> output = std::vector<SampleFrame>(Frames);
+		};
+		auto data = std::make_shared<Data>();
+		return Runner{[data](std::int64_t iterations) {
+			for (std::int64_t i = 0; i < iterations; ++i)
+			{
+				data->sample.play(data->output.data(), &data->state, Frames, DefaultBaseFreq, Sample::Loop::On);
+			}
+			doNotOptimize(data->output.front());
+		}};
+	}});
+}
+
+
+
+
+void addSampleThumbnail(std::vector<Benchmark>& benchmarks)
+{
+	// short enough to be generated on the calling thread, and without a
+	// file, so the thumbnail isn't taken from the cache
+	constexpr int ThumbnailFrames = 10 * SampleRate;
+	benchmarks.push_back({"SampleThumbnail/construct/10s", ThumbnailFrames, [] {
+		auto sample = std::make_shared<Sample>(noise(ThumbnailFrames).data(), ThumbnailFrames, SampleRate);
+		return Runner{[sample](std::int64_t iterations) {
+			for (std::int64_t i = 0; i < iterations; ++i)
+			{
+				const auto thumbnail = SampleThumbnail{*sample};
+				doNotOptimize(thumbnail);
+			}
+		}};
+	}});
+}
+
+
+
+
+void addAutomation(std::vector<Benchmark>& benchmarks)
+{
+	constexpr int Nodes = 1000;
+	constexpr int Lookups = 256;
+
+	const std::pair<const char*, AutomationClip::ProgressionType> progressions[] = {
+		{"Discrete", AutomationClip::ProgressionType::Discrete},
+		{"Linear", AutomationClip::ProgressionType::Linear},
+		{"CubicHermite", AutomationClip::ProgressionType::CubicHermite},
+	};
+
+	for (const auto& [name, progression] : progressions)
+	{
+		benchmarks.push_back({QString("AutomationClip/valueAt/%1").arg(name), Lookups, [progression = progression] {
+			struct Data
+			{
+				AutomationClip clip{nullptr};
+				std::vector<TimePos> times;
+			};
+			auto data = std::make_shared<Data>();
+
+			auto rng = std::mt19937{1};
+			auto dist = std::uniform_real_distribution<float>{0.f, 1.f};
+			auto values = std::vector<std::pair<TimePos, float>>{};
+			for (int n = 0; n < Nodes; ++n)
+			{
+				values.emplace_back(TimePos(n * 12), dist(rng));
+			}
+			data->clip.putValues(values);
+			data->clip.setProgressionType(progression);
+
+			for (int l = 0; l < Lookups; ++l)
+			{
+				data->times.emplace_back(static_cast<int>(dist(rng) * Nodes * 12));
+			}
+
+			return Runner{[data](std::int64_t iterations) {
+				for (std::int64_t i = 0; i < iterations; ++i)
+				{
+					for (const auto& time : data->times)
+					{
+						doNotOptimize(data->clip.valueAt(time));
+					}
+				}
+			}};
+		}});
+	}
+}
+
+
+
+
+void addClipsInRange(std::vector<Benchmark>& benchmarks)
+{
+	constexpr int Clips = 2000;
+	constexpr int Queries = 64;
+
+	benchmarks.push_back({"Track/getClipsInRange/2000clips", Queries, [] {
+		struct Data
+		{
+			AutomationTrack track{Engine::getSong()};
+			std::vector<std::pair<TimePos, TimePos>> ranges;
+			Track::clipVector found;
+		};
+		auto data = std::make_shared<Data>();
+
+		auto rng = std::mt19937{1};
+		auto position = std::uniform_int_distribution<int>{0, Clips * DefaultTicksPerBar};
+		for (int c = 0; c < Clips; ++c)
+		{
+			auto clip = data->track.createClip(TimePos(position(rng)));
+			clip->changeLength(TimePos(DefaultTicksPerBar));
+		}
+		for (int q = 0; q < Queries; ++q)
+		{
+			const auto start = TimePos(position(rng));
+			data->ranges.emplace_back(start, start + 4 * DefaultTicksPerBar);
+		}
+
+		return Runner{[data](std::int64_t iterations) {
+			for (std::int64_t i = 0; i < iterations; ++i)
+			{
+				for (const auto& [start, end] : data->ranges)
+				{
+					data->found.clear();
+					data->track.getClipsInRange(data->found, start, end);
+					doNotOptimize(data->found.size());
+				}
+			}
+		}};
+	}});
+}
+
+
+
+
+void addJobQueue(std::vector<Benchmark>& benchmarks)
+{
+	//! Does a little work, like a small mixer channel
+	class Job : public ThreadableJob
+	{
+	public:
+		bool requiresProcessing() const override { return true; }
+
+	protected:
+		void doProcessing() override
+		{
+			for (auto& frame : m_frames)
+			{
+				frame *= 0.5f;
+			}
+		}
+
+	private:
+		std::vector<SampleFrame> m_frames = noise(64);
+	};
+
+	for (const int count : {16, 256})
+	{
+		benchmarks.push_back({QString("AudioEngineWorkerThread/jobQueue/%1jobs").arg(count), count, [count] {
+			auto jobs = std::make_shared<std::vector<std::unique_ptr<Job>>>();
+			auto pointers = std::make_shared<std::vector<ThreadableJob*>>();
+			for (int j = 0; j < count; ++j)
+			{
+				jobs->push_back(std::make_unique<Job>());
+				pointers->push_back(jobs->back().get());
+			}
+
+			return Runner{[jobs, pointers](std::int64_t iterations) {
+				for (std::int64_t i = 0; i < iterations; ++i)
+				{
+					for (auto job : *pointers) { job->reset(); }
+					AudioEngineWorkerThread::fillJobQueue(*pointers);
+					AudioEngineWorkerThread::startAndWaitForJobs();
+				}
+			}};
+		}});
+	}
+}
+
+
+
+
+std::vector<Benchmark> allBenchmarks()
+{
+	auto benchmarks = std::vector<Benchmark>{};
+	addMixHelpers(benchmarks);
+	addOscillator(benchmarks);
+	addBasicFilters(benchmarks);
+	addResampling(benchmarks);
+	addSampleThumbnail(benchmarks);
+	addAutomation(benchmarks);
+	addClipsInRange(benchmarks);
+	addJobQueue(benchmarks);
+	return benchmarks;
+}
+
+
+
+
+QJsonObject runJson(const QString& name, const QString& runName, const Measurement& m, std::int64_t items,
+	int repetitions, int repetitionIndex)
+{
+	QJsonObject result;
+	result["name"] = name;
+	result["run_name"] = runName;
+	result["run_type"] = "iteration";
+	result["repetitions"] = repetitions;
+	result["repetition_index"] = repetitionIndex;
+	result["threads"] = 1;
+	result["iterations"] = static_cast<qint64>(m.iterations);
+	result["real_time"] = m.realNs;
+	result["cpu_time"] = m.cpuNs;
+	result["time_unit"] = "ns";
+	if (items > 0)
+	{
+		result["items_per_second"] = items * 1e9 / m.realNs;
+	}
+	return result;
+}
+
+
+QJsonObject aggregateJson(const QString& runName, const char* aggregate, double realNs, double cpuNs,
+	std::int64_t iterations, int repetitions)
+{
+	QJsonObject result;
+	result["name"] = QString("%1_%2").arg(runName, aggregate);
+	result["run_name"] = runName;
+	result["run_type"] = "aggregate";
+	result["repetitions"] = repetitions;
+	result["threads"] = 1;
+	result["aggregate_name"] = aggregate;
+	result["iterations"] = static_cast<qint64>(iterations);
+	result["real_time"] = realNs;
+	result["cpu_time"] = cpuNs;
+	result["time_unit"] = "ns";
+	return result;
+}
+
+
+double median(std::vector<double> values)
+{
+	std::sort(values.begin(), values.end());
+	const auto mid = values.size() / 2;
+	return values.size() % 2 ? values[mid] : (values[mid - 1] + values[mid]) / 2;
+}
+
+
+
+
+void printUsage()
+{
+	std::printf("Usage: lmms-microbench [options]\n\n"
+		"  --filter <regex>         Only run the benchmarks whose name matches <regex>\n"
+		"  --list                   List the benchmarks and exit\n"
+		"  --min-time <seconds>     Minimum time of each measurement\n"
+		"          Default: 0.2\n"
+		"  --repetitions <n>        Measure every benchmark <n> times\n"
+		"          Default: 5\n"
+		"  --output <file>          Write the JSON report to <file> instead of stdout\n"
+		"  -h, --help               Show this usage information and exit\n\n");
+}
+
+} // namespace
+
+
+
+
+int main(int argc, char** argv)
+{
+	QCoreApplication app(argc, argv);
+
+	if (qEnvironmentVariableIsEmpty("LMMS_PLUGIN_DIR"))
+	{
+		qputenv("LMMS_PLUGIN_DIR", LMMS_BENCH_PLUGIN_DIR);
+	}
+	if (qEnvironmentVariableIsEmpty("LMMS_DATA_DIR"))
+	{
+		qputenv("LMMS_DATA_DIR", LMMS_BENCH_DATA_DIR);
+	}
+
+	QString filter;
+	QString outputFile;
+	bool list = false;
+	double minTime = 0.2;
+	int repetitions = 5;
+
+	const QStringList args = app.arguments();
+	for (int i = 1; i < args.size(); ++i)
+	{
+		const QString& arg = args[i];
+		const bool hasValue = i + 1 < args.size();
+
+		if (arg == "--help" || arg == "-h")
+		{
+			printUsage();
+			return EXIT_SUCCESS;
+		}
+		else if (arg == "--filter" && hasValue)
+		{
+			filter = args[++i];
+		}
+		else if (arg == "--list")
+		{
+			list = true;
+		}
+		else if (arg == "--min-time" && hasValue)
+		{
+			minTime = std::max(args[++i].toDouble(), 0.001);
+		}
+		else if (arg == "--repetitions" && hasValue)
+		{
+			repetitions = std::max(args[++i].toInt(), 1);
+		}
+		else if (arg == "--output" && hasValue)
+		{
+			outputFile = args[++i];
+		}
+		else
+		{
+			std::fprintf(stderr, "Invalid option %s\n\n", qPrintable(arg));
+			printUsage();
+			return EXIT_FAILURE;
+		}
+	}
+
+	const auto filterExpression = QRegularExpression(filter);
+	if (!filterExpression.isValid())
+	{
+		std::fprintf(stderr, "Invalid filter %s\n", qPrintable(filter));
+		return EXIT_FAILURE;
+	}
+
+	auto benchmarks = allBenchmarks();
+	benchmarks.erase(std::remove_if(benchmarks.begin(), benchmarks.end(),
+		[&](const Benchmark& b) { return !filterExpression.match(b.name).hasMatch(); }), benchmarks.end());
+
+	if (list)
+	{
+		for (const auto& benchmark : benchmarks)
+		{
+			std::printf("%s\n", qPrintable(benchmark.name));
+		}
+		return EXIT_SUCCESS;
+	}
+
+	// use a private configuration, so the user's one is neither read nor written
+	QTemporaryDir workDir;
+	ConfigManager::inst()->loadConfigFile(workDir.filePath("lmmsrc.xml"));
+	Engine::init(true);
+
+	std::fprintf(stderr, "%-56s %14s %14s %12s\n", "Benchmark", "Time", "CPU", "Iterations");
+
+	QJsonArray results;
+	for (const auto& benchmark : benchmarks)
+	{
+		const Runner run = benchmark.setup();
+
+		// warm up, then find an iteration count taking at least minTime
+		auto m = measure(run, 1);
+		std::int64_t iterations = 1;
+		while (m.realNs * iterations < minTime * 1e9 && iterations < 1'000'000'000)
+		{
+			const double needed = minTime * 1e9 / std::max(m.realNs, 1.) * 1.4;
+			iterations = std::clamp<std::int64_t>(static_cast<std::int64_t>(needed), iterations * 2,
+				iterations * 100);
+			m = measure(run, iterations);
+		}
+
+		auto realTimes = std::vector<double>{};
+		auto cpuTimes = std::vector<double>{};
+		for (int r = 0; r < repetitions; ++r)
+		{
+			m = measure(run, iterations);
+			realTimes.push_back(m.realNs);
+			cpuTimes.push_back(m.cpuNs);
+			results.append(runJson(benchmark.name, benchmark.name, m, benchmark.items, repetitions, r));
+		}
+
+		const double realMedian = median(realTimes);
+		const double cpuMedian = median(cpuTimes);
+		if (repetitions > 1)
+		{
+			results.append(aggregateJson(benchmark.name, "median", realMedian, cpuMedian, iterations, repetitions));
+		}
+
+		std::fprintf(stderr, "%-56s %11.1f ns %11.1f ns %12lld\n", qPrintable(benchmark.name), realMedian,
+			cpuMedian, static_cast<long long>(iterations));
+	}
+
+	Engine::destroy();
+
+	QJsonObject context;
+	context["date"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+	context["host_name"] = QSysInfo::machineHostName();
+	context["executable"] = app.applicationFilePath();
+	context["num_cpus"] = QThread::idealThreadCount();
+	context["library_build_type"] = LMMS_MICROBENCH_BUILD_TYPE;
+	context["lmms_version"] = LMMS_VERSION;
+	context["simd_level"] = simdLevelName(MixHelpers::bestSimdLevel());
+
+	QJsonObject report;
+	report["context"] = context;
+	report["benchmarks"] = results;
+
+	const QByteArray json = QJsonDocument(report).toJson();
+	if (outputFile.isEmpty())
+	{
+		std::fwrite(json.constData(), 1, json.size(), stdout);
+	}
+	else
+	{
+		QFile file(outputFile);
+		if (!file.open(QFile::WriteOnly | QFile::Truncate) || file.write(json) != json.size())
+		{
+			std::fprintf(stderr, "Could not write %s\n", qPrintable(outputFile));
+			return EXIT_FAILURE;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,714 @@
+/*
+ * PluginBench.cpp - renders every instrument and effect with a fixed stimulus
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+// Every plugin is rendered in a child process of its own for each sample rate
+// and period size, so a crashing or hanging plugin only fails its own entry.
+//
+// Instruments play a chord and a run of short notes through the audio engine,
+// which renders on the calling thread only. Their time per period includes
+// the engine's work for the one track. Effects process a sweep and a noise
+// burst followed by silence through an effect chain of their own.
+//
+// Each plugin is rendered twice by fresh instances; the output of both has to
+// be identical. Allocations through operator new on the rendering thread are
+// counted during the second run, so one-time initialization shared between
+// instances doesn't show up. Allocations of plugins loaded as DLLs aren't
+// seen on Windows, and neither are direct calls to malloc().
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QRegularExpression>
+#include <QTemporaryDir>
+#include <QThread>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <vector>
+
+#include "lmmsconfig.h"
+#include "lmmsversion.h"
+
+#include "AudioDevice.h"
+#include "AudioEngine.h"
+#include "ConfigManager.h"
+#include "DummyInstrument.h"
+#include "Effect.h"
+#include "EffectChain.h"
+#include "Engine.h"
+#include "InstrumentTrack.h"
+#include "MidiEvent.h"
+#include "MixHelpers.h"
+#include "PluginFactory.h"
+#include "SampleFrame.h"
+#include "Song.h"
+
+#ifdef LMMS_BUILD_WIN32
+#include <malloc.h>
+#endif
+
+
+namespace
+{
+
+thread_local bool t_countAllocations = false;
+thread_local std::uint64_t t_allocations = 0;
+
+void* allocate(std::size_t size)
+{
+	if (t_countAllocations) { ++t_allocations; }
+	return std::malloc(size > 0 ? size : 1);
+}
+
+void* allocateAligned(std::size_t size, std::align_val_t alignment)
+{
+	if (t_countAllocations) { ++t_allocations; }
+	const auto align = std::max(static_cast<std::size_t>(alignment), sizeof(void*));
+#ifdef LMMS_BUILD_WIN32
+	return _aligned_malloc(size > 0 ? size : 1, align);
+#else
+	void* p = nullptr;
+	return posix_memalign(&p, align, size > 0 ? size : 1) == 0 ? p : nullptr;
+#endif
+}
+
+void freeAligned(void* p) noexcept
+{
+#ifdef LMMS_BUILD_WIN32
+	_aligned_free(p);
+#else
+	std::free(p);
+#endif
+}
+
+} // namespace
+
+
+// counting versions of the replaceable allocation functions
+void* operator new(std::size_t size)
+{
+	if (void* p = allocate(size)) { return p; }
+	throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t size)
+{
+	if (void* p = allocate(size)) { return p; }
+	throw std::bad_alloc{};
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+	if (void* p = allocateAligned(size, alignment)) { return p; }
+	throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+	if (void* p = allocateAligned(size, alignment)) { return p; }
+	throw std::bad_alloc{};
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return allocateAligned(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return allocateAligned(size, alignment);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { freeAligned(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { freeAligned(p); }
+
+
+
+
+using namespace lmms;
+
+namespace
+{
+
+//! Seconds of the stimulus, including the release tail
+constexpr double InstrumentSeconds = 3.;
+constexpr double EffectSeconds = 3.;
+//! A child taking longer than this is considered hanging
+constexpr int TimeoutMs = 5 * 60 * 1000;
+
+
+//! Lets the engine render on demand on the calling thread
+class BenchDevice : public AudioDevice
+{
+public:
+	BenchDevice(sample_rate_t sampleRate, AudioEngine* audioEngine) :
+		AudioDevice(DEFAULT_CHANNELS, audioEngine)
+	{
+		setSampleRate(sampleRate);
+	}
+};
+
+
+
+
+struct NoteEvent
+{
+	f_cnt_t frame;
+	int key;
+	bool on;
+};
+
+//! A held chord followed by a run of short notes
+std::vector<NoteEvent> instrumentStimulus(sample_rate_t sampleRate)
+{
+	const auto at = [sampleRate](double seconds) { return static_cast<f_cnt_t>(seconds * sampleRate); };
+
+	auto events = std::vector<NoteEvent>{};
+	for (const int key : {60, 64, 67})
+	{
+		events.push_back({at(0.), key, true});
+		events.push_back({at(1.), key, false});
+	}
+	for (int n = 0; n < 8; ++n)
+	{
+		const double start = 1.5 + n * 0.125;
+		events.push_back({at(start), 48 + 2 * n, true});
+		events.push_back({at(start + 0.0625), 48 + 2 * n, false});
+	}
+
+	std::stable_sort(events.begin(), events.end(),
+		[](const NoteEvent& a, const NoteEvent& b) { return a.frame < b.frame; });
+	return events;
+}
+
+
+//! A sine sweep and a noise burst, followed by silence for the tail
+std::vector<SampleFrame> effectStimulus(sample_rate_t sampleRate)
+{
+	auto frames = std::vector<SampleFrame>(static_cast<std::size_t>(EffectSeconds * sampleRate));
+
+	const auto sweepFrames = static_cast<std::size_t>(sampleRate);
+	double phase = 0.;
+	for (std::size_t f = 0; f < sweepFrames; ++f)
+	{
+		const double frequency = 100. * std::pow(50., static_cast<double>(f) / sweepFrames);
+		phase += 2. * 3.14159265358979 * frequency / sampleRate;
+		const auto value = static_cast<float>(0.5 * std::sin(phase));
+		frames[f] = SampleFrame(value, value);
+	}
+
+	auto rng = std::mt19937{1};
+	auto dist = std::uniform_real_distribution<float>{-0.25f, 0.25f};
+	for (std::size_t f = sweepFrames; f < sweepFrames + sweepFrames / 2; ++f)
+	{
+		frames[f] = SampleFrame(dist(rng), dist(rng));
+	}
+	return frames;
+}
+
+
+
+
+struct RunStats
+{
+	void add(double us, std::uint64_t allocations)
+	{
+		++periods;
+		totalUs += us;
+		maxUs = std::max(maxUs, us);
+		this->allocations += allocations;
+		allocatingPeriods += allocations > 0;
+	}
+
+	int periods = 0;
+	double totalUs = 0.;
+	double maxUs = 0.;
+	std::uint64_t allocations = 0;
+	int allocatingPeriods = 0;
+	QByteArray hash;
+};
+
+template<typename F>
+double timedUs(F&& render, std::uint64_t& allocations)
+{
+	t_allocations = 0;
+	t_countAllocations = true;
+	const auto start = std::chrono::steady_clock::now();
+	render();
+	const auto end = std::chrono::steady_clock::now();
+	t_countAllocations = false;
+	allocations = t_allocations;
+	return std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+
+
+
+RunStats renderInstrument(InstrumentTrack* track)
+{
+	AudioEngine* engine = Engine::audioEngine();
+	const fpp_t frames = engine->framesPerPeriod();
+	const auto events = instrumentStimulus(engine->outputSampleRate());
+	const auto totalFrames = static_cast<f_cnt_t>(InstrumentSeconds * engine->outputSampleRate());
+
+	auto stats = RunStats{};
+	auto hash = QCryptographicHash{QCryptographicHash::Sha1};
+	auto next = events.begin();
+	for (f_cnt_t frame = 0; frame < totalFrames; frame += frames)
+	{
+		for (; next != events.end() && next->frame < frame + frames; ++next)
+		{
+			track->processInEvent(MidiEvent(next->on ? MidiNoteOn : MidiNoteOff, 0, next->key, next->on ? 100 : 0));
+		}
+
+		const SampleFrame* output = nullptr;
+		std::uint64_t allocations = 0;
+		const double us = timedUs([&] { output = engine->nextBuffer(); }, allocations);
+		stats.add(us, allocations);
+		hash.addData(reinterpret_cast<const char*>(output), static_cast<int>(frames * sizeof(SampleFrame)));
+	}
+
+	// leave nothing behind for the next instance
+	track->silenceAllNotes(true);
+	for (int i = 0; i < 4; ++i) { engine->nextBuffer(); }
+
+	stats.hash = hash.result().toHex();
+	return stats;
+}
+
+
+//! Returns false if the effect couldn't be loaded
+bool renderEffect(const QString& plugin, RunStats& stats)
+{
+	const fpp_t frames = Engine::audioEngine()->framesPerPeriod();
+	const auto stimulus = effectStimulus(Engine::audioEngine()->outputSampleRate());
+
+	// the chain deletes the effect
+	EffectChain chain(nullptr);
+	Effect* effect = Effect::instantiate(plugin, &chain, nullptr);
+	if (!effect) { return false; }
+	chain.appendEffect(effect);
+
+	auto hash = QCryptographicHash{QCryptographicHash::Sha1};
+	auto buffer = std::vector<SampleFrame>(frames);
+	for (std::size_t frame = 0; frame < stimulus.size(); frame += frames)
+	{
+		const auto count = std::min<std::size_t>(frames, stimulus.size() - frame);
+		std::fill(std::copy_n(stimulus.begin() + frame, count, buffer.begin()), buffer.end(), SampleFrame{});
+
+		// as the mixer does, effects are only woken up by input
+		const bool hasInput = !MixHelpers::isSilent(buffer.data(), frames);
+		if (hasInput) { chain.startRunning(); }
+
+		std::uint64_t allocations = 0;
+		const double us = timedUs([&] { chain.processAudioBuffer(buffer.data(), frames, hasInput); }, allocations);
+		stats.add(us, allocations);
+		hash.addData(reinterpret_cast<const char*>(buffer.data()), static_cast<int>(frames * sizeof(SampleFrame)));
+	}
+
+	stats.hash = hash.result().toHex();
+	return true;
+}
+
+
+
+
+//! Renders one plugin twice and prints the result as one JSON object
+int runPlugin(const QString& plugin, Plugin::Type type, sample_rate_t sampleRate, fpp_t frames)
+{
+	// use a private configuration, so the settings below are never written
+	// to the user's configuration file
+	QTemporaryDir workDir;
+	ConfigManager::inst()->loadConfigFile(workDir.filePath("lmmsrc.xml"));
+	// render everything on the calling thread, where allocations are counted
+	ConfigManager::inst()->setValue("audioengine", "workerthreads", "1");
+	ConfigManager::inst()->setValue("audioengine", "renderframesperperiod", QString::number(frames));
+
+	Engine::init(true);
+
+	AudioEngine* engine = Engine::audioEngine();
+	engine->setAudioDevice(new BenchDevice(sampleRate, engine), engine->currentQualitySettings(), false, false);
+
+	QJsonObject result;
+	result["plugin"] = plugin;
+	result["type"] = type == Plugin::Type::Instrument ? "instrument" : "effect";
+	result["sampleRate"] = static_cast<int>(engine->outputSampleRate());
+	result["framesPerPeriod"] = static_cast<int>(engine->framesPerPeriod());
+
+	RunStats runs[2];
+	QString error;
+	if (type == Plugin::Type::Instrument)
+	{
+		auto track = dynamic_cast<InstrumentTrack*>(Track::create(Track::Type::Instrument, Engine::getSong()));
+		for (auto& run : runs)
+		{
+			if (dynamic_cast<DummyInstrument*>(track->loadInstrument(plugin)))
+			{
+				error = "could not be loaded";
+				break;
+			}
+			run = renderInstrument(track);
+		}
+	}
+	else
+	{
+		for (auto& run : runs)
+		{
+			if (!renderEffect(plugin, run))
+			{
+				error = "could not be loaded";
+				break;
+			}
+		}
+	}
+
+	Engine::destroy();
+
+	if (!error.isEmpty())
+	{
+		result["status"] = "failed";
+		result["error"] = error;
+	}
+	else
+	{
+		result["status"] = "ok";
+		result["usPerPeriod"] = std::min(runs[0].totalUs, runs[1].totalUs) / runs[1].periods;
+		result["maxUsPerPeriod"] = std::min(runs[0].maxUs, runs[1].maxUs);
+		result["allocations"] = static_cast<qint64>(runs[1].allocations);
+		result["allocatingPeriods"] = runs[1].allocatingPeriods;
+		result["periods"] = runs[1].periods;
+		result["deterministic"] = runs[0].hash == runs[1].hash;
+		result["outputHash"] = QString::fromLatin1(runs[1].hash);
+	}
+
+	std::printf("%s\n", QJsonDocument(result).toJson(QJsonDocument::Compact).constData());
+	return EXIT_SUCCESS;
+}
+
+
+
+
+QString resultKey(const QJsonObject& result)
+{
+	return QString("%1/%2/%3/%4").arg(result["type"].toString(), result["plugin"].toString())
+		.arg(result["sampleRate"].toInt()).arg(result["framesPerPeriod"].toInt());
+}
+
+
+//! Prints what got worse compared to @p baseline, returns the number of regressions
+int compareWithBaseline(const QJsonArray& results, const QJsonArray& baseline, double tolerance)
+{
+	QHash<QString, QJsonObject> baselineResults;
+	for (const auto& value : baseline)
+	{
+		baselineResults.insert(resultKey(value.toObject()), value.toObject());
+	}
+
+	int regressions = 0;
+	const auto report = [&regressions](const QString& key, const QString& what) {
+		std::fprintf(stderr, "REGRESSION %s: %s\n", qPrintable(key), qPrintable(what));
+		++regressions;
+	};
+
+	for (const auto& value : results)
+	{
+		const auto result = value.toObject();
+		const auto key = resultKey(result);
+		if (!baselineResults.contains(key)) { continue; }
+		const auto base = baselineResults[key];
+
+		if (result["status"].toString() != "ok")
+		{
+			if (base["status"].toString() == "ok") { report(key, "failed: " + result["error"].toString()); }
+			continue;
+		}
+		if (base["status"].toString() != "ok") { continue; }
+
+		const double us = result["usPerPeriod"].toDouble();
+		const double baseUs = base["usPerPeriod"].toDouble();
+		// ignore differences in the range of timer noise
+		if (us > baseUs * (1. + tolerance) && us - baseUs > 2.)
+		{
+			report(key, QString("%1 us per period instead of %2").arg(us, 0, 'f', 1).arg(baseUs, 0, 'f', 1));
+		}
+		if (result["allocations"].toDouble() > base["allocations"].toDouble())
+		{
+			report(key, QString("%1 allocations instead of %2")
+				.arg(result["allocations"].toDouble()).arg(base["allocations"].toDouble()));
+		}
+		if (!result["deterministic"].toBool() && base["deterministic"].toBool())
+		{
+			report(key, "output is not deterministic anymore");
+		}
+	}
+	return regressions;
+}
+
+
+
+
+QList<int> parseList(const QString& list)
+{
+	QList<int> values;
+	for (const auto& item : list.split(','))
+	{
+		bool ok = false;
+		const int value = item.toInt(&ok);
+		if (!ok || value <= 0)
+		{
+			return {};
+		}
+		values.append(value);
+	}
+	return values;
+}
+
+
+void printUsage()
+{
+	std::printf("Usage: lmms-pluginbench [options]\n\n"
+		"  --plugins <regex>        Only render the plugins whose name matches <regex>\n"
+		"  --rates <list>           Comma-separated sample rates\n"
+		"          Default: 44100,96000\n"
+		"  --frames <list>          Comma-separated frames per period, at most %zu\n"
+		"          Default: 64,%zu\n"
+		"  --output <file>          Write the JSON report to <file> instead of stdout,\n"
+		"                           e.g. to keep it as a baseline\n"
+		"  --baseline <file>        Compare with a report written before and fail if a\n"
+		"                           plugin got slower, allocates more or isn't deterministic\n"
+		"                           anymore\n"
+		"  --tolerance <percent>    Slowdown accepted when comparing with the baseline\n"
+		"          Default: 25\n"
+		"  -h, --help               Show this usage information and exit\n\n",
+		MAXIMUM_RENDER_BUFFER_SIZE, DEFAULT_BUFFER_SIZE);
+}
+
+} // namespace
+
+
+
+
+int main(int argc, char** argv)
+{
+	QCoreApplication app(argc, argv);
+
+	// use the plugins and samples of the build tree unless told otherwise
+	if (qEnvironmentVariableIsEmpty("LMMS_PLUGIN_DIR"))
+	{
+		qputenv("LMMS_PLUGIN_DIR", LMMS_BENCH_PLUGIN_DIR);
+	}
+	if (qEnvironmentVariableIsEmpty("LMMS_DATA_DIR"))
+	{
+		qputenv("LMMS_DATA_DIR", LMMS_BENCH_DATA_DIR);
+	}
+
+	QString filter;
+	QString outputFile;
+	QString baselineFile;
+	QString runPluginName;
+	QString runType;
+	QList<int> sampleRates = {44100, 96000};
+	QList<int> frameCounts = {64, DEFAULT_BUFFER_SIZE};
+	double tolerance = 0.25;
+
+	const QStringList args = app.arguments();
+	for (int i = 1; i < args.size(); ++i)
+	{
+		const QString& arg = args[i];
+		const bool hasValue = i + 1 < args.size();
+
+		if (arg == "--help" || arg == "-h")
+		{
+			printUsage();
+			return EXIT_SUCCESS;
+		}
+		else if (arg == "--plugins" && hasValue)
+		{
+			filter = args[++i];
+		}
+		else if (arg == "--rates" && hasValue)
+		{
+			sampleRates = parseList(args[++i]);
+		}
+		else if (arg == "--frames" && hasValue)
+		{
+			frameCounts = parseList(args[++i]);
+		}
+		else if (arg == "--output" && hasValue)
+		{
+			outputFile = args[++i];
+		}
+		else if (arg == "--baseline" && hasValue)
+		{
+			baselineFile = args[++i];
+		}
+		else if (arg == "--tolerance" && hasValue)
+		{
+			tolerance = std::max(args[++i].toDouble(), 0.) / 100.;
+		}
+		else if (arg == "--run" && i + 2 < args.size())
+		{
+			runType = args[++i];
+			runPluginName = args[++i];
+		}
+		else
+		{
+			std::fprintf(stderr, "Invalid option %s\n\n", qPrintable(arg));
+			printUsage();
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (sampleRates.isEmpty() || frameCounts.isEmpty())
+	{
+		std::fprintf(stderr, "Sample rates and frame counts must be lists of positive numbers\n");
+		return EXIT_FAILURE;
+	}
+
+	if (!runPluginName.isEmpty())
+	{
+		return runPlugin(runPluginName, runType == "effect" ? Plugin::Type::Effect : Plugin::Type::Instrument,
+			sampleRates.front(), frameCounts.front());
+	}
+
+	const auto filterExpression = QRegularExpression(filter);
+	if (!filterExpression.isValid())
+	{
+		std::fprintf(stderr, "Invalid plugin filter %s\n", qPrintable(filter));
+		return EXIT_FAILURE;
+	}
+
+	QJsonArray baseline;
+	if (!baselineFile.isEmpty())
+	{
+		QFile file(baselineFile);
+		if (!file.open(QFile::ReadOnly))
+		{
+			std::fprintf(stderr, "Could not read %s\n", qPrintable(baselineFile));
+			return EXIT_FAILURE;
+		}
+		baseline = QJsonDocument::fromJson(file.readAll()).object()["results"].toArray();
+	}
+
+	QList<std::pair<QString, Plugin::Type>> plugins;
+	for (const auto type : {Plugin::Type::Instrument, Plugin::Type::Effect})
+	{
+		for (const auto descriptor : getPluginFactory()->descriptors(type))
+		{
+			const QString name = descriptor->name;
+			if (filterExpression.match(name).hasMatch()) { plugins.append({name, type}); }
+		}
+	}
+	if (plugins.isEmpty())
+	{
+		std::fprintf(stderr, "No plugins found\n");
+		return EXIT_FAILURE;
+	}
+
+	QJsonArray results;
+	for (const auto& [plugin, type] : plugins)
+	{
+		const QString typeName = type == Plugin::Type::Instrument ? "instrument" : "effect";
+		for (const int sampleRate : sampleRates)
+		{
+			for (const int frames : frameCounts)
+			{
+				std::fprintf(stderr, "Rendering %s %s at %d Hz, %d frames per period...\n",
+					qPrintable(typeName), qPrintable(plugin), sampleRate, frames);
+
+				QProcess child;
+				child.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+				child.start(app.applicationFilePath(), {"--run", typeName, plugin,
+					"--rates", QString::number(sampleRate), "--frames", QString::number(frames)});
+				const bool finished = child.waitForFinished(TimeoutMs);
+				if (!finished) { child.kill(); child.waitForFinished(); }
+
+				auto result = QJsonDocument::fromJson(child.readAllStandardOutput().trimmed()).object();
+				if (!finished || child.exitStatus() != QProcess::NormalExit || child.exitCode() != EXIT_SUCCESS
+					|| result.isEmpty())
+				{
+					result = QJsonObject{};
+					result["plugin"] = plugin;
+					result["type"] = typeName;
+					result["sampleRate"] = sampleRate;
+					result["framesPerPeriod"] = frames;
+					result["status"] = "failed";
+					result["error"] = finished ? "crashed" : "timed out";
+				}
+				results.append(result);
+			}
+		}
+	}
+
+	QJsonObject report;
+	report["version"] = LMMS_VERSION;
+	report["date"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+	report["results"] = results;
+
+	const QByteArray json = QJsonDocument(report).toJson();
+	if (outputFile.isEmpty())
+	{
+		std::fwrite(json.constData(), 1, json.size(), stdout);
+	}
+	else
+	{
+		QFile file(outputFile);
+		if (!file.open(QFile::WriteOnly | QFile::Truncate) || file.write(json) != json.size())
+		{
+			std::fprintf(stderr, "Could not write %s\n", qPrintable(outputFile));
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (!baselineFile.isEmpty())
+	{
+		const int regressions = compareWithBaseline(results, baseline, tolerance);
+		std::fprintf(stderr, "%d regression(s) compared with %s\n", regressions, qPrintable(baselineFile));
+		return regressions > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+	return EXIT_SUCCESS;
+}
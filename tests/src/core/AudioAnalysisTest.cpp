@@ -0,0 +1,112 @@
+/*
+ * AudioAnalysisTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QObject>
+#include <QtTest>
+
+#include <cmath>
+#include <numbers>
+#include <vector>
+
+#include "AudioAnalysis.h"
+#include "SampleFrame.h"
+
+namespace
+{
+
+constexpr auto SampleRate = lmms::sample_rate_t{48000};
+
+std::vector<lmms::SampleFrame> tones(std::initializer_list<double> frequencies, double amplitude, double seconds)
+{
+	auto frames = std::vector<lmms::SampleFrame>(static_cast<std::size_t>(seconds * SampleRate));
+	for (std::size_t i = 0; i < frames.size(); ++i)
+	{
+		double value = 0;
+		for (const double frequency : frequencies)
+		{
+			value += amplitude * std::sin(2 * std::numbers::pi * frequency * i / SampleRate);
+		}
+		frames[i] = lmms::SampleFrame{static_cast<float>(value)};
+	}
+	return frames;
+}
+
+} // namespace
+
+class AudioAnalysisTest : public QObject
+{
+	Q_OBJECT
+private slots:
+	void LoudnessTest()
+	{
+		// BS.1770 calibrates a 997 Hz sine at full scale in one channel to -3.01 LUFS
+		const auto frames = tones({997}, 0.5, 5);
+		const auto result = lmms::AudioAnalysis::compute(frames.data(), frames.size(), SampleRate);
+		QVERIFY(std::abs(result.loudness - -6.02f) < 0.1f);
+		QVERIFY(std::abs(result.peak - -6.02f) < 0.01f);
+		QVERIFY(std::abs(result.rms - -9.03f) < 0.01f);
+	}
+
+	void KeyTest()
+	{
+		// A minor triad
+		const auto frames = tones({440, 523.25, 659.26}, 0.3, 3);
+		const auto result = lmms::AudioAnalysis::compute(frames.data(), frames.size(), SampleRate);
+		QCOMPARE(result.key, 9);
+		QVERIFY(result.minor);
+		QCOMPARE(QString{lmms::AudioAnalysis::keyName(result.key)}, QString{"A"});
+	}
+
+	void TempoTest()
+	{
+		// decaying noise bursts at 120 BPM
+		auto frames = std::vector<lmms::SampleFrame>(8 * SampleRate);
+		auto seed = 1u;
+		for (std::size_t beat = 0; beat < frames.size(); beat += SampleRate / 2)
+		{
+			for (std::size_t i = 0; i < 2000; ++i)
+			{
+				seed = seed * 1103515245u + 12345u;
+				const auto noise = static_cast<float>((seed >> 16) % 2000) / 1000.f - 1.f;
+				frames[beat + i] = lmms::SampleFrame{noise * std::exp(-static_cast<float>(i) / 300)};
+			}
+		}
+
+		const auto result = lmms::AudioAnalysis::compute(frames.data(), frames.size(), SampleRate);
+		QVERIFY(std::abs(result.bpm - 120.f) < 2.f);
+		QCOMPARE(result.onsets.size(), std::size_t{16});
+		QVERIFY(std::abs(result.onsets[1] - 0.5) < 0.02);
+	}
+
+	void SilenceTest()
+	{
+		const auto frames = std::vector<lmms::SampleFrame>(SampleRate);
+		const auto result = lmms::AudioAnalysis::compute(frames.data(), frames.size(), SampleRate);
+		QCOMPARE(result.key, -1);
+		QCOMPARE(result.bpm, 0.f);
+		QCOMPARE(result.loudness, -70.f);
+		QVERIFY(result.onsets.empty());
+	}
+};
+
+QTEST_GUILESS_MAIN(AudioAnalysisTest)
+#include "AudioAnalysisTest.moc"
@@ -0,0 +1,145 @@
+/*
+ * BinaryDataFileTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QDomDocument>
+#include <QObject>
+#include <QtTest>
+
+#include "BinaryDataFile.h"
+
+using namespace lmms;
+
+namespace
+{
+
+const char* const Project = R"(<?xml version="1.0"?>
+<!DOCTYPE lmms-project>
+<lmms-project version="31" creator="LMMS" type="song">
+  <head bpm="140" timesig_numerator="4"/>
+  <song>
+    <trackcontainer type="song">
+      <track type="0" name="Tr&#xe4;ck &lt;1&gt;" muted="0">
+        <midiclip pos="0" len="768" name="">
+          <note pos="0" len="48" key="57" vol="100" pan="0"/>
+          <note pos="48" len="48" key="-3" vol="100" pan="0"/>
+          <note pos="96" len="48" key="007" vol="100" pan="0"/>
+          <note pos="144" len="48" key="9223372036854775807" vol="100" pan="0"/>
+          <note pos="192" len="48" key="-9223372036854775808" vol="100" pan="0"/>
+          <note pos="240" len="48" key="60" vol="100"/>
+        </midiclip>
+      </track>
+      <track type="6" name="Automation">
+        <automationclip pos="0" len="192" prog="1">
+          <time pos="0" value="0.5" outValue="0.5"/>
+          <time pos="48" value="0.25" outValue="0.25"/>
+          <time pos="96" value="1" outValue="1"/>
+          <time pos="144" value="-0" outValue="+2"/>
+        </automationclip>
+      </track>
+    </trackcontainer>
+    <projectnotes><![CDATA[<b>notes</b>]]></projectnotes>
+    <!-- a comment -->
+    <text>plain text</text>
+  </song>
+</lmms-project>
+)";
+
+//! Compares two nodes and their children, ignoring the order of attributes
+void compareNodes(const QDomNode& a, const QDomNode& b)
+{
+	QCOMPARE(b.nodeType(), a.nodeType());
+	QCOMPARE(b.nodeName(), a.nodeName());
+	QCOMPARE(b.nodeValue(), a.nodeValue());
+
+	const QDomNamedNodeMap attributesA = a.attributes();
+	const QDomNamedNodeMap attributesB = b.attributes();
+	QCOMPARE(attributesB.count(), attributesA.count());
+	for (int i = 0; i < attributesA.count(); ++i)
+	{
+		const QDomAttr attr = attributesA.item(i).toAttr();
+		QVERIFY(b.toElement().hasAttribute(attr.name()));
+		QCOMPARE(b.toElement().attribute(attr.name()), attr.value());
+	}
+
+	QCOMPARE(b.childNodes().count(), a.childNodes().count());
+	for (int i = 0; i < a.childNodes().count(); ++i)
+	{
+		compareNodes(a.childNodes().at(i), b.childNodes().at(i));
+	}
+}
+
+} // namespace
+
+class BinaryDataFileTest : public QObject
+{
+	Q_OBJECT
+private slots:
+	void roundTripTest()
+	{
+		auto xml = QDomDocument();
+		QVERIFY(xml.setContent(QByteArray(Project)));
+
+		const QByteArray binary = BinaryDataFile::encode(xml);
+		QVERIFY(BinaryDataFile::isBinary(binary));
+		QVERIFY(!BinaryDataFile::isBinary(QByteArray(Project)));
+
+		auto decoded = QDomDocument();
+		QString error;
+		QVERIFY2(BinaryDataFile::decode(binary, decoded, &error), qPrintable(error));
+
+		// the doctype is the only node type the format doesn't store
+		xml.removeChild(xml.doctype());
+		compareNodes(xml, decoded);
+	}
+
+	void emptyDocumentTest()
+	{
+		auto decoded = QDomDocument();
+		QVERIFY(BinaryDataFile::decode(BinaryDataFile::encode(QDomDocument()), decoded));
+		QVERIFY(!decoded.hasChildNodes());
+	}
+
+	void corruptDataTest()
+	{
+		auto xml = QDomDocument();
+		QVERIFY(xml.setContent(QByteArray(Project)));
+		const QByteArray binary = BinaryDataFile::encode(xml);
+
+		// a newer format version
+		QByteArray newer = binary;
+		newer[4] = 2;
+		auto doc = QDomDocument();
+		QVERIFY(!BinaryDataFile::decode(newer, doc));
+
+		// truncated compressed data
+		doc = QDomDocument();
+		QVERIFY(!BinaryDataFile::decode(binary.left(binary.size() / 2), doc));
+
+		// a payload which ends in the middle of the nodes
+		const QByteArray payload = qUncompress(binary.mid(5));
+		doc = QDomDocument();
+		QVERIFY(!BinaryDataFile::decode(binary.left(5) + qCompress(payload.left(payload.size() - 3)), doc));
+	}
+};
+
+QTEST_GUILESS_MAIN(BinaryDataFileTest)
+#include "BinaryDataFileTest.moc"
@@ -0,0 +1,120 @@
+/*
+ * DataFileUpgradeTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <algorithm>
+
+#include <QDirIterator>
+#include <QObject>
+#include <QtTest>
+
+#include "DataFile.h"
+#include "ZlibDevice.h"
+
+using namespace lmms;
+
+class DataFileUpgradeTest : public QObject
+{
+	Q_OBJECT
+private slots:
+	//! upgrade() skips steps and shares the walks of element upgrades, which
+	//! must not change the outcome of running every step in turn
+	void upgradeMatchesSequentialUpgrade()
+	{
+		auto projects = QDirIterator(LMMS_TEST_PROJECT_DIR, {"*.mmp", "*.mmpz", "*.mpt"},
+			QDir::Files, QDirIterator::Subdirectories);
+		auto count = 0;
+		while (projects.hasNext())
+		{
+			const auto path = projects.next();
+
+			auto upgraded = DataFile(DataFile::Type::SongProject);
+			auto reference = DataFile(DataFile::Type::SongProject);
+			QVERIFY2(loadAsSaved(upgraded, path), qPrintable(path));
+			QVERIFY2(loadAsSaved(reference, path), qPrintable(path));
+
+			upgraded.upgrade();
+			upgradeSequentially(reference);
+
+			QVERIFY2(upgraded.toString() == reference.toString(), qPrintable(path));
+			++count;
+		}
+		QVERIFY(count > 0);
+	}
+
+private:
+	//! Loads @p path into @p file at the version it was saved with, as
+	//! DataFile::loadContent() does, but without upgrading it
+	static bool loadAsSaved(DataFile& file, const QString& path)
+	{
+		auto input = QFile(path);
+		if (!input.open(QIODevice::ReadOnly)) { return false; }
+		auto data = input.readAll();
+		if (isZlibCompressed(data)) { data = qUncompress(data); }
+		if (!file.setContent(data)) { return false; }
+
+		const auto root = file.documentElement();
+		file.m_type = DataFile::type(root.attribute("type"));
+		file.m_head = root.elementsByTagName("head").item(0).toElement();
+		file.m_fileVersion = !root.hasAttribute("version") || root.attribute("version") == "1.0"
+			? file.legacyFileVersion()
+			: root.attribute("version").toUInt();
+		return true;
+	}
+
+	//! Runs every upgrade step from the version of @p file on, one after
+	//! another, with a walk through the whole document for each element upgrade
+	static void upgradeSequentially(DataFile& file)
+	{
+		const auto& steps = DataFile::UPGRADE_METHODS;
+		for (auto step = steps.begin() + std::min<std::size_t>(file.m_fileVersion, steps.size());
+			step != steps.end(); ++step)
+		{
+			if (step->method)
+			{
+				(file.*step->method)();
+				continue;
+			}
+
+			upgradeElements(*step, file.documentElement());
+		}
+
+		// only leaves updating the meta data to upgrade()
+		file.m_fileVersion = steps.size();
+		file.upgrade();
+	}
+
+	//! Applies the element upgrade of @p step to @p element and everything below it
+	static void upgradeElements(const DataFile::UpgradeStep& step, QDomElement element)
+	{
+		if (std::find(step.tagNames.begin(), step.tagNames.end(), element.tagName()) != step.tagNames.end())
+		{
+			step.elementUpgrade(element);
+		}
+		for (auto e = element.firstChildElement(); !e.isNull(); e = e.nextSiblingElement())
+		{
+			upgradeElements(step, e);
+		}
+	}
+};
+
+QTEST_GUILESS_MAIN(DataFileUpgradeTest)
+#include "DataFileUpgradeTest.moc"
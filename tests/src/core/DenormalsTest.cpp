@@ -0,0 +1,65 @@
+/*
+ * DenormalsTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QObject>
+#include <QtTest>
+
+#include <limits>
+
+#include "denormals.h"
+#include "ThreadPool.h"
+
+class DenormalsTest : public QObject
+{
+	Q_OBJECT
+private slots:
+	void initTestCase()
+	{
+		// starts the workers of the pool before this thread flushes denormals,
+		// as new threads may inherit the setting
+		lmms::ThreadPool::instance();
+
+		// denormals are left alone on platforms without hardware flushing
+		lmms::disable_denormals();
+		if (!lmms::denormals_disabled()) { QSKIP("No flush-to-zero mode on this platform"); }
+	}
+
+	void FlushesResultsTest()
+	{
+		volatile float smallest = std::numeric_limits<float>::min();
+		volatile float half = 0.5f;
+		const float result = smallest * half;
+		QCOMPARE(result, 0.f);
+	}
+
+	void ThreadPoolFlushesTest()
+	{
+		auto& pool = lmms::ThreadPool::instance();
+		for (auto i = std::size_t{0}; i < pool.numWorkers(); ++i)
+		{
+			QVERIFY(pool.enqueue([] { return lmms::denormals_disabled(); }).get());
+		}
+	}
+};
+
+QTEST_GUILESS_MAIN(DenormalsTest)
+#include "DenormalsTest.moc"
@@ -0,0 +1,185 @@
+/*
+ * DeterministicRenderTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+// Every render runs in a child process of its own, as the number of worker
+// threads is only read when the engine starts
+
+#include <algorithm>
+#include <cstdio>
+
+#include <QDomDocument>
+#include <QFile>
+#include <QObject>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include "AudioEngine.h"
+#include "ConfigManager.h"
+#include "Engine.h"
+#include "EnvelopeAndLfoParameters.h"
+#include "InstrumentTrack.h"
+#include "MidiClip.h"
+#include "Oscillator.h"
+#include "Song.h"
+
+using namespace lmms;
+
+namespace
+{
+
+constexpr auto ThreadsVariable = "LMMS_TEST_RENDER_THREADS";
+constexpr auto OutputVariable = "LMMS_TEST_RENDER_OUTPUT";
+constexpr auto Tracks = 4;
+constexpr auto Periods = 400;
+
+
+//! Sets @p name to @p value on @p element and everything below it having it
+void setAttributes(QDomElement element, const QString& name, const QString& value)
+{
+	if (element.hasAttribute(name)) { element.setAttribute(name, value); }
+	for (auto e = element.firstChildElement(); !e.isNull(); e = e.nextSiblingElement())
+	{
+		setAttributes(e, name, value);
+	}
+}
+
+
+//! Renders tracks drawing random numbers in every way the engine offers:
+//! noise, arpeggios missing and skipping notes and random LFOs
+int render(int threads, const QString& output)
+{
+	// use a private configuration, so the settings below are never written
+	// to the user's configuration file
+	QTemporaryDir workDir;
+	ConfigManager::inst()->loadConfigFile(workDir.filePath("lmmsrc.xml"));
+	ConfigManager::inst()->setValue("audioengine", "workerthreads", QString::number(threads));
+	ConfigManager::inst()->setValue("audioengine", "deterministic", "1");
+
+	Engine::init(true);
+
+	for (int i = 0; i < Tracks; ++i)
+	{
+		auto track = dynamic_cast<InstrumentTrack*>(Track::create(Track::Type::Instrument, Engine::getSong()));
+		if (!track || !track->loadInstrument("tripleoscillator"))
+		{
+			std::fprintf(stderr, "Could not load TripleOscillator\n");
+			Engine::destroy();
+			return EXIT_FAILURE;
+		}
+
+		auto doc = QDomDocument{};
+		auto parent = doc.createElement("track");
+		auto state = track->saveState(doc, parent);
+		setAttributes(state, "wavetype0", QString::number(static_cast<int>(Oscillator::WaveShape::WhiteNoise)));
+		setAttributes(state, "arp-enabled", "1");
+		setAttributes(state, "arpskip", "30");
+		setAttributes(state, "arpmiss", "30");
+		setAttributes(state, "lshp", QString::number(static_cast<int>(EnvelopeAndLfoParameters::LfoShape::RandomWave)));
+		setAttributes(state, "lamt", "1");
+		track->restoreState(state);
+
+		auto clip = dynamic_cast<MidiClip*>(track->createClip(TimePos{0}));
+		for (int note = 0; note < 8; ++note)
+		{
+			clip->addNote(Note{TimePos{48}, TimePos{note * 48}, 57 + i * 3 + note}, false);
+		}
+	}
+
+	Engine::getSong()->playSong();
+
+	auto file = QFile{output};
+	if (!file.open(QIODevice::WriteOnly))
+	{
+		std::fprintf(stderr, "Could not create %s\n", qPrintable(output));
+		Engine::destroy();
+		return EXIT_FAILURE;
+	}
+	for (int period = 0; period < Periods; ++period)
+	{
+		const SampleFrame* buffer = Engine::audioEngine()->nextBuffer();
+		file.write(reinterpret_cast<const char*>(buffer),
+			Engine::audioEngine()->nextBufferFrames() * sizeof(SampleFrame));
+	}
+
+	Engine::destroy();
+	return EXIT_SUCCESS;
+}
+
+} // namespace
+
+
+class DeterministicRenderTest : public QObject
+{
+	Q_OBJECT
+private slots:
+	void sameOutputWithAnyNumberOfThreads()
+	{
+		QTemporaryDir outputDir;
+		const auto single = renderInChild(1, outputDir.filePath("single.raw"));
+		const auto multi = renderInChild(std::max(QThread::idealThreadCount(), 4), outputDir.filePath("multi.raw"));
+
+		QVERIFY(!single.isEmpty());
+		QCOMPARE(multi.size(), single.size());
+		QVERIFY(multi == single);
+	}
+
+private:
+	static QByteArray renderInChild(int threads, const QString& output)
+	{
+		auto environment = QProcessEnvironment::systemEnvironment();
+		environment.insert(ThreadsVariable, QString::number(threads));
+		environment.insert(OutputVariable, output);
+
+		QProcess child;
+		child.setProcessEnvironment(environment);
+		child.setProcessChannelMode(QProcess::ForwardedChannels);
+		child.start(QCoreApplication::applicationFilePath(), QStringList{});
+		child.waitForFinished(-1);
+		if (child.exitStatus() != QProcess::NormalExit || child.exitCode() != EXIT_SUCCESS) { return {}; }
+
+		auto file = QFile{output};
+		return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray{};
+	}
+};
+
+
+int main(int argc, char** argv)
+{
+	QCoreApplication app(argc, argv);
+
+	// use the plugins of the build tree unless told otherwise
+	if (qEnvironmentVariableIsEmpty("LMMS_PLUGIN_DIR"))
+	{
+		qputenv("LMMS_PLUGIN_DIR", LMMS_TEST_PLUGIN_DIR);
+	}
+
+	if (qEnvironmentVariableIsSet(ThreadsVariable))
+	{
+		return render(qEnvironmentVariableIntValue(ThreadsVariable), qEnvironmentVariable(OutputVariable));
+	}
+
+	DeterministicRenderTest test;
+	return QTest::qExec(&test, argc, argv);
+}
+
+#include "DeterministicRenderTest.moc"
@@ -0,0 +1,110 @@
+/*
+ * JournalDiffTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QObject>
+#include <QRandomGenerator>
+#include <QtTest>
+
+#include "JournalDiff.h"
+
+using namespace lmms;
+
+namespace
+{
+
+QStringList notes(int count)
+{
+	auto lines = QStringList{"<midiclip pos=\"0\">"};
+	for (int i = 0; i < count; ++i)
+	{
+		lines.append(QString(" <note pos=\"%1\" len=\"48\" key=\"57\"/>").arg(i * 48));
+	}
+	lines.append("</midiclip>");
+	return lines;
+}
+
+} // namespace
+
+class JournalDiffTest : public QObject
+{
+	Q_OBJECT
+private slots:
+	void identicalTest()
+	{
+		const QStringList lines = notes(10);
+		const auto diff = JournalDiff::between(lines, lines);
+		QVERIFY(diff.isEmpty());
+		QCOMPARE(diff.applyTo(lines), lines);
+	}
+
+	void localChangeTest()
+	{
+		const QStringList before = notes(10000);
+		QStringList after = before;
+		after[5000] = " <note pos=\"240000\" len=\"96\" key=\"60\"/>";
+		after.removeAt(200);
+		after.insert(9000, " <note pos=\"1\" len=\"1\" key=\"1\"/>");
+
+		const auto diff = JournalDiff::between(before, after);
+		QCOMPARE(diff.applyTo(before), after);
+		QCOMPARE(JournalDiff::between(after, before).applyTo(after), before);
+
+		// only the changed lines are kept
+		QVERIFY(diff.memoryUsage() < 1024);
+	}
+
+	void unrelatedTest()
+	{
+		const QStringList before = notes(3000);
+		auto after = QStringList();
+		for (int i = 0; i < 2000; ++i) { after.append(QString::number(i)); }
+
+		// too many edits to search for the shortest difference
+		QCOMPARE(JournalDiff::between(before, after).applyTo(before), after);
+		QCOMPARE(JournalDiff::between(after, QStringList()).applyTo(after), QStringList());
+		QCOMPARE(JournalDiff::between(QStringList(), after).applyTo(QStringList()), after);
+	}
+
+	void randomEditsTest()
+	{
+		auto random = QRandomGenerator(42);
+		for (int run = 0; run < 500; ++run)
+		{
+			auto before = QStringList();
+			const int count = random.bounded(50);
+			for (int i = 0; i < count; ++i) { before.append(QString::number(random.bounded(8))); }
+
+			QStringList after = before;
+			for (int edit = random.bounded(6); edit > 0; --edit)
+			{
+				const int pos = random.bounded(after.size() + 1);
+				if (random.bounded(2) == 0 && pos < after.size()) { after.removeAt(pos); }
+				else { after.insert(pos, QString::number(random.bounded(10))); }
+			}
+
+			QCOMPARE(JournalDiff::between(before, after).applyTo(before), after);
+		}
+	}
+};
+
+QTEST_GUILESS_MAIN(JournalDiffTest)
+#include "JournalDiffTest.moc"
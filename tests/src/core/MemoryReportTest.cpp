@@ -0,0 +1,68 @@
+/*
+ * MemoryReportTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QObject>
+#include <QtTest>
+
+#include "LocklessAllocator.h"
+#include "MemoryReport.h"
+#include "ProjectJournal.h"
+
+using namespace lmms;
+
+class MemoryReportTest : public QObject
+{
+	Q_OBJECT
+private slots:
+	void formatBytesTest()
+	{
+		QCOMPARE(MemoryReport::formatBytes(0), QString("0 B"));
+		QCOMPARE(MemoryReport::formatBytes(1023), QString("1023 B"));
+		QCOMPARE(MemoryReport::formatBytes(1536), QString("1.5 KiB"));
+		QCOMPARE(MemoryReport::formatBytes(std::size_t{6} * 1024 * 1024 * 1024), QString("6.0 GiB"));
+	}
+
+	void categoryNamesTest()
+	{
+		for (auto c = std::size_t{0}; c < static_cast<std::size_t>(MemoryReport::Category::Count); ++c)
+		{
+			QVERIFY(!MemoryReport::categoryName(static_cast<MemoryReport::Category>(c)).isEmpty());
+		}
+	}
+
+	void allocatorTest()
+	{
+		struct alignas(64) Voice { char data[100]; };
+		auto pool = LocklessAllocatorT<Voice>(10, 64);
+		QVERIFY(pool.capacity() >= 10);
+		QVERIFY(pool.memoryUsage() >= pool.capacity() * sizeof(Voice));
+	}
+
+	void emptyJournalTest()
+	{
+		auto journal = ProjectJournal();
+		QCOMPARE(journal.memoryUsage(), std::size_t{0});
+	}
+};
+
+QTEST_GUILESS_MAIN(MemoryReportTest)
+#include "MemoryReportTest.moc"
@@ -0,0 +1,324 @@
+/*
+ * MixHelpersTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QObject>
+#include <QtTest>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "MixHelpers.h"
+#include "SampleFrame.h"
+#include "ValueBuffer.h"
+
+using namespace lmms;
+
+namespace
+{
+
+struct Buffers
+{
+	std::vector<SampleFrame> dst;
+	std::vector<SampleFrame> src;
+	ValueBuffer coeffs1;
+	ValueBuffer coeffs2;
+};
+
+// frame counts covering empty buffers, partial vectors and full periods
+constexpr int FrameCounts[] = {0, 1, 2, 3, 5, 7, 8, 13, 64, 255, 256};
+
+Buffers makeBuffers(int frames, bool withSpecialValues)
+{
+	auto rng = std::mt19937{static_cast<std::mt19937::result_type>(frames)};
+	auto dist = std::uniform_real_distribution<float>{-2.f, 2.f};
+
+	auto buffers = Buffers{std::vector<SampleFrame>(frames), std::vector<SampleFrame>(frames),
+		ValueBuffer(frames), ValueBuffer(frames)};
+	for (int f = 0; f < frames; ++f)
+	{
+		buffers.dst[f] = SampleFrame(dist(rng), dist(rng));
+		buffers.src[f] = SampleFrame(dist(rng), dist(rng));
+		buffers.coeffs1.values()[f] = dist(rng);
+		buffers.coeffs2.values()[f] = dist(rng);
+	}
+
+	if (withSpecialValues && frames > 3)
+	{
+		buffers.src[1][0] = std::numeric_limits<float>::infinity();
+		buffers.src[2][1] = -0.f;
+		buffers.src[frames - 1][1] = std::numeric_limits<float>::quiet_NaN();
+	}
+	return buffers;
+}
+
+bool bitEqual(const std::vector<SampleFrame>& a, const std::vector<SampleFrame>& b)
+{
+	return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(SampleFrame)) == 0;
+}
+
+} // namespace
+
+class MixHelpersTest : public QObject
+{
+	Q_OBJECT
+private:
+	//! Runs @p op on the scalar and on every vectorised implementation
+	//! available on this machine and checks that the results are identical
+	template<typename Op>
+	void compareWithScalar(Op op, bool withSpecialValues = false)
+	{
+		for (int frames : FrameCounts)
+		{
+			const auto input = makeBuffers(frames, withSpecialValues);
+
+			QVERIFY(MixHelpers::setSimdLevel(MixHelpers::SimdLevel::Scalar));
+			auto expected = input;
+			const bool expectedResult = op(expected);
+
+			for (auto level : {MixHelpers::SimdLevel::Sse2, MixHelpers::SimdLevel::Avx2, MixHelpers::SimdLevel::Neon})
+			{
+				if (!MixHelpers::setSimdLevel(level)) { continue; }
+
+				auto actual = input;
+				QCOMPARE(op(actual), expectedResult);
+				QVERIFY(bitEqual(actual.dst, expected.dst));
+				QVERIFY(bitEqual(actual.src, expected.src));
+			}
+		}
+	}
+
+private slots:
+	void init()
+	{
+		MixHelpers::setNaNHandler(true);
+	}
+
+	void cleanup()
+	{
+		MixHelpers::setSimdLevel(MixHelpers::bestSimdLevel());
+		MixHelpers::setNaNHandler(false);
+	}
+
+	void bestLevelIsUsedByDefault()
+	{
+		QCOMPARE(MixHelpers::simdLevel(), MixHelpers::bestSimdLevel());
+	}
+
+	void addTest()
+	{
+		compareWithScalar([](Buffers& b) {
+			MixHelpers::add(b.dst.data(), b.src.data(), b.dst.size());
+			return true;
+		});
+	}
+
+	void multiplyTest()
+	{
+		compareWithScalar([](Buffers& b) {
+			MixHelpers::multiply(b.dst.data(), 0.37f, b.dst.size());
+			return true;
+		});
+	}
+
+	void multiplyStereoTest()
+	{
+		compareWithScalar([](Buffers& b) {
+			MixHelpers::multiplyStereo(b.dst.data(), 0.37f, -1.3f, b.dst.size());
+			return true;
+		});
+	}
+
+	void multiplyByBufferTest()
+	{
+		compareWithScalar([](Buffers& b) {
+			MixHelpers::multiplyByBuffer(b.dst.data(), b.coeffs1.values(), b.dst.size());
+			return true;
+		});
+	}
+
+	void multiplyAndAddMultipliedTest()
+	{
+		compareWithScalar([](Buffers& b) {
+			MixHelpers::multiplyAndAddMultiplied(b.dst.data(), b.src.data(), 0.61f, 0.37f, b.dst.size());
+			return true;
+		});
+	}
+
+	void addMultipliedTest()
+	{
+		compareWithScalar([](Buffers& b) {
+			MixHelpers::addMultiplied(b.dst.data(), b.src.data(), 0.37f, b.dst.size());
+			return true;
+		});
+	}
+
+	void addMultipliedByBufferTest()
+	{
+		compareWithScalar([](Buffers& b) {
+			MixHelpers::addMultipliedByBuffer(b.dst.data(), b.src.data(), 0.37f, &b.coeffs1, b.dst.size());
+			return true;
+		});
+	}
+
+	void addMultipliedByBuffersTest()
+	{
+		compareWithScalar([](Buffers& b) {
+			MixHelpers::addMultipliedByBuffers(b.dst.data(), b.src.data(), &b.coeffs1, &b.coeffs2, b.dst.size());
+			return true;
+		});
+	}
+
+	void addSanitizedMultipliedTest()
+	{
+		compareWithScalar([](Buffers& b) {
+			MixHelpers::addSanitizedMultiplied(b.dst.data(), b.src.data(), 0.37f, b.dst.size());
+			return true;
+		}, true);
+	}
+
+	void addSanitizedMultipliedByBufferTest()
+	{
+		compareWithScalar([](Buffers& b) {
+			MixHelpers::addSanitizedMultipliedByBuffer(b.dst.data(), b.src.data(), 0.37f, &b.coeffs1, b.dst.size());
+			return true;
+		}, true);
+	}
+
+	void addSanitizedMultipliedByBuffersTest()
+	{
+		compareWithScalar([](Buffers& b) {
+			MixHelpers::addSanitizedMultipliedByBuffers(b.dst.data(), b.src.data(), &b.coeffs1, &b.coeffs2,
+				b.dst.size());
+			return true;
+		}, true);
+	}
+
+	void isSilentTest()
+	{
+		compareWithScalar([](Buffers& b) {
+			return MixHelpers::isSilent(b.src.data(), b.src.size());
+		});
+		compareWithScalar([](Buffers& b) {
+			zeroSampleFrames(b.src.data(), b.src.size());
+			if (!b.src.empty()) { b.src.back()[1] = 1e-3f; }
+			return MixHelpers::isSilent(b.src.data(), b.src.size());
+		});
+		compareWithScalar([](Buffers& b) {
+			zeroSampleFrames(b.src.data(), b.src.size());
+			return MixHelpers::isSilent(b.src.data(), b.src.size());
+		});
+	}
+
+	void absPeakTest()
+	{
+		// the results are compared in dst
+		compareWithScalar([](Buffers& b) {
+			b.dst.assign(1, MixHelpers::absPeak(b.src.data(), b.src.size()));
+			return true;
+		});
+		compareWithScalar([](Buffers& b) {
+			b.dst.assign(1, MixHelpers::absPeak(b.src.data(), b.src.size()));
+			return !std::isnan(b.dst[0][1]);
+		}, true);
+	}
+
+	void sumOfSquaresTest()
+	{
+		compareWithScalar([](Buffers& b) {
+			b.dst.assign(1, MixHelpers::sumOfSquares(b.src.data(), b.src.size()));
+			return true;
+		});
+	}
+
+	void levelsTest()
+	{
+		// the peaks end up in dst[0], the sums of squares in dst[1]
+		compareWithScalar([](Buffers& b) {
+			b.dst.resize(2);
+			MixHelpers::levels(b.src.data(), b.src.size(), b.dst[0], b.dst[1]);
+			return true;
+		});
+		compareWithScalar([](Buffers& b) {
+			auto sums = SampleFrame{};
+			b.dst.resize(1);
+			MixHelpers::levels(b.src.data(), b.src.size(), b.dst[0], sums);
+			return !std::isnan(b.dst[0][1]);
+		}, true);
+
+		// same results as measuring the levels separately
+		for (int frames : FrameCounts)
+		{
+			const auto b = makeBuffers(frames, false);
+			auto peak = SampleFrame{};
+			auto sums = SampleFrame{};
+			MixHelpers::levels(b.src.data(), b.src.size(), peak, sums);
+			QVERIFY(bitEqual({peak}, {MixHelpers::absPeak(b.src.data(), b.src.size())}));
+			QVERIFY(bitEqual({sums}, {MixHelpers::sumOfSquares(b.src.data(), b.src.size())}));
+		}
+	}
+
+	void interleaveTest()
+	{
+		compareWithScalar([](Buffers& b) {
+			MixHelpers::interleave(b.dst.data(), b.coeffs1.values(), b.coeffs2.values(), b.dst.size());
+			return true;
+		});
+		compareWithScalar([](Buffers& b) {
+			MixHelpers::deinterleave(b.coeffs1.values(), b.coeffs2.values(), b.src.data(), b.src.size());
+			MixHelpers::interleave(b.dst.data(), b.coeffs1.values(), b.coeffs2.values(), b.dst.size());
+			return true;
+		}, true);
+
+		// interleaving the deinterleaved channels gives back the frames
+		for (int frames : FrameCounts)
+		{
+			const auto b = makeBuffers(frames, false);
+			auto left = std::vector<float>(frames);
+			auto right = std::vector<float>(frames);
+			MixHelpers::deinterleave(left.data(), right.data(), b.src.data(), frames);
+
+			auto roundTrip = std::vector<SampleFrame>(frames);
+			MixHelpers::interleave(roundTrip.data(), left.data(), right.data(), frames);
+			QVERIFY(bitEqual(roundTrip, b.src));
+			if (frames > 0) { QCOMPARE(right.back(), b.src.back()[1]); }
+		}
+	}
+
+	void sanitizeTest()
+	{
+		// clamping only
+		compareWithScalar([](Buffers& b) {
+			MixHelpers::multiply(b.src.data(), 800.f, b.src.size());
+			return MixHelpers::sanitize(b.src.data(), b.src.size());
+		});
+		// clearing buffers containing infs/nans
+		compareWithScalar([](Buffers& b) {
+			return MixHelpers::sanitize(b.src.data(), b.src.size());
+		}, true);
+	}
+};
+
+QTEST_GUILESS_MAIN(MixHelpersTest)
+#include "MixHelpersTest.moc"
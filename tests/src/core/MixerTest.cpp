@@ -0,0 +1,78 @@
+/*
+ * MixerTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QObject>
+#include <QtTest>
+
+#include "AudioEngine.h"
+#include "Engine.h"
+#include "Mixer.h"
+
+class MixerTest : public QObject
+{
+	Q_OBJECT
+private slots:
+	void initTestCase()
+	{
+		using namespace lmms;
+		Engine::init(true);
+	}
+
+	void cleanupTestCase()
+	{
+		using namespace lmms;
+		Engine::destroy();
+	}
+
+	void deleteMiddleChannel()
+	{
+		using namespace lmms;
+		auto mixer = Engine::mixer();
+		mixer->clear();
+
+		// 1 -> 3 -> 4 -> master, with 2 in between to be deleted
+		for (int i = 0; i < 4; ++i) { mixer->createChannel(); }
+		mixer->deleteChannelSend(1, 0);
+		mixer->deleteChannelSend(3, 0);
+		mixer->createChannelSend(1, 3);
+		mixer->createChannelSend(3, 4);
+		mixer->createChannelSend(2, 4);
+
+		mixer->deleteChannel(2);
+
+		QCOMPARE(mixer->numChannels(), 4);
+		for (int i = 0; i < mixer->numChannels(); ++i)
+		{
+			QCOMPARE(mixer->mixerChannel(i)->index(), i);
+		}
+		QVERIFY(mixer->channelSendModel(1, 2) != nullptr);
+		QVERIFY(mixer->channelSendModel(2, 3) != nullptr);
+		QVERIFY(mixer->channelSendModel(3, 0) != nullptr);
+		QVERIFY(mixer->channelSendModel(1, 0) == nullptr);
+
+		// the channels have to be processed in the order of their sends for a period to finish
+		QVERIFY(Engine::audioEngine()->nextBuffer() != nullptr);
+	}
+};
+
+QTEST_GUILESS_MAIN(MixerTest)
+#include "MixerTest.moc"
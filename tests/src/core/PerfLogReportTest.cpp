@@ -0,0 +1,82 @@
+/*
+ * PerfLogReportTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QObject>
+#include <QtTest>
+
+#include <optional>
+
+#include "PerfLog.h"
+
+using namespace lmms;
+
+class PerfLogReportTest : public QObject
+{
+	Q_OBJECT
+private slots:
+	void aggregateTest()
+	{
+		PerfLogReport::begin("project.mmpz");
+		for (int i = 0; i < 3; ++i) { PerfLogReport::Timer("Plugin", "tripleoscillator"); }
+		PerfLogReport::Timer("Plugin", "kicker").end();
+		PerfLogReport::end();
+
+		const auto entries = PerfLogReport::entries();
+		QCOMPARE(PerfLogReport::title(), QString("project.mmpz"));
+		QCOMPARE(entries.size(), std::size_t{2});
+		QCOMPARE(entries[0].name, QString("tripleoscillator"));
+		QCOMPARE(entries[0].count, 3);
+		QVERIFY(entries[0].maxSeconds <= entries[0].seconds);
+		QCOMPARE(entries[1].name, QString("kicker"));
+		QCOMPARE(entries[1].count, 1);
+		QVERIFY(PerfLogReport::toString().contains("tripleoscillator"));
+	}
+
+	void runningTimersTest()
+	{
+		PerfLogReport::begin("first");
+		auto running = std::optional<PerfLogReport::Timer>();
+		running.emplace("Sample decode", "kick.ogg");
+		PerfLogReport::end();
+
+		// not started while no report is collected
+		PerfLogReport::Timer("Plugin", "kicker").end();
+		QVERIFY(PerfLogReport::entries().empty());
+
+		// started ones still count after collecting ended
+		running.reset();
+		PerfLogReport::waitForTimers();
+		QCOMPARE(PerfLogReport::entries().size(), std::size_t{1});
+
+		// but not to a report begun meanwhile
+		PerfLogReport::begin("second");
+		running.emplace("Sample decode", "kick.ogg");
+		PerfLogReport::begin("third");
+		running.reset();
+		PerfLogReport::waitForTimers();
+		PerfLogReport::end();
+		QVERIFY(PerfLogReport::entries().empty());
+	}
+};
+
+QTEST_GUILESS_MAIN(PerfLogReportTest)
+#include "PerfLogReportTest.moc"
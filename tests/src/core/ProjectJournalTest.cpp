@@ -0,0 +1,101 @@
+/*
+ * ProjectJournalTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QObject>
+#include <QtTest>
+
+#include <array>
+
+#include "ProjectJournal.h"
+
+using namespace lmms;
+
+namespace
+{
+
+// only stored and compared, never used
+std::array<int, 4> objectStorage;
+
+JournallingObject* object(int index)
+{
+	return reinterpret_cast<JournallingObject*>(&objectStorage[index]);
+}
+
+} // namespace
+
+class ProjectJournalTest : public QObject
+{
+	Q_OBJECT
+private slots:
+	void allocatedIdsTest()
+	{
+		auto journal = ProjectJournal();
+		const jo_id_t first = journal.allocID(object(0));
+		const jo_id_t second = journal.allocID(object(1));
+		QVERIFY(first != second);
+		QCOMPARE(journal.journallingObject(first), object(0));
+		QCOMPARE(journal.journallingObject(second), object(1));
+
+		// loaded files don't have the bit of allocated IDs
+		QCOMPARE(ProjectJournal::idFromSave(ProjectJournal::idToSave(first)), first);
+		QCOMPARE(journal.journallingObject(ProjectJournal::idToSave(first)), nullptr);
+
+		// freed IDs stay reserved, as undoing may restore their object
+		journal.freeID(first);
+		QCOMPARE(journal.journallingObject(first), nullptr);
+		const jo_id_t third = journal.allocID(object(2));
+		QVERIFY(third != first && third != second);
+		journal.reallocID(first, object(0));
+		QCOMPARE(journal.journallingObject(first), object(0));
+
+		// until nothing refers to them anymore
+		journal.freeID(first);
+		journal.clearJournal();
+		QCOMPARE(journal.allocID(object(3)), first);
+		QCOMPARE(journal.journallingObject(first), object(3));
+		QCOMPARE(journal.journallingObject(third), object(2));
+	}
+
+	void loadedIdsTest()
+	{
+		auto journal = ProjectJournal();
+		journal.reallocID(4711, object(0));
+		journal.reallocID(123456, object(1));
+		QCOMPARE(journal.journallingObject(4711), object(0));
+		QCOMPARE(journal.journallingObject(123456), object(1));
+		QCOMPARE(journal.journallingObject(4712), nullptr);
+
+		journal.freeID(4711);
+		QCOMPARE(journal.journallingObject(4711), nullptr);
+
+		// saved again as they were
+		QCOMPARE(ProjectJournal::idToSave(4711), jo_id_t{4711});
+
+		// not confused with allocated IDs
+		const jo_id_t allocated = journal.allocID(object(2));
+		QCOMPARE(journal.journallingObject(ProjectJournal::idToSave(allocated)), nullptr);
+		QCOMPARE(journal.journallingObject(allocated), object(2));
+	}
+};
+
+QTEST_GUILESS_MAIN(ProjectJournalTest)
+#include "ProjectJournalTest.moc"
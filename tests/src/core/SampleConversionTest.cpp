@@ -0,0 +1,168 @@
+/*
+ * SampleConversionTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QObject>
+#include <QtTest>
+
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "MixHelpers.h"
+#include "SampleConversion.h"
+#include "SampleFrame.h"
+
+using namespace lmms;
+
+namespace
+{
+
+// frame counts covering empty buffers, partial vectors and full periods
+constexpr int FrameCounts[] = {0, 1, 3, 4, 5, 8, 13, 64, 255, 256};
+
+std::vector<SampleFrame> makeInput(int frames)
+{
+	auto rng = std::mt19937{static_cast<std::mt19937::result_type>(frames)};
+	auto dist = std::uniform_real_distribution<float>{-1.5f, 1.5f};
+
+	auto input = std::vector<SampleFrame>(frames);
+	for (auto& frame : input) { frame = SampleFrame(dist(rng), dist(rng)); }
+
+	if (frames > 3)
+	{
+		input[1][0] = std::numeric_limits<float>::infinity();
+		input[2][1] = std::numeric_limits<float>::quiet_NaN();
+	}
+	return input;
+}
+
+} // namespace
+
+class SampleConversionTest : public QObject
+{
+	Q_OBJECT
+private:
+	//! Converts with the scalar and every vectorised implementation available
+	//! on this machine, in two parts to carry the dither state over, and
+	//! checks that the results are identical
+	template<typename T, typename Convert>
+	void compareWithScalar(Convert convert)
+	{
+		using SampleConversion::Dither;
+		for (auto dither : {Dither::None, Dither::Triangular, Dither::NoiseShaped})
+		{
+			for (int frames : FrameCounts)
+			{
+				const auto input = makeInput(frames);
+				const int half = frames / 2;
+				const auto run = [&] {
+					auto output = std::vector<T>(frames * DEFAULT_CHANNELS);
+					auto state = SampleConversion::DitherState{dither};
+					convert(input.data(), half, output.data(), state);
+					convert(input.data() + half, frames - half, output.data() + half * DEFAULT_CHANNELS, state);
+					return output;
+				};
+
+				QVERIFY(MixHelpers::setSimdLevel(MixHelpers::SimdLevel::Scalar));
+				const auto expected = run();
+
+				for (auto level : {MixHelpers::SimdLevel::Sse2, MixHelpers::SimdLevel::Avx2, MixHelpers::SimdLevel::Neon})
+				{
+					if (!MixHelpers::setSimdLevel(level)) { continue; }
+					QCOMPARE(run(), expected);
+				}
+			}
+		}
+	}
+
+private slots:
+	void cleanup()
+	{
+		MixHelpers::setSimdLevel(MixHelpers::bestSimdLevel());
+	}
+
+	void toS16MatchesScalarTest()
+	{
+		compareWithScalar<std::int16_t>([](const SampleFrame* src, int frames, std::int16_t* dst,
+			SampleConversion::DitherState& state) {
+			SampleConversion::toS16(src, frames, DEFAULT_CHANNELS, dst, false, &state);
+		});
+		compareWithScalar<std::int16_t>([](const SampleFrame* src, int frames, std::int16_t* dst,
+			SampleConversion::DitherState& state) {
+			SampleConversion::toS16(src, frames, DEFAULT_CHANNELS, dst, true, &state);
+		});
+	}
+
+	void toS32MatchesScalarTest()
+	{
+		for (int bits : {24, 32})
+		{
+			compareWithScalar<std::int32_t>([bits](const SampleFrame* src, int frames, std::int32_t* dst,
+				SampleConversion::DitherState& state) {
+				SampleConversion::toS32(src, frames, DEFAULT_CHANNELS, dst, bits, &state);
+			});
+		}
+	}
+
+	void clippingTest()
+	{
+		const SampleFrame input[] = {{1.f, -1.f}, {2.f, -2.f}, {0.5f, 0.f}};
+
+		std::int16_t s16[6];
+		SampleConversion::toS16(input, 3, DEFAULT_CHANNELS, s16);
+		QCOMPARE(s16[0], std::int16_t{32767});
+		QCOMPARE(s16[1], std::int16_t{-32767});
+		QCOMPARE(s16[2], std::int16_t{32767});
+		QCOMPARE(s16[3], std::int16_t{-32767});
+		QCOMPARE(s16[4], std::int16_t{16384});
+		QCOMPARE(s16[5], std::int16_t{0});
+
+		std::int32_t s24[6];
+		SampleConversion::toS32(input, 3, DEFAULT_CHANNELS, s24, 24);
+		QCOMPARE(s24[2], 8388607 * 256);
+		QCOMPARE(s24[3], -8388607 * 256);
+		QCOMPARE(s24[4], 4194304 * 256);
+	}
+
+	void monoTakesLeftChannelTest()
+	{
+		const SampleFrame input[] = {{0.5f, -1.f}, {-0.5f, 1.f}};
+
+		std::int16_t output[2];
+		SampleConversion::toS16(input, 2, 1, output);
+		QCOMPARE(output[0], std::int16_t{16384});
+		QCOMPARE(output[1], std::int16_t{-16384});
+	}
+
+	void byteSwapTest()
+	{
+		const SampleFrame input[] = {{1.f, -1.f}};
+
+		std::int16_t output[2];
+		SampleConversion::toS16(input, 1, DEFAULT_CHANNELS, output, true);
+		QCOMPARE(static_cast<std::uint16_t>(output[0]), std::uint16_t{0xff7f});
+		QCOMPARE(static_cast<std::uint16_t>(output[1]), std::uint16_t{0x0180});
+	}
+};
+
+QTEST_GUILESS_MAIN(SampleConversionTest)
+#include "SampleConversionTest.moc"
@@ -0,0 +1,81 @@
+/*
+ * StartupSchedulerTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QObject>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include <atomic>
+
+#include "StartupScheduler.h"
+
+using namespace lmms;
+
+class StartupSchedulerTest : public QObject
+{
+	Q_OBJECT
+private slots:
+	void startupTest()
+	{
+		auto dir = QTemporaryDir();
+		QVERIFY(dir.isValid());
+		const QString reportFile = dir.filePath("startup.txt");
+		StartupScheduler::reportTo(reportFile);
+
+		StartupScheduler::beginPhase("first phase");
+
+		auto done = std::atomic<int>(0);
+		StartupScheduler::start("task a", [&done] { ++done; });
+		StartupScheduler::start("task b", [&done] { ++done; });
+		StartupScheduler::wait("task a");
+		StartupScheduler::wait("task b");
+		StartupScheduler::wait("unknown task");
+		QCOMPARE(done.load(), 2);
+
+		StartupScheduler::beginPhase("second phase");
+
+		int deferred = 0;
+		auto kept = QObject();
+		auto deleted = new QObject();
+		StartupScheduler::defer("kept", &kept, [&deferred] { ++deferred; });
+		StartupScheduler::defer("deleted", deleted, [&deferred] { deferred += 10; });
+		delete deleted;
+
+		// deferred tasks wait for the event loop
+		QCOMPARE(deferred, 0);
+		StartupScheduler::finish();
+		QTRY_VERIFY(QFile::exists(reportFile));
+		QCOMPARE(deferred, 1);
+
+		auto file = QFile(reportFile);
+		QVERIFY(file.open(QIODevice::ReadOnly | QIODevice::Text));
+		const auto report = QString::fromUtf8(file.readAll());
+		for (const auto& name : {"first phase", "second phase", "task a", "task b", "kept"})
+		{
+			QVERIFY(report.contains(name));
+		}
+		QVERIFY(!report.contains("deleted"));
+	}
+};
+
+QTEST_GUILESS_MAIN(StartupSchedulerTest)
+#include "StartupSchedulerTest.moc"
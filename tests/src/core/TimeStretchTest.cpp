@@ -0,0 +1,99 @@
+/*
+ * TimeStretchTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QObject>
+#include <QtTest>
+
+#include <cmath>
+#include <numbers>
+#include <vector>
+
+#include "SampleBuffer.h"
+#include "TimeStretch.h"
+
+namespace
+{
+
+constexpr auto SampleRate = 44100;
+
+lmms::SampleBuffer sine(double frequency, double seconds)
+{
+	auto frames = std::vector<lmms::SampleFrame>(static_cast<std::size_t>(seconds * SampleRate));
+	for (std::size_t i = 0; i < frames.size(); ++i)
+	{
+		frames[i] = lmms::SampleFrame{static_cast<float>(0.5 * std::sin(2 * std::numbers::pi * frequency * i / SampleRate))};
+	}
+	return lmms::SampleBuffer{std::move(frames), SampleRate};
+}
+
+//! The frequency of the sine in @p buffer, counted in its middle half where every frame is covered by two windows
+double frequency(const lmms::SampleBuffer& buffer)
+{
+	const auto begin = buffer.size() / 4;
+	const auto end = buffer.size() * 3 / 4;
+	auto crossings = 0;
+	for (auto i = begin + 1; i < end; ++i)
+	{
+		if (buffer.data()[i - 1][0] < 0 && buffer.data()[i][0] >= 0) { ++crossings; }
+	}
+	return crossings * static_cast<double>(SampleRate) / (end - begin);
+}
+
+} // namespace
+
+class TimeStretchTest : public QObject
+{
+	Q_OBJECT
+private slots:
+	void stretchKeepsPitch_data()
+	{
+		QTest::addColumn<double>("ratio");
+		QTest::newRow("shorter") << 0.75;
+		QTest::newRow("longer") << 1.5;
+	}
+
+	void stretchKeepsPitch()
+	{
+		QFETCH(double, ratio);
+		const auto input = sine(440, 1);
+		const auto output = lmms::TimeStretch::stretch(input, ratio);
+
+		QCOMPARE(output.size(), static_cast<std::size_t>(std::lround(input.size() * ratio)));
+		QCOMPARE(output.sampleRate(), input.sampleRate());
+		QVERIFY(std::abs(frequency(output) - 440) < 2);
+	}
+
+	void unityRatioCopies()
+	{
+		const auto input = sine(440, 0.1);
+		const auto output = lmms::TimeStretch::stretch(input, 1.0);
+
+		QCOMPARE(output.size(), input.size());
+		for (std::size_t i = 0; i < input.size(); ++i)
+		{
+			QCOMPARE(output.data()[i][0], input.data()[i][0]);
+		}
+	}
+};
+
+QTEST_GUILESS_MAIN(TimeStretchTest)
+#include "TimeStretchTest.moc"
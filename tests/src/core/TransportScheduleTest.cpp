@@ -0,0 +1,76 @@
+/*
+ * TransportScheduleTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QObject>
+#include <QtTest>
+#include <cmath>
+
+#include "TransportSchedule.h"
+
+using namespace lmms;
+
+class TransportScheduleTest : public QObject
+{
+	Q_OBJECT
+private slots:
+	void tickLengthsTest()
+	{
+		// 1378.125 frames per tick
+		const auto schedule = TransportSchedule{44100, 40, 100};
+		QCOMPARE(schedule.tickStart(100), std::int64_t{0});
+		for (tick_t tick = 0; tick < 1000; ++tick)
+		{
+			const auto length = schedule.tickLength(tick);
+			QVERIFY(length == 1378 || length == 1379);
+		}
+		// every 8 ticks take a whole number of frames
+		QCOMPARE(schedule.tickStart(108), std::int64_t{11025});
+		QCOMPARE(schedule.tickStart(92), std::int64_t{-11025});
+	}
+
+	void noDriftTest()
+	{
+		const auto schedule = TransportSchedule{48000, 97, 0};
+		const auto framesPerTick = 48000. * 60 * 4 / DefaultTicksPerBar / 97;
+
+		auto frames = std::int64_t{0};
+		for (tick_t tick = 0; tick < 1000000; ++tick)
+		{
+			frames += schedule.tickLength(tick);
+		}
+		QCOMPARE(frames, schedule.tickStart(1000000));
+		QCOMPARE(frames, static_cast<std::int64_t>(std::floor(1000000 * framesPerTick)));
+	}
+
+	void fitsTest()
+	{
+		QVERIFY(!TransportSchedule{}.fits(44100, 120));
+
+		const auto schedule = TransportSchedule{44100, 120, 0};
+		QVERIFY(schedule.fits(44100, 120));
+		QVERIFY(!schedule.fits(44100, 121));
+		QVERIFY(!schedule.fits(48000, 120));
+	}
+};
+
+QTEST_GUILESS_MAIN(TransportScheduleTest)
+#include "TransportScheduleTest.moc"
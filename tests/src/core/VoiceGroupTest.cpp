@@ -0,0 +1,134 @@
+/*
+ * VoiceGroupTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QObject>
+#include <QtTest>
+
+#include <array>
+#include <atomic>
+#include <vector>
+
+#include "AudioEngine.h"
+#include "Engine.h"
+#include "Instrument.h"
+#include "SampleFrame.h"
+
+using namespace lmms;
+
+namespace
+{
+
+constexpr auto MaxGroups = 8;
+
+//! Adds group + 1 to every frame of the buffer of each group
+class GroupedInstrument : public Instrument
+{
+public:
+	GroupedInstrument(int groups) :
+		Instrument(nullptr, nullptr, nullptr, Flag::IsSingleStreamed)
+	{
+		setVoiceGroups(groups);
+	}
+
+	void play(SampleFrame* buffer) override
+	{
+		renderVoiceGroups(buffer, Engine::audioEngine()->framesPerPeriod());
+	}
+
+	int groups() const
+	{
+		return voiceGroups();
+	}
+
+	void saveSettings(QDomDocument&, QDomElement&) override {}
+	void loadSettings(const QDomElement&) override {}
+	QString nodeName() const override { return "groupedinstrument"; }
+	gui::PluginView* instantiateView(QWidget*) override { return nullptr; }
+
+	std::array<std::atomic<int>, MaxGroups> calls = {};
+
+protected:
+	void renderVoiceGroup(int group, SampleFrame* buffer, fpp_t frames) override
+	{
+		++calls[group];
+		for (fpp_t frame = 0; frame < frames; ++frame)
+		{
+			buffer[frame] += SampleFrame{static_cast<float>(group + 1)};
+		}
+	}
+};
+
+} // namespace
+
+class VoiceGroupTest : public QObject
+{
+	Q_OBJECT
+private slots:
+	void initTestCase()
+	{
+		Engine::init(true);
+	}
+
+	void cleanupTestCase()
+	{
+		Engine::destroy();
+	}
+
+	void everyGroupIsRenderedOnce_data()
+	{
+		QTest::addColumn<int>("groups");
+		QTest::newRow("single") << 1;
+		QTest::newRow("several") << 4;
+		QTest::newRow("more than threads") << MaxGroups;
+	}
+
+	void everyGroupIsRenderedOnce()
+	{
+		QFETCH(int, groups);
+		auto instrument = GroupedInstrument{groups};
+		QCOMPARE(instrument.groups(), groups);
+
+		const auto frames = Engine::audioEngine()->framesPerPeriod();
+		auto buffer = std::vector<SampleFrame>(frames);
+		const auto expected = static_cast<float>(groups * (groups + 1) / 2);
+
+		// the jobs are reused from one period to the next
+		for (int period = 1; period <= 3; ++period)
+		{
+			zeroSampleFrames(buffer.data(), frames);
+			instrument.play(buffer.data());
+
+			for (int group = 0; group < groups; ++group)
+			{
+				QCOMPARE(instrument.calls[group].load(), period);
+			}
+			for (const auto& frame : buffer)
+			{
+				QCOMPARE(frame.left(), expected);
+				QCOMPARE(frame.right(), expected);
+			}
+		}
+	}
+};
+
+QTEST_GUILESS_MAIN(VoiceGroupTest)
+#include "VoiceGroupTest.moc"
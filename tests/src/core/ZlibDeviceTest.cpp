@@ -0,0 +1,129 @@
+/*
+ * ZlibDeviceTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QBuffer>
+#include <QObject>
+#include <QtTest>
+
+#include <random>
+
+#include "ZlibDevice.h"
+
+using namespace lmms;
+
+namespace
+{
+
+//! Compressible text spanning several chunks, with some noise
+QByteArray makeData(int size)
+{
+	auto rng = std::mt19937{42};
+	auto data = QByteArray();
+	while (data.size() < size)
+	{
+		data.append("<note pos=\"");
+		data.append(QByteArray::number(static_cast<int>(rng() % 100000)));
+		data.append("\" len=\"48\" key=\"57\" vol=\"100\" pan=\"0\"/>\n");
+	}
+	data.resize(size);
+	return data;
+}
+
+QByteArray deflate(const QByteArray& data, int writeSize)
+{
+	auto compressed = QByteArray();
+	auto buffer = QBuffer(&compressed);
+	buffer.open(QIODevice::WriteOnly);
+
+	auto deflating = DeflatingDevice(&buffer);
+	if (!deflating.open(QIODevice::WriteOnly)) { return QByteArray(); }
+	for (int pos = 0; pos < data.size(); pos += writeSize)
+	{
+		deflating.write(data.mid(pos, writeSize));
+	}
+	deflating.close();
+	return deflating.error() ? QByteArray() : compressed;
+}
+
+QByteArray inflate(QByteArray compressed, bool* error)
+{
+	auto buffer = QBuffer(&compressed);
+	buffer.open(QIODevice::ReadOnly);
+
+	auto inflating = InflatingDevice(&buffer);
+	if (!inflating.open(QIODevice::ReadOnly))
+	{
+		*error = true;
+		return QByteArray();
+	}
+	const QByteArray data = inflating.readAll();
+	*error = inflating.error();
+	return data;
+}
+
+} // namespace
+
+class ZlibDeviceTest : public QObject
+{
+	Q_OBJECT
+private slots:
+	void deflateMatchesQUncompressTest()
+	{
+		for (int size : {0, 1, 1000, 256 * 1024, 1000 * 1000})
+		{
+			const QByteArray data = makeData(size);
+			const QByteArray compressed = deflate(data, 4096);
+			QVERIFY(isZlibCompressed(compressed));
+			QCOMPARE(qUncompress(compressed), data);
+		}
+	}
+
+	void inflateReadsQCompressTest()
+	{
+		for (int size : {1, 1000, 1000 * 1000})
+		{
+			const QByteArray data = makeData(size);
+			bool error = false;
+			QCOMPARE(inflate(qCompress(data), &error), data);
+			QVERIFY(!error);
+		}
+	}
+
+	void roundTripTest()
+	{
+		const QByteArray data = makeData(3 * 1000 * 1000);
+		bool error = false;
+		QCOMPARE(inflate(deflate(data, 100 * 1000), &error), data);
+		QVERIFY(!error);
+	}
+
+	void truncatedDataTest()
+	{
+		const QByteArray compressed = deflate(makeData(100 * 1000), 4096);
+		bool error = false;
+		inflate(compressed.left(compressed.size() / 2), &error);
+		QVERIFY(error);
+	}
+};
+
+QTEST_GUILESS_MAIN(ZlibDeviceTest)
+#include "ZlibDeviceTest.moc"
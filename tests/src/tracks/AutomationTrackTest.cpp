@@ -237,6 +237,69 @@ private slots:
 		QCOMPARE(song->automatedValuesAt(0)[&model], 50.0f);
 	}
 
+	void testSaveLoadNodes()
+	{
+		using namespace lmms;
+
+		// few nodes are saved as a <time> element each, many as one base64 <nodes> element
+		for (const int nodes : {3, 100})
+		{
+			AutomationClip original(nullptr);
+			original.setProgressionType(AutomationClip::ProgressionType::CubicHermite);
+			original.setSimplificationTolerance(0.25f);
+			for (int i = 0; i < nodes; ++i)
+			{
+				original.putValues(i * 7, i * 0.5f, i * 0.5f + (i % 3 == 0 ? 1.f : 0.f), false);
+			}
+			original.getTimeMap()[7].setLockedTangents(true);
+
+			QDomDocument doc;
+			QDomElement element = doc.createElement("automationclip");
+			original.saveSettings(doc, element);
+			QCOMPARE(element.elementsByTagName("nodes").isEmpty(), nodes <= 64);
+
+			AutomationClip loaded(nullptr);
+			loaded.loadSettings(element);
+			QCOMPARE(loaded.simplificationTolerance(), 0.25f);
+
+			const auto& expected = original.getTimeMap();
+			const auto& actual = loaded.getTimeMap();
+			QCOMPARE(actual.size(), expected.size());
+			for (auto it = expected.begin(), loadedIt = actual.begin(); it != expected.end(); ++it, ++loadedIt)
+			{
+				QCOMPARE(POS(loadedIt), POS(it));
+				QCOMPARE(INVAL(loadedIt), INVAL(it));
+				QCOMPARE(OUTVAL(loadedIt), OUTVAL(it));
+				QCOMPARE(INTAN(loadedIt), INTAN(it));
+				QCOMPARE(OUTTAN(loadedIt), OUTTAN(it));
+				QCOMPARE(LOCKEDTAN(loadedIt), LOCKEDTAN(it));
+			}
+		}
+	}
+
+	void testLoadNodesWithoutTangents()
+	{
+		using namespace lmms;
+
+		// written by versions storing neither tangents nor a compact node list
+		QDomDocument doc;
+		doc.setContent(QString{
+			"<automationclip pos=\"0\" len=\"192\" prog=\"1\" tens=\"1\" name=\"\">"
+			"<time pos=\"0\" value=\"0\" outValue=\"0\"/>"
+			"<time pos=\"96\" value=\"1\" outValue=\"0.5\"/>"
+			"</automationclip>"});
+
+		AutomationClip clip(nullptr);
+		clip.loadSettings(doc.documentElement());
+
+		QCOMPARE(clip.getTimeMap().size(), 2);
+		QCOMPARE(clip.simplificationTolerance(), 0.0f);
+		QCOMPARE(clip.valueAt(48), 0.5f);
+		const auto last = clip.getTimeMap().constFind(96);
+		QCOMPARE(INVAL(last), 1.0f);
+		QCOMPARE(OUTVAL(last), 0.5f);
+	}
+
 };
 
 QTEST_GUILESS_MAIN(AutomationTrackTest)
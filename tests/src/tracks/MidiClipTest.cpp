@@ -0,0 +1,96 @@
+/*
+ * MidiClipTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QtTest>
+
+#include "Engine.h"
+#include "InstrumentTrack.h"
+#include "MidiClip.h"
+#include "Song.h"
+
+using namespace lmms;
+
+class MidiClipTest : public QObject
+{
+	Q_OBJECT
+private slots:
+	void initTestCase()
+	{
+		Engine::init(true);
+	}
+
+	void cleanupTestCase()
+	{
+		Engine::destroy();
+	}
+
+	void notesInTest()
+	{
+		InstrumentTrack instrumentTrack(Engine::getSong());
+		MidiClip clip(&instrumentTrack);
+
+		Note* a = clip.addNote(Note(TimePos(48), TimePos(0), 60), false);
+		Note* b = clip.addNote(Note(TimePos(48), TimePos(96), 60), false);
+		Note* c = clip.addNote(Note(TimePos(480), TimePos(24), 64), false);
+		Note* step = clip.addNote(Note(TimePos(-192), TimePos(200), 62), false);
+		clip.addNote(Note(TimePos(0), TimePos(0), 60), false);
+
+		QCOMPARE(clip.notesIn(0, 1000), (NoteVector{a, c, b, step}));
+		QCOMPARE(clip.notesIn(48, 48, 60, 60), NoteVector{a});
+		QCOMPARE(clip.notesIn(49, 95, 60, 60), NoteVector{});
+		QCOMPARE(clip.notesIn(100, 100, 0, 70), (NoteVector{c, b}));
+		QCOMPARE(clip.notesIn(504, 600), NoteVector{c});
+		QCOMPARE(clip.notesIn(204, 204, 62, 62), NoteVector{step});
+		QCOMPARE(clip.notesIn(205, 205, 62, 62), NoteVector{});
+
+		// the index follows the changes of the notes
+		clip.removeNote(a);
+		QCOMPARE(clip.notesIn(0, 0, 60, 60), NoteVector{});
+
+		b->setPos(TimePos(0));
+		b->setKey(61);
+		clip.rearrangeAllNotes();
+		QCOMPARE(clip.notesIn(0, 0), (NoteVector{b}));
+		QCOMPARE(clip.notesIn(96, 96, 60, 61), NoteVector{});
+	}
+
+	void manyNotesTest()
+	{
+		InstrumentTrack instrumentTrack(Engine::getSong());
+		MidiClip clip(&instrumentTrack);
+
+		// a long note at the start mustn't hide the short ones after it
+		Note* pedal = clip.addNote(Note(TimePos(100000), TimePos(0), 36), false);
+		for (int i = 0; i < 1000; ++i)
+		{
+			clip.addNote(Note(TimePos(12), TimePos(i * 24), 36 + i % 12), false);
+		}
+
+		const NoteVector found = clip.notesIn(12000, 12000, 36, 47);
+		QCOMPARE(found.size(), std::size_t{2});
+		QCOMPARE(found[0], pedal);
+		QCOMPARE(found[1]->pos(), TimePos(12000));
+	}
+};
+
+QTEST_GUILESS_MAIN(MidiClipTest)
+#include "MidiClipTest.moc"